@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 using tensorflow::FunctionDef;
 using tensorflow::Node;
@@ -8482,3 +8483,111 @@ void TF_EnqueueNamedTensor(TF_Session* session, int tensor_id,
                 /*run_metadata*/ nullptr, status);
   VLOG(1) << "Enqueuing is done.";
 }
+
+struct TF_Callable {
+  tensorflow::Session::CallableHandle handle;
+  int num_feeds;
+  // Whether each fetch is backed by device memory.
+  std::vector<bool> fetch_on_device;
+};
+
+TF_Callable* TF_SessionMakeCallable(TF_Session* session,
+                                    const void* callable_options_proto,
+                                    size_t proto_len, TF_Status* status) {
+  tensorflow::CallableOptions options;
+  if (!options.ParseFromArray(callable_options_proto, proto_len)) {
+    status->status =
+        tensorflow::errors::InvalidArgument("Unparseable CallableOptions");
+    return nullptr;
+  }
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return nullptr;
+  }
+  tensorflow::Session::CallableHandle handle;
+  status->status = session->session->MakeCallable(options, &handle);
+  if (!status->status.ok()) return nullptr;
+
+  TF_Callable* callable = new TF_Callable;
+  callable->handle = handle;
+  callable->num_feeds = options.feed_size();
+  for (const tensorflow::string& fetch : options.fetch()) {
+    const auto it = options.fetch_devices().find(fetch);
+    tensorflow::DeviceNameUtils::ParsedName device;
+    callable->fetch_on_device.push_back(
+        it != options.fetch_devices().end() &&
+        tensorflow::DeviceNameUtils::ParseFullName(it->second, &device) &&
+        device.type != tensorflow::DEVICE_CPU);
+  }
+  return callable;
+}
+
+void TF_SessionRunCallable(TF_Session* session, TF_Callable* callable,
+                           TF_Tensor* const* inputs, int ninputs,
+                           TF_Tensor** outputs, int noutputs,
+                           TF_Buffer* run_metadata, TF_Status* status) {
+  const int num_fetches = callable->fetch_on_device.size();
+  if (ninputs != callable->num_feeds || noutputs != num_fetches) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Expected ", callable->num_feeds, " inputs and ", num_fetches,
+        " outputs, got ", ninputs, " and ", noutputs);
+    return;
+  }
+  std::vector<tensorflow::Tensor> feeds(ninputs);
+  for (int i = 0; i < ninputs; ++i) {
+    status->status = tensorflow::TF_TensorToTensor(inputs[i], &feeds[i]);
+    if (!status->status.ok()) return;
+  }
+
+  std::vector<tensorflow::Tensor> fetches;
+  tensorflow::RunMetadata run_metadata_proto;
+  status->status = session->session->RunCallable(
+      callable->handle, feeds, &fetches,
+      run_metadata == nullptr ? nullptr : &run_metadata_proto);
+  if (!status->status.ok()) return;
+  if (run_metadata != nullptr) {
+    status->status =
+        tensorflow::MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    const tensorflow::Tensor& fetch = fetches[i];
+    TF_Tensor* dst = outputs[i];
+    if (dst == nullptr) {
+      outputs[i] = tensorflow::TF_TensorFromTensor(fetch, status);
+      if (!status->status.ok()) return;
+      continue;
+    }
+    const tensorflow::DataType dtype = fetch.dtype();
+    if (callable->fetch_on_device[i] ||
+        !tensorflow::DataTypeCanUseMemcpy(dtype)) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "Output ", i, " of type ", tensorflow::DataTypeString(dtype),
+          " must be null, since only host tensors of non-string types can be "
+          "written to tensors of the caller");
+      return;
+    }
+    const tensorflow::DataType dst_dtype =
+        static_cast<tensorflow::DataType>(dst->dtype);
+    if (dst_dtype != dtype || dst->shape != fetch.shape()) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "Output ", i, " is a ", tensorflow::DataTypeString(dst_dtype),
+          " tensor of shape ", dst->shape.DebugString(),
+          " but the fetched value is a ", tensorflow::DataTypeString(dtype),
+          " tensor of shape ", fetch.shape().DebugString());
+      return;
+    }
+    const tensorflow::StringPiece data = fetch.tensor_data();
+    // The fetch can be the fed tensor of the caller itself.
+    if (data.data() != TF_TensorData(dst)) {
+      std::memcpy(TF_TensorData(dst), data.data(), data.size());
+    }
+  }
+}
+
+void TF_SessionReleaseCallable(TF_Session* session, TF_Callable* callable,
+                               TF_Status* status) {
+  status->status = session->session->ReleaseCallable(callable->handle);
+  delete callable;
+}
@@ -125,6 +125,41 @@ TF_CAPI_EXPORT extern void TF_EnqueueNamedTensor(TF_Session* session,
                                                  TF_Tensor* tensor,
                                                  TF_Status* status);
 
+// A subgraph of a session, pruned and placed once by TF_SessionMakeCallable,
+// that TF_SessionRunCallable runs without the per-run setup of
+// TF_SessionRun.
+typedef struct TF_Callable TF_Callable;
+
+// Creates a callable in `session` from a serialized CallableOptions proto,
+// which names the feeds, fetches and targets of the subgraph, and the devices
+// of the feeds and fetches that stay in device memory. Returns nullptr on
+// error. The callable must be released by TF_SessionReleaseCallable.
+TF_CAPI_EXPORT extern TF_Callable* TF_SessionMakeCallable(
+    TF_Session* session, const void* callable_options_proto,
+    size_t proto_len, TF_Status* status);
+
+// Runs `callable`, feeding `inputs` in the order of CallableOptions.feed.
+// Non-string inputs are fed without copying their buffers.
+//
+// `outputs` follows the order of CallableOptions.fetch, and each entry must be
+// either null or a tensor owned by the caller:
+// - A null entry is set to a new tensor that shares the buffer of the fetched
+//   value, e.g. device memory for the fetches in
+//   CallableOptions.fetch_devices. The caller must delete it.
+// - A tensor, e.g. one made by TF_NewTensor over a buffer that the caller
+//   reuses across runs, receives the fetched value, which must have its type
+//   and shape. No tensor is allocated for it. This is only supported for
+//   fetches of non-string types that are backed by host memory.
+TF_CAPI_EXPORT extern void TF_SessionRunCallable(
+    TF_Session* session, TF_Callable* callable, TF_Tensor* const* inputs,
+    int ninputs, TF_Tensor** outputs, int noutputs, TF_Buffer* run_metadata,
+    TF_Status* status);
+
+// Releases the resources of `callable` in `session`, and deletes it.
+TF_CAPI_EXPORT extern void TF_SessionReleaseCallable(TF_Session* session,
+                                                     TF_Callable* callable,
+                                                     TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
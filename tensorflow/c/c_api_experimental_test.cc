@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/c/c_api_experimental.h"
 #include "tensorflow/c/c_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -116,5 +117,63 @@ TEST(CAPI_EXPERIMENTAL, ImagenetIteratorGetNext) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI_EXPERIMENTAL, RunCallable) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* one = ScalarConst(1, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  Add(feed, one, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  CSession csession(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Session* session = csession.mutable_session();
+
+  CallableOptions options;
+  options.add_feed("feed:0");
+  options.add_fetch("add:0");
+  const string proto = options.SerializeAsString();
+  TF_Callable* callable =
+      TF_SessionMakeCallable(session, proto.data(), proto.size(), s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  // The output is written to a tensor of the caller on every run.
+  TF_Tensor* output = Int32Tensor(0);
+  for (int i = 0; i < 3; ++i) {
+    TF_Tensor* input = Int32Tensor(i);
+    TF_SessionRunCallable(session, callable, &input, 1, &output, 1, nullptr,
+                          s);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    EXPECT_EQ(i + 1, *static_cast<int32*>(TF_TensorData(output)));
+    TF_DeleteTensor(input);
+  }
+  TF_DeleteTensor(output);
+
+  // A null output is set to a new tensor.
+  TF_Tensor* input = Int32Tensor(41);
+  output = nullptr;
+  TF_SessionRunCallable(session, callable, &input, 1, &output, 1, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  ASSERT_TRUE(output != nullptr);
+  EXPECT_EQ(42, *static_cast<int32*>(TF_TensorData(output)));
+  TF_DeleteTensor(output);
+
+  // The output of the caller must have the fetched shape.
+  output = Int32Tensor({1, 2});
+  TF_SessionRunCallable(session, callable, &input, 1, &output, 1, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteTensor(output);
+  TF_DeleteTensor(input);
+
+  TF_SessionReleaseCallable(session, callable, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  csession.CloseAndDelete(s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -19,10 +19,17 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
@@ -42,6 +49,10 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were successfully loaded.",
     "model_path");
+auto* load_latency_by_stage = monitoring::Counter<2>::New(
+    "/tensorflow/cc/saved_model/load_latency_by_stage",
+    "Latency in microseconds of each stage of the SavedModel loads.",
+    "model_path", "stage");
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
 
@@ -207,25 +218,136 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return Status::OK();
 }
 
+// Measures the latency of a stage of the load of "export_dir", from
+// construction to destruction, and exports it to the load_latency_by_stage
+// counter.
+class StageTimer {
+ public:
+  StageTimer(const string& export_dir, const char* stage)
+      : export_dir_(export_dir),
+        stage_(stage),
+        start_microseconds_(Env::Default()->NowMicros()) {}
+
+  ~StageTimer() {
+    const uint64 end_microseconds = Env::Default()->NowMicros();
+    // Avoid clock skew.
+    const uint64 latency_microseconds =
+        end_microseconds < start_microseconds_
+            ? 0
+            : end_microseconds - start_microseconds_;
+    VLOG(1) << "SavedModel load stage " << stage_ << " took "
+            << latency_microseconds << " microseconds.";
+    load_latency_by_stage->GetCell(export_dir_, stage_)
+        ->IncrementBy(latency_microseconds);
+  }
+
+ private:
+  const string& export_dir_;
+  const char* const stage_;
+  const uint64 start_microseconds_;
+};
+
+// Writes `data` to `path` unless the file already exists. The data is written
+// to a temporary file first, so that concurrent loads never map a partially
+// written file.
+Status WriteMemmappedConstantFile(const string& path, StringPiece data) {
+  Env* env = Env::Default();
+  if (env->FileExists(path).ok()) {
+    return Status::OK();
+  }
+  const string tmp_path = strings::StrCat(path, ".tmp.", env->NowMicros(), ".",
+                                          random::New64());
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_path, data));
+  return env->RenameFile(tmp_path, path);
+}
+
+// Replaces the Const nodes of the graph that are large enough by ImmutableConst
+// nodes over files in the directory of `options`.
+Status ConvertConstantsToMemmapped(const MemmappedConstantsOptions& options,
+                                   GraphDef* graph_def) {
+  TF_RETURN_IF_ERROR(
+      Env::Default()->RecursivelyCreateDir(options.directory));
+  int num_converted = 0;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    // ImmutableConst only has a CPU kernel.
+    if (node.op() != "Const" ||
+        (!node.device().empty() &&
+         !str_util::StrContains(str_util::Lowercase(node.device()), "cpu"))) {
+      continue;
+    }
+    const auto value_it = node.attr().find("value");
+    if (value_it == node.attr().end()) continue;
+    const TensorProto& tensor_proto = value_it->second.tensor();
+    if (!DataTypeCanUseMemcpy(tensor_proto.dtype())) continue;
+    Tensor tensor;
+    if (!tensor.FromProto(tensor_proto)) {
+      return errors::InvalidArgument("Cannot parse the value of constant ",
+                                     node.name());
+    }
+    const StringPiece data = tensor.tensor_data();
+    if (data.empty() || static_cast<int64>(data.size()) < options.min_bytes) {
+      continue;
+    }
+    const string path = io::JoinPath(
+        options.directory,
+        strings::Printf("%016llx_%zu.tensor",
+                        static_cast<unsigned long long>(
+                            Hash64(data.data(), data.size())),
+                        data.size()));
+    TF_RETURN_IF_ERROR(WriteMemmappedConstantFile(path, data));
+
+    AttrValue dtype;
+    dtype.set_type(tensor.dtype());
+    AttrValue shape;
+    tensor.shape().AsProto(shape.mutable_shape());
+    AttrValue region;
+    region.set_s(path);
+    node.set_op("ImmutableConst");
+    node.mutable_attr()->clear();
+    (*node.mutable_attr())["dtype"] = dtype;
+    (*node.mutable_attr())["shape"] = shape;
+    (*node.mutable_attr())["memory_region_name"] = region;
+    ++num_converted;
+  }
+  VLOG(1) << "Memory-mapped " << num_converted << " constants from "
+          << options.directory;
+  return Status::OK();
+}
+
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
+                              const MemmappedConstantsOptions* memmapped,
                               SavedModelBundle* const bundle) {
-  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
-                                                    &bundle->meta_graph_def));
-
-  TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
-      bundle->meta_graph_def, session_options, &bundle->session));
+  {
+    StageTimer timer(export_dir, "read_meta_graph");
+    TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(
+        export_dir, tags, &bundle->meta_graph_def));
+  }
+  if (memmapped != nullptr) {
+    StageTimer timer(export_dir, "memmap_constants");
+    TF_RETURN_IF_ERROR(ConvertConstantsToMemmapped(
+        *memmapped, bundle->meta_graph_def.mutable_graph_def()));
+  }
+  {
+    StageTimer timer(export_dir, "create_session");
+    TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
+        bundle->meta_graph_def, session_options, &bundle->session));
+  }
 
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
       GetAssetFileDefs(bundle->meta_graph_def, &asset_file_defs));
-  TF_RETURN_IF_ERROR(
-      RunRestore(run_options, export_dir,
-                 bundle->meta_graph_def.saver_def().restore_op_name(),
-                 bundle->meta_graph_def.saver_def().filename_tensor_name(),
-                 asset_file_defs, bundle->session.get()));
+  {
+    StageTimer timer(export_dir, "restore");
+    TF_RETURN_IF_ERROR(
+        RunRestore(run_options, export_dir,
+                   bundle->meta_graph_def.saver_def().restore_op_name(),
+                   bundle->meta_graph_def.saver_def().filename_tensor_name(),
+                   asset_file_defs, bundle->session.get()));
+  }
+  StageTimer timer(export_dir, "init");
   if (HasMainOp(bundle->meta_graph_def)) {
     TF_RETURN_IF_ERROR(RunMainOp(run_options, export_dir,
                                  bundle->meta_graph_def, asset_file_defs,
@@ -238,16 +360,16 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   return Status::OK();
 }
 
-}  // namespace
-
-Status LoadSavedModel(const SessionOptions& session_options,
-                      const RunOptions& run_options, const string& export_dir,
-                      const std::unordered_set<string>& tags,
-                      SavedModelBundle* const bundle) {
+Status LoadSavedModelAndCount(const SessionOptions& session_options,
+                              const RunOptions& run_options,
+                              const string& export_dir,
+                              const std::unordered_set<string>& tags,
+                              const MemmappedConstantsOptions* memmapped,
+                              SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status = LoadSavedModelInternal(
+      session_options, run_options, export_dir, tags, memmapped, bundle);
   const uint64 load_latency_microsecs = [&]() -> uint64 {
     const uint64 end_microseconds = Env::Default()->NowMicros();
     // Avoid clock skew.
@@ -269,6 +391,25 @@ Status LoadSavedModel(const SessionOptions& session_options,
   return status;
 }
 
+}  // namespace
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle) {
+  return LoadSavedModelAndCount(session_options, run_options, export_dir, tags,
+                                nullptr, bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const MemmappedConstantsOptions& memmapped_options,
+                      SavedModelBundle* const bundle) {
+  return LoadSavedModelAndCount(session_options, run_options, export_dir, tags,
+                                &memmapped_options, bundle);
+}
+
 bool MaybeSavedModelDirectory(const string& export_dir) {
   const string saved_model_pb_path =
       io::JoinPath(export_dir, kSavedModelFilenamePb);
@@ -52,6 +52,27 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Options for serving the large constants of a SavedModel from read-only
+/// memory-mapped files instead of copies in each session.
+struct MemmappedConstantsOptions {
+  /// Directory in which the constants are written, in files named after a
+  /// hash of their contents. The processes of a host that load models with the
+  /// same directory share one page-cache copy of each constant.
+  string directory;
+  /// Constants smaller than this many bytes are kept in the graph.
+  int64 min_bytes = 64 << 10;
+};
+
+/// Like LoadSavedModel above, but the constants of the meta graph that are
+/// placed on CPU and have a plain-old-data type are replaced by ImmutableConst
+/// ops over files in `memmapped_options.directory`, which are written on first
+/// use. Variables are restored as usual.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const MemmappedConstantsOptions& memmapped_options,
+                      SavedModelBundle* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
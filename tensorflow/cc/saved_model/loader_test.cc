@@ -124,6 +124,39 @@ TEST_F(LoaderTest, TagMatch) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, MemmappedConstants) {
+  SessionOptions session_options;
+  RunOptions run_options;
+  MemmappedConstantsOptions memmapped_options;
+  memmapped_options.directory =
+      io::JoinPath(testing::TmpDir(), "memmapped_constants");
+  memmapped_options.min_bytes = 0;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  for (int i = 0; i < 2; ++i) {
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, memmapped_options,
+                                &bundle));
+    CheckSavedModelBundle(export_dir, bundle);
+    int num_immutable_consts = 0;
+    for (const NodeDef& node : bundle.meta_graph_def.graph_def().node()) {
+      if (node.op() == "ImmutableConst") ++num_immutable_consts;
+    }
+    EXPECT_GT(num_immutable_consts, 0);
+  }
+
+  // The second load reuses the files of the first one.
+  std::vector<string> files;
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(memmapped_options.directory, &files));
+  EXPECT_FALSE(files.empty());
+  for (const string& file : files) {
+    EXPECT_FALSE(str_util::StrContains(file, ".tmp.")) << file;
+  }
+}
+
 TEST_F(LoaderTest, NoTagMatch) {
   SavedModelBundle bundle;
   RunOptions run_options;
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/codegen.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -563,51 +564,254 @@ static string CreateUniqueIdentifier(const CodegenOpts& opts,
   return result;
 }
 
-Status GenerateMetadata(const CodegenOpts& opts,
-                        const CompileResult& compile_result,
-                        MetadataResult* metadata_result) {
-  std::unique_ptr<xla::ProgramShape> program_shape;
-
+// Appends the protocol buffers to embed for the metadata of `compile_result`
+// to `protobufs`.  The program shape to embed, if any, is returned via
+// `program_shape`, which must outlive the embedding.
+static void AppendMetadataProtobufs(
+    const CodegenOpts& opts, const CompileResult& compile_result,
+    std::unique_ptr<xla::ProgramShape>* program_shape,
+    std::vector<ProtobufToEmbed>* protobufs) {
   if (opts.gen_program_shape) {
-    program_shape =
+    *program_shape =
         tensorflow::MakeUnique<xla::ProgramShape>(compile_result.program_shape);
     // The parameter names are currently meaningless, and redundant with the
     // rest of our metadata, so clear them out to avoid confusion and save
     // space.
-    program_shape->clear_parameter_names();
+    (*program_shape)->clear_parameter_names();
   }
 
   // When asked to serialize a null protobuf, CreateEmbeddedProtocolBuffer gives
   // a shim that evaluates to nullptr, which is what we want.
 
-  ProtobufToEmbed program_shape_protobuf{
-      CreateUniqueIdentifier(opts, "ProgramShape"), "xla::ProgramShape",
-      program_shape.get()};
+  protobufs->push_back({CreateUniqueIdentifier(opts, "ProgramShape"),
+                        "xla::ProgramShape", program_shape->get()});
 
-  ProtobufToEmbed hlo_profile_printer_data_protobuf{
-      CreateUniqueIdentifier(opts, "HloProfilePrinterData"),
-      "xla::HloProfilePrinterData",
-      compile_result.aot->hlo_profile_printer_data()};
-
-  TF_ASSIGN_OR_RETURN(
-      EmbeddedProtocolBuffers embedded_protobufs,
-      CreateEmbeddedProtocolBuffers(
-          opts.target_triple,
-          {program_shape_protobuf, hlo_profile_printer_data_protobuf}));
+  protobufs->push_back({CreateUniqueIdentifier(opts, "HloProfilePrinterData"),
+                        "xla::HloProfilePrinterData",
+                        compile_result.aot->hlo_profile_printer_data()});
+}
 
+// Sets the shims of `metadata_result` from the embedded protocol buffers
+// appended by AppendMetadataProtobufs, starting at `index`.
+static void SetMetadataShims(EmbeddedProtocolBuffers* embedded_protobufs,
+                             int index, MetadataResult* metadata_result) {
+  auto& shims = embedded_protobufs->cpp_shims;
   metadata_result->program_shape_access_shim =
-      std::move(embedded_protobufs.cpp_shims[0].expression);
+      std::move(shims[index].expression);
   metadata_result->hlo_profile_printer_data_access_shim =
-      std::move(embedded_protobufs.cpp_shims[1].expression);
+      std::move(shims[index + 1].expression);
   metadata_result->header_variable_decls.emplace_back(
-      std::move(embedded_protobufs.cpp_shims[0].variable_decl));
+      std::move(shims[index].variable_decl));
   metadata_result->header_variable_decls.emplace_back(
-      std::move(embedded_protobufs.cpp_shims[1].variable_decl));
+      std::move(shims[index + 1].variable_decl));
+}
+
+// Returns the options of the variant for `batch_size`.
+static CodegenOpts VariantOpts(const CodegenOpts& opts, int64 batch_size) {
+  CodegenOpts variant_opts = opts;
+  strings::StrAppend(&variant_opts.class_name, "_", batch_size);
+  return variant_opts;
+}
+
+Status GenerateMetadata(const CodegenOpts& opts,
+                        const CompileResult& compile_result,
+                        MetadataResult* metadata_result) {
+  std::unique_ptr<xla::ProgramShape> program_shape;
+  std::vector<ProtobufToEmbed> protobufs;
+  AppendMetadataProtobufs(opts, compile_result, &program_shape, &protobufs);
+
+  TF_ASSIGN_OR_RETURN(
+      EmbeddedProtocolBuffers embedded_protobufs,
+      CreateEmbeddedProtocolBuffers(opts.target_triple, protobufs));
+
+  SetMetadataShims(&embedded_protobufs, 0, metadata_result);
   metadata_result->object_file_data =
       std::move(embedded_protobufs.object_file_data);
   return Status::OK();
 }
 
+Status GenerateVariantsMetadata(
+    const CodegenOpts& opts, const std::vector<int64>& batch_sizes,
+    const std::vector<CompileResult>& compile_results,
+    std::vector<MetadataResult>* metadata_results, string* object_file_data) {
+  if (batch_sizes.size() != compile_results.size()) {
+    return errors::InvalidArgument("mismatch between batch sizes(",
+                                   batch_sizes.size(), ") and variants(",
+                                   compile_results.size(), ")");
+  }
+  std::vector<std::unique_ptr<xla::ProgramShape>> program_shapes(
+      compile_results.size());
+  std::vector<ProtobufToEmbed> protobufs;
+  for (size_t i = 0; i < compile_results.size(); ++i) {
+    AppendMetadataProtobufs(VariantOpts(opts, batch_sizes[i]),
+                            compile_results[i], &program_shapes[i],
+                            &protobufs);
+  }
+
+  TF_ASSIGN_OR_RETURN(
+      EmbeddedProtocolBuffers embedded_protobufs,
+      CreateEmbeddedProtocolBuffers(opts.target_triple, protobufs));
+
+  metadata_results->clear();
+  metadata_results->resize(compile_results.size());
+  for (size_t i = 0; i < compile_results.size(); ++i) {
+    SetMetadataShims(&embedded_protobufs, 2 * i, &(*metadata_results)[i]);
+  }
+  *object_file_data = std::move(embedded_protobufs.object_file_data);
+  return Status::OK();
+}
+
+Status GenerateVariantsHeader(
+    const CodegenOpts& opts, const tf2xla::Config& config,
+    const std::vector<int64>& batch_sizes,
+    const std::vector<CompileResult>& compile_results,
+    const std::vector<MetadataResult>& metadata_results, string* header) {
+  if (batch_sizes.size() != compile_results.size() ||
+      batch_sizes.size() != metadata_results.size()) {
+    return errors::InvalidArgument(
+        "mismatch between batch sizes(", batch_sizes.size(), "), variants(",
+        compile_results.size(), ") and metadata(", metadata_results.size(),
+        ")");
+  }
+  if (batch_sizes.empty() ||
+      !std::is_sorted(batch_sizes.begin(), batch_sizes.end())) {
+    return errors::InvalidArgument("batch sizes must be in increasing order");
+  }
+
+  // The variants are self-contained, so simply concatenate their headers.
+  string variants;
+  std::vector<string> static_data_functions;
+  for (size_t i = 0; i < batch_sizes.size(); ++i) {
+    const CodegenOpts variant_opts = VariantOpts(opts, batch_sizes[i]);
+    string variant_header;
+    TF_RETURN_IF_ERROR(GenerateHeader(variant_opts, config, compile_results[i],
+                                      metadata_results[i], &variant_header));
+    strings::StrAppend(&variants, variant_header, "\n");
+    static_data_functions.push_back(
+        strings::StrCat("&", variant_opts.class_name, "::StaticData"));
+  }
+
+  string guard = "TFCOMPILE_GENERATED";
+  for (const string& n : opts.namespaces) {
+    strings::StrAppend(&guard, "_", n);
+  }
+  strings::StrAppend(&guard, "_", opts.class_name, "_VARIANTS_H_");
+
+  string ns_start;
+  for (const string& n : opts.namespaces) {
+    ns_start += strings::StrCat("namespace ", n, " {\n");
+  }
+  ns_start += "\n";
+  string ns_end("\n");
+  for (int i = opts.namespaces.size() - 1; i >= 0; --i) {
+    const string& n = opts.namespaces[i];
+    ns_end += strings::StrCat("}  // end namespace ", n, "\n");
+  }
+
+  *header =
+      R"(// Generated by tfcompile, the TensorFlow graph compiler.  DO NOT EDIT!
+//
+// This header was generated via ahead-of-time compilation of a TensorFlow
+// graph for several batch sizes.  An object file corresponding to this header
+// was also generated.  This header gives access to the functionality in that
+// object file.
+//
+// clang-format off
+
+#ifndef {{GUARD}}  // NOLINT(build/header_guard)
+#define {{GUARD}}  // NOLINT(build/header_guard)
+
+#include <memory>
+
+{{VARIANTS}}
+{{NS_START}}
+// {{CLASS}} creates the variant of a computation previously specified in a
+// TensorFlow graph, now compiled into executable code for the batch sizes
+// {{BATCH_SIZES}}. The variants share the constants of the computation.
+// Usage example:
+//
+//   std::unique_ptr<tensorflow::XlaCompiledCpuFunction> computation =
+//       {{CLASS}}::Create(batch_size);
+//   CHECK(computation != nullptr);
+//   // ...set args using computation->arg_data(N)
+//   CHECK(computation->Run());
+//   // ...inspect results using computation->result_data(N)
+//
+// The leading dimension of the args and results of a variant is its batch
+// size, which may be larger than the requested one: the args must be padded,
+// and the results that depend on the padding ignored. Each variant is also
+// available as a class with statically type-safe arg and result methods,
+// named after {{CLASS}} suffixed with its batch size.
+class {{CLASS}} {
+ public:
+  // Number of variants of the computation.
+  static constexpr size_t kNumVariants = {{NUM_VARIANTS}};
+
+  // Batch size of each variant, in increasing order. There are kNumVariants
+  // entries.
+  static const tensorflow::int64* BatchSizes() {
+    static constexpr tensorflow::int64 kBatchSizes[kNumVariants] = {
+        {{BATCH_SIZES}}};
+    return kBatchSizes;
+  }
+
+  // Returns the index of the variant with the smallest batch size of at least
+  // `batch_size`, or -1 if there is none.
+  static int VariantIndex(tensorflow::int64 batch_size) {
+    for (size_t i = 0; i < kNumVariants; ++i) {
+      if (BatchSizes()[i] >= batch_size) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  // Returns static data used to create the XlaCompiledCpuFunction of variant
+  // `index`.
+  static const tensorflow::XlaCompiledCpuFunction::StaticData& StaticData(
+      int index) {
+    using StaticDataFunction =
+        const tensorflow::XlaCompiledCpuFunction::StaticData& (*)();
+    static constexpr StaticDataFunction kStaticData[kNumVariants] = {
+        {{STATIC_DATA_FUNCTIONS}}};
+    return kStaticData[index]();
+  }
+
+  // Returns a new instance of the variant for `batch_size`, or nullptr if
+  // `batch_size` is larger than the batch sizes of all the variants.
+  static std::unique_ptr<tensorflow::XlaCompiledCpuFunction> Create(
+      tensorflow::int64 batch_size,
+      tensorflow::XlaCompiledCpuFunction::AllocMode alloc_mode =
+          tensorflow::XlaCompiledCpuFunction::AllocMode::
+              ARGS_RESULTS_PROFILES_AND_TEMPS) {
+    const int index = VariantIndex(batch_size);
+    if (index < 0) {
+      return nullptr;
+    }
+    return std::unique_ptr<tensorflow::XlaCompiledCpuFunction>(
+        new tensorflow::XlaCompiledCpuFunction(StaticData(index), alloc_mode));
+  }
+};
+{{NS_END}}
+
+#endif  // {{GUARD}}
+
+// clang-format on
+)";
+  const std::vector<std::pair<string, string>> rewrites = {
+      {"{{BATCH_SIZES}}", str_util::Join(batch_sizes, ", ")},
+      {"{{CLASS}}", opts.class_name},
+      {"{{GUARD}}", guard},
+      {"{{NS_END}}\n", ns_end},
+      {"{{NS_START}}\n", ns_start},
+      {"{{NUM_VARIANTS}}", strings::StrCat(batch_sizes.size())},
+      {"{{STATIC_DATA_FUNCTIONS}}",
+       str_util::Join(static_data_functions, ", ")},
+      {"{{VARIANTS}}\n", variants}};
+  str_util::ReplaceAllPairs(header, rewrites);
+  return Status::OK();
+}
+
 Status ParseCppClass(const string& cpp_class, string* class_name,
                      std::vector<string>* namespaces) {
   class_name->clear();
@@ -87,6 +87,30 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
                       const CompileResult& compile_result,
                       const MetadataResult& metadata_result, string* header);
 
+// GenerateVariantsMetadata is like GenerateMetadata for the variants of a
+// computation compiled by CompileGraphVariants, where compile_results[i] is the
+// variant for batch_sizes[i].  The metadata of all the variants is generated
+// into the single object file returned via `object_file_data`, and the
+// object_file_data of the returned metadata_results is empty.
+Status GenerateVariantsMetadata(
+    const CodegenOpts& opts, const std::vector<int64>& batch_sizes,
+    const std::vector<CompileResult>& compile_results,
+    std::vector<MetadataResult>* metadata_results, string* object_file_data);
+
+// GenerateVariantsHeader generates a C++ header giving access to the variants
+// of a computation compiled by CompileGraphVariants.  The header contains a
+// class for each variant, like the one of GenerateHeader, named after
+// opts.class_name suffixed with "_<batch size>".  The opts.class_name class
+// creates the variant with the smallest batch size of at least a given one.
+//
+// metadata_results are obtained by a previous invocation to
+// GenerateVariantsMetadata.
+Status GenerateVariantsHeader(
+    const CodegenOpts& opts, const tf2xla::Config& config,
+    const std::vector<int64>& batch_sizes,
+    const std::vector<CompileResult>& compile_results,
+    const std::vector<MetadataResult>& metadata_results, string* header);
+
 // ParseCppClass parses `cpp_class` into its `class_name` and `namespaces`
 // components.  The syntax is [[<optional_namespace>::],...]<class_name>.  This
 // mirrors the C++ syntax for referring to a class, where multiple namespaces
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -198,6 +199,63 @@ TEST(CodegenTest, Golden) {
 
   CompareWithGoldenFile("compiler/aot/codegen_test_h.golden", header);
 }
+
+TEST(CodegenTest, Variants) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  LLVMInitializeX86Target();
+  LLVMInitializeX86TargetMC();
+
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  opts.target_triple = "x86_64-pc-linux";
+  opts.namespaces = {"foo"};
+  opts.gen_program_shape = true;
+  tf2xla::Config config;
+  config.add_feed()->mutable_id()->set_node_name("feed0");
+  config.add_fetch()->mutable_id()->set_node_name("fetch0");
+  const std::vector<int64> batch_sizes = {1, 4};
+  std::vector<CompileResult> compile_results(batch_sizes.size());
+  for (size_t i = 0; i < batch_sizes.size(); ++i) {
+    CompileResult& compile_result = compile_results[i];
+    compile_result.aot.reset(
+        new xla::cpu::CpuAotCompilationResult({}, {-1, 16}, 1, {}));
+    compile_result.program_shape = xla::ShapeUtil::MakeProgramShape(
+        {xla::ShapeUtil::MakeShape(xla::F32, {batch_sizes[i], 2})},
+        xla::ShapeUtil::MakeTupleShape(
+            {xla::ShapeUtil::MakeShape(xla::F32, {batch_sizes[i]})}));
+    compile_result.entry_point =
+        strings::StrCat("entry_point_", batch_sizes[i]);
+    compile_result.pointer_size = 8;
+  }
+
+  std::vector<MetadataResult> metadata_results;
+  string object_file_data;
+  TF_ASSERT_OK(GenerateVariantsMetadata(opts, batch_sizes, compile_results,
+                                        &metadata_results, &object_file_data));
+  ASSERT_EQ(2, metadata_results.size());
+  EXPECT_FALSE(object_file_data.empty());
+  EXPECT_NE(metadata_results[0].program_shape_access_shim,
+            metadata_results[1].program_shape_access_shim);
+
+  string header;
+  TF_ASSERT_OK(GenerateVariantsHeader(opts, config, batch_sizes,
+                                      compile_results, metadata_results,
+                                      &header));
+  EXPECT_TRUE(str_util::StrContains(
+      header, "class MyClass_1 : public tensorflow::XlaCompiledCpuFunction"));
+  EXPECT_TRUE(str_util::StrContains(
+      header, "class MyClass_4 : public tensorflow::XlaCompiledCpuFunction"));
+  EXPECT_TRUE(str_util::StrContains(header, "class MyClass {"));
+  EXPECT_TRUE(str_util::StrContains(header, "kNumVariants = 2;"));
+  EXPECT_TRUE(str_util::StrContains(
+      header, "&MyClass_1::StaticData, &MyClass_4::StaticData"));
+
+  ExpectErrorContains(
+      GenerateVariantsHeader(opts, config, {4, 1}, compile_results,
+                             metadata_results, &header),
+      "increasing order");
+}
 }  // namespace
 }  // namespace tfcompile
 }  // namespace tensorflow
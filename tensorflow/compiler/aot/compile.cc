@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,7 +34,10 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
@@ -43,63 +47,74 @@ namespace tfcompile {
 
 namespace {
 
-// Compiles the XLA computation into executable code.
+// Compiles the XLA computations into executable code, in a single object file.
 Status CompileXla(xla::CompileOnlyClient* client,
-                  const xla::XlaComputation& computation,
+                  const std::vector<xla::XlaComputation>& computations,
                   const xla::cpu::CpuAotCompilationOptions& aot_opts,
-                  CompileResult* compile_result) {
-  // Retrieves arg and result layouts from the computation.
-  // TODO(toddw): Should we let the user choose the major/minor ordering?
-  xla::StatusOr<std::unique_ptr<xla::ProgramShape>> pshape_or =
-      client->GetComputationShape(computation);
-  if (!pshape_or.ok()) {
-    return errors::Unknown("Couldn't get XLA program shape: ",
-                           pshape_or.status().error_message());
+                  std::vector<CompileResult>* compile_results) {
+  compile_results->resize(computations.size());
+  std::vector<xla::CompileOnlyClient::AotXlaComputationInstance> instances(
+      computations.size());
+  for (size_t i = 0; i < computations.size(); ++i) {
+    // Retrieves arg and result layouts from the computation.
+    // TODO(toddw): Should we let the user choose the major/minor ordering?
+    xla::StatusOr<std::unique_ptr<xla::ProgramShape>> pshape_or =
+        client->GetComputationShape(computations[i]);
+    if (!pshape_or.ok()) {
+      return errors::Unknown("Couldn't get XLA program shape: ",
+                             pshape_or.status().error_message());
+    }
+    CompileResult* compile_result = &(*compile_results)[i];
+    compile_result->program_shape = *pshape_or.ValueOrDie();
+    xla::ProgramShape* pshape = &compile_result->program_shape;
+    std::vector<const xla::Shape*> arg_layouts;
+    arg_layouts.reserve(pshape->parameters_size());
+    for (int j = 0; j < pshape->parameters_size(); ++j) {
+      arg_layouts.push_back(pshape->mutable_parameters(j));
+    }
+    instances[i].computation = &computations[i];
+    instances[i].argument_layouts = std::move(arg_layouts);
+    instances[i].result_layout = &pshape->result();
   }
-  compile_result->program_shape = *pshape_or.ValueOrDie();
-  xla::ProgramShape* pshape = &compile_result->program_shape;
-  std::vector<const xla::Shape*> arg_layouts;
-  arg_layouts.reserve(pshape->parameters_size());
-  for (int i = 0; i < pshape->parameters_size(); ++i) {
-    arg_layouts.push_back(pshape->mutable_parameters(i));
-  }
-  xla::CompileOnlyClient::AotXlaComputationInstance instance;
-  instance.computation = &computation;
-  instance.argument_layouts = std::move(arg_layouts);
-  instance.result_layout = &pshape->result();
   xla::StatusOr<std::vector<std::unique_ptr<xla::AotCompilationResult>>>
-      aot_or = client->CompileAheadOfTime({instance}, aot_opts);
+      aot_or = client->CompileAheadOfTime(instances, aot_opts);
   if (!aot_or.ok()) {
     return errors::Unknown("XLA compilation failed: ",
                            aot_or.status().error_message());
   }
-  compile_result->aot =
-      xla::unique_ptr_static_cast<xla::cpu::CpuAotCompilationResult>(
-          std::move(aot_or.ValueOrDie().back()));
-  compile_result->entry_point = aot_opts.entry_point_name();
-  compile_result->pointer_size =
-      xla::CompileOnlyClient::PointerSizeForTriple(aot_opts.triple());
+  for (size_t i = 0; i < computations.size(); ++i) {
+    CompileResult* compile_result = &(*compile_results)[i];
+    compile_result->aot =
+        xla::unique_ptr_static_cast<xla::cpu::CpuAotCompilationResult>(
+            std::move(aot_or.ValueOrDie()[i]));
+    compile_result->entry_point = aot_opts.entry_point_names()[i];
+    compile_result->pointer_size =
+        xla::CompileOnlyClient::PointerSizeForTriple(aot_opts.triple());
+  }
   return Status::OK();
 }
 
-}  // namespace
-
-Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
-                    const MainFlags& flags, CompileResult* compile_result) {
-  // Converts the graph into an XLA computation, and compiles the
-  // computation.
+// Converts the graph into an XLA computation for each of the configs, and
+// compiles the computations.
+Status CompileConfigs(const GraphDef& graph_def,
+                      const std::vector<tf2xla::Config>& configs,
+                      const MainFlags& flags,
+                      std::vector<string> entry_points,
+                      std::vector<CompileResult>* compile_results) {
   // TODO(toddw): Should we let the user pick the XLA cpu vs. gpu client?
   se::Platform* cpu_platform =
       se::MultiPlatformManager::PlatformWithName("Host").ValueOrDie();
   xla::CompileOnlyClient* client =
       xla::ClientLibrary::GetOrCreateCompileOnlyClient(cpu_platform)
           .ValueOrDie();
-  xla::XlaComputation computation;
-  TF_RETURN_IF_ERROR(
-      ConvertGraphDefToXla(graph_def, config, client, &computation));
+  std::vector<xla::XlaComputation> computations(configs.size());
+  for (size_t i = 0; i < configs.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToXla(graph_def, configs[i], client, &computations[i]));
+  }
   if (!flags.out_session_module.empty()) {
     TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloSnapshot> module,
-                        computation.Snapshot());
+                        computations[0].Snapshot());
     // Serialize the HloSnapshot deterministically so that all the outputs of a
     // tf_library genrule are deterministic.
     string proto;
@@ -109,10 +124,62 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
   }
   xla::cpu::CpuAotCompilationOptions aot_opts(
       flags.target_triple, flags.target_cpu, flags.target_features,
-      flags.entry_point,
+      std::move(entry_points),
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
 
-  return CompileXla(client, computation, aot_opts, compile_result);
+  return CompileXla(client, computations, aot_opts, compile_results);
+}
+
+}  // namespace
+
+Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
+                    const MainFlags& flags, CompileResult* compile_result) {
+  // Converts the graph into an XLA computation, and compiles the
+  // computation.
+  std::vector<CompileResult> compile_results;
+  TF_RETURN_IF_ERROR(CompileConfigs(graph_def, {config}, flags,
+                                    {flags.entry_point}, &compile_results));
+  *compile_result = std::move(compile_results[0]);
+  return Status::OK();
+}
+
+Status CompileGraphVariants(const GraphDef& graph_def,
+                            const tf2xla::Config& config,
+                            const MainFlags& flags,
+                            const std::vector<int64>& batch_sizes,
+                            std::vector<CompileResult>* compile_results) {
+  if (batch_sizes.empty()) {
+    return errors::InvalidArgument("Must specify at least one batch size");
+  }
+  std::vector<tf2xla::Config> configs;
+  std::vector<string> entry_points;
+  for (int64 batch_size : batch_sizes) {
+    tf2xla::Config variant_config = config;
+    for (tf2xla::Feed& feed : *variant_config.mutable_feed()) {
+      if (feed.shape().dim_size() > 0) {
+        feed.mutable_shape()->mutable_dim(0)->set_size(batch_size);
+      }
+    }
+    configs.push_back(std::move(variant_config));
+    entry_points.push_back(strings::StrCat(flags.entry_point, "_", batch_size));
+  }
+  return CompileConfigs(graph_def, configs, flags, std::move(entry_points),
+                        compile_results);
+}
+
+Status ParseBatchSizes(const string& batch_sizes, std::vector<int64>* result) {
+  result->clear();
+  for (const string& batch_size : str_util::Split(batch_sizes, ',')) {
+    int64 value;
+    if (!strings::safe_strto64(batch_size, &value) || value <= 0) {
+      return errors::InvalidArgument("Invalid batch size \"", batch_size,
+                                     "\" in: ", batch_sizes);
+    }
+    result->push_back(value);
+  }
+  std::sort(result->begin(), result->end());
+  result->erase(std::unique(result->begin(), result->end()), result->end());
+  return Status::OK();
 }
 
 }  // namespace tfcompile
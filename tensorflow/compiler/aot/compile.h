@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
@@ -45,6 +46,24 @@ struct CompileResult {
 Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
                     const MainFlags& flags, CompileResult* compile_result);
 
+// CompileGraphVariants compiles a variant of the graph_def for each of
+// batch_sizes into a single object file, in which the variants share their
+// constants.  The leading dimension of the non-scalar feeds of each variant is
+// set to its batch size.  compile_results[i] is the variant for batch_sizes[i],
+// whose entry point is the one of the flags suffixed with "_<batch size>".
+//
+// The session module written to flags.out_session_module, if any, is the one
+// of the first variant.
+Status CompileGraphVariants(const GraphDef& graph_def,
+                            const tf2xla::Config& config,
+                            const MainFlags& flags,
+                            const std::vector<int64>& batch_sizes,
+                            std::vector<CompileResult>* compile_results);
+
+// ParseBatchSizes parses `batch_sizes`, a comma-separated list of positive
+// batch sizes, into `result` in increasing order.
+Status ParseBatchSizes(const string& batch_sizes, std::vector<int64>* result);
+
 }  // namespace tfcompile
 }  // namespace tensorflow
 
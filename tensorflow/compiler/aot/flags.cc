@@ -68,6 +68,13 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "function."},
       {"out_session_module", &flags->out_session_module,
        "Output session module proto."},
+      {"batch_sizes", &flags->batch_sizes,
+       "Comma-separated list of batch sizes, e.g. \"1,4,16,64\".  If set, a "
+       "variant of the computation is compiled for each batch size, with the "
+       "leading dimension of the feeds set to it, and all the variants share "
+       "their constants.  The variant classes are named after --cpp_class "
+       "with the batch size as suffix, and --cpp_class names a class that "
+       "picks the smallest variant of at least a given batch size."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
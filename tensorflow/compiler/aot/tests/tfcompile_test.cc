@@ -19,6 +19,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt.h"
+#include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt_batched.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt_saver.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfassert_eq.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfcond.h"
@@ -123,6 +124,40 @@ TEST(TFCompileTest, AddWithCkpt) {
   EXPECT_EQ(add_const.result0_data(), add_const.results()[0]);
 }
 
+TEST(TFCompileTest, AddWithCkptBatched) {
+  EXPECT_EQ(AddWithCkptBatchedComp::kNumVariants, 2);
+  EXPECT_EQ(AddWithCkptBatchedComp::VariantIndex(1), 0);
+  EXPECT_EQ(AddWithCkptBatchedComp::VariantIndex(3), 1);
+  EXPECT_EQ(AddWithCkptBatchedComp::VariantIndex(4), 1);
+  EXPECT_EQ(AddWithCkptBatchedComp::VariantIndex(5), -1);
+  EXPECT_TRUE(AddWithCkptBatchedComp::Create(5) == nullptr);
+
+  AddWithCkptBatchedComp_4 add;
+  for (int i = 0; i < 4; ++i) {
+    add.arg0(i) = i;
+  }
+  EXPECT_TRUE(add.Run());
+  EXPECT_EQ(add.error_msg(), "");
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(add.result0(i), 42 + i);
+  }
+
+  // The dispatcher picks the variant of batch size 4 for 3 elements.
+  std::unique_ptr<XlaCompiledCpuFunction> padded =
+      AddWithCkptBatchedComp::Create(3);
+  ASSERT_TRUE(padded != nullptr);
+  int32* arg = static_cast<int32*>(padded->arg_data(0));
+  for (int i = 0; i < 4; ++i) {
+    arg[i] = 10 * i;
+  }
+  EXPECT_TRUE(padded->Run());
+  EXPECT_EQ(padded->error_msg(), "");
+  const int32* result = static_cast<const int32*>(padded->result_data(0));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(result[i], 10 * i + 42);
+  }
+}
+
 TEST(TFCompileTest, AddWithCkptSaver) {
   AddWithCkptSaverComp add;
   EXPECT_EQ(add.arg0_data(), add.args()[0]);
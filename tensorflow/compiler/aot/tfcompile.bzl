@@ -26,7 +26,8 @@ def tf_library(name, graph, config,
                tfcompile_flags=None,
                tfcompile_tool="//tensorflow/compiler/aot:tfcompile",
                include_standard_runtime_deps=True,
-               enable_xla_hlo_profiling=False, deps=None, tags=None):
+               enable_xla_hlo_profiling=False, batch_sizes=None, deps=None,
+               tags=None):
   """Runs tfcompile to compile a TensorFlow graph into executable code.
 
   Given an invocation of tf_library(name="foo", ...), generates the following
@@ -71,6 +72,11 @@ def tf_library(name, graph, config,
       needed by the generated library.
     enable_xla_hlo_profiling: Enable XLA HLO profiling in the generated program,
       and emit metadata that lets us pretty-print the gathered profile counters.
+    batch_sizes: If provided, a list of batch sizes to compile a variant of the
+      graph for, with the leading dimension of the feeds set to the batch size.
+      The variants share their constants, and cpp_class is a class that creates
+      the smallest variant of at least a given batch size.  The generated test
+      and benchmark use the variant of the smallest batch size.
     deps: a list of deps to include on the build rules for the generated
       library, added to the standard deps if standard_runtime_deps is True.
     tags: tags to apply to subsidiary build rules.
@@ -144,6 +150,8 @@ def tf_library(name, graph, config,
     profiling_flag = "--xla_hlo_profile"
   else:
     profiling_flag = ""
+  if batch_sizes:
+    flags += " --batch_sizes=" + ",".join([str(b) for b in batch_sizes])
   native.genrule(
       name=("gen_" + name),
       srcs=[
@@ -243,15 +251,18 @@ def tf_library(name, graph, config,
   )
 
   # Variables used for gen_test and gen_benchmark.
+  test_cpp_class = cpp_class
+  if batch_sizes:
+    test_cpp_class = cpp_class + "_" + str(sorted(batch_sizes)[0])
   no_ns_name = ""
-  cpp_class_split = cpp_class.rsplit("::", maxsplit=2)
+  cpp_class_split = test_cpp_class.rsplit("::", maxsplit=2)
   if len(cpp_class_split) == 1:
     no_ns_name = cpp_class_split[0]
   else:
     no_ns_name = cpp_class_split[1]
   sed_replace = (
       "-e \"s|{{TFCOMPILE_HEADER}}|$(location " + header_file + ")|g\" " +
-      "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + cpp_class + "|g\" " +
+      "-e \"s|{{TFCOMPILE_CPP_CLASS}}|" + test_cpp_class + "|g\" " +
       "-e \"s|{{TFCOMPILE_NAME}}|" + no_ns_name + "|g\" ")
 
   if gen_test:
@@ -85,12 +85,22 @@ Status Main(const MainFlags& flags) {
   }
   GraphDef graph_def;
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.graph, &graph_def));
-  CompileResult compile_result;
-  TF_RETURN_IF_ERROR(CompileGraph(graph_def, config, flags, &compile_result));
+  std::vector<int64> batch_sizes;
+  if (!flags.batch_sizes.empty()) {
+    TF_RETURN_IF_ERROR(ParseBatchSizes(flags.batch_sizes, &batch_sizes));
+  }
+  std::vector<CompileResult> compile_results(1);
+  if (batch_sizes.empty()) {
+    TF_RETURN_IF_ERROR(
+        CompileGraph(graph_def, config, flags, &compile_results[0]));
+  } else {
+    TF_RETURN_IF_ERROR(CompileGraphVariants(graph_def, config, flags,
+                                            batch_sizes, &compile_results));
+  }
 
-  // Write output files.
+  // Write output files.  The variants, if any, share the same object file.
   Env* env = Env::Default();
-  const std::vector<char>& obj = compile_result.aot->object_file_data();
+  const std::vector<char>& obj = compile_results[0].aot->object_file_data();
   TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_function_object,
                                        StringPiece(obj.data(), obj.size())));
   CodegenOpts codegen_opts;
@@ -105,14 +115,27 @@ Status Main(const MainFlags& flags) {
   TF_RETURN_IF_ERROR(ParseCppClass(flags.cpp_class, &codegen_opts.class_name,
                                    &codegen_opts.namespaces));
 
-  MetadataResult metadata_result;
-  TF_RETURN_IF_ERROR(
-      GenerateMetadata(codegen_opts, compile_result, &metadata_result));
-  TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
-                                       metadata_result.object_file_data));
   string header;
-  TF_RETURN_IF_ERROR(GenerateHeader(codegen_opts, config, compile_result,
-                                    metadata_result, &header));
+  if (batch_sizes.empty()) {
+    MetadataResult metadata_result;
+    TF_RETURN_IF_ERROR(
+        GenerateMetadata(codegen_opts, compile_results[0], &metadata_result));
+    TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
+                                         metadata_result.object_file_data));
+    TF_RETURN_IF_ERROR(GenerateHeader(codegen_opts, config, compile_results[0],
+                                      metadata_result, &header));
+  } else {
+    std::vector<MetadataResult> metadata_results;
+    string metadata_object_file_data;
+    TF_RETURN_IF_ERROR(GenerateVariantsMetadata(
+        codegen_opts, batch_sizes, compile_results, &metadata_results,
+        &metadata_object_file_data));
+    TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
+                                         metadata_object_file_data));
+    TF_RETURN_IF_ERROR(GenerateVariantsHeader(codegen_opts, config,
+                                              batch_sizes, compile_results,
+                                              metadata_results, &header));
+  }
   TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_header, header));
   return Status::OK();
 }
@@ -33,8 +33,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
 namespace tensorflow {
@@ -59,6 +61,15 @@ XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
   } else {
     platform_id_ = nullptr;
   }
+  OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar("TF_XLA_ASYNC_COMPILATION", false,
+                                         &async_compilation_));
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar("TF_XLA_MAX_CONCURRENT_COMPILES", 1,
+                                          &max_concurrent_compiles_));
+  string shape_buckets;
+  OP_REQUIRES_OK(
+      ctx, ReadStringFromEnvVar("TF_XLA_SHAPE_BUCKETS", "", &shape_buckets));
+  OP_REQUIRES_OK(ctx,
+                 ShapeBucketingPolicy::Parse(shape_buckets, &shape_bucketing_));
 }
 
 Status XlaLocalLaunchBase::BuildCompilationCache(OpKernelContext* ctx,
@@ -94,6 +105,45 @@ Status XlaLocalLaunchBase::BuildCompilationCache(OpKernelContext* ctx,
   return Status::OK();
 }
 
+void XlaLocalLaunchBase::RunFunction(OpKernelContext* ctx) {
+  FunctionLibraryRuntime* lib = ctx->function_library();
+  OP_REQUIRES(ctx, lib != nullptr,
+              errors::Internal("No function library is provided."));
+  FunctionLibraryRuntime::Handle handle;
+  OP_REQUIRES_OK(ctx, lib->Instantiate(function_.name(),
+                                       AttrSlice(&function_.attr()), &handle));
+
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.rendezvous = ctx->rendezvous();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  opts.step_container = ctx->step_container();
+  opts.stats_collector = ctx->stats_collector();
+  opts.runner = ctx->runner();
+
+  // The arguments of the function are the inputs of the op, in order.
+  std::vector<Tensor> args;
+  args.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    args.push_back(ctx->input(i));
+  }
+  std::vector<Tensor> rets;
+  Notification done;
+  Status status;
+  lib->Run(opts, handle, args, &rets, [&done, &status](const Status& s) {
+    status = s;
+    done.Notify();
+  });
+  done.WaitForNotification();
+  OP_REQUIRES_OK(ctx, status);
+  OP_REQUIRES(ctx, rets.size() == ctx->num_outputs(),
+              errors::Internal("The function returned ", rets.size(),
+                               " values, expected ", ctx->num_outputs()));
+  for (int i = 0; i < rets.size(); ++i) {
+    ctx->set_output(i, rets[i]);
+  }
+}
+
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   VLOG(1) << "XlaLocalLaunchOpBase::Compute "
           << Canonicalize(function_.name(), AttrSlice(&function_.attr()));
@@ -179,15 +229,43 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   // rather than a one-element tuple.
   compile_options.always_return_tuple = false;
 
-  OP_REQUIRES_OK(
-      ctx, cache->Compile(options, function_, constant_args, variables, ctx,
-                          &kernel, &executable, &compile_options));
+  // Pad the batch of the inputs to a bucket, to bound the number of
+  // compilations.
+  BatchPadding batch_padding;
+  bool padded = false;
+  if (shape_bucketing_.enabled() && !allocate_xla_tensors) {
+    std::vector<int> skipped_inputs(constants_);
+    skipped_inputs.insert(skipped_inputs.end(), resources_.begin(),
+                          resources_.end());
+    OP_REQUIRES_OK(ctx, PadBatch(ctx, shape_bucketing_, skipped_inputs,
+                                 &batch_padding, &padded));
+  }
+  const BatchPadding* padding = padded ? &batch_padding : nullptr;
+
+  // The function can run without XLA unless it is on an XLA device, or needs
+  // constants in host memory on a non-CPU device.
+  if (async_compilation_ && !allocate_xla_tensors &&
+      (device_type_ == DeviceType(DEVICE_CPU) || constants_.empty())) {
+    OP_REQUIRES_OK(ctx, cache->CompileAsync(options, function_, constant_args,
+                                            variables, ctx, &kernel,
+                                            &executable, &compile_options,
+                                            max_concurrent_compiles_, padding));
+    if (kernel == nullptr) {
+      VLOG(1) << "Running the function until its compilation is done";
+      RunFunction(ctx);
+      return;
+    }
+  } else {
+    OP_REQUIRES_OK(
+        ctx, cache->Compile(options, function_, constant_args, variables, ctx,
+                            &kernel, &executable, &compile_options, padding));
+  }
 
   VLOG(1) << "Executing XLA Computation...";
 
   XlaComputationLaunchContext launch_context(
       client, xla_allocator, allocate_xla_tensors, use_multiple_streams);
-  launch_context.PopulateInputs(ctx, kernel, variables);
+  launch_context.PopulateInputs(ctx, kernel, variables, padding);
 
   // Execute the computation.
   VLOG(2) << "Executing computation.";
@@ -205,7 +283,8 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   auto elapsed = env->NowMicros() - start_time;
   VLOG(2) << "Elapsed time: " << elapsed << "us";
 
-  launch_context.PopulateOutputs(ctx, kernel, run_result.ConsumeValueOrDie());
+  launch_context.PopulateOutputs(ctx, kernel, run_result.ConsumeValueOrDie(),
+                                 padding);
   VLOG(1) << "Done";
 }
 
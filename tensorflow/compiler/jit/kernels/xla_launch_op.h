@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/jit/xla_shape_bucketing.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -51,6 +52,10 @@ class XlaLocalLaunchBase : public OpKernel {
   Status BuildCompilationCache(OpKernelContext* ctx,
                                XlaCompilationCache** cache);
 
+  // Runs the function with the TensorFlow executor instead of XLA, e.g. while
+  // it is being compiled in the background.
+  void RunFunction(OpKernelContext* ctx);
+
   // Indexes of compile-time constant inputs
   std::vector<int> constants_;
   // Indexes of resource inputs
@@ -59,6 +64,17 @@ class XlaLocalLaunchBase : public OpKernel {
   DeviceType device_type_;
   NameAttrList function_;
   se::Platform::Id platform_id_;
+
+  // If true, new signatures are compiled in the background, and the function
+  // runs without XLA until they are compiled. Set by the
+  // TF_XLA_ASYNC_COMPILATION environment variable.
+  bool async_compilation_ = false;
+  // The maximum number of background compilations of the process, set by the
+  // TF_XLA_MAX_CONCURRENT_COMPILES environment variable.
+  int64 max_concurrent_compiles_ = 1;
+  // The buckets to which the batch size of the inputs is padded, set by the
+  // TF_XLA_SHAPE_BUCKETS environment variable (see ShapeBucketingPolicy).
+  ShapeBucketingPolicy shape_bucketing_;
 };
 
 // XlaLocalLaunchOp is used to replace a region of the TensorFlow graph
@@ -55,6 +55,10 @@ typedef struct {
                             // is set to ON* and overrides its behavior. If
                             // true, enable fusion of element-wise operations
                             // only using XLA.
+  bool tf_xla_cost_based_clustering;  // If true, don't compile the automatic
+                                      // clusters that a cost model estimates
+                                      // are unprofitable, e.g. the ones built
+                                      // around convolutions and matmuls.
 } MarkForCompilationPassFlags;
 
 // Return a pointer to the MarkForCompilationPassFlags struct;
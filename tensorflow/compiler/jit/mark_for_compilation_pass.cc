@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/mark_for_compilation_pass.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <limits>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -518,49 +520,26 @@ static bool IsShapeConsumerOp(const Node& node) {
          node.type_string() == "Size";
 }
 
-// Sequence number generator to ensure clusters have unique names.
-static std::atomic<int64> cluster_sequence_num;
-
-Status MarkForCompilationPass::RunImpl(
-    const GraphOptimizationPassOptions& options,
-    const std::function<bool(const Node*, const DeviceType&)>&
-        is_compilable_fn) {
-  VLOG(1) << "MarkForCompilationPass::Run";
-
-  // Make sure that kernels have been registered on the JIT device.
-  XlaOpRegistry::RegisterCompilationKernels();
-
-  Graph* graph = options.graph->get();
-
-  OrderedNodeSet compilation_candidates;
-  TF_RETURN_IF_ERROR(FindCompilationCandidates(
-      *graph, options.flib_def,
-      (options.session_options != nullptr) ? options.session_options->env
-                                           : Env::Default(),
-      is_compilable_fn, &compilation_candidates));
-
-  if (compilation_candidates.empty()) {
-    VLOG(2) << "No compilable candidates";
-    return Status::OK();
-  }
-
+// Puts each of the `candidates` in a cluster, contracting the edges between
+// the clusters of `graph` as long as it doesn't create a cycle.
+static Status ClusterCandidates(Graph* graph, const OrderedNodeSet& candidates,
+                                int max_cluster_size,
+                                std::vector<UnionFind<Cluster>>* clusters) {
   GraphCycles cycles;
   TF_RETURN_IF_ERROR(CreateCycleDetectionGraph(graph, &cycles));
 
   // Each compilation candidate belongs to a cluster. The cluster's
   // representative
   // names the node in the 'cycles' graph that represents the cluster.
-  std::vector<UnionFind<Cluster>> clusters(graph->num_node_ids());
+  clusters->clear();
+  clusters->resize(graph->num_node_ids());
   std::deque<UnionFind<Cluster>*> worklist;
-  for (Node* node : compilation_candidates) {
-    Cluster& cluster = clusters[node->id()].Get();
+  for (Node* node : candidates) {
+    Cluster& cluster = (*clusters)[node->id()].Get();
     cluster.representative = node->id();
-    worklist.push_back(&clusters[node->id()]);
+    worklist.push_back(&(*clusters)[node->id()]);
   }
 
-  legacy_flags::MarkForCompilationPassFlags* flags =
-      legacy_flags::GetMarkForCompilationPassFlags();
-
   // Repeatedly contract edges between clusters that are on the same device,
   // provided the contraction would not create a cycle.
   //
@@ -587,8 +566,7 @@ Status MarkForCompilationPass::RunImpl(
         continue;
       }
       Node* node_to = graph->FindNodeId(to);
-      if (compilation_candidates.find(node_to) ==
-          compilation_candidates.cend()) {
+      if (candidates.find(node_to) == candidates.cend()) {
         continue;
       }
       if (node_from->assigned_device_name() !=
@@ -611,13 +589,13 @@ Status MarkForCompilationPass::RunImpl(
 
       // Ops that consume shapes cannot be the root of a cluster. This is an
       // optimization.
-      if (clusters[from].Size() == 1 && IsShapeConsumerOp(*node_from)) {
+      if ((*clusters)[from].Size() == 1 && IsShapeConsumerOp(*node_from)) {
         continue;
       }
 
       // Don't exceed the maximum cluster size.
-      if (clusters[from].Size() + clusters[to].Size() >
-          flags->tf_xla_max_cluster_size) {
+      if ((*clusters)[from].Size() + (*clusters)[to].Size() >
+          max_cluster_size) {
         continue;
       }
 
@@ -630,12 +608,180 @@ Status MarkForCompilationPass::RunImpl(
 
       // Merge the clusters. ContractEdge uses 'from' as the number of the
       // merged node, so make sure 'from' is the chosen representative.
-      clusters[from].Merge(&clusters[to]);
+      (*clusters)[from].Merge(&(*clusters)[to]);
 
-      worklist.push_back(&clusters[from]);
+      worklist.push_back(&(*clusters)[from]);
       break;
     }
   }
+  return Status::OK();
+}
+
+// Is 'node' an operator that XLA implements with the same library calls
+// (cuDNN, cuBLAS, Eigen) as the TensorFlow kernel? Compiling such an operator
+// gains nothing by itself, and can cost layout changes around it.
+static bool IsLibraryBoundOp(const Node& node) {
+  static const std::unordered_set<string>* library_bound_ops =
+      new std::unordered_set<string>(
+          {"Conv2D", "Conv2DBackpropFilter", "Conv2DBackpropInput", "Conv3D",
+           "Conv3DBackpropFilterV2", "Conv3DBackpropInputV2",
+           "DepthwiseConv2dNative", "DepthwiseConv2dNativeBackpropFilter",
+           "DepthwiseConv2dNativeBackpropInput", "MatMul", "BatchMatMul",
+           "FusedBatchNorm", "FusedBatchNormV2", "FusedBatchNormGrad",
+           "FusedBatchNormGradV2"});
+  return library_bound_ops->count(node.type_string()) > 0;
+}
+
+// The number of operators a cluster must fuse per library-bound operator to
+// be worth compiling.
+static const int kFusedOpsPerLibraryBoundOp = 2;
+
+// A static estimate of whether compiling the cluster made of `members` is
+// profitable. XLA gains by fusing elementwise operators, each of which then
+// saves a kernel launch and a round trip of its input through memory. A
+// fusable operator counts as fused if one of its inputs is produced by another
+// fusable operator of the cluster.
+static bool IsProfitableCluster(const std::vector<Node*>& members) {
+  auto is_fusable = [](const Node* n) {
+    return IsXlaFusable(n->def()) && !n->IsConstant() && !n->IsIdentity();
+  };
+  std::unordered_set<const Node*> fusable_members;
+  int num_library_bound_ops = 0;
+  for (const Node* n : members) {
+    if (is_fusable(n)) {
+      fusable_members.insert(n);
+    } else if (IsLibraryBoundOp(*n)) {
+      ++num_library_bound_ops;
+    }
+  }
+  int num_fused_ops = 0;
+  for (const Node* n : fusable_members) {
+    for (const Edge* e : n->in_edges()) {
+      if (!e->IsControlEdge() && fusable_members.count(e->src()) > 0) {
+        ++num_fused_ops;
+        break;
+      }
+    }
+  }
+  return num_fused_ops >= kFusedOpsPerLibraryBoundOp * num_library_bound_ops;
+}
+
+// Sets `*marked_for_compilation` if the user marked `node` _XlaCompile=true,
+// and `*requires_compilation` if `node` is placed on a device that requires
+// compilation.
+static Status GetCompilationRequirements(const Node& node,
+                                         const FunctionLibraryDefinition& fld,
+                                         bool* marked_for_compilation,
+                                         bool* requires_compilation) {
+  bool compile_attr = false;
+  *marked_for_compilation = false;
+  if (GetNodeAttr(node.attrs(), kXlaCompileAttr, &compile_attr).ok()) {
+    *marked_for_compilation = compile_attr;
+  } else if (fld.GetAttr(node, kXlaCompileAttr, &compile_attr).ok()) {
+    *marked_for_compilation = compile_attr;
+  }
+
+  DeviceType device_type("");
+  TF_RETURN_IF_ERROR(
+      DeviceToDeviceType(node.assigned_device_name(), &device_type));
+  const XlaOpRegistry::DeviceRegistration* registration;
+  XlaOpRegistry::GetCompilationDevice(device_type.type(), &registration);
+  *requires_compilation = registration->requires_compilation;
+  return Status::OK();
+}
+
+// Removes the library-bound operators of the clusters of
+// `compilation_candidates` that would be compiled automatically but aren't
+// profitable, and clusters the remaining candidates again, until all the
+// clusters are profitable. The clusters explicitly marked for compilation or
+// placed on a device that requires compilation are kept as they are.
+static Status SplitUnprofitableClusters(
+    Graph* graph, const FunctionLibraryDefinition& fld, int min_cluster_size,
+    int max_cluster_size, OrderedNodeSet* compilation_candidates,
+    std::vector<UnionFind<Cluster>>* clusters) {
+  while (true) {
+    // The members of each cluster, by representative.
+    std::map<int, std::vector<Node*>> cluster_members;
+    std::unordered_set<int> explicit_clusters;
+    for (Node* n : *compilation_candidates) {
+      int cluster = (*clusters)[n->id()].Get().representative;
+      cluster_members[cluster].push_back(n);
+      bool marked_for_compilation, requires_compilation;
+      TF_RETURN_IF_ERROR(GetCompilationRequirements(
+          *n, fld, &marked_for_compilation, &requires_compilation));
+      if (marked_for_compilation || requires_compilation) {
+        explicit_clusters.insert(cluster);
+      }
+    }
+
+    std::vector<Node*> removed;
+    for (const auto& it : cluster_members) {
+      const std::vector<Node*>& members = it.second;
+      const int effective_size = std::count_if(
+          members.begin(), members.end(),
+          [](const Node* n) { return n->def().op() != "Identity"; });
+      if (explicit_clusters.count(it.first) > 0 ||
+          effective_size < min_cluster_size || IsProfitableCluster(members)) {
+        continue;
+      }
+      for (Node* n : members) {
+        if (IsLibraryBoundOp(*n)) removed.push_back(n);
+      }
+    }
+    if (removed.empty()) return Status::OK();
+
+    for (Node* n : removed) {
+      VLOG(2) << "Not compiling " << n->name() << ": " << n->type_string()
+              << " in an unprofitable cluster";
+      compilation_candidates->erase(n);
+    }
+    TF_RETURN_IF_ERROR(ClusterCandidates(graph, *compilation_candidates,
+                                         max_cluster_size, clusters));
+  }
+}
+
+// Sequence number generator to ensure clusters have unique names.
+static std::atomic<int64> cluster_sequence_num;
+
+Status MarkForCompilationPass::RunImpl(
+    const GraphOptimizationPassOptions& options,
+    const std::function<bool(const Node*, const DeviceType&)>&
+        is_compilable_fn) {
+  VLOG(1) << "MarkForCompilationPass::Run";
+
+  // Make sure that kernels have been registered on the JIT device.
+  XlaOpRegistry::RegisterCompilationKernels();
+
+  Graph* graph = options.graph->get();
+
+  OrderedNodeSet compilation_candidates;
+  TF_RETURN_IF_ERROR(FindCompilationCandidates(
+      *graph, options.flib_def,
+      (options.session_options != nullptr) ? options.session_options->env
+                                           : Env::Default(),
+      is_compilable_fn, &compilation_candidates));
+
+  if (compilation_candidates.empty()) {
+    VLOG(2) << "No compilable candidates";
+    return Status::OK();
+  }
+
+  legacy_flags::MarkForCompilationPassFlags* flags =
+      legacy_flags::GetMarkForCompilationPassFlags();
+
+  // Each compilation candidate belongs to a cluster. The cluster's
+  // representative names the node in the cycle detection graph that
+  // represents the cluster.
+  std::vector<UnionFind<Cluster>> clusters;
+  TF_RETURN_IF_ERROR(ClusterCandidates(graph, compilation_candidates,
+                                       flags->tf_xla_max_cluster_size,
+                                       &clusters));
+
+  if (flags->tf_xla_cost_based_clustering) {
+    TF_RETURN_IF_ERROR(SplitUnprofitableClusters(
+        graph, *options.flib_def, flags->tf_xla_min_cluster_size,
+        flags->tf_xla_max_cluster_size, &compilation_candidates, &clusters));
+  }
 
   // Count the number of non-trivial elements in each cluster.
   std::vector<int> effective_cluster_sizes(graph->num_node_ids());
@@ -660,23 +806,12 @@ Status MarkForCompilationPass::RunImpl(
   for (Node* n : compilation_candidates) {
     int cluster = clusters[n->id()].Get().representative;
 
-    // Compile if the user marked this node _XlaCompile=true
-    bool compile_attr = false;
-    bool marked_for_compilation = false;
-    if (GetNodeAttr(n->attrs(), kXlaCompileAttr, &compile_attr).ok()) {
-      marked_for_compilation = compile_attr;
-    } else if (options.flib_def->GetAttr(*n, kXlaCompileAttr, &compile_attr)
-                   .ok()) {
-      marked_for_compilation = compile_attr;
-    }
-
-    // Compile if this operator is placed on a device that requires
-    // compilation.
-    DeviceType device_type("");
-    TF_RETURN_IF_ERROR(
-        DeviceToDeviceType(n->assigned_device_name(), &device_type));
-    const XlaOpRegistry::DeviceRegistration* registration;
-    XlaOpRegistry::GetCompilationDevice(device_type.type(), &registration);
+    // Compile if the user marked this node _XlaCompile=true, or if this
+    // operator is placed on a device that requires compilation.
+    bool marked_for_compilation, requires_compilation;
+    TF_RETURN_IF_ERROR(GetCompilationRequirements(*n, *options.flib_def,
+                                                  &marked_for_compilation,
+                                                  &requires_compilation));
 
     // Compile if this is a cluster of >= min_cluster_size compilable operators.
     // Also, always compile if the operator is placed on a device that requires
@@ -684,7 +819,7 @@ Status MarkForCompilationPass::RunImpl(
     // compilation that is not an Identity op.
     if (effective_cluster_sizes[cluster] >= min_cluster_size ||
         (effective_cluster_sizes[cluster] > 0 && marked_for_compilation) ||
-        registration->requires_compilation) {
+        requires_compilation) {
       string& name = cluster_names[cluster];
 
       if (name.empty()) {
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/legacy_flags/mark_for_compilation_pass_flags.h"
 #include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -98,6 +99,44 @@ TEST(XlaCompilationTest, Chains) {
   EXPECT_TRUE(clusters.find("D") == clusters.cend());
 }
 
+TEST(XlaCompilationTest, CostBasedClustering) {
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  GraphDef graphdef;
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* a =
+        ops::SourceOp("UncompilableNullary", builder.opts().WithName("A"));
+    Node* b =
+        ops::SourceOp("UncompilableNullary", builder.opts().WithName("B"));
+    // A matmul followed by a single elementwise op gains nothing from XLA.
+    Node* c = ops::BinaryOp("MatMul", a, b, builder.opts().WithName("C"));
+    Node* d = ops::UnaryOp("Relu", c, builder.opts().WithName("D"));
+    ops::UnaryOp("UncompilableUnary", d, builder.opts().WithName("E"));
+    // A matmul followed by a chain of elementwise ops does.
+    Node* f = ops::BinaryOp("MatMul", a, b, builder.opts().WithName("F"));
+    Node* g = ops::UnaryOp("Relu", f, builder.opts().WithName("G"));
+    Node* h = ops::UnaryOp("Sigmoid", g, builder.opts().WithName("H"));
+    ops::UnaryOp("Tanh", h, builder.opts().WithName("I"));
+    TF_EXPECT_OK(GraphDefBuilderToGraph(builder, graph.get()));
+  }
+
+  legacy_flags::MarkForCompilationPassFlags* flags =
+      legacy_flags::GetMarkForCompilationPassFlags();
+  flags->tf_xla_cost_based_clustering = true;
+  Status status = MarkForCompilation(&graph);
+  flags->tf_xla_cost_based_clustering = false;
+  TF_ASSERT_OK(status);
+  auto clusters = GetClusters(*graph);
+
+  EXPECT_EQ(4, clusters.size());
+  EXPECT_TRUE(clusters.find("C") == clusters.cend());
+  EXPECT_TRUE(clusters.find("D") == clusters.cend());
+  EXPECT_FALSE(clusters["F"].empty());
+  EXPECT_EQ(clusters["F"], clusters["G"]);
+  EXPECT_EQ(clusters["F"], clusters["H"]);
+  EXPECT_EQ(clusters["F"], clusters["I"]);
+}
+
 TEST(XlaCompilationTest, UncompilableCycles) {
   std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
   GraphDef graphdef;
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <numeric>
 
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
 #include "tensorflow/compiler/tf2xla/dump_graph.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/type_util.h"
@@ -30,16 +31,26 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : client_(client), device_type_(std::move(device_type)) {
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_XLA_PERSISTENT_CACHE_DIR", "",
+                                   &persistent_cache_dir_));
+}
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
@@ -107,10 +118,19 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
   return h;
 }
 
+namespace {
+
+// Returns input `i` of `ctx`, padded if `padding` is non-null.
+const Tensor& Input(OpKernelContext* ctx, const BatchPadding* padding, int i) {
+  return padding ? padding->input(ctx, i) : ctx->input(i);
+}
+
+}  // namespace
+
 Status XlaCompilationCache::BuildSignature(
     const NameAttrList& function, const std::map<int, Tensor>& constant_args,
     const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
-    Signature* signature) {
+    const BatchPadding* padding, Signature* signature) {
   signature->name = Canonicalize(function.name(), AttrSlice(&function.attr()));
   signature->arg_values.reserve(constant_args.size());
 
@@ -130,7 +150,7 @@ Status XlaCompilationCache::BuildSignature(
       }
     } else {
       signature->arg_types.emplace_back(ctx->input_dtype(i),
-                                        ctx->input(i).shape());
+                                        Input(ctx, padding, i).shape());
     }
   }
   return Status::OK();
@@ -141,7 +161,7 @@ namespace {
 // Builds a XlaCompiler::Argument vector from the arguments to the XlaLaunch op.
 Status BuildArguments(const std::map<int, Tensor>& constant_args,
                       const std::map<int, OptionalTensor>& variable_args,
-                      OpKernelContext* ctx,
+                      OpKernelContext* ctx, const BatchPadding* padding,
                       std::vector<XlaCompiler::Argument>* args) {
   args->resize(ctx->num_inputs());
 
@@ -157,7 +177,7 @@ Status BuildArguments(const std::map<int, Tensor>& constant_args,
       arg.constant_value = input;
     } else if (variable_args.count(input_num) == 0) {
       // Handles the non-constant arguments.
-      const Tensor& input = ctx->input(input_num);
+      const Tensor& input = Input(ctx, padding, input_num);
       TF_RET_CHECK(input.dtype() != DT_RESOURCE);
       if (input.NumElements() > 0) {
         arg.kind = XlaCompiler::Argument::kParameter;
@@ -197,6 +217,192 @@ Status BuildArguments(const std::map<int, Tensor>& constant_args,
 
 }  // namespace
 
+namespace {
+
+auto* xla_compilations = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilations",
+    "The number of XLA compilations of each function, e.g. to tune the shape "
+    "buckets.",
+    "function");
+
+// Bump this when the format of the persistent cache entries or the meaning of
+// their key changes.
+const int kPersistentCacheVersion = 1;
+
+string Fingerprint128String(StringPiece data) {
+  const Fprint128 fingerprint = Fingerprint128(data);
+  return strings::Printf("%016llx%016llx",
+                         static_cast<unsigned long long>(fingerprint.high64),
+                         static_cast<unsigned long long>(fingerprint.low64));
+}
+
+uint64 ComputationFingerprint(const xla::HloModuleProto& computation) {
+  string serialized;
+  SerializeToStringDeterministic(computation, &serialized);
+  return Fingerprint64(serialized);
+}
+
+void CompilationResultToProto(const XlaCompiler::CompilationResult& result,
+                              XlaCompilationCacheEntry* entry) {
+  for (int index : result.input_mapping) {
+    entry->add_input_mapping(index);
+  }
+  for (const xla::Shape& shape : result.xla_input_shapes) {
+    *entry->add_xla_input_shapes() = shape;
+  }
+  *entry->mutable_xla_output_shape() = result.xla_output_shape;
+  for (const XlaCompiler::OutputDescription& output : result.outputs) {
+    XlaCompilationCacheEntry::OutputDescription* proto = entry->add_outputs();
+    proto->set_type(output.type);
+    output.shape.AsProto(proto->mutable_shape());
+    proto->set_is_constant(output.is_constant);
+    if (output.is_constant) {
+      output.constant_value.AsProtoTensorContent(
+          proto->mutable_constant_value());
+    }
+  }
+  *entry->mutable_host_compute_metadata() = result.host_compute_metadata;
+  for (const XlaCompiler::ResourceUpdate& update : result.resource_updates) {
+    XlaCompilationCacheEntry::ResourceUpdate* proto =
+        entry->add_resource_updates();
+    proto->set_input_index(update.input_index);
+    proto->set_type(update.type);
+    update.shape.AsProto(proto->mutable_shape());
+    proto->set_modified(update.modified);
+    for (const string& gradient : update.tensor_array_gradients_accessed) {
+      proto->add_tensor_array_gradients_accessed(gradient);
+    }
+  }
+  *entry->mutable_computation() = result.computation->proto();
+}
+
+Status CompilationResultFromProto(const XlaCompilationCacheEntry& entry,
+                                  XlaCompiler::CompilationResult* result) {
+  result->input_mapping.assign(entry.input_mapping().begin(),
+                               entry.input_mapping().end());
+  result->xla_input_shapes.assign(entry.xla_input_shapes().begin(),
+                                  entry.xla_input_shapes().end());
+  result->xla_output_shape = entry.xla_output_shape();
+  result->outputs.clear();
+  for (const auto& proto : entry.outputs()) {
+    XlaCompiler::OutputDescription output;
+    output.type = proto.type();
+    output.shape = TensorShape(proto.shape());
+    output.is_constant = proto.is_constant();
+    if (output.is_constant &&
+        !output.constant_value.FromProto(proto.constant_value())) {
+      return errors::DataLoss("Invalid constant output");
+    }
+    result->outputs.push_back(std::move(output));
+  }
+  result->host_compute_metadata = entry.host_compute_metadata();
+  result->resource_updates.clear();
+  for (const auto& proto : entry.resource_updates()) {
+    XlaCompiler::ResourceUpdate update;
+    update.input_index = proto.input_index();
+    update.type = proto.type();
+    update.shape = TensorShape(proto.shape());
+    update.modified = proto.modified();
+    update.tensor_array_gradients_accessed.insert(
+        proto.tensor_array_gradients_accessed().begin(),
+        proto.tensor_array_gradients_accessed().end());
+    result->resource_updates.push_back(std::move(update));
+  }
+  result->computation =
+      std::make_shared<xla::XlaComputation>(entry.computation());
+  return Status::OK();
+}
+
+}  // namespace
+
+string XlaCompilationCache::PersistentKey(
+    const XlaCompiler::Options& options, const Signature& signature,
+    const XlaCompiler::CompileOptions& compile_options,
+    bool compile_single_op) {
+  const int flags = (compile_single_op << 0) |
+                    (options.allow_cpu_custom_calls << 1) |
+                    (compile_options.use_tuple_arg << 2) |
+                    (compile_options.return_updated_values_for_all_resources
+                     << 3) |
+                    (compile_options.resolve_compile_time_constants << 4) |
+                    (compile_options.always_return_tuple << 5) |
+                    (compile_options.is_entry_computation << 6);
+  string key = strings::StrCat(
+      kPersistentCacheVersion, ";", device_type_.type(), ";",
+      client_->platform()->Name(), ";", options.graph_def_version, ";", flags,
+      ";", signature.name);
+  for (const auto& a : signature.arg_types) {
+    strings::StrAppend(&key, ",", DataTypeString(a.first),
+                       a.second.DebugString());
+  }
+  // The constant arguments are keyed by value, and the functions by the
+  // fingerprint of their definitions.
+  for (const Tensor& v : signature.arg_values) {
+    TensorProto proto;
+    v.AsProtoTensorContent(&proto);
+    string serialized;
+    SerializeToStringDeterministic(proto, &serialized);
+    strings::StrAppend(&key, ";", serialized.size(), ":", serialized);
+  }
+  if (options.flib_def != nullptr) {
+    string serialized;
+    SerializeToStringDeterministic(options.flib_def->ToProto(), &serialized);
+    strings::StrAppend(&key, ";", Fingerprint128String(serialized));
+  }
+  return key;
+}
+
+Status XlaCompilationCache::LoadPersistentEntry(
+    const string& key, XlaCompiler::CompilationResult* result) {
+  const string filename =
+      io::JoinPath(persistent_cache_dir_, Fingerprint128String(key));
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->FileExists(filename));
+  XlaCompilationCacheEntry entry;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, filename, &entry));
+  if (entry.key() != key) {
+    return errors::NotFound("The cached compilation ", filename,
+                            " is for another computation");
+  }
+  if (ComputationFingerprint(entry.computation()) !=
+      entry.computation_fingerprint()) {
+    return errors::DataLoss("The cached compilation ", filename,
+                            " is corrupted");
+  }
+  return CompilationResultFromProto(entry, result);
+}
+
+void XlaCompilationCache::SavePersistentEntry(
+    const string& key, const XlaCompiler::CompilationResult& result) {
+  if (result.computation == nullptr) {
+    return;
+  }
+  XlaCompilationCacheEntry entry;
+  entry.set_key(key);
+  CompilationResultToProto(result, &entry);
+  entry.set_computation_fingerprint(
+      ComputationFingerprint(entry.computation()));
+
+  // Write to a temporary file first, so that other processes never read a
+  // partial entry.
+  Env* env = Env::Default();
+  const string filename =
+      io::JoinPath(persistent_cache_dir_, Fingerprint128String(key));
+  const string tmp_filename =
+      strings::StrCat(filename, ".tmp", env->NowMicros());
+  Status s = env->RecursivelyCreateDir(persistent_cache_dir_);
+  if (s.ok() || errors::IsAlreadyExists(s)) {
+    s = WriteBinaryProto(env, tmp_filename, entry);
+  }
+  if (s.ok()) {
+    s = env->RenameFile(tmp_filename, filename);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to cache the XLA compilation in " << filename
+                 << ": " << s;
+  }
+}
+
 Status XlaCompilationCache::BuildExecutable(
     const XlaCompiler::Options& options,
     const XlaCompiler::CompilationResult& result,
@@ -222,15 +428,163 @@ Status XlaCompilationCache::BuildExecutable(
   return Status::OK();
 }
 
+XlaCompilationCache::Entry* XlaCompilationCache::LookupOrCreateEntry(
+    const Signature& signature) {
+  // The outer lock protects the existence of the cache entry. It does not
+  // protect the contents of the cache entry.
+  mutex_lock lock(mu_);
+  // Find or create a cache entry.
+  std::unique_ptr<Entry>& e = cache_[signature];
+  if (!e) {
+    e.reset(new Entry);
+  }
+  return e.get();
+}
+
+Status XlaCompilationCache::CompileToResult(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    const Signature& signature, const std::vector<XlaCompiler::Argument>& args,
+    const XlaCompiler::CompileOptions& compile_options, bool compile_single_op,
+    OpKernelContext* ctx, XlaCompiler::CompilationResult* result) {
+  string persistent_key;
+  if (!persistent_cache_dir_.empty()) {
+    persistent_key =
+        PersistentKey(options, signature, compile_options, compile_single_op);
+    Status s = LoadPersistentEntry(persistent_key, result);
+    if (s.ok()) {
+      VLOG(1) << "Loaded the compilation from the persistent cache";
+      return Status::OK();
+    }
+    if (!errors::IsNotFound(s)) {
+      LOG(WARNING) << "Ignoring the persistent cache entry: " << s;
+    }
+    *result = XlaCompiler::CompilationResult();
+  }
+
+  xla_compilations->GetCell(function.name())->IncrementBy(1);
+  XlaCompiler compiler(options);
+  Status status;
+  if (compile_single_op) {
+    status = compiler.CompileSingleOp(compile_options, signature.name, ctx,
+                                      args, result);
+  } else {
+    status = compiler.CompileFunction(compile_options, function, args, result);
+  }
+  if (status.ok() && !persistent_key.empty()) {
+    SavePersistentEntry(persistent_key, *result);
+  }
+  return status;
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     const std::map<int, Tensor>& constant_args,
     const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
     const XlaCompiler::CompilationResult** compilation_result,
     xla::LocalExecutable** executable,
-    const XlaCompiler::CompileOptions* compile_options) {
+    const XlaCompiler::CompileOptions* compile_options,
+    const BatchPadding* padding) {
   return CompileImpl(options, function, constant_args, variable_args, ctx,
-                     compilation_result, executable, compile_options, false);
+                     compilation_result, executable, compile_options, false,
+                     padding);
+}
+
+Status XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    const std::map<int, Tensor>& constant_args,
+    const std::map<int, OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable,
+    const XlaCompiler::CompileOptions* compile_options,
+    int max_concurrent_compiles, const BatchPadding* padding) {
+  *compilation_result = nullptr;
+  *executable = nullptr;
+  TF_RET_CHECK(constant_args.size() + variable_args.size() <=
+               ctx->num_inputs());
+
+  Signature signature;
+  TF_RETURN_IF_ERROR(BuildSignature(function, constant_args, variable_args,
+                                    ctx, padding, &signature));
+  Entry* entry = LookupOrCreateEntry(signature);
+
+  mutex_lock entry_lock(entry->mu);
+  if (entry->compiled) {
+    *compilation_result = &entry->compilation_result;
+    if (entry->compilation_status.ok() && entry->executable == nullptr) {
+      // Compiled by Compile() without an executable.
+      entry->compilation_status = BuildExecutable(
+          options, entry->compilation_result, &entry->executable);
+    }
+    *executable = entry->executable.get();
+    return entry->compilation_status;
+  }
+  if (entry->compiling) {
+    return Status::OK();
+  }
+  {
+    mutex_lock lock(mu_);
+    if (num_background_compiles_ >= max_concurrent_compiles) {
+      return Status::OK();
+    }
+    ++num_background_compiles_;
+  }
+  VLOG(1) << "Compiling in the background for signature: "
+          << SignatureDebugString(signature);
+  std::vector<XlaCompiler::Argument> args;
+  Status s = BuildArguments(constant_args, variable_args, ctx, padding, &args);
+  if (!s.ok()) {
+    mutex_lock lock(mu_);
+    --num_background_compiles_;
+    return s;
+  }
+  entry->compiling = true;
+
+  // The compilation may outlive the function library and the allocator of
+  // the caller: use a copy of the former, and the default allocator of the
+  // backend.
+  std::shared_ptr<FunctionLibraryDefinition> flib_def;
+  XlaCompiler::Options background_options = options;
+  if (options.flib_def != nullptr) {
+    flib_def = std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+    background_options.flib_def = flib_def.get();
+  }
+  background_options.device_allocator = nullptr;
+  const XlaCompiler::CompileOptions background_compile_options =
+      compile_options ? *compile_options : XlaCompiler::CompileOptions();
+
+  Ref();
+  Env::Default()->SchedClosure([this, entry, background_options, flib_def,
+                                function, signature, args,
+                                background_compile_options]() {
+    XlaCompiler::CompilationResult result;
+    Status status = CompileToResult(background_options, function, signature,
+                                    args, background_compile_options,
+                                    /*compile_single_op=*/false,
+                                    /*ctx=*/nullptr, &result);
+    std::unique_ptr<xla::LocalExecutable> executable;
+    if (status.ok()) {
+      status = BuildExecutable(background_options, result, &executable);
+    }
+    VLOG(1) << "Background compilation done: " << status;
+    {
+      mutex_lock entry_lock(entry->mu);
+      entry->compiling = false;
+      // Compile() may have compiled the entry in the meantime, and its
+      // results may be in use.
+      if (!entry->compiled) {
+        entry->compilation_result = std::move(result);
+        entry->executable = std::move(executable);
+        entry->compilation_status = status;
+        entry->compiled = true;
+      }
+    }
+    {
+      mutex_lock lock(mu_);
+      --num_background_compiles_;
+    }
+    Unref();
+  });
+  return Status::OK();
 }
 
 Status XlaCompilationCache::CompileSingleOp(
@@ -245,7 +599,8 @@ Status XlaCompilationCache::CompileSingleOp(
   name.set_name(def.op());
   *name.mutable_attr() = def.attr();
   return CompileImpl(options, name, constant_args, variable_args, ctx,
-                     compilation_result, executable, compile_options, true);
+                     compilation_result, executable, compile_options, true,
+                     /*padding=*/nullptr);
 }
 
 Status XlaCompilationCache::CompileImpl(
@@ -255,7 +610,7 @@ Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::CompilationResult** compilation_result,
     xla::LocalExecutable** executable,
     const XlaCompiler::CompileOptions* compile_options,
-    bool compile_single_op) {
+    bool compile_single_op, const BatchPadding* padding) {
   VLOG(1) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
@@ -285,22 +640,11 @@ Status XlaCompilationCache::CompileImpl(
                ctx->num_inputs());
 
   Signature signature;
-  TF_RETURN_IF_ERROR(
-      BuildSignature(function, constant_args, variable_args, ctx, &signature));
+  TF_RETURN_IF_ERROR(BuildSignature(function, constant_args, variable_args,
+                                    ctx, padding, &signature));
 
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
-  // The outer lock protects the existence of the cache entry. It does not
-  // protect the contents of the cache entry.
-  Entry* entry;
-  {
-    mutex_lock lock(mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
-    if (!e) {
-      e.reset(new Entry);
-    }
-    entry = e.get();
-  }
+  Entry* entry = LookupOrCreateEntry(signature);
 
   // Acquire the cache entry lock and compile, if necessary.
   // TODO(phawkins): this locking will need to be restructured when we implement
@@ -313,20 +657,13 @@ Status XlaCompilationCache::CompileImpl(
     // a long time.)
     std::vector<XlaCompiler::Argument> args;
     TF_RETURN_IF_ERROR(
-        BuildArguments(constant_args, variable_args, ctx, &args));
+        BuildArguments(constant_args, variable_args, ctx, padding, &args));
 
-    XlaCompiler compiler(options);
     entry->compiled = true;
-
-    if (compile_single_op) {
-      entry->compilation_status = compiler.CompileSingleOp(
-          compile_options ? *compile_options : XlaCompiler::CompileOptions(),
-          signature.name, ctx, args, &entry->compilation_result);
-    } else {
-      entry->compilation_status = compiler.CompileFunction(
-          compile_options ? *compile_options : XlaCompiler::CompileOptions(),
-          function, args, &entry->compilation_result);
-    }
+    entry->compilation_status = CompileToResult(
+        options, function, signature, args,
+        compile_options ? *compile_options : XlaCompiler::CompileOptions(),
+        compile_single_op, ctx, &entry->compilation_result);
   }
   *compilation_result = &entry->compilation_result;
   if (entry->compilation_status.ok() && executable) {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include "tensorflow/compiler/jit/xla_shape_bucketing.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -44,6 +45,12 @@ struct OptionalTensor {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// If the TF_XLA_PERSISTENT_CACHE_DIR environment variable is set, the XLA
+// computations are also stored in that directory, which may be shared by
+// several processes, and loaded from there after a restart. This skips the
+// translation of the TensorFlow graph to XLA, but the executables are still
+// built by the XLA backend in each process.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
@@ -62,6 +69,8 @@ class XlaCompilationCache : public ResourceBase {
   // xla::LocalExecutable and sets `executable` to point to it. The resulting
   // executable pointer may be null if the computation has no non-constant
   // outputs.
+  // If `padding` is non-null, the function is compiled for the padded inputs
+  // instead of the inputs of `ctx`.
   Status Compile(const XlaCompiler::Options& options,
                  const NameAttrList& function,
                  const std::map<int, Tensor>& constant_args,
@@ -69,7 +78,26 @@ class XlaCompilationCache : public ResourceBase {
                  OpKernelContext* ctx,
                  const XlaCompiler::CompilationResult** compilation_result,
                  xla::LocalExecutable** executable,
-                 const XlaCompiler::CompileOptions* compile_options);
+                 const XlaCompiler::CompileOptions* compile_options,
+                 const BatchPadding* padding = nullptr);
+
+  // As Compile(), but does not block on compilations: if `function` isn't
+  // compiled yet for these arguments, starts compiling it, and building its
+  // executable, in the background and returns OK with `*compilation_result`
+  // and `*executable` set to null. The caller is expected to run the function
+  // some other way until a later call returns the executable. At most
+  // `max_concurrent_compiles` compilations run in the background at a time;
+  // beyond that, nothing is started and a later call tries again.
+  Status CompileAsync(const XlaCompiler::Options& options,
+                      const NameAttrList& function,
+                      const std::map<int, Tensor>& constant_args,
+                      const std::map<int, OptionalTensor>& variable_args,
+                      OpKernelContext* ctx,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable,
+                      const XlaCompiler::CompileOptions* compile_options,
+                      int max_concurrent_compiles,
+                      const BatchPadding* padding = nullptr);
 
   // As above, but calls XlaCompiler::CompileSingleOp instead of
   // XlaCompiler::CompileFunction.
@@ -96,7 +124,7 @@ class XlaCompilationCache : public ResourceBase {
                      const XlaCompiler::CompilationResult** compilation_result,
                      xla::LocalExecutable** executable,
                      const XlaCompiler::CompileOptions* compile_options,
-                     bool compile_single_op);
+                     bool compile_single_op, const BatchPadding* padding);
 
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
@@ -107,6 +135,9 @@ class XlaCompilationCache : public ResourceBase {
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
+  // The directory of the persistent cache, or empty if there is none.
+  string persistent_cache_dir_;
+
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
   struct Signature {
@@ -130,7 +161,26 @@ class XlaCompilationCache : public ResourceBase {
   Status BuildSignature(const NameAttrList& function,
                         const std::map<int, Tensor>& constant_args,
                         const std::map<int, OptionalTensor>& variable_args,
-                        OpKernelContext* ctx, Signature* signature);
+                        OpKernelContext* ctx, const BatchPadding* padding,
+                        Signature* signature);
+
+  // Returns the key of a compilation in the persistent cache. Unlike the
+  // signature, it includes the definitions of the functions and the target,
+  // since they may differ between processes.
+  string PersistentKey(const XlaCompiler::Options& options,
+                       const Signature& signature,
+                       const XlaCompiler::CompileOptions& compile_options,
+                       bool compile_single_op);
+
+  // Loads the compilation with `key` from the persistent cache. Returns
+  // NotFound if there is no valid entry for it.
+  Status LoadPersistentEntry(const string& key,
+                             XlaCompiler::CompilationResult* result);
+
+  // Stores a compilation in the persistent cache. Failures are logged and
+  // ignored.
+  void SavePersistentEntry(const string& key,
+                           const XlaCompiler::CompilationResult& result);
 
   // The value associated with a cache entry.
   struct Entry {
@@ -139,6 +189,9 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is this entry being compiled in the background?
+    bool compiling = false;
+
     // Did compilation succeed?
     Status compilation_status GUARDED_BY(mu);
 
@@ -150,10 +203,26 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
   };
 
+  // Returns the cache entry of `signature`, creating it if needed.
+  Entry* LookupOrCreateEntry(const Signature& signature);
+
+  // Compiles to `result`, going through the persistent cache if there is
+  // one. `ctx` is only used to compile single ops.
+  Status CompileToResult(const XlaCompiler::Options& options,
+                         const NameAttrList& function,
+                         const Signature& signature,
+                         const std::vector<XlaCompiler::Argument>& args,
+                         const XlaCompiler::CompileOptions& compile_options,
+                         bool compile_single_op, OpKernelContext* ctx,
+                         XlaCompiler::CompilationResult* result);
+
   mutex mu_;
   std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
 
+  // The number of compilations running in the background.
+  int num_background_compiles_ GUARDED_BY(mu_) = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
@@ -130,7 +130,8 @@ XlaComputationLaunchContext::XlaComputationLaunchContext(
 
 void XlaComputationLaunchContext::PopulateInputs(
     OpKernelContext* ctx, const XlaCompiler::CompilationResult* kernel,
-    const std::map<int, OptionalTensor>& variables) {
+    const std::map<int, OptionalTensor>& variables,
+    const BatchPadding* padding) {
   se::Stream* stream =
       ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
   // Build ShapedBuffers that point directly to the Tensor buffers.
@@ -146,6 +147,8 @@ void XlaComputationLaunchContext::PopulateInputs(
     if (variables.count(arg_num)) {
       t = &(variables.at(arg_num).value);
       CHECK(t);
+    } else if (padding) {
+      t = &padding->input(ctx, arg_num);
     } else {
       t = &(ctx->input(arg_num));
     }
@@ -184,7 +187,7 @@ void XlaComputationLaunchContext::PopulateInputs(
 
 void XlaComputationLaunchContext::PopulateOutputs(
     OpKernelContext* ctx, const XlaCompiler::CompilationResult* kernel,
-    ScopedShapedBuffer output) {
+    ScopedShapedBuffer output, const BatchPadding* padding) {
   se::Stream* stream =
       ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
 
@@ -195,6 +198,7 @@ void XlaComputationLaunchContext::PopulateOutputs(
             << output.on_device_shape().DebugString();
   }
   CHECK_EQ(ctx->num_outputs(), kernel->outputs.size());
+  CHECK(padding == nullptr || !allocate_xla_tensors_);
 
   // If the on-host-shape isn't a tuple, create a new single-element tuple
   // buffer with a nullptr root index table. This allows the code below to treat
@@ -283,6 +287,9 @@ void XlaComputationLaunchContext::PopulateOutputs(
         Tensor output_tensor = XlaTensorBuffer::MakeTensor(
             ctx->expected_output_dtype(i), shape, buffer, allocator);
         output.set_buffer(xla::OwningDeviceMemory(), {output_num});
+        if (padding) {
+          output_tensor = padding->SliceOutput(output_tensor);
+        }
         ctx->set_output(i, output_tensor);
       }
       ++output_num;
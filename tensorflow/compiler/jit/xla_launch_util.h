@@ -19,6 +19,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_XLA_LAUNCH_UTIL_H_
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/jit/xla_shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_tensor.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -88,14 +89,19 @@ class XlaComputationLaunchContext {
 
   // Add all inputs within `ctx` as XLA arguments (returned by arguments()).
   // `variables` is a map from TensorFlow argument number to resource variable.
+  // If `padding` is non-null, the padded inputs are used instead.
   void PopulateInputs(OpKernelContext* ctx,
                       const XlaCompiler::CompilationResult* kernel,
-                      const std::map<int, OptionalTensor>& variables);
+                      const std::map<int, OptionalTensor>& variables,
+                      const BatchPadding* padding = nullptr);
 
-  // Given the XLA output in `output`, populate all outputs of `ctx`.
+  // Given the XLA output in `output`, populate all outputs of `ctx`. If
+  // `padding` is non-null, the padded non-constant outputs are sliced back to
+  // the batch size. It is only supported if `allocate_xla_tensors` is false.
   void PopulateOutputs(OpKernelContext* ctx,
                        const XlaCompiler::CompilationResult* kernel,
-                       xla::ScopedShapedBuffer output);
+                       xla::ScopedShapedBuffer output,
+                       const BatchPadding* padding = nullptr);
 
   // Return the argument list. Only valid after PopulateInputs() has been
   // called.
@@ -0,0 +1,141 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_shape_bucketing.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/compiler/jit/xla_tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+
+namespace tensorflow {
+
+Status ShapeBucketingPolicy::Parse(const string& spec,
+                                   ShapeBucketingPolicy* policy) {
+  *policy = ShapeBucketingPolicy();
+  if (spec.empty()) {
+    return Status::OK();
+  }
+  if (spec == "pow2") {
+    policy->powers_of_two_ = true;
+    return Status::OK();
+  }
+  for (const string& size : str_util::Split(spec, ',')) {
+    int64 bucket;
+    if (!strings::safe_strto64(size, &bucket) || bucket <= 0) {
+      return errors::InvalidArgument("Invalid shape bucket \"", size,
+                                     "\" in \"", spec, "\"");
+    }
+    policy->buckets_.push_back(bucket);
+  }
+  std::sort(policy->buckets_.begin(), policy->buckets_.end());
+  policy->buckets_.erase(
+      std::unique(policy->buckets_.begin(), policy->buckets_.end()),
+      policy->buckets_.end());
+  return Status::OK();
+}
+
+int64 ShapeBucketingPolicy::Bucket(int64 size) const {
+  if (powers_of_two_) {
+    int64 bucket = 1;
+    while (bucket < size && bucket <= kint64max / 2) {
+      bucket *= 2;
+    }
+    return std::max(bucket, size);
+  }
+  auto it = std::lower_bound(buckets_.begin(), buckets_.end(), size);
+  return it == buckets_.end() ? size : *it;
+}
+
+const Tensor& BatchPadding::input(OpKernelContext* ctx, int i) const {
+  auto it = padded_inputs.find(i);
+  return it == padded_inputs.end() ? ctx->input(i) : it->second;
+}
+
+Tensor BatchPadding::SliceOutput(const Tensor& output) const {
+  if (output.dims() == 0 || output.dim_size(0) != padded_batch_size) {
+    return output;
+  }
+  return output.Slice(0, batch_size);
+}
+
+Status PadBatch(OpKernelContext* ctx, const ShapeBucketingPolicy& policy,
+                const std::vector<int>& skipped_inputs, BatchPadding* padding,
+                bool* padded) {
+  *padded = false;
+  std::vector<int> batched_inputs;
+  int64 batch_size = -1;
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    const Tensor& input = ctx->input(i);
+    if (std::find(skipped_inputs.begin(), skipped_inputs.end(), i) !=
+            skipped_inputs.end() ||
+        input.dims() == 0) {
+      continue;
+    }
+    if (!DataTypeCanUseMemcpy(input.dtype()) ||
+        (batch_size >= 0 && input.dim_size(0) != batch_size)) {
+      return Status::OK();
+    }
+    batch_size = input.dim_size(0);
+    batched_inputs.push_back(i);
+  }
+  if (batch_size <= 0) {
+    return Status::OK();
+  }
+  const int64 padded_batch_size = policy.Bucket(batch_size);
+  if (padded_batch_size == batch_size) {
+    return Status::OK();
+  }
+
+  padding->batch_size = batch_size;
+  padding->padded_batch_size = padded_batch_size;
+  padding->padded_inputs.clear();
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  for (int i : batched_inputs) {
+    const Tensor& input = ctx->input(i);
+    TensorShape shape = input.shape();
+    shape.set_dim(0, padded_batch_size);
+    Tensor* padded_input = &padding->padded_inputs[i];
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), shape, padded_input));
+    // The input is a prefix of the padded input.
+    const uint64 size = input.TotalBytes();
+    const uint64 padding_size = padded_input->TotalBytes() - size;
+    if (stream != nullptr) {
+      se::DeviceMemoryBase src = XlaTensor::DeviceMemoryFromTensor(input);
+      se::DeviceMemoryBase dst =
+          XlaTensor::DeviceMemoryFromTensor(*padded_input);
+      se::DeviceMemoryBase rest(static_cast<char*>(dst.opaque()) + size,
+                                padding_size);
+      if (size > 0) {
+        stream->ThenMemcpy(&dst, src, size);
+      }
+      stream->ThenMemZero(&rest, padding_size);
+    } else {
+      char* dst = const_cast<char*>(padded_input->tensor_data().data());
+      std::memcpy(dst, input.tensor_data().data(), size);
+      std::memset(dst + size, 0, padding_size);
+    }
+  }
+  *padded = true;
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Contains the padding of the inputs of XLA clusters to a bounded set of
+// shapes, which bounds the number of compilations of each cluster.
+
+#ifndef TENSORFLOW_COMPILER_JIT_XLA_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_XLA_SHAPE_BUCKETING_H_
+
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Rounds sizes up to buckets: either the powers of two, or a list of sizes.
+class ShapeBucketingPolicy {
+ public:
+  // Parses `spec`, which is either empty (no bucketing), "pow2", or a
+  // comma-separated list of sizes, e.g. "8,16,32,128".
+  static Status Parse(const string& spec, ShapeBucketingPolicy* policy);
+
+  bool enabled() const { return powers_of_two_ || !buckets_.empty(); }
+
+  // Returns the smallest bucket of at least `size`, or `size` if there is
+  // none.
+  int64 Bucket(int64 size) const;
+
+ private:
+  bool powers_of_two_ = false;
+  // Sorted and unique.
+  std::vector<int64> buckets_;
+};
+
+// The padding of the leading (batch) dimension of the inputs of a cluster.
+// The XLA computation is compiled and run with the padded inputs, and its
+// outputs whose leading dimension is the padded batch size are sliced back to
+// the batch size.
+//
+// This is only correct if the cluster computes each element of the batch
+// independently of the others, which is why bucketing is opt-in.
+struct BatchPadding {
+  int64 batch_size = 0;
+  int64 padded_batch_size = 0;
+
+  // The padded inputs, by input number. The other inputs are unchanged.
+  std::map<int, Tensor> padded_inputs;
+
+  // Returns input `i` of `ctx`, padded.
+  const Tensor& input(OpKernelContext* ctx, int i) const;
+
+  // Returns `output` sliced back to the batch size if it is padded.
+  Tensor SliceOutput(const Tensor& output) const;
+};
+
+// Pads the inputs of `ctx` according to `policy`, skipping the inputs in
+// `skipped_inputs` (e.g. compile-time constants and resources) and the
+// scalars. The padding is filled with zeros. Sets `*padded` to false if the
+// inputs need no padding: if the padded batch size is the batch size, or if
+// the inputs don't share their leading dimension.
+Status PadBatch(OpKernelContext* ctx, const ShapeBucketingPolicy& policy,
+                const std::vector<int>& skipped_inputs, BatchPadding* padding,
+                bool* padded);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_XLA_SHAPE_BUCKETING_H_
@@ -0,0 +1,76 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_shape_bucketing.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ShapeBucketingPolicyTest, Disabled) {
+  ShapeBucketingPolicy policy;
+  TF_ASSERT_OK(ShapeBucketingPolicy::Parse("", &policy));
+  EXPECT_FALSE(policy.enabled());
+  EXPECT_EQ(5, policy.Bucket(5));
+}
+
+TEST(ShapeBucketingPolicyTest, PowersOfTwo) {
+  ShapeBucketingPolicy policy;
+  TF_ASSERT_OK(ShapeBucketingPolicy::Parse("pow2", &policy));
+  EXPECT_TRUE(policy.enabled());
+  EXPECT_EQ(1, policy.Bucket(1));
+  EXPECT_EQ(8, policy.Bucket(5));
+  EXPECT_EQ(8, policy.Bucket(8));
+  EXPECT_EQ(1024, policy.Bucket(1000));
+}
+
+TEST(ShapeBucketingPolicyTest, List) {
+  ShapeBucketingPolicy policy;
+  TF_ASSERT_OK(ShapeBucketingPolicy::Parse("32,8,16,8", &policy));
+  EXPECT_TRUE(policy.enabled());
+  EXPECT_EQ(8, policy.Bucket(1));
+  EXPECT_EQ(16, policy.Bucket(9));
+  EXPECT_EQ(32, policy.Bucket(32));
+  // Larger than any bucket.
+  EXPECT_EQ(33, policy.Bucket(33));
+
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(ShapeBucketingPolicy::Parse("8,x", &policy)));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(ShapeBucketingPolicy::Parse("0", &policy)));
+}
+
+TEST(BatchPaddingTest, SliceOutput) {
+  BatchPadding padding;
+  padding.batch_size = 3;
+  padding.padded_batch_size = 4;
+
+  Tensor padded = test::AsTensor<float>({1, 2, 3, 4, 5, 6, 0, 0}, {4, 2});
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {3, 2}),
+      padding.SliceOutput(padded));
+
+  // Outputs with another leading dimension are left alone.
+  Tensor other = test::AsTensor<float>({1, 2}, {2});
+  test::ExpectTensorEqual<float>(other, padding.SliceOutput(other));
+  Tensor scalar = test::AsScalar<float>(4);
+  test::ExpectTensorEqual<float>(scalar, padding.SliceOutput(scalar));
+}
+
+}  // namespace
+}  // namespace tensorflow
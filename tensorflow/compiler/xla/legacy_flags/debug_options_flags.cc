@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/legacy_flags/debug_options_parsers.h"
 #include "tensorflow/compiler/xla/legacy_flags/parse_flags_from_env.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/protobuf.h"
 
 namespace xla {
 namespace legacy_flags {
@@ -80,6 +81,14 @@ void AllocateFlags() {
     };
   };
 
+  auto int64_setter_for =
+      [](void (DebugOptions::*member_setter)(tensorflow::protobuf_int64)) {
+        return [member_setter](int64 value) {
+          (flag_values->*member_setter)(value);
+          return true;
+        };
+      };
+
   // Custom "sub-parser" lambda for xla_disable_hlo_passes.
   auto setter_for_xla_disable_hlo_passes = [](string comma_separated_values) {
     std::vector<string> disabled_passes =
@@ -306,6 +315,26 @@ void AllocateFlags() {
                        bool_setter_for(&DebugOptions::set_xla_cpu_use_mkl_dnn),
                        flag_values->xla_cpu_use_mkl_dnn(),
                        "Generate calls to MKL-DNN in the CPU backend."),
+      tensorflow::Flag(
+          "xla_gpu_use_cuda_graphs",
+          bool_setter_for(&DebugOptions::set_xla_gpu_use_cuda_graphs),
+          flag_values->xla_gpu_use_cuda_graphs(),
+          "Capture the thunks of GPU executables into CUDA graphs and replay "
+          "them, to reduce the kernel launch overhead."),
+      tensorflow::Flag(
+          "xla_gpu_memory_limit_bytes",
+          int64_setter_for(&DebugOptions::set_xla_gpu_memory_limit_bytes),
+          static_cast<int64>(flag_values->xla_gpu_memory_limit_bytes()),
+          "Rematerialize instructions in the GPU backend to fit the module "
+          "in this many bytes. 0 means the memory of the device, and a "
+          "negative value disables rematerialization."),
+      tensorflow::Flag(
+          "xla_cpu_parallel_codegen_split_count",
+          int32_setter_for(
+              &DebugOptions::set_xla_cpu_parallel_codegen_split_count),
+          flag_values->xla_cpu_parallel_codegen_split_count(),
+          "If greater than 1, the CPU backend generates the machine code of "
+          "JIT-compiled modules in this many partitions in parallel."),
   });
   ParseFlagsFromEnv(*flag_objects);
 }
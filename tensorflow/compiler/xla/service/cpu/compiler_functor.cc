@@ -25,6 +25,8 @@ limitations under the License.
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/MCContext.h"
@@ -35,6 +37,7 @@ limitations under the License.
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/llvm_ir_runtime.h"
@@ -42,6 +45,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -95,6 +99,54 @@ class FilteredPassManager : public llvm::legacy::PassManager {
 
 std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
     llvm::Module& module) const {
+  OptimizeModule(&module);
+  return EmitObjectFile(&module, target_machine_);
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+CompilerFunctor::CompileInPartitions(
+    std::unique_ptr<llvm::Module> module, int partition_count,
+    tensorflow::thread::ThreadPool* pool,
+    const TargetMachineFactory& target_machine_factory) const {
+  // Optimize the module as a whole, so that the partitions don't prevent
+  // inlining, e.g. of the reducers into the reductions.
+  OptimizeModule(module.get());
+
+  // Split the module into partitions, which are serialized since the modules
+  // code generated concurrently must not share an LLVMContext.  Local symbols
+  // which end up used across partitions become external and hidden.
+  std::vector<string> partitions;
+  llvm::SplitModule(std::move(module), partition_count,
+                    [&partitions](std::unique_ptr<llvm::Module> partition) {
+                      partitions.emplace_back();
+                      llvm::raw_string_ostream ostream(partitions.back());
+                      llvm::WriteBitcodeToFile(*partition, ostream);
+                    });
+  VLOG(1) << "Generating code for " << partitions.size()
+          << " partitions in parallel";
+
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files(
+      partitions.size());
+  tensorflow::BlockingCounter counter(static_cast<int>(partitions.size()));
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    pool->Schedule([this, i, &partitions, &object_files, &counter,
+                    &target_machine_factory]() {
+      llvm::LLVMContext context;
+      std::unique_ptr<llvm::Module> partition = llvm::cantFail(
+          llvm::parseBitcodeFile(
+              llvm::MemoryBufferRef(partitions[i], "partition"), context));
+      std::unique_ptr<llvm::TargetMachine> target_machine =
+          target_machine_factory();
+      object_files[i] = EmitObjectFile(partition.get(), target_machine.get());
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  return object_files;
+}
+
+void CompilerFunctor::OptimizeModule(llvm::Module* module_ptr) const {
+  llvm::Module& module = *module_ptr;
   FilteredPassManager module_passes(disable_expensive_passes_);
   FilteredFunctionPassManager function_passes(&module,
                                               disable_expensive_passes_);
@@ -139,22 +191,25 @@ std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
 
   runtime::RewriteIRRuntimeFunctions(&module, enable_fast_math_);
 
-  // Buffer for holding machine code prior to constructing the ObjectFile.
-  llvm::SmallVector<char, 0> stream_buffer;
-  llvm::raw_svector_ostream ostream(stream_buffer);
-
   VLOG(2) << "IR after optimizations";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
 
   if (post_optimization_hook_) {
     TF_CHECK_OK(post_optimization_hook_(module));
   }
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::EmitObjectFile(
+    llvm::Module* module, llvm::TargetMachine* target_machine) const {
+  // Buffer for holding machine code prior to constructing the ObjectFile.
+  llvm::SmallVector<char, 0> stream_buffer;
+  llvm::raw_svector_ostream ostream(stream_buffer);
 
   // Generate code.
   llvm::MCContext* mc_context;
   llvm::legacy::PassManager codegen_passes;
-  target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
-  codegen_passes.run(module);
+  target_machine->addPassesToEmitMC(codegen_passes, mc_context, ostream);
+  codegen_passes.run(*module);
 
   // Construct ObjectFile from machine code buffer.
   return std::unique_ptr<llvm::MemoryBuffer>(
@@ -16,12 +16,17 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -31,6 +36,9 @@ namespace cpu {
 // Orc JIT compile layer.
 class CompilerFunctor {
  public:
+  using TargetMachineFactory =
+      std::function<std::unique_ptr<llvm::TargetMachine>()>;
+
   explicit CompilerFunctor(
       llvm::TargetMachine* target_machine, const Disassembler* disassembler,
       int opt_level, bool optimize_for_size, bool enable_fast_math,
@@ -50,7 +58,23 @@ class CompilerFunctor {
   std::unique_ptr<llvm::MemoryBuffer> operator()(
       llvm::Module& module) const;  // NOLINT
 
+  // Optimizes `module` as a whole, splits it into at most `partition_count`
+  // modules and generates code for them in parallel on `pool`, each with its
+  // own target machine from `target_machine_factory`.  Returns an object file
+  // per partition, to be linked together.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> CompileInPartitions(
+      std::unique_ptr<llvm::Module> module, int partition_count,
+      tensorflow::thread::ThreadPool* pool,
+      const TargetMachineFactory& target_machine_factory) const;
+
  private:
+  // Runs the IR optimization passes and the hooks on `module`.
+  void OptimizeModule(llvm::Module* module) const;
+
+  // Generates the machine code of `module` with `target_machine`.
+  std::unique_ptr<llvm::MemoryBuffer> EmitObjectFile(
+      llvm::Module* module, llvm::TargetMachine* target_machine) const;
+
   // Populates the given pass manager with TargetLibraryInfo and
   // TargetTransformInfo passes.
   void AddTargetInfoPasses(llvm::legacy::PassManagerBase* passes) const;
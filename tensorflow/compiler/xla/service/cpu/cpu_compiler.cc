@@ -110,7 +110,16 @@ CpuAotCompilationOptions::CpuAotCompilationOptions(
     : triple_(std::move(triple)),
       cpu_name_(std::move(cpu_name)),
       features_(std::move(features)),
-      entry_point_name_(std::move(entry_point_name)),
+      entry_point_names_({std::move(entry_point_name)}),
+      relocation_model_(relocation_model) {}
+
+CpuAotCompilationOptions::CpuAotCompilationOptions(
+    string triple, string cpu_name, string features,
+    std::vector<string> entry_point_names, RelocationModel relocation_model)
+    : triple_(std::move(triple)),
+      cpu_name_(std::move(cpu_name)),
+      features_(std::move(features)),
+      entry_point_names_(std::move(entry_point_names)),
       relocation_model_(relocation_model) {}
 
 CpuAotCompilationOptions::~CpuAotCompilationOptions() = default;
@@ -546,6 +555,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       module->config().debug_options().xla_embed_ir_in_executable();
   const string xla_dump_optimized_hlo_proto_to =
       module->config().debug_options().xla_dump_optimized_hlo_proto_to();
+  const int parallel_codegen_split_count =
+      module->config().debug_options().xla_cpu_parallel_codegen_split_count();
 
   // Select an order for emitting the HLO instructions for each
   // computation. Using this sequence enables tighter buffer liveness analysis
@@ -625,7 +636,12 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   XLA_VLOG_LINES(2, "LLVM IR:\n" + llvm_ir::DumpModuleToString(*llvm_module));
 
   // JIT compile the LLVM IR module to in-memory machine code.
-  jit->AddModule(std::move(llvm_module));
+  if (parallel_codegen_split_count > 1) {
+    jit->AddModuleInPartitions(std::move(llvm_module),
+                               parallel_codegen_split_count);
+  } else {
+    jit->AddModule(std::move(llvm_module));
+  }
   cpu_executable.reset(new CpuExecutable(
       std::move(jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
@@ -666,6 +682,12 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
   }
   const CpuAotCompilationOptions& options =
       static_cast<const CpuAotCompilationOptions&>(aot_options);
+  if (options.entry_point_names().size() != modules.size()) {
+    return InvalidArgument(
+        "Expected an entry point name for each of the %zu HLO modules, got "
+        "%zu",
+        modules.size(), options.entry_point_names().size());
+  }
   llvm::StringRef target_triple = llvm_ir::AsStringRef(options.triple());
   llvm::Triple triple(llvm::Triple::normalize(target_triple));
   std::string error;
@@ -726,7 +748,12 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
     llvm_module.setPIELevel(pie_level);
   }
 
-  std::vector<std::unique_ptr<AotCompilationResult>> results;
+  // All the modules are emitted into the same LLVM module, and so into the
+  // same object file, which lets them share their constants.
+  std::vector<BufferSizes> buffer_sizes(modules.size());
+  std::vector<BufferAllocation::Index> result_buffer_indices(modules.size());
+  std::vector<std::unique_ptr<HloProfilePrinterData>> hlo_profile_printer_data(
+      modules.size());
   for (size_t i = 0; i < modules.size(); ++i) {
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
@@ -769,12 +796,11 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
     std::unordered_map<const HloInstruction*, int64> instruction_to_profile_idx;
     std::unordered_map<const HloComputation*, int64> computation_to_profile_idx;
     std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map;
-    std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data;
 
     if (module->config().hlo_profiling_enabled()) {
       TF_RETURN_IF_ERROR(CreateHloProfilingArtifacts(
           *module, &instruction_to_profile_idx, &computation_to_profile_idx,
-          &hlo_profile_index_map, &hlo_profile_printer_data));
+          &hlo_profile_index_map, &hlo_profile_printer_data[i]));
     }
 
     LLVMTargetMachineFeatures target_machine_features(target_machine.get());
@@ -799,7 +825,7 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
                                &module_sequence.at(embedded_computation))
               .status());
     }
-    const string& entry_point_name = options.entry_point_name();
+    const string& entry_point_name = options.entry_point_names()[i];
     TF_ASSIGN_OR_RETURN(
         llvm::Function * entry_function,
         ir_emitter.EmitComputation(computation, entry_point_name,
@@ -808,59 +834,63 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
 
     CHECK(entry_function->getName() == llvm_ir::AsStringRef(entry_point_name));
 
-    ModuleHook pre_optimization_ir_dump_hook;
-    ModuleHook post_optimization_ir_dump_hook;
-    TF_RETURN_IF_ERROR(InitializeModuleHooks(
-        *module, user_pre_optimization_hook_, user_post_optimization_hook_,
-        &pre_optimization_ir_dump_hook, &post_optimization_ir_dump_hook));
-
-    // Run the LLVM verifier over the unoptimized LLVM IR.  If it fails, run the
-    // pre-optimization IR dump hook before returning.
-    {
-      Status verify_status = VerifyLlvmModule(llvm_module);
-      if (!verify_status.ok() && pre_optimization_ir_dump_hook) {
-        pre_optimization_ir_dump_hook(llvm_module).IgnoreError();
-      }
-      TF_RETURN_IF_ERROR(verify_status);
-    }
-
-    XLA_VLOG_LINES(2, "LLVM IR:\n" + llvm_ir::DumpModuleToString(llvm_module));
-
-    Disassembler disassembler(*target_machine);
-    CompilerFunctor compiler_functor(
-        target_machine.get(), &disassembler, opt_level,
-        options::OptimizeForSizeRequested(module->config()),
-        module->config().debug_options().xla_enable_fast_math(),
-        module->config().debug_options().xla_llvm_disable_expensive_passes(),
-        pre_optimization_ir_dump_hook, post_optimization_ir_dump_hook);
-    std::unique_ptr<llvm::MemoryBuffer> object_file =
-        compiler_functor(llvm_module);
-    ObjectFileData object_file_data(object_file->getBufferStart(),
-                                    object_file->getBufferEnd());
-
-    BufferSizes buffer_sizes;
     for (const BufferAllocation& allocation : assignment->Allocations()) {
       // Callers don't need to allocate temporary buffers for parameters.
       if (allocation.is_entry_computation_parameter() ||
           allocation.is_constant()) {
-        buffer_sizes.push_back(-1);
+        buffer_sizes[i].push_back(-1);
         continue;
       }
       // Callers don't need to allocate anything for thread-local temporary
       // buffers.  They are lowered to allocas.
       if (allocation.is_thread_local()) {
-        buffer_sizes.push_back(-1);
+        buffer_sizes[i].push_back(-1);
         continue;
       }
-      buffer_sizes.push_back(allocation.size());
+      buffer_sizes[i].push_back(allocation.size());
     }
 
     TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice result_slice,
                         assignment->GetUniqueTopLevelOutputSlice());
+    result_buffer_indices[i] = result_slice.index();
+  }
+
+  const HloModule& first_module = *modules[0];
+  ModuleHook pre_optimization_ir_dump_hook;
+  ModuleHook post_optimization_ir_dump_hook;
+  TF_RETURN_IF_ERROR(InitializeModuleHooks(
+      first_module, user_pre_optimization_hook_, user_post_optimization_hook_,
+      &pre_optimization_ir_dump_hook, &post_optimization_ir_dump_hook));
+
+  // Run the LLVM verifier over the unoptimized LLVM IR.  If it fails, run the
+  // pre-optimization IR dump hook before returning.
+  {
+    Status verify_status = VerifyLlvmModule(llvm_module);
+    if (!verify_status.ok() && pre_optimization_ir_dump_hook) {
+      pre_optimization_ir_dump_hook(llvm_module).IgnoreError();
+    }
+    TF_RETURN_IF_ERROR(verify_status);
+  }
+
+  XLA_VLOG_LINES(2, "LLVM IR:\n" + llvm_ir::DumpModuleToString(llvm_module));
 
+  Disassembler disassembler(*target_machine);
+  CompilerFunctor compiler_functor(
+      target_machine.get(), &disassembler, opt_level,
+      options::OptimizeForSizeRequested(first_module.config()),
+      first_module.config().debug_options().xla_enable_fast_math(),
+      first_module.config().debug_options().xla_llvm_disable_expensive_passes(),
+      pre_optimization_ir_dump_hook, post_optimization_ir_dump_hook);
+  std::unique_ptr<llvm::MemoryBuffer> object_file =
+      compiler_functor(llvm_module);
+
+  std::vector<std::unique_ptr<AotCompilationResult>> results;
+  for (size_t i = 0; i < modules.size(); ++i) {
+    ObjectFileData object_file_data(object_file->getBufferStart(),
+                                    object_file->getBufferEnd());
     results.emplace_back(MakeUnique<CpuAotCompilationResult>(
-        std::move(object_file_data), std::move(buffer_sizes),
-        result_slice.index(), std::move(hlo_profile_printer_data)));
+        std::move(object_file_data), std::move(buffer_sizes[i]),
+        result_buffer_indices[i], std::move(hlo_profile_printer_data[i])));
   }
 
   VLOG(1) << "Compilation finished";
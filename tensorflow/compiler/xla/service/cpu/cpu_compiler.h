@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_COMPILER_H_
 
 #include <memory>
+#include <vector>
 
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/executable.h"
@@ -52,6 +53,11 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   CpuAotCompilationOptions(string triple, string cpu_name, string features,
                            string entry_point_name,
                            RelocationModel relocation_model);
+  // Options to compile several modules into a single object file, where the
+  // entry point of module i is entry_point_names[i].
+  CpuAotCompilationOptions(string triple, string cpu_name, string features,
+                           std::vector<string> entry_point_names,
+                           RelocationModel relocation_model);
   ~CpuAotCompilationOptions() override;
 
   se::Platform::Id PlatformId() const override;
@@ -63,7 +69,11 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The target features used for compilation ("+avx2", "+neon", etc).
   const string& features() const { return features_; }
   // The name to be used for the compiled code's entry point.
-  const string& entry_point_name() const { return entry_point_name_; }
+  const string& entry_point_name() const { return entry_point_names_[0]; }
+  // The names to be used for the entry points of the compiled modules.
+  const std::vector<string>& entry_point_names() const {
+    return entry_point_names_;
+  }
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
@@ -71,7 +81,7 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   const string triple_;
   const string cpu_name_;
   const string features_;
-  const string entry_point_name_;
+  const std::vector<string> entry_point_names_;
   const RelocationModel relocation_model_;
 };
 
@@ -42,6 +42,35 @@ bool CanBeLoopFused(const HloInstruction& hlo) {
          hlo.opcode() == HloOpcode::kTranspose;
 }
 
+// Returns true if `hlo` is a convolution small enough to be emitted elementally
+// in a loop fusion, instead of calling the Eigen convolution runtime.  These
+// are e.g. the 1x1 and 3x3 convolutions over few features of mobile models, for
+// which fusing the neighboring elementwise operations saves more than the
+// runtime call gains.
+bool IsFusibleConvolution(const HloInstruction& hlo) {
+  if (hlo.opcode() != HloOpcode::kConvolution) {
+    return false;
+  }
+  const PrimitiveType element_type = hlo.shape().element_type();
+  if (element_type != F32 && element_type != F16) {
+    return false;
+  }
+
+  constexpr int64 kMaxFusedConvolutionWindowSize = 3;
+  constexpr int64 kMaxFusedConvolutionReductionSize = 256;
+  // The number of multiply-adds per element of the output.
+  int64 reduction_size =
+      hlo.operand(0)->shape().dimensions(
+          hlo.convolution_dimension_numbers().input_feature_dimension());
+  for (const WindowDimension& dimension : hlo.window().dimensions()) {
+    if (dimension.size() > kMaxFusedConvolutionWindowSize) {
+      return false;
+    }
+    reduction_size *= dimension.size();
+  }
+  return reduction_size <= kMaxFusedConvolutionReductionSize;
+}
+
 bool IsMatrixVectorDot(const HloInstruction* hlo) {
   const Shape& hlo_shape = hlo->shape();
   return hlo->opcode() == HloOpcode::kDot && hlo_shape.dimensions_size() == 2 &&
@@ -77,7 +106,7 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     return false;
   }
 
-  if (!CanBeLoopFused(*producer)) {
+  if (!CanBeLoopFused(*producer) && !IsFusibleConvolution(*producer)) {
     VLOG(2) << "Producer is not fusile.";
     return false;
   }
@@ -133,6 +162,11 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     }
   }
 
+  if (IsFusibleConvolution(*consumer)) {
+    VLOG(2) << "Fusing: consumer is a small convolution.";
+    return true;
+  }
+
   if (consumer->opcode() == HloOpcode::kFusion &&
       consumer->fusion_kind() == HloInstruction::FusionKind::kLoop) {
     VLOG(2) << "Fusing: consumer is a fusion node.";
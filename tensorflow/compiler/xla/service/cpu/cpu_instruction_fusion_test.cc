@@ -756,6 +756,58 @@ TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x1_multi_use) {
               Not(op::Fusion()));
 }
 
+TEST_F(OpcodeFusionTest, SmallConvolution_BiasAdd_Relu) {
+  const char* hlo_string = R"(
+HloModule SmallConvolution
+
+ENTRY main {
+  input = f32[1,8,8,16] parameter(0)
+  filter = f32[1,1,16,32] parameter(1)
+  bias = f32[32] parameter(2)
+  convolution = f32[1,8,8,32] convolution(input, filter), window={size=1x1}, dim_labels=b01f_01io->b01f
+  broadcasted_bias = f32[1,8,8,32] broadcast(bias), dimensions={3}
+  add = f32[1,8,8,32] add(convolution, broadcasted_bias)
+  zero = f32[] constant(0)
+  zeros = f32[1,8,8,32] broadcast(zero), dimensions={}
+  ROOT relu = f32[1,8,8,32] maximum(add, zeros)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseHloString(hlo_string));
+
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kConvolution, HloOpcode::kBroadcast, HloOpcode::kAdd,
+       HloOpcode::kBroadcast, HloOpcode::kMaximum, HloOpcode::kParameter,
+       HloOpcode::kParameter, HloOpcode::kParameter, HloOpcode::kParameter});
+}
+
+TEST_F(OpcodeFusionTest, LargeConvolution_BiasAdd) {
+  const char* hlo_string = R"(
+HloModule LargeConvolution
+
+ENTRY main {
+  input = f32[1,8,8,64] parameter(0)
+  filter = f32[3,3,64,32] parameter(1)
+  bias = f32[32] parameter(2)
+  convolution = f32[1,8,8,32] convolution(input, filter), window={size=3x3 pad=1_1x1_1}, dim_labels=b01f_01io->b01f
+  broadcasted_bias = f32[1,8,8,32] broadcast(bias), dimensions={3}
+  ROOT add = f32[1,8,8,32] add(convolution, broadcasted_bias)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseHloString(hlo_string));
+
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module.get()));
+  EXPECT_TRUE(fused_something);
+  // Only the broadcast is fused into the add; the convolution is left to the
+  // runtime.
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  ASSERT_THAT(root, op::Fusion());
+  EXPECT_THAT(root->operands(), ::testing::Contains(op::Convolution()));
+}
+
 struct GatherLoopFusionTestSpec {
   string test_name;
   string hlo_computation_text;
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -122,6 +124,15 @@ llvm_ir::ElementGenerator CpuElementalIrEmitter::MakeElementGenerator(
                                          llvm_ir::IrName(hlo));
     };
   }
+  if (hlo->opcode() == HloOpcode::kConvolution) {
+    return [this, hlo, &operand_to_generator](
+               const llvm_ir::IrArray::Index& index) -> StatusOr<llvm::Value*> {
+      return ir_emitter_->EmitElementalConvolution(
+          Cast<HloConvolutionInstruction>(hlo),
+          operand_to_generator.at(hlo->operand(0)),
+          operand_to_generator.at(hlo->operand(1)), index);
+    };
+  }
   return ElementalIrEmitter::MakeElementGenerator(hlo, operand_to_generator);
 }
 }  // namespace cpu
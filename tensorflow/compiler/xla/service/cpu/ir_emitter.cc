@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
+#include "tensorflow/compiler/xla/service/cpu/vector_support_library.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
@@ -54,6 +55,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/buffer_assignment_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/kernel_support_library.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/tuple_ops.h"
@@ -164,6 +166,19 @@ Status IrEmitter::HandleBitcast(HloInstruction* bitcast) {
 llvm::Constant* IrEmitter::EmitGlobalForLiteral(const Literal& literal) {
   llvm::Constant* initializer =
       llvm_ir::ConvertLiteralToIrConstant(literal, module_);
+  const int alignment = MinimumAlignmentForShape(literal.shape());
+  llvm::Type* pointer_type = IrShapeType(literal.shape())->getPointerTo();
+  // Several HLO modules may be emitted into the same LLVM module, e.g. the
+  // variants of an ahead-of-time compiled computation.  LLVM uniques constant
+  // arrays, so the constants of the other modules are found by comparing the
+  // initializers.
+  for (llvm::GlobalVariable& global : module_->globals()) {
+    if (global.isConstant() && global.hasPrivateLinkage() &&
+        global.hasInitializer() && global.getInitializer() == initializer &&
+        static_cast<int>(global.getAlignment()) >= alignment) {
+      return llvm::ConstantExpr::getBitCast(&global, pointer_type);
+    }
+  }
   llvm::GlobalVariable* result_global = new llvm::GlobalVariable(
       /*Module=*/*module_,
       /*Type=*/initializer->getType(),
@@ -171,9 +186,8 @@ llvm::Constant* IrEmitter::EmitGlobalForLiteral(const Literal& literal) {
       /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
       /*Initializer=*/initializer,
       /*Name=*/"");
-  result_global->setAlignment(MinimumAlignmentForShape(literal.shape()));
-  return llvm::ConstantExpr::getBitCast(
-      result_global, IrShapeType(literal.shape())->getPointerTo());
+  result_global->setAlignment(alignment);
+  return llvm::ConstantExpr::getBitCast(result_global, pointer_type);
 }
 
 Status IrEmitter::EmitConstantGlobals() {
@@ -820,6 +834,26 @@ Status IrEmitter::HandleDot(HloInstruction* dot) {
 StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForConvolution(
     HloConvolutionInstruction* convolution,
     const llvm_ir::IrArray::Index& index) {
+  llvm_ir::IrArray input_array(GetIrArrayFor(convolution->operand(0)));
+  llvm_ir::IrArray kernel_array(GetIrArrayFor(convolution->operand(1)));
+  return EmitElementalConvolution(
+      convolution,
+      [&](const llvm_ir::IrArray::Index& input_index)
+          -> StatusOr<llvm::Value*> {
+        return input_array.EmitReadArrayElement(input_index, &b_);
+      },
+      [&](const llvm_ir::IrArray::Index& kernel_index)
+          -> StatusOr<llvm::Value*> {
+        return kernel_array.EmitReadArrayElement(kernel_index, &b_);
+      },
+      index);
+}
+
+StatusOr<llvm::Value*> IrEmitter::EmitElementalConvolution(
+    const HloConvolutionInstruction* convolution,
+    const llvm_ir::ElementGenerator& input_generator,
+    const llvm_ir::ElementGenerator& kernel_generator,
+    const llvm_ir::IrArray::Index& index) {
   const HloInstruction* lhs = convolution->operand(0);
   const HloInstruction* rhs = convolution->operand(1);
   const Window& window = convolution->window();
@@ -931,7 +965,6 @@ StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForConvolution(
   input_index[dnums.input_feature_dimension()] = input_feature;
   input_index[dnums.input_batch_dimension()] = batch;
 
-  llvm_ir::IrArray kernel_array(GetIrArrayFor(rhs));
   llvm_ir::IrArray::Index kernel_index(b_.getInt64Ty(), num_dims);
   for (int i = 0; i < num_spatial_dims; ++i) {
     kernel_index[dnums.kernel_spatial_dimensions(i)] =
@@ -944,10 +977,10 @@ StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForConvolution(
   kernel_index[dnums.kernel_input_feature_dimension()] = input_feature;
   kernel_index[dnums.kernel_output_feature_dimension()] = output_feature;
 
-  llvm_ir::IrArray input_array(GetIrArrayFor(lhs));
-  llvm::Value* product =
-      b_.CreateFMul(input_array.EmitReadArrayElement(input_index, &b_),
-                    kernel_array.EmitReadArrayElement(kernel_index, &b_));
+  TF_ASSIGN_OR_RETURN(llvm::Value * input_value, input_generator(input_index));
+  TF_ASSIGN_OR_RETURN(llvm::Value * kernel_value,
+                      kernel_generator(kernel_index));
+  llvm::Value* product = b_.CreateFMul(input_value, kernel_value);
   llvm::Value* sum = b_.CreateFAdd(b_.CreateLoad(sum_address), product);
   b_.CreateStore(sum, sum_address);
 
@@ -1601,16 +1634,26 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
     gtl::ArraySlice<int64> dimensions, HloComputation* function,
     string* failure_reason) {
-  if (!ReductionPreservesLayout(*reduce)) {
-    return false;
-  }
-
   ReductionGenerator reduction_generator =
       MatchReductionGenerator(function, failure_reason);
   if (!reduction_generator) {
     return false;
   }
 
+  bool is_reduction_over_minor_dimension =
+      std::find(dimensions.begin(), dimensions.end(),
+                LayoutUtil::Minor(arg->shape().layout(), 0)) !=
+      dimensions.end();
+
+  if (is_reduction_over_minor_dimension) {
+    return EmitVectorizedReduceOverMinorDimension(
+        reduce, function, reduction_generator, failure_reason);
+  }
+
+  if (!ReductionPreservesLayout(*reduce)) {
+    return false;
+  }
+
   int vectorization_factor_in_bytes =
       target_machine_features_.vectorization_factor_in_bytes();
 
@@ -1619,21 +1662,10 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
       vectorization_factor_in_bytes /
       ShapeUtil::ByteSizeOfPrimitiveType(reduce->shape().element_type());
 
-  bool is_reduction_over_minor_dimension =
-      std::find(dimensions.begin(), dimensions.end(),
-                LayoutUtil::Minor(arg->shape().layout(), 0)) !=
-      dimensions.end();
-
   unsigned element_alignment = tensorflow::MathUtil::GCD<unsigned>(
       ShapeUtil::ByteSizeOfPrimitiveType(reduce->shape().element_type()),
       MinimumAlignmentForPrimitiveType(reduce->shape().element_type()));
 
-  if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
-    return false;
-  }
-
   CHECK(!ShapeUtil::IsTuple(reduce->shape()));
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
 
@@ -1746,6 +1778,178 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   return true;
 }
 
+// The maximum number of vector accumulators of a reduction over the minor
+// dimension.  Several accumulators make consecutive vector operations
+// independent, which hides their latency.
+static const int64 kMaxMinorDimensionReductionAccumulators = 4;
+
+StatusOr<bool> IrEmitter::EmitVectorizedReduceOverMinorDimension(
+    HloInstruction* reduce, HloComputation* function,
+    const ReductionGenerator& reduction_generator, string* failure_reason) {
+  const HloInstruction* arg = reduce->operand(0);
+  const HloOpcode reducer_opcode = function->root_instruction()->opcode();
+
+  // The elements of the minor dimension are reduced in a different order than
+  // by the scalar loop.  This is exact for integers, minimum and maximum, but
+  // not for floating point additions and multiplications.
+  if (ShapeUtil::ElementIsFloating(reduce->shape()) &&
+      (reducer_opcode == HloOpcode::kAdd ||
+       reducer_opcode == HloOpcode::kMultiply) &&
+      !hlo_module_config_.debug_options().xla_enable_fast_math()) {
+    *failure_reason =
+        "reassociating a floating point reduction requires fast math";
+    return false;
+  }
+
+  const int64 vector_size =
+      target_machine_features_.vectorization_factor_in_bytes() /
+      ShapeUtil::ByteSizeOfPrimitiveType(reduce->shape().element_type());
+  const int64 minor_dimension_size =
+      arg->shape().dimensions(LayoutUtil::Minor(arg->shape().layout(), 0));
+  if (vector_size < 2 || (vector_size & (vector_size - 1)) != 0 ||
+      minor_dimension_size < vector_size) {
+    *failure_reason = "minor dimension too small to vectorize";
+    return false;
+  }
+
+  CHECK(!ShapeUtil::IsTuple(reduce->shape()));
+  TF_RETURN_IF_ERROR(EmitTargetElementLoop(
+      reduce, [&](const llvm_ir::IrArray::Index& index) {
+        return EmitTargetElementLoopBodyForVectorizedReduce(
+            Cast<HloReduceInstruction>(reduce), reduction_generator,
+            vector_size, index);
+      }));
+  return true;
+}
+
+StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForVectorizedReduce(
+    HloReduceInstruction* reduce,
+    const ReductionGenerator& reduction_generator, int64 vector_size,
+    const llvm_ir::IrArray::Index& index) {
+  const HloInstruction* arg = reduce->operand(0);
+  const int64 minor_dimension = LayoutUtil::Minor(arg->shape().layout(), 0);
+  const int64 minor_dimension_size = arg->shape().dimensions(minor_dimension);
+
+  // We lower the reduction as:
+  //
+  //  1. We're reducing over dimensions R1, R0 and the minor dimension M.
+  //  2. VS is the vector size and NA the number of vector accumulators.
+  //
+  //  vector_acc[0..NA) = init; scalar_acc = init
+  //  for (r1 in R1) {
+  //    for (r0 in R0) {
+  //      for (m in M with stride VS * NA)
+  //        vector_acc[i] = reduce(vector_acc[i], input[r1, r0, m + i * VS])
+  //      for (m in the rest of M with stride VS)
+  //        vector_acc[0] = reduce(vector_acc[0], input[r1, r0, m])
+  //      for (m in the rest of M)
+  //        scalar_acc = reduce(scalar_acc, input[r1, r0, m])
+  //    }
+  //  }
+  //  output[index] = reduce(horizontal_reduce(vector_acc), scalar_acc)
+  //
+  // This applies the reduction to the initial value more than once, which the
+  // semantics of Reduce allow.
+  const int64 num_accumulators =
+      std::min(kMaxMinorDimensionReductionAccumulators,
+               minor_dimension_size / vector_size);
+  const int64 tile_size = vector_size * num_accumulators;
+  const int64 tiled_limit =
+      minor_dimension_size - minor_dimension_size % tile_size;
+  const int64 vector_limit =
+      minor_dimension_size - minor_dimension_size % vector_size;
+
+  VectorSupportLibrary vsl(reduce->shape().element_type(), vector_size, &b_,
+                           "reduce");
+  KernelSupportLibrary ksl(&b_);
+  auto reduce_values = [&](llvm::Value* lhs, llvm::Value* rhs) {
+    return reduction_generator(&b_, lhs, rhs);
+  };
+
+  llvm::Value* init_value =
+      b_.CreateLoad(GetEmittedValueFor(reduce->operand(1)));
+  std::vector<VectorVariable> vector_accumulators;
+  for (int64 i = 0; i < num_accumulators; ++i) {
+    vector_accumulators.emplace_back(&vsl, vsl.BroadcastScalar(init_value));
+  }
+  ScalarVariable scalar_accumulator(&vsl, init_value);
+
+  std::vector<int64> outer_reduced_dimensions;
+  for (int64 dimension : reduce->dimensions()) {
+    if (dimension != minor_dimension) {
+      outer_reduced_dimensions.push_back(dimension);
+    }
+  }
+  llvm_ir::ForLoopNest loops(IrName(reduce, "vectorized_inner"), &b_);
+  const llvm_ir::IrArray::Index reduced_dims_index =
+      loops.AddLoopsForShapeOnDimensions(arg->shape(),
+                                         outer_reduced_dimensions,
+                                         "reduction_dim");
+  if (llvm::BasicBlock* inner_body_bb = loops.GetInnerLoopBodyBasicBlock()) {
+    SetToFirstInsertPoint(inner_body_bb, &b_);
+  }
+
+  // Build the index of the first element of the minor dimension, using
+  // reduced_dims_index as the base like EmitTargetElementLoopBodyForReduce.
+  llvm_ir::IrArray arg_array(GetIrArrayFor(arg));
+  llvm_ir::IrArray::Index input_index = reduced_dims_index;
+  llvm_ir::IrArray::Index::const_iterator it = index.begin();
+  for (int64 i = 0, e = input_index.size(); i < e; ++i) {
+    if (i == minor_dimension) {
+      input_index[i] = b_.getInt64(0);
+    } else if (input_index[i] == nullptr) {
+      input_index[i] = *it++;
+    }
+  }
+  CHECK(index.end() == it);
+  llvm::Value* row = arg_array.EmitArrayElementAddress(input_index, &b_);
+
+  auto load = [&](llvm::Value* value) {
+    arg_array.AnnotateLoadStoreInstructionWithMetadata(
+        llvm::cast<llvm::Instruction>(value));
+    return value;
+  };
+
+  ksl.ForReturnVoid(
+      "reduce.tiled", /*start=*/0, /*end=*/tiled_limit,
+      /*step=*/tile_size, [&](llvm::Value* column) {
+        for (int64 i = 0; i < num_accumulators; ++i) {
+          llvm::Value* input = load(vsl.LoadVector(
+              row, b_.CreateAdd(column, b_.getInt64(i * vector_size))));
+          vector_accumulators[i].Set(
+              reduce_values(vector_accumulators[i].Get(), input));
+        }
+      });
+  if (tiled_limit < vector_limit) {
+    ksl.ForReturnVoid("reduce.vector", /*start=*/tiled_limit,
+                      /*end=*/vector_limit, /*step=*/vector_size,
+                      [&](llvm::Value* column) {
+                        llvm::Value* input = load(vsl.LoadVector(row, column));
+                        vector_accumulators[0].Set(reduce_values(
+                            vector_accumulators[0].Get(), input));
+                      });
+  }
+  if (vector_limit < minor_dimension_size) {
+    ksl.ForReturnVoid("reduce.scalar", /*start=*/vector_limit,
+                      /*end=*/minor_dimension_size, /*step=*/1,
+                      [&](llvm::Value* column) {
+                        llvm::Value* input = load(vsl.LoadScalar(row, column));
+                        scalar_accumulator.Set(
+                            reduce_values(scalar_accumulator.Get(), input));
+                      });
+  }
+
+  if (llvm::BasicBlock* outer_exit_bb = loops.GetOuterLoopExitBasicBlock()) {
+    SetToFirstInsertPoint(outer_exit_bb, &b_);
+  }
+  llvm::Value* vector_result = vector_accumulators[0].Get();
+  for (int64 i = 1; i < num_accumulators; ++i) {
+    vector_result = reduce_values(vector_result, vector_accumulators[i].Get());
+  }
+  return reduce_values(vsl.ReduceVector(vector_result, reduce_values),
+                       scalar_accumulator.Get());
+}
+
 StatusOr<llvm::Value*> IrEmitter::EmitTargetElementLoopBodyForReduce(
     HloReduceInstruction* reduce, const llvm_ir::IrArray::Index& index) {
   const HloInstruction* arg = reduce->mutable_operand(0);
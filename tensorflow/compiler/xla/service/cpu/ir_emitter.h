@@ -105,6 +105,15 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       PrimitiveType return_type, HloComputation* computation,
       const std::vector<llvm::Value*>& arguments, tensorflow::StringPiece name);
 
+  // Emits the element of `convolution` at `index`, reading the elements of its
+  // input and kernel with the given generators.  This lets convolutions be
+  // emitted inside loop fusions.
+  StatusOr<llvm::Value*> EmitElementalConvolution(
+      const HloConvolutionInstruction* convolution,
+      const llvm_ir::ElementGenerator& input_generator,
+      const llvm_ir::ElementGenerator& kernel_generator,
+      const llvm_ir::IrArray::Index& index);
+
   // Emit an LLVM global variable for every constant buffer allocation.
   Status EmitConstantGlobals();
 
@@ -379,6 +388,21 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       HloInstruction* arg, tensorflow::gtl::ArraySlice<int64> dimensions,
       unsigned element_alignment);
 
+  // Emits a reduction over the minor dimension of `arg`, and possibly other
+  // dimensions, with SIMD accumulators.  Helper function for
+  // EmitVectorizedReduce.
+  StatusOr<bool> EmitVectorizedReduceOverMinorDimension(
+      HloInstruction* reduce, HloComputation* function,
+      const ReductionGenerator& reduction_generator, string* failure_reason);
+
+  // Emits the computation of the element at `index` of a reduction over the
+  // minor dimension.  Helper function for
+  // EmitVectorizedReduceOverMinorDimension.
+  StatusOr<llvm::Value*> EmitTargetElementLoopBodyForVectorizedReduce(
+      HloReduceInstruction* reduce,
+      const ReductionGenerator& reduction_generator, int64 vector_size,
+      const llvm_ir::IrArray::Index& index);
+
   // Tries to emit a fast concatenate operation using memcpy.  Returns true if
   // successful, and false on failure.  On failure, sets "failure_reason" to a
   // string describing why it could not emit a fast concatenate.
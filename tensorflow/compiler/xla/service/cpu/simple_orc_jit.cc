@@ -42,6 +42,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/windows_compatibility.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -96,13 +98,21 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
                            bool disable_expensive_passes,
                            LLVMCompiler::ModuleHook pre_optimization_hook,
                            LLVMCompiler::ModuleHook post_optimization_hook)
-    : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
       disassembler_(*target_machine_),
       data_layout_(target_machine_->createDataLayout()),
       symbol_resolver_(llvm::orc::createLegacyLookupResolver(
           execution_session_,
           [this](const std::string& name) -> llvm::JITSymbol {
-            return this->ResolveRuntimeSymbol(name);
+            if (auto symbol = this->ResolveRuntimeSymbol(name)) {
+              return symbol;
+            }
+            // The symbol may be defined by another partition of the module;
+            // the symbols shared by partitions are hidden.
+            return this->object_layer_.findSymbol(
+                name, /*ExportedSymbolsOnly=*/false);
           },
           [](llvm::Error Err) {
             cantFail(std::move(Err), "lookupFlags failed");
@@ -116,12 +126,12 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
                       result.Resolver = symbol_resolver_;
                       return result;
                     }),
-      compile_layer_(object_layer_,
-                     CompilerFunctor(target_machine_.get(), &disassembler_,
-                                     opt_level, optimize_for_size,
-                                     enable_fast_math, disable_expensive_passes,
-                                     std::move(pre_optimization_hook),
-                                     std::move(post_optimization_hook))) {
+      compiler_functor_(target_machine_.get(), &disassembler_, opt_level,
+                        optimize_for_size, enable_fast_math,
+                        disable_expensive_passes,
+                        std::move(pre_optimization_hook),
+                        std::move(post_optimization_hook)),
+      compile_layer_(object_layer_, compiler_functor_) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
@@ -144,6 +154,28 @@ SimpleOrcJIT::VModuleKeyT SimpleOrcJIT::AddModule(
   return key;
 }
 
+std::vector<SimpleOrcJIT::VModuleKeyT> SimpleOrcJIT::AddModuleInPartitions(
+    std::unique_ptr<llvm::Module> module, int partition_count) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files;
+  {
+    // The pool is destroyed once the code is generated.
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_codegen", partition_count);
+    object_files = compiler_functor_.CompileInPartitions(
+        std::move(module), partition_count, &pool, [this]() {
+          return InferTargetMachineForJIT(target_options_, opt_level_);
+        });
+  }
+  std::vector<VModuleKeyT> keys;
+  for (auto& object_file : object_files) {
+    auto key = execution_session_.allocateVModule();
+    cantFail(object_layer_.addObject(key, std::move(object_file)));
+    module_keys_.push_back(key);
+    keys.push_back(key);
+  }
+  return keys;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::VModuleKeyT key) {
   module_keys_.erase(std::remove(module_keys_.begin(), module_keys_.end(), key),
                      module_keys_.end());
@@ -81,6 +81,12 @@ class SimpleOrcJIT {
   // remove this module.
   VModuleKeyT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Like AddModule, but splits the module into at most `partition_count`
+  // partitions after optimizing it, and generates their code in parallel.
+  // Returns the keys of the partitions.
+  std::vector<VModuleKeyT> AddModuleInPartitions(
+      std::unique_ptr<llvm::Module> module, int partition_count);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(VModuleKeyT key);
 
@@ -100,12 +106,15 @@ class SimpleOrcJIT {
   llvm::JITSymbol ResolveRuntimeSymbol(const std::string& name);
 
   std::vector<VModuleKeyT> module_keys_;
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const Disassembler disassembler_;
   const llvm::DataLayout data_layout_;
   llvm::orc::ExecutionSession execution_session_;
   std::shared_ptr<llvm::orc::SymbolResolver> symbol_resolver_;
   ObjLayerT object_layer_;
+  const CompilerFunctor compiler_functor_;
   CompileLayerT compile_layer_;
 };
 
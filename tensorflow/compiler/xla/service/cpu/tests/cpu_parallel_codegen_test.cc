@@ -0,0 +1,83 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelCodegenTest : public HloTestBase {};
+
+TEST_F(CpuParallelCodegenTest, LinksPartitions) {
+  // The while loop, its body and condition, and the reducer are separate
+  // functions, which end up in different partitions.
+  const char* const hlo_text = R"(
+    HloModule LinksPartitions
+
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    condition {
+      state = (s32[], f32[16]) parameter(0)
+      i = s32[] get-tuple-element(state), index=0
+      limit = s32[] constant(10)
+      ROOT less-than = pred[] less-than(i, limit)
+    }
+
+    body {
+      state = (s32[], f32[16]) parameter(0)
+      i = s32[] get-tuple-element(state), index=0
+      one = s32[] constant(1)
+      next_i = s32[] add(i, one)
+      values = f32[16] get-tuple-element(state), index=1
+      half = f32[] constant(0.5)
+      halves = f32[16] broadcast(half), dimensions={}
+      next_values = f32[16] multiply(values, halves)
+      ROOT next_state = (s32[], f32[16]) tuple(next_i, next_values)
+    }
+
+    ENTRY main {
+      input = f32[16] parameter(0)
+      zero = s32[] constant(0)
+      init = (s32[], f32[16]) tuple(zero, input)
+      while = (s32[], f32[16]) while(init), condition=condition, body=body
+      values = f32[16] get-tuple-element(while), index=1
+      exp = f32[16] exponential(values)
+      zero_f32 = f32[] constant(0)
+      ROOT reduce = f32[] reduce(exp, zero_f32), dimensions={0}, to_apply=add
+    }
+  )";
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_cpu_parallel_codegen_split_count(4);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseHloString(hlo_text, config));
+  EXPECT_TRUE(RunAndCompare(std::move(module), ErrorSpec{1e-5, 1e-5}));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
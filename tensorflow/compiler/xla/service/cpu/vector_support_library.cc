@@ -251,10 +251,19 @@ llvm::Value* VectorSupportLibrary::LoadBroadcast(llvm::Value* pointer) {
 }
 
 llvm::Value* VectorSupportLibrary::AddReduce(llvm::Value* vector) {
+  return ReduceVector(vector, [this](llvm::Value* lhs, llvm::Value* rhs) {
+    return Add(lhs, rhs);
+  });
+}
+
+llvm::Value* VectorSupportLibrary::ReduceVector(
+    llvm::Value* vector,
+    const std::function<llvm::Value*(llvm::Value*, llvm::Value*)>& reducer) {
+  CHECK_EQ(vector->getType(), vector_type());
   llvm::SmallVector<llvm::Constant*, 32> mask(vector_size(), nullptr);
   for (unsigned i = vector_size(); i != 1; i >>= 1) {
     // On every iteration, we shuffle half of the remaining lanes to the top
-    // half of shuffle, and add two old and the new vector.
+    // half of shuffle, and combine the old and the new vector.
 
     for (unsigned j = 0; j < vector_size(); ++j) {
       if (j < (i / 2)) {
@@ -267,7 +276,7 @@ llvm::Value* VectorSupportLibrary::AddReduce(llvm::Value* vector) {
     llvm::Value* half_remaining_lanes =
         b()->CreateShuffleVector(vector, llvm::UndefValue::get(vector_type()),
                                  llvm::ConstantVector::get(mask), "");
-    vector = Add(vector, half_remaining_lanes);
+    vector = reducer(vector, half_remaining_lanes);
   }
 
   return b()->CreateExtractElement(vector, b()->getInt32(0), name());
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_VECTOR_SUPPORT_LIBRARY_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_VECTOR_SUPPORT_LIBRARY_H_
 
+#include <functional>
 #include <string>
 
 #include "llvm/IR/IRBuilder.h"
@@ -215,6 +216,12 @@ class VectorSupportLibrary {
   std::vector<llvm::Value*> ComputeHorizontalSums(
       std::vector<llvm::Value*> vectors, llvm::Value* init_values = nullptr);
 
+  // Reduces the lanes of `vector` to a scalar with `reducer`, which must be
+  // associative and commutative, in log2(vector_size()) steps.
+  llvm::Value* ReduceVector(
+      llvm::Value* vector,
+      const std::function<llvm::Value*(llvm::Value*, llvm::Value*)>& reducer);
+
   llvm::Value* GetZeroVector();
   llvm::Value* GetZeroScalar();
 
@@ -64,6 +64,7 @@ class DeviceToDeviceCopyThunk : public Thunk {
   DeviceToDeviceCopyThunk(const DeviceToDeviceCopyThunk&) = delete;
   DeviceToDeviceCopyThunk& operator=(const DeviceToDeviceCopyThunk&) = delete;
 
+  bool SupportsGraphCapture() const override { return true; }
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
@@ -18,8 +18,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/kernels/autotune_cache.h"
 #include "tensorflow/core/lib/gtl/optional.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
 namespace xla {
@@ -137,24 +140,54 @@ string NumBytesToString(int64 bytes) {
       tensorflow::strings::HumanReadableNumBytes(bytes), " (", bytes, "B)");
 }
 
+// Returns the key of a convolution in the persistent autotune cache.  The
+// text form of the protos is good enough as a key: a field added to one of
+// them can only cause cache misses, not wrong hits.
+string PersistentCacheKey(CudnnConvKind kind, const Shape& input_shape,
+                          const Shape& filter_shape, const Shape& output_shape,
+                          const Window& window,
+                          const ConvolutionDimensionNumbers& dnums) {
+  return tensorflow::strings::StrCat(
+      CudnnConvKindToString(kind), " ",
+      ShapeUtil::HumanStringWithLayout(input_shape), " ",
+      ShapeUtil::HumanStringWithLayout(filter_shape), " ",
+      ShapeUtil::HumanStringWithLayout(output_shape), " {",
+      window.ShortDebugString(), "} {", dnums.ShortDebugString(), "}");
+}
+
 }  // anonymous namespace
 
-// We could have caching here so that we don't redo this work for two identical
-// convolutions.  Unfortunately our cache key would have to be a tuple
-// containing the protos passed to this function, and we have no utility for
-// hashing protos.  We could write our own hash functions, but they'd silently
-// break if we ever added a field to one of the protos.  Perhaps we could hack
-// using the binary-encoded proto as the hash key, on the assumption that two
-// protos being binary-equal is a sufficient, if not necessary, condition for
-// proper equality.  But that would still leave us open to having unnecessary
-// cache misses and doing extra work.  Overall, caching doesn't seem worth the
-// trouble, but we may want to revisit this if we ever find a model where
-// caching would speed up compilation a lot.
+// Results are shared with later compilations, and with other processes,
+// through the persistent autotune cache that the TensorFlow convolution
+// kernels use, if TF_AUTOTUNE_CACHE_DIR is set.  Identical convolutions
+// within one process are not cached otherwise.
 optional<std::tuple<int64, bool, int64>>
 CudnnConvolutionAlgorithmPicker::PickBestAlgorithm(
     CudnnConvKind kind, const Shape& input_shape, const Shape& filter_shape,
     const Shape& output_shape, const Window& window,
     const ConvolutionDimensionNumbers& dnums, HloInstruction* instr) {
+  tensorflow::PersistentAutoTuneCache* persistent_cache =
+      tensorflow::PersistentAutoTuneCache::Get("xla_cudnn_conv");
+  string cache_key;
+  if (persistent_cache != nullptr) {
+    cache_key = PersistentCacheKey(kind, input_shape, filter_shape,
+                                   output_shape, window, dnums);
+    string value;
+    if (persistent_cache->Lookup(cache_key, &value)) {
+      std::vector<string> fields = tensorflow::str_util::Split(value, ',');
+      int64 algorithm, tensor_ops_enabled, scratch_bytes;
+      if (fields.size() == 3 &&
+          tensorflow::strings::safe_strto64(fields[0], &algorithm) &&
+          tensorflow::strings::safe_strto64(fields[1], &tensor_ops_enabled) &&
+          tensorflow::strings::safe_strto64(fields[2], &scratch_bytes)) {
+        VLOG(2) << "Loaded algorithm " << algorithm << " for "
+                << instr->ToString() << " from the persistent cache";
+        return std::make_tuple(algorithm, tensor_ops_enabled != 0,
+                               scratch_bytes);
+      }
+    }
+  }
+
   // Create a stream for us to do our work on.
   se::Stream stream{stream_exec_};
   stream.Init();
@@ -257,6 +290,14 @@ CudnnConvolutionAlgorithmPicker::PickBestAlgorithm(
             << AlgorithmToString(best_result.algorithm()) << ", takes "
             << best_result.elapsed_time_in_ms() << "ms, and uses "
             << best_result_bytes_used << "B of scratch memory.";
+    if (persistent_cache != nullptr) {
+      persistent_cache->Record(
+          cache_key,
+          tensorflow::strings::StrCat(
+              best_result.algorithm().algo_id(), ",",
+              best_result.algorithm().tensor_ops_enabled() ? 1 : 0, ",",
+              best_result_bytes_used));
+    }
     return std::make_tuple(best_result.algorithm().algo_id(),
                            best_result.algorithm().tensor_ops_enabled(),
                            best_result_bytes_used);
@@ -40,6 +40,12 @@ Status ForThunk::Initialize(const GpuExecutable& executable,
   return Status::OK();
 }
 
+bool ForThunk::SupportsGraphCapture() const {
+  // The trip count is known on the host, so the iterations are captured one
+  // after the other.
+  return body_thunk_sequence_->SupportsGraphCapture();
+}
+
 Status ForThunk::ExecuteOnStream(const BufferAllocations& buffer_allocations,
                                  se::Stream* stream,
                                  HloExecutionProfiler* profiler) {
@@ -42,6 +42,23 @@ namespace {
 
 using tensorflow::tracing::ScopedAnnotation;
 
+bool CanUseCudaGraphs(const HloModule& module,
+                      const ThunkSchedule& thunk_schedule) {
+  if (!module.config().debug_options().xla_gpu_use_cuda_graphs() ||
+      thunk_schedule.StreamCount() != 1) {
+    return false;
+  }
+  for (const Thunk* thunk : thunk_schedule.TotalOrder()) {
+    if (!thunk->SupportsGraphCapture()) {
+      VLOG(1) << "Not using CUDA graphs for " << module.name()
+              << ": they can't capture the thunk of "
+              << thunk->hlo_instruction()->name();
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 // Implementation note: HLO profiling is always enabled for GPU executables,
@@ -60,7 +77,79 @@ GpuExecutable::GpuExecutable(
       cubin_(cubin),
       compute_capability_(compute_capability),
       thunk_schedule_(std::move(thunk_schedule)),
-      assignment_(std::move(assignment)) {}
+      assignment_(std::move(assignment)),
+      use_cuda_graphs_(CanUseCudaGraphs(module(), *thunk_schedule_)) {}
+
+GpuExecutable::~GpuExecutable() {
+  for (const auto& graph : cuda_graphs_) {
+    graph.first.first->DestroyGraph(graph.second);
+  }
+}
+
+StatusOr<bool> GpuExecutable::ExecuteThunksAsCudaGraph(
+    const BufferAllocations& buffer_allocations, se::Stream* stream,
+    HloExecutionProfiler* profiler) {
+  se::StreamExecutor* executor = stream->parent();
+  CudaGraphKey key;
+  key.first = executor;
+  key.second.reserve(assignment_->Allocations().size());
+  for (BufferAllocation::Index i = 0; i < assignment_->Allocations().size();
+       ++i) {
+    key.second.push_back(buffer_allocations.GetDeviceAddress(i).opaque());
+  }
+  {
+    tensorflow::mutex_lock lock(cuda_graph_mutex_);
+    if (cuda_graph_capture_failed_) {
+      return false;
+    }
+    auto it = cuda_graphs_.find(key);
+    if (it != cuda_graphs_.end()) {
+      TF_RETURN_IF_ERROR(executor->LaunchGraph(stream, it->second));
+      return true;
+    }
+    if (cuda_graphs_.size() >= static_cast<size_t>(kMaxCudaGraphs)) {
+      return false;
+    }
+  }
+
+  // Initialize the thunks first, since initialization isn't captured.
+  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
+  }
+  VLOG(2) << "Capturing the thunks of " << module().name()
+          << " into a CUDA graph";
+  Status status = executor->BeginGraphCapture(stream);
+  if (status.ok()) {
+    for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+      status = thunk->ExecuteOnStream(buffer_allocations, stream, profiler);
+      if (!status.ok()) {
+        break;
+      }
+    }
+    // End the capture even if a thunk failed, to leave the stream usable.
+    StatusOr<void*> graph = executor->EndGraphCapture(stream);
+    if (status.ok() && graph.ok()) {
+      TF_RETURN_IF_ERROR(executor->LaunchGraph(stream, graph.ValueOrDie()));
+      tensorflow::mutex_lock lock(cuda_graph_mutex_);
+      if (!cuda_graphs_.emplace(key, graph.ValueOrDie()).second) {
+        // Another execution captured a graph for the same buffers meanwhile.
+        executor->DestroyGraph(graph.ValueOrDie());
+      }
+      return true;
+    }
+    if (graph.ok()) {
+      executor->DestroyGraph(graph.ValueOrDie());
+    } else if (status.ok()) {
+      status = graph.status();
+    }
+  }
+  LOG(WARNING) << "Failed to capture the thunks of " << module().name()
+               << " into a CUDA graph, running them without graphs: "
+               << status;
+  tensorflow::mutex_lock lock(cuda_graph_mutex_);
+  cuda_graph_capture_failed_ = true;
+  return false;
+}
 
 Status GpuExecutable::ExecuteThunks(
     const ServiceExecutableRunOptions* run_options,
@@ -104,49 +193,61 @@ Status GpuExecutable::ExecuteThunks(
   //     tracing is disabled.
   ScopedAnnotation top_level_annotation(hlo_module_->name(), "XLA GPU module");
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
-    // Annotate execution of this op if tracing was enabled when we started
-    // running this module.  If tracing is enabled *while* we're running the
-    // module, we won't get any data, but that's probably an OK trade-off.
-    //
-    // TODO(jlebar): Should we cache the results of HloInstruction::ToString(),
-    // since we expect it to be an expensive call?
-    tensorflow::gtl::optional<ScopedAnnotation> op_annotation;
-    if (top_level_annotation.IsEnabled()) {
-      op_annotation.emplace(
-          thunk->hlo_instruction() != nullptr
-              ? thunk->hlo_instruction()->ToString(HloPrintOptions::Canonical())
-              : "<unknown>",
-          "XLA op");
-    }
+  bool executed_as_cuda_graph = false;
+  if (use_cuda_graphs_ && !do_profile) {
+    TF_ASSIGN_OR_RETURN(executed_as_cuda_graph,
+                        ExecuteThunksAsCudaGraph(buffer_allocations,
+                                                 main_stream, &profiler));
+  }
 
-    TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
-    int32 stream_no =
-        thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
-    se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+  if (!executed_as_cuda_graph) {
+    std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
+    for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+      // Annotate execution of this op if tracing was enabled when we started
+      // running this module.  If tracing is enabled *while* we're running the
+      // module, we won't get any data, but that's probably an OK trade-off.
+      //
+      // TODO(jlebar): Should we cache the results of
+      // HloInstruction::ToString(), since we expect it to be an expensive
+      // call?
+      tensorflow::gtl::optional<ScopedAnnotation> op_annotation;
+      if (top_level_annotation.IsEnabled()) {
+        op_annotation.emplace(
+            thunk->hlo_instruction() != nullptr
+                ? thunk->hlo_instruction()->ToString(
+                      HloPrintOptions::Canonical())
+                : "<unknown>",
+            "XLA op");
+      }
 
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
-    }
+      TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
+      int32 stream_no =
+          thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
+      se::Stream* stream =
+          (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
 
-    // If this thunk requests it, wait for all currently-executing thunks to
-    // finish.  This is useful e.g. if the thunk is about to perform autotuning.
-    if (thunk->ShouldHaltAllActivityBeforeRunning(stream)) {
-      TF_RETURN_IF_ERROR(main_stream->BlockHostUntilDone());
-    }
+      for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+        stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+      }
+
+      // If this thunk requests it, wait for all currently-executing thunks to
+      // finish.  This is useful e.g. if the thunk is about to perform
+      // autotuning.
+      if (thunk->ShouldHaltAllActivityBeforeRunning(stream)) {
+        TF_RETURN_IF_ERROR(main_stream->BlockHostUntilDone());
+      }
 
-    VLOG(2) << "Executing the thunk for "
-            << thunk->hlo_instruction()->ToString() << " on stream "
-            << stream_no;
-    TF_RETURN_IF_ERROR(
-        thunk->ExecuteOnStream(buffer_allocations, stream, &profiler));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = MakeUnique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
+      VLOG(2) << "Executing the thunk for "
+              << thunk->hlo_instruction()->ToString() << " on stream "
+              << stream_no;
+      TF_RETURN_IF_ERROR(
+          thunk->ExecuteOnStream(buffer_allocations, stream, &profiler));
+      if (thunk_schedule_->Depended(thunk)) {
+        auto finish_event = MakeUnique<se::Event>(main_stream->parent());
+        finish_event->Init();
+        stream->ThenRecordEvent(finish_event.get());
+        thunk_to_finish_event[thunk] = std::move(finish_event);
+      }
     }
   }
 
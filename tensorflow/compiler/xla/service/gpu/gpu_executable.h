@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/device_memory_allocator.h"
@@ -58,6 +61,7 @@ class GpuExecutable : public Executable {
                 std::unique_ptr<const BufferAssignment> assignment,
                 std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data,
                 std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map);
+  ~GpuExecutable() override;
 
   // This should be called after set_ir_module_string.
   const string& ir_module_string() const { return ir_module_string_; }
@@ -96,6 +100,13 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // Launches on `stream` the CUDA graph of the thunks for the addresses in
+  // `buffer_allocations`, capturing it first if there is none yet.  Returns
+  // false, having enqueued nothing, if the thunks must run without a graph.
+  StatusOr<bool> ExecuteThunksAsCudaGraph(
+      const BufferAllocations& buffer_allocations, se::Stream* stream,
+      HloExecutionProfiler* profiler);
+
   // Returns the points-to set of the root instruction of the entry
   // computation. Uses points-to analysis from buffer assignment.
   const PointsToSet& GetRootPointsToSet() const;
@@ -145,6 +156,25 @@ class GpuExecutable : public Executable {
   std::map<stream_executor::StreamExecutor*, BufferAllocToDeviceMemoryMap>
       module_globals_ GUARDED_BY(module_handle_mutex_);
 
+  // Whether the thunks run as CUDA graphs: requested by the
+  // xla_gpu_use_cuda_graphs debug option, and supported by all the thunks,
+  // which run on a single stream.
+  const bool use_cuda_graphs_;
+
+  // The maximum number of CUDA graphs kept.  Executions with buffers that
+  // have no graph yet run the thunks without a graph once it is reached.
+  static constexpr int kMaxCudaGraphs = 16;
+
+  // The CUDA graphs of the thunks, by the executor and the addresses of the
+  // buffer allocations they were captured with.
+  using CudaGraphKey =
+      std::pair<stream_executor::StreamExecutor*, std::vector<void*>>;
+  tensorflow::mutex cuda_graph_mutex_;
+  std::map<CudaGraphKey, void*> cuda_graphs_ GUARDED_BY(cuda_graph_mutex_);
+  // Set if a capture failed, e.g. because the driver doesn't support graphs,
+  // in which case the thunks always run without a graph.
+  bool cuda_graph_capture_failed_ GUARDED_BY(cuda_graph_mutex_) = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
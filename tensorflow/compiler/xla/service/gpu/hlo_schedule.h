@@ -38,9 +38,15 @@ class HloSchedule {
  public:
   // Constructs an HloSchedule for the given module, based on the given stream
   // assignment.
+  //
+  // If `entry_sequence` is non-null, it is used as the total order of thunk
+  // launches of the entry computation, e.g. to keep the order rematerialization
+  // assumed.  Otherwise the launch order minimizes memory usage when there is a
+  // single stream, and maximizes concurrency when there are several.
   static StatusOr<std::unique_ptr<HloSchedule>> Build(
       const HloModule& module, const StreamAssignment& stream_assignment,
-      int64 pointer_size);
+      int64 pointer_size,
+      const std::vector<const HloInstruction*>* entry_sequence = nullptr);
 
   // Returns the total order of thunk launches, represented in terms of HLO
   // instructions.
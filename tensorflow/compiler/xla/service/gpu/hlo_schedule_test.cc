@@ -249,6 +249,42 @@ TEST_F(HloScheduleTest, ConcurrentMatMul) {
   EXPECT_FALSE(order->ExecutesBefore(add, add));
 }
 
+// Test of two streams with a given entry sequence, which is used as the thunk
+// launch order.
+TEST_F(HloScheduleTest, ConcurrentMatMulWithEntrySequence) {
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"y"));
+  HloInstruction* dot1 = builder.AddInstruction(
+      HloInstruction::CreateCanonicalDot(f32_2x2_, x, y));
+  HloInstruction* dot2 = builder.AddInstruction(
+      HloInstruction::CreateCanonicalDot(f32_2x2_, y, x));
+  HloInstruction* add = builder.AddInstruction(
+      HloInstruction::CreateCanonicalDot(f32_2x2_, dot1, dot2));
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build(add));
+
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  EXPECT_NE(streams->StreamNumberForHlo(*dot1),
+            streams->StreamNumberForHlo(*dot2));
+
+  const HloVec entry_sequence({y, x, dot2, dot1, add});
+  auto schedule = HloSchedule::Build(*module, *streams, /*pointer_size=*/8,
+                                     &entry_sequence)
+                      .ConsumeValueOrDie();
+  EXPECT_EQ(schedule->ThunkLaunchOrder(), entry_sequence);
+
+  // dot1 and dot2 still run concurrently on their streams.
+  auto order = schedule->ConsumeHloOrdering();
+  EXPECT_TRUE(order->ExecutesBefore(dot1, add));
+  EXPECT_TRUE(order->ExecutesBefore(dot2, add));
+  EXPECT_FALSE(order->ExecutesBefore(dot1, dot2));
+  EXPECT_FALSE(order->ExecutesBefore(dot2, dot1));
+}
+
 // Test of multiple streams.
 TEST_F(HloScheduleTest, LatticeMatMul) {
   //      d00      -- layer 0
@@ -0,0 +1,152 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Returns whether `instr` is a small single-output loop fusion of elementwise
+// instructions and broadcasts of scalars.
+bool IsHorizontallyFusible(const HloInstruction* instr) {
+  if (instr->opcode() != HloOpcode::kFusion ||
+      instr->fusion_kind() != HloInstruction::FusionKind::kLoop ||
+      instr->IsMultiOutputFusion() || ShapeUtil::IsTuple(instr->shape()) ||
+      ShapeUtil::ElementsIn(instr->shape()) >
+          GpuHorizontalFusion::kMaxOutputElements) {
+    return false;
+  }
+  // Merging a fusion redirects its users to a get-tuple-element of the merged
+  // fusion, which requires it to have users.
+  if (instr->user_count() == 0) {
+    return false;
+  }
+  for (const HloInstruction* fused : instr->fused_instructions()) {
+    const bool is_scalar_broadcast =
+        fused->opcode() == HloOpcode::kBroadcast &&
+        ShapeUtil::IsScalar(fused->operand(0)->shape());
+    if (!fused->IsElementwise() && !is_scalar_broadcast &&
+        fused->opcode() != HloOpcode::kParameter &&
+        fused->opcode() != HloOpcode::kConstant) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Fuses the candidates of one group, which all have the same output shape.
+// `candidates` are all the candidates of the computation, whose reachability
+// must be kept up to date, and `fused` the ones that were fused into others
+// and removed from the computation.
+bool FuseGroup(const std::vector<HloInstruction*>& group,
+               const std::vector<HloInstruction*>& candidates,
+               HloReachabilityMap* reachability,
+               tensorflow::gtl::FlatSet<HloInstruction*>* fused) {
+  bool changed = false;
+  HloInstruction* fusion = nullptr;
+  for (HloInstruction* instr : group) {
+    if (fusion == nullptr || reachability->IsConnected(fusion, instr) ||
+        GpuInstructionFusion::FusionWouldBeTooLarge(fusion, instr)) {
+      // Start a new horizontal fusion.
+      fusion = instr;
+      continue;
+    }
+    VLOG(2) << "Horizontally fusing " << instr->name() << " into "
+            << fusion->name();
+    // Everything reachable from either instruction is now reachable from both,
+    // like in MultiOutputFusion::UpdateReachability. The reachability map is
+    // based on the original computation, which works because reachability
+    // only increases with fusion.
+    for (HloInstruction* candidate : candidates) {
+      if (candidate == instr || fused->count(candidate) > 0) {
+        continue;
+      }
+      const bool reachable_from_instr =
+          reachability->IsReachable(instr, candidate);
+      const bool reachable_from_fusion =
+          reachability->IsReachable(fusion, candidate);
+      if (reachable_from_instr && !reachable_from_fusion) {
+        reachability->FastSetReachabilityToUnion({candidate, fusion},
+                                                 candidate);
+      } else if (reachable_from_fusion && !reachable_from_instr) {
+        reachability->FastSetReachabilityToUnion({candidate, instr}, candidate);
+      }
+    }
+    fusion->MergeFusionInstructionIntoMultiOutput(instr);
+    fused->insert(instr);
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+StatusOr<bool> GpuHorizontalFusion::Run(HloModule* module) {
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    std::vector<HloInstruction*> candidates;
+    // The candidates by output shape, in post order.
+    std::vector<std::vector<HloInstruction*>> groups;
+    for (HloInstruction* instr : computation->MakeInstructionPostOrder()) {
+      if (!IsHorizontallyFusible(instr)) {
+        continue;
+      }
+      candidates.push_back(instr);
+      auto it = std::find_if(
+          groups.begin(), groups.end(),
+          [&](const std::vector<HloInstruction*>& group) {
+            return ShapeUtil::EqualIgnoringFpPrecision(group.front()->shape(),
+                                                       instr->shape());
+          });
+      if (it == groups.end()) {
+        groups.push_back({instr});
+      } else {
+        it->push_back(instr);
+      }
+    }
+    if (candidates.size() < 2) {
+      continue;
+    }
+
+    std::unique_ptr<HloReachabilityMap> reachability =
+        computation->ComputeReachability();
+    tensorflow::gtl::FlatSet<HloInstruction*> fused;
+    for (const std::vector<HloInstruction*>& group : groups) {
+      if (group.size() > 1 &&
+          FuseGroup(group, candidates, reachability.get(), &fused)) {
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
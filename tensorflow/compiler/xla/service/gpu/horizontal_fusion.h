@@ -0,0 +1,53 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// An HLO pass that packs independent elementwise loop fusions into one
+// multi-output loop fusion, and thus into one kernel launch.
+//
+// Graphs with many small independent kernels, e.g. the per-variable updates
+// of an optimizer, are dominated by kernel launch overhead. Unlike the
+// producer-consumer fusions and the sibling fusions of GpuMultiOutputFusion,
+// the fused instructions don't have to share any operand. They must:
+//
+// 1) be loop fusions of elementwise instructions (and constants and
+//    broadcasts of scalars) with the same output shape, since the outputs of a
+//    multi-output loop fusion are emitted by a single loop, and
+// 2) not reach each other, so that fusing them doesn't create cycles, and
+// 3) not make a fusion that GpuInstructionFusion considers too large.
+//
+class GpuHorizontalFusion : public HloPassInterface {
+ public:
+  tensorflow::StringPiece name() const override { return "horizontal fusion"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // Fusions with more output elements than this are not small: their kernel
+  // launch overhead is negligible.
+  static constexpr int64 kMaxOutputElements = 1 << 20;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_FUSION_H_
@@ -0,0 +1,121 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using HorizontalFusionTest = HloTestBase;
+
+TEST_F(HorizontalFusionTest, FusesIndependentElementwiseFusions) {
+  auto module = ParseHloString(R"(
+    HloModule test_module
+
+    fused_computation.1 {
+      p.1 = f32[1024]{0} parameter(0)
+      lr.1 = f32[] parameter(1)
+      broadcast.1 = f32[1024]{0} broadcast(lr.1), dimensions={}
+      ROOT mul.1 = f32[1024]{0} multiply(p.1, broadcast.1)
+    }
+
+    fused_computation.2 {
+      p.2 = f32[1024]{0} parameter(0)
+      ROOT neg.2 = f32[1024]{0} negate(p.2)
+    }
+
+    ENTRY entry {
+      p0 = f32[1024]{0} parameter(0)
+      p1 = f32[1024]{0} parameter(1)
+      lr = f32[] parameter(2)
+      fusion.1 = f32[1024]{0} fusion(p0, lr), kind=kLoop, calls=fused_computation.1
+      fusion.2 = f32[1024]{0} fusion(p1), kind=kLoop, calls=fused_computation.2
+      ROOT root = (f32[1024]{0}, f32[1024]{0}) tuple(fusion.1, fusion.2)
+    })")
+                    .ValueOrDie();
+  ASSERT_TRUE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+  SCOPED_TRACE(module->ToString());
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::GetTupleElement(op::Fusion()),
+                              op::GetTupleElement(op::Fusion())));
+  const HloInstruction* fusion = root->operand(0)->operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  ASSERT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Multiply(), op::Negate()));
+}
+
+TEST_F(HorizontalFusionTest, DoesNotFuseDifferentShapes) {
+  auto module = ParseHloString(R"(
+    HloModule test_module
+
+    fused_computation.1 {
+      p.1 = f32[1024]{0} parameter(0)
+      ROOT neg.1 = f32[1024]{0} negate(p.1)
+    }
+
+    fused_computation.2 {
+      p.2 = f32[512]{0} parameter(0)
+      ROOT neg.2 = f32[512]{0} negate(p.2)
+    }
+
+    ENTRY entry {
+      p0 = f32[1024]{0} parameter(0)
+      p1 = f32[512]{0} parameter(1)
+      fusion.1 = f32[1024]{0} fusion(p0), kind=kLoop, calls=fused_computation.1
+      fusion.2 = f32[512]{0} fusion(p1), kind=kLoop, calls=fused_computation.2
+      ROOT root = (f32[1024]{0}, f32[512]{0}) tuple(fusion.1, fusion.2)
+    })")
+                    .ValueOrDie();
+  EXPECT_FALSE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+}
+
+TEST_F(HorizontalFusionTest, DoesNotFuseConnectedFusions) {
+  // fusion.2 depends on fusion.1 through an instruction that isn't a
+  // candidate, so fusing them would create a cycle.
+  auto module = ParseHloString(R"(
+    HloModule test_module
+
+    fused_computation.1 {
+      p.1 = f32[1024]{0} parameter(0)
+      ROOT neg.1 = f32[1024]{0} negate(p.1)
+    }
+
+    fused_computation.2 {
+      p.2 = f32[1024]{0} parameter(0)
+      ROOT neg.2 = f32[1024]{0} negate(p.2)
+    }
+
+    ENTRY entry {
+      p0 = f32[1024]{0} parameter(0)
+      fusion.1 = f32[1024]{0} fusion(p0), kind=kLoop, calls=fused_computation.1
+      reverse = f32[1024]{0} reverse(fusion.1), dimensions={0}
+      fusion.2 = f32[1024]{0} fusion(reverse), kind=kLoop, calls=fused_computation.2
+      ROOT root = (f32[1024]{0}, f32[1024]{0}) tuple(fusion.1, fusion.2)
+    })")
+                    .ValueOrDie();
+  EXPECT_FALSE(GpuHorizontalFusion().Run(module.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
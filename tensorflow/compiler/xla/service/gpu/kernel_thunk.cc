@@ -61,10 +61,11 @@ Status KernelThunk::Initialize(const GpuExecutable& executable,
   // profiles.
   auto it = kernel_cache_.find(executor);
   if (kernel_cache_.end() == it) {
-    it = kernel_cache_.emplace(executor, se::KernelBase(executor)).first;
-    if (!executor->GetKernel(*loader_spec_, &it->second)) {
+    auto loaded = MakeUnique<LoadedKernel>(executor);
+    if (!executor->GetKernel(*loader_spec_, &loaded->kernel)) {
       return InternalError("Unable to load kernel %s", kernel_name_.c_str());
     }
+    kernel_cache_.emplace(executor, std::move(loaded));
   }
 
   return Status::OK();
@@ -81,7 +82,7 @@ Status KernelThunk::ExecuteOnStream(const BufferAllocations& buffer_allocations,
   // Load the kernel.
   se::StreamExecutor* executor = stream->parent();
   LaunchDimensions launch_dimensions;
-  const se::KernelBase* kernel = nullptr;
+  LoadedKernel* loaded = nullptr;
 
   {
     tensorflow::mutex_lock lock(mutex_);
@@ -89,24 +90,33 @@ Status KernelThunk::ExecuteOnStream(const BufferAllocations& buffer_allocations,
     CHECK(it != kernel_cache_.end())
         << "Initialize() not called for StreamExecutor " << executor;
     launch_dimensions = launch_dimensions_;
-    kernel = &it->second;
+    loaded = it->second.get();
   }
 
-  VLOG(3) << "Launching " << kernel->name();
-  // Launch the kernel with potentially multiple blocks and threads.
-  static constexpr int kKernelArgsLimit = 1024;
-  auto kernel_args = MakeUnique<se::KernelArgsArray<kKernelArgsLimit>>();
-  for (const BufferAllocation* arg : args_) {
+  VLOG(3) << "Launching " << loaded->kernel.name();
+  // Launch the kernel with potentially multiple blocks and threads. The
+  // arguments are packed on the first launch only.
+  tensorflow::mutex_lock args_lock(loaded->args_mutex);
+  const bool pack_args = loaded->args == nullptr;
+  if (pack_args) {
+    loaded->args = MakeUnique<se::KernelArgsArray<kKernelArgsLimit>>();
+  }
+  for (size_t i = 0; i < args_.size(); ++i) {
+    const BufferAllocation* arg = args_[i];
     const auto& buf = buffer_allocations.GetDeviceAddress(arg->index());
-    kernel_args->add_device_memory_argument(buf);
+    if (pack_args) {
+      loaded->args->add_device_memory_argument(buf);
+    } else {
+      loaded->args->set_device_memory_argument(i, buf);
+    }
     VLOG(3) << "  Arg: alloc #" << arg->index() << ": " << buf.opaque() << " ("
             << buf.size() << "B)";
   }
   auto op_profiler = profiler->MakeScopedInstructionProfiler(hlo_instruction());
   if (!stream->parent()->Launch(
           stream, se::ThreadDim(launch_dimensions.threads_per_block()),
-          se::BlockDim(launch_dimensions.block_count()), *kernel,
-          *kernel_args)) {
+          se::BlockDim(launch_dimensions.block_count()), loaded->kernel,
+          *loaded->args)) {
     return InternalError("Unable to launch kernel %s", kernel_name_.c_str());
   }
   return Status::OK();
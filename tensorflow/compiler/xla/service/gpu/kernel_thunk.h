@@ -60,6 +60,7 @@ class KernelThunk : public Thunk {
 
   Status Initialize(const GpuExecutable& executable,
                     se::StreamExecutor* executor) override;
+  bool SupportsGraphCapture() const override { return true; }
 
   // Executes the kernel for the thunk on "stream", which must be non-null.
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
@@ -67,6 +68,21 @@ class KernelThunk : public Thunk {
                          HloExecutionProfiler* profiler) override;
 
  private:
+  static constexpr int kKernelArgsLimit = 1024;
+
+  // A kernel loaded for a `StreamExecutor`, with the arguments of its last
+  // launch. The layout of the arguments doesn't change between launches, so
+  // later launches only update the buffer addresses in place.
+  struct LoadedKernel {
+    explicit LoadedKernel(se::StreamExecutor* executor) : kernel(executor) {}
+
+    se::KernelBase kernel;
+    // Held while the arguments are updated and the kernel is launched.
+    tensorflow::mutex args_mutex;
+    std::unique_ptr<se::KernelArgsArray<kKernelArgsLimit>> args
+        GUARDED_BY(args_mutex);
+  };
+
   // Buffers passed to the kernel as arguments.
   const std::vector<const BufferAllocation*> args_;
 
@@ -86,10 +102,9 @@ class KernelThunk : public Thunk {
   mutable tensorflow::mutex mutex_;
   std::unique_ptr<se::MultiKernelLoaderSpec> loader_spec_ GUARDED_BY(mutex_);
 
-  // Loaded kernels for each `StreamExecutor`.  Requires pointer stability of
-  // values.
-  std::unordered_map<se::StreamExecutor*, se::KernelBase> kernel_cache_
-      GUARDED_BY(mutex_);
+  // Loaded kernels for each `StreamExecutor`.
+  std::unordered_map<se::StreamExecutor*, std::unique_ptr<LoadedKernel>>
+      kernel_cache_ GUARDED_BY(mutex_);
 };
 
 }  // namespace gpu
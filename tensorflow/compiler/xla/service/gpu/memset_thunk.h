@@ -36,6 +36,7 @@ class MemzeroThunk : public Thunk {
                         const HloInstruction* hlo)
       : Thunk(Kind::kMemzero, hlo), dest_(dest) {}
 
+  bool SupportsGraphCapture() const override { return true; }
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
@@ -53,6 +54,7 @@ class Memset32BitValueThunk : public Thunk {
                                  const HloInstruction* hlo)
       : Thunk(Kind::kMemset32BitValue, hlo), value_(value), dest_(dest) {}
 
+  bool SupportsGraphCapture() const override { return true; }
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
@@ -46,6 +46,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_support_checker.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/hlo_schedule.h"
+#include "tensorflow/compiler/xla/service/gpu/horizontal_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
@@ -66,6 +67,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_proto_util.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
+#include "tensorflow/compiler/xla/service/hlo_scheduling.h"
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
@@ -273,6 +276,14 @@ Status OptimizeHloModule(HloModule* hlo_module, se::StreamExecutor* stream_exec,
       // fuse the new ReducePrecision operations.
       TF_RETURN_IF_ERROR(fusion.Run(hlo_module).status());
     }
+
+    // Pack the independent small kernels that are left into fewer kernel
+    // launches. This runs after the fusion pipeline because it turns the
+    // fusions into multi-output fusions, which it would no longer fuse.
+    HloPassPipeline horizontal_fusion("horizontal-fusion");
+    horizontal_fusion.AddInvariantChecker<HloVerifier>();
+    horizontal_fusion.AddPass<GpuHorizontalFusion>();
+    TF_RETURN_IF_ERROR(horizontal_fusion.Run(hlo_module).status());
   }
 
   {
@@ -528,13 +539,40 @@ StatusOr<std::unique_ptr<Executable>> NVPTXCompiler::RunBackend(
   llvm_module.setTargetTriple(kTargetTriple);
   llvm_module.setDataLayout(kDataLayout);
 
+  // Rematerialize instructions if the module doesn't fit in the memory of the
+  // device.  This runs before the streams are assigned, so that the
+  // rematerialized instructions get streams too, and the order it assumed is
+  // kept as the thunk launch order: the launch order favoring concurrency
+  // across streams would compute the rematerialized instructions too early.
+  SequentialHloOrdering::HloModuleSequence module_sequence;
+  const std::vector<const HloInstruction*>* entry_sequence = nullptr;
+  int64 memory_limit_bytes =
+      module->config().debug_options().xla_gpu_memory_limit_bytes();
+  if (memory_limit_bytes == 0) {
+    memory_limit_bytes =
+        stream_exec->GetDeviceDescription().device_memory_size();
+  }
+  if (memory_limit_bytes > 0) {
+    TF_ASSIGN_OR_RETURN(
+        bool rematerialized,
+        HloRematerialization::RematerializeAndSchedule(
+            [this](const Shape& shape) {
+              return ShapeUtil::ByteSizeOf(shape, pointer_size_);
+            },
+            memory_limit_bytes, module.get(), DefaultMemoryScheduler,
+            &module_sequence, /*sizes=*/nullptr));
+    if (rematerialized) {
+      entry_sequence = &module_sequence.at(module->entry_computation());
+    }
+  }
+
   // Determine the HLO schedule, which is an ordering of HLO instructions.  This
   // is used by buffer assignment to enable buffer reuse, and the same ordering
   // must also be used to determine the thunk launch schedule.
   std::unique_ptr<StreamAssignment> stream_assignment = AssignStreams(*module);
-  TF_ASSIGN_OR_RETURN(
-      std::unique_ptr<HloSchedule> hlo_schedule,
-      HloSchedule::Build(*module, *stream_assignment, pointer_size_));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloSchedule> hlo_schedule,
+                      HloSchedule::Build(*module, *stream_assignment,
+                                         pointer_size_, entry_sequence));
 
   // Run buffer analysis on the HLO graph. This analysis figures out which
   // temporary buffers are required to run the computation.
@@ -41,6 +41,7 @@ class SequentialThunk : public Thunk {
 
   Status Initialize(const GpuExecutable& executable,
                     se::StreamExecutor* executor) override;
+  bool SupportsGraphCapture() const override;
   Status ExecuteOnStream(const BufferAllocations& buffer_allocations,
                          se::Stream* stream,
                          HloExecutionProfiler* profiler) override;
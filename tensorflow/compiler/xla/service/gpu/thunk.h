@@ -94,6 +94,12 @@ class Thunk {
     return false;
   }
 
+  // Returns true if the work ExecuteOnStream enqueues on a stream can be
+  // captured into a CUDA graph and replayed later with the same buffers.  The
+  // work must not synchronize with the host, allocate memory, or read host
+  // memory.
+  virtual bool SupportsGraphCapture() const { return false; }
+
   // Execute the kernel for the thunk on the given stream. This method must be
   // called after Initialize and can be called multiple times over Thunk's
   // lifetime. 'stream' and 'profiler' must be non-null.
@@ -280,8 +280,10 @@ class ReduceTest : public ClientLibraryTestBase {
           reduction_function_generator,
       const std::function<NativeT(NativeT, NativeT)>&
           reference_reduction_function,
-      const NativeT& initial_value) {
-    const int rows = 64, cols = 128;
+      const NativeT& initial_value, int64 dimension_to_reduce = 0) {
+    // Reducing the minor dimension (1) vectorizes along each row, so make the
+    // rows long enough to need tiled, vector and scalar loops.
+    const int rows = 64, cols = dimension_to_reduce == 0 ? 128 : 155;
     const int minor = 1, major = 0;
     XlaBuilder builder(TestName());
     XlaComputation reduction_function = reduction_function_generator(&builder);
@@ -290,7 +292,7 @@ class ReduceTest : public ClientLibraryTestBase {
     auto input = Parameter(&builder, 0, input_shape, "input");
     auto zero = ConstantR0<NativeT>(&builder, initial_value);
     Reduce(input, zero, reduction_function,
-           /*dimensions_to_reduce=*/{0});
+           /*dimensions_to_reduce=*/{dimension_to_reduce});
 
     Array2D<NativeT> input_data(rows, cols);
     input_data.FillUnique(initial_value);
@@ -303,18 +305,21 @@ class ReduceTest : public ClientLibraryTestBase {
 
     // NativeT can be bool, and std::vector<bool> does not convert to
     // ArraySlice.
-    std::unique_ptr<NativeT[]> expected(new NativeT[cols]);
-    for (int64 colno = 0; colno < cols; ++colno) {
-      NativeT column_result = initial_value;
-      for (int64 rowno = 0; rowno < rows; ++rowno) {
-        column_result = reference_reduction_function(column_result,
-                                                     input_data(rowno, colno));
+    const int64 result_size = dimension_to_reduce == 0 ? cols : rows;
+    std::unique_ptr<NativeT[]> expected(new NativeT[result_size]);
+    for (int64 i = 0; i < result_size; ++i) {
+      expected[i] = initial_value;
+    }
+    for (int64 rowno = 0; rowno < rows; ++rowno) {
+      for (int64 colno = 0; colno < cols; ++colno) {
+        NativeT& result = expected[dimension_to_reduce == 0 ? colno : rowno];
+        result = reference_reduction_function(result, input_data(rowno, colno));
       }
-      expected[colno] = column_result;
     }
 
     ComputeAndCompareGeneric<NativeT>(
-        &builder, tensorflow::gtl::ArraySlice<NativeT>(expected.get(), cols),
+        &builder,
+        tensorflow::gtl::ArraySlice<NativeT>(expected.get(), result_size),
         {input_global_data.get()});
   }
 
@@ -328,27 +333,30 @@ class ReduceTest : public ClientLibraryTestBase {
       const std::function<uint32(uint32, uint32)>&
           reference_reduction_function_for_uints,
       float floating_point_identity, int32 signed_int_identity,
-      uint32 unsigned_int_identity) {
+      uint32 unsigned_int_identity, int64 dimension_to_reduce = 0) {
     // Float version
     RunVectorizedReduceTestForType<float>(
         [&](XlaBuilder* builder) {
           return reduction_function_generator_for_type(F32, builder);
         },
-        reference_reduction_function_for_floats, floating_point_identity);
+        reference_reduction_function_for_floats, floating_point_identity,
+        dimension_to_reduce);
 
     // Signed int version
     RunVectorizedReduceTestForType<int32>(
         [&](XlaBuilder* builder) {
           return reduction_function_generator_for_type(S32, builder);
         },
-        reference_reduction_function_for_ints, signed_int_identity);
+        reference_reduction_function_for_ints, signed_int_identity,
+        dimension_to_reduce);
 
     // Unsigned int version
     RunVectorizedReduceTestForType<uint32>(
         [&](XlaBuilder* builder) {
           return reduction_function_generator_for_type(U32, builder);
         },
-        reference_reduction_function_for_uints, unsigned_int_identity);
+        reference_reduction_function_for_uints, unsigned_int_identity,
+        dimension_to_reduce);
   }
 
   std::unique_ptr<Literal> literal_2d_;
@@ -812,6 +820,37 @@ XLA_TEST_F(ReduceTest, VectorizedReduce_BooleanOr) {
       [](bool a, bool b) { return a || b; }, false);
 }
 
+XLA_TEST_F(ReduceTest, VectorizedReduceMinorDimension_Add) {
+  RunVectorizedReduceTest(
+      static_cast<FuncGeneratorForType>(CreateScalarAddComputation),
+      [](float a, float b) { return a + b; },
+      [](int32 a, int32 b) {
+        return static_cast<int32>(static_cast<uint32>(a) +
+                                  static_cast<uint32>(b));
+      },
+      [](uint32 a, uint32 b) { return a + b; }, 0.0, 0, 0,
+      /*dimension_to_reduce=*/1);
+}
+
+XLA_TEST_F(ReduceTest, VectorizedReduceMinorDimension_Max) {
+  RunVectorizedReduceTest(
+      static_cast<FuncGeneratorForType>(CreateScalarMaxComputation),
+      [](float a, float b) { return std::max(a, b); },
+      [](int32 a, int32 b) { return std::max(a, b); },
+      [](uint32 a, uint32 b) { return std::max(a, b); },
+      std::numeric_limits<float>::min(), std::numeric_limits<int32>::min(),
+      std::numeric_limits<uint32>::min(), /*dimension_to_reduce=*/1);
+}
+
+XLA_TEST_F(ReduceTest, VectorizedReduceMinorDimension_BooleanOr) {
+  RunVectorizedReduceTestForType<bool>(
+      static_cast<FuncGenerator>([](XlaBuilder* builder) {
+        return CreateScalarOrComputation(PRED, builder);
+      }),
+      [](bool a, bool b) { return a || b; }, false,
+      /*dimension_to_reduce=*/1);
+}
+
 class ReduceR3ToR2Test : public ReduceTest,
                          public ::testing::WithParamInterface<BoundsLayout> {};
 
@@ -58,7 +58,8 @@ def batch_function(num_batch_threads,
                    max_batch_size,
                    batch_timeout_micros,
                    allowed_batch_sizes=None,
-                   max_enqueued_batches=10):
+                   max_enqueued_batches=10,
+                   enable_ragged_batching=False):
   """Batches the computation done by the decorated function.
 
   So, for example, in the following code
@@ -93,6 +94,9 @@ def batch_function(num_batch_threads,
      to pad batches up to one of those sizes. The entries must increase
      monotonically, and the final entry must equal max_batch_size.
     max_enqueued_batches: The maximum depth of the batch queue. Defaults to 10.
+    enable_ragged_batching: If True, a batch may be split into several batches
+     of allowed_batch_sizes that add up to its size instead of being padded,
+     when that saves more padding than the extra calls cost.
 
   Returns:
     The decorated function will return the unbatched computation output Tensors.
@@ -119,6 +123,7 @@ def batch_function(num_batch_threads,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
             max_enqueued_batches=max_enqueued_batches,
+            enable_ragged_batching=enable_ragged_batching,
             shared_name=name,
             f=computation,
             in_tensors=list(args),
@@ -321,6 +321,31 @@ class BatchOpsTest(test.TestCase):
       self.assertEqual(thread_results[0], [2])
       self.assertEqual(main_results[0], [3])
 
+  def testBatchFunctionOpWithRaggedBatching(self):
+    """Tests that batch_function splits batches instead of padding them."""
+    with self.test_session() as sess:
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        # Adds the size of the batch the function runs on.
+        return in_t + array_ops.shape(in_t)[0]
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[6])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=8,
+          batch_timeout_micros=1000,
+          allowed_batch_sizes=[2, 4, 8],
+          enable_ragged_batching=True,
+          Tout=[dtypes.int32],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      # The batch of 6 runs as batches of 4 and 2 rather than padded to 8.
+      self.assertAllEqual(
+          sess.run(result, feed_dict={inp: [0, 0, 0, 0, 0, 0]}),
+          [[4, 4, 4, 4, 2, 2]])
+
   def testBatchFunctionOpWithInputError(self):
     """Tests that batch_function op works with error in the inputs."""
     with self.test_session() as sess:
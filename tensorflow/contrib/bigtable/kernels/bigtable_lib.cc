@@ -42,4 +42,53 @@ string RegexFromStringSet(const std::vector<string>& strs) {
   return str_util::Join(uniq, "|");
 }
 
+::google::cloud::bigtable::Filter MakeScanFilter(
+    const string& column_family_regex, const string& column_regex,
+    float probability) {
+  // TODO(saeta): Investigate optimal ordering here.
+  return ::google::cloud::bigtable::Filter::Chain(
+      ::google::cloud::bigtable::Filter::Latest(1),
+      ::google::cloud::bigtable::Filter::FamilyRegex(column_family_regex),
+      ::google::cloud::bigtable::Filter::ColumnRegex(column_regex),
+      probability != 1.0
+          ? ::google::cloud::bigtable::Filter::RowSample(probability)
+          : ::google::cloud::bigtable::Filter::PassAllFilter());
+}
+
+Status ParseScanRow(Allocator* allocator,
+                    const ::google::cloud::bigtable::Row& row,
+                    const std::vector<string>& column_families,
+                    const std::vector<string>& columns,
+                    std::vector<Tensor>* out_tensors) {
+  out_tensors->reserve(columns.size() + 1);
+  Tensor row_key_tensor(allocator, DT_STRING, {});
+  row_key_tensor.scalar<string>()() = string(row.row_key());
+  out_tensors->emplace_back(std::move(row_key_tensor));
+
+  if (row.cells().size() > 2 * columns.size()) {
+    LOG(WARNING) << "An excessive number of columns (" << row.cells().size()
+                 << ") were retrieved when reading row: " << row.row_key();
+  }
+
+  for (uint64 i = 0; i < columns.size(); ++i) {
+    Tensor col_tensor(allocator, DT_STRING, {});
+    bool found_column = false;
+    for (auto cell_itr = row.cells().begin();
+         !found_column && cell_itr != row.cells().end(); ++cell_itr) {
+      if (cell_itr->family_name() == column_families[i] &&
+          string(cell_itr->column_qualifier()) == columns[i]) {
+        col_tensor.scalar<string>()() = string(cell_itr->value());
+        found_column = true;
+      }
+    }
+    if (!found_column) {
+      return errors::InvalidArgument("Column ", column_families[i], ":",
+                                     columns[i],
+                                     " not found in row: ", row.row_key());
+    }
+    out_tensors->emplace_back(std::move(col_tensor));
+  }
+  return Status::OK();
+}
+
 }  // namespace tensorflow
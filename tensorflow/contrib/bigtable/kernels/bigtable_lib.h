@@ -29,6 +29,21 @@ Status GrpcStatusToTfStatus(const ::grpc::Status& status);
 
 string RegexFromStringSet(const std::vector<string>& strs);
 
+// Returns the filter of a scan that keeps the latest cell of the matching
+// columns, in rows sampled with `probability`.
+::google::cloud::bigtable::Filter MakeScanFilter(
+    const string& column_family_regex, const string& column_regex,
+    float probability);
+
+// Appends the key of `row` followed by the values of the `columns` from the
+// `column_families` to `out_tensors`, as scalar strings. Fails if a column is
+// missing from the row.
+Status ParseScanRow(Allocator* allocator,
+                    const ::google::cloud::bigtable::Row& row,
+                    const std::vector<string>& column_families,
+                    const std::vector<string>& columns,
+                    std::vector<Tensor>* out_tensors);
+
 class BigtableClientResource : public ResourceBase {
  public:
   BigtableClientResource(
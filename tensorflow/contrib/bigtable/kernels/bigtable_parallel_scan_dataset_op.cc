@@ -0,0 +1,368 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+
+#include "tensorflow/contrib/bigtable/kernels/bigtable_lib.h"
+#include "tensorflow/contrib/bigtable/kernels/bigtable_range_helpers.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+
+namespace tensorflow {
+namespace {
+
+// Scans a range of a table with several concurrent streaming reads, one per
+// sub-range between the sample row keys of the table, which usually fall on
+// tablet boundaries. Rows are produced in the order they arrive.
+class BigtableParallelScanDatasetOp : public DatasetOpKernel {
+ public:
+  using DatasetOpKernel::DatasetOpKernel;
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    string prefix;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "prefix", &prefix));
+    string start_key;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "start_key", &start_key));
+    string end_key;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "end_key", &end_key));
+
+    OP_REQUIRES(ctx, prefix.empty() || start_key.empty(),
+                errors::InvalidArgument(
+                    "Only one of prefix and start_key can be provided"));
+    if (!prefix.empty()) {
+      OP_REQUIRES(ctx, end_key.empty(),
+                  errors::InvalidArgument(
+                      "If prefix is specified, end_key must be empty."));
+    }
+
+    std::vector<string> column_families;
+    std::vector<string> columns;
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<string>(ctx, "column_families",
+                                                    &column_families));
+    OP_REQUIRES_OK(ctx, ParseVectorArgument<string>(ctx, "columns", &columns));
+    OP_REQUIRES(
+        ctx, column_families.size() == columns.size(),
+        errors::InvalidArgument("len(columns) != len(column_families)"));
+    OP_REQUIRES(ctx, !column_families.empty(),
+                errors::InvalidArgument("`column_families` is empty"));
+
+    float probability = 0;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<float>(ctx, "probability", &probability));
+    OP_REQUIRES(
+        ctx, probability > 0 && probability <= 1,
+        errors::InvalidArgument(
+            "Probability outside the range of (0, 1]. Got: ", probability));
+
+    int64 num_parallel_scans = 0;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "num_parallel_scans",
+                                                   &num_parallel_scans));
+    OP_REQUIRES(ctx, num_parallel_scans > 0,
+                errors::InvalidArgument(
+                    "num_parallel_scans must be positive. Got: ",
+                    num_parallel_scans));
+    int64 buffer_size = 0;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size > 0,
+                errors::InvalidArgument("buffer_size must be positive. Got: ",
+                                        buffer_size));
+
+    BigtableTableResource* resource;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &resource));
+
+    const uint64 num_outputs = columns.size() + 1;
+    std::vector<PartialTensorShape> output_shapes;
+    output_shapes.reserve(num_outputs);
+    DataTypeVector output_types;
+    output_types.reserve(num_outputs);
+    for (uint64 i = 0; i < num_outputs; ++i) {
+      output_shapes.push_back({});
+      output_types.push_back(DT_STRING);
+    }
+
+    *output = new Dataset(
+        ctx, resource, std::move(prefix), std::move(start_key),
+        std::move(end_key), std::move(column_families), std::move(columns),
+        probability, num_parallel_scans, buffer_size, output_types,
+        std::move(output_shapes));
+  }
+
+ private:
+  class Dataset : public GraphDatasetBase {
+   public:
+    explicit Dataset(OpKernelContext* ctx, BigtableTableResource* table,
+                     string prefix, string start_key, string end_key,
+                     std::vector<string> column_families,
+                     std::vector<string> columns, float probability,
+                     int64 num_parallel_scans, int64 buffer_size,
+                     const DataTypeVector& output_types,
+                     std::vector<PartialTensorShape> output_shapes)
+        : GraphDatasetBase(ctx),
+          table_(table),
+          key_range_(MakeMultiModeKeyRange(
+              std::move(prefix), std::move(start_key), std::move(end_key))),
+          column_families_(std::move(column_families)),
+          columns_(std::move(columns)),
+          column_family_regex_(RegexFromStringSet(column_families_)),
+          column_regex_(RegexFromStringSet(columns_)),
+          probability_(probability),
+          num_parallel_scans_(num_parallel_scans),
+          buffer_size_(buffer_size),
+          output_types_(output_types),
+          output_shapes_(std::move(output_shapes)) {
+      table_->Ref();
+    }
+
+    ~Dataset() override { table_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(
+          {this, strings::StrCat(prefix, "::BigtableParallelScanDataset")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "BigtableParallelScanDatasetOp::Dataset";
+    }
+
+   private:
+    static MultiModeKeyRange MakeMultiModeKeyRange(string prefix,
+                                                   string start_key,
+                                                   string end_key) {
+      if (!start_key.empty()) {
+        return MultiModeKeyRange::FromRange(std::move(start_key),
+                                            std::move(end_key));
+      }
+      return MultiModeKeyRange::FromPrefix(std::move(prefix));
+    }
+
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      ~Iterator() override {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        // Joins the worker threads, which stop after their current row.
+        worker_threads_.clear();
+      }
+
+      // Splits the range to scan at the sample row keys of the table. They
+      // are sampled again for each iterator, in case tablets were rebalanced
+      // since the dataset was created.
+      Status Initialize(IteratorContext* ctx) override {
+        grpc::Status status;
+        std::vector<google::cloud::bigtable::RowKeySample> row_keys =
+            dataset()->table_->table().SampleRows(status);
+        if (!status.ok()) {
+          return GrpcStatusToTfStatus(status);
+        }
+        std::vector<string> sample_keys;
+        sample_keys.reserve(row_keys.size());
+        for (size_t i = 0; i < row_keys.size(); ++i) {
+          sample_keys.emplace_back(row_keys[i].row_key);
+        }
+        keys_ = SplitKeyRange(dataset()->key_range_, sample_keys);
+        // Scans neighboring sub-ranges at different times, so that the
+        // concurrent reads spread over the tablet servers.
+        range_order_.resize(keys_.size() - 1);
+        std::iota(range_order_.begin(), range_order_.end(), 0);
+        random::PhiloxRandom philox(random::New64(), random::New64());
+        random::SimplePhilox rng(&philox);
+        for (size_t i = range_order_.size(); i > 1; --i) {
+          std::swap(range_order_[i - 1], range_order_[rng.Uniform(i)]);
+        }
+        return Status::OK();
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureWorkerThreadsStarted(ctx);
+        while (buffer_.empty() && status_.ok() && num_running_workers_ > 0) {
+          cond_var_.wait(l);
+        }
+        if (!status_.ok()) {
+          return status_;
+        }
+        if (buffer_.empty()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        *out_tensors = std::move(buffer_.front());
+        buffer_.pop_front();
+        *end_of_sequence = false;
+        // Wake the workers waiting for space in the buffer.
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+     private:
+      void EnsureWorkerThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (workers_started_) {
+          return;
+        }
+        workers_started_ = true;
+        const int64 num_workers = std::min<int64>(
+            dataset()->num_parallel_scans_, range_order_.size());
+        num_running_workers_ = num_workers;
+        std::shared_ptr<IteratorContext> worker_ctx(new IteratorContext(*ctx));
+        for (int64 i = 0; i < num_workers; ++i) {
+          worker_threads_.emplace_back(ctx->env()->StartThread(
+              {}, "bigtable_parallel_scan",
+              std::bind(&Iterator::WorkerThread, this, worker_ctx)));
+        }
+      }
+
+      // Scans sub-ranges until none is left, the iterator is destroyed or a
+      // scan fails.
+      void WorkerThread(const std::shared_ptr<IteratorContext>& ctx) {
+        while (true) {
+          size_t range;
+          {
+            mutex_lock l(mu_);
+            if (cancelled_ || !status_.ok() ||
+                next_range_ == range_order_.size()) {
+              break;
+            }
+            range = range_order_[next_range_++];
+          }
+          Status s = ScanRange(ctx.get(), keys_[range], keys_[range + 1]);
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            if (status_.ok()) {
+              status_ = s;
+            }
+            break;
+          }
+        }
+        mutex_lock l(mu_);
+        --num_running_workers_;
+        cond_var_.notify_all();
+      }
+
+      Status ScanRange(IteratorContext* ctx, const string& begin_key,
+                       const string& end_key) {
+        const uint64 start_micros = ctx->env()->NowMicros();
+        int64 num_rows = 0;
+        int64 num_bytes = 0;
+        std::unique_ptr<::google::cloud::bigtable::RowReader> reader(
+            new ::google::cloud::bigtable::RowReader(
+                dataset()->table_->table().ReadRows(
+                    ::google::cloud::bigtable::RowRange::Range(begin_key,
+                                                               end_key),
+                    MakeScanFilter(dataset()->column_family_regex_,
+                                   dataset()->column_regex_,
+                                   dataset()->probability_))));
+        for (auto it = reader->begin(); it != reader->end(); ++it) {
+          std::vector<Tensor> row;
+          TF_RETURN_IF_ERROR(ParseScanRow(ctx->allocator({}), *it,
+                                          dataset()->column_families_,
+                                          dataset()->columns_, &row));
+          for (const Tensor& t : row) {
+            num_bytes += t.scalar<string>()().size();
+          }
+          ++num_rows;
+
+          mutex_lock l(mu_);
+          while (!cancelled_ && status_.ok() &&
+                 buffer_.size() >=
+                     static_cast<size_t>(dataset()->buffer_size_)) {
+            cond_var_.wait(l);
+          }
+          // Stops early when the iterator is destroyed or another scan failed.
+          if (cancelled_ || !status_.ok()) {
+            return Status::OK();
+          }
+          buffer_.push_back(std::move(row));
+          cond_var_.notify_all();
+        }
+        TF_RETURN_IF_ERROR(GrpcStatusToTfStatus(reader->Finish()));
+
+        const double seconds =
+            std::max<uint64>(ctx->env()->NowMicros() - start_micros, 1) / 1e6;
+        VLOG(1) << "Scanned " << num_rows << " rows (" << num_bytes
+                << " bytes) of tablet [" << begin_key << ", " << end_key
+                << ") in " << seconds << " s";
+        auto stats_aggregator = ctx->stats_aggregator();
+        if (stats_aggregator) {
+          stats_aggregator->AddToHistogram("bigtable_tablet_rows_per_second",
+                                           {num_rows / seconds});
+          stats_aggregator->AddToHistogram("bigtable_tablet_bytes_per_second",
+                                           {num_bytes / seconds});
+        }
+        return Status::OK();
+      }
+
+      // The boundaries of the sub-ranges to scan, and the order to scan them
+      // in. Read-only after Initialize.
+      std::vector<string> keys_;
+      std::vector<size_t> range_order_;
+
+      mutex mu_;
+      // Signals changes of the buffer, of the number of running workers and
+      // of `cancelled_`.
+      condition_variable cond_var_;
+      std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+      size_t next_range_ GUARDED_BY(mu_) = 0;
+      int64 num_running_workers_ GUARDED_BY(mu_) = 0;
+      bool workers_started_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      Status status_ GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<Thread>> worker_threads_;
+    };
+
+    BigtableTableResource* const table_;
+    const MultiModeKeyRange key_range_;
+    const std::vector<string> column_families_;
+    const std::vector<string> columns_;
+    const string column_family_regex_;
+    const string column_regex_;
+    const float probability_;
+    const int64 num_parallel_scans_;
+    const int64 buffer_size_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("BigtableParallelScanDataset").Device(DEVICE_CPU),
+    BigtableParallelScanDatasetOp);
+
+}  // namespace
+}  // namespace tensorflow
@@ -65,4 +65,33 @@ bool MultiModeKeyRange::contains_key(StringPiece key) const {
   return true;
 }
 
+std::vector<string> SplitKeyRange(const MultiModeKeyRange& range,
+                                  const std::vector<string>& sample_keys) {
+  std::vector<string> keys;
+  for (const string& sample_key : sample_keys) {
+    if (range.contains_key(sample_key)) {
+      // First key: check to see if we need to add the begin_key.
+      if (keys.empty() && range.begin_key() != sample_key) {
+        keys.push_back(range.begin_key());
+      }
+      keys.push_back(sample_key);
+    } else if (!keys.empty()) {
+      // Because `sample_keys` is sorted and ranges are contiguous, a key
+      // outside of the range after one inside it ends the range.
+      break;
+    }
+  }
+
+  // Handle the case where we skip over the selected range entirely.
+  if (keys.empty()) {
+    keys.push_back(range.begin_key());
+  }
+
+  // Last key: check to see if we need to add the end_key.
+  if (keys.size() == 1 || keys.back() != range.end_key()) {
+    keys.push_back(range.end_key());
+  }
+  return keys;
+}
+
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CONTRIB_BIGTABLE_KERNELS_BIGTABLE_RANGE_HELPERS_H_
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/types.h"
@@ -62,6 +63,15 @@ class MultiModeKeyRange {
   const string end_;
 };
 
+// Returns the boundaries of the sub-ranges to scan `range` in, given the
+// sorted `sample_keys` of a table, which usually fall on tablet boundaries.
+//
+// The result starts with `range.begin_key()` and ends with `range.end_key()`,
+// and sub-range i spans keys [result[i], result[i + 1]). Sample keys outside
+// of `range` are dropped, so the result always holds at least two keys.
+std::vector<string> SplitKeyRange(const MultiModeKeyRange& range,
+                                  const std::vector<string>& sample_keys);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CONTRIB_BIGTABLE_KERNELS_BIGTABLE_RANGE_HELPERS_H_
@@ -103,5 +103,25 @@ TEST(MultiModeKeyRangeTest, PrefixSignedWrapAround) {
   EXPECT_FALSE(r.contains_key("ab\x80"));
 }
 
+TEST(SplitKeyRangeTest, KeysWithinRange) {
+  MultiModeKeyRange r = MultiModeKeyRange::FromRange("b", "f");
+  EXPECT_EQ(std::vector<string>({"b", "c", "e", "f"}),
+            SplitKeyRange(r, {"a", "c", "e", "g"}));
+  EXPECT_EQ(std::vector<string>({"b", "c", "f"}),
+            SplitKeyRange(r, {"b", "c", "f"}));
+}
+
+TEST(SplitKeyRangeTest, NoKeysWithinRange) {
+  MultiModeKeyRange r = MultiModeKeyRange::FromPrefix("r");
+  EXPECT_EQ(std::vector<string>({"r", "s"}), SplitKeyRange(r, {"a", "z"}));
+  EXPECT_EQ(std::vector<string>({"r", "s"}), SplitKeyRange(r, {}));
+}
+
+TEST(SplitKeyRangeTest, EverythingWithoutSamples) {
+  MultiModeKeyRange r = MultiModeKeyRange::FromPrefix("");
+  EXPECT_EQ(std::vector<string>({"", ""}), SplitKeyRange(r, {}));
+  EXPECT_EQ(std::vector<string>({"", "m", ""}), SplitKeyRange(r, {"m"}));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -108,12 +108,9 @@ class BigtableSampleKeyPairsDatasetOp : public DatasetOpKernel {
       // Computes split points (`keys_`) to use when scanning the table.
       //
       // Initialize first retrieves the sample keys from the table (`row_keys`),
-      // as these often form good split points within the table. We then iterate
-      // over them, and copy them to `keys_` if they fall within the requested
-      // range to scan (`dataset()->key_range_`). Because the requested range
-      // might start between elements of the sampled keys list, care is taken to
-      // ensure we don't accidentally miss any subsets of the requested range by
-      // including `begin_key()` and `end_key()` as appropriate.
+      // as these often form good split points within the table, and then keeps
+      // the ones within the requested range to scan (`dataset()->key_range_`),
+      // see SplitKeyRange.
       Status Initialize(IteratorContext* ctx) override {
         grpc::Status status;
         std::vector<google::cloud::bigtable::RowKeySample> row_keys =
@@ -122,34 +119,12 @@ class BigtableSampleKeyPairsDatasetOp : public DatasetOpKernel {
           return GrpcStatusToTfStatus(status);
         }
 
+        std::vector<string> sample_keys;
+        sample_keys.reserve(row_keys.size());
         for (size_t i = 0; i < row_keys.size(); ++i) {
-          string row_key(row_keys[i].row_key);
-          if (dataset()->key_range_.contains_key(row_key)) {
-            // First key: check to see if we need to add the begin_key.
-            if (keys_.empty() && dataset()->key_range_.begin_key() != row_key) {
-              keys_.push_back(dataset()->key_range_.begin_key());
-            }
-            keys_.push_back(std::move(row_key));
-          } else if (!keys_.empty()) {
-            // If !keys_.empty(), then we have found at least one element of
-            // `row_keys` that is within our requested range
-            // (`dataset()->key_range_`). Because `row_keys` is sorted, if we
-            // have found an element that's not within our key range, then we
-            // are after our requested range (ranges are contiguous) and can end
-            // iteration early.
-            break;
-          }
-        }
-
-        // Handle the case where we skip over the selected range entirely.
-        if (keys_.empty()) {
-          keys_.push_back(dataset()->key_range_.begin_key());
-        }
-
-        // Last key: check to see if we need to add the end_key.
-        if (keys_.back() != dataset()->key_range_.end_key()) {
-          keys_.push_back(dataset()->key_range_.end_key());
+          sample_keys.emplace_back(row_keys[i].row_key);
         }
+        keys_ = SplitKeyRange(dataset()->key_range_, sample_keys);
         return Status::OK();
       }
 
@@ -148,53 +148,16 @@ class BigtableScanDatasetOp : public DatasetOpKernel {
         }
       }
       ::google::cloud::bigtable::Filter MakeFilter() override {
-        // TODO(saeta): Investigate optimal ordering here.
-        return ::google::cloud::bigtable::Filter::Chain(
-            ::google::cloud::bigtable::Filter::Latest(1),
-            ::google::cloud::bigtable::Filter::FamilyRegex(
-                dataset()->column_family_regex_),
-            ::google::cloud::bigtable::Filter::ColumnRegex(
-                dataset()->column_regex_),
-            dataset()->probability_ != 1.0
-                ? ::google::cloud::bigtable::Filter::RowSample(
-                      dataset()->probability_)
-                : ::google::cloud::bigtable::Filter::PassAllFilter());
+        return MakeScanFilter(dataset()->column_family_regex_,
+                              dataset()->column_regex_,
+                              dataset()->probability_);
       }
       Status ParseRow(IteratorContext* ctx,
                       const ::google::cloud::bigtable::Row& row,
                       std::vector<Tensor>* out_tensors) override {
-        out_tensors->reserve(dataset()->columns_.size() + 1);
-        Tensor row_key_tensor(ctx->allocator({}), DT_STRING, {});
-        row_key_tensor.scalar<string>()() = string(row.row_key());
-        out_tensors->emplace_back(std::move(row_key_tensor));
-
-        if (row.cells().size() > 2 * dataset()->columns_.size()) {
-          LOG(WARNING) << "An excessive number of columns ("
-                       << row.cells().size()
-                       << ") were retrieved when reading row: "
-                       << row.row_key();
-        }
-
-        for (uint64 i = 0; i < dataset()->columns_.size(); ++i) {
-          Tensor col_tensor(ctx->allocator({}), DT_STRING, {});
-          bool found_column = false;
-          for (auto cell_itr = row.cells().begin();
-               !found_column && cell_itr != row.cells().end(); ++cell_itr) {
-            if (cell_itr->family_name() == dataset()->column_families_[i] &&
-                string(cell_itr->column_qualifier()) ==
-                    dataset()->columns_[i]) {
-              col_tensor.scalar<string>()() = string(cell_itr->value());
-              found_column = true;
-            }
-          }
-          if (!found_column) {
-            return errors::InvalidArgument(
-                "Column ", dataset()->column_families_[i], ":",
-                dataset()->columns_[i], " not found in row: ", row.row_key());
-          }
-          out_tensors->emplace_back(std::move(col_tensor));
-        }
-        return Status::OK();
+        return ParseScanRow(ctx->allocator({}), row,
+                            dataset()->column_families_, dataset()->columns_,
+                            out_tensors);
       }
     };
 
@@ -104,4 +104,21 @@ REGISTER_OP("BigtableScanDataset")
                       // stateful to inhibit constant folding.
     .SetShapeFn(shape_inference::ScalarShape);
 
+// Scans the sub-ranges between the sample row keys of the table with up to
+// `num_parallel_scans` concurrent reads, buffering at most `buffer_size` rows.
+REGISTER_OP("BigtableParallelScanDataset")
+    .Input("table: resource")
+    .Input("prefix: string")
+    .Input("start_key: string")
+    .Input("end_key: string")
+    .Input("column_families: string")
+    .Input("columns: string")
+    .Input("probability: float")
+    .Input("num_parallel_scans: int64")
+    .Input("buffer_size: int64")
+    .Output("handle: variant")
+    .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
+                      // stateful to inhibit constant folding.
+    .SetShapeFn(shape_inference::ScalarShape);
+
 }  // namespace tensorflow
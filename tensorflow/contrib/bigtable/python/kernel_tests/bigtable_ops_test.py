@@ -267,6 +267,23 @@ class BigtableOpsTest(test.TestCase):
           _ListOfTuplesOfStringsToBytes(expected_values),
           _ListOfTuplesOfStringsToBytes(actual_values))
 
+  def testParallelScanSingleScan(self):
+    ds = self._table.parallel_scan_prefix(
+        prefix="r", num_parallel_scans=1, cf1="c1")
+    itr = ds.make_initializable_iterator()
+    n = itr.get_next()
+    with self.test_session() as sess:
+      self._writeCommonValues(sess)
+      sess.run(itr.initializer)
+      expected_values = list(zip(self.COMMON_ROW_KEYS, self.COMMON_VALUES))
+      # A single scan walks the sub-ranges one after another, in random order.
+      actual_values = [sess.run(n) for _ in range(len(expected_values))]
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(n)
+      self.assertItemsEqual(
+          _ListOfTuplesOfStringsToBytes(expected_values),
+          _ListOfTuplesOfStringsToBytes(actual_values))
+
 
 if __name__ == "__main__":
   test.main()
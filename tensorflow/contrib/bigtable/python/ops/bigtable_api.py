@@ -31,7 +31,6 @@ from six import iteritems
 from six import string_types
 
 from tensorflow.contrib.bigtable.ops import gen_bigtable_ops
-from tensorflow.contrib.data.python.ops import interleave_ops
 from tensorflow.contrib.util import loader
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import nest
@@ -43,6 +42,9 @@ from tensorflow.python.platform import resource_loader
 _bigtable_so = loader.load_op_library(
     resource_loader.get_path_to_datafile("_bigtable.so"))
 
+# The number of rows buffered per concurrent scan of a parallel scan.
+_PARALLEL_SCAN_ROWS_PER_SCAN = 64
+
 
 class BigtableClient(object):
   """BigtableClient is the entrypoint for interacting with Cloud Bigtable in TF.
@@ -376,9 +378,8 @@ class BigtableTable(object):
     """
     probability = _normalize_probability(probability)
     normalized = _normalize_columns(columns, kwargs)
-    ds = _BigtableSampleKeyPairsDataset(self, prefix, "", "")
-    return self._make_parallel_scan_dataset(ds, num_parallel_scans, probability,
-                                            normalized)
+    return self._make_parallel_scan_dataset(prefix, "", "", num_parallel_scans,
+                                            probability, normalized)
 
   def parallel_scan_range(self,
                           start,
@@ -438,9 +439,8 @@ class BigtableTable(object):
     """
     probability = _normalize_probability(probability)
     normalized = _normalize_columns(columns, kwargs)
-    ds = _BigtableSampleKeyPairsDataset(self, "", start, end)
-    return self._make_parallel_scan_dataset(ds, num_parallel_scans, probability,
-                                            normalized)
+    return self._make_parallel_scan_dataset("", start, end, num_parallel_scans,
+                                            probability, normalized)
 
   def write(self, dataset, column_families, columns, timestamp=None):
     """Writes a dataset to the table.
@@ -487,12 +487,17 @@ class BigtableTable(object):
         columns,
         timestamp)
 
-  def _make_parallel_scan_dataset(self, ds, num_parallel_scans,
+  def _make_parallel_scan_dataset(self, prefix, start, end, num_parallel_scans,
                                   normalized_probability, normalized_columns):
     """Builds a parallel dataset from a given range.
 
+    The range is split at the sample row keys of the table, which usually fall
+    on tablet boundaries, and the sub-ranges are scanned concurrently.
+
     Args:
-      ds: A `_BigtableSampleKeyPairsDataset` returning ranges of keys to use.
+      prefix: The prefix of the rows to scan, or "" to scan a key range.
+      start: The start of the range when scanning by range.
+      end: The end of the range when scanning by range.
       num_parallel_scans: The number of concurrent parallel scans to use.
       normalized_probability: A number between 0 and 1 for the keep probability.
       normalized_columns: The column families and column qualifiers to retrieve.
@@ -503,25 +508,15 @@ class BigtableTable(object):
     if num_parallel_scans is None:
       num_parallel_scans = 50
 
-    ds = ds.shuffle(buffer_size=10000)  # TODO(saeta): Make configurable.
-
-    def _interleave_fn(start, end):
-      return _BigtableScanDataset(
-          self,
-          prefix="",
-          start=start,
-          end=end,
-          normalized=normalized_columns,
-          probability=normalized_probability)
-
-    # Note prefetch_input_elements must be set in order to avoid rpc timeouts.
-    ds = ds.apply(
-        interleave_ops.parallel_interleave(
-            _interleave_fn,
-            cycle_length=num_parallel_scans,
-            sloppy=True,
-            prefetch_input_elements=1))
-    return ds
+    return _BigtableParallelScanDataset(
+        self,
+        prefix=prefix,
+        start=start,
+        end=end,
+        normalized=normalized_columns,
+        probability=normalized_probability,
+        num_parallel_scans=num_parallel_scans,
+        buffer_size=_PARALLEL_SCAN_ROWS_PER_SCAN * num_parallel_scans)
 
 
 def _normalize_probability(probability):
@@ -711,6 +706,30 @@ class _BigtableScanDataset(dataset_ops.Dataset):
         probability=self._probability)
 
 
+class _BigtableParallelScanDataset(_BigtableScanDataset):
+  """_BigtableParallelScanDataset scans sub-ranges of a table concurrently.
+  """
+
+  def __init__(self, table, prefix, start, end, normalized, probability,
+               num_parallel_scans, buffer_size):
+    super(_BigtableParallelScanDataset, self).__init__(
+        table, prefix, start, end, normalized, probability)
+    self._num_parallel_scans = num_parallel_scans
+    self._buffer_size = buffer_size
+
+  def _as_variant_tensor(self):
+    return gen_bigtable_ops.bigtable_parallel_scan_dataset(
+        table=self._table._resource,  # pylint: disable=protected-access
+        prefix=self._prefix,
+        start_key=self._start,
+        end_key=self._end,
+        column_families=self._column_families,
+        columns=self._columns,
+        probability=self._probability,
+        num_parallel_scans=self._num_parallel_scans,
+        buffer_size=self._buffer_size)
+
+
 class _BigtableSampleKeyPairsDataset(dataset_ops.Dataset):
   """_BigtableKeyRangeDataset returns key pairs from the Bigtable.
   """
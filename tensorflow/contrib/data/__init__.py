@@ -25,6 +25,7 @@ See @{$guide/datasets$Importing Data} for an overview.
 @@Counter
 @@CheckpointInputPipelineHook
 @@CsvDataset
+@@IndexedTFRecordDataset
 @@RandomDataset
 @@Reducer
 @@SqlDataset
@@ -49,6 +50,7 @@ See @{$guide/datasets$Importing Data} for an overview.
 @@map_and_batch
 @@padded_batch_and_drop_remainder
 @@parallel_interleave
+@@partitioned_shuffle
 @@prefetch_to_device
 @@read_batch_features
 @@rejection_resample
@@ -93,12 +95,14 @@ from tensorflow.contrib.data.python.ops.prefetching_ops import copy_to_device
 from tensorflow.contrib.data.python.ops.prefetching_ops import prefetch_to_device
 from tensorflow.contrib.data.python.ops.random_ops import RandomDataset
 from tensorflow.contrib.data.python.ops.readers import CsvDataset
+from tensorflow.contrib.data.python.ops.readers import IndexedTFRecordDataset
 from tensorflow.contrib.data.python.ops.readers import make_batched_features_dataset
 from tensorflow.contrib.data.python.ops.readers import make_csv_dataset
 from tensorflow.contrib.data.python.ops.readers import read_batch_features
 from tensorflow.contrib.data.python.ops.readers import SqlDataset
 from tensorflow.contrib.data.python.ops.resampling import rejection_resample
 from tensorflow.contrib.data.python.ops.scan_ops import scan
+from tensorflow.contrib.data.python.ops.shuffle_ops import partitioned_shuffle
 from tensorflow.contrib.data.python.ops.shuffle_ops import shuffle_and_repeat
 from tensorflow.contrib.data.python.ops.sliding import sliding_window_batch
 from tensorflow.contrib.data.python.ops.unique import unique
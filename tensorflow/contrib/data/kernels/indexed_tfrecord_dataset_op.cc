@@ -0,0 +1,274 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+
+namespace tensorflow {
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class IndexedTFRecordDatasetOp : public DatasetOpKernel {
+ public:
+  using DatasetOpKernel::DatasetOpKernel;
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    int64 buffer_size = -1;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size >= 0,
+                errors::InvalidArgument(
+                    "`buffer_size` must be >= 0 (0 == no buffering)"));
+
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards > 0,
+                errors::InvalidArgument("`num_shards` must be > 0"));
+
+    int64 shard_index;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "shard_index", &shard_index));
+    OP_REQUIRES(ctx, shard_index >= 0 && shard_index < num_shards,
+                errors::InvalidArgument("`shard_index` must be in [0, ",
+                                        num_shards, ")"));
+
+    *output = new Dataset(ctx, std::move(filenames), buffer_size, num_shards,
+                          shard_index);
+  }
+
+ private:
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            int64 buffer_size, int64 num_shards, int64 shard_index)
+        : GraphDatasetBase(ctx),
+          filenames_(std::move(filenames)),
+          num_shards_(num_shards),
+          shard_index_(shard_index) {
+      if (buffer_size > 0) {
+        options_.buffer_size = buffer_size;
+      }
+    }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::IndexedTFRecord")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{}});
+      return *shapes;
+    }
+
+    string DebugString() const override {
+      return "IndexedTFRecordDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* buffer_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+      Node* num_shards = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_shards_, &num_shards));
+      Node* shard_index = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(shard_index_, &shard_index));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {filenames, buffer_size, num_shards, shard_index}, output));
+      return Status::OK();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (!indices_loaded_) {
+          TF_RETURN_IF_ERROR(LoadIndicesLocked(ctx->env()));
+        }
+        if (next_record_ >= end_record_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (!reader_) {
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        }
+        Tensor record_tensor(ctx->allocator({}), DT_STRING, {});
+        Status s = reader_->ReadRecord(&record_tensor.scalar<string>()());
+        if (errors::IsOutOfRange(s)) {
+          return errors::DataLoss(
+              dataset()->filenames_[current_file_index_],
+              " has fewer records than its index");
+        }
+        TF_RETURN_IF_ERROR(s);
+        ++next_record_;
+        if (next_record_ == first_records_[current_file_index_ + 1]) {
+          ResetStreamsLocked();
+        }
+        out_tensors->emplace_back(std::move(record_tensor));
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (indices_loaded_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("next_record"), next_record_));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        ResetStreamsLocked();
+        if (reader->Contains(full_name("next_record"))) {
+          TF_RETURN_IF_ERROR(LoadIndicesLocked(ctx->env()));
+          int64 next_record;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("next_record"), &next_record));
+          if (next_record < next_record_ || next_record > end_record_) {
+            return errors::InvalidArgument(
+                "Record ", next_record, " is not in the shard [",
+                next_record_, ", ", end_record_, ")");
+          }
+          next_record_ = next_record;
+        }
+        return Status::OK();
+      }
+
+     private:
+      // Reads the index of every file, and finds the records of the shard.
+      Status LoadIndicesLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const std::vector<string>& filenames = dataset()->filenames_;
+        indices_.resize(filenames.size());
+        first_records_.assign(1, 0);
+        for (size_t i = 0; i < filenames.size(); ++i) {
+          Status s = io::RecordIndex::Read(env, filenames[i], &indices_[i]);
+          if (errors::IsNotFound(s)) {
+            LOG(WARNING) << filenames[i] << " has no index. Reading it to "
+                         << "build one.";
+            std::unique_ptr<RandomAccessFile> file;
+            TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filenames[i], &file));
+            s = io::RecordIndex::Build(file.get(), &indices_[i]);
+          }
+          TF_RETURN_IF_ERROR(s);
+          first_records_.push_back(first_records_.back() +
+                                   indices_[i].num_records());
+        }
+        const int64 num_records = first_records_.back();
+        next_record_ = num_records * dataset()->shard_index_ /
+                       dataset()->num_shards_;
+        end_record_ = num_records * (dataset()->shard_index_ + 1) /
+                      dataset()->num_shards_;
+        // Only the indices of the files in the shard are needed.
+        for (size_t i = 0; i < filenames.size(); ++i) {
+          if (first_records_[i + 1] <= next_record_ ||
+              first_records_[i] >= end_record_) {
+            indices_[i] = io::RecordIndex();
+          }
+        }
+        indices_loaded_ = true;
+        return Status::OK();
+      }
+
+      // Sets up reader streams at `next_record_`.
+      Status SetupStreamsLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        // The file of `next_record_` is the last one that starts at or before
+        // it, which skips empty files.
+        current_file_index_ =
+            std::upper_bound(first_records_.begin(), first_records_.end(),
+                             next_record_) -
+            first_records_.begin() - 1;
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            dataset()->filenames_[current_file_index_], &file_));
+        reader_.reset(
+            new io::SequentialRecordReader(file_.get(), dataset()->options_));
+        return reader_->SeekRecord(
+            indices_[current_file_index_],
+            next_record_ - first_records_[current_file_index_]);
+      }
+
+      // Resets all reader streams.
+      void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        reader_.reset();
+        file_.reset();
+      }
+
+      mutex mu_;
+      bool indices_loaded_ GUARDED_BY(mu_) = false;
+      std::vector<io::RecordIndex> indices_ GUARDED_BY(mu_);
+      // The number of records in the files before each file, and then the
+      // total number of records.
+      std::vector<int64> first_records_ GUARDED_BY(mu_);
+      // The next record to read and the end of the shard, counted over all
+      // files.
+      int64 next_record_ GUARDED_BY(mu_) = 0;
+      int64 end_record_ GUARDED_BY(mu_) = 0;
+      size_t current_file_index_ GUARDED_BY(mu_) = 0;
+
+      // `reader_` will borrow the object that `file_` points to, so
+      // we must destroy `reader_` before `file_`.
+      std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
+      std::unique_ptr<io::SequentialRecordReader> reader_ GUARDED_BY(mu_);
+    };
+
+    const std::vector<string> filenames_;
+    const int64 num_shards_;
+    const int64 shard_index_;
+    io::RecordReaderOptions options_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("IndexedTFRecordDataset").Device(DEVICE_CPU),
+                        IndexedTFRecordDatasetOp);
+
+}  // namespace
+}  // namespace tensorflow
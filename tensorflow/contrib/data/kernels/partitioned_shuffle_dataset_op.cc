@@ -0,0 +1,357 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+
+namespace tensorflow {
+
+namespace {
+
+const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class PartitionedShuffleDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit PartitionedShuffleDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 num_partitions;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "num_partitions",
+                                                   &num_partitions));
+    OP_REQUIRES(
+        ctx, num_partitions > 0,
+        errors::InvalidArgument("num_partitions must be greater than zero."));
+
+    string directory;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<string>(ctx, "directory", &directory));
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+
+    // By TensorFlow convention, passing 0 for both seeds indicates
+    // that the shuffling should be seeded non-deterministically.
+    if (seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+
+    *output = new Dataset(ctx, input, num_partitions, directory, seed, seed2);
+  }
+
+ private:
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input,
+            int64 num_partitions, const string& directory, int64 seed,
+            int64 seed2)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          num_partitions_(num_partitions),
+          directory_(directory),
+          seed_(seed),
+          seed2_(seed2),
+          parent_generator_(seed, seed2),
+          generator_(&parent_generator_) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      // Like `ShuffleDataset` with `reshuffle_each_iteration`, every
+      // iterator produces a different permutation.
+      int64 iterator_seed;
+      int64 iterator_seed2;
+      {
+        mutex_lock l(mu_);
+        iterator_seed = generator_();
+        iterator_seed2 = generator_();
+      }
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::PartitionedShuffle")},
+                       iterator_seed, iterator_seed2));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return strings::StrCat("PartitionedShuffleDatasetOp(", num_partitions_,
+                             ", ", seed_, ", ", seed2_, ")::Dataset");
+    }
+
+   protected:
+    Status AsGraphDefInternal(OpKernelContext* ctx, DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddParentDataset(ctx, input_, &input_graph_node));
+      Node* num_partitions = nullptr;
+      Node* directory = nullptr;
+      Node* seed = nullptr;
+      Node* seed2 = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_partitions_, &num_partitions));
+      TF_RETURN_IF_ERROR(b->AddScalar(directory_, &directory));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
+      TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {input_graph_node, num_partitions, directory, seed, seed2},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // Shuffles in two passes, so that only a partition of the input needs to
+    // be in memory at once.
+    //
+    // The first pass appends every element of the input to a partition
+    // chosen uniformly at random, each of which is a file of records. The
+    // second pass visits the partitions in a random order, reads each one
+    // into memory and produces its elements in a random order. Since the
+    // partition of each element is chosen independently, every permutation
+    // of the input is equally likely, as with a shuffle buffer that holds
+    // the whole input.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      Iterator(const Params& params, int64 seed, int64 seed2)
+          : DatasetIterator<Dataset>(params),
+            parent_generator_(seed, seed2),
+            generator_(&parent_generator_) {}
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        // Delete the partitions that have not been read yet.
+        writers_.clear();
+        files_.clear();
+        if (order_.empty()) {
+          for (const string& filename : filenames_) {
+            env_->DeleteFile(filename).IgnoreError();
+          }
+        }
+        for (size_t i = next_partition_; i < order_.size(); ++i) {
+          env_->DeleteFile(filenames_[order_[i]]).IgnoreError();
+        }
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (input_impl_) {
+          TF_RETURN_IF_ERROR(WritePartitions(ctx));
+        }
+        while (next_element_ == buffer_.size()) {
+          if (next_partition_ == order_.size()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          TF_RETURN_IF_ERROR(ReadPartition(ctx, order_[next_partition_]));
+          next_partition_++;
+        }
+        *out_tensors = std::move(buffer_[next_element_]);
+        next_element_++;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        return errors::Unimplemented(
+            "PartitionedShuffleDataset does not support checkpointing, "
+            "because its state is in temporary files.");
+      }
+
+     private:
+      // The first pass.
+      Status WritePartitions(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = ctx->env();
+        env_ = env;
+        string prefix;
+        if (dataset()->directory_.empty()) {
+          if (!env->LocalTempFilename(&prefix)) {
+            return errors::Internal(
+                "Failed to create a temporary file name for the partitions "
+                "of the shuffle.");
+          }
+        } else {
+          TF_RETURN_IF_ERROR(
+              env->RecursivelyCreateDir(dataset()->directory_));
+          prefix = io::JoinPath(
+              dataset()->directory_,
+              strings::StrCat("shuffle-", strings::Hex(random::New64())));
+        }
+        for (int64 i = 0; i < dataset()->num_partitions_; ++i) {
+          filenames_.push_back(strings::StrCat(prefix, ".partition-", i));
+          std::unique_ptr<WritableFile> file;
+          TF_RETURN_IF_ERROR(env->NewWritableFile(filenames_.back(), &file));
+          writers_.emplace_back(new io::RecordWriter(file.get()));
+          files_.push_back(std::move(file));
+        }
+
+        const int64 start_micros = env->NowMicros();
+        int64 num_log_entries = 0;
+        int64 num_elements = 0;
+        while (true) {
+          std::vector<Tensor> element;
+          bool end_of_input_sequence;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_input_sequence));
+          if (end_of_input_sequence) break;
+          io::RecordWriter* writer =
+              writers_[Random() % dataset()->num_partitions_].get();
+          for (const Tensor& t : element) {
+            TensorProto proto;
+            t.AsProtoTensorContent(&proto);
+            TF_RETURN_IF_ERROR(writer->WriteRecord(proto.SerializeAsString()));
+          }
+          num_elements++;
+          if (env->NowMicros() >
+              ((num_log_entries + 1) * kLogIntervalMicros) + start_micros) {
+            num_log_entries++;
+            LOG(INFO) << "Partitioning the input of the shuffle (this may "
+                      << "take a while): " << num_elements << " elements";
+          }
+        }
+        input_impl_.reset();
+        for (size_t i = 0; i < writers_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writers_[i]->Close());
+          TF_RETURN_IF_ERROR(files_[i]->Close());
+        }
+        writers_.clear();
+        files_.clear();
+
+        order_.resize(dataset()->num_partitions_);
+        for (int64 i = 0; i < order_.size(); ++i) {
+          order_[i] = i;
+        }
+        Shuffle(&order_);
+        return Status::OK();
+      }
+
+      // Reads the `index`-th partition into `buffer_` in a random order, and
+      // deletes it.
+      Status ReadPartition(IteratorContext* ctx, int64 index)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const string& filename = filenames_[index];
+        buffer_.clear();
+        next_element_ = 0;
+        {
+          std::unique_ptr<RandomAccessFile> file;
+          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(filename, &file));
+          io::SequentialRecordReader reader(file.get());
+          const size_t num_components = dataset()->output_dtypes().size();
+          string record;
+          while (true) {
+            Status s = reader.ReadRecord(&record);
+            if (errors::IsOutOfRange(s)) break;
+            TF_RETURN_IF_ERROR(s);
+            std::vector<Tensor> element(num_components);
+            for (size_t i = 0; i < num_components; ++i) {
+              if (i > 0) {
+                TF_RETURN_IF_ERROR(reader.ReadRecord(&record));
+              }
+              TensorProto proto;
+              if (!proto.ParseFromString(record) ||
+                  !element[i].FromProto(proto)) {
+                return errors::DataLoss("Corrupt shuffle partition: ",
+                                        filename);
+              }
+            }
+            buffer_.push_back(std::move(element));
+          }
+        }
+        TF_RETURN_IF_ERROR(ctx->env()->DeleteFile(filename));
+        Shuffle(&buffer_);
+        return Status::OK();
+      }
+
+      template <typename T>
+      void Shuffle(std::vector<T>* v) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (size_t i = v->size(); i > 1; --i) {
+          std::swap((*v)[i - 1], (*v)[Random() % i]);
+        }
+      }
+
+      random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return generator_();
+      }
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      // The environment in which the partitions were created.
+      Env* env_ GUARDED_BY(mu_) = nullptr;
+      random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator_
+          GUARDED_BY(mu_);
+      // The files of the partitions, indexed by partition.
+      std::vector<string> filenames_ GUARDED_BY(mu_);
+      // Only set during the first pass.
+      std::vector<std::unique_ptr<WritableFile>> files_ GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<io::RecordWriter>> writers_
+          GUARDED_BY(mu_);
+      // The order in which the partitions are read, and the position of the
+      // next partition to read in it.
+      std::vector<int64> order_ GUARDED_BY(mu_);
+      size_t next_partition_ GUARDED_BY(mu_) = 0;
+      // The elements of the partition that is being produced.
+      std::vector<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+      size_t next_element_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const int64 num_partitions_;
+    const string directory_;
+    const int64 seed_;
+    const int64 seed2_;
+    mutable mutex mu_;
+    mutable random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+    mutable random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        GUARDED_BY(mu_);
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("PartitionedShuffleDataset").Device(DEVICE_CPU),
+                        PartitionedShuffleDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -70,6 +70,42 @@ REGISTER_OP("CSVDataset")
       return shape_inference::ScalarShape(c);
     });
 
+REGISTER_OP("IndexedTFRecordDataset")
+    .Input("filenames: string")
+    .Input("buffer_size: int64")
+    .Input("num_shards: int64")
+    .Input("shard_index: int64")
+    .Output("handle: variant")
+    .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
+                      // stateful to inhibit constant folding.
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // `filenames` must be a scalar or a vector.
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(0), 1, &unused));
+      // `buffer_size`, `num_shards` and `shard_index` must be scalars.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    })
+    .Doc(R"doc(
+Creates a dataset that emits the records of one shard of uncompressed
+TFRecord files.
+
+The records of all the files, in order, are split into `num_shards` ranges of
+(nearly) equal size, and the dataset emits the records of range `shard_index`.
+The records are located with the index of each file, which is read from the
+file name followed by ".index", so that only the records of the shard are
+read. The index of a file without one is built by reading the file.
+
+filenames: A scalar or vector containing the name(s) of the file(s) to be
+  read.
+buffer_size: A scalar representing the number of bytes to buffer. 0 means no
+  buffering.
+num_shards: The number of shards into which the records are split.
+shard_index: The shard to read, in `[0, num_shards)`.
+)doc");
+
 REGISTER_OP("IgnoreErrorsDataset")
     .Input("input_dataset: variant")
     .Output("handle: variant")
@@ -90,6 +126,43 @@ REGISTER_OP("UniqueDataset")
 Creates a dataset that contains the unique elements of `input_dataset`.
 )doc");
 
+REGISTER_OP("PartitionedShuffleDataset")
+    .Input("input_dataset: variant")
+    .Input("num_partitions: int64")
+    .Input("directory: string")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Output("handle: variant")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // `num_partitions`, `directory`, `seed` and `seed2` must be scalars.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    })
+    .Doc(R"doc(
+Creates a dataset that shuffles the elements of `input_dataset` uniformly,
+without holding all of them in memory.
+
+The elements are first written to `num_partitions` files, choosing a file
+uniformly at random for each element, and the files are then read back in a
+random order, each one shuffled in memory. Only the elements of one partition
+are in memory at once, and the first element is produced after the whole
+input has been read.
+
+num_partitions: The number of files into which the input is partitioned.
+directory: The directory of the files. If empty, a local temporary directory
+  is used.
+seed: A scalar seed for the random number generator. If either `seed` or
+  `seed2` is set to be non-zero, the random number generator is seeded
+  by the given seed.  Otherwise, a random seed is used.
+seed2: A second scalar seed to avoid seed collision.
+)doc");
+
 REGISTER_OP("IteratorGetDevice")
     .Input("resource: resource")
     .Output("device: string")
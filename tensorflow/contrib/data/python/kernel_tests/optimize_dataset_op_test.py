@@ -101,6 +101,21 @@ class OptimizeDatasetTest(test.TestCase, parameterized.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  def testMapVectorization(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        optimization.assert_next(
+            ["Batch", "Map"])).map(lambda x: x * x + 1).batch(4).apply(
+                optimization.optimize(["map_vectorization"]))
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for i in range(0, 10, 4):
+        self.assertAllEqual([x * x + 1 for x in range(i, min(i + 4, 10))],
+                            sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   def testFunctionLibraryDefinitionModification(self):
     dataset = dataset_ops.Dataset.from_tensors(0).map(lambda x: x).apply(
         optimization.optimize(["_test_only_function_rename"]))
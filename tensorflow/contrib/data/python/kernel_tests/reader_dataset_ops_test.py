@@ -1002,5 +1002,52 @@ class MakeTFRecordDatasetTest(
           self._shuffle_test(batch_size, num_epochs, num_parallel_reads,
                              seed=21345)
 
+
+class IndexedTFRecordDatasetTest(
+    reader_dataset_ops_test_base.TFRecordDatasetTestBase):
+
+  def _read_shard(self, filenames, num_shards, shard_index):
+    dataset = readers.IndexedTFRecordDataset(
+        filenames, num_shards=num_shards, shard_index=shard_index)
+    get_next = dataset.make_one_shot_iterator().get_next()
+    records = []
+    with self.test_session() as sess:
+      while True:
+        try:
+          records.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          return records
+
+  def testShardsPartitionRecords(self):
+    # An empty file in the middle is skipped.
+    empty_filename = os.path.join(self.get_temp_dir(), "empty.tfrecord")
+    open(empty_filename, "wb").close()
+    filenames = [self.test_filenames[0], empty_filename,
+                 self.test_filenames[1]]
+    expected = [
+        self._record(f, r)
+        for f in range(self._num_files)
+        for r in range(self._num_records)
+    ]
+    for num_shards in [1, 2, 3, 5, 14, 20]:
+      shards = [
+          self._read_shard(filenames, num_shards, shard_index)
+          for shard_index in range(num_shards)
+      ]
+      self.assertEqual(expected, [r for shard in shards for r in shard])
+      sizes = [len(shard) for shard in shards]
+      self.assertLessEqual(max(sizes) - min(sizes), 1)
+
+  def testCorruptIndex(self):
+    with open(self.test_filenames[0] + ".index", "wb") as f:
+      f.write(b"not an index")
+    with self.assertRaises(errors.DataLossError):
+      self._read_shard(self.test_filenames, 1, 0)
+
+  def testInvalidShardIndex(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      self._read_shard(self.test_filenames, 2, 2)
+
+
 if __name__ == "__main__":
   test.main()
@@ -21,7 +21,6 @@ import os
 
 from tensorflow.contrib.data.python.kernel_tests.serialization import dataset_serialization_test_base
 from tensorflow.python.data.ops import dataset_ops
-from tensorflow.python.framework import errors
 from tensorflow.python.platform import test
 
 
@@ -67,14 +66,14 @@ class CacheDatasetSerializationTest(
         save_checkpoint_at_end=False)
     self.assertSequenceEqual(outputs, range(8))
 
-    # Restoring from checkpoint and running GetNext should return a
-    # `AlreadExistsError` now because the lockfile already exists.
-    with self.assertRaises(errors.AlreadyExistsError):
-      self.gen_outputs(
-          self.ds_fn, [],
-          self.num_outputs - 5,
-          ckpt_saved=True,
-          verify_exhausted=False)
+    # Restoring from checkpoint produces the elements after the checkpoint
+    # again, reading the ones that were cached after it from the cache.
+    outputs = list(range(5)) + self.gen_outputs(
+        self.ds_fn, [],
+        self.num_outputs - 5,
+        ckpt_saved=True,
+        verify_exhausted=False)
+    self.assertSequenceEqual(outputs, self.expected_outputs())
 
   def testCheckpointAfterOneEpoch(self):
     # Generate 15 entries from iterator and save checkpoint.
@@ -162,17 +161,16 @@ class CacheDatasetSerializationTest(
             verify_exhausted=False))
     self.assertSequenceEqual(outputs, list(range(10)) * 3)
 
-  def testUnusedCheckpointError(self):
+  def testIgnoreCheckpointIfCachePartiallyWritten(self):
     # Produce 5 elements and save ckpt.
     outputs = self.gen_outputs(self.ds_fn, [], 5, verify_exhausted=False)
     self.assertSequenceEqual(outputs, range(5))
 
-    # Since the complete cache has not been written, a new iterator which does
-    # not restore the checkpoint will throw an error since there is a partial
-    # cache shard.
-    with self.assertRaises(errors.AlreadyExistsError):
-      outputs = self.gen_outputs(
-          self.ds_fn, [], self.num_outputs, verify_exhausted=False)
+    # Build the iterator again but do not restore from ckpt. The elements in
+    # the partial cache are read from it, and the rest are cached.
+    outputs = self.gen_outputs(
+        self.ds_fn, [], self.num_outputs, verify_exhausted=False)
+    self.assertSequenceEqual(outputs, self.expected_outputs())
 
   def testIgnoreCheckpointIfCacheWritten(self):
     # Produce 15 elements and save ckpt. This will write the complete cache.
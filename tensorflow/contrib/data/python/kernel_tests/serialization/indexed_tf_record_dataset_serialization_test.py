@@ -0,0 +1,43 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the IndexedTFRecordDataset serialization."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.data.python.kernel_tests import reader_dataset_ops_test_base
+from tensorflow.contrib.data.python.kernel_tests.serialization import dataset_serialization_test_base
+from tensorflow.contrib.data.python.ops import readers
+from tensorflow.python.platform import test
+
+
+class IndexedTFRecordDatasetSerializationTest(
+    reader_dataset_ops_test_base.TFRecordDatasetTestBase,
+    dataset_serialization_test_base.DatasetSerializationTestBase):
+
+  def _build_iterator_graph(self, num_shards, shard_index):
+    return readers.IndexedTFRecordDataset(
+        self.test_filenames, num_shards=num_shards, shard_index=shard_index)
+
+  def testSerializationCore(self):
+    # The second of three shards spans both files.
+    num_records = self._num_files * self._num_records
+    num_outputs = num_records * 2 // 3 - num_records // 3
+    self.run_core_tests(lambda: self._build_iterator_graph(3, 1),
+                        lambda: self._build_iterator_graph(3, 2), num_outputs)
+
+
+if __name__ == "__main__":
+  test.main()
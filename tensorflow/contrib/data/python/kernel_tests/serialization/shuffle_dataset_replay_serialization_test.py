@@ -0,0 +1,37 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the ShuffleDataset serialization that replays the input."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+# Must be set before the first shuffle iterator is saved.
+os.environ["TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY"] = "true"
+
+# pylint: disable=g-import-not-at-top
+from tensorflow.contrib.data.python.kernel_tests.serialization import shuffle_dataset_serialization_test
+from tensorflow.python.platform import test
+# pylint: enable=g-import-not-at-top
+
+
+class ShuffleDatasetReplaySerializationTest(
+    shuffle_dataset_serialization_test.ShuffleDatasetSerializationTest):
+  """Runs the ShuffleDataset serialization tests with checkpoints by replay."""
+
+
+if __name__ == "__main__":
+  test.main()
@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import shuffle_ops
@@ -110,5 +112,57 @@ class ShuffleAndRepeatTest(test.TestCase):
         sess.run(get_next_op)
 
 
+class PartitionedShuffleTest(test.TestCase):
+
+  def _build_ds(self, seed, num_partitions=4, num_elements=100, count=1):
+    return dataset_ops.Dataset.range(num_elements).apply(
+        shuffle_ops.partitioned_shuffle(
+            num_partitions, directory=self.get_temp_dir(),
+            seed=seed)).repeat(count)
+
+  def _gen_outputs(self, ds_fn, num_outputs):
+    get_next = ds_fn().make_one_shot_iterator().get_next()
+    outputs = []
+    with self.test_session() as sess:
+      for _ in range(num_outputs):
+        outputs.append(sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+    return outputs
+
+  def testCorrectOutput(self):
+    output = self._gen_outputs(lambda: self._build_ds(10), 100)
+    self.assertNotEqual(output, list(range(100)))
+    self.assertSequenceEqual(sorted(output), range(100))
+
+  def testReshuffling(self):
+    output = self._gen_outputs(lambda: self._build_ds(10, count=2), 200)
+    self.assertNotEqual(output[:100], output[100:])
+    self.assertSequenceEqual(sorted(output[:100]), range(100))
+    self.assertSequenceEqual(sorted(output[100:]), range(100))
+
+  def testSameOrderForSameSeeds(self):
+    output1 = self._gen_outputs(lambda: self._build_ds(10), 100)
+    output2 = self._gen_outputs(lambda: self._build_ds(10), 100)
+    self.assertEqual(output1, output2)
+
+  def testDifferentOrderForDifferentSeeds(self):
+    output1 = self._gen_outputs(lambda: self._build_ds(10), 100)
+    output2 = self._gen_outputs(lambda: self._build_ds(20), 100)
+    self.assertNotEqual(output1, output2)
+
+  def testMorePartitionsThanElements(self):
+    output = self._gen_outputs(
+        lambda: self._build_ds(10, num_partitions=10, num_elements=3), 3)
+    self.assertSequenceEqual(sorted(output), range(3))
+
+  def testEmptyInput(self):
+    self._gen_outputs(lambda: self._build_ds(10, num_elements=0), 0)
+
+  def testRemovesPartitions(self):
+    self._gen_outputs(lambda: self._build_ds(10), 100)
+    self.assertEqual([], os.listdir(self.get_temp_dir()))
+
+
 if __name__ == "__main__":
   test.main()
@@ -651,6 +651,67 @@ class CsvDataset(dataset_ops.Dataset):
     return self._output_classes
 
 
+class IndexedTFRecordDataset(dataset_ops.Dataset):
+  """A `Dataset` comprising the records of one shard of TFRecord files."""
+
+  def __init__(self, filenames, num_shards=1, shard_index=0, buffer_size=None):
+    """Creates an `IndexedTFRecordDataset`.
+
+    The records of all the files, in order, are split into `num_shards`
+    contiguous ranges of (nearly) equal size, and the dataset comprises the
+    records of range `shard_index`. Unlike `tf.data.TFRecordDataset(...)
+    .shard(num_shards, shard_index)`, each worker reads only its own records.
+    They are located with the index that is stored next to each file, in the
+    file name followed by `".index"`, and that is written by
+    `tensorflow::io::RecordIndex`. The index of a file without one is built
+    by reading the whole file.
+
+    For example, each of 1000 workers can read its part of the records with:
+
+    ```python
+    dataset = tf.contrib.data.IndexedTFRecordDataset(
+        filenames, num_shards=1000, shard_index=worker_index)
+    ```
+
+    The files must be uncompressed.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      num_shards: (Optional.) A `tf.int64` scalar, the number of shards into
+        which the records are split. Defaults to 1.
+      shard_index: (Optional.) A `tf.int64` scalar, the shard to read, in
+        `[0, num_shards)`. Defaults to 0.
+      buffer_size: (Optional.) A `tf.int64` scalar denoting the number of bytes
+        to buffer while reading files. Defaults to 4MB.
+    """
+    super(IndexedTFRecordDataset, self).__init__()
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._num_shards = ops.convert_to_tensor(
+        num_shards, dtype=dtypes.int64, name="num_shards")
+    self._shard_index = ops.convert_to_tensor(
+        shard_index, dtype=dtypes.int64, name="shard_index")
+    self._buffer_size = convert.optional_param_to_tensor(
+        "buffer_size", buffer_size, _DEFAULT_READER_BUFFER_SIZE_BYTES)
+
+  def _as_variant_tensor(self):
+    return contrib_gen_dataset_ops.indexed_tf_record_dataset(
+        self._filenames, self._buffer_size, self._num_shards,
+        self._shard_index)
+
+  @property
+  def output_classes(self):
+    return ops.Tensor
+
+  @property
+  def output_shapes(self):
+    return tensor_shape.TensorShape([])
+
+  @property
+  def output_types(self):
+    return dtypes.string
+
+
 def make_batched_features_dataset(file_pattern,
                                   batch_size,
                                   features,
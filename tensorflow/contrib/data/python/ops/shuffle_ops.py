@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+from tensorflow.contrib.data.python.ops import contrib_op_loader  # pylint: disable=unused-import
+from tensorflow.contrib.data.python.ops import gen_dataset_ops as contrib_gen_dataset_ops
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import random_seed
 from tensorflow.python.framework import constant_op
@@ -103,3 +105,78 @@ def shuffle_and_repeat(buffer_size, count=None, seed=None):
     return _ShuffleAndRepeatDataset(dataset, buffer_size, count, seed)
 
   return _apply_fn
+
+
+class _PartitionedShuffleDataset(dataset_ops.Dataset):
+  """A `Dataset` that shuffles its input through temporary files."""
+
+  def __init__(self, input_dataset, num_partitions, directory=None,
+               seed=None):
+    """See `partitioned_shuffle()` for details."""
+    super(_PartitionedShuffleDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._num_partitions = ops.convert_to_tensor(
+        num_partitions, dtype=dtypes.int64, name="num_partitions")
+    if directory is None:
+      directory = ""
+    self._directory = ops.convert_to_tensor(
+        directory, dtype=dtypes.string, name="directory")
+    self._seed, self._seed2 = random_seed.get_seed(seed)
+
+  def _as_variant_tensor(self):
+    return contrib_gen_dataset_ops.partitioned_shuffle_dataset(
+        self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
+        num_partitions=self._num_partitions,
+        directory=self._directory,
+        seed=self._seed,
+        seed2=self._seed2,
+        **dataset_ops.flat_structure(self))
+
+  @property
+  def output_classes(self):
+    return self._input_dataset.output_classes
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+def partitioned_shuffle(num_partitions, directory=None, seed=None):
+  """Shuffles a Dataset uniformly, without holding all of it in memory.
+
+  `dataset.apply(tf.contrib.data.partitioned_shuffle(num_partitions))`
+
+  produces the same distribution of orders as
+
+  `dataset.shuffle(buffer_size=<size of dataset>)`
+
+  but only holds about `1 / num_partitions` of the dataset in memory. Each
+  element is first written to one of `num_partitions` temporary files, chosen
+  at random, and the files are then read back in a random order and shuffled
+  in memory one at a time. The first element is therefore only produced once
+  the whole input has been read, and the input must be finite. Every iterator
+  produces a different order, and iterators cannot be checkpointed.
+
+  Args:
+    num_partitions: A `tf.int64` scalar `tf.Tensor`, representing the number
+      of temporary files into which the input is partitioned.
+    directory: (Optional.) A `tf.string` scalar `tf.Tensor`, representing the
+      directory of the temporary files. Defaults to a local temporary
+      directory.
+    seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      random seed that will be used to create the distribution. See
+      @{tf.set_random_seed} for behavior.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+
+  def _apply_fn(dataset):  # pylint: disable=missing-docstring
+    return _PartitionedShuffleDataset(dataset, num_partitions, directory, seed)
+
+  return _apply_fn
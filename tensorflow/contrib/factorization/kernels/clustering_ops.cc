@@ -56,6 +56,9 @@ const int64 kDefaultL3CachePerCpu = 1 << 20;
 // NearestNeighborsOp benchmark.
 const int64 kNearestNeighborsCentersMaxBlockSize = 1024;
 const int64 kNearestNeighborsPointsMinBlockSize = 16;
+// The relative error of the inner products that NearestNeighborsOp allows
+// for when it skips blocks of centers that are provably too far from a point.
+const float kNearestNeighborsPruningTolerance = 1e-3;
 
 // Returns the smallest multiple of a that is not smaller than b.
 int64 NextMultiple(int64 a, int64 b) {
@@ -510,8 +513,21 @@ class NearestNeighborsOp : public OpKernel {
         centers.topRows(kNearestNeighborsCentersMaxBlockSize),
         centers_half_squared_norm.head(kNearestNeighborsCentersMaxBlockSize),
         nearest_center_indices, nearest_center_distances);
+    // By the Cauchy-Schwarz inequality, the partial distance
+    // |c|^2 / 2 - <x, c> between a point x and a center c is at least
+    // |c|^2 / 2 - |x| |c|. A point skips the blocks of centers where that
+    // bound exceeds the partial distance to the k-th nearest center found so
+    // far, since they can't contain any of its k nearest centers.
+    const Eigen::VectorXf centers_norm =
+        (2.0 * centers_half_squared_norm).cwiseSqrt();
+    const Eigen::VectorXf points_norm =
+        (2.0 * points_half_squared_norm).cwiseSqrt();
     // Iteratively compute nearest neighbors with other blocks of centers, and
     // update the output matrices.
+    std::vector<int64> block_rows;
+    block_rows.reserve(num_points);
+    MatrixXfRowMajor block_points(num_points, points.cols());
+    Eigen::VectorXf block_points_half_squared_norm(num_points);
     MatrixXi64RowMajor block_nearest_center_indices(num_points, k);
     MatrixXfRowMajor block_nearest_center_distances(num_points, k);
     Eigen::Matrix<int64, 1, Eigen::Dynamic> merged_indices(k);
@@ -522,23 +538,69 @@ class NearestNeighborsOp : public OpKernel {
       const int64 centers_block_size = std::min(
           kNearestNeighborsCentersMaxBlockSize, num_centers - centers_start);
       const int64 block_k = std::min(k, centers_block_size);
+      const auto block_half_squared_norm =
+          centers_half_squared_norm.segment(centers_start, centers_block_size);
+      const auto block_norm =
+          centers_norm.segment(centers_start, centers_block_size);
+      const float max_half_squared_norm = block_half_squared_norm.maxCoeff();
+
+      block_rows.clear();
+      for (int64 i = 0; i < num_points; ++i) {
+        if (out_k == k) {
+          const float lower_bound =
+              (block_half_squared_norm - points_norm(i) * block_norm)
+                  .minCoeff();
+          const float kth_partial_distance =
+              0.5 * nearest_center_distances(i, k - 1) -
+              points_half_squared_norm(i);
+          // Allows for the rounding errors of the inner products.
+          const float tolerance =
+              kNearestNeighborsPruningTolerance *
+              (points_half_squared_norm(i) + max_half_squared_norm);
+          if (lower_bound > kth_partial_distance + tolerance) continue;
+        }
+        block_rows.push_back(i);
+      }
+      const int64 num_block_rows = block_rows.size();
+      if (num_block_rows == 0) {
+        out_k = std::min(k, out_k + block_k);
+        continue;
+      }
+      const bool all_rows = num_block_rows == num_points;
+      if (!all_rows) {
+        for (int64 m = 0; m < num_block_rows; ++m) {
+          block_points.row(m) = points.row(block_rows[m]);
+          block_points_half_squared_norm(m) =
+              points_half_squared_norm(block_rows[m]);
+        }
+      }
+      using ConstMatrixRef = Eigen::Ref<const MatrixXfRowMajor>;
+      using ConstVectorRef = Eigen::Ref<const Eigen::VectorXf>;
       FindKNearestCentersOneBlock(
-          block_k, points, points_half_squared_norm,
+          block_k,
+          all_rows ? ConstMatrixRef(points)
+                   : ConstMatrixRef(block_points.topRows(num_block_rows)),
+          all_rows ? ConstVectorRef(points_half_squared_norm)
+                   : ConstVectorRef(block_points_half_squared_norm.head(
+                         num_block_rows)),
           centers.middleRows(centers_start, centers_block_size),
-          centers_half_squared_norm.segment(centers_start, centers_block_size),
-          block_nearest_center_indices, block_nearest_center_distances);
+          block_half_squared_norm,
+          block_nearest_center_indices.topRows(num_block_rows),
+          block_nearest_center_distances.topRows(num_block_rows));
       if (k == 1) {
-        for (int i = 0; i < num_points; ++i) {
-          if (block_nearest_center_distances(i, 0) <
+        for (int64 m = 0; m < num_block_rows; ++m) {
+          const int64 i = block_rows[m];
+          if (block_nearest_center_distances(m, 0) <
               nearest_center_distances(i, 0)) {
             nearest_center_indices(i, 0) =
-                block_nearest_center_indices(i, 0) + centers_start;
+                block_nearest_center_indices(m, 0) + centers_start;
             nearest_center_distances(i, 0) =
-                block_nearest_center_distances(i, 0);
+                block_nearest_center_distances(m, 0);
           }
         }
       } else {
-        for (int i = 0; i < num_points; ++i) {
+        for (int64 m = 0; m < num_block_rows; ++m) {
+          const int64 i = block_rows[m];
           // Merge and accumulate top-k list from block_nearest_center_indices
           // into nearest_center_indices.
           for (int64 j_out = 0, j_block = 0, j_merged = 0;
@@ -548,7 +610,7 @@ class NearestNeighborsOp : public OpKernel {
                 j_out < out_k ? nearest_center_distances(i, j_out)
                               : std::numeric_limits<float>::infinity();
             const float distance_block =
-                j_block < block_k ? block_nearest_center_distances(i, j_block)
+                j_block < block_k ? block_nearest_center_distances(m, j_block)
                                   : std::numeric_limits<float>::infinity();
             if (distance_out <= distance_block) {
               merged_indices(j_merged) = nearest_center_indices(i, j_out);
@@ -556,16 +618,18 @@ class NearestNeighborsOp : public OpKernel {
               ++j_out;
             } else {
               merged_indices(j_merged) =
-                  block_nearest_center_indices(i, j_block) + centers_start;
+                  block_nearest_center_indices(m, j_block) + centers_start;
               merged_distances(j_merged) = distance_block;
               ++j_block;
             }
           }
           nearest_center_indices.row(i) = merged_indices;
           nearest_center_distances.row(i) = merged_distances;
-          out_k = std::min(k, out_k + block_k);
         }
       }
+      // The number of valid nearest centers of every point, including those
+      // that skipped the block since their k nearest centers were complete.
+      out_k = std::min(k, out_k + block_k);
     }
   }
 };
@@ -20,18 +20,13 @@
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -198,43 +193,17 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     // Batch the rank-one updates into a rank-k update to lower memory traffic
     const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
+    // Each worker batches the factors into its own factors_mat.rows() x
+    // kMaxBatchSize matrix, which it allocates the first time it runs.
+    thread::ThreadPool* const pool = worker_threads.workers;
+    std::vector<Eigen::MatrixXf> factor_batches(pool->NumThreads() + 1);
 
-    BlockingCounter counter(shards.size());
     // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      // TODO(b/72952120): Check whether the 3 lock-unlock pairs can be
-      // consolidated into just one.
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
+    auto work = [&](const Shard& shard, Eigen::MatrixXf* factor_batch_ptr) {
+      if (factor_batch_ptr->size() == 0) {
+        factor_batch_ptr->resize(factors_mat.rows(), kMaxBatchSize);
       }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
+      auto& factor_batch = *factor_batch_ptr;
 
       CHECK_GE(shard.first, 0);
       CHECK_LE(shard.second, perm.size());
@@ -279,14 +248,20 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
       // Copy lower triangular to upper triangular part of normal equation
       // matrix.
       lhs_mat = lhs_symm;
-      counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
-    }
-    // Inline execute the 1st shard.
-    work(shards[0]);
-    counter.Wait();
+    // Hands out contiguous blocks of rows rather than one closure per row, so
+    // that rows with few non-zero elements don't drown in scheduling overhead.
+    // Each non-zero element costs about a rank-one update of the lhs.
+    const int64 cost_per_shard =
+        std::max<int64>(1, num_nonzero_elements / shards.size()) * factor_dim *
+        factor_dim;
+    pool->ParallelForWithWorkerId(
+        shards.size(), cost_per_shard,
+        [&work, &shards, &factor_batches](int64 begin, int64 end, int id) {
+          for (int64 i = begin; i < end; ++i) {
+            work(shards[i], &factor_batches[id]);
+          }
+        });
   }
 };
 
@@ -17,8 +17,6 @@ limitations under the License.
 
 #include "grpc/support/alloc.h"
 #include "tensorflow/contrib/gdr/gdr_memory_manager.h"
-#include "tensorflow/contrib/gdr/gdr_rendezvous_mgr.h"
-#include "tensorflow/contrib/gdr/gdr_worker.h"
 
 #include "grpc/support/alloc.h"
 
@@ -48,16 +46,10 @@ GdrServer::GdrServer(const ServerDef& server_def, Env* env)
 GdrServer::~GdrServer() {}
 
 Status GdrServer::Init() {
-  RendezvousMgrCreationFunction rendezvous_mgr_func =
-      [this](const WorkerEnv* env) {
-        return new GdrRendezvousMgr(env, remote_memory_manager_.get());
-      };
-  WorkerCreationFunction worker_func = [this](WorkerEnv* env) {
-    return std::unique_ptr<GdrWorker>(
-        new GdrWorker(env, remote_memory_manager_.get()));
-  };
-  TF_RETURN_IF_ERROR(
-      GrpcServer::Init(nullptr, rendezvous_mgr_func, nullptr, worker_func));
+  // The gRPC rendezvous and worker service move tensors through the remote
+  // memory manager whenever it is set in the worker environment.
+  worker_env()->remote_memory_manager = remote_memory_manager_.get();
+  TF_RETURN_IF_ERROR(GrpcServer::Init());
 
   return remote_memory_manager_->Init();
 }
@@ -48,7 +48,16 @@ class KafkaDatasetOp : public DatasetOpKernel {
     OP_REQUIRES(ctx, (timeout > 0),
                 errors::InvalidArgument(
                     "Timeout value should be large than 0, got ", timeout));
-    *output = new Dataset(ctx, std::move(topics), servers, group, eof, timeout);
+    int64 batch_size = 0;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(ctx, (batch_size >= 0),
+                errors::InvalidArgument(
+                    "Batch size should not be negative, got ", batch_size));
+    bool parallel = false;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, "parallel", &parallel));
+    *output = new Dataset(ctx, std::move(topics), servers, group, eof, timeout,
+                          batch_size, parallel);
   }
 
  private:
@@ -56,13 +65,15 @@ class KafkaDatasetOp : public DatasetOpKernel {
    public:
     Dataset(OpKernelContext* ctx, std::vector<string> topics,
             const string& servers, const string& group, const bool eof,
-            const int64 timeout)
+            const int64 timeout, const int64 batch_size, const bool parallel)
         : GraphDatasetBase(ctx),
           topics_(std::move(topics)),
           servers_(servers),
           group_(group),
           eof_(eof),
-          timeout_(timeout) {}
+          timeout_(timeout),
+          batch_size_(batch_size),
+          parallel_(parallel) {}
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
         const string& prefix) const override {
@@ -78,7 +89,9 @@ class KafkaDatasetOp : public DatasetOpKernel {
     const std::vector<PartialTensorShape>& output_shapes() const override {
       static std::vector<PartialTensorShape>* shapes =
           new std::vector<PartialTensorShape>({{}});
-      return *shapes;
+      static std::vector<PartialTensorShape>* batched_shapes =
+          new std::vector<PartialTensorShape>({{-1}});
+      return batch_size_ > 0 ? *batched_shapes : *shapes;
     }
 
     string DebugString() const override { return "KafkaDatasetOp::Dataset"; }
@@ -96,8 +109,13 @@ class KafkaDatasetOp : public DatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddScalar(eof_, &eof));
       Node* timeout = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(timeout_, &timeout));
-      TF_RETURN_IF_ERROR(
-          b->AddDataset(this, {topics, servers, group, eof, timeout}, output));
+      Node* batch_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+      Node* parallel = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(parallel_, &parallel));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {topics, servers, group, eof, timeout, batch_size, parallel},
+          output));
       return Status::OK();
     }
 
@@ -111,56 +129,100 @@ class KafkaDatasetOp : public DatasetOpKernel {
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
+        const int64 batch_size = dataset()->batch_size_;
+        // The messages of a batch are copied straight into the elements of
+        // one tensor, which is only shrunk when the batch ends early.
+        Tensor batch;
+        int64 num_messages = 0;
         do {
-          // We are currently processing a topic, so try to read the next line.
+          // We are currently processing some partitions, so try to read the
+          // next messages.
           if (consumer_.get()) {
-            while (true) {
-              if (limit_ >= 0 &&
-                  (topic_partition_->offset() >= limit_ || offset_ >= limit_)) {
-                // EOF current topic
-                break;
-              }
+            while (num_active_partitions_ > 0) {
               std::unique_ptr<RdKafka::Message> message(
                   consumer_->consume(dataset()->timeout_));
               if (message->err() == RdKafka::ERR_NO_ERROR) {
-                // Produce the line as output.
-                Tensor line_tensor(cpu_allocator(), DT_STRING, {});
-                line_tensor.scalar<string>()() =
-                    std::string(static_cast<const char*>(message->payload()),
-                                message->len());
-                out_tensors->emplace_back(std::move(line_tensor));
-                *end_of_sequence = false;
-                // Sync offset
-                offset_ = message->offset();
-                return Status::OK();
+                Partition* partition = FindPartitionLocked(
+                    message->topic_name(), message->partition());
+                // Messages of finished partitions may still be in flight.
+                if (partition == nullptr || partition->done) continue;
+                if (partition->limit >= 0 &&
+                    message->offset() > partition->limit) {
+                  FinishPartitionLocked(partition);
+                  continue;
+                }
+                partition->topic_partition->set_offset(message->offset() + 1);
+                if (partition->limit >= 0 &&
+                    message->offset() >= partition->limit) {
+                  FinishPartitionLocked(partition);
+                }
+                const char* payload =
+                    static_cast<const char*>(message->payload());
+                if (batch_size == 0) {
+                  // Produce the message as output.
+                  Tensor line_tensor(cpu_allocator(), DT_STRING, {});
+                  line_tensor.scalar<string>()().assign(payload,
+                                                        message->len());
+                  out_tensors->emplace_back(std::move(line_tensor));
+                  *end_of_sequence = false;
+                  return Status::OK();
+                }
+                if (num_messages == 0) {
+                  batch = Tensor(cpu_allocator(), DT_STRING, {batch_size});
+                }
+                batch.vec<string>()(num_messages++).assign(payload,
+                                                           message->len());
+                if (num_messages == batch_size) {
+                  EmitBatch(&batch, num_messages, out_tensors);
+                  *end_of_sequence = false;
+                  return Status::OK();
+                }
+                continue;
               }
 
-              if (message->err() == RdKafka::ERR__PARTITION_EOF &&
-                  dataset()->eof_) {
-                // EOF current topic
-                break;
+              if (message->err() == RdKafka::ERR__PARTITION_EOF) {
+                if (dataset()->eof_) {
+                  Partition* partition = FindPartitionLocked(
+                      message->topic_name(), message->partition());
+                  if (partition != nullptr && !partition->done) {
+                    FinishPartitionLocked(partition);
+                  }
+                }
+                continue;
               }
               if (message->err() != RdKafka::ERR__TIMED_OUT) {
                 return errors::Internal("Failed to consume:",
                                         message->errstr());
               }
+              // Don't hold back the messages read so far while waiting.
+              if (num_messages > 0) {
+                EmitBatch(&batch, num_messages, out_tensors);
+                *end_of_sequence = false;
+                return Status::OK();
+              }
               message.reset(nullptr);
               consumer_->poll(0);
             }
 
-            // We have reached the end of the current topic, so maybe
-            // move on to next topic.
+            // We have reached the end of the current partitions, so maybe
+            // move on to the next topic.
+            current_topic_index_ += partitions_.size();
             ResetStreamsLocked();
-            ++current_topic_index_;
           }
 
           // Iteration ends when there are no more topic to process.
           if (current_topic_index_ == dataset()->topics_.size()) {
+            if (num_messages > 0) {
+              EmitBatch(&batch, num_messages, out_tensors);
+              *end_of_sequence = false;
+              return Status::OK();
+            }
             *end_of_sequence = true;
             return Status::OK();
           }
 
-          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+          TF_RETURN_IF_ERROR(SetupPartitionsLocked());
+          TF_RETURN_IF_ERROR(AssignPartitionsLocked());
         } while (true);
       }
 
@@ -174,8 +236,26 @@ class KafkaDatasetOp : public DatasetOpKernel {
         // 1. GetNext has not been called even once.
         // 2. All topics have been read and iterator has been exhausted.
         if (consumer_.get()) {
-          TF_RETURN_IF_ERROR(
-              writer->WriteScalar(full_name("current_pos"), offset_));
+          std::vector<RdKafka::TopicPartition*> committed;
+          for (size_t i = 0; i < partitions_.size(); ++i) {
+            RdKafka::TopicPartition* topic_partition =
+                partitions_[i].topic_partition.get();
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name(PositionKey(i)), topic_partition->offset()));
+            if (topic_partition->offset() >= 0) {
+              committed.push_back(topic_partition);
+            }
+          }
+          // Let the consumer group follow the checkpoints, so that a job can
+          // resume from the stored offsets of the group.
+          if (!dataset()->group_.empty() && !committed.empty()) {
+            RdKafka::ErrorCode err = consumer_->commitSync(committed);
+            if (err != RdKafka::ERR_NO_ERROR) {
+              LOG(WARNING) << "Failed to commit the offsets of group "
+                           << dataset()->group_ << ": "
+                           << RdKafka::err2str(err);
+            }
+          }
         }
         return Status::OK();
       }
@@ -188,45 +268,45 @@ class KafkaDatasetOp : public DatasetOpKernel {
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("current_topic_index"),
                                               &current_topic_index));
         current_topic_index_ = size_t(current_topic_index);
-        // The key "current_pos" is written only if the iterator was saved
-        // with an open topic.
-        if (reader->Contains(full_name("current_pos"))) {
-          int64 current_pos;
-          TF_RETURN_IF_ERROR(
-              reader->ReadScalar(full_name("current_pos"), &current_pos));
-
-          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-          topic_partition_->set_offset(current_pos);
-          if (topic_partition_->offset() != current_pos) {
-            return errors::Internal("Failed to restore to offset ",
-                                    current_pos);
+        // The positions are written only if the iterator was saved with
+        // open partitions.
+        if (reader->Contains(full_name(PositionKey(0)))) {
+          TF_RETURN_IF_ERROR(SetupPartitionsLocked());
+          for (size_t i = 0; i < partitions_.size(); ++i) {
+            int64 current_pos;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(PositionKey(i)),
+                                                  &current_pos));
+            partitions_[i].topic_partition->set_offset(current_pos);
           }
-          offset_ = current_pos;
+          TF_RETURN_IF_ERROR(AssignPartitionsLocked());
         }
         return Status::OK();
       }
 
      private:
-      // Sets up Kafka streams to read from the topic at
-      // `current_topic_index_`.
-      Status SetupStreamsLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        if (current_topic_index_ >= dataset()->topics_.size()) {
-          return errors::InvalidArgument(
-              "current_topic_index_:", current_topic_index_,
-              " >= topics_.size():", dataset()->topics_.size());
-        }
-
-        // Actually move on to next topic.
-        string entry = dataset()->topics_[current_topic_index_];
+      // A subscription that is being read.
+      struct Partition {
+        // Its offset is the offset of the next message to read.
+        std::unique_ptr<RdKafka::TopicPartition> topic_partition;
+        // The offset of the last message to read, or -1 for unlimited.
+        int64 limit = -1;
+        bool done = false;
+      };
+
+      static string PositionKey(size_t i) {
+        return i == 0 ? "current_pos" : strings::StrCat("current_pos_", i);
+      }
 
+      static Status ParseSubscription(const string& entry,
+                                      Partition* partition) {
         std::vector<string> parts = str_util::Split(entry, ":");
         if (parts.size() < 1) {
           return errors::InvalidArgument("Invalid parameters: ", entry);
         }
         string topic = parts[0];
-        int32 partition = 0;
+        int32 partition_id = 0;
         if (parts.size() > 1) {
-          if (!strings::safe_strto32(parts[1], &partition)) {
+          if (!strings::safe_strto32(parts[1], &partition_id)) {
             return errors::InvalidArgument("Invalid parameters: ", entry);
           }
         }
@@ -236,17 +316,77 @@ class KafkaDatasetOp : public DatasetOpKernel {
             return errors::InvalidArgument("Invalid parameters: ", entry);
           }
         }
-
-        topic_partition_.reset(
-            RdKafka::TopicPartition::create(topic, partition, offset));
-
-        offset_ = topic_partition_->offset();
-        limit_ = -1;
+        partition->topic_partition.reset(
+            RdKafka::TopicPartition::create(topic, partition_id, offset));
+        partition->limit = -1;
         if (parts.size() > 3) {
-          if (!strings::safe_strto64(parts[3], &limit_)) {
+          if (!strings::safe_strto64(parts[3], &partition->limit)) {
             return errors::InvalidArgument("Invalid parameters: ", entry);
           }
         }
+        return Status::OK();
+      }
+
+      // Moves the first `num_messages` messages of `batch` to a new output
+      // tensor, unless the batch is full.
+      static void EmitBatch(Tensor* batch, int64 num_messages,
+                            std::vector<Tensor>* out_tensors) {
+        if (num_messages < batch->NumElements()) {
+          Tensor shrunk(cpu_allocator(), DT_STRING, {num_messages});
+          for (int64 i = 0; i < num_messages; ++i) {
+            shrunk.vec<string>()(i).swap(batch->vec<string>()(i));
+          }
+          *batch = std::move(shrunk);
+        }
+        out_tensors->emplace_back(std::move(*batch));
+      }
+
+      // Sets up the partitions to read next, starting at the subscription at
+      // `current_topic_index_`: only that one, or all the remaining ones
+      // when the dataset reads them in parallel.
+      Status SetupPartitionsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_topic_index_ >= dataset()->topics_.size()) {
+          return errors::InvalidArgument(
+              "current_topic_index_:", current_topic_index_,
+              " >= topics_.size():", dataset()->topics_.size());
+        }
+        const size_t end = dataset()->parallel_ ? dataset()->topics_.size()
+                                                : current_topic_index_ + 1;
+        partitions_.clear();
+        partitions_.resize(end - current_topic_index_);
+        for (size_t i = 0; i < partitions_.size(); ++i) {
+          const string& entry = dataset()->topics_[current_topic_index_ + i];
+          TF_RETURN_IF_ERROR(ParseSubscription(entry, &partitions_[i]));
+          const RdKafka::TopicPartition* topic_partition =
+              partitions_[i].topic_partition.get();
+          for (size_t j = 0; j < i; ++j) {
+            if (partitions_[j].topic_partition->partition() ==
+                    topic_partition->partition() &&
+                partitions_[j].topic_partition->topic() ==
+                    topic_partition->topic()) {
+              return errors::InvalidArgument(
+                  "Partition subscribed more than once: ", entry);
+            }
+          }
+        }
+        return Status::OK();
+      }
+
+      // Creates the consumer and assigns it the partitions that have
+      // messages left to read. Kafka fetches from all of them at once.
+      Status AssignPartitionsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        std::vector<RdKafka::TopicPartition*> assigned;
+        num_active_partitions_ = 0;
+        for (Partition& partition : partitions_) {
+          RdKafka::TopicPartition* topic_partition =
+              partition.topic_partition.get();
+          partition.done = partition.limit >= 0 &&
+                           topic_partition->offset() > partition.limit;
+          if (!partition.done) {
+            assigned.push_back(topic_partition);
+            ++num_active_partitions_;
+          }
+        }
 
         std::unique_ptr<RdKafka::Conf> conf(
             RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
@@ -271,37 +411,63 @@ class KafkaDatasetOp : public DatasetOpKernel {
           return errors::Internal("Failed to set group.id ", dataset()->group_,
                                   ":", errstr);
         }
+        // Offsets are only committed along with the iterator checkpoints.
+        result = conf->set("enable.auto.commit", "false", errstr);
+        if (result != RdKafka::Conf::CONF_OK) {
+          return errors::Internal("Failed to set enable.auto.commit:",
+                                  errstr);
+        }
 
         consumer_.reset(RdKafka::KafkaConsumer::create(conf.get(), errstr));
         if (!consumer_.get()) {
           return errors::Internal("Failed to create consumer:", errstr);
         }
 
-        std::vector<RdKafka::TopicPartition*> partitions;
-        partitions.emplace_back(topic_partition_.get());
-        RdKafka::ErrorCode err = consumer_->assign(partitions);
+        RdKafka::ErrorCode err = consumer_->assign(assigned);
         if (err != RdKafka::ERR_NO_ERROR) {
-          return errors::Internal(
-              "Failed to assign partition [", topic_partition_->topic(), ", ",
-              topic_partition_->partition(), ", ", topic_partition_->offset(),
-              "]:", RdKafka::err2str(err));
+          return errors::Internal("Failed to assign ", assigned.size(),
+                                  " partitions:", RdKafka::err2str(err));
         }
 
         return Status::OK();
       }
 
+      Partition* FindPartitionLocked(const string& topic, int32 partition_id)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (Partition& partition : partitions_) {
+          if (partition.topic_partition->partition() == partition_id &&
+              partition.topic_partition->topic() == topic) {
+            return &partition;
+          }
+        }
+        return nullptr;
+      }
+
+      // Stops fetching the messages of a partition that has been read.
+      void FinishPartitionLocked(Partition* partition)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        partition->done = true;
+        --num_active_partitions_;
+        std::vector<RdKafka::TopicPartition*> paused = {
+            partition->topic_partition.get()};
+        consumer_->pause(paused);
+      }
+
       // Resets all Kafka streams.
       void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        consumer_->unassign();
-        consumer_->close();
-        consumer_.reset(nullptr);
+        if (consumer_.get()) {
+          consumer_->unassign();
+          consumer_->close();
+          consumer_.reset(nullptr);
+        }
+        partitions_.clear();
+        num_active_partitions_ = 0;
       }
 
       mutex mu_;
       size_t current_topic_index_ GUARDED_BY(mu_) = 0;
-      int64 offset_ GUARDED_BY(mu_) = 0;
-      int64 limit_ GUARDED_BY(mu_) = -1;
-      std::unique_ptr<RdKafka::TopicPartition> topic_partition_ GUARDED_BY(mu_);
+      std::vector<Partition> partitions_ GUARDED_BY(mu_);
+      size_t num_active_partitions_ GUARDED_BY(mu_) = 0;
       std::unique_ptr<RdKafka::KafkaConsumer> consumer_ GUARDED_BY(mu_);
     };
 
@@ -310,6 +476,8 @@ class KafkaDatasetOp : public DatasetOpKernel {
     const std::string group_;
     const bool eof_;
     const int64 timeout_;
+    const int64 batch_size_;
+    const bool parallel_;
   };
 };
 
@@ -25,6 +25,8 @@ REGISTER_OP("KafkaDataset")
     .Input("group: string")
     .Input("eof: bool")
     .Input("timeout: int64")
+    .Input("batch_size: int64")
+    .Input("parallel: bool")
     .Output("handle: variant")
     .SetIsStateful()
     .SetShapeFn(shape_inference::ScalarShape)
@@ -39,6 +41,11 @@ group: The consumer group id.
 eof: If True, the kafka reader will stop on EOF.
 timeout: The timeout value for the Kafka Consumer to wait
   (in millisecond).
+batch_size: If positive, the dataset emits vectors of up to `batch_size`
+  messages instead of single messages. A batch is cut short when the consumer
+  times out or the subscriptions are exhausted.
+parallel: If True, all the subscriptions are read at once and their messages
+  are interleaved in arrival order. Otherwise they are read one after another.
 )doc");
 
 }  // namespace tensorflow
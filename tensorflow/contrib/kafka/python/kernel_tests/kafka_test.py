@@ -110,6 +110,56 @@ class KafkaDatasetTest(test.TestCase):
         self.assertAllEqual(["D" + str(i + 5) for i in range(5)],
                             sess.run(get_next))
 
+  def testKafkaDatasetBatchSize(self):
+    topics = array_ops.placeholder(dtypes.string, shape=[None])
+    parallel = array_ops.placeholder(dtypes.bool, shape=[])
+
+    dataset = kafka_dataset_ops.KafkaDataset(
+        topics, group="test", eof=True, batch_size=4, parallel=parallel)
+    iterator = dataset.make_initializable_iterator()
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      # Batches span subscriptions, and the last one is cut short.
+      sess.run(
+          iterator.initializer,
+          feed_dict={
+              topics: ["test:0:0:4", "test:0:5:-1"],
+              parallel: False
+          })
+      for i in range(2):
+        self.assertAllEqual(["D" + str(j) for j in range(i * 4, i * 4 + 4)],
+                            sess.run(get_next))
+      self.assertAllEqual(["D8", "D9"], sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # Reading in parallel interleaves the messages of both topics.
+      sess.run(
+          iterator.initializer,
+          feed_dict={
+              topics: ["test:0:0:4", "test2:0:0:-1"],
+              parallel: True
+          })
+      messages = []
+      while True:
+        try:
+          messages.extend(sess.run(get_next))
+        except errors.OutOfRangeError:
+          break
+      self.assertEqual(
+          sorted(["D" + str(i) for i in range(5)] +
+                 ["E" + str(i) for i in range(5)]), sorted(messages))
+
+      # A partition can only be read once at a time.
+      sess.run(
+          iterator.initializer,
+          feed_dict={
+              topics: ["test:0:0:4", "test:0:5:-1"],
+              parallel: True
+          })
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
 
 if __name__ == "__main__":
   test.main()
@@ -33,6 +33,10 @@ if [ "$1" == "start" ]; then
     docker exec $container bash -c 'echo -e "D0\nD1\nD2\nD3\nD4\nD5\nD6\nD7\nD8\nD9" > /test'
     echo Produce test message
     docker exec $container bash -c '/opt/kafka_2.11-0.10.1.0/bin/kafka-console-producer.sh --topic test --broker-list 127.0.0.1:9092 < /test'
+    echo Create second test topic
+    docker exec $container bash -c '/opt/kafka_2.11-0.10.1.0/bin/kafka-topics.sh --create --zookeeper localhost:2181 --replication-factor 1 --partitions 1 --topic test2'
+    docker exec $container bash -c 'echo -e "E0\nE1\nE2\nE3\nE4" > /test2'
+    docker exec $container bash -c '/opt/kafka_2.11-0.10.1.0/bin/kafka-console-producer.sh --topic test2 --broker-list 127.0.0.1:9092 < /test2'
 
     echo Container $container started successfully
 elif [ "$1" == "stop" ]; then
@@ -34,18 +34,29 @@ class KafkaDataset(Dataset):
                servers="localhost",
                group="",
                eof=False,
-               timeout=1000):
+               timeout=1000,
+               batch_size=None,
+               parallel=False):
     """Create a KafkaReader.
 
     Args:
       topics: A `tf.string` tensor containing one or more subscriptions,
               in the format of [topic:partition:offset:length],
-              by default length is -1 for unlimited.
+              by default length is -1 for unlimited. An offset of -1000
+              starts from the offsets committed by the consumer group.
       servers: A list of bootstrap servers.
       group: The consumer group id.
       eof: If True, the kafka reader will stop on EOF.
       timeout: The timeout value for the Kafka Consumer to wait
                (in millisecond).
+      batch_size: If set, the dataset emits vectors of up to `batch_size`
+                  messages, cut short when the consumer times out or the
+                  subscriptions are exhausted.
+      parallel: If True, all the subscriptions are read at once and their
+                messages are interleaved in arrival order.
+
+    When `group` is set, the offsets of the subscriptions are committed to
+    the consumer group each time the iterator is saved.
     """
     super(KafkaDataset, self).__init__()
     self._topics = ops.convert_to_tensor(
@@ -57,10 +68,18 @@ class KafkaDataset(Dataset):
     self._eof = ops.convert_to_tensor(eof, dtype=dtypes.bool, name="eof")
     self._timeout = ops.convert_to_tensor(
         timeout, dtype=dtypes.int64, name="timeout")
+    self._batched = batch_size is not None
+    self._batch_size = ops.convert_to_tensor(
+        batch_size if self._batched else 0,
+        dtype=dtypes.int64,
+        name="batch_size")
+    self._parallel = ops.convert_to_tensor(
+        parallel, dtype=dtypes.bool, name="parallel")
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.kafka_dataset(self._topics, self._servers,
-                                         self._group, self._eof, self._timeout)
+                                         self._group, self._eof, self._timeout,
+                                         self._batch_size, self._parallel)
 
   @property
   def output_classes(self):
@@ -68,6 +87,8 @@ class KafkaDataset(Dataset):
 
   @property
   def output_shapes(self):
+    if self._batched:
+      return tensor_shape.vector(None)
     return tensor_shape.scalar()
 
   @property
@@ -30,9 +30,19 @@ namespace tflite {
 // A memory allocation handle. This could be a mmap or shared memory.
 class Allocation {
  public:
-  Allocation(ErrorReporter* error_reporter) : error_reporter_(error_reporter) {}
+  // The kind of memory, letting delegates share it with accelerators.
+  enum class Type {
+    kMMap,
+    kFileCopy,
+    kMemory,
+  };
+
+  Allocation(ErrorReporter* error_reporter, Type type)
+      : error_reporter_(error_reporter), type_(type) {}
   virtual ~Allocation() {}
 
+  Type type() const { return type_; }
+
   // Base pointer of this allocation
   virtual const void* base() const = 0;
   // Size in bytes of the allocation
@@ -42,6 +52,9 @@ class Allocation {
 
  protected:
   ErrorReporter* error_reporter_;
+
+ private:
+  const Type type_;
 };
 
 class MMAPAllocation : public Allocation {
@@ -52,6 +65,9 @@ class MMAPAllocation : public Allocation {
   size_t bytes() const override;
   bool valid() const override;
 
+  // The descriptor of the mapped file, e.g. to map it in another process.
+  int fd() const { return mmap_fd_; }
+
  protected:
   // Data required for mmap.
   int mmap_fd_ = -1;  // mmap file descriptor
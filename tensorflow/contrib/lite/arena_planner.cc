@@ -13,9 +13,19 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/arena_planner.h"
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 namespace tflite {
+namespace {
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+}  // namespace
 
 struct AllocationInfo {
   // The node index requesting this allocation.
@@ -29,14 +39,16 @@ struct AllocationInfo {
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_inputs, bool preserve_intermediates,
-                           int tensor_alignment)
+                           int tensor_alignment,
+                           ArenaPlanningStrategy strategy)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment),
       persistent_arena_(kDefaultArenaAlignment),
       preserve_inputs_(preserve_inputs),
       preserve_intermediates_(preserve_intermediates),
-      tensor_alignment_(tensor_alignment) {}
+      tensor_alignment_(tensor_alignment),
+      strategy_(strategy) {}
 
 ArenaPlanner::~ArenaPlanner() {}
 
@@ -55,12 +67,54 @@ TfLiteStatus ArenaPlanner::ResetAllocations() {
   TF_LITE_ENSURE_STATUS(persistent_arena_.Clear());
   allocs_.clear();
   allocs_.resize(graph_info_->num_tensors());
+  unplaced_tensors_.clear();
+  placed_tensors_.clear();
+  allocations_executed_ = false;
   return kTfLiteOk;
 }
 
+void ArenaPlanner::SetNodeSteps(std::vector<int> node_steps) {
+  node_steps_ = std::move(node_steps);
+  strategy_ = ArenaPlanningStrategy::kGreedyBySize;
+  plan_cache_.clear();
+}
+
+void ArenaPlanner::SetPlanCacheCapacity(int capacity) {
+  plan_cache_capacity_ = std::max(capacity, 0);
+  while (plan_cache_.size() > plan_cache_capacity_) {
+    plan_cache_.pop_back();
+  }
+}
+
+size_t ArenaPlanner::LowerBoundArenaSize() {
+  std::vector<int> first_node, last_node;
+  CalculateLifetimes(&first_node, &last_node);
+
+  // live_bytes[i + 1] - live_bytes[i] is the change in the number of live
+  // bytes when entering node (or step) i.
+  std::vector<int64_t> live_bytes(graph_info_->num_nodes() + 2, 0);
+  for (int i = 0; i < graph_info_->num_tensors(); ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    if (first_node[i] < 0 || tensor.allocation_type != kTfLiteArenaRw) {
+      continue;
+    }
+    live_bytes[first_node[i] + 1] += tensor.bytes;
+    live_bytes[last_node[i] + 2] -= tensor.bytes;
+  }
+  int64_t lower_bound = 0;
+  for (int i = 1; i < live_bytes.size(); ++i) {
+    live_bytes[i] += live_bytes[i - 1];
+    lower_bound = std::max(lower_bound, live_bytes[i]);
+  }
+  return lower_bound;
+}
+
 TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Invalidate any existing data.
   TF_LITE_ENSURE_STATUS(ResetAllocations());
+  plan_cache_.clear();
+  TF_LITE_ENSURE(context_, node_steps_.empty() ||
+                               node_steps_.size() == graph_info_->num_nodes());
 
   // Keeps track of references to each tensor.
   std::vector<int> refcounts(graph_info_->num_tensors(), 0);
@@ -185,7 +239,31 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   TF_LITE_ENSURE(context_, graph_info_->num_tensors() >= allocs_.size());
   allocs_.resize(graph_info_->num_tensors());
 
-  TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+  // Only the plans covering the whole graph are cached, as those of a part
+  // depend on how the previous parts were placed.
+  const bool cacheable = plan_cache_capacity_ > 0 && !allocations_executed_ &&
+                         first_node == 0 &&
+                         last_node + 1 >= graph_info_->num_nodes();
+  allocations_executed_ = true;
+
+  std::vector<size_t> key;
+  auto cached_plan = plan_cache_.end();
+  if (cacheable) {
+    GetPlanCacheKey(&key);
+    cached_plan = std::find_if(
+        plan_cache_.begin(), plan_cache_.end(),
+        [&key](const CachedPlan& plan) { return plan.key == key; });
+  }
+  if (cached_plan != plan_cache_.end()) {
+    plan_cache_.splice(plan_cache_.begin(), plan_cache_, cached_plan);
+    TF_LITE_ENSURE_STATUS(RestorePlan(plan_cache_.front().allocs));
+  } else {
+    TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
+    if (cacheable) {
+      plan_cache_.push_front({std::move(key), allocs_});
+      SetPlanCacheCapacity(plan_cache_capacity_);
+    }
+  }
   TF_LITE_ENSURE_STATUS(Commit());
 
   for (int i = 0; i < graph_info_->num_tensors(); ++i) {
@@ -236,6 +314,10 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   TF_LITE_ENSURE_STATUS(
       CalculateDeallocationOfInternalTensors(active_node - 1));
 
+  if (strategy_ == ArenaPlanningStrategy::kGreedyBySize) {
+    TF_LITE_ENSURE_STATUS(PlaceTensorsBySize());
+  }
+
   return kTfLiteOk;
 }
 
@@ -258,7 +340,12 @@ TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
 
 TfLiteStatus ArenaPlanner::CalculateTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-  if (tensor.allocation_type == kTfLiteArenaRw) {
+  if (tensor.allocation_type == kTfLiteArenaRw &&
+      strategy_ == ArenaPlanningStrategy::kGreedyBySize) {
+    // The offset is chosen once all the tensors of the current call are
+    // known.
+    unplaced_tensors_.push_back(tensor_index);
+  } else if (tensor.allocation_type == kTfLiteArenaRw) {
     TF_LITE_ENSURE_STATUS(arena_.Allocate(
         context_, tensor_alignment_, tensor.bytes, &allocs_[tensor_index]));
   }
@@ -271,7 +358,8 @@ TfLiteStatus ArenaPlanner::CalculateTensorAllocation(int tensor_index) {
 
 TfLiteStatus ArenaPlanner::CalculateTensorDeallocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-  if (tensor.allocation_type == kTfLiteArenaRw) {
+  if (tensor.allocation_type == kTfLiteArenaRw &&
+      strategy_ == ArenaPlanningStrategy::kExecutionOrder) {
     TF_LITE_ENSURE_STATUS(arena_.Deallocate(context_, allocs_[tensor_index]));
   }
   return kTfLiteOk;
@@ -303,4 +391,145 @@ TfLiteStatus ArenaPlanner::CalculateDeallocationOfInternalTensors(
   return kTfLiteOk;
 }
 
+void ArenaPlanner::CalculateLifetimes(std::vector<int>* first_node,
+                                      std::vector<int>* last_node) {
+  const int num_nodes = graph_info_->num_nodes();
+  first_node->assign(graph_info_->num_tensors(), -1);
+  last_node->assign(graph_info_->num_tensors(), -1);
+  std::vector<int> deallocated(graph_info_->num_tensors(), false);
+  for (const auto& alloc_info : alloc_queue_) {
+    if (alloc_info.type == AllocationInfo::ALLOC) {
+      (*first_node)[alloc_info.tensor] = alloc_info.node;
+    } else {
+      (*last_node)[alloc_info.tensor] = alloc_info.node;
+      deallocated[alloc_info.tensor] = true;
+    }
+  }
+  for (int i = 0; i < graph_info_->num_tensors(); ++i) {
+    if ((*first_node)[i] >= 0 && !deallocated[i]) {
+      (*last_node)[i] = std::max((*first_node)[i], num_nodes - 1);
+    }
+  }
+  // Temporaries only live during the node that owns them.
+  for (int i = 0; i < num_nodes; ++i) {
+    TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    for (int j = 0; j < node_temporaries->size; ++j) {
+      int tensor_index = node_temporaries->data[j];
+      if ((*first_node)[tensor_index] < 0) {
+        (*first_node)[tensor_index] = i;
+        (*last_node)[tensor_index] = i;
+      } else {
+        (*first_node)[tensor_index] = std::min((*first_node)[tensor_index], i);
+        (*last_node)[tensor_index] = std::max((*last_node)[tensor_index], i);
+      }
+    }
+  }
+  // As steps don't decrease along the execution order, the first and last
+  // nodes of a lifetime fall in its first and last steps.
+  if (!node_steps_.empty()) {
+    for (int i = 0; i < graph_info_->num_tensors(); ++i) {
+      if ((*first_node)[i] >= 0) {
+        (*first_node)[i] = node_steps_[(*first_node)[i]];
+        (*last_node)[i] = node_steps_[(*last_node)[i]];
+      }
+    }
+  }
+}
+
+TfLiteStatus ArenaPlanner::PlaceTensorsBySize() {
+  std::vector<int> first_node, last_node;
+  CalculateLifetimes(&first_node, &last_node);
+
+  // Place the largest tensors first, breaking ties by index to keep the plan
+  // deterministic.
+  auto larger = [this](int a, int b) {
+    size_t a_bytes = graph_info_->tensor(a)->bytes;
+    size_t b_bytes = graph_info_->tensor(b)->bytes;
+    return a_bytes > b_bytes || (a_bytes == b_bytes && a < b);
+  };
+  std::sort(unplaced_tensors_.begin(), unplaced_tensors_.end(), larger);
+  unplaced_tensors_.erase(
+      std::unique(unplaced_tensors_.begin(), unplaced_tensors_.end()),
+      unplaced_tensors_.end());
+
+  std::vector<ArenaAlloc> overlapping;
+  for (int tensor_index : unplaced_tensors_) {
+    const size_t size = graph_info_->tensor(tensor_index)->bytes;
+
+    // Only the tensors that are live at the same time must be kept apart.
+    overlapping.clear();
+    for (int other : placed_tensors_) {
+      if (first_node[other] <= last_node[tensor_index] &&
+          first_node[tensor_index] <= last_node[other]) {
+        overlapping.push_back(allocs_[other]);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end());
+
+    // Take the smallest gap that fits, or else go past all the overlapping
+    // tensors. These may overlap each other, as they need not be live at the
+    // same time.
+    size_t best_offset = 0;
+    size_t best_offset_fit = std::numeric_limits<size_t>::max();
+    size_t current_offset = 0;
+    for (const ArenaAlloc& alloc : overlapping) {
+      size_t aligned_current_offset =
+          AlignTo(tensor_alignment_, current_offset);
+      if (aligned_current_offset + size <= alloc.offset &&
+          alloc.offset - current_offset < best_offset_fit) {
+        best_offset = aligned_current_offset;
+        best_offset_fit = alloc.offset - current_offset;
+      }
+      current_offset = std::max(current_offset, alloc.offset + alloc.size);
+    }
+    if (best_offset_fit == std::numeric_limits<size_t>::max()) {
+      best_offset = AlignTo(tensor_alignment_, current_offset);
+    }
+
+    TF_LITE_ENSURE_STATUS(arena_.AllocateAt(context_, tensor_alignment_,
+                                            best_offset, size,
+                                            &allocs_[tensor_index]));
+    if (size != 0) {
+      placed_tensors_.push_back(tensor_index);
+    }
+  }
+  unplaced_tensors_.clear();
+  return kTfLiteOk;
+}
+
+void ArenaPlanner::GetPlanCacheKey(std::vector<size_t>* key) {
+  key->clear();
+  for (int i = 0; i < graph_info_->num_tensors(); ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    key->push_back(tensor.allocation_type);
+    if (tensor.allocation_type == kTfLiteArenaRw ||
+        tensor.allocation_type == kTfLiteArenaRwPersistent) {
+      key->push_back(tensor.bytes);
+    }
+  }
+  for (int i = 0; i < graph_info_->num_nodes(); ++i) {
+    TfLiteIntArray* node_temporaries = graph_info_->node(i).temporaries;
+    key->push_back(node_temporaries->size);
+    key->insert(key->end(), node_temporaries->data,
+                node_temporaries->data + node_temporaries->size);
+  }
+}
+
+TfLiteStatus ArenaPlanner::RestorePlan(const std::vector<ArenaAlloc>& allocs) {
+  for (int i = 0; i < graph_info_->num_tensors(); ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    if (tensor.allocation_type == kTfLiteArenaRw) {
+      TF_LITE_ENSURE_STATUS(arena_.AllocateAt(context_, tensor_alignment_,
+                                              allocs[i].offset, allocs[i].size,
+                                              &allocs_[i]));
+    }
+    if (tensor.allocation_type == kTfLiteArenaRwPersistent) {
+      TF_LITE_ENSURE_STATUS(persistent_arena_.AllocateAt(
+          context_, tensor_alignment_, allocs[i].offset, allocs[i].size,
+          &allocs_[i]));
+    }
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_LITE_ARENA_PLANNER_H_
 #define TENSORFLOW_CONTRIB_LITE_ARENA_PLANNER_H_
 
+#include <list>
 #include <memory>
 #include <vector>
 
@@ -31,6 +32,19 @@ constexpr const int kDefaultTensorAlignment = 64;
 
 struct AllocationInfo;
 
+// How an ArenaPlanner assigns offsets to the kTfLiteArenaRw tensors.
+enum class ArenaPlanningStrategy {
+  // Tensors are allocated and deallocated in execution order, each new tensor
+  // taking the best fitting gap left by those deallocated so far.
+  kExecutionOrder,
+  // The tensors of each ExecuteAllocations() call are placed from the largest
+  // to the smallest, each in the best fitting gap between the already placed
+  // tensors whose lifetimes overlap its own. This usually gets closer to
+  // LowerBoundArenaSize() than kExecutionOrder, as large tensors are not
+  // pushed up by the small ones allocated before them.
+  kGreedyBySize,
+};
+
 // A memory planner that makes all the allocations using arenas.
 //
 // Before a model is executed by the interpreter, this class determines when
@@ -52,7 +66,9 @@ class ArenaPlanner : public MemoryPlanner {
   // them until the end of inference.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_inputs, bool preserve_intermediates,
-               int tensor_alignment = kDefaultTensorAlignment);
+               int tensor_alignment = kDefaultTensorAlignment,
+               ArenaPlanningStrategy strategy =
+                   ArenaPlanningStrategy::kExecutionOrder);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -64,7 +80,37 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   int64_t BasePointer(TfLiteAllocationType type);
 
+  // Returns the number of bytes of the kTfLiteArenaRw arena used by the
+  // allocations executed so far, not counting the arena's own padding.
+  size_t ArenaSize() const { return arena_.high_water_mark(); }
+
+  // Returns a lower bound for ArenaSize(): the largest total size of the
+  // kTfLiteArenaRw tensors that are live during the same node. Tensors whose
+  // allocations have not been executed yet count with their current size.
+  size_t LowerBoundArenaSize();
+
+  // Keeps the tensors of nodes that may run concurrently apart. 'node_steps'
+  // gives the step of each node, in execution order, and must not decrease
+  // along it; the nodes of a step may run concurrently. Lifetimes then span
+  // whole steps, which the execution order alone cannot express, so tensors
+  // are placed as with ArenaPlanningStrategy::kGreedyBySize.
+  void SetNodeSteps(std::vector<int> node_steps);
+
+  // Keeps the plans made for up to 'capacity' different sets of tensor sizes.
+  // When ExecuteAllocations() covers all the nodes right after a reset and
+  // the tensors have the sizes of a kept plan, they are given the offsets of
+  // that plan instead of being placed again, e.g. for a model whose inputs
+  // take a few different shapes. The least recently used plan goes first.
+  void SetPlanCacheCapacity(int capacity);
+
  private:
+  // The offsets given to all the tensors for the sizes in 'key', see
+  // GetPlanCacheKey().
+  struct CachedPlan {
+    std::vector<size_t> key;
+    std::vector<ArenaAlloc> allocs;
+  };
+
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
   TfLiteStatus Commit();
@@ -91,6 +137,24 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Sets 'first_node' and 'last_node' to the first and last nodes during which
+  // each tensor must stay allocated, or to -1 for tensors that are never
+  // allocated. Tensors that are never deallocated live until the last node.
+  // With node steps, lifetimes are given in steps rather than nodes.
+  void CalculateLifetimes(std::vector<int>* first_node,
+                          std::vector<int>* last_node);
+
+  // Assigns offsets to the tensors in 'unplaced_tensors_', as described for
+  // ArenaPlanningStrategy::kGreedyBySize.
+  TfLiteStatus PlaceTensorsBySize();
+
+  // Sets 'key' to what a plan depends on besides the graph: the allocation
+  // type and size of each tensor, and the temporaries of each node.
+  void GetPlanCacheKey(std::vector<size_t>* key);
+
+  // Allocates the arena tensors at the offsets in 'allocs'.
+  TfLiteStatus RestorePlan(const std::vector<ArenaAlloc>& allocs);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -120,6 +184,24 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  ArenaPlanningStrategy strategy_;
+
+  // With kGreedyBySize, the kTfLiteArenaRw tensors allocated by the current
+  // ExecuteAllocations() call, and those placed by the previous calls since
+  // the last reset.
+  std::vector<int> unplaced_tensors_;
+  std::vector<int> placed_tensors_;
+
+  // The step of each node, if set by SetNodeSteps().
+  std::vector<int> node_steps_;
+
+  // The plans kept by SetPlanCacheCapacity(), most recently used first.
+  int plan_cache_capacity_ = 0;
+  std::list<CachedPlan> plan_cache_;
+
+  // Whether ExecuteAllocations() was called since the last reset.
+  bool allocations_executed_ = false;
 };
 
 }  // namespace tflite
@@ -15,6 +15,8 @@ limitations under the License.
 #include "tensorflow/contrib/lite/arena_planner.h"
 
 #include <cstdarg>
+#include <map>
+#include <utility>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -153,12 +155,19 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_inputs = false) {
+  void SetGraph(TestGraph* graph, bool preserve_inputs = false,
+                ArenaPlanningStrategy strategy =
+                    ArenaPlanningStrategy::kExecutionOrder,
+                std::vector<int> node_steps = {}) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment));
+        preserve_inputs, /*preserve intermediates*/ false, kTensorAlignment,
+        strategy));
+    if (!node_steps.empty()) {
+      planner_->SetNodeSteps(node_steps);
+    }
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -186,6 +195,25 @@ class ArenaPlannerTest : public ::testing::Test {
     return offset;
   };
 
+  // Checks that no two tensors share memory while they are both live, given
+  // the [first, last] node of each tensor's lifetime.
+  void ExpectNoOverlap(const std::map<int, std::pair<int, int>>& lifetimes) {
+    for (const auto& a : lifetimes) {
+      for (const auto& b : lifetimes) {
+        if (a.first >= b.first || a.second.first > b.second.second ||
+            b.second.first > a.second.second) {
+          continue;
+        }
+        bool apart =
+            GetOffset(a.first) + (*graph_->tensors())[a.first].bytes <=
+                GetOffset(b.first) ||
+            GetOffset(b.first) + (*graph_->tensors())[b.first].bytes <=
+                GetOffset(a.first);
+        EXPECT_TRUE(apart) << "#" << a.first << " and #" << b.first;
+      }
+    }
+  }
+
   TfLiteContext context_;
   TestGraph* graph_;
   std::unique_ptr<ArenaPlanner> planner_;
@@ -246,6 +274,120 @@ TEST_F(ArenaPlannerTest, SimpleGraph) {
   EXPECT_EQ(GetOffset(3), 0);
 }
 
+TEST_F(ArenaPlannerTest, SimpleGraphArenaSize) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+
+  // #4 doesn't fit where #1 was, so #5 ends at 40 + 18.
+  EXPECT_EQ(planner_->ArenaSize(), 58);
+  // The second and third ops both need 45 bytes: #0, #2, #4 and #5, then #4,
+  // #5 and #3.
+  EXPECT_EQ(planner_->LowerBoundArenaSize(), 45);
+}
+
+TEST_F(ArenaPlannerTest, SimpleGraphCachedPlans) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  planner_->SetPlanCacheCapacity(1);
+  Execute(0, 10);
+  std::vector<int64_t> offsets;
+  for (int i = 0; i < 6; ++i) offsets.push_back(GetOffset(i));
+  const size_t arena_size = planner_->ArenaSize();
+
+  // A larger #1 pushes #2 up.
+  (*graph.tensors())[1].bytes = 100;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(1));
+  EXPECT_GT(planner_->ArenaSize(), arena_size);
+
+  // The plan for the smaller #1 was dropped for the last one, and is made
+  // again.
+  (*graph.tensors())[1].bytes = 6;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  for (int i = 0; i < 6; ++i) EXPECT_EQ(GetOffset(i), offsets[i]);
+  EXPECT_EQ(planner_->ArenaSize(), arena_size);
+
+  // Now it is restored from the cache.
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  for (int i = 0; i < 6; ++i) EXPECT_EQ(GetOffset(i), offsets[i]);
+  EXPECT_EQ(planner_->ArenaSize(), arena_size);
+}
+
+TEST_F(ArenaPlannerTest, SimpleGraphGreedyBySize) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph, /*preserve_inputs=*/false,
+           ArenaPlanningStrategy::kGreedyBySize);
+  Execute(0, 10);
+
+  // Lifetimes: #0 [0, 1], #1 [0, 0], #2 [0, 1], #4 [1, 2], #5 [1, 2] and
+  // #3 [2, 2]. Placement order: #5 #4 #3 #2 #1 #0.
+  EXPECT_EQ(GetOffset(5), 0);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(4));
+  // #2 is not live with #3, so they share memory.
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(4));
+  // #1 only needs to stay clear of #2.
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_EQ(GetOffset(0), GetOffsetAfter(2));
+  EXPECT_EQ(planner_->ArenaSize(), 51);
+  EXPECT_EQ(planner_->LowerBoundArenaSize(), 45);
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodesWithTemporaries) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {4}},    // First op
+                      {{0}, {2}, {5}},    // Second op, independent of first
+                      {{1, 2}, {3}, {}}   // Third op
+                  },
+                  {3});
+
+  // Run in order, the two ops can share the memory of their temporaries.
+  SetGraph(&graph, /*preserve_inputs=*/false,
+           ArenaPlanningStrategy::kGreedyBySize);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(5), GetOffset(4));
+
+  // Not if they run concurrently.
+  SetGraph(&graph, /*preserve_inputs=*/false,
+           ArenaPlanningStrategy::kExecutionOrder, /*node_steps=*/{0, 0, 1});
+  Execute(0, 10);
+  ExpectNoOverlap({{0, {0, 0}},
+                   {1, {0, 1}},
+                   {2, {0, 1}},
+                   {3, {1, 1}},
+                   {4, {0, 0}},
+                   {5, {0, 0}}});
+  // The third op needs #1, #2 and #3, the first two #0, #1, #2, #4 and #5.
+  EXPECT_EQ(planner_->LowerBoundArenaSize(), 3 + 6 + 9 + 15 + 18);
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
@@ -493,6 +635,47 @@ TEST_F(ArenaPlannerTest, LargerGraphAndStepwiseAllocation) {
   EXPECT_EQ(GetOffset(10), 0);
 }
 
+TEST_F(ArenaPlannerTest, LargerGraphAndStepwiseGreedyBySize) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2, 3}, {}},
+                      {{2, 0}, {4, 5}, {6}},
+                      {{1, -1}, {7}, {}},
+                      {{7, 3}, {8}, {9}},
+                      {{4, 5, 8}, {10}, {}},
+                  },
+                  {10});
+  SetGraph(&graph, /*preserve_inputs=*/false,
+           ArenaPlanningStrategy::kGreedyBySize);
+
+  // Tensors placed by an earlier step keep their offsets, and those of later
+  // steps avoid them while they are live.
+  Execute(0, 0);
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(3));
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffset(0), GetOffsetAfter(1));
+  for (int step = 1; step <= 4; ++step) {
+    Execute(step, step);
+  }
+  EXPECT_EQ(GetOffset(3), 0);
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(3));
+
+  ExpectNoOverlap({{0, {0, 1}},
+                   {1, {0, 2}},
+                   {2, {0, 1}},
+                   {3, {0, 3}},
+                   {4, {1, 4}},
+                   {5, {1, 4}},
+                   {6, {1, 1}},
+                   {7, {2, 3}},
+                   {8, {3, 4}},
+                   {9, {3, 3}},
+                   {10, {4, 4}}});
+  EXPECT_GE(planner_->ArenaSize(), planner_->LowerBoundArenaSize());
+}
+
 }  // namespace
 }  // namespace tflite
 
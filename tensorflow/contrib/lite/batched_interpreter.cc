@@ -0,0 +1,248 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/batched_interpreter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tflite {
+
+BatchedInterpreter::BatchedInterpreter(ErrorReporter* error_reporter)
+    : error_reporter_(error_reporter ? error_reporter
+                                     : DefaultErrorReporter()) {}
+
+BatchedInterpreter::~BatchedInterpreter() {}
+
+std::unique_ptr<BatchedInterpreter> BatchedInterpreter::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const std::vector<int>& batch_sizes, ErrorReporter* error_reporter) {
+  std::unique_ptr<BatchedInterpreter> batched(
+      new BatchedInterpreter(error_reporter));
+  for (int batch_size : batch_sizes) {
+    std::unique_ptr<Interpreter> interpreter;
+    if (InterpreterBuilder(model, op_resolver)(&interpreter) != kTfLiteOk ||
+        batched->AddInterpreter(std::move(interpreter), batch_size) !=
+            kTfLiteOk) {
+      return nullptr;
+    }
+  }
+  return batched;
+}
+
+TfLiteStatus BatchedInterpreter::AddInterpreter(
+    std::unique_ptr<Interpreter> interpreter, int batch_size) {
+  if (!interpreter || batch_size < 1) {
+    error_reporter_->Report("Invalid interpreter or batch size %d.",
+                            batch_size);
+    return kTfLiteError;
+  }
+  for (const SizedInterpreter& sized : interpreters_) {
+    if (sized.batch_size == batch_size) {
+      error_reporter_->Report("Batch size %d was already added.", batch_size);
+      return kTfLiteError;
+    }
+  }
+
+  for (int index : interpreter->inputs()) {
+    const TfLiteTensor* tensor = interpreter->tensor(index);
+    if (tensor->dims->size < 1) {
+      error_reporter_->Report("Input '%s' has no batch dimension.",
+                              tensor->name);
+      return kTfLiteError;
+    }
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    dims[0] = batch_size;
+    if (interpreter->ResizeInputTensor(index, dims) != kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+
+  // The bytes of each example, for the inputs and then the outputs.
+  std::vector<size_t> example_bytes;
+  std::vector<int> tensors = interpreter->inputs();
+  tensors.insert(tensors.end(), interpreter->outputs().begin(),
+                 interpreter->outputs().end());
+  for (int index : tensors) {
+    const TfLiteTensor* tensor = interpreter->tensor(index);
+    if (tensor->type == kTfLiteString ||
+        tensor->allocation_type == kTfLiteDynamic) {
+      error_reporter_->Report(
+          "Tensor '%s' is a string or dynamic tensor, which can't be batched.",
+          tensor->name);
+      return kTfLiteError;
+    }
+    if (tensor->dims->size < 1 || tensor->dims->data[0] != batch_size) {
+      error_reporter_->Report(
+          "Tensor '%s' doesn't have the batch size %d as first dimension.",
+          tensor->name, batch_size);
+      return kTfLiteError;
+    }
+    example_bytes.push_back(tensor->bytes / batch_size);
+  }
+  const size_t num_inputs = interpreter->inputs().size();
+  std::vector<size_t> input_bytes(example_bytes.begin(),
+                                  example_bytes.begin() + num_inputs);
+  std::vector<size_t> output_bytes(example_bytes.begin() + num_inputs,
+                                   example_bytes.end());
+  if (interpreters_.empty()) {
+    example_input_bytes_ = std::move(input_bytes);
+    example_output_bytes_ = std::move(output_bytes);
+  } else if (input_bytes != example_input_bytes_ ||
+             output_bytes != example_output_bytes_) {
+    error_reporter_->Report(
+        "The examples of batch size %d don't match those of the other "
+        "interpreters.",
+        batch_size);
+    return kTfLiteError;
+  }
+
+  auto position = std::find_if(
+      interpreters_.begin(), interpreters_.end(),
+      [batch_size](const SizedInterpreter& sized) {
+        return sized.batch_size > batch_size;
+      });
+  interpreters_.insert(position, {batch_size, std::move(interpreter)});
+  return kTfLiteOk;
+}
+
+int BatchedInterpreter::max_batch_size() const {
+  return interpreters_.empty() ? 0 : interpreters_.back().batch_size;
+}
+
+TfLiteStatus BatchedInterpreter::InvokeOnce(const Example* const* examples,
+                                            int count) {
+  // The smallest interpreter that fits the examples.
+  SizedInterpreter* sized = &interpreters_.back();
+  for (SizedInterpreter& candidate : interpreters_) {
+    if (candidate.batch_size >= count) {
+      sized = &candidate;
+      break;
+    }
+  }
+  Interpreter* interpreter = sized->interpreter.get();
+  const std::vector<int>& inputs = interpreter->inputs();
+  const std::vector<int>& outputs = interpreter->outputs();
+  for (int e = 0; e < count; ++e) {
+    if (examples[e]->inputs.size() != inputs.size() ||
+        examples[e]->outputs.size() != outputs.size()) {
+      error_reporter_->Report(
+          "Examples need %d inputs and %d outputs, got %d and %d.",
+          static_cast<int>(inputs.size()), static_cast<int>(outputs.size()),
+          static_cast<int>(examples[e]->inputs.size()),
+          static_cast<int>(examples[e]->outputs.size()));
+      return kTfLiteError;
+    }
+  }
+
+  for (int i = 0; i < inputs.size(); ++i) {
+    char* data = interpreter->tensor(inputs[i])->data.raw;
+    const size_t bytes = example_input_bytes_[i];
+    for (int e = 0; e < count; ++e) {
+      std::memcpy(data + e * bytes, examples[e]->inputs[i], bytes);
+    }
+    // Zeros in the unused rows, so that they don't hold stale values that
+    // could be slow to compute with, such as denormals.
+    std::memset(data + count * bytes, 0, (sized->batch_size - count) * bytes);
+  }
+  if (interpreter->Invoke() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  for (int i = 0; i < outputs.size(); ++i) {
+    const char* data = interpreter->tensor(outputs[i])->data.raw;
+    const size_t bytes = example_output_bytes_[i];
+    for (int e = 0; e < count; ++e) {
+      std::memcpy(examples[e]->outputs[i], data + e * bytes, bytes);
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchedInterpreter::InvokeBatch(
+    const std::vector<Example>& examples) {
+  if (interpreters_.empty()) {
+    error_reporter_->Report("No interpreter was added.");
+    return kTfLiteError;
+  }
+  std::vector<const Example*> pointers;
+  pointers.reserve(examples.size());
+  for (const Example& example : examples) {
+    pointers.push_back(&example);
+  }
+  std::lock_guard<std::mutex> lock(invoke_mutex_);
+  const int max_batch = max_batch_size();
+  for (int start = 0; start < pointers.size(); start += max_batch) {
+    const int count =
+        std::min(max_batch, static_cast<int>(pointers.size()) - start);
+    TF_LITE_ENSURE_STATUS(InvokeOnce(pointers.data() + start, count));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchedInterpreter::Invoke(const Example& example) {
+  if (interpreters_.empty()) {
+    error_reporter_->Report("No interpreter was added.");
+    return kTfLiteError;
+  }
+  if (example.inputs.size() != example_input_bytes_.size() ||
+      example.outputs.size() != example_output_bytes_.size()) {
+    error_reporter_->Report("Examples need %d inputs and %d outputs.",
+                            static_cast<int>(example_input_bytes_.size()),
+                            static_cast<int>(example_output_bytes_.size()));
+    return kTfLiteError;
+  }
+  PendingExample pending;
+  pending.example = &example;
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  queue_.push_back(&pending);
+  while (!pending.done) {
+    if (batch_running_) {
+      queue_cond_.wait(queue_lock);
+      continue;
+    }
+    // This thread runs the examples queued so far, which may not include its
+    // own if more than a batch is waiting.
+    batch_running_ = true;
+    const int count =
+        std::min(max_batch_size(), static_cast<int>(queue_.size()));
+    std::vector<PendingExample*> batch(queue_.begin(), queue_.begin() + count);
+    queue_.erase(queue_.begin(), queue_.begin() + count);
+    queue_lock.unlock();
+
+    std::vector<const Example*> examples;
+    for (PendingExample* batch_pending : batch) {
+      examples.push_back(batch_pending->example);
+    }
+    TfLiteStatus status;
+    {
+      std::lock_guard<std::mutex> lock(invoke_mutex_);
+      status = InvokeOnce(examples.data(), count);
+    }
+
+    queue_lock.lock();
+    for (PendingExample* batch_pending : batch) {
+      batch_pending->status = status;
+      batch_pending->done = true;
+    }
+    batch_running_ = false;
+    queue_cond_.notify_all();
+  }
+  return pending.status;
+}
+
+}  // namespace tflite
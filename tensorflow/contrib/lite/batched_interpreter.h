@@ -0,0 +1,137 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Runs single-example requests on a model in batches, for servers with many
+// small concurrent requests.
+#ifndef TENSORFLOW_CONTRIB_LITE_BATCHED_INTERPRETER_H_
+#define TENSORFLOW_CONTRIB_LITE_BATCHED_INTERPRETER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tensorflow/contrib/lite/error_reporter.h"
+#include "tensorflow/contrib/lite/interpreter.h"
+#include "tensorflow/contrib/lite/model.h"
+
+namespace tflite {
+
+// Holds one interpreter per batch size, prepared once, and runs examples on
+// the smallest one that fits them, so that a model converted with batch 1
+// serves batches without resizing and re-preparing the graph on each call.
+// The batch dimension is the first dimension of every input and output.
+//
+// Example:
+//
+// auto batched = BatchedInterpreter::Create(*model, resolver, {1, 4, 16});
+// // On each request thread:
+// BatchedInterpreter::Example example;
+// example.inputs = {image};
+// example.outputs = {scores};
+// if (batched->Invoke(example) != kTfLiteOk) return error;
+//
+// Concurrent calls to Invoke() are coalesced into one batch while the
+// previous batch runs.
+class BatchedInterpreter {
+ public:
+  // The buffers of one example, in the order of Interpreter::inputs() and
+  // Interpreter::outputs(). Each has the size of the tensor divided by its
+  // batch size, see example_input_bytes() and example_output_bytes().
+  struct Example {
+    std::vector<const void*> inputs;
+    std::vector<void*> outputs;
+  };
+
+  // Ownership of 'error_reporter' remains with the caller.
+  explicit BatchedInterpreter(
+      ErrorReporter* error_reporter = DefaultErrorReporter());
+  ~BatchedInterpreter();
+
+  BatchedInterpreter(const BatchedInterpreter&) = delete;
+  BatchedInterpreter& operator=(const BatchedInterpreter&) = delete;
+
+  // Builds an interpreter for each of 'batch_sizes' from 'model'. Returns
+  // nullptr if one of them can't be built or batched.
+  static std::unique_ptr<BatchedInterpreter> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const std::vector<int>& batch_sizes,
+      ErrorReporter* error_reporter = DefaultErrorReporter());
+
+  // Resizes the first dimension of the inputs of 'interpreter' to
+  // 'batch_size' and allocates its tensors. Fails if an output doesn't get
+  // 'batch_size' as its first dimension, is a string or dynamic tensor, or if
+  // the examples don't have the size of those of the other interpreters.
+  // Must not be called concurrently with Invoke() or InvokeBatch().
+  TfLiteStatus AddInterpreter(std::unique_ptr<Interpreter> interpreter,
+                              int batch_size);
+
+  // Runs 'examples' with as few invokes as possible: the smallest interpreter
+  // that fits all of them is used, with the rows past the examples filled
+  // with zeros, and more examples than the largest batch size are split.
+  TfLiteStatus InvokeBatch(const std::vector<Example>& examples);
+
+  // Runs one example and blocks until its outputs are written. The examples
+  // of the threads that call Invoke() while a batch runs are coalesced into
+  // the next batch, by one of these threads. Thread safe.
+  TfLiteStatus Invoke(const Example& example);
+
+  // The largest batch size of the interpreters, or 0 if there are none.
+  int max_batch_size() const;
+
+  // The bytes of the 'i'th input or output of one example.
+  size_t example_input_bytes(int i) const { return example_input_bytes_[i]; }
+  size_t example_output_bytes(int i) const {
+    return example_output_bytes_[i];
+  }
+
+ private:
+  struct SizedInterpreter {
+    int batch_size;
+    std::unique_ptr<Interpreter> interpreter;
+  };
+
+  // An example waiting in Invoke().
+  struct PendingExample {
+    const Example* example;
+    TfLiteStatus status = kTfLiteOk;
+    bool done = false;
+  };
+
+  // Runs 'count' examples, at most max_batch_size(), in one invoke.
+  TfLiteStatus InvokeOnce(const Example* const* examples, int count);
+
+  ErrorReporter* error_reporter_;
+
+  // Sorted by increasing batch size.
+  std::vector<SizedInterpreter> interpreters_;
+  std::vector<size_t> example_input_bytes_;
+  std::vector<size_t> example_output_bytes_;
+
+  // Serializes the invokes of the interpreters.
+  std::mutex invoke_mutex_;
+
+  // The examples waiting in Invoke(), and whether one of the waiting threads
+  // is running a batch.
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::deque<PendingExample*> queue_;
+  bool batch_running_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_BATCHED_INTERPRETER_H_
@@ -0,0 +1,167 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/batched_interpreter.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kExampleSize = 2;
+
+// An op that doubles its float input.
+TfLiteRegistration* GetDoubleRegistration() {
+  static TfLiteRegistration registration = {
+      nullptr, nullptr,
+      [](TfLiteContext* context, TfLiteNode* node) {
+        const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+        TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+        return context->ResizeTensor(context, output,
+                                     TfLiteIntArrayCopy(input->dims));
+      },
+      [](TfLiteContext* context, TfLiteNode* node) {
+        const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+        TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+        for (int i = 0; i < input->bytes / sizeof(float); ++i) {
+          output->data.f[i] = 2 * input->data.f[i];
+        }
+        return kTfLiteOk;
+      }};
+  return &registration;
+}
+
+// An interpreter running the double op on a [1, kExampleSize] input.
+std::unique_ptr<Interpreter> MakeInterpreter() {
+  std::unique_ptr<Interpreter> interpreter(new Interpreter);
+  interpreter->AddTensors(2);
+  interpreter->SetInputs({0});
+  interpreter->SetOutputs({1});
+  TfLiteQuantizationParams quant;
+  interpreter->SetTensorParametersReadWrite(0, kTfLiteFloat32, "in",
+                                            {1, kExampleSize}, quant);
+  interpreter->SetTensorParametersReadWrite(1, kTfLiteFloat32, "out",
+                                            {1, kExampleSize}, quant);
+  interpreter->AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                     GetDoubleRegistration());
+  return interpreter;
+}
+
+struct TestExample {
+  explicit TestExample(float value)
+      : input(kExampleSize, value), output(kExampleSize, 0.0f) {
+    example.inputs = {input.data()};
+    example.outputs = {output.data()};
+  }
+
+  std::vector<float> input;
+  std::vector<float> output;
+  BatchedInterpreter::Example example;
+};
+
+TEST(BatchedInterpreter, AddInterpreter) {
+  BatchedInterpreter batched;
+  EXPECT_EQ(batched.max_batch_size(), 0);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 4), kTfLiteOk);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 1), kTfLiteOk);
+  EXPECT_EQ(batched.max_batch_size(), 4);
+  EXPECT_EQ(batched.example_input_bytes(0), kExampleSize * sizeof(float));
+  EXPECT_EQ(batched.example_output_bytes(0), kExampleSize * sizeof(float));
+
+  EXPECT_NE(batched.AddInterpreter(MakeInterpreter(), 4), kTfLiteOk);
+  EXPECT_NE(batched.AddInterpreter(MakeInterpreter(), 0), kTfLiteOk);
+  EXPECT_NE(batched.AddInterpreter(nullptr, 2), kTfLiteOk);
+}
+
+TEST(BatchedInterpreter, RejectsDifferentExamples) {
+  BatchedInterpreter batched;
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 1), kTfLiteOk);
+  std::unique_ptr<Interpreter> other = MakeInterpreter();
+  ASSERT_EQ(other->ResizeInputTensor(0, {1, kExampleSize + 1}), kTfLiteOk);
+  EXPECT_NE(batched.AddInterpreter(std::move(other), 2), kTfLiteOk);
+}
+
+TEST(BatchedInterpreter, InvokeBatch) {
+  BatchedInterpreter batched;
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 1), kTfLiteOk);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 4), kTfLiteOk);
+
+  // Five examples run as a batch of four and a batch of one, and three as a
+  // padded batch of four.
+  for (int num_examples : {5, 3, 1}) {
+    std::vector<std::unique_ptr<TestExample>> test_examples;
+    std::vector<BatchedInterpreter::Example> examples;
+    for (int e = 0; e < num_examples; ++e) {
+      test_examples.emplace_back(new TestExample(e + 1));
+      examples.push_back(test_examples.back()->example);
+    }
+    ASSERT_EQ(batched.InvokeBatch(examples), kTfLiteOk);
+    for (int e = 0; e < num_examples; ++e) {
+      for (float value : test_examples[e]->output) {
+        EXPECT_EQ(value, 2.0f * (e + 1));
+      }
+    }
+  }
+}
+
+TEST(BatchedInterpreter, InvokeRejectsBadExample) {
+  BatchedInterpreter batched;
+  BatchedInterpreter::Example example;
+  EXPECT_NE(batched.Invoke(example), kTfLiteOk);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 1), kTfLiteOk);
+  EXPECT_NE(batched.Invoke(example), kTfLiteOk);
+}
+
+TEST(BatchedInterpreter, ConcurrentInvokes) {
+  BatchedInterpreter batched;
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 1), kTfLiteOk);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 2), kTfLiteOk);
+  ASSERT_EQ(batched.AddInterpreter(MakeInterpreter(), 8), kTfLiteOk);
+
+  constexpr int kNumThreads = 16;
+  constexpr int kNumInvokes = 50;
+  std::vector<int> failures(kNumThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&batched, &failures, t]() {
+      for (int i = 0; i < kNumInvokes; ++i) {
+        TestExample test_example(t * kNumInvokes + i);
+        if (batched.Invoke(test_example.example) != kTfLiteOk ||
+            test_example.output[0] != 2.0f * (t * kNumInvokes + i) ||
+            test_example.output[1] != 2.0f * (t * kNumInvokes + i)) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kNumThreads; ++t) {
+    EXPECT_EQ(failures[t], 0) << "thread " << t;
+  }
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
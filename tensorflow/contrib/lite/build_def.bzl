@@ -324,21 +324,53 @@ def gen_zipped_test_file(name, file):
         srcs = [file],
     )
 
-def gen_selected_ops(name, model):
+def gen_selected_ops(name, model = None, models = []):
     """Generate the library that includes only used ops.
 
     Args:
       name: Name of the generated library.
       model: TFLite model to interpret.
+      models: TFLite models to interpret, in addition to `model`. The ops of
+        all of them are registered, up to the highest version they use.
     """
     out = name + "_registration.cc"
     tool = "//tensorflow/contrib/lite/tools:generate_op_registrations"
     tflite_path = "//tensorflow/contrib/lite"
+    all_models = ([model] if model else []) + models
     native.genrule(
         name = name,
-        srcs = [model],
+        srcs = all_models,
         outs = [out],
-        cmd = ("$(location %s) --input_model=$(location %s) --output_registration=$(location %s) --tflite_path=%s") %
-              (tool, model, out, tflite_path[2:]),
+        cmd = ("$(location %s) --input_models=%s --output_registration=$(location %s) --tflite_path=%s") %
+              (tool, ",".join(["$(location %s)" % m for m in all_models]), out, tflite_path[2:]),
         tools = [tool],
     )
+
+def tflite_selected_ops_library(name, models, **kwargs):
+    """Generate a library registering only the kernels that models use.
+
+    The library defines `void RegisterSelectedOps(MutableOpResolver*)`, to be
+    used instead of BuiltinOpResolver. Since it doesn't depend on
+    kernels/register.cc, the kernels, and the Eigen and gemmlowp code paths,
+    that the models don't use are left out of binaries linking it.
+
+    Args:
+      name: Name of the cc_library.
+      models: TFLite models to interpret.
+      **kwargs: Passed to the cc_library, e.g. visibility.
+    """
+    gen_selected_ops(name = name + "_registration", models = models)
+    native.cc_library(
+        name = name,
+        srcs = [":" + name + "_registration"],
+        copts = tflite_copts(),
+        linkopts = select({
+            "//tensorflow:darwin": ["-Wl,-dead_strip"],
+            "//conditions:default": ["-Wl,--gc-sections"],
+        }),
+        deps = [
+            "//tensorflow/contrib/lite:framework",
+            "//tensorflow/contrib/lite/kernels:builtin_op_kernels",
+        ],
+        **kwargs
+    )
@@ -49,13 +49,24 @@ typedef enum {
   kTfLiteActSigmoid,
 } TfLiteFusedActivation;
 
+typedef enum {
+  kTfLiteConvFilterFormatDefault = 0,
+  kTfLiteConvFilterFormatHwio = 1,
+  // A float 1x1 filter with sparse data, see TfLiteSparsity.
+  kTfLiteConvFilterFormatBlockSparse = 2,
+} TfLiteConvFilterFormat;
+
 typedef struct {
+  // Parameters for Conv2D version 1 or above.
   TfLitePadding padding;
   int stride_width;
   int stride_height;
   int dilation_width_factor;
   int dilation_height_factor;
   TfLiteFusedActivation activation;
+
+  // Parameters for Conv2D version 2 or above.
+  TfLiteConvFilterFormat filter_format;
 } TfLiteConvParams;
 
 typedef struct {
@@ -95,6 +106,8 @@ typedef struct {
 typedef enum {
   kTfLiteFullyConnectedWeightsFormatDefault = 0,
   kTfLiteFullyConnectedWeightsFormatShuffled4x16Int8 = 1,
+  // Float weights with sparse data, see TfLiteSparsity.
+  kTfLiteFullyConnectedWeightsFormatBlockSparse = 2,
 } TfLiteFullyConnectedWeightsFormat;
 
 typedef struct {
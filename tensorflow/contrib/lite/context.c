@@ -60,6 +60,29 @@ TfLiteIntArray* TfLiteIntArrayCopy(TfLiteIntArray* src) {
 
 void TfLiteIntArrayFree(TfLiteIntArray* a) { free(a); }
 
+TfLiteFloatArray* TfLiteFloatArrayCreate(int size) {
+  TfLiteFloatArray* ret = (TfLiteFloatArray*)malloc(
+      sizeof(TfLiteFloatArray) + sizeof(float) * size);
+  ret->size = size;
+  return ret;
+}
+
+void TfLiteFloatArrayFree(TfLiteFloatArray* a) { free(a); }
+
+void TfLiteAffineQuantizationFree(TfLiteAffineQuantization* quantization) {
+  if (!quantization) return;
+  if (quantization->scale) TfLiteFloatArrayFree(quantization->scale);
+  if (quantization->zero_point) TfLiteIntArrayFree(quantization->zero_point);
+  free(quantization);
+}
+
+void TfLiteSparsityFree(TfLiteSparsity* sparsity) {
+  if (!sparsity) return;
+  if (sparsity->row_segments) TfLiteIntArrayFree(sparsity->row_segments);
+  if (sparsity->block_indices) TfLiteIntArrayFree(sparsity->block_indices);
+  free(sparsity);
+}
+
 void TfLiteTensorDataFree(TfLiteTensor* t) {
   if (t->allocation_type == kTfLiteDynamic && t->data.raw) {
     free(t->data.raw);
@@ -71,6 +94,10 @@ void TfLiteTensorFree(TfLiteTensor* t) {
   TfLiteTensorDataFree(t);
   if (t->dims) TfLiteIntArrayFree(t->dims);
   t->dims = NULL;
+  TfLiteAffineQuantizationFree(t->quantization);
+  t->quantization = NULL;
+  TfLiteSparsityFree(t->sparsity);
+  t->sparsity = NULL;
 }
 
 void TfLiteTensorReset(TfLiteType type, const char* name, TfLiteIntArray* dims,
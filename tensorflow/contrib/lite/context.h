@@ -100,6 +100,26 @@ TfLiteIntArray* TfLiteIntArrayCopy(TfLiteIntArray* src);
 // Free memory of array `v`.
 void TfLiteIntArrayFree(TfLiteIntArray* v);
 
+// Fixed size list of floats. Used for per-channel quantization.
+typedef struct {
+  int size;
+// gcc 6.1+ have a bug where flexible members aren't properly handled
+// https://github.com/google/re2/commit/b94b7cd42e9f02673cd748c1ac1d16db4052514c
+#if !defined(__clang__) && defined(__GNUC__) && __GNUC__ == 6 && \
+    __GNUC_MINOR__ >= 1
+  float data[0];
+#else
+  float data[];
+#endif
+} TfLiteFloatArray;
+
+// Create a array of a given `size` (uninitialized entries).
+// This returns a pointer, that you must free using TfLiteFloatArrayFree().
+TfLiteFloatArray* TfLiteFloatArrayCreate(int size);
+
+// Free memory of array `a`.
+void TfLiteFloatArrayFree(TfLiteFloatArray* a);
+
 // Since we must not depend on any libraries, define a minimal subset of
 // error macros while avoiding names that have pre-conceived meanings like
 // assert and check.
@@ -163,6 +183,7 @@ typedef enum {
   kTfLiteBool = 6,
   kTfLiteInt16 = 7,
   kTfLiteComplex64 = 8,
+  kTfLiteInt8 = 9,
 } TfLiteType;
 
 // Parameters for asymmetric quantization. Quantized values can be converted
@@ -173,6 +194,35 @@ typedef struct {
   int32_t zero_point;
 } TfLiteQuantizationParams;
 
+// Parameters for per-channel asymmetric quantization. The quantized values at
+// index i along dimension `quantized_dimension` can be converted back to float
+// using:
+//    real_value = scale->data[i] * (quantized_value - zero_point->data[i]);
+typedef struct {
+  TfLiteFloatArray* scale;
+  TfLiteIntArray* zero_point;
+  int32_t quantized_dimension;
+} TfLiteAffineQuantization;
+
+// Free memory of `quantization` and of its arrays.
+void TfLiteAffineQuantizationFree(TfLiteAffineQuantization* quantization);
+
+// Block compressed sparse row encoding of the values of a constant tensor,
+// seen as a matrix of shape [dims->data[0], product of the other dims]. The
+// rows are divided into blocks of `block_size` consecutive values, and the
+// tensor data holds only the blocks with a nonzero value, one row after the
+// other. The blocks of row r are those from index row_segments->data[r] up to
+// row_segments->data[r + 1], and block_indices->data[i] is the column of block
+// i divided by `block_size`.
+typedef struct {
+  int block_size;
+  TfLiteIntArray* row_segments;
+  TfLiteIntArray* block_indices;
+} TfLiteSparsity;
+
+// Free memory of `sparsity` and of its arrays.
+void TfLiteSparsityFree(TfLiteSparsity* sparsity);
+
 // A union of pointers that points to memory for a given tensor.
 typedef union {
   int* i32;
@@ -181,6 +231,7 @@ typedef union {
   char* raw;
   const char* raw_const;
   uint8_t* uint8;
+  int8_t* int8;
   bool* b;
   int16_t* i16;
 #if defined(_MSC_VER)
@@ -257,6 +308,17 @@ typedef struct {
 
   // True if the tensor is a variable.
   bool is_variable;
+
+  // Per-channel quantization information, or NULL if `params` applies to the
+  // whole tensor. Owned by the tensor, and freed by TfLiteTensorFree().
+  // WARNING: This is an experimental interface that is subject to change.
+  TfLiteAffineQuantization* quantization;
+
+  // Sparse encoding of the data of a constant tensor, or NULL if the data is
+  // dense. Only the kernels documented to accept sparse inputs can read the
+  // data of such tensors. Owned by the tensor, and freed by TfLiteTensorFree().
+  // WARNING: This is an experimental interface that is subject to change.
+  TfLiteSparsity* sparsity;
 } TfLiteTensor;
 
 // Free data memory of tensor `t`;
@@ -375,6 +437,13 @@ typedef struct TfLiteContext {
   // WARNING: This is an experimental interface that is subject to change.
   void (*SetExternalContext)(struct TfLiteContext*, TfLiteExternalContextType,
                              TfLiteExternalContext*);
+
+  // Whether kernels may keep the weights they transform, e.g. transpose to
+  // the layout they read, in persistent tensors so that constant weights are
+  // transformed once rather than at every invocation. When false, kernels
+  // transform them into temporaries of the arena instead, saving memory.
+  // WARNING: This is an experimental interface that is subject to change.
+  bool cache_transformed_weights;
 } TfLiteContext;
 
 typedef struct _TfLiteRegistration {
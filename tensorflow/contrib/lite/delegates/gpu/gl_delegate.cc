@@ -0,0 +1,856 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/delegates/gpu/gl_delegate.h"
+
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/builtin_op_data.h"
+#include "tensorflow/contrib/lite/builtin_ops.h"
+#include "tensorflow/contrib/lite/context_util.h"
+#include "tensorflow/contrib/lite/kernels/kernel_util.h"
+#include "tensorflow/contrib/lite/kernels/padding.h"
+
+namespace tflite {
+namespace {
+
+// Invocations per work group of every shader.
+constexpr int kWorkGroupSize = 64;
+// The maximum number of work groups per dimension guaranteed by OpenGL ES.
+constexpr int kMaxWorkGroupCount = 65535;
+
+// State of a delegate returned by NewGlDelegate().
+struct GlDelegateData {
+  // The shader storage buffers bound with BindGlBufferToTensor(), indexed by
+  // TfLiteBufferHandle. Freed handles hold 0.
+  std::vector<GLuint> buffers;
+};
+
+GlDelegateData* GetDelegateData(TfLiteDelegate* delegate) {
+  return reinterpret_cast<GlDelegateData*>(delegate->data_);
+}
+
+// Whether the current thread has an OpenGL ES context running compute shaders.
+bool HasGlComputeContext() {
+  if (glGetString(GL_VERSION) == nullptr) return false;
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  return major > 3 || (major == 3 && minor >= 1);
+}
+
+// Writes 'value' exactly, as GLSL literals would round it.
+std::string FloatLiteral(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return "uintBitsToFloat(" + std::to_string(bits) + "u)";
+}
+
+std::string IntConstant(const char* name, int value) {
+  return std::string("const int ") + name + " = " + std::to_string(value) +
+         ";\n";
+}
+
+// The GLSL function applying a fused activation.
+std::string ActivationFunction(TfLiteFusedActivation activation) {
+  std::string body;
+  switch (activation) {
+    case kTfLiteActRelu:
+      body = "max(value, 0.0)";
+      break;
+    case kTfLiteActRelu1:
+      body = "clamp(value, -1.0, 1.0)";
+      break;
+    case kTfLiteActRelu6:
+      body = "clamp(value, 0.0, 6.0)";
+      break;
+    default:
+      body = "value";
+      break;
+  }
+  return "float Activation(float value) { return " + body + "; }\n";
+}
+
+bool IsActivationSupported(TfLiteFusedActivation activation) {
+  return activation == kTfLiteActNone || activation == kTfLiteActRelu ||
+         activation == kTfLiteActRelu1 || activation == kTfLiteActRelu6;
+}
+
+// The beginning of every shader: its output is the float array 'output_data',
+// its inputs 'input0_data', 'input1_data', ... and GetIndex() returns the
+// index of the invocation.
+std::string ShaderHeader(int num_inputs) {
+  std::string source =
+      "#version 310 es\n"
+      "precision highp float;\n"
+      "layout(local_size_x = " +
+      std::to_string(kWorkGroupSize) +
+      ") in;\n"
+      "layout(std430, binding = 0) writeonly buffer Output {\n"
+      "  float output_data[];\n"
+      "};\n";
+  for (int i = 0; i < num_inputs; ++i) {
+    const std::string n = std::to_string(i);
+    source += "layout(std430, binding = " + std::to_string(i + 1) +
+              ") readonly buffer Input" + n + " {\n  float input" + n +
+              "_data[];\n};\n";
+  }
+  source +=
+      "int GetIndex() {\n"
+      "  return int(gl_GlobalInvocationID.y * gl_NumWorkGroups.x *\n"
+      "             gl_WorkGroupSize.x + gl_GlobalInvocationID.x);\n"
+      "}\n";
+  return source;
+}
+
+// The shader body of an op computing 'size' values. 'body' sets 'result'
+// from 'index'.
+std::string ElementwiseMain(int size, const std::string& body) {
+  return IntConstant("SIZE", size) +
+         "void main() {\n"
+         "  int index = GetIndex();\n"
+         "  if (index >= SIZE) return;\n" +
+         body + "}\n";
+}
+
+// Declares the coordinates of 'index' in a NHWC output.
+std::string OutputCoordinates() {
+  return "  int d = index % OUTPUT_DEPTH;\n"
+         "  int x = (index / OUTPUT_DEPTH) % OUTPUT_WIDTH;\n"
+         "  int y = (index / (OUTPUT_DEPTH * OUTPUT_WIDTH)) % OUTPUT_HEIGHT;\n"
+         "  int b = index / (OUTPUT_DEPTH * OUTPUT_WIDTH * OUTPUT_HEIGHT);\n";
+}
+
+// Declares the sizes of the NHWC input and output of a node.
+std::string ImageSizes(const TfLiteTensor* input, const TfLiteTensor* output) {
+  return IntConstant("INPUT_HEIGHT", SizeOfDimension(input, 1)) +
+         IntConstant("INPUT_WIDTH", SizeOfDimension(input, 2)) +
+         IntConstant("INPUT_DEPTH", SizeOfDimension(input, 3)) +
+         IntConstant("OUTPUT_HEIGHT", SizeOfDimension(output, 1)) +
+         IntConstant("OUTPUT_WIDTH", SizeOfDimension(output, 2)) +
+         IntConstant("OUTPUT_DEPTH", SizeOfDimension(output, 3));
+}
+
+// One run of a compute shader.
+struct GlDispatch {
+  std::string source;
+  GLuint program = 0;
+  // The tensor written by the shader, then the tensors it reads.
+  std::vector<int> tensors;
+  // The number of invocations.
+  int size = 0;
+};
+
+// Whether every input and output of 'node' is a float32 tensor of 'rank'
+// dimensions, or of any rank if 'rank' is 0.
+bool HasFloatTensors(const TfLiteContext* context, const TfLiteNode* node,
+                     int rank) {
+  for (const TfLiteIntArray* tensors : {node->inputs, node->outputs}) {
+    for (int tensor_index : TfLiteIntArrayView(tensors)) {
+      if (tensor_index == kOptionalTensor) continue;
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      if (tensor.type != kTfLiteFloat32) return false;
+      if (rank != 0 && tensor.dims->size != rank) return false;
+    }
+  }
+  return true;
+}
+
+bool IsNodeSupported(const TfLiteContext* context, const TfLiteNode* node,
+                     const TfLiteRegistration* registration) {
+  if (registration->version != 1 || node->outputs->size != 1) return false;
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinConv2d: {
+      auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
+      return node->inputs->size == 3 && HasFloatTensors(context, node, 0) &&
+             IsActivationSupported(params->activation);
+    }
+    case kTfLiteBuiltinDepthwiseConv2d: {
+      auto* params =
+          reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data);
+      return HasFloatTensors(context, node, 0) &&
+             IsActivationSupported(params->activation);
+    }
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinMaxPool2d: {
+      auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+      return HasFloatTensors(context, node, 4) &&
+             IsActivationSupported(params->activation);
+    }
+    case kTfLiteBuiltinAdd: {
+      auto* params = reinterpret_cast<TfLiteAddParams*>(node->builtin_data);
+      // Broadcasting adds are left to the CPU.
+      return node->inputs->size == 2 && HasFloatTensors(context, node, 0) &&
+             HaveSameShapes(&context->tensors[node->inputs->data[0]],
+                            &context->tensors[node->inputs->data[1]]) &&
+             IsActivationSupported(params->activation);
+    }
+    case kTfLiteBuiltinConcatenation: {
+      auto* params =
+          reinterpret_cast<TfLiteConcatenationParams*>(node->builtin_data);
+      return HasFloatTensors(context, node, 0) &&
+             params->activation == kTfLiteActNone;
+    }
+    case kTfLiteBuiltinResizeBilinear:
+      // The size input is an int32 tensor, which only sets the output shape.
+      return node->inputs->size == 2 &&
+             context->tensors[node->inputs->data[0]].type == kTfLiteFloat32 &&
+             context->tensors[node->inputs->data[0]].dims->size == 4 &&
+             context->tensors[node->outputs->data[0]].type == kTfLiteFloat32;
+    case kTfLiteBuiltinSoftmax:
+      return HasFloatTensors(context, node, 0);
+    default:
+      return false;
+  }
+}
+
+void AddConvDispatch(TfLiteContext* context, TfLiteNode* node,
+                     std::vector<GlDispatch>* dispatches) {
+  auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  const TfLiteTensor* filter = GetInput(context, node, 1);
+  const TfLiteTensor* output = GetOutput(context, node, 0);
+  const int filter_height = SizeOfDimension(filter, 1);
+  const int filter_width = SizeOfDimension(filter, 2);
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0],
+                      node->inputs->data[1], node->inputs->data[2]};
+  dispatch.size = NumElements(output);
+  // Filters are [output_depth, filter_height, filter_width, input_depth].
+  dispatch.source =
+      ShaderHeader(3) + ActivationFunction(params->activation) +
+      ImageSizes(input, output) +
+      IntConstant("FILTER_HEIGHT", filter_height) +
+      IntConstant("FILTER_WIDTH", filter_width) +
+      IntConstant("STRIDE_HEIGHT", params->stride_height) +
+      IntConstant("STRIDE_WIDTH", params->stride_width) +
+      IntConstant("DILATION_HEIGHT", params->dilation_height_factor) +
+      IntConstant("DILATION_WIDTH", params->dilation_width_factor) +
+      IntConstant("PADDING_HEIGHT",
+                  ComputePadding(params->stride_height,
+                                 params->dilation_height_factor,
+                                 SizeOfDimension(input, 1), filter_height,
+                                 SizeOfDimension(output, 1))) +
+      IntConstant("PADDING_WIDTH",
+                  ComputePadding(params->stride_width,
+                                 params->dilation_width_factor,
+                                 SizeOfDimension(input, 2), filter_width,
+                                 SizeOfDimension(output, 2))) +
+      ElementwiseMain(
+          dispatch.size,
+          OutputCoordinates() +
+              "  float result = input2_data[d];\n"
+              "  for (int fy = 0; fy < FILTER_HEIGHT; ++fy) {\n"
+              "    int in_y = y * STRIDE_HEIGHT - PADDING_HEIGHT +\n"
+              "               fy * DILATION_HEIGHT;\n"
+              "    if (in_y < 0 || in_y >= INPUT_HEIGHT) continue;\n"
+              "    for (int fx = 0; fx < FILTER_WIDTH; ++fx) {\n"
+              "      int in_x = x * STRIDE_WIDTH - PADDING_WIDTH +\n"
+              "                 fx * DILATION_WIDTH;\n"
+              "      if (in_x < 0 || in_x >= INPUT_WIDTH) continue;\n"
+              "      int input_offset =\n"
+              "          ((b * INPUT_HEIGHT + in_y) * INPUT_WIDTH + in_x) *\n"
+              "          INPUT_DEPTH;\n"
+              "      int filter_offset =\n"
+              "          ((d * FILTER_HEIGHT + fy) * FILTER_WIDTH + fx) *\n"
+              "          INPUT_DEPTH;\n"
+              "      for (int c = 0; c < INPUT_DEPTH; ++c) {\n"
+              "        result += input0_data[input_offset + c] *\n"
+              "                  input1_data[filter_offset + c];\n"
+              "      }\n"
+              "    }\n"
+              "  }\n"
+              "  output_data[index] = Activation(result);\n");
+  dispatches->push_back(dispatch);
+}
+
+void AddDepthwiseConvDispatch(TfLiteContext* context, TfLiteNode* node,
+                              std::vector<GlDispatch>* dispatches) {
+  auto* params =
+      reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data);
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  const TfLiteTensor* filter = GetInput(context, node, 1);
+  const TfLiteTensor* output = GetOutput(context, node, 0);
+  const bool has_bias = NumInputs(node) == 3;
+  const int filter_height = SizeOfDimension(filter, 1);
+  const int filter_width = SizeOfDimension(filter, 2);
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0],
+                      node->inputs->data[1]};
+  if (has_bias) dispatch.tensors.push_back(node->inputs->data[2]);
+  dispatch.size = NumElements(output);
+  // Filters are [1, filter_height, filter_width, output_depth].
+  dispatch.source =
+      ShaderHeader(has_bias ? 3 : 2) + ActivationFunction(params->activation) +
+      ImageSizes(input, output) +
+      IntConstant("FILTER_HEIGHT", filter_height) +
+      IntConstant("FILTER_WIDTH", filter_width) +
+      IntConstant("STRIDE_HEIGHT", params->stride_height) +
+      IntConstant("STRIDE_WIDTH", params->stride_width) +
+      IntConstant("DEPTH_MULTIPLIER", params->depth_multiplier) +
+      IntConstant("PADDING_HEIGHT",
+                  ComputePadding(params->stride_height, 1,
+                                 SizeOfDimension(input, 1), filter_height,
+                                 SizeOfDimension(output, 1))) +
+      IntConstant("PADDING_WIDTH",
+                  ComputePadding(params->stride_width, 1,
+                                 SizeOfDimension(input, 2), filter_width,
+                                 SizeOfDimension(output, 2))) +
+      ElementwiseMain(
+          dispatch.size,
+          OutputCoordinates() +
+              (has_bias ? "  float result = input2_data[d];\n"
+                        : "  float result = 0.0;\n") +
+              "  int c = d / DEPTH_MULTIPLIER;\n"
+              "  for (int fy = 0; fy < FILTER_HEIGHT; ++fy) {\n"
+              "    int in_y = y * STRIDE_HEIGHT - PADDING_HEIGHT + fy;\n"
+              "    if (in_y < 0 || in_y >= INPUT_HEIGHT) continue;\n"
+              "    for (int fx = 0; fx < FILTER_WIDTH; ++fx) {\n"
+              "      int in_x = x * STRIDE_WIDTH - PADDING_WIDTH + fx;\n"
+              "      if (in_x < 0 || in_x >= INPUT_WIDTH) continue;\n"
+              "      result += input0_data[((b * INPUT_HEIGHT + in_y) *\n"
+              "                             INPUT_WIDTH + in_x) *\n"
+              "                            INPUT_DEPTH + c] *\n"
+              "                input1_data[(fy * FILTER_WIDTH + fx) *\n"
+              "                            OUTPUT_DEPTH + d];\n"
+              "    }\n"
+              "  }\n"
+              "  output_data[index] = Activation(result);\n");
+  dispatches->push_back(dispatch);
+}
+
+void AddPoolDispatch(TfLiteContext* context, TfLiteNode* node,
+                     bool average, std::vector<GlDispatch>* dispatches) {
+  auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  const TfLiteTensor* output = GetOutput(context, node, 0);
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0]};
+  dispatch.size = NumElements(output);
+  // As on the CPU, averages only count the values within the input.
+  const std::string accumulate = average
+                                     ? "      result += value;\n"
+                                       "      ++count;\n"
+                                     : "      result = max(result, value);\n";
+  const std::string result =
+      average ? "float(result) / float(count)" : "result";
+  dispatch.source =
+      ShaderHeader(1) + ActivationFunction(params->activation) +
+      ImageSizes(input, output) +
+      IntConstant("FILTER_HEIGHT", params->filter_height) +
+      IntConstant("FILTER_WIDTH", params->filter_width) +
+      IntConstant("STRIDE_HEIGHT", params->stride_height) +
+      IntConstant("STRIDE_WIDTH", params->stride_width) +
+      IntConstant("PADDING_HEIGHT",
+                  ComputePadding(params->stride_height, 1,
+                                 SizeOfDimension(input, 1),
+                                 params->filter_height,
+                                 SizeOfDimension(output, 1))) +
+      IntConstant("PADDING_WIDTH",
+                  ComputePadding(params->stride_width, 1,
+                                 SizeOfDimension(input, 2),
+                                 params->filter_width,
+                                 SizeOfDimension(output, 2))) +
+      ElementwiseMain(
+          dispatch.size,
+          OutputCoordinates() +
+              (average ? "  float result = 0.0;\n  int count = 0;\n"
+                       : "  float result = -3.402823466e+38;\n") +
+              "  for (int fy = 0; fy < FILTER_HEIGHT; ++fy) {\n"
+              "    int in_y = y * STRIDE_HEIGHT - PADDING_HEIGHT + fy;\n"
+              "    if (in_y < 0 || in_y >= INPUT_HEIGHT) continue;\n"
+              "    for (int fx = 0; fx < FILTER_WIDTH; ++fx) {\n"
+              "      int in_x = x * STRIDE_WIDTH - PADDING_WIDTH + fx;\n"
+              "      if (in_x < 0 || in_x >= INPUT_WIDTH) continue;\n"
+              "      float value = input0_data[((b * INPUT_HEIGHT + in_y) *\n"
+              "                                 INPUT_WIDTH + in_x) *\n"
+              "                                INPUT_DEPTH + d];\n" +
+              accumulate +
+              "    }\n"
+              "  }\n"
+              "  output_data[index] = Activation(" +
+              result + ");\n");
+  dispatches->push_back(dispatch);
+}
+
+void AddAddDispatch(TfLiteContext* context, TfLiteNode* node,
+                    std::vector<GlDispatch>* dispatches) {
+  auto* params = reinterpret_cast<TfLiteAddParams*>(node->builtin_data);
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0],
+                      node->inputs->data[1]};
+  dispatch.size = NumElements(GetOutput(context, node, 0));
+  dispatch.source =
+      ShaderHeader(2) + ActivationFunction(params->activation) +
+      ElementwiseMain(dispatch.size,
+                      "  output_data[index] =\n"
+                      "      Activation(input0_data[index] + "
+                      "input1_data[index]);\n");
+  dispatches->push_back(dispatch);
+}
+
+// Each input is copied to its slice of the output by its own dispatch.
+void AddConcatenationDispatches(TfLiteContext* context, TfLiteNode* node,
+                                std::vector<GlDispatch>* dispatches) {
+  auto* params =
+      reinterpret_cast<TfLiteConcatenationParams*>(node->builtin_data);
+  const TfLiteTensor* output = GetOutput(context, node, 0);
+  const int axis =
+      params->axis < 0 ? params->axis + NumDimensions(output) : params->axis;
+  int outer_size = 1;
+  for (int i = 0; i < axis; ++i) {
+    outer_size *= SizeOfDimension(output, i);
+  }
+  const int output_stride = NumElements(output) / outer_size;
+  int offset = 0;
+  for (int i = 0; i < NumInputs(node); ++i) {
+    const TfLiteTensor* input = GetInput(context, node, i);
+    const int copy_size = NumElements(input) / outer_size;
+    GlDispatch dispatch;
+    dispatch.tensors = {node->outputs->data[0], node->inputs->data[i]};
+    dispatch.size = NumElements(input);
+    dispatch.source =
+        ShaderHeader(1) + IntConstant("COPY_SIZE", copy_size) +
+        IntConstant("OUTPUT_STRIDE", output_stride) +
+        IntConstant("OFFSET", offset) +
+        ElementwiseMain(dispatch.size,
+                        "  output_data[(index / COPY_SIZE) * OUTPUT_STRIDE +\n"
+                        "              OFFSET + index % COPY_SIZE] =\n"
+                        "      input0_data[index];\n");
+    dispatches->push_back(dispatch);
+    offset += copy_size;
+  }
+}
+
+void AddResizeBilinearDispatch(TfLiteContext* context, TfLiteNode* node,
+                               std::vector<GlDispatch>* dispatches) {
+  auto* params =
+      reinterpret_cast<TfLiteResizeBilinearParams*>(node->builtin_data);
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  const TfLiteTensor* output = GetOutput(context, node, 0);
+  // Matches the scales of reference_ops::ResizeBilinear().
+  auto scale = [params](int input_size, int output_size) {
+    if (params->align_corners && output_size > 1) {
+      return static_cast<float>(input_size - 1) / (output_size - 1);
+    }
+    return static_cast<float>(input_size) / output_size;
+  };
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0]};
+  dispatch.size = NumElements(output);
+  dispatch.source =
+      ShaderHeader(1) + ImageSizes(input, output) +
+      "const float HEIGHT_SCALE = " +
+      FloatLiteral(scale(SizeOfDimension(input, 1),
+                         SizeOfDimension(output, 1))) +
+      ";\n"
+      "const float WIDTH_SCALE = " +
+      FloatLiteral(scale(SizeOfDimension(input, 2),
+                         SizeOfDimension(output, 2))) +
+      ";\n"
+      "float Input(int b, int y, int x, int d) {\n"
+      "  return input0_data[((b * INPUT_HEIGHT + y) * INPUT_WIDTH + x) *\n"
+      "                     INPUT_DEPTH + d];\n"
+      "}\n" +
+      ElementwiseMain(
+          dispatch.size,
+          OutputCoordinates() +
+              "  float in_y = float(y) * HEIGHT_SCALE;\n"
+              "  int y0 = int(floor(in_y));\n"
+              "  int y1 = min(y0 + 1, INPUT_HEIGHT - 1);\n"
+              "  float in_x = float(x) * WIDTH_SCALE;\n"
+              "  int x0 = int(floor(in_x));\n"
+              "  int x1 = min(x0 + 1, INPUT_WIDTH - 1);\n"
+              "  float dy = in_y - float(y0);\n"
+              "  float dx = in_x - float(x0);\n"
+              "  output_data[index] =\n"
+              "      Input(b, y0, x0, d) * (1.0 - dy) * (1.0 - dx) +\n"
+              "      Input(b, y1, x0, d) * dy * (1.0 - dx) +\n"
+              "      Input(b, y0, x1, d) * (1.0 - dy) * dx +\n"
+              "      Input(b, y1, x1, d) * dy * dx;\n");
+  dispatches->push_back(dispatch);
+}
+
+// One invocation per row, i.e. per set of values along the last dimension.
+void AddSoftmaxDispatch(TfLiteContext* context, TfLiteNode* node,
+                        std::vector<GlDispatch>* dispatches) {
+  auto* params = reinterpret_cast<TfLiteSoftmaxParams*>(node->builtin_data);
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  const int depth = SizeOfDimension(input, NumDimensions(input) - 1);
+  GlDispatch dispatch;
+  dispatch.tensors = {node->outputs->data[0], node->inputs->data[0]};
+  dispatch.size = NumElements(input) / depth;
+  dispatch.source =
+      ShaderHeader(1) + IntConstant("DEPTH", depth) +
+      "const float BETA = " + FloatLiteral(params->beta) + ";\n" +
+      ElementwiseMain(dispatch.size,
+                      "  int offset = index * DEPTH;\n"
+                      "  float max_value = input0_data[offset];\n"
+                      "  for (int i = 1; i < DEPTH; ++i) {\n"
+                      "    max_value = max(max_value, input0_data[offset + "
+                      "i]);\n"
+                      "  }\n"
+                      "  float sum = 0.0;\n"
+                      "  for (int i = 0; i < DEPTH; ++i) {\n"
+                      "    sum += exp((input0_data[offset + i] - max_value) "
+                      "* BETA);\n"
+                      "  }\n"
+                      "  for (int i = 0; i < DEPTH; ++i) {\n"
+                      "    output_data[offset + i] =\n"
+                      "        exp((input0_data[offset + i] - max_value) * "
+                      "BETA) / sum;\n"
+                      "  }\n");
+  dispatches->push_back(dispatch);
+}
+
+void AddDispatches(TfLiteContext* context, TfLiteNode* node,
+                   const TfLiteRegistration* registration,
+                   std::vector<GlDispatch>* dispatches) {
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinConv2d:
+      AddConvDispatch(context, node, dispatches);
+      break;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      AddDepthwiseConvDispatch(context, node, dispatches);
+      break;
+    case kTfLiteBuiltinAveragePool2d:
+      AddPoolDispatch(context, node, /*average=*/true, dispatches);
+      break;
+    case kTfLiteBuiltinMaxPool2d:
+      AddPoolDispatch(context, node, /*average=*/false, dispatches);
+      break;
+    case kTfLiteBuiltinAdd:
+      AddAddDispatch(context, node, dispatches);
+      break;
+    case kTfLiteBuiltinConcatenation:
+      AddConcatenationDispatches(context, node, dispatches);
+      break;
+    case kTfLiteBuiltinResizeBilinear:
+      AddResizeBilinearDispatch(context, node, dispatches);
+      break;
+    case kTfLiteBuiltinSoftmax:
+      AddSoftmaxDispatch(context, node, dispatches);
+      break;
+  }
+}
+
+// Copies 'size' bytes of the shader storage buffer 'buffer' to 'data'.
+TfLiteStatus ReadBuffer(GLuint buffer, void* data, size_t size) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+  void* mapped =
+      glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT);
+  if (mapped == nullptr) return kTfLiteError;
+  memcpy(data, mapped, size);
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  return kTfLiteOk;
+}
+
+TfLiteStatus CheckGlError(TfLiteContext* context, const char* action) {
+  const GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    context->ReportError(context, "GL error %d while %s the GL delegate.",
+                         error, action);
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+// The kernel running one delegated subgraph.
+class GlDelegateKernel {
+ public:
+  ~GlDelegateKernel() {
+    for (const auto& program : programs_) {
+      glDeleteProgram(program.second);
+    }
+    for (const auto& buffer : buffers_) {
+      glDeleteBuffers(1, &buffer.second);
+    }
+  }
+
+  void Init(const TfLiteDelegateParams* params) {
+    delegate_ = params->delegate;
+    for (int node_index : TfLiteIntArrayView(params->nodes_to_replace)) {
+      nodes_.push_back(node_index);
+    }
+  }
+
+  // Compiles the shaders of the subgraph and allocates a buffer for each of
+  // its tensors, which are only copied from or to the CPU at its boundaries.
+  TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* delegate_node) {
+    dispatches_.clear();
+    for (int node_index : nodes_) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, node_index, &node, &registration));
+      AddDispatches(context, node, registration, &dispatches_);
+    }
+    for (GlDispatch& dispatch : dispatches_) {
+      TF_LITE_ENSURE_STATUS(GetProgram(context, dispatch.source,
+                                       &dispatch.program));
+      for (int tensor_index : dispatch.tensors) {
+        TF_LITE_ENSURE_STATUS(AllocateBuffer(context, tensor_index));
+      }
+    }
+    // Constant tensors, e.g. weights, are only uploaded once.
+    for (int tensor_index : TfLiteIntArrayView(delegate_node->inputs)) {
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      if (tensor.allocation_type == kTfLiteMmapRo) {
+        UploadTensor(tensor_index, tensor);
+      }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return CheckGlError(context, "preparing");
+  }
+
+  TfLiteStatus Invoke(TfLiteContext* context, TfLiteNode* delegate_node) {
+    for (int tensor_index : TfLiteIntArrayView(delegate_node->inputs)) {
+      const TfLiteTensor& tensor = context->tensors[tensor_index];
+      if (tensor.allocation_type == kTfLiteMmapRo ||
+          HasBoundBuffer(tensor)) {
+        continue;
+      }
+      UploadTensor(tensor_index, tensor);
+    }
+
+    for (const GlDispatch& dispatch : dispatches_) {
+      glUseProgram(dispatch.program);
+      for (size_t i = 0; i < dispatch.tensors.size(); ++i) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i,
+                         GetBuffer(context, dispatch.tensors[i]));
+      }
+      const int num_groups =
+          (dispatch.size + kWorkGroupSize - 1) / kWorkGroupSize;
+      const int num_groups_x = std::min(num_groups, kMaxWorkGroupCount);
+      glDispatchCompute(num_groups_x,
+                        (num_groups + num_groups_x - 1) / num_groups_x, 1);
+      // The next shaders may read what this one wrote.
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    glUseProgram(0);
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    for (int tensor_index : TfLiteIntArrayView(delegate_node->outputs)) {
+      TfLiteTensor* tensor = &context->tensors[tensor_index];
+      if (HasBoundBuffer(*tensor)) {
+        // Copied back by CopyFromBufferHandle() if needed.
+        tensor->data_is_stale = true;
+        continue;
+      }
+      if (ReadBuffer(buffers_[tensor_index], tensor->data.raw,
+                     tensor->bytes) != kTfLiteOk) {
+        context->ReportError(context, "Failed to map a GL buffer.");
+        return kTfLiteError;
+      }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return CheckGlError(context, "invoking");
+  }
+
+ private:
+  bool HasBoundBuffer(const TfLiteTensor& tensor) const {
+    return tensor.delegate == delegate_ &&
+           tensor.buffer_handle != kTfLiteNullBufferHandle;
+  }
+
+  GLuint GetBuffer(TfLiteContext* context, int tensor_index) const {
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    if (HasBoundBuffer(tensor)) {
+      return GetDelegateData(delegate_)->buffers[tensor.buffer_handle];
+    }
+    return buffers_.at(tensor_index);
+  }
+
+  // Inputs only setting the shape of an output, e.g. the size of
+  // RESIZE_BILINEAR, have no buffer and are not uploaded.
+  void UploadTensor(int tensor_index, const TfLiteTensor& tensor) {
+    auto it = buffers_.find(tensor_index);
+    if (it == buffers_.end()) return;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, it->second);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, tensor.bytes,
+                    tensor.data.raw);
+  }
+
+  TfLiteStatus AllocateBuffer(TfLiteContext* context, int tensor_index) {
+    const TfLiteTensor& tensor = context->tensors[tensor_index];
+    GLuint& buffer = buffers_[tensor_index];
+    if (buffer == 0) {
+      glGenBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, tensor.bytes, nullptr,
+                 GL_DYNAMIC_COPY);
+    return kTfLiteOk;
+  }
+
+  // Shaders are shared by the identical ops of the subgraph.
+  TfLiteStatus GetProgram(TfLiteContext* context, const std::string& source,
+                          GLuint* program) {
+    auto it = programs_.find(source);
+    if (it != programs_.end()) {
+      *program = it->second;
+      return kTfLiteOk;
+    }
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    const char* source_data = source.c_str();
+    glShaderSource(shader, 1, &source_data, nullptr);
+    glCompileShader(shader);
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+      char log[1024];
+      glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+      glDeleteShader(shader);
+      context->ReportError(context, "Failed to compile shader: %s", log);
+      return kTfLiteError;
+    }
+    *program = glCreateProgram();
+    glAttachShader(*program, shader);
+    glLinkProgram(*program);
+    glDeleteShader(shader);
+    glGetProgramiv(*program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+      char log[1024];
+      glGetProgramInfoLog(*program, sizeof(log), nullptr, log);
+      glDeleteProgram(*program);
+      context->ReportError(context, "Failed to link shader: %s", log);
+      return kTfLiteError;
+    }
+    programs_[source] = *program;
+    return kTfLiteOk;
+  }
+
+  TfLiteDelegate* delegate_ = nullptr;
+  // Node indices that this delegate is responsible for.
+  std::vector<int> nodes_;
+  std::vector<GlDispatch> dispatches_;
+  // Programs by shader source.
+  std::map<std::string, GLuint> programs_;
+  // The buffers of the tensors, by tensor index.
+  std::map<int, GLuint> buffers_;
+
+};
+
+TfLiteStatus DelegatePrepare(TfLiteContext* context,
+                             TfLiteDelegate* delegate) {
+  // Leave the graph to the CPU without a context to run the shaders.
+  if (!HasGlComputeContext()) {
+    return kTfLiteOk;
+  }
+
+  std::vector<int> supported_nodes(1);
+  TfLiteIntArray* plan;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &plan));
+  for (int node_index : TfLiteIntArrayView(plan)) {
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+        context, node_index, &node, &registration));
+    if (IsNodeSupported(context, node, registration)) {
+      supported_nodes.push_back(node_index);
+    }
+  }
+  // Put the size at the beginning of the array.
+  supported_nodes[0] = supported_nodes.size() - 1;
+
+  static TfLiteRegistration gl_delegate_kernel = [] {
+    TfLiteRegistration registration = {};
+    registration.init = [](TfLiteContext* context, const char* buffer,
+                           size_t length) -> void* {
+      auto* kernel = new GlDelegateKernel;
+      kernel->Init(reinterpret_cast<const TfLiteDelegateParams*>(buffer));
+      return kernel;
+    };
+    registration.free = [](TfLiteContext* context, void* buffer) {
+      delete reinterpret_cast<GlDelegateKernel*>(buffer);
+    };
+    registration.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+      return reinterpret_cast<GlDelegateKernel*>(node->user_data)
+          ->Prepare(context, node);
+    };
+    registration.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+      return reinterpret_cast<GlDelegateKernel*>(node->user_data)
+          ->Invoke(context, node);
+    };
+    registration.builtin_code = kTfLiteBuiltinDelegate;
+    return registration;
+  }();
+
+  return context->ReplaceSubgraphsWithDelegateKernels(
+      context, gl_delegate_kernel,
+      reinterpret_cast<TfLiteIntArray*>(supported_nodes.data()), delegate);
+}
+
+TfLiteStatus CopyFromBufferHandle(TfLiteDelegate* delegate,
+                                  TfLiteBufferHandle buffer_handle, void* data,
+                                  size_t size) {
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  const TfLiteStatus status = ReadBuffer(
+      GetDelegateData(delegate)->buffers[buffer_handle], data, size);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return status;
+}
+
+TfLiteStatus CopyToBufferHandle(TfLiteDelegate* delegate,
+                                TfLiteBufferHandle buffer_handle, void* data,
+                                size_t size) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER,
+               GetDelegateData(delegate)->buffers[buffer_handle]);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return kTfLiteOk;
+}
+
+void FreeBufferHandle(TfLiteDelegate* delegate, TfLiteBufferHandle* handle) {
+  // The buffer itself belongs to the caller of BindGlBufferToTensor().
+  GetDelegateData(delegate)->buffers[*handle] = 0;
+  *handle = kTfLiteNullBufferHandle;
+}
+
+}  // namespace
+
+TfLiteDelegate* NewGlDelegate() {
+  TfLiteDelegate* delegate = new TfLiteDelegate();
+  delegate->data_ = new GlDelegateData;
+  delegate->Prepare = DelegatePrepare;
+  delegate->CopyFromBufferHandle = CopyFromBufferHandle;
+  delegate->CopyToBufferHandle = CopyToBufferHandle;
+  delegate->FreeBufferHandle = FreeBufferHandle;
+  return delegate;
+}
+
+void DeleteGlDelegate(TfLiteDelegate* delegate) {
+  delete GetDelegateData(delegate);
+  delete delegate;
+}
+
+TfLiteStatus BindGlBufferToTensor(Interpreter* interpreter,
+                                  TfLiteDelegate* delegate, int tensor_index,
+                                  GLuint ssbo) {
+  const TfLiteTensor* tensor = interpreter->tensor(tensor_index);
+  if (tensor == nullptr || tensor->type != kTfLiteFloat32) {
+    return kTfLiteError;
+  }
+  std::vector<GLuint>& buffers = GetDelegateData(delegate)->buffers;
+  buffers.push_back(ssbo);
+  return interpreter->SetBufferHandle(tensor_index, buffers.size() - 1,
+                                      delegate);
+}
+
+}  // namespace tflite
@@ -0,0 +1,55 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
+#define TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
+
+#include <GLES3/gl31.h>
+
+#include "tensorflow/contrib/lite/context.h"
+#include "tensorflow/contrib/lite/interpreter.h"
+
+namespace tflite {
+
+// Return a delegate that runs the float32 conv, depthwise conv, pooling, add,
+// concatenation, bilinear resize and softmax ops of a graph as OpenGL ES 3.1
+// compute shaders. The tensors produced and consumed within a delegated
+// subgraph stay in GPU memory. e.g.
+//   TfLiteDelegate* delegate = NewGlDelegate();
+//   interpreter->ModifyGraphWithDelegate(delegate);
+//   ...
+//   interpreter.reset();
+//   DeleteGlDelegate(delegate);
+// The delegate uses the OpenGL ES 3.1 context that is current on the calling
+// thread, which must be current whenever the interpreter is modified, invoked
+// or destroyed. Without such a context, the delegate leaves the graph alone.
+TfLiteDelegate* NewGlDelegate();
+
+// Destroy a delegate returned by NewGlDelegate(), after the interpreters
+// using it.
+void DeleteGlDelegate(TfLiteDelegate* delegate);
+
+// Make the delegated subgraphs read the tensor 'tensor_index' from, or write
+// it to, the shader storage buffer 'ssbo' instead of the tensor's memory, e.g.
+// to feed camera frames already in GPU memory. 'ssbo' is owned by the caller
+// and must hold at least the bytes of the tensor. The tensor must be float32.
+// Reading a bound output from the CPU copies it back from 'ssbo', see
+// Interpreter::SetAllowBufferHandleOutput().
+TfLiteStatus BindGlBufferToTensor(Interpreter* interpreter,
+                                  TfLiteDelegate* delegate, int tensor_index,
+                                  GLuint ssbo);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_DELEGATES_GPU_GL_DELEGATE_H_
@@ -0,0 +1,311 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/delegates/gpu/gl_delegate.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/interpreter.h"
+#include "tensorflow/contrib/lite/kernels/test_util.h"
+#include "tensorflow/contrib/lite/model.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+// Makes an OpenGL ES 3.1 context without a surface current for all the tests
+// and shares a delegate between them.
+class GlDelegateTest : public ::testing::Test {
+ public:
+  static void SetUpTestCase() {
+    display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    ASSERT_TRUE(eglInitialize(display_, nullptr, nullptr));
+    ASSERT_TRUE(eglBindAPI(EGL_OPENGL_ES_API));
+    const EGLint attributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3,
+                                 EGL_CONTEXT_MINOR_VERSION, 1, EGL_NONE};
+    context_ = eglCreateContext(display_, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                attributes);
+    ASSERT_NE(context_, EGL_NO_CONTEXT);
+    ASSERT_TRUE(
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_));
+    delegate_ = NewGlDelegate();
+  }
+
+  static void TearDownTestCase() {
+    DeleteGlDelegate(delegate_);
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display_, context_);
+    eglTerminate(display_);
+  }
+
+  static TfLiteDelegate* delegate() { return delegate_; }
+
+ private:
+  static EGLDisplay display_;
+  static EGLContext context_;
+  static TfLiteDelegate* delegate_;
+};
+
+EGLDisplay GlDelegateTest::display_ = EGL_NO_DISPLAY;
+EGLContext GlDelegateTest::context_ = EGL_NO_CONTEXT;
+TfLiteDelegate* GlDelegateTest::delegate_ = nullptr;
+
+class SingleOpModelWithGl : public SingleOpModel {
+ public:
+  SingleOpModelWithGl() {
+    this->SetApplyDelegate([](Interpreter* interpreter) {
+      interpreter->ModifyGraphWithDelegate(GlDelegateTest::delegate(), false);
+    });
+  }
+
+  Interpreter* interpreter() { return interpreter_.get(); }
+};
+
+class FloatAddOpModel : public SingleOpModelWithGl {
+ public:
+  FloatAddOpModel(const TensorData& input1, const TensorData& input2,
+                  const TensorData& output,
+                  ActivationFunctionType activation_type) {
+    input1_ = AddInput(input1);
+    input2_ = AddInput(input2);
+    output_ = AddOutput(output);
+    SetBuiltinOp(BuiltinOperator_ADD, BuiltinOptions_AddOptions,
+                 CreateAddOptions(builder_, activation_type).Union());
+    BuildInterpreter({GetShape(input1_), GetShape(input2_)});
+  }
+
+  int input1() { return input1_; }
+  int input2() { return input2_; }
+  int output() { return output_; }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ protected:
+  int input1_;
+  int input2_;
+  int output_;
+};
+
+TEST_F(GlDelegateTest, AddWithRelu) {
+  FloatAddOpModel m({TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {}}, ActivationFunctionType_RELU);
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({0.0, 0.4, 1.0, 1.3})));
+}
+
+TEST_F(GlDelegateTest, AddToBoundBuffer) {
+  FloatAddOpModel m({TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {1, 2, 2, 1}},
+                    {TensorType_FLOAT32, {}}, ActivationFunctionType_NONE);
+  GLuint ssbo;
+  glGenBuffers(1, &ssbo);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, 4 * sizeof(float), nullptr,
+               GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  ASSERT_EQ(BindGlBufferToTensor(m.interpreter(), delegate(), m.output(),
+                                 ssbo),
+            kTfLiteOk);
+  m.interpreter()->SetAllowBufferHandleOutput(true);
+
+  m.PopulateTensor<float>(m.input1(), {-2.0, 0.2, 0.7, 0.8});
+  m.PopulateTensor<float>(m.input2(), {0.1, 0.2, 0.3, 0.5});
+  m.Invoke();
+  ASSERT_EQ(m.interpreter()->EnsureTensorDataIsReadable(m.output()),
+            kTfLiteOk);
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({-1.9, 0.4, 1.0, 1.3})));
+  glDeleteBuffers(1, &ssbo);
+}
+
+class FloatConvolutionOpModel : public SingleOpModelWithGl {
+ public:
+  FloatConvolutionOpModel(const TensorData& input, const TensorData& filter,
+                          const TensorData& output, int stride,
+                          Padding padding) {
+    input_ = AddInput(input);
+    filter_ = AddInput(filter);
+    bias_ = AddInput({TensorType_FLOAT32, {filter.shape[0]}});
+    output_ = AddOutput(output);
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, padding, stride, stride,
+                                     ActivationFunctionType_NONE)
+                     .Union());
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)});
+  }
+
+  int input() { return input_; }
+  int filter() { return filter_; }
+  int bias() { return bias_; }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ protected:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_F(GlDelegateTest, Conv) {
+  FloatConvolutionOpModel m({TensorType_FLOAT32, {2, 2, 4, 1}},
+                            {TensorType_FLOAT32, {3, 2, 2, 1}},
+                            {TensorType_FLOAT32, {}}, /*stride=*/2,
+                            Padding_VALID);
+  m.PopulateTensor<float>(m.input(), {
+                                         1, 1, 1, 1,  // row = 1
+                                         2, 2, 2, 2,  // row = 2
+                                         // second batch
+                                         1, 2, 3, 4,  // row = 1
+                                         1, 2, 3, 4,  // row = 2
+                                     });
+  m.PopulateTensor<float>(m.filter(), {
+                                          1, 2, 3, 4,    // first 2x2 filter
+                                          -1, 1, -1, 1,  // second 2x2 filter
+                                          -1, -1, 1, 1,  // third 2x2 filter
+                                      });
+  m.PopulateTensor<float>(m.bias(), {1, 2, 3});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 18, 2, 5,  // first batch, left
+                                 18, 2, 5,  // first batch, right
+                                 17, 4, 3,  // second batch, left
+                                 37, 4, 3,  // second batch, right
+                             })));
+}
+
+class FloatPoolingOpModel : public SingleOpModelWithGl {
+ public:
+  FloatPoolingOpModel(BuiltinOperator type, const TensorData& input,
+                      int filter_width, int filter_height,
+                      const TensorData& output) {
+    input_ = AddInput(input);
+    output_ = AddOutput(output);
+    SetBuiltinOp(
+        type, BuiltinOptions_Pool2DOptions,
+        CreatePool2DOptions(builder_, Padding_VALID, 2, 2, filter_width,
+                            filter_height, ActivationFunctionType_NONE)
+            .Union());
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  int input() { return input_; }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ protected:
+  int input_;
+  int output_;
+};
+
+TEST_F(GlDelegateTest, AveragePool) {
+  FloatPoolingOpModel m(BuiltinOperator_AVERAGE_POOL_2D,
+                        {TensorType_FLOAT32, {1, 2, 4, 1}}, 2, 2,
+                        {TensorType_FLOAT32, {}});
+  m.PopulateTensor<float>(m.input(), {0, 6, 2, 4, 3, 2, 10, 7});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({2.75, 5.75})));
+}
+
+TEST_F(GlDelegateTest, MaxPool) {
+  FloatPoolingOpModel m(BuiltinOperator_MAX_POOL_2D,
+                        {TensorType_FLOAT32, {1, 2, 4, 1}}, 2, 2,
+                        {TensorType_FLOAT32, {}});
+  m.PopulateTensor<float>(m.input(), {0, 6, 2, 4, 3, 2, 10, 7});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({6, 10})));
+}
+
+class FloatConcatenationOpModel : public SingleOpModelWithGl {
+ public:
+  FloatConcatenationOpModel(const TensorData& input1,
+                            const TensorData& input2, int axis) {
+    input1_ = AddInput(input1);
+    input2_ = AddInput(input2);
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(
+        BuiltinOperator_CONCATENATION, BuiltinOptions_ConcatenationOptions,
+        CreateConcatenationOptions(builder_, axis, ActivationFunctionType_NONE)
+            .Union());
+    BuildInterpreter({GetShape(input1_), GetShape(input2_)});
+  }
+
+  int input1() { return input1_; }
+  int input2() { return input2_; }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ protected:
+  int input1_;
+  int input2_;
+  int output_;
+};
+
+TEST_F(GlDelegateTest, ConcatenationOnLastAxis) {
+  FloatConcatenationOpModel m({TensorType_FLOAT32, {2, 1, 2}},
+                              {TensorType_FLOAT32, {2, 1, 1}}, /*axis=*/-1);
+  m.PopulateTensor<float>(m.input1(), {1, 2, 3, 4});
+  m.PopulateTensor<float>(m.input2(), {5, 6});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({1, 2, 5, 3, 4, 6})));
+}
+
+class FloatSoftmaxOpModel : public SingleOpModelWithGl {
+ public:
+  FloatSoftmaxOpModel(int batches, int size, float beta) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, size}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+    SetBuiltinOp(BuiltinOperator_SOFTMAX, BuiltinOptions_SoftmaxOptions,
+                 CreateSoftmaxOptions(builder_, beta).Union());
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  int input() { return input_; }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ protected:
+  int input_;
+  int output_;
+};
+
+TEST_F(GlDelegateTest, Softmax) {
+  FloatSoftmaxOpModel m(/*batches=*/2, /*size=*/5, /*beta=*/1.0);
+  m.PopulateTensor<float>(m.input(), {
+                                         1.0, 2.0, 3.0, 4.0, 5.0,       //
+                                         -1.0, -2.0, -3.0, -4.0, -5.0,  //
+                                     });
+  m.Invoke();
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {0.011656231, 0.031684921, 0.086128544, 0.234121657,
+                   0.636408647, 0.636408647, 0.234121657, 0.086128544,
+                   0.031684921, 0.011656231},
+                  1e-6)));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
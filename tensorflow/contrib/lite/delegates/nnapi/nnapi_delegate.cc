@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <cstdarg>
+#include <cstring>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "tensorflow/contrib/lite/allocation.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/nnapi/NeuralNetworksShim.h"
 
+#include <sys/mman.h>
 #ifdef __ANDROID__
 #include <sys/system_properties.h>
 #endif
@@ -80,6 +84,74 @@ struct NNFreeCompilation {
   }
 };
 
+// NN API memory that the caller bound to a tensor with
+// BindNnApiMemoryToTensor().
+struct NnApiBuffer {
+  ANeuralNetworksMemory* memory;
+  // Where the caller mapped `memory` in this process, or null.
+  void* data;
+};
+
+// The memory bound to tensors, indexed by TfLiteBufferHandle. Freed handles
+// hold a null memory.
+class NnApiBuffers {
+ public:
+  static NnApiBuffers* Get() {
+    static NnApiBuffers* buffers = new NnApiBuffers;
+    return buffers;
+  }
+
+  TfLiteBufferHandle Add(const NnApiBuffer& buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(buffer);
+    return buffers_.size() - 1;
+  }
+
+  NnApiBuffer Lookup(TfLiteBufferHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffers_[handle];
+  }
+
+  void Remove(TfLiteBufferHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_[handle] = {nullptr, nullptr};
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<NnApiBuffer> buffers_;
+};
+
+// The NN API memory sharing each mapped model with the accelerators, which
+// must outlive the NN API models reading from it.
+class AllocationMemoryMapping {
+ public:
+  ~AllocationMemoryMapping() {
+    for (const auto& memory : memories_) {
+      ANeuralNetworksMemory_free(memory.second);
+    }
+  }
+
+  // Return the NN API memory of `allocation`, creating it on first use.
+  TfLiteStatus GetMemory(TfLiteContext* context,
+                         const MMAPAllocation* allocation,
+                         ANeuralNetworksMemory** memory) {
+    auto it = memories_.find(allocation);
+    if (it != memories_.end()) {
+      *memory = it->second;
+      return kTfLiteOk;
+    }
+    CHECK_NN(context, ANeuralNetworksMemory_createFromFd(
+                          allocation->bytes(), PROT_READ, allocation->fd(), 0,
+                          memory));
+    memories_[allocation] = *memory;
+    return kTfLiteOk;
+  }
+
+ private:
+  std::map<const MMAPAllocation*, ANeuralNetworksMemory*> memories_;
+};
+
 // Track tensor indices to NN API tensor indices mapping.
 class OperandMapping {
  public:
@@ -123,9 +195,11 @@ class OperandMapping {
 class NNAPIOpBuilder {
  public:
   NNAPIOpBuilder(TfLiteContext* context, OperandMapping* tensor_mapping,
+                 AllocationMemoryMapping* allocation_mapping,
                  ANeuralNetworksModel* nn_model)
       : context_(context),
         operand_mapping_(tensor_mapping),
+        allocation_mapping_(allocation_mapping),
         nn_model_(nn_model) {}
 
   TfLiteStatus AddScalarInt32Operand(int32_t value) {
@@ -216,10 +290,27 @@ class NNAPIOpBuilder {
              ANeuralNetworksModel_addOperand(nn_model_, &operand_type));
 
     if (tensor->allocation_type == kTfLiteMmapRo) {
-      // TODO(b/80630405): Use NNAPIAllocation.
-      CHECK_NN(context_, ANeuralNetworksModel_setOperandValue(
-                             nn_model_, ann_tensor_index, tensor->data.raw,
-                             tensor->bytes));
+      const Allocation* allocation =
+          static_cast<const Allocation*>(tensor->allocation);
+      if (allocation && allocation->type() == Allocation::Type::kMMap) {
+        // Share the weights in the mapped model file with the accelerators
+        // instead of having NN API copy them.
+        const MMAPAllocation* mmap_allocation =
+            static_cast<const MMAPAllocation*>(allocation);
+        ANeuralNetworksMemory* memory;
+        TF_LITE_ENSURE_STATUS(
+            allocation_mapping_->GetMemory(context_, mmap_allocation, &memory));
+        const size_t offset =
+            tensor->data.raw -
+            static_cast<const char*>(mmap_allocation->base());
+        CHECK_NN(context_, ANeuralNetworksModel_setOperandValueFromMemory(
+                               nn_model_, ann_tensor_index, memory, offset,
+                               tensor->bytes));
+      } else {
+        CHECK_NN(context_, ANeuralNetworksModel_setOperandValue(
+                               nn_model_, ann_tensor_index, tensor->data.raw,
+                               tensor->bytes));
+      }
     }
 
     *ann_tensor_index_out = ann_tensor_index;
@@ -275,6 +366,9 @@ class NNAPIOpBuilder {
   // Tracks relationship between indices
   OperandMapping* operand_mapping_;
 
+  // The NN API memory of the mapped models.
+  AllocationMemoryMapping* allocation_mapping_;
+
   // The model
   ANeuralNetworksModel* nn_model_;
 
@@ -694,6 +788,7 @@ class NNAPIDelegateKernel {
   // Initialize the kernel (a NN model).
   TfLiteStatus Init(TfLiteContext* context,
                     const TfLiteDelegateParams* params) {
+    delegate_ = params->delegate;
     for (auto node_index : TfLiteIntArrayView(params->nodes_to_replace)) {
       nodes_.push_back(node_index);
     }
@@ -730,9 +825,17 @@ class NNAPIDelegateKernel {
       // TODO(miaowang): make sure the delegation works with dequantized weights
       // as intermediate tensors.
       if (tensor->allocation_type != kTfLiteMmapRo) {
-        CHECK_NN(context, ANeuralNetworksExecution_setInput(
-                              execution, relative_input_index, nullptr,
-                              tensor->data.raw, tensor->bytes));
+        if (HasBoundMemory(*tensor)) {
+          const NnApiBuffer buffer =
+              NnApiBuffers::Get()->Lookup(tensor->buffer_handle);
+          CHECK_NN(context, ANeuralNetworksExecution_setInputFromMemory(
+                                execution, relative_input_index, nullptr,
+                                buffer.memory, 0, tensor->bytes));
+        } else {
+          CHECK_NN(context, ANeuralNetworksExecution_setInput(
+                                execution, relative_input_index, nullptr,
+                                tensor->data.raw, tensor->bytes));
+        }
         relative_input_index++;
       }
     }
@@ -741,9 +844,19 @@ class NNAPIDelegateKernel {
     int relative_output_index = 0;
     for (auto output_index : TfLiteIntArrayView(node->outputs)) {
       TfLiteTensor* tensor = &context->tensors[output_index];
-      CHECK_NN(context, ANeuralNetworksExecution_setOutput(
-                            execution, relative_output_index, nullptr,
-                            tensor->data.raw, tensor->bytes));
+      if (HasBoundMemory(*tensor)) {
+        const NnApiBuffer buffer =
+            NnApiBuffers::Get()->Lookup(tensor->buffer_handle);
+        CHECK_NN(context, ANeuralNetworksExecution_setOutputFromMemory(
+                              execution, relative_output_index, nullptr,
+                              buffer.memory, 0, tensor->bytes));
+        // Copied to the tensor by CopyFromBufferHandle() if read on the CPU.
+        tensor->data_is_stale = true;
+      } else {
+        CHECK_NN(context, ANeuralNetworksExecution_setOutput(
+                              execution, relative_output_index, nullptr,
+                              tensor->data.raw, tensor->bytes));
+      }
       relative_output_index++;
     }
     // Invoke ANN in blocking fashion.
@@ -757,6 +870,14 @@ class NNAPIDelegateKernel {
   }
 
  private:
+  bool HasBoundMemory(const TfLiteTensor& tensor) const {
+    return tensor.delegate == delegate_ &&
+           tensor.buffer_handle != kTfLiteNullBufferHandle;
+  }
+
+  TfLiteDelegate* delegate_ = nullptr;
+  // Declared before the model so that it is freed after it.
+  AllocationMemoryMapping allocation_mapping_;
   // ANN API state.
   std::unique_ptr<ANeuralNetworksModel, NNFreeModel> nn_model_;
   std::unique_ptr<ANeuralNetworksCompilation, NNFreeCompilation>
@@ -771,7 +892,8 @@ class NNAPIDelegateKernel {
     // The operand builder allows creating a single op. We create it at this
     // reduced power position rather than in the for loop to avoid reallocating
     // the vectors.
-    NNAPIOpBuilder builder(context, &operand_mapping_, nn_model_.get());
+    NNAPIOpBuilder builder(context, &operand_mapping_, &allocation_mapping_,
+                           nn_model_.get());
     // Add Tensors
     // allocate outside to avoid realloc
     for (auto node_index : nodes_) {
@@ -903,9 +1025,47 @@ TfLiteDelegate* NnApiDelegate() {
             reinterpret_cast<TfLiteIntArray*>(supported_nodes.data()),
             delegate);
         return kTfLiteOk;
+      },
+
+      .CopyFromBufferHandle = [](TfLiteDelegate* delegate,
+                                 TfLiteBufferHandle buffer_handle, void* data,
+                                 size_t size) -> TfLiteStatus {
+        const NnApiBuffer buffer = NnApiBuffers::Get()->Lookup(buffer_handle);
+        // NN API can't map memory, so only memory the caller mapped can be
+        // read back.
+        if (buffer.data == nullptr) return kTfLiteError;
+        memcpy(data, buffer.data, size);
+        return kTfLiteOk;
+      },
+
+      .CopyToBufferHandle = [](TfLiteDelegate* delegate,
+                               TfLiteBufferHandle buffer_handle, void* data,
+                               size_t size) -> TfLiteStatus {
+        const NnApiBuffer buffer = NnApiBuffers::Get()->Lookup(buffer_handle);
+        if (buffer.data == nullptr) return kTfLiteError;
+        memcpy(buffer.data, data, size);
+        return kTfLiteOk;
+      },
+
+      .FreeBufferHandle = [](TfLiteDelegate* delegate,
+                             TfLiteBufferHandle* handle) {
+        // The memory itself belongs to the caller of
+        // BindNnApiMemoryToTensor().
+        NnApiBuffers::Get()->Remove(*handle);
+        *handle = kTfLiteNullBufferHandle;
       }};
 
   return &delegate;
 }
 
+TfLiteStatus BindNnApiMemoryToTensor(Interpreter* interpreter,
+                                     int tensor_index,
+                                     ANeuralNetworksMemory* memory,
+                                     void* data) {
+  if (interpreter->tensor(tensor_index) == nullptr) return kTfLiteError;
+  const TfLiteBufferHandle handle =
+      NnApiBuffers::Get()->Add({memory, data});
+  return interpreter->SetBufferHandle(tensor_index, handle, NnApiDelegate());
+}
+
 }  // namespace tflite
@@ -16,6 +16,8 @@ limitations under the License.
 #define TENSORFLOW_CONTRIB_LITE_DELEGATES_NNAPI_NNAPI_DELEGATE_H_
 
 #include "tensorflow/contrib/lite/context.h"
+#include "tensorflow/contrib/lite/interpreter.h"
+#include "tensorflow/contrib/lite/nnapi/NeuralNetworksShim.h"
 
 namespace tflite {
 
@@ -25,7 +27,22 @@ namespace tflite {
 //   interpreter->ModifyGraphWithDelegate(&delegate);
 // NnApiDelegate() returns a singleton, so you should not free this
 // pointer or worry about its lifetime.
+// The delegate runs each maximal subgraph of supported ops on NN API, leaving
+// the others to the CPU. Weights of models mapped from a file are shared with
+// NN API rather than copied.
 TfLiteDelegate* NnApiDelegate();
+
+// Make the NN API subgraphs read the tensor `tensor_index` from, or write it
+// to, `memory` instead of the tensor's buffer, e.g. memory created with
+// ANeuralNetworksMemory_createFromFd() from the buffer a camera writes to.
+// `data` is where the caller mapped `memory` in this process, or null; it is
+// used to copy the tensor when it's read from the CPU, see
+// Interpreter::SetAllowBufferHandleOutput(). `memory` is owned by the caller
+// and must hold at least the bytes of the tensor.
+TfLiteStatus BindNnApiMemoryToTensor(Interpreter* interpreter,
+                                     int tensor_index,
+                                     ANeuralNetworksMemory* memory,
+                                     void* data);
 }  // namespace tflite
 
 #endif  // TENSORFLOW_CONTRIB_LITE_DELEGATES_NNAPI_NNAPI_DELEGATE_H_
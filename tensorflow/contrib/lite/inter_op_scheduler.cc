@@ -0,0 +1,130 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/inter_op_scheduler.h"
+
+#include <algorithm>
+
+namespace tflite {
+
+std::vector<int> CalculateNodeSteps(const GraphInfo& graph_info) {
+  const int num_tensors = graph_info.num_tensors();
+  // The largest step of the nodes that wrote each tensor, and of those that
+  // read it.
+  std::vector<int> write_step(num_tensors, -1);
+  std::vector<int> read_step(num_tensors, -1);
+  std::vector<int> is_variable(num_tensors, false);
+  for (int tensor_index : graph_info.variables()) {
+    if (tensor_index != kOptionalTensor) {
+      is_variable[tensor_index] = true;
+    }
+  }
+
+  std::vector<int> steps(graph_info.num_nodes());
+  for (int i = 0; i < graph_info.num_nodes(); ++i) {
+    const TfLiteNode& node = graph_info.node(i);
+    int step = 0;
+    for (int j = 0; j < node.inputs->size; ++j) {
+      int tensor_index = node.inputs->data[j];
+      if (tensor_index == kOptionalTensor) continue;
+      step = std::max(step, write_step[tensor_index] + 1);
+      if (is_variable[tensor_index]) {
+        step = std::max(step, read_step[tensor_index] + 1);
+      }
+    }
+    for (int j = 0; j < node.outputs->size; ++j) {
+      int tensor_index = node.outputs->data[j];
+      step = std::max(step, write_step[tensor_index] + 1);
+      step = std::max(step, read_step[tensor_index] + 1);
+    }
+    steps[i] = step;
+
+    for (int j = 0; j < node.inputs->size; ++j) {
+      int tensor_index = node.inputs->data[j];
+      if (tensor_index == kOptionalTensor) continue;
+      read_step[tensor_index] = std::max(read_step[tensor_index], step);
+      if (is_variable[tensor_index]) {
+        write_step[tensor_index] = std::max(write_step[tensor_index], step);
+      }
+    }
+    for (int j = 0; j < node.outputs->size; ++j) {
+      int tensor_index = node.outputs->data[j];
+      write_step[tensor_index] = std::max(write_step[tensor_index], step);
+    }
+  }
+  return steps;
+}
+
+InterOpThreadPool::InterOpThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    threads_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void InterOpThreadPool::ParallelFor(int n,
+                                    const std::function<void(int)>& fn) {
+  if (n == 0) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  fn_ = &fn;
+  num_calls_ = n;
+  next_call_ = 0;
+  num_unfinished_calls_ = n;
+  ++generation_;
+  if (n > 1) {
+    work_available_.notify_all();
+  }
+  RunCalls(&lock);
+  work_done_.wait(lock, [this]() { return num_unfinished_calls_ == 0; });
+  fn_ = nullptr;
+}
+
+void InterOpThreadPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Not generation_, as a ParallelFor() may have started before this thread.
+  int last_generation = 0;
+  while (true) {
+    work_available_.wait(lock, [this, last_generation]() {
+      return stopping_ || generation_ != last_generation;
+    });
+    if (stopping_) return;
+    last_generation = generation_;
+    RunCalls(&lock);
+  }
+}
+
+void InterOpThreadPool::RunCalls(std::unique_lock<std::mutex>* lock) {
+  while (next_call_ < num_calls_) {
+    const int i = next_call_++;
+    const std::function<void(int)>& fn = *fn_;
+    lock->unlock();
+    fn(i);
+    lock->lock();
+    if (--num_unfinished_calls_ == 0) {
+      work_done_.notify_all();
+    }
+  }
+}
+
+}  // namespace tflite
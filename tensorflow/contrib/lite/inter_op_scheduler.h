@@ -0,0 +1,82 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_INTER_OP_SCHEDULER_H_
+#define TENSORFLOW_CONTRIB_LITE_INTER_OP_SCHEDULER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tensorflow/contrib/lite/graph_info.h"
+
+namespace tflite {
+
+// Returns the step of each node of 'graph_info', in execution order: 0 for
+// the nodes that depend on no other node, and otherwise one more than the
+// largest step of the nodes they depend on. The nodes of a step are
+// independent of each other and can run concurrently once the previous steps
+// are done.
+//
+// A node depends on an earlier node of the execution plan if it reads a
+// tensor the earlier node writes, or writes a tensor the earlier node reads
+// or writes. Nodes are assumed to write the variable tensors among their
+// inputs.
+std::vector<int> CalculateNodeSteps(const GraphInfo& graph_info);
+
+// A small pool of threads that runs the nodes of a step concurrently.
+class InterOpThreadPool {
+ public:
+  // Starts 'num_threads' - 1 threads, the thread calling ParallelFor() being
+  // the last one.
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return threads_.size() + 1; }
+
+  // Calls 'fn' once for each value in [0, n), and returns once all the calls
+  // have returned. Must not be called concurrently.
+  void ParallelFor(int n, const std::function<void(int)>& fn);
+
+ private:
+  void WorkerLoop();
+
+  // Makes calls of the current ParallelFor() until none are left to start.
+  // 'mutex_' must be held by 'lock'.
+  void RunCalls(std::unique_lock<std::mutex>* lock);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  // Signaled when a ParallelFor() starts or the pool is destroyed.
+  std::condition_variable work_available_;
+  // Signaled when the last call of a ParallelFor() returns.
+  std::condition_variable work_done_;
+  const std::function<void(int)>* fn_ = nullptr;
+  int num_calls_ = 0;
+  int next_call_ = 0;
+  int num_unfinished_calls_ = 0;
+  // Incremented by each ParallelFor(), so workers don't mistake the one they
+  // already took part in for a new one.
+  int generation_ = 0;
+  bool stopping_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_INTER_OP_SCHEDULER_H_
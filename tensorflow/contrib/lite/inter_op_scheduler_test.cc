@@ -0,0 +1,140 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/inter_op_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+// A GraphInfo for nodes given by their input and output tensors.
+class TestGraphInfo : public GraphInfo {
+ public:
+  TestGraphInfo(int num_tensors,
+                std::initializer_list<
+                    std::pair<std::vector<int>, std::vector<int>>>
+                    nodes,
+                std::vector<int> variables = {})
+      : num_tensors_(num_tensors), variables_(variables) {
+    for (const auto& node : nodes) {
+      nodes_.push_back(TfLiteNode());
+      nodes_.back().inputs = ToIntArray(node.first);
+      nodes_.back().outputs = ToIntArray(node.second);
+    }
+  }
+
+  ~TestGraphInfo() override {
+    for (TfLiteNode& node : nodes_) {
+      TfLiteIntArrayFree(node.inputs);
+      TfLiteIntArrayFree(node.outputs);
+    }
+  }
+
+  size_t num_tensors() const override { return num_tensors_; }
+  TfLiteTensor* tensor(size_t index) override { return nullptr; }
+  size_t num_nodes() const override { return nodes_.size(); }
+  const TfLiteNode& node(size_t index) const override { return nodes_[index]; }
+  const std::vector<int>& inputs() const override { return empty_; }
+  const std::vector<int>& outputs() const override { return empty_; }
+  const std::vector<int>& variables() const override { return variables_; }
+
+ private:
+  static TfLiteIntArray* ToIntArray(const std::vector<int>& values) {
+    TfLiteIntArray* array = TfLiteIntArrayCreate(values.size());
+    for (size_t i = 0; i < values.size(); ++i) array->data[i] = values[i];
+    return array;
+  }
+
+  int num_tensors_;
+  std::vector<TfLiteNode> nodes_;
+  std::vector<int> variables_;
+  std::vector<int> empty_;
+};
+
+TEST(CalculateNodeStepsTest, Branches) {
+  // Two branches from #0, joined by the last node, and an independent node.
+  TestGraphInfo graph(8, {{{0}, {1}},
+                          {{1}, {2}},
+                          {{0}, {3}},
+                          {{2, 3, -1}, {4}},
+                          {{5}, {6}}});
+  EXPECT_THAT(CalculateNodeSteps(graph), ElementsAre(0, 1, 0, 2, 0));
+}
+
+TEST(CalculateNodeStepsTest, WritesWaitForEarlierAccesses) {
+  // The third node overwrites #1, which the second node reads.
+  TestGraphInfo graph(4, {{{0}, {1}}, {{1}, {2}}, {{3}, {1}}});
+  EXPECT_THAT(CalculateNodeSteps(graph), ElementsAre(0, 1, 2));
+}
+
+TEST(CalculateNodeStepsTest, VariablesAreWritten) {
+  // Both nodes read variable #0, so they may both update it.
+  TestGraphInfo graph(3, {{{0}, {1}}, {{0}, {2}}}, /*variables=*/{0});
+  EXPECT_THAT(CalculateNodeSteps(graph), ElementsAre(0, 1));
+}
+
+TEST(InterOpThreadPoolTest, MakesEveryCall) {
+  InterOpThreadPool pool(3);
+  EXPECT_EQ(pool.num_threads(), 3);
+  for (int n : {0, 1, 5, 100}) {
+    std::vector<std::atomic<int>> calls(n);
+    for (auto& count : calls) count = 0;
+    pool.ParallelFor(n, [&calls](int i) { ++calls[i]; });
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(calls[i], 1) << "call " << i << " of " << n;
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, MakesCallsConcurrently) {
+  // Each call waits for the other to start, which only happens if they run
+  // on different threads.
+  InterOpThreadPool pool(2);
+  std::atomic<int> started(0);
+  std::atomic<int> met(0);
+  pool.ParallelFor(2, [&started, &met](int i) {
+    ++started;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    if (started == 2) ++met;
+  });
+  EXPECT_EQ(met, 2);
+}
+
+TEST(InterOpThreadPoolTest, SingleThread) {
+  InterOpThreadPool pool(1);
+  EXPECT_EQ(pool.num_threads(), 1);
+  std::vector<int> order;
+  pool.ParallelFor(3, [&order](int i) { order.push_back(i); });
+  EXPECT_THAT(order, ElementsAre(0, 1, 2));
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
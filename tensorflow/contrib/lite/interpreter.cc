@@ -15,16 +15,20 @@ limitations under the License.
 
 #include "tensorflow/contrib/lite/interpreter.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdint>
 #include <cstring>
+#include <numeric>
 
 #include "tensorflow/contrib/lite/arena_planner.h"
 #include "tensorflow/contrib/lite/context.h"
 #include "tensorflow/contrib/lite/context_util.h"
 #include "tensorflow/contrib/lite/error_reporter.h"
 #include "tensorflow/contrib/lite/graph_info.h"
+#include "tensorflow/contrib/lite/kernels/eigen_support.h"
+#include "tensorflow/contrib/lite/kernels/gemm_support.h"
 #include "tensorflow/contrib/lite/memory_planner.h"
 #ifndef TFLITE_MCU
 #include "tensorflow/contrib/lite/nnapi_delegate.h"
@@ -40,6 +44,9 @@ class NNAPIDelegate {};
 
 namespace {
 
+// The number of arena plans kept with incremental preparation.
+constexpr int kArenaPlanCacheCapacity = 4;
+
 TfLiteStatus ReportOpError(TfLiteContext* context, const TfLiteNode& node,
                            const TfLiteRegistration& registration,
                            int node_index, const char* message) {
@@ -120,9 +127,11 @@ class InterpreterInfo : public GraphInfo {
   Interpreter* interpreter_;
 };
 
-Interpreter::Interpreter(ErrorReporter* error_reporter)
+Interpreter::Interpreter(ErrorReporter* error_reporter,
+                         ArenaPlanningStrategy arena_planning_strategy)
     : error_reporter_(error_reporter ? error_reporter
-                                     : DefaultErrorReporter()) {
+                                     : DefaultErrorReporter()),
+      arena_planning_strategy_(arena_planning_strategy) {
   context_.impl_ = static_cast<void*>(this);
   context_.ResizeTensor = ResizeTensor;
   context_.ReportError = ReportError;
@@ -130,6 +139,7 @@ Interpreter::Interpreter(ErrorReporter* error_reporter)
   context_.tensors = nullptr;
   context_.tensors_size = 0;
   context_.recommended_num_threads = -1;
+  context_.cache_transformed_weights = true;
   context_.GetExternalContext = GetExternalContext;
   context_.SetExternalContext = SetExternalContext;
 
@@ -149,6 +159,10 @@ Interpreter::Interpreter(ErrorReporter* error_reporter)
 }
 
 Interpreter::~Interpreter() {
+  if (async_invoke_thread_.joinable()) {
+    async_invoke_thread_.join();
+  }
+
   for (auto& nodeAndReg : nodes_and_registration_) {
     TfLiteNode& node = nodeAndReg.first;
     TfLiteIntArrayFree(node.inputs);
@@ -414,6 +428,9 @@ TfLiteStatus Interpreter::BytesRequired(TfLiteType type, const int* dims,
     case kTfLiteUInt8:
       *bytes = sizeof(uint8_t) * count;
       break;
+    case kTfLiteInt8:
+      *bytes = sizeof(int8_t) * count;
+      break;
     case kTfLiteInt64:
       *bytes = sizeof(int64_t) * count;
       break;
@@ -425,8 +442,8 @@ TfLiteStatus Interpreter::BytesRequired(TfLiteType type, const int* dims,
       break;
     default:
       ReportError(&context_,
-                  "Only float32, int16, int32, int64, uint8, bool, complex64 "
-                  "supported currently.");
+                  "Only float32, int16, int32, int64, uint8, int8, bool, "
+                  "complex64 supported currently.");
       return kTfLiteError;
   }
   return kTfLiteOk;
@@ -445,12 +462,27 @@ TfLiteStatus Interpreter::AllocateTensors() {
     return kTfLiteOk;
   }
 
-  next_execution_plan_index_to_prepare_ = 0;
-  if (memory_planner_) {
-    TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
-  }
+  const bool incremental = incremental_preparation_ &&
+                           !needs_full_preparation_ && memory_planner_ &&
+                           state_ == kStateUninvokable;
+  // Until the ops are all prepared again, with the current sizes.
+  needs_full_preparation_ = true;
+  if (incremental) {
+    TF_LITE_ENSURE_STATUS(PrepareResizedOpsAndTensors());
+  } else {
+    next_execution_plan_index_to_prepare_ = 0;
+    if (memory_planner_) {
+      TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+    }
 
-  TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+    TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  }
+  resized_tensors_.clear();
+  // The output sizes of ops prepared after Invoke() has resolved dynamic
+  // tensors may depend on more than the input sizes, so those ops are always
+  // all prepared again.
+  needs_full_preparation_ =
+      next_execution_plan_index_to_prepare_ != execution_plan_.size();
 
   state_ = kStateInvokable;
 
@@ -492,6 +524,7 @@ TfLiteStatus Interpreter::AddNodeWithParameters(
     return kTfLiteError;
   }
   state_ = kStateUninvokable;
+  needs_full_preparation_ = true;
 
   std::unique_ptr<void, decltype(free)*> builtin_data_deleter(builtin_data,
                                                               free);
@@ -566,6 +599,13 @@ TfLiteStatus Interpreter::ResizeInputTensor(int tensor_index,
   }
 
   state_ = kStateUninvokable;
+  // Only the consumers of graph inputs can be prepared again alone, as the
+  // producers of other tensors would resize them back.
+  if (std::find(inputs_.begin(), inputs_.end(), tensor_index) ==
+      inputs_.end()) {
+    needs_full_preparation_ = true;
+  }
+  resized_tensors_.push_back(tensor_index);
   return ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims));
 }
 
@@ -604,7 +644,15 @@ TfLiteStatus Interpreter::PrepareOpsAndTensors() {
   if (!memory_planner_) {
     memory_planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
-        /*preserve_inputs=*/true, /*preserve_intermediates*/ false));
+        /*preserve_inputs=*/true, /*preserve_intermediates*/ false,
+        kDefaultTensorAlignment, arena_planning_strategy_));
+    if (inter_op_thread_pool_) {
+      OrderExecutionPlanBySteps();
+      memory_planner_->SetNodeSteps(execution_plan_steps_);
+    }
+    if (incremental_preparation_) {
+      memory_planner_->SetPlanCacheCapacity(kArenaPlanCacheCapacity);
+    }
     memory_planner_->PlanAllocations();
   }
 
@@ -619,6 +667,64 @@ TfLiteStatus Interpreter::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::PrepareResizedOpsAndTensors() {
+  TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
+
+  std::vector<int> resized(tensors_.size(), false);
+  for (int tensor_index : resized_tensors_) {
+    resized[tensor_index] = true;
+  }
+
+  int last_exec_plan_index_prepared =
+      std::max(static_cast<int>(execution_plan_.size()) - 1, 0);
+  for (int execution_plan_index = 0;
+       execution_plan_index < execution_plan_.size(); execution_plan_index++) {
+    int node_index = execution_plan_[execution_plan_index];
+    TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    bool inputs_resized = false;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index != kOptionalTensor && resized[tensor_index]) {
+        inputs_resized = true;
+        break;
+      }
+    }
+    if (!inputs_resized) continue;
+
+    std::vector<TfLiteIntArray*> output_dims;
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      output_dims.push_back(TfLiteIntArrayCopy(tensors_[tensor_index].dims));
+    }
+    EnsureTensorsVectorCapacity();
+    TfLiteStatus status = OpPrepare(registration, &node);
+    resized.resize(tensors_.size(), false);
+    for (int i = 0; i < node.outputs->size; ++i) {
+      if (!TfLiteIntArrayEqual(output_dims[i],
+                               tensors_[node.outputs->data[i]].dims)) {
+        resized[node.outputs->data[i]] = true;
+      }
+      TfLiteIntArrayFree(output_dims[i]);
+    }
+    if (status == kTfLiteError) {
+      return ReportOpError(&context_, node, registration, node_index,
+                           "failed to prepare");
+    }
+
+    // As in PrepareOpsStartingAt(), the ops after one with dynamic outputs
+    // are prepared once Invoke() has resolved their sizes.
+    if (HasDynamicTensor(context_, node.outputs)) {
+      last_exec_plan_index_prepared = execution_plan_index;
+      break;
+    }
+  }
+
+  TF_LITE_ENSURE_STATUS(
+      memory_planner_->ExecuteAllocations(0, last_exec_plan_index_prepared));
+  next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::Invoke() {
   if (!consistent_) {
     ReportError(&context_, "Invoke called on model that is not consistent.");
@@ -646,6 +752,10 @@ TfLiteStatus Interpreter::Invoke() {
   }
 #endif
 
+  if (CanInvokeConcurrently()) {
+    return InvokeConcurrently();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -706,6 +816,199 @@ TfLiteStatus Interpreter::Invoke() {
   return status;
 }
 
+TfLiteStatus Interpreter::SetNumBufferSets(int num_buffer_sets) {
+  if (async_invoke_thread_.joinable()) {
+    ReportError(&context_, "SetNumBufferSets called before Wait.");
+    return kTfLiteError;
+  }
+  buffer_sets_.clear();
+  buffered_tensors_.clear();
+  if (num_buffer_sets <= 0) {
+    return kTfLiteOk;
+  }
+  if (state_ == kStateUninvokable) {
+    ReportError(&context_, "SetNumBufferSets called before AllocateTensors.");
+    return kTfLiteError;
+  }
+  if (next_execution_plan_index_to_prepare_ != execution_plan_.size()) {
+    ReportError(&context_,
+                "Buffer sets were requested, but dependent sized tensors are "
+                "being used.");
+    return kTfLiteError;
+  }
+  std::vector<int> tensor_indices = inputs_;
+  tensor_indices.insert(tensor_indices.end(), outputs_.begin(),
+                        outputs_.end());
+  size_t set_bytes = 0;
+  for (int tensor_index : tensor_indices) {
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    // Tensors allocated otherwise could be reallocated or freed during
+    // Invoke(), and a tensor both input and output would need two pointers.
+    if (tensor.allocation_type != kTfLiteArenaRw ||
+        std::count(tensor_indices.begin(), tensor_indices.end(),
+                   tensor_index) != 1) {
+      ReportError(&context_,
+                  "Tensor %d can't have buffer sets, it must be a single "
+                  "input or output in the arena.",
+                  tensor_index);
+      return kTfLiteError;
+    }
+    buffered_tensors_.push_back({tensor.type, tensor.bytes});
+    // Each buffer is aligned like the tensors in the arena.
+    set_bytes += (tensor.bytes + kDefaultTensorAlignment - 1) /
+                 kDefaultTensorAlignment * kDefaultTensorAlignment;
+  }
+
+  buffer_sets_.resize(num_buffer_sets);
+  for (BufferSet& buffer_set : buffer_sets_) {
+    buffer_set.memory.reset(new char[set_bytes + kDefaultTensorAlignment]);
+    const std::uintptr_t base =
+        reinterpret_cast<std::uintptr_t>(buffer_set.memory.get());
+    char* buffer = buffer_set.memory.get() +
+                   (kDefaultTensorAlignment - base % kDefaultTensorAlignment);
+    for (int i = 0; i < tensor_indices.size(); ++i) {
+      (i < inputs_.size() ? buffer_set.inputs : buffer_set.outputs)
+          .push_back(buffer);
+      buffer += (buffered_tensors_[i].bytes + kDefaultTensorAlignment - 1) /
+                kDefaultTensorAlignment * kDefaultTensorAlignment;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::InvokeAsync(int buffer_set) {
+  if (async_invoke_thread_.joinable()) {
+    ReportError(&context_, "InvokeAsync called before Wait.");
+    return kTfLiteError;
+  }
+  if (buffer_set < 0 || buffer_set >= buffer_sets_.size()) {
+    ReportError(&context_, "Invalid buffer set %d, there are %d.", buffer_set,
+                static_cast<int>(buffer_sets_.size()));
+    return kTfLiteError;
+  }
+  // The tensors must still fit the buffers, and must not be reallocated by
+  // Invoke().
+  bool tensors_changed =
+      next_execution_plan_index_to_prepare_ != execution_plan_.size();
+  for (int i = 0; i < inputs_.size(); ++i) {
+    tensors_changed |= tensors_[inputs_[i]].bytes != buffered_tensors_[i].bytes;
+  }
+  for (int i = 0; i < outputs_.size(); ++i) {
+    tensors_changed |= tensors_[outputs_[i]].bytes !=
+                       buffered_tensors_[inputs_.size() + i].bytes;
+  }
+  if (tensors_changed) {
+    ReportError(&context_,
+                "Tensors changed since SetNumBufferSets, it must be called "
+                "again.");
+    return kTfLiteError;
+  }
+  async_invoke_thread_ = std::thread([this, buffer_set]() {
+    async_invoke_status_ = InvokeWithBufferSet(buffer_set);
+  });
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::Wait() {
+  if (!async_invoke_thread_.joinable()) {
+    ReportError(&context_, "Wait called without InvokeAsync.");
+    return kTfLiteError;
+  }
+  async_invoke_thread_.join();
+  return async_invoke_status_;
+}
+
+TfLiteStatus Interpreter::InvokeWithBufferSet(int buffer_set) {
+  const BufferSet& buffers = buffer_sets_[buffer_set];
+  std::vector<char*> arena_data;
+  for (int i = 0; i < inputs_.size(); ++i) {
+    arena_data.push_back(tensors_[inputs_[i]].data.raw);
+    tensors_[inputs_[i]].data.raw = buffers.inputs[i];
+  }
+  for (int i = 0; i < outputs_.size(); ++i) {
+    arena_data.push_back(tensors_[outputs_[i]].data.raw);
+    tensors_[outputs_[i]].data.raw = buffers.outputs[i];
+  }
+  TfLiteStatus status = Invoke();
+  for (int i = 0; i < inputs_.size(); ++i) {
+    tensors_[inputs_[i]].data.raw = arena_data[i];
+  }
+  for (int i = 0; i < outputs_.size(); ++i) {
+    tensors_[outputs_[i]].data.raw = arena_data[inputs_.size() + i];
+  }
+  return status;
+}
+
+void Interpreter::OrderExecutionPlanBySteps() {
+  std::vector<int> steps = CalculateNodeSteps(InterpreterInfo(this));
+  std::vector<int> order(execution_plan_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&steps](int a, int b) { return steps[a] < steps[b]; });
+
+  std::vector<int> execution_plan;
+  execution_plan_steps_.clear();
+  for (int i : order) {
+    execution_plan.push_back(execution_plan_[i]);
+    execution_plan_steps_.push_back(steps[i]);
+  }
+  execution_plan_ = execution_plan;
+}
+
+bool Interpreter::CanInvokeConcurrently() {
+  if (!inter_op_thread_pool_ || profiler_ ||
+      execution_plan_steps_.size() != execution_plan_.size() ||
+      next_execution_plan_index_to_prepare_ != execution_plan_.size()) {
+    return false;
+  }
+  for (int node_index : execution_plan_) {
+    if (nodes_and_registration_[node_index].first.delegate) {
+      return false;
+    }
+  }
+  // Resizing dynamic tensors would call for preparing the following nodes
+  // while others run.
+  for (const TfLiteTensor& tensor : tensors_) {
+    if (tensor.allocation_type == kTfLiteDynamic || tensor.delegate) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TfLiteStatus Interpreter::InvokeConcurrently() {
+  EnsureTensorsVectorCapacity();
+  std::vector<TfLiteStatus> statuses(execution_plan_.size(), kTfLiteOk);
+  int step_begin = 0;
+  while (step_begin < execution_plan_.size()) {
+    int step_end = step_begin + 1;
+    while (step_end < execution_plan_.size() &&
+           execution_plan_steps_[step_end] ==
+               execution_plan_steps_[step_begin]) {
+      ++step_end;
+    }
+    inter_op_thread_pool_->ParallelFor(
+        step_end - step_begin, [this, step_begin, &statuses](int i) {
+          const int execution_plan_index = step_begin + i;
+          const int node_index = execution_plan_[execution_plan_index];
+          TfLiteNode& node = nodes_and_registration_[node_index].first;
+          const TfLiteRegistration& registration =
+              nodes_and_registration_[node_index].second;
+          if (OpInvoke(registration, &node) == kTfLiteError) {
+            statuses[execution_plan_index] =
+                ReportOpError(&context_, node, registration, node_index,
+                              "failed to invoke");
+          }
+        });
+    step_begin = step_end;
+  }
+
+  for (TfLiteStatus status : statuses) {
+    if (status != kTfLiteOk) return status;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::ResizeTensor(TfLiteContext* context,
                                        TfLiteTensor* tensor,
                                        TfLiteIntArray* new_size) {
@@ -801,10 +1104,15 @@ TfLiteStatus Interpreter::SetTensorParametersReadOnly(
     tensor.data.raw = const_cast<char*>(buffer);
     if (!tensor.dims) tensor.dims = ConvertArrayToTfLiteIntArray(rank, dims);
     tensor.params = quantization;
+    TfLiteAffineQuantizationFree(tensor.quantization);
+    tensor.quantization = nullptr;
+    TfLiteSparsityFree(tensor.sparsity);
+    tensor.sparsity = nullptr;
     tensor.allocation_type = kTfLiteMmapRo;
     tensor.allocation = allocation;
   } else {
     state_ = kStateUninvokable;
+    needs_full_preparation_ = true;
     TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(rank, dims),
                       quantization, const_cast<char*>(buffer), bytes,
                       kTfLiteMmapRo, allocation, false, &tensor);
@@ -812,6 +1120,58 @@ TfLiteStatus Interpreter::SetTensorParametersReadOnly(
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetTensorParametersReadOnlySparse(
+    int tensor_index, TfLiteType type, const char* name,
+    const std::vector<int>& dims, TfLiteQuantizationParams quantization,
+    int block_size, const std::vector<int>& row_segments,
+    const std::vector<int>& block_indices, const char* buffer, size_t bytes,
+    const Allocation* allocation) {
+  if (state_ == kStateInvokableAndImmutable) {
+    ReportError(&context_,
+                "SetTensorParametersReadOnlySparse is disallowed when graph "
+                "is immutable.");
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE(&context_,
+                 tensor_index < context_.tensors_size && tensor_index >= 0);
+  TF_LITE_ENSURE_EQ(&context_, type, kTfLiteFloat32);
+  TF_LITE_ENSURE(&context_, !dims.empty() && block_size > 0);
+  // The tensor is seen as a matrix, whose rows are made of whole blocks.
+  const int rows = dims[0];
+  int cols = 1;
+  for (int i = 1; i < dims.size(); ++i) {
+    cols *= dims[i];
+  }
+  TF_LITE_ENSURE_EQ(&context_, cols % block_size, 0);
+  const int num_blocks = block_indices.size();
+  TF_LITE_ENSURE_EQ(&context_, static_cast<int>(row_segments.size()),
+                    rows + 1);
+  TF_LITE_ENSURE_EQ(&context_, row_segments[0], 0);
+  TF_LITE_ENSURE_EQ(&context_, row_segments[rows], num_blocks);
+  for (int r = 0; r < rows; ++r) {
+    TF_LITE_ENSURE(&context_, row_segments[r] <= row_segments[r + 1]);
+  }
+  for (int block_index : block_indices) {
+    TF_LITE_ENSURE(&context_,
+                   block_index >= 0 && block_index < cols / block_size);
+  }
+  TF_LITE_ENSURE(&context_, bytes == num_blocks * block_size * sizeof(float));
+
+  state_ = kStateUninvokable;
+  needs_full_preparation_ = true;
+  TfLiteTensor& tensor = context_.tensors[tensor_index];
+  TfLiteTensorReset(type, name, ConvertVectorToTfLiteIntArray(dims),
+                    quantization, const_cast<char*>(buffer), bytes,
+                    kTfLiteMmapRo, allocation, false, &tensor);
+  auto* sparsity =
+      static_cast<TfLiteSparsity*>(malloc(sizeof(TfLiteSparsity)));
+  sparsity->block_size = block_size;
+  sparsity->row_segments = ConvertVectorToTfLiteIntArray(row_segments);
+  sparsity->block_indices = ConvertVectorToTfLiteIntArray(block_indices);
+  tensor.sparsity = sparsity;
+  return kTfLiteOk;
+}
+
 // Set description of inputs/outputs/data/fptrs for node `node_index`.
 // This variant assumes an external buffer has been allocated of size
 // bytes. The lifetime of buffer must be ensured to be greater or equal
@@ -856,11 +1216,45 @@ TfLiteStatus Interpreter::SetTensorParametersReadWrite(
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetTensorPerChannelQuantization(
+    int tensor_index, const std::vector<float>& scales,
+    const std::vector<int>& zero_points, int quantized_dimension) {
+  if (state_ == kStateInvokableAndImmutable) {
+    ReportError(&context_,
+                "SetTensorPerChannelQuantization is disallowed when graph is "
+                "immutable.");
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE(&context_,
+                 tensor_index < context_.tensors_size && tensor_index >= 0);
+  TfLiteTensor& tensor = context_.tensors[tensor_index];
+  TF_LITE_ENSURE(&context_, tensor.dims != nullptr);
+  TF_LITE_ENSURE(&context_, quantized_dimension >= 0 &&
+                                quantized_dimension < tensor.dims->size);
+  TF_LITE_ENSURE_EQ(&context_, scales.size(),
+                    tensor.dims->data[quantized_dimension]);
+  TF_LITE_ENSURE_EQ(&context_, zero_points.size(), scales.size());
+
+  auto* quantization = static_cast<TfLiteAffineQuantization*>(
+      malloc(sizeof(TfLiteAffineQuantization)));
+  quantization->scale = TfLiteFloatArrayCreate(scales.size());
+  quantization->zero_point = TfLiteIntArrayCreate(zero_points.size());
+  std::copy(scales.begin(), scales.end(), quantization->scale->data);
+  std::copy(zero_points.begin(), zero_points.end(),
+            quantization->zero_point->data);
+  quantization->quantized_dimension = quantized_dimension;
+  TfLiteAffineQuantizationFree(tensor.quantization);
+  tensor.quantization = quantization;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Interpreter::SetExecutionPlan(const std::vector<int>& new_plan) {
   for (int node_index : new_plan) {
     TF_LITE_ENSURE(&context_, node_index >= 0 && node_index < nodes_size());
   }
   execution_plan_ = new_plan;
+  execution_plan_steps_.clear();
+  needs_full_preparation_ = true;
   return kTfLiteOk;
 }
 
@@ -915,6 +1309,55 @@ void Interpreter::UseNNAPI(bool enable) {
 #endif
 }
 
+void Interpreter::SetNumInterOpThreads(int num_threads) {
+  const int current_num_threads =
+      inter_op_thread_pool_ ? inter_op_thread_pool_->num_threads() : 1;
+  if (std::max(num_threads, 1) == current_num_threads) return;
+  inter_op_thread_pool_.reset(
+      num_threads > 1 ? new InterOpThreadPool(num_threads) : nullptr);
+  execution_plan_steps_.clear();
+  // The execution plan is ordered and the tensors planned again by the next
+  // AllocateTensors().
+  memory_planner_.reset();
+  state_ = kStateUninvokable;
+}
+
+void Interpreter::SetCacheTransformedWeights(bool enable) {
+  if (context_.cache_transformed_weights == enable) return;
+  context_.cache_transformed_weights = enable;
+  // The ops are all prepared again by the next AllocateTensors().
+  needs_full_preparation_ = true;
+  state_ = kStateUninvokable;
+}
+
+void Interpreter::SetIncrementalPreparation(bool enable) {
+  incremental_preparation_ = enable;
+  if (memory_planner_) {
+    memory_planner_->SetPlanCacheCapacity(enable ? kArenaPlanCacheCapacity
+                                                 : 0);
+  }
+}
+
+void Interpreter::SetArenaPlanningStrategy(ArenaPlanningStrategy strategy) {
+  if (strategy == arena_planning_strategy_) return;
+  arena_planning_strategy_ = strategy;
+  // The planner is recreated with the new strategy by the next
+  // AllocateTensors().
+  memory_planner_.reset();
+  state_ = kStateUninvokable;
+}
+
+TfLiteStatus Interpreter::GetArenaSizes(size_t* planned_bytes,
+                                        size_t* lower_bound_bytes) {
+  if (!memory_planner_ || state_ == kStateUninvokable) {
+    ReportError(&context_, "GetArenaSizes called before AllocateTensors.");
+    return kTfLiteError;
+  }
+  *planned_bytes = memory_planner_->ArenaSize();
+  *lower_bound_bytes = memory_planner_->LowerBoundArenaSize();
+  return kTfLiteOk;
+}
+
 void Interpreter::SetNumThreads(int num_threads) {
   context_.recommended_num_threads = num_threads;
 
@@ -926,6 +1369,20 @@ void Interpreter::SetNumThreads(int num_threads) {
   }
 }
 
+TfLiteStatus Interpreter::UseSharedExternalContext(
+    TfLiteExternalContext* shared_context) {
+  switch (shared_context->type) {
+    case kTfLiteEigenContext:
+      return eigen_support::UseSharedContext(&context_, shared_context);
+    case kTfLiteGemmLowpContext:
+      return gemm_support::UseSharedContext(&context_, shared_context);
+    default:
+      ReportError(&context_, "Unsupported shared external context type %d.",
+                  shared_context->type);
+      return kTfLiteError;
+  }
+}
+
 void Interpreter::SwitchToDelegateContext() {
   context_.GetNodeAndRegistration = GetNodeAndRegistration;
   context_.ReplaceSubgraphsWithDelegateKernels =
@@ -977,6 +1434,7 @@ TfLiteStatus Interpreter::ModifyGraphWithDelegate(TfLiteDelegate* delegate,
   if (!allow_dynamic_tensors) {
     // Reset the state to force tensor/op reallocation.
     state_ = kStateUninvokable;
+    needs_full_preparation_ = true;
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
     TF_LITE_ENSURE_EQ(&context_, state_, kStateInvokable);
     // After using a delegate which doesn't support dynamic tensors, make the
@@ -20,11 +20,15 @@ limitations under the License.
 #include <complex>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "tensorflow/contrib/lite/allocation.h"
+#include "tensorflow/contrib/lite/arena_planner.h"
 #include "tensorflow/contrib/lite/context.h"
 #include "tensorflow/contrib/lite/error_reporter.h"
+#include "tensorflow/contrib/lite/inter_op_scheduler.h"
 #include "tensorflow/contrib/lite/memory_planner.h"
 #include "tensorflow/contrib/lite/profiling/profiler.h"
 
@@ -56,6 +60,10 @@ constexpr TfLiteType typeToTfLiteType<unsigned char>() {
   return kTfLiteUInt8;
 }
 template <>
+constexpr TfLiteType typeToTfLiteType<int8_t>() {
+  return kTfLiteInt8;
+}
+template <>
 constexpr TfLiteType typeToTfLiteType<bool>() {
   return kTfLiteBool;
 }
@@ -112,7 +120,12 @@ class Interpreter {
   //
   // Note, if error_reporter is nullptr, then a default StderrReporter is
   // used. Ownership of 'error_reporter' remains with the caller.
-  explicit Interpreter(ErrorReporter* error_reporter = DefaultErrorReporter());
+  //
+  // 'arena_planning_strategy' selects how the memory of the tensors is laid
+  // out in the arena; see ArenaPlanningStrategy.
+  explicit Interpreter(ErrorReporter* error_reporter = DefaultErrorReporter(),
+                       ArenaPlanningStrategy arena_planning_strategy =
+                           ArenaPlanningStrategy::kExecutionOrder);
 
   ~Interpreter();
 
@@ -172,6 +185,18 @@ class Interpreter {
       const int* dims, TfLiteQuantizationParams quantization,
       const char* buffer, size_t bytes, const Allocation* allocation = nullptr);
 
+  // Same as SetTensorParametersReadOnly(), for a float tensor whose `buffer`
+  // holds only the nonzero blocks of its values, in the block compressed
+  // sparse row format described by `block_size`, `row_segments` and
+  // `block_indices`, see TfLiteSparsity.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetTensorParametersReadOnlySparse(
+      int tensor_index, TfLiteType type, const char* name,
+      const std::vector<int>& dims, TfLiteQuantizationParams quantization,
+      int block_size, const std::vector<int>& row_segments,
+      const std::vector<int>& block_indices, const char* buffer, size_t bytes,
+      const Allocation* allocation = nullptr);
+
   // Set description of inputs/outputs/data/fptrs for node `node_index`.
   // This variant assumes an external buffer has been allocated of size
   // bytes. The lifetime of buffer must be ensured to be greater or equal
@@ -188,6 +213,15 @@ class Interpreter {
       const int* dims, TfLiteQuantizationParams quantization,
       bool is_variable = false);
 
+  // Quantizes tensor `tensor_index` per channel along `quantized_dimension`,
+  // with one scale and zero point per index of that dimension. Must follow
+  // the SetTensorParameters*() call for the tensor, whose `quantization` then
+  // holds the parameters of the first channel.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetTensorPerChannelQuantization(
+      int tensor_index, const std::vector<float>& scales,
+      const std::vector<int>& zero_points, int quantized_dimension);
+
   // Functions to access tensor data
 
   // Read only access to list of inputs.
@@ -300,6 +334,29 @@ class Interpreter {
     return typed_tensor<T>(outputs_[index]);
   }
 
+  // Return a checked cast of the buffer of a given input tensor in a set made
+  // by SetNumBufferSets(). The given indices must be between 0 and
+  // num_buffer_sets() and inputs().size() respectively.
+  template <class T>
+  T* typed_input_buffer(int buffer_set, int index) {
+    if (buffered_tensors_[index].type == typeToTfLiteType<T>()) {
+      return reinterpret_cast<T*>(buffer_sets_[buffer_set].inputs[index]);
+    }
+    return nullptr;
+  }
+
+  // Return a checked cast of the buffer of a given output tensor in a set
+  // made by SetNumBufferSets(). The given indices must be between 0 and
+  // num_buffer_sets() and outputs().size() respectively.
+  template <class T>
+  T* typed_output_buffer(int buffer_set, int index) {
+    if (buffered_tensors_[inputs_.size() + index].type ==
+        typeToTfLiteType<T>()) {
+      return reinterpret_cast<T*>(buffer_sets_[buffer_set].outputs[index]);
+    }
+    return nullptr;
+  }
+
   // Change the dimensionality of a given tensor. Note, this is only acceptable
   // for tensor indices that are inputs.
   // Returns status of failure or success.
@@ -324,12 +381,90 @@ class Interpreter {
   // Returns status of success or failure.
   TfLiteStatus Invoke();
 
+  // Give each input and output tensor 'num_buffer_sets' buffers of its own,
+  // accessed with typed_input_buffer() and typed_output_buffer(), so that the
+  // application can fill the inputs of one set and read the outputs of
+  // another while InvokeAsync() runs with a third, e.g. to preprocess the
+  // next camera frame during inference. Must be called after
+  // AllocateTensors(), and again after inputs are resized. The inputs and
+  // outputs must be allocated in the arena, and no tensor may be dynamic. 0
+  // frees the buffers.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumBufferSets(int num_buffer_sets);
+
+  int num_buffer_sets() const { return buffer_sets_.size(); }
+
+  // Starts an Invoke() on another thread, with the input and output tensors
+  // reading and writing the buffers of 'buffer_set', and returns without
+  // waiting for it. Until Wait() returns, the application must not access
+  // the buffers of that set, nor call methods of the interpreter other than
+  // the accessors of the other buffer sets.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus InvokeAsync(int buffer_set);
+
+  // Blocks until the Invoke() started by InvokeAsync() is done, and returns
+  // its status.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus Wait();
+
   // Enable or disable the NN API (true to enable)
   void UseNNAPI(bool enable);
 
-  // Set the number of threads available to the interpreter.
+  // Set the number of threads available to the interpreter. With a shared
+  // context (see UseSharedExternalContext()) this only limits the threads
+  // the ops of this interpreter use from it.
   void SetNumThreads(int num_threads);
 
+  // Makes the ops of this interpreter use 'shared_context', as returned by
+  // eigen_support::CreateSharedContext() or
+  // gemm_support::CreateSharedContext(), instead of starting threads of their
+  // own, so that several interpreters share one thread pool. The caller keeps
+  // 'shared_context' alive until this interpreter is destroyed.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus UseSharedExternalContext(TfLiteExternalContext* shared_context);
+
+  // Set the number of threads running independent nodes concurrently. With
+  // more than one, AllocateTensors() reorders the execution plan so that
+  // nodes depending on no earlier ones come first, then those only depending
+  // on these, and so on, and keeps the tensors of each such step apart in
+  // the arena. Invoke() then runs the nodes of each step concurrently, unless
+  // a tensor is dynamic or held by a delegate, or a profiler is set, in which
+  // case it runs them one after the other as usual. Kernels sharing state
+  // through the TfLiteContext must be safe to run concurrently. Takes effect
+  // at the next AllocateTensors().
+  // WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int num_threads);
+
+  // Whether kernels keep the weights they transform, e.g. transpose to the
+  // layout they read, in persistent tensors so that constant weights are
+  // transformed once rather than at every Invoke(). Enabled by default,
+  // disabling it saves that memory. Takes effect at the next
+  // AllocateTensors().
+  // WARNING: This is an experimental API and subject to change.
+  void SetCacheTransformedWeights(bool enable);
+
+  // Changes the strategy given at construction, e.g. for interpreters made by
+  // an InterpreterBuilder. Takes effect at the next AllocateTensors().
+  // WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanningStrategy(ArenaPlanningStrategy strategy);
+
+  // Sets 'planned_bytes' to the size of the arena holding the tensors that
+  // are not persistent, and 'lower_bound_bytes' to the largest total size of
+  // those that are live at the same time, which no plan can go below. Fails
+  // if the tensors have not been allocated.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus GetArenaSizes(size_t* planned_bytes, size_t* lower_bound_bytes);
+
+  // When enabled, AllocateTensors() after resizing inputs with
+  // ResizeInputTensor() only prepares again the nodes whose input sizes
+  // changed, and the arena plans made for the last few sets of tensor sizes
+  // are kept and reused, e.g. for models fed variable length sequences. This
+  // requires that the nodes not prepared again keep their output sizes. It
+  // applies after a first AllocateTensors() that prepared all the nodes, and
+  // as long as the graph is not otherwise modified.
+  // WARNING: This is an experimental API and subject to change.
+  void SetIncrementalPreparation(bool enable);
+
   // Allow a delegate to look at the graph and modify the graph to handle
   // parts of the graph themselves. After this is called, the graph may
   // contain new nodes that replace 1 more nodes.
@@ -464,6 +599,11 @@ class Interpreter {
   TfLiteStatus PrepareOpsStartingAt(int first_execution_plan_index,
                                     int* last_execution_plan_index_prepared);
 
+  // Like resetting the allocations and calling PrepareOpsAndTensors(), but
+  // only calls OpPrepare() for the ops whose inputs were resized since the
+  // last AllocateTensors(), directly or through the outputs of other ops.
+  TfLiteStatus PrepareResizedOpsAndTensors();
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -627,10 +767,64 @@ class Interpreter {
   // Whether to delegate to NN API
   std::unique_ptr<NNAPIDelegate> nnapi_delegate_;
 
-  std::unique_ptr<MemoryPlanner> memory_planner_;
+  // Sorts the execution plan by the steps computed by CalculateNodeSteps(),
+  // and records them in 'execution_plan_steps_'.
+  void OrderExecutionPlanBySteps();
+
+  // Whether Invoke() can run the nodes of each step concurrently.
+  bool CanInvokeConcurrently();
+
+  // Runs the nodes of each step of the execution plan concurrently.
+  TfLiteStatus InvokeConcurrently();
+
+  // Runs Invoke() with the input and output tensors pointing at the buffers
+  // of 'buffer_set', and points them back at the arena afterwards.
+  TfLiteStatus InvokeWithBufferSet(int buffer_set);
+
+  // The buffers of the inputs and outputs in a set made by
+  // SetNumBufferSets(), in the order of 'inputs_' and 'outputs_'.
+  struct BufferSet {
+    std::unique_ptr<char[]> memory;
+    std::vector<char*> inputs;
+    std::vector<char*> outputs;
+  };
+  std::vector<BufferSet> buffer_sets_;
+
+  // The inputs, then the outputs, as they were when the buffer sets were
+  // made. Kept apart from the tensors, which Invoke() may reallocate while the
+  // buffers are accessed.
+  struct BufferedTensor {
+    TfLiteType type;
+    size_t bytes;
+  };
+  std::vector<BufferedTensor> buffered_tensors_;
+
+  // Runs the Invoke() started by InvokeAsync() until Wait() joins it.
+  std::thread async_invoke_thread_;
+  TfLiteStatus async_invoke_status_ = kTfLiteOk;
+
+  ArenaPlanningStrategy arena_planning_strategy_;
+  std::unique_ptr<ArenaPlanner> memory_planner_;
+
+  // Set if SetNumInterOpThreads() asked for more than one thread.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // The step of each node of the execution plan, once ordered by
+  // OrderExecutionPlanBySteps().
+  std::vector<int> execution_plan_steps_;
 
   bool allow_buffer_handle_output_ = false;
 
+  // Set by SetIncrementalPreparation().
+  bool incremental_preparation_ = false;
+
+  // Whether the next AllocateTensors() must prepare all the ops, rather than
+  // those affected by the tensors in 'resized_tensors_'.
+  bool needs_full_preparation_ = true;
+
+  // The inputs resized since the last AllocateTensors().
+  std::vector<int> resized_tensors_;
+
   // Tracking bit for whether a tensor was resized in the course of an op
   // invocation. This is a useful hint to ensure that dynamic tensor outputs
   // trigger downstream reallocation after op invocation.
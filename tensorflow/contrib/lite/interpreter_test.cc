@@ -17,6 +17,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "tensorflow/contrib/lite/error_reporter.h"
 #include "tensorflow/contrib/lite/kernels/internal/compatibility.h"
+#include "tensorflow/contrib/lite/kernels/gemm_support.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/schema/schema_generated.h"
 #include "tensorflow/contrib/lite/string_util.h"
@@ -268,6 +269,224 @@ TEST(BasicInterpreter, CheckArenaAllocation) {
   ASSERT_EQ(interpreter.tensor(9)->data.raw, interpreter.tensor(5)->data.raw);
 }
 
+TEST(BasicInterpreter, GreedyBySizeArenaAllocation) {
+  size_t planned_bytes[2];
+  size_t lower_bound_bytes[2];
+  for (int i = 0; i < 2; ++i) {
+    Interpreter interpreter(DefaultErrorReporter(),
+                            i == 0 ? ArenaPlanningStrategy::kExecutionOrder
+                                   : ArenaPlanningStrategy::kGreedyBySize);
+    ASSERT_EQ(interpreter.AddTensors(10), kTfLiteOk);
+
+    TfLiteQuantizationParams quant;
+    TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+
+    std::vector<int> sizes{2048, 4096, 1023, 2047, 1021,
+                           2047, 1023, 2046, 0,    2048};
+    for (int j = 0; j < sizes.size(); ++j) {
+      interpreter.SetTensorParametersReadWrite(j, kTfLiteUInt8, "", {sizes[j]},
+                                               quant);
+    }
+    interpreter.SetInputs({0, 1});
+    interpreter.SetOutputs({9, 4});
+    interpreter.AddNodeWithParameters({0, 1}, {2, 3}, nullptr, 0, nullptr,
+                                      &reg);
+    interpreter.AddNodeWithParameters({2, 1}, {4, 5}, nullptr, 0, nullptr,
+                                      &reg);
+    interpreter.AddNodeWithParameters({4, 3}, {6, 7}, nullptr, 0, nullptr,
+                                      &reg);
+    interpreter.AddNodeWithParameters({6, 5}, {8}, nullptr, 0, nullptr, &reg);
+    interpreter.AddNodeWithParameters({8, 7}, {9}, nullptr, 0, nullptr, &reg);
+
+    ASSERT_NE(interpreter.GetArenaSizes(&planned_bytes[i],
+                                        &lower_bound_bytes[i]),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+    ASSERT_EQ(
+        interpreter.GetArenaSizes(&planned_bytes[i], &lower_bound_bytes[i]),
+        kTfLiteOk);
+  }
+  // The third op needs #0, #1, #3, #4, #5, #6 and #7 at once.
+  EXPECT_EQ(lower_bound_bytes[0], 14328);
+  EXPECT_EQ(lower_bound_bytes[1], 14328);
+  EXPECT_GE(planned_bytes[1], lower_bound_bytes[1]);
+  EXPECT_LE(planned_bytes[1], planned_bytes[0]);
+}
+
+TEST(BasicInterpreter, ConcurrentInvoke) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quant),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+
+  // Adds one to the sum of the inputs.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    for (int i = 0; i < 3; ++i) {
+      output->data.f[i] = 1;
+      for (int j = 0; j < node->inputs->size; ++j) {
+        output->data.f[i] += context->tensors[node->inputs->data[j]].data.f[i];
+      }
+    }
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1}, {4}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({4, 2}, {3}, nullptr, 0,
+                                              nullptr, &reg),
+            kTfLiteOk);
+
+  interpreter.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  // The third node only depends on the input, so it runs with the first.
+  ASSERT_EQ(interpreter.execution_plan(), std::vector<int>({0, 2, 1, 3}));
+
+  for (float x : {0.0f, 1.0f, -2.5f}) {
+    for (int i = 0; i < 3; ++i) {
+      interpreter.typed_tensor<float>(0)[i] = x + i;
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], 2 * (x + i) + 4);
+    }
+  }
+}
+
+TEST(BasicInterpreter, AsyncInvokeWithBufferSets) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(3), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quant),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2}), kTfLiteOk);
+
+  // Adds one to the input.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    for (int i = 0; i < input->dims->data[0]; ++i) {
+      output->data.f[i] = input->data.f[i] + 1;
+    }
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+
+  ASSERT_EQ(interpreter.SetNumBufferSets(2), kTfLiteError);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter.InvokeAsync(0), kTfLiteError);
+  ASSERT_EQ(interpreter.SetNumBufferSets(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.num_buffer_sets(), 2);
+  EXPECT_EQ(interpreter.typed_input_buffer<int>(0, 0), nullptr);
+  EXPECT_NE(interpreter.typed_input_buffer<float>(0, 0),
+            interpreter.typed_input_buffer<float>(1, 0));
+  EXPECT_NE(interpreter.typed_output_buffer<float>(0, 0),
+            interpreter.typed_output_buffer<float>(1, 0));
+  for (int i = 0; i < 3; ++i) {
+    interpreter.typed_input_tensor<float>(0)[i] = -1;
+    interpreter.typed_input_buffer<float>(0, 0)[i] = i;
+  }
+
+  ASSERT_EQ(interpreter.InvokeAsync(0), kTfLiteOk);
+  EXPECT_EQ(interpreter.InvokeAsync(1), kTfLiteError);
+  // The other set can be filled during the inference.
+  for (int i = 0; i < 3; ++i) {
+    interpreter.typed_input_buffer<float>(1, 0)[i] = 10 + i;
+  }
+  ASSERT_EQ(interpreter.Wait(), kTfLiteOk);
+  EXPECT_EQ(interpreter.Wait(), kTfLiteError);
+  ASSERT_EQ(interpreter.InvokeAsync(1), kTfLiteOk);
+  ASSERT_EQ(interpreter.Wait(), kTfLiteOk);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter.typed_output_buffer<float>(0, 0)[i], i + 2);
+    EXPECT_EQ(interpreter.typed_output_buffer<float>(1, 0)[i], i + 12);
+    // The tensors still point at the arena, as used by Invoke().
+    EXPECT_EQ(interpreter.typed_input_tensor<float>(0)[i], -1);
+  }
+  EXPECT_EQ(interpreter.InvokeAsync(2), kTfLiteError);
+
+  // Resizing the input requires new buffers.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {4}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(interpreter.InvokeAsync(0), kTfLiteError);
+  ASSERT_EQ(interpreter.SetNumBufferSets(1), kTfLiteOk);
+  for (int i = 0; i < 4; ++i) {
+    interpreter.typed_input_buffer<float>(0, 0)[i] = i;
+  }
+  ASSERT_EQ(interpreter.InvokeAsync(0), kTfLiteOk);
+  ASSERT_EQ(interpreter.Wait(), kTfLiteOk);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(interpreter.typed_output_buffer<float>(0, 0)[i], i + 2);
+  }
+}
+
+TEST(BasicInterpreter, CacheTransformedWeights) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(2), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quant),
+              kTfLiteOk);
+  }
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({1}), kTfLiteOk);
+
+  // Records the setting seen by the last Prepare().
+  static bool cache_transformed_weights;
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    cache_transformed_weights = context->cache_transformed_weights;
+    return kTfLiteOk;
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &reg),
+            kTfLiteOk);
+
+  cache_transformed_weights = false;
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_TRUE(cache_transformed_weights);
+
+  // The ops are prepared again with the new setting.
+  interpreter.SetCacheTransformedWeights(false);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteError);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_FALSE(cache_transformed_weights);
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+}
+
 TEST(BasicInterpreter, BufferAccess) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(1), kTfLiteOk);
@@ -754,6 +973,101 @@ TEST(BasicInterpreter, DynamicTensorsResizeDescendants) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 10 * 14);
 }
 
+// The outputs of the nodes prepared by the op below.
+std::vector<int> prepared_outputs;
+
+TEST(BasicInterpreter, IncrementalPreparation) {
+  Interpreter interpreter;
+  interpreter.SetIncrementalPreparation(true);
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 4}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quant),
+              kTfLiteOk);
+  }
+
+  // Copies its input to its output.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    prepared_outputs.push_back(node->outputs->data[0]);
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    memcpy(output->data.raw, input->data.raw, input->bytes);
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({2}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {4}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+
+  prepared_outputs.clear();
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(prepared_outputs, std::vector<int>({2, 3, 4}));
+  size_t planned_bytes, lower_bound_bytes;
+  ASSERT_EQ(interpreter.GetArenaSizes(&planned_bytes, &lower_bound_bytes),
+            kTfLiteOk);
+
+  // Only the nodes depending on the resized input are prepared again.
+  prepared_outputs.clear();
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {5}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(prepared_outputs, std::vector<int>({2, 3}));
+  ASSERT_EQ(interpreter.tensor(3)->bytes, 5 * sizeof(float));
+  ASSERT_EQ(interpreter.tensor(4)->bytes, 3 * sizeof(float));
+  for (int i = 0; i < 5; ++i) {
+    interpreter.typed_tensor<float>(0)[i] = i;
+  }
+  for (int i = 0; i < 3; ++i) {
+    interpreter.typed_tensor<float>(1)[i] = -i;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(3)[i], i);
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], -i);
+  }
+
+  prepared_outputs.clear();
+  ASSERT_EQ(interpreter.ResizeInputTensor(1, {2}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(prepared_outputs, std::vector<int>({4}));
+  ASSERT_EQ(interpreter.tensor(4)->bytes, 2 * sizeof(float));
+
+  // Back to the first shapes, which get their first plan again.
+  prepared_outputs.clear();
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {3}), kTfLiteOk);
+  ASSERT_EQ(interpreter.ResizeInputTensor(1, {3}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(prepared_outputs, std::vector<int>({2, 3, 4}));
+  size_t cached_planned_bytes;
+  ASSERT_EQ(
+      interpreter.GetArenaSizes(&cached_planned_bytes, &lower_bound_bytes),
+      kTfLiteOk);
+  EXPECT_EQ(cached_planned_bytes, planned_bytes);
+
+  // Without incremental preparation, all the nodes are prepared again.
+  interpreter.SetIncrementalPreparation(false);
+  prepared_outputs.clear();
+  ASSERT_EQ(interpreter.ResizeInputTensor(1, {4}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(prepared_outputs, std::vector<int>({2, 3, 4}));
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
@@ -835,6 +1149,28 @@ TEST_F(InterpreterTest, GetSetResetExternalContexts) {
   interpreter_.SetNumThreads(4);
 }
 
+TEST(BasicInterpreter, UseSharedExternalContext) {
+  TfLiteExternalContext* shared_context = gemm_support::CreateSharedContext(4);
+  {
+    Interpreter interpreter1;
+    Interpreter interpreter2;
+    ASSERT_EQ(interpreter1.UseSharedExternalContext(shared_context),
+              kTfLiteOk);
+    ASSERT_EQ(interpreter2.UseSharedExternalContext(shared_context),
+              kTfLiteOk);
+    // Refreshing one interpreter leaves the shared context alone.
+    interpreter1.SetNumThreads(2);
+
+    // Only one shared context of each type per interpreter.
+    TfLiteExternalContext* other = gemm_support::CreateSharedContext(1);
+    EXPECT_EQ(interpreter1.UseSharedExternalContext(other), kTfLiteError);
+    gemm_support::ReleaseSharedContext(other);
+  }
+  // Still held by this test once the interpreters are gone.
+  EXPECT_EQ(shared_context->type, kTfLiteGemmLowpContext);
+  gemm_support::ReleaseSharedContext(shared_context);
+}
+
 // Test fixture that allows playing with execution plans. It creates a two
 // node graph that can be executed in either [0,1] order or [1,0] order.
 // The CopyOp records when it is invoked in the class member run_order_
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include "tensorflow/contrib/lite/builtin_op_data.h"
 #include "tensorflow/contrib/lite/context.h"
@@ -28,8 +29,10 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/internal/optimized/multithreaded_conv.h"
 #include "tensorflow/contrib/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/contrib/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/contrib/lite/kernels/internal/reference/conv_int8.h"
 #include "tensorflow/contrib/lite/kernels/internal/reference/reference_ops.h"
 #include "tensorflow/contrib/lite/kernels/internal/tensor.h"
+#include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
 #include "tensorflow/contrib/lite/kernels/padding.h"
@@ -59,13 +62,17 @@ struct OpData {
   // IDs are the arbitrary identifiers used by TF Lite to identify and access
   // memory buffers.
   int im2col_id = kTensorNotAllocated;
-  int hwcn_weights_id = kTensorNotAllocated;
+  int transposed_filter_id = kTensorNotAllocated;
 
   TfLitePaddingValues padding;
   // The scaling factor from input to output (aka the 'real multiplier') can
   // be represented as a fixed point multiplier plus a left shift.
   int32_t output_multiplier;
   int output_shift;
+  // Per output channel multipliers and shifts, for int8 filters quantized per
+  // channel. Unlike 'output_shift', these shifts are positive to the left.
+  std::vector<int32_t> per_channel_output_multiplier;
+  std::vector<int> per_channel_output_shift;
   // The range of the fused activation layer. For example for kNone and
   // uint8_t these would be 0 and 255.
   int32_t output_activation_min;
@@ -73,8 +80,11 @@ struct OpData {
   // Indexes are the offset to the memory buffer in the array used to keep track
   // of the allocated temporaries.
   int32_t im2col_index;
-  int32_t hwcn_weights_index;
-  bool need_hwcn_weights;
+  int32_t transposed_filter_index;
+  bool need_transposed_filter;
+  // Whether the transposed filter is kept across invocations, rather than
+  // transposed at each one.
+  bool cache_transposed_filter;
   bool have_weights_been_transposed;
   bool need_im2col;
 
@@ -97,9 +107,25 @@ void Free(TfLiteContext* context, void* buffer) {
   delete reinterpret_cast<OpData*>(buffer);
 }
 
+// Whether EvalFloat() runs the multithreaded EigenTensor implementation of
+// convolution, which expects the filter weights to be transposed compared to
+// the normal TF Lite buffer format. Typical TF Lite weights are
+// [filter_count, filter_height, filter_width, input_depth], but this
+// implementation needs them as [filter_height, filter_width, input_depth,
+// filter_count], the HWIO filter format of the model.
+bool NeedsHwioFilter(KernelType kernel_type, TfLiteConvParams* params,
+                     OpData* data) {
+  // kMultithreadOptimized does not support dilation, see EvalFloat().
+  return kernel_type == kMultithreadOptimized &&
+         data->run_multithreaded_kernel &&
+         params->dilation_width_factor == 1 &&
+         params->dilation_height_factor == 1;
+}
+
 // Naive implementation of transpose for floats. Could be optimized to be more
-// cache friendly, but for now it's a one-time cost on first run, and we would
-// prefer to remove the need to do this at all eventually.
+// cache friendly, but for now it's a one-time cost on first run for constant
+// filters, unless TfLiteContext::cache_transformed_weights is false, and models
+// can avoid it altogether by storing the filter in the layout of the kernel.
 void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
   const int rows = output->dims->data[1];
   const int cols = output->dims->data[0];
@@ -113,9 +139,10 @@ void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
-// Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
+// Allocate temporary tensors (`im2col`, `transposed_filter` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
+template <KernelType kernel_type>
 static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
                                                        TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -130,23 +157,27 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
-  // optimized_ops.h, in order to avoid a DCHECK(!im2col_data).
+  // optimized_ops.h, in order to avoid a DCHECK(!im2col_data). The int8 kernel
+  // never uses it.
   data->need_im2col =
+      input->type != kTfLiteInt8 &&
       (params->stride_width != 1 || params->stride_height != 1 ||
        params->dilation_width_factor != 1 ||
        params->dilation_height_factor != 1 || filter_width != 1 ||
        filter_height != 1);
-  // If we're using the optimized multithreaded EigenTensor implementation of
-  // convolution, it expects the filter weights to be transposed compared to
-  // the normal TF Lite buffer format. Typical TF Lite weights are
-  // [filter_count, filter_height, filter_width, input_depth], but for the float
-  // implementation we need them as [filter_height, filter_width, input_depth,
-  // filter_count]. We get to that format by transposing, and create a temporary
-  // buffer to store the results.
+  // If the filter isn't stored in the layout the float kernel reads, we get
+  // to that layout by transposing, and create a persistent buffer to store the
+  // results. Models converted with HWIO filters spare the multithreaded kernel
+  // this copy, which reads them in place, e.g. from the mmapped model.
   // This path is only used for float processing, so only create the buffer if
   // we're running with that data type.
-  data->need_hwcn_weights =
-      (input->type == kTfLiteFloat32 && data->run_multithreaded_kernel);
+  // Block sparse filters are read in place by EvalSparseFloat().
+  const bool has_hwio_filter =
+      params->filter_format == kTfLiteConvFilterFormatHwio;
+  data->need_transposed_filter =
+      (input->type == kTfLiteFloat32 &&
+       params->filter_format != kTfLiteConvFilterFormatBlockSparse &&
+       NeedsHwioFilter(kernel_type, params, data) != has_hwio_filter);
 
   int temporaries_count = 0;
   if (data->need_im2col) {
@@ -156,10 +187,10 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
-    data->hwcn_weights_index = temporaries_count;
-    if (data->hwcn_weights_id == kTensorNotAllocated) {
-      context->AddTensors(context, 1, &data->hwcn_weights_id);
+  if (data->need_transposed_filter) {
+    data->transposed_filter_index = temporaries_count;
+    if (data->transposed_filter_id == kTensorNotAllocated) {
+      context->AddTensors(context, 1, &data->transposed_filter_id);
     }
     ++temporaries_count;
   }
@@ -170,13 +201,15 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+template <KernelType kernel_type>
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
   OpData* data = reinterpret_cast<OpData*>(node->user_data);
 
   data->run_multithreaded_kernel = context->recommended_num_threads != 1;
 
-  TF_LITE_ENSURE_STATUS(AllocateTemporaryTensorsIfRequired(context, node));
+  TF_LITE_ENSURE_STATUS(
+      AllocateTemporaryTensorsIfRequired<kernel_type>(context, node));
 
   bool has_bias = node->inputs->size == 3;
   // Check number of inputs/outputs
@@ -194,10 +227,28 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   // Check types. (We assume that UINT8 refers to quantized tensors)
   TfLiteType data_type = input->type;
-  TF_LITE_ENSURE(context,
-                 data_type == kTfLiteFloat32 || data_type == kTfLiteUInt8);
+  TF_LITE_ENSURE(context, data_type == kTfLiteFloat32 ||
+                              data_type == kTfLiteUInt8 ||
+                              data_type == kTfLiteInt8);
   TF_LITE_ENSURE_EQ(context, output->type, data_type);
   TF_LITE_ENSURE_EQ(context, filter->type, data_type);
+  // Only the float kernels read HWIO or block sparse filters.
+  TF_LITE_ENSURE(context,
+                 params->filter_format == kTfLiteConvFilterFormatDefault ||
+                     data_type == kTfLiteFloat32);
+  // Block sparse filters are only supported for pointwise convolutions, which
+  // are a plain matrix multiplication over all pixels.
+  const bool sparse_filter =
+      params->filter_format == kTfLiteConvFilterFormatBlockSparse;
+  TF_LITE_ENSURE_EQ(context, sparse_filter, filter->sparsity != nullptr);
+  if (sparse_filter) {
+    TF_LITE_ENSURE_EQ(context, filter->dims->data[1], 1);
+    TF_LITE_ENSURE_EQ(context, filter->dims->data[2], 1);
+    TF_LITE_ENSURE_EQ(context, params->stride_width, 1);
+    TF_LITE_ENSURE_EQ(context, params->stride_height, 1);
+    TF_LITE_ENSURE_EQ(context, params->dilation_width_factor, 1);
+    TF_LITE_ENSURE_EQ(context, params->dilation_height_factor, 1);
+  }
 
   TfLiteTensor* bias = nullptr;
 
@@ -207,7 +258,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   if (has_bias) {
     bias = &context->tensors[node->inputs->data[2]];
-    if (data_type == kTfLiteUInt8) {
+    if (data_type == kTfLiteUInt8 || data_type == kTfLiteInt8) {
       TF_LITE_ENSURE_EQ(context, bias->type, kTfLiteInt32);
       TF_LITE_ENSURE_EQ(context, bias->params.zero_point, 0);
     } else {
@@ -252,7 +303,23 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   // Note that quantized inference requires that all tensors have their
   // parameters set. This is usually done during quantized training.
-  if (data_type != kTfLiteFloat32) {
+  if (data_type == kTfLiteInt8) {
+    // int8 filters are quantized per output channel, which is dimension 0.
+    std::vector<double> real_multipliers;
+    TF_LITE_ENSURE_STATUS(GetPerChannelConvolutionMultipliers(
+        context, input, filter, output, 0, &real_multipliers));
+    const int num_channels = real_multipliers.size();
+    data->per_channel_output_multiplier.resize(num_channels);
+    data->per_channel_output_shift.resize(num_channels);
+    for (int i = 0; i < num_channels; ++i) {
+      QuantizeMultiplier(real_multipliers[i],
+                         &data->per_channel_output_multiplier[i],
+                         &data->per_channel_output_shift[i]);
+    }
+    TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+        context, params->activation, output, &data->output_activation_min,
+        &data->output_activation_max));
+  } else if (data_type != kTfLiteFloat32) {
     double real_multiplier = 0.0;
     TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
         context, input, filter, bias, output, &real_multiplier));
@@ -293,26 +360,42 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
-    node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
-    TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
+  if (data->need_transposed_filter) {
+    node->temporaries->data[data->transposed_filter_index] =
+        data->transposed_filter_id;
+    TfLiteIntArray* transposed_filter_size = TfLiteIntArrayCreate(2);
 
     // Because we're treating the filter weights as a matrix when we do the
     // transpose, we allocate the buffer with a two-dimensional shape, where one
     // dimension is the number of elements in each filter, and the second is the
-    // total number of filters.
+    // total number of filters, in the order of the layout we transpose to.
     int input_depth = input->dims->data[3];
-    hwcn_weights_size->data[0] = (filter_height * filter_width * input_depth);
-    hwcn_weights_size->data[1] = channels_out;
-
-    TfLiteTensor* hwcn_weights =
-        &context->tensors[node->temporaries->data[data->hwcn_weights_index]];
-    hwcn_weights->type = data_type;
-    hwcn_weights->allocation_type = kTfLiteArenaRwPersistent;
+    int filter_size = filter_height * filter_width * input_depth;
+    if (params->filter_format == kTfLiteConvFilterFormatHwio) {
+      transposed_filter_size->data[0] = channels_out;
+      transposed_filter_size->data[1] = filter_size;
+    } else {
+      transposed_filter_size->data[0] = filter_size;
+      transposed_filter_size->data[1] = channels_out;
+    }
 
-    auto hwcn_weights_status =
-        context->ResizeTensor(context, hwcn_weights, hwcn_weights_size);
-    if (hwcn_weights_status != kTfLiteOk) return hwcn_weights_status;
+    // A filter that isn't constant may change between invocations, so its
+    // transposition can't be kept.
+    data->cache_transposed_filter =
+        context->cache_transformed_weights && IsConstantTensor(filter);
+    TfLiteTensor* transposed_filter =
+        &context->tensors[node->temporaries
+                              ->data[data->transposed_filter_index]];
+    transposed_filter->type = data_type;
+    transposed_filter->allocation_type = data->cache_transposed_filter
+                                             ? kTfLiteArenaRwPersistent
+                                             : kTfLiteArenaRw;
+
+    auto transposed_filter_status = context->ResizeTensor(
+        context, transposed_filter, transposed_filter_size);
+    if (transposed_filter_status != kTfLiteOk) {
+      return transposed_filter_status;
+    }
 
     // TODO(petewarden): If Resize() is called when the size hasn't actually
     // changed, this will do extra redundant work.
@@ -326,7 +409,7 @@ template <KernelType kernel_type>
 void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                    TfLiteConvParams* params, OpData* data, TfLiteTensor* input,
                    TfLiteTensor* filter, TfLiteTensor* bias,
-                   TfLiteTensor* im2col, TfLiteTensor* hwcn_weights,
+                   TfLiteTensor* im2col, TfLiteTensor* transposed_filter,
                    TfLiteTensor* output) {
   gemmlowp::GemmContext* gemm_context = gemm_support::GetFromContext(context);
 
@@ -365,11 +448,28 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   }
 }
 
+// There is only a reference implementation of the per-channel kernel, which
+// all kernel types run.
+void EvalQuantizedPerChannel(TfLiteConvParams* params, OpData* data,
+                             TfLiteTensor* input, TfLiteTensor* filter,
+                             TfLiteTensor* bias, TfLiteTensor* output) {
+  reference_ops::ConvPerChannel(
+      GetTensorData<int8_t>(input), GetTensorDims(input),
+      -input->params.zero_point, GetTensorData<int8_t>(filter),
+      GetTensorDims(filter), GetTensorData<int32_t>(bias), GetTensorDims(bias),
+      params->stride_width, params->stride_height, data->padding.width,
+      data->padding.height, output->params.zero_point,
+      data->per_channel_output_multiplier.data(),
+      data->per_channel_output_shift.data(), data->output_activation_min,
+      data->output_activation_max, GetTensorData<int8_t>(output),
+      GetTensorDims(output));
+}
+
 template <KernelType kernel_type>
 void EvalFloat(TfLiteContext* context, TfLiteNode* node,
                TfLiteConvParams* params, OpData* data, TfLiteTensor* input,
                TfLiteTensor* filter, TfLiteTensor* bias, TfLiteTensor* im2col,
-               TfLiteTensor* hwcn_weights, TfLiteTensor* output) {
+               TfLiteTensor* transposed_filter, TfLiteTensor* output) {
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
@@ -384,38 +484,36 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   } else {
     effective_kernel_type = kernel_type;
   }
+  // The filter in the layout this kernel reads, see NeedsHwioFilter().
+  const float* filter_data = data->need_transposed_filter
+                                 ? GetTensorData<float>(transposed_filter)
+                                 : GetTensorData<float>(filter);
   switch (effective_kernel_type) {
     case kReference: {
       reference_ops::Conv(
-          GetTensorData<float>(input), GetTensorDims(input),
-          GetTensorData<float>(filter), GetTensorDims(filter),
-          GetTensorData<float>(bias), GetTensorDims(bias), params->stride_width,
-          params->stride_height, params->dilation_width_factor,
-          params->dilation_height_factor, data->padding.width,
-          data->padding.height, output_activation_min, output_activation_max,
-          GetTensorData<float>(output), GetTensorDims(output),
-          GetTensorData<float>(im2col), GetTensorDims(im2col));
+          GetTensorData<float>(input), GetTensorDims(input), filter_data,
+          GetTensorDims(filter), GetTensorData<float>(bias),
+          GetTensorDims(bias), params->stride_width, params->stride_height,
+          params->dilation_width_factor, params->dilation_height_factor,
+          data->padding.width, data->padding.height, output_activation_min,
+          output_activation_max, GetTensorData<float>(output),
+          GetTensorDims(output), GetTensorData<float>(im2col),
+          GetTensorDims(im2col));
       break;
     }
     case kGenericOptimized: {
       optimized_ops::Conv(
-          GetTensorData<float>(input), GetTensorDims(input),
-          GetTensorData<float>(filter), GetTensorDims(filter),
-          GetTensorData<float>(bias), GetTensorDims(bias), params->stride_width,
-          params->stride_height, params->dilation_width_factor,
-          params->dilation_height_factor, data->padding.width,
-          data->padding.height, output_activation_min, output_activation_max,
-          GetTensorData<float>(output), GetTensorDims(output),
-          GetTensorData<float>(im2col), GetTensorDims(im2col));
+          GetTensorData<float>(input), GetTensorDims(input), filter_data,
+          GetTensorDims(filter), GetTensorData<float>(bias),
+          GetTensorDims(bias), params->stride_width, params->stride_height,
+          params->dilation_width_factor, params->dilation_height_factor,
+          data->padding.width, data->padding.height, output_activation_min,
+          output_activation_max, GetTensorData<float>(output),
+          GetTensorDims(output), GetTensorData<float>(im2col),
+          GetTensorDims(im2col));
       break;
     }
     case kMultithreadOptimized: {
-      const float* filter_data;
-      if (data->need_hwcn_weights) {
-        filter_data = GetTensorData<float>(hwcn_weights);
-      } else {
-        filter_data = GetTensorData<float>(filter);
-      }
       multithreaded_ops::Conv(
           *eigen_support::GetThreadPoolDevice(context),
           GetTensorData<float>(input), GetTensorDims(input), filter_data,
@@ -429,7 +527,7 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
     }
     case kCblasOptimized: {
       cblas_ops::Conv(GetTensorData<float>(input), GetTensorDims(input),
-                      GetTensorData<float>(filter), GetTensorDims(filter),
+                      filter_data, GetTensorDims(filter),
                       GetTensorData<float>(bias), GetTensorDims(bias),
                       params->stride_width, params->stride_height,
                       data->padding.width, data->padding.height,
@@ -441,6 +539,30 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   }
 }
 
+// A 1x1 convolution with unit strides is a fully connected layer applied to
+// every pixel, so the block sparse filter is multiplied with all of them at
+// once.
+void EvalSparseFloat(TfLiteConvParams* params, TfLiteTensor* input,
+                     TfLiteTensor* filter, TfLiteTensor* bias,
+                     TfLiteTensor* output) {
+  const TfLiteSparsity* sparsity = filter->sparsity;
+  const int output_depth = filter->dims->data[0];
+  const int input_depth = filter->dims->data[3];
+  const int num_pixels = NumElements(input) / input_depth;
+
+  tensor_utils::VectorBatchVectorAssign(GetTensorData<float>(bias),
+                                        output_depth, num_pixels,
+                                        GetTensorData<float>(output));
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate(
+      GetTensorData<float>(filter), sparsity->row_segments->data,
+      sparsity->block_indices->data, sparsity->block_size, output_depth,
+      input_depth, GetTensorData<float>(input), num_pixels,
+      GetTensorData<float>(output), /*result_stride=*/1);
+  tensor_utils::ApplyActivationToVector(
+      GetTensorData<float>(output), num_pixels * output_depth,
+      params->activation, GetTensorData<float>(output));
+}
+
 template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -456,13 +578,15 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       data->need_im2col
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
-  TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
-          ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
+  TfLiteTensor* transposed_filter =
+      data->need_transposed_filter
+          ? &context->tensors[node->temporaries
+                                  ->data[data->transposed_filter_index]]
           : nullptr;
 
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
-    TransposeFloatTensor(filter, hwcn_weights);
+  if (data->need_transposed_filter &&
+      !(data->cache_transposed_filter && data->have_weights_been_transposed)) {
+    TransposeFloatTensor(filter, transposed_filter);
     data->have_weights_been_transposed = true;
   }
 
@@ -470,17 +594,22 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   // separate ops to avoid dispatch overhead here.
   switch (input->type) {  // Already know in/outtypes are same.
     case kTfLiteFloat32:
-      if (data->run_multithreaded_kernel) {
+      if (params->filter_format == kTfLiteConvFilterFormatBlockSparse) {
+        EvalSparseFloat(params, input, filter, bias, output);
+      } else if (data->run_multithreaded_kernel) {
         EvalFloat<kernel_type>(context, node, params, data, input, filter, bias,
-                               im2col, hwcn_weights, output);
+                               im2col, transposed_filter, output);
       } else {
         EvalFloat<kGenericOptimized>(context, node, params, data, input, filter,
-                                     bias, im2col, hwcn_weights, output);
+                                     bias, im2col, transposed_filter, output);
       }
       break;
     case kTfLiteUInt8:
       EvalQuantized<kernel_type>(context, node, params, data, input, filter,
-                                 bias, im2col, hwcn_weights, output);
+                                 bias, im2col, transposed_filter, output);
+      break;
+    case kTfLiteInt8:
+      EvalQuantizedPerChannel(params, data, input, filter, bias, output);
       break;
     default:
       context->ReportError(context, "Type %d not currently supported.",
@@ -493,25 +622,29 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace conv
 
 TfLiteRegistration* Register_CONVOLUTION_REF() {
-  static TfLiteRegistration r = {conv::Init, conv::Free, conv::Prepare,
+  static TfLiteRegistration r = {conv::Init, conv::Free,
+                                 conv::Prepare<conv::kReference>,
                                  conv::Eval<conv::kReference>};
   return &r;
 }
 
 TfLiteRegistration* Register_CONVOLUTION_GENERIC_OPT() {
-  static TfLiteRegistration r = {conv::Init, conv::Free, conv::Prepare,
+  static TfLiteRegistration r = {conv::Init, conv::Free,
+                                 conv::Prepare<conv::kGenericOptimized>,
                                  conv::Eval<conv::kGenericOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_CONVOLUTION_MULTITHREADED_OPT() {
-  static TfLiteRegistration r = {conv::Init, conv::Free, conv::Prepare,
+  static TfLiteRegistration r = {conv::Init, conv::Free,
+                                 conv::Prepare<conv::kMultithreadOptimized>,
                                  conv::Eval<conv::kMultithreadOptimized>};
   return &r;
 }
 
 TfLiteRegistration* Register_CONVOLUTION_CBLAS_OPT() {
-  static TfLiteRegistration r = {conv::Init, conv::Free, conv::Prepare,
+  static TfLiteRegistration r = {conv::Init, conv::Free,
+                                 conv::Prepare<conv::kCblasOptimized>,
                                  conv::Eval<conv::kCblasOptimized>};
   return &r;
 }
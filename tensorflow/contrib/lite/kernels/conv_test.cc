@@ -47,7 +47,9 @@ class BaseConvolutionOpModel : public SingleOpModel {
       const TensorData& filter, const TensorData& output, int stride_width = 2,
       int stride_height = 2, enum Padding padding = Padding_VALID,
       enum ActivationFunctionType activation = ActivationFunctionType_NONE,
-      int dilation_width_factor = 1, int dilation_height_factor = 1) {
+      int dilation_width_factor = 1, int dilation_height_factor = 1,
+      Conv2DOptionsFilterFormat filter_format =
+          Conv2DOptionsFilterFormat_DEFAULT) {
     input_ = AddInput(input);
     filter_ = AddInput(filter);
 
@@ -72,9 +74,10 @@ class BaseConvolutionOpModel : public SingleOpModel {
     }
 
     SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
-                 CreateConv2DOptions(
-                     builder_, padding, stride_width, stride_height, activation,
-                     dilation_width_factor, dilation_height_factor)
+                 CreateConv2DOptions(builder_, padding, stride_width,
+                                     stride_height, activation,
+                                     dilation_width_factor,
+                                     dilation_height_factor, filter_format)
                      .Union());
 
     resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
@@ -148,6 +151,146 @@ TEST_P(ConvolutionOpTest, SimpleTestFloat32) {
                              }));
 }
 
+TEST_P(ConvolutionOpTest, SimpleTestFloat32WithFilterChangedBetweenInvokes) {
+  ConvolutionOpModel m(GetRegistration(), {TensorType_FLOAT32, {2, 2, 4, 1}},
+                       {TensorType_FLOAT32, {3, 2, 2, 1}},
+                       {TensorType_FLOAT32, {}});
+
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  m.SetFilter({
+      1, 2, 3, 4,    // first 2x2 filter
+      -1, 1, -1, 1,  // second 2x2 filter
+      -1, -1, 1, 1,  // third 2x2 filter
+  });
+  m.SetBias({1, 2, 3});
+  m.Invoke();
+
+  // The filter isn't constant, so kernels transposing it must not reuse the
+  // transposition of the previous invocation.
+  m.SetFilter({
+      -1, -2, -3, -4,  // first 2x2 filter
+      1, -1, 1, -1,    // second 2x2 filter
+      1, 1, -1, -1,    // third 2x2 filter
+  });
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 -16, 2, 1,  // first batch, left
+                                 -16, 2, 1,  // first batch, right
+                                 -15, 0, 3,  // second batch, left
+                                 -35, 0, 3,  // second batch, right
+                             }));
+}
+
+TEST_P(ConvolutionOpTest, SimpleTestFloat32WithHwioFilter) {
+  ConvolutionOpModel m(GetRegistration(), {TensorType_FLOAT32, {2, 2, 4, 1}},
+                       {TensorType_FLOAT32, {3, 2, 2, 1}},
+                       {TensorType_FLOAT32, {}}, /*stride_width=*/2,
+                       /*stride_height=*/2, Padding_VALID,
+                       ActivationFunctionType_NONE,
+                       /*dilation_width_factor=*/1,
+                       /*dilation_height_factor=*/1,
+                       Conv2DOptionsFilterFormat_HWIO);
+
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  // The filters of SimpleTestFloat32, each filter position holding the value
+  // of every filter.
+  m.SetFilter({
+      1, -1, -1,  // top left
+      2, 1, -1,   // top right
+      3, -1, 1,   // bottom left
+      4, 1, 1,    // bottom right
+  });
+  m.SetBias({1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 18, 2, 5,  // first batch, left
+                                 18, 2, 5,  // first batch, right
+                                 17, 4, 3,  // second batch, left
+                                 37, 4, 3,  // second batch, right
+                             }));
+}
+
+// Pointwise convolution whose filter is constant and stored in the block
+// sparse format.
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input,
+                           std::initializer_list<int> filter_shape,
+                           const std::vector<float>& filter, int block_size) {
+    input_ = AddInput(input);
+    AddBlockSparseConstInput(filter, filter_shape, block_size);
+    bias_ = AddInput({TensorType_FLOAT32, {*filter_shape.begin()}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    SetBuiltinOp(
+        BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+        CreateConv2DOptions(builder_, Padding_VALID, /*stride_w=*/1,
+                            /*stride_h=*/1, ActivationFunctionType_NONE,
+                            /*dilation_w_factor=*/1, /*dilation_h_factor=*/1,
+                            Conv2DOptionsFilterFormat_BLOCK_SPARSE)
+            .Union());
+
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)});
+  }
+
+  void SetBias(std::initializer_list<float> f) { PopulateTensor(bias_, f); }
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, SimpleTestFloat32WithBlockSparseFilter) {
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {1, 1, 2, 8}},
+                             /*filter_shape=*/{3, 1, 1, 8},
+                             /*filter=*/
+                             {
+                                 1, 2, 3, 4, 0, 0, 0, 0,  // first filter
+                                 0, 0, 0, 0, 0, 0, 0, 0,  // second filter
+                                 0, 0, 0, 0, 5, 6, 7, 8,  // third filter
+                             },
+                             /*block_size=*/4);
+
+  m.SetInput({
+      1, 1, 1, 1, 1, 1, 1, 1,      // left
+      1, 2, 3, 4, -1, -1, -1, -1,  // right
+  });
+  m.SetBias({1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 11, 2, 29,   // left
+                                 31, 2, -23,  // right
+                             }));
+}
+
 TEST_P(ConvolutionOpTest, SimpleTestFloat32WithAnisotropicStrides) {
   ConvolutionOpModel m(GetRegistration(), {TensorType_FLOAT32, {1, 3, 6, 1}},
                        {TensorType_FLOAT32, {1, 2, 2, 1}},
@@ -468,6 +611,75 @@ TEST_P(ConvolutionOpTest, SimpleTestQuantizedWithAnisotropicStrides) {
                              }));
 }
 
+class PerChannelQuantizedConvolutionOpModel : public BaseConvolutionOpModel {
+ public:
+  using BaseConvolutionOpModel::BaseConvolutionOpModel;
+
+  void SetInput(std::initializer_list<float> data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+
+  void SetFilter(const std::vector<float>& data) {
+    PerChannelSymmetricQuantizeAndPopulate(filter_, data);
+  }
+
+  void SetBias(const std::vector<float>& data) {
+    PerChannelQuantizeBias(bias_, input_, filter_, data);
+  }
+
+  std::vector<int8_t> GetOutput() { return ExtractVector<int8_t>(output_); }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+};
+
+TEST_P(ConvolutionOpTest, SimpleTestInt8PerChannel) {
+  PerChannelQuantizedConvolutionOpModel m(
+      GetRegistration(), {TensorType_INT8, {2, 2, 4, 1}, -63.5, 64},
+      {TensorType_INT8,
+       {3, 2, 2, 1},
+       0,
+       0,
+       0,
+       0,
+       /*per_channel_scales=*/{0.25, 0.5, 1},
+       /*quantized_dimension=*/0},
+      {TensorType_INT8, {}, -127, 128});
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  m.SetFilter({
+      1, 2, 3, 4,    // first 2x2 filter
+      -1, 1, -1, 1,  // second 2x2 filter
+      -1, -1, 1, 1,  // third 2x2 filter
+  });
+  m.SetBias({1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {
+                      18, 2, 5,  // first batch, left
+                      18, 2, 5,  // first batch, right
+                      17, 4, 3,  // second batch, left
+                      37, 4, 3,  // second batch, right
+                  },
+                  1e-5)));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 17, 1, 4,  //
+                                 17, 1, 4,  //
+                                 16, 3, 2,  //
+                                 36, 3, 2,  //
+                             }));
+}
+
 INSTANTIATE_TEST_CASE_P(
     ConvolutionOpTest, ConvolutionOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include "tensorflow/contrib/lite/builtin_op_data.h"
 #include "tensorflow/contrib/lite/context.h"
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/internal/optimized/depthwiseconv_uint8.h"
 #include "tensorflow/contrib/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/contrib/lite/kernels/internal/reference/depthwiseconv_float.h"
+#include "tensorflow/contrib/lite/kernels/internal/reference/depthwiseconv_int8.h"
 #include "tensorflow/contrib/lite/kernels/internal/reference/depthwiseconv_uint8.h"
 #include "tensorflow/contrib/lite/kernels/internal/tensor.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
@@ -54,6 +56,10 @@ struct OpData {
   // be represented as a fixed point multiplier plus a left shift.
   int32_t output_multiplier;
   int output_shift;
+  // Per output channel multipliers and shifts, for int8 filters quantized per
+  // channel. Unlike 'output_shift', these shifts are positive to the left.
+  std::vector<int32_t> per_channel_output_multiplier;
+  std::vector<int> per_channel_output_shift;
   // The range of the fused activation layer. For example for kNone and
   // uint8_t these would be 0 and 255.
   int32_t output_activation_min;
@@ -99,14 +105,15 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                     SizeOfDimension(filter, 3));
 
   const TfLiteType data_type = input->type;
-  TF_LITE_ENSURE(context,
-                 data_type == kTfLiteFloat32 || data_type == kTfLiteUInt8);
+  TF_LITE_ENSURE(context, data_type == kTfLiteFloat32 ||
+                              data_type == kTfLiteUInt8 ||
+                              data_type == kTfLiteInt8);
   TF_LITE_ENSURE_EQ(context, output->type, data_type);
   TF_LITE_ENSURE_EQ(context, filter->type, data_type);
 
   if (hasBias) {
     bias = GetInput(context, node, kBiasTensor);
-    if (data_type == kTfLiteUInt8) {
+    if (data_type == kTfLiteUInt8 || data_type == kTfLiteInt8) {
       TF_LITE_ENSURE_EQ(context, bias->type, kTfLiteInt32);
       TF_LITE_ENSURE_EQ(context, bias->params.zero_point, 0);
     } else {
@@ -146,7 +153,23 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   // Note that quantized inference requires that all tensors have their
   // parameters set. This is usually done during quantized training.
-  if (data_type != kTfLiteFloat32) {
+  if (data_type == kTfLiteInt8) {
+    // int8 filters are quantized per output channel, which is dimension 3.
+    std::vector<double> real_multipliers;
+    TF_LITE_ENSURE_STATUS(GetPerChannelConvolutionMultipliers(
+        context, input, filter, output, 3, &real_multipliers));
+    const int num_channels = real_multipliers.size();
+    data->per_channel_output_multiplier.resize(num_channels);
+    data->per_channel_output_shift.resize(num_channels);
+    for (int i = 0; i < num_channels; ++i) {
+      QuantizeMultiplier(real_multipliers[i],
+                         &data->per_channel_output_multiplier[i],
+                         &data->per_channel_output_shift[i]);
+    }
+    TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+        context, params->activation, output, &data->output_activation_min,
+        &data->output_activation_max));
+  } else if (data_type != kTfLiteFloat32) {
     double real_multiplier = 0.0;
     TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
         context, input, filter, bias, output, &real_multiplier));
@@ -223,6 +246,24 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
       GetTensorDims(output));
 }
 
+// There is only a reference implementation of the per-channel kernel, which
+// all kernel types run.
+void EvalQuantizedPerChannel(TfLiteDepthwiseConvParams* params, OpData* data,
+                             const TfLiteTensor* input,
+                             const TfLiteTensor* filter,
+                             const TfLiteTensor* bias, TfLiteTensor* output) {
+  reference_ops::DepthwiseConvPerChannel(
+      GetTensorData<int8_t>(input), GetTensorDims(input),
+      -input->params.zero_point, GetTensorData<int8_t>(filter),
+      GetTensorDims(filter), GetTensorData<int32_t>(bias), GetTensorDims(bias),
+      params->stride_width, params->stride_height, data->padding.width,
+      data->padding.height, params->depth_multiplier,
+      output->params.zero_point, data->per_channel_output_multiplier.data(),
+      data->per_channel_output_shift.data(), data->output_activation_min,
+      data->output_activation_max, GetTensorData<int8_t>(output),
+      GetTensorDims(output));
+}
+
 template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
@@ -246,6 +287,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       EvalQuantized<kernel_type>(context, node, params, data, input, filter,
                                  bias, output);
       break;
+    case kTfLiteInt8:
+      EvalQuantizedPerChannel(params, data, input, filter, bias, output);
+      break;
     default:
       context->ReportError(context, "Type %d not currently supported.",
                            input->type);
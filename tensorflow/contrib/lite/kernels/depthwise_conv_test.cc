@@ -207,6 +207,70 @@ TEST(QuantizedDepthwiseConvolutionOpTest,
               ElementsAreArray(ArrayFloatNear(float_op.GetOutput(), 1)));
 }
 
+class PerChannelQuantizedDepthwiseConvolutionOpModel
+    : public BaseDepthwiseConvolutionOpModel {
+ public:
+  using BaseDepthwiseConvolutionOpModel::BaseDepthwiseConvolutionOpModel;
+
+  void SetInput(std::initializer_list<float> data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+
+  void SetFilter(const std::vector<float>& data) {
+    PerChannelSymmetricQuantizeAndPopulate(filter_, data);
+  }
+
+  void SetBias(const std::vector<float>& data) {
+    PerChannelQuantizeBias(bias_, input_, filter_, data);
+  }
+
+  std::vector<int8_t> GetOutput() { return ExtractVector<int8_t>(output_); }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+};
+
+TEST(PerChannelQuantizedDepthwiseConvolutionOpTest, SimpleTestInt8) {
+  PerChannelQuantizedDepthwiseConvolutionOpModel m(
+      {TensorType_INT8, {1, 3, 2, 2}, -63.5, 64},
+      {TensorType_INT8,
+       {1, 2, 2, 4},
+       0,
+       0,
+       0,
+       0,
+       /*per_channel_scales=*/{1, 2, 1, 2},
+       /*quantized_dimension=*/3},
+      {TensorType_INT8, {}, -127, 128});
+
+  m.SetInput({
+      1, 2, 7, 8,    // column 1
+      3, 4, 9, 10,   // column 2
+      5, 6, 11, 12,  // column 3
+  });
+  m.SetFilter({
+      1, 2, 3, 4,        //
+      -9, 10, -11, 12,   //
+      5, 6, 7, 8,        //
+      13, -14, 15, -16,  //
+  });
+  m.SetBias({1, 2, 3, 4});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetDequantizedOutput(), ElementsAreArray(ArrayFloatNear(
+                                            {
+                                                71, -34, 99, -20,  //
+                                                91, -26, 127, -4,  //
+                                            },
+                                            1e-5)));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 70, -35, 98, -21,  //
+                                 90, -27, 126, -5,  //
+                             }));
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -0,0 +1,294 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <string>
+
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/contrib/lite/builtin_op_data.h"
+#include "tensorflow/contrib/lite/context.h"
+#include "tensorflow/contrib/lite/kernels/internal/tensor.h"
+#include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
+#include "tensorflow/contrib/lite/kernels/kernel_util.h"
+#include "tensorflow/contrib/lite/kernels/op_macros.h"
+#include "tensorflow/contrib/lite/kernels/padding.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace depthwise_pointwise_conv {
+
+// A depthwise convolution followed by a pointwise (1x1, stride 1)
+// convolution, each with its own bias and fused activation, as found in
+// MobileNet blocks. The depthwise output is computed a tile of output pixels
+// at a time into a small temporary, and the pointwise convolution consumes
+// the tile while it is still in cache, instead of the whole intermediate
+// tensor going through memory.
+constexpr int kInputTensor = 0;
+constexpr int kDepthwiseFilterTensor = 1;
+constexpr int kDepthwiseBiasTensor = 2;
+constexpr int kPointwiseFilterTensor = 3;
+constexpr int kPointwiseBiasTensor = 4;
+constexpr int kOutputTensor = 0;
+
+// The number of depthwise output values in a tile, sized for the tile to
+// stay in the L1 cache along with a slice of the pointwise filter.
+constexpr int kTileSize = 4096;
+
+struct OpData {
+  TfLitePadding padding;
+  int stride_width;
+  int stride_height;
+  int depth_multiplier;
+  TfLiteFusedActivation depthwise_activation;
+  TfLiteFusedActivation activation;
+
+  TfLitePaddingValues padding_values;
+  // The number of output pixels per tile.
+  int tile_pixels;
+  // Index of the temporary tensor holding a tile of the depthwise output.
+  int tile_index;
+};
+
+TfLiteFusedActivation ParseActivation(const std::string& name) {
+  if (name == "RELU") return kTfLiteActRelu;
+  if (name == "RELU_N1_TO_1") return kTfLiteActRelu1;
+  if (name == "RELU6") return kTfLiteActRelu6;
+  return kTfLiteActNone;
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  auto* op_data = new OpData;
+  const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+  const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
+  const std::string padding = m["padding"].AsString().str();
+  op_data->padding = padding == "SAME"
+                         ? kTfLitePaddingSame
+                         : padding == "VALID" ? kTfLitePaddingValid
+                                              : kTfLitePaddingUnknown;
+  op_data->stride_width = m["stride_width"].AsInt32();
+  op_data->stride_height = m["stride_height"].AsInt32();
+  op_data->depth_multiplier = m["depth_multiplier"].AsInt32();
+  op_data->depthwise_activation =
+      ParseActivation(m["depthwise_activation"].AsString().str());
+  op_data->activation = ParseActivation(m["activation"].AsString().str());
+  context->AddTensors(context, 1, &op_data->tile_index);
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 5);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* dw_filter =
+      GetInput(context, node, kDepthwiseFilterTensor);
+  const TfLiteTensor* dw_bias = GetInput(context, node, kDepthwiseBiasTensor);
+  const TfLiteTensor* pw_filter =
+      GetInput(context, node, kPointwiseFilterTensor);
+  const TfLiteTensor* pw_bias = GetInput(context, node, kPointwiseBiasTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+
+  TF_LITE_ENSURE(context, op_data->padding != kTfLitePaddingUnknown);
+  TF_LITE_ENSURE(context, op_data->stride_width > 0);
+  TF_LITE_ENSURE(context, op_data->stride_height > 0);
+
+  // Only float is supported.
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, dw_filter->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, dw_bias->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, pw_filter->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, pw_bias->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, output->type, kTfLiteFloat32);
+
+  // The depthwise filter is [1, height, width, depth * depth_multiplier] and
+  // the pointwise filter is [output_depth, 1, 1, depth * depth_multiplier].
+  TF_LITE_ENSURE_EQ(context, NumDimensions(input), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(dw_filter), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(pw_filter), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(dw_bias), 1);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(pw_bias), 1);
+  const int dw_depth = SizeOfDimension(dw_filter, 3);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(dw_filter, 0), 1);
+  TF_LITE_ENSURE_EQ(context,
+                    op_data->depth_multiplier * SizeOfDimension(input, 3),
+                    dw_depth);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(dw_bias, 0), dw_depth);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(pw_filter, 1), 1);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(pw_filter, 2), 1);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(pw_filter, 3), dw_depth);
+  const int output_depth = SizeOfDimension(pw_filter, 0);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(pw_bias, 0), output_depth);
+
+  const int batches = SizeOfDimension(input, 0);
+  const int height = SizeOfDimension(input, 1);
+  const int width = SizeOfDimension(input, 2);
+  const int filter_height = SizeOfDimension(dw_filter, 1);
+  const int filter_width = SizeOfDimension(dw_filter, 2);
+
+  // Matching GetWindowedOutputSize in TensorFlow.
+  auto padding = op_data->padding;
+  auto compute_out_size = [padding](int imageSize, int filterSize,
+                                    int stride) -> int {
+    return padding == kTfLitePaddingSame
+               ? (imageSize + stride - 1) / stride
+               : (imageSize - filterSize + stride) / stride;
+  };
+  const int out_width =
+      compute_out_size(width, filter_width, op_data->stride_width);
+  const int out_height =
+      compute_out_size(height, filter_height, op_data->stride_height);
+  op_data->padding_values.height = ComputePadding(
+      op_data->stride_height, 1, height, filter_height, out_height);
+  op_data->padding_values.width = ComputePadding(op_data->stride_width, 1,
+                                                 width, filter_width, out_width);
+
+  // Tiles are made of whole output pixels, within a single output row.
+  op_data->tile_pixels =
+      std::max(1, std::min(out_width, kTileSize / dw_depth));
+  TfLiteIntArrayFree(node->temporaries);
+  node->temporaries = TfLiteIntArrayCreate(1);
+  node->temporaries->data[0] = op_data->tile_index;
+  TfLiteTensor* tile = GetTemporary(context, node, /*index=*/0);
+  tile->type = kTfLiteFloat32;
+  tile->allocation_type = kTfLiteArenaRw;
+  TfLiteIntArray* tile_size = TfLiteIntArrayCreate(2);
+  tile_size->data[0] = op_data->tile_pixels;
+  tile_size->data[1] = dw_depth;
+  TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, tile, tile_size));
+
+  TfLiteIntArray* output_size = TfLiteIntArrayCreate(4);
+  output_size->data[0] = batches;
+  output_size->data[1] = out_height;
+  output_size->data[2] = out_width;
+  output_size->data[3] = output_depth;
+  return context->ResizeTensor(context, output, output_size);
+}
+
+void ClampToRange(float min, float max, int size, float* values) {
+  for (int i = 0; i < size; ++i) {
+    values[i] = std::min(std::max(values[i], min), max);
+  }
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* dw_filter =
+      GetInput(context, node, kDepthwiseFilterTensor);
+  const TfLiteTensor* dw_bias = GetInput(context, node, kDepthwiseBiasTensor);
+  const TfLiteTensor* pw_filter =
+      GetInput(context, node, kPointwiseFilterTensor);
+  const TfLiteTensor* pw_bias = GetInput(context, node, kPointwiseBiasTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  TfLiteTensor* tile = GetTemporary(context, node, /*index=*/0);
+
+  float dw_activation_min, dw_activation_max;
+  CalculateActivationRange(op_data->depthwise_activation, &dw_activation_min,
+                           &dw_activation_max);
+  float activation_min, activation_max;
+  CalculateActivationRange(op_data->activation, &activation_min,
+                           &activation_max);
+
+  const int batches = SizeOfDimension(input, 0);
+  const int height = SizeOfDimension(input, 1);
+  const int width = SizeOfDimension(input, 2);
+  const int depth = SizeOfDimension(input, 3);
+  const int filter_height = SizeOfDimension(dw_filter, 1);
+  const int filter_width = SizeOfDimension(dw_filter, 2);
+  const int dw_depth = SizeOfDimension(dw_filter, 3);
+  const int out_height = SizeOfDimension(output, 1);
+  const int out_width = SizeOfDimension(output, 2);
+  const int output_depth = SizeOfDimension(output, 3);
+  const int depth_multiplier = op_data->depth_multiplier;
+
+  const float* input_data = GetTensorData<float>(input);
+  const float* dw_filter_data = GetTensorData<float>(dw_filter);
+  const float* dw_bias_data = GetTensorData<float>(dw_bias);
+  const float* pw_filter_data = GetTensorData<float>(pw_filter);
+  const float* pw_bias_data = GetTensorData<float>(pw_bias);
+  float* output_data = GetTensorData<float>(output);
+  float* tile_data = GetTensorData<float>(tile);
+
+  for (int b = 0; b < batches; ++b) {
+    for (int out_y = 0; out_y < out_height; ++out_y) {
+      const int in_y_origin =
+          out_y * op_data->stride_height - op_data->padding_values.height;
+      for (int tile_x = 0; tile_x < out_width;
+           tile_x += op_data->tile_pixels) {
+        const int tile_pixels =
+            std::min(op_data->tile_pixels, out_width - tile_x);
+
+        // Depthwise convolution of the tile.
+        for (int p = 0; p < tile_pixels; ++p) {
+          float* tile_pixel = tile_data + p * dw_depth;
+          std::copy(dw_bias_data, dw_bias_data + dw_depth, tile_pixel);
+          const int in_x_origin = (tile_x + p) * op_data->stride_width -
+                                  op_data->padding_values.width;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + filter_y;
+            if (in_y < 0 || in_y >= height) continue;
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + filter_x;
+              if (in_x < 0 || in_x >= width) continue;
+              const float* in =
+                  input_data + ((b * height + in_y) * width + in_x) * depth;
+              const float* filter =
+                  dw_filter_data +
+                  (filter_y * filter_width + filter_x) * dw_depth;
+              for (int ic = 0; ic < depth; ++ic) {
+                for (int m = 0; m < depth_multiplier; ++m) {
+                  const int oc = ic * depth_multiplier + m;
+                  tile_pixel[oc] += in[ic] * filter[oc];
+                }
+              }
+            }
+          }
+        }
+        ClampToRange(dw_activation_min, dw_activation_max,
+                     tile_pixels * dw_depth, tile_data);
+
+        // Pointwise convolution of the tile, straight into the output.
+        float* out = output_data +
+                     ((b * out_height + out_y) * out_width + tile_x) *
+                         output_depth;
+        tensor_utils::VectorBatchVectorAssign(pw_bias_data, output_depth,
+                                              tile_pixels, out);
+        tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+            pw_filter_data, output_depth, dw_depth, tile_data, tile_pixels,
+            out, /*result_stride=*/1);
+        ClampToRange(activation_min, activation_max,
+                     tile_pixels * output_depth, out);
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace depthwise_pointwise_conv
+
+TfLiteRegistration* Register_DEPTHWISE_POINTWISE_CONV() {
+  static TfLiteRegistration r = {
+      depthwise_pointwise_conv::Init, depthwise_pointwise_conv::Free,
+      depthwise_pointwise_conv::Prepare, depthwise_pointwise_conv::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,159 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/contrib/lite/interpreter.h"
+#include "tensorflow/contrib/lite/kernels/register.h"
+#include "tensorflow/contrib/lite/kernels/test_util.h"
+#include "tensorflow/contrib/lite/model.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+
+TfLiteRegistration* Register_DEPTHWISE_POINTWISE_CONV();
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+class DepthwisePointwiseConvOpModel : public SingleOpModel {
+ public:
+  DepthwisePointwiseConvOpModel(const TensorData& input,
+                                const TensorData& dw_filter,
+                                const TensorData& pw_filter,
+                                const std::string& padding, int stride,
+                                int depth_multiplier,
+                                const std::string& depthwise_activation,
+                                const std::string& activation) {
+    input_ = AddInput(input);
+    dw_filter_ = AddInput(dw_filter);
+    const int dw_depth = dw_filter.shape[3];
+    dw_bias_ = AddInput({TensorType_FLOAT32, {dw_depth}});
+    pw_filter_ = AddInput(pw_filter);
+    const int output_depth = pw_filter.shape[0];
+    pw_bias_ = AddInput({TensorType_FLOAT32, {output_depth}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      fbb.String("padding", padding);
+      fbb.Int("stride_width", stride);
+      fbb.Int("stride_height", stride);
+      fbb.Int("depth_multiplier", depth_multiplier);
+      fbb.String("depthwise_activation", depthwise_activation);
+      fbb.String("activation", activation);
+    });
+    fbb.Finish();
+    SetCustomOp("TFLite_DepthwiseConvPointwiseConv", fbb.GetBuffer(),
+                Register_DEPTHWISE_POINTWISE_CONV);
+    BuildInterpreter({GetShape(input_), GetShape(dw_filter_),
+                      GetShape(dw_bias_), GetShape(pw_filter_),
+                      GetShape(pw_bias_)});
+  }
+
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  void SetDepthwiseFilter(std::initializer_list<float> data) {
+    PopulateTensor(dw_filter_, data);
+  }
+  void SetDepthwiseBias(std::initializer_list<float> data) {
+    PopulateTensor(dw_bias_, data);
+  }
+  void SetPointwiseFilter(std::initializer_list<float> data) {
+    PopulateTensor(pw_filter_, data);
+  }
+  void SetPointwiseBias(std::initializer_list<float> data) {
+    PopulateTensor(pw_bias_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input_;
+  int dw_filter_;
+  int dw_bias_;
+  int pw_filter_;
+  int pw_bias_;
+  int output_;
+};
+
+TEST(DepthwisePointwiseConvOpTest, ValidPadding) {
+  DepthwisePointwiseConvOpModel m(
+      {TensorType_FLOAT32, {1, 3, 3, 2}}, {TensorType_FLOAT32, {1, 2, 2, 2}},
+      {TensorType_FLOAT32, {3, 1, 1, 2}}, "VALID", /*stride=*/1,
+      /*depth_multiplier=*/1, "NONE", "NONE");
+  m.SetInput({
+      1, 2, 3, 4, 5, 6,        //
+      7, 8, 9, 10, 11, 12,     //
+      13, 14, 15, 16, 17, 18,  //
+  });
+  m.SetDepthwiseFilter({1, 2, 3, 4, -5, -6, 7, 8});
+  m.SetDepthwiseBias({1, -1});
+  m.SetPointwiseFilter({1, 0, 0, 1, 1, -1});
+  m.SetPointwiseBias({0, 1, 2});
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(1, 2, 2, 3));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 39, 52, -10, 51, 68, -14,    //
+                                 75, 100, -22, 87, 116, -26,  //
+                             })));
+}
+
+TEST(DepthwisePointwiseConvOpTest, SamePaddingStrideDepthMultiplierRelu6) {
+  DepthwisePointwiseConvOpModel m(
+      {TensorType_FLOAT32, {1, 4, 4, 2}}, {TensorType_FLOAT32, {1, 3, 3, 4}},
+      {TensorType_FLOAT32, {2, 1, 1, 4}}, "SAME", /*stride=*/2,
+      /*depth_multiplier=*/2, "RELU6", "RELU6");
+  m.SetInput({
+      -1.0, -0.9, -0.8, -0.7, -0.6, -0.5, -0.4, -0.3,  //
+      -0.2, -0.1, 0.0,  0.1,  0.2,  0.3,  0.4,  0.5,   //
+      0.6,  0.7,  0.8,  0.9,  1.0,  1.1,  1.2,  1.3,   //
+      1.4,  1.5,  1.6,  1.7,  1.8,  1.9,  2.0,  2.1,   //
+  });
+  m.SetDepthwiseFilter({
+      0.5, -0.5, 1, 0.25,  0.25, 0.5, -1,   1,     1,  1,  0.5,  -0.25,  //
+      -0.5, 0.25, 0.25, 0.5, 1,  -1,  0.5,  0.5,   0.25, 0.25, -0.5, 1,  //
+      1,   0,    0,  1,     0.5, 0.5, 0.5,  0.5,   -0.25, 1,  1,    -1,  //
+  });
+  m.SetDepthwiseBias({0.5, 0, -0.5, 1});
+  m.SetPointwiseFilter({1, 2, -1, 0.5, 0.5, -0.5, 1, 0.25});
+  m.SetPointwiseBias({0.5, -1});
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(1, 2, 2, 2));
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 2.2, 0, 4.2875, 0.78125,  //
+                                 6, 1.975, 4.3625, 2.16875,
+                             })));
+}
+
+}  // namespace
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/kernels/eigen_support.h"
 
+#include <map>
+#include <mutex>
 #include <utility>
 
 #include "tensorflow/contrib/lite/arena_planner.h"
@@ -58,6 +60,12 @@ struct RefCountedEigenContext : public TfLiteExternalContext {
   std::unique_ptr<Eigen::ThreadPoolInterface> thread_pool_wrapper;
   std::unique_ptr<Eigen::ThreadPoolDevice> device;
   int num_references = 0;
+  // Set for contexts made by CreateSharedContext(), whose thread pool the
+  // Refresh() of one TfLiteContext leaves alone. TfLiteContexts recommending
+  // fewer threads get one of 'limited_devices', by number of threads.
+  bool shared = false;
+  std::mutex mutex;
+  std::map<int, std::unique_ptr<Eigen::ThreadPoolDevice>> limited_devices;
 };
 
 RefCountedEigenContext* GetEigenContext(TfLiteContext* context) {
@@ -65,11 +73,7 @@ RefCountedEigenContext* GetEigenContext(TfLiteContext* context) {
       context->GetExternalContext(context, kTfLiteEigenContext));
 }
 
-void InitDevice(TfLiteContext* context, RefCountedEigenContext* ptr) {
-  int num_threads = 4;
-  if (context->recommended_num_threads != -1) {
-    num_threads = context->recommended_num_threads;
-  }
+void InitDevice(int num_threads, RefCountedEigenContext* ptr) {
   ptr->device.reset();  // destroy before we invalidate the thread pool
   ptr->thread_pool_wrapper.reset(
       new EigenThreadPoolWrapper(new Eigen::ThreadPool(num_threads)));
@@ -77,17 +81,37 @@ void InitDevice(TfLiteContext* context, RefCountedEigenContext* ptr) {
       new Eigen::ThreadPoolDevice(ptr->thread_pool_wrapper.get(), num_threads));
 }
 
+void InitDevice(TfLiteContext* context, RefCountedEigenContext* ptr) {
+  int num_threads = 4;
+  if (context->recommended_num_threads != -1) {
+    num_threads = context->recommended_num_threads;
+  }
+  InitDevice(num_threads, ptr);
+}
+
 TfLiteStatus Refresh(TfLiteContext* context) {
   Eigen::setNbThreads(context->recommended_num_threads);
 
   auto* ptr = GetEigenContext(context);
-  if (ptr != nullptr) {
+  if (ptr != nullptr && !ptr->shared) {
     InitDevice(context, ptr);
   }
 
   return kTfLiteOk;
 }
 
+// Drops 'count' references to 'ptr', and deletes it if none are left.
+// Returns whether it was deleted.
+bool ReleaseReferences(RefCountedEigenContext* ptr, int count) {
+  {
+    std::lock_guard<std::mutex> lock(ptr->mutex);
+    ptr->num_references -= count;
+    if (ptr->num_references > 0) return false;
+  }
+  delete ptr;
+  return true;
+}
+
 }  // namespace
 
 void IncrementUsageCounter(TfLiteContext* context) {
@@ -103,6 +127,7 @@ void IncrementUsageCounter(TfLiteContext* context) {
     InitDevice(context, ptr);
     context->SetExternalContext(context, kTfLiteEigenContext, ptr);
   }
+  std::lock_guard<std::mutex> lock(ptr->mutex);
   ptr->num_references++;
 }
 
@@ -113,8 +138,7 @@ void DecrementUsageCounter(TfLiteContext* context) {
         "Call to DecrementUsageCounter() not preceded by "
         "IncrementUsageCounter()");
   }
-  if (--ptr->num_references == 0) {
-    delete ptr;
+  if (ReleaseReferences(ptr, 1)) {
     context->SetExternalContext(context, kTfLiteEigenContext, nullptr);
   }
 }
@@ -125,7 +149,58 @@ const Eigen::ThreadPoolDevice* GetThreadPoolDevice(TfLiteContext* context) {
     TF_LITE_FATAL(
         "Call to GetFromContext() not preceded by IncrementUsageCounter()");
   }
-  return ptr->device.get();
+  const int num_threads = context->recommended_num_threads;
+  if (!ptr->shared || num_threads <= 0 ||
+      num_threads >= ptr->device->numThreads()) {
+    return ptr->device.get();
+  }
+  std::lock_guard<std::mutex> lock(ptr->mutex);
+  std::unique_ptr<Eigen::ThreadPoolDevice>& device =
+      ptr->limited_devices[num_threads];
+  if (!device) {
+    device.reset(new Eigen::ThreadPoolDevice(ptr->thread_pool_wrapper.get(),
+                                             num_threads));
+  }
+  return device.get();
+}
+
+TfLiteExternalContext* CreateSharedContext(int num_threads) {
+  auto* ptr = new RefCountedEigenContext;
+  ptr->type = kTfLiteEigenContext;
+  ptr->Refresh = Refresh;
+  ptr->shared = true;
+  InitDevice(num_threads, ptr);
+  // Held by the caller until ReleaseSharedContext().
+  ptr->num_references = 1;
+  return ptr;
+}
+
+void ReleaseSharedContext(TfLiteExternalContext* shared_context) {
+  ReleaseReferences(static_cast<RefCountedEigenContext*>(shared_context), 1);
+}
+
+TfLiteStatus UseSharedContext(TfLiteContext* context,
+                              TfLiteExternalContext* shared_context) {
+  auto* shared_ptr = static_cast<RefCountedEigenContext*>(shared_context);
+  auto* ptr = GetEigenContext(context);
+  if (ptr == shared_ptr) return kTfLiteOk;
+  if (ptr != nullptr && ptr->shared) {
+    context->ReportError(context,
+                         "Already using another shared Eigen context.");
+    return kTfLiteError;
+  }
+  // The ops already using a context of their own move to the shared one.
+  int num_references = 0;
+  if (ptr != nullptr) {
+    num_references = ptr->num_references;
+    delete ptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared_ptr->mutex);
+    shared_ptr->num_references += num_references;
+  }
+  context->SetExternalContext(context, kTfLiteEigenContext, shared_ptr);
+  return kTfLiteOk;
 }
 
 }  // namespace eigen_support
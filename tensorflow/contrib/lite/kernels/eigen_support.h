@@ -35,6 +35,21 @@ void DecrementUsageCounter(TfLiteContext* context);
 const EigenForTFLite::ThreadPoolDevice* GetThreadPoolDevice(
     TfLiteContext* context);
 
+// Returns a new Eigen thread pool of 'num_threads' threads that several
+// TfLiteContexts can share through UseSharedContext(), so that interpreters
+// don't each start their own. Ops use up to the recommended number of threads
+// of their TfLiteContext, or all of them if it is unset. The caller must free
+// the result with ReleaseSharedContext() once the TfLiteContexts using it are
+// gone.
+TfLiteExternalContext* CreateSharedContext(int num_threads);
+void ReleaseSharedContext(TfLiteExternalContext* shared_context);
+
+// Makes the ops of 'context' use 'shared_context', from
+// CreateSharedContext(), including those already using an Eigen context of
+// their own. Fails if 'context' already uses another shared context.
+TfLiteStatus UseSharedContext(TfLiteContext* context,
+                              TfLiteExternalContext* shared_context);
+
 }  // namespace eigen_support
 }  // namespace tflite
 
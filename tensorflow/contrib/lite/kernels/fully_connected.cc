@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
+#include "tensorflow/contrib/lite/kernels/quantized_gemm.h"
 
 namespace tflite {
 namespace ops {
@@ -56,6 +57,10 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int input_quantized_index;
+  // The uint8 weights, packed once for quantized_gemm::PackedGemv() if it is
+  // the chosen backend.
+  quantized_gemm::PackedWeights packed_weights;
+  bool weights_packed = false;
 };
 
 constexpr int kInputTensor = 0;
@@ -89,8 +94,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, node->inputs->size, 3);
   // Shuffled formats need a workspace to store the shuffled input activations.
   const int expected_outputs_count =
-      params->weights_format == kTfLiteFullyConnectedWeightsFormatDefault ? 1
-                                                                          : 2;
+      params->weights_format ==
+              kTfLiteFullyConnectedWeightsFormatShuffled4x16Int8
+          ? 2
+          : 1;
   TF_LITE_ENSURE_EQ(context, node->outputs->size, expected_outputs_count);
 
   const TfLiteTensor* input = GetInput(context, node, kInputTensor);
@@ -114,6 +121,19 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, NumElements(bias), SizeOfDimension(filter, 0));
   }
 
+  // Block sparse weights are only supported for float, and the filter must
+  // carry the block structure that the format promises.
+  const bool sparse_weights =
+      params->weights_format == kTfLiteFullyConnectedWeightsFormatBlockSparse;
+  TF_LITE_ENSURE_EQ(context, sparse_weights, filter->sparsity != nullptr);
+  if (sparse_weights) {
+    TF_LITE_ENSURE_EQ(context, input->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteFloat32);
+  }
+
+  // The weights may have changed, and are packed again if needed.
+  data->weights_packed = false;
+
   // Note that quantized inference requires that all tensors have their
   // parameters set. This is usually done during quantized training.
   TfLiteType data_type = input->type;
@@ -193,6 +213,37 @@ TfLiteStatus EvalPie(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+TfLiteStatus EvalSparse(TfLiteContext* context, TfLiteNode* node,
+                        TfLiteFullyConnectedParams* params,
+                        const TfLiteTensor* input, const TfLiteTensor* filter,
+                        const TfLiteTensor* bias, TfLiteTensor* output) {
+  const TfLiteSparsity* sparsity = filter->sparsity;
+  const int input_size = filter->dims->data[1];
+  const int batch_size = NumElements(input) / input_size;
+  const int num_units = filter->dims->data[0];
+
+  // Output = bias if bias tensor exists.
+  if (bias) {
+    tensor_utils::VectorBatchVectorAssign(bias->data.f, num_units, batch_size,
+                                          output->data.f);
+  } else {
+    tensor_utils::ZeroVector(output->data.f, batch_size * num_units);
+  }
+
+  // Compute output += weight * input, visiting only the non-zero blocks.
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate(
+      filter->data.f, sparsity->row_segments->data,
+      sparsity->block_indices->data, sparsity->block_size, num_units,
+      input_size, input->data.f, batch_size, output->data.f,
+      /*result_stride=*/1);
+
+  // Apply activation function
+  tensor_utils::ApplyActivationToVector(output->data.f, batch_size * num_units,
+                                        params->activation, output->data.f);
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus EvalPieQuantized(TfLiteContext* context, TfLiteNode* node,
                               TfLiteFullyConnectedParams* params, OpData* data,
                               const TfLiteTensor* input,
@@ -271,6 +322,38 @@ TfLiteStatus EvalPieQuantized(TfLiteContext* context, TfLiteNode* node,
     macro_name(target_namespace, kRelu6);                            \
   }
 
+quantized_gemm::Backend ChooseQuantizedGemmBackend(TfLiteContext* context,
+                                                   const TfLiteTensor* input,
+                                                   const TfLiteTensor* filter) {
+  const int num_units = SizeOfDimension(filter, 0);
+  const int input_size = SizeOfDimension(filter, 1);
+  const int batch_size = NumElements(input) / input_size;
+  // Only constant weights can be packed once for all invokes.
+  const bool weights_cached =
+      context->cache_transformed_weights && IsConstantTensor(filter);
+  return quantized_gemm::ChooseBackend(num_units, input_size, batch_size,
+                                       weights_cached);
+}
+
+void EvalPackedGemv(OpData* data, const TfLiteTensor* input,
+                    const TfLiteTensor* filter, const TfLiteTensor* bias,
+                    TfLiteTensor* output) {
+  const int num_units = SizeOfDimension(filter, 0);
+  const int input_size = SizeOfDimension(filter, 1);
+  if (!data->weights_packed) {
+    quantized_gemm::PackWeights(GetTensorData<uint8_t>(filter), num_units,
+                                input_size, &data->packed_weights);
+    data->weights_packed = true;
+  }
+  quantized_gemm::PackedGemv(
+      data->packed_weights, -filter->params.zero_point,
+      GetTensorData<uint8_t>(input), -input->params.zero_point,
+      NumElements(input) / input_size, GetTensorData<int32_t>(bias),
+      output->params.zero_point, data->output_multiplier, data->output_shift,
+      data->output_activation_min, data->output_activation_max,
+      GetTensorData<uint8_t>(output));
+}
+
 template <KernelType kernel_type>
 TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                            TfLiteFullyConnectedParams* params, OpData* data,
@@ -314,6 +397,12 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   } else {
     switch (output->type) {
       case kTfLiteUInt8:
+        if (input->type == kTfLiteUInt8 &&
+            ChooseQuantizedGemmBackend(context, input, filter) ==
+                quantized_gemm::Backend::kPackedGemv) {
+          EvalPackedGemv(data, input, filter, bias, output);
+          break;
+        }
         TF_LITE_FULLY_CONNECTED(optimized_ops, uint8_t);
         break;
       case kTfLiteInt16:
@@ -410,6 +499,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (filter->type) {  // Already know in/out types are same.
     case kTfLiteFloat32:
+      if (params->weights_format ==
+          kTfLiteFullyConnectedWeightsFormatBlockSparse) {
+        return EvalSparse(context, node, params, input, filter, bias, output);
+      }
       return EvalFloat<kernel_type>(context, node, params, data, input, filter,
                                     bias, output);
     case kTfLiteUInt8:
@@ -314,6 +314,42 @@ class HybridFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// Fully connected op whose weights are constant and stored in the block sparse
+// format.
+class SparseFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseFullyConnectedOpModel(TfLiteRegistration* registration, int units,
+                              int batches, int input_size,
+                              const std::vector<float>& weights,
+                              int block_size) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, input_size}});
+    weights_ =
+        AddBlockSparseConstInput(weights, {units, input_size}, block_size);
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput({TensorType_FLOAT32});
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(
+            builder_, ActivationFunctionType_RELU,
+            FullyConnectedOptionsWeightsFormat_BLOCK_SPARSE)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)});
+  }
+
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
 const auto kKernelMap = new std::map<string, TfLiteRegistration*>({
     {"Reference", ops::builtin::Register_FULLY_CONNECTED_REF()},
     {"NeonOptimized", ops::builtin::Register_FULLY_CONNECTED_NEON_OPT()},
@@ -393,6 +429,28 @@ TEST_P(FloatFullyConnectedOpTest, SimpleTest2) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(11, 9));
 }
 
+TEST_P(FloatFullyConnectedOpTest, BlockSparseWeightsTest) {
+  SparseFullyConnectedOpModel m(GetRegistration(), /*units=*/3, /*batches=*/2,
+                                /*input_size=*/8,
+                                /*weights=*/
+                                {
+                                    1, 2, 3, 4, 0, 0, 0, 0,  // u = 0
+                                    0, 0, 0, 0, 0, 0, 0, 0,  // u = 1
+                                    0, 0, 0, 0, 5, 6, 7, 8,  // u = 2
+                                },
+                                /*block_size=*/4);
+  m.SetBias({1, 2, 3});
+
+  m.SetInput({
+      1, 1, 1, 1, 1, 1, 1, 1,      // b = 0
+      1, 2, 3, 4, -1, -1, -1, -1,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAre(11, 2, 29, 31, 2, 0));
+}
+
 TEST_P(QuantizedFullyConnectedOpTest, SimpleTestQuantized) {
   QuantizedFullyConnectedOpModel m(
       GetRegistration(), /*units=*/3, /*batches*/ 2,
@@ -14,7 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/kernels/gemm_support.h"
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
 
@@ -25,6 +29,18 @@ namespace {
 struct RefCountedGemmContext : public TfLiteExternalContext {
   std::unique_ptr<gemmlowp::GemmContext> gemm_context;
   int num_references = 0;
+  // A GemmContext can't be used by several threads at once, so ops running
+  // concurrently (see Interpreter::SetNumInterOpThreads()) each get their
+  // own. The first thread asking for one gets 'gemm_context'.
+  std::mutex mutex;
+  std::thread::id owner;
+  std::map<std::thread::id, std::unique_ptr<gemmlowp::GemmContext>>
+      thread_contexts;
+  // Set for contexts made by CreateSharedContext(), which the Refresh() of
+  // one TfLiteContext leaves alone. Each TfLiteContext may instead use up to
+  // 'max_num_threads' threads per GEMM.
+  bool shared = false;
+  int max_num_threads = 0;
 };
 
 RefCountedGemmContext* GetGemmLowpContext(TfLiteContext* context) {
@@ -34,12 +50,29 @@ RefCountedGemmContext* GetGemmLowpContext(TfLiteContext* context) {
 
 TfLiteStatus Refresh(TfLiteContext* context) {
   auto* ptr = GetGemmLowpContext(context);
-  if (ptr != nullptr) {
+  if (ptr != nullptr && !ptr->shared) {
     ptr->gemm_context->set_max_num_threads(context->recommended_num_threads);
+    std::lock_guard<std::mutex> lock(ptr->mutex);
+    for (auto& thread_context : ptr->thread_contexts) {
+      thread_context.second->set_max_num_threads(
+          context->recommended_num_threads);
+    }
   }
   return kTfLiteOk;
 }
 
+// Drops 'count' references to 'ptr', and deletes it if none are left.
+// Returns whether it was deleted.
+bool ReleaseReferences(RefCountedGemmContext* ptr, int count) {
+  {
+    std::lock_guard<std::mutex> lock(ptr->mutex);
+    ptr->num_references -= count;
+    if (ptr->num_references > 0) return false;
+  }
+  delete ptr;
+  return true;
+}
+
 }  // namespace
 
 void IncrementUsageCounter(TfLiteContext* context) {
@@ -55,6 +88,7 @@ void IncrementUsageCounter(TfLiteContext* context) {
     ptr->num_references = 0;
     context->SetExternalContext(context, kTfLiteGemmLowpContext, ptr);
   }
+  std::lock_guard<std::mutex> lock(ptr->mutex);
   ptr->num_references++;
 }
 
@@ -65,8 +99,7 @@ void DecrementUsageCounter(TfLiteContext* context) {
         "Call to DecrementUsageCounter() not preceded by "
         "IncrementUsageCounter()");
   }
-  if (--ptr->num_references == 0) {
-    delete ptr;
+  if (ReleaseReferences(ptr, 1)) {
     context->SetExternalContext(context, kTfLiteGemmLowpContext, nullptr);
   }
 }
@@ -77,7 +110,73 @@ gemmlowp::GemmContext* GetFromContext(TfLiteContext* context) {
     TF_LITE_FATAL(
         "Call to GetFromContext() not preceded by IncrementUsageCounter()");
   }
-  return ptr->gemm_context.get();
+  const std::thread::id this_thread = std::this_thread::get_id();
+  std::lock_guard<std::mutex> lock(ptr->mutex);
+  if (ptr->owner == std::thread::id()) {
+    ptr->owner = this_thread;
+  }
+  gemmlowp::GemmContext* gemm_context = ptr->gemm_context.get();
+  if (ptr->owner != this_thread) {
+    std::unique_ptr<gemmlowp::GemmContext>& thread_context =
+        ptr->thread_contexts[this_thread];
+    if (!thread_context) {
+      thread_context.reset(new gemmlowp::GemmContext());
+      thread_context->set_max_num_threads(
+          ptr->gemm_context->max_num_threads());
+    }
+    gemm_context = thread_context.get();
+  }
+  if (ptr->shared) {
+    // Only this thread uses 'gemm_context' until the op is done with it.
+    int num_threads = ptr->max_num_threads;
+    if (context->recommended_num_threads > 0 &&
+        (num_threads == 0 || context->recommended_num_threads < num_threads)) {
+      num_threads = context->recommended_num_threads;
+    }
+    gemm_context->set_max_num_threads(num_threads);
+  }
+  return gemm_context;
+}
+
+TfLiteExternalContext* CreateSharedContext(int max_num_threads) {
+  auto* ptr = new RefCountedGemmContext;
+  ptr->type = kTfLiteGemmLowpContext;
+  ptr->Refresh = Refresh;
+  ptr->gemm_context.reset(new gemmlowp::GemmContext());
+  ptr->shared = true;
+  ptr->max_num_threads = std::max(max_num_threads, 0);
+  ptr->gemm_context->set_max_num_threads(ptr->max_num_threads);
+  // Held by the caller until ReleaseSharedContext().
+  ptr->num_references = 1;
+  return ptr;
+}
+
+void ReleaseSharedContext(TfLiteExternalContext* shared_context) {
+  ReleaseReferences(static_cast<RefCountedGemmContext*>(shared_context), 1);
+}
+
+TfLiteStatus UseSharedContext(TfLiteContext* context,
+                              TfLiteExternalContext* shared_context) {
+  auto* shared_ptr = static_cast<RefCountedGemmContext*>(shared_context);
+  auto* ptr = GetGemmLowpContext(context);
+  if (ptr == shared_ptr) return kTfLiteOk;
+  if (ptr != nullptr && ptr->shared) {
+    context->ReportError(context,
+                         "Already using another shared gemmlowp context.");
+    return kTfLiteError;
+  }
+  // The ops already using a context of their own move to the shared one.
+  int num_references = 0;
+  if (ptr != nullptr) {
+    num_references = ptr->num_references;
+    delete ptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared_ptr->mutex);
+    shared_ptr->num_references += num_references;
+  }
+  context->SetExternalContext(context, kTfLiteGemmLowpContext, shared_ptr);
+  return kTfLiteOk;
 }
 
 }  // namespace gemm_support
@@ -22,7 +22,8 @@ namespace tflite {
 namespace gemm_support {
 
 // Returns the GemmContext stored in 'context', allowing multiple ops to
-// share a single object, as long as they share a TfLiteContext. The caller
+// share a single object, as long as they share a TfLiteContext and run on the
+// same thread; ops running concurrently get one per thread. The caller
 // must ensure that this is called between IncrementUsageCounter() and
 // DecrementUsageCounter(). For example, in the implementation of an op:
 //   void* Init(TfLiteContext* context, const char*, size_t) {
@@ -45,6 +46,22 @@ void IncrementUsageCounter(TfLiteContext* context);
 // 'context'. If there are no more usages the GemmContext will be deleted.
 void DecrementUsageCounter(TfLiteContext* context);
 
+// Returns a new GemmContext that several TfLiteContexts can share through
+// UseSharedContext(), so that interpreters don't each start their own
+// threads. A GEMM uses up to 'max_num_threads' threads, or up to the
+// recommended number of threads of the TfLiteContext running it if that is
+// lower; 0 means as many as there are cores. GEMMs run from different threads
+// still get different GemmContexts. The caller must free the result with
+// ReleaseSharedContext() once the TfLiteContexts using it are gone.
+TfLiteExternalContext* CreateSharedContext(int max_num_threads);
+void ReleaseSharedContext(TfLiteExternalContext* shared_context);
+
+// Makes the ops of 'context' use 'shared_context', from
+// CreateSharedContext(), including those already using a GemmContext of
+// their own. Fails if 'context' already uses another shared context.
+TfLiteStatus UseSharedContext(TfLiteContext* context,
+                              TfLiteExternalContext* shared_context);
+
 }  // namespace gemm_support
 }  // namespace tflite
 
@@ -46,6 +46,51 @@ inline bool TestCPUFeatureNeon() { return false; }
 
 }  // namespace tflite
 
+#if defined __aarch64__ && defined __ARM_FEATURE_DOTPROD && defined __linux__
+#include <sys/auxv.h>
+
+#ifndef HWCAP_ASIMDDP
+#define HWCAP_ASIMDDP (1 << 20)
+#endif
+#endif
+
+namespace tflite {
+
+// Runtime check for the ARMv8.2 dot product instructions (SDOT/UDOT), which
+// are optional in ARMv8.2. Kernels using them are only built when the compiler
+// targets them, e.g. with -march=armv8.2-a+dotprod.
+inline bool TestCPUFeatureDotprod() {
+#if defined __aarch64__ && defined __ARM_FEATURE_DOTPROD && defined __linux__
+  static const bool kUseDotprod = (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) != 0;
+  return kUseDotprod;
+#else
+  return false;
+#endif
+}
+
+// Runtime checks for the x86 SSE4.1 and AVX2 instructions. The kernels using
+// them are compiled for these instruction sets with target attributes, so
+// that a binary built for baseline x86 uses them where they are available.
+inline bool TestCPUFeatureSse4_1() {
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+  static const bool kUseSse4_1 = __builtin_cpu_supports("sse4.1");
+  return kUseSse4_1;
+#else
+  return false;
+#endif
+}
+
+inline bool TestCPUFeatureAvx2() {
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+  static const bool kUseAvx2 = __builtin_cpu_supports("avx2");
+  return kUseAvx2;
+#else
+  return false;
+#endif
+}
+
+}  // namespace tflite
+
 // NEON_OR_PORTABLE(SomeFunc, arcs) calls NeonSomeFunc(args) if Neon is both
 // enabled at build time and detected at runtime, or PortableSomeFunc(args)
 // otherwise.
@@ -58,4 +103,10 @@ inline bool TestCPUFeatureNeon() { return false; }
                        : Portable##funcname(__VA_ARGS__)
 #endif
 
+// SSE_OR_PORTABLE(SomeFunc, args) calls SseSomeFunc(args) if SSE4.1 is
+// detected at runtime, or PortableSomeFunc(args) otherwise.
+#define SSE_OR_PORTABLE(funcname, ...)                 \
+  TestCPUFeatureSse4_1() ? Sse##funcname(__VA_ARGS__) \
+                         : Portable##funcname(__VA_ARGS__)
+
 #endif  // TENSORFLOW_CONTRIB_LITE_KERNELS_INTERNAL_OPTIMIZED_CPU_CHECK_
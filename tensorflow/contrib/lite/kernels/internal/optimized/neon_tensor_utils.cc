@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/contrib/lite/kernels/activation_functor.h"
 #include "tensorflow/contrib/lite/kernels/internal/common.h"
 #include "tensorflow/contrib/lite/kernels/internal/compatibility.h"
+#include "tensorflow/contrib/lite/kernels/internal/optimized/cpu_check.h"
 #include "tensorflow/contrib/lite/kernels/internal/optimized/tensor_utils_impl.h"
 #include "tensorflow/contrib/lite/kernels/internal/round.h"
 
@@ -43,6 +44,41 @@ void* aligned_alloc(size_t alignment, size_t size, void** freeing_buffer) {
              : ((char*)*freeing_buffer + (alignment - offset));  // NOLINT
 }
 
+#if defined __aarch64__ && defined __ARM_FEATURE_DOTPROD
+// Variant of the int8 NeonMatrixBatchVectorMultiplyAccumulate() for cores with
+// the SDOT instruction, which multiplies and accumulates 16 pairs of int8 into
+// 4 int32 in one go, instead of widening them to int16 first.
+void DotprodMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors, const float* scaling_factors,
+    int n_batch, float* __restrict__ result, int result_stride) {
+  const int kWeightsPerNeonLane = 16;
+  const int postamble_start = m_cols - (m_cols & (kWeightsPerNeonLane - 1));
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const float batch_scaling_factor = scaling_factors[batch];
+    const int8_t* vector = vectors + batch * m_cols;
+    const int8_t* row_ptr = matrix;
+    for (int row = 0; row < m_rows;
+         ++row, row_ptr += m_cols, result += result_stride) {
+      int32x4_t dotprod = vmovq_n_s32(0);
+      __builtin_prefetch(row_ptr, 0 /* prefetch for read */,
+                         3 /* temporal locality */);
+      int col = 0;
+      for (; col < postamble_start; col += kWeightsPerNeonLane) {
+        const int8x16_t s1_8x16 = vld1q_s8(vector + col);
+        const int8x16_t s2_8x16 = vld1q_s8(row_ptr + col);
+        dotprod = vdotq_s32(dotprod, s1_8x16, s2_8x16);
+      }
+      int32 sum = vaddvq_s32(dotprod);
+      for (; col < m_cols; ++col) {
+        sum += row_ptr[col] * vector[col];
+      }
+      *result += sum * batch_scaling_factor;
+    }
+  }
+}
+#endif  // __ARM_FEATURE_DOTPROD
+
 }  // namespace
 
 void NeonMatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
@@ -84,10 +120,60 @@ void NeonMatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride) {
+  // Each block is multiplied kFloatWeightsPerNeonLane values at a time, so
+  // other block sizes take the portable path.
+  if (block_size % kFloatWeightsPerNeonLane != 0) {
+    PortableSparseMatrixBatchVectorMultiplyAccumulate(
+        matrix, row_segments, block_indices, block_size, m_rows, m_cols,
+        vector, n_batch, result, result_stride);
+    return;
+  }
+
+  for (int b = 0; b < n_batch; b++) {
+    float* result_in_batch = result + b * m_rows * result_stride;
+    const float* vector_in_batch = vector + b * m_cols;
+
+    for (int r = 0; r < m_rows; r++) {
+      float32x4_t acc_32x4 = vmovq_n_f32(0.0);
+      for (int i = row_segments[r]; i < row_segments[r + 1]; i++) {
+        const float* block = matrix + i * block_size;
+        const float* vector_block =
+            vector_in_batch + block_indices[i] * block_size;
+        for (int c = 0; c < block_size; c += kFloatWeightsPerNeonLane) {
+          // Load 4 float values from vector and matrix block.
+          float32x4_t vector_f32x4 = vld1q_f32(vector_block + c);
+          float32x4_t matrix_f32x4 = vld1q_f32(block + c);
+          // Multiply the vector and matrix block and add to accumulator.
+          acc_32x4 = vmlaq_f32(acc_32x4, matrix_f32x4, vector_f32x4);
+        }
+      }
+      // Add the 4 intermediate sum values to get the final dot-prod value for
+      // this row.
+      *result_in_batch +=
+          (vgetq_lane_f32(acc_32x4, 0) + vgetq_lane_f32(acc_32x4, 1) +
+           vgetq_lane_f32(acc_32x4, 2) + vgetq_lane_f32(acc_32x4, 3));
+      result_in_batch += result_stride;
+    }
+  }
+}
+
 void NeonMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
     const int8_t* __restrict__ vectors, const float* scaling_factors,
     int n_batch, float* __restrict__ result, int result_stride) {
+#if defined __aarch64__ && defined __ARM_FEATURE_DOTPROD
+  if (TestCPUFeatureDotprod()) {
+    DotprodMatrixBatchVectorMultiplyAccumulate(matrix, m_rows, m_cols, vectors,
+                                               scaling_factors, n_batch,
+                                               result, result_stride);
+    return;
+  }
+#endif  // __ARM_FEATURE_DOTPROD
   const int kWeightsPerUint32 = 4;
   const int kWeightsPerNeonLane = 16;
   // If the number of rows is not divisible by kWeightsPerUint32, we set a
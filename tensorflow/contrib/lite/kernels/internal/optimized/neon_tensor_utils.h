@@ -32,6 +32,16 @@ void MatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
                    vector, n_batch, result, result_stride);
 }
 
+void SparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride) {
+  NEON_OR_PORTABLE(SparseMatrixBatchVectorMultiplyAccumulate, matrix,
+                   row_segments, block_indices, block_size, m_rows, m_cols,
+                   vector, n_batch, result, result_stride);
+}
+
 void MatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
     const int8_t* __restrict__ vectors, const float* scaling_factors,
@@ -0,0 +1,436 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/contrib/lite/kernels/internal/optimized/cpu_check.h"
+#include "tensorflow/contrib/lite/kernels/internal/optimized/tensor_utils_impl.h"
+#include "tensorflow/contrib/lite/kernels/internal/round.h"
+
+#ifdef USE_SSE_TENSOR_UTILS
+
+#include <immintrin.h>
+
+// The kernels are compiled for SSE4.1 or AVX2 whatever the flags of the build,
+// and are only called once cpu_check.h has detected these instruction sets.
+#define SSE4_1_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+#define kFloatWeightsPerSseLane 4
+#define kFloatWeightsPerAvx2Lane 8
+#define kInt8WeightsPerSseLane 16
+
+namespace tflite {
+namespace tensor_utils {
+namespace {
+
+SSE4_1_TARGET inline float HorizontalSum(__m128 values) {
+  const __m128 high = _mm_movehl_ps(values, values);
+  const __m128 sum = _mm_add_ps(values, high);
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+}
+
+SSE4_1_TARGET inline int32_t HorizontalSum(__m128i values) {
+  values = _mm_add_epi32(values,
+                         _mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2)));
+  values = _mm_add_epi32(values,
+                         _mm_shuffle_epi32(values, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(values);
+}
+
+// Multiplies 16 pairs of int8 and adds the products to the 4 int32 of 'acc'.
+SSE4_1_TARGET inline __m128i DotProductAccumulate(__m128i acc, __m128i a,
+                                                  __m128i b) {
+  const __m128i a_low = _mm_cvtepi8_epi16(a);
+  const __m128i b_low = _mm_cvtepi8_epi16(b);
+  const __m128i a_high = _mm_cvtepi8_epi16(_mm_srli_si128(a, 8));
+  const __m128i b_high = _mm_cvtepi8_epi16(_mm_srli_si128(b, 8));
+  acc = _mm_add_epi32(acc, _mm_madd_epi16(a_low, b_low));
+  return _mm_add_epi32(acc, _mm_madd_epi16(a_high, b_high));
+}
+
+// Rounds half away from zero like TfLiteRound(), which _mm_round_ps() can't.
+SSE4_1_TARGET inline __m128i RoundToInt32(__m128 values) {
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  const __m128 truncated =
+      _mm_round_ps(values, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  // The fractional part is exact, so comparing it to 0.5 is too.
+  const __m128 fraction =
+      _mm_andnot_ps(sign_mask, _mm_sub_ps(values, truncated));
+  const __m128 round_away = _mm_cmpge_ps(fraction, _mm_set1_ps(0.5f));
+  const __m128 signed_one =
+      _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(values, sign_mask));
+  return _mm_cvtps_epi32(
+      _mm_add_ps(truncated, _mm_and_ps(round_away, signed_one)));
+}
+
+AVX2_TARGET void Avx2MatrixBatchVectorMultiplyAccumulate(
+    const float* matrix, int m_rows, int m_cols, const float* vector,
+    int n_batch, float* result, int result_stride) {
+  const int postamble_start =
+      m_cols - (m_cols & (kFloatWeightsPerAvx2Lane - 1));
+  for (int b = 0; b < n_batch; b++) {
+    float* result_in_batch = result + b * m_rows * result_stride;
+    const float* vector_in_batch = vector + b * m_cols;
+    const float* matrix_row = matrix;
+    for (int r = 0; r < m_rows; r++) {
+      __m256 acc = _mm256_setzero_ps();
+      for (int c = 0; c < postamble_start; c += kFloatWeightsPerAvx2Lane) {
+        const __m256 matrix_x8 = _mm256_loadu_ps(matrix_row + c);
+        const __m256 vector_x8 = _mm256_loadu_ps(vector_in_batch + c);
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(matrix_x8, vector_x8));
+      }
+      float sum = HorizontalSum(_mm_add_ps(_mm256_castps256_ps128(acc),
+                                           _mm256_extractf128_ps(acc, 1)));
+      for (int c = postamble_start; c < m_cols; c++) {
+        sum += matrix_row[c] * vector_in_batch[c];
+      }
+      *result_in_batch += sum;
+      matrix_row += m_cols;
+      result_in_batch += result_stride;
+    }
+  }
+}
+
+// Variant of the int8 SseMatrixBatchVectorMultiplyAccumulate() which widens
+// 16 pairs of int8 to int16 in one instruction per operand, and multiplies
+// and adds them into 8 int32 at a time.
+AVX2_TARGET void Avx2MatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors, const float* scaling_factors,
+    int n_batch, float* __restrict__ result, int result_stride) {
+  const int postamble_start =
+      m_cols - (m_cols & (kInt8WeightsPerSseLane - 1));
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const float batch_scaling_factor = scaling_factors[batch];
+    const int8_t* vector = vectors + batch * m_cols;
+    const int8_t* row_ptr = matrix;
+    for (int row = 0; row < m_rows;
+         ++row, row_ptr += m_cols, result += result_stride) {
+      __m256i dotprod = _mm256_setzero_si256();
+      int col = 0;
+      for (; col < postamble_start; col += kInt8WeightsPerSseLane) {
+        const __m256i row_16x16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(row_ptr + col)));
+        const __m256i vector_16x16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(vector + col)));
+        dotprod = _mm256_add_epi32(dotprod,
+                                   _mm256_madd_epi16(row_16x16, vector_16x16));
+      }
+      int32_t sum = HorizontalSum(
+          _mm_add_epi32(_mm256_castsi256_si128(dotprod),
+                        _mm256_extracti128_si256(dotprod, 1)));
+      for (; col < m_cols; ++col) {
+        sum += row_ptr[col] * vector[col];
+      }
+      *result += sum * batch_scaling_factor;
+    }
+  }
+}
+
+}  // namespace
+
+SSE4_1_TARGET void SseMatrixBatchVectorMultiplyAccumulate(
+    const float* matrix, int m_rows, int m_cols, const float* vector,
+    int n_batch, float* result, int result_stride) {
+  if (TestCPUFeatureAvx2()) {
+    Avx2MatrixBatchVectorMultiplyAccumulate(matrix, m_rows, m_cols, vector,
+                                            n_batch, result, result_stride);
+    return;
+  }
+  const int postamble_start =
+      m_cols - (m_cols & (kFloatWeightsPerSseLane - 1));
+  for (int b = 0; b < n_batch; b++) {
+    float* result_in_batch = result + b * m_rows * result_stride;
+    const float* vector_in_batch = vector + b * m_cols;
+    const float* matrix_row = matrix;
+    for (int r = 0; r < m_rows; r++) {
+      __m128 acc = _mm_setzero_ps();
+      for (int c = 0; c < postamble_start; c += kFloatWeightsPerSseLane) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(matrix_row + c),
+                                         _mm_loadu_ps(vector_in_batch + c)));
+      }
+      float sum = HorizontalSum(acc);
+      for (int c = postamble_start; c < m_cols; c++) {
+        sum += matrix_row[c] * vector_in_batch[c];
+      }
+      *result_in_batch += sum;
+      matrix_row += m_cols;
+      result_in_batch += result_stride;
+    }
+  }
+}
+
+SSE4_1_TARGET void SseMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors, const float* scaling_factors,
+    int n_batch, float* __restrict__ result, int result_stride) {
+  if (TestCPUFeatureAvx2()) {
+    Avx2MatrixBatchVectorMultiplyAccumulate(matrix, m_rows, m_cols, vectors,
+                                            scaling_factors, n_batch, result,
+                                            result_stride);
+    return;
+  }
+  const int postamble_start =
+      m_cols - (m_cols & (kInt8WeightsPerSseLane - 1));
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const float batch_scaling_factor = scaling_factors[batch];
+    const int8_t* vector = vectors + batch * m_cols;
+    const int8_t* row_ptr = matrix;
+    for (int row = 0; row < m_rows;
+         ++row, row_ptr += m_cols, result += result_stride) {
+      __m128i dotprod = _mm_setzero_si128();
+      int col = 0;
+      for (; col < postamble_start; col += kInt8WeightsPerSseLane) {
+        dotprod = DotProductAccumulate(
+            dotprod,
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_ptr + col)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(vector + col)));
+      }
+      int32_t sum = HorizontalSum(dotprod);
+      for (; col < m_cols; ++col) {
+        sum += row_ptr[col] * vector[col];
+      }
+      *result += sum * batch_scaling_factor;
+    }
+  }
+}
+
+SSE4_1_TARGET void SseVectorVectorCwiseProduct(const float* vector1,
+                                               const float* vector2,
+                                               int v_size, float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    _mm_storeu_ps(result + v, _mm_mul_ps(_mm_loadu_ps(vector1 + v),
+                                         _mm_loadu_ps(vector2 + v)));
+  }
+  for (int v = postamble_start; v < v_size; v++) {
+    result[v] = vector1[v] * vector2[v];
+  }
+}
+
+SSE4_1_TARGET void SseVectorVectorCwiseProductAccumulate(const float* vector1,
+                                                         const float* vector2,
+                                                         int v_size,
+                                                         float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    const __m128 product =
+        _mm_mul_ps(_mm_loadu_ps(vector1 + v), _mm_loadu_ps(vector2 + v));
+    _mm_storeu_ps(result + v, _mm_add_ps(_mm_loadu_ps(result + v), product));
+  }
+  for (int v = postamble_start; v < v_size; v++) {
+    result[v] += vector1[v] * vector2[v];
+  }
+}
+
+SSE4_1_TARGET void SseVectorBatchVectorCwiseProductAccumulate(
+    const float* vector, int v_size, const float* batch_vector, int n_batch,
+    float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  float* result_ptr = result;
+  const float* batch_vector_ptr = batch_vector;
+  for (int b = 0; b < n_batch; b++) {
+    for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+      const __m128 product = _mm_mul_ps(_mm_loadu_ps(vector + v),
+                                        _mm_loadu_ps(batch_vector_ptr + v));
+      _mm_storeu_ps(result_ptr + v,
+                    _mm_add_ps(_mm_loadu_ps(result_ptr + v), product));
+    }
+    for (int v = postamble_start; v < v_size; v++) {
+      result_ptr[v] += vector[v] * batch_vector_ptr[v];
+    }
+    result_ptr += v_size;
+    batch_vector_ptr += v_size;
+  }
+}
+
+SSE4_1_TARGET float SseVectorVectorDotProduct(const float* vector1,
+                                              const float* vector2,
+                                              int v_size) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  __m128 acc = _mm_setzero_ps();
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    acc = _mm_add_ps(
+        acc, _mm_mul_ps(_mm_loadu_ps(vector1 + v), _mm_loadu_ps(vector2 + v)));
+  }
+  float result = HorizontalSum(acc);
+  for (int v = postamble_start; v < v_size; v++) {
+    result += vector1[v] * vector2[v];
+  }
+  return result;
+}
+
+void SseBatchVectorBatchVectorDotProduct(const float* vector1,
+                                         const float* vector2, int v_size,
+                                         int n_batch, float* result,
+                                         int result_stride) {
+  float* result_ptr = result;
+  const float* vector1_ptr = vector1;
+  const float* vector2_ptr = vector2;
+  for (int b = 0; b < n_batch; b++) {
+    *result_ptr = SseVectorVectorDotProduct(vector1_ptr, vector2_ptr, v_size);
+    vector1_ptr += v_size;
+    vector2_ptr += v_size;
+    result_ptr += result_stride;
+  }
+}
+
+SSE4_1_TARGET void SseSub1Vector(const float* vector, int v_size,
+                                 float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    _mm_storeu_ps(result + v, _mm_sub_ps(one, _mm_loadu_ps(vector + v)));
+  }
+  for (int v = postamble_start; v < v_size; v++) {
+    result[v] = 1.0f - vector[v];
+  }
+}
+
+SSE4_1_TARGET bool SseIsZeroVector(const float* vector, int v_size) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  const __m128 zero = _mm_setzero_ps();
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_loadu_ps(vector + v), zero))) {
+      return false;
+    }
+  }
+  for (int v = postamble_start; v < v_size; ++v) {
+    if (vector[v] != 0.0f) return false;
+  }
+  return true;
+}
+
+SSE4_1_TARGET void SseClipVector(const float* vector, int v_size,
+                                 float abs_limit, float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  const __m128 abs_limit_x4 = _mm_set1_ps(abs_limit);
+  const __m128 neg_abs_limit_x4 = _mm_set1_ps(-abs_limit);
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    // The operand order matches PortableClip() for NaNs.
+    const __m128 clipped = _mm_min_ps(abs_limit_x4, _mm_loadu_ps(vector + v));
+    _mm_storeu_ps(result + v, _mm_max_ps(neg_abs_limit_x4, clipped));
+  }
+  for (int v = postamble_start; v < v_size; v++) {
+    result[v] = (abs_limit < vector[v]) ? abs_limit : vector[v];
+    result[v] = (-abs_limit > result[v]) ? -abs_limit : result[v];
+  }
+}
+
+SSE4_1_TARGET void SseVectorScalarMultiply(const int8_t* vector,
+                                           const int v_size, const float scale,
+                                           float* result) {
+  const int postamble_start =
+      v_size - (v_size & (kFloatWeightsPerSseLane - 1));
+  const __m128 scale_x4 = _mm_set1_ps(scale);
+  for (int v = 0; v < postamble_start; v += kFloatWeightsPerSseLane) {
+    int32_t packed;
+    memcpy(&packed, vector + v, sizeof(packed));
+    const __m128 values =
+        _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(packed)));
+    _mm_storeu_ps(result + v, _mm_mul_ps(scale_x4, values));
+  }
+  for (int v = postamble_start; v < v_size; v++) {
+    result[v] = scale * vector[v];
+  }
+}
+
+SSE4_1_TARGET void SseSymmetricQuantizeFloats(const float* values,
+                                              const int size,
+                                              int8_t* quantized_values,
+                                              float* min, float* max,
+                                              float* scaling_factor) {
+  const int postamble_start =
+      size - (size & (kFloatWeightsPerSseLane - 1));
+  float min_value = size > 0 ? values[0] : 0.0f;
+  float max_value = min_value;
+  if (postamble_start > 0) {
+    __m128 min_x4 = _mm_loadu_ps(values);
+    __m128 max_x4 = min_x4;
+    for (int i = kFloatWeightsPerSseLane; i < postamble_start;
+         i += kFloatWeightsPerSseLane) {
+      const __m128 value_x4 = _mm_loadu_ps(values + i);
+      min_x4 = _mm_min_ps(min_x4, value_x4);
+      max_x4 = _mm_max_ps(max_x4, value_x4);
+    }
+    float min_lanes[kFloatWeightsPerSseLane];
+    float max_lanes[kFloatWeightsPerSseLane];
+    _mm_storeu_ps(min_lanes, min_x4);
+    _mm_storeu_ps(max_lanes, max_x4);
+    min_value =
+        *std::min_element(min_lanes, min_lanes + kFloatWeightsPerSseLane);
+    max_value =
+        *std::max_element(max_lanes, max_lanes + kFloatWeightsPerSseLane);
+  }
+  for (int i = postamble_start; i < size; ++i) {
+    min_value = std::min(min_value, values[i]);
+    max_value = std::max(max_value, values[i]);
+  }
+  *min = min_value;
+  *max = max_value;
+
+  const int kScale = 127;
+  const float range = std::max(std::abs(min_value), std::abs(max_value));
+  if (range == 0) {
+    memset(quantized_values, 0, size * sizeof(int8_t));
+    *scaling_factor = 1;
+    return;
+  }
+  *scaling_factor = range / kScale;
+  const float scaling_factor_inv = 1.0f / *scaling_factor;
+
+  const int quantize_postamble_start =
+      size - (size & (kInt8WeightsPerSseLane - 1));
+  const __m128 scaling_factor_inv_x4 = _mm_set1_ps(scaling_factor_inv);
+  const __m128i scale_x4 = _mm_set1_epi32(kScale);
+  const __m128i neg_scale_x4 = _mm_set1_epi32(-kScale);
+  for (int i = 0; i < quantize_postamble_start; i += kInt8WeightsPerSseLane) {
+    __m128i quantized[4];
+    for (int j = 0; j < 4; ++j) {
+      const __m128 value_x4 =
+          _mm_loadu_ps(values + i + j * kFloatWeightsPerSseLane);
+      quantized[j] =
+          RoundToInt32(_mm_mul_ps(value_x4, scaling_factor_inv_x4));
+      // Clamp: just in case some odd numeric offset.
+      quantized[j] =
+          _mm_min_epi32(scale_x4, _mm_max_epi32(neg_scale_x4, quantized[j]));
+    }
+    const __m128i packed =
+        _mm_packs_epi16(_mm_packs_epi32(quantized[0], quantized[1]),
+                        _mm_packs_epi32(quantized[2], quantized[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(quantized_values + i), packed);
+  }
+  for (int i = quantize_postamble_start; i < size; ++i) {
+    const int32_t quantized_value =
+        static_cast<int32_t>(TfLiteRound(values[i] * scaling_factor_inv));
+    quantized_values[i] = std::min(kScale, std::max(-kScale, quantized_value));
+  }
+}
+
+}  // namespace tensor_utils
+}  // namespace tflite
+
+#endif  // USE_SSE_TENSOR_UTILS
@@ -29,6 +29,14 @@ limitations under the License.
 #endif  //  defined(__ARM_NEON__) || defined(__ARM_NEON)
 #endif  //  USE_NEON
 
+// On x86, the SSE4.1 and AVX2 kernels are used instead of the NEON ones, which
+// common.h otherwise enables through NEON_2_SSE when building for SSE4.1.
+#ifndef USE_SSE_TENSOR_UTILS
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define USE_SSE_TENSOR_UTILS
+#endif  // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#endif  // USE_SSE_TENSOR_UTILS
+
 namespace tflite {
 namespace tensor_utils {
 
@@ -43,6 +51,23 @@ void NeonMatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
                                              int m_cols, const float* vector,
                                              int n_batch, float* result,
                                              int result_stride);
+void SseMatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
+                                            int m_cols, const float* vector,
+                                            int n_batch, float* result,
+                                            int result_stride);
+
+// Multiply a block sparse matrix by a batch vector, and store results in a
+// batch-size vector.
+void PortableSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride);
+void NeonSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride);
 
 // Matrix multiplication for quantized values using symmetric quantization.
 void PortableMatrixBatchVectorMultiplyAccumulate(
@@ -53,6 +78,10 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
     const int8_t* __restrict__ vectors, const float* scaling_factors,
     int n_batch, float* __restrict__ result, int result_stride);
+void SseMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
+    const int8_t* __restrict__ vectors, const float* scaling_factors,
+    int n_batch, float* __restrict__ result, int result_stride);
 
 // Cwise product of two vectors.
 void PortableVectorVectorCwiseProduct(const float* vector1,
@@ -60,6 +89,8 @@ void PortableVectorVectorCwiseProduct(const float* vector1,
                                       float* result);
 void NeonVectorVectorCwiseProduct(const float* vector1, const float* vector2,
                                   int v_size, float* result);
+void SseVectorVectorCwiseProduct(const float* vector1, const float* vector2,
+                                 int v_size, float* result);
 
 // Cwise product and accumulate of two vectors. Since it's a MAC operation, the
 // assumption here is that result array is initialized to valid values.
@@ -69,12 +100,17 @@ void PortableVectorVectorCwiseProductAccumulate(const float* vector1,
 void NeonVectorVectorCwiseProductAccumulate(const float* vector1,
                                             const float* vector2, int v_size,
                                             float* result);
+void SseVectorVectorCwiseProductAccumulate(const float* vector1,
+                                           const float* vector2, int v_size,
+                                           float* result);
 
 // Dot product of two vectors.
 float PortableVectorVectorDotProduct(const float* vector1, const float* vector2,
                                      int v_size);
 float NeonVectorVectorDotProduct(const float* vector1, const float* vector2,
                                  int v_size);
+float SseVectorVectorDotProduct(const float* vector1, const float* vector2,
+                                int v_size);
 
 // Dot product of two batch vectors.
 void PortableBatchVectorBatchVectorDotProduct(const float* vector1,
@@ -85,6 +121,10 @@ void NeonBatchVectorBatchVectorDotProduct(const float* vector1,
                                           const float* vector2, int v_size,
                                           int n_batch, float* result,
                                           int result_stride);
+void SseBatchVectorBatchVectorDotProduct(const float* vector1,
+                                         const float* vector2, int v_size,
+                                         int n_batch, float* result,
+                                         int result_stride);
 
 // Cwise product and accumulate of a vector and a batch-vector. Since it's a MAC
 // operation, the assumption here is that result array is initialized to valid
@@ -98,16 +138,23 @@ void NeonVectorBatchVectorCwiseProductAccumulate(const float* vector,
                                                  int v_size,
                                                  const float* batch_vector,
                                                  int n_batch, float* result);
+void SseVectorBatchVectorCwiseProductAccumulate(const float* vector,
+                                                int v_size,
+                                                const float* batch_vector,
+                                                int n_batch, float* result);
 
 // Compute "1.0f - elements of vector" (used in CIFG).
 void PortableSub1Vector(const float* vector, int v_size, float* result);
 void NeonSub1Vector(const float* vector, int v_size, float* result);
+void SseSub1Vector(const float* vector, int v_size, float* result);
 
 // Clip elements of a vector using a abs_limit value.
 void PortableClipVector(const float* vector, int v_size, float abs_limit,
                         float* result);
 void NeonClipVector(const float* vector, int v_size, float abs_limit,
                     float* result);
+void SseClipVector(const float* vector, int v_size, float abs_limit,
+                   float* result);
 
 // Batch vector initialization with another vector.
 void PortableVectorBatchVectorAssign(const float* vector, int v_size,
@@ -133,6 +180,8 @@ void PortableVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                                   float* result);
 void NeonVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                               float* result);
+void SseVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
+                             float* result);
 
 // Limit a float input f between +abs_limit and -abs_limit.
 float PortableClip(float f, float abs_limit);
@@ -140,6 +189,7 @@ float PortableClip(float f, float abs_limit);
 // Check if all entries of a vector are zero.
 bool PortableIsZeroVector(const float* vector, int v_size);
 bool NeonIsZeroVector(const float* vector, int v_size);
+bool SseIsZeroVector(const float* vector, int v_size);
 
 // Symmetric quantizer.
 void PortableSymmetricQuantizeFloats(const float* values, const int size,
@@ -148,6 +198,9 @@ void PortableSymmetricQuantizeFloats(const float* values, const int size,
 void NeonSymmetricQuantizeFloats(const float* values, const int size,
                                  int8_t* quantized_values, float* min,
                                  float* max, float* scaling_factor);
+void SseSymmetricQuantizeFloats(const float* values, const int size,
+                                int8_t* quantized_values, float* min,
+                                float* max, float* scaling_factor);
 
 // Shift left a vector in place with v_size size.
 void PortableVectorShiftLeft(float* vector, int v_size, float shift_value);
@@ -80,6 +80,30 @@ void PortableMatrixBatchVectorMultiplyAccumulate(const float* matrix,
   }
 }
 
+void PortableSparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride) {
+  float* result_in_batch = result;
+  for (int b = 0; b < n_batch; b++) {
+    const float* vector_in_batch = vector + b * m_cols;
+    for (int r = 0; r < m_rows; r++) {
+      float dot_prod = 0.0f;
+      for (int i = row_segments[r]; i < row_segments[r + 1]; i++) {
+        const float* block = matrix + i * block_size;
+        const float* vector_block =
+            vector_in_batch + block_indices[i] * block_size;
+        for (int c = 0; c < block_size; c++) {
+          dot_prod += block[c] * vector_block[c];
+        }
+      }
+      *result_in_batch += dot_prod;
+      result_in_batch += result_stride;
+    }
+  }
+}
+
 void PortableMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const int m_rows, const int m_cols,
     const int8_t* __restrict__ vectors,
@@ -55,6 +55,19 @@ void MatrixBatchVectorMultiplyAccumulate(const float* matrix, int m_rows,
                                          int n_batch, float* result,
                                          int result_stride);
 
+// Same as the function above, but for a sparse matrix stored in block
+// compressed sparse row format, see TfLiteSparsity: `matrix` holds the blocks
+// of `block_size` values with a nonzero value, the blocks of row r are those
+// from index row_segments[r] up to row_segments[r + 1], and block_indices
+// holds the column of each block divided by `block_size`. m_cols must be a
+// multiple of block_size. Blocks of 4 values, the number of floats in a SIMD
+// register, or a multiple of that are the fastest.
+void SparseMatrixBatchVectorMultiplyAccumulate(
+    const float* __restrict__ matrix, const int* row_segments,
+    const int* block_indices, int block_size, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result,
+    int result_stride);
+
 // Same as the function above, but for values quantized using symmetric
 // quantization (e.g. by calling SymmetricQuantizeFloats).
 // The passed scaling factors is a buffer of the quantization scaling factors
@@ -143,6 +143,41 @@ TEST(uKernels, MatrixBatchVectorMultiplyAccumulateTest) {
                                                -1., 3., 7., 3., 23., 3.})));
 }
 
+TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
+  constexpr int kRow = 3;
+  constexpr int kCol = 8;
+  constexpr int kBatch = 2;
+  constexpr int kBlockSize = 4;
+  // Dense equivalent:
+  //   {1.0, 2.0,  3.0, 4.0,  0.0, 0.0,  0.0, 0.0,
+  //    0.0, 0.0,  0.0, 0.0,  0.0, 0.0,  0.0, 0.0,
+  //    0.0, 0.0,  0.0, 0.0,  1.0, -2.0, 3.0, -4.0}
+  static float matrix[] = {1.0, 2.0, 3.0, 4.0,  //
+                           1.0, -2.0, 3.0, -4.0};
+  static int row_segments[kRow + 1] = {0, 1, 1, 2};
+  static int block_indices[] = {0, 1};
+  static float vector[kCol * kBatch] = {1.0, -1.0, 1.0, -1.0,
+                                        2.0, -2.0, 2.0, -2.0,  //
+                                        2.0, -2.0, 2.0, -2.0,
+                                        1.0, -1.0, 1.0, -1.0};
+  std::vector<float> output(kRow * kBatch);
+  std::fill(output.begin(), output.end(), 3.0);
+  SparseMatrixBatchVectorMultiplyAccumulate(
+      matrix, row_segments, block_indices, kBlockSize, kRow, kCol, vector,
+      kBatch, output.data(), /*result_stride=*/1);
+  EXPECT_THAT(output, ElementsAreArray(ArrayFloatNear({1., 3., 23.,  //
+                                                       -1., 3., 13.})));
+
+  std::vector<float> output_with_stride2(kRow * kBatch * 2);
+  std::fill(output_with_stride2.begin(), output_with_stride2.end(), 3.0);
+  SparseMatrixBatchVectorMultiplyAccumulate(
+      matrix, row_segments, block_indices, kBlockSize, kRow, kCol, vector,
+      kBatch, output_with_stride2.data(), /*result_stride=*/2);
+  EXPECT_THAT(output_with_stride2,
+              ElementsAreArray(ArrayFloatNear({1., 3., 3., 3., 23., 3.,  //
+                                               -1., 3., 3., 3., 13., 3.})));
+}
+
 TEST(uKernels, MatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
   // Note we use 29 columns as this exercises all the neon kernel: the
   // 16-block SIMD code, the 8-block postamble, and the leftover postamble.
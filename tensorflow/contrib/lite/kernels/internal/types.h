@@ -89,6 +89,11 @@ enum class FullyConnectedWeightsFormat : uint8 {
   //   tensorflow/contrib/lite/toco/graph_transformations/ensure_uint8_weights_safe_for_fast_int8_kernels.cc
   //
   kShuffled4x16Int8,
+  // Float weights of which only the non-zero blocks of consecutive values
+  // along input_depth are stored, see SparsityParameters in the TF Lite
+  // schema. Pruned models spare both the memory and the multiplications of
+  // the zero blocks.
+  kBlockSparse,
 };
 
 // Quantization parameters, determining the mapping of quantized values
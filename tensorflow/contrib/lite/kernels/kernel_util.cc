@@ -43,6 +43,32 @@ TfLiteStatus GetQuantizedConvolutionMultipler(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus GetPerChannelConvolutionMultipliers(
+    TfLiteContext* context, const TfLiteTensor* input,
+    const TfLiteTensor* filter, const TfLiteTensor* output,
+    int channel_dimension, std::vector<double>* multipliers) {
+  const TfLiteAffineQuantization* quantization = filter->quantization;
+  TF_LITE_ENSURE(context, quantization != nullptr);
+  TF_LITE_ENSURE_EQ(context, quantization->quantized_dimension,
+                    channel_dimension);
+  const int num_channels = filter->dims->data[channel_dimension];
+  TF_LITE_ENSURE_EQ(context, quantization->scale->size, num_channels);
+  TF_LITE_ENSURE_EQ(context, quantization->zero_point->size, num_channels);
+  TF_LITE_ENSURE(context, output->params.scale > 0);
+
+  multipliers->resize(num_channels);
+  for (int i = 0; i < num_channels; ++i) {
+    // The filter is symmetric, so its values need no offset.
+    TF_LITE_ENSURE_EQ(context, quantization->zero_point->data[i], 0);
+    const double input_product_scale =
+        input->params.scale * quantization->scale->data[i];
+    TF_LITE_ENSURE(context, input_product_scale >= 0);
+    (*multipliers)[i] = input_product_scale / output->params.scale;
+  }
+
+  return kTfLiteOk;
+}
+
 namespace {
 void CalculateActivationRangeQuantizedImpl(TfLiteFusedActivation activation,
                                            int32_t qmin, int32_t qmax,
@@ -81,6 +107,9 @@ TfLiteStatus CalculateActivationRangeQuantized(TfLiteContext* context,
   if (output->type == kTfLiteUInt8) {
     qmin = std::numeric_limits<uint8_t>::min();
     qmax = std::numeric_limits<uint8_t>::max();
+  } else if (output->type == kTfLiteInt8) {
+    qmin = std::numeric_limits<int8_t>::min();
+    qmax = std::numeric_limits<int8_t>::max();
   } else if (output->type == kTfLiteInt16) {
     qmin = std::numeric_limits<int16_t>::min();
     qmax = std::numeric_limits<int16_t>::max();
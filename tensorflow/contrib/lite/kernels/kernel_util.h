@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CONTRIB_LITE_KERNELS_KERNEL_UTIL_H_
 
 #include <algorithm>
+#include <vector>
 
 #include "tensorflow/contrib/lite/builtin_op_data.h"
 #include "tensorflow/contrib/lite/context.h"
@@ -88,6 +89,16 @@ TfLiteStatus GetQuantizedConvolutionMultipler(TfLiteContext* context,
                                               TfLiteTensor* output,
                                               double* multiplier);
 
+// Calculates one multiplication factor per output channel for a quantized
+// convolution (or depthwise convolution) whose filter is symmetrically
+// quantized per channel, see TfLiteAffineQuantization. Returns an error if
+// the filter isn't quantized that way along 'channel_dimension', or if the
+// tensors don't have the int8 quantization parameters it expects.
+TfLiteStatus GetPerChannelConvolutionMultipliers(
+    TfLiteContext* context, const TfLiteTensor* input,
+    const TfLiteTensor* filter, const TfLiteTensor* output,
+    int channel_dimension, std::vector<double>* multipliers);
+
 // Calculates the useful quantized range of an activation layer given its
 // activation tensor.
 TfLiteStatus CalculateActivationRangeQuantized(TfLiteContext* context,
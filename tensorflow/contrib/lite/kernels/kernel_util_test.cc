@@ -30,6 +30,10 @@ class KernelUtilTest : public ::testing::Test {
 
     tensor1_.dims = nullptr;
     tensor2_.dims = nullptr;
+    tensor1_.quantization = nullptr;
+    tensor2_.quantization = nullptr;
+    tensor1_.sparsity = nullptr;
+    tensor2_.sparsity = nullptr;
     tensor1_.allocation_type = kTfLiteMmapRo;
     tensor2_.allocation_type = kTfLiteMmapRo;
   }
@@ -0,0 +1,116 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/kernels/quantized_gemm.h"
+
+#include <algorithm>
+
+#include "tensorflow/contrib/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace quantized_gemm {
+namespace {
+
+// Above this many input vectors, the cost of gemmlowp packing the weights on
+// every call is amortized, and its multithreaded GEMM kernels win.
+constexpr int kMaxPackedGemvBatches = 4;
+
+// The dot product of 'size' int8 weights and uint8 inputs, which compilers
+// turn into 8 bit multiply-accumulate instructions.
+inline int32_t DotProduct(const int8_t* weights, const uint8_t* input,
+                          int size) {
+  int32_t sum = 0;
+  for (int i = 0; i < size; ++i) {
+    sum += static_cast<int16_t>(weights[i]) * static_cast<int16_t>(input[i]);
+  }
+  return sum;
+}
+
+}  // namespace
+
+Backend ChooseBackend(int rows, int cols, int batches, bool weights_cached) {
+  if (!weights_cached || batches > kMaxPackedGemvBatches) {
+    return Backend::kGemmlowp;
+  }
+#ifdef USE_NEON
+  // optimized_ops has a NEON GEMV for single input vectors, which handles
+  // the zero points in its inner loop about as fast as PackedGemv() does.
+  if (batches == 1 && rows % 4 == 0) {
+    return Backend::kGemmlowp;
+  }
+#endif  // USE_NEON
+  return Backend::kPackedGemv;
+}
+
+void PackWeights(const uint8_t* weights, int rows, int cols,
+                 PackedWeights* packed) {
+  packed->rows = rows;
+  packed->cols = cols;
+  packed->data.resize(rows * cols);
+  packed->row_sums.resize(rows);
+  for (int r = 0; r < rows; ++r) {
+    int32_t row_sum = 0;
+    for (int c = 0; c < cols; ++c) {
+      const int8_t value = static_cast<int8_t>(weights[r * cols + c] - 128);
+      packed->data[r * cols + c] = value;
+      row_sum += value;
+    }
+    packed->row_sums[r] = row_sum;
+  }
+}
+
+void PackedGemv(const PackedWeights& weights, int32_t weights_offset,
+                const uint8_t* input, int32_t input_offset, int batches,
+                const int32_t* bias, int32_t output_offset,
+                int32_t output_multiplier, int output_shift,
+                int32_t output_activation_min, int32_t output_activation_max,
+                uint8_t* output) {
+  const int rows = weights.rows;
+  const int cols = weights.cols;
+  // With w the packed int8 weights and x the uint8 inputs, the accumulator of
+  // the reference kernel is
+  //   sum((w + weights_shift) * (x + input_offset))
+  //   = sum(w * x) + input_offset * sum(w) + weights_shift * sum(x)
+  //     + cols * weights_shift * input_offset
+  // where sum(w) was computed when packing the weights.
+  const int32_t weights_shift = weights_offset + 128;
+  for (int b = 0; b < batches; ++b) {
+    const uint8_t* batch_input = input + b * cols;
+    int32_t input_sum = 0;
+    for (int c = 0; c < cols; ++c) {
+      input_sum += batch_input[c];
+    }
+    const int64_t batch_term =
+        static_cast<int64_t>(weights_shift) * input_sum +
+        static_cast<int64_t>(cols) * weights_shift * input_offset;
+    for (int r = 0; r < rows; ++r) {
+      int32_t acc = static_cast<int32_t>(
+          DotProduct(weights.data.data() + r * cols, batch_input, cols) +
+          static_cast<int64_t>(input_offset) * weights.row_sums[r] +
+          batch_term);
+      if (bias) {
+        acc += bias[r];
+      }
+      acc = MultiplyByQuantizedMultiplierSmallerThanOneExp(
+          acc, output_multiplier, -output_shift);
+      acc += output_offset;
+      acc = std::max(acc, output_activation_min);
+      acc = std::min(acc, output_activation_max);
+      output[b * rows + r] = static_cast<uint8_t>(acc);
+    }
+  }
+}
+
+}  // namespace quantized_gemm
+}  // namespace tflite
@@ -0,0 +1,70 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_KERNELS_QUANTIZED_GEMM_H_
+#define TENSORFLOW_CONTRIB_LITE_KERNELS_QUANTIZED_GEMM_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace tflite {
+namespace quantized_gemm {
+
+// The implementations of the uint8 matrix multiplications of quantized ops,
+// which multiply a batch of input vectors by a weights matrix.
+enum class Backend {
+  // optimized_ops, i.e. gemmlowp, which packs both the weights and the inputs
+  // on every call and may use several threads, or a NEON GEMV for single
+  // input vectors.
+  kGemmlowp,
+  // PackedGemv(), on weights packed once by PackWeights().
+  kPackedGemv,
+};
+
+// Chooses the backend to multiply 'batches' input vectors of size 'cols' by a
+// 'rows' x 'cols' weights matrix, on this CPU. 'weights_cached' tells whether
+// the weights are constant and may be packed once for all invokes, without
+// which repacking them on every call makes kPackedGemv pointless.
+Backend ChooseBackend(int rows, int cols, int batches, bool weights_cached);
+
+// uint8 weights with a zero point, in the layout PackedGemv() reads.
+struct PackedWeights {
+  int rows = 0;
+  int cols = 0;
+  // The row major weights minus 128, as int8, so that their products with the
+  // uint8 inputs fit the 8 bit multiply-accumulate instructions.
+  std::vector<int8_t> data;
+  // The sum of each row of 'data', to account for the input zero point.
+  std::vector<int32_t> row_sums;
+};
+
+// Packs the row major 'rows' x 'cols' matrix 'weights'.
+void PackWeights(const uint8_t* weights, int rows, int cols,
+                 PackedWeights* packed);
+
+// Computes the uint8 outputs of a quantized FullyConnected op, exactly like
+// reference_ops::FullyConnected() does. The offsets are the negated zero
+// points of the weights and inputs, and 'output_shift' shifts to the right.
+// 'bias' may be null.
+void PackedGemv(const PackedWeights& weights, int32_t weights_offset,
+                const uint8_t* input, int32_t input_offset, int batches,
+                const int32_t* bias, int32_t output_offset,
+                int32_t output_multiplier, int output_shift,
+                int32_t output_activation_min, int32_t output_activation_max,
+                uint8_t* output);
+
+}  // namespace quantized_gemm
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_KERNELS_QUANTIZED_GEMM_H_
@@ -0,0 +1,110 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/kernels/quantized_gemm.h"
+
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/kernels/internal/reference/reference_ops.h"
+#include "tensorflow/contrib/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace quantized_gemm {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+Dims<4> MakeDims(int d0, int d1) {
+  Dims<4> dims;
+  dims.sizes[0] = d0;
+  dims.sizes[1] = d1;
+  dims.sizes[2] = 1;
+  dims.sizes[3] = 1;
+  dims.strides[0] = 1;
+  dims.strides[1] = d0;
+  dims.strides[2] = d0 * d1;
+  dims.strides[3] = d0 * d1;
+  return dims;
+}
+
+void TestPackedGemv(int rows, int cols, int batches, bool with_bias) {
+  std::mt19937 random_engine(rows * cols * batches);
+  std::uniform_int_distribution<int> uint8_distribution(0, 255);
+  std::uniform_int_distribution<int> bias_distribution(-5000, 5000);
+  std::vector<uint8_t> weights(rows * cols);
+  for (uint8_t& value : weights) value = uint8_distribution(random_engine);
+  std::vector<uint8_t> input(cols * batches);
+  for (uint8_t& value : input) value = uint8_distribution(random_engine);
+  std::vector<int32_t> bias(rows);
+  for (int32_t& value : bias) value = bias_distribution(random_engine);
+  const int32_t* bias_data = with_bias ? bias.data() : nullptr;
+
+  const int32_t weights_offset = -140;
+  const int32_t input_offset = -100;
+  const int32_t output_offset = 120;
+  const int32_t output_multiplier = 1 << 30;
+  const int output_shift = 8;
+  const int32_t output_activation_min = 10;
+  const int32_t output_activation_max = 250;
+
+  std::vector<uint8_t> expected(rows * batches);
+  reference_ops::FullyConnected(
+      input.data(), MakeDims(cols, batches), input_offset, weights.data(),
+      MakeDims(cols, rows), weights_offset, bias_data, MakeDims(rows, 1),
+      output_offset, output_multiplier, output_shift, output_activation_min,
+      output_activation_max, expected.data(), MakeDims(rows, batches),
+      /*gemm_context=*/nullptr);
+
+  PackedWeights packed;
+  PackWeights(weights.data(), rows, cols, &packed);
+  std::vector<uint8_t> output(rows * batches);
+  PackedGemv(packed, weights_offset, input.data(), input_offset, batches,
+             bias_data, output_offset, output_multiplier, output_shift,
+             output_activation_min, output_activation_max, output.data());
+  EXPECT_THAT(output, ElementsAreArray(expected));
+}
+
+TEST(QuantizedGemmTest, PackedGemvMatchesReference) {
+  TestPackedGemv(/*rows=*/1, /*cols=*/1, /*batches=*/1, /*with_bias=*/true);
+  TestPackedGemv(/*rows=*/7, /*cols=*/33, /*batches=*/1, /*with_bias=*/true);
+  TestPackedGemv(/*rows=*/16, /*cols=*/64, /*batches=*/3, /*with_bias=*/true);
+  TestPackedGemv(/*rows=*/10, /*cols=*/300, /*batches=*/4,
+                 /*with_bias=*/false);
+}
+
+TEST(QuantizedGemmTest, ChooseBackend) {
+  EXPECT_EQ(ChooseBackend(/*rows=*/7, /*cols=*/64, /*batches=*/2,
+                          /*weights_cached=*/true),
+            Backend::kPackedGemv);
+  // Weights that aren't cached would be packed on every call.
+  EXPECT_EQ(ChooseBackend(/*rows=*/7, /*cols=*/64, /*batches=*/2,
+                          /*weights_cached=*/false),
+            Backend::kGemmlowp);
+  // Large batches amortize the packing of gemmlowp.
+  EXPECT_EQ(ChooseBackend(/*rows=*/7, /*cols=*/64, /*batches=*/64,
+                          /*weights_cached=*/true),
+            Backend::kGemmlowp);
+}
+
+}  // namespace
+}  // namespace quantized_gemm
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -39,6 +39,9 @@ namespace {
 
 struct OpData {
   int scratch_tensor_index;
+  // Whether the dequantized weights_time are kept across invocations, rather
+  // than dequantized at each one.
+  bool cache_float_weights_time;
   bool float_weights_time_initialized;
 };
 
@@ -225,8 +228,15 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     node->temporaries->data[3] = scratch_tensor_index + 3;
     TfLiteTensor* float_weights_time = GetTemporary(context, node, /*index=*/3);
     float_weights_time->type = kTfLiteFloat32;
-    // Persistent so that we can compute the dequantized weights only once.
-    float_weights_time->allocation_type = kTfLiteArenaRwPersistent;
+    // Persistent so that we can compute the dequantized weights only once,
+    // unless they may change between invocations or caching is disabled.
+    op_data->cache_float_weights_time =
+        context->cache_transformed_weights && IsConstantTensor(weights_time);
+    float_weights_time->allocation_type = op_data->cache_float_weights_time
+                                              ? kTfLiteArenaRwPersistent
+                                              : kTfLiteArenaRw;
+    // Tensors planned again may not keep their contents.
+    op_data->float_weights_time_initialized = false;
     if (!TfLiteIntArrayEqual(float_weights_time->dims, weights_time->dims)) {
       TfLiteIntArray* float_weights_time_size =
           TfLiteIntArrayCopy(weights_time->dims);
@@ -380,7 +390,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       // or Prepare. However, TFLite doesn't allocate float_weights_time until
       // the Eval function.
       // TODO(alanchiao): refactor logic out into dequantize function.
-      if (!op_data->float_weights_time_initialized) {
+      if (!op_data->cache_float_weights_time ||
+          !op_data->float_weights_time_initialized) {
         const float dequantization_scale = weights_time->params.scale;
         const int8_t* weights_time_ptr =
             reinterpret_cast<int8_t*>(weights_time->data.uint8);
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/kernels/test_util.h"
 
+#include "tensorflow/contrib/lite/util.h"
 #include "tensorflow/contrib/lite/version.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -38,6 +39,40 @@ int SingleOpModel::AddInput(const TensorData& t, bool is_variable) {
   return id;
 }
 
+int SingleOpModel::AddBlockSparseConstInput(const std::vector<float>& data,
+                                            std::initializer_list<int> shape,
+                                            int block_size) {
+  int id = tensors_.size();
+  const int rows = *shape.begin();
+  const int cols = data.size() / rows;
+  std::vector<int> row_segments;
+  std::vector<int> block_indices;
+  std::vector<float> values;
+  BlockSparseEncode(data.data(), rows, cols, block_size, &row_segments,
+                    &block_indices, &values);
+
+  if (buffers_.empty()) {
+    buffers_.push_back(CreateBuffer(builder_, builder_.CreateVector({})));
+  }
+  int buffer_id = buffers_.size();
+  auto data_buffer =
+      builder_.CreateVector(reinterpret_cast<const uint8_t*>(values.data()),
+                            sizeof(float) * values.size());
+  buffers_.push_back(CreateBuffer(builder_, data_buffer));
+
+  auto sparsity = CreateSparsityParameters(
+      builder_, block_size, builder_.CreateVector<int>(row_segments),
+      builder_.CreateVector<int>(block_indices));
+  TensorData t{TensorType_FLOAT32, shape};
+  tensors_.push_back(CreateTensor(
+      builder_, builder_.CreateVector<int>(t.shape), t.type,
+      /*buffer=*/buffer_id, /*name=*/0, /*quantization=*/0,
+      /*is_variable=*/false, sparsity));
+  tensor_data_[id] = t;
+  inputs_.push_back(id);
+  return id;
+}
+
 int SingleOpModel::AddNullInput() {
   int id = kOptionalTensor;
   inputs_.push_back(id);
@@ -84,6 +84,11 @@ struct TensorData {
   float max;
   float scale;
   int32_t zero_point;
+  // If not empty, the tensor is symmetrically quantized with one scale per
+  // slice along 'quantized_dimension', and 'scale' and 'zero_point' are
+  // ignored.
+  std::vector<float> per_channel_scales;
+  int quantized_dimension;
 };
 
 class SingleOpResolver : public OpResolver {
@@ -140,6 +145,12 @@ class SingleOpModel {
     return id;
   }
 
+  // Add a constant float input tensor whose values are stored in the block
+  // sparse format, and return its index. `data` holds the dense values.
+  int AddBlockSparseConstInput(const std::vector<float>& data,
+                               std::initializer_list<int> shape,
+                               int block_size);
+
   // Add a null input tensor (optional input) and return kOptionalTensor.
   int AddNullInput();
 
@@ -168,6 +179,46 @@ class SingleOpModel {
                    reinterpret_cast<uint8_t*>(q.data() + q.size()));
   }
 
+  // Quantizes each slice of 'data' along the quantized dimension of the
+  // tensor with the scale of that slice, see TensorData::per_channel_scales.
+  void PerChannelSymmetricQuantizeAndPopulate(int index,
+                                              const std::vector<float>& data) {
+    TfLiteTensor* t = interpreter_->tensor(index);
+    const TfLiteAffineQuantization* quantization = t->quantization;
+    CHECK(quantization) << "Tensor '" << index << "' isn't per-channel.";
+    int inner_size = 1;
+    for (int i = quantization->quantized_dimension + 1; i < t->dims->size;
+         ++i) {
+      inner_size *= t->dims->data[i];
+    }
+    const int num_channels = quantization->scale->size;
+    std::vector<int8_t> q;
+    for (int i = 0; i < data.size(); ++i) {
+      const int channel = (i / inner_size) % num_channels;
+      const float scale = quantization->scale->data[channel];
+      q.push_back(Quantize<int8_t>({data[i]}, scale, /*zero_point=*/0)[0]);
+    }
+    PopulateTensor(index, /*offset=*/0, q.data(), q.data() + q.size());
+  }
+
+  // Quantizes the bias of a per-channel convolution: each value gets the scale
+  // of the products it is added to.
+  void PerChannelQuantizeBias(int index, int input_index, int filter_index,
+                              const std::vector<float>& data) {
+    const float input_scale = interpreter_->tensor(input_index)->params.scale;
+    const TfLiteAffineQuantization* quantization =
+        interpreter_->tensor(filter_index)->quantization;
+    CHECK(quantization) << "Tensor '" << filter_index << "' isn't per-channel.";
+    CHECK_EQ(data.size(), static_cast<size_t>(quantization->scale->size));
+    std::vector<int32_t> q;
+    for (int i = 0; i < data.size(); ++i) {
+      q.push_back(Quantize<int32_t>(
+          {data[i]}, input_scale * quantization->scale->data[i],
+          /*zero_point=*/0)[0]);
+    }
+    PopulateTensor(index, /*offset=*/0, q.data(), q.data() + q.size());
+  }
+
   const std::vector<int>& GetShape(int id) { return tensor_data_.at(id).shape; }
 
   float GetScale(int id) { return tensor_data_.at(id).scale; }
@@ -284,11 +335,21 @@ class SingleOpModel {
 
     flatbuffers::Offset<QuantizationParameters> q_params = 0;
 
-    if (is_quantized) {
+    if (!t.per_channel_scales.empty()) {
+      q_params = CreateQuantizationParameters(
+          builder_, /*min=*/0, /*max=*/0,
+          builder_.CreateVector<float>(t.per_channel_scales),
+          builder_.CreateVector<int64_t>(
+              std::vector<int64_t>(t.per_channel_scales.size(), 0)),
+          t.quantized_dimension);
+    } else if (is_quantized) {
       if (t.min != 0 || t.max != 0) {
         if (t.type == TensorType_UINT8) {
           std::tie(t.scale, t.zero_point) =
               QuantizationParams<uint8_t>(t.min, t.max);
+        } else if (t.type == TensorType_INT8) {
+          std::tie(t.scale, t.zero_point) =
+              QuantizationParams<int8_t>(t.min, t.max);
         } else if (t.type == TensorType_INT32) {
           std::tie(t.scale, t.zero_point) =
               QuantizationParams<int32_t>(t.min, t.max);
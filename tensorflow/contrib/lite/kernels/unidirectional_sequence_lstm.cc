@@ -13,17 +13,21 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <initializer_list>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include "tensorflow/contrib/lite/builtin_op_data.h"
 #include "tensorflow/contrib/lite/context.h"
 #include "tensorflow/contrib/lite/kernels/activation_functor.h"
-#include "tensorflow/contrib/lite/kernels/internal/kernel_utils.h"
+#include "tensorflow/contrib/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/contrib/lite/kernels/internal/tensor.h"
 #include "tensorflow/contrib/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/contrib/lite/kernels/kernel_util.h"
 #include "tensorflow/contrib/lite/kernels/op_macros.h"
@@ -81,14 +85,40 @@ enum TemporaryTensor {
   kNumTemporaryTensors = 7
 };
 
+// The input projections of this many time steps are computed at once.
+constexpr int kMaxTimeStepsPerBlock = 16;
+
+struct OpData {
+  // Index of the first temporary tensor.
+  int scratch_tensor_index;
+
+  // The weights of all the gates stacked in the order input (unless CIFG),
+  // forget, cell and output, e.g. [4 * n_cell, n_input] for the input
+  // weights, so that each time step streams all the recurrent weights in a
+  // single matrix product. They are packed by the first Eval() after
+  // Prepare() if constant, and by every Eval() otherwise.
+  bool weights_packed;
+  std::vector<float> input_weights;
+  std::vector<float> recurrent_weights;
+  std::vector<int8_t> quantized_input_weights;
+  std::vector<int8_t> quantized_recurrent_weights;
+  // The scale of the quantized weights of each gate.
+  std::vector<float> input_weights_scales;
+  std::vector<float> recurrent_weights_scales;
+  // The biases of the gates, in the same order.
+  std::vector<float> bias;
+};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
-  auto* scratch_tensor_index = new int;
-  context->AddTensors(context, kNumTemporaryTensors, scratch_tensor_index);
-  return scratch_tensor_index;
+  auto* op_data = new OpData;
+  op_data->weights_packed = false;
+  context->AddTensors(context, kNumTemporaryTensors,
+                      &op_data->scratch_tensor_index);
+  return op_data;
 }
 
 void Free(TfLiteContext* context, void* buffer) {
-  delete reinterpret_cast<int*>(buffer);
+  delete reinterpret_cast<OpData*>(buffer);
 }
 
 // Check that input tensor dimensions matches with each other.
@@ -244,7 +274,9 @@ TfLiteStatus CheckInputTensorDimensions(TfLiteContext* context,
 // Allocate a temprory scratch tensor. Also check that the sizes of the input
 // tensors match each other.
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
-  int* scratch_tensor_index = reinterpret_cast<int*>(node->user_data);
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const int* scratch_tensor_index = &op_data->scratch_tensor_index;
+  op_data->weights_packed = false;
 
   // Check we have all the inputs and outputs we need.
   TF_LITE_ENSURE_EQ(context, node->inputs->size, 18);
@@ -326,15 +358,15 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* input_to_input_weights =
       GetOptionalInputTensor(context, node, kInputToInputWeightsTensor);
   const bool use_cifg = (input_to_input_weights == nullptr);
+  // Reserving space for the Input (unless CIFG), Forget, Cell and Output
+  // gates of a block of time steps, for the recurrent part of the gates of
+  // one step, and for the gated cell state of one step.
+  const int n_gates = use_cifg ? 3 : 4;
+  const int time_steps_per_block = std::min(max_time, kMaxTimeStepsPerBlock);
   TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
   scratch_buffer_size->data[0] = n_batch;
-  if (use_cifg) {
-    // Reserving space for Cell, Forget, Output gates
-    scratch_buffer_size->data[1] = n_cell * 3;
-  } else {
-    // Reserving space for Input, Cell, Forget, Output gates
-    scratch_buffer_size->data[1] = n_cell * 4;
-  }
+  scratch_buffer_size->data[1] =
+      (time_steps_per_block + 1) * n_gates * n_cell + n_cell;
   TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scratch_buffer,
                                                    scratch_buffer_size));
 
@@ -392,7 +424,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     scaling_factors->type = kTfLiteFloat32;
     scaling_factors->allocation_type = kTfLiteArenaRw;
     TfLiteIntArray* scaling_factors_size = TfLiteIntArrayCreate(1);
-    scaling_factors_size->data[0] = n_batch;
+    scaling_factors_size->data[0] = time_steps_per_block * n_batch;
     if (!TfLiteIntArrayEqual(scaling_factors->dims, scaling_factors_size)) {
       TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, scaling_factors,
                                                        scaling_factors_size));
@@ -413,7 +445,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
 
     // Allocate a temporary tensor to store the recovered cell weights. Since
-    // this is used for diagonal matrices, only need to store n_cell values.
+    // these are diagonal matrices, only need to store n_cell values for each
+    // of the three gates.
     node->temporaries->data[kRecoveredCellWeights] =
         *scratch_tensor_index + kRecoveredCellWeights;
     TfLiteTensor* recovered_cell_weights =
@@ -421,7 +454,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     recovered_cell_weights->type = kTfLiteFloat32;
     recovered_cell_weights->allocation_type = kTfLiteArenaRw;
     TfLiteIntArray* recovered_cell_weights_size = TfLiteIntArrayCreate(1);
-    recovered_cell_weights_size->data[0] = n_cell;
+    recovered_cell_weights_size->data[0] = 3 * n_cell;
     if (!TfLiteIntArrayEqual(recovered_cell_weights->dims,
                              recovered_cell_weights_size)) {
       TF_LITE_ENSURE_OK(context,
@@ -432,228 +465,222 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
-// The LSTM Op engine.
-TfLiteStatus EvalFloat(
-    const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
-    const TfLiteTensor* input_to_forget_weights,
-    const TfLiteTensor* input_to_cell_weights,
-    const TfLiteTensor* input_to_output_weights,
-    const TfLiteTensor* recurrent_to_input_weights,
-    const TfLiteTensor* recurrent_to_forget_weights,
-    const TfLiteTensor* recurrent_to_cell_weights,
-    const TfLiteTensor* recurrent_to_output_weights,
-    const TfLiteTensor* cell_to_input_weights,
-    const TfLiteTensor* cell_to_forget_weights,
-    const TfLiteTensor* cell_to_output_weights,
-    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
-    const TfLiteTensor* cell_bias, const TfLiteTensor* output_gate_bias,
-    const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
-    const TfLiteLSTMParams* params, TfLiteTensor* scratch_buffer,
-    TfLiteTensor* output_state, TfLiteTensor* cell_state,
-    TfLiteTensor* output) {
+// Stacks the rows of the non-null 'gate_weights' into 'packed'.
+template <typename T>
+void PackGateWeights(std::initializer_list<const TfLiteTensor*> gate_weights,
+                     std::vector<T>* packed, std::vector<float>* scales) {
+  packed->clear();
+  if (scales) scales->clear();
+  for (const TfLiteTensor* weights : gate_weights) {
+    if (weights == nullptr) continue;
+    const T* data = reinterpret_cast<const T*>(weights->data.raw);
+    packed->insert(packed->end(), data, data + NumElements(weights));
+    if (scales) scales->push_back(weights->params.scale);
+  }
+}
+
+// Computes the new cell state, and the hidden state before projection, of
+// one time step from the pre-activation 'gates' of each batch, laid out as
+// packed in OpData. This fuses the gate nonlinearities, the peephole
+// connections and the cell update into a single pass.
+void UpdateCellAndHiddenState(const float* gates, int n_gates,
+                              const float* cell_to_input_weights,
+                              const float* cell_to_forget_weights,
+                              const float* cell_to_output_weights,
+                              const TfLiteLSTMParams* params, int n_batch,
+                              int n_cell, float* cell_state,
+                              float* hidden_state) {
+  const bool use_cifg = (n_gates == 3);
+  const bool use_peephole = (cell_to_output_weights != nullptr);
+  const ActivationFunctor sigmoid(kTfLiteActSigmoid);
+  const ActivationFunctor activation(params->activation);
+  const float* forget_gate = gates + (use_cifg ? 0 : n_cell);
+  const float* cell_gate = forget_gate + n_cell;
+  const float* output_gate = cell_gate + n_cell;
+  for (int b = 0; b < n_batch; ++b) {
+    for (int c = 0; c < n_cell; ++c) {
+      const float old_cell = cell_state[c];
+      float forget = forget_gate[c];
+      float output = output_gate[c];
+      if (use_peephole) {
+        forget += cell_to_forget_weights[c] * old_cell;
+      }
+      forget = sigmoid(forget);
+      float input;
+      if (use_cifg) {
+        input = 1.0f - forget;
+      } else {
+        input = gates[c];
+        if (use_peephole) {
+          input += cell_to_input_weights[c] * old_cell;
+        }
+        input = sigmoid(input);
+      }
+      float cell = forget * old_cell + input * activation(cell_gate[c]);
+      if (params->cell_clip > 0.0) {
+        cell = tensor_utils::Clip(cell, params->cell_clip);
+      }
+      if (use_peephole) {
+        output += cell_to_output_weights[c] * cell;
+      }
+      cell_state[c] = cell;
+      hidden_state[c] = sigmoid(output) * activation(cell);
+    }
+    gates += n_gates * n_cell;
+    forget_gate += n_gates * n_cell;
+    cell_gate += n_gates * n_cell;
+    output_gate += n_gates * n_cell;
+    cell_state += n_cell;
+    hidden_state += n_cell;
+  }
+}
+
+// The LSTM Op engine. The input projections of a block of time steps are
+// computed as one matrix product, leaving only the recurrent ones, with all
+// the recurrent weights packed together, to each step.
+TfLiteStatus EvalFloat(const TfLiteTensor* input,
+                       const TfLiteTensor* cell_to_input_weights,
+                       const TfLiteTensor* cell_to_forget_weights,
+                       const TfLiteTensor* cell_to_output_weights,
+                       const TfLiteTensor* projection_weights,
+                       const TfLiteTensor* projection_bias,
+                       const TfLiteLSTMParams* params, const OpData* op_data,
+                       TfLiteTensor* scratch_buffer, TfLiteTensor* output_state,
+                       TfLiteTensor* cell_state, TfLiteTensor* output) {
   const int max_time = input->dims->data[0];
   const int n_batch = input->dims->data[1];
   const int n_input = input->dims->data[2];
   // n_cell and n_output will be the same size when there is no projection.
-  const int n_cell = input_to_output_weights->dims->data[0];
-  const int n_output = recurrent_to_output_weights->dims->data[1];
+  const int n_cell = cell_state->dims->data[1];
+  const int n_output = output_state->dims->data[1];
+  const int n_gates = op_data->bias.size() / n_cell;
+  const int n_gate_rows = n_gates * n_cell;
+  const int time_steps_per_block = std::min(max_time, kMaxTimeStepsPerBlock);
 
-  // Since we have already checked that weights are all there or none, we can
-  // check the existence of only one to get the condition.
-  const bool use_cifg = (input_to_input_weights == nullptr);
   const bool use_peephole = (cell_to_output_weights != nullptr);
-
-  float* input_gate_scratch = nullptr;
-  float* cell_scratch = nullptr;
-  float* forget_gate_scratch = nullptr;
-  float* output_gate_scratch = nullptr;
-  if (use_cifg) {
-    cell_scratch = scratch_buffer->data.f;
-    forget_gate_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-  } else {
-    input_gate_scratch = scratch_buffer->data.f;
-    cell_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * n_batch;
-  }
-
-  // Check optional tensors, the respective pointers can be null.
-  const float* input_to_input_weights_ptr =
-      (use_cifg) ? nullptr : input_to_input_weights->data.f;
-  const float* recurrent_to_input_weights_ptr =
-      (use_cifg) ? nullptr : recurrent_to_input_weights->data.f;
-  const float* input_gate_bias_ptr =
-      (use_cifg) ? nullptr : input_gate_bias->data.f;
   const float* cell_to_input_weights_ptr =
-      (use_peephole && !use_cifg) ? cell_to_input_weights->data.f : nullptr;
+      (use_peephole && n_gates == 4) ? cell_to_input_weights->data.f : nullptr;
   const float* cell_to_forget_weights_ptr =
       (use_peephole) ? cell_to_forget_weights->data.f : nullptr;
   const float* cell_to_output_weights_ptr =
       (use_peephole) ? cell_to_output_weights->data.f : nullptr;
-  const float* projection_weights_ptr =
-      (projection_weights == nullptr) ? nullptr : projection_weights->data.f;
-  const float* projection_bias_ptr =
-      (projection_bias == nullptr) ? nullptr : projection_bias->data.f;
-
-  // Required tensors, pointers are non-null.
-  const float* input_to_forget_weights_ptr = input_to_forget_weights->data.f;
-  const float* input_to_cell_weights_ptr = input_to_cell_weights->data.f;
-  const float* input_to_output_weights_ptr = input_to_output_weights->data.f;
-  const float* recurrent_to_forget_weights_ptr =
-      recurrent_to_forget_weights->data.f;
-  const float* recurrent_to_cell_weights_ptr =
-      recurrent_to_cell_weights->data.f;
-  const float* recurrent_to_output_weights_ptr =
-      recurrent_to_output_weights->data.f;
-  const float* forget_gate_bias_ptr = forget_gate_bias->data.f;
-  const float* cell_bias_ptr = cell_bias->data.f;
-  const float* output_gate_bias_ptr = output_gate_bias->data.f;
+
+  float* gate_scratch = scratch_buffer->data.f;
+  float* hidden_scratch =
+      gate_scratch + (time_steps_per_block + 1) * n_batch * n_gate_rows;
 
   float* output_state_ptr = output_state->data.f;
   float* cell_state_ptr = cell_state->data.f;
 
-  // Feed the sequence into the LSTM step-by-step.
-  for (int t = 0; t < max_time; t++) {
-    const float* input_ptr_batch = input->data.f + t * n_batch * n_input;
-    float* output_ptr_batch = output->data.f + t * n_batch * n_output;
-
-    kernel_utils::LstmStep(
-        input_ptr_batch, input_to_input_weights_ptr,
-        input_to_forget_weights_ptr, input_to_cell_weights_ptr,
-        input_to_output_weights_ptr, recurrent_to_input_weights_ptr,
-        recurrent_to_forget_weights_ptr, recurrent_to_cell_weights_ptr,
-        recurrent_to_output_weights_ptr, cell_to_input_weights_ptr,
-        cell_to_forget_weights_ptr, cell_to_output_weights_ptr,
-        input_gate_bias_ptr, forget_gate_bias_ptr, cell_bias_ptr,
-        output_gate_bias_ptr, projection_weights_ptr, projection_bias_ptr,
-        params, n_batch, n_cell, n_input, n_output, output_state_ptr,
-        cell_state_ptr, input_gate_scratch, forget_gate_scratch, cell_scratch,
-        output_gate_scratch, output_ptr_batch);
+  const Dims<4> weights_dims = GetTensorDims({n_gate_rows, n_input});
+  const Dims<4> bias_dims = GetTensorDims({n_gate_rows});
+  for (int block_start = 0; block_start < max_time;
+       block_start += time_steps_per_block) {
+    const int block_steps =
+        std::min(time_steps_per_block, max_time - block_start);
+    optimized_ops::FullyConnected(
+        input->data.f + block_start * n_batch * n_input,
+        GetTensorDims({block_steps * n_batch, n_input}),
+        op_data->input_weights.data(), weights_dims, op_data->bias.data(),
+        bias_dims, std::numeric_limits<float>::lowest(),
+        std::numeric_limits<float>::max(), gate_scratch,
+        GetTensorDims({block_steps * n_batch, n_gate_rows}));
+
+    for (int t = block_start; t < block_start + block_steps; t++) {
+      float* gates = gate_scratch + (t - block_start) * n_batch * n_gate_rows;
+      float* output_ptr_batch = output->data.f + t * n_batch * n_output;
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          op_data->recurrent_weights.data(), n_gate_rows, n_output,
+          output_state_ptr, n_batch, gates, /*result_stride=*/1);
+
+      // Without projection, the hidden state is the output.
+      float* hidden_state =
+          projection_weights ? hidden_scratch : output_ptr_batch;
+      UpdateCellAndHiddenState(gates, n_gates, cell_to_input_weights_ptr,
+                               cell_to_forget_weights_ptr,
+                               cell_to_output_weights_ptr, params, n_batch,
+                               n_cell, cell_state_ptr, hidden_state);
+
+      if (projection_weights) {
+        if (projection_bias) {
+          tensor_utils::VectorBatchVectorAssign(projection_bias->data.f,
+                                                n_output, n_batch,
+                                                output_ptr_batch);
+        } else {
+          tensor_utils::ZeroVector(output_ptr_batch, n_batch * n_output);
+        }
+        tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+            projection_weights->data.f, n_output, n_cell, hidden_scratch,
+            n_batch, output_ptr_batch, /*result_stride=*/1);
+        if (params->proj_clip > 0.0) {
+          tensor_utils::ClipVector(output_ptr_batch, n_batch * n_output,
+                                   params->proj_clip, output_ptr_batch);
+        }
+      }
+      tensor_utils::CopyVector(output_ptr_batch, n_batch * n_output,
+                               output_state_ptr);
+    }
   }
   return kTfLiteOk;
 }
 
+// The hybrid LSTM Op engine, organized as EvalFloat() with the inputs
+// quantized on the fly. The products with the packed weights are scaled by
+// the weight scale of each gate afterwards.
 TfLiteStatus EvalHybrid(
-    const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
-    const TfLiteTensor* input_to_forget_weights,
-    const TfLiteTensor* input_to_cell_weights,
-    const TfLiteTensor* input_to_output_weights,
-    const TfLiteTensor* recurrent_to_input_weights,
-    const TfLiteTensor* recurrent_to_forget_weights,
-    const TfLiteTensor* recurrent_to_cell_weights,
-    const TfLiteTensor* recurrent_to_output_weights,
-    const TfLiteTensor* cell_to_input_weights,
+    const TfLiteTensor* input, const TfLiteTensor* cell_to_input_weights,
     const TfLiteTensor* cell_to_forget_weights,
     const TfLiteTensor* cell_to_output_weights,
-    const TfLiteTensor* input_gate_bias, const TfLiteTensor* forget_gate_bias,
-    const TfLiteTensor* cell_bias, const TfLiteTensor* output_gate_bias,
     const TfLiteTensor* projection_weights, const TfLiteTensor* projection_bias,
-    const TfLiteLSTMParams* params, TfLiteTensor* scratch_buffer,
-    TfLiteTensor* scaling_factors, TfLiteTensor* prod_scaling_factors,
-    TfLiteTensor* recovered_cell_weights, TfLiteTensor* input_quantized,
-    TfLiteTensor* output_state_quantized, TfLiteTensor* cell_state_quantized,
-    TfLiteTensor* output_state, TfLiteTensor* cell_state,
-    TfLiteTensor* output) {
+    const TfLiteLSTMParams* params, const OpData* op_data,
+    TfLiteTensor* scratch_buffer, TfLiteTensor* scaling_factors,
+    TfLiteTensor* prod_scaling_factors, TfLiteTensor* recovered_cell_weights,
+    TfLiteTensor* input_quantized, TfLiteTensor* output_state_quantized,
+    TfLiteTensor* cell_state_quantized, TfLiteTensor* output_state,
+    TfLiteTensor* cell_state, TfLiteTensor* output) {
   const int max_time = input->dims->data[0];
   const int n_batch = input->dims->data[1];
   const int n_input = input->dims->data[2];
   // n_cell and n_output will be the same size when there is no projection.
-  const int n_cell = input_to_output_weights->dims->data[0];
-  const int n_output = recurrent_to_output_weights->dims->data[1];
+  const int n_cell = cell_state->dims->data[1];
+  const int n_output = output_state->dims->data[1];
+  const int n_gates = op_data->bias.size() / n_cell;
+  const int n_gate_rows = n_gates * n_cell;
+  const int time_steps_per_block = std::min(max_time, kMaxTimeStepsPerBlock);
 
-  // Since we have already checked that weights are all there or none, we can
-  // check the existence of only one to get the condition.
-  const bool use_cifg = (input_to_input_weights == nullptr);
+  // Recover the peephole weights once for all the time steps.
   const bool use_peephole = (cell_to_output_weights != nullptr);
-
-  float* input_gate_scratch = nullptr;
-  float* cell_scratch = nullptr;
-  float* forget_gate_scratch = nullptr;
-  float* output_gate_scratch = nullptr;
-  if (use_cifg) {
-    cell_scratch = scratch_buffer->data.f;
-    forget_gate_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-  } else {
-    input_gate_scratch = scratch_buffer->data.f;
-    cell_scratch = scratch_buffer->data.f + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer->data.f + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer->data.f + 3 * n_cell * n_batch;
-  }
-
-  // Check optional tensors, the respective pointers can be null.
-  int8_t* input_to_input_weights_ptr = nullptr;
-  float input_to_input_weights_scale = 1.0f;
-  int8_t* recurrent_to_input_weights_ptr = nullptr;
-  float recurrent_to_input_weights_scale = 1.0f;
-  float* input_gate_bias_ptr = nullptr;
-  if (!use_cifg) {
-    input_to_input_weights_ptr =
-        reinterpret_cast<int8_t*>(input_to_input_weights->data.uint8);
-    recurrent_to_input_weights_ptr =
-        reinterpret_cast<int8_t*>(recurrent_to_input_weights->data.uint8);
-    input_gate_bias_ptr = input_gate_bias->data.f;
-    input_to_input_weights_scale = input_to_input_weights->params.scale;
-    recurrent_to_input_weights_scale = recurrent_to_input_weights->params.scale;
-  }
-
-  int8_t* cell_to_input_weights_ptr = nullptr;
-  int8_t* cell_to_forget_weights_ptr = nullptr;
-  int8_t* cell_to_output_weights_ptr = nullptr;
-  float cell_to_input_weights_scale = 1.0f;
-  float cell_to_forget_weights_scale = 1.0f;
-  float cell_to_output_weights_scale = 1.0f;
+  float* cell_to_input_weights_ptr = nullptr;
+  float* cell_to_forget_weights_ptr = nullptr;
+  float* cell_to_output_weights_ptr = nullptr;
   if (use_peephole) {
-    if (!use_cifg) {
-      cell_to_input_weights_ptr =
-          reinterpret_cast<int8_t*>(cell_to_input_weights->data.uint8);
-      cell_to_input_weights_scale = cell_to_input_weights->params.scale;
+    cell_to_forget_weights_ptr = recovered_cell_weights->data.f;
+    cell_to_output_weights_ptr = cell_to_forget_weights_ptr + n_cell;
+    tensor_utils::VectorScalarMultiply(
+        reinterpret_cast<int8_t*>(cell_to_forget_weights->data.uint8), n_cell,
+        cell_to_forget_weights->params.scale, cell_to_forget_weights_ptr);
+    tensor_utils::VectorScalarMultiply(
+        reinterpret_cast<int8_t*>(cell_to_output_weights->data.uint8), n_cell,
+        cell_to_output_weights->params.scale, cell_to_output_weights_ptr);
+    if (n_gates == 4) {
+      cell_to_input_weights_ptr = cell_to_output_weights_ptr + n_cell;
+      tensor_utils::VectorScalarMultiply(
+          reinterpret_cast<int8_t*>(cell_to_input_weights->data.uint8), n_cell,
+          cell_to_input_weights->params.scale, cell_to_input_weights_ptr);
     }
-    cell_to_forget_weights_ptr =
-        reinterpret_cast<int8_t*>(cell_to_forget_weights->data.uint8);
-    cell_to_output_weights_ptr =
-        reinterpret_cast<int8_t*>(cell_to_output_weights->data.uint8);
-    cell_to_forget_weights_scale = cell_to_forget_weights->params.scale;
-    cell_to_output_weights_scale = cell_to_output_weights->params.scale;
   }
 
   const int8_t* projection_weights_ptr =
       (projection_weights == nullptr)
           ? nullptr
           : reinterpret_cast<int8_t*>(projection_weights->data.uint8);
-  float projection_weights_scale =
+  const float projection_weights_scale =
       (projection_weights == nullptr) ? 1.0f : projection_weights->params.scale;
-  const float* projection_bias_ptr =
-      (projection_bias == nullptr) ? nullptr : projection_bias->data.f;
-
-  // Required tensors, pointers are non-null.
-  const int8_t* input_to_forget_weights_ptr =
-      reinterpret_cast<int8_t*>(input_to_forget_weights->data.uint8);
-  const float input_to_forget_weights_scale =
-      input_to_forget_weights->params.scale;
-  const int8_t* input_to_cell_weights_ptr =
-      reinterpret_cast<int8_t*>(input_to_cell_weights->data.uint8);
-  const float input_to_cell_weights_scale = input_to_cell_weights->params.scale;
-  const int8_t* input_to_output_weights_ptr =
-      reinterpret_cast<int8_t*>(input_to_output_weights->data.uint8);
-  const float input_to_output_weights_scale =
-      input_to_output_weights->params.scale;
-  const int8_t* recurrent_to_forget_weights_ptr =
-      reinterpret_cast<int8_t*>(recurrent_to_forget_weights->data.uint8);
-  const float recurrent_to_forget_weights_scale =
-      recurrent_to_forget_weights->params.scale;
-  const int8_t* recurrent_to_cell_weights_ptr =
-      reinterpret_cast<int8_t*>(recurrent_to_cell_weights->data.uint8);
-  const float recurrent_to_cell_weights_scale =
-      recurrent_to_cell_weights->params.scale;
-  const int8_t* recurrent_to_output_weights_ptr =
-      reinterpret_cast<int8_t*>(recurrent_to_output_weights->data.uint8);
-  const float recurrent_to_output_weights_scale =
-      recurrent_to_output_weights->params.scale;
-  const float* forget_gate_bias_ptr = forget_gate_bias->data.f;
-  const float* cell_bias_ptr = cell_bias->data.f;
-  const float* output_gate_bias_ptr = output_gate_bias->data.f;
+
+  float* gate_scratch = scratch_buffer->data.f;
+  float* recurrent_scratch =
+      gate_scratch + time_steps_per_block * n_batch * n_gate_rows;
+  float* hidden_scratch = recurrent_scratch + n_batch * n_gate_rows;
 
   float* output_state_ptr = output_state->data.f;
   float* cell_state_ptr = cell_state->data.f;
@@ -667,40 +694,120 @@ TfLiteStatus EvalHybrid(
       reinterpret_cast<int8_t*>(cell_state_quantized->data.uint8);
   float* scaling_factors_ptr = scaling_factors->data.f;
   float* prod_scaling_factors_ptr = prod_scaling_factors->data.f;
-  float* recovered_cell_weights_ptr = recovered_cell_weights->data.f;
-
-  // Feed the sequence into the LSTM step-by-step.
-  for (int t = 0; t < max_time; t++) {
-    const float* input_ptr_batch = input->data.f + t * n_batch * n_input;
-    float* output_ptr_batch = output->data.f + t * n_batch * n_output;
-
-    kernel_utils::LstmStep(
-        input_ptr_batch, input_to_input_weights_ptr,
-        input_to_input_weights_scale, input_to_forget_weights_ptr,
-        input_to_forget_weights_scale, input_to_cell_weights_ptr,
-        input_to_cell_weights_scale, input_to_output_weights_ptr,
-        input_to_output_weights_scale, recurrent_to_input_weights_ptr,
-        recurrent_to_input_weights_scale, recurrent_to_forget_weights_ptr,
-        recurrent_to_forget_weights_scale, recurrent_to_cell_weights_ptr,
-        recurrent_to_cell_weights_scale, recurrent_to_output_weights_ptr,
-        recurrent_to_output_weights_scale, cell_to_input_weights_ptr,
-        cell_to_input_weights_scale, cell_to_forget_weights_ptr,
-        cell_to_forget_weights_scale, cell_to_output_weights_ptr,
-        cell_to_output_weights_scale, input_gate_bias_ptr, forget_gate_bias_ptr,
-        cell_bias_ptr, output_gate_bias_ptr, projection_weights_ptr,
-        projection_weights_scale, projection_bias_ptr, params, n_batch, n_cell,
-        n_input, n_output, input_gate_scratch, forget_gate_scratch,
-        cell_scratch, output_gate_scratch, scaling_factors_ptr,
-        prod_scaling_factors_ptr, recovered_cell_weights_ptr,
-        quantized_input_ptr, quantized_output_state_ptr,
-        quantized_cell_state_ptr, output_state_ptr, cell_state_ptr,
-        output_ptr_batch);
+
+  float unused_min, unused_max;
+  for (int block_start = 0; block_start < max_time;
+       block_start += time_steps_per_block) {
+    const int block_steps =
+        std::min(time_steps_per_block, max_time - block_start);
+    const int block_vectors = block_steps * n_batch;
+    const float* block_input = input->data.f + block_start * n_batch * n_input;
+    int8_t* block_quantized_input =
+        quantized_input_ptr + block_start * n_batch * n_input;
+    for (int v = 0; v < block_vectors; ++v) {
+      tensor_utils::SymmetricQuantizeFloats(
+          block_input + v * n_input, n_input,
+          block_quantized_input + v * n_input, &unused_min, &unused_max,
+          &scaling_factors_ptr[v]);
+    }
+    tensor_utils::ZeroVector(gate_scratch, block_vectors * n_gate_rows);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        op_data->quantized_input_weights.data(), n_gate_rows, n_input,
+        block_quantized_input, scaling_factors_ptr, block_vectors,
+        gate_scratch, /*result_stride=*/1);
+    float* gates = gate_scratch;
+    for (int v = 0; v < block_vectors; ++v) {
+      for (int g = 0; g < n_gates; ++g) {
+        const float scale = op_data->input_weights_scales[g];
+        const float* bias = op_data->bias.data() + g * n_cell;
+        for (int c = 0; c < n_cell; ++c) {
+          gates[c] = bias[c] + gates[c] * scale;
+        }
+        gates += n_cell;
+      }
+    }
+
+    for (int t = block_start; t < block_start + block_steps; t++) {
+      gates = gate_scratch + (t - block_start) * n_batch * n_gate_rows;
+      float* output_ptr_batch = output->data.f + t * n_batch * n_output;
+
+      if (!tensor_utils::IsZeroVector(output_state_ptr, n_batch * n_output)) {
+        // Save quantization and matmul computation for all zero input.
+        for (int b = 0; b < n_batch; ++b) {
+          const int offset = b * n_output;
+          tensor_utils::SymmetricQuantizeFloats(
+              output_state_ptr + offset, n_output,
+              quantized_output_state_ptr + offset, &unused_min, &unused_max,
+              &scaling_factors_ptr[b]);
+        }
+        tensor_utils::ZeroVector(recurrent_scratch, n_batch * n_gate_rows);
+        tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+            op_data->quantized_recurrent_weights.data(), n_gate_rows,
+            n_output, quantized_output_state_ptr, scaling_factors_ptr, n_batch,
+            recurrent_scratch, /*result_stride=*/1);
+        const float* recurrent = recurrent_scratch;
+        float* gate = gates;
+        for (int b = 0; b < n_batch; ++b) {
+          for (int g = 0; g < n_gates; ++g) {
+            const float scale = op_data->recurrent_weights_scales[g];
+            for (int c = 0; c < n_cell; ++c) {
+              gate[c] += recurrent[c] * scale;
+            }
+            gate += n_cell;
+            recurrent += n_cell;
+          }
+        }
+      }
+
+      // Without projection, the hidden state is the output.
+      float* hidden_state =
+          projection_weights ? hidden_scratch : output_ptr_batch;
+      UpdateCellAndHiddenState(gates, n_gates, cell_to_input_weights_ptr,
+                               cell_to_forget_weights_ptr,
+                               cell_to_output_weights_ptr, params, n_batch,
+                               n_cell, cell_state_ptr, hidden_state);
+
+      if (projection_weights) {
+        if (projection_bias) {
+          tensor_utils::VectorBatchVectorAssign(projection_bias->data.f,
+                                                n_output, n_batch,
+                                                output_ptr_batch);
+        } else {
+          tensor_utils::ZeroVector(output_ptr_batch, n_batch * n_output);
+        }
+        if (!tensor_utils::IsZeroVector(hidden_scratch, n_batch * n_cell)) {
+          // Save quantization and matmul computation for all zero input.
+          for (int b = 0; b < n_batch; ++b) {
+            const int offset = b * n_cell;
+            tensor_utils::SymmetricQuantizeFloats(
+                hidden_scratch + offset, n_cell,
+                quantized_cell_state_ptr + offset, &unused_min, &unused_max,
+                &scaling_factors_ptr[b]);
+          }
+          for (int b = 0; b < n_batch; ++b) {
+            prod_scaling_factors_ptr[b] =
+                scaling_factors_ptr[b] * projection_weights_scale;
+          }
+          tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+              projection_weights_ptr, n_output, n_cell,
+              quantized_cell_state_ptr, prod_scaling_factors_ptr, n_batch,
+              output_ptr_batch, /*result_stride=*/1);
+        }
+        if (params->proj_clip > 0.0) {
+          tensor_utils::ClipVector(output_ptr_batch, n_batch * n_output,
+                                   params->proj_clip, output_ptr_batch);
+        }
+      }
+      tensor_utils::CopyVector(output_ptr_batch, n_batch * n_output,
+                               output_state_ptr);
+    }
   }
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteLSTMParams*>(node->builtin_data);
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
   const TfLiteTensor* input = GetInput(context, node, kInputTensor);
 
   const TfLiteTensor* input_to_input_weights =
@@ -748,17 +855,48 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensor* cell_state = GetOutput(context, node, kCellStateTensor);
   TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
 
+  const bool is_hybrid_op = (input_to_output_weights->type == kTfLiteUInt8);
+  if (!op_data->weights_packed) {
+    const auto input_weights = {input_to_input_weights, input_to_forget_weights,
+                                input_to_cell_weights, input_to_output_weights};
+    const auto recurrent_weights = {
+        recurrent_to_input_weights, recurrent_to_forget_weights,
+        recurrent_to_cell_weights, recurrent_to_output_weights};
+    if (is_hybrid_op) {
+      PackGateWeights(input_weights, &op_data->quantized_input_weights,
+                      &op_data->input_weights_scales);
+      PackGateWeights(recurrent_weights, &op_data->quantized_recurrent_weights,
+                      &op_data->recurrent_weights_scales);
+    } else {
+      PackGateWeights(input_weights, &op_data->input_weights, nullptr);
+      PackGateWeights(recurrent_weights, &op_data->recurrent_weights, nullptr);
+    }
+    PackGateWeights<float>(
+        {input_gate_bias, forget_gate_bias, cell_bias, output_gate_bias},
+        &op_data->bias, nullptr);
+    bool weights_constant = true;
+    for (const TfLiteTensor* tensor :
+         {input_to_forget_weights, input_to_cell_weights,
+          input_to_output_weights, recurrent_to_forget_weights,
+          recurrent_to_cell_weights, recurrent_to_output_weights,
+          forget_gate_bias, cell_bias, output_gate_bias}) {
+      weights_constant = weights_constant && IsConstantTensor(tensor);
+    }
+    if (input_to_input_weights) {
+      weights_constant = weights_constant &&
+                         IsConstantTensor(input_to_input_weights) &&
+                         IsConstantTensor(recurrent_to_input_weights) &&
+                         IsConstantTensor(input_gate_bias);
+    }
+    op_data->weights_packed = weights_constant;
+  }
+
   switch (input_to_output_weights->type) {
     case kTfLiteFloat32: {
-      return EvalFloat(input, input_to_input_weights, input_to_forget_weights,
-                       input_to_cell_weights, input_to_output_weights,
-                       recurrent_to_input_weights, recurrent_to_forget_weights,
-                       recurrent_to_cell_weights, recurrent_to_output_weights,
-                       cell_to_input_weights, cell_to_forget_weights,
-                       cell_to_output_weights, input_gate_bias,
-                       forget_gate_bias, cell_bias, output_gate_bias,
-                       projection_weights, projection_bias, params,
-                       scratch_buffer, output_state, cell_state, output);
+      return EvalFloat(input, cell_to_input_weights, cell_to_forget_weights,
+                       cell_to_output_weights, projection_weights,
+                       projection_bias, params, op_data, scratch_buffer,
+                       output_state, cell_state, output);
     }
     case kTfLiteUInt8: {
       TfLiteTensor* input_quantized = GetTemporary(context, node, /*index=*/1);
@@ -771,17 +909,13 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           GetTemporary(context, node, /*index=*/5);
       TfLiteTensor* recovered_cell_weights =
           GetTemporary(context, node, /*index=*/6);
-      return EvalHybrid(
-          input, input_to_input_weights, input_to_forget_weights,
-          input_to_cell_weights, input_to_output_weights,
-          recurrent_to_input_weights, recurrent_to_forget_weights,
-          recurrent_to_cell_weights, recurrent_to_output_weights,
-          cell_to_input_weights, cell_to_forget_weights, cell_to_output_weights,
-          input_gate_bias, forget_gate_bias, cell_bias, output_gate_bias,
-          projection_weights, projection_bias, params, scratch_buffer,
-          scaling_factors, prod_scaling_factors, recovered_cell_weights,
-          input_quantized, output_state_quantized, cell_state_quantized,
-          output_state, cell_state, output);
+      return EvalHybrid(input, cell_to_input_weights, cell_to_forget_weights,
+                        cell_to_output_weights, projection_weights,
+                        projection_bias, params, op_data, scratch_buffer,
+                        scaling_factors, prod_scaling_factors,
+                        recovered_cell_weights, input_quantized,
+                        output_state_quantized, cell_state_quantized,
+                        output_state, cell_state, output);
     }
     default:
       context->ReportError(context, "Type %d is not currently supported.",
@@ -20,6 +20,9 @@ limitations under the License.
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/contrib/lite/allocation.h"
 #include "tensorflow/contrib/lite/builtin_op_data.h"
 #include "tensorflow/contrib/lite/error_reporter.h"
@@ -53,6 +56,9 @@ TfLiteStatus ConvertTensorType(TensorType tensor_type, TfLiteType* type,
     case TensorType_UINT8:
       *type = kTfLiteUInt8;
       break;
+    case TensorType_INT8:
+      *type = kTfLiteInt8;
+      break;
     case TensorType_INT64:
       *type = kTfLiteInt64;
       break;
@@ -341,6 +347,20 @@ TfLiteStatus ParseOpData(const Operator* op, BuiltinOperator op_type,
 
         params->dilation_width_factor = conv_params->dilation_w_factor();
         params->dilation_height_factor = conv_params->dilation_h_factor();
+        switch (conv_params->filter_format()) {
+          case Conv2DOptionsFilterFormat_DEFAULT:
+            params->filter_format = kTfLiteConvFilterFormatDefault;
+            break;
+          case Conv2DOptionsFilterFormat_HWIO:
+            params->filter_format = kTfLiteConvFilterFormatHwio;
+            break;
+          case Conv2DOptionsFilterFormat_BLOCK_SPARSE:
+            params->filter_format = kTfLiteConvFilterFormatBlockSparse;
+            break;
+          default:
+            error_reporter->Report("Unhandled conv filter format.");
+            return kTfLiteError;
+        }
       }
       *builtin_data = reinterpret_cast<void*>(params);
       break;
@@ -457,6 +477,10 @@ TfLiteStatus ParseOpData(const Operator* op, BuiltinOperator op_type,
             params->weights_format =
                 kTfLiteFullyConnectedWeightsFormatShuffled4x16Int8;
             break;
+          case FullyConnectedOptionsWeightsFormat_BLOCK_SPARSE:
+            params->weights_format =
+                kTfLiteFullyConnectedWeightsFormatBlockSparse;
+            break;
           default:
             error_reporter->Report("Unhandled fully-connected weights format.");
             return kTfLiteError;
@@ -860,32 +884,45 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
     TfLiteQuantizationParams quantization;
     quantization.scale = 0;
     quantization.zero_point = 0;
+    // Set for tensors quantized per channel, one entry per channel.
+    std::vector<float> channel_scales;
+    std::vector<int> channel_zero_points;
     auto* q_params = tensor->quantization();
     if (q_params) {
-      // Note that the schema could hold per-channel quantization parameters
-      // but we really only support one value for the whole tensor.
       // TODO(aselle): This breaks as well if these are nullptr's.
-      // TODO(aselle): This assumes non per-channel quantization.
-
       if (q_params->scale()) {
-        if (q_params->scale()->size() != 1) {
-          error_reporter_->Report(
-              "QuantizationParam has %d scale values (only 1 is supported).",
-              q_params->scale()->size());
+        const int num_scales = q_params->scale()->size();
+        if (num_scales == 0) {
+          error_reporter_->Report("QuantizationParam has no scale values.");
           return kTfLiteError;
         }
         quantization.scale = q_params->scale()->Get(0);
+        if (num_scales > 1) {
+          channel_scales.assign(q_params->scale()->begin(),
+                                q_params->scale()->end());
+        }
       }
 
       if (q_params->zero_point()) {
-        if (q_params->zero_point()->size() != 1) {
+        const int num_zero_points = q_params->zero_point()->size();
+        if (num_zero_points != 1 &&
+            num_zero_points != static_cast<int>(channel_scales.size())) {
           error_reporter_->Report(
-              "QuantizationParam has %d zero_point values"
-              " (only 1 is supported).",
-              q_params->zero_point()->size());
+              "QuantizationParam has %d zero_point values for %d scale "
+              "values.",
+              num_zero_points, std::max<int>(channel_scales.size(), 1));
           return kTfLiteError;
         }
         quantization.zero_point = q_params->zero_point()->Get(0);
+        if (num_zero_points > 1) {
+          channel_zero_points.assign(q_params->zero_point()->begin(),
+                                     q_params->zero_point()->end());
+        }
+      }
+      if (!channel_scales.empty() && channel_zero_points.empty()) {
+        // A single zero point, or none, applies to every channel.
+        channel_zero_points.assign(channel_scales.size(),
+                                   quantization.zero_point);
       }
     }
 
@@ -931,7 +968,24 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
             i);
         status = kTfLiteError;
       }
+    }
 
+    if (auto* sparsity = tensor->sparsity()) {
+      // The buffer is empty if all the values of the tensor are zero.
+      auto get_vector = [](const flatbuffers::Vector<int32_t>* flat_array) {
+        return flat_array ? FlatBufferIntArrayToVector(flat_array)
+                          : std::vector<int>();
+      };
+      if (interpreter->SetTensorParametersReadOnlySparse(
+              i, type, get_name(tensor), dims, quantization,
+              sparsity->block_size(), get_vector(sparsity->row_segments()),
+              get_vector(sparsity->block_indices()), buffer_ptr, buffer_size,
+              allocation_) != kTfLiteOk) {
+        error_reporter_->Report("Tensor %d has invalid sparsity parameters.\n",
+                                i);
+        status = kTfLiteError;
+      }
+    } else if (buffer_ptr) {
       if (interpreter->SetTensorParametersReadOnly(
               i, type, get_name(tensor), dims, quantization, buffer_ptr,
               buffer_size, allocation_) != kTfLiteOk) {
@@ -948,6 +1002,14 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
         status = kTfLiteError;
       }
     }
+    if (!channel_scales.empty() &&
+        interpreter->SetTensorPerChannelQuantization(
+            i, channel_scales, channel_zero_points,
+            q_params->quantized_dimension()) != kTfLiteOk) {
+      error_reporter_->Report(
+          "Tensor %d has invalid per-channel quantization parameters.\n", i);
+      status = kTfLiteError;
+    }
   }
 
   return status;
@@ -448,6 +448,10 @@ TfLiteStatus AddOpsAndParams(
           logError("NNAPI does not support dilated Conv2D.");
           return kTfLiteError;
         }
+        if (builtin->filter_format != kTfLiteConvFilterFormatDefault) {
+          logError("NNAPI does not support prepacked Conv2D filters.");
+          return kTfLiteError;
+        }
       }
         add_convolution_params(node.builtin_data);
         nn_op_type = ANEURALNETWORKS_CONV_2D;
@@ -479,7 +483,15 @@ TfLiteStatus AddOpsAndParams(
         add_softmax_params(node.builtin_data);
         nn_op_type = ANEURALNETWORKS_SOFTMAX;
         break;
-      case tflite::BuiltinOperator_FULLY_CONNECTED:
+      case tflite::BuiltinOperator_FULLY_CONNECTED: {
+        auto builtin =
+            reinterpret_cast<TfLiteFullyConnectedParams*>(node.builtin_data);
+        if (builtin->weights_format !=
+            kTfLiteFullyConnectedWeightsFormatDefault) {
+          logError("NNAPI does not support packed FullyConnected weights.");
+          return kTfLiteError;
+        }
+      }
         add_fully_connected_params(node.builtin_data);
         nn_op_type = ANEURALNETWORKS_FULLY_CONNECTED;
         break;
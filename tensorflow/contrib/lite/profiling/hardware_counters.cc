@@ -0,0 +1,93 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/contrib/lite/profiling/hardware_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace tflite {
+namespace profiling {
+
+#if defined(__linux__)
+
+namespace {
+
+// Opens a counter of the calling thread in the group of `group_fd`, or as a
+// new group if it is -1. Returns -1 on failure.
+int OpenCounter(uint64_t config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  // Counting user space only needs the lowest privileges.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                 group_fd, /*flags=*/0);
+}
+
+}  // namespace
+
+HardwareCounters::HardwareCounters() {
+  cycles_fd_ = OpenCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (cycles_fd_ == -1) return;
+  instructions_fd_ = OpenCounter(PERF_COUNT_HW_INSTRUCTIONS, cycles_fd_);
+  cache_misses_fd_ = OpenCounter(PERF_COUNT_HW_CACHE_MISSES, cycles_fd_);
+  ioctl(cycles_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(cycles_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+HardwareCounters::~HardwareCounters() {
+  if (cache_misses_fd_ != -1) close(cache_misses_fd_);
+  if (instructions_fd_ != -1) close(instructions_fd_);
+  if (cycles_fd_ != -1) close(cycles_fd_);
+}
+
+HardwareCounterValues HardwareCounters::Read() const {
+  HardwareCounterValues values;
+  if (!enabled()) return values;
+  // The number of counters followed by their values in the order they were
+  // added to the group.
+  uint64_t data[4] = {0};
+  if (read(cycles_fd_, data, sizeof(data)) < 0) return values;
+  int next = 1;
+  values.cycles = data[next++];
+  if (instructions_fd_ != -1) values.instructions = data[next++];
+  if (cache_misses_fd_ != -1) values.cache_misses = data[next++];
+  return values;
+}
+
+#else
+
+HardwareCounters::HardwareCounters() {}
+
+HardwareCounters::~HardwareCounters() {}
+
+HardwareCounterValues HardwareCounters::Read() const {
+  return HardwareCounterValues();
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,58 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CONTRIB_LITE_PROFILING_HARDWARE_COUNTERS_H_
+#define TENSORFLOW_CONTRIB_LITE_PROFILING_HARDWARE_COUNTERS_H_
+
+#include <cstdint>
+
+namespace tflite {
+namespace profiling {
+
+// Values of the CPU's performance counters, in user space.
+struct HardwareCounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  // Misses of the last level cache.
+  uint64_t cache_misses = 0;
+};
+
+// Counts hardware events of the thread that creates it, using perf_event_open
+// on Linux and Android. Elsewhere, or if the kernel doesn't allow it (e.g. see
+// /proc/sys/kernel/perf_event_paranoid and, on Android, the
+// security.perf_harden property), enabled() is false and all values are 0.
+// Counters a CPU lacks also stay 0.
+class HardwareCounters {
+ public:
+  HardwareCounters();
+  ~HardwareCounters();
+
+  HardwareCounters(const HardwareCounters&) = delete;
+  HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+  bool enabled() const { return cycles_fd_ != -1; }
+
+  // Returns the values counted since construction.
+  HardwareCounterValues Read() const;
+
+ private:
+  // The cycle counter leads the group, which is read at once.
+  int cycles_fd_ = -1;
+  int instructions_fd_ = -1;
+  int cache_misses_fd_ = -1;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+#endif  // TENSORFLOW_CONTRIB_LITE_PROFILING_HARDWARE_COUNTERS_H_
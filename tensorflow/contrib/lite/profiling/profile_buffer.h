@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 
+#include "tensorflow/contrib/lite/profiling/hardware_counters.h"
 #include "tensorflow/contrib/lite/profiling/time.h"
 
 namespace tflite {
@@ -47,6 +48,8 @@ struct ProfileEvent {
   EventType event_type;
   // Extra data describing the details of the event.
   uint32_t event_metadata;
+  // Hardware events counted during the event, if the buffer counts them.
+  HardwareCounterValues hardware_counters;
 };
 }  // namespace profiling
 }  // namespace tflite
@@ -54,6 +57,7 @@ struct ProfileEvent {
 #ifdef TFLITE_PROFILING_ENABLED
 
 #include <sys/time.h>
+#include <memory>
 #include <vector>
 
 namespace tflite {
@@ -83,6 +87,10 @@ class ProfileBuffer {
     event_buffer_[index].event_metadata = event_metadata;
     event_buffer_[index].begin_timestamp_us = timestamp;
     event_buffer_[index].end_timestamp_us = 0;
+    // Holds the values at the beginning until the event ends.
+    event_buffer_[index].hardware_counters =
+        hardware_counters_ ? hardware_counters_->Read()
+                           : HardwareCounterValues();
     current_index_++;
     return index;
   }
@@ -90,6 +98,18 @@ class ProfileBuffer {
   // Sets the enabled state of buffer to |enabled|
   void SetEnabled(bool enabled) { enabled_ = enabled; }
 
+  // Starts counting hardware events of the calling thread during the events,
+  // which must all be on this thread. Returns false if the counters are
+  // unavailable.
+  bool EnableHardwareCounters() {
+    hardware_counters_.reset(new HardwareCounters);
+    if (!hardware_counters_->enabled()) {
+      hardware_counters_.reset();
+      return false;
+    }
+    return true;
+  }
+
   // Sets the end timestamp for event for the handle to current time.
   // If the buffer is disabled or previous event has been overwritten this
   // operation has not effect.
@@ -105,6 +125,14 @@ class ProfileBuffer {
     }
 
     int event_index = event_handle % max_size;
+    if (hardware_counters_) {
+      const HardwareCounterValues end = hardware_counters_->Read();
+      HardwareCounterValues* counters =
+          &event_buffer_[event_index].hardware_counters;
+      counters->cycles = end.cycles - counters->cycles;
+      counters->instructions = end.instructions - counters->instructions;
+      counters->cache_misses = end.cache_misses - counters->cache_misses;
+    }
     event_buffer_[event_index].end_timestamp_us = time::NowMicros();
   }
 
@@ -139,6 +167,7 @@ class ProfileBuffer {
   bool enabled_;
   uint32_t current_index_;
   std::vector<ProfileEvent> event_buffer_;
+  std::unique_ptr<HardwareCounters> hardware_counters_;
 };
 }  // namespace profiling
 }  // namespace tflite
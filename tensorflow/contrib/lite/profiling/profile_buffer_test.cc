@@ -91,6 +91,26 @@ TEST(ProfileBufferTest, Enable) {
   EXPECT_EQ(1, buffer.Size());
 }
 
+TEST(ProfileBufferTest, HardwareCounters) {
+  ProfileBuffer buffer(/*max_size*/ 10, /*enabled*/ true);
+  if (!buffer.EnableHardwareCounters()) {
+    // Not allowed on this platform.
+    return;
+  }
+  auto event_handle = buffer.BeginEvent(
+      "hello", ProfileEvent::EventType::DEFAULT, /* event_metadata */ 42);
+  volatile int sum = 0;
+  for (int i = 0; i < 1000; ++i) {
+    sum += i;
+  }
+  buffer.EndEvent(event_handle);
+  auto event = GetProfileEvents(buffer)[0];
+  EXPECT_GT(event->hardware_counters.cycles, 0);
+  // The loop alone runs more than 1000 instructions.
+  EXPECT_GT(event->hardware_counters.instructions, 1000);
+  EXPECT_LT(event->hardware_counters.instructions, 1000000);
+}
+
 }  // namespace
 }  // namespace profiling
 }  // namespace tflite
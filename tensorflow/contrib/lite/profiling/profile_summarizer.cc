@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/contrib/lite/profiling/profile_summarizer.h"
 
+#include <iomanip>
 #include <sstream>
 
 #include "tensorflow/contrib/lite/schema/schema_generated.h"
@@ -131,10 +132,49 @@ void ProfileSummarizer::ProcessProfiles(
         event->end_timestamp_us - event->begin_timestamp_us;
     stats_calculator_->AddNodeStats(node_name, op_details.name, node_num,
                                     start_us, node_exec_time, 0 /*memory */);
+    const HardwareCounterValues& counters = event->hardware_counters;
+    if (counters.cycles != 0 || counters.instructions != 0) {
+      OperatorCounters* op_counters =
+          &operator_counters_[event->event_metadata];
+      op_counters->name = node_name;
+      op_counters->type = op_details.name;
+      ++op_counters->count;
+      op_counters->total.cycles += counters.cycles;
+      op_counters->total.instructions += counters.instructions;
+      op_counters->total.cache_misses += counters.cache_misses;
+    }
     curr_total_us += node_exec_time;
     ++node_num;
   }
   stats_calculator_->UpdateRunTotalUs(curr_total_us);
 }
+
+std::string ProfileSummarizer::GetHardwareCountersString() const {
+  if (operator_counters_.empty()) {
+    return "";
+  }
+  // Few instructions per cycle and many cache misses per thousand
+  // instructions point to memory bound operators.
+  std::stringstream stream;
+  stream << "============================== Hardware counters "
+            "==============================\n";
+  stream << "[node type]\t[avg cycles]\t[avg instructions]\t[IPC]\t"
+            "[avg cache misses]\t[misses/1k instructions]\t[Name]\n";
+  stream << std::fixed << std::setprecision(2);
+  for (const auto& node : operator_counters_) {
+    const OperatorCounters& counters = node.second;
+    const double cycles = counters.total.cycles;
+    const double instructions = counters.total.instructions;
+    const double cache_misses = counters.total.cache_misses;
+    stream << counters.type << "\t" << cycles / counters.count << "\t"
+           << instructions / counters.count << "\t"
+           << (cycles > 0 ? instructions / cycles : 0.0) << "\t"
+           << cache_misses / counters.count << "\t"
+           << (instructions > 0 ? 1000 * cache_misses / instructions : 0.0)
+           << "\t" << counters.name << "\n";
+  }
+  return stream.str();
+}
+
 }  // namespace profiling
 }  // namespace tflite
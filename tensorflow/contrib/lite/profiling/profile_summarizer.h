@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_LITE_PROFILING_PROFILE_SUMMARIZER_H_
 #define TENSORFLOW_CONTRIB_LITE_PROFILING_PROFILE_SUMMARIZER_H_
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include "tensorflow/contrib/lite/interpreter.h"
@@ -37,8 +39,9 @@ class ProfileSummarizer {
 
   // Returns a string detailing the accumulated runtime stats in a tab-separated
   // format which can be pasted into a spreadsheet for further analysis.
+  // Hardware counters, if the profiler recorded any, follow in the same format.
   std::string GetOutputString() const {
-    return stats_calculator_->GetOutputString();
+    return stats_calculator_->GetOutputString() + GetHardwareCountersString();
   }
 
   std::string GetShortSummary() const {
@@ -46,7 +49,19 @@ class ProfileSummarizer {
   }
 
  private:
+  // Hardware counters of an operator summed over its invocations.
+  struct OperatorCounters {
+    std::string name;
+    std::string type;
+    int64_t count = 0;
+    HardwareCounterValues total;
+  };
+
+  std::string GetHardwareCountersString() const;
+
   std::unique_ptr<tensorflow::StatsCalculator> stats_calculator_;
+  // Indexed by node index.
+  std::map<int, OperatorCounters> operator_counters_;
 };
 
 }  // namespace profiling
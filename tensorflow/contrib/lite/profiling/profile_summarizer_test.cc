@@ -143,6 +143,28 @@ TEST(ProfileSummarizerTest, InterpreterPlusProfilingDetails) {
       << output;
 }
 
+TEST(ProfileSummarizerTest, InterpreterPlusHardwareCounters) {
+  Profiler profiler;
+  if (!profiler.EnableHardwareCounters()) {
+    // Not allowed on this platform.
+    return;
+  }
+  SimpleOpModel m;
+  m.Init(RegisterSimpleOp);
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  profiler.StartProfiling();
+  m.SetInputs(1, 2);
+  m.Invoke();
+  EXPECT_EQ(m.GetOutput(), 3);
+  profiler.StopProfiling();
+  ProfileSummarizer summarizer;
+  summarizer.ProcessProfiles(profiler.GetProfileEvents(), *interpreter);
+  auto output = summarizer.GetOutputString();
+  ASSERT_TRUE(output.find("Hardware counters") != std::string::npos)
+      << output;
+}
+
 #endif
 
 }  // namespace
@@ -82,6 +82,11 @@ class Profiler {
   void StartProfiling() { buffer_.SetEnabled(true); }
   void StopProfiling() { buffer_.SetEnabled(false); }
   void Reset() { buffer_.Reset(); }
+  // Also record the CPU cycles, instructions and cache misses of each event.
+  // Only the calling thread is counted, so it must be the thread invoking the
+  // interpreter; work handed to other threads, e.g. by multithreaded kernels,
+  // is missed. Returns false if the platform doesn't allow counting.
+  bool EnableHardwareCounters() { return buffer_.EnableHardwareCounters(); }
   std::vector<const ProfileEvent*> GetProfileEvents() {
     std::vector<const ProfileEvent*> profile_events;
     profile_events.reserve(buffer_.Size());
@@ -167,6 +172,7 @@ class Profiler {
   void StartProfiling() {}
   void StopProfiling() {}
   void Reset() {}
+  bool EnableHardwareCounters() { return false; }
   std::vector<const ProfileEvent*> GetProfileEvents() { return {}; }
 };
 }  // namespace profiling
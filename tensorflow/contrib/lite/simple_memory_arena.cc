@@ -80,6 +80,24 @@ TfLiteStatus SimpleMemoryArena::Allocate(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleMemoryArena::AllocateAt(TfLiteContext* context,
+                                           size_t alignment, size_t offset,
+                                           size_t size, ArenaAlloc* new_alloc) {
+  TF_LITE_ENSURE(context, alignment <= arena_alignment_);
+  TF_LITE_ENSURE_EQ(context, offset % alignment, 0);
+
+  if (size == 0) {
+    new_alloc->offset = 0;
+    new_alloc->size = 0;
+    return kTfLiteOk;
+  }
+
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+  new_alloc->offset = offset;
+  new_alloc->size = size;
+  return kTfLiteOk;
+}
+
 TfLiteStatus SimpleMemoryArena::Deallocate(TfLiteContext* context,
                                            const ArenaAlloc& alloc) {
   if (alloc.size == 0) {
@@ -108,16 +126,13 @@ TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
     char* new_underlying_buffer_aligned_ptr = reinterpret_cast<char*>(
         AlignTo(arena_alignment_, reinterpret_cast<intptr_t>(new_alloc)));
 
-    // If the arena had been previously allocated, copy over the old memory.
-    // Since Alloc pointers are offset based, they will remain valid in the new
-    // memory block.
-    if (high_water_mark_ > 0 && underlying_buffer_size_ > 0) {
-      size_t copy_amount = std::min(
-          underlying_buffer_.get() + underlying_buffer_size_ -
-              underlying_buffer_aligned_ptr_,
-          new_alloc + required_size - new_underlying_buffer_aligned_ptr);
+    // If allocations were committed since the last Clear(), copy over their
+    // memory. Since Alloc pointers are offset based, they will remain valid in
+    // the new memory block. After a Clear() nothing is live, so the arena can
+    // grow without copying the old contents.
+    if (committed_high_water_mark_ > 0) {
       memcpy(new_underlying_buffer_aligned_ptr, underlying_buffer_aligned_ptr_,
-             copy_amount);
+             committed_high_water_mark_);
     }
 
     underlying_buffer_.reset(new_alloc);
@@ -125,6 +140,7 @@ TfLiteStatus SimpleMemoryArena::Commit(TfLiteContext* context) {
     underlying_buffer_aligned_ptr_ = new_underlying_buffer_aligned_ptr;
   }
   committed_ = true;
+  committed_high_water_mark_ = high_water_mark_;
   return underlying_buffer_ != nullptr ? kTfLiteOk : kTfLiteError;
 }
 
@@ -144,6 +160,7 @@ TfLiteStatus SimpleMemoryArena::ResolveAlloc(TfLiteContext* context,
 TfLiteStatus SimpleMemoryArena::Clear() {
   committed_ = false;
   high_water_mark_ = 0;
+  committed_high_water_mark_ = 0;
   allocs_.clear();
   return kTfLiteOk;
 }
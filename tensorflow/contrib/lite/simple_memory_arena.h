@@ -47,12 +47,19 @@ class SimpleMemoryArena {
       : committed_(false),
         arena_alignment_(arena_alignment),
         high_water_mark_(0),
+        committed_high_water_mark_(0),
         underlying_buffer_size_(0),
         allocs_() {}
 
   TfLiteStatus Allocate(TfLiteContext* context, size_t alignment, size_t size,
                         ArenaAlloc* new_alloc);
 
+  // Allocates 'size' bytes at an 'offset' chosen by the caller, who is then
+  // responsible for keeping the allocations that are live at the same time
+  // apart. These allocations are not seen by Allocate() and Deallocate().
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t alignment,
+                          size_t offset, size_t size, ArenaAlloc* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context, const ArenaAlloc& alloc);
 
   inline size_t RequiredBufferSize() {
@@ -62,6 +69,8 @@ class SimpleMemoryArena {
     return arena_alignment_ + high_water_mark_ + padding;
   }
 
+  size_t high_water_mark() const { return high_water_mark_; }
+
   TfLiteStatus Commit(TfLiteContext* context);
 
   TfLiteStatus ResolveAlloc(TfLiteContext* context, const ArenaAlloc& alloc,
@@ -77,6 +86,10 @@ class SimpleMemoryArena {
   bool committed_;
   size_t arena_alignment_;
   size_t high_water_mark_;
+  // The high water mark of the last Commit() since the last Clear(). Only
+  // these bytes hold allocations that must survive a reallocation of the
+  // underlying buffer.
+  size_t committed_high_water_mark_;
   std::unique_ptr<char[]> underlying_buffer_;
   size_t underlying_buffer_size_;
   char* underlying_buffer_aligned_ptr_;
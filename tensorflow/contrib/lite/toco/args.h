@@ -246,6 +246,9 @@ struct ParsedTocoFlags {
   Arg<bool> allow_nudging_weights_to_use_fast_gemm_kernel = Arg<bool>(false);
   Arg<int64> dedupe_array_min_size_bytes = Arg<int64>(64);
   Arg<bool> split_tflite_lstm_inputs = Arg<bool>(true);
+  Arg<bool> prepack_conv_filters = Arg<bool>(false);
+  Arg<bool> sparsify_weights = Arg<bool>(false);
+  Arg<bool> fuse_depthwise_pointwise_conv = Arg<bool>(false);
 };
 
 }  // namespace toco
@@ -0,0 +1,109 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/toco/graph_transformations/graph_transformations.h"
+#include "tensorflow/contrib/lite/toco/model.h"
+#include "tensorflow/contrib/lite/toco/tooling_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace toco {
+
+// Fuses a float DepthwiseConv feeding a pointwise (1x1, stride 1) Conv, such
+// as the blocks of MobileNet once their BatchNorms and Relu6s have been fused
+// into the convolutions, into a DepthwiseConvPointwiseConv operator.
+bool FuseDepthwiseConvIntoPointwiseConv::Run(Model* model,
+                                             std::size_t op_index) {
+  const auto conv_it = model->operators.begin() + op_index;
+  if (conv_it->get()->type != OperatorType::kConv) {
+    return false;
+  }
+  auto* conv_op = static_cast<ConvOperator*>(conv_it->get());
+  // Exit if this Conv has prepacked or sparse weights, an im2col array, or
+  // isn't a pointwise convolution.
+  if (conv_op->filter_format != ConvFilterFormat::kDefault ||
+      conv_op->outputs.size() != 1 || conv_op->inputs.size() != 3 ||
+      conv_op->stride_width != 1 || conv_op->stride_height != 1 ||
+      conv_op->dilation_width_factor != 1 ||
+      conv_op->dilation_height_factor != 1) {
+    return false;
+  }
+  const Array& pw_weights_array = model->GetArray(conv_op->inputs[1]);
+  if (!pw_weights_array.has_shape() ||
+      pw_weights_array.shape().dimensions_count() != 4 ||
+      pw_weights_array.shape().dims(1) != 1 ||
+      pw_weights_array.shape().dims(2) != 1) {
+    return false;
+  }
+
+  const string& intermediate_name = conv_op->inputs[0];
+  Operator* producer = GetOpWithOutput(*model, intermediate_name);
+  if (!producer || producer->type != OperatorType::kDepthwiseConv) {
+    return false;
+  }
+  auto* dw_op = static_cast<DepthwiseConvOperator*>(producer);
+  if (dw_op->inputs.size() != 3 || !dw_op->depth_multiplier) {
+    return false;
+  }
+  // The depthwise output is never materialized, so nothing else can read it.
+  if (CountOpsWithInput(*model, intermediate_name) != 1 ||
+      IsOutputArray(*model, intermediate_name)) {
+    AddMessageF(
+        "Not fusing %s into %s because its output is consumed by other "
+        "operators or is an output of the model",
+        LogName(*dw_op), LogName(*conv_op));
+    return false;
+  }
+  // The fused TF Lite kernel only supports float, with constant weights and
+  // biases.
+  for (const string& name :
+       {dw_op->inputs[0], dw_op->inputs[1], dw_op->inputs[2],
+        conv_op->inputs[1], conv_op->inputs[2], conv_op->outputs[0]}) {
+    if (model->GetArray(name).data_type != ArrayDataType::kFloat) {
+      return false;
+    }
+  }
+  for (const string& name : {dw_op->inputs[1], dw_op->inputs[2],
+                             conv_op->inputs[1], conv_op->inputs[2]}) {
+    if (!IsConstantParameterArray(*model, name)) {
+      return false;
+    }
+  }
+
+  auto* fused_op = new DepthwiseConvPointwiseConvOperator;
+  fused_op->inputs = {dw_op->inputs[0], dw_op->inputs[1], dw_op->inputs[2],
+                      conv_op->inputs[1], conv_op->inputs[2]};
+  fused_op->outputs = conv_op->outputs;
+  fused_op->padding.type = dw_op->padding.type;
+  fused_op->padding.fixed = std::move(dw_op->padding.fixed);
+  fused_op->stride_width = dw_op->stride_width;
+  fused_op->stride_height = dw_op->stride_height;
+  fused_op->depth_multiplier = dw_op->depth_multiplier;
+  fused_op->depthwise_activation_function = dw_op->fused_activation_function;
+  fused_op->fused_activation_function = conv_op->fused_activation_function;
+  model->operators.emplace(conv_it, fused_op);
+
+  AddMessageF("Fused %s and %s into %s", LogName(*dw_op), LogName(*conv_op),
+              LogName(*fused_op));
+
+  model->EraseArray(intermediate_name);
+  model->operators.erase(FindOp(*model, conv_op));
+  model->operators.erase(FindOp(*model, dw_op));
+  return true;
+}
+
+}  // namespace toco
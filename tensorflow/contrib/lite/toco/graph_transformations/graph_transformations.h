@@ -194,6 +194,9 @@ DECLARE_GRAPH_TRANSFORMATION(ResolveMultiplyByZero)
 DECLARE_GRAPH_TRANSFORMATION(Dequantize)
 DECLARE_GRAPH_TRANSFORMATION(UnpartitionEmbeddingLookup)
 DECLARE_GRAPH_TRANSFORMATION(ShuffleFCWeights)
+DECLARE_GRAPH_TRANSFORMATION(PrepackConvFilters)
+DECLARE_GRAPH_TRANSFORMATION(SparsifyWeights)
+DECLARE_GRAPH_TRANSFORMATION(FuseDepthwiseConvIntoPointwiseConv)
 DECLARE_GRAPH_TRANSFORMATION(ResolveFakeQuantArgsFromVars)
 DECLARE_GRAPH_TRANSFORMATION(ResolveGatherAttributes)
 
@@ -0,0 +1,82 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/toco/graph_transformations/graph_transformations.h"
+#include "tensorflow/contrib/lite/toco/model.h"
+#include "tensorflow/contrib/lite/toco/tooling_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace toco {
+
+bool PrepackConvFilters::Run(Model* model, std::size_t op_index) {
+  Operator* op = model->operators[op_index].get();
+  if (op->type != OperatorType::kConv) {
+    return false;
+  }
+  ConvOperator* conv_op = static_cast<ConvOperator*>(op);
+  // Exit if this Conv op already has prepacked weights
+  if (conv_op->filter_format != ConvFilterFormat::kDefault) {
+    return false;
+  }
+  // Exit if this Conv op isn't one the multithreaded float kernel runs: that
+  // kernel doesn't support dilation, and the other kernels would have to
+  // transpose the weights back at runtime.
+  if (conv_op->dilation_width_factor != 1 ||
+      conv_op->dilation_height_factor != 1) {
+    return false;
+  }
+  const string& weights_name = conv_op->inputs[1];
+  Array& weights_array = model->GetArray(weights_name);
+  if (weights_array.data_type != ArrayDataType::kFloat ||
+      !weights_array.buffer) {
+    return false;
+  }
+  if (!weights_array.has_shape() ||
+      weights_array.shape().dimensions_count() != 4) {
+    return false;
+  }
+  // Exit if the weights are used by more than one op.
+  if (CountOpsWithInput(*model, weights_name) != 1) {
+    AddMessageF(
+        "Not prepacking the weights of %s because that array is consumed by "
+        "other operators",
+        LogName(*op));
+    return false;
+  }
+  // Transpose the weights, seen as a [output_depth, filter_height *
+  // filter_width * input_depth] matrix. The shape of the array is unchanged.
+  const Shape& weights_shape = weights_array.shape();
+  const int output_depth = weights_shape.dims(0);
+  const int filter_size =
+      weights_shape.dims(1) * weights_shape.dims(2) * weights_shape.dims(3);
+  auto& weights_data =
+      weights_array.GetMutableBuffer<ArrayDataType::kFloat>().data;
+  CHECK_EQ(output_depth * filter_size, weights_data.size());
+  std::vector<float> prepacked_data(weights_data.size());
+  for (int o = 0; o < output_depth; o++) {
+    for (int i = 0; i < filter_size; i++) {
+      prepacked_data[i * output_depth + o] = weights_data[o * filter_size + i];
+    }
+  }
+  weights_data = std::move(prepacked_data);
+  conv_op->filter_format = ConvFilterFormat::kHwio;
+  AddMessageF("Prepacked the weights of %s in HWIO format", LogName(*op));
+  return true;
+}
+
+}  // namespace toco
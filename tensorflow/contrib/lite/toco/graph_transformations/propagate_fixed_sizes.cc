@@ -290,6 +290,36 @@ void ProcessDepthwiseConvOperator(Model* model, DepthwiseConvOperator* op) {
                    &op->padding.GetOrCreateFixedPadding());
 }
 
+void ProcessDepthwiseConvPointwiseConvOperator(
+    Model* model, DepthwiseConvPointwiseConvOperator* op) {
+  const auto& input_array = model->GetArray(op->inputs[0]);
+  const auto& dw_weights_array = model->GetArray(op->inputs[1]);
+  const auto& pw_weights_array = model->GetArray(op->inputs[3]);
+  // Yield until input and weights dims have been resolved.
+  if (!input_array.has_shape() || !dw_weights_array.has_shape() ||
+      !pw_weights_array.has_shape()) {
+    return;
+  }
+  const auto& input_shape = input_array.shape();
+  CHECK_EQ(input_shape.dimensions_count(), 4);
+  const auto& dw_weights_shape = dw_weights_array.shape();
+  CHECK_EQ(dw_weights_shape.dimensions_count(), 4);
+  const auto& pw_weights_shape = pw_weights_array.shape();
+  CHECK_EQ(pw_weights_shape.dimensions_count(), 4);
+  CHECK_EQ(dw_weights_shape.dims(3), pw_weights_shape.dims(3))
+      << "depthwise output depth and pointwise input depth don't match";
+  CHECK_EQ(dw_weights_shape.dims(3), input_shape.dims(3) * op->depth_multiplier)
+      << "input/output depths and depth_multiplier don't match";
+
+  // The pointwise Conv preserves the spatial dims of the DepthwiseConv.
+  const int kheight = dw_weights_shape.dims(1);
+  const int kwidth = dw_weights_shape.dims(2);
+  ComputeConvSizes(input_shape, pw_weights_shape.dims(0), kwidth, kheight,
+                   op->stride_width, op->stride_height, 1, 1, op->padding.type,
+                   model->GetArray(op->outputs[0]).mutable_shape(),
+                   &op->padding.GetOrCreateFixedPadding());
+}
+
 void ProcessDepthToSpaceOperator(Model* model, DepthToSpaceOperator* op) {
   const auto& input_array = model->GetArray(op->inputs[0]);
   // Yield until input dims have been resolved.
@@ -1712,6 +1742,10 @@ bool PropagateFixedSizes::Run(Model* model, std::size_t op_index) {
       ProcessDepthwiseConvOperator(model,
                                    static_cast<DepthwiseConvOperator*>(op));
       break;
+    case OperatorType::kDepthwiseConvPointwiseConv:
+      ProcessDepthwiseConvPointwiseConvOperator(
+          model, static_cast<DepthwiseConvPointwiseConvOperator*>(op));
+      break;
     case OperatorType::kDepthToSpace:
       ProcessDepthToSpaceOperator(model,
                                   static_cast<DepthToSpaceOperator*>(op));
@@ -0,0 +1,131 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/toco/graph_transformations/graph_transformations.h"
+#include "tensorflow/contrib/lite/toco/model.h"
+#include "tensorflow/contrib/lite/toco/tooling_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace toco {
+
+namespace {
+
+// The number of consecutive weights stored or skipped together. This is the
+// number of floats in a NEON or SSE register, which the TF Lite sparse kernels
+// multiply at once.
+constexpr int kBlockSize = 4;
+
+// Below this fraction of zero blocks, the indices of the non-zero blocks and
+// the irregular accesses to the input cost more than the skipped blocks save.
+constexpr float kMinZeroBlocksFraction = 0.5f;
+
+}  // namespace
+
+bool SparsifyWeights::Run(Model* model, std::size_t op_index) {
+  Operator* op = model->operators[op_index].get();
+  int expected_weights_dims = 0;
+  if (op->type == OperatorType::kFullyConnected) {
+    auto* fc_op = static_cast<FullyConnectedOperator*>(op);
+    // Exit if this FC op already has packed weights
+    if (fc_op->weights_format != FullyConnectedWeightsFormat::kDefault) {
+      return false;
+    }
+    expected_weights_dims = 2;
+  } else if (op->type == OperatorType::kConv) {
+    auto* conv_op = static_cast<ConvOperator*>(op);
+    // Exit if this Conv op already has packed weights, or isn't a pointwise
+    // convolution, the only kind the TF Lite sparse kernel supports.
+    if (conv_op->filter_format != ConvFilterFormat::kDefault ||
+        conv_op->stride_width != 1 || conv_op->stride_height != 1 ||
+        conv_op->dilation_width_factor != 1 ||
+        conv_op->dilation_height_factor != 1) {
+      return false;
+    }
+    expected_weights_dims = 4;
+  } else {
+    return false;
+  }
+  const string& weights_name = op->inputs[1];
+  Array& weights_array = model->GetArray(weights_name);
+  if (weights_array.data_type != ArrayDataType::kFloat ||
+      !weights_array.buffer || weights_array.sparse_block_size != 0) {
+    return false;
+  }
+  if (!weights_array.has_shape() ||
+      weights_array.shape().dimensions_count() != expected_weights_dims) {
+    return false;
+  }
+  const Shape& weights_shape = weights_array.shape();
+  if (op->type == OperatorType::kConv &&
+      (weights_shape.dims(1) != 1 || weights_shape.dims(2) != 1)) {
+    return false;
+  }
+  // Exit if the weights are used by more than one op.
+  if (CountOpsWithInput(*model, weights_name) != 1) {
+    AddMessageF(
+        "Not sparsifying the weights of %s because that array is consumed by "
+        "other operators",
+        LogName(*op));
+    return false;
+  }
+  // The weights are seen as a [output_depth, input_depth] matrix, whose rows
+  // must be made of whole blocks.
+  const int rows = weights_shape.dims(0);
+  const int cols = RequiredBufferSizeForShape(weights_shape) / rows;
+  if (cols % kBlockSize != 0) {
+    AddMessageF(
+        "Not sparsifying the weights of %s because their input depth is not a "
+        "multiple of %d",
+        LogName(*op), kBlockSize);
+    return false;
+  }
+  const auto& weights_data =
+      weights_array.GetBuffer<ArrayDataType::kFloat>().data;
+  const int num_blocks = weights_data.size() / kBlockSize;
+  int num_zero_blocks = 0;
+  for (int b = 0; b < num_blocks; b++) {
+    bool is_zero = true;
+    for (int i = 0; i < kBlockSize; i++) {
+      if (weights_data[b * kBlockSize + i] != 0.0f) {
+        is_zero = false;
+        break;
+      }
+    }
+    num_zero_blocks += is_zero;
+  }
+  if (num_zero_blocks < kMinZeroBlocksFraction * num_blocks) {
+    AddMessageF(
+        "Not sparsifying the weights of %s because only %d of their %d blocks "
+        "are zero",
+        LogName(*op), num_zero_blocks, num_blocks);
+    return false;
+  }
+  weights_array.sparse_block_size = kBlockSize;
+  if (op->type == OperatorType::kFullyConnected) {
+    static_cast<FullyConnectedOperator*>(op)->weights_format =
+        FullyConnectedWeightsFormat::kBlockSparse;
+  } else {
+    static_cast<ConvOperator*>(op)->filter_format =
+        ConvFilterFormat::kBlockSparse;
+  }
+  AddMessageF("Sparsified the weights of %s, %d of their %d blocks are zero",
+              LogName(*op), num_zero_blocks, num_blocks);
+  return true;
+}
+
+}  // namespace toco
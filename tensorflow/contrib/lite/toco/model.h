@@ -147,6 +147,7 @@ enum class OperatorType : uint8 {
   kAny,
   kLogicalAnd,
   kLogicalNot,
+  kDepthwiseConvPointwiseConv,
 };
 
 // Helper to deal with TensorFlow arrays using a different ordering of
@@ -425,6 +426,20 @@ struct Padding {
 //                         of Conv layers as Im2col+GEMM.
 //
 // TensorFlow equivalent: Conv2D
+// Layout of the data of the Conv weights array, whose shape is always
+// [output_depth, filter_height, filter_width, input_depth].
+enum class ConvFilterFormat {
+  // Laid out as its shape says.
+  kDefault,
+  // Laid out as [filter_height, filter_width, input_depth, output_depth],
+  // which the multithreaded float kernel of TF Lite reads in place.
+  kHwio,
+  // Laid out as its shape says, with only the non-zero blocks of the weights
+  // array stored in the exported model, see Array::sparse_block_size. Only
+  // used by 1x1 convolutions with unit strides.
+  kBlockSparse,
+};
+
 struct ConvOperator : Operator {
   ConvOperator() : Operator(OperatorType::kConv) {}
   Padding padding;
@@ -435,6 +450,7 @@ struct ConvOperator : Operator {
   // attribute is not present.
   int dilation_width_factor = 1;
   int dilation_height_factor = 1;
+  ConvFilterFormat filter_format = ConvFilterFormat::kDefault;
 };
 
 // Depthwise-separable convolution operator.
@@ -454,6 +470,35 @@ struct DepthwiseConvOperator : Operator {
   int depth_multiplier = 0;
 };
 
+// A DepthwiseConv followed by a pointwise (1x1, stride 1) Conv, fused by the
+// FuseDepthwiseConvIntoPointwiseConv graph transformation so that the TF Lite
+// kernel can consume the depthwise output tile by tile, while it is in cache.
+//
+// Inputs:
+//   inputs[0]: required: the input activations array
+//   inputs[1]: required: the DepthwiseConv weights
+//   inputs[2]: required: the DepthwiseConv bias vector
+//   inputs[3]: required: the pointwise Conv weights, in OHWI order with H and
+//   W equal to 1
+//   inputs[4]: required: the pointwise Conv bias vector
+//
+// The inherited fused_activation_function applies to the output of the
+// pointwise Conv, while depthwise_activation_function applies to the output
+// of the DepthwiseConv.
+//
+// TensorFlow equivalent: none. It's only generated by toco, as a TF Lite
+// custom op.
+struct DepthwiseConvPointwiseConvOperator : Operator {
+  DepthwiseConvPointwiseConvOperator()
+      : Operator(OperatorType::kDepthwiseConvPointwiseConv) {}
+  Padding padding;
+  int stride_height = 0;
+  int stride_width = 0;
+  int depth_multiplier = 0;
+  FusedActivationFunctionType depthwise_activation_function =
+      FusedActivationFunctionType::kNone;
+};
+
 // Depth-to-space transform operator.
 //
 // Inputs:
@@ -1968,6 +2013,11 @@ struct Array {
   //   a min and a max. Unlike MinMax which is agnostic as to the quantized
   //   data type, narrow_range refers to values in the quantized data type.
   bool narrow_range = false;
+  // If positive, the constant float data of this array, seen as a matrix of
+  // shape [dims(0), product of the other dims], is exported in the TF Lite
+  // block sparse format, with blocks of this many consecutive values of a
+  // row. The buffer itself always holds the dense data.
+  int sparse_block_size = 0;
 
  private:
   std::unique_ptr<Shape> array_shape;
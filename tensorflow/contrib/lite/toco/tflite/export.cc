@@ -138,13 +138,14 @@ Offset<Vector<Offset<Tensor>>> ExportTensors(
     }
     auto q_param = ::tflite::CreateQuantizationParameters(*builder, min, max,
                                                           scale, zero_point);
+    auto sparsity = DataBuffer::SerializeSparsity(array, builder);
 
     int index = tensors_map.at(tensor_name);
     bool is_variable =
         variable_tensor_indices.find(index) != variable_tensor_indices.end();
-    ordered_tensors[index] =
-        CreateTensor(*builder, builder->CreateVector(shape), type, buffer_index,
-                     builder->CreateString(tensor_name), q_param, is_variable);
+    ordered_tensors[index] = CreateTensor(
+        *builder, builder->CreateVector(shape), type, buffer_index,
+        builder->CreateString(tensor_name), q_param, is_variable, sparsity);
   }
 
   std::vector<Offset<Tensor>> tensor_vector;
@@ -176,6 +177,12 @@ Offset<Vector<int32_t>> ExportOutputTensors(
   return builder->CreateVector<int32_t>(outputs);
 }
 
+// Whether 'name' is a custom op that the standard TF Lite runtime registers,
+// so that models using it don't need a custom implementation.
+bool IsStandardCustomOperator(const string& name) {
+  return name == "TFLite_DepthwiseConvPointwiseConv";
+}
+
 Offset<Vector<Offset<OperatorCode>>> ExportOperatorCodes(
     const Model& model,
     const std::map<OperatorType, std::unique_ptr<BaseOperator>>& ops_by_type,
@@ -219,8 +226,9 @@ Offset<Vector<Offset<OperatorCode>>> ExportOperatorCodes(
         name = operator_key.custom_code;
       }
       // Either way, this is an operator that is not supported by TF Lite,
-      // so we output it as a custom op and add it to the error summary.
-      if (error_summary) {
+      // so we output it as a custom op and add it to the error summary,
+      // unless the TF Lite runtime provides it as a custom op.
+      if (error_summary && !IsStandardCustomOperator(name)) {
         error_summary->insert(name);
       }
       ordered_opcodes[op_index] =
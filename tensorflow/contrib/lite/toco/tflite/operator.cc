@@ -72,10 +72,25 @@ class Convolution
     auto padding = Padding::Serialize(op.padding.type);
     auto activation_function =
         ActivationFunction::Serialize(op.fused_activation_function);
-    return ::tflite::CreateConv2DOptions(*builder, padding, op.stride_width,
-                                         op.stride_height, activation_function,
-                                         op.dilation_width_factor,
-                                         op.dilation_height_factor);
+    ::tflite::Conv2DOptionsFilterFormat tflite_filter_format;
+    switch (op.filter_format) {
+      case ConvFilterFormat::kDefault:
+        tflite_filter_format = ::tflite::Conv2DOptionsFilterFormat_DEFAULT;
+        break;
+      case ConvFilterFormat::kHwio:
+        tflite_filter_format = ::tflite::Conv2DOptionsFilterFormat_HWIO;
+        break;
+      case ConvFilterFormat::kBlockSparse:
+        tflite_filter_format = ::tflite::Conv2DOptionsFilterFormat_BLOCK_SPARSE;
+        break;
+      default:
+        LOG(ERROR) << "Unhandled Conv filter format";
+        tflite_filter_format = ::tflite::Conv2DOptionsFilterFormat_DEFAULT;
+    }
+    return ::tflite::CreateConv2DOptions(
+        *builder, padding, op.stride_width, op.stride_height,
+        activation_function, op.dilation_width_factor,
+        op.dilation_height_factor, tflite_filter_format);
   }
 
   void ReadOptions(const TfLiteOptions& options,
@@ -87,9 +102,33 @@ class Convolution
     op->dilation_height_factor = options.dilation_h_factor();
     op->fused_activation_function =
         ActivationFunction::Deserialize(options.fused_activation_function());
+    switch (options.filter_format()) {
+      case ::tflite::Conv2DOptionsFilterFormat_DEFAULT:
+        op->filter_format = ConvFilterFormat::kDefault;
+        break;
+      case ::tflite::Conv2DOptionsFilterFormat_HWIO:
+        op->filter_format = ConvFilterFormat::kHwio;
+        break;
+      case ::tflite::Conv2DOptionsFilterFormat_BLOCK_SPARSE:
+        op->filter_format = ConvFilterFormat::kBlockSparse;
+        break;
+      default:
+        LOG(ERROR) << "Unhandled Conv filter format";
+        op->filter_format = ConvFilterFormat::kDefault;
+    }
   }
 
-  int GetVersion(const Operator& op) const override { return 1; }
+  int GetVersion(const Operator& op) const override {
+    const auto& conv_op = static_cast<const ConvOperator&>(op);
+    switch (conv_op.filter_format) {
+      case ConvFilterFormat::kHwio:
+        return 2;
+      case ConvFilterFormat::kBlockSparse:
+        return 3;
+      default:
+        return 1;
+    }
+  }
 };
 
 class DepthwiseConvolution
@@ -282,6 +321,58 @@ class DepthToSpace : public CustomOperator<DepthToSpaceOperator> {
   int GetVersion(const Operator& op) const override { return 1; }
 };
 
+class DepthwiseConvPointwiseConv
+    : public CustomOperator<DepthwiseConvPointwiseConvOperator> {
+ public:
+  using CustomOperator::CustomOperator;
+  void WriteOptions(const TocoOperator& op,
+                    flexbuffers::Builder* fbb) const override {
+    fbb->String("padding",
+                op.padding.type == PaddingType::kSame ? "SAME" : "VALID");
+    fbb->Int("stride_width", op.stride_width);
+    fbb->Int("stride_height", op.stride_height);
+    fbb->Int("depth_multiplier", op.depth_multiplier);
+    fbb->String("depthwise_activation",
+                ActivationName(op.depthwise_activation_function));
+    fbb->String("activation", ActivationName(op.fused_activation_function));
+  }
+  void ReadOptions(const flexbuffers::Map& m, TocoOperator* op) const override {
+    op->padding.type = m["padding"].AsString().str() == "SAME"
+                           ? PaddingType::kSame
+                           : PaddingType::kValid;
+    op->stride_width = m["stride_width"].AsInt32();
+    op->stride_height = m["stride_height"].AsInt32();
+    op->depth_multiplier = m["depth_multiplier"].AsInt32();
+    op->depthwise_activation_function =
+        ActivationFromName(m["depthwise_activation"].AsString().str());
+    op->fused_activation_function =
+        ActivationFromName(m["activation"].AsString().str());
+  }
+
+  int GetVersion(const Operator& op) const override { return 1; }
+
+ private:
+  // The names of the activations in the options of the TF Lite custom op.
+  static const char* ActivationName(FusedActivationFunctionType activation) {
+    switch (activation) {
+      case FusedActivationFunctionType::kRelu:
+        return "RELU";
+      case FusedActivationFunctionType::kRelu1:
+        return "RELU_N1_TO_1";
+      case FusedActivationFunctionType::kRelu6:
+        return "RELU6";
+      default:
+        return "NONE";
+    }
+  }
+  static FusedActivationFunctionType ActivationFromName(const string& name) {
+    if (name == "RELU") return FusedActivationFunctionType::kRelu;
+    if (name == "RELU_N1_TO_1") return FusedActivationFunctionType::kRelu1;
+    if (name == "RELU6") return FusedActivationFunctionType::kRelu6;
+    return FusedActivationFunctionType::kNone;
+  }
+};
+
 class FakeQuant
     : public BuiltinOperator<FakeQuantOperator, ::tflite::FakeQuantOptions,
                              ::tflite::BuiltinOptions_FakeQuantOptions> {
@@ -330,6 +421,10 @@ class FullyConnected
         tflite_weights_format =
             ::tflite::FullyConnectedOptionsWeightsFormat_SHUFFLED4x16INT8;
         break;
+      case FullyConnectedWeightsFormat::kBlockSparse:
+        tflite_weights_format =
+            ::tflite::FullyConnectedOptionsWeightsFormat_BLOCK_SPARSE;
+        break;
       default:
         LOG(ERROR) << "Unhandled FC weights format";
         tflite_weights_format =
@@ -350,6 +445,9 @@ class FullyConnected
       case ::tflite::FullyConnectedOptionsWeightsFormat_SHUFFLED4x16INT8:
         op->weights_format = FullyConnectedWeightsFormat::kShuffled4x16Int8;
         break;
+      case ::tflite::FullyConnectedOptionsWeightsFormat_BLOCK_SPARSE:
+        op->weights_format = FullyConnectedWeightsFormat::kBlockSparse;
+        break;
       default:
         LOG(ERROR) << "Unhandled FC weights format";
         op->weights_format = FullyConnectedWeightsFormat::kDefault;
@@ -358,8 +456,14 @@ class FullyConnected
 
   int GetVersion(const Operator& op) const override {
     const auto& fc_op = static_cast<const FullyConnectedOperator&>(op);
-    return fc_op.weights_format == FullyConnectedWeightsFormat::kDefault ? 1
-                                                                         : 2;
+    switch (fc_op.weights_format) {
+      case FullyConnectedWeightsFormat::kShuffled4x16Int8:
+        return 2;
+      case FullyConnectedWeightsFormat::kBlockSparse:
+        return 3;
+      default:
+        return 1;
+    }
   }
 };
 
@@ -1301,6 +1405,9 @@ std::vector<std::unique_ptr<BaseOperator>> BuildOperatorList() {
   // Custom Operators.
   ops.emplace_back(
       new DepthToSpace("DEPTH_TO_SPACE", OperatorType::kDepthToSpace));
+  ops.emplace_back(new DepthwiseConvPointwiseConv(
+      "TFLite_DepthwiseConvPointwiseConv",
+      OperatorType::kDepthwiseConvPointwiseConv));
   ops.emplace_back(new TensorFlowUnsupported("TENSORFLOW_UNSUPPORTED",
                                              OperatorType::kUnsupported));
 
@@ -173,6 +173,28 @@ TEST_F(OperatorTest, CustomDepthToSpace) {
   EXPECT_EQ(op.block_size, output_toco_op->block_size);
 }
 
+TEST_F(OperatorTest, CustomDepthwiseConvPointwiseConv) {
+  DepthwiseConvPointwiseConvOperator op;
+  op.padding.type = PaddingType::kSame;
+  op.stride_width = 2;
+  op.stride_height = 3;
+  op.depth_multiplier = 4;
+  op.depthwise_activation_function = FusedActivationFunctionType::kRelu6;
+  op.fused_activation_function = FusedActivationFunctionType::kRelu1;
+  auto output_toco_op = SerializeAndDeserialize(
+      GetOperator("TFLite_DepthwiseConvPointwiseConv",
+                  OperatorType::kDepthwiseConvPointwiseConv),
+      op);
+  EXPECT_EQ(op.padding.type, output_toco_op->padding.type);
+  EXPECT_EQ(op.stride_width, output_toco_op->stride_width);
+  EXPECT_EQ(op.stride_height, output_toco_op->stride_height);
+  EXPECT_EQ(op.depth_multiplier, output_toco_op->depth_multiplier);
+  EXPECT_EQ(op.depthwise_activation_function,
+            output_toco_op->depthwise_activation_function);
+  EXPECT_EQ(op.fused_activation_function,
+            output_toco_op->fused_activation_function);
+}
+
 TEST_F(OperatorTest, CustomFakeQuant) {
   FakeQuantOperator op;
   auto* minmax = new MinMax;
@@ -196,6 +218,16 @@ TEST_F(OperatorTest, CustomFullyConnected) {
             output_toco_op->fused_activation_function);
 }
 
+TEST_F(OperatorTest, BuiltinFullyConnectedWithBlockSparseWeights) {
+  FullyConnectedOperator op;
+  op.weights_format = FullyConnectedWeightsFormat::kBlockSparse;
+  const auto& tflite_op =
+      GetOperator("FULLY_CONNECTED", OperatorType::kFullyConnected);
+  auto output_toco_op = SerializeAndDeserialize(tflite_op, op);
+  EXPECT_EQ(op.weights_format, output_toco_op->weights_format);
+  EXPECT_EQ(tflite_op.GetVersion(op), 3);
+}
+
 TEST_F(OperatorTest, BuiltinGather) {
   GatherOperator op;
   auto output_toco_op =
@@ -315,6 +347,25 @@ TEST_F(OperatorTest, BuiltinConvolution) {
   EXPECT_EQ(op.padding.type, output_toco_op->padding.type);
   EXPECT_EQ(op.fused_activation_function,
             output_toco_op->fused_activation_function);
+  EXPECT_EQ(op.filter_format, output_toco_op->filter_format);
+}
+
+TEST_F(OperatorTest, BuiltinConvolutionWithHwioFilter) {
+  ConvOperator op;
+  op.filter_format = ConvFilterFormat::kHwio;
+  auto output_toco_op =
+      SerializeAndDeserialize(GetOperator("CONV_2D", OperatorType::kConv), op);
+  EXPECT_EQ(op.filter_format, output_toco_op->filter_format);
+  EXPECT_EQ(GetOperator("CONV_2D", OperatorType::kConv).GetVersion(op), 2);
+}
+
+TEST_F(OperatorTest, BuiltinConvolutionWithBlockSparseFilter) {
+  ConvOperator op;
+  op.filter_format = ConvFilterFormat::kBlockSparse;
+  auto output_toco_op =
+      SerializeAndDeserialize(GetOperator("CONV_2D", OperatorType::kConv), op);
+  EXPECT_EQ(op.filter_format, output_toco_op->filter_format);
+  EXPECT_EQ(GetOperator("CONV_2D", OperatorType::kConv).GetVersion(op), 3);
 }
 
 TEST_F(OperatorTest, BuiltinDepthwiseConvolution) {
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/toco/tflite/types.h"
 #include "tensorflow/contrib/lite/string_util.h"
+#include "tensorflow/contrib/lite/util.h"
 
 namespace toco {
 
@@ -56,6 +57,29 @@ DataBuffer::FlatBufferOffset CopyBuffer(
   return builder->CreateVector(dst_data, size);
 }
 
+// Encode the float data of an array with a sparse_block_size, seen as a
+// matrix of shape [dims(0), product of the other dims].
+void EncodeBlockSparse(const Array& array, std::vector<int>* row_segments,
+                       std::vector<int>* block_indices,
+                       std::vector<float>* values) {
+  const auto& src_data = array.GetBuffer<ArrayDataType::kFloat>().data;
+  const int rows = array.shape().dims(0);
+  const int cols = src_data.size() / rows;
+  ::tflite::BlockSparseEncode(src_data.data(), rows, cols,
+                              array.sparse_block_size, row_segments,
+                              block_indices, values);
+}
+
+DataBuffer::FlatBufferOffset CopyBlockSparseToBuffer(
+    const Array& array, flatbuffers::FlatBufferBuilder* builder) {
+  std::vector<int> row_segments;
+  std::vector<int> block_indices;
+  std::vector<float> values;
+  EncodeBlockSparse(array, &row_segments, &block_indices, &values);
+  return builder->CreateVector(reinterpret_cast<const uint8_t*>(values.data()),
+                               values.size() * sizeof(float));
+}
+
 void CopyStringFromBuffer(const ::tflite::Buffer& buffer, Array* array) {
   auto* src_data = reinterpret_cast<const char*>(buffer.data()->data());
   std::vector<string>* dst_data =
@@ -82,6 +106,26 @@ void CopyBuffer(const ::tflite::Buffer& buffer, Array* array) {
     ++src_data;
   }
 }
+
+void CopyBlockSparseFromBuffer(const ::tflite::Tensor& tensor,
+                               const ::tflite::Buffer& buffer, Array* array) {
+  const auto* sparsity = tensor.sparsity();
+  CHECK(tensor.shape() && tensor.shape()->size() > 0);
+  CHECK(sparsity->row_segments() && sparsity->block_indices());
+  const int rows = tensor.shape()->Get(0);
+  int cols = 1;
+  for (int i = 1; i < tensor.shape()->size(); ++i) {
+    cols *= tensor.shape()->Get(i);
+  }
+  std::vector<float>* dst_data =
+      &array->GetMutableBuffer<ArrayDataType::kFloat>().data;
+  dst_data->resize(rows * cols);
+  ::tflite::BlockSparseDecode(
+      reinterpret_cast<const float*>(buffer.data()->data()),
+      sparsity->block_size(), sparsity->row_segments()->data(),
+      sparsity->block_indices()->data(), rows, cols, dst_data->data());
+  array->sparse_block_size = sparsity->block_size();
+}
 }  // namespace
 
 ::tflite::TensorType DataType::Serialize(ArrayDataType array_data_type) {
@@ -96,6 +140,8 @@ void CopyBuffer(const ::tflite::Buffer& buffer, Array* array) {
       return ::tflite::TensorType_INT64;
     case ArrayDataType::kUint8:
       return ::tflite::TensorType_UINT8;
+    case ArrayDataType::kInt8:
+      return ::tflite::TensorType_INT8;
     case ArrayDataType::kString:
       return ::tflite::TensorType_STRING;
     case ArrayDataType::kBool:
@@ -123,6 +169,8 @@ ArrayDataType DataType::Deserialize(int tensor_type) {
       return ArrayDataType::kString;
     case ::tflite::TensorType_UINT8:
       return ArrayDataType::kUint8;
+    case ::tflite::TensorType_INT8:
+      return ArrayDataType::kInt8;
     case ::tflite::TensorType_BOOL:
       return ArrayDataType::kBool;
     case ::tflite::TensorType_COMPLEX64:
@@ -138,6 +186,9 @@ flatbuffers::Offset<flatbuffers::Vector<uint8_t>> DataBuffer::Serialize(
 
   switch (array.data_type) {
     case ArrayDataType::kFloat:
+      if (array.sparse_block_size > 0) {
+        return CopyBlockSparseToBuffer(array, builder);
+      }
       return CopyBuffer<ArrayDataType::kFloat>(array, builder);
     case ArrayDataType::kInt16:
       return CopyBuffer<ArrayDataType::kInt16>(array, builder);
@@ -149,6 +200,8 @@ flatbuffers::Offset<flatbuffers::Vector<uint8_t>> DataBuffer::Serialize(
       return CopyStringToBuffer(array, builder);
     case ArrayDataType::kUint8:
       return CopyBuffer<ArrayDataType::kUint8>(array, builder);
+    case ArrayDataType::kInt8:
+      return CopyBuffer<ArrayDataType::kInt8>(array, builder);
     case ArrayDataType::kBool:
       return CopyBoolToBuffer(array, builder);
     case ArrayDataType::kComplex64:
@@ -165,6 +218,9 @@ void DataBuffer::Deserialize(const ::tflite::Tensor& tensor,
 
   switch (tensor.type()) {
     case ::tflite::TensorType_FLOAT32:
+      if (tensor.sparsity()) {
+        return CopyBlockSparseFromBuffer(tensor, buffer, array);
+      }
       return CopyBuffer<ArrayDataType::kFloat>(buffer, array);
     case ::tflite::TensorType_INT16:
       return CopyBuffer<ArrayDataType::kInt16>(buffer, array);
@@ -176,6 +232,8 @@ void DataBuffer::Deserialize(const ::tflite::Tensor& tensor,
       return CopyStringFromBuffer(buffer, array);
     case ::tflite::TensorType_UINT8:
       return CopyBuffer<ArrayDataType::kUint8>(buffer, array);
+    case ::tflite::TensorType_INT8:
+      return CopyBuffer<ArrayDataType::kInt8>(buffer, array);
     case ::tflite::TensorType_BOOL:
       return CopyBuffer<ArrayDataType::kBool>(buffer, array);
     case ::tflite::TensorType_COMPLEX64:
@@ -185,6 +243,20 @@ void DataBuffer::Deserialize(const ::tflite::Tensor& tensor,
   }
 }
 
+flatbuffers::Offset<::tflite::SparsityParameters>
+DataBuffer::SerializeSparsity(const Array& array,
+                              flatbuffers::FlatBufferBuilder* builder) {
+  if (array.sparse_block_size <= 0 || !array.buffer) return 0;
+  CHECK(array.data_type == ArrayDataType::kFloat);
+  std::vector<int> row_segments;
+  std::vector<int> block_indices;
+  std::vector<float> values;
+  EncodeBlockSparse(array, &row_segments, &block_indices, &values);
+  return ::tflite::CreateSparsityParameters(
+      *builder, array.sparse_block_size, builder->CreateVector(row_segments),
+      builder->CreateVector(block_indices));
+}
+
 ::tflite::Padding Padding::Serialize(PaddingType padding_type) {
   switch (padding_type) {
     case PaddingType::kSame:
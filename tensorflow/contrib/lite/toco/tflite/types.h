@@ -35,6 +35,11 @@ struct DataBuffer {
   // will be copied into the flatbuffer.
   static FlatBufferOffset Serialize(const Array& array,
                                     flatbuffers::FlatBufferBuilder* builder);
+  // Build the flatbuffer representation of the block sparse structure of a
+  // toco's Array, or return a null offset if the array is stored densely. In
+  // the former case Serialize() copies only the non-zero blocks.
+  static flatbuffers::Offset<::tflite::SparsityParameters> SerializeSparsity(
+      const Array& array, flatbuffers::FlatBufferBuilder* builder);
   // Copy data from the given tensor into toco's Array.
   static void Deserialize(const ::tflite::Tensor& tensor,
                           const ::tflite::Buffer& buffer, Array* array);
@@ -70,6 +70,7 @@ Array ToFlatBufferAndBack(std::initializer_list<::toco::DataType<T>> items) {
 TEST(DataType, SupportedTypes) {
   std::vector<std::pair<ArrayDataType, ::tflite::TensorType>> testdata = {
       {ArrayDataType::kUint8, ::tflite::TensorType_UINT8},
+      {ArrayDataType::kInt8, ::tflite::TensorType_INT8},
       {ArrayDataType::kInt32, ::tflite::TensorType_INT32},
       {ArrayDataType::kInt64, ::tflite::TensorType_INT64},
       {ArrayDataType::kFloat, ::tflite::TensorType_FLOAT32},
@@ -142,12 +143,55 @@ TEST(DataBuffer, Float) {
               ::testing::ElementsAre(1.0f, 2.0f));
 }
 
+TEST(DataBuffer, BlockSparseFloat) {
+  Array src;
+  src.data_type = ArrayDataType::kFloat;
+  src.copy_shape(Shape({2, 4}));
+  src.GetMutableBuffer<ArrayDataType::kFloat>().data = {0.0f, 0.0f, 1.0f, 2.0f,
+                                                        3.0f, 4.0f, 0.0f, 0.0f};
+  src.sparse_block_size = 2;
+
+  flatbuffers::FlatBufferBuilder builder;
+  auto sparsity = DataBuffer::SerializeSparsity(src, &builder);
+  builder.Finish(CreateTensor(builder, builder.CreateVector<int>({2, 4}),
+                              ::tflite::TensorType_FLOAT32, /*buffer=*/1,
+                              /*name=*/0, /*quantization=*/0,
+                              /*is_variable=*/false, sparsity));
+  flatbuffers::FlatBufferBuilder buffer_builder;
+  Offset<Vector<uint8_t>> data_buffer =
+      DataBuffer::Serialize(src, &buffer_builder);
+  buffer_builder.Finish(::tflite::CreateBuffer(buffer_builder, data_buffer));
+
+  auto* tensor =
+      flatbuffers::GetRoot<::tflite::Tensor>(builder.GetBufferPointer());
+  auto* buffer =
+      flatbuffers::GetRoot<::tflite::Buffer>(buffer_builder.GetBufferPointer());
+  // Only the two non-zero blocks are stored.
+  EXPECT_EQ(buffer->data()->size(), 4 * sizeof(float));
+  ASSERT_NE(tensor->sparsity(), nullptr);
+  EXPECT_EQ(tensor->sparsity()->block_size(), 2);
+
+  Array result;
+  result.data_type = ArrayDataType::kFloat;
+  DataBuffer::Deserialize(*tensor, *buffer, &result);
+  EXPECT_EQ(result.sparse_block_size, 2);
+  EXPECT_THAT(result.GetBuffer<ArrayDataType::kFloat>().data,
+              ::testing::ElementsAre(0.0f, 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 0.0f,
+                                     0.0f));
+}
+
 TEST(DataBuffer, Uint8) {
   Array recovered = ToFlatBufferAndBack<ArrayDataType::kUint8>({127, 244});
   EXPECT_THAT(recovered.GetBuffer<ArrayDataType::kUint8>().data,
               ::testing::ElementsAre(127, 244));
 }
 
+TEST(DataBuffer, Int8) {
+  Array recovered = ToFlatBufferAndBack<ArrayDataType::kInt8>({-127, 100});
+  EXPECT_THAT(recovered.GetBuffer<ArrayDataType::kInt8>().data,
+              ::testing::ElementsAre(-127, 100));
+}
+
 TEST(DataBuffer, Int32) {
   Array recovered = ToFlatBufferAndBack<ArrayDataType::kInt32>({1, 1 << 30});
   EXPECT_THAT(recovered.GetBuffer<ArrayDataType::kInt32>().data,
@@ -163,6 +163,25 @@ bool ParseTocoFlagsFromCommandLineFlags(
            "Store weights as quantized weights followed by dequantize "
            "operations. Computation is still done in float, but reduces model "
            "size (at the cost of accuracy and latency)."),
+      Flag("prepack_conv_filters", parsed_flags.prepack_conv_filters.bind(),
+           parsed_flags.prepack_conv_filters.default_value(),
+           "Store the float weights of Conv operators in the layout the "
+           "multithreaded TF Lite kernel reads, so that it uses them in place "
+           "rather than keeping a transposed copy in memory. Ignored if the "
+           "output format is not TFLite."),
+      Flag("sparsify_weights", parsed_flags.sparsify_weights.bind(),
+           parsed_flags.sparsify_weights.default_value(),
+           "Store the float weights of FullyConnected and 1x1 Conv operators "
+           "that are mostly zero, e.g. from pruned models, in the block "
+           "sparse format, which TF Lite multiplies skipping the zero blocks. "
+           "Ignored if the output format is not TFLite."),
+      Flag("fuse_depthwise_pointwise_conv",
+           parsed_flags.fuse_depthwise_pointwise_conv.bind(),
+           parsed_flags.fuse_depthwise_pointwise_conv.default_value(),
+           "Fuse each float DepthwiseConv feeding a 1x1 Conv, as in MobileNet "
+           "blocks, into a single TF Lite op that doesn't write the depthwise "
+           "output to memory. The fused kernel is single threaded. Ignored if "
+           "the output format is not TFLite."),
   };
   bool asked_for_help =
       *argc == 2 && (!strcmp(argv[1], "--help") || !strcmp(argv[1], "-help"));
@@ -257,6 +276,9 @@ void ReadTocoFlagsFromCommandLineFlags(const ParsedTocoFlags& parsed_toco_flags,
   READ_TOCO_FLAG(dedupe_array_min_size_bytes, FlagRequirement::kNone);
   READ_TOCO_FLAG(split_tflite_lstm_inputs, FlagRequirement::kNone);
   READ_TOCO_FLAG(quantize_weights, FlagRequirement::kNone);
+  READ_TOCO_FLAG(prepack_conv_filters, FlagRequirement::kNone);
+  READ_TOCO_FLAG(sparsify_weights, FlagRequirement::kNone);
+  READ_TOCO_FLAG(fuse_depthwise_pointwise_conv, FlagRequirement::kNone);
 
   // Deprecated flag handling.
   if (parsed_toco_flags.input_type.specified()) {
@@ -366,6 +366,23 @@ void Transform(const TocoFlags& toco_flags, Model* model) {
     EncodeConstantArraysMinMaxByWrappingThemInFakeQuantNodes(model);
   }
 
+  // Before the weights are sparsified or prepacked, which the fused kernel
+  // doesn't support.
+  if (toco_flags.fuse_depthwise_pointwise_conv() && output_format == TFLITE) {
+    RunGraphTransformations(model, "fusion of DepthwiseConv and 1x1 Conv",
+                            {new FuseDepthwiseConvIntoPointwiseConv});
+  }
+
+  if (toco_flags.sparsify_weights() && output_format == TFLITE) {
+    RunGraphTransformations(model, "sparsification of weights",
+                            {new SparsifyWeights});
+  }
+
+  if (toco_flags.prepack_conv_filters() && output_format == TFLITE) {
+    RunGraphTransformations(model, "prepacking of Conv filters",
+                            {new PrepackConvFilters});
+  }
+
   // Deduplicate large constant arrays.
   if (toco_flags.has_dedupe_array_min_size_bytes()) {
     DedupeConstantArrays(model, toco_flags.dedupe_array_min_size_bytes());
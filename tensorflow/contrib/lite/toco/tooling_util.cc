@@ -403,6 +403,7 @@ const char* OperatorTypeName(OperatorType type) {
     HANDLE_OPERATORTYPENAME_CASE(Any)
     HANDLE_OPERATORTYPENAME_CASE(LogicalAnd)
     HANDLE_OPERATORTYPENAME_CASE(LogicalNot)
+    HANDLE_OPERATORTYPENAME_CASE(DepthwiseConvPointwiseConv)
     default:
       LOG(FATAL) << "Unhandled op type";
 #undef HANDLE_OPERATORTYPENAME_CASE
@@ -722,7 +723,8 @@ bool CompareConstantArrays(const Array& lhs_array, const Array& rhs_array) {
       lhs_array.data_type == rhs_array.data_type &&
       lhs_array.final_data_type == rhs_array.final_data_type &&
       lhs_array.minmax == rhs_array.minmax &&
-      lhs_array.quantization_params == rhs_array.quantization_params;
+      lhs_array.quantization_params == rhs_array.quantization_params &&
+      lhs_array.sparse_block_size == rhs_array.sparse_block_size;
   if (!attrs_equal) {
     return false;
   }
@@ -2221,7 +2223,8 @@ void UndoWeightsShuffling(Model* model) {
       continue;
     }
     const auto& fc_op = static_cast<toco::FullyConnectedOperator&>(*op);
-    if (fc_op.weights_format == FullyConnectedWeightsFormat::kDefault) {
+    if (fc_op.weights_format !=
+        FullyConnectedWeightsFormat::kShuffled4x16Int8) {
       continue;
     }
     const string& weights_name = fc_op.inputs[1];
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/contrib/lite/tools/benchmark/benchmark_sweep.h"
 #include "tensorflow/contrib/lite/tools/benchmark/benchmark_tflite_model.h"
 #include "tensorflow/contrib/lite/tools/benchmark/logging.h"
 
@@ -25,6 +26,13 @@ int Main(int argc, char** argv) {
 #else
   TFLITE_LOG(INFO) << "STARTING!";
 #endif
+  BenchmarkSweep sweep;
+  if (!sweep.ParseFlags(&argc, argv)) {
+    return 1;
+  }
+  if (sweep.IsEnabled()) {
+    return sweep.Run(argc, argv);
+  }
   BenchmarkTfLiteModel benchmark;
   BenchmarkLoggingListener listener;
   benchmark.AddListener(&listener);
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <time.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 
@@ -48,6 +50,33 @@ namespace tflite {
 namespace benchmark {
 using tensorflow::Stat;
 
+BenchmarkResults::BenchmarkResults(int64_t startup_latency_us,
+                                   uint64_t input_bytes,
+                                   Stat<int64_t> warmup_time_us,
+                                   Stat<int64_t> inference_time_us,
+                                   std::vector<int64_t> inference_times_us,
+                                   uint64_t arena_bytes)
+    : startup_latency_us_(startup_latency_us),
+      input_bytes_(input_bytes),
+      warmup_time_us_(warmup_time_us),
+      inference_time_us_(inference_time_us),
+      inference_times_us_(std::move(inference_times_us)),
+      arena_bytes_(arena_bytes) {
+  std::sort(inference_times_us_.begin(), inference_times_us_.end());
+}
+
+int64_t BenchmarkResults::inference_time_percentile_us(int percentile) const {
+  if (inference_times_us_.empty()) {
+    return 0;
+  }
+  // Nearest-rank percentile: the smallest run time that at least
+  // 'percentile' percent of the runs don't exceed.
+  const int num_runs = inference_times_us_.size();
+  int rank = std::ceil(percentile / 100.0 * num_runs);
+  rank = std::min(std::max(rank, 1), num_runs);
+  return inference_times_us_[rank - 1];
+}
+
 BenchmarkParams BenchmarkModel::DefaultParams() {
   BenchmarkParams params;
   params.AddParam("num_runs", BenchmarkParam::Create<int32_t>(50));
@@ -69,6 +98,12 @@ void BenchmarkLoggingListener::OnBenchmarkEnd(const BenchmarkResults &results) {
                    << "Warmup: " << warmup_us.avg() << ", "
                    << "Init: " << init_us << ", "
                    << "no stats: " << inference_us.avg();
+  TFLITE_LOG(INFO) << "Inference timing percentiles in us: "
+                   << "p50: " << results.inference_time_percentile_us(50)
+                   << ", "
+                   << "p90: " << results.inference_time_percentile_us(90)
+                   << ", "
+                   << "p99: " << results.inference_time_percentile_us(99);
 }
 
 std::vector<Flag> BenchmarkModel::GetFlags() {
@@ -100,7 +135,8 @@ void BenchmarkModel::LogParams() {
 
 void BenchmarkModel::PrepareInputsAndOutputs() {}
 
-Stat<int64_t> BenchmarkModel::Run(int num_times, RunType run_type) {
+Stat<int64_t> BenchmarkModel::Run(int num_times, RunType run_type,
+                                  std::vector<int64_t> *run_times_us) {
   Stat<int64_t> run_stats;
   TFLITE_LOG(INFO) << "Running benchmark for " << num_times << " iterations ";
   for (int run = 0; run < num_times; run++) {
@@ -112,6 +148,9 @@ Stat<int64_t> BenchmarkModel::Run(int num_times, RunType run_type) {
     listeners_.OnSingleRunEnd();
 
     run_stats.UpdateStat(end_us - start_us);
+    if (run_times_us) {
+      run_times_us->push_back(end_us - start_us);
+    }
     SleepForSeconds(params_.Get<float>("run_delay"));
   }
 
@@ -145,11 +184,13 @@ void BenchmarkModel::Run() {
 
   uint64_t input_bytes = ComputeInputBytes();
   Stat<int64_t> warmup_time_us =
-      Run(params_.Get<int32_t>("warmup_runs"), WARMUP);
+      Run(params_.Get<int32_t>("warmup_runs"), WARMUP, nullptr);
+  std::vector<int64_t> inference_times_us;
   Stat<int64_t> inference_time_us =
-      Run(params_.Get<int32_t>("num_runs"), REGULAR);
-  listeners_.OnBenchmarkEnd(
-      {startup_latency_us, input_bytes, warmup_time_us, inference_time_us});
+      Run(params_.Get<int32_t>("num_runs"), REGULAR, &inference_times_us);
+  listeners_.OnBenchmarkEnd({startup_latency_us, input_bytes, warmup_time_us,
+                             inference_time_us, std::move(inference_times_us),
+                             ComputeArenaBytes()});
 }
 
 bool BenchmarkModel::ParseFlags(int argc, char **argv) {
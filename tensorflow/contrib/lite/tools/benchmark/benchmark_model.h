@@ -39,11 +39,9 @@ class BenchmarkResults {
  public:
   BenchmarkResults(int64_t startup_latency_us, uint64_t input_bytes,
                    tensorflow::Stat<int64_t> warmup_time_us,
-                   tensorflow::Stat<int64_t> inference_time_us)
-      : startup_latency_us_(startup_latency_us),
-        input_bytes_(input_bytes),
-        warmup_time_us_(warmup_time_us),
-        inference_time_us_(inference_time_us) {}
+                   tensorflow::Stat<int64_t> inference_time_us,
+                   std::vector<int64_t> inference_times_us = {},
+                   uint64_t arena_bytes = 0);
 
   tensorflow::Stat<int64_t> inference_time_us() const {
     return inference_time_us_;
@@ -56,12 +54,21 @@ class BenchmarkResults {
                            inference_time_us_.sum();
     return bytes_per_sec / (1024.0 * 1024.0);
   }
+  // The time within which 'percentile' percent of the inference runs
+  // completed, or 0 if the individual run times are unknown.
+  int64_t inference_time_percentile_us(int percentile) const;
+  // The size of the memory arena holding the intermediate tensors of the
+  // model, or 0 if unknown.
+  uint64_t arena_bytes() const { return arena_bytes_; }
 
  private:
   int64_t startup_latency_us_;
   uint64_t input_bytes_;
   tensorflow::Stat<int64_t> warmup_time_us_;
   tensorflow::Stat<int64_t> inference_time_us_;
+  // Sorted.
+  std::vector<int64_t> inference_times_us_;
+  uint64_t arena_bytes_;
 };
 
 class BenchmarkListener {
@@ -150,7 +157,11 @@ class BenchmarkModel {
   bool ParseFlags(int argc, char** argv);
   virtual std::vector<Flag> GetFlags();
   virtual uint64_t ComputeInputBytes() = 0;
-  virtual tensorflow::Stat<int64_t> Run(int num_times, RunType run_type);
+  virtual uint64_t ComputeArenaBytes() { return 0; }
+  // Runs the model 'num_times', and also appends the time of each run to
+  // 'run_times_us' if not null.
+  virtual tensorflow::Stat<int64_t> Run(int num_times, RunType run_type,
+                                        std::vector<int64_t>* run_times_us);
   virtual void PrepareInputsAndOutputs();
   virtual void RunImpl() = 0;
   BenchmarkParams params_;
@@ -0,0 +1,330 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/tools/benchmark/benchmark_sweep.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/tools/benchmark/benchmark_tflite_model.h"
+#include "tensorflow/contrib/lite/tools/benchmark/logging.h"
+
+namespace tflite {
+namespace benchmark {
+
+namespace {
+
+const char kCsvHeader[] =
+    "num_threads,use_nnapi,input_layer_shape,init_us,p50_us,p90_us,p99_us,"
+    "arena_bytes";
+constexpr int kCsvColumns = 8;
+
+std::vector<std::string> Split(const std::string& str, const char delim) {
+  std::istringstream input(str);
+  std::vector<std::string> results;
+  std::string item;
+  while (std::getline(input, item, delim)) {
+    results.push_back(item);
+  }
+  return results;
+}
+
+// The values to sweep a flag over. A single empty value stands for the value
+// of the regular flag.
+std::vector<std::string> SweptValues(const std::string& values, char delim) {
+  if (values.empty()) {
+    return {""};
+  }
+  return Split(values, delim);
+}
+
+// Splits a CSV line into its fields. Fields may be double-quoted, so that
+// they can contain commas, e.g. input shapes.
+bool SplitCsvLine(const std::string& line, std::vector<std::string>* fields) {
+  fields->clear();
+  std::string field;
+  bool in_quotes = false;
+  for (char c : line) {
+    if (c == '"') {
+      in_quotes = !in_quotes;
+    } else if (c == ',' && !in_quotes) {
+      fields->push_back(field);
+      field.clear();
+    } else {
+      field.push_back(c);
+    }
+  }
+  fields->push_back(field);
+  return !in_quotes;
+}
+
+template <typename T>
+bool ParseValue(const std::string& str, T* value) {
+  std::istringstream input(str);
+  input >> *value;
+  return !input.fail() && input.eof();
+}
+
+bool ReadFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  *contents = buffer.str();
+  return true;
+}
+
+// Describes 'value' if it is more than 'max_regression' above 'baseline'.
+void CheckRegression(const std::string& config, const char* what,
+                     int64_t value, int64_t baseline, float max_regression,
+                     std::vector<std::string>* regressions) {
+  if (value > baseline * (1.0f + max_regression)) {
+    std::ostringstream description;
+    description << config << ": " << what << " went from " << baseline
+                << " to " << value;
+    regressions->push_back(description.str());
+  }
+}
+
+}  // namespace
+
+std::string SweepResult::ConfigName() const {
+  std::ostringstream name;
+  name << "num_threads=" << num_threads
+       << " use_nnapi=" << (use_nnapi ? "true" : "false")
+       << " input_layer_shape=" << input_layer_shape;
+  return name.str();
+}
+
+void SweepResultsListener::OnBenchmarkStart(const BenchmarkParams& params) {
+  current_ = SweepResult();
+  if (params.HasParam("num_threads")) {
+    current_.num_threads = params.Get<int32_t>("num_threads");
+  }
+  if (params.HasParam("use_nnapi")) {
+    current_.use_nnapi = params.Get<bool>("use_nnapi");
+  }
+  if (params.HasParam("input_layer_shape")) {
+    current_.input_layer_shape = params.Get<std::string>("input_layer_shape");
+  }
+}
+
+void SweepResultsListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  current_.init_us = results.startup_latency_us();
+  current_.p50_us = results.inference_time_percentile_us(50);
+  current_.p90_us = results.inference_time_percentile_us(90);
+  current_.p99_us = results.inference_time_percentile_us(99);
+  current_.arena_bytes = results.arena_bytes();
+  results_.push_back(current_);
+}
+
+std::string SweepResultsToCsv(const std::vector<SweepResult>& results) {
+  std::ostringstream csv;
+  csv << kCsvHeader << "\n";
+  for (const SweepResult& result : results) {
+    csv << result.num_threads << "," << (result.use_nnapi ? "true" : "false")
+        << ",\"" << result.input_layer_shape << "\"," << result.init_us << ","
+        << result.p50_us << "," << result.p90_us << "," << result.p99_us
+        << "," << result.arena_bytes << "\n";
+  }
+  return csv.str();
+}
+
+bool SweepResultsFromCsv(const std::string& csv,
+                         std::vector<SweepResult>* results) {
+  std::vector<std::string> lines = Split(csv, '\n');
+  if (lines.empty() || lines[0] != kCsvHeader) {
+    return false;
+  }
+  std::vector<std::string> fields;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    if (lines[i].empty()) {
+      continue;
+    }
+    if (!SplitCsvLine(lines[i], &fields) || fields.size() != kCsvColumns) {
+      return false;
+    }
+    SweepResult result;
+    if (fields[1] != "true" && fields[1] != "false") {
+      return false;
+    }
+    result.use_nnapi = fields[1] == "true";
+    result.input_layer_shape = fields[2];
+    if (!ParseValue(fields[0], &result.num_threads) ||
+        !ParseValue(fields[3], &result.init_us) ||
+        !ParseValue(fields[4], &result.p50_us) ||
+        !ParseValue(fields[5], &result.p90_us) ||
+        !ParseValue(fields[6], &result.p99_us) ||
+        !ParseValue(fields[7], &result.arena_bytes)) {
+      return false;
+    }
+    results->push_back(result);
+  }
+  return true;
+}
+
+std::vector<std::string> FindRegressions(
+    const std::vector<SweepResult>& results,
+    const std::vector<SweepResult>& baseline, float max_regression) {
+  std::map<std::string, const SweepResult*> baseline_by_config;
+  for (const SweepResult& result : baseline) {
+    baseline_by_config[result.ConfigName()] = &result;
+  }
+  std::vector<std::string> regressions;
+  for (const SweepResult& result : results) {
+    const std::string config = result.ConfigName();
+    auto it = baseline_by_config.find(config);
+    if (it == baseline_by_config.end()) {
+      TFLITE_LOG(WARN) << "No baseline for " << config;
+      continue;
+    }
+    const SweepResult& base = *it->second;
+    CheckRegression(config, "init_us", result.init_us, base.init_us,
+                    max_regression, &regressions);
+    CheckRegression(config, "p50_us", result.p50_us, base.p50_us,
+                    max_regression, &regressions);
+    CheckRegression(config, "p90_us", result.p90_us, base.p90_us,
+                    max_regression, &regressions);
+    CheckRegression(config, "p99_us", result.p99_us, base.p99_us,
+                    max_regression, &regressions);
+    // The arena size doesn't vary between runs, so any growth is a change.
+    CheckRegression(config, "arena_bytes", result.arena_bytes,
+                    base.arena_bytes, 0.0f, &regressions);
+  }
+  return regressions;
+}
+
+BenchmarkSweep::BenchmarkSweep() : max_regression_(0.1f) {}
+
+std::vector<Flag> BenchmarkSweep::GetFlags() {
+  return {
+      Flag::CreateFlag("sweep_num_threads", &num_threads_,
+                       "comma separated numbers of threads to sweep over"),
+      Flag::CreateFlag("sweep_use_nnapi", &use_nnapi_,
+                       "comma separated use_nnapi values to sweep over, e.g. "
+                       "false,true"),
+      Flag::CreateFlag("sweep_input_layer_shapes", &input_layer_shapes_,
+                       "semicolon separated input_layer_shape values to sweep "
+                       "over"),
+      Flag::CreateFlag("sweep_output", &output_file_,
+                       "file to write the CSV results of the sweep to"),
+      Flag::CreateFlag("sweep_baseline", &baseline_file_,
+                       "CSV results of an earlier sweep to compare with"),
+      Flag::CreateFlag("sweep_max_regression", &max_regression_,
+                       "fraction by which latencies may exceed the baseline "
+                       "before the sweep fails"),
+  };
+}
+
+bool BenchmarkSweep::ParseFlags(int* argc, char** argv) {
+  auto flag_list = GetFlags();
+  // Flags::Parse() also fails on --help, which is left for the benchmark to
+  // handle along with the regular flags.
+  const bool parsed_values_ok =
+      Flags::Parse(argc, const_cast<const char**>(argv), flag_list) ||
+      (*argc >= 2 && std::strcmp(argv[1], "--help") == 0);
+  if (!parsed_values_ok) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flag_list);
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkSweep::IsEnabled() const {
+  return !num_threads_.empty() || !use_nnapi_.empty() ||
+         !input_layer_shapes_.empty();
+}
+
+int BenchmarkSweep::Run(int argc, char** argv) {
+  BenchmarkLoggingListener logging_listener;
+  SweepResultsListener results_listener;
+  for (const std::string& num_threads : SweptValues(num_threads_, ',')) {
+    for (const std::string& use_nnapi : SweptValues(use_nnapi_, ',')) {
+      for (const std::string& input_layer_shape :
+           SweptValues(input_layer_shapes_, ';')) {
+        // Each configuration is benchmarked as if by its own invocation, with
+        // the swept flags appended so that they take precedence.
+        std::vector<std::string> args(argv, argv + argc);
+        if (!num_threads.empty()) {
+          args.push_back("--num_threads=" + num_threads);
+        }
+        if (!use_nnapi.empty()) {
+          args.push_back("--use_nnapi=" + use_nnapi);
+        }
+        if (!input_layer_shape.empty()) {
+          args.push_back("--input_layer_shape=" + input_layer_shape);
+        }
+        std::vector<char*> arg_ptrs;
+        for (std::string& arg : args) {
+          arg_ptrs.push_back(&arg[0]);
+        }
+        arg_ptrs.push_back(nullptr);
+
+        const size_t num_results = results_listener.results().size();
+        BenchmarkTfLiteModel benchmark;
+        benchmark.AddListener(&logging_listener);
+        benchmark.AddListener(&results_listener);
+        benchmark.Run(args.size(), arg_ptrs.data());
+        if (results_listener.results().size() == num_results) {
+          TFLITE_LOG(ERROR) << "Failed to benchmark num_threads=" << num_threads
+                            << " use_nnapi=" << use_nnapi
+                            << " input_layer_shape=" << input_layer_shape;
+          return 1;
+        }
+      }
+    }
+  }
+
+  const std::string csv = SweepResultsToCsv(results_listener.results());
+  TFLITE_LOG(INFO) << "Sweep results:\n" << csv;
+  if (!output_file_.empty()) {
+    std::ofstream output(output_file_);
+    output << csv;
+    if (!output) {
+      TFLITE_LOG(ERROR) << "Failed to write " << output_file_;
+      return 1;
+    }
+  }
+
+  if (baseline_file_.empty()) {
+    return 0;
+  }
+  std::string baseline_csv;
+  std::vector<SweepResult> baseline;
+  if (!ReadFile(baseline_file_, &baseline_csv) ||
+      !SweepResultsFromCsv(baseline_csv, &baseline)) {
+    TFLITE_LOG(ERROR) << "Failed to read the baseline " << baseline_file_;
+    return 1;
+  }
+  const std::vector<std::string> regressions = FindRegressions(
+      results_listener.results(), baseline, max_regression_);
+  for (const std::string& regression : regressions) {
+    TFLITE_LOG(ERROR) << "Regression: " << regression;
+  }
+  if (!regressions.empty()) {
+    return 1;
+  }
+  TFLITE_LOG(INFO) << "No regression from the baseline " << baseline_file_;
+  return 0;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,106 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_LITE_TOOLS_BENCHMARK_BENCHMARK_SWEEP_H_
+#define TENSORFLOW_CONTRIB_LITE_TOOLS_BENCHMARK_BENCHMARK_SWEEP_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/contrib/lite/tools/benchmark/benchmark_model.h"
+#include "tensorflow/contrib/lite/tools/benchmark/command_line_flags.h"
+
+namespace tflite {
+namespace benchmark {
+
+// What a sweep records of the benchmark of one configuration.
+struct SweepResult {
+  int32_t num_threads = 0;
+  bool use_nnapi = false;
+  std::string input_layer_shape;
+  int64_t init_us = 0;
+  int64_t p50_us = 0;
+  int64_t p90_us = 0;
+  int64_t p99_us = 0;
+  uint64_t arena_bytes = 0;
+
+  // Identifies the configuration, to match results with a baseline.
+  std::string ConfigName() const;
+};
+
+// Records a SweepResult for each benchmark it listens to.
+class SweepResultsListener : public BenchmarkListener {
+ public:
+  void OnBenchmarkStart(const BenchmarkParams& params) override;
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+  const std::vector<SweepResult>& results() const { return results_; }
+
+ private:
+  SweepResult current_;
+  std::vector<SweepResult> results_;
+};
+
+// Formats 'results' as CSV, with a header line naming the columns.
+std::string SweepResultsToCsv(const std::vector<SweepResult>& results);
+
+// Parses CSV written by SweepResultsToCsv() into 'results'. Returns false if
+// it is malformed.
+bool SweepResultsFromCsv(const std::string& csv,
+                         std::vector<SweepResult>* results);
+
+// Compares 'results' with the results of the same configurations in
+// 'baseline', and returns a description of each latency that grew by more
+// than 'max_regression', as a fraction of the baseline, and of each arena
+// that grew at all. Configurations missing from the baseline are skipped.
+std::vector<std::string> FindRegressions(
+    const std::vector<SweepResult>& results,
+    const std::vector<SweepResult>& baseline, float max_regression);
+
+// Benchmarks a TFLite model once for each combination of the values given to
+// the sweep flags. Each run takes the regular benchmark flags as given, with
+// the swept ones overridden. The results can be written to a file and are
+// compared with a baseline file written by an earlier sweep, so that the sweep
+// can gate releases.
+class BenchmarkSweep {
+ public:
+  BenchmarkSweep();
+
+  // Parses the sweep flags and removes them from (argc, argv). Returns false
+  // if a value is malformed.
+  bool ParseFlags(int* argc, char** argv);
+
+  // Whether a sweep was requested, i.e. any value to sweep was given.
+  bool IsEnabled() const;
+
+  // Runs the sweep with the remaining regular benchmark flags. Returns 0 on
+  // success, and 1 if a configuration failed or regressed from the baseline.
+  int Run(int argc, char** argv);
+
+ private:
+  std::vector<Flag> GetFlags();
+
+  std::string num_threads_;
+  std::string use_nnapi_;
+  std::string input_layer_shapes_;
+  std::string output_file_;
+  std::string baseline_file_;
+  float max_regression_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_CONTRIB_LITE_TOOLS_BENCHMARK_BENCHMARK_SWEEP_H_
@@ -0,0 +1,123 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/lite/tools/benchmark/benchmark_sweep.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/contrib/lite/testing/util.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+SweepResult MakeResult(int32_t num_threads, bool use_nnapi,
+                       const std::string& input_layer_shape, int64_t p50_us,
+                       uint64_t arena_bytes) {
+  SweepResult result;
+  result.num_threads = num_threads;
+  result.use_nnapi = use_nnapi;
+  result.input_layer_shape = input_layer_shape;
+  result.init_us = 1000;
+  result.p50_us = p50_us;
+  result.p90_us = p50_us + 10;
+  result.p99_us = p50_us + 20;
+  result.arena_bytes = arena_bytes;
+  return result;
+}
+
+TEST(BenchmarkSweepTest, InferenceTimePercentiles) {
+  tensorflow::Stat<int64_t> inference_time_us;
+  BenchmarkResults results(0, 0, inference_time_us, inference_time_us,
+                           {50, 10, 40, 20, 30, 100, 70, 90, 60, 80}, 0);
+  EXPECT_EQ(results.inference_time_percentile_us(50), 50);
+  EXPECT_EQ(results.inference_time_percentile_us(90), 90);
+  EXPECT_EQ(results.inference_time_percentile_us(99), 100);
+  EXPECT_EQ(results.inference_time_percentile_us(0), 10);
+
+  BenchmarkResults no_runs(0, 0, inference_time_us, inference_time_us);
+  EXPECT_EQ(no_runs.inference_time_percentile_us(50), 0);
+}
+
+TEST(BenchmarkSweepTest, CsvRoundTrip) {
+  std::vector<SweepResult> results = {
+      MakeResult(1, false, "1,224,224,3", 500, 4096),
+      MakeResult(4, true, "1,8:1,16", 200, 8192),
+  };
+  std::string csv = SweepResultsToCsv(results);
+  EXPECT_THAT(csv, HasSubstr("4,true,\"1,8:1,16\",1000,200,210,220,8192\n"));
+
+  std::vector<SweepResult> parsed;
+  ASSERT_TRUE(SweepResultsFromCsv(csv, &parsed));
+  ASSERT_EQ(parsed.size(), 2);
+  for (size_t i = 0; i < parsed.size(); ++i) {
+    EXPECT_EQ(parsed[i].ConfigName(), results[i].ConfigName());
+    EXPECT_EQ(parsed[i].init_us, results[i].init_us);
+    EXPECT_EQ(parsed[i].p50_us, results[i].p50_us);
+    EXPECT_EQ(parsed[i].p90_us, results[i].p90_us);
+    EXPECT_EQ(parsed[i].p99_us, results[i].p99_us);
+    EXPECT_EQ(parsed[i].arena_bytes, results[i].arena_bytes);
+  }
+}
+
+TEST(BenchmarkSweepTest, MalformedCsv) {
+  std::string csv = SweepResultsToCsv({MakeResult(1, false, "", 500, 4096)});
+  std::vector<SweepResult> parsed;
+  EXPECT_FALSE(SweepResultsFromCsv("", &parsed));
+  EXPECT_FALSE(SweepResultsFromCsv(csv.substr(csv.find('\n') + 1), &parsed));
+  EXPECT_FALSE(SweepResultsFromCsv(csv + "1,false,\"\",1000,x,0,0,0\n",
+                                   &parsed));
+  EXPECT_FALSE(SweepResultsFromCsv(csv + "1,maybe,\"\",1,1,1,1,1\n", &parsed));
+  EXPECT_FALSE(SweepResultsFromCsv(csv + "1,false,\"\"\n", &parsed));
+}
+
+TEST(BenchmarkSweepTest, FindRegressions) {
+  std::vector<SweepResult> baseline = {
+      MakeResult(1, false, "", 1000, 4096),
+      MakeResult(2, false, "", 600, 4096),
+  };
+  // Within the tolerance, or for a configuration without a baseline.
+  EXPECT_THAT(FindRegressions({MakeResult(1, false, "", 1090, 4096),
+                               MakeResult(2, false, "", 500, 2048),
+                               MakeResult(4, false, "", 9000, 4096)},
+                              baseline, 0.1f),
+              IsEmpty());
+
+  std::vector<std::string> regressions =
+      FindRegressions({MakeResult(1, false, "", 1200, 4096),
+                       MakeResult(2, false, "", 600, 4100)},
+                      baseline, 0.1f);
+  EXPECT_THAT(
+      regressions,
+      ElementsAre(
+          HasSubstr("num_threads=1 use_nnapi=false input_layer_shape=: "
+                    "p50_us went from 1000 to 1200"),
+          HasSubstr("p90_us"), HasSubstr("p99_us"),
+          HasSubstr("num_threads=2 use_nnapi=false input_layer_shape=: "
+                    "arena_bytes went from 4096 to 4100")));
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -42,6 +42,12 @@ void ProfilingListener::SetInterpreter(tflite::Interpreter* interpreter) {
   interpreter_->SetProfiler(&profiler_);
 }
 
+void ProfilingListener::EnableHardwareCounters() {
+  if (!profiler_.EnableHardwareCounters()) {
+    TFLITE_LOG(WARN) << "Hardware counters are unavailable.";
+  }
+}
+
 void ProfilingListener::OnSingleRunStart(RunType run_type) {
   if (run_type == REGULAR) {
     profiler_.Reset();
@@ -170,6 +176,8 @@ BenchmarkParams GetDefaultParams() {
   default_params.AddParam("input_layer_shape",
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("use_nnapi", BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("enable_hardware_counters",
+                          BenchmarkParam::Create<bool>(false));
   return default_params;
 }
 
@@ -192,7 +200,10 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<std::string>("input_layer", &params_, "input layer names"),
       CreateFlag<std::string>("input_layer_shape", &params_,
                               "input layer shape"),
-      CreateFlag<bool>("use_nnapi", &params_, "use nnapi api")};
+      CreateFlag<bool>("use_nnapi", &params_, "use nnapi api"),
+      CreateFlag<bool>("enable_hardware_counters", &params_,
+                       "count cpu cycles, instructions and cache misses of "
+                       "each op when profiling")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
   return flags;
@@ -206,6 +217,8 @@ void BenchmarkTfLiteModel::LogParams() {
   TFLITE_LOG(INFO) << "Input shapes: ["
                    << params_.Get<std::string>("input_layer_shape") << "]";
   TFLITE_LOG(INFO) << "Use nnapi : [" << params_.Get<bool>("use_nnapi") << "]";
+  TFLITE_LOG(INFO) << "Enable hardware counters : ["
+                   << params_.Get<bool>("enable_hardware_counters") << "]";
 }
 
 bool BenchmarkTfLiteModel::ValidateParams() {
@@ -229,6 +242,17 @@ uint64_t BenchmarkTfLiteModel::ComputeInputBytes() {
   return total_input_bytes;
 }
 
+uint64_t BenchmarkTfLiteModel::ComputeArenaBytes() {
+  TFLITE_BENCHMARK_CHECK(interpreter);
+  size_t planned_bytes = 0;
+  size_t lower_bound_bytes = 0;
+  if (interpreter->GetArenaSizes(&planned_bytes, &lower_bound_bytes) !=
+      kTfLiteOk) {
+    return 0;
+  }
+  return planned_bytes;
+}
+
 void BenchmarkTfLiteModel::Init() {
   std::string graph = params_.Get<std::string>("graph");
   model = tflite::FlatBufferModel::BuildFromFile(graph.c_str());
@@ -251,6 +275,9 @@ void BenchmarkTfLiteModel::Init() {
     TFLITE_LOG(FATAL) << "Failed to construct interpreter";
   }
   profiling_listener_.SetInterpreter(interpreter.get());
+  if (params_.Get<bool>("enable_hardware_counters")) {
+    profiling_listener_.EnableHardwareCounters();
+  }
 
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
 
@@ -34,6 +34,10 @@ class ProfilingListener : public BenchmarkListener {
 
   void SetInterpreter(Interpreter* interpreter);
 
+  // Also count CPU cycles, instructions and cache misses of each op. Must be
+  // called on the thread running the benchmark.
+  void EnableHardwareCounters();
+
   void OnSingleRunStart(RunType run_type) override;
 
   void OnSingleRunEnd() override;
@@ -57,6 +61,7 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   void LogParams() override;
   bool ValidateParams() override;
   uint64_t ComputeInputBytes() override;
+  uint64_t ComputeArenaBytes() override;
   void Init() override;
   void RunImpl() override;
   virtual ~BenchmarkTfLiteModel() {}
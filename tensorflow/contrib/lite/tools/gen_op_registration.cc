@@ -12,6 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -22,6 +25,16 @@ limitations under the License.
 namespace tflite {
 
 string NormalizeCustomOpName(const string& op) {
+  // The custom ops of kernels/register.cc whose registration functions don't
+  // follow the convention.
+  static const auto* const kBuiltinCustomOps = new std::map<string, string>({
+      {"TFLite_Detection_PostProcess", "DETECTION_POSTPROCESS"},
+      {"TFLite_DepthwiseConvPointwiseConv", "DEPTHWISE_POINTWISE_CONV"},
+  });
+  auto it = kBuiltinCustomOps->find(op);
+  if (it != kBuiltinCustomOps->end()) {
+    return it->second;
+  }
   string method(op);
   RE2::GlobalReplace(&method, "([a-z])([A-Z])", "\\1_\\2");
   std::transform(method.begin(), method.end(), method.begin(), ::toupper);
@@ -44,4 +57,68 @@ void ReadOpsFromModel(const ::tflite::Model* model,
   }
 }
 
+void ReadOpsFromModel(const ::tflite::Model* model,
+                      std::map<string, int>* builtin_ops,
+                      std::map<string, int>* custom_ops) {
+  if (!model) return;
+  auto opcodes = model->operator_codes();
+  if (!opcodes) return;
+  for (const auto* opcode : *opcodes) {
+    int* version;
+    if (opcode->builtin_code() != ::tflite::BuiltinOperator_CUSTOM) {
+      version = &(*builtin_ops)[tflite::EnumNameBuiltinOperator(
+          opcode->builtin_code())];
+    } else {
+      version = &(*custom_ops)[opcode->custom_code()->c_str()];
+    }
+    *version = std::max(*version, opcode->version());
+  }
+}
+
+string GenerateRegistrationSource(const string& tflite_path,
+                                  const std::map<string, int>& builtin_ops,
+                                  const std::map<string, int>& custom_ops) {
+  std::ostringstream out;
+  out << "#include \"" << tflite_path << "/model.h\"\n";
+  out << "#include \"" << tflite_path << "/op_resolver.h\"\n";
+
+  out << "namespace tflite {\n";
+  out << "namespace ops {\n";
+  if (!builtin_ops.empty()) {
+    out << "namespace builtin {\n";
+    out << "// Forward-declarations for the builtin ops.\n";
+    for (const auto& op : builtin_ops) {
+      out << "TfLiteRegistration* Register_" << op.first << "();\n";
+    }
+    out << "}  // namespace builtin\n";
+  }
+
+  if (!custom_ops.empty()) {
+    out << "namespace custom {\n";
+    out << "// Forward-declarations for the custom ops.\n";
+    for (const auto& op : custom_ops) {
+      out << "TfLiteRegistration* Register_" << NormalizeCustomOpName(op.first)
+          << "();\n";
+    }
+    out << "}  // namespace custom\n";
+  }
+  out << "}  // namespace ops\n";
+  out << "}  // namespace tflite\n";
+
+  out << "void RegisterSelectedOps(::tflite::MutableOpResolver* resolver) {\n";
+  for (const auto& op : builtin_ops) {
+    out << "  resolver->AddBuiltin(::tflite::BuiltinOperator_" << op.first
+        << ", ::tflite::ops::builtin::Register_" << op.first << "(), 1, "
+        << op.second << ");\n";
+  }
+  for (const auto& op : custom_ops) {
+    out << "  resolver->AddCustom(\"" << op.first
+        << "\", ::tflite::ops::custom::Register_"
+        << NormalizeCustomOpName(op.first) << "(), 1, " << op.second
+        << ");\n";
+  }
+  out << "}\n";
+  return out.str();
+}
+
 }  // namespace tflite
@@ -15,6 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CONTRIB_LITE_TOOLS_GEN_OP_REGISTRATION_H_
 #define TENSORFLOW_CONTRIB_LITE_TOOLS_GEN_OP_REGISTRATION_H_
 
+#include <map>
+#include <vector>
+
 #include "tensorflow/contrib/lite/model.h"
 #include "tensorflow/contrib/lite/string.h"
 
@@ -25,6 +28,9 @@ namespace tflite {
 //   "custom_op" -> "CUSTOM_OP"
 //   "CustomOp" -> "CUSTOM_OP"
 // Note "Register_" suffix will be added later in the tool.
+// The custom ops registered by the BuiltinOpResolver keep the names of their
+// registration functions, e.g.
+//   "TFLite_Detection_PostProcess" -> "DETECTION_POSTPROCESS"
 string NormalizeCustomOpName(const string& op);
 
 // Read ops from the TFLite model.
@@ -34,6 +40,19 @@ void ReadOpsFromModel(const ::tflite::Model* model,
                       std::vector<string>* builtin_ops,
                       std::vector<string>* custom_ops);
 
+// Read ops from the TFLite model, adding them to the ops read from other
+// models, along with the highest version of each op that the models use.
+void ReadOpsFromModel(const ::tflite::Model* model,
+                      std::map<string, int>* builtin_ops,
+                      std::map<string, int>* custom_ops);
+
+// Generate the source of a RegisterSelectedOps() function, which registers
+// the given ops, up to the given versions, with a MutableOpResolver.
+// 'tflite_path' is the path of the TF Lite dir in includes.
+string GenerateRegistrationSource(const string& tflite_path,
+                                  const std::map<string, int>& builtin_ops,
+                                  const std::map<string, int>& custom_ops);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_CONTRIB_LITE_TOOLS_GEN_OP_REGISTRATION_H_
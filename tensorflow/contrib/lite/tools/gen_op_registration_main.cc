@@ -20,12 +20,14 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_split.h"
 #include "absl/strings/strip.h"
 #include "tensorflow/contrib/lite/tools/gen_op_registration.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/util/command_line_flags.h"
 
 const char kInputModelFlag[] = "input_model";
+const char kInputModelsFlag[] = "input_models";
 const char kOutputRegistrationFlag[] = "output_registration";
 const char kTfLitePathFlag[] = "tflite_path";
 
@@ -34,9 +36,13 @@ using tensorflow::Flags;
 using tensorflow::string;
 
 void ParseFlagAndInit(int argc, char** argv, string* input_model,
-                      string* output_registration, string* tflite_path) {
+                      string* input_models, string* output_registration,
+                      string* tflite_path) {
   std::vector<tensorflow::Flag> flag_list = {
       Flag(kInputModelFlag, input_model, "path to the tflite model"),
+      Flag(kInputModelsFlag, input_models,
+           "comma separated paths to tflite models, to register the ops of "
+           "all of them"),
       Flag(kOutputRegistrationFlag, output_registration,
            "filename for generated registration code"),
       Flag(kTfLitePathFlag, tflite_path, "Path to tensorflow lite dir"),
@@ -46,72 +52,33 @@ void ParseFlagAndInit(int argc, char** argv, string* input_model,
   tensorflow::port::InitMain(argv[0], &argc, &argv);
 }
 
-namespace {
-
-void GenerateFileContent(const std::string& tflite_path,
-                         const std::string& filename,
-                         const std::vector<string>& builtin_ops,
-                         const std::vector<string>& custom_ops) {
-  std::ofstream fout(filename);
-
-  fout << "#include \"" << tflite_path << "/model.h\"\n";
-  fout << "#include \"" << tflite_path << "/op_resolver.h\"\n";
-
-  fout << "namespace tflite {\n";
-  fout << "namespace ops {\n";
-  if (!builtin_ops.empty()) {
-    fout << "namespace builtin {\n";
-    fout << "// Forward-declarations for the builtin ops.\n";
-    for (const auto& op : builtin_ops) {
-      fout << "TfLiteRegistration* Register_" << op << "();\n";
-    }
-    fout << "}  // namespace builtin\n";
-  }
-
-  if (!custom_ops.empty()) {
-    fout << "namespace custom {\n";
-    fout << "// Forward-declarations for the custom ops.\n";
-    for (const auto& op : custom_ops) {
-      fout << "TfLiteRegistration* Register_"
-           << ::tflite::NormalizeCustomOpName(op) << "();\n";
-    }
-    fout << "}  // namespace custom\n";
-  }
-  fout << "}  // namespace ops\n";
-  fout << "}  // namespace tflite\n";
-
-  fout << "void RegisterSelectedOps(::tflite::MutableOpResolver* resolver) {\n";
-  for (const auto& op : builtin_ops) {
-    fout << "  resolver->AddBuiltin(::tflite::BuiltinOperator_" << op
-         << ", ::tflite::ops::builtin::Register_" << op << "());\n";
-  }
-  for (const auto& op : custom_ops) {
-    fout << "  resolver->AddCustom(\"" << op
-         << "\", ::tflite::ops::custom::Register_"
-         << ::tflite::NormalizeCustomOpName(op) << "());\n";
-  }
-  fout << "}\n";
-  fout.close();
-}
-}  // namespace
-
 int main(int argc, char** argv) {
   string input_model;
+  string input_models;
   string output_registration;
   string tflite_path;
-  ParseFlagAndInit(argc, argv, &input_model, &output_registration,
-                   &tflite_path);
+  ParseFlagAndInit(argc, argv, &input_model, &input_models,
+                   &output_registration, &tflite_path);
 
-  std::vector<string> builtin_ops;
-  std::vector<string> custom_ops;
-  std::ifstream fin(input_model);
-  std::stringstream content;
-  content << fin.rdbuf();
-  // Need to store content data first, otherwise, it won't work in bazel.
-  string content_str = content.str();
-  const ::tflite::Model* model = ::tflite::GetModel(content_str.data());
-  ::tflite::ReadOpsFromModel(model, &builtin_ops, &custom_ops);
-  GenerateFileContent(tflite_path, output_registration, builtin_ops,
-                      custom_ops);
+  std::vector<string> model_paths =
+      absl::StrSplit(input_models, ',', absl::SkipEmpty());
+  if (!input_model.empty()) {
+    model_paths.push_back(input_model);
+  }
+  std::map<string, int> builtin_ops;
+  std::map<string, int> custom_ops;
+  for (const string& model_path : model_paths) {
+    std::ifstream fin(model_path);
+    std::stringstream content;
+    content << fin.rdbuf();
+    // Need to store content data first, otherwise, it won't work in bazel.
+    string content_str = content.str();
+    const ::tflite::Model* model = ::tflite::GetModel(content_str.data());
+    ::tflite::ReadOpsFromModel(model, &builtin_ops, &custom_ops);
+  }
+  std::ofstream fout(output_registration);
+  fout << ::tflite::GenerateRegistrationSource(tflite_path, builtin_ops,
+                                               custom_ops);
+  fout.close();
   return 0;
 }
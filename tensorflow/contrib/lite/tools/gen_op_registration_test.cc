@@ -17,7 +17,10 @@ limitations under the License.
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+using ::testing::Pair;
 
 namespace tflite {
 
@@ -32,8 +35,18 @@ class GenOpRegistrationTest : public ::testing::Test {
     }
   }
 
+  void ReadOpVersions(const string& model_path) {
+    auto model = FlatBufferModel::BuildFromFile(model_path.data());
+    if (model) {
+      ReadOpsFromModel(model->GetModel(), &builtin_op_versions_,
+                       &custom_op_versions_);
+    }
+  }
+
   std::vector<string> builtin_ops_;
   std::vector<string> custom_ops_;
+  std::map<string, int> builtin_op_versions_;
+  std::map<string, int> custom_op_versions_;
 };
 
 TEST_F(GenOpRegistrationTest, TestNonExistantFiles) {
@@ -48,6 +61,14 @@ TEST_F(GenOpRegistrationTest, TestModels) {
   EXPECT_THAT(custom_ops_, ElementsAreArray({"testing_op"}));
 }
 
+TEST_F(GenOpRegistrationTest, TestOpVersionsOfModels) {
+  ReadOpVersions("tensorflow/contrib/lite/testdata/test_model.bin");
+  ReadOpVersions("tensorflow/contrib/lite/testdata/test_model.bin");
+  ReadOpVersions("tensorflow/contrib/lite/testdata/empty_model.bin");
+  EXPECT_THAT(builtin_op_versions_, ElementsAre(Pair("CONV_2D", 1)));
+  EXPECT_THAT(custom_op_versions_, ElementsAre(Pair("testing_op", 1)));
+}
+
 TEST_F(GenOpRegistrationTest, TestEmptyModels) {
   ReadOps("tensorflow/contrib/lite/testdata/empty_model.bin");
   EXPECT_EQ(builtin_ops_.size(), 0);
@@ -72,12 +93,33 @@ TEST_F(GenOpRegistrationTest, TestNormalizeCustomOpName) {
       {"a", "A"},
       {"custom_op", "CUSTOM_OP"},
       {"customop", "CUSTOMOP"},
+      {"TFLite_Detection_PostProcess", "DETECTION_POSTPROCESS"},
   };
 
   for (const auto& test : testcase) {
     EXPECT_EQ(NormalizeCustomOpName(test.first), test.second);
   }
 }
+
+TEST_F(GenOpRegistrationTest, TestGenerateRegistrationSource) {
+  string source = GenerateRegistrationSource(
+      "tensorflow/contrib/lite", {{"CONV_2D", 3}, {"ADD", 1}},
+      {{"CustomOp", 2}});
+  EXPECT_THAT(source,
+              HasSubstr("#include \"tensorflow/contrib/lite/op_resolver.h\""));
+  EXPECT_THAT(source, HasSubstr("TfLiteRegistration* Register_CONV_2D();"));
+  EXPECT_THAT(source, HasSubstr("TfLiteRegistration* Register_CUSTOM_OP();"));
+  EXPECT_THAT(source,
+              HasSubstr("resolver->AddBuiltin(::tflite::BuiltinOperator_ADD, "
+                        "::tflite::ops::builtin::Register_ADD(), 1, 1);"));
+  EXPECT_THAT(
+      source,
+      HasSubstr("resolver->AddBuiltin(::tflite::BuiltinOperator_CONV_2D, "
+                "::tflite::ops::builtin::Register_CONV_2D(), 1, 3);"));
+  EXPECT_THAT(source, HasSubstr("resolver->AddCustom(\"CustomOp\", "
+                                "::tflite::ops::custom::Register_CUSTOM_OP(), "
+                                "1, 2);"));
+}
 }  // namespace tflite
 
 int main(int argc, char** argv) {
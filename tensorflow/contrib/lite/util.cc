@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/lite/util.h"
 
+#include <algorithm>
+
 namespace tflite {
 
 TfLiteIntArray* ConvertVectorToTfLiteIntArray(const std::vector<int>& input) {
@@ -48,4 +50,38 @@ size_t CombineHashes(std::initializer_list<size_t> hashes) {
   return result;
 }
 
+void BlockSparseEncode(const float* dense, int rows, int cols, int block_size,
+                       std::vector<int>* row_segments,
+                       std::vector<int>* block_indices,
+                       std::vector<float>* values) {
+  row_segments->assign(1, 0);
+  block_indices->clear();
+  values->clear();
+  for (int r = 0; r < rows; ++r) {
+    const float* row = dense + r * cols;
+    for (int c = 0; c < cols; c += block_size) {
+      const float* block = row + c;
+      if (std::all_of(block, block + block_size,
+                      [](float value) { return value == 0.0f; })) {
+        continue;
+      }
+      block_indices->push_back(c / block_size);
+      values->insert(values->end(), block, block + block_size);
+    }
+    row_segments->push_back(block_indices->size());
+  }
+}
+
+void BlockSparseDecode(const float* values, int block_size,
+                       const int* row_segments, const int* block_indices,
+                       int rows, int cols, float* dense) {
+  std::fill(dense, dense + rows * cols, 0.0f);
+  for (int r = 0; r < rows; ++r) {
+    for (int i = row_segments[r]; i < row_segments[r + 1]; ++i) {
+      std::copy(values + i * block_size, values + (i + 1) * block_size,
+                dense + r * cols + block_indices[i] * block_size);
+    }
+  }
+}
+
 }  // namespace tflite
@@ -42,6 +42,21 @@ bool EqualArrayAndTfLiteIntArray(const TfLiteIntArray* a, const int b_size,
 
 size_t CombineHashes(std::initializer_list<size_t> hashes);
 
+// Encodes the row-major matrix `dense` of shape [rows, cols] in block
+// compressed sparse row format, see TfLiteSparsity: `values` gets the blocks
+// of `block_size` values that hold a nonzero value. `cols` must be a multiple
+// of `block_size`.
+void BlockSparseEncode(const float* dense, int rows, int cols, int block_size,
+                       std::vector<int>* row_segments,
+                       std::vector<int>* block_indices,
+                       std::vector<float>* values);
+
+// Decodes the blocks `values` of a matrix of shape [rows, cols] encoded by
+// BlockSparseEncode() into the row-major matrix `dense`.
+void BlockSparseDecode(const float* values, int block_size,
+                       const int* row_segments, const int* block_indices,
+                       int rows, int cols, float* dense);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_CONTRIB_LITE_UTIL_H_
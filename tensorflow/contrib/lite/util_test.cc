@@ -41,6 +41,28 @@ TEST(ConvertVectorToTfLiteIntArray, TestWithEmptyVector) {
   TfLiteIntArrayFree(output);
 }
 
+TEST(BlockSparse, EncodeAndDecode) {
+  // clang-format off
+  std::vector<float> dense = {
+      0, 0, 1, 2, 0, 0,
+      0, 0, 0, 0, 0, 0,
+      3, 0, 0, 0, 0, 4,
+  };
+  // clang-format on
+  std::vector<int> row_segments, block_indices;
+  std::vector<float> values;
+  BlockSparseEncode(dense.data(), 3, 6, 2, &row_segments, &block_indices,
+                    &values);
+  EXPECT_THAT(row_segments, ::testing::ElementsAre(0, 1, 1, 3));
+  EXPECT_THAT(block_indices, ::testing::ElementsAre(1, 0, 2));
+  EXPECT_THAT(values, ::testing::ElementsAre(1, 2, 3, 0, 0, 4));
+
+  std::vector<float> decoded(dense.size(), -1);
+  BlockSparseDecode(values.data(), 2, row_segments.data(),
+                    block_indices.data(), 3, 6, decoded.data());
+  EXPECT_EQ(decoded, dense);
+}
+
 }  // namespace
 }  // namespace tflite
 
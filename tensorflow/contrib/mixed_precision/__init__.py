@@ -19,6 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 # pylint: disable=unused-import,wildcard-import
+from tensorflow.contrib.mixed_precision.python.auto_mixed_precision import *
 from tensorflow.contrib.mixed_precision.python.loss_scale_manager import *
 from tensorflow.contrib.mixed_precision.python.loss_scale_optimizer import *
 
@@ -29,6 +30,7 @@ _allowed_symbols = [
     "FixedLossScaleManager",
     "ExponentialUpdateLossScaleManager",
     "LossScaleOptimizer",
+    "enable_auto_mixed_precision",
 ]
 
 remove_undocumented(__name__, _allowed_symbols)
@@ -0,0 +1,64 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Automatic mixed precision training."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.mixed_precision.python import loss_scale_manager as lsm_lib
+from tensorflow.contrib.mixed_precision.python import loss_scale_optimizer as lso
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.core.protobuf import rewriter_config_pb2
+
+
+def enable_auto_mixed_precision(opt, config=None, loss_scale_manager=None):
+  """Enables the automatic mixed precision graph rewrite for training.
+
+  The rewrite converts the float32 ops placed on GPUs with Tensor Cores to
+  float16 where it is numerically safe, and inserts the casts this requires.
+  Gradients computed in float16 may underflow, so the returned optimizer also
+  scales the loss, by default with a dynamic loss scale that grows while the
+  gradients stay finite and shrinks when they overflow.
+
+  Example:
+
+  ```python
+  opt, config = tf.contrib.mixed_precision.enable_auto_mixed_precision(
+      tf.train.MomentumOptimizer(0.1, 0.9))
+  train_op = opt.minimize(loss)
+  with tf.Session(config=config) as sess:
+    ...
+  ```
+
+  Args:
+    opt: The `Optimizer` to wrap.
+    config: An optional `ConfigProto` to enable the rewrite in. It is not
+      modified.
+    loss_scale_manager: An optional `LossScaleManager`. Defaults to an
+      `ExponentialUpdateLossScaleManager`.
+
+  Returns:
+    A pair of a `LossScaleOptimizer` wrapping `opt`, and a copy of `config`
+    that enables the rewrite, to create the training session with.
+  """
+  if loss_scale_manager is None:
+    loss_scale_manager = lsm_lib.ExponentialUpdateLossScaleManager(
+        init_loss_scale=2**15, incr_every_n_steps=2000)
+  new_config = config_pb2.ConfigProto()
+  if config is not None:
+    new_config.CopyFrom(config)
+  new_config.graph_options.rewrite_options.auto_mixed_precision = (
+      rewriter_config_pb2.RewriterConfig.ON)
+  return lso.LossScaleOptimizer(opt, loss_scale_manager), new_config
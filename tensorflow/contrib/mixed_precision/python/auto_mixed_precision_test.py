@@ -0,0 +1,53 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for enable_auto_mixed_precision."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.mixed_precision.python import auto_mixed_precision
+from tensorflow.contrib.mixed_precision.python import loss_scale_manager as lsm_lib
+from tensorflow.contrib.mixed_precision.python import loss_scale_optimizer as lso
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.core.protobuf import rewriter_config_pb2
+from tensorflow.python.platform import test
+from tensorflow.python.training import gradient_descent as gd
+
+
+class AutoMixedPrecisionTest(test.TestCase):
+
+  def testEnablesRewrite(self):
+    config = config_pb2.ConfigProto(allow_soft_placement=True)
+    opt, new_config = auto_mixed_precision.enable_auto_mixed_precision(
+        gd.GradientDescentOptimizer(1.0), config)
+    self.assertIsInstance(opt, lso.LossScaleOptimizer)
+    self.assertTrue(new_config.allow_soft_placement)
+    self.assertEqual(rewriter_config_pb2.RewriterConfig.ON,
+                     new_config.graph_options.rewrite_options
+                     .auto_mixed_precision)
+    # The config passed in is left alone.
+    self.assertEqual(rewriter_config_pb2.RewriterConfig.DEFAULT,
+                     config.graph_options.rewrite_options.auto_mixed_precision)
+
+  def testLossScaleManager(self):
+    manager = lsm_lib.FixedLossScaleManager(128)
+    opt, _ = auto_mixed_precision.enable_auto_mixed_precision(
+        gd.GradientDescentOptimizer(1.0), loss_scale_manager=manager)
+    self.assertIs(manager, opt._loss_scale_manager)  # pylint: disable=protected-access
+
+
+if __name__ == "__main__":
+  test.main()
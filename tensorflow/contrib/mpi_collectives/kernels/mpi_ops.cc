@@ -21,8 +21,13 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 
 #define EIGEN_USE_THREADS
 
@@ -70,6 +75,20 @@ limitations under the License.
  *          the tensor on the first dimension across all MPI processes in the
  *          global communicator.
  *
+ * The ops are configured with environment variables:
+ *      – TF_MPI_FUSION_THRESHOLD_BYTES (default 64 MiB):
+ *          Allreduces of tensors of the same type and device that become
+ *          ready in the same tick are fused into a single allreduce of up to
+ *          this many bytes. 0 disables fusion.
+ *      – TF_MPI_CUDA_AWARE (default true):
+ *          Whether the MPI library can send and receive GPU memory, e.g.
+ *          through GPUDirect RDMA. If false, GPU tensors are reduced and
+ *          gathered in pinned host memory.
+ *      – TF_MPI_TIMELINE:
+ *          If set, rank zero writes to this file a timeline of when each
+ *          tensor was negotiated and reduced or gathered, in the Chrome trace
+ *          format (see chrome://tracing).
+ *
  */
 
 template <class T>
@@ -174,6 +193,66 @@ struct CollectiveOpRecord {
 // This table contains everything necessary to do the reduction
 typedef std::unordered_map<std::string, CollectiveOpRecord> TensorTable;
 
+// Records on rank zero when each tensor was negotiated (from the first rank
+// requesting it until all ranks have) and reduced or gathered, in the Chrome
+// trace event format. Each tensor gets its own row. Only used by the
+// background thread.
+class MPITimeline {
+ public:
+  // Starts writing to "path".
+  Status Initialize(const string& path) {
+    TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(path, &file_));
+    start_micros_ = Env::Default()->NowMicros();
+    return file_->Append("[\n");
+  }
+
+  bool Enabled() const { return file_ != nullptr; }
+
+  void NegotiateStart(const string& tensor_name) {
+    negotiate_start_micros_[tensor_name] = Env::Default()->NowMicros();
+  }
+
+  void NegotiateEnd(const string& tensor_name) {
+    auto it = negotiate_start_micros_.find(tensor_name);
+    if (it == negotiate_start_micros_.end()) return;
+    WriteEvent(tensor_name, "NEGOTIATE", it->second);
+    negotiate_start_micros_.erase(it);
+  }
+
+  // Records that "activity" ran on "tensor_name" from "start_micros" until
+  // now.
+  void WriteEvent(const string& tensor_name, const string& activity,
+                  int64 start_micros) {
+    const int64 now_micros = Env::Default()->NowMicros();
+    auto inserted = tensor_ids_.emplace(tensor_name, tensor_ids_.size());
+    const int tid = inserted.first->second;
+    string event;
+    if (inserted.second) {
+      strings::StrAppend(&event,
+                         "{\"name\": \"thread_name\", \"ph\": \"M\", "
+                         "\"pid\": 0, \"tid\": ",
+                         tid, ", \"args\": {\"name\": \"", tensor_name,
+                         "\"}},\n");
+    }
+    strings::StrAppend(&event, "{\"name\": \"", activity,
+                       "\", \"ph\": \"X\", \"pid\": 0, \"tid\": ", tid,
+                       ", \"ts\": ", start_micros - start_micros_,
+                       ", \"dur\": ", now_micros - start_micros, "},\n");
+    Status s = file_->Append(event);
+    if (s.ok()) s = file_->Flush();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to write the MPI timeline: " << s;
+      file_.reset();
+    }
+  }
+
+ private:
+  std::unique_ptr<WritableFile> file_;
+  int64 start_micros_ = 0;
+  std::unordered_map<string, int> tensor_ids_;
+  std::unordered_map<string, int64> negotiate_start_micros_;
+};
+
 // Table for storing Tensor metadata on rank zero. This is used for error
 // checking and size calculations, as well as determining when a reduction is
 // ready to be done (when all nodes are ready to do it).
@@ -228,6 +307,14 @@ struct MPIGlobalState {
   // The device that MPI was initialized on. (-1 for no GPU)
   int device = -1;
 
+  // Set by the environment variables documented at the top of this file.
+  int64 fusion_threshold_bytes = 64 << 20;
+  bool cuda_aware = true;
+  string timeline_path;
+
+  // Only written on the coordinator node, if timeline_path is not empty.
+  MPITimeline timeline;
+
   // The CUDA stream used for data transfers and within-allreduce operations.
   // A naive implementation would use the TensorFlow StreamExecutor CUDA
   // stream. However, the allreduce and allgather require doing memory copies
@@ -277,14 +364,38 @@ bool IncrementTensorCount(std::unique_ptr<MessageTable>& message_table,
   if (table_iter == message_table->end()) {
     message_table->emplace(name, std::vector<MPIRequest>({msg}));
     table_iter = message_table->find(name);
+    if (mpi_global.timeline.Enabled()) {
+      mpi_global.timeline.NegotiateStart(name);
+    }
   } else {
     table_iter->second.push_back(msg);
   }
 
   int count = table_iter->second.size();
+  if (count == mpi_size && mpi_global.timeline.Enabled()) {
+    mpi_global.timeline.NegotiateEnd(name);
+  }
   return count == mpi_size;
 }
 
+// Returns the number of bytes of the tensor that "requests" (the requests
+// of all ranks for one tensor) allreduce, or -1 if the ranks do not agree on
+// its type, shape or device, in which case it is not fused.
+int64 FusableBytes(const std::vector<MPIRequest>& requests) {
+  const MPIRequest& first = requests[0];
+  for (const MPIRequest& request : requests) {
+    if (request.request_type() != MPIRequest::ALLREDUCE ||
+        request.tensor_type() != first.tensor_type() ||
+        request.on_gpu() != first.on_gpu() ||
+        TensorShape(request.tensor_shape()) !=
+            TensorShape(first.tensor_shape())) {
+      return -1;
+    }
+  }
+  return TensorShape(first.tensor_shape()).num_elements() *
+         DataTypeSize(first.tensor_type());
+}
+
 // Once a tensor is ready to be reduced, the coordinator sends an MPIResponse
 // instructing all ranks to start the reduction to all ranks. The MPIResponse
 // also contains error messages in case the submitted MPIRequests were not
@@ -420,53 +531,150 @@ MPIResponse ConstructMPIResponse(std::unique_ptr<MessageTable>& message_table,
   return response;
 }
 
+// Use CPUDevice instead of GPUDevice if no CUDA, to ensure we don't
+// link to non-existent symbols.
+#if GOOGLE_CUDA
+#define GPU_DEVICE_IF_CUDA GPUDevice
+#else
+#define GPU_DEVICE_IF_CUDA CPUDevice
+#endif
+
+// Copies "size" bytes from "src" to "dst", either of which may be in GPU
+// memory if "on_gpu".
+void CopyData(bool on_gpu, void* dst, const void* src, size_t size) {
+  if (on_gpu) {
+    CopyTensorData<GPU_DEVICE_IF_CUDA>(dst, const_cast<void*>(src), size);
+  } else {
+    CopyTensorData<CPUDevice>(dst, const_cast<void*>(src), size);
+  }
+}
+
+// Returns the attributes of the memory that GPU tensors are staged through
+// if MPI is not CUDA-aware.
+AllocatorAttributes StagingAttributes() {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  attr.set_gpu_compatible(true);
+  return attr;
+}
+
+// Allreduces the tensors of "records", which have the same type and device,
+// through a single fusion buffer. The buffer is in GPU memory if the tensors
+// are and MPI is CUDA-aware, and in pinned host memory otherwise.
+template <typename T>
+Status FusedRingAllreduce(const std::vector<CollectiveOpRecord>& records) {
+  const CollectiveOpRecord& first = records[0];
+  const bool reduce_on_gpu = first.on_gpu && mpi_global.cuda_aware;
+  AllocatorAttributes attr;
+  if (first.on_gpu && !reduce_on_gpu) attr = StagingAttributes();
+
+  int64 num_elements = 0;
+  for (const CollectiveOpRecord& record : records) {
+    num_elements += record.in_t->NumElements();
+  }
+  Tensor buffer;
+  Tensor temp;
+  TF_RETURN_IF_ERROR(first.context->allocate_temp(
+      first.dtype, TensorShape({num_elements}), &buffer, attr));
+  TF_RETURN_IF_ERROR(first.context->allocate_temp(
+      first.dtype,
+      TensorShape({(num_elements + mpi_global.size - 1) / mpi_global.size}),
+      &temp, attr));
+
+  char* data = const_cast<char*>(buffer.tensor_data().data());
+  size_t offset = 0;
+  for (const CollectiveOpRecord& record : records) {
+    StringPiece input = record.in_t->tensor_data();
+    CopyData(first.on_gpu, data + offset, input.data(), input.size());
+    offset += input.size();
+  }
+  TF_RETURN_IF_ERROR(
+      reduce_on_gpu
+          ? RingAllreduce<GPU_DEVICE_IF_CUDA, T>(first.context, &buffer, &temp,
+                                                 &buffer)
+          : RingAllreduce<CPUDevice, T>(first.context, &buffer, &temp,
+                                        &buffer));
+  offset = 0;
+  for (const CollectiveOpRecord& record : records) {
+    StringPiece output = record.out_t->tensor_data();
+    CopyData(first.on_gpu, const_cast<char*>(output.data()), data + offset,
+             output.size());
+    offset += output.size();
+  }
+  return Status::OK();
+}
+
+// Allgathers the GPU tensor of "record" in pinned host memory.
+template <typename T>
+Status StagedRingAllgather(const CollectiveOpRecord& record) {
+  const AllocatorAttributes attr = StagingAttributes();
+  Tensor input;
+  Tensor output;
+  TF_RETURN_IF_ERROR(record.context->allocate_temp(
+      record.dtype, record.in_t->shape(), &input, attr));
+  TF_RETURN_IF_ERROR(record.context->allocate_temp(
+      record.dtype, record.out_t->shape(), &output, attr));
+  CopyData(true, const_cast<char*>(input.tensor_data().data()),
+           record.in_t->tensor_data().data(), input.tensor_data().size());
+  TF_RETURN_IF_ERROR(RingAllgather<CPUDevice, T>(record.context, &input,
+                                                 record.sizes_vec, &output));
+  CopyData(true, const_cast<char*>(record.out_t->tensor_data().data()),
+           output.tensor_data().data(), output.tensor_data().size());
+  return Status::OK();
+}
+
 // Process an MPIResponse by doing a reduction, a gather, or raising an error.
 void PerformCollectiveOp(TensorTable& tensor_table, MPIResponse response) {
-  OpKernelContext* context;
-  const Tensor* input_tensor;
-  std::vector<size_t> sizes_vec;
-  Tensor temp_tensor;
-  Tensor* output_tensor;
-  CommunicationDoneCallback callback;
-  bool on_gpu;
+  std::vector<CollectiveOpRecord> records;
   {
     // Lock on the tensor table.
     mutex_lock guard(mpi_global.mu);
 
-    // We should never fail at finding this key in the tensor table.
-    auto name = response.tensor_name();
-    auto iter = tensor_table.find(name);
-    assert(iter != tensor_table.end());
+    std::vector<std::string> names = {response.tensor_name()};
+    names.insert(names.end(), response.fused_tensor_names().begin(),
+                 response.fused_tensor_names().end());
+    for (const std::string& name : names) {
+      // We should never fail at finding this key in the tensor table.
+      auto iter = tensor_table.find(name);
+      assert(iter != tensor_table.end());
+
+      records.push_back(iter->second);
+
+      // Clear the tensor table of this tensor and its callbacks; the rest of
+      // this function takes care of it.
+      tensor_table.erase(iter);
+    }
 
     assert(response.response_type() == MPIResponse::ALLREDUCE ||
            response.response_type() == MPIResponse::ALLGATHER ||
            response.response_type() == MPIResponse::ERROR);
-
-    CollectiveOpRecord record = iter->second;
-    context = record.context;
-    input_tensor = record.in_t;
-    sizes_vec = record.sizes_vec;
-    temp_tensor = record.temp_t;
-    output_tensor = record.out_t;
-    on_gpu = record.on_gpu;
-    callback = record.callback;
-
-    // Clear the tensor table of this tensor and its callbacks; the rest of
-    // this function takes care of it.
-    tensor_table.erase(iter);
   }
 
-  // Use CPUDevice instead of GPUDevice if no CUDA, to ensure we don't
-  // link to non-existent symbols.
-#if GOOGLE_CUDA
-#define GPU_DEVICE_IF_CUDA GPUDevice
-#else
-#define GPU_DEVICE_IF_CUDA CPUDevice
-#endif
+  const CollectiveOpRecord& record = records[0];
+  OpKernelContext* context = record.context;
+  const Tensor* input_tensor = record.in_t;
+  const std::vector<size_t>& sizes_vec = record.sizes_vec;
+  Tensor temp_tensor = record.temp_t;
+  Tensor* output_tensor = record.out_t;
+  const bool on_gpu = record.on_gpu;
+  // Whether GPU tensors go through host memory.
+  const bool staged = on_gpu && !mpi_global.cuda_aware;
+  const int64 start_micros =
+      mpi_global.timeline.Enabled() ? Env::Default()->NowMicros() : 0;
 
   Status status;
   auto dtype = input_tensor->dtype();
-  if (response.response_type() == MPIResponse::ALLGATHER) {
+  if (response.response_type() == MPIResponse::ALLGATHER && staged) {
+    if (dtype == DT_FLOAT) {
+      status = StagedRingAllgather<float>(record);
+    } else if (dtype == DT_INT32) {
+      status = StagedRingAllgather<int>(record);
+    } else if (dtype == DT_INT64) {
+      status = StagedRingAllgather<long long>(record);
+    } else {
+      status = errors::Unknown("Invalid tensor type for MPI allgather.");
+    }
+  } else if (response.response_type() == MPIResponse::ALLGATHER) {
     if (dtype == DT_FLOAT) {
       status = on_gpu ? RingAllgather<GPU_DEVICE_IF_CUDA, float>(
                             context, input_tensor, sizes_vec, output_tensor)
@@ -485,6 +693,17 @@ void PerformCollectiveOp(TensorTable& tensor_table, MPIResponse response) {
     } else {
       status = errors::Unknown("Invalid tensor type for MPI allgather.");
     }
+  } else if (response.response_type() == MPIResponse::ALLREDUCE &&
+             (records.size() > 1 || staged)) {
+    if (dtype == DT_FLOAT) {
+      status = FusedRingAllreduce<float>(records);
+    } else if (dtype == DT_INT32) {
+      status = FusedRingAllreduce<int>(records);
+    } else if (dtype == DT_INT64) {
+      status = FusedRingAllreduce<long long>(records);
+    } else {
+      status = errors::Unknown("Invalid tensor type for MPI allreduce.");
+    }
   } else if (response.response_type() == MPIResponse::ALLREDUCE) {
     if (dtype == DT_FLOAT) {
       status = on_gpu ? RingAllreduce<GPU_DEVICE_IF_CUDA, float>(
@@ -508,10 +727,20 @@ void PerformCollectiveOp(TensorTable& tensor_table, MPIResponse response) {
     status = errors::FailedPrecondition(response.error_message());
   }
 
-  if (status.ok()) {
-    callback(StatusOr<Tensor>(*output_tensor));
-  } else {
-    callback(StatusOr<Tensor>(status));
+  for (const CollectiveOpRecord& done_record : records) {
+    if (mpi_global.timeline.Enabled() &&
+        response.response_type() != MPIResponse::ERROR) {
+      mpi_global.timeline.WriteEvent(
+          done_record.name,
+          response.response_type() == MPIResponse::ALLREDUCE ? "ALLREDUCE"
+                                                             : "ALLGATHER",
+          start_micros);
+    }
+    if (status.ok()) {
+      done_record.callback(StatusOr<Tensor>(*done_record.out_t));
+    } else {
+      done_record.callback(StatusOr<Tensor>(status));
+    }
   }
 }
 
@@ -626,6 +855,12 @@ void BackgroundThreadLoop() {
   if (is_coordinator) {
     mpi_global.message_table =
         std::unique_ptr<MessageTable>(new MessageTable());
+    if (!mpi_global.timeline_path.empty()) {
+      Status s = mpi_global.timeline.Initialize(mpi_global.timeline_path);
+      if (!s.ok()) {
+        LOG(ERROR) << "Failed to open the MPI timeline: " << s;
+      }
+    }
   }
 
   // The coordinator sends a SHUTDOWN message to trigger shutdown.
@@ -721,12 +956,39 @@ void BackgroundThreadLoop() {
       // their information to rank zero. We can now do reductions and
       // gathers; rank zero will choose which ones and in what order,
       // and will notify the other ranks before doing each reduction.
+      // Consecutive allreduces of tensors with the same type and device
+      // are fused into one, up to fusion_threshold_bytes.
+      std::vector<MPIResponse> responses;
+      bool fusable = false;
+      DataType fused_type = DT_INVALID;
+      bool fused_on_gpu = false;
+      int64 fused_bytes = 0;
       for (int i = 0; i < ready_to_reduce.size(); i++) {
-        // Notify all nodes which tensor we'd like to reduce now
         auto name = ready_to_reduce[i];
+        const std::vector<MPIRequest> requests =
+            mpi_global.message_table->at(name);
         MPIResponse response =
             ConstructMPIResponse(mpi_global.message_table, name);
+        const int64 bytes = response.response_type() == MPIResponse::ALLREDUCE
+                                ? FusableBytes(requests)
+                                : -1;
+        if (fusable && bytes >= 0 &&
+            requests[0].tensor_type() == fused_type &&
+            requests[0].on_gpu() == fused_on_gpu &&
+            fused_bytes + bytes <= mpi_global.fusion_threshold_bytes) {
+          responses.back().add_fused_tensor_names(name);
+          fused_bytes += bytes;
+          continue;
+        }
+        responses.push_back(response);
+        fusable = bytes >= 0 && bytes < mpi_global.fusion_threshold_bytes;
+        fused_type = requests[0].tensor_type();
+        fused_on_gpu = requests[0].on_gpu();
+        fused_bytes = bytes;
+      }
 
+      for (const MPIResponse& response : responses) {
+        // Notify all nodes which tensors we'd like to reduce now
         std::string encoded_response;
         response.SerializeToString(&encoded_response);
         for (int r = 1; r < size; r++) {
@@ -807,6 +1069,21 @@ Status InitializeMPIOnce(bool gpu) {
   }
 #endif
 
+  Status s = ReadInt64FromEnvVar("TF_MPI_FUSION_THRESHOLD_BYTES",
+                                 mpi_global.fusion_threshold_bytes,
+                                 &mpi_global.fusion_threshold_bytes);
+  if (s.ok()) {
+    s = ReadBoolFromEnvVar("TF_MPI_CUDA_AWARE", mpi_global.cuda_aware,
+                           &mpi_global.cuda_aware);
+  }
+  if (s.ok()) {
+    s = ReadStringFromEnvVar("TF_MPI_TIMELINE", "", &mpi_global.timeline_path);
+  }
+  if (!s.ok()) {
+    mpi_global.init_status = s;
+    return s;
+  }
+
   // Start the MPI background thread, which assumes MPI is initialized
   // TODO: Change this to a Tensorflow thread
   mpi_global.background_thread = std::thread(BackgroundThreadLoop);
@@ -843,6 +1120,7 @@ void EnqueueTensorCollective(CollectiveOpRecord record,
   message.set_tensor_name(record.name);
   message.set_tensor_type(record.dtype);
   message.set_request_type(rtype);
+  message.set_on_gpu(record.on_gpu);
   input_tensor->shape().AsProto(message.mutable_tensor_shape());
 
   mutex_lock guard(mpi_global.mu);
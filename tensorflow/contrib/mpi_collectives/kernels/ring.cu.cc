@@ -76,11 +76,13 @@ template Status RingAllgather<GPUDevice, float>(OpKernelContext*, const Tensor*,
 
 // Synchronously copy data on the GPU, using a different stream than the default
 // and than TensorFlow to avoid synchronizing on operations unrelated to the
-// allreduce.
+// allreduce. With unified addressing, cudaMemcpyDefault also copies to and
+// from the pinned host memory that tensors are staged through when MPI is not
+// CUDA-aware.
 template <>
 void CopyTensorData<GPUDevice>(void* dst, void* src, size_t size) {
   auto stream = CudaStreamForMPI();
-  cudaMemcpyAsync(dst, src, size, cudaMemcpyDeviceToDevice, stream);
+  cudaMemcpyAsync(dst, src, size, cudaMemcpyDefault, stream);
   cudaStreamSynchronize(stream);
 };
 
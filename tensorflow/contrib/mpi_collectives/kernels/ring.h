@@ -57,7 +57,8 @@ DataType TensorFlowDataType();
 
 // Copy data from one tensor to another tensor.
 // This uses a custom CUDA stream on GPU, which is necessary to overlay the
-// backpropagation computations with the allreduce.
+// backpropagation computations with the allreduce. On GPU, either tensor may
+// also be in pinned host memory.
 template <typename Device>
 void CopyTensorData(void* destination, void* source, size_t size);
 
@@ -162,8 +163,11 @@ Status RingAllreduce(OpKernelContext* context, const Tensor* input,
 
   T* buffer = (T*)output->tensor_data().data();
 
-  CopyTensorData<Device>((void*)buffer, (void*)input->tensor_data().data(),
-                         output->tensor_data().size());
+  // The input and output are the same tensor when reducing a fusion buffer.
+  if (buffer != (T*)input->tensor_data().data()) {
+    CopyTensorData<Device>((void*)buffer, (void*)input->tensor_data().data(),
+                           output->tensor_data().size());
+  }
 
   // Calculate segment sizes and segment ends
   const size_t elements_to_reduce = input->NumElements();
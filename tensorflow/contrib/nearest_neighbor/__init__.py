@@ -25,6 +25,18 @@ The following ops generate multiprobe sequences for various hash families.
 
 @@hyperplane_lsh_hash
 
+### LSH index ops
+
+The following ops build and query an index that ranks the points found in
+the probed buckets by their distance to the query.
+
+@@hyperplane_lsh_index_handle
+@@create_hyperplane_lsh_index
+@@hyperplane_lsh_index_query
+@@hyperplane_lsh_index_serialize
+@@hyperplane_lsh_index_deserialize
+@@hyperplane_lsh_index_is_initialized
+
 """
 
 from __future__ import absolute_import
@@ -0,0 +1,296 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_HYPERPLANE_LSH_INDEX_H_
+#define TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_HYPERPLANE_LSH_INDEX_H_
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/hyperplane_lsh_probes.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace nearest_neighbor {
+
+// An approximate nearest neighbor index over a corpus of points, which are
+// hashed into the buckets of several tables by hyperplane LSH. A query only
+// compares against the points in the buckets of its multiprobe sequence (see
+// HyperplaneMultiprobe) and returns the nearest ones in Euclidean distance.
+//
+// The index is immutable once built, so concurrent queries are safe.
+class HyperplaneLSHIndex {
+ public:
+  using Matrix =
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using ConstMatrixMap = Eigen::Map<const Matrix>;
+  using Vector = Eigen::Matrix<float, Eigen::Dynamic, 1, Eigen::ColMajor>;
+  using Multiprobe = HyperplaneMultiprobe<float, int32>;
+
+  HyperplaneLSHIndex() : num_tables_(0), num_hyperplanes_per_table_(0) {}
+
+  // Builds the index of the rows of "corpus". "hyperplanes" holds the
+  // num_tables * num_hyperplanes_per_table normal vectors of the hyperplanes,
+  // one per row, and the hyperplanes of table i are rows
+  // [i * num_hyperplanes_per_table, (i + 1) * num_hyperplanes_per_table).
+  void Build(const ConstMatrixMap& corpus, const ConstMatrixMap& hyperplanes,
+             int num_tables, int num_hyperplanes_per_table) {
+    num_tables_ = num_tables;
+    num_hyperplanes_per_table_ = num_hyperplanes_per_table;
+    hyperplanes_ = hyperplanes;
+    corpus_ = corpus;
+    const Matrix products = corpus_ * hyperplanes_.transpose();
+    table_hashes_.assign(num_tables_, std::vector<int32>());
+    table_points_.assign(num_tables_, std::vector<int64>());
+    std::vector<std::pair<int32, int64>> buckets(corpus_.rows());
+    for (int table = 0; table < num_tables_; ++table) {
+      for (int64 point = 0; point < corpus_.rows(); ++point) {
+        buckets[point] = {Hash(products.row(point).data(), table), point};
+      }
+      std::sort(buckets.begin(), buckets.end());
+      table_hashes_[table].reserve(buckets.size());
+      table_points_[table].reserve(buckets.size());
+      for (const auto& bucket : buckets) {
+        table_hashes_[table].push_back(bucket.first);
+        table_points_[table].push_back(bucket.second);
+      }
+    }
+  }
+
+  int num_tables() const { return num_tables_; }
+  int num_hyperplanes_per_table() const { return num_hyperplanes_per_table_; }
+  int64 num_points() const { return corpus_.rows(); }
+  int64 dimension() const { return hyperplanes_.cols(); }
+
+  // Stores the indices of the (at most) k nearest points that "query" finds
+  // in the buckets of its first "num_probes" probes into "indices", and their
+  // squared distances into "distances", nearest first. The remaining entries
+  // are set to -1 and infinity. "multiprobe" must have been created with the
+  // shape of the tables of the index, and "candidates" is scratch space; both
+  // may be reused across queries by the same thread.
+  void Query(const float* query, int num_probes, int k, Multiprobe* multiprobe,
+             std::vector<std::pair<float, int64>>* candidates,
+             int64* indices, float* distances) const {
+    const Eigen::Map<const Vector> query_vector(query, dimension());
+    const Vector products = hyperplanes_ * query_vector;
+    multiprobe->SetupProbing(products, num_probes);
+    candidates->clear();
+    int32 probe;
+    int_fast32_t table;
+    while (multiprobe->GetNextProbe(&probe, &table)) {
+      const std::vector<int32>& hashes = table_hashes_[table];
+      const auto range =
+          std::equal_range(hashes.begin(), hashes.end(), probe);
+      for (auto it = range.first; it != range.second; ++it) {
+        candidates->emplace_back(
+            0.0f, table_points_[table][it - hashes.begin()]);
+      }
+    }
+    // Points that share buckets with the query in several tables are only
+    // compared once.
+    std::sort(candidates->begin(), candidates->end(),
+              [](const std::pair<float, int64>& a,
+                 const std::pair<float, int64>& b) {
+                return a.second < b.second;
+              });
+    candidates->erase(
+        std::unique(candidates->begin(), candidates->end(),
+                    [](const std::pair<float, int64>& a,
+                       const std::pair<float, int64>& b) {
+                      return a.second == b.second;
+                    }),
+        candidates->end());
+    for (auto& candidate : *candidates) {
+      candidate.first =
+          (corpus_.row(candidate.second).transpose() - query_vector)
+              .squaredNorm();
+    }
+    const int num_results =
+        std::min<int64>(k, static_cast<int64>(candidates->size()));
+    std::partial_sort(candidates->begin(), candidates->begin() + num_results,
+                      candidates->end());
+    for (int i = 0; i < k; ++i) {
+      if (i < num_results) {
+        indices[i] = (*candidates)[i].second;
+        distances[i] = (*candidates)[i].first;
+      } else {
+        indices[i] = -1;
+        distances[i] = std::numeric_limits<float>::infinity();
+      }
+    }
+  }
+
+  // Serializes the index into a little-endian byte string.
+  std::string Serialize() const {
+    std::string serialized;
+    AppendInt(&serialized, kFormatVersion);
+    AppendInt(&serialized, num_tables_);
+    AppendInt(&serialized, num_hyperplanes_per_table_);
+    AppendInt(&serialized, corpus_.rows());
+    AppendInt(&serialized, dimension());
+    AppendArray(&serialized, hyperplanes_.data(), hyperplanes_.size());
+    AppendArray(&serialized, corpus_.data(), corpus_.size());
+    for (int table = 0; table < num_tables_; ++table) {
+      AppendArray(&serialized, table_hashes_[table].data(),
+                  table_hashes_[table].size());
+      AppendArray(&serialized, table_points_[table].data(),
+                  table_points_[table].size());
+    }
+    return serialized;
+  }
+
+  // Replaces the index with the one serialized in "serialized". Returns false
+  // if it is not a valid serialized index.
+  bool Deserialize(const std::string& serialized) {
+    const char* pos = serialized.data();
+    const char* const end = pos + serialized.size();
+    int64 version, num_tables, num_hyperplanes_per_table, num_points,
+        dimension;
+    if (!ReadInt(&pos, end, &version) || version != kFormatVersion ||
+        !ReadInt(&pos, end, &num_tables) ||
+        !ReadInt(&pos, end, &num_hyperplanes_per_table) ||
+        !ReadInt(&pos, end, &num_points) || !ReadInt(&pos, end, &dimension) ||
+        num_tables < 0 || num_hyperplanes_per_table < 0 ||
+        num_hyperplanes_per_table > 30 || num_points < 0 || dimension < 0) {
+      return false;
+    }
+    // Rejects sizes that the remaining bytes can't hold before allocating.
+    const uint64 remaining = end - pos;
+    const uint64 num_hyperplanes = num_tables * num_hyperplanes_per_table;
+    if (num_tables > remaining ||
+        !Fits(num_hyperplanes, dimension, remaining) ||
+        !Fits(num_points, dimension, remaining) ||
+        !Fits(num_tables, num_points, remaining)) {
+      return false;
+    }
+    Matrix hyperplanes(num_hyperplanes, dimension);
+    Matrix corpus(num_points, dimension);
+    if (!ReadArray(&pos, end, hyperplanes.size(), hyperplanes.data()) ||
+        !ReadArray(&pos, end, corpus.size(), corpus.data())) {
+      return false;
+    }
+    std::vector<std::vector<int32>> table_hashes(num_tables);
+    std::vector<std::vector<int64>> table_points(num_tables);
+    for (int table = 0; table < num_tables; ++table) {
+      table_hashes[table].resize(num_points);
+      table_points[table].resize(num_points);
+      if (!ReadArray(&pos, end, num_points, table_hashes[table].data()) ||
+          !ReadArray(&pos, end, num_points, table_points[table].data()) ||
+          !std::is_sorted(table_hashes[table].begin(),
+                          table_hashes[table].end())) {
+        return false;
+      }
+      for (const int64 point : table_points[table]) {
+        if (point < 0 || point >= num_points) return false;
+      }
+    }
+    if (pos != end) return false;
+    num_tables_ = num_tables;
+    num_hyperplanes_per_table_ = num_hyperplanes_per_table;
+    hyperplanes_ = std::move(hyperplanes);
+    corpus_ = std::move(corpus);
+    table_hashes_ = std::move(table_hashes);
+    table_points_ = std::move(table_points);
+    return true;
+  }
+
+ private:
+  static constexpr int64 kFormatVersion = 1;
+
+  // Returns the bucket of a point in "table", given the inner products of the
+  // point with all the hyperplanes. Matches the primary probes of
+  // HyperplaneMultiprobe.
+  int32 Hash(const float* products, int table) const {
+    int32 hash = 0;
+    for (int i = 0; i < num_hyperplanes_per_table_; ++i) {
+      hash = (hash << 1) |
+             (products[table * num_hyperplanes_per_table_ + i] >= 0.0f);
+    }
+    return hash;
+  }
+
+  // Returns whether a * b <= limit, without overflowing.
+  static bool Fits(uint64 a, uint64 b, uint64 limit) {
+    return a == 0 || b <= limit / a;
+  }
+
+  static void AppendInt(std::string* dst, uint64 value) {
+    for (int i = 0; i < 8; ++i) {
+      dst->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+  }
+
+  static bool ReadInt(const char** pos, const char* end, int64* value) {
+    if (end - *pos < 8) return false;
+    uint64 result = 0;
+    for (int i = 0; i < 8; ++i) {
+      result |= static_cast<uint64>(static_cast<unsigned char>((*pos)[i]))
+                << (8 * i);
+    }
+    *pos += 8;
+    *value = static_cast<int64>(result);
+    return true;
+  }
+
+  template <typename T>
+  static void AppendArray(std::string* dst, const T* data, int64 size) {
+    for (int64 i = 0; i < size; ++i) {
+      uint64 bits = 0;
+      std::memcpy(&bits, &data[i], sizeof(T));
+      for (size_t j = 0; j < sizeof(T); ++j) {
+        dst->push_back(static_cast<char>((bits >> (8 * j)) & 0xff));
+      }
+    }
+  }
+
+  template <typename T>
+  static bool ReadArray(const char** pos, const char* end, int64 size,
+                        T* data) {
+    if (size < 0 ||
+        static_cast<uint64>(end - *pos) / sizeof(T) <
+            static_cast<uint64>(size)) {
+      return false;
+    }
+    for (int64 i = 0; i < size; ++i) {
+      uint64 bits = 0;
+      for (size_t j = 0; j < sizeof(T); ++j) {
+        bits |= static_cast<uint64>(static_cast<unsigned char>(*(*pos)++))
+                << (8 * j);
+      }
+      std::memcpy(&data[i], &bits, sizeof(T));
+    }
+    return true;
+  }
+
+  int num_tables_;
+  int num_hyperplanes_per_table_;
+  Matrix hyperplanes_;
+  Matrix corpus_;
+  // Per table, the buckets of the points sorted by bucket, and the indices
+  // of the points in the same order.
+  std::vector<std::vector<int32>> table_hashes_;
+  std::vector<std::vector<int64>> table_points_;
+};
+
+}  // namespace nearest_neighbor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_HYPERPLANE_LSH_INDEX_H_
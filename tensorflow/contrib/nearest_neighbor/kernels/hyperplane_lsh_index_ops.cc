@@ -0,0 +1,283 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/hyperplane_lsh_index.h"
+
+namespace tensorflow {
+
+using errors::InvalidArgument;
+
+using nearest_neighbor::HyperplaneLSHIndex;
+
+// Holds a HyperplaneLSHIndex. Queries share the current index, which is
+// replaced as a whole when the index is rebuilt or deserialized.
+class HyperplaneLSHIndexResource : public ResourceBase {
+ public:
+  HyperplaneLSHIndexResource() : index_(new HyperplaneLSHIndex) {}
+
+  string DebugString() override {
+    std::shared_ptr<const HyperplaneLSHIndex> index = GetIndex();
+    return strings::StrCat("HyperplaneLSHIndex[points=", index->num_points(),
+                           ", tables=", index->num_tables(), "]");
+  }
+
+  std::shared_ptr<const HyperplaneLSHIndex> GetIndex() {
+    tf_shared_lock l(mu_);
+    return index_;
+  }
+
+  void SetIndex(std::shared_ptr<const HyperplaneLSHIndex> index) {
+    mutex_lock l(mu_);
+    index_ = std::move(index);
+  }
+
+ private:
+  mutex mu_;
+  std::shared_ptr<const HyperplaneLSHIndex> index_ GUARDED_BY(mu_);
+};
+
+REGISTER_RESOURCE_HANDLE_KERNEL(HyperplaneLSHIndexResource);
+
+REGISTER_KERNEL_BUILDER(
+    Name("HyperplaneLSHIndexIsInitialized").Device(DEVICE_CPU),
+    IsResourceInitialized<HyperplaneLSHIndexResource>);
+
+namespace {
+
+// Returns the resource behind the handle in input 0, and creates it if it
+// doesn't exist yet.
+Status LookupOrCreateIndexResource(OpKernelContext* context,
+                                   HyperplaneLSHIndexResource** resource) {
+  return LookupOrCreateResource<HyperplaneLSHIndexResource>(
+      context, HandleFromInput(context, 0), resource,
+      [](HyperplaneLSHIndexResource** resource) {
+        *resource = new HyperplaneLSHIndexResource;
+        return Status::OK();
+      });
+}
+
+}  // namespace
+
+class CreateHyperplaneLSHIndexOp : public OpKernel {
+ public:
+  explicit CreateHyperplaneLSHIndexOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& corpus_tensor = context->input(1);
+    OP_REQUIRES(context, corpus_tensor.dims() == 2,
+                InvalidArgument("Need a two-dimensional corpus tensor, got ",
+                                corpus_tensor.dims(), " dimensions."));
+    const Tensor& hyperplanes_tensor = context->input(2);
+    OP_REQUIRES(context, hyperplanes_tensor.dims() == 2,
+                InvalidArgument("Need a two-dimensional hyperplanes tensor, "
+                                "got ",
+                                hyperplanes_tensor.dims(), " dimensions."));
+    OP_REQUIRES(context,
+                corpus_tensor.dim_size(1) == hyperplanes_tensor.dim_size(1),
+                InvalidArgument("The corpus has ", corpus_tensor.dim_size(1),
+                                " dimensions but the hyperplanes have ",
+                                hyperplanes_tensor.dim_size(1), "."));
+
+    const Tensor& num_tables_tensor = context->input(3);
+    OP_REQUIRES(context, num_tables_tensor.dims() == 0,
+                InvalidArgument("Need a scalar num_tables tensor, got ",
+                                num_tables_tensor.dims(), " dimensions."));
+    const int num_tables = num_tables_tensor.scalar<int32>()();
+    OP_REQUIRES(context, num_tables >= 1 && num_tables <= 1000,
+                InvalidArgument("Need 1 <= num_tables <= 1000, got ",
+                                num_tables, "."));
+
+    const Tensor& num_hyperplanes_per_table_tensor = context->input(4);
+    OP_REQUIRES(context, num_hyperplanes_per_table_tensor.dims() == 0,
+                InvalidArgument("Need a scalar num_hyperplanes_per_table "
+                                "tensor, got ",
+                                num_hyperplanes_per_table_tensor.dims(),
+                                " dimensions."));
+    const int num_hyperplanes_per_table =
+        num_hyperplanes_per_table_tensor.scalar<int32>()();
+    OP_REQUIRES(context,
+                num_hyperplanes_per_table >= 1 &&
+                    num_hyperplanes_per_table <= 30,
+                InvalidArgument("Need 1 <= num_hyperplanes_per_table <= 30, "
+                                "got ",
+                                num_hyperplanes_per_table, "."));
+    OP_REQUIRES(context,
+                hyperplanes_tensor.dim_size(0) ==
+                    num_tables * num_hyperplanes_per_table,
+                InvalidArgument("Expected ",
+                                num_tables * num_hyperplanes_per_table,
+                                " hyperplanes but got ",
+                                hyperplanes_tensor.dim_size(0), "."));
+
+    std::shared_ptr<HyperplaneLSHIndex> index(new HyperplaneLSHIndex);
+    index->Build(HyperplaneLSHIndex::ConstMatrixMap(
+                     corpus_tensor.matrix<float>().data(),
+                     corpus_tensor.dim_size(0), corpus_tensor.dim_size(1)),
+                 HyperplaneLSHIndex::ConstMatrixMap(
+                     hyperplanes_tensor.matrix<float>().data(),
+                     hyperplanes_tensor.dim_size(0),
+                     hyperplanes_tensor.dim_size(1)),
+                 num_tables, num_hyperplanes_per_table);
+
+    HyperplaneLSHIndexResource* resource;
+    OP_REQUIRES_OK(context, LookupOrCreateIndexResource(context, &resource));
+    core::ScopedUnref unref_me(resource);
+    resource->SetIndex(std::move(index));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("CreateHyperplaneLSHIndex").Device(DEVICE_CPU),
+                        CreateHyperplaneLSHIndexOp);
+
+class HyperplaneLSHIndexQueryOp : public OpKernel {
+ public:
+  explicit HyperplaneLSHIndexQueryOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    HyperplaneLSHIndexResource* resource;
+    OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
+                                           &resource));
+    core::ScopedUnref unref_me(resource);
+    const std::shared_ptr<const HyperplaneLSHIndex> index =
+        resource->GetIndex();
+
+    const Tensor& queries_tensor = context->input(1);
+    OP_REQUIRES(context, queries_tensor.dims() == 2,
+                InvalidArgument("Need a two-dimensional queries tensor, got ",
+                                queries_tensor.dims(), " dimensions."));
+    OP_REQUIRES(context, queries_tensor.dim_size(1) == index->dimension(),
+                InvalidArgument("The queries have ",
+                                queries_tensor.dim_size(1),
+                                " dimensions but the index has ",
+                                index->dimension(), "."));
+
+    const Tensor& num_probes_tensor = context->input(2);
+    OP_REQUIRES(context, num_probes_tensor.dims() == 0,
+                InvalidArgument("Need a scalar num_probes tensor, got ",
+                                num_probes_tensor.dims(), " dimensions."));
+    const int num_probes = num_probes_tensor.scalar<int32>()();
+    OP_REQUIRES(context, num_probes >= 1,
+                InvalidArgument("num_probes must be at least 1."));
+
+    const Tensor& k_tensor = context->input(3);
+    OP_REQUIRES(context, k_tensor.dims() == 0,
+                InvalidArgument("Need a scalar k tensor, got ",
+                                k_tensor.dims(), " dimensions."));
+    const int k = k_tensor.scalar<int32>()();
+    OP_REQUIRES(context, k >= 1, InvalidArgument("k must be at least 1."));
+
+    const int64 batch_size = queries_tensor.dim_size(0);
+    Tensor* indices_tensor = nullptr;
+    Tensor* distances_tensor = nullptr;
+    TensorShape output_shape({batch_size, k});
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &indices_tensor));
+    OP_REQUIRES_OK(context, context->allocate_output(1, output_shape,
+                                                     &distances_tensor));
+    if (index->num_tables() == 0) {
+      indices_tensor->flat<int64>().setConstant(-1);
+      distances_tensor->flat<float>().setConstant(
+          std::numeric_limits<float>::infinity());
+      return;
+    }
+
+    const float* queries = queries_tensor.matrix<float>().data();
+    int64* indices = indices_tensor->matrix<int64>().data();
+    float* distances = distances_tensor->matrix<float>().data();
+    const int64 dimension = index->dimension();
+    // Hashing the query costs a product with every hyperplane, and each probe
+    // compares the query with the points of one bucket, which hold
+    // num_points / 2^num_hyperplanes_per_table points on average.
+    const int64 points_per_bucket = std::max<int64>(
+        1, index->num_points() >> index->num_hyperplanes_per_table());
+    const int64 cost_per_unit =
+        dimension * (index->num_tables() * index->num_hyperplanes_per_table() +
+                     num_probes * points_per_bucket);
+    context->device()->tensorflow_cpu_worker_threads()->workers->ParallelFor(
+        batch_size, cost_per_unit, [&](int64 start, int64 end) {
+          HyperplaneLSHIndex::Multiprobe multiprobe(
+              index->num_hyperplanes_per_table(), index->num_tables());
+          std::vector<std::pair<float, int64>> candidates;
+          for (int64 query = start; query < end; ++query) {
+            index->Query(queries + query * dimension, num_probes, k,
+                         &multiprobe, &candidates, indices + query * k,
+                         distances + query * k);
+          }
+        });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("HyperplaneLSHIndexQuery").Device(DEVICE_CPU),
+                        HyperplaneLSHIndexQueryOp);
+
+class HyperplaneLSHIndexSerializeOp : public OpKernel {
+ public:
+  explicit HyperplaneLSHIndexSerializeOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    HyperplaneLSHIndexResource* resource;
+    OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
+                                           &resource));
+    core::ScopedUnref unref_me(resource);
+    Tensor* output_config_t = nullptr;
+    OP_REQUIRES_OK(
+        context, context->allocate_output(0, TensorShape(), &output_config_t));
+    output_config_t->scalar<string>()() = resource->GetIndex()->Serialize();
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("HyperplaneLSHIndexSerialize").Device(DEVICE_CPU),
+                        HyperplaneLSHIndexSerializeOp);
+
+class HyperplaneLSHIndexDeserializeOp : public OpKernel {
+ public:
+  explicit HyperplaneLSHIndexDeserializeOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& index_config_t = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(index_config_t.shape()),
+                InvalidArgument("Index config must be a scalar."));
+    std::shared_ptr<HyperplaneLSHIndex> index(new HyperplaneLSHIndex);
+    OP_REQUIRES(context, index->Deserialize(index_config_t.scalar<string>()()),
+                InvalidArgument("Unable to parse the index config."));
+
+    HyperplaneLSHIndexResource* resource;
+    OP_REQUIRES_OK(context, LookupOrCreateIndexResource(context, &resource));
+    core::ScopedUnref unref_me(resource);
+    resource->SetIndex(std::move(index));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("HyperplaneLSHIndexDeserialize").Device(DEVICE_CPU),
+    HyperplaneLSHIndexDeserializeOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,145 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/nearest_neighbor/kernels/hyperplane_lsh_index.h"
+
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace {
+
+using tensorflow::nearest_neighbor::HyperplaneLSHIndex;
+
+const int kNumPoints = 200;
+const int kDimension = 8;
+const int kNumTables = 3;
+const int kNumHyperplanesPerTable = 4;
+const int kK = 5;
+
+class HyperplaneLSHIndexTest : public ::testing::Test {
+ protected:
+  HyperplaneLSHIndexTest()
+      : corpus_(kNumPoints, kDimension),
+        hyperplanes_(kNumTables * kNumHyperplanesPerTable, kDimension) {
+    std::mt19937 generator(1);
+    std::normal_distribution<float> distribution;
+    for (int i = 0; i < corpus_.size(); ++i) {
+      corpus_.data()[i] = distribution(generator);
+    }
+    for (int i = 0; i < hyperplanes_.size(); ++i) {
+      hyperplanes_.data()[i] = distribution(generator);
+    }
+    index_.Build(
+        HyperplaneLSHIndex::ConstMatrixMap(corpus_.data(), kNumPoints,
+                                           kDimension),
+        HyperplaneLSHIndex::ConstMatrixMap(hyperplanes_.data(),
+                                           hyperplanes_.rows(), kDimension),
+        kNumTables, kNumHyperplanesPerTable);
+  }
+
+  void Query(const HyperplaneLSHIndex& index, int point, int num_probes,
+             std::vector<tensorflow::int64>* indices,
+             std::vector<float>* distances) {
+    HyperplaneLSHIndex::Multiprobe multiprobe(kNumHyperplanesPerTable,
+                                              kNumTables);
+    std::vector<std::pair<float, tensorflow::int64>> candidates;
+    indices->resize(kK);
+    distances->resize(kK);
+    index.Query(corpus_.row(point).data(), num_probes, kK, &multiprobe,
+                &candidates, indices->data(), distances->data());
+  }
+
+  HyperplaneLSHIndex::Matrix corpus_;
+  HyperplaneLSHIndex::Matrix hyperplanes_;
+  HyperplaneLSHIndex index_;
+};
+
+TEST_F(HyperplaneLSHIndexTest, FindsTheQueryPoint) {
+  std::vector<tensorflow::int64> indices;
+  std::vector<float> distances;
+  for (int point = 0; point < kNumPoints; ++point) {
+    // The primary probes always include the bucket of the point itself.
+    Query(index_, point, kNumTables, &indices, &distances);
+    EXPECT_EQ(point, indices[0]);
+    EXPECT_EQ(0.0f, distances[0]);
+    for (int i = 1; i < kK; ++i) {
+      EXPECT_LE(distances[i - 1], distances[i]);
+    }
+  }
+}
+
+TEST_F(HyperplaneLSHIndexTest, ProbingAllBucketsIsExact) {
+  const int num_probes = kNumTables * (1 << kNumHyperplanesPerTable);
+  std::vector<tensorflow::int64> indices;
+  std::vector<float> distances;
+  for (int point = 0; point < kNumPoints; point += 7) {
+    Query(index_, point, num_probes, &indices, &distances);
+    std::vector<std::pair<float, int>> expected;
+    for (int other = 0; other < kNumPoints; ++other) {
+      expected.emplace_back(
+          (corpus_.row(other) - corpus_.row(point)).squaredNorm(), other);
+    }
+    std::sort(expected.begin(), expected.end());
+    for (int i = 0; i < kK; ++i) {
+      EXPECT_EQ(expected[i].second, indices[i]);
+      EXPECT_FLOAT_EQ(expected[i].first, distances[i]);
+    }
+  }
+}
+
+TEST_F(HyperplaneLSHIndexTest, PadsMissingNeighbors) {
+  HyperplaneLSHIndex index;
+  index.Build(HyperplaneLSHIndex::ConstMatrixMap(corpus_.data(), 2, kDimension),
+              HyperplaneLSHIndex::ConstMatrixMap(
+                  hyperplanes_.data(), hyperplanes_.rows(), kDimension),
+              kNumTables, kNumHyperplanesPerTable);
+  std::vector<tensorflow::int64> indices;
+  std::vector<float> distances;
+  Query(index, 0, kNumTables * (1 << kNumHyperplanesPerTable), &indices,
+        &distances);
+  EXPECT_EQ(0, indices[0]);
+  EXPECT_EQ(1, indices[1]);
+  for (int i = 2; i < kK; ++i) {
+    EXPECT_EQ(-1, indices[i]);
+    EXPECT_EQ(std::numeric_limits<float>::infinity(), distances[i]);
+  }
+}
+
+TEST_F(HyperplaneLSHIndexTest, SerializeAndDeserialize) {
+  const std::string serialized = index_.Serialize();
+  HyperplaneLSHIndex index;
+  ASSERT_TRUE(index.Deserialize(serialized));
+  EXPECT_EQ(kNumPoints, index.num_points());
+  EXPECT_EQ(kDimension, index.dimension());
+  EXPECT_EQ(kNumTables, index.num_tables());
+  EXPECT_EQ(kNumHyperplanesPerTable, index.num_hyperplanes_per_table());
+  std::vector<tensorflow::int64> indices, expected_indices;
+  std::vector<float> distances, expected_distances;
+  for (int point = 0; point < kNumPoints; point += 11) {
+    Query(index_, point, 10, &expected_indices, &expected_distances);
+    Query(index, point, 10, &indices, &distances);
+    EXPECT_EQ(expected_indices, indices);
+    EXPECT_EQ(expected_distances, distances);
+  }
+
+  EXPECT_FALSE(index.Deserialize(serialized.substr(0, serialized.size() - 1)));
+  EXPECT_FALSE(index.Deserialize("garbage"));
+  // A failed deserialization leaves the index alone.
+  EXPECT_EQ(kNumPoints, index.num_points());
+}
+
+}  // namespace
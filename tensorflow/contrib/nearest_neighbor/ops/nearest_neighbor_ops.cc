@@ -13,7 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/shape_inference.h"
 
 namespace tensorflow {
 
@@ -46,4 +49,96 @@ probes: the output matrix of probes. Size `batch_size` times `num_probes`.
 table_ids: the output matrix of tables ids. Size `batch_size` times `num_probes`.
 )doc");
 
+REGISTER_RESOURCE_HANDLE_OP(HyperplaneLSHIndexResource);
+
+REGISTER_OP("HyperplaneLSHIndexIsInitialized")
+    .Input("index_handle: resource")
+    .Output("is_initialized: bool")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Checks whether a hyperplane LSH index has been created.
+)doc");
+
+REGISTER_OP("CreateHyperplaneLSHIndex")
+    .Input("index_handle: resource")
+    .Input("corpus: float")
+    .Input("hyperplanes: float")
+    .Input("num_tables: int32")
+    .Input("num_hyperplanes_per_table: int32")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Builds a hyperplane LSH index over the rows of `corpus`.
+
+Each point is hashed into `num_tables` tables by the signs of its inner
+products with the hyperplanes of the table. The index keeps a copy of the
+corpus so that queries can rank the points they retrieve, and replaces any
+index previously held by the resource.
+
+index_handle: handle to the index resource to be created.
+corpus: the points to index, a matrix of size `num_points` times `dimension`.
+hyperplanes: a matrix of size `num_tables * num_hyperplanes_per_table` times
+  `dimension`. Rows `t * num_hyperplanes_per_table` to
+  `(t + 1) * num_hyperplanes_per_table - 1` are the hyperplanes of table `t`.
+num_tables: the number of hash tables.
+num_hyperplanes_per_table: the number of hyperplanes per table.
+)doc");
+
+REGISTER_OP("HyperplaneLSHIndexQuery")
+    .Input("index_handle: resource")
+    .Input("queries: float")
+    .Input("num_probes: int32")
+    .Input("k: int32")
+    .Output("indices: int64")
+    .Output("distances: float")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle queries;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &queries));
+      shape_inference::DimensionHandle k;
+      TF_RETURN_IF_ERROR(c->MakeDimForScalarInput(3, &k));
+      shape_inference::ShapeHandle output =
+          c->Matrix(c->Dim(queries, 0), k);
+      c->set_output(0, output);
+      c->set_output(1, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Finds approximate nearest neighbors of the queries in a hyperplane LSH index.
+
+The points in the first `num_probes` buckets of the multiprobe sequence of a
+query are ranked by their squared Euclidean distance to it.
+
+index_handle: the handle to the index.
+queries: a matrix of size `batch_size` times `dimension`.
+num_probes: the number of buckets to probe for each query. The first
+  `num_tables` probes are the primary buckets of each table.
+k: the number of neighbors to return for each query.
+indices: the rows of the corpus closest to each query, a matrix of size
+  `batch_size` times `k`, padded with -1 when fewer than `k` points were
+  retrieved.
+distances: the squared Euclidean distances to the points in `indices`,
+  padded with infinity.
+)doc");
+
+REGISTER_OP("HyperplaneLSHIndexSerialize")
+    .Input("index_handle: resource")
+    .Output("index_config: string")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Serializes a hyperplane LSH index to a string.
+
+index_handle: the handle to the index.
+index_config: the serialized index.
+)doc");
+
+REGISTER_OP("HyperplaneLSHIndexDeserialize")
+    .Input("index_handle: resource")
+    .Input("index_config: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Replaces the index held by a resource with a serialized one.
+
+index_handle: the handle to the index.
+index_config: an index serialized by HyperplaneLSHIndexSerialize.
+)doc");
+
 }  // namespace tensorflow
@@ -62,3 +62,95 @@ def hyperplane_lsh_probes(point_hyperplane_product,
                                                      name=name)
 
 ops.NotDifferentiable("HyperplaneLSHProbes")
+
+
+def hyperplane_lsh_index_handle(name, container=None):
+  """Returns a handle to a hyperplane LSH index resource.
+
+  Args:
+    name: the shared name of the index.
+    container: the container of the index (optional).
+
+  Returns:
+    A resource handle to pass to the other hyperplane LSH index ops.
+  """
+  return _nearest_neighbor_ops.hyperplane_lsh_index_resource_handle_op(
+      container=container or "", shared_name=name, name=name)
+
+
+def create_hyperplane_lsh_index(index_handle,
+                                corpus,
+                                hyperplanes,
+                                num_tables,
+                                num_hyperplanes_per_table,
+                                name=None):
+  """Builds a hyperplane LSH index over the rows of `corpus`.
+
+  Args:
+    index_handle: the handle returned by `hyperplane_lsh_index_handle`.
+    corpus: the points to index, a float matrix of size `num_points` times
+      `dimension`. The index keeps a copy of it to rank candidates.
+    hyperplanes: a float matrix of size `num_tables *
+      num_hyperplanes_per_table` times `dimension`, holding the hyperplanes of
+      each table in consecutive rows.
+    num_tables: the number of hash tables.
+    num_hyperplanes_per_table: the number of hyperplanes per table.
+    name: A name for the operation (optional).
+
+  Returns:
+    The created operation.
+  """
+  return _nearest_neighbor_ops.create_hyperplane_lsh_index(
+      index_handle, corpus, hyperplanes, num_tables,
+      num_hyperplanes_per_table, name=name)
+
+
+def hyperplane_lsh_index_query(index_handle, queries, num_probes, k,
+                               name=None):
+  """Finds approximate nearest neighbors in a hyperplane LSH index.
+
+  The points in the first `num_probes` buckets of the multiprobe sequence of
+  each query are ranked by their squared Euclidean distance to the query.
+
+  Args:
+    index_handle: the handle of an index built by
+      `create_hyperplane_lsh_index`.
+    queries: a float matrix of size `batch_size` times `dimension`.
+    num_probes: the number of buckets to probe for each query.
+    k: the number of neighbors to return for each query.
+    name: A name prefix for the returned tensors (optional).
+
+  Returns:
+    indices: an int64 matrix of size `batch_size` times `k` with the rows of
+      the corpus closest to each query, padded with -1.
+    distances: the squared distances to those rows, padded with infinity.
+  """
+  return _nearest_neighbor_ops.hyperplane_lsh_index_query(
+      index_handle, queries, num_probes, k, name=name)
+
+
+def hyperplane_lsh_index_serialize(index_handle, name=None):
+  """Serializes a hyperplane LSH index to a string scalar."""
+  return _nearest_neighbor_ops.hyperplane_lsh_index_serialize(index_handle,
+                                                              name=name)
+
+
+def hyperplane_lsh_index_deserialize(index_handle, index_config, name=None):
+  """Replaces an index with one serialized by `hyperplane_lsh_index_serialize`.
+  """
+  return _nearest_neighbor_ops.hyperplane_lsh_index_deserialize(
+      index_handle, index_config, name=name)
+
+
+def hyperplane_lsh_index_is_initialized(index_handle, name=None):
+  """Returns whether a hyperplane LSH index has been created."""
+  return _nearest_neighbor_ops.hyperplane_lsh_index_is_initialized(
+      index_handle, name=name)
+
+
+ops.NotDifferentiable("HyperplaneLSHIndexResourceHandleOp")
+ops.NotDifferentiable("HyperplaneLSHIndexIsInitialized")
+ops.NotDifferentiable("CreateHyperplaneLSHIndex")
+ops.NotDifferentiable("HyperplaneLSHIndexQuery")
+ops.NotDifferentiable("HyperplaneLSHIndexSerialize")
+ops.NotDifferentiable("HyperplaneLSHIndexDeserialize")
@@ -14,6 +14,11 @@
 // =============================================================================
 #include "tensorflow/contrib/tensor_forest/kernels/v4/decision-tree-resource.h"
 
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/core/lib/strings/numbers.h"
+
 namespace tensorflow {
 namespace tensorforest {
 
@@ -29,14 +34,33 @@ DecisionTreeResource::DecisionTreeResource(const TensorForestParams& params)
 int32 DecisionTreeResource::TraverseTree(
     const std::unique_ptr<TensorDataSet>& input_data, int example,
     int32* leaf_depth, TreePath* path) const {
-  const DecisionTree& tree = decision_tree_->decision_tree();
   int32 current_id = 0;
   int32 depth = 0;
+  if (path == nullptr) {
+    while (true) {
+      const PackedNode& current = packed_nodes_[current_id];
+      if (current.left_id < 0) break;
+      ++depth;
+      if (current.feature_id >= 0) {
+        current_id =
+            input_data->GetExampleValue(example, current.feature_id) <=
+                    current.threshold
+                ? current.left_id
+                : current.right_id;
+      } else {
+        current_id = node_evaluators_[current_id]->Decide(input_data, example);
+      }
+    }
+    if (leaf_depth != nullptr) {
+      *leaf_depth = depth;
+    }
+    return current_id;
+  }
+
+  const DecisionTree& tree = decision_tree_->decision_tree();
   while (true) {
     const TreeNode& current = tree.nodes(current_id);
-    if (path != nullptr) {
-      *path->add_nodes_visited() = current;
-    }
+    *path->add_nodes_visited() = current;
     if (current.has_leaf()) {
       if (leaf_depth != nullptr) {
         *leaf_depth = depth;
@@ -50,6 +74,33 @@ int32 DecisionTreeResource::TraverseTree(
   }
 }
 
+void DecisionTreeResource::PackNode(int32 node_id) {
+  const TreeNode& node = decision_tree_->decision_tree().nodes(node_id);
+  while (packed_nodes_.size() <= node_id) {
+    packed_nodes_.push_back({-1, 0, -1, -1});
+  }
+  PackedNode* packed = &packed_nodes_[node_id];
+  *packed = {-1, 0, -1, -1};
+  if (node.has_leaf()) return;
+  const decision_trees::BinaryNode& split = node.binary_node();
+  packed->left_id = split.left_child_id().value();
+  packed->right_id = split.right_child_id().value();
+  if (!split.has_inequality_left_child_test()) return;
+  const auto& test = split.inequality_left_child_test();
+  int32 feature_id;
+  if (test.has_oblique() ||
+      !strings::safe_strto32(test.feature_id().id().value(), &feature_id)) {
+    return;
+  }
+  packed->feature_id = feature_id;
+  packed->threshold = test.threshold().float_value();
+  if (test.type() != decision_trees::InequalityTest::LESS_OR_EQUAL) {
+    // "value < threshold" is "value <= the next float below threshold".
+    packed->threshold = std::nextafter(
+        packed->threshold, -std::numeric_limits<float>::infinity());
+  }
+}
+
 void DecisionTreeResource::SplitNode(int32 node_id, SplitCandidate* best,
                                      std::vector<int32>* new_children) {
   DecisionTree* tree = decision_tree_->mutable_decision_tree();
@@ -78,12 +129,16 @@ void DecisionTreeResource::SplitNode(int32 node_id, SplitCandidate* best,
     node_evaluators_.emplace_back(nullptr);
   }
   node_evaluators_[node_id] = CreateDecisionNodeEvaluator(*node);
+  PackNode(node_id);
+  PackNode(newid - 1);
+  PackNode(newid);
 }
 
 void DecisionTreeResource::MaybeInitialize() {
   DecisionTree* tree = decision_tree_->mutable_decision_tree();
   if (tree->nodes_size() == 0) {
     model_op_->InitModel(tree->add_nodes()->mutable_leaf());
+    PackNode(0);
   } else if (node_evaluators_.empty()) {  // reconstruct evaluators
     for (const auto& node : tree->nodes()) {
       if (node.has_leaf()) {
@@ -92,6 +147,10 @@ void DecisionTreeResource::MaybeInitialize() {
         node_evaluators_.push_back(CreateDecisionNodeEvaluator(node));
       }
     }
+    packed_nodes_.reserve(tree->nodes_size());
+    for (int32 node_id = 0; node_id < tree->nodes_size(); ++node_id) {
+      PackNode(node_id);
+    }
   }
 }
 
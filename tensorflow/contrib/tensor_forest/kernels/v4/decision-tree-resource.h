@@ -55,7 +55,11 @@ class DecisionTreeResource : public ResourceBase {
 
   // Resets the resource and frees the proto.
   // Caller needs to hold the mutex lock while calling this.
-  void Reset() { decision_tree_.reset(new decision_trees::Model()); }
+  void Reset() {
+    decision_tree_.reset(new decision_trees::Model());
+    node_evaluators_.clear();
+    packed_nodes_.clear();
+  }
 
   mutex* get_mutex() { return &mu_; }
 
@@ -71,11 +75,29 @@ class DecisionTreeResource : public ResourceBase {
                  std::vector<int32>* new_children);
 
  private:
+  // A node of the packed copy of the tree that TraverseTree() walks instead
+  // of the proto. Inequality splits are decided inline as
+  // "value <= threshold", other splits through their evaluator.
+  struct PackedNode {
+    // -1 for leaves, and for splits that are not plain inequalities.
+    int32 feature_id;
+    float threshold;
+    // -1 for leaves.
+    int32 left_id;
+    int32 right_id;
+  };
+
+  // Sets packed_nodes_[node_id] from the node in the proto.
+  void PackNode(int32 node_id);
+
   mutex mu_;
   const TensorForestParams params_;
   std::unique_ptr<decision_trees::Model> decision_tree_;
   std::shared_ptr<LeafModelOperator> model_op_;
   std::vector<std::unique_ptr<DecisionNodeEvaluator>> node_evaluators_;
+  // Indexed by node id. Kept in sync with the structure of the tree, which
+  // only changes in SplitNode() and when it is loaded.
+  std::vector<PackedNode> packed_nodes_;
 };
 
 }  // namespace tensorforest
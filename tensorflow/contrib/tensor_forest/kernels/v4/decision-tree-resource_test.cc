@@ -0,0 +1,81 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/tensor_forest/kernels/v4/decision-tree-resource.h"
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model.pb.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/test_utils.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using tensorflow::decision_trees::InequalityTest;
+using tensorflow::decision_trees::TreeNode;
+using tensorflow::tensorforest::DecisionTreeResource;
+using tensorflow::tensorforest::TensorDataSet;
+using tensorflow::tensorforest::TensorForestParams;
+using tensorflow::tensorforest::TestableDataSet;
+using tensorflow::tensorforest::TreePath;
+
+void AddSplit(TreeNode* node, const string& feature, float threshold,
+              InequalityTest::Type type, int32 left, int32 right) {
+  auto* split = node->mutable_binary_node();
+  split->mutable_left_child_id()->set_value(left);
+  split->mutable_right_child_id()->set_value(right);
+  auto* test = split->mutable_inequality_left_child_test();
+  test->mutable_feature_id()->mutable_id()->set_value(feature);
+  test->mutable_threshold()->set_float_value(threshold);
+  test->set_type(type);
+}
+
+TEST(DecisionTreeResourceTest, TraverseTree) {
+  //        0: f1 < 3
+  //       /         \
+  //     1: leaf    2: f0 <= 4.5
+  //                 /        \
+  //               3: leaf   4: leaf
+  TensorForestParams params;
+  DecisionTreeResource* resource = new DecisionTreeResource(params);
+  core::ScopedUnref unref(resource);
+  auto* tree = resource->mutable_decision_tree()->mutable_decision_tree();
+  for (int32 i = 0; i < 5; ++i) {
+    TreeNode* node = tree->add_nodes();
+    node->mutable_node_id()->set_value(i);
+    node->mutable_leaf();
+  }
+  AddSplit(tree->mutable_nodes(0), "1", 3.0, InequalityTest::LESS_THAN, 1, 2);
+  AddSplit(tree->mutable_nodes(2), "0", 4.5, InequalityTest::LESS_OR_EQUAL, 3,
+           4);
+  resource->MaybeInitialize();
+
+  std::unique_ptr<TensorDataSet> dataset(new TestableDataSet(
+      {0.0, 2.0, 0.0, 3.0, 4.5, 3.0, 5.0, 7.0}, 2));
+  const int32 expected_leaves[] = {1, 3, 3, 4};
+  const int32 expected_depths[] = {1, 2, 2, 2};
+  for (int example = 0; example < 4; ++example) {
+    int32 depth;
+    EXPECT_EQ(expected_leaves[example],
+              resource->TraverseTree(dataset, example, &depth, nullptr));
+    EXPECT_EQ(expected_depths[example], depth);
+
+    // Recording the path walks the proto, which must agree.
+    TreePath path;
+    EXPECT_EQ(expected_leaves[example],
+              resource->TraverseTree(dataset, example, nullptr, &path));
+    EXPECT_EQ(expected_depths[example] + 1, path.nodes_visited_size());
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/tensorboard/db/summary_file_writer.h"
 
+#include <algorithm>
+
 #include "tensorflow/contrib/tensorboard/db/summary_converter.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -21,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -29,11 +32,14 @@ namespace {
 
 class SummaryFileWriter : public SummaryWriterInterface {
  public:
-  SummaryFileWriter(int max_queue, int flush_millis, Env* env)
+  SummaryFileWriter(const SummaryFileWriterOptions& options, Env* env)
       : SummaryWriterInterface(),
         is_initialized_(false),
-        max_queue_(max_queue),
-        flush_millis_(flush_millis),
+        max_queue_(options.max_queue),
+        flush_millis_(options.flush_millis),
+        queue_capacity_(std::max(options.queue_capacity, 1)),
+        block_when_full_(options.block_when_full),
+        compression_type_(options.compression_type),
         env_(env) {}
 
   Status Initialize(const string& logdir, const string& filename_suffix) {
@@ -44,27 +50,44 @@ class SummaryFileWriter : public SummaryWriterInterface {
       }
       TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(logdir));
     }
-    mutex_lock ml(mu_);
-    events_writer_ =
-        tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+    events_writer_ = tensorflow::MakeUnique<EventsWriter>(
+        io::JoinPath(logdir, "events"),
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type_));
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
         events_writer_->InitWithSuffix(filename_suffix),
         "Could not initialize events writer.");
+    mutex_lock ml(mu_);
     last_flush_ = env_->NowMicros();
     is_initialized_ = true;
+    writer_thread_.reset(env_->StartThread(ThreadOptions(),
+                                           "summary_file_writer",
+                                           [this]() { WriterLoop(); }));
     return Status::OK();
   }
 
+  // Waits until the writer thread has written and flushed the events queued
+  // so far.
   Status Flush() override {
     mutex_lock ml(mu_);
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    const int64 flush_request = ++num_flush_requests_;
+    queue_changed_.notify_one();
+    while (num_flushes_ < flush_request) {
+      flushed_.wait(ml);
+    }
+    return flush_status_;
   }
 
   ~SummaryFileWriter() override {
-    (void)Flush();  // Ignore errors.
+    {
+      mutex_lock ml(mu_);
+      shutting_down_ = true;
+      queue_changed_.notify_one();
+    }
+    // Joins the writer thread, which writes the remaining events first.
+    writer_thread_.reset();
   }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
@@ -129,13 +152,19 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return WriteEvent(std::move(e));
   }
 
+  // Queues the event for the writer thread. When the queue is full, this
+  // either waits for room or drops the event, depending on the options.
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
-    queue_.emplace_back(std::move(event));
-    if (queue_.size() > max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+    while (queue_.size() >= queue_capacity_) {
+      if (!block_when_full_) {
+        ++num_dropped_events_;
+        return Status::OK();
+      }
+      queue_not_full_.wait(ml);
     }
+    queue_.emplace_back(std::move(event));
+    queue_changed_.notify_one();
     return Status::OK();
   }
 
@@ -146,26 +175,89 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
-      events_writer_->WriteEvent(*e);
+  // Returns whether the writer thread should write the queued events now.
+  bool ShouldWrite() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return shutting_down_ || num_flushes_ < num_flush_requests_ ||
+           queue_.size() > max_queue_ ||
+           (!queue_.empty() &&
+            env_->NowMicros() - last_flush_ >= 1000 * flush_millis_);
+  }
+
+  // Writes the queued events in batches, off the threads of the callers, so
+  // that slow file systems don't stall them.
+  void WriterLoop() {
+    while (true) {
+      std::vector<std::unique_ptr<Event>> batch;
+      int64 flush_request;
+      int64 num_dropped_events;
+      bool shutting_down;
+      {
+        mutex_lock ml(mu_);
+        while (!ShouldWrite()) {
+          if (queue_.empty()) {
+            queue_changed_.wait(ml);
+          } else {
+            // Wakes up when the queued events are due to be flushed.
+            const int64 elapsed_millis =
+                (env_->NowMicros() - last_flush_) / 1000;
+            WaitForMilliseconds(&ml, &queue_changed_,
+                                std::max<int64>(flush_millis_ - elapsed_millis,
+                                                1));
+          }
+        }
+        batch.swap(queue_);
+        queue_not_full_.notify_all();
+        flush_request = num_flush_requests_;
+        num_dropped_events = num_dropped_events_;
+        num_dropped_events_ = 0;
+        shutting_down = shutting_down_;
+      }
+      if (num_dropped_events > 0) {
+        LOG(WARNING) << "Dropped " << num_dropped_events
+                     << " summary events since the queue was full.";
+      }
+      for (const std::unique_ptr<Event>& e : batch) {
+        events_writer_->WriteEvent(*e);
+      }
+      Status status = events_writer_->Flush();
+      if (!status.ok()) {
+        errors::AppendToMessage(&status, "Could not flush events file.");
+      }
+      {
+        mutex_lock ml(mu_);
+        flush_status_ = status;
+        num_flushes_ = flush_request;
+        last_flush_ = env_->NowMicros();
+        flushed_.notify_all();
+      }
+      if (shutting_down) return;
     }
-    queue_.clear();
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
-                                    "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
-    return Status::OK();
   }
 
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
+  const int queue_capacity_;
+  const bool block_when_full_;
+  const string compression_type_;
+  uint64 last_flush_ GUARDED_BY(mu_);
   Env* env_;
   mutex mu_;
+  condition_variable queue_changed_;
+  condition_variable queue_not_full_;
+  condition_variable flushed_;
   std::vector<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
-  // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(mu_);
+  int64 num_dropped_events_ GUARDED_BY(mu_) = 0;
+  // Flush() requests flushes by number, and the writer thread records the
+  // last one it completed, with its status.
+  int64 num_flush_requests_ GUARDED_BY(mu_) = 0;
+  int64 num_flushes_ GUARDED_BY(mu_) = 0;
+  Status flush_status_ GUARDED_BY(mu_);
+  bool shutting_down_ GUARDED_BY(mu_) = false;
+  // A pointer to allow deferred construction. Only the writer thread uses it
+  // once it has started.
+  std::unique_ptr<EventsWriter> events_writer_;
+  std::unique_ptr<Thread> writer_thread_;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       GUARDED_BY(mu_);
 };
@@ -176,7 +268,17 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& logdir,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result) {
-  SummaryFileWriter* w = new SummaryFileWriter(max_queue, flush_millis, env);
+  SummaryFileWriterOptions options;
+  options.max_queue = max_queue;
+  options.flush_millis = flush_millis;
+  return CreateSummaryFileWriter(options, logdir, filename_suffix, env, result);
+}
+
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result) {
+  SummaryFileWriter* w = new SummaryFileWriter(options, env);
   const Status s = w->Initialize(logdir, filename_suffix);
   if (!s.ok()) {
     w->Unref();
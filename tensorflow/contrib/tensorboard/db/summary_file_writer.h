@@ -28,9 +28,9 @@ namespace tensorflow {
 /// makes this summary writer suitable for file systems like GCS.
 ///
 /// It will enqueue up to max_queue summaries, and flush at least every
-/// flush_millis milliseconds. The summaries will be written to the
-/// directory specified by logdir and with the filename suffixed by
-/// filename_suffix. The caller owns a reference to result if the
+/// flush_millis milliseconds, from a background thread. The summaries
+/// will be written to the directory specified by logdir and with the
+/// filename suffixed by filename_suffix. The caller owns a reference to result if the
 /// returned status is ok. The Env object must not be destroyed until
 /// after the returned writer.
 Status CreateSummaryFileWriter(int max_queue, int flush_millis,
@@ -38,6 +38,30 @@ Status CreateSummaryFileWriter(int max_queue, int flush_millis,
                                const string& filename_suffix, Env* env,
                                SummaryWriterInterface** result);
 
+/// \brief Options of a SummaryWriterInterface which writes to a file.
+struct SummaryFileWriterOptions {
+  /// The events are written by a background thread once more than
+  /// max_queue of them are queued, or once the oldest has waited for
+  /// flush_millis milliseconds.
+  int max_queue = 10;
+  int flush_millis = 2 * 60 * 1000;
+  /// The most events that can be queued for the background thread.
+  int queue_capacity = 1000;
+  /// Whether writing an event waits for room when the queue is full, rather
+  /// than dropping the event.
+  bool block_when_full = true;
+  /// "" or "ZLIB". The records of compressed files can only be read with
+  /// the same compression type.
+  string compression_type;
+};
+
+/// \brief Creates SummaryWriterInterface which writes to a file from a
+/// background thread, as configured by options.
+Status CreateSummaryFileWriter(const SummaryFileWriterOptions& options,
+                               const string& logdir,
+                               const string& filename_suffix, Env* env,
+                               SummaryWriterInterface** result);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CONTRIB_TENSORBOARD_DB_SUMMARY_FILE_WRITER_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -213,5 +214,49 @@ TEST_F(SummaryFileWriterTest, WallTime) {
       [](const Event& e) { EXPECT_EQ(e.wall_time(), 7.023); }));
 }
 
+TEST_F(SummaryFileWriterTest, WriteManyCompressedEvents) {
+  SummaryFileWriterOptions options;
+  options.max_queue = 3;
+  options.queue_capacity = 4;
+  options.compression_type = "ZLIB";
+  SummaryWriterInterface* writer;
+  TF_ASSERT_OK(CreateSummaryFileWriter(options, testing::TmpDir(),
+                                       "many_compressed_test", &env_, &writer));
+  {
+    core::ScopedUnref deleter(writer);
+    // Writing blocks while the queue is full, so no event is dropped.
+    for (int i = 0; i < 100; ++i) {
+      std::unique_ptr<Event> e{new Event};
+      e->set_step(i);
+      TF_ASSERT_OK(writer->WriteEvent(std::move(e)));
+    }
+  }
+
+  std::vector<string> files;
+  TF_ASSERT_OK(env_.GetChildren(testing::TmpDir(), &files));
+  int num_files = 0;
+  for (const string& f : files) {
+    if (!str_util::StrContains(f, "many_compressed_test")) continue;
+    ++num_files;
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_ASSERT_OK(env_.NewRandomAccessFile(io::JoinPath(testing::TmpDir(), f),
+                                          &read_file));
+    io::RecordReader reader(
+        read_file.get(),
+        io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB"));
+    string record;
+    uint64 offset = 0;
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));  // The version event.
+    for (int i = 0; i < 100; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+      Event e;
+      ASSERT_TRUE(e.ParseFromString(record));
+      EXPECT_EQ(i, e.step());
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+  }
+  EXPECT_EQ(1, num_files);
+}
+
 }  // namespace
 }  // namespace tensorflow
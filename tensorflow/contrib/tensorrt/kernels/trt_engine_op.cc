@@ -24,11 +24,14 @@ limitations under the License.
 #include "tensorflow/contrib/tensorrt/resources/trt_resources.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 #if GOOGLE_CUDA
 #if GOOGLE_TENSORRT
@@ -143,6 +146,12 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   OP_REQUIRES_OK(context, context->GetAttr("cached_engine_batches",
                                            &cached_engine_batches_));
   std::sort(cached_engine_batches_.begin(), cached_engine_batches_.end());
+  {
+    mutex_lock lock(engine_mutex_);
+    engine_cache_.set_capacity(std::max(1, max_cached_engines_));
+  }
+  OP_REQUIRES_OK(context, ReadStringFromEnvVar("TF_TRT_ENGINE_CACHE_DIR", "",
+                                               &engine_cache_dir_));
   if (VLOG_IS_ON(1)) {
     string s("Engine Batches= ");
     for (auto i : cached_engine_batches_) {
@@ -239,31 +248,16 @@ void TRTEngineOp::ExecuteCalibration(OpKernelContext* ctx,
 }
 
 int TRTEngineOp::GetEngineBatch(OpKernelContext* ctx) {
-  int num_batch = ctx->input(0).shape().dim_size(0);
-  int smallest_engine = 0;
+  const int num_batch = ctx->input(0).shape().dim_size(0);
   for (const auto i : cached_engine_batches_) {
     if (i >= num_batch) {
-      smallest_engine = i;
-      break;
-    }
-  }
-  // TODO(sami): Need an LRU here
-  if (smallest_engine == 0) {
-    if (max_cached_engines_ > cached_engine_batches_.size()) {
-      smallest_engine = num_batch;
-      cached_engine_batches_.push_back(num_batch);
-      VLOG(1) << "Running with batch size " << num_batch;
-    } else {
-      string msg =
-          StrCat("Engine buffer is full. buffer limit=", max_cached_engines_,
-                 ", current entries=");
-      for (auto i : cached_engine_batches_) StrAppend(&msg, i, ",");
-      StrAppend(&msg, "Requested batch=", num_batch);
-      LOG(WARNING) << msg;
-      return -1;
+      return i;
     }
   }
-  return smallest_engine;
+  // Batches larger than the configured ones get engines of their own, which
+  // engine_cache_ evicts when they aren't used.
+  VLOG(1) << "Running with batch size " << num_batch;
+  return num_batch;
 }
 
 void TRTEngineOp::ComputeAsync(OpKernelContext* ctx,
@@ -275,23 +269,20 @@ void TRTEngineOp::ComputeAsync(OpKernelContext* ctx,
     return;
   }
   const int smallest_engine = GetEngineBatch(ctx);
-  if (smallest_engine < 0) {
-    LOG(WARNING) << "Failed to get engine batch, running native segment";
-    ExecuteNativeSegment(ctx, helper);
-    return;
-  }
-
   const int num_batch = ctx->input(0).shape().dim_size(0);
-  auto& engine_ctx_pair = GetEngine(smallest_engine, ctx);
-  auto& trt_engine_ptr = engine_ctx_pair.first;
-  if (!trt_engine_ptr) {
-    LOG(WARNING) << "Engine retrieval for batch size " << num_batch
-                 << " failed. Running native segment";
+  // Holds the engine until the execution is enqueued, even if engine_cache_
+  // evicts it meanwhile.
+  std::shared_ptr<EngineCtxPair> engine_ctx_pair =
+      GetEngine(smallest_engine, ctx);
+  if (engine_ctx_pair == nullptr || !engine_ctx_pair->first) {
+    VLOG(1) << "No engine for batch size " << num_batch
+            << " yet. Running native segment";
     ExecuteNativeSegment(ctx, helper);
     return;
   }
-  const bool retry = ExecuteTrtEngine(ctx, num_batch, trt_engine_ptr.get(),
-                                      engine_ctx_pair.second.get());
+  const bool retry =
+      ExecuteTrtEngine(ctx, num_batch, engine_ctx_pair->first.get(),
+                       engine_ctx_pair->second.get());
   if (retry) {
     LOG(WARNING) << "Failed to execute engine, retrying with native segment";
     ExecuteNativeSegment(ctx, helper);
@@ -418,11 +409,15 @@ bool TRTEngineOp::ExecuteTrtEngine(
 
 TRTEngineOp::~TRTEngineOp() {
   // We need to manually destroy the engine and execution context before
-  // the allocator is destructed.
-  for (auto& eng : engine_map_) {
-    eng.second.first.reset();
-    eng.second.second.reset();
+  // the allocator is destructed, after the background builds are done.
+  {
+    mutex_lock lock(engine_mutex_);
+    while (!engines_building_.empty()) {
+      engine_built_.wait(lock);
+    }
+    engine_cache_.Clear();
   }
+  static_engine_ctx_pair_.reset();
   allocator_.reset();
 }
 
@@ -439,89 +434,195 @@ nvinfer1::IGpuAllocator* TRTEngineOp::GetAllocator(OpKernelContext* ctx) {
   return allocator_.get();
 }
 
-TRTEngineOp::EngineCtxPair& TRTEngineOp::GetEngine(int batch_size,
-                                                   OpKernelContext* ctx) {
-  static EngineCtxPair null_pair = {
-      TrtUniquePtrType<nvinfer1::ICudaEngine>(nullptr),
-      TrtUniquePtrType<nvinfer1::IExecutionContext>(nullptr)};
-  // TODO(sami): This method needs to be re-written to use resource manager and
-  // with LRU mechanism option.
+std::shared_ptr<TRTEngineOp::EngineCtxPair> TRTEngineOp::GetEngine(
+    int batch_size, OpKernelContext* ctx) {
+  // TODO(sami): This method needs to be re-written to use resource manager.
   tensorflow::mutex_lock lock(engine_mutex_);
 
   if (static_engine_) {
-    if (engine_map_.size()) {
-      if (engine_map_.begin()->first >= batch_size) {
-        return engine_map_.begin()->second;
-      }
-      return null_pair;
-    }
-    TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
+    if (static_engine_ctx_pair_ == nullptr) {
+      TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
 #if NV_TENSORRT_MAJOR > 3
-    auto allocator = GetAllocator(ctx);
-    if (allocator == nullptr) {
-      return null_pair;
-    }
-    infer->setGpuAllocator(allocator);
+      auto allocator = GetAllocator(ctx);
+      if (allocator == nullptr) {
+        return nullptr;
+      }
+      infer->setGpuAllocator(allocator);
 #endif
-    TrtUniquePtrType<nvinfer1::ICudaEngine> static_engine(
-        infer->deserializeCudaEngine(serialized_segment_.c_str(),
-                                     serialized_segment_.size(),
-                                     PluginFactoryTensorRT::GetInstance()));
-    auto raw_static_engine = static_engine.get();
-    const auto max_batch_size = raw_static_engine->getMaxBatchSize();
-    engine_map_[max_batch_size] = {
-        std::move(static_engine),
-        TrtUniquePtrType<nvinfer1::IExecutionContext>(
-            raw_static_engine->createExecutionContext())};
-    // Runtime is safe to delete after engine creation
-    serialized_segment_.clear();
-    if (max_batch_size < batch_size) {
-      return null_pair;
+      TrtUniquePtrType<nvinfer1::ICudaEngine> static_engine(
+          infer->deserializeCudaEngine(serialized_segment_.c_str(),
+                                       serialized_segment_.size(),
+                                       PluginFactoryTensorRT::GetInstance()));
+      auto raw_static_engine = static_engine.get();
+      static_engine_ctx_pair_ = std::make_shared<EngineCtxPair>(
+          std::move(static_engine),
+          TrtUniquePtrType<nvinfer1::IExecutionContext>(
+              raw_static_engine->createExecutionContext()));
+      // Runtime is safe to delete after engine creation
+      serialized_segment_.clear();
     }
-    return engine_map_.at(max_batch_size);
+    if (static_engine_ctx_pair_->first->getMaxBatchSize() < batch_size) {
+      return nullptr;
+    }
+    return static_engine_ctx_pair_;
   }  // static_engine_
 
-  // Handle the dynamic engine case.
-  auto engine_it = engine_map_.find(batch_size);
-  if (engine_it == engine_map_.end() &&
-      engine_map_.size() < (size_t)max_cached_engines_) {
-    nvinfer1::IGpuAllocator* allocator = nullptr;
-#if NV_TENSORRT_MAJOR > 3
-    allocator = GetAllocator(ctx);
-    if (allocator == nullptr) {
-      return null_pair;
+  // Handle the dynamic engine case. Engines are keyed by their batch size and
+  // the other dimensions of the inputs.
+  std::vector<tensorflow::PartialTensorShape> shapes;
+  string key = StrCat(batch_size);
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    const TensorShape& shape = ctx->input(i).shape();
+    shapes.emplace_back(shape);
+    StrAppend(&key, "_");
+    for (int d = 1; d < shape.dims(); ++d) {
+      StrAppend(&key, d > 1 ? "x" : "", shape.dim_size(d));
     }
+  }
+  std::shared_ptr<EngineCtxPair>* cached = engine_cache_.Lookup(key);
+  if (cached != nullptr) {
+    return *cached;
+  }
+  if (engines_building_.count(key) != 0) {
+    return nullptr;
+  }
+  nvinfer1::IGpuAllocator* allocator = nullptr;
+#if NV_TENSORRT_MAJOR > 3
+  allocator = GetAllocator(ctx);
+  if (allocator == nullptr) {
+    return nullptr;
+  }
 #endif
-    std::vector<tensorflow::PartialTensorShape> shapes;
-    for (int i = 0; i < ctx->num_inputs(); ++i) {
-      shapes.emplace_back(ctx->input(i).shape());
+  std::shared_ptr<EngineCtxPair> engine_ctx_pair =
+      LoadSerializedEngine(key, allocator);
+  if (engine_ctx_pair != nullptr) {
+    CacheEngineLocked(key, engine_ctx_pair);
+    return engine_ctx_pair;
+  }
+
+  if (engine_cache_.size() == 0) {
+    // Without any engine to fall back on, the first one is built right away.
+    bool cache_result = false;
+    engine_ctx_pair =
+        BuildEngine(key, shapes, batch_size, allocator, &cache_result);
+    if (cache_result) {
+      CacheEngineLocked(key, engine_ctx_pair);
     }
-    TrtUniquePtrType<nvinfer1::ICudaEngine> engine;
-    bool convert_successfully = false;
-    VLOG(0) << name() << " Constructing a new engine with batch size "
-            << batch_size;
-    // Up to this point, calibrator_ can never be empty, since otherwise it
-    // means calibration_mode_ is true and this path won't get executed.
-    auto status = convert::ConvertGraphDefToEngine(
-        segment_graph_, precision_mode_, batch_size, workspace_size_, shapes,
-        &logger, allocator, calibrator_.get(), &engine, &convert_successfully);
+    return engine_ctx_pair;
+  }
+
+  // Engines for new shapes are built in the background, while the native
+  // segment runs the inputs that need them.
+  const int cuda_gpu_id = ctx->device()->tensorflow_gpu_device_info()->gpu_id;
+  engines_building_.insert(key);
+  ctx->env()->SchedClosure([this, key, shapes, batch_size, allocator,
+                            cuda_gpu_id]() {
+    if (cudaSetDevice(cuda_gpu_id) != cudaSuccess) {
+      LOG(ERROR) << "Couldn't set cuda device to " << cuda_gpu_id
+                 << " to build an engine for " << name();
+    }
+    bool cache_result = false;
+    std::shared_ptr<EngineCtxPair> engine_ctx_pair =
+        BuildEngine(key, shapes, batch_size, allocator, &cache_result);
+    mutex_lock lock(engine_mutex_);
+    if (cache_result) {
+      CacheEngineLocked(key, std::move(engine_ctx_pair));
+    }
+    engines_building_.erase(key);
+    engine_built_.notify_all();
+  });
+  return nullptr;
+}
+
+std::shared_ptr<TRTEngineOp::EngineCtxPair> TRTEngineOp::BuildEngine(
+    const string& key, const std::vector<PartialTensorShape>& shapes,
+    int batch_size, nvinfer1::IGpuAllocator* allocator, bool* cache_result) {
+  TrtUniquePtrType<nvinfer1::ICudaEngine> engine;
+  bool convert_successfully = false;
+  VLOG(0) << name() << " Constructing a new engine with batch size "
+          << batch_size;
+  // Up to this point, calibrator_ can never be empty, since otherwise it
+  // means calibration_mode_ is true and this path won't get executed.
+  auto status = convert::ConvertGraphDefToEngine(
+      segment_graph_, precision_mode_, batch_size, workspace_size_, shapes,
+      &logger, allocator, calibrator_.get(), &engine, &convert_successfully);
+  if (!status.ok()) {
+    // If the network was built but the engine wasn't, the build probably
+    // failed for internal reasons, so it isn't retried in the future.
+    *cache_result = convert_successfully;
+    LOG(WARNING) << "Engine creation for batch size " << batch_size
+                 << " failed " << status;
+    return nullptr;
+  }
+  VLOG(1) << "Conversion is done";
+  *cache_result = true;
+  if (!engine_cache_dir_.empty()) {
+    TrtUniquePtrType<nvinfer1::IHostMemory> engine_data(engine->serialize());
+    const string path = SerializedEnginePath(key);
+    status = WriteStringToFile(
+        Env::Default(), path,
+        StringPiece(static_cast<const char*>(engine_data->data()),
+                    engine_data->size()));
     if (!status.ok()) {
-      if (convert_successfully) {
-        // This means it fail to build the engine even when the network is built
-        // successfully, probably due to internal issues. In this case we don't
-        // retry in the future.
-        engine_map_[batch_size] = {nullptr, nullptr};
-      }
-      LOG(WARNING) << "Engine creation for batch size " << batch_size
-                   << " failed " << status;
-      return null_pair;
+      LOG(WARNING) << "Failed to serialize engine to " << path << ": "
+                   << status;
     }
-    VLOG(1) << "Conversion is done";
-    TrtUniquePtrType<nvinfer1::IExecutionContext> exec_context(
-        engine->createExecutionContext());
-    engine_map_[batch_size] = {std::move(engine), std::move(exec_context)};
   }
-  return engine_map_.at(batch_size);
+  TrtUniquePtrType<nvinfer1::IExecutionContext> exec_context(
+      engine->createExecutionContext());
+  return std::make_shared<EngineCtxPair>(std::move(engine),
+                                         std::move(exec_context));
+}
+
+void TRTEngineOp::CacheEngineLocked(
+    const string& key, std::shared_ptr<EngineCtxPair> engine_ctx_pair) {
+  std::vector<std::shared_ptr<EngineCtxPair>> evicted;
+  engine_cache_.Insert(key, std::move(engine_ctx_pair), &evicted);
+  if (!evicted.empty()) {
+    VLOG(1) << name() << " evicted " << evicted.size()
+            << " least recently used engines";
+  }
+}
+
+string TRTEngineOp::SerializedEnginePath(const string& key) const {
+  string op_name = name();
+  std::replace(op_name.begin(), op_name.end(), '/', '_');
+  return io::JoinPath(engine_cache_dir_,
+                      StrCat(op_name, "_", precision_mode_, "_", key, ".trt"));
+}
+
+std::shared_ptr<TRTEngineOp::EngineCtxPair> TRTEngineOp::LoadSerializedEngine(
+    const string& key, nvinfer1::IGpuAllocator* allocator) {
+  if (engine_cache_dir_.empty()) {
+    return nullptr;
+  }
+  const string path = SerializedEnginePath(key);
+  if (!Env::Default()->FileExists(path).ok()) {
+    return nullptr;
+  }
+  string engine_data;
+  Status status = ReadFileToString(Env::Default(), path, &engine_data);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read serialized engine " << path << ": "
+                 << status;
+    return nullptr;
+  }
+  TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
+#if NV_TENSORRT_MAJOR > 3
+  infer->setGpuAllocator(allocator);
+#endif
+  TrtUniquePtrType<nvinfer1::ICudaEngine> engine(infer->deserializeCudaEngine(
+      engine_data.data(), engine_data.size(),
+      PluginFactoryTensorRT::GetInstance()));
+  if (engine == nullptr) {
+    LOG(WARNING) << "Failed to deserialize engine " << path;
+    return nullptr;
+  }
+  VLOG(1) << name() << " loaded serialized engine " << path;
+  TrtUniquePtrType<nvinfer1::IExecutionContext> exec_context(
+      engine->createExecutionContext());
+  return std::make_shared<EngineCtxPair>(std::move(engine),
+                                         std::move(exec_context));
 }
 
 tensorflow::Status TRTEngineOp::AllocateCalibrationResources(
@@ -17,11 +17,13 @@ limitations under the License.
 #define TENSORFLOW_CONTRIB_TENSORRT_KERNELS_TRT_ENGINE_OP_H_
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/contrib/tensorrt/convert/utils.h"
 #include "tensorflow/contrib/tensorrt/log/trt_logger.h"
 #include "tensorflow/contrib/tensorrt/resources/trt_allocator.h"
+#include "tensorflow/contrib/tensorrt/resources/trt_lru_cache.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -74,15 +76,58 @@ class TRTEngineOp : public AsyncOpKernel {
   typedef std::pair<TrtUniquePtrType<nvinfer1::ICudaEngine>,
                     TrtUniquePtrType<nvinfer1::IExecutionContext>>
       EngineCtxPair;
-  EngineCtxPair& GetEngine(int batch_size, OpKernelContext* ctx);
+
+  // Returns the engine for the inputs of `ctx` with a maximum batch size of
+  // `batch_size`, or null if there is none yet, in which case it may be
+  // being built in the background.
+  std::shared_ptr<EngineCtxPair> GetEngine(int batch_size,
+                                           OpKernelContext* ctx);
+
+  // Builds an engine for inputs of `shapes`. Returns null if the build fails,
+  // and sets `*cache_result` to whether the result should be cached rather
+  // than retried by later calls.
+  std::shared_ptr<EngineCtxPair> BuildEngine(
+      const string& key, const std::vector<PartialTensorShape>& shapes,
+      int batch_size, nvinfer1::IGpuAllocator* allocator, bool* cache_result);
+
+  // Adds an engine to engine_cache_, evicting the least recently used ones
+  // beyond max_cached_engines_.
+  void CacheEngineLocked(const string& key,
+                         std::shared_ptr<EngineCtxPair> engine_ctx_pair)
+      EXCLUSIVE_LOCKS_REQUIRED(engine_mutex_);
+
+  // Returns the path of the file in engine_cache_dir_ that holds the
+  // serialized engine for `key`.
+  string SerializedEnginePath(const string& key) const;
+
+  // Returns the engine deserialized from engine_cache_dir_ for `key`, or null
+  // if there is none.
+  std::shared_ptr<EngineCtxPair> LoadSerializedEngine(
+      const string& key, nvinfer1::IGpuAllocator* allocator);
 
   // Return engine batch closest to input batch.
   int GetEngineBatch(OpKernelContext* ctx);
 
   nvinfer1::IGpuAllocator* GetAllocator(OpKernelContext* ctx);
 
-  // map to keep engines and their execution context for given batch size.
-  std::unordered_map<int, EngineCtxPair> engine_map_;
+  // The engine deserialized from serialized_segment_ when static_engine_.
+  std::shared_ptr<EngineCtxPair> static_engine_ctx_pair_;
+
+  // Engines and their execution contexts for the shapes of the inputs they
+  // were built for, without the batch dimension, and their batch sizes. Null
+  // values mark the shapes for which an engine couldn't be built.
+  LRUCache<string, std::shared_ptr<EngineCtxPair>> engine_cache_
+      GUARDED_BY(engine_mutex_);
+
+  // Keys of the engines that are being built in the background.
+  std::unordered_set<string> engines_building_ GUARDED_BY(engine_mutex_);
+  condition_variable engine_built_;
+
+  // The directory that built engines are serialized to, and that engines are
+  // deserialized from before they are built, from the TF_TRT_ENGINE_CACHE_DIR
+  // environment variable. Pointing it at a directory shipped with the
+  // SavedModel lets new serving replicas start with built engines.
+  string engine_cache_dir_;
   std::vector<string> input_nodes_;
   std::vector<string> output_nodes_;
 
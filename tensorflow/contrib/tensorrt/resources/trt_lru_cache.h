@@ -0,0 +1,104 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_LRU_CACHE_H_
+#define TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_LRU_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+// A map that holds at most `capacity` entries, and evicts the least recently
+// used one to make room for a new one. Not thread-safe.
+template <class Key, class Value, class HashFunction = std::hash<Key>>
+class LRUCache {
+ public:
+  explicit LRUCache(size_t capacity = 1) : capacity_(capacity) {
+    CHECK_GT(capacity, 0);
+  }
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  // Evicts the least recently used entries beyond `capacity`.
+  void set_capacity(size_t capacity) {
+    CHECK_GT(capacity, 0);
+    capacity_ = capacity;
+    EvictLeastRecentlyUsed(nullptr);
+  }
+
+  void Clear() {
+    entries_.clear();
+    order_.clear();
+  }
+
+  bool Contains(const Key& key) const { return entries_.count(key) != 0; }
+
+  // Returns the value of `key` and makes it the most recently used entry, or
+  // returns null if the cache has no such entry.
+  Value* Lookup(const Key& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return nullptr;
+    order_.splice(order_.begin(), order_, it->second.second);
+    return &it->second.first;
+  }
+
+  // Sets the value of `key`, making it the most recently used entry, and
+  // moves the values of the entries it evicts to `evicted` unless it is null.
+  void Insert(const Key& key, Value value, std::vector<Value>* evicted) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      it->second.first = std::move(value);
+      order_.splice(order_.begin(), order_, it->second.second);
+      return;
+    }
+    order_.push_front(key);
+    entries_.emplace(key, std::make_pair(std::move(value), order_.begin()));
+    EvictLeastRecentlyUsed(evicted);
+  }
+
+  // Returns the keys from the most to the least recently used.
+  std::vector<Key> Keys() const {
+    return std::vector<Key>(order_.begin(), order_.end());
+  }
+
+ private:
+  void EvictLeastRecentlyUsed(std::vector<Value>* evicted) {
+    while (entries_.size() > capacity_) {
+      auto it = entries_.find(order_.back());
+      if (evicted != nullptr) evicted->push_back(std::move(it->second.first));
+      entries_.erase(it);
+      order_.pop_back();
+    }
+  }
+
+  size_t capacity_;
+  // The keys from the most to the least recently used.
+  std::list<Key> order_;
+  std::unordered_map<
+      Key, std::pair<Value, typename std::list<Key>::iterator>, HashFunction>
+      entries_;
+};
+
+}  // namespace tensorrt
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_TENSORRT_RESOURCES_TRT_LRU_CACHE_H_
@@ -0,0 +1,63 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/tensorrt/resources/trt_lru_cache.h"
+
+#include <memory>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+TEST(LRUCacheTest, Basic) {
+  LRUCache<string, int> cache(2);
+  EXPECT_EQ(nullptr, cache.Lookup("a"));
+  cache.Insert("a", 1, nullptr);
+  cache.Insert("b", 2, nullptr);
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(1, *cache.Lookup("a"));
+  EXPECT_EQ(std::vector<string>({"a", "b"}), cache.Keys());
+
+  // "b" is the least recently used entry since "a" was looked up.
+  std::vector<int> evicted;
+  cache.Insert("c", 3, &evicted);
+  EXPECT_EQ(std::vector<int>({2}), evicted);
+  EXPECT_FALSE(cache.Contains("b"));
+  EXPECT_EQ(std::vector<string>({"c", "a"}), cache.Keys());
+
+  // Replacing a value evicts nothing.
+  evicted.clear();
+  cache.Insert("a", 4, &evicted);
+  EXPECT_TRUE(evicted.empty());
+  EXPECT_EQ(4, *cache.Lookup("a"));
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(LRUCacheTest, SetCapacity) {
+  LRUCache<int, std::unique_ptr<int>> cache(3);
+  for (int i = 0; i < 3; ++i) {
+    cache.Insert(i, std::unique_ptr<int>(new int(i)), nullptr);
+  }
+  cache.set_capacity(1);
+  EXPECT_EQ(std::vector<int>({2}), cache.Keys());
+  EXPECT_EQ(2, **cache.Lookup(2));
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.Lookup(2));
+}
+
+}  // namespace tensorrt
+}  // namespace tensorflow
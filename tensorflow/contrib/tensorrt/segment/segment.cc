@@ -361,6 +361,34 @@ void ContractEdge(SimpleEdge* edge, SimpleGraph* graph,
   }
 }
 
+namespace {
+
+// Returns the estimated gain of converting 'segment_nodes', which is the gain
+// of its nodes minus the cost of the data edges that enter or leave it.
+float EstimateSegmentGain(
+    const std::set<const tensorflow::Node*>& segment_nodes,
+    const SegmentOptions& options) {
+  int num_boundary_edges = 0;
+  for (const tensorflow::Node* node : segment_nodes) {
+    for (const tensorflow::Edge* edge : node->in_edges()) {
+      if (!edge->IsControlEdge() && !edge->src()->IsSource() &&
+          !segment_nodes.count(edge->src())) {
+        ++num_boundary_edges;
+      }
+    }
+    for (const tensorflow::Edge* edge : node->out_edges()) {
+      if (!edge->IsControlEdge() && !edge->dst()->IsSink() &&
+          !segment_nodes.count(edge->dst())) {
+        ++num_boundary_edges;
+      }
+    }
+  }
+  return options.node_gain * segment_nodes.size() -
+         options.boundary_edge_cost * num_boundary_edges;
+}
+
+}  // namespace
+
 tensorflow::Status SegmentGraph(
     const tensorflow::Graph* tf_graph,
     const std::function<bool(const tensorflow::Node*)>& candidate_fn,
@@ -606,6 +634,17 @@ tensorflow::Status SegmentGraph(
       continue;
     }
 
+    // Don't use segments that would not pay for the copies at their
+    // boundaries.
+    const float gain = EstimateSegmentGain(segment_nodes, options);
+    if (gain < options.minimum_segment_gain) {
+      VLOG(1) << "Segment " << segments->size() << " has an estimated gain of "
+              << gain << ", dropping";
+      continue;
+    }
+    VLOG(1) << "Segment " << segments->size() << " has an estimated gain of "
+            << gain;
+
     // TODO(sami): Make segmenter placement aware once trtscopes are in place
     std::set<string> segment_node_names;
     for (auto node : itr.second) segment_node_names.insert(node->name());
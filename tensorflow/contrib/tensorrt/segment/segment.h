@@ -38,6 +38,13 @@ struct SegmentOptions {
   // Segment must contain at least this many nodes.
   int minimum_segment_size = 2;
   std::set<string> exclude_node_list;
+  // The estimated gain of running a node in TensorRT, and the estimated cost
+  // of moving a tensor across the boundary of a segment, in the same
+  // arbitrary unit. A segment is dropped when the gain of its nodes minus the
+  // cost of its boundary edges is below minimum_segment_gain.
+  float node_gain = 1.0f;
+  float boundary_edge_cost = 0.0f;
+  float minimum_segment_gain = 0.0f;
 };
 
 // Get the subgraphs of a graph that can be handled by TensorRT.
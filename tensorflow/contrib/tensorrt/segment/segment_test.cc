@@ -150,6 +150,33 @@ TEST_F(SegmentTest, Simple) {
   RunTest(&g, all_adds, all_adds, without_add3, {all_adds});
 }
 
+TEST_F(SegmentTest, MinimumSegmentGain) {
+  //           feed
+  //          //  \\
+  //       add0    add1
+  //          \    /
+  //           add2
+  Scope s = Scope::NewRootScope();
+  auto feed = ops::Placeholder(s.WithOpName("feed"), DT_FLOAT);
+  auto add0 = ops::Add(s.WithOpName("add0"), feed, feed);
+  auto add1 = ops::Add(s.WithOpName("add1"), feed, feed);
+  auto add2 = ops::Add(s.WithOpName("add2"), add0, add1);
+  tensorflow::Graph g(OpRegistry::Global());
+  TF_EXPECT_OK(s.ToGraph(&g));
+
+  // The segment has 3 nodes and 4 input edges, so its gain is 3 - 4 * 0.5.
+  const std::set<string> all_adds = {"add0", "add1", "add2"};
+  default_options_.boundary_edge_cost = 0.5f;
+  RunTest(&g, all_adds, all_adds, all_adds, {all_adds});
+
+  default_options_.minimum_segment_gain = 1.5f;
+  RunTest(&g, all_adds, all_adds, all_adds, {});
+
+  // Higher node gains, e.g. from lower precisions, make up for the copies.
+  default_options_.node_gain = 2.0f;
+  RunTest(&g, all_adds, all_adds, all_adds, {all_adds});
+}
+
 TEST_F(SegmentTest, AvoidCycle) {
   //           feed
   //          //  \\
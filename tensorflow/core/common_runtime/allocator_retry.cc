@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
+#include "tensorflow/core/lib/core/memory_pressure.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -42,16 +43,28 @@ void* AllocatorRetry::AllocateRaw(
       if (first) {
         deadline_micros = now + max_millis_to_wait * 1000;
         first = false;
+        // Retry once after registering: a deallocation that completes
+        // before the registration is seen by the retry, and one that
+        // completes after it takes mu_ to notify us.
+        num_waiters_.fetch_add(1);
+        continue;
+      }
+      // Ask the holders of reclaimable memory to give some back before
+      // waiting for it.
+      if (MemoryPressureRegistry::Global()->ReleaseMemory(num_bytes) > 0) {
+        continue;
       }
       if (now < deadline_micros) {
         mutex_lock l(mu_);
         WaitForMilliseconds(&l, &memory_returned_,
                             (deadline_micros - now) / 1000);
       } else {
-        return alloc_func(alignment, num_bytes, true);
+        ptr = alloc_func(alignment, num_bytes, true);
+        break;
       }
     }
   }
+  if (!first) num_waiters_.fetch_sub(1);
   return ptr;
 }
 
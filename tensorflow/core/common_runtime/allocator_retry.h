@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATOR_RETRY_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATOR_RETRY_H_
 
+#include <atomic>
+
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -31,10 +33,12 @@ class AllocatorRetry {
   // 'verbose_failure' will be false.  If return value is nullptr,
   // then wait up to 'max_millis_to_wait' milliseconds, retrying each
   // time a call to DeallocateRaw() is detected, until either a good
-  // pointer is returned or the deadline is exhausted.  If the
-  // deadline is exhausted, try one more time with 'verbose_failure'
-  // set to true.  The value returned is either the first good pointer
-  // obtained from 'alloc_func' or nullptr.
+  // pointer is returned or the deadline is exhausted.  Before each
+  // wait, the handlers in MemoryPressureRegistry::Global() are asked
+  // to release memory, and the allocation is retried at once if they
+  // did.  If the deadline is exhausted, try one more time with
+  // 'verbose_failure' set to true.  The value returned is either the
+  // first good pointer obtained from 'alloc_func' or nullptr.
   void* AllocateRaw(std::function<void*(size_t alignment, size_t num_bytes,
                                         bool verbose_failure)>
                         alloc_func,
@@ -47,10 +51,14 @@ class AllocatorRetry {
   Env* env_;
   mutex mu_;
   condition_variable memory_returned_;
+  // Number of AllocateRaw() calls that have failed at least once, so that
+  // NotifyDealloc() need not take mu_ when nobody is waiting.
+  std::atomic<int> num_waiters_{0};
 };
 
 // Implementation details below
 inline void AllocatorRetry::NotifyDealloc() {
+  if (num_waiters_.load() == 0) return;
   mutex_lock l(mu_);
   memory_returned_.notify_all();
 }
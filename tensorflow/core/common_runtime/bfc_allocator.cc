@@ -29,12 +29,25 @@ limitations under the License.
 
 namespace tensorflow {
 
+constexpr size_t BFCAllocator::kSlabClassSizes[];
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name)
+    : BFCAllocator(sub_allocator, total_memory, allow_growth, name,
+                   Options()) {}
+
+BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
+                           bool allow_growth, const string& name,
+                           const Options& options)
     : suballocator_(sub_allocator),
       name_(name),
+      use_slabs_(options.use_slabs),
       free_chunks_list_(kInvalidChunkHandle),
       next_allocation_id_(1) {
+  if (options.use_thread_caches) {
+    cache_shards_.reset(new CacheShard[kNumCacheShards]);
+    size_class_shards_.reset(new SizeClassShard[kNumCacheShards]);
+  }
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -78,6 +91,10 @@ BFCAllocator::~BFCAllocator() {
   for (BinNum b = 0; b < kNumBins; b++) {
     BinFromIndex(b)->~Bin();
   }
+
+  for (Chunk& c : chunks_) {
+    delete c.slab;
+  }
 }
 
 BFCAllocator::Chunk* BFCAllocator::ChunkFromHandle(ChunkHandle h) {
@@ -247,23 +264,60 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  int size_class = -1;
+  if (cache_shards_ != nullptr && num_bytes <= kMaxCachedAllocationSize) {
+    size_class = CacheClassForSize(num_bytes);
+    void* ptr = AllocateFromCache(size_class);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    // Carve a chunk that can later serve any request of this size class.
+    rounded_bytes = CacheClassToSize(size_class);
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
   mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-  if (ptr != nullptr) {
-    return ptr;
+  void* ptr = nullptr;
+  if (use_slabs_ && rounded_bytes <= kMaxSlabAllocationSize) {
+    ptr = AllocateFromSlab(unused_alignment, SlabClassForSize(rounded_bytes));
+  }
+
+  const bool from_slab = ptr != nullptr;
+  if (!from_slab) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
   }
 
   // Try to extend
-  if (Extend(unused_alignment, rounded_bytes)) {
+  if (ptr == nullptr && Extend(unused_alignment, rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-    if (ptr != nullptr) {
-      return ptr;
+  }
+
+  // Chunks held by the thread caches and by empty slabs may satisfy the
+  // request once they are coalesced.
+  if (ptr == nullptr) {
+    bool released = cache_shards_ != nullptr && FlushCaches();
+    if (use_slabs_ && ReleaseEmptySlabs()) {
+      released = true;
+    }
+    if (released) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
     }
   }
 
+  if (ptr != nullptr) {
+    if (!from_slab) {
+      RecordAllocation(ChunkFromHandle(region_manager_.get_handle(ptr))->size);
+    }
+    if (size_class >= 0) {
+      SizeClassShard* shard = SizeClassShardFor(ptr);
+      mutex_lock sl(shard->mu);
+      shard->chunks[ptr] = {size_class, AllocatedSizeLocked(ptr)};
+    }
+    return ptr;
+  }
+
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
@@ -312,14 +366,6 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         // chunk as being in use.
         chunk->allocation_id = next_allocation_id_++;
 
-        // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.max_bytes_in_use =
-            std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
-        stats_.max_alloc_size =
-            std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
-
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
           LOG(INFO) << "A: " << RenderOccupancy();
@@ -377,18 +423,232 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (cache_shards_ != nullptr && DeallocateToCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
+  FreeLocked(ptr);
+
+  if (VLOG_IS_ON(4)) {
+    LOG(INFO) << "F: " << RenderOccupancy();
+  }
+}
 
+void BFCAllocator::FreeLocked(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
+  Chunk* c = ChunkFromHandle(h);
+  if (c->slab != nullptr) {
+    DeallocateToSlab(c->slab, ptr);
+    return;
+  }
+
+  stats_.bytes_in_use -= c->size;
 
   // Consider coalescing it.
   FreeAndMaybeCoalesce(h);
+}
 
-  if (VLOG_IS_ON(4)) {
-    LOG(INFO) << "F: " << RenderOccupancy();
+void BFCAllocator::RecordAllocation(size_t bytes) {
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += bytes;
+  stats_.max_bytes_in_use =
+      std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+  stats_.max_alloc_size = std::max<std::size_t>(stats_.max_alloc_size, bytes);
+}
+
+size_t BFCAllocator::AllocatedSizeLocked(const void* ptr) {
+  BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+  CHECK(h != kInvalidChunkHandle)
+      << "Asked for allocated size of pointer we never allocated: " << ptr;
+  const Chunk* c = ChunkFromHandle(h);
+  return c->slab != nullptr ? c->slab->slot_size : c->size;
+}
+
+// static
+int BFCAllocator::SlabClassForSize(size_t bytes) {
+  DCHECK_LE(bytes, kMaxSlabAllocationSize);
+  return std::lower_bound(kSlabClassSizes, kSlabClassSizes + kNumSlabClasses,
+                          bytes) -
+         kSlabClassSizes;
+}
+
+void* BFCAllocator::AllocateFromSlab(size_t alignment, int size_class) {
+  std::vector<Slab*>& partial_slabs = partial_slabs_[size_class];
+  if (partial_slabs.empty()) {
+    const BinNum bin_num = BinNumForSize(kSlabBytes);
+    void* base = FindChunkPtr(bin_num, kSlabBytes, kSlabBytes);
+    if (base == nullptr && Extend(alignment, kSlabBytes)) {
+      base = FindChunkPtr(bin_num, kSlabBytes, kSlabBytes);
+    }
+    if (base == nullptr) {
+      return nullptr;
+    }
+    const ChunkHandle h = region_manager_.get_handle(base);
+    Chunk* c = ChunkFromHandle(h);
+    Slab* slab = new Slab;
+    slab->chunk = h;
+    slab->size_class = size_class;
+    slab->slot_size = kSlabClassSizes[size_class];
+    slab->num_slots = c->size / slab->slot_size;
+    slab->free_slots.reserve(slab->num_slots);
+    // Push in reverse so that the lowest addresses are handed out first.
+    for (size_t i = slab->num_slots; i-- > 0;) {
+      void* slot = static_cast<char*>(base) + i * slab->slot_size;
+      if (i > 0) {
+        region_manager_.set_handle(slot, h);
+      }
+      slab->free_slots.push_back(slot);
+    }
+    c->slab = slab;
+    partial_slabs.push_back(slab);
+    VLOG(2) << "New slab of " << slab->num_slots << " slots of "
+            << strings::HumanReadableNumBytes(slab->slot_size) << " at "
+            << base;
+  }
+
+  Slab* slab = partial_slabs.back();
+  void* ptr = slab->free_slots.back();
+  slab->free_slots.pop_back();
+  if (slab->free_slots.empty()) {
+    partial_slabs.pop_back();
+  }
+  RecordAllocation(slab->slot_size);
+  return ptr;
+}
+
+void BFCAllocator::DeallocateToSlab(Slab* slab, void* ptr) {
+  std::vector<Slab*>& partial_slabs = partial_slabs_[slab->size_class];
+  if (slab->free_slots.empty()) {
+    partial_slabs.push_back(slab);
+  }
+  slab->free_slots.push_back(ptr);
+  stats_.bytes_in_use -= slab->slot_size;
+
+  // Keep the last slab of each class even when it is empty, so that a
+  // class whose only slot is repeatedly allocated and freed does not create
+  // and release a slab each time.
+  if (slab->free_slots.size() == slab->num_slots && partial_slabs.size() > 1) {
+    partial_slabs.erase(
+        std::find(partial_slabs.begin(), partial_slabs.end(), slab));
+    ReleaseSlab(slab);
+  }
+}
+
+void BFCAllocator::ReleaseSlab(Slab* slab) {
+  const ChunkHandle h = slab->chunk;
+  Chunk* c = ChunkFromHandle(h);
+  for (size_t i = 1; i < slab->num_slots; ++i) {
+    region_manager_.erase(static_cast<char*>(c->ptr) + i * slab->slot_size);
+  }
+  c->slab = nullptr;
+  delete slab;
+  FreeAndMaybeCoalesce(h);
+}
+
+bool BFCAllocator::ReleaseEmptySlabs() {
+  bool released = false;
+  for (std::vector<Slab*>& partial_slabs : partial_slabs_) {
+    for (auto it = partial_slabs.begin(); it != partial_slabs.end();) {
+      Slab* slab = *it;
+      if (slab->free_slots.size() == slab->num_slots) {
+        it = partial_slabs.erase(it);
+        ReleaseSlab(slab);
+        released = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+  return released;
+}
+
+// static
+int BFCAllocator::CacheClassForSize(size_t bytes) {
+  DCHECK_LE(bytes, kMaxCachedAllocationSize);
+  return std::max(0,
+                  Log2Ceiling64(bytes) - static_cast<int>(kMinAllocationBits));
+}
+
+BFCAllocator::SizeClassShard* BFCAllocator::SizeClassShardFor(
+    const void* ptr) {
+  // Chunks are kMinAllocationSize aligned, so the low bits carry no entropy.
+  const uintptr_t index =
+      reinterpret_cast<uintptr_t>(ptr) >> kMinAllocationBits;
+  return &size_class_shards_[index % kNumCacheShards];
+}
+
+BFCAllocator::CacheShard* BFCAllocator::CacheShardForCurrentThread() {
+  static std::atomic<int> next_shard{0};
+  static thread_local int shard = next_shard.fetch_add(1) % kNumCacheShards;
+  return &cache_shards_[shard];
+}
+
+void* BFCAllocator::AllocateFromCache(int size_class) {
+  CacheShard* shard = CacheShardForCurrentThread();
+  mutex_lock l(shard->mu);
+  auto& free_chunks = shard->free_chunks[size_class];
+  if (free_chunks.empty()) {
+    return nullptr;
+  }
+  const std::pair<void*, size_t> chunk = free_chunks.back();
+  free_chunks.pop_back();
+  shard->cached_bytes -= chunk.second;
+  ++shard->num_allocs;
+  return chunk.first;
+}
+
+bool BFCAllocator::DeallocateToCache(void* ptr) {
+  SizeClassShard* classes = SizeClassShardFor(ptr);
+  ClassifiedChunk chunk;
+  {
+    mutex_lock l(classes->mu);
+    auto it = classes->chunks.find(ptr);
+    if (it == classes->chunks.end()) {
+      return false;
+    }
+    chunk = it->second;
+  }
+  CacheShard* shard = CacheShardForCurrentThread();
+  {
+    mutex_lock l(shard->mu);
+    if (shard->cached_bytes + chunk.size <= kMaxCachedBytesPerShard) {
+      shard->free_chunks[chunk.size_class].emplace_back(ptr, chunk.size);
+      shard->cached_bytes += chunk.size;
+      return true;
+    }
+  }
+  // The cache is full, so the chunk goes back to the bins.
+  mutex_lock l(classes->mu);
+  classes->chunks.erase(ptr);
+  return false;
+}
+
+bool BFCAllocator::FlushCaches() {
+  bool flushed = false;
+  for (int i = 0; i < kNumCacheShards; ++i) {
+    CacheShard* shard = &cache_shards_[i];
+    mutex_lock l(shard->mu);
+    for (auto& free_chunks : shard->free_chunks) {
+      for (const auto& chunk : free_chunks) {
+        SizeClassShard* classes = SizeClassShardFor(chunk.first);
+        {
+          mutex_lock cl(classes->mu);
+          classes->chunks.erase(chunk.first);
+        }
+        FreeLocked(chunk.first);
+        flushed = true;
+      }
+      free_chunks.clear();
+    }
+    shard->cached_bytes = 0;
   }
+  if (flushed) {
+    VLOG(1) << "Returned the chunks held by the thread caches of " << Name()
+            << " to its bins.";
+  }
+  return flushed;
 }
 
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
@@ -464,9 +724,6 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   // Mark the chunk as no longer in use.
   c->allocation_id = -1;
 
-  // Updates the stats.
-  stats_.bytes_in_use -= c->size;
-
   ChunkHandle coalesced_chunk = h;
 
   // If the next chunk is free, merge it into c and delete it.
@@ -499,7 +756,11 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
   }
 }
 
-bool BFCAllocator::TracksAllocationSizes() { return true; }
+bool BFCAllocator::TracksAllocationSizes() {
+  // A cached chunk keeps the requested size and allocation id of its first
+  // user, and slots share those of their slab.
+  return cache_shards_ == nullptr && !use_slabs_;
+}
 
 size_t BFCAllocator::RequestedSize(const void* ptr) {
   mutex_lock l(lock_);
@@ -507,16 +768,12 @@ size_t BFCAllocator::RequestedSize(const void* ptr) {
   CHECK(h != kInvalidChunkHandle)
       << "Asked for requested size of pointer we never allocated: " << ptr;
   BFCAllocator::Chunk* c = ChunkFromHandle(h);
-  return c->requested_size;
+  return c->slab != nullptr ? c->slab->slot_size : c->requested_size;
 }
 
 size_t BFCAllocator::AllocatedSize(const void* ptr) {
   mutex_lock l(lock_);
-  BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
-  CHECK(h != kInvalidChunkHandle)
-      << "Asked for allocated size of pointer we never allocated: " << ptr;
-  BFCAllocator::Chunk* c = ChunkFromHandle(h);
-  return c->size;
+  return AllocatedSizeLocked(ptr);
 }
 
 int64 BFCAllocator::AllocationId(const void* ptr) {
@@ -663,6 +920,26 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
 void BFCAllocator::GetStats(AllocatorStats* stats) {
   mutex_lock l(lock_);
   *stats = stats_;
+  stats->bytes_reserved = total_region_allocated_bytes_;
+  for (BinNum b = kNumBins - 1; b >= 0; b--) {
+    const Bin* bin = BinFromIndex(b);
+    if (!bin->free_chunks.empty()) {
+      // Free chunks are sorted by size.
+      stats->largest_free_block_bytes =
+          ChunkFromHandle(*bin->free_chunks.rbegin())->size;
+      break;
+    }
+  }
+  if (cache_shards_ != nullptr) {
+    // The bins count cached chunks as in use.  max_bytes_in_use includes the
+    // chunks that were cached at the time of the peak.
+    for (int i = 0; i < kNumCacheShards; ++i) {
+      CacheShard* shard = &cache_shards_[i];
+      mutex_lock sl(shard->mu);
+      stats->num_allocs += shard->num_allocs;
+      stats->bytes_in_use -= shard->cached_bytes;
+    }
+  }
 }
 
 void BFCAllocator::ClearStats() {
@@ -670,6 +947,13 @@ void BFCAllocator::ClearStats() {
   stats_.num_allocs = 0;
   stats_.max_bytes_in_use = stats_.bytes_in_use;
   stats_.max_alloc_size = 0;
+  if (cache_shards_ != nullptr) {
+    for (int i = 0; i < kNumCacheShards; ++i) {
+      CacheShard* shard = &cache_shards_[i];
+      mutex_lock sl(shard->mu);
+      shard->num_allocs = 0;
+    }
+  }
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/visitable_allocator.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
@@ -44,9 +45,29 @@ namespace tensorflow {
 // all requests to allocate memory go through this interface.
 class BFCAllocator : public VisitableAllocator {
  public:
+  struct Options {
+    // If true, small allocations are served from per-thread caches of free
+    // chunks in front of the bins, so that most AllocateRaw() and
+    // DeallocateRaw() calls take a lock shared by few threads instead of the
+    // allocator-wide lock. Cached chunks are returned to the bins when a
+    // cache grows too large or when an allocation would otherwise fail.
+    bool use_thread_caches = false;
+
+    // If true, small and medium allocations are carved out of slabs of
+    // fixed-size slots, one size class per slab, and only large allocations
+    // use best-fit with coalescing. This bounds the fragmentation caused by
+    // many differently-sized short-lived allocations, at the cost of
+    // rounding each allocation up to its size class.
+    bool use_slabs = false;
+  };
+
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name);
+  // Allocation sizes are not tracked if "options" enables thread caches or
+  // slabs.
+  BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
+               bool allow_growth, const string& name, const Options& options);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -74,11 +95,59 @@ class BFCAllocator : public VisitableAllocator {
 
  private:
   struct Bin;
+  struct Slab;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure);
   void DeallocateRawInternal(void* ptr);
 
+  // Thread caches.  Allocations of up to kMaxCachedAllocationSize bytes are
+  // rounded up to one of kNumCacheClasses power-of-two size classes.  A
+  // chunk of a size class stays in use as far as the bins are concerned
+  // while it sits in a cache, and is only coalesced once it is released.
+  static const int kNumCacheClasses = 9;
+  static const size_t kMaxCachedAllocationSize = 256 << (kNumCacheClasses - 1);
+  static const int kNumCacheShards = 16;
+  static const size_t kMaxCachedBytesPerShard = 4 << 20;
+
+  // The free chunks cached for the threads mapped to one shard.
+  struct CacheShard {
+    mutex mu;
+    // Pointer and chunk size of each cached chunk, by size class.
+    std::vector<std::pair<void*, size_t>> free_chunks[kNumCacheClasses]
+        GUARDED_BY(mu);
+    size_t cached_bytes GUARDED_BY(mu) = 0;
+    // Number of allocations served from this shard.
+    int64 num_allocs GUARDED_BY(mu) = 0;
+  };
+
+  struct ClassifiedChunk {
+    int size_class;
+    size_t size;
+  };
+
+  // Every live or cached chunk that belongs to a size class, sharded by
+  // address, so that DeallocateRaw() need not consult region_manager_.
+  struct SizeClassShard {
+    mutex mu;
+    gtl::FlatMap<void*, ClassifiedChunk> chunks GUARDED_BY(mu);
+  };
+
+  static int CacheClassForSize(size_t bytes);
+  static size_t CacheClassToSize(int size_class) {
+    return static_cast<size_t>(256) << size_class;
+  }
+  SizeClassShard* SizeClassShardFor(const void* ptr);
+  CacheShard* CacheShardForCurrentThread();
+
+  // Returns a cached chunk of class "size_class", or nullptr.
+  void* AllocateFromCache(int size_class);
+  // Caches "ptr" if it belongs to a size class.  Returns false if "ptr" must
+  // be freed to the bins instead.
+  bool DeallocateToCache(void* ptr);
+  // Returns every cached chunk to the bins.  Returns true if any was.
+  bool FlushCaches() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -131,6 +200,10 @@ class BFCAllocator : public VisitableAllocator {
     // What bin are we in?
     BinNum bin_num = kInvalidBinNum;
 
+    // If not null, this in-use chunk is split into the slots of "slab",
+    // which it owns.
+    Slab* slab = nullptr;
+
     bool in_use() const { return allocation_id != -1; }
 
     string DebugString(BFCAllocator* a,
@@ -308,6 +381,49 @@ class BFCAllocator : public VisitableAllocator {
     std::vector<AllocationRegion> regions_;
   };
 
+  // Slabs.  A slab is a chunk of kSlabBytes split into slots of one of
+  // kNumSlabClasses sizes, all multiples of kMinAllocationSize, about 1.5x
+  // apart.  The region handle of every slot refers to the slab's chunk.
+  static const int kNumSlabClasses = 20;
+  static const size_t kMaxSlabAllocationSize = 256 << 10;
+  static const size_t kSlabBytes = 2 << 20;
+  static constexpr size_t kSlabClassSizes[kNumSlabClasses] = {
+      256 << 0, 512 << 0, 768 << 0, 1 << 10,   1536 << 0, 2 << 10,  3 << 10,
+      4 << 10,  6 << 10,  8 << 10,  12 << 10,  16 << 10,  24 << 10, 32 << 10,
+      48 << 10, 64 << 10, 96 << 10, 128 << 10, 192 << 10, 256 << 10};
+
+  struct Slab {
+    ChunkHandle chunk = kInvalidChunkHandle;
+    int size_class = -1;
+    size_t slot_size = 0;
+    size_t num_slots = 0;
+    std::vector<void*> free_slots;
+  };
+
+  static int SlabClassForSize(size_t bytes);
+
+  // Returns a slot of class "size_class", creating a slab if needed, or
+  // nullptr if no slab can be created.
+  void* AllocateFromSlab(size_t alignment, int size_class)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the slot "ptr" to "slab".
+  void DeallocateToSlab(Slab* slab, void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the chunk of "slab" to the bins and deletes "slab".
+  void ReleaseSlab(Slab* slab) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Releases every slab with no slot in use.  Returns true if any was.
+  bool ReleaseEmptySlabs() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the number of bytes available to the user at "ptr", which must
+  // have been returned by AllocateRaw().
+  size_t AllocatedSizeLocked(const void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Frees "ptr", which must have been returned by AllocateRaw(), to its slab
+  // or to the bins.
+  void FreeLocked(void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Records the allocation of "bytes" bytes in stats_.
+  void RecordAllocation(size_t bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Returns 'bytes' rounded up to the next highest kMinAllocationSize.
   size_t RoundedBytes(size_t bytes);
 
@@ -318,7 +434,7 @@ class BFCAllocator : public VisitableAllocator {
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Returns a pointer to an underlying allocated chunk of size
-  // 'rounded_bytes'.
+  // 'rounded_bytes'.  The caller records the allocation in stats_.
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -426,6 +542,12 @@ class BFCAllocator : public VisitableAllocator {
   std::unique_ptr<SubAllocator> suballocator_;
   string name_;
 
+  // Immutable after construction; null unless thread caches are used.
+  std::unique_ptr<CacheShard[]> cache_shards_;
+  std::unique_ptr<SizeClassShard[]> size_class_shards_;
+
+  const bool use_slabs_;
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ GUARDED_BY(lock_);
@@ -442,6 +564,9 @@ class BFCAllocator : public VisitableAllocator {
   // newly-created chunk.
   int64 next_allocation_id_ GUARDED_BY(lock_);
 
+  // The slabs of each size class that have a free slot.
+  std::vector<Slab*> partial_slabs_[kNumSlabClasses] GUARDED_BY(lock_);
+
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
@@ -35,6 +35,10 @@ string BuildGraphOptions::DebugString() const {
   if (collective_graph_key != kNoCollectiveGraphKey) {
     strings::StrAppend(&rv, "\ncollective_graph_key: ", collective_graph_key);
   }
+  if (specialized_batch_size != kNoSpecializedBatchSize) {
+    strings::StrAppend(&rv,
+                       "\nspecialized_batch_size: ", specialized_batch_size);
+  }
   return rv;
 }
 
@@ -34,6 +34,12 @@ struct BuildGraphOptions {
   static const int64 kNoCollectiveGraphKey = 0;
   int64 collective_graph_key = kNoCollectiveGraphKey;
 
+  // If non-negative, the graph is only run with feeds whose first dimension
+  // is this batch size, so the optimizers may assume it for the fed
+  // placeholders whose first dimension is unknown.
+  static const int64 kNoSpecializedBatchSize = -1;
+  int64 specialized_batch_size = kNoSpecializedBatchSize;
+
   string DebugString() const;
 };
 
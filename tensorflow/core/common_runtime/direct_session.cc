@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <algorithm>
 #include <atomic>
 #include <string>
 #include <vector>
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
@@ -39,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph_def_util.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/shared_kernel_cache.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -87,8 +90,9 @@ Status NewThreadPoolFromThreadPoolOptions(
     // Session-local threadpool.
     VLOG(1) << "Direct session inter op parallelism threads for pool "
             << pool_number << ": " << num_threads;
-    *pool = new thread::ThreadPool(
-        options.env, strings::StrCat("Compute", pool_number), num_threads);
+    *pool = NewThreadPoolWithSessionSpinPolicy(
+        options, ThreadOptions(), strings::StrCat("Compute", pool_number),
+        num_threads);
     *owned = true;
     return Status::OK();
   }
@@ -102,8 +106,9 @@ Status NewThreadPoolFromThreadPoolOptions(
   MapValue* mvalue = &(*global_pool_map)[name];
   if (mvalue->second == nullptr) {
     mvalue->first = thread_pool_options.num_threads();
-    mvalue->second = new thread::ThreadPool(
-        options.env, strings::StrCat("Compute", pool_number), num_threads);
+    mvalue->second = NewThreadPoolWithSessionSpinPolicy(
+        options, ThreadOptions(), strings::StrCat("Compute", pool_number),
+        num_threads);
   } else {
     if (mvalue->first != thread_pool_options.num_threads()) {
       return errors::InvalidArgument(
@@ -136,6 +141,47 @@ string GetRendezvousKey(const string& tensor_name,
                          frame_iter.frame_id, ":", frame_iter.iter_id);
 }
 
+// Returns the first dimension shared by the non-scalar `inputs` if it is one
+// of the batch sizes the session specializes its graph for, and
+// BuildGraphOptions::kNoSpecializedBatchSize otherwise.
+int64 SpecializedBatchSize(
+    const SessionOptions& options,
+    const std::vector<std::pair<string, Tensor>>& inputs) {
+  const auto& batch_sizes =
+      options.config.experimental().specialized_batch_sizes();
+  int64 batch_size = BuildGraphOptions::kNoSpecializedBatchSize;
+  if (batch_sizes.empty()) {
+    return batch_size;
+  }
+  for (const auto& it : inputs) {
+    if (it.second.dims() == 0) {
+      continue;
+    }
+    if (batch_size == BuildGraphOptions::kNoSpecializedBatchSize) {
+      batch_size = it.second.dim_size(0);
+    } else if (batch_size != it.second.dim_size(0)) {
+      return BuildGraphOptions::kNoSpecializedBatchSize;
+    }
+  }
+  if (std::find(batch_sizes.begin(), batch_sizes.end(), batch_size) ==
+      batch_sizes.end()) {
+    return BuildGraphOptions::kNoSpecializedBatchSize;
+  }
+  return batch_size;
+}
+
+// Returns whether the kernel of the stateless, non-function node "ndef" can
+// be shared with other sessions. Kernels of ops that take functions may
+// depend on the function library of the session that creates them.
+bool CanShareKernel(const NodeDef& ndef) {
+  for (const auto& attr : ndef.attr()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 class DirectSessionFactory : public SessionFactory {
@@ -677,6 +723,8 @@ Status DirectSession::Run(const RunOptions& run_options,
   // Check if we already have an executor for these arguments.
   ExecutorsAndKeys* executors_and_keys;
   RunStateArgs run_state_args(run_options.debug_options());
+  run_state_args.specialized_batch_size =
+      SpecializedBatchSize(options_, inputs);
 
   TF_RETURN_IF_ERROR(GetOrCreateExecutors(input_tensor_names, output_names,
                                           target_nodes, &executors_and_keys,
@@ -1115,6 +1163,7 @@ Status DirectSession::CreateExecutors(
   BuildGraphOptions options;
   options.callable_options = callable_options;
   options.use_function_convention = !run_state_args->is_partial_run;
+  options.specialized_batch_size = run_state_args->specialized_batch_size;
 
   std::unique_ptr<FunctionInfo> func_info(new FunctionInfo);
   std::unique_ptr<ExecutorsAndKeys> ek(new ExecutorsAndKeys);
@@ -1177,16 +1226,27 @@ Status DirectSession::CreateExecutors(
     params.device = device;
     params.function_library = lib;
     auto opseg = device->op_segment();
-    params.create_kernel = [this, lib, opseg](const NodeDef& ndef,
-                                              OpKernel** kernel) {
+    const bool share_kernels =
+        options_.config.experimental().share_stateless_kernels();
+    params.create_kernel = [this, lib, opseg, share_kernels](
+                               const NodeDef& ndef, OpKernel** kernel) {
       // We do not share the kernel via the OpSegment if the node is
       // stateless, or a function.
       // NOTE(mrry): We must not share function kernels (implemented
       // using `CallOp`) between subgraphs, because `CallOp::handle_`
       // is tied to a particular subgraph. Even if the function itself
       // is stateful, the `CallOp` that invokes it is not.
-      if (!lib->IsStateful(ndef.op()) ||
-          lib->GetFunctionLibraryDefinition()->Find(ndef.op()) != nullptr) {
+      if (lib->GetFunctionLibraryDefinition()->Find(ndef.op()) != nullptr) {
+        return lib->CreateKernel(ndef, kernel);
+      }
+      if (!lib->IsStateful(ndef.op())) {
+        if (share_kernels && CanShareKernel(ndef)) {
+          return SharedKernelCache::Global()->FindOrCreate(
+              lib->device()->name(), lib->graph_def_version(), ndef, kernel,
+              [lib, &ndef](OpKernel** kernel) {
+                return lib->CreateKernel(ndef, kernel);
+              });
+        }
         return lib->CreateKernel(ndef, kernel);
       }
       auto create_fn = [lib, &ndef](OpKernel** kernel) {
@@ -1198,9 +1258,13 @@ Status DirectSession::CreateExecutors(
       return opseg->FindOrCreate(session_handle_, ndef.name(), kernel,
                                  create_fn);
     };
-    params.delete_kernel = [lib](OpKernel* kernel) {
-      // If the node is stateful, opseg owns it. Otherwise, delete it.
+    params.delete_kernel = [lib, share_kernels](OpKernel* kernel) {
+      // If the node is stateful, opseg owns it. Otherwise, delete it unless
+      // it is shared with other sessions.
       if (kernel && !lib->IsStateful(kernel->type_string())) {
+        if (share_kernels && SharedKernelCache::Global()->Release(kernel)) {
+          return;
+        }
         delete kernel;
       }
     };
@@ -1219,14 +1283,13 @@ Status DirectSession::CreateExecutors(
     TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device->device_type()),
                                          device->name(),
                                          partition_graph.get()));
-    // NewLocalExecutor takes ownership of partition_graph.
+    // NewExecutor takes ownership of partition_graph.
     item->graph = partition_graph.get();
     item->executor = nullptr;
     item->device = device;
-    Executor* executor;
-    TF_RETURN_IF_ERROR(
-        NewLocalExecutor(params, std::move(partition_graph), &executor));
-    item->executor.reset(executor);
+    auto executor_type = options_.config.experimental().executor_type();
+    TF_RETURN_IF_ERROR(NewExecutor(
+        executor_type, params, std::move(partition_graph), &item->executor));
   }
 
   // Cache the mapping from input/output names to graph elements to
@@ -1286,7 +1349,8 @@ Status DirectSession::GetOrCreateExecutors(
   const string key = strings::StrCat(
       str_util::Join(inputs, ","), "->", str_util::Join(outputs, ","), "/",
       str_util::Join(target_nodes, ","), "/", run_state_args->is_partial_run,
-      "/", debug_tensor_watches_summary);
+      "/", debug_tensor_watches_summary, "/",
+      run_state_args->specialized_batch_size);
   // Set the handle, if it's needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1319,7 +1383,8 @@ Status DirectSession::GetOrCreateExecutors(
   const string sorted_key = strings::StrCat(
       str_util::Join(inputs_sorted, ","), "->",
       str_util::Join(outputs_sorted, ","), "/", str_util::Join(tn_sorted, ","),
-      "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary);
+      "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary,
+      "/", run_state_args->specialized_batch_size);
   // Set the handle, if its needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1769,6 +1834,80 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   return Status::OK();
 }
 
+class DirectSession::BoundCallableImpl : public Session::BoundCallable {
+ public:
+  BoundCallableImpl(DirectSession* session, const Callable& callable,
+                    const std::vector<Tensor>* feed_tensors,
+                    std::vector<Tensor>* fetch_tensors)
+      : session_(session),
+        executors_and_keys_(callable.executors_and_keys),
+        function_info_(callable.function_info),
+        feed_tensors_(feed_tensors),
+        call_frame_(session, executors_and_keys_.get(), feed_tensors,
+                    fetch_tensors) {}
+
+  ~BoundCallableImpl() override {
+    // See DirectSession::Callable::~Callable().
+    executors_and_keys_.reset();
+    function_info_.reset();
+  }
+
+  Status Run(RunMetadata* run_metadata) override {
+    TF_RETURN_IF_ERROR(session_->CheckNotClosed());
+    direct_session_runs->GetCell()->IncrementBy(1);
+    const int64 step_id = session_->step_id_counter_.fetch_add(1);
+    if (feed_tensors_->size() != executors_and_keys_->input_types.size()) {
+      return errors::InvalidArgument(
+          "Expected ", executors_and_keys_->input_types.size(),
+          " feed tensors, but got ", feed_tensors_->size());
+    }
+    if (LogMemory::IsEnabled()) {
+      LogMemory::RecordStep(step_id, "");
+    }
+    return session_->RunInternal(
+        step_id, executors_and_keys_->callable_options.run_options(),
+        &call_frame_, executors_and_keys_.get(), run_metadata);
+  }
+
+ private:
+  DirectSession* const session_;  // Not owned.
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys_;
+  std::shared_ptr<FunctionInfo> function_info_;
+  const std::vector<Tensor>* const feed_tensors_;  // Not owned.
+  RunCallableCallFrame call_frame_;
+};
+
+::tensorflow::Status DirectSession::BindCallable(
+    CallableHandle handle, const std::vector<Tensor>* feed_tensors,
+    std::vector<Tensor>* fetch_tensors,
+    std::unique_ptr<BoundCallable>* out_bound) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  TF_RETURN_IF_ERROR(CheckGraphCreated("BindCallable()"));
+  if (feed_tensors == nullptr) {
+    return errors::InvalidArgument("`feed_tensors` must not be null.");
+  }
+  tf_shared_lock l(callables_lock_);
+  if (handle >= next_callable_handle_) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  auto it = callables_.find(handle);
+  if (it == callables_.end() || !it->second.executors_and_keys) {
+    return errors::InvalidArgument(
+        "Attempted to bind callable after handle was released: ", handle);
+  }
+  const ExecutorsAndKeys& executors_and_keys = *it->second.executors_and_keys;
+  if (fetch_tensors != nullptr) {
+    fetch_tensors->resize(executors_and_keys.output_types.size());
+  } else if (!executors_and_keys.output_types.empty()) {
+    return errors::InvalidArgument(
+        "`fetch_tensors` must be provided when the callable has one or more "
+        "outputs.");
+  }
+  out_bound->reset(
+      new BoundCallableImpl(this, it->second, feed_tensors, fetch_tensors));
+  return Status::OK();
+}
+
 DirectSession::Callable::~Callable() {
   // We must delete the fields in this order, because the destructor
   // of `executors_and_keys` will call into an object owned by
@@ -115,6 +115,10 @@ class DirectSession : public Session {
                                    std::vector<Tensor>* fetch_tensors,
                                    RunMetadata* run_metadata) override;
   ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+  ::tensorflow::Status BindCallable(
+      CallableHandle handle, const std::vector<Tensor>* feed_tensors,
+      std::vector<Tensor>* fetch_tensors,
+      std::unique_ptr<BoundCallable>* out_bound) override;
 
  private:
   // We create one executor and its dependent library runtime for
@@ -203,6 +207,8 @@ class DirectSession : public Session {
     string handle;
     std::unique_ptr<Graph> graph;
     const DebugOptions& debug_options;
+    // The batch size the executors are specialized for, if any.
+    int64 specialized_batch_size = BuildGraphOptions::kNoSpecializedBatchSize;
   };
 
   // Initializes the base execution state given the 'graph',
@@ -336,6 +342,7 @@ class DirectSession : public Session {
       GUARDED_BY(executor_lock_);
 
   class RunCallableCallFrame;
+  class BoundCallableImpl;
   struct Callable {
     std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
     std::shared_ptr<FunctionInfo> function_info;
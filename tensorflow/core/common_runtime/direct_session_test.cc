@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/shared_kernel_cache.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -142,6 +143,39 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, ShareStatelessKernels) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_experimental()->set_share_stateless_kernels(true);
+  SharedKernelCache* cache = SharedKernelCache::Global();
+  const size_t initial_size = cache->size();
+
+  std::unique_ptr<Session> sessions[2];
+  size_t shared_size = 0;
+  for (auto& session : sessions) {
+    session.reset(NewSession(options));
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def_));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {y_neg_}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    if (shared_size == 0) {
+      shared_size = cache->size();
+      EXPECT_GT(shared_size, initial_size);
+    } else {
+      // The second session reuses the kernels of the first one.
+      EXPECT_EQ(shared_size, cache->size());
+    }
+  }
+
+  sessions[0].reset();
+  EXPECT_EQ(shared_size, cache->size());
+  sessions[1].reset();
+  EXPECT_EQ(initial_size, cache->size());
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -403,6 +437,49 @@ TEST_F(DirectSessionMinusAXTest, TestFeed_Callable) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithBoundCallable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(MakeCallableOptions({x_}, {y_ + ":0"}, {}),
+                                     &handle));
+  std::vector<Tensor> inputs = {Tensor(DT_FLOAT, TensorShape({2, 1}))};
+  std::vector<Tensor> outputs;
+  std::unique_ptr<Session::BoundCallable> bound;
+  TF_ASSERT_OK(session->BindCallable(handle, &inputs, &outputs, &bound));
+  ASSERT_EQ(1, outputs.size());
+  // The bound callable stays valid after its handle is released.
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+
+  // Each run reads the current contents of the bound inputs.
+  for (int i = 0; i < 3; ++i) {
+    inputs[0].matrix<float>()(0, 0) = 5 + i;
+    inputs[0].matrix<float>()(1, 0) = 6;
+    TF_ASSERT_OK(bound->Run(nullptr));
+
+    ASSERT_EQ(1, outputs.size());
+    auto mat = outputs[0].matrix<float>();
+    // Expect outputs to be; 1*x + 2*6, 3*x + 4*6
+    EXPECT_FLOAT_EQ(1 * (5 + i) + 12, mat(0, 0));
+    EXPECT_FLOAT_EQ(3 * (5 + i) + 24, mat(1, 0));
+  }
+
+  inputs.clear();
+  Status s = bound->Run(nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(str_util::StrContains(s.error_message(), "feed tensors"));
+
+  s = session->BindCallable(handle, &inputs, &outputs, &bound);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(
+      str_util::StrContains(s.error_message(),
+                            "Attempted to bind callable after handle was "
+                            "released"));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -1088,6 +1165,36 @@ TEST(DirectSessionTest, PlacePrunedGraph) {
   }
 }
 
+TEST(DirectSessionTest, SpecializedBatchSizes) {
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("dtype", DT_FLOAT)
+                   .Attr("shape", PartialTensorShape({-1, 2}))
+                   .Finalize(&g, &x));
+  Node* y = test::graph::Unary(&g, "Shape", x);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->add_specialized_batch_sizes(2);
+  std::unique_ptr<Session> sess(NewSession(options));
+  TF_ASSERT_OK(sess->Create(def));
+
+  // The first run creates the variant for batch size 2, in which the shape of
+  // x is known. The other batch sizes must still run the generic graph.
+  for (int batch_size : {2, 3, 2}) {
+    Tensor x_value(DT_FLOAT, TensorShape({batch_size, 2}));
+    x_value.flat<float>().setZero();
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(
+        sess->Run({{"x", x_value}}, {y->name() + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<int32>(
+        test::AsTensor<int32>({batch_size, 2}, {2}), outputs[0]);
+  }
+}
+
 TEST(DirectSessionTest, PartialRunTest) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -99,6 +99,7 @@ Status AttrTypeMapForOp(const char* op_name, const AttrTypeMap** out) {
 #define DEFINE_SET_ATTR(value_type, value_field)                             \
   template <>                                                                \
   AttrBuilder& AttrBuilder::Set(StringPiece attr_name, value_type&& value) { \
+    cached_cache_key_valid_ = false;                                         \
     value_field.push_back(std::make_pair(attr_name, value));                 \
     return *this;                                                            \
   }
@@ -113,6 +114,7 @@ DEFINE_SET_ATTR(tensorflow::DataType, type_attrs_);
 
 AttrBuilder& AttrBuilder::NumInputs(int n) {
   DCHECK(!node_def_finalized_) << "Calling NumInputs after BuildNodeDef.";
+  cached_cache_key_valid_ = false;
   num_inputs_ = n;
   return *this;
 }
@@ -195,6 +197,17 @@ inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
 }  // namespace
 
 tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
+  // BuildNodeDef does not change the attributes, only where they are stored,
+  // so the remembered key stays valid across it.
+  if (!cached_cache_key_valid_ || cached_cache_key_device_ != device) {
+    cached_cache_key_ = ComputeCacheKey(device);
+    cached_cache_key_device_ = device;
+    cached_cache_key_valid_ = true;
+  }
+  return cached_cache_key_;
+}
+
+tensorflow::Fprint128 AttrBuilder::ComputeCacheKey(const string& device) const {
   tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name_);
   f = tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
   if (node_def_ != nullptr) {
@@ -78,6 +78,10 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
 // BuildNodeDef. Also, calls to NumInputs or Set between multiple invocations
 // to CacheKey may cause different values to be returned by CacheKey.
 //
+// The cache key is remembered until the next call to Set or NumInputs, so that
+// executing an op again with unchanged attributes does not fingerprint them
+// again.
+//
 // For performance reasons, the class internally delays the actual construction
 // of the NodeDef till BuildNodeDef is called, or Set is called with certain
 // uncommon types (see template specializations of Set to see which types
@@ -88,13 +92,15 @@ class AttrBuilder {
       : op_name_(op),
         num_inputs_(0),
         node_def_(nullptr),
-        node_def_finalized_(false) {}
+        node_def_finalized_(false),
+        cached_cache_key_valid_(false) {}
 
   // Needed to work around call to ValidateNodeDef in CreateOpKernel.
   AttrBuilder& NumInputs(int n);
 
   template <class T>
   AttrBuilder& Set(StringPiece attr_name, T&& value) {
+    cached_cache_key_valid_ = false;
     MayBeInitializeNodeDef();
     SetInAttrValueMap(node_def_->mutable_attr(), attr_name, value);
     return *this;
@@ -110,6 +116,7 @@ class AttrBuilder {
   using AttrVec = tensorflow::gtl::InlinedVector<std::pair<StringPiece, T>, 2>;
 
   void MayBeInitializeNodeDef();
+  tensorflow::Fprint128 ComputeCacheKey(const string& device) const;
   void FillAttrValueMap(AttrValueMap* m, bool include_those_in_node_def) const;
 
   template <class T>
@@ -140,6 +147,9 @@ class AttrBuilder {
   int num_inputs_;
   std::unique_ptr<NodeDef> node_def_;
   bool node_def_finalized_;
+  mutable bool cached_cache_key_valid_;
+  mutable tensorflow::Fprint128 cached_cache_key_;
+  mutable string cached_cache_key_device_;
 };  // namespace tensorflow
 
 template <>
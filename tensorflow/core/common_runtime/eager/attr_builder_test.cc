@@ -58,5 +58,25 @@ TEST(AttrTypeMap, Lookup) {
   EXPECT_NE(is_list, 0);
 }
 
+TEST(AttrBuilder, CacheKey) {
+  AttrBuilder a("MatMul");
+  a.NumInputs(2);
+  a.Set("transpose_a", true);
+  a.Set("T", DT_FLOAT);
+  const Fprint128 cpu_key = a.CacheKey("cpu:0");
+  EXPECT_EQ(cpu_key, a.CacheKey("cpu:0"));
+  EXPECT_FALSE(cpu_key == a.CacheKey("gpu:0"));
+  // Building the NodeDef keeps the key.
+  a.BuildNodeDef();
+  EXPECT_EQ(cpu_key, a.CacheKey("cpu:0"));
+
+  AttrBuilder b("MatMul");
+  b.NumInputs(2);
+  b.Set("transpose_a", true);
+  EXPECT_FALSE(cpu_key == b.CacheKey("cpu:0"));
+  b.Set("T", DT_FLOAT);
+  EXPECT_EQ(cpu_key, b.CacheKey("cpu:0"));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -30,6 +30,22 @@ bool ReadBoolFromEnvVar(StringPiece env_var_name, bool default_val) {
   return default_val;
 }
 
+// The kernels of a context found by a thread, valid as long as the generation
+// of the context's kernel cache is `generation`.
+struct ThreadLocalKernelCache {
+  uint64 generation = 0;
+  std::unordered_map<Fprint128, KernelAndDevice*, Fprint128Hasher> kernels;
+};
+
+ThreadLocalKernelCache* GetThreadLocalKernelCache(uint64 generation) {
+  static thread_local ThreadLocalKernelCache cache;
+  if (cache.generation != generation) {
+    cache.kernels.clear();
+    cache.generation = generation;
+  }
+  return &cache;
+}
+
 }  // namespace
 
 EagerContext::EagerContext(const SessionOptions& opts,
@@ -130,6 +146,8 @@ Status EagerContext::SetAsyncForThread(bool async) {
 
 void EagerContext::ClearCaches() {
   mutex_lock ml(cache_mu_);
+  kernel_cache_generation_.store(NewKernelCacheGeneration(),
+                                 std::memory_order_release);
   gtl::STLDeleteValues(&kernel_cache_);
 }
 
@@ -257,15 +275,34 @@ Status EagerContext::AddFunctionDef(const FunctionDef& fdef) {
   return MaybeRegisterFunctionRemotely(fdef);
 }
 
+uint64 EagerContext::NewKernelCacheGeneration() {
+  static std::atomic<uint64> next_generation{1};
+  return next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 KernelAndDevice* EagerContext::GetCachedKernel(Fprint128 cache_key) {
-  tf_shared_lock l(cache_mu_);
-  return gtl::FindPtrOrNull(kernel_cache_, cache_key);
+  ThreadLocalKernelCache* local_cache = GetThreadLocalKernelCache(
+      kernel_cache_generation_.load(std::memory_order_acquire));
+  KernelAndDevice* kernel =
+      gtl::FindPtrOrNull(local_cache->kernels, cache_key);
+  if (kernel != nullptr) return kernel;
+  {
+    tf_shared_lock l(cache_mu_);
+    kernel = gtl::FindPtrOrNull(kernel_cache_, cache_key);
+  }
+  if (kernel != nullptr) {
+    local_cache->kernels[cache_key] = kernel;
+  }
+  return kernel;
 }
 
 void EagerContext::AddKernelToCache(Fprint128 cache_key,
                                     KernelAndDevice* kernel) {
+  ThreadLocalKernelCache* local_cache = GetThreadLocalKernelCache(
+      kernel_cache_generation_.load(std::memory_order_acquire));
   mutex_lock ml(cache_mu_);
   gtl::InsertOrUpdate(&kernel_cache_, cache_key, kernel);
+  local_cache->kernels[cache_key] = kernel;
 }
 
 void EagerContext::SetShouldStoreMetadata(bool value) {
@@ -295,6 +332,7 @@ Status EagerContext::GetClientAndContextID(Device* device,
   if (it != device_to_client_cache_.end()) {
     *client = it->second.first;
     *context_id = it->second.second;
+    return Status::OK();
   }
   string device_task_name;
   TF_RETURN_IF_ERROR(GetTaskName(device, &device_task_name));
@@ -317,6 +355,30 @@ Status EagerContext::GetClientAndContextID(Device* device,
 
   return Status::OK();
 }
+
+bool EagerContext::AddPendingRemoteDecref(eager::EagerClient* client,
+                                          int64 op_id, int32 output_num) {
+  mutex_lock l(remote_decrefs_mu_);
+  auto& pending = pending_remote_decrefs_[client];
+  pending.emplace_back();
+  pending.back().set_op_id(op_id);
+  pending.back().set_output_num(output_num);
+  return pending.size() >= kMaxPendingRemoteDecrefs;
+}
+
+void EagerContext::TakePendingRemoteDecrefs(eager::EagerClient* client,
+                                            eager::EnqueueRequest* request) {
+  std::vector<eager::RemoteTensorHandle> pending;
+  {
+    mutex_lock l(remote_decrefs_mu_);
+    auto it = pending_remote_decrefs_.find(client);
+    if (it == pending_remote_decrefs_.end()) return;
+    pending.swap(it->second);
+  }
+  for (auto& handle : pending) {
+    request->add_queue()->mutable_handle_to_decref()->Swap(&handle);
+  }
+}
 #endif
 
 }  // namespace tensorflow
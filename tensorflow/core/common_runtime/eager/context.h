@@ -150,6 +150,8 @@ class EagerContext {
 
   Status AddFunctionDef(const FunctionDef& fdef);
 
+  // Looks up the kernel in a cache of the calling thread first, which needs
+  // no lock, and then in the cache shared by all the threads.
   KernelAndDevice* GetCachedKernel(Fprint128 cache_key);
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
@@ -187,6 +189,20 @@ class EagerContext {
   // EagerService.SendTensor RPC. If false, _Send/_Recv ops should be used
   // instead (which in-turn use WorkerService.RecvTensor RPCs.
   bool UseSendTensorRPC() { return use_send_tensor_rpc_; }
+
+  // Queues the release of the remote tensor handle (op_id, output_num),
+  // which lives in a remote context on "client". Instead of an RPC per
+  // handle, queued releases are sent along with the next EnqueueRequest to
+  // "client" (see TakePendingRemoteDecrefs). Returns true once
+  // kMaxPendingRemoteDecrefs releases are queued, in which case the caller
+  // should send them in a request of their own.
+  bool AddPendingRemoteDecref(eager::EagerClient* client, int64 op_id,
+                              int32 output_num);
+
+  // Appends the releases queued for "client" to "request", in the order in
+  // which they were queued.
+  void TakePendingRemoteDecrefs(eager::EagerClient* client,
+                                eager::EnqueueRequest* request);
 #endif
  private:
   void InitDeviceMapAndAsync();
@@ -226,6 +242,11 @@ class EagerContext {
   mutex cache_mu_;
   std::unordered_map<Fprint128, KernelAndDevice*, Fprint128Hasher> kernel_cache_
       GUARDED_BY(cache_mu_);
+  // Identifies the contents of kernel_cache_ across all the contexts, so that
+  // the per-thread caches can tell whether their kernels are still valid. It
+  // changes whenever the kernels are deleted.
+  static uint64 NewKernelCacheGeneration();
+  std::atomic<uint64> kernel_cache_generation_{NewKernelCacheGeneration()};
 
   // Whether we should compute RunMetadata.
   std::atomic<bool> should_store_metadata_{false};
@@ -255,6 +276,12 @@ class EagerContext {
   gtl::FlatMap<Device*, std::pair<eager::EagerClient*, uint64>>
       device_to_client_cache_;
 
+  static constexpr int kMaxPendingRemoteDecrefs = 64;
+  mutex remote_decrefs_mu_;
+  // client -> the handles whose release has not been sent to it yet.
+  gtl::FlatMap<eager::EagerClient*, std::vector<eager::RemoteTensorHandle>>
+      pending_remote_decrefs_ GUARDED_BY(remote_decrefs_mu_);
+
   const bool use_send_tensor_rpc_;
 #endif
 };
@@ -15,7 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include "tensorflow/core/platform/cpu_info.h"
+
 namespace tensorflow {
+namespace {
+
+// The maximum number of EagerNodes running in parallel.
+constexpr int kMaxNodesInParallel = 16;
+
+}  // namespace
 
 EagerNode::EagerNode(tensorflow::uint64 id) : id(id) {}
 
@@ -33,6 +41,10 @@ tensorflow::uint64 EagerExecutor::NextId() {
 void EagerExecutor::EnableAsync() {
   tensorflow::mutex_lock l(node_queue_mutex_);
   if (thread_ == nullptr) {
+    thread_pool_.reset(new thread::ThreadPool(
+        tensorflow::Env::Default(), "eager_async_node",
+        std::max(1, std::min(port::NumSchedulableCPUs(),
+                             kMaxNodesInParallel))));
     thread_.reset(tensorflow::Env::Default()->StartThread(
         tensorflow::ThreadOptions(), "eager_async_executor",
         std::bind(&EagerExecutor::Run, this)));
@@ -46,18 +58,17 @@ void EagerExecutor::Add(EagerNode* node) {
     delete node;
     return;
   }
-  int64 qlen = node_queue_.size();
-  if (qlen > 0) {
-    if (node_queue_.back()->id >= node->id) {
-      status_ = tensorflow::errors::InvalidArgument(
-          "Inserting EagerNode with non-increasing ids:",
-          node_queue_.back()->id, " vs ", node->id);
-      delete node;
-      return;
-    }
-    node_queue_.push(node);
-  } else {
-    node_queue_.push(node);
+  if (!unfinished_nodes_.empty() &&
+      *unfinished_nodes_.rbegin() >= node->id) {
+    status_ = tensorflow::errors::InvalidArgument(
+        "Inserting EagerNode with non-increasing ids:",
+        *unfinished_nodes_.rbegin(), " vs ", node->id);
+    delete node;
+    return;
+  }
+  unfinished_nodes_.insert(node->id);
+  node_queue_.push(node);
+  if (node_queue_.size() == 1) {
     nodes_pending_.notify_all();
   }
 }
@@ -72,31 +83,25 @@ tensorflow::Status EagerExecutor::WaitForAllPendingNodes() {
 
 tensorflow::Status EagerExecutor::WaitImpl(bool wait_all,
                                            tensorflow::uint64 node_id) {
-  tensorflow::condition_variable cond;
   tensorflow::mutex_lock l(node_queue_mutex_);
-  // Don't wait if an error is already set.
-  if (!status_.ok()) return status_;
-  if (node_queue_.empty()) return tensorflow::Status::OK();
   if (wait_all) {
-    node_id = node_queue_.back()->id;
-  } else if (node_id < node_queue_.front()->id) {
-    // Note that we are relying on the ops being dispatched sequentially from
-    // the queue.
-    return tensorflow::Status::OK();
+    if (unfinished_nodes_.empty()) return status_;
+    node_id = *unfinished_nodes_.rbegin();
   }
-  node_done_notifications_.insert(std::make_pair(node_id, &cond));
-  cond.wait(l);
   // Note that we could be woken up if an error occurs, even though the node has
   // not actually executed.
+  while (status_.ok() && !unfinished_nodes_.empty() &&
+         *unfinished_nodes_.begin() <= node_id) {
+    nodes_done_.wait(l);
+  }
   return status_;
 }
 
 void EagerExecutor::ClearError() {
   tensorflow::mutex_lock l(node_queue_mutex_);
   if (status_.ok()) return;
-  // If an error was set, node_done_notifications_ and node_queue_ should have
-  // been cleared, and no new entries should have been added since.
-  DCHECK(node_done_notifications_.empty());
+  // If an error was set, node_queue_ should have been cleared, and no new
+  // entries should have been added since.
   DCHECK(node_queue_.empty());
   status_ = tensorflow::Status::OK();
   nodes_pending_.notify_all();
@@ -108,8 +113,10 @@ tensorflow::Status EagerExecutor::status() {
 }
 
 void EagerExecutor::Run() {
+  std::vector<tensorflow::uint64> input_node_ids;
   while (true) {
     std::unique_ptr<EagerNode> curr_node;
+    bool in_parallel;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
@@ -117,36 +124,64 @@ void EagerExecutor::Run() {
         nodes_pending_.wait(l);
       }
       curr_node.reset(node_queue_.front());
-    }
-    tensorflow::Status status = curr_node->Run();
-    const bool ok = status.ok();
-    tensorflow::mutex_lock l(node_queue_mutex_);
-    node_queue_.pop();
-    if (!ok) {
-      status_ = status;
-      // TODO(agarwal): mark all affected handles as corrupted before clearing
-      // this queue.
-      // We remove any pending ops so that we don't try to execute them if
-      // ClearError is called.
-      for (int i = 0; i < node_queue_.size(); ++i) {
-        delete node_queue_.front();
-        node_queue_.pop();
+      node_queue_.pop();
+      input_node_ids.clear();
+      in_parallel = curr_node->RunsInParallel(&input_node_ids);
+      // Waits for the inputs of a node running in parallel, or for all the
+      // previous nodes otherwise.
+      auto ready = [this, &curr_node, &input_node_ids, in_parallel]() {
+        if (!in_parallel) {
+          return *unfinished_nodes_.begin() == curr_node->id;
+        }
+        for (tensorflow::uint64 id : input_node_ids) {
+          if (id < curr_node->id && unfinished_nodes_.count(id) > 0) {
+            return false;
+          }
+        }
+        return true;
+      };
+      while (status_.ok() && !ready()) {
+        nodes_done_.wait(l);
       }
-    }
-    if (!node_done_notifications_.empty()) {
-      tensorflow::uint64 node_id = curr_node->id;
-      // Note that we notify all waiting threads in case an error has occurred.
-      // These calling threads are responsible for checking status_ before
-      // proceeding.
-      const auto range = ok ? node_done_notifications_.equal_range(node_id)
-                            : make_pair(node_done_notifications_.begin(),
-                                        node_done_notifications_.end());
-      for (auto it = range.first; it != range.second; ++it) {
-        it->second->notify_all();
+      if (!status_.ok()) {
+        // The node is dropped, like those still queued.
+        unfinished_nodes_.erase(curr_node->id);
+        nodes_done_.notify_all();
+        continue;
       }
-      node_done_notifications_.erase(range.first, range.second);
+    }
+    if (in_parallel) {
+      EagerNode* node = curr_node.release();
+      thread_pool_->Schedule([this, node]() { NodeDone(node, node->Run()); });
+    } else {
+      const tensorflow::Status status = curr_node->Run();
+      NodeDone(curr_node.release(), status);
+    }
+  }
+}
+
+void EagerExecutor::NodeDone(EagerNode* node,
+                             const tensorflow::Status& status) {
+  // The node is deleted without holding the lock.
+  std::unique_ptr<EagerNode> done_node(node);
+  tensorflow::mutex_lock l(node_queue_mutex_);
+  unfinished_nodes_.erase(node->id);
+  if (!status.ok()) {
+    if (status_.ok()) status_ = status;
+    // TODO(agarwal): mark all affected handles as corrupted before clearing
+    // this queue.
+    // We remove any pending ops so that we don't try to execute them if
+    // ClearError is called.
+    while (!node_queue_.empty()) {
+      unfinished_nodes_.erase(node_queue_.front()->id);
+      delete node_queue_.front();
+      node_queue_.pop();
     }
   }
+  // Note that we notify all waiting threads in case an error has occurred.
+  // These calling threads are responsible for checking status_ before
+  // proceeding.
+  nodes_done_.notify_all();
 }
 
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -50,6 +52,14 @@ class EagerNode {
   // execution is done.
   virtual Status Run() = 0;
 
+  // Returns true if this node may run concurrently with other nodes once the
+  // nodes with ids in `input_node_ids` are done, and false if it must run
+  // after all the nodes added before it and before all the nodes added after
+  // it, which is the default.
+  virtual bool RunsInParallel(std::vector<uint64>* input_node_ids) const {
+    return false;
+  }
+
   // An id unique to the TFE_Context under which this node is created. Allocated
   // monotonically.
   const uint64 id;
@@ -61,8 +71,12 @@ class EagerNode {
 // device of the input handle. Fix that.
 // TODO(agarwal): On error, mark all affected handles as corrupted.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
+//
+// Nodes are dispatched in order. A node which RunsInParallel is dispatched to
+// a thread pool once its inputs are computed, and the nodes after it may be
+// dispatched before it is done. Other nodes, like those of stateful ops, run
+// one by one on the executor thread after all the previous nodes, so that
+// their effects are observed in order.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
 class EagerExecutor {
  public:
@@ -81,8 +95,8 @@ class EagerExecutor {
   // Note that Add must be called in monotonically increasing order of node->id.
   void Add(EagerNode* node);
 
-  // Causes the caller to block till node with id `node_id` has finished
-  // execution.
+  // Causes the caller to block till node with id `node_id`, and all the nodes
+  // added before it, have finished execution.
   Status WaitFor(uint64 node_id);
 
   // Blocks till all currently pending ops are done.
@@ -101,6 +115,9 @@ class EagerExecutor {
   // `status_` is not ok.
   void Run();
 
+  // Records that `node` is done, with `status`, and deletes it.
+  void NodeDone(EagerNode* node, const Status& status);
+
   Status WaitImpl(bool wait_all, uint64 node_id);
 
   mutex node_queue_mutex_;
@@ -108,21 +125,26 @@ class EagerExecutor {
   // Used to signal that some EagerNodes are pending execution.
   condition_variable nodes_pending_ GUARDED_BY(node_queue_mutex_);
 
-  // Queue of pending EagerNodes.
+  // Used to signal that some EagerNodes are done executing, or that an error
+  // was found.
+  condition_variable nodes_done_ GUARDED_BY(node_queue_mutex_);
+
+  // Queue of EagerNodes yet to be dispatched.
   std::queue<EagerNode*> node_queue_ GUARDED_BY(node_queue_mutex_);
 
+  // Ids of the EagerNodes added but not done executing, queued or running.
+  std::set<uint64> unfinished_nodes_ GUARDED_BY(node_queue_mutex_);
+
   // `status_` is set based on any errors raised during execution of a
   // EagerNode.  It remains set until ClearError is called.
   Status status_ GUARDED_BY(node_queue_mutex_);
 
-  // Map from id of a EagerNode to condition_variables (not owned by the map).
-  // These condition_variables are notified and removed when that EagerNode is
-  // done executing, or if an error is found in execution of any EagerNode.
-  std::multimap<uint64, condition_variable*> node_done_notifications_
-      GUARDED_BY(node_queue_mutex_);
+  // Runs the EagerNodes which RunsInParallel. It is declared before `thread_`
+  // so that it outlives the nodes dispatched by `thread_`.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
 
-  // Thread object that calls the `Run` method. Currently we use only one thread
-  // for executing the EagerNodes one-by-one.
+  // Thread object that calls the `Run` method, which dispatches the EagerNodes
+  // and runs those which must run one by one.
   std::unique_ptr<Thread> thread_ GUARDED_BY(node_queue_mutex_);
 
   // Indicates that `thread_` should stop as soon as it is done executing the
@@ -597,12 +597,15 @@ std::function<void()> GetRemoteTensorDestructor(
     EagerContext* ctx, eager::EagerClient* eager_client, uint64 context_id,
     uint64 op_id, int output_num) {
   return [ctx, eager_client, context_id, op_id, output_num]() {
+    // The release is usually sent along with the next op executed on the
+    // same worker; only a full batch of releases gets an RPC of its own.
+    if (!ctx->AddPendingRemoteDecref(eager_client, op_id, output_num)) {
+      return tensorflow::Status::OK();
+    }
     std::unique_ptr<eager::EnqueueRequest> request(new eager::EnqueueRequest);
     request->set_context_id(context_id);
-
-    auto* handle_to_decref = request->add_queue()->mutable_handle_to_decref();
-    handle_to_decref->set_op_id(op_id);
-    handle_to_decref->set_output_num(output_num);
+    ctx->TakePendingRemoteDecrefs(eager_client, request.get());
+    if (request->queue_size() == 0) return tensorflow::Status::OK();
 
     if (ctx->Async()) {
       tensorflow::uint64 id = ctx->NextId();
@@ -725,6 +728,9 @@ Status EagerRemoteExecute(EagerOperation* op, TensorHandle** retvals,
   // Inputs set above.
   op->Attrs().FillAttrValueMap(remote_op->mutable_attrs());
   remote_op->set_device(op->Device()->name());
+  // Piggyback the pending releases of remote handles on this request. They
+  // follow the op, so queue_response(0) still holds the op's output shapes.
+  ctx->TakePendingRemoteDecrefs(eager_client, request.get());
 
   DataTypeVector output_dtypes;
   TF_RETURN_IF_ERROR(GetOutputDTypes(op, &output_dtypes));
@@ -745,8 +751,6 @@ Status EagerRemoteExecute(EagerOperation* op, TensorHandle** retvals,
 
   const tensorflow::uint64 id = remote_op->id();
   for (int i = 0; i < *num_retvals; i++) {
-    // TODO(nareshmodi): Change the callback to instead add the decref to a list
-    // of pending decrefs that we can send as a batch with the next execute.
     std::function<void()> destructor =
         GetRemoteTensorDestructor(ctx, eager_client, context_id, id, i);
 
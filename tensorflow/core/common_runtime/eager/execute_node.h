@@ -60,6 +60,14 @@ class ExecuteNode : public EagerNode {
     }
   }
 
+  bool RunsInParallel(std::vector<uint64>* input_node_ids) const override {
+    if (kernel_->is_stateful()) return false;
+    for (auto handle : inputs_) {
+      input_node_ids->push_back(handle->node_id());
+    }
+    return true;
+  }
+
   tensorflow::Status Run() override {
     const Status status =
         EagerExecute(ctx_, op_device_, inputs_, kernel_, maybe_stats_.get(),
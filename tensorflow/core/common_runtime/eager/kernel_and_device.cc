@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -30,6 +31,16 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
+namespace {
+
+// Functions are not in the op registry, and are taken to be stateful.
+bool IsStatefulOp(const NodeDef& ndef) {
+  const OpDef* op_def = nullptr;
+  return !OpRegistry::Global()->LookUpOpDef(ndef.op(), &op_def).ok() ||
+         op_def->is_stateful();
+}
+
+}  // namespace
 
 // static
 Status KernelAndDevice::InitOp(Device* device, const NodeDef& ndef,
@@ -40,6 +51,7 @@ Status KernelAndDevice::InitOp(Device* device, const NodeDef& ndef,
                             nullptr, ndef, TF_GRAPH_DEF_VERSION, &k);
   out->device_ = device;
   out->kernel_.reset(k);
+  out->is_stateful_ = IsStatefulOp(ndef);
   out->flib_ = nullptr;
   out->runner_ = nullptr;
   out->default_runner_ = [](std::function<void()> f) { f(); };
@@ -54,6 +66,7 @@ Status KernelAndDevice::Init(const NodeDef& ndef, FunctionLibraryRuntime* flib,
   Status s = flib->CreateKernel(ndef, &k);
   out->device_ = flib->device();
   out->kernel_.reset(k);
+  out->is_stateful_ = IsStatefulOp(ndef);
   out->flib_ = flib;
   out->runner_ = runner;
   out->default_runner_ = [](std::function<void()> f) { f(); };
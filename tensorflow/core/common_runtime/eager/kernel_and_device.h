@@ -64,7 +64,10 @@ class KernelAndDevice {
                        KernelAndDevice* out);
 
   KernelAndDevice(tensorflow::Rendezvous* rendez)
-      : device_(nullptr), flib_(nullptr), rendez_(rendez) {}
+      : device_(nullptr),
+        flib_(nullptr),
+        rendez_(rendez),
+        is_stateful_(true) {}
 
   // TODO(ashankar): Handle list-valued inputs.
   Status Run(std::vector<Tensor>* inputs, std::vector<Tensor>* outputs,
@@ -74,6 +77,10 @@ class KernelAndDevice {
 
   Device* device() const { return device_; }
 
+  // True unless the kernel is of a registered op which is not stateful, so
+  // that running it concurrently with other kernels cannot change results.
+  bool is_stateful() const { return is_stateful_; }
+
   DataTypeVector* mutable_output_dtypes() { return &output_dtypes_; }
   const DataTypeVector& output_dtypes() { return output_dtypes_; }
 
@@ -89,6 +96,7 @@ class KernelAndDevice {
   checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache_;
   Rendezvous* rendez_;
   DataTypeVector output_dtypes_;
+  bool is_stateful_;
   std::function<void(std::function<void()>)>* runner_;
   std::function<void(std::function<void()>)> default_runner_;
 };
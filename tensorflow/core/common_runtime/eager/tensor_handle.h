@@ -126,6 +126,10 @@ class TensorHandle : public core::RefCounted {
   Status CopyToDevice(EagerContext* ctx, tensorflow::Device* dstd,
                       TensorHandle** output);
 
+  // Id of the EagerNode computing the value of this handle, or 0 if there is
+  // none.
+  uint64 node_id() const { return node_id_; }
+
   // Warning: can return nullptr for CPU tensors.
   EagerContext* Context() {
     mutex_lock ml(ctx_mutex_);
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -25,7 +26,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/trace_ring_buffer.h"
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -42,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -52,14 +57,19 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -68,6 +78,31 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Recorded by the executors that TF_EXECUTOR_METRICS enables; see
+// ExecutorImpl::metrics_level_.
+auto* op_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/op_latency_usecs",
+     "The time that the kernels of each op type took to compute.", "op"},
+    monitoring::Buckets::Exponential(1, 2, 30));
+auto* node_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/node_latency_usecs",
+     "The time that the kernel of each node took to compute.", "node"},
+    monitoring::Buckets::Exponential(1, 2, 30));
+auto* queueing_delay_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/queueing_delay_usecs",
+     "The time between a node becoming ready and starting to run.",
+     "device"},
+    monitoring::Buckets::Exponential(1, 2, 30));
+auto* step_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/step_latency_usecs",
+     "The time that the executor of each device took to run a step.",
+     "device"},
+    monitoring::Buckets::Exponential(1, 2, 30));
+auto* step_output_bytes = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/step_output_bytes",
+     "The bytes of the tensors that the kernels of a step output.", "device"},
+    monitoring::Buckets::Exponential(1, 4, 20));
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -124,6 +159,28 @@ bool SetTimelineLabel(const Node* node, NodeExecStatsWrapper* stats) {
   return is_transfer_node;
 }
 
+// Block size of the per-step arena, and the size beyond which a step's
+// allocations go to the device allocator instead.
+const size_t kStepArenaBlockSize = 1 << 20;
+const size_t kStepArenaMaxBytes = 256 << 20;
+
+// Node costs are measured in the first kCostWarmupSteps steps of an
+// executor and then in one step out of every kCostSampleInterval. A
+// synchronous node whose average measured cost is below
+// kInlineCostThresholdMicros runs inline on the thread that made it ready.
+const int64 kCostWarmupSteps = 4;
+const int64 kCostSampleInterval = 16;
+const int64 kInlineCostThresholdMicros = 10;
+
+// The work-stealing worker running on the current thread, if any. A worker
+// only runs nodes for one ExecutorState at a time, but a kernel may run a
+// nested executor synchronously, so RunWorker() saves and restores this.
+struct CurrentWorker {
+  const void* state = nullptr;
+  int id = -1;
+};
+thread_local CurrentWorker current_worker;
+
 // Helper routines for collecting step stats.
 namespace nodestats {
 inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
@@ -181,6 +238,11 @@ void SetMemory(NodeExecStatsWrapper* stats, OpKernelContext* ctx) {
   ms->set_persistent_memory_size(ctx->persistent_memory_allocated());
 }
 
+void SetMeasuredCost(NodeExecStatsWrapper* stats, int64 cost_micros) {
+  if (!stats || cost_micros < 0) return;
+  stats->stats()->set_measured_cost_micros(cost_micros);
+}
+
 void SetReferencedTensors(NodeExecStatsWrapper* stats,
                           const TensorReferenceVector& tensors) {
   if (!stats) return;
@@ -224,6 +286,9 @@ struct NodeItem {
   bool is_sink : 1;              // True iff IsSink(node)
   // True iff IsEnter(node) || IsExit(node) || IsNextIteration(node)
   bool is_enter_exit_or_next_iter : 1;
+  // True iff the outputs of this node may be kept past the end of the step,
+  // so they must not be allocated from the step arena.
+  bool outputs_outlive_step : 1;
 
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
@@ -239,6 +304,10 @@ struct NodeItem {
 
   PendingCounts::Handle pending_id;
 
+  // The rank of this node in the memory-efficient order computed by grappler
+  // (the "_execution_priority" attribute). Lower values should run first.
+  int32 priority = 0;
+
   const EdgeInfo* output_edge_list() const { return output_edge_base(); }
 
   // ith output edge.
@@ -348,8 +417,16 @@ class GraphView {
 
 class ExecutorImpl : public Executor {
  public:
-  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g)
-      : params_(p), graph_(std::move(g)), gview_() {
+  // If "work_stealing" is true, every step keeps one queue of ready nodes
+  // per inter-op worker instead of scheduling each node as its own closure.
+  // See ExecutorState::ScheduleReadyWorkStealing().
+  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g,
+               bool work_stealing = false)
+      : params_(p),
+        graph_(std::move(g)),
+        gview_(),
+        work_stealing_(work_stealing),
+        num_workers_(work_stealing ? port::NumSchedulableCPUs() : 0) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
   }
@@ -417,6 +494,49 @@ class ExecutorImpl : public Executor {
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
 
+  // Sets NodeItem::outputs_outlive_step for every node.
+  void MarkOutputsOutlivingStep();
+
+  // Returns true if the next step to start should measure node costs.
+  bool SampleCostsInNextStep() const {
+    const int64 step = num_steps_started_.fetch_add(1);
+    return step < kCostWarmupSteps || step % kCostSampleInterval == 0;
+  }
+
+  // Folds a measured compute time of node "id" into its moving average.
+  // Concurrent steps may race and drop a sample, which is harmless.
+  void RecordMeasuredCost(int id, int64 cost_micros) const {
+    std::atomic<int64>& cost = measured_costs_[id];
+    const int64 old_cost = cost.load(std::memory_order_relaxed);
+    cost.store(old_cost < 0 ? cost_micros
+                            : old_cost + (cost_micros - old_cost) / 8,
+               std::memory_order_relaxed);
+  }
+
+  // Records that the kernel of node "id" took "micros" to compute. Requires
+  // metrics_level_ > 0.
+  void RecordLatency(int id, int64 micros) const {
+    op_latency_cells_[id]->Add(micros);
+    if (node_latency_cells_) node_latency_cells_[id]->Add(micros);
+  }
+
+  // Returns the average measured compute time of node "id", or -1 if it
+  // has not been measured.
+  int64 MeasuredCost(int id) const {
+    return measured_costs_[id].load(std::memory_order_relaxed);
+  }
+
+  // Returns true if "item" should be dispatched to the threadpool rather
+  // than run inline. Dead nodes are always run inline.
+  bool IsExpensive(const NodeItem& item) const {
+    if (!use_measured_costs_ || item.kernel_is_async) {
+      return item.kernel_is_expensive;
+    }
+    const int64 cost = MeasuredCost(item.node->id());
+    if (cost < 0) return item.kernel_is_expensive;
+    return cost >= kInlineCostThresholdMicros;
+  }
+
   FrameInfo* EnsureFrameInfo(const string& fname) {
     auto slot = &frame_info_[fname];
     if (*slot == nullptr) {
@@ -433,6 +553,48 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // True iff some node has an execution priority, in which case the ready
+  // nodes are run by increasing priority.
+  bool has_priorities_ = false;
+
+  // Whether steps use per-worker ready queues, and how many workers (and
+  // queues) each step may use.
+  const bool work_stealing_;
+  const int num_workers_;
+
+  // If true, each step allocates short-lived CPU tensors from its own
+  // StepArenaAllocator. Enabled by TF_CPU_STEP_ARENA_ALLOCATOR=1.
+  bool use_step_arena_ = false;
+
+  // If true, synchronous kernels are run inline or dispatched based on
+  // their measured cost rather than OpKernel::IsExpensive(). Enabled by
+  // TF_EXECUTOR_USE_MEASURED_COSTS=1.
+  bool use_measured_costs_ = false;
+  // Indexed by node id. See RecordMeasuredCost().
+  std::unique_ptr<std::atomic<int64>[]> measured_costs_;
+  mutable std::atomic<int64> num_steps_started_{0};
+
+  // If not -1, every node run is recorded into TraceRingBuffer::Global()
+  // under this device id. Enabled by TF_EXECUTOR_TRACE_RING_BUFFER=1.
+  int32 trace_device_id_ = -1;
+  // If positive and trace_dump_dir_ is not empty, the recorded nodes of
+  // each step that takes longer than this are written to trace_dump_dir_.
+  // Set by TF_EXECUTOR_TRACE_SLOW_STEP_MICROS and TF_EXECUTOR_TRACE_DUMP_DIR.
+  int64 trace_slow_step_micros_ = 0;
+  string trace_dump_dir_;
+
+  // Set by TF_EXECUTOR_METRICS. If positive, the latency of each kernel is
+  // added to op_latency_usecs (and, if 2 or more, to node_latency_usecs)
+  // and each step records its latency, queueing delays and output bytes.
+  // The cells are looked up once here, so recording does not take locks.
+  int64 metrics_level_ = 0;
+  // Indexed by node id. node_latency_cells_ is null if metrics_level_ < 2.
+  std::unique_ptr<monitoring::SamplerCell*[]> op_latency_cells_;
+  std::unique_ptr<monitoring::SamplerCell*[]> node_latency_cells_;
+  monitoring::SamplerCell* queueing_delay_cell_ = nullptr;
+  monitoring::SamplerCell* step_latency_cell_ = nullptr;
+  monitoring::SamplerCell* step_output_bytes_cell_ = nullptr;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -444,15 +606,6 @@ class ExecutorImpl : public Executor {
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
-// Infer memory allocation attributes of a node n's output,
-// based on its use node dst.  Note that dst might not be directly
-// connected to n by a single edge, but might be a downstream
-// consumer of n's output by reference.  *attr is updated with any
-// necessary attributes.
-Status InferAllocAttr(const Node* n, const Node* dst,
-                      const DeviceNameUtils::ParsedName& local_dev_name,
-                      AllocatorAttributes* attr);
-
 GraphView::~GraphView() {
   static_assert(std::is_trivially_destructible<AllocatorAttributes>::value,
                 "Update code if AllocatorAttributes gains a destructor");
@@ -707,6 +860,11 @@ Status ExecutorImpl::Initialize() {
     item->is_sink = IsSink(n);
     item->is_enter_exit_or_next_iter =
         (IsEnter(n) || IsExit(n) || IsNextIteration(n));
+    const AttrValue* priority = n->attrs().Find("_execution_priority");
+    if (priority != nullptr) {
+      item->priority = priority->i();
+      has_priorities_ = true;
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -730,9 +888,86 @@ Status ExecutorImpl::Initialize() {
   // all nodes.
   InitializePending(graph_.get(), cf_info);
 
+  if (params_.device->device_type() == DEVICE_CPU) {
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_CPU_STEP_ARENA_ALLOCATOR", false,
+                                          &use_step_arena_));
+  }
+  MarkOutputsOutlivingStep();
+
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_USE_MEASURED_COSTS",
+                                        false, &use_measured_costs_));
+  if (use_measured_costs_) {
+    measured_costs_.reset(new std::atomic<int64>[graph_->num_node_ids()]);
+    for (int i = 0; i < graph_->num_node_ids(); ++i) {
+      measured_costs_[i].store(-1, std::memory_order_relaxed);
+    }
+  }
+
+  bool use_trace_ring_buffer = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_TRACE_RING_BUFFER", false,
+                                        &use_trace_ring_buffer));
+  if (use_trace_ring_buffer) {
+    trace_device_id_ =
+        TraceRingBuffer::Global()->InternDevice(params_.device->name());
+    TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+        "TF_EXECUTOR_TRACE_SLOW_STEP_MICROS", 0, &trace_slow_step_micros_));
+    TF_RETURN_IF_ERROR(ReadStringFromEnvVar("TF_EXECUTOR_TRACE_DUMP_DIR", "",
+                                            &trace_dump_dir_));
+  }
+
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar("TF_EXECUTOR_METRICS", 0, &metrics_level_));
+  if (metrics_level_ > 0) {
+    const string& device_name = params_.device->name();
+    queueing_delay_cell_ = queueing_delay_usecs->GetCell(device_name);
+    step_latency_cell_ = step_latency_usecs->GetCell(device_name);
+    step_output_bytes_cell_ = step_output_bytes->GetCell(device_name);
+    op_latency_cells_.reset(
+        new monitoring::SamplerCell*[graph_->num_node_ids()]());
+    if (metrics_level_ >= 2) {
+      node_latency_cells_.reset(
+          new monitoring::SamplerCell*[graph_->num_node_ids()]());
+    }
+    for (const Node* n : graph_->nodes()) {
+      op_latency_cells_[n->id()] = op_latency_usecs->GetCell(n->type_string());
+      if (node_latency_cells_) {
+        node_latency_cells_[n->id()] = node_latency_usecs->GetCell(n->name());
+      }
+    }
+  }
+
   return gview_.SetAllocAttrs(graph_.get(), params_.device);
 }
 
+void ExecutorImpl::MarkOutputsOutlivingStep() {
+  // Visit consumers before producers, so that values passed through
+  // Identity and control flow nodes inherit the answer of their consumers.
+  // This is a heuristic: a tensor forwarded into a kernel's output or state
+  // in other ways is still safe, because the step arena stays alive until
+  // its last tensor is deallocated.
+  std::vector<Node*> order;
+  GetPostOrder(*graph_, &order);
+  for (const Node* n : order) {
+    NodeItem* item = gview_.node(n->id());
+    bool outlives = !use_step_arena_ || n->op_def().is_stateful();
+    for (int i = 0; !outlives && i < n->num_outputs(); ++i) {
+      outlives = IsRefType(n->output_type(i));
+    }
+    for (const Edge* e : n->out_edges()) {
+      if (outlives) break;
+      if (e->IsControlEdge()) continue;
+      const Node* dst = e->dst();
+      // Values fetched by the caller, sent to another device or handed to a
+      // stateful op (e.g. a variable update or an enqueue) may be kept.
+      outlives = dst->IsSend() || dst->type_string() == "_Retval" ||
+                 dst->op_def().is_stateful() ||
+                 (IsHostMemoryPreserving(dst) &&
+                  gview_.node(dst->id())->outputs_outlive_step);
+    }
+    item->outputs_outlive_step = outlives;
+  }
+}
+
 // If a Node has been marked to use a ScopedAllocator x for output i, then
 // sc_attr will contain the subsequence (i, x) at an even offset.  This function
 // extracts and transfers that ScopedAllocator id to alloc_attr.  For now, we
@@ -833,6 +1068,8 @@ Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
   return s;
 }
 
+}  // namespace
+
 Status InferAllocAttr(const Node* n, const Node* dst,
                       const DeviceNameUtils::ParsedName& local_dev_name,
                       AllocatorAttributes* attr) {
@@ -899,6 +1136,8 @@ Status InferAllocAttr(const Node* n, const Node* dst,
   return s;
 }
 
+namespace {
+
 // The state associated with one invocation of ExecutorImpl::Run.
 // ExecutorState dispatches nodes when they become ready and keeps
 // track of how many predecessors of a node have not done (pending_).
@@ -1261,6 +1500,14 @@ class ExecutorState {
     TaggedNodeReadyQueue() : front_index_(0) {}
 
     void push_back(TaggedNode node) { ready_.push_back(node); }
+    // Inserts `node` before the first queued node that `less` orders after
+    // it, so that a queue filled this way stays sorted.
+    template <typename Less>
+    void insert_sorted(TaggedNode node, Less less) {
+      auto it = ready_.begin() + front_index_;
+      while (it != ready_.end() && !less(node, *it)) ++it;
+      ready_.insert(it, node);
+    }
     TaggedNode front() const {
       DCHECK_LT(front_index_, ready_.size());
       return ready_[front_index_];
@@ -1290,6 +1537,13 @@ class ExecutorState {
 
   struct AsyncState;
 
+  // A ready node waiting in one of the work-stealing queues.
+  struct QueuedNode {
+    TaggedNode tagged_node{nullptr, nullptr, -1, false};
+    int64 scheduled_usec = 0;
+  };
+  typedef WorkStealingQueue<QueuedNode> ReadyQueue;
+
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
 
   // true if LogMemory::IsEnabled(). Used to check memory enabled cheaply.
@@ -1327,6 +1581,34 @@ class ExecutorState {
 
   std::atomic_int_fast32_t num_outstanding_ops_;
 
+  // Work-stealing mode only. One ready queue per worker. "num_queued_" is
+  // the total number of nodes in all queues and "num_active_workers_" the
+  // number of RunWorker() loops; a worker that runs dry re-checks
+  // "num_queued_" after leaving so that a concurrent push never goes
+  // unnoticed. "num_refs_" holds one reference for the step plus one per
+  // running worker, and the last one released calls Finish().
+  std::unique_ptr<ReadyQueue[]> ready_queues_;
+  std::atomic<int64> num_queued_{0};
+  std::atomic<int> num_active_workers_{0};
+  std::atomic<int> num_refs_{1};
+  std::atomic<uint32> next_queue_{0};
+
+  // If not null, the arena for tensors that do not outlive this step. It
+  // deletes itself after StepDone() once its last tensor is deallocated.
+  StepArenaAllocator* step_arena_ = nullptr;
+
+  // True if this step measures the compute time of synchronous kernels.
+  bool sample_costs_ = false;
+
+  // When the step started, if it records into the trace ring buffer or
+  // exports metrics.
+  int64 step_start_micros_ = 0;
+
+  // Whether this step exports metrics (see ExecutorImpl::metrics_level_),
+  // and the bytes output by its kernels so far.
+  bool record_metrics_ = false;
+  std::atomic<int64> output_bytes_{0};
+
   mutex mu_;
   Status status_ GUARDED_BY(mu_);
 
@@ -1387,6 +1669,35 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      TaggedNodeReadyQueue* inline_ready);
 
+  // Work-stealing variant of ScheduleReady(). When called on a worker, the
+  // first node in 'ready' continues inline (if 'inline_ready' is empty) and
+  // the rest go to the back of the worker's own queue, so successors of a
+  // node stay on the thread that produced their inputs. Otherwise the nodes
+  // are spread across the queues. Idle workers are started as needed.
+  void ScheduleReadyWorkStealing(const TaggedNodeSeq& ready,
+                                 TaggedNodeReadyQueue* inline_ready,
+                                 int64 scheduled_usec);
+
+  // Starts a RunWorker() loop on the runner if fewer than
+  // impl_->num_workers_ are active.
+  void MaybeStartWorker(int worker_id);
+
+  // Runs nodes from queue 'worker_id', stealing from the other queues when
+  // it is empty, until there is no queued work left.
+  void RunWorker(int worker_id);
+
+  // Pops a node from the back of queue 'worker_id', or steals one from the
+  // front of another queue. Returns false if all queues are empty.
+  bool PopReady(int worker_id, QueuedNode* node);
+
+  // Called once the step has no outstanding ops. Calls Finish() directly,
+  // or in work-stealing mode once the last worker has exited.
+  void StepDone();
+
+  // Releases a reference taken by the step or by a worker in work-stealing
+  // mode, calling Finish() on the last one.
+  void Unref();
+
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
 
@@ -1405,6 +1716,13 @@ class ExecutorState {
   // Clean up when this executor is done.
   void Finish();
 
+  // Called by Finish() when the step records into the trace ring buffer.
+  // Writes the step's trace if the step was slower than the threshold.
+  void MaybeDumpSlowStep();
+
+  // Adds the bytes of the tensors in "outputs" to output_bytes_.
+  void RecordOutputBytes(const EntryVector& outputs);
+
   // A standalone routine for this expression so that we can express
   // that we don't want thread safety analysis on this reference (it's
   // safe to do without the lock because the iterations array never
@@ -1446,6 +1764,24 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       root_frame_->pending_counts, root_frame_->total_input_tensors);
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
+
+  if (impl_->work_stealing_) {
+    ready_queues_.reset(new ReadyQueue[impl_->num_workers_]);
+  }
+  if (impl_->use_step_arena_) {
+    step_arena_ = new StepArenaAllocator(
+        impl_->params_.device->GetAllocator(AllocatorAttributes()),
+        kStepArenaBlockSize, kStepArenaMaxBytes);
+  }
+  // Steps that collect stats always measure, so that the reported costs
+  // are those of the step.
+  sample_costs_ =
+      impl_->use_measured_costs_ &&
+      (stats_collector_ != nullptr || impl_->SampleCostsInNextStep());
+  record_metrics_ = impl_->metrics_level_ > 0;
+  if (impl_->trace_device_id_ >= 0 || record_metrics_) {
+    step_start_micros_ = Env::Default()->NowMicros();
+  }
 }
 
 ExecutorState::~ExecutorState() {
@@ -1456,6 +1792,8 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  // After the frames, whose tensors may have been allocated from the arena.
+  if (step_arena_ != nullptr) step_arena_->StepDone();
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1604,6 +1942,8 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsWrapper* stats;
+  // Set if the step records into the trace ring buffer.
+  int64 start_micros = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1673,6 +2013,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.op_device_context = device_context_map_[id];
     }
 
+    if (record_metrics_ && scheduled_usec > 0) {
+      impl_->queueing_delay_cell_->Add(nodestats::NowInUsec() -
+                                       scheduled_usec);
+    }
+
     params.track_allocations = false;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.is_dead) {
@@ -1722,6 +2067,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       // Set up compute params.
       OpKernel* op_kernel = item.kernel;
       params.op_kernel = op_kernel;
+      params.step_allocator = step_arena_;
+      params.outputs_outlive_step = item.outputs_outlive_step;
       params.frame_iter = FrameAndIter(input_frame->frame_id, input_iter);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
@@ -1741,8 +2088,22 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           Entry* first_input = state->first_input;     // Shorthand
 
           nodestats::SetOpEnd(stats);
+          if (impl_->trace_device_id_ >= 0 || record_metrics_) {
+            const int64 end_micros = Env::Default()->NowMicros();
+            if (impl_->trace_device_id_ >= 0) {
+              TraceRingBuffer::Global()->Record(
+                  impl_->trace_device_id_, step_id_,
+                  state->tagged_node.node->name(), state->start_micros,
+                  end_micros);
+            }
+            if (record_metrics_) {
+              impl_->RecordLatency(state->item->node->id(),
+                                   end_micros - state->start_micros);
+            }
+          }
           EntryVector outputs;
           Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
+          if (record_metrics_) RecordOutputBytes(outputs);
           nodestats::SetMemory(stats, &state->ctx);
           if (vlog_) {
             VLOG(2) << "Async kernel done: " << state->item->node->id()
@@ -1778,17 +2139,39 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           const bool completed =
               NodeDone(s, state->item->node, ready, stats, nullptr);
           delete state;
-          if (completed) Finish();
+          if (completed) StepDone();
         };
         nodestats::SetOpStart(stats);
+        if (impl_->trace_device_id_ >= 0 || record_metrics_) {
+          state->start_micros = Env::Default()->NowMicros();
+        }
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        const bool timed =
+            sample_costs_ || impl_->trace_device_id_ >= 0 || record_metrics_;
+        const int64 start_micros = timed ? Env::Default()->NowMicros() : 0;
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        if (timed) {
+          const int64 end_micros = Env::Default()->NowMicros();
+          if (sample_costs_) {
+            impl_->RecordMeasuredCost(id, end_micros - start_micros);
+            nodestats::SetMeasuredCost(stats, impl_->MeasuredCost(id));
+          }
+          if (impl_->trace_device_id_ >= 0) {
+            TraceRingBuffer::Global()->Record(impl_->trace_device_id_,
+                                              step_id_, node->name(),
+                                              start_micros, end_micros);
+          }
+          if (record_metrics_) {
+            impl_->RecordLatency(id, end_micros - start_micros);
+          }
+        }
         nodestats::SetOpEnd(stats);
         s = ProcessOutputs(item, &ctx, &outputs, stats);
+        if (record_metrics_) RecordOutputBytes(outputs);
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
           ctx.retrieve_accessed_tensors(&accessed_tensors);
@@ -1822,7 +2205,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // device_context is set above in synchronous computes
         device->ConsumeListOfAccessedTensors(device_context, accessed_tensors);
       }
-      if (stats) {
+      if (stats || record_metrics_) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
@@ -1831,7 +2214,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   }  // while !inline_ready.empty()
 
   // This thread of computation is done if completed = true.
-  if (completed) Finish();
+  if (completed) StepDone();
 }
 
 Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -2199,9 +2582,13 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
-  if (stats_collector_) {
+  if (stats_collector_ || record_metrics_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  if (impl_->work_stealing_) {
+    ScheduleReadyWorkStealing(ready, inline_ready, scheduled_usec);
+    return;
+  }
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
@@ -2210,12 +2597,32 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     return;
   }
   const GraphView& gview = impl_->gview_;
+  auto runs_before = [&gview](const TaggedNode& a, const TaggedNode& b) {
+    return gview.node(a.node->id())->priority <
+           gview.node(b.node->id())->priority;
+  };
+  const TaggedNodeSeq* nodes = &ready;
+  TaggedNodeSeq sorted;
+  if (impl_->has_priorities_ && ready.size() > 1) {
+    // Visit the nodes from the last to the first one to run, so that the
+    // expensive node kept on this thread is the most urgent one.
+    sorted = ready;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&runs_before](const TaggedNode& a, const TaggedNode& b) {
+                       return runs_before(b, a);
+                     });
+    nodes = &sorted;
+  }
   const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
+  for (auto& tagged_node : *nodes) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
-    if (tagged_node.is_dead || !item.kernel_is_expensive) {
+    if (tagged_node.is_dead || !impl_->IsExpensive(item)) {
       // Inline this inexpensive node.
-      inline_ready->push_back(tagged_node);
+      if (impl_->has_priorities_) {
+        inline_ready->insert_sorted(tagged_node, runs_before);
+      } else {
+        inline_ready->push_back(tagged_node);
+      }
     } else {
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
@@ -2239,6 +2646,110 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   }
 }
 
+void ExecutorState::ScheduleReadyWorkStealing(
+    const TaggedNodeSeq& ready, TaggedNodeReadyQueue* inline_ready,
+    int64 scheduled_usec) {
+  const int num_workers = impl_->num_workers_;
+  const bool on_worker = current_worker.state == this;
+  size_t begin = 0;
+  if (on_worker && inline_ready != nullptr && inline_ready->empty()) {
+    // Keep the first successor on this thread: its inputs were just
+    // produced here.
+    inline_ready->push_back(ready[0]);
+    begin = 1;
+  }
+  const size_t num_pushed = ready.size() - begin;
+  if (num_pushed == 0) return;
+
+  QueuedNode queued;
+  queued.scheduled_usec = scheduled_usec;
+  int first_queue;
+  if (on_worker) {
+    first_queue = current_worker.id;
+    for (size_t i = begin; i < ready.size(); ++i) {
+      queued.tagged_node = ready[i];
+      ready_queues_[first_queue].PushBack(queued);
+    }
+  } else {
+    first_queue = next_queue_.fetch_add(num_pushed) % num_workers;
+    for (size_t i = begin; i < ready.size(); ++i) {
+      queued.tagged_node = ready[i];
+      ready_queues_[(first_queue + i - begin) % num_workers].PushBack(queued);
+    }
+  }
+  num_queued_.fetch_add(num_pushed);
+
+  // Wake up at most one idle worker per pushed node. New workers start on
+  // the queues following 'first_queue' so that they find work immediately
+  // when the nodes were spread across queues.
+  const size_t num_to_start = std::min<size_t>(num_pushed, num_workers);
+  for (size_t i = 0; i < num_to_start; ++i) {
+    if (num_active_workers_.load() >= num_workers) break;
+    MaybeStartWorker((first_queue + i + (on_worker ? 1 : 0)) % num_workers);
+  }
+}
+
+void ExecutorState::MaybeStartWorker(int worker_id) {
+  int active = num_active_workers_.load();
+  do {
+    if (active >= impl_->num_workers_) return;
+  } while (!num_active_workers_.compare_exchange_weak(active, active + 1));
+  num_refs_.fetch_add(1, std::memory_order_relaxed);
+  runner_([this, worker_id]() { RunWorker(worker_id); });
+}
+
+void ExecutorState::RunWorker(int worker_id) {
+  const CurrentWorker saved_worker = current_worker;
+  current_worker.state = this;
+  current_worker.id = worker_id;
+  while (true) {
+    QueuedNode queued;
+    while (PopReady(worker_id, &queued)) {
+      Process(queued.tagged_node, queued.scheduled_usec);
+    }
+    num_active_workers_.fetch_sub(1);
+    // A node may have been pushed after the last PopReady() by a thread
+    // that saw this worker as still active and so did not start another.
+    if (num_queued_.load() == 0) break;
+    int active = num_active_workers_.load();
+    bool rejoined = false;
+    while (active < impl_->num_workers_) {
+      if (num_active_workers_.compare_exchange_weak(active, active + 1)) {
+        rejoined = true;
+        break;
+      }
+    }
+    if (!rejoined) break;
+  }
+  current_worker = saved_worker;
+  // This may delete "this".
+  Unref();
+}
+
+bool ExecutorState::PopReady(int worker_id, QueuedNode* node) {
+  const int num_workers = impl_->num_workers_;
+  bool found = ready_queues_[worker_id].PopBack(node);
+  for (int i = 1; !found && i < num_workers; ++i) {
+    found = ready_queues_[(worker_id + i) % num_workers].StealFront(node);
+  }
+  if (found) num_queued_.fetch_sub(1);
+  return found;
+}
+
+void ExecutorState::StepDone() {
+  if (impl_->work_stealing_) {
+    Unref();
+  } else {
+    Finish();
+  }
+}
+
+void ExecutorState::Unref() {
+  if (num_refs_.fetch_sub(1) == 1) {
+    Finish();
+  }
+}
+
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
                                               int64 node_id) {
   // TODO(misard) Replace with a finer-grain enabling flag once we
@@ -2370,6 +2881,40 @@ void ExecutorState::DumpState() {
   }
 }
 
+void ExecutorState::RecordOutputBytes(const EntryVector& outputs) {
+  int64 bytes = 0;
+  for (const Entry& entry : outputs) {
+    if (entry.val_field_is_set) bytes += entry.val->TotalBytes();
+  }
+  output_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ExecutorState::MaybeDumpSlowStep() {
+  if (impl_->trace_slow_step_micros_ <= 0 || impl_->trace_dump_dir_.empty()) {
+    return;
+  }
+  const int64 step_micros = Env::Default()->NowMicros() - step_start_micros_;
+  if (step_micros <= impl_->trace_slow_step_micros_) return;
+  // The dump holds what every executor of the step has recorded so far.
+  StepStats step_stats;
+  TraceRingBuffer::Global()->Dump(step_id_, &step_stats);
+  const string fname = io::JoinPath(
+      impl_->trace_dump_dir_,
+      strings::StrCat("step_", step_id_, "_",
+                      str_util::StringReplace(impl_->params_.device->name(),
+                                              "/", "_", true /*replace_all*/),
+                      ".step_stats.pb"));
+  Status s = WriteBinaryProto(Env::Default(), fname, step_stats);
+  if (s.ok()) {
+    LOG(INFO) << "Step " << step_id_ << " on "
+              << impl_->params_.device->name() << " took " << step_micros
+              << "us; wrote its trace to " << fname;
+  } else {
+    LOG(WARNING) << "Failed to write the trace of slow step " << step_id_
+                 << ": " << s;
+  }
+}
+
 void ExecutorState::Finish() {
   mu_.lock();
   auto status = status_;
@@ -2383,6 +2928,13 @@ void ExecutorState::Finish() {
     // the user until the step (and its side-effects) has actually completed.
     status = impl_->params_.device->Sync();
   }
+  if (impl_->trace_device_id_ >= 0) MaybeDumpSlowStep();
+  if (record_metrics_) {
+    impl_->step_latency_cell_->Add(Env::Default()->NowMicros() -
+                                   step_start_micros_);
+    impl_->step_output_bytes_cell_->Add(
+        output_bytes_.load(std::memory_order_relaxed));
+  }
   delete this;
   CHECK(done_cb != nullptr);
   runner([=]() { done_cb(status); });
@@ -2720,10 +3272,13 @@ void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
 
 }  // namespace
 
-Status NewLocalExecutor(const LocalExecutorParams& params,
-                        std::unique_ptr<const Graph> graph,
-                        Executor** executor) {
-  ExecutorImpl* impl = new ExecutorImpl(params, std::move(graph));
+namespace {
+
+Status NewExecutorImpl(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph, bool work_stealing,
+                       Executor** executor) {
+  ExecutorImpl* impl =
+      new ExecutorImpl(params, std::move(graph), work_stealing);
   const Status s = impl->Initialize();
   if (s.ok()) {
     *executor = impl;
@@ -2733,6 +3288,15 @@ Status NewLocalExecutor(const LocalExecutorParams& params,
   return s;
 }
 
+}  // namespace
+
+Status NewLocalExecutor(const LocalExecutorParams& params,
+                        std::unique_ptr<const Graph> graph,
+                        Executor** executor) {
+  return NewExecutorImpl(params, std::move(graph), /*work_stealing=*/false,
+                         executor);
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const NodeDef& ndef, int graph_def_version,
                              OpKernel** kernel) {
@@ -2768,6 +3332,30 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING" executor: the default executor with one
+// ready queue per inter-op worker. Select it with
+// ConfigProto.Experimental.executor_type.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewExecutorImpl(params, std::move(graph),
+                                         /*work_stealing=*/true, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -221,6 +221,15 @@ class ExecutorBarrier {
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorBarrier);
 };
 
+// Infer memory allocation attributes of a node n's output,
+// based on its use node dst.  Note that dst might not be directly
+// connected to n by a single edge, but might be a downstream
+// consumer of n's output by reference.  *attr is updated with any
+// necessary attributes.
+Status InferAllocAttr(const Node* n, const Node* dst,
+                      const DeviceNameUtils::ParsedName& local_dev_name,
+                      AllocatorAttributes* attr);
+
 // A few helpers to facilitate create/delete kernels.
 
 // Creates a kernel based on "ndef" on device "device". The kernel can
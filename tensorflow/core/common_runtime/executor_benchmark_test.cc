@@ -0,0 +1,355 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the scheduling overhead of running graphs, separated from
+// kernel time by using graphs of (nearly) free kernels.
+//
+// The graphs come in several shapes (see GraphShape), and are run directly
+// by an Executor, by a DirectSession and by a GraphRunner. Besides the time
+// per step, each benchmark reports in its label the time per node scheduled
+// and per edge propagated. The time per step of a graph of size 1 is the
+// fixed cost of a step: e.g. the Executor's per-step setup, or the
+// GraphRunner's copy of the graph and construction of an executor.
+//
+// Run with:
+//   bazel run -c opt \
+//     //tensorflow/core:common_runtime_executor_benchmark_test \
+//     -- --benchmarks=all
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+enum GraphShape {
+  // A NoOp fanning out to "size" NoOps, which fan in to one NoOp.
+  kWide = 0,
+  // A chain of "size" NoOps.
+  kDeep = 1,
+  // "size" NoOps, each with control inputs from up to 4 random earlier ones.
+  kRandomDag = 2,
+  // A while loop of "size" iterations, incrementing an int32 counter.
+  kWhileLoop = 3,
+};
+
+// The number of nodes and edges that a step of a graph processes. Loop nodes
+// count once per iteration.
+struct GraphStats {
+  int64 nodes = 0;
+  int64 edges = 0;
+};
+
+// Adds the node "done" to "g", which the runners fetch. It outputs "input",
+// or a constant if "input" is null, after all of "control_inputs".
+void AddDone(Graph* g, Node* input, const std::vector<Node*>& control_inputs,
+             GraphStats* stats) {
+  Node* done;
+  if (input == nullptr) {
+    TF_CHECK_OK(NodeBuilder("done", "Const")
+                    .Attr("dtype", DT_INT32)
+                    .Attr("value", test::AsScalar<int32>(0))
+                    .ControlInputs(control_inputs)
+                    .Finalize(g, &done));
+  } else {
+    TF_CHECK_OK(NodeBuilder("done", "Identity")
+                    .Input(input)
+                    .ControlInputs(control_inputs)
+                    .Finalize(g, &done));
+  }
+  stats->nodes += 1;
+  stats->edges += control_inputs.size() + (input == nullptr ? 0 : 1);
+}
+
+// Adds an Enter node of a loop invariant to "g".
+Node* EnterConstant(Graph* g, Node* input, const string& frame_name) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Enter")
+                  .Input(input)
+                  .Attr("frame_name", frame_name)
+                  .Attr("is_constant", true)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+Graph* BuildGraph(GraphShape shape, int size, GraphStats* stats) {
+  Graph* g = new Graph(OpRegistry::Global());
+  *stats = GraphStats();
+  switch (shape) {
+    case kWide: {
+      Node* source = test::graph::NoOp(g, {});
+      std::vector<Node*> middle;
+      for (int i = 0; i < size; ++i) {
+        middle.push_back(test::graph::NoOp(g, {source}));
+      }
+      Node* sink = test::graph::NoOp(g, middle);
+      stats->nodes = size + 2;
+      stats->edges = 2 * size;
+      AddDone(g, nullptr, {sink}, stats);
+      break;
+    }
+    case kDeep: {
+      Node* last = test::graph::NoOp(g, {});
+      for (int i = 1; i < size; ++i) {
+        last = test::graph::NoOp(g, {last});
+      }
+      stats->nodes = size;
+      stats->edges = size - 1;
+      AddDone(g, nullptr, {last}, stats);
+      break;
+    }
+    case kRandomDag: {
+      random::PhiloxRandom philox(1729, 17);
+      random::SimplePhilox rand(&philox);
+      std::vector<Node*> nodes;
+      std::vector<bool> has_output(size, false);
+      for (int i = 0; i < size; ++i) {
+        std::vector<Node*> control_inputs;
+        const int num_inputs = i == 0 ? 0 : 1 + rand.Uniform(4);
+        for (int j = 0; j < num_inputs; ++j) {
+          const int input = rand.Uniform(i);
+          control_inputs.push_back(nodes[input]);
+          has_output[input] = true;
+        }
+        nodes.push_back(test::graph::NoOp(g, control_inputs));
+        stats->edges += num_inputs;
+      }
+      stats->nodes = size;
+      // "done" depends on the nodes that nothing else depends on, so that no
+      // node is pruned.
+      std::vector<Node*> leaves;
+      for (int i = 0; i < size; ++i) {
+        if (!has_output[i]) leaves.push_back(nodes[i]);
+      }
+      AddDone(g, nullptr, leaves, stats);
+      break;
+    }
+    case kWhileLoop: {
+      // i = 0; while (i < size) { i = i + 1; }
+      const string frame = "loop";
+      Node* zero = test::graph::Constant(g, test::AsScalar<int32>(0));
+      Node* limit = test::graph::Constant(g, test::AsScalar<int32>(size));
+      Node* one = test::graph::Constant(g, test::AsScalar<int32>(1));
+      Node* enter = test::graph::Enter(g, zero, frame);
+      Node* limit_in_loop = EnterConstant(g, limit, frame);
+      Node* one_in_loop = EnterConstant(g, one, frame);
+      Node* merge = test::graph::Merge(g, enter, {"next"});
+      Node* less = test::graph::Less(g, merge, limit_in_loop);
+      Node* cond = test::graph::LoopCond(g, less);
+      Node* switch_node = test::graph::Switch(g, merge, cond);
+      Node* body = test::graph::Identity(g, switch_node, 1);
+      Node* add = test::graph::Add(g, body, one_in_loop);
+      Node* next = test::graph::Next(g, "next", add);
+      g->AddEdge(next, 0, merge, 1);
+      Node* exit = test::graph::Exit(g, switch_node);
+      // The constants, Enters and Exit run once. Merge, Less, LoopCond and
+      // Switch run size + 1 times, and Identity, Add and NextIteration size
+      // times.
+      stats->nodes = 7 + 4 * (size + 1) + 3 * size;
+      stats->edges = 4 + 6 * (size + 1) + 4 * size;
+      AddDone(g, exit, {}, stats);
+      break;
+    }
+  }
+  return g;
+}
+
+// Reports the time per step, node and edge of "iters" steps of a graph with
+// "stats" that took "elapsed_micros".
+void ReportOverhead(int iters, uint64 elapsed_micros, const GraphStats& stats) {
+  const double nanos_per_step = 1000.0 * elapsed_micros / iters;
+  testing::ItemsProcessed(static_cast<int64>(iters) * stats.nodes);
+  testing::SetLabel(strings::StrCat(
+      "nodes=", stats.nodes, " edges=", stats.edges,
+      " ns/step=", static_cast<int64>(nanos_per_step),
+      " ns/node=", nanos_per_step / stats.nodes,
+      " ns/edge=", stats.edges > 0 ? nanos_per_step / stats.edges : 0));
+}
+
+// Options that keep the session from optimizing away the graphs' nodes or
+// inlining their functions.
+SessionOptions NoRewriteOptions() {
+  SessionOptions options;
+  GraphOptions* graph_options = options.config.mutable_graph_options();
+  OptimizerOptions* optimizer_options =
+      graph_options->mutable_optimizer_options();
+  optimizer_options->set_opt_level(OptimizerOptions::L0);
+  optimizer_options->set_do_function_inlining(false);
+  RewriterConfig* rewrite_options = graph_options->mutable_rewrite_options();
+  rewrite_options->set_disable_model_pruning(true);
+  rewrite_options->set_layout_optimizer(RewriterConfig::OFF);
+  rewrite_options->set_function_optimization(RewriterConfig::OFF);
+  rewrite_options->set_constant_folding(RewriterConfig::OFF);
+  rewrite_options->set_shape_optimization(RewriterConfig::OFF);
+  rewrite_options->set_remapping(RewriterConfig::OFF);
+  rewrite_options->set_arithmetic_optimization(RewriterConfig::OFF);
+  rewrite_options->set_loop_optimization(RewriterConfig::OFF);
+  rewrite_options->set_dependency_optimization(RewriterConfig::OFF);
+  rewrite_options->set_memory_optimization(RewriterConfig::NO_MEM_OPT);
+  return options;
+}
+
+// Runs the graph with an Executor, through kernel_benchmark_testlib.
+static void BM_Executor(int iters, int shape, int size) {
+  testing::UseRealTime();
+  GraphStats stats;
+  Graph* g = BuildGraph(static_cast<GraphShape>(shape), size, &stats);
+  test::Benchmark bm("cpu", g);
+  const uint64 start = Env::Default()->NowMicros();
+  bm.Run(iters);
+  ReportOverhead(iters, Env::Default()->NowMicros() - start, stats);
+}
+
+// Runs the graph with DirectSession::Run(), which also covers the lookup of
+// the cached executors and the feeding and fetching.
+static void BM_DirectSession(int iters, int shape, int size) {
+  testing::StopTiming();
+  testing::UseRealTime();
+  GraphStats stats;
+  std::unique_ptr<Graph> g(
+      BuildGraph(static_cast<GraphShape>(shape), size, &stats));
+  GraphDef def;
+  g->ToGraphDef(&def);
+  std::unique_ptr<Session> session(NewSession(NoRewriteOptions()));
+  TF_CHECK_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  // Creates and caches the executors.
+  TF_CHECK_OK(session->Run({}, {"done:0"}, {}, &outputs));
+
+  const uint64 start = Env::Default()->NowMicros();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {"done:0"}, {}, &outputs));
+  }
+  testing::StopTiming();
+  ReportOverhead(iters, Env::Default()->NowMicros() - start, stats);
+  TF_CHECK_OK(session->Close());
+}
+
+// Runs the graph with GraphRunner, which copies and rewrites the graph and
+// creates an executor for every step.
+static void BM_GraphRunner(int iters, int shape, int size) {
+  testing::StopTiming();
+  testing::UseRealTime();
+  GraphStats stats;
+  std::unique_ptr<Graph> g(
+      BuildGraph(static_cast<GraphShape>(shape), size, &stats));
+  GraphRunner runner(Env::Default());
+  std::vector<Tensor> outputs;
+
+  const uint64 start = Env::Default()->NowMicros();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(runner.Run(g.get(), nullptr, {}, {"done:0"}, &outputs));
+  }
+  testing::StopTiming();
+  ReportOverhead(iters, Env::Default()->NowMicros() - start, stats);
+}
+
+#define BM_GRAPH_SHAPES(bm)                                          \
+  BENCHMARK(bm)                                                      \
+      ->ArgPair(kWide, 1)                                            \
+      ->ArgPair(kWide, 256)                                          \
+      ->ArgPair(kWide, 4096)                                         \
+      ->ArgPair(kDeep, 256)                                          \
+      ->ArgPair(kDeep, 4096)                                         \
+      ->ArgPair(kRandomDag, 256)                                     \
+      ->ArgPair(kRandomDag, 4096)                                    \
+      ->ArgPair(kWhileLoop, 1)                                       \
+      ->ArgPair(kWhileLoop, 256)                                     \
+      ->ArgPair(kWhileLoop, 4096)
+
+BM_GRAPH_SHAPES(BM_Executor);
+BM_GRAPH_SHAPES(BM_DirectSession);
+BM_GRAPH_SHAPES(BM_GraphRunner);
+
+#undef BM_GRAPH_SHAPES
+
+// Runs a chain of "num_calls" calls of a function made of a single Identity
+// in a DirectSession, without inlining the function.
+static void BM_FunctionCalls(int iters, int num_calls) {
+  testing::StopTiming();
+  testing::UseRealTime();
+  std::vector<NodeDef> nodes;
+  nodes.push_back(test::function::NDef(
+      "x", "Const", {},
+      {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(1)}}));
+  string last = "x";
+  for (int i = 0; i < num_calls; ++i) {
+    const string name = strings::StrCat("call", i);
+    nodes.push_back(test::function::NDef(name, "IdentityFunction", {last}));
+    last = name;
+  }
+  nodes.push_back(test::function::NDef("done", "Identity", {last},
+                                       {{"T", DT_FLOAT}}));
+  const FunctionDef identity_function = FunctionDefHelper::Define(
+      // Name
+      "IdentityFunction",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"y"}, "Identity", {"x"}, {{"T", DT_FLOAT}}}});
+  std::unique_ptr<Session> session(NewSession(NoRewriteOptions()));
+  TF_CHECK_OK(
+      session->Create(test::function::GDef(nodes, {identity_function})));
+  std::vector<Tensor> outputs;
+  // Creates and caches the executors, and instantiates the function.
+  TF_CHECK_OK(session->Run({}, {"done:0"}, {}, &outputs));
+
+  const uint64 start = Env::Default()->NowMicros();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {"done:0"}, {}, &outputs));
+  }
+  testing::StopTiming();
+  const double nanos_per_step =
+      1000.0 * (Env::Default()->NowMicros() - start) / iters;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_calls);
+  testing::SetLabel(strings::StrCat(
+      "calls=", num_calls, " ns/step=", static_cast<int64>(nanos_per_step),
+      " ns/call=", nanos_per_step / num_calls));
+  TF_CHECK_OK(session->Close());
+}
+
+BENCHMARK(BM_FunctionCalls)->Arg(1)->Arg(16)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -69,7 +71,9 @@ class ExecutorTest : public ::testing::Test {
       DeleteNonCachedKernel(kernel);
     };
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, std::move(graph), &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type_, params, std::move(graph), &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
     rendez_ = NewLocalRendezvous();
   }
@@ -82,6 +86,7 @@ class ExecutorTest : public ::testing::Test {
     return exec_->Run(args);
   }
 
+  string executor_type_;
   thread::ThreadPool* thread_pool_ = nullptr;
   Device* device_ = nullptr;
   Executor* exec_ = nullptr;
@@ -410,14 +415,288 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
-// Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
-// maximum of 'width' nodes. All nodes are no-ops and all dependencies are
-// control dependencies.
-static void BM_executor(int iters, int width, int depth) {
-#ifdef PLATFORM_GOOGLE
-  BenchmarkUseRealTime();
-#endif  // PLATFORM_GOOGLE
-  Graph* g = new Graph(OpRegistry::Global());
+class WorkStealingExecutorTest : public ExecutorTest {
+ protected:
+  WorkStealingExecutorTest() { executor_type_ = "WORK_STEALING"; }
+};
+
+TEST_F(WorkStealingExecutorTest, SimpleAdd) {
+  // c = a + b
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));  // in0 = 1.0
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args, V(1.0),
+                             false));  // in1 = 1.0
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(2.0, V(out));  // out = 1.0 + 1.0 = 2.0
+}
+
+TEST_F(WorkStealingExecutorTest, RandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  // Run several steps so that workers of one step may still be exiting
+  // when the next step starts.
+  for (int iters = 0; iters < 8; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(WorkStealingExecutorTest, SimpleSwitchDead) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g.get(), VB(true));
+  auto tmp = test::graph::Switch(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));  // in0 = 1.0
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
+TEST_F(WorkStealingExecutorTest, RecvInvalidDtype) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto one = test::graph::Recv(g.get(), "one", "float", ALICE, 1, BOB);
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({1}));
+  auto init = test::graph::Assign(g.get(), var, one);
+  auto* two = test::graph::Send(g.get(), var, "two", BOB, 1, ALICE);
+  g->AddControlEdge(init, two);  // Ensures run after init.
+  Create(std::move(g));
+  Rendezvous* rendez = NewLocalRendezvous();
+  // Send a double instead of float.
+  TF_ASSERT_OK(rendez->Send(Key(ALICE, 1, BOB, "one"), Rendezvous::Args(),
+                            VD(1.0), false));
+  // Fails due to invalid dtype.
+  EXPECT_TRUE(errors::IsInternal(Run(rendez)));
+  rendez->Unref();
+}
+
+class MeasuredCostsExecutorTest : public ExecutorTest {
+ protected:
+  MeasuredCostsExecutorTest() {
+    setenv("TF_EXECUTOR_USE_MEASURED_COSTS", "1", 1 /*overwrite*/);
+  }
+  ~MeasuredCostsExecutorTest() override {
+    unsetenv("TF_EXECUTOR_USE_MEASURED_COSTS");
+  }
+};
+
+TEST_F(MeasuredCostsExecutorTest, RandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  // Run past the warm-up steps, so that later steps schedule nodes based on
+  // the costs measured in earlier ones.
+  for (int iters = 0; iters < 20; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+class MetricsExecutorTest : public ExecutorTest {
+ protected:
+  MetricsExecutorTest() { setenv("TF_EXECUTOR_METRICS", "2", 1 /*overwrite*/); }
+  ~MetricsExecutorTest() override { unsetenv("TF_EXECUTOR_METRICS"); }
+
+  // Returns the number of samples of the histogram metric "name" whose
+  // only label has the value "label".
+  static int64 NumSamples(const string& name, const string& label) {
+    auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+        monitoring::CollectionRegistry::CollectMetricsOptions());
+    auto it = metrics->point_set_map.find(name);
+    if (it == metrics->point_set_map.end()) return 0;
+    for (const auto& point : it->second->points) {
+      if (point->labels.size() == 1 && point->labels[0].value == label) {
+        return static_cast<int64>(point->histogram_value.num());
+      }
+    }
+    return 0;
+  }
+};
+
+TEST_F(MetricsExecutorTest, SimpleAdd) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  const string add_name = tmp->name();
+  const string device_name = device_->name();
+  const int64 adds = NumSamples("/tensorflow/core/executor/op_latency_usecs",
+                                "Add");
+  const int64 steps = NumSamples(
+      "/tensorflow/core/executor/step_latency_usecs", device_name);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(2.0, V(out));
+
+  EXPECT_EQ(adds + 1, NumSamples("/tensorflow/core/executor/op_latency_usecs",
+                                 "Add"));
+  EXPECT_EQ(1, NumSamples("/tensorflow/core/executor/node_latency_usecs",
+                          add_name));
+  EXPECT_EQ(steps + 1,
+            NumSamples("/tensorflow/core/executor/step_latency_usecs",
+                       device_name));
+  EXPECT_EQ(steps + 1,
+            NumSamples("/tensorflow/core/executor/step_output_bytes",
+                       device_name));
+  EXPECT_LT(0, NumSamples("/tensorflow/core/executor/queueing_delay_usecs",
+                          device_name));
+}
+
+class StaticScheduleExecutorTest : public ExecutorTest {
+ protected:
+  StaticScheduleExecutorTest() { executor_type_ = "STATIC_SCHEDULE"; }
+};
+
+TEST_F(StaticScheduleExecutorTest, SelfAdd) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto v = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g.get(), v, v);
+  }
+  test::graph::Send(g.get(), v, "b", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+}
+
+TEST_F(StaticScheduleExecutorTest, RandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  // The plan is computed once and reused by every step.
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, VariableRefs) {
+  // var = 1; out = var + var, ordered by a control edge.
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto one = test::graph::Constant(g.get(), V(1.0));
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({}));
+  auto init = test::graph::Assign(g.get(), var, one);
+  auto add = test::graph::Add(g.get(), var, var);
+  g->AddControlEdge(init, add);
+  test::graph::Send(g.get(), add, "out", ALICE, kIncarnation, BOB);
+  Create(std::move(g));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out;
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(ALICE, kIncarnation, BOB, "out"),
+                             Rendezvous::Args(), &out, &is_dead));
+  EXPECT_EQ(2.0, V(out));
+}
+
+TEST_F(StaticScheduleExecutorTest, RecvInvalidDtype) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto one = test::graph::Recv(g.get(), "one", "float", ALICE, 1, BOB);
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({1}));
+  auto init = test::graph::Assign(g.get(), var, one);
+  auto* two = test::graph::Send(g.get(), var, "two", BOB, 1, ALICE);
+  g->AddControlEdge(init, two);  // Ensures run after init.
+  Create(std::move(g));
+  Rendezvous* rendez = NewLocalRendezvous();
+  // Send a double instead of float.
+  TF_ASSERT_OK(rendez->Send(Key(ALICE, 1, BOB, "one"), Rendezvous::Args(),
+                            VD(1.0), false));
+  // Fails due to invalid dtype, and the later levels are skipped.
+  EXPECT_TRUE(errors::IsInternal(Run(rendez)));
+  Tensor output;
+  bool is_dead;
+  EXPECT_TRUE(errors::IsInternal(rendez->Recv(
+      Key(BOB, 1, ALICE, "two"), Rendezvous::Args(), &output, &is_dead)));
+  rendez->Unref();
+}
+
+TEST_F(StaticScheduleExecutorTest, RejectsControlFlow) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g.get(), VB(false));
+  auto tmp = test::graph::Switch(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device_;
+  params.create_kernel = [this, version](const NodeDef& ndef,
+                                         OpKernel** kernel) {
+    return CreateNonCachedKernel(device_, nullptr, ndef, version, kernel);
+  };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  std::unique_ptr<Executor> exec;
+  Status s = NewExecutor(executor_type_, params, std::move(g), &exec);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+  // The fixture expects a rendezvous when it is torn down.
+  rendez_ = NewLocalRendezvous();
+}
+
+static void BuildRandomNoOpGraph(int width, int depth, Graph* g,
+                                 uint64* num_nodes) {
   random::PhiloxRandom philox(1729, 17);
   random::SimplePhilox rand(&philox);
   uint64 cur = 0;
@@ -443,23 +722,62 @@ static void BM_executor(int iters, int width, int depth) {
       ++cur;
     }
   }
+  *num_nodes = cur;
+}
+
+static void RunExecutorBenchmark(int iters, int width, int depth,
+                                 const char* executor_type) {
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  uint64 cur = 0;
+  BuildRandomNoOpGraph(width, depth, g, &cur);
 #ifdef PLATFORM_GOOGLE
   SetBenchmarkLabel(strings::StrCat("Nodes = ", cur));
   SetBenchmarkItemsProcessed(cur * static_cast<int64>(iters));
 #endif  // PLATFORM_GOOGLE
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+// Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
+// maximum of 'width' nodes. All nodes are no-ops and all dependencies are
+// control dependencies.
+static void BM_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "");
+}
+
+// Same graphs as BM_executor, run by the work-stealing executor.
+static void BM_work_stealing_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "WORK_STEALING");
+}
+
+// Same graphs as BM_executor, run by the static schedule executor.
+static void BM_static_schedule_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "STATIC_SCHEDULE");
 }
 
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(32, 8192);
 
 // Short fat graphs
 BENCHMARK(BM_executor)->ArgPair(1024, 16);
 BENCHMARK(BM_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(8192, 32);
 
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_work_stealing_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_static_schedule_executor)->ArgPair(1024, 1024);
 
 static void BM_FeedInputFetchOutput(int iters) {
   Graph* g = new Graph(OpRegistry::Global());
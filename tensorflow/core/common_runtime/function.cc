@@ -139,6 +139,179 @@ static Node* AddRet(Graph* g, Endpoint input, int index) {
   return ret;
 }
 
+namespace {
+
+// The largest number of nodes of a function body run inline.
+constexpr int kMaxInlineRunNodes = 32;
+
+// Runs a small function body in a single closure, one kernel after the other
+// in topological order, without an executor or a rendezvous, whose overhead is
+// comparable with the work of such a body. The kernels are created once, and
+// shared with the executor of the function.
+class InlineRunner {
+ public:
+  ~InlineRunner() {
+    for (const auto& node : nodes_) {
+      DeleteNonCachedKernel(node.kernel);
+    }
+  }
+
+  // Returns nullptr unless `graph` is small, on a CPU device, run by the
+  // default executor, and all its kernels are synchronous, free of side
+  // effects and control flow, and take no references.
+  static std::unique_ptr<InlineRunner> Create(
+      const Graph& graph, const Device* device, const string& executor_type,
+      const std::function<Status(const NodeDef&, OpKernel**)>& create_kernel) {
+    if (device->device_type() != DEVICE_CPU ||
+        (!executor_type.empty() && executor_type != "DEFAULT") ||
+        graph.num_op_nodes() > kMaxInlineRunNodes) {
+      return nullptr;
+    }
+    for (const Node* n : graph.op_nodes()) {
+      const bool is_arg_or_ret =
+          n->type_string() == kArgOp || n->type_string() == kRetOp;
+      if ((n->op_def().is_stateful() && !is_arg_or_ret) ||
+          n->IsControlFlow() || n->IsSend() || n->IsRecv()) {
+        return nullptr;
+      }
+      for (const DataType dtype : n->input_types()) {
+        if (IsRefType(dtype)) return nullptr;
+      }
+      for (const DataType dtype : n->output_types()) {
+        if (IsRefType(dtype)) return nullptr;
+      }
+    }
+
+    std::unique_ptr<InlineRunner> runner(new InlineRunner);
+    std::vector<Node*> order;
+    GetReversePostOrder(graph, &order);
+    // The index in `nodes_` of each graph node, and the index of its first
+    // output in the values of a call.
+    std::vector<int> node_index(graph.num_node_ids(), -1);
+    std::vector<int> value_offsets;
+    std::vector<const Edge*> input_edges;
+    for (Node* n : order) {
+      if (!n->IsOp()) continue;
+      InlineNode node;
+      if (!create_kernel(n->def(), &node.kernel).ok()) return nullptr;
+      runner->nodes_.push_back(node);
+      if (runner->nodes_.back().kernel->AsAsync() != nullptr ||
+          !n->input_edges(&input_edges).ok()) {
+        return nullptr;
+      }
+      for (const Edge* e : input_edges) {
+        runner->nodes_.back().inputs.push_back(
+            {value_offsets[node_index[e->src()->id()]] + e->src_output(),
+             false});
+      }
+      runner->nodes_.back().output_attrs.resize(n->num_outputs());
+      node_index[n->id()] = runner->nodes_.size() - 1;
+      value_offsets.push_back(runner->num_values_);
+      runner->num_values_ += n->num_outputs();
+      runner->kernels_[n->name()] = runner->nodes_.back().kernel;
+    }
+    // Marks the last use of each value, which moves it to its consumer.
+    std::vector<bool> used(runner->num_values_, false);
+    for (auto node = runner->nodes_.rbegin(); node != runner->nodes_.rend();
+         ++node) {
+      for (auto& input : node->inputs) {
+        input.last_use = !used[input.value];
+        used[input.value] = true;
+      }
+    }
+    runner->value_offsets_ = std::move(value_offsets);
+    return runner;
+  }
+
+  // Returns the kernel of the node named `name`, or nullptr.
+  OpKernel* FindKernel(const string& name) const {
+    return gtl::FindPtrOrNull(kernels_, name);
+  }
+
+  bool OwnsKernel(const OpKernel* kernel) const {
+    return FindKernel(kernel->name()) == kernel;
+  }
+
+  Status Run(const FunctionLibraryRuntime::Options& opts,
+             FunctionLibraryRuntime* flr, Device* device,
+             Executor::Args::Runner* runner, CallFrameInterface* frame) const {
+    std::vector<Tensor> values(num_values_);
+    gtl::InlinedVector<Tensor, 4> input_tensors;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs;
+    gtl::InlinedVector<DeviceContext*, 4> input_device_contexts;
+    OpKernelContext::Params params;
+    params.step_id = opts.step_id;
+    params.device = device;
+    params.rendezvous = opts.rendezvous;
+    params.collective_executor = opts.collective_executor;
+    params.cancellation_manager = opts.cancellation_manager;
+    params.call_frame = frame;
+    params.function_library = flr;
+    params.resource_manager = device->resource_manager();
+    params.step_container = opts.step_container;
+    params.inputs = &inputs;
+    params.input_alloc_attrs = &input_alloc_attrs;
+    params.input_device_contexts = &input_device_contexts;
+    params.runner = runner;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      const InlineNode& node = nodes_[i];
+      const int num_inputs = node.inputs.size();
+      input_tensors.resize(num_inputs);
+      inputs.resize(num_inputs);
+      input_alloc_attrs.resize(num_inputs);
+      input_device_contexts.resize(num_inputs, nullptr);
+      for (int j = 0; j < num_inputs; ++j) {
+        Tensor* value = &values[node.inputs[j].value];
+        if (node.inputs[j].last_use) {
+          input_tensors[j] = std::move(*value);
+        } else {
+          input_tensors[j] = *value;
+        }
+        inputs[j] = TensorValue(&input_tensors[j]);
+      }
+      params.op_kernel = node.kernel;
+      params.output_attr_array = node.output_attrs.data();
+      OpKernelContext ctx(&params, node.output_attrs.size());
+      device->Compute(node.kernel, &ctx);
+      TF_RETURN_IF_ERROR(ctx.status());
+      for (int j = 0; j < ctx.num_outputs(); ++j) {
+        Tensor* output = ctx.mutable_output(j);
+        if (output == nullptr) {
+          return errors::Internal("Missing ", j, "-th output from ",
+                                  node.kernel->name());
+        }
+        values[value_offsets_[i] + j] = std::move(*output);
+      }
+      input_tensors.clear();
+    }
+    return Status::OK();
+  }
+
+ private:
+  InlineRunner() {}
+
+  struct InlineNode {
+    OpKernel* kernel = nullptr;
+    struct Input {
+      int value;
+      bool last_use;
+    };
+    gtl::InlinedVector<Input, 4> inputs;
+    std::vector<AllocatorAttributes> output_attrs;
+  };
+
+  std::vector<InlineNode> nodes_;
+  // The index of the first output of each node in the values of a call.
+  std::vector<int> value_offsets_;
+  int num_values_ = 0;
+  std::unordered_map<string, OpKernel*> kernels_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineRunner);
+};
+
+}  // namespace
+
 class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
  public:
   FunctionLibraryRuntimeImpl(const DeviceMgr* dmgr, Env* env, Device* device,
@@ -217,6 +390,9 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
     FunctionBody* func_graph = nullptr;
     Executor* exec = nullptr;
     string executor_type;
+    // Set if the function body is small enough to run inline. It owns some of
+    // the kernels of `exec`.
+    std::unique_ptr<InlineRunner> inline_runner;
 
     ~Item() {
       delete this->func_graph;
@@ -235,6 +411,12 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
                            FunctionBody** fbody);
   Status CreateItem(Handle handle, Item** item);
   Status GetOrCreateItem(Handle handle, Item** item);
+  // Returns the item of `handle` if its body runs inline with `opts`, or
+  // nullptr.
+  Item* GetInlineItem(const Options& opts, Handle handle);
+  // Runs the body of `item` inline, and calls `done`.
+  void RunInline(const Options& opts, Item* item, CallFrameInterface* frame,
+                 DoneCallback done);
   Status InstantiateSymbolicGradient(const NameAttrList& func,
                                      const FunctionLibraryDefinition* lib_def,
                                      FunctionBody** g_body);
@@ -659,6 +841,21 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
   params.delete_kernel = [](OpKernel* kernel) {
     DeleteNonCachedKernel(kernel);
   };
+  std::unique_ptr<InlineRunner> inline_runner =
+      InlineRunner::Create(*g, device_, executor_type, params.create_kernel);
+  if (inline_runner != nullptr) {
+    // The executor uses the kernels of the inline runner.
+    const InlineRunner* runner = inline_runner.get();
+    auto create_kernel = params.create_kernel;
+    params.create_kernel = [runner, create_kernel](const NodeDef& ndef,
+                                                   OpKernel** kernel) {
+      *kernel = runner->FindKernel(ndef.name());
+      return *kernel != nullptr ? Status::OK() : create_kernel(ndef, kernel);
+    };
+    params.delete_kernel = [runner](OpKernel* kernel) {
+      if (!runner->OwnsKernel(kernel)) DeleteNonCachedKernel(kernel);
+    };
+  }
   Graph* graph = g.get();
   std::unique_ptr<Executor> exec;
   TF_RETURN_IF_ERROR(NewExecutor(executor_type, params, std::move(g), &exec));
@@ -667,6 +864,7 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
     mutex_lock l(mu_);
     if ((*item)->exec == nullptr) {
       (*item)->graph = graph;
+      (*item)->inline_runner = std::move(inline_runner);
       (*item)->exec = exec.release();
     }
   }
@@ -804,6 +1002,29 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
     done(errors::Cancelled(""));
     return;
   }
+  Item* inline_item = GetInlineItem(opts, handle);
+  if (inline_item != nullptr) {
+    const FunctionBody* fbody = GetFunctionBody(handle);
+    FunctionCallFrame* frame =
+        new FunctionCallFrame(fbody->arg_types, fbody->ret_types);
+    Status s = frame->SetArgs(args);
+    if (!s.ok()) {
+      delete frame;
+      done(s);
+      return;
+    }
+    bool allow_dead_tensors = opts.allow_dead_tensors;
+    RunInline(opts, inline_item, frame,
+              [frame, rets, done, allow_dead_tensors](const Status& status) {
+                Status s = status;
+                if (s.ok()) {
+                  s = frame->ConsumeRetvals(rets, allow_dead_tensors);
+                }
+                delete frame;
+                done(s);
+              });
+    return;
+  }
   Options run_opts = opts;
   if (opts.create_rendezvous) {
     Rendezvous* rendezvous = new IntraProcessRendezvous(device_mgr_);
@@ -889,6 +1110,11 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
     done(errors::Unimplemented("Remote calling with CallFrameInterface"));
     return;
   }
+  Item* inline_item = GetInlineItem(opts, handle);
+  if (inline_item != nullptr) {
+    RunInline(opts, inline_item, frame, std::move(done));
+    return;
+  }
 
   Options run_opts = opts;
   if (opts.create_rendezvous) {
@@ -941,6 +1167,39 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
           std::move(done), std::placeholders::_1));
 }
 
+FunctionLibraryRuntimeImpl::Item* FunctionLibraryRuntimeImpl::GetInlineItem(
+    const Options& opts, Handle handle) {
+  // Stats are collected per node by the executor.
+  if (opts.remote_execution || opts.stats_collector != nullptr ||
+      !parent_->IsInstantiatedOnDevice(device_name_, handle)) {
+    return nullptr;
+  }
+  Item* item = nullptr;
+  if (!GetOrCreateItem(handle, &item).ok() || item->inline_runner == nullptr) {
+    return nullptr;
+  }
+  return item;
+}
+
+void FunctionLibraryRuntimeImpl::RunInline(const Options& opts, Item* item,
+                                           CallFrameInterface* frame,
+                                           DoneCallback done) {
+  // The body has no Send or Recv, so it needs no rendezvous of its own. Like
+  // an executor, it is run by the runner, but in a single closure.
+  Executor::Args::Runner* runner =
+      opts.runner == nullptr ? &default_runner_ : opts.runner;
+  auto run = std::bind(
+      [this, item, opts, runner, frame](DoneCallback done) {
+        done(item->inline_runner->Run(opts, this, device_, runner, frame));
+      },
+      std::move(done));
+  if (*runner) {
+    (*runner)(std::move(run));
+  } else {
+    run();
+  }
+}
+
 bool FunctionLibraryRuntimeImpl::IsStateful(const string& func) {
   const OpDef* op_def;
   const Status s = base_lib_def_->LookUpOpDef(func, &op_def);
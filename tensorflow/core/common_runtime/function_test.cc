@@ -396,6 +396,45 @@ TEST_F(FunctionLibraryRuntimeTest, XTimesN) {
   test::ExpectTensorEqual<float>(y, test::AsTensor<float>({16, 32, 48, 64}));
 }
 
+TEST_F(FunctionLibraryRuntimeTest, SmallFunctionCalledRepeatedly) {
+  // Small, stateless function bodies are run without an executor. Here, `x`
+  // and `y` are each used three times.
+  auto func = FDH::Create(
+      // Name
+      "XSquaredPlusX",
+      // Input
+      {"x: float"},
+      // Output
+      {"o: float"},
+      // Attr
+      {},
+      // Nodes
+      {{{"y"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}},
+       {{"z"}, "Add", {"y:z:0", "x"}, {{"T", DT_FLOAT}}},
+       {{"w"}, "Sub", {"z:z:0", "y:z:0"}, {{"T", DT_FLOAT}}},
+       {{"o"}, "Add", {"w:z:0", "y:z:0"}, {{"T", DT_FLOAT}}}},
+      // Return
+      {{"o", "o:z:0"}});
+  Init({func});
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(Instantiate(flr0_, "XSquaredPlusX", {}, &handle));
+  for (int i = 0; i < 10; ++i) {
+    auto x = test::AsTensor<float>({1.0f * i, 2.0f});
+    Tensor y;
+    TF_CHECK_OK(Run(flr0_, handle, FunctionLibraryRuntime::Options(), {x},
+                    {&y}));
+    test::ExpectTensorEqual<float>(
+        y, test::AsTensor<float>({1.0f * i * i + i, 6.0f}));
+    FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+    TF_CHECK_OK(frame.SetArgs({x}));
+    TF_CHECK_OK(Run(flr0_, handle, FunctionLibraryRuntime::Options(), &frame));
+    std::vector<Tensor> rets;
+    TF_CHECK_OK(frame.GetRetvals(&rets));
+    test::ExpectTensorEqual<float>(rets[0], y);
+  }
+  TF_CHECK_OK(flr0_->ReleaseHandle(handle));
+}
+
 TEST_F(FunctionLibraryRuntimeTest, XTimesNInOverlayLib) {
   Init({});
   FunctionDefLibrary proto;
@@ -22,6 +22,18 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+BFCAllocator::Options BFCOptions(const GPUOptions& gpu_options) {
+  BFCAllocator::Options options;
+  options.use_thread_caches =
+      gpu_options.experimental().use_allocator_thread_caches();
+  options.use_slabs = gpu_options.experimental().use_allocator_slabs();
+  return options;
+}
+
+}  // namespace
+
 GPUBFCAllocator::GPUBFCAllocator(CudaGpuId cuda_gpu_id, size_t total_memory,
                                  const string& name)
     : GPUBFCAllocator(cuda_gpu_id, total_memory, GPUOptions(), name) {}
@@ -34,6 +46,7 @@ GPUBFCAllocator::GPUBFCAllocator(CudaGpuId cuda_gpu_id, size_t total_memory,
               GpuIdUtil::ExecutorForCudaGpuId(cuda_gpu_id).ValueOrDie(),
               gpu_options.per_process_gpu_memory_fraction() > 1.0 ||
                   gpu_options.experimental().use_unified_memory()),
-          total_memory, gpu_options.allow_growth(), name) {}
+          total_memory, gpu_options.allow_growth(), name,
+          BFCOptions(gpu_options)) {}
 
 }  // namespace tensorflow
@@ -263,6 +263,164 @@ TEST(GPUBFCAllocatorTest, AllocationsAndDeallocationsWithGrowth) {
   LOG(INFO) << "Alloc stats: \n" << stats.DebugString();
 }
 
+static GPUOptions ThreadCacheOptions() {
+  GPUOptions options;
+  options.mutable_experimental()->set_use_allocator_thread_caches(true);
+  return options;
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCachesReuseChunks) {
+  GPUBFCAllocator a(CudaGpuId(0), 1 << 30, ThreadCacheOptions(), "GPU_0_bfc");
+  EXPECT_FALSE(a.TracksAllocationSizes());
+
+  // Small requests are rounded up to a power-of-two size class.
+  void* p1 = a.AllocateRaw(1, 1000);
+  ASSERT_NE(nullptr, p1);
+  CheckStats(&a, 1, 1024, 1024, 1024);
+
+  // A freed chunk is cached rather than coalesced, and serves the next
+  // request of its size class.
+  a.DeallocateRaw(p1);
+  CheckStats(&a, 1, 0, 1024, 1024);
+  void* p2 = a.AllocateRaw(1, 600);
+  EXPECT_EQ(p1, p2);
+  CheckStats(&a, 2, 1024, 1024, 1024);
+
+  // Large requests bypass the caches.
+  void* p3 = a.AllocateRaw(1, 1 << 20);
+  ASSERT_NE(nullptr, p3);
+  CheckStats(&a, 3, 1024 + (1 << 20), 1024 + (1 << 20), 1 << 20);
+  a.DeallocateRaw(p3);
+  a.DeallocateRaw(p2);
+  CheckStats(&a, 3, 0, 1024 + (1 << 20), 1 << 20);
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCachesAreFlushedWhenOutOfMemory) {
+  GPUBFCAllocator a(CudaGpuId(0), 1 << 20, ThreadCacheOptions(), "GPU_0_bfc");
+  // Fill the whole region with cacheable chunks and free them all.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; i++) {
+    void* raw = a.AllocateRaw(1, 64 << 10);
+    ASSERT_NE(nullptr, raw);
+    ptrs.push_back(raw);
+  }
+  for (void* raw : ptrs) {
+    a.DeallocateRaw(raw);
+  }
+  // Only coalescing the cached chunks can satisfy this request.
+  void* big = a.AllocateRaw(1, 512 << 10);
+  ASSERT_NE(nullptr, big);
+  a.DeallocateRaw(big);
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCachesConcurrentAllocations) {
+  GPUBFCAllocator a(CudaGpuId(0), 1 << 30, ThreadCacheOptions(), "GPU_0_bfc");
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; t++) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 1000; i++) {
+          ptrs.push_back(a.AllocateRaw(1, 1 + rand.Rand32() % (128 << 10)));
+          CHECK(ptrs.back() != nullptr);
+          if (i % 3 == 0) {
+            const size_t j = rand.Rand32() % ptrs.size();
+            a.DeallocateRaw(ptrs[j]);
+            ptrs[j] = ptrs.back();
+            ptrs.pop_back();
+          }
+        }
+        for (void* raw : ptrs) {
+          a.DeallocateRaw(raw);
+        }
+      });
+    }
+  }
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(8000, stats.num_allocs);
+}
+
+TEST(GPUBFCAllocatorTest, FragmentationStats) {
+  GPUBFCAllocator a(CudaGpuId(0), 1 << 30, "GPU_0_bfc");
+  void* p1 = a.AllocateRaw(1, 1 << 20);
+  void* p2 = a.AllocateRaw(1, 1 << 20);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1 << 30, stats.bytes_reserved);
+  EXPECT_EQ((1 << 30) - (2 << 20), stats.largest_free_block_bytes);
+
+  // Freeing the first chunk leaves a hole that cannot be coalesced.
+  a.DeallocateRaw(p1);
+  a.GetStats(&stats);
+  EXPECT_EQ((1 << 30) - (2 << 20), stats.largest_free_block_bytes);
+  a.DeallocateRaw(p2);
+  a.GetStats(&stats);
+  EXPECT_EQ(1 << 30, stats.largest_free_block_bytes);
+}
+
+static GPUOptions SlabOptions() {
+  GPUOptions options;
+  options.mutable_experimental()->set_use_allocator_slabs(true);
+  return options;
+}
+
+TEST(GPUBFCAllocatorTest, SlabsServeSmallAllocations) {
+  GPUBFCAllocator a(CudaGpuId(0), 1 << 30, SlabOptions(), "GPU_0_bfc");
+  EXPECT_FALSE(a.TracksAllocationSizes());
+
+  // Requests are rounded up to a size class and packed into one slab.
+  void* p1 = a.AllocateRaw(1, 1000);
+  void* p2 = a.AllocateRaw(1, 700);
+  ASSERT_NE(nullptr, p1);
+  ASSERT_NE(nullptr, p2);
+  EXPECT_EQ(1024, a.AllocatedSize(p1));
+  EXPECT_EQ(768, a.AllocatedSize(p2));
+  void* p3 = a.AllocateRaw(1, 1024);
+  EXPECT_EQ(static_cast<char*>(p1) + 1024, p3);
+  CheckStats(&a, 3, 2048 + 768, 2048 + 768, 1024);
+
+  // Large requests use best-fit.
+  void* big = a.AllocateRaw(1, 1 << 20);
+  EXPECT_EQ(1 << 20, a.AllocatedSize(big));
+  CheckStats(&a, 4, (1 << 20) + 2048 + 768, (1 << 20) + 2048 + 768, 1 << 20);
+
+  a.DeallocateRaw(p1);
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  a.DeallocateRaw(big);
+  CheckStats(&a, 4, 0, (1 << 20) + 2048 + 768, 1 << 20);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1 << 30, stats.bytes_reserved);
+}
+
+TEST(GPUBFCAllocatorTest, EmptySlabsAreReleasedWhenOutOfMemory) {
+  GPUBFCAllocator a(CudaGpuId(0), 64 << 20, SlabOptions(), "GPU_0_bfc");
+  random::PhiloxRandom philox(123, 17);
+  random::SimplePhilox rand(&philox);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 200; i++) {
+    void* raw = a.AllocateRaw(1, 1 + rand.Rand32() % (64 << 10));
+    ASSERT_NE(nullptr, raw);
+    ptrs.push_back(raw);
+  }
+  for (void* raw : ptrs) {
+    a.DeallocateRaw(raw);
+  }
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_LT(stats.largest_free_block_bytes, 64 << 20);
+  // Only releasing the slabs kept for reuse can satisfy this request.
+  void* all = a.AllocateRaw(1, 64 << 20);
+  ASSERT_NE(nullptr, all);
+  a.DeallocateRaw(all);
+}
+
 TEST(GPUBFCAllocatorTest, DISABLED_AllocatorReceivesZeroMemory) {
   GPUBFCAllocator a(CudaGpuId(0), 1UL << 60, "GPU_0_bfc");
   GPUBFCAllocator b(CudaGpuId(0), 1UL << 60, "GPU_0_bfc");
@@ -288,8 +446,9 @@ static void BM_Allocation(int iters) {
 }
 BENCHMARK(BM_Allocation);
 
-static void BM_AllocationThreaded(int iters, int num_threads) {
-  GPUBFCAllocator a(CudaGpuId(0), 1uLL << 33, "GPU_0_bfc");
+static void AllocationThreaded(int iters, int num_threads,
+                               const GPUOptions& options) {
+  GPUBFCAllocator a(CudaGpuId(0), 1uLL << 33, options, "GPU_0_bfc");
   thread::ThreadPool pool(Env::Default(), "test", num_threads);
   std::atomic_int_fast32_t count(iters);
   mutex done_lock;
@@ -320,8 +479,17 @@ static void BM_AllocationThreaded(int iters, int num_threads) {
     done.wait(l);
   }
 }
+
+static void BM_AllocationThreaded(int iters, int num_threads) {
+  AllocationThreaded(iters, num_threads, GPUOptions());
+}
 BENCHMARK(BM_AllocationThreaded)->Arg(1)->Arg(4)->Arg(16);
 
+static void BM_AllocationThreadedWithCaches(int iters, int num_threads) {
+  AllocationThreaded(iters, num_threads, ThreadCacheOptions());
+}
+BENCHMARK(BM_AllocationThreadedWithCaches)->Arg(1)->Arg(4)->Arg(16);
+
 // A more complex benchmark that defers deallocation of an object for
 // "delay" allocations.
 static void BM_AllocationDelayed(int iters, int delay) {
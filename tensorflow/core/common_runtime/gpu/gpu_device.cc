@@ -208,18 +208,27 @@ class BaseGPUDevice::StreamGroupFactory {
     StreamGroup* group =
         &streams_[key_type(tf_gpu_id.value(), stream_group_within_gpu)];
     if (!group->compute) {
+      const bool prioritize =
+          options.experimental().prioritize_compute_streams();
+      const se::StreamPriority compute_priority =
+          prioritize ? se::StreamPriority::kHighest
+                     : se::StreamPriority::kDefault;
+      const se::StreamPriority copy_priority =
+          prioritize ? se::StreamPriority::kLowest
+                     : se::StreamPriority::kDefault;
+
       group->compute = new se::Stream(executor);
-      group->compute->Init();
+      group->compute->InitWithPriority(compute_priority);
       VLOG(2) << "Created stream[" << stream_group_within_gpu
               << "] = " << group->compute;
 
       group->host_to_device = new se::Stream(executor);
-      group->host_to_device->Init();
+      group->host_to_device->InitWithPriority(copy_priority);
       VLOG(2) << "Created host_to_device_stream[" << stream_group_within_gpu
               << "] = " << group->host_to_device;
 
       group->device_to_host = new se::Stream(executor);
-      group->device_to_host->Init();
+      group->device_to_host->InitWithPriority(copy_priority);
       VLOG(2) << "Created device_to_host_stream[" << stream_group_within_gpu
               << "] = " << group->device_to_host;
 
@@ -234,7 +243,7 @@ class BaseGPUDevice::StreamGroupFactory {
       }
       for (int i = 0; i < num_d2d_streams; ++i) {
         se::Stream* stream = new se::Stream(executor);
-        stream->Init();
+        stream->InitWithPriority(copy_priority);
         group->device_to_device.push_back(stream);
         VLOG(2) << "Created device_to_device_stream[" << stream_group_within_gpu
                 << "] = " << group->device_to_device.back();
@@ -261,6 +270,18 @@ class BaseGPUDevice::StreamGroupFactory {
   TF_DISALLOW_COPY_AND_ASSIGN(StreamGroupFactory);
 };
 
+namespace {
+
+// Returns true if GPU memory is unified memory whose pages should be
+// prefetched to the GPU before the ops that read them.
+bool PrefetchUnifiedMemory(const GPUOptions& gpu_options) {
+  return gpu_options.experimental().prefetch_unified_memory() &&
+         (gpu_options.per_process_gpu_memory_fraction() > 1.0 ||
+          gpu_options.experimental().use_unified_memory());
+}
+
+}  // namespace
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              TfGpuId tf_gpu_id,
@@ -275,7 +296,9 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
       scoped_allocator_mgr_(new ScopedAllocatorMgr(name)),
       tf_gpu_id_(tf_gpu_id),
       sync_every_op_(sync_every_op),
-      max_streams_(max_streams) {
+      max_streams_(max_streams),
+      prefetch_unified_memory_(
+          PrefetchUnifiedMemory(options.config.gpu_options())) {
   GPUProcessState::singleton()->EnableGPUDevice();
 }
 
@@ -502,6 +525,7 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
       if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
     }
   }
+  if (prefetch_unified_memory_) PrefetchInputs(context, stream);
   se::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
   op_kernel->Compute(context);
   if (context->status().ok()) {
@@ -556,6 +580,21 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << op_kernel->type_string() << " on GPU" << tf_gpu_id_ << " stream["
           << stream_id << "]";
 
+  if (streams_.size() > 1) {
+    // As in ComputeHelper(), the op's stream must wait for the streams that
+    // produced its inputs.
+    for (int i = 0; i < context->num_inputs(); ++i) {
+      const GPUDeviceContext* idc =
+          static_cast<GPUDeviceContext*>(context->input_device_context(i));
+      OP_REQUIRES_ASYNC(context, idc != nullptr,
+                        errors::Internal("Input device context ", i,
+                                         " was not set properly."),
+                        done);
+      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
+    }
+  }
+  if (prefetch_unified_memory_) PrefetchInputs(context, stream);
+
   // When Xprof profiling is off (which is the default), constructing the
   // activity is simple enough that its overhead is negligible.
   tracing::ScopedActivity activity(op_kernel->name(), op_kernel->type_string(),
@@ -564,6 +603,25 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   op_kernel->ComputeAsync(context, done);
 }
 
+void BaseGPUDevice::PrefetchInputs(OpKernelContext* context,
+                                   se::Stream* stream) {
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (!context->has_input(i) ||
+        context->input_memory_type(i) != DEVICE_MEMORY) {
+      continue;
+    }
+    Tensor tensor = IsRefType(context->input_dtype(i))
+                        ? context->mutable_input(i, false)
+                        : context->input(i);
+    const int64 total_bytes = tensor.TotalBytes();
+    if (total_bytes == 0) continue;
+    // A failed prefetch only costs performance, since the kernel faults the
+    // memory in anyway.
+    executor_->UnifiedMemoryPrefetch(stream, DMAHelper::base(&tensor),
+                                     total_bytes, false /* to_host */);
+  }
+}
+
 Status BaseGPUDevice::MaybeCopyTensorToGPU(
     const AllocatorAttributes& alloc_attrs, const Tensor& from, Tensor* to,
     StatusCallback done) {
@@ -132,6 +132,9 @@ class BaseGPUDevice : public LocalDevice {
   TfGpuId tf_gpu_id_;
   const bool sync_every_op_ = false;
   const int32 max_streams_;
+  // True if the inputs of each op are prefetched to the GPU, see
+  // GPUOptions.Experimental.prefetch_unified_memory.
+  const bool prefetch_unified_memory_;
   std::unique_ptr<EventMgr> em_;
   std::unique_ptr<thread::ThreadPool> thread_pool_;
 
@@ -140,6 +143,10 @@ class BaseGPUDevice : public LocalDevice {
 
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
 
+  // Enqueues on "stream" the migration of the op's inputs in unified memory
+  // to this GPU.
+  void PrefetchInputs(OpKernelContext* context, se::Stream* stream);
+
   string ComputeOpKernelDebugString(const OpKernel& op_kernel,
                                     const int& stream_id);
 
@@ -279,6 +279,42 @@ TEST_F(GPUDeviceTest, UnifiedMemoryAllocation) {
   gtl::STLDeleteElements(&devices);
 }
 
+// Unified memory can be prefetched to the GPU and back to the host.
+TEST_F(GPUDeviceTest, UnifiedMemoryPrefetch) {
+  static constexpr CudaGpuId kCudaGpuId(0);
+
+  int cc_major, cc_minor;
+  TF_ASSERT_OK(GetComputeCapability(kCudaGpuId, &cc_major, &cc_minor));
+  // Exit early if running on pre-Pascal GPUs.
+  if (cc_major < 6) {
+    LOG(INFO) << "Unified memory prefetching is not supported with pre-Pascal "
+                 "GPUs.";
+    return;
+  }
+
+  SessionOptions opts = MakeSessionOptions("0", /*memory_fraction=*/1.2);
+  opts.config.mutable_gpu_options()
+      ->mutable_experimental()
+      ->set_prefetch_unified_memory(true);
+  std::vector<tensorflow::Device*> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  ASSERT_EQ(1, devices.size());
+
+  Allocator* allocator = devices[0]->GetAllocator(AllocatorAttributes());
+  constexpr int64 kBytes = 1 << 20;
+  void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, kBytes);
+  ASSERT_NE(ptr, nullptr);
+  se::Stream* stream = devices[0]->tensorflow_gpu_device_info()->stream;
+  se::StreamExecutor* se = stream->parent();
+  EXPECT_TRUE(se->UnifiedMemoryPrefetch(stream, ptr, kBytes, true));
+  EXPECT_TRUE(se->UnifiedMemoryPrefetch(stream, ptr, kBytes, false));
+  TF_EXPECT_OK(stream->BlockHostUntilDone());
+  allocator->DeallocateRaw(ptr);
+
+  gtl::STLDeleteElements(&devices);
+}
+
 }  // namespace tensorflow
 
 #endif
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -97,9 +99,13 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      polling_busy_window_usecs_(
+          gpu_options.experimental().polling_busy_window_usecs()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
+      last_queued_micros_(0),
+      completion_usecs_(std::max(polling_busy_window_usecs_, 0)),
       threadpool_(Env::Default(), "GPU_Event_Manager", kNumThreads) {
   gpu_event_mgr::InitThreadpoolLabels(&threadpool_);
   StartPollingLoop();
@@ -192,11 +198,13 @@ void EventMgr::FlushAccumulatedTensors() {
 // A polling loop to detect completion of GPU events.
 //
 // While one or more events is outstanding, poll for completed events.  When no
-// events are outstanding, we sleep until one is enqueued.
+// events are outstanding, we sleep until one is enqueued.  Shortly after an
+// event is enqueued we may poll without sleeping, see InBusyPollingWindow().
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
   while (true) {
     bool events_still_pending;
+    bool busy_poll;
     {
       mutex_lock l(mu_);
       if (stop_polling_) {
@@ -207,17 +215,31 @@ void EventMgr::PollLoop() {
       }
       PollEvents(true, &to_free);
       events_still_pending = !used_events_.empty();
+      busy_poll = events_still_pending && InBusyPollingWindow();
     }
     FreeMemory(to_free);
     to_free.clear();
 
-    if (events_still_pending) {
+    if (events_still_pending && !busy_poll) {
       Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
     }
   }
   polling_stopped_->Notify();
 }
 
+// Sleeping between polls puts a floor of polling_active_delay_usecs_ under
+// the latency of every callback, which dominates when the GPU work behind
+// an event is short.  We therefore poll continuously for a while after an
+// event is queued.  The window is capped at twice the average time events
+// took to complete, so that a stream of long-running GPU work does not keep
+// the polling thread spinning.
+bool EventMgr::InBusyPollingWindow() {
+  if (polling_busy_window_usecs_ <= 0) return false;
+  const uint64 window = std::min<uint64>(polling_busy_window_usecs_,
+                                         2 * completion_usecs_);
+  return Env::Default()->NowMicros() < last_queued_micros_ + window;
+}
+
 void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
@@ -231,6 +253,10 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse iu) {
   free_events_.pop_back();
   stream->ThenRecordEvent(e);
   iu.event = e;
+  if (polling_busy_window_usecs_ > 0) {
+    iu.queued_micros = Env::Default()->NowMicros();
+    last_queued_micros_ = iu.queued_micros;
+  }
   bool was_empty = used_events_.empty();
   used_events_.push_back(iu);
   // Maybe wake up the polling thread
@@ -263,6 +289,7 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
+  uint64 now_micros = 0;
   for (auto& iu : used_events_) {
     if (iu.event == nullptr) continue;
     se::Event::Status s = iu.event->PollForStatus();
@@ -281,6 +308,12 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
         // the lock
         to_free->push_back(iu);
         free_events_.push_back(iu.event);
+        if (polling_busy_window_usecs_ > 0) {
+          if (now_micros == 0) now_micros = Env::Default()->NowMicros();
+          const uint64 latency =
+              now_micros > iu.queued_micros ? now_micros - iu.queued_micros : 0;
+          completion_usecs_ = (7 * completion_usecs_ + latency) / 8;
+        }
         // Mark this InUse record as completed.
         iu.event = nullptr;
     }
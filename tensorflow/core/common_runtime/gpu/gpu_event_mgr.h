@@ -111,6 +111,7 @@ class EventMgr {
   se::StreamExecutor* const exec_;
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
+  const int32 polling_busy_window_usecs_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -121,6 +122,8 @@ class EventMgr {
     TensorReferenceVector* mem;
     BufRec bufrec;
     std::function<void()> func;
+    // Time at which the event was queued, only set for busy polling.
+    uint64 queued_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
@@ -179,6 +182,10 @@ class EventMgr {
   // straggler Events.
   void PollLoop();
 
+  // Returns true if the polling loop should poll again without sleeping,
+  // because an event was queued less than the busy polling window ago.
+  bool InBusyPollingWindow() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Setup/Teardown functions for the polling loop.
   void StartPollingLoop();
   void StopPollingLoop();
@@ -195,6 +202,12 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // Time at which the most recent event was queued.
+  uint64 last_queued_micros_ GUARDED_BY(mu_);
+  // Moving average of the time between queueing an event and seeing it
+  // complete, which bounds the busy polling window.
+  uint64 completion_usecs_ GUARDED_BY(mu_);
+
   bool stop_polling_ GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
@@ -266,6 +266,23 @@ TEST(EventMgr, WarnIfInCallback) {
   EXPECT_TRUE(hit);
 }
 
+TEST(EventMgr, BusyPolling) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_polling_busy_window_usecs(100);
+  EventMgr em(stream_exec, gpu_options);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  // The callbacks run whether or not they are picked up while busy polling.
+  for (int i = 0; i < 10; ++i) {
+    Notification note;
+    em.ThenExecute(stream.get(), [&note]() { note.Notify(); });
+    note.WaitForNotification();
+    if (i % 2 == 1) Env::Default()->SleepForMicroseconds(200);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
 
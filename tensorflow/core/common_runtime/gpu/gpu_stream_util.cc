@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -65,14 +66,17 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
   // stream IDs and then map these down to the required number of streams
   // using simple round-robin.
   // Stream Assignment strategy:
-  // 1. Nodes with zero inputs are always be executed on a
-  // fresh stream.
-  // 2. Try to execute a node on the same stream as one of its
-  // inputs to avoid inter-stream dependencies.
-  // 3. If any input comes from a node with a large fanout then
-  // perhaps an indication that it is shared between parallel
-  // streams of work. We choose a new stream here so that all consumers
-  // of the tensor are likely to run in parallel.
+  // 1. A node is executed on the stream of the first of its data inputs
+  // whose producer has no other consumer on that stream yet, so that a
+  // chain of dependent nodes stays on one stream and needs no inter-stream
+  // dependencies.
+  // 2. Any other node, i.e. a node with no inputs or a further consumer of
+  // its inputs, is executed on a fresh stream, so that the independent
+  // branches of the graph are likely to run in parallel.
+  // The GPU device makes a node's stream wait for the streams of its inputs
+  // when they differ.
+  std::vector<int> candidate_stream(graph->num_node_ids(), -1);
+  std::vector<bool> stream_continued(graph->num_node_ids(), false);
   int highest_stream_id = -1;
   for (Node* n : order) {
     VLOG(3) << "Inspecting node " << n->DebugString();
@@ -80,14 +84,19 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
     const string& op = n->type_string();
 
     // Determine a suitable stream to use.
-    int stream_id = highest_stream_id + 1;
+    int stream_id = -1;
     for (const Edge* e : n->in_edges()) {
-      const size_t fanout = e->src()->out_edges().size();
-      if (fanout == 1) {
-        stream_id = (*node_to_stream_id)[e->src()->id()];
+      if (e->IsControlEdge()) continue;
+      const int src_id = e->src()->id();
+      if (!stream_continued[src_id]) {
+        stream_continued[src_id] = true;
+        stream_id = candidate_stream[src_id];
         break;
       }
     }
+    if (stream_id < 0) {
+      stream_id = highest_stream_id + 1;
+    }
     // Override stream for specific op types.
     if (op == "_Send") {
       if (opts.send_stream >= 0) stream_id = opts.send_stream;
@@ -99,6 +108,7 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
       if (opts.compute_stream >= 0) stream_id = opts.compute_stream;
     }
 
+    candidate_stream[node_id] = stream_id;
     (*node_to_stream_id)[node_id] = stream_id % opts.max_streams;
     highest_stream_id = std::max(stream_id, highest_stream_id);
   }
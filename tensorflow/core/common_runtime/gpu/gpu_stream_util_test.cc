@@ -103,6 +103,35 @@ TEST_F(GpuStreamUtilTest, SimpleGraphManyStreams) {
   }
 }
 
+TEST_F(GpuStreamUtilTest, IndependentBranches) {
+  auto root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Const(root.WithOpName("x"), 1.0f, {2, 2});
+  auto a = ops::MatMul(root.WithOpName("a"), x, x);
+  auto b = ops::MatMul(root.WithOpName("b"), x, x);
+  auto a2 = ops::Neg(root.WithOpName("a2"), a);
+  auto b2 = ops::Neg(root.WithOpName("b2"), b);
+  ops::Add(root.WithOpName("c"), a2, b2);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<int, int> node_to_stream_id;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = 2;
+  TF_ASSERT_OK(gpu_stream_util::AssignStreams(&g, opts, &node_to_stream_id));
+
+  std::unordered_map<string, int> stream;
+  for (const auto& it : node_to_stream_id) {
+    stream[g.FindNodeId(it.first)->name()] = it.second;
+  }
+  // The two branches run on different streams, and each chain of nodes
+  // stays on the stream of its branch.
+  EXPECT_NE(stream["a"], stream["b"]);
+  EXPECT_EQ(stream["a"], stream["a2"]);
+  EXPECT_EQ(stream["b"], stream["b2"]);
+  EXPECT_TRUE(stream["x"] == stream["a"] || stream["x"] == stream["b"]);
+  EXPECT_TRUE(stream["c"] == stream["a"] || stream["c"] == stream["b"]);
+}
+
 TEST_F(GpuStreamUtilTest, StreamOverrides) {
   auto root = Scope::DisabledShapeInferenceScope().ExitOnError();
   ops::_Recv(root.WithOpName("input"), DT_FLOAT, "input", "/cpu:0", 0,
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -36,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 // IMPLEMENTATION NOTE:
@@ -251,6 +256,65 @@ void GPUUtil::DeviceToDeviceCopy(
 static CopyTensor::Registration register_gpu_gpu_copy(
     DEVICE_GPU, DEVICE_GPU, GPUUtil::DeviceToDeviceCopy);
 
+namespace {
+
+// Name of the pooled allocator of CUDA host memory.
+const char kCUDAHostAllocatorName[] = "cuda_host_bfc";
+
+// Size of the chunks in which a host-to-device copy is staged.
+const int64 kHostStagingChunkBytes = 1 << 20;
+
+// Returns the size from which copies between the GPU and pageable host
+// memory go through pinned staging memory, read from
+// TF_GPU_HOST_STAGING_MIN_BYTES.  0 (the default) disables staging.
+int64 HostStagingMinBytes() {
+  static const int64 min_bytes = [] {
+    int64 bytes = 0;
+    Status s = ReadInt64FromEnvVar("TF_GPU_HOST_STAGING_MIN_BYTES", 0, &bytes);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      bytes = 0;
+    }
+    return bytes;
+  }();
+  return min_bytes;
+}
+
+// Returns true if the buffer of "tensor" was allocated in CUDA host memory,
+// which the GPU can copy to and from asynchronously.
+bool IsInCUDAHostMemory(const Tensor& tensor) {
+  TensorDescription desc;
+  tensor.FillDescription(&desc);
+  return desc.allocation_description().allocator_name() ==
+         kCUDAHostAllocatorName;
+}
+
+// Returns a buffer of "total_bytes" of pinned memory to stage a copy of
+// "cpu_tensor" through, and its allocator in "*allocator", or nullptr if
+// the copy should be made directly.
+//
+// A copy from or to pageable memory is staged by the driver itself, and is
+// synchronous with respect to the host.  Staging it through the pool of
+// CUDA host memory instead lets the copy overlap with other work.
+void* AllocateHostStagingBuffer(const Tensor& cpu_tensor, int64 total_bytes,
+                                Allocator** allocator) {
+  const int64 min_bytes = HostStagingMinBytes();
+  if (min_bytes <= 0 || total_bytes < min_bytes ||
+      IsInCUDAHostMemory(cpu_tensor)) {
+    return nullptr;
+  }
+  *allocator = GPUProcessState::singleton()->GetCUDAHostAllocator(0);
+  // Without CUDA host memory registration the allocator above hands out
+  // pageable memory, which is no better than the tensor's own buffer.
+  if ((*allocator)->Name() != kCUDAHostAllocatorName) {
+    return nullptr;
+  }
+  return (*allocator)->AllocateRaw(Allocator::kAllocatorAlignment,
+                                   total_bytes);
+}
+
+}  // namespace
+
 // static
 void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
                                  const DeviceContext* device_context,
@@ -277,21 +341,33 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = gpu_tensor->TotalBytes();
+  void* dst_ptr = nullptr;
+  Allocator* staging_allocator = nullptr;
+  void* staging_ptr = nullptr;
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
-    void* dst_ptr = GetBase(cpu_tensor);
-    send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
+    dst_ptr = GetBase(cpu_tensor);
+    staging_ptr = AllocateHostStagingBuffer(*cpu_tensor, total_bytes,
+                                            &staging_allocator);
+    send_device_to_host_stream->ThenMemcpy(
+        staging_ptr != nullptr ? staging_ptr : dst_ptr, gpu_src_ptr,
+        total_bytes);
   }
   // Use of the input may outlive stack scope, so keep a ref.
   TensorReference input_ref(*gpu_tensor);
   dev_info->event_mgr->ThenExecute(
       send_device_to_host_stream,
-      [send_device_to_host_stream, done, input_ref]() {
+      [send_device_to_host_stream, done, input_ref, dst_ptr,
+       staging_allocator, staging_ptr, total_bytes]() {
         if (!send_device_to_host_stream->ok()) {
           LOG(FATAL) << "GPU->CPU Memcpy failed";
         }
         input_ref.Unref();
+        if (staging_ptr != nullptr) {
+          std::memcpy(dst_ptr, staging_ptr, total_bytes);
+          staging_allocator->DeallocateRaw(staging_ptr);
+        }
         done(Status::OK());
       });
 }
@@ -326,8 +402,32 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
-    DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
-    recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
+    Allocator* staging_allocator = nullptr;
+    void* staging_ptr = AllocateHostStagingBuffer(*cpu_tensor, total_bytes,
+                                                  &staging_allocator);
+    if (staging_ptr != nullptr) {
+      // Stage and enqueue the copy chunk by chunk, so that the copy of a
+      // chunk to the GPU overlaps with staging the next one.
+      char* src = static_cast<char*>(src_ptr);
+      char* staging = static_cast<char*>(staging_ptr);
+      char* dst = static_cast<char*>(dst_ptr);
+      for (int64 offset = 0; offset < total_bytes;
+           offset += kHostStagingChunkBytes) {
+        const int64 bytes =
+            std::min(kHostStagingChunkBytes, total_bytes - offset);
+        std::memcpy(staging + offset, src + offset, bytes);
+        DeviceMemoryBase gpu_dst_ptr(dst + offset, bytes);
+        recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, staging + offset,
+                                               bytes);
+      }
+      EventMgr::BufRec bufrec{staging_allocator, staging_ptr, "", 0};
+      dev_info->event_mgr->ThenDeleteBuffer(recv_host_to_device_stream,
+                                            bufrec);
+    } else {
+      DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
+      recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr,
+                                             total_bytes);
+    }
   }
   // Use of cpu_tensor may outlive stack scope, so keep a ref.
   TensorReference input_ref(*cpu_tensor);
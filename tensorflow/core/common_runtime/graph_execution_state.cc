@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -592,6 +593,7 @@ Status GraphExecutionState::OptimizeGraph(
         }
         feeds.insert(id.first.ToString());
       }
+      std::unordered_map<string, TensorShapeProto> specialized_shapes;
       for (const NodeDef& node : original_graph_def_.node()) {
         if (feeds.find(node.name()) == feeds.end()) {
           continue;
@@ -601,6 +603,15 @@ Status GraphExecutionState::OptimizeGraph(
           return errors::InvalidArgument("Missing node shape or type");
         }
         TensorShapeProto shape_proto(node.attr().at("shape").shape());
+        // The graph is only run with feeds of the specialized batch size, so
+        // tell the optimizers about it.
+        if (options.specialized_batch_size !=
+                BuildGraphOptions::kNoSpecializedBatchSize &&
+            !shape_proto.unknown_rank() && shape_proto.dim_size() > 0 &&
+            shape_proto.dim(0).size() < 0) {
+          shape_proto.mutable_dim(0)->set_size(options.specialized_batch_size);
+          specialized_shapes[node.name()] = shape_proto;
+        }
         // If the shape of the placeholder value is only partially known,
         // we're free to use any dimension we want to feed the placeholder. We
         // choose 1 to minimize the memory impact. Note that this only matters
@@ -619,6 +630,14 @@ Status GraphExecutionState::OptimizeGraph(
         Tensor fake_input(type, shape);
         item.feed.emplace_back(node.name(), fake_input);
       }
+      if (!specialized_shapes.empty()) {
+        for (NodeDef& node : *item.graph.mutable_node()) {
+          auto it = specialized_shapes.find(node.name());
+          if (it != specialized_shapes.end()) {
+            *(*node.mutable_attr())["shape"].mutable_shape() = it->second;
+          }
+        }
+      }
     }
 
     Device* cpu_device = nullptr;
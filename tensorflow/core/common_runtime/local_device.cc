@@ -16,13 +16,21 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/common_runtime/local_device.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
+#include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -32,17 +40,30 @@ namespace tensorflow {
 bool LocalDevice::use_global_threadpool_ = true;
 
 struct LocalDevice::EigenThreadPoolInfo {
-  explicit EigenThreadPoolInfo(const SessionOptions& options) {
+  // Creates the threads on "numa_node", or anywhere if it is
+  // port::kNUMANoAffinity.
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
     if (intra_op_parallelism_threads == 0) {
       intra_op_parallelism_threads = port::NumSchedulableCPUs();
+      if (numa_node != port::kNUMANoAffinity) {
+        // Each node's pool gets the schedulable CPUs of one node.
+        intra_op_parallelism_threads = std::max(
+            1, intra_op_parallelism_threads / port::NUMANumNodes());
+      }
     }
     VLOG(1) << "Local device intra op parallelism threads: "
             << intra_op_parallelism_threads;
+    ThreadOptions thread_opts;
+    thread_opts.numa_node = numa_node;
+    string name = "Eigen";
+    if (numa_node != port::kNUMANoAffinity) {
+      name = strings::StrCat("numa_", numa_node, "_Eigen");
+    }
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
-    eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+    eigen_worker_threads_.workers = NewThreadPoolWithSessionSpinPolicy(
+        options, thread_opts, name, intra_op_parallelism_threads);
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -67,16 +88,40 @@ LocalDevice::LocalDevice(const SessionOptions& options,
   // could speed up performance and are available on the current CPU.
   port::InfoAboutUnusedCPUFeatures();
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  int numa_node = port::kNUMANoAffinity;
+  if (options.config.experimental().use_numa_affinity() &&
+      port::NUMAEnabled()) {
+    numa_node = attributes.locality().numa_node();
+    if (numa_node < 0 || numa_node >= port::NUMANumNodes()) {
+      numa_node = port::kNUMANoAffinity;
+    }
+  }
+  if (use_global_threadpool_ && numa_node != port::kNUMANoAffinity) {
+    // All devices on a NUMA node share one fixed sized threadpool whose
+    // threads are pinned to that node.
+    static mutex* global_tp_mu = new mutex;
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_infos =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>(
+            port::NUMANumNodes(), nullptr);
+    mutex_lock l(*global_tp_mu);
+    LocalDevice::EigenThreadPoolInfo*& numa_tp_info =
+        (*numa_tp_infos)[numa_node];
+    if (numa_tp_info == nullptr) {
+      numa_tp_info = new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+    }
+    tp_info = numa_tp_info;
+  } else if (use_global_threadpool_) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options,
+                                             port::kNUMANoAffinity);
     tp_info = global_tp_info;
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
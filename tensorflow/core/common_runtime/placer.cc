@@ -21,12 +21,16 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/memory_types.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -616,6 +620,12 @@ class ColocationGraph {
     return member.parent;
   }
 
+  // Returns true if no other node is colocated with the node with the given
+  // id.
+  bool IsSingleton(int node_id) {
+    return FindRoot(node_id) == node_id && members_[node_id].rank == 0;
+  }
+
   // Ensures that the devices of 'dst's resource and reference match the device
   // specified for 'src', which is an input of 'dst' with a partially or fully
   // specified device.
@@ -677,16 +687,145 @@ bool IsExemptFromResourceInputColocation(const Node* node) {
   return op_type == "PartitionedCall" || op_type == "StatefulPartitionedCall";
 }
 
+// The estimates of cost-aware placement, in microseconds and bytes.
+//
+// The fixed cost of running a kernel on an accelerator rather than on a CPU,
+// e.g. of launching it.
+constexpr int64 kAcceleratorLaunchMicros = 5;
+// The latency and bandwidth of copies between host and device memory.
+constexpr double kCopyLatencyMillis = 0.01;
+constexpr double kCopyGbps = 64;
+// Nodes that are estimated to take longer are not moved, as the estimates
+// don't tell how much their time differs between devices.
+constexpr int64 kMaxMovableNodeMicros = 50;
+
+// Estimates what running nodes on given devices costs, for cost-aware
+// placement. Measurements from a CostModel take precedence over static
+// estimates, which rely on the output shapes that shape inference finds.
+class PlacementCostEstimator {
+ public:
+  PlacementCostEstimator(const Graph& graph, const CostModel* cost_model)
+      : graph_(graph), cost_model_(cost_model) {
+    InferOutputBytes();
+  }
+
+  // Returns the estimated time of running "node" on "device", not counting
+  // copies, or -1 if it's unknown.
+  int64 ComputeMicros(const Node* node, const Device* device) const {
+    int64 micros = 0;
+    if (cost_model_ != nullptr && cost_model_->TotalCount(node) > 0) {
+      micros = cost_model_->TimeEstimate(node).value();
+    } else {
+      // Assumes about one operation per byte read or written.
+      int64 bytes = 0;
+      for (const Edge* edge : node->in_edges()) {
+        if (edge->IsControlEdge()) continue;
+        const int64 input_bytes = OutputBytes(edge->src(), edge->src_output());
+        if (input_bytes < 0) return -1;
+        bytes += input_bytes;
+      }
+      for (int i = 0; i < node->num_outputs(); ++i) {
+        const int64 output_bytes = OutputBytes(node, i);
+        if (output_bytes < 0) return -1;
+        bytes += output_bytes;
+      }
+      micros = CostModel::ComputationTimeEstimate(bytes).value();
+    }
+    if (device->device_type() != DEVICE_CPU) {
+      micros += kAcceleratorLaunchMicros;
+    }
+    return micros;
+  }
+
+  // Returns the estimated time of copying the tensor "edge" carries when its
+  // source runs on "src_device" and its destination on "dst_device", or -1
+  // if it's unknown.
+  int64 CopyMicros(const Edge* edge, const Device* src_device,
+                   const Device* dst_device) const {
+    if (src_device == dst_device ||
+        (InHostMemory(edge->src(), src_device, false, edge->src_output()) &&
+         InHostMemory(edge->dst(), dst_device, true, edge->dst_input()))) {
+      return 0;
+    }
+    const int64 bytes = OutputBytes(edge->src(), edge->src_output());
+    if (bytes < 0) return -1;
+    return CostModel::CopyTimeEstimate(Bytes(bytes), kCopyLatencyMillis,
+                                       kCopyGbps)
+        .value();
+  }
+
+ private:
+  // Returns the size of output "slot" of "node", or -1 if it's unknown.
+  int64 OutputBytes(const Node* node, int slot) const {
+    if (cost_model_ != nullptr) {
+      const int64 bytes = cost_model_->SizeEstimate(node, slot).value();
+      if (bytes > 0) return bytes;
+    }
+    return output_bytes_[node->id()][slot];
+  }
+
+  // Returns whether input or output "index" of "node" is in host memory when
+  // "node" runs on "device".
+  bool InHostMemory(const Node* node, const Device* device, bool is_input,
+                    int index) const {
+    MemoryTypeVector input_types;
+    MemoryTypeVector output_types;
+    if (!MemoryTypesForNode(graph_.op_registry(),
+                            DeviceType(device->device_type()), node->def(),
+                            &input_types, &output_types)
+             .ok()) {
+      return false;
+    }
+    const MemoryTypeVector& types = is_input ? input_types : output_types;
+    return index < types.size() && types[index] == HOST_MEMORY;
+  }
+
+  void InferOutputBytes() {
+    output_bytes_.resize(graph_.num_node_ids());
+    ShapeRefiner refiner(graph_.versions(), graph_.op_registry());
+    std::vector<Node*> order;
+    GetReversePostOrder(graph_, &order);
+    for (Node* node : order) {
+      std::vector<int64>* bytes = &output_bytes_[node->id()];
+      bytes->assign(node->num_outputs(), -1);
+      // Nodes whose inputs include back edges fail, so their sizes stay
+      // unknown.
+      if (!node->IsOp() || !refiner.AddNode(node).ok()) continue;
+      shape_inference::InferenceContext* c = refiner.GetContext(node);
+      for (int i = 0; i < node->num_outputs(); ++i) {
+        const int element_bytes = DataTypeSize(BaseType(node->output_type(i)));
+        const shape_inference::ShapeHandle shape = c->output(i);
+        if (element_bytes == 0 || !c->FullyDefined(shape)) continue;
+        int64 num_elements = 1;
+        for (int d = 0; d < c->Rank(shape); ++d) {
+          num_elements *= c->Value(c->Dim(shape, d));
+        }
+        (*bytes)[i] = num_elements * element_bytes;
+      }
+    }
+  }
+
+  const Graph& graph_;
+  const CostModel* const cost_model_;
+  // Indexed by node id and output slot, -1 where unknown.
+  std::vector<std::vector<int64>> output_bytes_;
+};
+
 }  // namespace
 
 Placer::Placer(Graph* graph, const DeviceSet* devices,
-               const SessionOptions* options)
+               const SessionOptions* options, const CostModel* cost_model)
     : graph_(graph),
       devices_(devices),
       options_(options),
+      cost_model_(cost_model),
       log_device_placement_(options != nullptr &&
                             options->config.log_device_placement()) {}
 
+Placer::Placer(Graph* graph, const DeviceSet* devices,
+               const SessionOptions* options)
+    : Placer(graph, devices, options, nullptr) {}
+
 Placer::Placer(Graph* graph, const DeviceSet* devices)
     : Placer(graph, devices, nullptr) {}
 
@@ -784,6 +923,27 @@ Status Placer::Run() {
     }
   }
 
+  // Nodes that cost-aware placement may move to a CPU device, see
+  // RefinePlacementByCost().
+  const bool cost_aware = UseCostAwarePlacement();
+  std::vector<Device*> cpu_devices;
+  if (cost_aware) cpu_devices.resize(graph_->num_node_ids(), nullptr);
+  auto add_cost_aware_candidate = [this, &colocation_graph, &cpu_devices](
+                                      const Node* node,
+                                      const std::vector<Device*>& devices) {
+    if (!colocation_graph.IsSingleton(node->id()) ||
+        devices_->FindDeviceByName(node->assigned_device_name())
+                ->device_type() == DEVICE_CPU) {
+      return;
+    }
+    for (Device* device : devices) {
+      if (device->device_type() == DEVICE_CPU) {
+        cpu_devices[node->id()] = device;
+        return;
+      }
+    }
+  };
+
   // 3. For each node, assign a device based on the constraints in the
   // disjoint node set.
   std::vector<Node*> second_pass;
@@ -843,12 +1003,35 @@ Status Placer::Run() {
       }
     }
 
+    // Heuristic C: If CPU devices are bound to NUMA nodes, place a node
+    // on the device of its first data input instead of the first device
+    // of the same type, so that it runs on the NUMA node that holds its
+    // input. Only nodes that are not colocated with any other node are
+    // moved, as the rest of a colocation group would still be placed on
+    // the first device.
+    if (assigned_device == -1 && UseNUMAAffinity() &&
+        colocation_graph.IsSingleton(node->id())) {
+      for (const Edge* edge : node->in_edges()) {
+        if (edge->IsControlEdge()) continue;
+        const Node* input = edge->src();
+        const Device* input_device =
+            devices_->FindDeviceByName(input->assigned_device_name());
+        if (input_device != nullptr &&
+            input_device->device_type() == (*devices)[0]->device_type() &&
+            CanAssignToDevice(input->assigned_device_name(), *devices)) {
+          assigned_device = input->assigned_device_name_index();
+        }
+        break;
+      }
+    }
+
     // Provide the default, if necessary.
     if (assigned_device == -1) {
       assigned_device = graph_->InternDeviceName((*devices)[0]->name());
     }
 
     AssignAndLog(assigned_device, node);
+    if (cost_aware) add_cost_aware_candidate(node, *devices);
   }
 
   // 4. Perform a second pass assignment for those nodes explicitly
@@ -863,24 +1046,8 @@ Status Placer::Run() {
                        *node);
     }
 
-    int assigned_device = -1;
-
     // Heuristic A application.
-    if (IsGeneratorNode(node)) {
-      const Node* output = (*node->out_edges().begin())->dst();
-      int output_device_name = output->assigned_device_name_index();
-
-      const bool consumers_on_same_device = std::all_of(
-          node->out_edges().begin(), node->out_edges().end(),
-          [output_device_name](const Edge* e) {
-            return e->dst()->assigned_device_name_index() == output_device_name;
-          });
-
-      if (consumers_on_same_device &&
-          CanAssignToDevice(output->assigned_device_name(), *devices)) {
-        assigned_device = output_device_name;
-      }
-    }
+    int assigned_device = GeneratorDevice(node, *devices);
 
     // Provide the default, if necessary.
     if (assigned_device == -1) {
@@ -888,11 +1055,103 @@ Status Placer::Run() {
     }
 
     AssignAndLog(assigned_device, node);
+    if (cost_aware) add_cost_aware_candidate(node, *devices);
+  }
+
+  // 5. With cost-aware placement, move cheap nodes to a CPU device where
+  // that saves more time in copies and kernel launches than it costs.
+  if (cost_aware) {
+    RefinePlacementByCost(cpu_devices);
+    // Generators follow their consumers again, in case those moved.
+    for (Node* node : second_pass) {
+      if (!colocation_graph.IsSingleton(node->id())) continue;
+      std::vector<Device*>* devices;
+      TF_RETURN_IF_ERROR(colocation_graph.GetDevicesForNode(node, &devices));
+      const int assigned_device = GeneratorDevice(node, *devices);
+      if (assigned_device != -1 &&
+          assigned_device != node->assigned_device_name_index()) {
+        AssignAndLog(assigned_device, node);
+      }
+    }
   }
 
   return Status::OK();
 }
 
+int Placer::GeneratorDevice(const Node* node,
+                            const std::vector<Device*>& devices) const {
+  if (!IsGeneratorNode(node)) return -1;
+  const Node* output = (*node->out_edges().begin())->dst();
+  int output_device_name = output->assigned_device_name_index();
+
+  const bool consumers_on_same_device = std::all_of(
+      node->out_edges().begin(), node->out_edges().end(),
+      [output_device_name](const Edge* e) {
+        return e->dst()->assigned_device_name_index() == output_device_name;
+      });
+
+  if (consumers_on_same_device &&
+      CanAssignToDevice(output->assigned_device_name(), devices)) {
+    return output_device_name;
+  }
+  return -1;
+}
+
+void Placer::RefinePlacementByCost(
+    const std::vector<Device*>& cpu_devices) const {
+  PlacementCostEstimator estimator(*graph_, cost_model_);
+  auto device_of = [this](const Node* node) {
+    return devices_->FindDeviceByName(node->assigned_device_name());
+  };
+  // Returns the estimated time of running "node" on "device", including the
+  // copies of its inputs and outputs, or -1 if it's unknown.
+  auto cost_on = [&estimator, &device_of](const Node* node,
+                                          const Device* device) -> int64 {
+    int64 micros = estimator.ComputeMicros(node, device);
+    if (micros < 0) return -1;
+    for (const Edge* edge : node->in_edges()) {
+      if (edge->IsControlEdge()) continue;
+      const Device* src_device = device_of(edge->src());
+      if (src_device == nullptr) return -1;
+      const int64 copy_micros = estimator.CopyMicros(edge, src_device, device);
+      if (copy_micros < 0) return -1;
+      micros += copy_micros;
+    }
+    for (const Edge* edge : node->out_edges()) {
+      if (edge->IsControlEdge()) continue;
+      const Device* dst_device = device_of(edge->dst());
+      if (dst_device == nullptr) return -1;
+      const int64 copy_micros = estimator.CopyMicros(edge, device, dst_device);
+      if (copy_micros < 0) return -1;
+      micros += copy_micros;
+    }
+    return micros;
+  };
+
+  // Visits the nodes in topological order, so that the moves of the inputs
+  // of a node are known when it is considered.
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph_, &order);
+  for (Node* node : order) {
+    const Device* cpu_device = cpu_devices[node->id()];
+    if (cpu_device == nullptr) continue;
+    const int64 cpu_compute_micros = estimator.ComputeMicros(node, cpu_device);
+    if (cpu_compute_micros < 0 || cpu_compute_micros > kMaxMovableNodeMicros) {
+      continue;
+    }
+    const int64 current_micros = cost_on(node, device_of(node));
+    const int64 cpu_micros = cost_on(node, cpu_device);
+    if (current_micros < 0 || cpu_micros < 0 || cpu_micros >= current_micros) {
+      continue;
+    }
+    VLOG(1) << "Moving " << node->name() << " from "
+            << node->assigned_device_name() << " to " << cpu_device->name()
+            << ", which saves an estimated "
+            << current_micros - cpu_micros << "us";
+    AssignAndLog(graph_->InternDeviceName(cpu_device->name()), node);
+  }
+}
+
 bool Placer::CanAssignToDevice(const string& candidate_device_name,
                                const std::vector<Device*>& devices) const {
   if (!candidate_device_name.empty()) {
@@ -926,6 +1185,16 @@ void Placer::LogDeviceAssignment(const Node* node) const {
   }
 }
 
+bool Placer::UseNUMAAffinity() const {
+  return options_ != nullptr &&
+         options_->config.experimental().use_numa_affinity();
+}
+
+bool Placer::UseCostAwarePlacement() const {
+  return options_ != nullptr &&
+         options_->config.experimental().cost_aware_placement();
+}
+
 bool Placer::ClientHandlesErrorFormatting() const {
   return options_ != nullptr &&
          options_->config.experimental().client_handles_error_formatting();
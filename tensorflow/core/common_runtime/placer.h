@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/graph/graph.h"
@@ -29,6 +30,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class CostModel;
+
 // A placement algorithm that assigns the nodes of the given Graph to
 // devices the given DeviceSet, respecting the following constraints:
 //
@@ -68,6 +71,14 @@ class Placer {
 
   Placer(Graph* graph, const DeviceSet* devices);
 
+  // Same as above, but with cost-aware placement (see
+  // ConfigProto.Experimental.cost_aware_placement) "cost_model" provides the
+  // measured execution times and output sizes of the nodes of "graph",
+  // which take precedence over static estimates. "cost_model" may be null,
+  // and is borrowed by this Placer.
+  Placer(Graph* graph, const DeviceSet* devices, const SessionOptions* options,
+         const CostModel* cost_model);
+
   ~Placer();
 
   // Assigns each node in this Placer's graph to a device in its
@@ -88,11 +99,25 @@ class Placer {
   void AssignAndLog(int assigned_device, Node* node) const;
   void LogDeviceAssignment(const Node* node) const;
   bool ClientHandlesErrorFormatting() const;
+  // Returns true if CPU devices may be bound to different NUMA nodes.
+  bool UseNUMAAffinity() const;
+  bool UseCostAwarePlacement() const;
+  // Moves each of the candidates, which were placed on an accelerator but
+  // may run on a CPU device, to that device if that lowers the estimated
+  // step time.
+  // "cpu_devices" maps the id of each candidate to the CPU device it may be
+  // moved to, and that of any other node to null.
+  void RefinePlacementByCost(const std::vector<Device*>& cpu_devices) const;
+  // Returns the device of the consumers of generator node "node" if it's in
+  // "devices", or -1.
+  int GeneratorDevice(const Node* node,
+                      const std::vector<Device*>& devices) const;
   string RichNodeName(const Node* node) const;
 
   Graph* const graph_;              // Not owned.
   const DeviceSet* const devices_;  // Not owned.
   const SessionOptions* options_;   // Not owned.
+  const CostModel* cost_model_;     // Not owned.
   const bool log_device_placement_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Placer);
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/graph/graph_def_builder_util.h"
@@ -329,6 +330,65 @@ TEST_F(PlacerTest, TestMetadataColocatedWithInput) {
   EXPECT_COLOCATED(g, "var_cpu", "shape_op");
 }
 
+// Heuristic C: with NUMA affinity, a node follows its input to another
+// device of the same type instead of taking the first one.
+TEST_F(PlacerTest, TestNUMAAffinityFollowsInputDevice) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp(
+        "TestInput", b.opts().WithName("in").WithDevice(
+                         "/job:a/replica:0/task:0/device:fakecpu:3"));
+    ops::UnaryOp("ReluCPU", ops::NodeOut(input, 0), b.opts().WithName("n1"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  TF_EXPECT_OK(Place(&g));
+  EXPECT_DEVICE_CONTAINS(g, "n1", "/device:fakecpu:0");
+
+  for (Node* node : g.op_nodes()) node->set_assigned_device_name("");
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  TF_EXPECT_OK(Place(&g, &options));
+  EXPECT_DEVICE_CONTAINS(g, "in", "/device:fakecpu:3");
+  EXPECT_COLOCATED(g, "in", "n1");
+}
+
+// With cost-aware placement, a cheap node between CPU nodes moves to the CPU
+// when the copies to and from the GPU cost more than it saves.
+TEST_F(PlacerTest, TestCostAwarePlacementAvoidsCopies) {
+  Graph g(OpRegistry::Global());
+  {  // Scope for temporary variables used to construct g.
+    GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+    Node* input = ops::SourceOp("TestInput", b.opts().WithName("in"));
+    Node* n1 = ops::UnaryOp("TestRelu", ops::NodeOut(input, 0),
+                            b.opts().WithName("n1"));
+    ops::UnaryOp("ReluCPU", n1, b.opts().WithName("n2"));
+    TF_EXPECT_OK(BuildGraph(b, &g));
+  }
+
+  TF_EXPECT_OK(Place(&g));
+  EXPECT_DEVICE_TYPE(g, "n1", "FakeGPU");
+
+  // Measured: "n1" takes 1us, and "in" and "n1" output 4MB each.
+  CostModel cost_model(false);
+  cost_model.InitFromGraph(g);
+  for (const string& name : {"in", "n1"}) {
+    Node* node = GetNodeByName(g, name);
+    cost_model.RecordCount(node, 1);
+    cost_model.RecordTime(node, Microseconds(1));
+    cost_model.RecordSize(node, 0, Bytes(4 << 20));
+  }
+
+  for (Node* node : g.op_nodes()) node->set_assigned_device_name("");
+  SessionOptions options;
+  options.config.mutable_experimental()->set_cost_aware_placement(true);
+  Placer placer(&g, &devices_, &options, &cost_model);
+  TF_EXPECT_OK(placer.Run());
+  EXPECT_DEVICE_TYPE(g, "n1", "FakeCPU");
+  EXPECT_DEVICE_TYPE(g, "n2", "FakeCPU");
+}
+
 // Heuristic A implements "Island fusing": if a node only generates
 // an output and it has only one consumer, we place the node
 // with its consumer.
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -285,10 +286,18 @@ void PoolAllocator::AddFreeVisitor(Visitor visitor) {
 }
 
 void* BasicCPUAllocator::Alloc(size_t alignment, size_t num_bytes) {
+  if (numa_node_ != port::kNUMANoAffinity) {
+    return port::NUMAMalloc(numa_node_, num_bytes,
+                            static_cast<int>(alignment));
+  }
   return port::AlignedMalloc(num_bytes, static_cast<int>(alignment));
 }
 
 void BasicCPUAllocator::Free(void* ptr, size_t num_bytes) {
+  if (numa_node_ != port::kNUMANoAffinity) {
+    port::NUMAFree(ptr, num_bytes);
+    return;
+  }
   port::AlignedFree(ptr);
 }
 
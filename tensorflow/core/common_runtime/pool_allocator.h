@@ -165,7 +165,7 @@ class Pow2Rounder : public RoundUpInterface {
 
 class BasicCPUAllocator : public SubAllocator {
  public:
-  // Argument numa_node is currently ignored.
+  // Memory is allocated on "numa_node" unless it is port::kNUMANoAffinity.
   explicit BasicCPUAllocator(int numa_node) : numa_node_(numa_node) {}
 
   ~BasicCPUAllocator() override {}
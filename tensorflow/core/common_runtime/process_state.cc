@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -76,6 +77,10 @@ VisitableAllocator* ProcessState::GetCPUAllocator(int numa_node) {
   if (!numa_enabled_) numa_node = 0;
   mutex_lock lock(mu_);
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
+    // Allocators are created for every node up to "numa_node", each bound
+    // to the node it will be returned for.
+    const int node =
+        numa_enabled_ ? cpu_allocators_.size() : port::kNUMANoAffinity;
     bool use_bfc_allocator = false;
     // TODO(reedwm): Switch default to BGFAllocator if it's at least as fast and
     // efficient.
@@ -96,14 +101,14 @@ VisitableAllocator* ProcessState::GetCPUAllocator(int numa_node) {
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       allocator = new BFCAllocator(
-          new BasicCPUAllocator(numa_enabled_ ? numa_node : -1), cpu_mem_limit,
+          new BasicCPUAllocator(node), cpu_mem_limit,
           true /*allow_growth*/, "bfc_cpu_allocator_for_gpu" /*name*/);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else {
       allocator = new PoolAllocator(
           100 /*pool_size_limit*/, true /*auto_resize*/,
-          new BasicCPUAllocator(numa_enabled_ ? numa_node : -1),
+          new BasicCPUAllocator(node),
           new NoopRounder, "cpu_pool");
       VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
               << "numa_enabled_=" << numa_enabled_
@@ -63,8 +63,8 @@ class ProcessState {
   // If we know nothing, it's called CPU 0 with no other attributes.
   MemDesc PtrType(const void* ptr);
 
-  // Returns the one CPUAllocator used for the given numa_node.
-  // TEMPORARY: ignores numa_node.
+  // Returns the one CPUAllocator used for the given numa_node. Its memory
+  // is only bound to numa_node if EnableNUMA() has been called.
   VisitableAllocator* GetCPUAllocator(int numa_node);
 
   typedef std::unordered_map<const void*, MemDesc> MDMap;
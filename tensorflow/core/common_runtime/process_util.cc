@@ -41,8 +41,11 @@ static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
     inter_op_parallelism_threads = port::NumSchedulableCPUs();
   }
 
-  return new thread::ThreadPool(Env::Default(), "Compute",
-                                inter_op_parallelism_threads);
+  SessionOptions default_env_options = options;
+  default_env_options.env = Env::Default();
+  return NewThreadPoolWithSessionSpinPolicy(
+      default_env_options, ThreadOptions(), "Compute",
+      inter_op_parallelism_threads);
 }
 
 }  // namespace
@@ -80,7 +83,35 @@ thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options) {
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
-  return new thread::ThreadPool(options.env, "Compute", num_threads);
+  return NewThreadPoolWithSessionSpinPolicy(options, ThreadOptions(),
+                                            "Compute", num_threads);
+}
+
+thread::ThreadPool* NewThreadPoolWithSessionSpinPolicy(
+    const SessionOptions& options, const ThreadOptions& thread_options,
+    const string& name, int32 num_threads) {
+  const ConfigProto::Experimental& experimental = options.config.experimental();
+  thread::ThreadPool::SpinPolicy spin_policy;
+  switch (experimental.thread_pool_spin_policy()) {
+    case ConfigProto::Experimental::NO_SPIN:
+      spin_policy = thread::ThreadPool::SpinPolicy::kNever;
+      break;
+    case ConfigProto::Experimental::ALWAYS_SPIN:
+      spin_policy = thread::ThreadPool::SpinPolicy::kAlways;
+      break;
+    case ConfigProto::Experimental::ADAPTIVE_SPIN:
+      spin_policy = thread::ThreadPool::SpinPolicy::kAdaptive;
+      break;
+    default:
+      spin_policy = thread::ThreadPool::SpinPolicy::kDefault;
+      break;
+  }
+  int64 spin_duration_us = experimental.thread_pool_spin_duration_us();
+  if (spin_duration_us <= 0) {
+    spin_duration_us = 50;
+  }
+  return new thread::ThreadPool(options.env, thread_options, name,
+                                num_threads, spin_policy, spin_duration_us);
 }
 
 void SchedClosure(std::function<void()> closure) {
@@ -37,6 +37,12 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
 
+// Creates a thread pool with "num_threads" threads whose idle threads spin
+// as "options" configures.
+thread::ThreadPool* NewThreadPoolWithSessionSpinPolicy(
+    const SessionOptions& options, const ThreadOptions& thread_options,
+    const string& name, int32 num_threads);
+
 // Schedule "closure" in the default thread queue.
 void SchedClosure(std::function<void()> closure);
 
@@ -14,10 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/ring_reducer.h"
 
+#include <set>
+
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
@@ -29,18 +32,27 @@ namespace tensorflow {
 namespace {
 // Each CollectiveOp implementation is free to define its own
 // BufRendezvous key format.  This function produces the key used by
-// RingReducer.
-string RingReduceBufKey(const string& exec_key, int pass, int section,
-                        int source_rank) {
+// RingReducer.  'source_rank' is the default rank of the sending device,
+// not its position in the ring, so that the keys of the concurrent per-task
+// rings of a hierarchical reduction do not collide.
+string RingReduceBufKey(const string& exec_key, int phase, int pass,
+                        int section, int source_rank) {
   if (READABLE_KEYS) {
-    return strings::StrCat("rred(", exec_key, "):pass(", pass, "):section(",
-                           section, "):srcrank(", source_rank, ")");
+    return strings::StrCat("rred(", exec_key, "):phase(", phase, "):pass(",
+                           pass, "):section(", section, "):srcrank(",
+                           source_rank, ")");
   } else {
     // TODO(tucker): Try out some kind of denser encoding, e.g. 128 bit hash.
-    return strings::StrCat(exec_key, ":", pass, ":", section, ":", source_rank);
+    return strings::StrCat(exec_key, ":", phase, ":", pass, ":", section, ":",
+                           source_rank);
   }
 }
 
+// Phases of a hierarchical reduction.  A flat ring runs only kTaskRing.
+const int kTaskRing = 0;
+const int kLeaderRing = 1;
+const int kTaskBroadcast = 2;
+
 }  // namespace
 
 void RingReducer::PCQueue::Enqueue(RingField* rf) {
@@ -180,9 +192,14 @@ void RingReducer::Run(StatusCallback done) {
 // Note that this function is blocking and must not run in any thread
 // which cannot be blocked.
 void RingReducer::ContinueAfterInputCopy() {
-  AllocatorAttributes attr = ctx_->output_alloc_attr(0);
-  ca_.reset(MakeCollectiveAdapter(output_, group_size_ * num_subdivs_,
-                                  device_->GetAllocator(attr)));
+  hierarchical_ =
+      col_params_.instance.impl_details.hierarchical && InitHierarchy();
+  if (hierarchical_) {
+    StartRing(kTaskRing, task_perms_, task_ranks_, false /*apply_final_op*/);
+  } else {
+    StartRing(kTaskRing, col_params_.instance.impl_details.subdiv_permutations,
+              col_params_.subdiv_rank, true /*apply_final_op*/);
+  }
 
   if (col_params_.final_op) {
     // Create an on-device scalar value from group_size_ that may be needed
@@ -207,7 +224,139 @@ void RingReducer::ContinueAfterInputCopy() {
       group_size_tensor_ready_.Notify();
     }
   }
-  Finish(RunAsyncParts());
+  bool ok = RunAsyncParts();
+  if (ok && hierarchical_) {
+    ok = ContinueHierarchical();
+  }
+  Finish(ok);
+}
+
+void RingReducer::StartRing(int phase,
+                            const std::vector<std::vector<int>>& perms,
+                            const std::vector<int>& ranks,
+                            bool apply_final_op) {
+  CHECK_EQ(perms.size(), num_subdivs_);
+  CHECK_EQ(ranks.size(), num_subdivs_);
+  ring_phase_ = phase;
+  ring_size_ = static_cast<int>(perms[0].size());
+  ring_applies_final_op_ = apply_final_op;
+  ring_perms_ = perms;
+  ring_rank_ = ranks;
+  if (ca_) {
+    // Recover the output left by the previous ring before re-chunking it.
+    ca_->ConsumeFinalValue(output_);
+  }
+  AllocatorAttributes attr = ctx_->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(output_, ring_size_ * num_subdivs_,
+                                  device_->GetAllocator(attr)));
+}
+
+bool RingReducer::InitHierarchy() {
+  const CollInstanceParams& ip = col_params_.instance;
+  const string& task_name = ip.task_names[col_params_.default_rank];
+  // The leader of each task is its device with the least default rank.
+  std::vector<int> leaders;
+  std::set<string> seen_tasks;
+  for (int i = 0; i < group_size_; ++i) {
+    if (!seen_tasks.insert(ip.task_names[i]).second) continue;
+    leaders.push_back(i);
+    if (ip.task_names[i] == task_name) task_leader_ = i;
+  }
+  if (leaders.size() < 2 || leaders.size() == group_size_) {
+    return false;
+  }
+  // Each per-task ring keeps the order its devices have in the subdiv
+  // permutations, which the param resolver derived from device localities.
+  task_perms_.assign(num_subdivs_, std::vector<int>());
+  task_ranks_.assign(num_subdivs_, -1);
+  for (int sdi = 0; sdi < num_subdivs_; ++sdi) {
+    for (int di : ip.impl_details.subdiv_permutations[sdi]) {
+      if (ip.task_names[di] != task_name) continue;
+      if (di == col_params_.default_rank) {
+        task_ranks_[sdi] = static_cast<int>(task_perms_[sdi].size());
+      }
+      task_perms_[sdi].push_back(di);
+    }
+    CHECK_GE(task_ranks_[sdi], 0);
+  }
+  // Subdivisions of the leader ring all use the same order, but still
+  // move their chunks concurrently.
+  leader_perms_.assign(num_subdivs_, leaders);
+  leader_ranks_.clear();
+  if (task_leader_ == col_params_.default_rank) {
+    for (int r = 0; r < leaders.size(); ++r) {
+      if (leaders[r] == col_params_.default_rank) {
+        leader_ranks_.assign(num_subdivs_, r);
+        break;
+      }
+    }
+  }
+  VLOG(1) << this << " hierarchical reduction: " << leaders.size()
+          << " tasks, " << task_perms_[0].size() << " devices in task "
+          << task_name << ", leader " << task_leader_;
+  return true;
+}
+
+// Note that this function is blocking and must not run in any thread
+// which cannot be blocked.
+bool RingReducer::ContinueHierarchical() {
+  // After the per-task ring every device of a task holds the task's sum.
+  if (!leader_ranks_.empty()) {
+    StartRing(kLeaderRing, leader_perms_, leader_ranks_,
+              true /*apply_final_op*/);
+    if (!RunAsyncParts()) return false;
+  }
+  ca_->ConsumeFinalValue(output_);
+  ca_.reset();
+  return BroadcastWithinTask();
+}
+
+// Note that this function is blocking and must not run in any thread
+// which cannot be blocked.
+bool RingReducer::BroadcastWithinTask() {
+  const CollInstanceParams& ip = col_params_.instance;
+  const int default_rank = col_params_.default_rank;
+  const bool is_leader = (task_leader_ == default_rank);
+  std::vector<int> peers;
+  if (is_leader) {
+    for (int di : task_perms_[0]) {
+      if (di != default_rank) peers.push_back(di);
+    }
+  } else {
+    peers.push_back(task_leader_);
+  }
+  BlockingCounter pending(static_cast<int>(peers.size()));
+  auto op_done = [this, &pending](const Status& s) {
+    if (!s.ok()) {
+      StartAbort(s);
+    }
+    pending.DecrementCount();
+  };
+  for (int di : peers) {
+    // Keyed by the receiving device, which has exactly one sender.
+    const int receiver = is_leader ? di : default_rank;
+    string buf_key =
+        RingReduceBufKey(exec_key_, kTaskBroadcast, 0 /*pass*/, 0, receiver);
+    VLOG(3) << "BroadcastWithinTask rank=" << default_rank << " key "
+            << buf_key << (is_leader ? " send to " : " recv from ")
+            << ip.device_names[di];
+    if (is_leader) {
+      col_exec_->PostToPeer(ip.device_names[di], ip.task_names[di], buf_key,
+                            device_, ctx_->op_device_context(),
+                            ctx_->output_alloc_attr(0), output_,
+                            device_locality_, op_done);
+    } else {
+      col_exec_->RecvFromPeer(ip.device_names[di], ip.task_names[di],
+                              col_params_.task.is_local[di], buf_key, device_,
+                              ctx_->op_device_context(),
+                              ctx_->output_alloc_attr(0), output_,
+                              device_locality_, 0 /*dev_to_dev_stream_index*/,
+                              op_done);
+    }
+  }
+  pending.Wait();
+  mutex_lock l(status_mu_);
+  return status_.ok();
 }
 
 void RingReducer::StartAbort(const Status& s) {
@@ -233,7 +382,7 @@ void RingReducer::StartAbort(const Status& s) {
 }
 
 void RingReducer::Finish(bool ok) {
-  if (ok) {
+  if (ok && ca_) {
     // Recover the output from the adaptor.
     ca_->ConsumeFinalValue(output_);
   }
@@ -281,27 +430,25 @@ Status RingReducer::ComputeBinOp(Device* device, OpKernel* op, Tensor* output,
 // every independent field of the tensor.
 void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
                                 int field_idx) {
-  // Note on field indexing: There are group_size_ devices in the
-  // instance, implying the same number of chunks per tensor, where a
+  // Note on field indexing: There are ring_size_ devices in the
+  // ring, implying the same number of chunks per tensor, where a
   // chunk is the unit of data transferred in a time step.  However, if
   // a device can simultaneously send data by 2 or more independent
   // channels we can speed up the transfer by subdividing chunks and
   // processing multiple subdivisions at once.  So the actual number
-  // of RingFields is group_size_ * num_subdivs_.
+  // of RingFields is ring_size_ * num_subdivs_.
   DCHECK_EQ(field_idx, (chunk_idx * num_subdivs_) + subdiv_idx);
   rf->chunk_idx = chunk_idx;
   rf->subdiv_idx = subdiv_idx;
   rf->sc_idx = field_idx;
-  rf->rank = col_params_.subdiv_rank[subdiv_idx];
+  rf->rank = ring_rank_[subdiv_idx];
   rf->second_pass = false;
   rf->action = RF_INIT;
   // Recv from the device with preceding rank within the subdivision.
-  int recv_from_rank = (rf->rank + (group_size_ - 1)) % group_size_;
-  int send_to_rank = (rf->rank + 1) % group_size_;
-  rf->recv_dev_idx = col_params_.instance.impl_details
-                         .subdiv_permutations[subdiv_idx][recv_from_rank];
-  int send_dev_idx = col_params_.instance.impl_details
-                         .subdiv_permutations[subdiv_idx][send_to_rank];
+  int recv_from_rank = (rf->rank + (ring_size_ - 1)) % ring_size_;
+  int send_to_rank = (rf->rank + 1) % ring_size_;
+  rf->recv_dev_idx = ring_perms_[subdiv_idx][recv_from_rank];
+  int send_dev_idx = ring_perms_[subdiv_idx][send_to_rank];
   rf->recv_is_remote = !col_params_.task.is_local[rf->recv_dev_idx];
   rf->send_is_remote = !col_params_.task.is_local[send_dev_idx];
   if (ca_->ChunkBytes(rf->sc_idx) > 0) {
@@ -309,10 +456,10 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
     rf->do_recv = (rf->chunk_idx != rf->rank);
     // In pass 0 we skip Send when rank = chunk_idx-1
     rf->do_send =
-        (rf->rank != ((rf->chunk_idx + (group_size_ - 1)) % group_size_));
+        (rf->rank != ((rf->chunk_idx + (ring_size_ - 1)) % ring_size_));
   }
   rf->is_final =
-      (rf->rank == ((rf->chunk_idx + (group_size_ - 1)) % group_size_));
+      (rf->rank == ((rf->chunk_idx + (ring_size_ - 1)) % ring_size_));
   if (rf->do_send || rf->do_recv) {
     rf->chunk = ca_->ChunkAlias(rf->sc_idx);
     CHECK(rf->chunk.IsAligned()) << rf->DebugString();
@@ -335,12 +482,12 @@ void RingReducer::AdvanceToSecondPass(RingField* rf) {
   if (ca_->ChunkBytes(rf->sc_idx) > 0) {
     // In pass 1 the send/no-send boundary moves down 1 place.
     rf->do_recv =
-        (rf->rank != ((rf->chunk_idx + (group_size_ - 1)) % group_size_));
+        (rf->rank != ((rf->chunk_idx + (ring_size_ - 1)) % ring_size_));
     rf->do_send =
-        (rf->rank != ((rf->chunk_idx + (group_size_ - 2)) % group_size_));
+        (rf->rank != ((rf->chunk_idx + (ring_size_ - 2)) % ring_size_));
   }
   rf->is_final =
-      (rf->rank == ((rf->chunk_idx + (group_size_ - 2)) % group_size_));
+      (rf->rank == ((rf->chunk_idx + (ring_size_ - 2)) % ring_size_));
   VLOG(3) << "IncrRingField new value " << rf->DebugString();
 }
 
@@ -358,13 +505,13 @@ string RingReducer::RingField::DebugString() const {
 void RingReducer::DispatchSend(RingField* rf, const StatusCallback& done) {
   CHECK(rf->do_send);
   string send_buf_key =
-      RingReduceBufKey(exec_key_, rf->second_pass, rf->sc_idx, rf->rank);
+      RingReduceBufKey(exec_key_, ring_phase_, rf->second_pass, rf->sc_idx,
+                       col_params_.default_rank);
   VLOG(3) << "DispatchSend rank=" << col_params_.default_rank << " send key "
           << send_buf_key << " chunk " << ca_->TBounds(rf->chunk) << " sc_idx "
           << rf->sc_idx;
-  int send_to_rank = (rf->rank + 1) % group_size_;
-  int send_to_dev_idx = col_params_.instance.impl_details
-                            .subdiv_permutations[rf->subdiv_idx][send_to_rank];
+  int send_to_rank = (rf->rank + 1) % ring_size_;
+  int send_to_dev_idx = ring_perms_[rf->subdiv_idx][send_to_rank];
   col_exec_->PostToPeer(col_params_.instance.device_names[send_to_dev_idx],
                         col_params_.instance.task_names[send_to_dev_idx],
                         send_buf_key, device_, ctx_->op_device_context(),
@@ -375,8 +522,8 @@ void RingReducer::DispatchSend(RingField* rf, const StatusCallback& done) {
 void RingReducer::DispatchRecv(RingField* rf, const StatusCallback& done) {
   CHECK(rf->do_recv);
   string recv_buf_key =
-      RingReduceBufKey(exec_key_, rf->second_pass, rf->sc_idx,
-                       (rf->rank + (group_size_ - 1)) % group_size_);
+      RingReduceBufKey(exec_key_, ring_phase_, rf->second_pass, rf->sc_idx,
+                       rf->recv_dev_idx);
   VLOG(3) << "DispatchRecv rank=" << col_params_.default_rank << " recv key "
           << recv_buf_key << " chunk " << ca_->TBounds(rf->chunk) << " into "
           << ((col_params_.merge_op != nullptr) ? "tmp_chunk" : "chunk");
@@ -410,7 +557,7 @@ bool RingReducer::RunAsyncParts() {
   // complete. Hence function local variables are accessible only by that
   // one thread and do not require an explicit mutex.
   rfv_.clear();
-  rfv_.resize(group_size_ * num_subdivs_);
+  rfv_.resize(ring_size_ * num_subdivs_);
   PCQueue ready_queue;
   int field_done_count = 0;
   int send_pending_count = 0;
@@ -419,7 +566,7 @@ bool RingReducer::RunAsyncParts() {
   field_done_count = 0;
   send_pending_count = 0;
   recv_pending_count = 0;
-  for (int chunk_idx = 0; chunk_idx < group_size_; ++chunk_idx) {
+  for (int chunk_idx = 0; chunk_idx < ring_size_; ++chunk_idx) {
     for (int subdiv_idx = 0; subdiv_idx < num_subdivs_; ++subdiv_idx) {
       int rf_index = (chunk_idx * num_subdivs_) + subdiv_idx;
       InitRingField(&rfv_[rf_index], chunk_idx, subdiv_idx, rf_index);
@@ -476,7 +623,8 @@ bool RingReducer::RunAsyncParts() {
           }
           break;
         case RF_REDUCE:
-          if (!rf->second_pass && col_params_.final_op.get() && rf->is_final) {
+          if (!rf->second_pass && ring_applies_final_op_ &&
+              col_params_.final_op.get() && rf->is_final) {
             rf->action = RF_FINALIZE;
             group_size_tensor_ready_.WaitForNotification();
             Status s = ComputeBinOp(device_, col_params_.final_op.get(),
@@ -25,6 +25,14 @@ namespace tensorflow {
 class DeviceMgr;
 
 // Ring-algorithm implementation of collective all-reduce.
+//
+// If col_params.instance.impl_details.hierarchical is set and the group
+// spans more than one task, the reduction runs in three phases: a ring
+// all-reduce among the devices of each task, a ring all-reduce across
+// tasks among one leader device per task, and a broadcast from each
+// leader back to the other devices of its task.  The per-task rings
+// follow the locality-based device order established by the param
+// resolver, so they run over the fastest intra-task links.
 class RingReducer {
  public:
   RingReducer(CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
@@ -42,6 +50,18 @@ class RingReducer {
   void StartAbort(const Status& s);
   void ContinueAfterInputCopy();
   void Finish(bool ok);
+  // Sets the ring over which RunAsyncParts operates and makes a new
+  // CollectiveAdapter with one chunk per ring member and subdivision.
+  void StartRing(int phase, const std::vector<std::vector<int>>& perms,
+                 const std::vector<int>& ranks, bool apply_final_op);
+  // Computes the per-task and leader rings of a hierarchical reduction.
+  // Returns false if the hierarchy would collapse to a single ring, i.e.
+  // if there is only one task or only one device in every task.
+  bool InitHierarchy();
+  // Runs the leader ring and the broadcast phases of a hierarchical
+  // reduction after the per-task ring has completed.
+  bool ContinueHierarchical();
+  bool BroadcastWithinTask();
   Status ComputeBinOp(Device* device, OpKernel* op, Tensor* output,
                       Tensor* input);
   bool RunAsyncParts();
@@ -140,6 +160,23 @@ class RingReducer {
   Status status_ GUARDED_BY(status_mu_);
 
   std::vector<RingField> rfv_;
+
+  // The ring currently run by RunAsyncParts.  ring_perms_ holds, for each
+  // subdivision, the default ranks of the ring members in ring order, and
+  // ring_rank_ this device's position in each of them.
+  int ring_phase_ = 0;
+  int ring_size_ = 0;
+  bool ring_applies_final_op_ = true;
+  std::vector<std::vector<int>> ring_perms_;
+  std::vector<int> ring_rank_;
+
+  // Hierarchical reduction only.
+  bool hierarchical_ = false;
+  std::vector<std::vector<int>> task_perms_;
+  std::vector<int> task_ranks_;
+  std::vector<std::vector<int>> leader_perms_;
+  std::vector<int> leader_ranks_;  // Empty if this device is not a leader.
+  int task_leader_ = -1;            // Default rank of this task's leader.
 };
 
 }  // namespace tensorflow
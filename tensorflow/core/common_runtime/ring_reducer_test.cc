@@ -202,6 +202,7 @@ class RingReducerTest : public ::testing::Test {
     col_params_.instance.impl_details.subdiv_offsets.clear();
     col_params_.instance.type = REDUCTION_COLLECTIVE;
     col_params_.instance.data_type = dtype;
+    col_params_.instance.impl_details.hierarchical = hierarchical_;
     col_params_.instance.impl_details.subdiv_permutations.resize(num_subdivs);
     col_params_.subdiv_rank.resize(num_subdivs);
     int subdiv_stride = num_devices / num_subdivs;
@@ -518,6 +519,7 @@ class RingReducerTest : public ::testing::Test {
   };
 
   bool stop_ = false;
+  bool hierarchical_ = false;
   DeviceType device_type_;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
@@ -579,6 +581,25 @@ DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
 #endif
 
+#define DEF_HIERARCHICAL_TEST(B, T, W, D, S, L)                               \
+  TEST_F(RingReducerTest,                                                     \
+         Hierarchical_DaTy##B##_Wkr##W##_Dev##D##_Sdiv##S##_Len##L) {         \
+    hierarchical_ = true;                                                     \
+    RunTest<T>(DT_##B, DEVICE_CPU, W, D, S, L, 0);                            \
+  }
+
+#ifndef GOOGLE_CUDA
+DEF_HIERARCHICAL_TEST(FLOAT, float, 2, 4, 1, 128)
+DEF_HIERARCHICAL_TEST(FLOAT, float, 2, 8, 1, 1001)
+DEF_HIERARCHICAL_TEST(FLOAT, float, 2, 8, 3, 4095)
+DEF_HIERARCHICAL_TEST(FLOAT, float, 4, 4, 4, 1045991)
+DEF_HIERARCHICAL_TEST(DOUBLE, double, 3, 2, 1, 1001)
+DEF_HIERARCHICAL_TEST(INT64, int64, 2, 8, 3, 4095)
+// Degenerate hierarchies fall back to a single ring.
+DEF_HIERARCHICAL_TEST(FLOAT, float, 1, 8, 1, 1001)
+DEF_HIERARCHICAL_TEST(FLOAT, float, 4, 1, 1, 1001)
+#endif
+
 #ifdef GOOGLE_CUDA
 // GPU tests.  So long as the device names are all in a single tasks we
 // bypass inter-worker routing code and can fake multiple GPUs with a single
@@ -0,0 +1,769 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// An executor for graphs without control flow that computes its schedule
+// once, when the executor is created, instead of on every step.
+//
+// At creation time the graph is sorted into levels: level 0 holds the nodes
+// without inputs, and every other node is placed one level after its
+// latest input. Nodes of a level are independent of each other, so each
+// level is split into at most one list of nodes per inter-op worker. Every
+// data edge is assigned a fixed slot in a flat array of tensors, and the
+// level after which each slot is no longer read is recorded so the tensor
+// can be released as early as the dynamic executor would.
+//
+// A step then allocates the slot array once and walks the plan level by
+// level. There are no pending counts, frames, iterations or per-node ready
+// queues: the only per-step synchronization is one atomic counter per
+// level.
+//
+// Graphs containing Switch, Merge, Enter, Exit or NextIteration nodes are
+// rejected; use the default executor for those.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_slice_reader_cache.h"
+
+namespace tensorflow {
+namespace {
+
+// Static information about one node of the plan.
+struct PlanNode {
+  const Node* node = nullptr;
+  OpKernel* kernel = nullptr;
+  bool kernel_is_async = false;
+  bool is_initialization_op = false;
+  int num_inputs = 0;
+  int num_outputs = 0;
+  // input_slots_[input_start + i] is the slot read by the i-th input.
+  int input_start = 0;
+  // The i-th output is written to slot output_start + i.
+  int output_start = 0;
+  gtl::InlinedVector<AllocatorAttributes, 4> output_attrs;
+};
+
+class StaticScheduleExecutor : public Executor {
+ public:
+  StaticScheduleExecutor(const LocalExecutorParams& p,
+                         std::unique_ptr<const Graph> g)
+      : params_(p),
+        graph_(std::move(g)),
+        num_workers_(port::NumSchedulableCPUs()) {
+    CHECK(p.create_kernel != nullptr);
+    CHECK(p.delete_kernel != nullptr);
+  }
+
+  ~StaticScheduleExecutor() override {
+    for (PlanNode& item : nodes_) {
+      if (item.kernel != nullptr) {
+        params_.delete_kernel(item.kernel);
+      }
+    }
+  }
+
+  Status Initialize();
+
+  void RunAsync(const Args& args, DoneCallback done) override;
+
+ private:
+  friend class StaticScheduleStep;
+
+  // Builds nodes_ in level order and fills in level_start_.
+  Status BuildLevels(std::vector<int>* node_level);
+
+  // Splits every level into at most num_workers_ node lists.
+  void BuildChunks();
+
+  // Assigns slots to edges and computes release_slots_.
+  Status BuildSlots(const std::vector<int>& node_level);
+
+  int num_levels() const { return static_cast<int>(level_start_.size()) - 1; }
+
+  // Owned.
+  LocalExecutorParams params_;
+  std::unique_ptr<const Graph> graph_;
+  const int num_workers_;
+
+  // All op nodes, sorted by level. Nodes of level l are
+  // nodes_[level_start_[l], level_start_[l + 1]).
+  std::vector<PlanNode> nodes_;
+  std::vector<int> level_start_;
+
+  // The nodes of chunk c are chunk_nodes_[chunk_start_[c],
+  // chunk_start_[c + 1]), as indices into nodes_. The chunks of level l are
+  // [level_chunk_start_[l], level_chunk_start_[l + 1]).
+  std::vector<int> chunk_nodes_;
+  std::vector<int> chunk_start_;
+  std::vector<int> level_chunk_start_;
+
+  // Slot read by each input of each node; see PlanNode::input_start.
+  std::vector<int> input_slots_;
+  int num_slots_ = 0;
+
+  // Slots whose last reader is in level l, flattened like chunk_nodes_.
+  std::vector<int> release_slots_;
+  std::vector<int> release_start_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticScheduleExecutor);
+};
+
+Status StaticScheduleExecutor::Initialize() {
+  if (params_.device->RequiresRecordingAccessedTensors()) {
+    return errors::Unimplemented(
+        "The static schedule executor does not support devices that record "
+        "accessed tensors: ",
+        params_.device->name());
+  }
+  std::vector<int> node_level;
+  TF_RETURN_IF_ERROR(BuildLevels(&node_level));
+  BuildChunks();
+  return BuildSlots(node_level);
+}
+
+Status StaticScheduleExecutor::BuildLevels(std::vector<int>* node_level) {
+  const Graph* g = graph_.get();
+  node_level->assign(g->num_node_ids(), -1);
+  std::vector<int> pending(g->num_node_ids(), 0);
+  std::vector<const Node*> ready;
+  int num_op_nodes = 0;
+  for (const Node* n : g->nodes()) {
+    if (!n->IsOp()) continue;
+    if (IsControlFlow(n)) {
+      return errors::InvalidArgument(
+          "The static schedule executor does not support control flow, but "
+          "the graph contains ",
+          SummarizeNode(*n));
+    }
+    ++num_op_nodes;
+    for (const Edge* e : n->in_edges()) {
+      if (e->src()->IsOp()) ++pending[n->id()];
+    }
+    if (pending[n->id()] == 0) {
+      (*node_level)[n->id()] = 0;
+      ready.push_back(n);
+    }
+  }
+
+  // Kahn's algorithm; a node's level is one more than that of its latest
+  // input.
+  std::vector<const Node*> order;
+  order.reserve(num_op_nodes);
+  int max_level = -1;
+  while (!ready.empty()) {
+    const Node* n = ready.back();
+    ready.pop_back();
+    order.push_back(n);
+    const int level = (*node_level)[n->id()];
+    max_level = std::max(max_level, level);
+    for (const Edge* e : n->out_edges()) {
+      const Node* dst = e->dst();
+      if (!dst->IsOp()) continue;
+      (*node_level)[dst->id()] = std::max((*node_level)[dst->id()], level + 1);
+      if (--pending[dst->id()] == 0) ready.push_back(dst);
+    }
+  }
+  if (order.size() != num_op_nodes) {
+    return errors::InvalidArgument(
+        "The static schedule executor requires an acyclic graph");
+  }
+
+  std::stable_sort(order.begin(), order.end(),
+                   [node_level](const Node* a, const Node* b) {
+                     return (*node_level)[a->id()] < (*node_level)[b->id()];
+                   });
+  nodes_.resize(order.size());
+  level_start_.assign(max_level + 2, 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    const Node* n = order[i];
+    PlanNode* item = &nodes_[i];
+    item->node = n;
+    Status s = params_.create_kernel(n->def(), &item->kernel);
+    if (!s.ok()) {
+      item->kernel = nullptr;
+      s = AttachDef(s, *n);
+      LOG(ERROR) << "Executor failed to create kernel. " << s;
+      return s;
+    }
+    CHECK(item->kernel);
+    item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
+    item->is_initialization_op = n->op_def().allows_uninitialized_input();
+    item->num_inputs = n->num_inputs();
+    item->num_outputs = n->num_outputs();
+    ++level_start_[(*node_level)[n->id()] + 1];
+  }
+  for (size_t l = 1; l < level_start_.size(); ++l) {
+    level_start_[l] += level_start_[l - 1];
+  }
+  return Status::OK();
+}
+
+void StaticScheduleExecutor::BuildChunks() {
+  level_chunk_start_.push_back(0);
+  chunk_start_.push_back(0);
+  for (int l = 0; l < num_levels(); ++l) {
+    const int begin = level_start_[l];
+    const int end = level_start_[l + 1];
+    // Inexpensive nodes are not worth a closure each: run them all in the
+    // first chunk, and give every expensive node after the first a chunk of
+    // its own up to the number of workers.
+    int num_expensive = 0;
+    for (int i = begin; i < end; ++i) {
+      if (nodes_[i].kernel->IsExpensive()) ++num_expensive;
+    }
+    const int num_chunks = std::max(1, std::min(num_workers_, num_expensive));
+    std::vector<std::vector<int>> chunks(num_chunks);
+    int next_expensive = 0;
+    for (int i = begin; i < end; ++i) {
+      if (nodes_[i].kernel->IsExpensive()) {
+        chunks[next_expensive++ % num_chunks].push_back(i);
+      } else {
+        chunks[0].push_back(i);
+      }
+    }
+    for (const auto& chunk : chunks) {
+      chunk_nodes_.insert(chunk_nodes_.end(), chunk.begin(), chunk.end());
+      chunk_start_.push_back(chunk_nodes_.size());
+    }
+    level_chunk_start_.push_back(chunk_start_.size() - 1);
+  }
+}
+
+Status StaticScheduleExecutor::BuildSlots(const std::vector<int>& node_level) {
+  const Graph* g = graph_.get();
+  DeviceNameUtils::ParsedName local_dev_name = params_.device->parsed_name();
+  std::vector<int> output_start(g->num_node_ids(), -1);
+  for (PlanNode& item : nodes_) {
+    item.output_start = num_slots_;
+    output_start[item.node->id()] = num_slots_;
+    num_slots_ += item.num_outputs;
+  }
+
+  // The last level that reads each slot. Slots that are never read are
+  // released after the level that produces them.
+  std::vector<int> last_use(num_slots_, 0);
+  for (const PlanNode& item : nodes_) {
+    for (int i = 0; i < item.num_outputs; ++i) {
+      last_use[item.output_start + i] = node_level[item.node->id()];
+    }
+  }
+
+  for (PlanNode& item : nodes_) {
+    const Node* n = item.node;
+    item.input_start = input_slots_.size();
+    input_slots_.resize(input_slots_.size() + item.num_inputs, -1);
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      const int slot = output_start[e->src()->id()] + e->src_output();
+      input_slots_[item.input_start + e->dst_input()] = slot;
+      last_use[slot] = std::max(last_use[slot], node_level[n->id()]);
+    }
+    for (int i = 0; i < item.num_inputs; ++i) {
+      if (input_slots_[item.input_start + i] < 0) {
+        return errors::InvalidArgument("Input ", i, " of ", SummarizeNode(*n),
+                                       " is not connected");
+      }
+    }
+
+    // Same allocator attributes as the default executor.
+    item.output_attrs.resize(item.num_outputs);
+    for (const Edge* e : n->out_edges()) {
+      if (e->IsControlEdge()) continue;
+      AllocatorAttributes attr;
+      TF_RETURN_IF_ERROR(InferAllocAttr(n, e->dst(), local_dev_name, &attr));
+      item.output_attrs[e->src_output()].Merge(attr);
+    }
+    for (int i = 0; i < item.num_outputs; ++i) {
+      if (item.kernel->output_memory_types()[i] == HOST_MEMORY) {
+        AllocatorAttributes h;
+        h.set_on_host(true);
+        item.output_attrs[i].Merge(h);
+      }
+    }
+  }
+
+  std::vector<std::vector<int>> release(num_levels());
+  for (int slot = 0; slot < num_slots_; ++slot) {
+    release[last_use[slot]].push_back(slot);
+  }
+  release_start_.push_back(0);
+  for (const auto& slots : release) {
+    release_slots_.insert(release_slots_.end(), slots.begin(), slots.end());
+    release_start_.push_back(release_slots_.size());
+  }
+  return Status::OK();
+}
+
+// The state associated with one invocation of
+// StaticScheduleExecutor::RunAsync. Deletes itself once the step is done.
+class StaticScheduleStep {
+ public:
+  StaticScheduleStep(const Executor::Args& args,
+                     const StaticScheduleExecutor* impl)
+      : step_id_(args.step_id),
+        rendezvous_(args.rendezvous),
+        collective_executor_(args.collective_executor),
+        session_state_(args.session_state),
+        tensor_store_(args.tensor_store),
+        step_container_(args.step_container),
+        stats_collector_(args.stats_collector),
+        call_frame_(args.call_frame),
+        cancellation_manager_(args.cancellation_manager),
+        runner_(args.runner),
+        sync_on_finish_(args.sync_on_finish),
+        impl_(impl),
+        slots_(new Slot[impl->num_slots_]) {}
+
+  ~StaticScheduleStep() {
+    for (auto it : device_context_map_) {
+      it->Unref();
+    }
+  }
+
+  void RunAsync(Executor::DoneCallback done);
+
+ private:
+  // The value of one output of one node.
+  struct Slot {
+    Tensor val;
+    Tensor* ref = nullptr;    // A tensor reference.
+    mutex* ref_mu = nullptr;  // mutex for *ref if ref is not nullptr.
+    bool has_value = false;
+    AllocatorAttributes alloc_attr;
+    DeviceContext* device_context = nullptr;
+  };
+
+  // State kept alive while an asynchronous kernel runs; see
+  // ExecutorState::AsyncState for why the inputs are copied.
+  struct AsyncState;
+
+  // Runs levels starting at "level" until one of them completes on
+  // another thread, or all levels have run.
+  void RunLevels(int level);
+
+  // Runs the nodes of chunk "chunk" of level "level" on the current thread.
+  // Returns true if this thread completed the last node of the level.
+  bool RunChunk(int level, int chunk);
+
+  // Runs one node. Returns true if it was the last node of its level to
+  // complete.
+  bool RunNode(int node_index, int level);
+
+  // Called on the thread that completed a level, other than the thread
+  // running RunLevels().
+  void LevelDone(int level);
+
+  // Gathers the inputs of "item". "deref_storage" holds copies of refs
+  // passed to inputs that are not of ref type; it is only allocated when
+  // needed, and moving it keeps the input pointers valid.
+  Status PrepareInputs(const PlanNode& item,
+                       gtl::InlinedVector<TensorValue, 4>* inputs,
+                       gtl::InlinedVector<DeviceContext*, 4>* device_contexts,
+                       gtl::InlinedVector<AllocatorAttributes, 4>* alloc_attrs,
+                       std::vector<Tensor>* deref_storage);
+
+  // Moves the outputs of "ctx" into the slots of "item".
+  Status ProcessOutputs(const PlanNode& item, OpKernelContext* ctx);
+
+  // Records the result of a node. Returns true if it was the last node of
+  // "level" to complete.
+  bool NodeDone(const Status& s, int level);
+
+  void FillParams(const PlanNode& item, OpKernelContext::Params* params);
+
+  void Finish();
+
+  const int64 step_id_;
+  Rendezvous* rendezvous_;
+  CollectiveExecutor* collective_executor_;
+  SessionState* session_state_;
+  TensorStore* tensor_store_;
+  ScopedStepContainer* step_container_;
+  StepStatsCollector* stats_collector_;
+  CallFrameInterface* call_frame_;
+  CancellationManager* cancellation_manager_;
+  Executor::Args::Runner runner_;
+  const bool sync_on_finish_;
+  const StaticScheduleExecutor* impl_;
+
+  checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache_;
+  DeviceContextMap device_context_map_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Nodes of the current level that have not completed.
+  std::atomic<int> pending_{0};
+  std::atomic<bool> aborted_{false};
+
+  Executor::DoneCallback done_cb_;
+
+  mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticScheduleStep);
+};
+
+struct StaticScheduleStep::AsyncState {
+  AsyncState(const OpKernelContext::Params& p, const PlanNode* _item,
+             int _level)
+      : saved_inputs(*p.inputs),
+        saved_input_device_contexts(*p.input_device_contexts),
+        saved_input_alloc_attrs(*p.input_alloc_attrs),
+        params(p),
+        item(_item),
+        level(_level),
+        ctx(ParamsButClearingEigenGPUDevice(&params), item->num_outputs) {
+    params.inputs = &saved_inputs;
+    params.input_device_contexts = &saved_input_device_contexts;
+    params.input_alloc_attrs = &saved_input_alloc_attrs;
+  }
+
+  std::vector<Tensor> deref_storage;
+  gtl::InlinedVector<TensorValue, 4> saved_inputs;
+  gtl::InlinedVector<DeviceContext*, 4> saved_input_device_contexts;
+  gtl::InlinedVector<AllocatorAttributes, 4> saved_input_alloc_attrs;
+  OpKernelContext::Params params;
+  const PlanNode* item;
+  const int level;
+  OpKernelContext ctx;
+
+ private:
+  OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
+      OpKernelContext::Params* p) {
+    // Ensure OpKernelContext constructor will make a new eigen GPU device if
+    // necessary.
+    p->eigen_gpu_device = nullptr;  // Force allocation
+    return p;
+  }
+};
+
+void StaticScheduleStep::RunAsync(Executor::DoneCallback done) {
+  Device* device = impl_->params_.device;
+  const Status fill_status =
+      device->FillContextMap(impl_->graph_.get(), &device_context_map_);
+  if (!fill_status.ok()) {
+    delete this;
+    done(fill_status);
+    return;
+  }
+  if (impl_->num_levels() == 0) {
+    delete this;
+    done(Status::OK());
+    return;
+  }
+  done_cb_ = std::move(done);
+  RunLevels(0);
+}
+
+void StaticScheduleStep::RunLevels(int level) {
+  const int num_levels = impl_->num_levels();
+  for (; level < num_levels && !aborted_; ++level) {
+    pending_ = impl_->level_start_[level + 1] - impl_->level_start_[level];
+    const int first_chunk = impl_->level_chunk_start_[level];
+    const int end_chunk = impl_->level_chunk_start_[level + 1];
+    for (int c = first_chunk + 1; c < end_chunk; ++c) {
+      runner_([this, level, c]() {
+        if (RunChunk(level, c)) LevelDone(level);
+      });
+    }
+    if (!RunChunk(level, first_chunk)) {
+      // Another thread completes this level and continues from there.
+      return;
+    }
+    for (int i = impl_->release_start_[level];
+         i < impl_->release_start_[level + 1]; ++i) {
+      slots_[impl_->release_slots_[i]] = Slot();
+    }
+  }
+  Finish();
+}
+
+void StaticScheduleStep::LevelDone(int level) {
+  for (int i = impl_->release_start_[level];
+       i < impl_->release_start_[level + 1]; ++i) {
+    slots_[impl_->release_slots_[i]] = Slot();
+  }
+  RunLevels(level + 1);
+}
+
+bool StaticScheduleStep::RunChunk(int level, int chunk) {
+  // An asynchronous node may complete the level, and with it the step,
+  // before RunNode() returns, so only the executor is used past that point.
+  const StaticScheduleExecutor* impl = impl_;
+  const int end = impl->chunk_start_[chunk + 1];
+  bool level_done = false;
+  for (int i = impl->chunk_start_[chunk]; i < end; ++i) {
+    level_done = RunNode(impl->chunk_nodes_[i], level);
+  }
+  return level_done;
+}
+
+void StaticScheduleStep::FillParams(const PlanNode& item,
+                                    OpKernelContext::Params* params) {
+  Device* device = impl_->params_.device;
+  params->step_id = step_id_;
+  params->device = device;
+  params->rendezvous = rendezvous_;
+  params->collective_executor = collective_executor_;
+  params->session_state = session_state_;
+  params->tensor_store = tensor_store_;
+  params->cancellation_manager = cancellation_manager_;
+  params->call_frame = call_frame_;
+  params->function_library = impl_->params_.function_library;
+  params->resource_manager = device->resource_manager();
+  params->step_container = step_container_;
+  params->slice_reader_cache = &slice_reader_cache_;
+  params->runner = &runner_;
+  params->stats_collector = stats_collector_;
+  params->op_kernel = item.kernel;
+  params->frame_iter = FrameAndIter(0, 0);
+  params->output_attr_array = item.output_attrs.data();
+  const int id = item.node->id();
+  if (id < device_context_map_.size()) {
+    params->op_device_context = device_context_map_[id];
+  }
+}
+
+bool StaticScheduleStep::RunNode(int node_index, int level) {
+  const PlanNode& item = impl_->nodes_[node_index];
+  if (aborted_) return NodeDone(Status::OK(), level);
+
+  gtl::InlinedVector<TensorValue, 4> inputs;
+  gtl::InlinedVector<DeviceContext*, 4> input_device_contexts;
+  gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs;
+  std::vector<Tensor> deref_storage;
+  Status s = PrepareInputs(item, &inputs, &input_device_contexts,
+                           &input_alloc_attrs, &deref_storage);
+  if (!s.ok()) return NodeDone(s, level);
+
+  OpKernelContext::Params params;
+  FillParams(item, &params);
+  params.inputs = &inputs;
+  params.input_device_contexts = &input_device_contexts;
+  params.input_alloc_attrs = &input_alloc_attrs;
+
+  Device* device = impl_->params_.device;
+  if (item.kernel_is_async) {
+    AsyncOpKernel* async = item.kernel->AsAsync();
+    AsyncState* state = new AsyncState(params, &item, level);
+    // The copied inputs may point into "deref_storage", so keep it alive
+    // with the rest of the state.
+    state->deref_storage = std::move(deref_storage);
+    auto done = [this, state]() {
+      const Status s = ProcessOutputs(*state->item, &state->ctx);
+      const int level = state->level;
+      delete state;
+      if (NodeDone(s, level)) LevelDone(level);
+    };
+    device->ComputeAsync(async, &state->ctx, done);
+    // The level is completed by "done", which may already have run.
+    return false;
+  }
+
+  OpKernelContext ctx(&params, item.num_outputs);
+  device->Compute(item.kernel, &ctx);
+  return NodeDone(ProcessOutputs(item, &ctx), level);
+}
+
+Status StaticScheduleStep::PrepareInputs(
+    const PlanNode& item, gtl::InlinedVector<TensorValue, 4>* inputs,
+    gtl::InlinedVector<DeviceContext*, 4>* device_contexts,
+    gtl::InlinedVector<AllocatorAttributes, 4>* alloc_attrs,
+    std::vector<Tensor>* deref_storage) {
+  inputs->resize(item.num_inputs);
+  device_contexts->resize(item.num_inputs);
+  alloc_attrs->resize(item.num_inputs);
+  for (int i = 0; i < item.num_inputs; ++i) {
+    Slot* slot = &slots_[impl_->input_slots_[item.input_start + i]];
+    (*device_contexts)[i] = slot->device_context;
+    (*alloc_attrs)[i] = slot->alloc_attr;
+    TensorValue* inp = &(*inputs)[i];
+    const bool expect_ref = IsRefType(item.kernel->input_type(i));
+    if (!slot->has_value) {
+      return AttachDef(errors::Internal("Input ", i, " has no value"),
+                       item.kernel->def());
+    }
+    if (slot->ref == nullptr) {
+      if (expect_ref) {
+        return AttachDef(
+            errors::InvalidArgument(i, "-th input expects a ref type"),
+            item.kernel->def());
+      }
+      inp->tensor = &slot->val;
+      continue;
+    }
+    {
+      mutex_lock ml(*slot->ref_mu);
+      if (!slot->ref->IsInitialized() && !item.is_initialization_op) {
+        return AttachDef(errors::FailedPrecondition(
+                             "Attempting to use uninitialized value ",
+                             item.kernel->requested_input(i)),
+                         item.kernel->def());
+      }
+      if (!expect_ref) {
+        // Dereference under the mutex. Other readers of the same slot may
+        // run concurrently, so the copy is kept per node instead of
+        // replacing the slot.
+        if (deref_storage->empty()) deref_storage->resize(item.num_inputs);
+        (*deref_storage)[i] = *slot->ref;
+      }
+    }
+    if (expect_ref) {
+      inp->mutex_if_ref = slot->ref_mu;
+      inp->tensor = slot->ref;
+    } else {
+      inp->tensor = &(*deref_storage)[i];
+      if (item.kernel->input_type(i) != inp->tensor->dtype()) {
+        return AttachDef(
+            errors::InvalidArgument(
+                i, "-th input expects type ",
+                DataTypeString(item.kernel->input_type(i)),
+                " but automatically dereferenced input tensor has type ",
+                DataTypeString(inp->tensor->dtype())),
+            item.kernel->def());
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status StaticScheduleStep::ProcessOutputs(const PlanNode& item,
+                                          OpKernelContext* ctx) {
+  Status s = ctx->status();
+  if (!s.ok()) {
+    return AttachDef(s, item.kernel->def());
+  }
+  const Node* node = item.node;
+  for (int i = 0; i < item.num_outputs; ++i) {
+    const TensorValue val = ctx->release_output(i);
+    if (val.tensor == nullptr) {
+      s.Update(errors::Internal("Missing ", i, "-th output from ",
+                                SummarizeNode(*node)));
+      continue;
+    }
+    Slot* out = &slots_[item.output_start + i];
+    out->device_context = ctx->op_device_context();
+    out->alloc_attr = ctx->output_alloc_attr(i);
+    DataType dtype;
+    if (val.is_ref()) {
+      mutex_lock ml(*val.mutex_if_ref);
+      dtype = MakeRefType(val->dtype());
+    } else {
+      dtype = val->dtype();
+    }
+    if (dtype != item.kernel->output_type(i)) {
+      s.Update(errors::Internal("Output ", i, " of type ",
+                                DataTypeString(dtype),
+                                " does not match declared output type ",
+                                DataTypeString(item.kernel->output_type(i)),
+                                " for node ", SummarizeNode(*node)));
+    } else if (val.is_ref()) {
+      out->ref = val.tensor;
+      out->ref_mu = val.mutex_if_ref;
+      out->has_value = true;
+    } else {
+      out->val = std::move(*val.tensor);
+      out->has_value = true;
+    }
+    if (!val.is_ref()) {
+      delete val.tensor;
+    }
+  }
+  return s;
+}
+
+bool StaticScheduleStep::NodeDone(const Status& s, int level) {
+  if (!s.ok()) {
+    bool abort_run = false;
+    {
+      mutex_lock l(mu_);
+      if (status_.ok()) {
+        abort_run = true;
+        status_ = s;
+      }
+    }
+    if (abort_run) {
+      aborted_ = true;
+      if (rendezvous_) {
+        rendezvous_->StartAbort(s);
+      }
+      if (collective_executor_) {
+        collective_executor_->StartAbort(s);
+      }
+      if (cancellation_manager_) {
+        cancellation_manager_->StartCancel();
+      }
+    }
+  }
+  return pending_.fetch_sub(1) == 1;
+}
+
+void StaticScheduleStep::Finish() {
+  mu_.lock();
+  auto status = status_;
+  auto done_cb = std::move(done_cb_);
+  auto runner = std::move(runner_);
+  mu_.unlock();
+  if (sync_on_finish_ && status.ok()) {
+    // Block until the device has finished all queued operations, as the
+    // default executor does.
+    status = impl_->params_.device->Sync();
+  }
+  delete this;
+  CHECK(done_cb != nullptr);
+  runner([=]() { done_cb(status); });
+}
+
+void StaticScheduleExecutor::RunAsync(const Args& args, DoneCallback done) {
+  (new StaticScheduleStep(args, this))->RunAsync(std::move(done));
+}
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register("STATIC_SCHEDULE", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      std::unique_ptr<StaticScheduleExecutor> ret(
+          new StaticScheduleExecutor(params, std::move(graph)));
+      TF_RETURN_IF_ERROR(ret->Initialize());
+      out_executor->reset(ret.release());
+      return Status::OK();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base, size_t block_size,
+                                       size_t max_arena_bytes)
+    : base_(base),
+      max_arena_allocation_(block_size / 4),
+      max_arena_bytes_(max_arena_bytes),
+      arena_(block_size) {
+  CHECK(base_ != nullptr);
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  mutex_lock l(mu_);
+  void* ptr = nullptr;
+  if (num_bytes <= max_arena_allocation_ &&
+      arena_bytes_ + num_bytes <= max_arena_bytes_) {
+    // Arena::AllocAligned() returns nullptr for empty requests, which
+    // Allocator callers treat as an allocation failure.
+    ptr = arena_.AllocAligned(std::max<size_t>(num_bytes, 1), alignment);
+    arena_bytes_ += num_bytes;
+    stats_.bytes_in_use = arena_bytes_;
+    stats_.max_bytes_in_use = arena_bytes_;
+  } else {
+    ptr = base_->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) return nullptr;
+    base_allocations_.insert(ptr);
+  }
+  ++num_live_allocations_;
+  ++stats_.num_allocs;
+  stats_.max_alloc_size =
+      std::max<int64>(stats_.max_alloc_size, static_cast<int64>(num_bytes));
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    auto it = base_allocations_.find(ptr);
+    if (it != base_allocations_.end()) {
+      base_allocations_.erase(it);
+      base_->DeallocateRaw(ptr);
+    }
+    // Arena memory is reclaimed all at once when this allocator is deleted.
+    DCHECK_GT(num_live_allocations_, 0);
+    --num_live_allocations_;
+    delete_self = step_done_ && num_live_allocations_ == 0;
+  }
+  if (delete_self) delete this;
+}
+
+void StepArenaAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock l(mu_);
+  *stats = stats_;
+}
+
+void StepArenaAllocator::StepDone() {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!step_done_);
+    step_done_ = true;
+    delete_self = num_live_allocations_ == 0;
+    if (!delete_self) {
+      VLOG(1) << num_live_allocations_
+              << " tensors outlive their step; keeping its arena of "
+              << arena_bytes_ << " bytes alive";
+    }
+  }
+  if (delete_self) delete this;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/arena.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An Allocator for tensors that live no longer than one executor step.
+//
+// Small allocations are carved out of a core::Arena, so a step makes one
+// malloc per arena block instead of one malloc/free pair per tensor, and
+// DeallocateRaw() of an arena allocation is only a counter decrement.
+// Allocations larger than a quarter of the block size, and all
+// allocations once the arena has grown to "max_arena_bytes", are
+// forwarded to "base".
+//
+// A tensor can escape the step even when the executor does not expect it
+// to, e.g. by being forwarded into a variable or the session state. The
+// allocator therefore owns itself: the executor calls StepDone() when the
+// step finishes, and the allocator (with its arena) is deleted once that
+// has happened and every allocation made from it has been deallocated.
+// An escaped tensor keeps the arena of its step alive, but never dangles.
+//
+// Thread-safe.
+class StepArenaAllocator : public Allocator {
+ public:
+  StepArenaAllocator(Allocator* base, size_t block_size,
+                     size_t max_arena_bytes);
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+
+  // Called once by the owning step when it finishes. May delete "this".
+  void StepDone() LOCKS_EXCLUDED(mu_);
+
+ private:
+  ~StepArenaAllocator() override {}
+
+  Allocator* const base_;
+  const size_t max_arena_allocation_;
+  const size_t max_arena_bytes_;
+
+  mutex mu_;
+  core::Arena arena_ GUARDED_BY(mu_);
+  // Allocations that were forwarded to base_.
+  gtl::FlatSet<void*> base_allocations_ GUARDED_BY(mu_);
+  int64 num_live_allocations_ GUARDED_BY(mu_) = 0;
+  bool step_done_ GUARDED_BY(mu_) = false;
+  // Bytes handed out by arena_; arena memory is only reclaimed on deletion.
+  int64 arena_bytes_ GUARDED_BY(mu_) = 0;
+  AllocatorStats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,100 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Counts the allocations that reach the base allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_live;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_live;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  int num_live = 0;
+};
+
+TEST(StepArenaAllocatorTest, SmallAllocationsUseArena) {
+  CountingAllocator base;
+  StepArenaAllocator* a = new StepArenaAllocator(&base, 4096, 1 << 20);
+  void* small = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* empty = a->AllocateRaw(Allocator::kAllocatorAlignment, 0);
+  ASSERT_NE(nullptr, small);
+  ASSERT_NE(nullptr, empty);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(small) %
+                   Allocator::kAllocatorAlignment);
+  EXPECT_EQ(0, base.num_live);
+
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(1, base.num_live);
+
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(3, stats.num_allocs);
+  EXPECT_EQ(64, stats.bytes_in_use);
+  EXPECT_EQ(2048, stats.max_alloc_size);
+
+  a->DeallocateRaw(large);
+  EXPECT_EQ(0, base.num_live);
+  a->DeallocateRaw(small);
+  a->DeallocateRaw(empty);
+  a->StepDone();
+}
+
+TEST(StepArenaAllocatorTest, ArenaSizeIsCapped) {
+  CountingAllocator base;
+  StepArenaAllocator* a = new StepArenaAllocator(&base, 4096, 1024);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 512));
+  }
+  // The first two fit in the arena, the rest are forwarded.
+  EXPECT_EQ(2, base.num_live);
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  EXPECT_EQ(0, base.num_live);
+  a->StepDone();
+}
+
+TEST(StepArenaAllocatorTest, TensorOutlivesStep) {
+  CountingAllocator base;
+  StepArenaAllocator* a = new StepArenaAllocator(&base, 4096, 1 << 20);
+  Tensor small(a, DT_FLOAT, TensorShape({16}));
+  Tensor large(a, DT_FLOAT, TensorShape({1024}));
+  small.flat<float>().setConstant(1.0f);
+  EXPECT_EQ(1, base.num_live);
+
+  a->StepDone();
+  // Both tensors remain usable after the step, and the allocator is
+  // deleted with the last of them.
+  EXPECT_EQ(1.0f, small.flat<float>()(15));
+  large = Tensor();
+  EXPECT_EQ(0, base.num_live);
+  small = Tensor();
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -63,6 +63,7 @@ void NodeExecStatsWrapper::Finalize() {
       auto* r = memory->add_allocation_records();
       r->set_alloc_bytes(record.alloc_bytes);
       r->set_alloc_micros(record.alloc_micros);
+      r->set_allocation_id(record.allocation_id);
     }
   }
   allocations_.clear();
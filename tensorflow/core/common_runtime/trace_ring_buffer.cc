@@ -0,0 +1,140 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/trace_ring_buffer.h"
+
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+
+constexpr int TraceRingBuffer::kEventsPerThread;
+constexpr int TraceRingBuffer::kMaxNodeNameLength;
+constexpr int64 TraceRingBuffer::kAllSteps;
+
+// Returns the ring of a thread to the free list when the thread exits.
+class TraceRingBuffer::ThreadBufferHolder {
+ public:
+  ThreadBufferHolder() {}
+  ~ThreadBufferHolder() {
+    if (buffer != nullptr) Global()->ReleaseBuffer(buffer);
+  }
+
+  ThreadBuffer* buffer = nullptr;
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(ThreadBufferHolder);
+};
+
+/* static */
+TraceRingBuffer* TraceRingBuffer::Global() {
+  static TraceRingBuffer* global = new TraceRingBuffer;
+  return global;
+}
+
+int32 TraceRingBuffer::InternDevice(const string& device) {
+  mutex_lock l(mu_);
+  for (size_t i = 0; i < devices_.size(); ++i) {
+    if (devices_[i] == device) return i;
+  }
+  devices_.push_back(device);
+  return devices_.size() - 1;
+}
+
+TraceRingBuffer::ThreadBuffer* TraceRingBuffer::GetThreadBuffer() {
+  static thread_local ThreadBufferHolder holder;
+  if (holder.buffer == nullptr) holder.buffer = AcquireBuffer();
+  return holder.buffer;
+}
+
+TraceRingBuffer::ThreadBuffer* TraceRingBuffer::AcquireBuffer() {
+  mutex_lock l(mu_);
+  if (!free_buffers_.empty()) {
+    ThreadBuffer* buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer;
+  }
+  ThreadBuffer* buffer = new ThreadBuffer;
+  buffer->index = buffers_.size();
+  buffers_.push_back(buffer);
+  return buffer;
+}
+
+void TraceRingBuffer::ReleaseBuffer(ThreadBuffer* buffer) {
+  mutex_lock l(mu_);
+  free_buffers_.push_back(buffer);
+}
+
+void TraceRingBuffer::Record(int32 device_id, int64 step_id,
+                             StringPiece node_name, int64 start_micros,
+                             int64 end_micros) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  // Only this thread writes to "buffer", so a relaxed load is enough.
+  const uint64 n = buffer->num_events.load(std::memory_order_relaxed);
+  Event* event = &buffer->events[n % kEventsPerThread];
+  event->step_id = step_id;
+  event->start_micros = start_micros;
+  event->duration_micros = end_micros - start_micros;
+  event->device_id = device_id;
+  const size_t length =
+      std::min<size_t>(node_name.size(), kMaxNodeNameLength);
+  memcpy(event->node_name, node_name.data(), length);
+  event->node_name[length] = '\0';
+  // Publishes the event to Dump().
+  buffer->num_events.store(n + 1, std::memory_order_release);
+}
+
+void TraceRingBuffer::Dump(int64 step_id, StepStats* step_stats) {
+  mutex_lock l(mu_);
+  std::unordered_map<int32, DeviceStepStats*> device_stats;
+  std::vector<Event> events;
+  for (ThreadBuffer* buffer : buffers_) {
+    const uint64 end = buffer->num_events.load(std::memory_order_acquire);
+    const uint64 begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+    events.clear();
+    for (uint64 i = begin; i < end; ++i) {
+      events.push_back(buffer->events[i % kEventsPerThread]);
+    }
+    // The owning thread keeps recording while the events are copied. Drop
+    // the copies of slots it may have rewritten in the meantime, including
+    // the one it may be writing now.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64 now_end = buffer->num_events.load(std::memory_order_relaxed);
+    const uint64 valid_begin =
+        now_end + 1 > kEventsPerThread ? now_end + 1 - kEventsPerThread : 0;
+    for (uint64 i = std::max(begin, valid_begin); i < end; ++i) {
+      const Event& event = events[i - begin];
+      if (step_id != kAllSteps && event.step_id != step_id) continue;
+      if (event.device_id < 0 || event.device_id >= devices_.size()) continue;
+      DeviceStepStats*& dev_stats = device_stats[event.device_id];
+      if (dev_stats == nullptr) {
+        dev_stats = step_stats->add_dev_stats();
+        dev_stats->set_device(devices_[event.device_id]);
+      }
+      NodeExecStats* node_stats = dev_stats->add_node_stats();
+      node_stats->set_node_name(event.node_name);
+      node_stats->set_all_start_micros(event.start_micros);
+      node_stats->set_op_start_rel_micros(0);
+      node_stats->set_op_end_rel_micros(event.duration_micros);
+      node_stats->set_all_end_rel_micros(event.duration_micros);
+      node_stats->set_thread_id(buffer->index);
+    }
+  }
+}
+
+}  // namespace tensorflow
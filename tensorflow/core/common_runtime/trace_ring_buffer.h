@@ -0,0 +1,112 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_TRACE_RING_BUFFER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_TRACE_RING_BUFFER_H_
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StepStats;
+
+// TraceRingBuffer keeps the most recent node executions of every thread,
+// so that the timeline of a slow step can be recovered after the fact
+// without paying for a StepStatsCollector on every step.
+//
+// Each thread records into its own fixed-size ring of compact events, so
+// Record() takes no locks and allocates nothing once the thread's ring
+// exists. When a ring is full the oldest events are overwritten.
+//
+//    const int32 device = TraceRingBuffer::Global()->InternDevice(name);
+//    TraceRingBuffer::Global()->Record(device, step_id, node->name(),
+//                                      start_micros, end_micros);
+//    ...
+//    StepStats step_stats;
+//    TraceRingBuffer::Global()->Dump(step_id, &step_stats);
+//
+// Dump() produces the StepStats format that RunMetadata carries, so the
+// result can be fed to the timeline and tfprof tools.
+class TraceRingBuffer {
+ public:
+  // Number of events kept per thread.
+  static constexpr int kEventsPerThread = 4096;
+  // Node names are truncated to this many characters.
+  static constexpr int kMaxNodeNameLength = 39;
+  // Passed to Dump() to dump the events of every step.
+  static constexpr int64 kAllSteps = -1;
+
+  static TraceRingBuffer* Global();
+
+  // Returns the id of "device" to pass to Record().
+  int32 InternDevice(const string& device) LOCKS_EXCLUDED(mu_);
+
+  // Records that "node_name" ran on the device with id "device_id" from
+  // "start_micros" to "end_micros", as part of step "step_id".
+  void Record(int32 device_id, int64 step_id, StringPiece node_name,
+              int64 start_micros, int64 end_micros);
+
+  // Appends the recorded events of step "step_id" (or of every step if it
+  // is kAllSteps) to "step_stats", with one DeviceStepStats per device.
+  // Events that are overwritten while they are copied are dropped.
+  void Dump(int64 step_id, StepStats* step_stats) LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Event {
+    int64 step_id;
+    int64 start_micros;
+    int32 duration_micros;
+    int32 device_id;
+    char node_name[kMaxNodeNameLength + 1];
+  };
+
+  struct ThreadBuffer {
+    // Total number of events recorded into "events"; only the last
+    // kEventsPerThread of them are still present.
+    std::atomic<uint64> num_events{0};
+    // Reported as the thread id of the events.
+    int32 index = 0;
+    Event events[kEventsPerThread];
+  };
+  class ThreadBufferHolder;
+
+  TraceRingBuffer() {}
+
+  // Returns the ring of the calling thread, creating it on first use.
+  ThreadBuffer* GetThreadBuffer();
+  ThreadBuffer* AcquireBuffer() LOCKS_EXCLUDED(mu_);
+  // Called on thread exit; the ring is reused by the next new thread.
+  void ReleaseBuffer(ThreadBuffer* buffer) LOCKS_EXCLUDED(mu_);
+
+  mutex mu_;
+  std::vector<string> devices_ GUARDED_BY(mu_);
+  // Every ring ever created. Rings are never deleted, so Dump() can read
+  // them while their thread exits.
+  std::vector<ThreadBuffer*> buffers_ GUARDED_BY(mu_);
+  std::vector<ThreadBuffer*> free_buffers_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TraceRingBuffer);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_TRACE_RING_BUFFER_H_
@@ -0,0 +1,104 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/trace_ring_buffer.h"
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Every test uses its own step ids, as they share the global buffer.
+TEST(TraceRingBuffer, DumpsOneStep) {
+  TraceRingBuffer* trace = TraceRingBuffer::Global();
+  const int32 cpu = trace->InternDevice("/device:CPU:0");
+  const int32 gpu = trace->InternDevice("/device:GPU:0");
+  EXPECT_EQ(cpu, trace->InternDevice("/device:CPU:0"));
+  EXPECT_NE(cpu, gpu);
+
+  trace->Record(cpu, 1001, "a", 100, 110);
+  trace->Record(gpu, 1001, "b", 105, 125);
+  trace->Record(cpu, 1002, "c", 200, 201);
+
+  StepStats step_stats;
+  trace->Dump(1001, &step_stats);
+  ASSERT_EQ(2, step_stats.dev_stats_size());
+  for (const DeviceStepStats& dev_stats : step_stats.dev_stats()) {
+    ASSERT_EQ(1, dev_stats.node_stats_size());
+    const NodeExecStats& node_stats = dev_stats.node_stats(0);
+    if (dev_stats.device() == "/device:CPU:0") {
+      EXPECT_EQ("a", node_stats.node_name());
+      EXPECT_EQ(100, node_stats.all_start_micros());
+      EXPECT_EQ(10, node_stats.all_end_rel_micros());
+    } else {
+      EXPECT_EQ("/device:GPU:0", dev_stats.device());
+      EXPECT_EQ("b", node_stats.node_name());
+      EXPECT_EQ(105, node_stats.all_start_micros());
+      EXPECT_EQ(20, node_stats.op_end_rel_micros());
+    }
+  }
+}
+
+TEST(TraceRingBuffer, KeepsNewestEventsAndTruncatesNames) {
+  TraceRingBuffer* trace = TraceRingBuffer::Global();
+  const int32 cpu = trace->InternDevice("/device:CPU:0");
+  const int kEvents = TraceRingBuffer::kEventsPerThread + 10;
+  const string long_name(2 * TraceRingBuffer::kMaxNodeNameLength, 'x');
+  for (int i = 0; i < kEvents; ++i) {
+    trace->Record(cpu, 2001, long_name, i, i + 1);
+  }
+
+  StepStats step_stats;
+  trace->Dump(2001, &step_stats);
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  // The oldest slot is dropped, as it is the next one to be rewritten.
+  ASSERT_EQ(TraceRingBuffer::kEventsPerThread - 1,
+            dev_stats.node_stats_size());
+  EXPECT_EQ(kEvents - 1, dev_stats.node_stats(dev_stats.node_stats_size() - 1)
+                             .all_start_micros());
+  EXPECT_EQ(string(TraceRingBuffer::kMaxNodeNameLength, 'x'),
+            dev_stats.node_stats(0).node_name());
+}
+
+TEST(TraceRingBuffer, RecordsFromManyThreads) {
+  TraceRingBuffer* trace = TraceRingBuffer::Global();
+  const int32 cpu = trace->InternDevice("/device:CPU:0");
+  const int kThreads = 4;
+  const int kEventsPerThread = 100;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+      pool.Schedule([trace, cpu, t]() {
+        for (int i = 0; i < kEventsPerThread; ++i) {
+          trace->Record(cpu, 3001, strings::StrCat("n", t, "_", i), i, i);
+        }
+      });
+    }
+  }
+
+  StepStats step_stats;
+  trace->Dump(3001, &step_stats);
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  EXPECT_EQ(kThreads * kEventsPerThread,
+            step_stats.dev_stats(0).node_stats_size());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+
+#include <deque>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// WorkStealingQueue is a double-ended queue of work items owned by a
+// single worker, for use in the work-stealing mode of ExecutorState.
+//
+// The owning worker pushes and pops at the back, so the most recently
+// produced item (typically a successor of the node that just finished,
+// whose inputs are still in cache) runs next. Other workers that have run
+// out of work steal from the front, taking the oldest item, which is the
+// one least likely to share cache lines with the owner's current work.
+//
+//    WorkStealingQueue<int> q;
+//    q.PushBack(1);
+//    q.PushBack(2);
+//    int item;
+//    q.PopBack(&item);     // item == 2, by the owner.
+//    q.StealFront(&item);  // item == 1, by a thief.
+//
+// Contention is limited to the two ends of one worker's queue rather than
+// a single queue shared by every thread, so a plain mutex is sufficient.
+template <typename T>
+class WorkStealingQueue {
+ public:
+  WorkStealingQueue() {}
+
+  // Appends "item" at the owner's end of the queue.
+  void PushBack(const T& item) {
+    mutex_lock l(mu_);
+    items_.push_back(item);
+  }
+
+  // Removes the most recently pushed item and stores it in "*item".
+  // Returns false if the queue is empty.
+  bool PopBack(T* item) {
+    mutex_lock l(mu_);
+    if (items_.empty()) return false;
+    *item = items_.back();
+    items_.pop_back();
+    return true;
+  }
+
+  // Removes the least recently pushed item and stores it in "*item".
+  // Returns false if the queue is empty.
+  bool StealFront(T* item) {
+    mutex_lock l(mu_);
+    if (items_.empty()) return false;
+    *item = items_.front();
+    items_.pop_front();
+    return true;
+  }
+
+  bool Empty() const {
+    mutex_lock l(mu_);
+    return items_.empty();
+  }
+
+  size_t Size() const {
+    mutex_lock l(mu_);
+    return items_.size();
+  }
+
+ private:
+  mutable mutex mu_;
+  std::deque<T> items_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
@@ -0,0 +1,92 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueue, OwnerIsLifoThiefIsFifo) {
+  WorkStealingQueue<int> q;
+  EXPECT_TRUE(q.Empty());
+  for (int i = 0; i < 4; ++i) {
+    q.PushBack(i);
+  }
+  EXPECT_EQ(4, q.Size());
+
+  int item = -1;
+  EXPECT_TRUE(q.PopBack(&item));
+  EXPECT_EQ(3, item);
+  EXPECT_TRUE(q.StealFront(&item));
+  EXPECT_EQ(0, item);
+  EXPECT_TRUE(q.StealFront(&item));
+  EXPECT_EQ(1, item);
+  EXPECT_TRUE(q.PopBack(&item));
+  EXPECT_EQ(2, item);
+
+  EXPECT_TRUE(q.Empty());
+  EXPECT_FALSE(q.PopBack(&item));
+  EXPECT_FALSE(q.StealFront(&item));
+  EXPECT_EQ(2, item);
+}
+
+TEST(WorkStealingQueue, ConcurrentOwnerAndThieves) {
+  const int kItems = 10000;
+  const int kThieves = 4;
+  WorkStealingQueue<int> q;
+  std::vector<std::atomic<int>> seen(kItems);
+  for (auto& s : seen) s = 0;
+  std::atomic<int> taken(0);
+
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kThieves + 1);
+    pool.Schedule([&q, &seen, &taken]() {
+      for (int i = 0; i < kItems; ++i) {
+        q.PushBack(i);
+        int item;
+        if (i % 3 == 0 && q.PopBack(&item)) {
+          ++seen[item];
+          ++taken;
+        }
+      }
+    });
+    for (int t = 0; t < kThieves; ++t) {
+      pool.Schedule([&q, &seen, &taken]() {
+        int item;
+        while (taken < kItems) {
+          if (q.StealFront(&item)) {
+            ++seen[item];
+            ++taken;
+          }
+        }
+      });
+    }
+  }
+
+  EXPECT_TRUE(q.Empty());
+  for (int i = 0; i < kItems; ++i) {
+    EXPECT_EQ(1, seen[i]) << i;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
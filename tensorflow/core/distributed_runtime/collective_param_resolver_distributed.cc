@@ -62,6 +62,7 @@ class CompleteInstanceCall : public CancellableCall {
     for (int32 offset : instance.impl_details.subdiv_offsets) {
       req_.add_subdiv_offset(offset);
     }
+    req_.set_hierarchical(instance.impl_details.hierarchical);
     req_.set_device(device_name);
     req_.set_is_source(is_source);
   }
@@ -150,6 +151,7 @@ void CollectiveParamResolverDistributed::CompleteInstanceAsync(
   for (int32 offset : request->subdiv_offset()) {
     cp->instance.impl_details.subdiv_offsets.push_back(offset);
   }
+  cp->instance.impl_details.hierarchical = request->hierarchical();
   string* device = new string(request->device());
   VLOG(1) << "New cp " << cp << " for device " << *device << " : "
           << cp->ToString();
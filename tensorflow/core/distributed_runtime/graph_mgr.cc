@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 
+#include <atomic>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -36,13 +37,16 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -60,10 +64,20 @@ GraphMgr::GraphMgr(const WorkerEnv* worker_env, DeviceMgr* device_mgr)
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  status = ReadInt64FromEnvVar("TF_REGISTERED_GRAPH_CACHE_SIZE", 0,
+                               &cache_size_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  status = ReadBoolFromEnvVar("TF_PIPELINE_STEPS", false, &pipeline_steps_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
 }
 
 GraphMgr::~GraphMgr() {
   for (auto p : table_) p.second->Unref();
+  for (auto p : cache_) p.second->Unref();
 }
 
 GraphMgr::Item::~Item() {
@@ -96,6 +110,72 @@ static Status ValidateGraphDefForDevices(const GraphDef& gdef) {
   return Status::OK();
 }
 
+// Adds to "*num_sends" the number of tensors that a step of "graph" sends to
+// the rendezvous. Returns false if the step may use the rendezvous, or the
+// collective executor, after its last send, or if the number of sends can
+// vary between steps.
+static bool CountSendsOfPipelinableGraph(const Graph& graph,
+                                         int64* num_sends) {
+  std::vector<Node*> sends;
+  for (Node* n : graph.op_nodes()) {
+    if (n->IsEnter() || n->IsCollective()) {
+      return false;
+    }
+    if (n->IsSend()) {
+      sends.push_back(n);
+    }
+  }
+  std::vector<bool> before_send(graph.num_node_ids(), false);
+  ReverseDFSFrom(graph, sends,
+                 [&before_send](Node* n) { before_send[n->id()] = true; },
+                 nullptr);
+  for (Node* n : graph.op_nodes()) {
+    if (n->IsRecv() && !before_send[n->id()]) {
+      return false;
+    }
+  }
+  *num_sends += sends.size();
+  return true;
+}
+
+namespace {
+
+// Forwards to another rendezvous, and calls "sent" once "num_sends" tensors
+// have been sent through it.
+class SendCountingRendezvous : public Rendezvous {
+ public:
+  SendCountingRendezvous(Rendezvous* base, int64 num_sends,
+                         std::function<void()> sent)
+      : base_(base), remaining_sends_(num_sends), sent_(std::move(sent)) {
+    base_->Ref();
+  }
+
+  Status Send(const ParsedKey& key, const Args& args, const Tensor& val,
+              const bool is_dead) override {
+    Status s = base_->Send(key, args, val, is_dead);
+    if (remaining_sends_.fetch_sub(1) == 1) {
+      sent_();
+    }
+    return s;
+  }
+
+  void RecvAsync(const ParsedKey& key, const Args& args,
+                 DoneCallback done) override {
+    base_->RecvAsync(key, args, std::move(done));
+  }
+
+  void StartAbort(const Status& status) override { base_->StartAbort(status); }
+
+ private:
+  ~SendCountingRendezvous() override { base_->Unref(); }
+
+  Rendezvous* const base_;
+  std::atomic<int64> remaining_sends_;
+  const std::function<void()> sent_;
+};
+
+}  // namespace
+
 Status GraphMgr::DecorateAndPublishGraphForDebug(
     const DebugOptions& debug_options, Graph* graph, Device* device) {
   std::unique_ptr<DebugGraphDecoratorInterface> decorator;
@@ -193,6 +273,8 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
 
   LocalExecutorParams params;
 
+  bool pipelinable = pipeline_steps_;
+  int64 num_sends = 0;
   item->units.reserve(partitions.size());
   item->graph_mgr = this;
   const auto& optimizer_opts = graph_options.optimizer_options();
@@ -270,6 +352,9 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     TF_RETURN_IF_ERROR(
         EnsureMemoryTypes(DeviceType(unit->device->device_type()),
                           unit->device->name(), subgraph.get()));
+    if (pipelinable) {
+      pipelinable = CountSendsOfPipelinableGraph(*subgraph, &num_sends);
+    }
     unit->graph = subgraph.get();
     unit->build_cost_model = graph_options.build_cost_model();
     if (unit->build_cost_model > 0) {
@@ -278,28 +363,109 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
     TF_RETURN_IF_ERROR(
         NewLocalExecutor(params, std::move(subgraph), &unit->root));
   }
+  if (pipelinable && num_sends > 0) {
+    item->pipelined_sends = num_sends;
+  }
   return Status::OK();
 }
 
+// Computes in "fingerprint" the fingerprint of the arguments of Register()
+// that determine the registered item. Returns false if "gdef" cannot be
+// serialized.
+static bool RegistrationFingerprint(const string& session, const GraphDef& gdef,
+                                    const GraphOptions& graph_options,
+                                    const DebugOptions& debug_options,
+                                    int64 collective_graph_key,
+                                    uint64* fingerprint) {
+  string serialized;
+  if (!SerializeToStringDeterministic(gdef, &serialized)) {
+    return false;
+  }
+  uint64 fp = FingerprintCat64(Fingerprint64(session),
+                               Fingerprint64(serialized));
+  if (!SerializeToStringDeterministic(graph_options, &serialized)) {
+    return false;
+  }
+  fp = FingerprintCat64(fp, Fingerprint64(serialized));
+  if (!SerializeToStringDeterministic(debug_options, &serialized)) {
+    return false;
+  }
+  fp = FingerprintCat64(fp, Fingerprint64(serialized));
+  *fingerprint = FingerprintCat64(fp, collective_graph_key);
+  return true;
+}
+
+GraphMgr::Item* GraphMgr::LookupCachedItem(uint64 fingerprint) {
+  mutex_lock l(mu_);
+  auto iter = cache_.find(fingerprint);
+  if (iter == cache_.end()) {
+    return nullptr;
+  }
+  cache_lru_.remove(fingerprint);
+  cache_lru_.push_back(fingerprint);
+  iter->second->Ref();
+  return iter->second;
+}
+
+void GraphMgr::CacheItem(uint64 fingerprint, Item* item) {
+  std::vector<Item*> evicted;
+  {
+    mutex_lock l(mu_);
+    if (!cache_.insert({fingerprint, item}).second) {
+      return;
+    }
+    item->Ref();
+    cache_lru_.push_back(fingerprint);
+    while (static_cast<int64>(cache_lru_.size()) > cache_size_) {
+      auto iter = cache_.find(cache_lru_.front());
+      evicted.push_back(iter->second);
+      cache_.erase(iter);
+      cache_lru_.pop_front();
+    }
+  }
+  for (Item* e : evicted) {
+    e->Unref();
+  }
+}
+
 Status GraphMgr::Register(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
                           int64 collective_graph_key,
                           DistributedFunctionLibraryRuntime* cluster_flr,
                           string* handle) {
-  Item* item = new Item;
-  Status s = InitItem(session, gdef, graph_options, debug_options,
-                      collective_graph_key, cluster_flr, item);
-  if (!s.ok()) {
-    item->Unref();
-    return s;
+  uint64 fingerprint = 0;
+  const bool cacheable =
+      cache_size_ > 0 &&
+      RegistrationFingerprint(session, gdef, graph_options, debug_options,
+                              collective_graph_key, &fingerprint);
+  Item* item = cacheable ? LookupCachedItem(fingerprint) : nullptr;
+  const bool reused = item != nullptr;
+  if (!reused) {
+    item = new Item;
+    Status s = InitItem(session, gdef, graph_options, debug_options,
+                        collective_graph_key, cluster_flr, item);
+    if (!s.ok()) {
+      item->Unref();
+      return s;
+    }
+    if (cacheable) {
+      CacheItem(fingerprint, item);
+    }
   }
 
-  // Inserts one item into table_.
+  // Inserts one item into table_. A cached item may be registered under
+  // several handles, and keeps the first one for logging.
   {
     mutex_lock l(mu_);
     *handle = strings::Printf("%016llx", ++next_id_);
-    item->handle = *handle;
+    if (item->handle.empty()) {
+      item->handle = *handle;
+    }
+    if (reused) {
+      VLOG(1) << "Registered graph " << *handle << " with the executors of "
+              << item->handle;
+    }
     CHECK(table_.insert({*handle, item}).second);
   }
   return Status::OK();
@@ -324,13 +490,18 @@ Status GraphMgr::Deregister(const string& handle) {
 
 Status GraphMgr::DeregisterAll() {
   std::vector<Item*> items;
-  // Removes all items from table_.
+  // Removes all items from table_ and cache_.
   {
     mutex_lock l(mu_);
     for (const auto& entry : table_) {
       items.push_back(entry.second);
     }
     table_.clear();
+    for (const auto& entry : cache_) {
+      items.push_back(entry.second);
+    }
+    cache_.clear();
+    cache_lru_.clear();
   }
   for (auto item : items) {
     item->Unref();
@@ -447,6 +618,14 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
     return;
   }
 
+  // Steps that collect statistics are not pipelined, since the collector
+  // is only valid until "done" is called.
+  if (item->pipelined_sends > 0 && collector == nullptr) {
+    StartPipelinedStep(handle, step_id, item, rendezvous, ce_handle,
+                       cancellation_manager, std::move(done));
+    return;
+  }
+
   StartParallelExecutors(handle, step_id, item, rendezvous, ce_handle,
                          collector, cost_graph, cancellation_manager,
                          [item, rendezvous, ce_handle, done](const Status& s) {
@@ -512,6 +691,82 @@ void GraphMgr::StartParallelExecutors(const string& handle, int64 step_id,
   }
 }
 
+void GraphMgr::StartPipelinedStep(const string& handle, int64 step_id,
+                                  Item* item, Rendezvous* rendezvous,
+                                  CollectiveExecutor::Handle* ce_handle,
+                                  CancellationManager* cancellation_manager,
+                                  StatusCallback done) {
+  Status tail_status;
+  {
+    mutex_lock l(item->tail_mu);
+    std::swap(tail_status, item->tail_status);
+  }
+  if (!tail_status.ok()) {
+    done(tail_status);
+    delete ce_handle;
+    item->Unref();
+    rendezvous->Unref();
+    return;
+  }
+
+  // The executors may outlive "cancellation_manager", which is only valid
+  // until "done" is called, so they use their own cancellation manager.
+  struct PipelinedStep {
+    StatusCallback done;
+    CancellationManager* caller_cm = nullptr;
+    CancellationToken token;
+    CancellationManager cm;
+    mutex mu;
+    bool reported GUARDED_BY(mu) = false;
+  };
+  std::shared_ptr<PipelinedStep> step = std::make_shared<PipelinedStep>();
+  step->done = std::move(done);
+  if (cancellation_manager != nullptr) {
+    step->caller_cm = cancellation_manager;
+    step->token = cancellation_manager->get_cancellation_token();
+    PipelinedStep* step_ptr = step.get();
+    if (!cancellation_manager->RegisterCallback(
+            step->token, [step_ptr]() { step_ptr->cm.StartCancel(); })) {
+      step->cm.StartCancel();
+      step->caller_cm = nullptr;
+    }
+  }
+  // Reports the step complete unless it already was. Returns false if it
+  // already was.
+  auto report = [step](const Status& s) {
+    {
+      mutex_lock l(step->mu);
+      if (step->reported) return false;
+      step->reported = true;
+    }
+    if (step->caller_cm != nullptr) {
+      step->caller_cm->DeregisterCallback(step->token);
+    }
+    step->done(s);
+    return true;
+  };
+
+  Rendezvous* counting_rendezvous = new SendCountingRendezvous(
+      rendezvous, item->pipelined_sends,
+      [report]() { report(Status::OK()); });
+  StartParallelExecutors(
+      handle, step_id, item, counting_rendezvous, ce_handle,
+      /*collector=*/nullptr, /*cost_graph=*/nullptr, &step->cm,
+      [handle, step_id, item, rendezvous, counting_rendezvous, ce_handle, step,
+       report](const Status& s) {
+        if (!report(s) && !s.ok()) {
+          LOG(ERROR) << "Step " << step_id << " of graph " << handle
+                     << " failed after it was reported complete: " << s;
+          mutex_lock l(item->tail_mu);
+          item->tail_status.Update(s);
+        }
+        counting_rendezvous->Unref();
+        rendezvous->Unref();
+        item->Unref();
+        delete ce_handle;
+      });
+}
+
 void GraphMgr::BuildCostModel(Item* item, StepStatsCollector* collector,
                               CostGraphDef* cost_graph) {
   if (collector && !skip_cost_models_) {
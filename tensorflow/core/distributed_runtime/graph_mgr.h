@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -74,6 +75,11 @@ class GraphMgr {
 
   // Registers a graph. Fills in "handle". The registered graph retains a
   // reference to cluster_flr to do cross process function calls.
+  //
+  // If TF_REGISTERED_GRAPH_CACHE_SIZE is positive, up to that many of the
+  // most recently registered graphs are kept after they are deregistered,
+  // and registering an identical graph again reuses their executors instead
+  // of partitioning, optimizing and instantiating the graph again.
   Status Register(const string& session, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, int64 collective_graph_key,
@@ -141,6 +147,16 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // If positive, the number of tensors that a step sends to the rendezvous
+    // before it stops using it, which allows the step to be pipelined (see
+    // TF_PIPELINE_STEPS).
+    int64 pipelined_sends = 0;
+
+    // The error that a pipelined step raised after it was reported complete.
+    // It fails the next step.
+    mutex tail_mu;
+    Status tail_status GUARDED_BY(tail_mu);
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -155,6 +171,11 @@ class GraphMgr {
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
 
+  // If true, steps of the graphs that only use the rendezvous in a prefix of
+  // the step are reported complete once that prefix is done, so that the
+  // master can start the next step while the rest of the step runs.
+  bool pipeline_steps_ = false;
+
   // Table mapping graph handles to registered graphs.
   //
   // TODO(zhifengc): If the client does not call Deregister, we'll
@@ -162,6 +183,16 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Maximum number of items in cache_.
+  int64 cache_size_ = 0;
+
+  // Registered items, keyed by the fingerprint of their Register()
+  // arguments. Each entry holds a reference on its item, and the least
+  // recently registered entry is evicted first.
+  std::unordered_map<uint64, Item*> cache_ GUARDED_BY(mu_);
+  // Fingerprints of the entries in cache_, least recently registered first.
+  std::list<uint64> cache_lru_ GUARDED_BY(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               CollectiveExecutor::Handle* ce_handle,
@@ -170,6 +201,15 @@ class GraphMgr {
                               CancellationManager* cancellation_manager,
                               StatusCallback done);
 
+  // Runs a step of an item with positive "pipelined_sends", and calls "done"
+  // as soon as the step has sent them all. Takes over the references on
+  // "item" and "rendezvous", and the ownership of "ce_handle".
+  void StartPipelinedStep(const string& handle, int64 step_id, Item* item,
+                          Rendezvous* rendezvous,
+                          CollectiveExecutor::Handle* ce_handle,
+                          CancellationManager* cancellation_manager,
+                          StatusCallback done);
+
   // Don't attempt to process cost models unless explicitly requested for at
   // least one of the items.
   bool skip_cost_models_ = true;
@@ -177,6 +217,13 @@ class GraphMgr {
   void BuildCostModel(Item* item, StepStatsCollector* collector,
                       CostGraphDef* cost_graph);
 
+  // Returns the item cached for "fingerprint" with a new reference, or
+  // nullptr.
+  Item* LookupCachedItem(uint64 fingerprint);
+
+  // Caches "item" for "fingerprint" unless an item is already cached for it.
+  void CacheItem(uint64 fingerprint, Item* item);
+
   Status InitItem(const string& session, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, int64 collective_graph_key,
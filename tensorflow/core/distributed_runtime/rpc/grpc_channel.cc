@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 
+#include <atomic>
 #include <limits>
 #include <map>
 #include <unordered_map>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -53,6 +55,24 @@ Status ValidateHostPortPair(const string& host_port) {
   }
   return Status::OK();
 }
+
+// Returns the number of channels (i.e. TCP connections) that a channel cache
+// opens to each target, from the TF_GRPC_CHANNELS_PER_TARGET environment
+// variable (default 1). Several channels avoid serializing all the RPCs to a
+// busy peer, e.g. a parameter server, over a single connection.
+int64 NumChannelsPerTarget() {
+  static const int64 num_channels = []() {
+    int64 n;
+    Status s = ReadInt64FromEnvVar("TF_GRPC_CHANNELS_PER_TARGET", 1, &n);
+    if (!s.ok() || n < 1) {
+      LOG(ERROR) << "Invalid TF_GRPC_CHANNELS_PER_TARGET, using 1 channel: "
+                 << s;
+      n = 1;
+    }
+    return n;
+  }();
+  return num_channels;
+}
 }  // namespace
 
 Status NewHostPortGrpcChannel(const string& target,
@@ -66,6 +86,13 @@ Status NewHostPortGrpcChannel(const string& target,
   // NOTE(mrry): Some versions of gRPC use a 20-second minimum backoff
   // on connection failure, which makes our tests time out.
   args.SetInt("grpc.testing.fixed_reconnect_backoff_ms", 1000);
+  if (NumChannelsPerTarget() > 1) {
+    // gRPC shares one connection among the channels to a target that have
+    // identical arguments, so tell the channels apart with an argument that
+    // gRPC itself ignores.
+    static std::atomic<int> next_channel_index(0);
+    args.SetInt("grpc.tensorflow.channel_index", next_channel_index++);
+  }
   *channel_pointer = ::grpc::CreateCustomChannel(
       "dns:///" + target, ::grpc::InsecureChannelCredentials(), args);
   return Status::OK();
@@ -109,39 +136,57 @@ Status GrpcChannelSpec::AddHostPortsJob(
 namespace {
 
 // GrpcChannelCache that caches results to FindWorkerChannel() calls.
+//
+// Up to NumChannelsPerTarget() channels are opened to each target, and
+// FindWorkerChannel() hands them out in turn.
 class CachingGrpcChannelCache : public GrpcChannelCache {
  public:
-  CachingGrpcChannelCache() {}
+  CachingGrpcChannelCache()
+      : num_channels_per_target_(NumChannelsPerTarget()) {}
 
   ~CachingGrpcChannelCache() override {}
 
   SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
-    SharedGrpcChannelPtr ch = nullptr;
     {
       mutex_lock l(mu_);  // could use reader lock
-      ch = gtl::FindPtrOrNull(channels_, target);
-      if (ch) {
-        return ch;
+      TargetChannels* channels = gtl::FindOrNull(channels_, target);
+      if (channels != nullptr &&
+          channels->channels.size() >= num_channels_per_target_) {
+        return channels->channels[channels->next++ % num_channels_per_target_];
       }
     }
-    ch = FindChannelOnce(target);
+    SharedGrpcChannelPtr ch = FindChannelOnce(target);
     if (ch) {
       mutex_lock l(mu_);
-      channels_.insert({target, ch});
+      TargetChannels* channels = &channels_[target];
+      if (channels->channels.size() < num_channels_per_target_) {
+        channels->channels.push_back(ch);
+      } else {
+        // Another thread completed the set of channels meanwhile.
+        ch = channels->channels[channels->next++ % num_channels_per_target_];
+      }
     }
     return ch;
   }
 
  protected:
-  // Find the ClientChannel for "target".  Only called when no channel was
-  // found in the channels_ cache for "target".  A non nullptr result will be
-  // cached in channels_.
+  // Find the ClientChannel for "target".  Only called while fewer than
+  // num_channels_per_target_ channels were found in the channels_ cache for
+  // "target".  A non nullptr result will be cached in channels_.
   virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
 
  private:
+  struct TargetChannels {
+    std::vector<SharedGrpcChannelPtr> channels;
+    // Index of the channel to return next, modulo the number of channels.
+    size_t next = 0;
+  };
+
+  const size_t num_channels_per_target_;
+
   // TODO(zhifengc): Eviction when the map becomes too big.
   mutex mu_;
-  std::unordered_map<string, SharedGrpcChannelPtr> channels_ GUARDED_BY(mu_);
+  std::unordered_map<string, TargetChannels> channels_ GUARDED_BY(mu_);
 };
 
 // A ChannelCache that is the union of multiple ChannelCaches.
@@ -30,18 +30,39 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The number of RPCs in flight to a peer is the difference between these two.
+auto* rpcs_started = monitoring::Counter<1>::New(
+    "/tensorflow/core/grpc_remote_worker/rpcs_started",
+    "The number of RPCs issued to each remote worker.", "peer");
+auto* rpcs_completed = monitoring::Counter<1>::New(
+    "/tensorflow/core/grpc_remote_worker/rpcs_completed",
+    "The number of RPCs to each remote worker that have completed.", "peer");
+auto* rpc_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/grpc_remote_worker/rpc_latency_usecs",
+     "The latency of the RPCs to each remote worker, in microseconds.",
+     "peer"},
+    // 10us to ~3min.
+    monitoring::Buckets::Exponential(10, 2, 25));
+
+}  // namespace
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
                             ::grpc::CompletionQueue* completion_queue,
-                            WorkerCacheLogger* logger)
+                            WorkerCacheLogger* logger, const string& target)
       : channel_(std::move(channel)),
         stub_(channel_),
         cq_(completion_queue),
@@ -60,7 +81,11 @@ class GrpcRemoteWorker : public WorkerInterface {
         completegroup_(Method(GrpcWorkerMethod::kCompleteGroup)),
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
-        logger_(logger) {}
+        recvtensorbatch_(Method(GrpcWorkerMethod::kRecvTensorBatch)),
+        logger_(logger),
+        rpcs_started_(rpcs_started->GetCell(target)),
+        rpcs_completed_(rpcs_completed->GetCell(target)),
+        rpc_latency_usecs_(rpc_latency_usecs->GetCell(target)) {}
 
   ~GrpcRemoteWorker() override {}
 
@@ -203,6 +228,14 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvtensor_, *cb_to_use, call_opts);
   }
 
+  void RecvTensorBatchAsync(CallOptions* call_opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    IssueRequest(request, response, recvtensorbatch_, std::move(done),
+                 call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -220,13 +253,29 @@ class GrpcRemoteWorker : public WorkerInterface {
                     protobuf::Message* response, const ::grpc::string& method,
                     StatusCallback done, CallOptions* call_opts = nullptr) {
     new RPCState<protobuf::Message>(&stub_, cq_, method, *request, response,
-                                    std::move(done), call_opts);
+                                    TrackRpc(std::move(done)), call_opts);
   }
   void IssueRequest(const protobuf::Message* request, TensorResponse* response,
                     const ::grpc::string& method, StatusCallback done,
                     CallOptions* call_opts = nullptr) {
     new RPCState<TensorResponse>(&stub_, cq_, method, *request, response,
-                                 std::move(done), call_opts);
+                                 TrackRpc(std::move(done)), call_opts);
+  }
+
+  // Counts an RPC that is being issued, and wraps its callback to record
+  // the RPC's completion and latency.
+  StatusCallback TrackRpc(StatusCallback done) {
+    rpcs_started_->IncrementBy(1);
+    const uint64 start_usecs = Env::Default()->NowMicros();
+    // The cells outlive this worker, which may be released before the RPC
+    // completes.
+    monitoring::CounterCell* completed = rpcs_completed_;
+    monitoring::SamplerCell* latency = rpc_latency_usecs_;
+    return [completed, latency, start_usecs, done](const Status& s) {
+      completed->IncrementBy(1);
+      latency->Add(Env::Default()->NowMicros() - start_usecs);
+      done(s);
+    };
   }
 
   // Helper function for initializing the RpcMethod objects below.
@@ -251,17 +300,25 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string completegroup_;
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
+  const ::grpc::string recvtensorbatch_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
 
+  // Per-peer RPC metrics.
+  monitoring::CounterCell* const rpcs_started_;
+  monitoring::CounterCell* const rpcs_completed_;
+  monitoring::SamplerCell* const rpc_latency_usecs_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcRemoteWorker);
 };
 
 WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
-                                     WorkerCacheLogger* logger) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue, logger);
+                                     WorkerCacheLogger* logger,
+                                     const string& target) {
+  return new GrpcRemoteWorker(std::move(channel), completion_queue, logger,
+                              target);
 }
 
 }  // namespace tensorflow
@@ -29,9 +29,12 @@ namespace tensorflow {
 class WorkerCacheLogger;
 class WorkerInterface;
 
+// "target" names the remote worker, e.g. "/job:ps/replica:0/task:3", and
+// labels the per-peer RPC metrics of the returned worker.
 WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
-                                     WorkerCacheLogger* logger);
+                                     WorkerCacheLogger* logger,
+                                     const string& target);
 
 }  // namespace tensorflow
 
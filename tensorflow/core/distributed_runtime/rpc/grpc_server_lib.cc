@@ -124,6 +124,22 @@ Status GrpcServer::Init(
   ConfigProto config = server_def_.default_session_config();
   sess_opts.config = config;
 
+  const RPCOptions& rpc_options =
+      server_def_.default_session_config().rpc_options();
+  if (!rpc_options.recv_tensor_compression().empty() &&
+      rpc_options.recv_tensor_compression() != "snappy") {
+    return errors::InvalidArgument("Unknown recv_tensor_compression: ",
+                                   rpc_options.recv_tensor_compression());
+  }
+  if (rpc_options.recv_tensor_lossy_dtype() != DT_INVALID &&
+      rpc_options.recv_tensor_lossy_dtype() != DT_HALF &&
+      rpc_options.recv_tensor_lossy_dtype() != DT_BFLOAT16) {
+    return errors::InvalidArgument(
+        "recv_tensor_lossy_dtype must be DT_HALF or DT_BFLOAT16, not ",
+        DataTypeString(rpc_options.recv_tensor_lossy_dtype()));
+  }
+  worker_env_.rpc_options = &rpc_options;
+
   // Configure shared devices between master and worker.
   string name_prefix =
       strings::StrCat("/job:", server_def_.job_name(), "/replica:0",
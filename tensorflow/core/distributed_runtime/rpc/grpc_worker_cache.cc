@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -33,7 +34,8 @@ namespace {
 
 class GrpcWorkerCache : public WorkerCachePartial {
  public:
-  // TODO(ncteisen): consider adding a config var or flag for this
+  // The default number of completion queue polling threads, which can be
+  // overridden with the TF_GRPC_WORKER_CACHE_THREADS environment variable.
   static constexpr const size_t kGrpcWorkerCacheThreadCount = 8;
 
   explicit GrpcWorkerCache(std::shared_ptr<GrpcChannelCache> channel_cache,
@@ -42,7 +44,7 @@ class GrpcWorkerCache : public WorkerCachePartial {
       : local_target_(local_target),
         local_worker_(local_worker),
         channel_cache_(channel_cache),
-        threads_(kGrpcWorkerCacheThreadCount),
+        threads_(NumThreads()),
         next_round_robin_assignment_(0) {}
 
   // Explicit destructor to control destruction order.
@@ -61,8 +63,9 @@ class GrpcWorkerCache : public WorkerCachePartial {
       SharedGrpcChannelPtr channel = channel_cache_->FindWorkerChannel(target);
       if (!channel) return nullptr;
       return NewGrpcRemoteWorker(
-          channel, threads_[AssignWorkerToThread(target)].completion_queue(),
-          &logger_);
+          channel,
+          threads_[AssignChannelToThread(channel.get())].completion_queue(),
+          &logger_, target);
     }
   }
 
@@ -113,15 +116,29 @@ class GrpcWorkerCache : public WorkerCachePartial {
     std::unique_ptr<Thread> thread_;
   };  // GrpcWorkerCacheThread
 
-  size_t AssignWorkerToThread(const string& target) {
-    // Round-robin target assignment, but keeps the same target on the same
-    // polling thread always, as this is important for gRPC performance
+  static size_t NumThreads() {
+    int64 num_threads;
+    Status s = ReadInt64FromEnvVar("TF_GRPC_WORKER_CACHE_THREADS",
+                                   kGrpcWorkerCacheThreadCount, &num_threads);
+    if (!s.ok() || num_threads < 1) {
+      LOG(ERROR) << "Invalid TF_GRPC_WORKER_CACHE_THREADS, using "
+                 << kGrpcWorkerCacheThreadCount << " threads: " << s;
+      return kGrpcWorkerCacheThreadCount;
+    }
+    return num_threads;
+  }
+
+  size_t AssignChannelToThread(const ::grpc::Channel* channel) {
+    // Round-robin channel assignment, but keeps the same channel on the same
+    // polling thread always, as this is important for gRPC performance. When
+    // there are several channels per target (see TF_GRPC_CHANNELS_PER_TARGET)
+    // the traffic to a target is thus spread over several threads.
     mutex_lock lock(assignment_mu_);
-    auto it = target_assignments_.find(target);
-    if (it == target_assignments_.end()) {
-      it = target_assignments_
+    auto it = channel_assignments_.find(channel);
+    if (it == channel_assignments_.end()) {
+      it = channel_assignments_
                .insert(std::make_pair(
-                   target, (next_round_robin_assignment_++) % threads_.size()))
+                   channel, (next_round_robin_assignment_++) % threads_.size()))
                .first;
     }
     return it->second;
@@ -134,7 +151,7 @@ class GrpcWorkerCache : public WorkerCachePartial {
   std::vector<GrpcWorkerCacheThread> threads_;
 
   mutex assignment_mu_;
-  std::unordered_map<std::string, size_t> target_assignments_
+  std::unordered_map<const ::grpc::Channel*, size_t> channel_assignments_
       GUARDED_BY(assignment_mu_);
   size_t next_round_robin_assignment_ GUARDED_BY(assignment_mu_);
 };
@@ -28,12 +28,14 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
+#include "tensorflow/core/distributed_runtime/remote_memory_manager.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -41,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
@@ -165,6 +168,9 @@ class GrpcWorkerService : public AsyncServiceInterface {
       for (int i = 0; i < 500; ++i) {
         ENQUEUE_REQUEST(RecvBuf, true);
       }
+      for (int i = 0; i < 100; ++i) {
+        ENQUEUE_REQUEST(RecvTensorBatch, true);
+      }
       for (int i = 0; i < 100; ++i) {
         ENQUEUE_REQUEST(RunGraph, true);
       }
@@ -382,6 +388,22 @@ class GrpcWorkerService : public AsyncServiceInterface {
       });
       ENQUEUE_REQUEST(GetStepSequence, true);
     }
+
+    void RecvTensorBatchHandler(
+        WorkerCall<RecvTensorBatchRequest, RecvTensorBatchResponse>* call) {
+      Schedule([this, call]() {
+        CallOptions* call_opts = new CallOptions;
+        call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+        worker_->RecvTensorBatchAsync(call_opts, &call->request,
+                                      &call->response,
+                                      [call, call_opts](const Status& s) {
+                                        call->ClearCancelCallback();
+                                        delete call_opts;
+                                        call->SendResponse(ToGrpcStatus(s));
+                                      });
+      });
+      ENQUEUE_REQUEST(RecvTensorBatch, true);
+    }
 #undef ENQUEUE_REQUEST
 
     void EnqueueRecvTensorRequestRaw() {
@@ -416,6 +438,21 @@ class GrpcWorkerService : public AsyncServiceInterface {
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerService);
 };
 
+// Encodes `val` as the response to `request`, compressed if `request` asks for
+// it.
+void EncodeRecvTensorResponse(const RecvTensorRequest& request, bool is_dead,
+                              const Tensor& val, ::grpc::ByteBuffer* response) {
+  if (!is_dead && request.has_compression()) {
+    RecvTensorResponse proto;
+    if (CompressRecvTensor(request.compression(), val, &proto)) {
+      proto.set_send_start_micros(Env::Default()->NowMicros());
+      grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+      return;
+    }
+  }
+  grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+}
+
 }  // namespace
 
 GrpcWorker::GrpcWorker(WorkerEnv* worker_env)
@@ -454,9 +491,11 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // of execution of the callback lambda body below, an RPC
   // cancellation should abort the rendezvous.
   opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  RemoteMemoryManager* remote_memory_manager =
+      request->dma_ok() ? env_->remote_memory_manager : nullptr;
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev, request](
+      [opts, response, done, src_dev, request, remote_memory_manager](
           const Status& status, const Rendezvous::Args& send_args,
           const Rendezvous::Args& recv_args, const Tensor& val,
           const bool is_dead) {
@@ -469,7 +508,29 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
           // i.e. it's in CPU RAM *independent of its assigned
           // device type*.
           const bool on_host = send_args.alloc_attrs.on_host();
-          {
+          if (remote_memory_manager != nullptr && val.TotalBytes() > 0 &&
+              (!is_dead) && DMAHelper::CanUseDMA(&val)) {
+            // DMA cases: only the metadata goes on the wire, and the
+            // receiver reads the content through the transport options.
+            RecvTensorResponse* proto = new RecvTensorResponse;
+            proto->set_is_dead(is_dead);
+            proto->set_send_start_micros(Env::Default()->NowMicros());
+            TensorProto* tensor_proto = proto->mutable_tensor();
+            tensor_proto->set_dtype(val.dtype());
+            val.shape().AsProto(tensor_proto->mutable_tensor_shape());
+            remote_memory_manager->TransportOptionsFromTensor(
+                proto->mutable_transport_options(), val, src_dev,
+                send_args.device_context,
+                on_host || src_dev->tensorflow_gpu_device_info() == nullptr,
+                [proto, done, response](const Status& s) {
+                  if (s.ok()) {
+                    grpc::EncodeRecvTensorResponseToByteBuffer(*proto,
+                                                               response);
+                  }
+                  done(s);
+                  delete proto;
+                });
+          } else {
             // Non-DMA cases.
             if (src_dev->tensorflow_gpu_device_info() && (!on_host)) {
               DeviceContext* send_dev_context = send_args.device_context;
@@ -483,10 +544,10 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on an accelerator device. Uses the device_context to
               // fill the copy on host.
-              StatusCallback copy_ready = [response, done, copy,
+              StatusCallback copy_ready = [request, response, done, copy,
                                            is_dead](const Status& s) {
                 // The value is now ready to be returned on the wire.
-                grpc::EncodeTensorToByteBuffer(is_dead, *copy, response);
+                EncodeRecvTensorResponse(*request, is_dead, *copy, response);
                 done(s);
                 delete copy;
               };
@@ -494,7 +555,7 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
               send_dev_context->CopyDeviceTensorToCPU(
                   &val, request->rendezvous_key(), src_dev, copy, copy_ready);
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              EncodeRecvTensorResponse(*request, is_dead, val, response);
               done(Status::OK());
             }
           }
@@ -600,6 +661,175 @@ void GrpcWorker::LoggingAsync(const LoggingRequest* request,
   done(Status::OK());
 }
 
+struct GrpcWorker::RecvTensorBatch {
+  int64 step_id = 0;
+
+  mutex mu;
+  // The number of tensors that aren't ready yet.
+  int num_pending GUARDED_BY(mu) = 0;
+  // The tensors that are ready but weren't returned yet, with their indices.
+  std::vector<std::pair<int, RecvTensorResponse>> ready GUARDED_BY(mu);
+  Status status GUARDED_BY(mu);
+
+  // The call waiting for the next ready tensors, if any.
+  CallOptions* waiting_opts GUARDED_BY(mu) = nullptr;
+  RecvTensorBatchResponse* waiting_response GUARDED_BY(mu) = nullptr;
+  StatusCallback waiting_done GUARDED_BY(mu);
+};
+
+void GrpcWorker::RecvTensorBatchAsync(CallOptions* opts,
+                                      const RecvTensorBatchRequest* request,
+                                      RecvTensorBatchResponse* response,
+                                      StatusCallback done) {
+  const int64 batch_id = request->batch_id();
+  const bool is_new = request->request_size() > 0;
+  std::shared_ptr<RecvTensorBatch> batch;
+  {
+    mutex_lock l(recv_tensor_batches_mu_);
+    auto it = recv_tensor_batches_.find(batch_id);
+    if (is_new && it == recv_tensor_batches_.end()) {
+      batch = std::make_shared<RecvTensorBatch>();
+      batch->step_id = request->request(0).step_id();
+      recv_tensor_batches_[batch_id] = batch;
+    } else if (!is_new && it != recv_tensor_batches_.end()) {
+      batch = it->second;
+    }
+  }
+  if (batch == nullptr) {
+    done(is_new ? errors::AlreadyExists("RecvTensorBatch ", batch_id,
+                                        " already exists")
+                : errors::NotFound("RecvTensorBatch ", batch_id, " not found"));
+    return;
+  }
+
+  bool is_concurrent = false;
+  {
+    mutex_lock l(batch->mu);
+    if (batch->waiting_done != nullptr) {
+      is_concurrent = true;
+    } else {
+      if (is_new) {
+        batch->num_pending = request->request_size();
+      }
+      batch->waiting_opts = opts;
+      batch->waiting_response = response;
+      batch->waiting_done = std::move(done);
+    }
+  }
+  if (is_concurrent) {
+    done(errors::FailedPrecondition("Concurrent calls of RecvTensorBatch ",
+                                    batch_id));
+    return;
+  }
+  const int64 step_id = batch->step_id;
+  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  if (is_new) {
+    for (int i = 0; i < request->request_size(); ++i) {
+      RecvBatchedTensor(batch_id, batch, i, request->request(i));
+    }
+  }
+  MaybeRespondToRecvTensorBatch(batch_id, batch.get());
+}
+
+void GrpcWorker::RecvBatchedTensor(
+    int64 batch_id, const std::shared_ptr<RecvTensorBatch>& batch, int index,
+    const RecvTensorRequest& request) {
+  Rendezvous::ParsedKey parsed;
+  Status s = Rendezvous::ParseKey(request.rendezvous_key(), &parsed);
+  Device* src_dev = nullptr;
+  if (s.ok()) {
+    s = PrepareRecvTensor(parsed, &src_dev);
+  }
+  if (!s.ok()) {
+    CompleteBatchedTensor(batch_id, batch, index, s, false, Tensor());
+    return;
+  }
+
+  const string key = request.rendezvous_key();
+  env_->rendezvous_mgr->RecvLocalAsync(
+      request.step_id(), parsed,
+      [this, batch_id, batch, index, src_dev, key](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
+        if (!status.ok() || !src_dev->tensorflow_gpu_device_info() ||
+            send_args.alloc_attrs.on_host()) {
+          CompleteBatchedTensor(batch_id, batch, index, status, is_dead, val);
+          return;
+        }
+        // "val" is on an accelerator device: copy it to the host, as
+        // GrpcRecvTensorAsync does.
+        AllocatorAttributes alloc_attrs;
+        alloc_attrs.set_gpu_compatible(true);
+        alloc_attrs.set_on_host(true);
+        Allocator* alloc = src_dev->GetAllocator(alloc_attrs);
+        Tensor* copy = new Tensor(alloc, val.dtype(), val.shape());
+        send_args.device_context->CopyDeviceTensorToCPU(
+            &val, key, src_dev, copy,
+            [this, batch_id, batch, index, is_dead, copy](const Status& s) {
+              CompleteBatchedTensor(batch_id, batch, index, s, is_dead, *copy);
+              delete copy;
+            });
+      });
+}
+
+void GrpcWorker::CompleteBatchedTensor(
+    int64 batch_id, const std::shared_ptr<RecvTensorBatch>& batch, int index,
+    const Status& status, bool is_dead, const Tensor& val) {
+  RecvTensorResponse response;
+  if (status.ok()) {
+    response.set_is_dead(is_dead);
+    response.set_send_start_micros(Env::Default()->NowMicros());
+    val.AsProtoTensorContent(response.mutable_tensor());
+  }
+  {
+    mutex_lock l(batch->mu);
+    --batch->num_pending;
+    if (status.ok()) {
+      batch->ready.emplace_back();
+      batch->ready.back().first = index;
+      batch->ready.back().second.Swap(&response);
+    } else {
+      batch->status.Update(status);
+    }
+  }
+  MaybeRespondToRecvTensorBatch(batch_id, batch.get());
+}
+
+void GrpcWorker::MaybeRespondToRecvTensorBatch(int64 batch_id,
+                                               RecvTensorBatch* batch) {
+  CallOptions* opts;
+  StatusCallback done;
+  Status status;
+  bool finished;
+  {
+    mutex_lock l(batch->mu);
+    if (batch->waiting_done == nullptr ||
+        (batch->ready.empty() && batch->status.ok())) {
+      return;
+    }
+    for (auto& index_and_response : batch->ready) {
+      batch->waiting_response->add_index(index_and_response.first);
+      batch->waiting_response->add_response()->Swap(
+          &index_and_response.second);
+    }
+    batch->ready.clear();
+    opts = batch->waiting_opts;
+    done = std::move(batch->waiting_done);
+    batch->waiting_opts = nullptr;
+    batch->waiting_response = nullptr;
+    batch->waiting_done = nullptr;
+    status = batch->status;
+    finished = !status.ok() || batch->num_pending == 0;
+  }
+  if (finished) {
+    mutex_lock l(recv_tensor_batches_mu_);
+    recv_tensor_batches_.erase(batch_id);
+  }
+  opts->ClearCancelCallback();
+  done(status);
+}
+
 WorkerEnv* GrpcWorker::env() { return env_; }
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
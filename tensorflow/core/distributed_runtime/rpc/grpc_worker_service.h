@@ -16,8 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
+#include <memory>
+#include <unordered_map>
+
 #include "tensorflow/core/distributed_runtime/recent_request_ids.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace grpc {
 class ByteBuffer;
@@ -46,10 +50,33 @@ class GrpcWorker : public Worker {
   virtual void RecvBufAsync(CallOptions* opts, const RecvBufRequest* request,
                             RecvBufResponse* response, StatusCallback done);
 
+  void RecvTensorBatchAsync(CallOptions* opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override;
+
   WorkerEnv* env();
 
  private:
+  // The state of a batch across its RecvTensorBatch calls.
+  struct RecvTensorBatch;
+
+  void RecvBatchedTensor(int64 batch_id,
+                         const std::shared_ptr<RecvTensorBatch>& batch,
+                         int index, const RecvTensorRequest& request);
+  void CompleteBatchedTensor(int64 batch_id,
+                             const std::shared_ptr<RecvTensorBatch>& batch,
+                             int index, const Status& status, bool is_dead,
+                             const Tensor& val);
+  // Responds to the waiting call of `batch`, if any, once a tensor is ready or
+  // the batch failed.
+  void MaybeRespondToRecvTensorBatch(int64 batch_id, RecvTensorBatch* batch);
+
   RecentRequestIds recv_tensor_recent_request_ids_;
+
+  mutex recv_tensor_batches_mu_;
+  std::unordered_map<int64, std::shared_ptr<RecvTensorBatch>>
+      recv_tensor_batches_ GUARDED_BY(recv_tensor_batches_mu_);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env);
@@ -87,9 +87,10 @@ enum class GrpcWorkerMethod {
   kCompleteGroup,
   kCompleteInstance,
   kGetStepSequence,
+  kRecvTensorBatch,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kGetStepSequence) + 1;
+    static_cast<int>(GrpcWorkerMethod::kRecvTensorBatch) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/remote_memory_manager.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
@@ -32,11 +34,34 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Asks the sender of the tensor of `parsed` to compress it as `options` say.
+void SetRecvTensorCompression(const RPCOptions& options,
+                              const Rendezvous::ParsedKey& parsed,
+                              RecvTensorRequest* request) {
+  RecvTensorCompression compression;
+  if (options.recv_tensor_compression() == "snappy") {
+    compression.set_algorithm(RecvTensorCompression::SNAPPY);
+  }
+  if (str_util::StrContains(parsed.edge_name,
+                            options.recv_tensor_lossy_name_substring())) {
+    compression.set_lossy_dtype(options.recv_tensor_lossy_dtype());
+  }
+  if (compression.algorithm() == RecvTensorCompression::NONE &&
+      compression.lossy_dtype() == DT_INVALID) {
+    return;
+  }
+  compression.set_min_bytes(options.recv_tensor_compression_min_bytes());
+  *request->mutable_compression() = compression;
+}
+
+class RpcRecvTensorBatchCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
@@ -50,20 +75,44 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Receives the tensor of "parsed" with its own RecvTensor call.
+  void RecvFromRemoteUnbatchedAsync(const Rendezvous::ParsedKey& parsed,
+                                    const Rendezvous::Args& args,
+                                    DoneCallback done);
+
+  // Adds the recv of "parsed" to the next batch of recvs from its source
+  // worker, which is started once it has "max_batch_size" recvs, or once the
+  // recvs issued concurrently with its first one have joined it.
+  void AddToBatch(const Rendezvous::ParsedKey& parsed,
+                  const Rendezvous::Args& args, DoneCallback done,
+                  int max_batch_size);
+  void FlushBatch(const string& src_worker);
+  void StartBatch(RpcRecvTensorBatchCall* batch);
+
+  mutex batches_mu_;
+  // The batches that aren't started yet, by source worker.
+  std::unordered_map<string, RpcRecvTensorBatchCall*> pending_batches_
+      GUARDED_BY(batches_mu_);
+  // The source workers that don't support RecvTensorBatch.
+  std::unordered_set<string> unbatched_workers_ GUARDED_BY(batches_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
 // Used only to retrieve tensors from remote processes.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
-  RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
+  RpcRecvTensorCall()
+      : wi_(nullptr), dst_device_(nullptr), remote_memory_manager_(nullptr) {}
 
   void Init(WorkerInterface* wi, int64 step_id, StringPiece key,
             AllocatorAttributes alloc_attrs, Device* dst_device,
+            RemoteMemoryManager* remote_memory_manager,
             const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
     wi_ = wi;
     alloc_attrs_ = alloc_attrs;
     dst_device_ = dst_device;
+    remote_memory_manager_ = remote_memory_manager;
     recv_args_ = recv_args;
     done_ = std::move(done);
     req_.set_step_id(step_id);
@@ -76,6 +125,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    remote_memory_manager_ = nullptr;
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -127,11 +177,19 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
     resp_.InitAlloc(dst_device_, alloc_attrs_);
+    if (remote_memory_manager_ != nullptr) {
+      req_.set_dma_ok(true);
+    }
     using namespace std::placeholders;
     StatusCallback cb = std::bind(
         [this](std::function<void()> recv_done,
                // Begin unbound arguments.
                const Status& s) {
+          if (s.ok() && remote_memory_manager_ != nullptr &&
+              resp_.metadata().has_transport_options()) {
+            RecvOutOfBand(std::move(recv_done));
+            return;
+          }
           if (!s.ok()) {
             mutex_lock l(mu_);
             status_.Update(s);
@@ -142,11 +200,34 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
   }
 
+  // Fills the tensor, which the response only describes, from the location
+  // encoded in its transport options.
+  void RecvOutOfBand(std::function<void()> recv_done) {
+    if (tensor().TotalBytes() == 0 || is_dead()) {
+      recv_done();
+      return;
+    }
+    const bool on_host =
+        (dst_device_->tensorflow_gpu_device_info() == nullptr) ||
+        alloc_attrs_.on_host();
+    remote_memory_manager_->TensorFromTransportOptions(
+        const_cast<Tensor*>(&tensor()), resp_.metadata().transport_options(),
+        dst_device_, recv_args_.device_context, on_host,
+        [this, recv_done](const Status& s) {
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            status_.Update(s);
+          }
+          recv_done();
+        });
+  }
+
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
+  RemoteMemoryManager* remote_memory_manager_;
   CallOptions opts_;
   RecvTensorRequest req_;
   TensorResponse resp_;
@@ -199,6 +280,145 @@ class RpcRecvTensorFreeList {
   std::vector<RpcRecvTensorCall*> objects_ GUARDED_BY(mu_);
 };
 
+// Used to retrieve a batch of tensors from the same remote process, with one
+// or more RecvTensorBatch calls.
+class RpcRecvTensorBatchCall : public BaseRecvTensorCall {
+ public:
+  struct Recv {
+    Rendezvous::ParsedKey parsed;
+    Rendezvous::Args recv_args;
+    Device* dst_device;
+    // Null once the tensor is received.
+    Rendezvous::DoneCallback done;
+  };
+
+  RpcRecvTensorBatchCall(const string& src_worker, int64 step_id)
+      : src_worker_(src_worker), step_id_(step_id) {}
+
+  void Add(const Rendezvous::ParsedKey& parsed,
+           const Rendezvous::Args& recv_args, Device* dst_device,
+           Rendezvous::DoneCallback done) {
+    RecvTensorRequest* request = req_.add_request();
+    request->set_step_id(step_id_);
+    StringPiece key = parsed.FullKey();
+    request->set_rendezvous_key(key.data(), key.size());
+    request->set_request_id(GetUniqueRequestId());
+    recvs_.push_back({parsed, recv_args, dst_device, std::move(done)});
+  }
+
+  int size() const { return recvs_.size(); }
+  const string& src_worker() const { return src_worker_; }
+
+  WorkerInterface* worker() const { return wi_; }
+  void set_worker(WorkerInterface* wi) { wi_ = wi; }
+
+  void Start(std::function<void()> recv_done) override {
+    recv_done_ = std::move(recv_done);
+    req_.set_batch_id(GetUniqueRequestId());
+    num_pending_ = recvs_.size();
+    Status s = status();
+    if (!s.ok()) {
+      OnResponse(s);
+      return;
+    }
+    IssueCall();
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  // Fails the recvs that haven't received their tensor yet.
+  void Fail(const Status& s) {
+    for (Recv& recv : recvs_) {
+      if (recv.done != nullptr) {
+        recv.done(s, Rendezvous::Args(), recv.recv_args, Tensor{}, false);
+        recv.done = nullptr;
+      }
+    }
+  }
+
+  // True if the remote worker doesn't support RecvTensorBatch. Then none of
+  // the recvs has received its tensor or failed.
+  bool unimplemented() const { return unimplemented_; }
+
+  std::vector<Recv>* mutable_recvs() { return &recvs_; }
+
+ private:
+  void IssueCall() {
+    resp_.Clear();
+    wi_->RecvTensorBatchAsync(&opts_, &req_, &resp_,
+                              [this](const Status& s) { OnResponse(s); });
+  }
+
+  void OnResponse(Status s) {
+    if (s.ok() && resp_.index_size() != resp_.response_size()) {
+      s = errors::Internal("Malformed RecvTensorBatch response");
+    }
+    for (int i = 0; s.ok() && i < resp_.response_size(); ++i) {
+      const int index = resp_.index(i);
+      if (index < 0 || index >= size() || recvs_[index].done == nullptr) {
+        s = errors::Internal("Invalid index ", index,
+                             " in RecvTensorBatch response");
+        break;
+      }
+      Recv& recv = recvs_[index];
+      TensorResponse response;
+      response.InitAlloc(recv.dst_device, recv.recv_args.alloc_attrs);
+      Status recv_status = response.InitFrom(resp_.mutable_response(i));
+      recv.done(recv_status, Rendezvous::Args(), recv.recv_args,
+                response.tensor(), response.metadata().is_dead());
+      recv.done = nullptr;
+      --num_pending_;
+    }
+    {
+      mutex_lock l(mu_);
+      // Prefer the status of an abort to the error it caused.
+      if (!status_.ok()) {
+        s = status_;
+      }
+      status_.Update(s);
+    }
+    if (s.ok() && num_pending_ > 0) {
+      // The next call returns the tensors that weren't ready yet.
+      req_.clear_request();
+      IssueCall();
+      return;
+    }
+    if (errors::IsUnimplemented(s) && num_pending_ == size()) {
+      unimplemented_ = true;
+    } else if (!s.ok()) {
+      Fail(s);
+    }
+    recv_done_();
+  }
+
+  const string src_worker_;
+  const int64 step_id_;
+  WorkerInterface* wi_ = nullptr;
+  CallOptions opts_;
+  RecvTensorBatchRequest req_;
+  RecvTensorBatchResponse resp_;
+  std::vector<Recv> recvs_;
+  int num_pending_ = 0;
+  bool unimplemented_ = false;
+  std::function<void()> recv_done_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorBatchCall);
+};
+
 static RpcRecvTensorFreeList* get_call_freelist() {
   static RpcRecvTensorFreeList* call_freelist = new RpcRecvTensorFreeList();
   return call_freelist;
@@ -208,6 +428,22 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  const int max_batch_size =
+      env_->rpc_options == nullptr
+          ? 0
+          : env_->rpc_options->recv_tensor_max_batch_size();
+  // A tensor transferred out of band is described by the transport options
+  // of its own RecvTensor response, so such recvs are never batched.
+  if (max_batch_size > 1 && env_->remote_memory_manager == nullptr) {
+    AddToBatch(parsed, recv_args, std::move(done), max_batch_size);
+  } else {
+    RecvFromRemoteUnbatchedAsync(parsed, recv_args, std::move(done));
+  }
+}
+
+void RpcRemoteRendezvous::RecvFromRemoteUnbatchedAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -239,7 +475,10 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   }
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+             env_->remote_memory_manager, recv_args, std::move(done));
+  if (env_->rpc_options != nullptr) {
+    SetRecvTensorCompression(*env_->rpc_options, parsed, &call->req_);
+  }
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
@@ -260,6 +499,104 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::AddToBatch(const Rendezvous::ParsedKey& parsed,
+                                     const Rendezvous::Args& recv_args,
+                                     DoneCallback done, int max_batch_size) {
+  string src_worker;
+  string src_rel_device;
+  Device* dst_device = nullptr;
+  Status s;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    s = errors::Internal(parsed.src_device,
+                         " is invalid remote source device.");
+  }
+  if (s.ok()) {
+    s = session()->device_mgr()->LookupDevice(parsed.dst_device, &dst_device);
+  }
+  if (!s.ok()) {
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  bool batched = false;
+  RpcRecvTensorBatchCall* full_batch = nullptr;
+  {
+    mutex_lock l(batches_mu_);
+    if (unbatched_workers_.count(src_worker) == 0) {
+      RpcRecvTensorBatchCall*& batch = pending_batches_[src_worker];
+      if (batch == nullptr) {
+        batch = new RpcRecvTensorBatchCall(src_worker, step_id_);
+        Ref();
+        SchedClosure([this, src_worker]() {
+          FlushBatch(src_worker);
+          Unref();
+        });
+      }
+      batch->Add(parsed, recv_args, dst_device, std::move(done));
+      batched = true;
+      if (batch->size() >= max_batch_size) {
+        full_batch = batch;
+        pending_batches_.erase(src_worker);
+      }
+    }
+  }
+  if (!batched) {
+    RecvFromRemoteUnbatchedAsync(parsed, recv_args, std::move(done));
+  } else if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker) {
+  RpcRecvTensorBatchCall* batch = nullptr;
+  {
+    mutex_lock l(batches_mu_);
+    auto it = pending_batches_.find(src_worker);
+    if (it != pending_batches_.end()) {
+      batch = it->second;
+      pending_batches_.erase(it);
+    }
+  }
+  if (batch != nullptr) {
+    StartBatch(batch);
+  }
+}
+
+void RpcRemoteRendezvous::StartBatch(RpcRecvTensorBatchCall* batch) {
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(batch->src_worker());
+  if (rwi == nullptr) {
+    batch->Fail(errors::Internal("No worker known as ", batch->src_worker()));
+    delete batch;
+    return;
+  }
+  batch->set_worker(rwi);
+
+  // Record "batch" in active_ so that it can be aborted cleanly.
+  RegisterCall(batch);
+
+  Ref();
+  batch->Start([this, batch]() {
+    DeregisterCall(batch);
+    session()->worker_cache->ReleaseWorker(batch->src_worker(),
+                                           batch->worker());
+    if (batch->unimplemented()) {
+      // Fall back to one RecvTensor call per tensor.
+      {
+        mutex_lock l(batches_mu_);
+        unbatched_workers_.insert(batch->src_worker());
+      }
+      for (RpcRecvTensorBatchCall::Recv& recv : *batch->mutable_recvs()) {
+        RecvFromRemoteUnbatchedAsync(recv.parsed, recv.recv_args,
+                                     std::move(recv.done));
+      }
+    }
+    delete batch;
+    Unref();
+  });
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
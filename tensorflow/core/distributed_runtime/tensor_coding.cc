@@ -18,8 +18,11 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 
@@ -30,6 +33,7 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  host_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -48,6 +52,16 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
     on_host_ = true;
   }
   allocator_ = device_->GetAllocator(alloc_attrs_);
+  if (on_host_) {
+    host_allocator_ = allocator_;
+  } else if (device_->tensorflow_gpu_device_info() != nullptr &&
+             device_->tensorflow_gpu_device_info()->default_context !=
+                 nullptr) {
+    AllocatorAttributes host_alloc_attrs;
+    host_alloc_attrs.set_on_host(true);
+    host_alloc_attrs.set_gpu_compatible(true);
+    host_allocator_ = device_->GetAllocator(host_alloc_attrs);
+  }
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
@@ -79,7 +93,18 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response) {
 }
 
 Status TensorResponse::ParseFrom(Source* source) {
+  if (already_used_) {
+    ClearTensor();
+  }
+  already_used_ = true;
   if (!on_host_) {
+    // Parse the tensor contents straight from the wire into pinned host
+    // memory, and copy them to the device from there.
+    if (host_allocator_ != nullptr && ParseFast(source)) {
+      return CopyToDevice();
+    }
+    meta_.Clear();
+
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
 
@@ -87,6 +112,20 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (IsCompressedRecvTensor(meta_)) {
+      Tensor decompressed;
+      TF_RETURN_IF_ERROR(DecompressRecvTensor(
+          meta_, host_allocator_ != nullptr ? host_allocator_ : cpu_allocator(),
+          &decompressed));
+      meta_.clear_compression();
+      meta_.clear_original_dtype();
+      if (host_allocator_ != nullptr) {
+        meta_.clear_tensor();
+        tensor_ = std::move(decompressed);
+        return CopyToDevice();
+      }
+      decompressed.AsProtoTensorContent(meta_.mutable_tensor());
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -97,10 +136,6 @@ Status TensorResponse::ParseFrom(Source* source) {
     meta_.clear_tensor();
     return s;
   }
-  if (already_used_) {
-    ClearTensor();
-  }
-  already_used_ = true;
   if (ParseFast(source)) return Status::OK();
   meta_.Clear();
   if (ParseSlow(source)) return Status::OK();
@@ -155,7 +190,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(host_allocator_, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -195,7 +230,7 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(host_allocator_, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -276,7 +311,13 @@ bool TensorResponse::ParseSlow(Source* source) {
   }
 
   Tensor parsed(meta_.tensor().dtype());
-  if (!parsed.FromProto(allocator_, meta_.tensor())) {
+  if (IsCompressedRecvTensor(meta_)) {
+    if (!DecompressRecvTensor(meta_, host_allocator_, &parsed).ok()) {
+      return false;
+    }
+    meta_.clear_compression();
+    meta_.clear_original_dtype();
+  } else if (!parsed.FromProto(host_allocator_, meta_.tensor())) {
     return false;
   }
   tensor_ = std::move(parsed);
@@ -291,4 +332,130 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+Status TensorResponse::CopyToDevice() {
+  Tensor host_tensor;
+  std::swap(host_tensor, tensor_);
+  Tensor device_tensor(allocator_, host_tensor.dtype(), host_tensor.shape());
+  DeviceContext* device_context =
+      device_->tensorflow_gpu_device_info()->default_context;
+  Notification n;
+  Status status;
+  // A device with GPU device info is a Device.
+  device_context->CopyCPUTensorToDevice(
+      &host_tensor, static_cast<Device*>(device_), &device_tensor,
+      [&n, &status](const Status& s) {
+        status = s;
+        n.Notify();
+      });
+  n.WaitForNotification();
+  if (status.ok()) {
+    tensor_ = std::move(device_tensor);
+  }
+  return status;
+}
+
+bool CompressRecvTensor(const RecvTensorCompression& compression,
+                        const Tensor& val, RecvTensorResponse* response) {
+  const bool downcast = val.dtype() == DT_FLOAT &&
+                        (compression.lossy_dtype() == DT_HALF ||
+                         compression.lossy_dtype() == DT_BFLOAT16);
+  if ((compression.algorithm() == RecvTensorCompression::NONE && !downcast) ||
+      !DataTypeCanUseMemcpy(val.dtype()) ||
+      static_cast<int64>(val.TotalBytes()) < compression.min_bytes()) {
+    return false;
+  }
+
+  Tensor sent = val;
+  if (downcast) {
+    sent = Tensor(cpu_allocator(), compression.lossy_dtype(), val.shape());
+    if (sent.dtype() == DT_BFLOAT16) {
+      FloatToBFloat16(val.flat<float>().data(), sent.flat<bfloat16>().data(),
+                      val.NumElements());
+    } else {
+      sent.flat<Eigen::half>() = val.flat<float>().cast<Eigen::half>();
+    }
+    response->set_original_dtype(DT_FLOAT);
+  }
+
+  TensorProto* proto = response->mutable_tensor();
+  proto->set_dtype(sent.dtype());
+  sent.shape().AsProto(proto->mutable_tensor_shape());
+  StringPiece content = sent.tensor_data();
+  if (compression.algorithm() == RecvTensorCompression::SNAPPY &&
+      port::Snappy_Compress(content.data(), content.size(),
+                            proto->mutable_tensor_content()) &&
+      proto->tensor_content().size() < content.size()) {
+    response->set_compression(RecvTensorCompression::SNAPPY);
+    return true;
+  }
+  // Compression didn't help, but downcasting still does.
+  if (!downcast) {
+    return false;
+  }
+  proto->set_tensor_content(content.data(), content.size());
+  return true;
+}
+
+Status DecompressRecvTensor(const RecvTensorResponse& response,
+                            Allocator* allocator, Tensor* result) {
+  const TensorProto& proto = response.tensor();
+  if (!DataTypeCanUseMemcpy(proto.dtype()) ||
+      !TensorShape::IsValid(proto.tensor_shape())) {
+    return errors::InvalidArgument("Cannot parse tensor from response");
+  }
+  const DataType dtype = response.original_dtype() == DT_INVALID
+                             ? proto.dtype()
+                             : response.original_dtype();
+  const TensorShape shape(proto.tensor_shape());
+
+  // Downcast tensors are decompressed to a temporary tensor first.
+  Tensor sent(dtype == proto.dtype() ? allocator : cpu_allocator(),
+              proto.dtype(), shape);
+  char* buf = const_cast<char*>(sent.tensor_data().data());
+  const size_t num_bytes = sent.TotalBytes();
+  const string& content = proto.tensor_content();
+  switch (response.compression()) {
+    case RecvTensorCompression::NONE:
+      if (content.size() != num_bytes) {
+        return errors::InvalidArgument("Cannot parse tensor from response");
+      }
+      memcpy(buf, content.data(), num_bytes);
+      break;
+    case RecvTensorCompression::SNAPPY: {
+      size_t uncompressed_length;
+      if (!port::Snappy_GetUncompressedLength(content.data(), content.size(),
+                                              &uncompressed_length) ||
+          uncompressed_length != num_bytes ||
+          !port::Snappy_Uncompress(content.data(), content.size(), buf)) {
+        return errors::InvalidArgument(
+            "Cannot decompress tensor from response");
+      }
+      break;
+    }
+    default:
+      return errors::Unimplemented("Unknown tensor compression ",
+                                   response.compression());
+  }
+
+  if (dtype == proto.dtype()) {
+    *result = std::move(sent);
+    return Status::OK();
+  }
+  if (dtype != DT_FLOAT ||
+      (sent.dtype() != DT_HALF && sent.dtype() != DT_BFLOAT16)) {
+    return errors::InvalidArgument("Cannot cast ", DataTypeString(sent.dtype()),
+                                   " tensor from response to ",
+                                   DataTypeString(dtype));
+  }
+  Tensor upcast(allocator, DT_FLOAT, shape);
+  if (sent.dtype() == DT_BFLOAT16) {
+    BFloat16ToFloat(sent.flat<bfloat16>().data(), upcast.flat<float>().data(),
+                    upcast.NumElements());
+  } else {
+    upcast.flat<float>() = sent.flat<Eigen::half>().cast<float>();
+  }
+  *result = std::move(upcast);
+  return Status::OK();
+}
+
 }  // namespace tensorflow
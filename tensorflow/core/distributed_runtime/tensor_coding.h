@@ -92,16 +92,40 @@ class TensorResponse {
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
+  Status CopyToDevice();
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // The allocator of the tensors parsed from the wire: allocator_ if the
+  // tensor is received on the host, or pinned host memory from which it is
+  // copied to a GPU. Null if the device can only make tensors from protos.
+  Allocator* host_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
 };
 
+// Sets `response->tensor` to `val` compressed as `compression` asks, and
+// returns true. Returns false if `val` should be sent unchanged instead: if it
+// is smaller than `compression.min_bytes()`, can't be compressed, or doesn't
+// get smaller. Leaves `*response` with unspecified contents in that case.
+bool CompressRecvTensor(const RecvTensorCompression& compression,
+                        const Tensor& val, RecvTensorResponse* response);
+
+// Returns true if the tensor of `response` was compressed by
+// CompressRecvTensor.
+inline bool IsCompressedRecvTensor(const RecvTensorResponse& response) {
+  return response.compression() != RecvTensorCompression::NONE ||
+         response.original_dtype() != DT_INVALID;
+}
+
+// Decompresses the tensor of `response` into a tensor allocated by
+// `allocator`.
+Status DecompressRecvTensor(const RecvTensorResponse& response,
+                            Allocator* allocator, Tensor* result);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
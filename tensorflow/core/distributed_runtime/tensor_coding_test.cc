@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -46,6 +48,59 @@ class DummyDevice : public DeviceBase {
   DeviceAttributes attr_;
 };
 
+// A device that copies tensors received from the host to its own allocator, as
+// a GPU does.
+class FakeGpuDevice : public Device {
+ public:
+  class CopyingDeviceContext : public DeviceContext {
+   public:
+    void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
+                               Tensor* device_tensor,
+                               StatusCallback done) const override {
+      ++*num_copies;
+      StringPiece src = cpu_tensor->tensor_data();
+      memcpy(const_cast<char*>(device_tensor->tensor_data().data()),
+             src.data(), src.size());
+      done(Status::OK());
+    }
+
+    int* num_copies;
+  };
+
+  explicit FakeGpuDevice(Env* env) : Device(env, MakeAttributes()) {
+    device_context_ = new CopyingDeviceContext;
+    device_context_->num_copies = &num_copies_;
+    gpu_device_info_.default_context = device_context_;
+    set_tensorflow_gpu_device_info(&gpu_device_info_);
+  }
+  ~FakeGpuDevice() override { device_context_->Unref(); }
+
+  Status Sync() override { return Status::OK(); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    if (attr.on_host()) {
+      ++num_host_allocators_;
+    }
+    return cpu_allocator();
+  }
+
+  int num_copies() const { return num_copies_; }
+  int num_host_allocators() const { return num_host_allocators_; }
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attributes;
+    attributes.set_name("/job:localhost/replica:0/task:0/device:GPU:0");
+    attributes.set_device_type("GPU");
+    return attributes;
+  }
+
+  CopyingDeviceContext* device_context_;
+  GpuDeviceInfo gpu_device_info_;
+  int num_copies_ = 0;
+  int num_host_allocators_ = 0;
+};
+
 class StringSource : public TensorResponse::Source {
  public:
   explicit StringSource(const string* s, int block_size)
@@ -156,6 +211,59 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, CopiesToGpuFromHost) {
+  Tensor src(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&src, {1, 2, 3, 4, 5, 6});
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  StringSource source(&encoded, 4);
+
+  FakeGpuDevice gpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&gpu_device, AllocatorAttributes());
+  EXPECT_EQ(1, gpu_device.num_host_allocators());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(1, gpu_device.num_copies());
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
+TEST_F(TensorResponseTest, ParsesCompressedTensor) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  for (int i = 0; i < 1000; ++i) {
+    // Exactly representable as bfloat16.
+    src.flat<float>()(i) = i % 10;
+  }
+  RecvTensorCompression compression;
+  compression.set_algorithm(RecvTensorCompression::SNAPPY);
+  compression.set_lossy_dtype(DT_BFLOAT16);
+  RecvTensorResponse proto;
+  ASSERT_TRUE(CompressRecvTensor(compression, src, &proto));
+  EXPECT_EQ(DT_BFLOAT16, proto.tensor().dtype());
+  EXPECT_LT(proto.tensor().tensor_content().size(), src.TotalBytes());
+  string encoded;
+  proto.AppendToString(&encoded);
+  StringSource source(&encoded, 64);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_FALSE(IsCompressedRecvTensor(response.metadata()));
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
+TEST_F(TensorResponseTest, DoesNotCompressSmallTensors) {
+  Tensor src(DT_FLOAT, TensorShape({16}));
+  src.flat<float>().setZero();
+  RecvTensorCompression compression;
+  compression.set_algorithm(RecvTensorCompression::SNAPPY);
+  compression.set_min_bytes(1024);
+  RecvTensorResponse proto;
+  EXPECT_FALSE(CompressRecvTensor(compression, src, &proto));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -29,7 +29,9 @@ class CollectiveExecutorMgrInterface;
 class Device;
 class DeviceMgr;
 class Env;
+class RemoteMemoryManager;
 class RendezvousMgrInterface;
+class RPCOptions;
 class SessionMgr;
 
 // The worker environment class, which holds a bag of pointers to
@@ -64,6 +66,15 @@ struct WorkerEnv {
 
   // A pool of threads for scheduling compute work.
   thread::ThreadPool* compute_pool = nullptr;
+
+  // The options of the RPCs of this worker, e.g. the compression of the
+  // tensors it receives. May be null.
+  const RPCOptions* rpc_options = nullptr;
+
+  // If set, tensor content is transferred out of band by this transport,
+  // e.g. with RDMA, and RecvTensor RPCs carry only transport options. May be
+  // null.
+  RemoteMemoryManager* remote_memory_manager = nullptr;
 };
 
 }  // end namespace tensorflow
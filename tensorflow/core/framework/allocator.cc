@@ -31,6 +31,8 @@ void AllocatorStats::Clear() {
   this->max_bytes_in_use = 0;
   this->max_alloc_size = 0;
   this->bytes_limit = 0;
+  this->bytes_reserved = 0;
+  this->largest_free_block_bytes = 0;
 }
 
 string AllocatorStats::DebugString() const {
@@ -39,9 +41,12 @@ string AllocatorStats::DebugString() const {
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
       "NumAllocs:    %20lld\n"
-      "MaxAllocSize: %20lld\n",
+      "MaxAllocSize: %20lld\n"
+      "Reserved:     %20lld\n"
+      "LargestFree:  %20lld\n",
       this->bytes_limit, this->bytes_in_use, this->max_bytes_in_use,
-      this->num_allocs, this->max_alloc_size);
+      this->num_allocs, this->max_alloc_size, this->bytes_reserved,
+      this->largest_free_block_bytes);
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
@@ -87,6 +92,7 @@ static int64_t TotalAllocationWarningBytes() {
 void EnableCPUAllocatorStats(bool enable) {
   cpu_allocator_collect_stats = enable;
 }
+bool CPUAllocatorStatsEnabled() { return cpu_allocator_collect_stats; }
 void EnableCPUAllocatorFullStats(bool enable) {
   cpu_allocator_collect_full_stats = enable;
 }
@@ -57,6 +57,13 @@ struct AllocatorStats {
   // unknown.
   int64 bytes_limit;
 
+  // Fragmentation metrics, for allocators that manage memory reserved from
+  // an underlying allocator; 0 if unknown. Of the bytes_reserved -
+  // bytes_in_use reserved bytes that are not in use, at most
+  // largest_free_block_bytes can be returned by a single allocation.
+  int64 bytes_reserved;            // Number of bytes reserved.
+  int64 largest_free_block_bytes;  // Largest contiguous free block.
+
   AllocatorStats() { Clear(); }
 
   void Clear();
@@ -386,6 +393,10 @@ Allocator* cpu_allocator();
 // AllocatorStats. By default, it's disabled.
 void EnableCPUAllocatorStats(bool enable);
 
+// Returns whether the default CPU allocator implementation collects
+// AllocatorStats.
+bool CPUAllocatorStatsEnabled();
+
 // If 'enable' is true, the default CPU allocator implementation will collect
 // full statistics. By default, it's disabled.
 void EnableCPUAllocatorFullStats(bool enable);
@@ -50,6 +50,7 @@ CollInstanceParams& CollInstanceParams::operator=(
     impl_details.subdiv_source_rank.assign(
         other.impl_details.subdiv_source_rank.begin(),
         other.impl_details.subdiv_source_rank.end());
+    impl_details.hierarchical = other.impl_details.hierarchical;
   }
   return *this;
 }
@@ -85,6 +86,9 @@ string CollInstanceParams::ToString() const {
     strings::StrAppend(&v, "}");
   }
   strings::StrAppend(&v, "}");  // all subdivs
+  if (impl_details.hierarchical) {
+    strings::StrAppend(&v, " hierarchical");
+  }
   return v;
 }
 
@@ -68,6 +68,9 @@ struct CollImplDetails {
   std::vector<int> subdiv_offsets;
   // broadcast only: rank of source in each subdiv
   std::vector<int> subdiv_source_rank;
+  // reduction only: if true, reduce within each task first, then run the
+  // ring across one device per task, then broadcast back within each task.
+  bool hierarchical = false;
 };
 
 // Data common to all members of a collective instance.
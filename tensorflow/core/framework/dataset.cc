@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/util/batch_util.h"
 
 namespace tensorflow {
 
@@ -210,6 +211,56 @@ Status GraphDatasetBase::Serialize(OpKernelContext* ctx,
   return Status::OK();
 }
 
+Status IteratorBase::GetNextIntoBatch(IteratorContext* ctx, int64 index,
+                                      std::vector<Tensor>* batch,
+                                      bool* end_of_sequence) {
+  std::vector<Tensor> element;
+  TF_RETURN_IF_ERROR(GetNext(ctx, &element, end_of_sequence));
+  if (*end_of_sequence) return Status::OK();
+  return CopyElementToBatch(&element, index, batch);
+}
+
+/* static */
+Status IteratorBase::ValidateBatchSlice(const Tensor& component,
+                                        const Tensor& batch_component,
+                                        size_t component_index, int64 index) {
+  if (component.dtype() != batch_component.dtype()) {
+    return errors::InvalidArgument(
+        "Cannot batch tensors with different types in component ",
+        component_index, ". Batch has type ",
+        DataTypeString(batch_component.dtype()), " and element ", index,
+        " had type ", DataTypeString(component.dtype()), ".");
+  }
+  TensorShape slice_shape = batch_component.shape();
+  slice_shape.RemoveDim(0);
+  if (component.shape() != slice_shape) {
+    return errors::InvalidArgument(
+        "Cannot batch tensors with different shapes in component ",
+        component_index, ". First element had shape ",
+        slice_shape.DebugString(), " and element ", index, " had shape ",
+        component.shape().DebugString(), ".");
+  }
+  return Status::OK();
+}
+
+/* static */
+Status IteratorBase::CopyElementToBatch(std::vector<Tensor>* element,
+                                        int64 index,
+                                        std::vector<Tensor>* batch) {
+  if (element->size() != batch->size()) {
+    return errors::InvalidArgument("Cannot batch an element with ",
+                                   element->size(), " components into ",
+                                   batch->size(), " batch components.");
+  }
+  for (size_t i = 0; i < element->size(); ++i) {
+    TF_RETURN_IF_ERROR(ValidateBatchSlice((*element)[i], (*batch)[i], i,
+                                          index));
+    TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+        std::move((*element)[i]), &(*batch)[i], index));
+  }
+  return Status::OK();
+}
+
 Status GetDatasetFromVariantTensor(const Tensor& tensor,
                                    DatasetBase** out_dataset) {
   if (!(tensor.dtype() == DT_VARIANT ||
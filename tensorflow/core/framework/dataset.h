@@ -15,13 +15,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_DATASET_H_
 #define TENSORFLOW_CORE_FRAMEWORK_DATASET_H_
 
+#include <algorithm>
 #include <memory>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/dataset_scheduler.h"
 #include "tensorflow/core/framework/dataset_stateful_op_whitelist.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -275,6 +278,14 @@ class IteratorContext {
 
     // The Allocator to be used to allocate the output of an iterator.
     std::function<Allocator*(AllocatorAttributes)> allocator_getter = nullptr;
+
+    // If non-null, iterators created with this context add themselves to
+    // this performance model, which tunes their parameters.
+    std::shared_ptr<model::Model> model = nullptr;
+
+    // If non-null, parallel iterators run their background work on this
+    // pipeline of the process-wide `DatasetScheduler`.
+    std::shared_ptr<DatasetScheduler::Pipeline> scheduler = nullptr;
   };
 
   explicit IteratorContext(Params params) : params_(std::move(params)) {}
@@ -313,6 +324,20 @@ class IteratorContext {
     return params_.stats_aggregator_getter;
   }
 
+  std::shared_ptr<model::Model> model() { return params_.model; }
+
+  void set_model(std::shared_ptr<model::Model> model) {
+    params_.model = std::move(model);
+  }
+
+  std::shared_ptr<DatasetScheduler::Pipeline> scheduler() {
+    return params_.scheduler;
+  }
+
+  void set_scheduler(std::shared_ptr<DatasetScheduler::Pipeline> scheduler) {
+    params_.scheduler = std::move(scheduler);
+  }
+
  private:
   Params params_;
 };
@@ -341,6 +366,20 @@ class IteratorBase {
   virtual Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
 
+  // Gets the next output like `GetNext()`, but writes its components into
+  // row `index` of the respective tensors in `*batch`, which must have been
+  // allocated with the type of the component and a shape of
+  // `[batch_size] + component_shape`. The output is not stored anywhere else.
+  //
+  // The default implementation copies the output of `GetNext()`. Iterators
+  // that can produce their output directly into `*batch` should override it.
+  //
+  // This method is thread-safe, as long as concurrent callers write into
+  // distinct rows.
+  virtual Status GetNextIntoBatch(IteratorContext* ctx, int64 index,
+                                  std::vector<Tensor>* batch,
+                                  bool* end_of_sequence);
+
   // Returns a vector of DataType values, representing the respective
   // element types of each tuple component in the outputs of this
   // iterator.
@@ -382,6 +421,18 @@ class IteratorBase {
     return parent->RestoreInternal(ctx, reader);
   }
 
+  // Returns an error if `component` cannot be written into row `index` of
+  // `batch_component`, because its type or shape differs from the slices of
+  // `batch_component`.
+  static Status ValidateBatchSlice(const Tensor& component,
+                                   const Tensor& batch_component,
+                                   size_t component_index, int64 index);
+
+  // Moves (or, if `element` shares its buffers, copies) the components of
+  // `element` into row `index` of the respective tensors in `*batch`.
+  static Status CopyElementToBatch(std::vector<Tensor>* element, int64 index,
+                                   std::vector<Tensor>* batch);
+
   // Saves the state of this iterator recursively.
   virtual Status SaveInternal(IteratorStateWriter* writer) {
     return errors::Unimplemented("SaveInternal");
@@ -392,6 +443,14 @@ class IteratorBase {
                                  IteratorStateReader* reader) {
     return errors::Unimplemented("RestoreInternal");
   }
+
+ private:
+  friend class DatasetBase;
+
+  // Called by `DatasetBase::MakeIterator()` before `Initialize()`, with the
+  // prefix of the iterator that consumes this one.
+  virtual void InitializeBase(IteratorContext* ctx,
+                              const string& output_prefix) {}
 };
 
 // Represents a (potentially infinite) range of outputs, where each
@@ -411,6 +470,7 @@ class DatasetBase : public core::RefCounted {
   Status MakeIterator(IteratorContext* ctx, const string& prefix,
                       std::unique_ptr<IteratorBase>* iterator) const {
     *iterator = MakeIteratorInternal(prefix);
+    (*iterator)->InitializeBase(ctx, prefix);
     return (*iterator)->Initialize(ctx);
   }
 
@@ -513,7 +573,10 @@ class DatasetIterator : public IteratorBase {
     params_.dataset->Ref();
   }
 
-  ~DatasetIterator() override { params_.dataset->Unref(); }
+  ~DatasetIterator() override {
+    if (model_node_ != nullptr) model_->RemoveNode(model_node_);
+    params_.dataset->Unref();
+  }
 
   // The dataset from which this iterator was created.
   const DatasetType* dataset() const { return params_.dataset; }
@@ -531,17 +594,31 @@ class DatasetIterator : public IteratorBase {
 
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) final {
-    tracing::ScopedActivity activity(params_.prefix);
-    Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
-    if (TF_PREDICT_FALSE(errors::IsOutOfRange(s) && !*end_of_sequence)) {
-      s = errors::Internal(
-          "Iterator \"", params_.prefix,
-          "\" returned OutOfRange without setting `*end_of_sequence`. This "
-          "indicates that an error may have occurred. Original message: ",
-          s.error_message());
-      LOG(ERROR) << s;
-    }
-    return s;
+    return RecordGetNext(
+        ctx, end_of_sequence,
+        [&]() { return GetNextInternal(ctx, out_tensors, end_of_sequence); },
+        [&]() {
+          int64 bytes = 0;
+          for (const Tensor& t : *out_tensors) bytes += t.TotalBytes();
+          return bytes;
+        });
+  }
+
+  Status GetNextIntoBatch(IteratorContext* ctx, int64 index,
+                          std::vector<Tensor>* batch,
+                          bool* end_of_sequence) final {
+    return RecordGetNext(
+        ctx, end_of_sequence,
+        [&]() {
+          return GetNextIntoBatchInternal(ctx, index, batch, end_of_sequence);
+        },
+        [&]() {
+          int64 bytes = 0;
+          for (const Tensor& t : *batch) {
+            bytes += t.TotalBytes() / std::max<int64>(t.dim_size(0), 1);
+          }
+          return bytes;
+        });
   }
 
   Status Save(OpKernelContext* ctx, IteratorStateWriter* writer) final {
@@ -555,12 +632,93 @@ class DatasetIterator : public IteratorBase {
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) = 0;
 
+  // Internal implementation of GetNextIntoBatch that is wrapped in tracing
+  // logic. The default implementation copies the output of
+  // `GetNextInternal()`.
+  virtual Status GetNextIntoBatchInternal(IteratorContext* ctx, int64 index,
+                                          std::vector<Tensor>* batch,
+                                          bool* end_of_sequence) {
+    std::vector<Tensor> element;
+    TF_RETURN_IF_ERROR(GetNextInternal(ctx, &element, end_of_sequence));
+    if (*end_of_sequence) return Status::OK();
+    return CopyElementToBatch(&element, index, batch);
+  }
+
   string full_name(const string& name) const {
     return strings::StrCat(prefix(), ":", name);
   }
 
+  // The node of this iterator in the performance model of its pipeline, or
+  // nullptr if it has none. Set before `Initialize()` is called.
+  model::Node* model_node() const { return model_node_; }
+
  private:
+  // Runs `get_next`, which produces the next output of this iterator, with
+  // tracing and, if the pipeline has a model, the recording of its time.
+  // If the model profiles the pipeline, also records the latency of the
+  // output and its size, as returned by `output_bytes`.
+  template <typename GetNextFn, typename OutputBytesFn>
+  Status RecordGetNext(IteratorContext* ctx, bool* end_of_sequence,
+                       const GetNextFn& get_next,
+                       const OutputBytesFn& output_bytes) {
+    tracing::ScopedActivity activity(params_.prefix);
+    if (is_root_) {
+      // Lets iterators created while producing the element, e.g. by
+      // interleave, join the model and the scheduler of this pipeline.
+      if (ctx->model() == nullptr) ctx->set_model(model_);
+      if (ctx->scheduler() == nullptr) ctx->set_scheduler(scheduler_);
+    }
+    if (model_node_ == nullptr) {
+      return CheckGetNextStatus(get_next(), end_of_sequence);
+    }
+    const bool is_model_output = model_->IsOutput(model_node_);
+    const bool profiling = model_->profiling();
+    const int64 start_micros = profiling ? ctx->env()->NowMicros() : 0;
+    model::Model::RecordStart(model_node_);
+    Status s = get_next();
+    model::Model::RecordStop(model_node_);
+    if (s.ok() && !*end_of_sequence) {
+      model_node_->record_element();
+      if (profiling) {
+        model_node_->record_output(ctx->env()->NowMicros() - start_micros,
+                                   output_bytes());
+      }
+    }
+    if (is_model_output) {
+      model_->MaybeOptimize();
+      model_->MaybeLogProfile(s.ok() && *end_of_sequence);
+    }
+    return CheckGetNextStatus(s, end_of_sequence);
+  }
+
+  Status CheckGetNextStatus(Status s, bool* end_of_sequence) {
+    if (TF_PREDICT_FALSE(errors::IsOutOfRange(s) && !*end_of_sequence)) {
+      s = errors::Internal(
+          "Iterator \"", params_.prefix,
+          "\" returned OutOfRange without setting `*end_of_sequence`. This "
+          "indicates that an error may have occurred. Original message: ",
+          s.error_message());
+      LOG(ERROR) << s;
+    }
+    return s;
+  }
+
+  void InitializeBase(IteratorContext* ctx,
+                      const string& output_prefix) final {
+    // The consumer of a root iterator is not an iterator, e.g. "Iterator".
+    is_root_ = !str_util::StrContains(output_prefix, "::");
+    if (is_root_) scheduler_ = ctx->scheduler();
+    model_ = ctx->model();
+    if (model_ != nullptr) {
+      model_node_ = model_->AddNode(params_.prefix, output_prefix);
+    }
+  }
+
   Params params_;
+  bool is_root_ = false;
+  std::shared_ptr<DatasetScheduler::Pipeline> scheduler_;
+  std::shared_ptr<model::Model> model_;
+  model::Node* model_node_ = nullptr;
 };
 
 // Encapsulates the work required to plug a DatasetBase into the core TensorFlow
@@ -0,0 +1,232 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/dataset_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+// How often the monitor checks for stalled work.
+constexpr int64 kMonitorPeriodMillis = 10;
+// Queued work is stalled if no task has started for this long.
+constexpr uint64 kStallMicros = 10 * 1000;
+
+}  // namespace
+
+constexpr int64 DatasetScheduler::kMaxPriority;
+
+struct DatasetScheduler::Pipeline::Queue {
+  // A heap, with the task to run next at the front.
+  std::vector<Task> tasks;
+  // Whether the pipeline has no open handle.
+  bool closed = false;
+};
+
+/* static */
+bool DatasetScheduler::RunsAfter(const Task& a, const Task& b) {
+  if (a.priority != b.priority) return a.priority < b.priority;
+  return a.sequence > b.sequence;
+}
+
+DatasetScheduler::Pipeline::~Pipeline() {
+  scheduler_->ClosePipeline(queue_.get());
+}
+
+void DatasetScheduler::Pipeline::Schedule(std::function<void()> fn,
+                                          int64 priority) {
+  scheduler_->Schedule(queue_.get(), std::move(fn), priority);
+}
+
+std::function<void(std::function<void()>)> DatasetScheduler::Pipeline::Runner(
+    int64 priority) {
+  std::shared_ptr<Pipeline> pipeline = shared_from_this();
+  return [pipeline, priority](std::function<void()> fn) {
+    pipeline->Schedule(std::move(fn), priority);
+  };
+}
+
+/* static */
+DatasetScheduler* DatasetScheduler::Global() {
+  static DatasetScheduler* global = [] {
+    const int num_threads = std::max(port::NumSchedulableCPUs(), 1);
+    return new DatasetScheduler(Env::Default(), "tf_data_scheduler",
+                                num_threads, 4 * num_threads);
+  }();
+  return global;
+}
+
+DatasetScheduler::DatasetScheduler(Env* env, const string& name,
+                                   int num_threads, int max_threads)
+    : env_(env),
+      name_(name),
+      num_threads_(num_threads),
+      max_threads_(std::max(num_threads, max_threads)),
+      max_active_(num_threads) {
+  CHECK_GE(num_threads, 1);
+  mutex_lock l(mu_);
+  for (int i = 0; i < num_threads_; ++i) {
+    threads_.emplace_back(env_->StartThread(
+        {}, name_, std::bind(&DatasetScheduler::WorkerLoop, this)));
+  }
+  monitor_thread_.reset(env_->StartThread(
+      {}, strings::StrCat(name_, "_monitor"),
+      std::bind(&DatasetScheduler::MonitorLoop, this)));
+}
+
+DatasetScheduler::~DatasetScheduler() {
+  std::vector<std::unique_ptr<Thread>> threads;
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    std::swap(threads, threads_);
+  }
+  worker_cond_.notify_all();
+  monitor_cond_.notify_all();
+  // Joins the threads.
+  threads.clear();
+  monitor_thread_.reset();
+}
+
+std::shared_ptr<DatasetScheduler::Pipeline> DatasetScheduler::NewPipeline() {
+  std::shared_ptr<Pipeline::Queue> queue(new Pipeline::Queue);
+  {
+    mutex_lock l(mu_);
+    queues_.push_back(queue);
+  }
+  return std::shared_ptr<Pipeline>(new Pipeline(this, std::move(queue)));
+}
+
+/* static */
+int64 DatasetScheduler::PriorityFromBufferFill(int64 num_buffered,
+                                               int64 capacity) {
+  if (capacity <= 0 || num_buffered <= 0) return kMaxPriority;
+  if (num_buffered >= capacity) return 0;
+  return kMaxPriority - kMaxPriority * num_buffered / capacity;
+}
+
+int DatasetScheduler::max_active() {
+  mutex_lock l(mu_);
+  return max_active_;
+}
+
+void DatasetScheduler::Schedule(Pipeline::Queue* queue,
+                                std::function<void()> fn, int64 priority) {
+  bool wake_monitor;
+  {
+    mutex_lock l(mu_);
+    queue->tasks.push_back({std::move(fn), priority, next_sequence_++});
+    std::push_heap(queue->tasks.begin(), queue->tasks.end(), RunsAfter);
+    wake_monitor = num_pending_ == 0;
+    ++num_pending_;
+  }
+  worker_cond_.notify_one();
+  if (wake_monitor) monitor_cond_.notify_one();
+}
+
+void DatasetScheduler::ClosePipeline(Pipeline::Queue* queue) {
+  mutex_lock l(mu_);
+  queue->closed = true;
+  if (!queue->tasks.empty()) return;
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    if (queues_[i].get() == queue) {
+      RemoveQueue(i);
+      return;
+    }
+  }
+}
+
+void DatasetScheduler::RemoveQueue(size_t index) {
+  queues_.erase(queues_.begin() + index);
+  if (next_queue_ > index) --next_queue_;
+  if (next_queue_ >= queues_.size()) next_queue_ = 0;
+}
+
+std::function<void()> DatasetScheduler::PopTask() {
+  DCHECK_GT(num_pending_, 0);
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    const size_t index = (next_queue_ + i) % queues_.size();
+    Pipeline::Queue* queue = queues_[index].get();
+    if (queue->tasks.empty()) continue;
+    std::pop_heap(queue->tasks.begin(), queue->tasks.end(), RunsAfter);
+    std::function<void()> fn = std::move(queue->tasks.back().fn);
+    queue->tasks.pop_back();
+    --num_pending_;
+    next_queue_ = index + 1;
+    if (queue->closed && queue->tasks.empty()) {
+      RemoveQueue(index);
+    } else if (next_queue_ >= queues_.size()) {
+      next_queue_ = 0;
+    }
+    return fn;
+  }
+  LOG(FATAL) << "No queued task in " << name_;
+}
+
+void DatasetScheduler::WorkerLoop() {
+  bool ran_task = false;
+  while (true) {
+    std::function<void()> fn;
+    {
+      mutex_lock l(mu_);
+      if (ran_task) --num_active_;
+      while (!cancelled_ && (num_pending_ == 0 || num_active_ >= max_active_)) {
+        worker_cond_.wait(l);
+      }
+      if (cancelled_) return;
+      fn = PopTask();
+      ++num_active_;
+      last_start_micros_ = env_->NowMicros();
+    }
+    fn();
+    ran_task = true;
+  }
+}
+
+void DatasetScheduler::MonitorLoop() {
+  mutex_lock l(mu_);
+  while (!cancelled_) {
+    if (num_pending_ == 0 && max_active_ == num_threads_) {
+      monitor_cond_.wait(l);
+      continue;
+    }
+    WaitForMilliseconds(&l, &monitor_cond_, kMonitorPeriodMillis);
+    if (cancelled_) return;
+    const uint64 now = env_->NowMicros();
+    if (num_pending_ > 0 && num_active_ >= max_active_ &&
+        now - last_start_micros_ >= kStallMicros) {
+      if (max_active_ < max_threads_) {
+        ++max_active_;
+        VLOG(1) << name_ << ": work is stalled, allowing " << max_active_
+                << " threads to run";
+        if (threads_.size() < static_cast<size_t>(max_active_)) {
+          threads_.emplace_back(env_->StartThread(
+              {}, name_, std::bind(&DatasetScheduler::WorkerLoop, this)));
+        }
+        worker_cond_.notify_one();
+      }
+    } else if (max_active_ > num_threads_ && num_active_ < max_active_) {
+      --max_active_;
+    }
+  }
+}
+
+}  // namespace tensorflow
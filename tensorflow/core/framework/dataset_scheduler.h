@@ -0,0 +1,146 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_DATASET_SCHEDULER_H_
+#define TENSORFLOW_CORE_FRAMEWORK_DATASET_SCHEDULER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// DatasetScheduler runs the background work of the parallel stages of many
+// input pipelines on one set of threads, so that a process with several
+// pipelines does not create threads for each of their stages.
+//
+// Each pipeline submits work through its own Pipeline handle. The threads
+// take work from the pipelines in turn, so that a pipeline with a lot of
+// queued work does not starve the others; within a pipeline, work with a
+// higher priority runs first. Stages derive the priority of their work from
+// how full the buffer of their consumer is (PriorityFromBufferFill()), so
+// that work nobody is waiting for yields to work for starved consumers.
+//
+// Work may block, e.g. on an input iterator whose own work is queued behind
+// it. If queued work has not been able to start for a while because all
+// threads are busy, the scheduler lets one more thread run, up to
+// `max_threads`, and gives back the extra threads once they are not needed.
+//
+// Thread-safe.
+class DatasetScheduler {
+ public:
+  // The priority of work for a consumer that has nothing buffered.
+  static constexpr int64 kMaxPriority = 100;
+
+  // A handle through which one input pipeline submits work. The pipeline
+  // leaves the scheduler when its last handle is deleted; work submitted
+  // before that still runs.
+  class Pipeline : public std::enable_shared_from_this<Pipeline> {
+   public:
+    ~Pipeline();
+
+    // Runs `fn` on a thread of the scheduler.
+    void Schedule(std::function<void()> fn, int64 priority = 0);
+
+    // Returns a function that schedules closures with `priority`, to be used
+    // as the runner of an IteratorContext.
+    std::function<void(std::function<void()>)> Runner(int64 priority);
+
+   private:
+    friend class DatasetScheduler;
+    struct Queue;
+
+    Pipeline(DatasetScheduler* scheduler, std::shared_ptr<Queue> queue)
+        : scheduler_(scheduler), queue_(std::move(queue)) {}
+
+    DatasetScheduler* const scheduler_;
+    const std::shared_ptr<Queue> queue_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Pipeline);
+  };
+
+  // The scheduler of the process, with one thread per schedulable CPU.
+  static DatasetScheduler* Global();
+
+  // Runs work on `num_threads` threads, or on up to `max_threads` while work
+  // is stalled.
+  DatasetScheduler(Env* env, const string& name, int num_threads,
+                   int max_threads);
+  // Waits for running work to finish. Work that has not started is dropped.
+  ~DatasetScheduler();
+
+  std::shared_ptr<Pipeline> NewPipeline();
+
+  // Returns the priority of work that fills a buffer holding `num_buffered`
+  // of `capacity` elements: kMaxPriority when it is empty, 0 when it is full.
+  static int64 PriorityFromBufferFill(int64 num_buffered, int64 capacity);
+
+  // The number of threads that may currently run work.
+  int max_active() LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Task {
+    std::function<void()> fn;
+    int64 priority;
+    // Orders tasks with the same priority by submission.
+    uint64 sequence;
+  };
+  // The heap order of tasks: whether `a` runs after `b`.
+  static bool RunsAfter(const Task& a, const Task& b);
+
+  void Schedule(Pipeline::Queue* queue, std::function<void()> fn,
+                int64 priority) LOCKS_EXCLUDED(mu_);
+  void ClosePipeline(Pipeline::Queue* queue) LOCKS_EXCLUDED(mu_);
+  // Takes the next task to run, visiting the pipelines in turn.
+  std::function<void()> PopTask() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RemoveQueue(size_t index) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void WorkerLoop();
+  // Grows and shrinks `max_active_`.
+  void MonitorLoop();
+
+  Env* const env_;
+  const string name_;
+  const int num_threads_;
+  const int max_threads_;
+
+  mutex mu_;
+  condition_variable worker_cond_;
+  condition_variable monitor_cond_;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  // The pipelines that have queued tasks or an open handle.
+  std::vector<std::shared_ptr<Pipeline::Queue>> queues_ GUARDED_BY(mu_);
+  // The pipeline to take the next task from.
+  size_t next_queue_ GUARDED_BY(mu_) = 0;
+  int64 num_pending_ GUARDED_BY(mu_) = 0;
+  uint64 next_sequence_ GUARDED_BY(mu_) = 0;
+  int num_active_ GUARDED_BY(mu_) = 0;
+  int max_active_ GUARDED_BY(mu_);
+  // When a task last started running.
+  uint64 last_start_micros_ GUARDED_BY(mu_) = 0;
+  std::vector<std::unique_ptr<Thread>> threads_ GUARDED_BY(mu_);
+  std::unique_ptr<Thread> monitor_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DatasetScheduler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_DATASET_SCHEDULER_H_
@@ -0,0 +1,146 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/dataset_scheduler.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Records the order in which tasks run.
+class Recorder {
+ public:
+  std::function<void()> Task(int id, BlockingCounter* counter) {
+    return [this, id, counter]() {
+      {
+        mutex_lock l(mu_);
+        ids_.push_back(id);
+      }
+      counter->DecrementCount();
+    };
+  }
+
+  std::vector<int> ids() {
+    mutex_lock l(mu_);
+    return ids_;
+  }
+
+ private:
+  mutex mu_;
+  std::vector<int> ids_;
+};
+
+TEST(DatasetSchedulerTest, RunsAllTasks) {
+  DatasetScheduler scheduler(Env::Default(), "test", 4, 4);
+  std::shared_ptr<DatasetScheduler::Pipeline> pipeline =
+      scheduler.NewPipeline();
+  const int kNumTasks = 1000;
+  BlockingCounter counter(kNumTasks);
+  std::atomic<int> num_run(0);
+  for (int i = 0; i < kNumTasks; ++i) {
+    pipeline->Schedule([&num_run, &counter]() {
+      ++num_run;
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_EQ(kNumTasks, num_run);
+}
+
+TEST(DatasetSchedulerTest, RunsHigherPriorityFirst) {
+  DatasetScheduler scheduler(Env::Default(), "test", 1, 1);
+  std::shared_ptr<DatasetScheduler::Pipeline> pipeline =
+      scheduler.NewPipeline();
+  Notification blocked;
+  Notification unblock;
+  pipeline->Schedule([&blocked, &unblock]() {
+    blocked.Notify();
+    unblock.WaitForNotification();
+  });
+  blocked.WaitForNotification();
+
+  Recorder recorder;
+  BlockingCounter counter(4);
+  pipeline->Schedule(recorder.Task(1, &counter), 1);
+  pipeline->Schedule(recorder.Task(3, &counter), 3);
+  pipeline->Schedule(recorder.Task(2, &counter), 2);
+  pipeline->Schedule(recorder.Task(4, &counter), 1);
+  unblock.Notify();
+  counter.Wait();
+  EXPECT_EQ(std::vector<int>({3, 2, 1, 4}), recorder.ids());
+}
+
+TEST(DatasetSchedulerTest, SharesThreadsBetweenPipelines) {
+  DatasetScheduler scheduler(Env::Default(), "test", 1, 1);
+  std::shared_ptr<DatasetScheduler::Pipeline> a = scheduler.NewPipeline();
+  std::shared_ptr<DatasetScheduler::Pipeline> b = scheduler.NewPipeline();
+  std::shared_ptr<DatasetScheduler::Pipeline> blocker =
+      scheduler.NewPipeline();
+  Notification blocked;
+  Notification unblock;
+  blocker->Schedule([&blocked, &unblock]() {
+    blocked.Notify();
+    unblock.WaitForNotification();
+  });
+  blocked.WaitForNotification();
+
+  // Even though `a` queues all of its work first, the pipelines take turns.
+  Recorder recorder;
+  BlockingCounter counter(6);
+  for (int i = 0; i < 3; ++i) {
+    a->Schedule(recorder.Task(0, &counter), DatasetScheduler::kMaxPriority);
+  }
+  for (int i = 0; i < 3; ++i) {
+    b->Schedule(recorder.Task(1, &counter), 0);
+  }
+  unblock.Notify();
+  counter.Wait();
+  EXPECT_EQ(std::vector<int>({0, 1, 0, 1, 0, 1}), recorder.ids());
+}
+
+TEST(DatasetSchedulerTest, GrowsWhenWorkIsStalled) {
+  DatasetScheduler scheduler(Env::Default(), "test", 1, 2);
+  std::shared_ptr<DatasetScheduler::Pipeline> pipeline =
+      scheduler.NewPipeline();
+  EXPECT_EQ(1, scheduler.max_active());
+  // The first task blocks the only thread until the second one runs, which
+  // needs the scheduler to let a second thread run.
+  Notification first_done;
+  Notification second_done;
+  pipeline->Schedule([&first_done, &second_done]() {
+    second_done.WaitForNotification();
+    first_done.Notify();
+  });
+  pipeline->Schedule([&second_done]() { second_done.Notify(); });
+  first_done.WaitForNotification();
+}
+
+TEST(DatasetSchedulerTest, PriorityFromBufferFill) {
+  EXPECT_EQ(DatasetScheduler::kMaxPriority,
+            DatasetScheduler::PriorityFromBufferFill(0, 10));
+  EXPECT_EQ(DatasetScheduler::kMaxPriority / 2,
+            DatasetScheduler::PriorityFromBufferFill(5, 10));
+  EXPECT_EQ(0, DatasetScheduler::PriorityFromBufferFill(10, 10));
+  EXPECT_EQ(DatasetScheduler::kMaxPriority,
+            DatasetScheduler::PriorityFromBufferFill(0, 0));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,383 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/model.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace model {
+namespace {
+
+// How often MaybeOptimize() re-tunes the model.
+constexpr int64 kOptimizationPeriodMicros = 100 * 1000;
+
+// How often MaybeLogProfile() logs the profile of the model.
+constexpr int64 kProfilePeriodMicros = 60 * 1000 * 1000;
+
+// The nodes the calling thread is working for, innermost last, with the
+// time since which the innermost one has been working.
+struct ActiveNode {
+  Node* node;
+  int64 start_micros;
+};
+
+std::vector<ActiveNode>* ActiveNodes() {
+  static thread_local std::vector<ActiveNode> active_nodes;
+  return &active_nodes;
+}
+
+}  // namespace
+
+Node::Node(Model* model, const string& name, Node* output)
+    : model_(model),
+      name_(name),
+      latency_(model->profiling() ? new histogram::ThreadSafeHistogram
+                                  : nullptr),
+      output_(output) {}
+
+void Node::record_output(int64 micros, int64 bytes) {
+  output_time_.fetch_add(micros, std::memory_order_relaxed);
+  output_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  if (latency_ != nullptr) latency_->Add(micros);
+}
+
+void Node::add_tunable_parallelism(std::atomic<int64>* value, int64 min,
+                                   int64 max, mutex* mu,
+                                   condition_variable* cond_var) {
+  set_asynchronous();
+  mutex_lock l(model_->mu_);
+  tunables_.push_back({value, min, std::max(min, max), mu, cond_var, min});
+}
+
+double Node::average_buffer_size() const {
+  const int64 num_samples = num_buffer_samples_.load(std::memory_order_relaxed);
+  if (num_samples == 0) return 0;
+  return static_cast<double>(
+             buffered_elements_.load(std::memory_order_relaxed)) /
+         num_samples;
+}
+
+double Node::CandidateParallelism() const {
+  int64 parallelism = 0;
+  for (const Tunable& tunable : tunables_) {
+    parallelism += tunable.candidate;
+  }
+  return std::max<int64>(parallelism, 1);
+}
+
+double Node::CurrentParallelism() const {
+  int64 parallelism = 0;
+  for (const Tunable& tunable : tunables_) {
+    parallelism += tunable.value->load();
+  }
+  return std::max<int64>(parallelism, 1);
+}
+
+void Node::EstimateTimes(double* output_time, double* total_time) const {
+  *output_time = 0;
+  *total_time = 0;
+  const int64 num_elements = this->num_elements();
+  if (num_elements == 0) return;
+  double self_time = static_cast<double>(processing_time()) / num_elements;
+  if (asynchronous()) self_time /= CandidateParallelism();
+  double input_time = 0;
+  for (const Node* input : inputs_) {
+    const double inputs_per_element =
+        static_cast<double>(input->num_elements()) / num_elements;
+    double input_output_time, input_total_time;
+    input->EstimateTimes(&input_output_time, &input_total_time);
+    input_time += inputs_per_element * input_output_time;
+    *total_time += inputs_per_element * input_total_time;
+  }
+  *total_time += self_time;
+  *output_time =
+      asynchronous() ? std::max(self_time, input_time) : self_time + input_time;
+}
+
+Model::Model() : Model(Options()) {}
+
+Model::Model(const Options& options)
+    : options_(options),
+      next_optimization_micros_(Env::Default()->NowMicros() +
+                                kOptimizationPeriodMicros),
+      next_profile_micros_(Env::Default()->NowMicros() +
+                           kProfilePeriodMicros) {}
+
+Model::~Model() {
+  mutex_lock l(mu_);
+  DCHECK(lookup_table_.empty()) << "Model destroyed before its iterators";
+}
+
+Node* Model::AddNode(const string& name, const string& output_name) {
+  mutex_lock l(mu_);
+  auto it = lookup_table_.find(output_name);
+  if (it == lookup_table_.end()) {
+    // Iterators created from input elements, e.g. by interleave, append
+    // "[<index>]" to the prefix of the iterator that consumes them.
+    StringPiece stripped = output_name;
+    if (str_util::EndsWith(stripped, "]")) {
+      const size_t pos = stripped.rfind('[');
+      if (pos != StringPiece::npos) {
+        it = lookup_table_.find(string(stripped.substr(0, pos)));
+      }
+    }
+  }
+  Node* output = it == lookup_table_.end() ? nullptr : it->second;
+  nodes_.emplace_back(new Node(this, name, output));
+  Node* node = nodes_.back().get();
+  if (output != nullptr) {
+    output->inputs_.push_back(node);
+  } else if (output_ == nullptr) {
+    output_ = node;
+  }
+  lookup_table_[name] = node;
+  return node;
+}
+
+void Model::RemoveNode(Node* node) {
+  mutex_lock l(mu_);
+  if (node->output_ != nullptr) {
+    auto& siblings = node->output_->inputs_;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), node),
+                   siblings.end());
+  }
+  for (Node* input : node->inputs_) {
+    input->output_ = nullptr;
+  }
+  if (output_ == node) output_ = nullptr;
+  auto it = lookup_table_.find(node->name());
+  if (it != lookup_table_.end() && it->second == node) {
+    lookup_table_.erase(it);
+  }
+  for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
+    if (it->get() == node) {
+      nodes_.erase(it);
+      break;
+    }
+  }
+}
+
+/* static */
+void Model::RecordStart(Node* node) {
+  std::vector<ActiveNode>* active_nodes = ActiveNodes();
+  const int64 now = Env::Default()->NowMicros();
+  if (!active_nodes->empty()) {
+    ActiveNode& enclosing = active_nodes->back();
+    if (!enclosing.node->asynchronous()) {
+      enclosing.node->add_processing_time(now - enclosing.start_micros);
+    }
+  }
+  active_nodes->push_back({node, now});
+}
+
+/* static */
+void Model::RecordStop(Node* node) {
+  std::vector<ActiveNode>* active_nodes = ActiveNodes();
+  DCHECK(!active_nodes->empty() && active_nodes->back().node == node);
+  const int64 now = Env::Default()->NowMicros();
+  // The time the consumer of an asynchronous node waits for an element is
+  // not spent producing it; the node records its own processing time.
+  if (!node->asynchronous()) {
+    node->add_processing_time(now - active_nodes->back().start_micros);
+  }
+  active_nodes->pop_back();
+  if (!active_nodes->empty()) {
+    active_nodes->back().start_micros = now;
+  }
+}
+
+void Model::CollectTunables(Node* node, std::vector<Node::Tunable*>* tunables) {
+  for (Node::Tunable& tunable : node->tunables_) {
+    tunables->push_back(&tunable);
+  }
+  for (Node* input : node->inputs_) {
+    CollectTunables(input, tunables);
+  }
+}
+
+void Model::Optimize(int64 cpu_budget) {
+  mutex_lock l(mu_);
+  Node* output = output_;
+  if (output == nullptr) return;
+  std::vector<Node::Tunable*> tunables;
+  CollectTunables(output, &tunables);
+  if (tunables.empty()) return;
+
+  int64 total_parallelism = 0;
+  for (Node::Tunable* tunable : tunables) {
+    tunable->candidate = tunable->min;
+    total_parallelism += tunable->min;
+  }
+  // Hill-climb: spend one unit of the budget at a time on whichever
+  // parameter reduces the estimated output time the most.
+  double output_time, total_time;
+  output->EstimateTimes(&output_time, &total_time);
+  while (total_parallelism < cpu_budget) {
+    Node::Tunable* best = nullptr;
+    double best_output_time = output_time;
+    double best_total_time = total_time;
+    for (Node::Tunable* tunable : tunables) {
+      if (tunable->candidate >= tunable->max) continue;
+      ++tunable->candidate;
+      double new_output_time, new_total_time;
+      output->EstimateTimes(&new_output_time, &new_total_time);
+      --tunable->candidate;
+      if (new_output_time < best_output_time ||
+          (new_output_time == best_output_time &&
+           new_total_time < best_total_time)) {
+        best = tunable;
+        best_output_time = new_output_time;
+        best_total_time = new_total_time;
+      }
+    }
+    if (best == nullptr) break;
+    ++best->candidate;
+    ++total_parallelism;
+    output_time = best_output_time;
+    total_time = best_total_time;
+  }
+
+  VLOG(2) << "Estimated output time of " << output->name() << ": "
+          << output_time << "us with a total parallelism of "
+          << total_parallelism;
+  for (Node::Tunable* tunable : tunables) {
+    if (tunable->value->load() == tunable->candidate) continue;
+    {
+      mutex_lock tunable_lock(*tunable->mu);
+      tunable->value->store(tunable->candidate);
+    }
+    tunable->cond_var->notify_all();
+  }
+}
+
+void Model::MaybeOptimize() {
+  if (!options_.autotune) return;
+  const int64 now = Env::Default()->NowMicros();
+  int64 next = next_optimization_micros_.load(std::memory_order_relaxed);
+  if (now < next) return;
+  // Only one of the threads that notice the deadline optimizes.
+  if (!next_optimization_micros_.compare_exchange_strong(
+          next, now + kOptimizationPeriodMicros)) {
+    return;
+  }
+  Optimize(port::NumSchedulableCPUs());
+}
+
+string Model::ProfileReport() {
+  struct Stage {
+    const Node* node;
+    // The number of elements of the stage per output element.
+    double ratio;
+    // The time the stage adds to an output element.
+    double time;
+  };
+  mutex_lock l(mu_);
+  const Node* output = output_;
+  if (output == nullptr || output->num_elements() == 0) {
+    return "The input pipeline has produced no elements yet.";
+  }
+  std::vector<Stage> stages;
+  std::vector<Stage> pending = {{output, 1.0, 0.0}};
+  double total_time = 0;
+  while (!pending.empty()) {
+    Stage stage = pending.back();
+    pending.pop_back();
+    const Node* node = stage.node;
+    const int64 num_elements = node->num_elements();
+    if (num_elements > 0) {
+      stage.time = stage.ratio * node->processing_time() / num_elements /
+                   node->CurrentParallelism();
+      for (const Node* input : node->inputs_) {
+        pending.push_back(
+            {input, stage.ratio * input->num_elements() / num_elements, 0.0});
+      }
+    }
+    total_time += stage.time;
+    stages.push_back(stage);
+  }
+  std::stable_sort(
+      stages.begin(), stages.end(),
+      [](const Stage& a, const Stage& b) { return a.time > b.time; });
+
+  string report = strings::StrCat(
+      "Profile of the input pipeline of ", output->name(), " after ",
+      output->num_elements(), " elements, ranked by the time each stage adds ",
+      "to an element:");
+  for (const Stage& stage : stages) {
+    const Node* node = stage.node;
+    const int64 num_elements = std::max<int64>(node->num_elements(), 1);
+    const double self_time =
+        static_cast<double>(node->processing_time()) / num_elements;
+    const double latency =
+        static_cast<double>(node->output_time()) / num_elements;
+    strings::Appendf(
+        &report,
+        "\n  %s: %.1fus (%.1f%%); %lld elements, %.1fus processing with a "
+        "parallelism of %.0f, %.1fus latency",
+        node->name().c_str(), stage.time,
+        total_time > 0 ? 100 * stage.time / total_time : 0.0,
+        static_cast<long long>(node->num_elements()), self_time,
+        node->CurrentParallelism(), latency);
+    if (node->latency_ != nullptr) {
+      strings::Appendf(&report, " (median %.1fus, p99 %.1fus)",
+                       node->latency_->Median(),
+                       node->latency_->Percentile(99));
+    }
+    // The consumer of an asynchronous stage waits for its buffer, while a
+    // synchronous stage waits for its inputs for the time it does not
+    // process.
+    if (node->asynchronous()) {
+      strings::Appendf(&report, ", %.1f elements buffered",
+                       node->average_buffer_size());
+    } else {
+      strings::Appendf(&report, ", %.1fus waiting for inputs",
+                       std::max(latency - self_time, 0.0));
+    }
+    strings::Appendf(&report, ", %lld bytes per element",
+                     static_cast<long long>(node->output_bytes() /
+                                            num_elements));
+  }
+  return report;
+}
+
+void Model::MaybeLogProfile(bool end_of_sequence) {
+  if (!options_.profile) return;
+  if (end_of_sequence) {
+    if (!logged_end_of_sequence_.exchange(true)) {
+      LOG(INFO) << ProfileReport();
+    }
+    return;
+  }
+  const int64 now = Env::Default()->NowMicros();
+  int64 next = next_profile_micros_.load(std::memory_order_relaxed);
+  if (now < next) return;
+  if (!next_profile_micros_.compare_exchange_strong(
+          next, now + kProfilePeriodMicros)) {
+    return;
+  }
+  LOG(INFO) << ProfileReport();
+}
+
+}  // namespace model
+}  // namespace tensorflow
@@ -0,0 +1,248 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
+#define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace model {
+
+// Passed as the parallelism of an input pipeline stage to let the model of
+// its pipeline choose it.
+constexpr int64 kAutoTune = -1;
+
+class Model;
+
+// A Node models one iterator of an input pipeline. It records how much time
+// the iterator spends producing its elements, and owns the parameters of the
+// iterator that the model tunes.
+//
+// The recording methods are lock-free, except record_output(), and may be
+// called from any thread.
+class Node {
+ public:
+  Node(Model* model, const string& name, Node* output);
+
+  // The prefix of the modeled iterator.
+  const string& name() const { return name_; }
+
+  // Records that the iterator spent `micros` producing its elements.
+  void add_processing_time(int64 micros) {
+    processing_time_.fetch_add(micros, std::memory_order_relaxed);
+  }
+
+  // Records that the iterator produced an element.
+  void record_element() {
+    num_elements_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Records that `num_buffered` elements were buffered by the iterator when
+  // its consumer asked for the next one.
+  void record_buffer_size(int64 num_buffered) {
+    buffered_elements_.fetch_add(num_buffered, std::memory_order_relaxed);
+    num_buffer_samples_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Records that the consumer of the iterator waited `micros` for an element
+  // of `bytes` bytes. Only called if the model profiles its pipeline.
+  void record_output(int64 micros, int64 bytes);
+
+  // Marks the iterator as producing its elements on threads of its own, so
+  // that the time its consumer waits for an element is not its processing
+  // time, and its inputs run concurrently with it.
+  void set_asynchronous() { asynchronous_ = true; }
+  bool asynchronous() const { return asynchronous_; }
+
+  // Lets the model choose the number of elements that the iterator produces
+  // in parallel, from [`min`, `max`]. The model stores its choice into
+  // `*value` while holding `*mu`, then notifies `*cond_var`. The iterator
+  // must not add or remove nodes while holding `*mu`.
+  //
+  // Implies set_asynchronous().
+  void add_tunable_parallelism(std::atomic<int64>* value, int64 min,
+                               int64 max, mutex* mu,
+                               condition_variable* cond_var);
+
+  int64 num_elements() const {
+    return num_elements_.load(std::memory_order_relaxed);
+  }
+  int64 processing_time() const {
+    return processing_time_.load(std::memory_order_relaxed);
+  }
+  // The average of the values passed to record_buffer_size().
+  double average_buffer_size() const;
+  // The sums of the values passed to record_output().
+  int64 output_time() const {
+    return output_time_.load(std::memory_order_relaxed);
+  }
+  int64 output_bytes() const {
+    return output_bytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class Model;
+
+  struct Tunable {
+    std::atomic<int64>* value;
+    int64 min;
+    int64 max;
+    mutex* mu;
+    condition_variable* cond_var;
+    // The value being evaluated by Model::Optimize().
+    int64 candidate;
+  };
+
+  // Estimates, given the candidate values of the tunable parameters, the
+  // time to produce one element of this node, in `*output_time`, and the
+  // sum of the times its stages spend on it, in `*total_time`.
+  void EstimateTimes(double* output_time, double* total_time) const;
+  // The sum of the candidate values of the tunable parameters, or 1.
+  double CandidateParallelism() const;
+  // The sum of the current values of the tunable parameters, or 1.
+  double CurrentParallelism() const;
+
+  Model* const model_;
+  const string name_;
+  std::atomic<int64> processing_time_{0};
+  std::atomic<int64> num_elements_{0};
+  std::atomic<int64> buffered_elements_{0};
+  std::atomic<int64> num_buffer_samples_{0};
+  std::atomic<bool> asynchronous_{false};
+  std::atomic<int64> output_time_{0};
+  std::atomic<int64> output_bytes_{0};
+  // The distribution of the values passed to record_output(), or nullptr if
+  // the model does not profile its pipeline.
+  const std::unique_ptr<histogram::ThreadSafeHistogram> latency_;
+
+  // The following are guarded by the `mu_` of the owning Model.
+  Node* output_;
+  std::vector<Node*> inputs_;
+  std::vector<Tunable> tunables_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Node);
+};
+
+// A Model holds one Node per iterator of an input pipeline, linked from
+// each iterator to the iterators it consumes, and periodically re-chooses
+// the tunable parameters of all of them at once.
+//
+// Optimize() estimates the time the pipeline takes to produce an element by
+// composing the measured per-element processing time of every node: a
+// synchronous node adds its own time to the time of its inputs, weighted by
+// how many input elements it consumes per output element, while an
+// asynchronous node takes the longer of its own time divided by its
+// parallelism and the time of its inputs. It then increases, one step at a
+// time, whichever parallelism reduces that estimate the most, until the
+// total parallelism uses up the CPU budget or nothing improves the
+// estimate. Ties, e.g. between two stages that are both bottlenecks, go to
+// the step that most reduces the summed time of all stages. Stages thus
+// get parallelism where it pays off, instead of each being sized by a guess
+// that ignores the rest of the pipeline.
+//
+// If profiling, the model also records the latency and the size of the
+// elements of every node, and ProfileReport() ranks the stages of the
+// pipeline by the time each of them adds to an output element.
+//
+// Thread-safe.
+class Model {
+ public:
+  struct Options {
+    // Whether MaybeOptimize() tunes the parameters of the nodes.
+    bool autotune = true;
+    // Whether the nodes record the latency and the size of their elements,
+    // and MaybeLogProfile() logs ProfileReport().
+    bool profile = false;
+  };
+
+  Model();
+  explicit Model(const Options& options);
+  ~Model();
+
+  bool profiling() const { return options_.profile; }
+
+  // Adds a node for the iterator with prefix `name`, whose elements are
+  // consumed by the iterator with prefix `output_name`. If that iterator has
+  // no node, the new node becomes the output of the model.
+  Node* AddNode(const string& name, const string& output_name)
+      LOCKS_EXCLUDED(mu_);
+
+  // Removes and deletes `node`, e.g. when its iterator is destroyed.
+  void RemoveNode(Node* node) LOCKS_EXCLUDED(mu_);
+
+  // Starts attributing the time of the calling thread to `node`, pausing the
+  // node the thread was working for until the matching RecordStop().
+  static void RecordStart(Node* node);
+  static void RecordStop(Node* node);
+
+  // Re-chooses the tunable parameters of all nodes so that their total
+  // parallelism does not exceed `cpu_budget`.
+  void Optimize(int64 cpu_budget) LOCKS_EXCLUDED(mu_);
+
+  // Calls Optimize() with the number of schedulable CPUs as the budget, if
+  // autotuning and it has not been called for a while. Called by the output
+  // iterator for each element it produces.
+  void MaybeOptimize();
+
+  // Returns a report of the nodes reachable from the output of the model,
+  // one line per stage, starting with the stage that adds the most time to
+  // an output element: the one that limits the throughput of the pipeline.
+  // The time a stage adds is its processing time per element, divided by
+  // its parallelism, times the number of its elements consumed per output
+  // element. Requires profiling for the latencies and the sizes.
+  string ProfileReport() LOCKS_EXCLUDED(mu_);
+
+  // If profiling, logs ProfileReport() if it has not been logged for a while
+  // or if `end_of_sequence` is true for the first time. Called by the output
+  // iterator for each call to its GetNext().
+  void MaybeLogProfile(bool end_of_sequence);
+
+  // Whether `node` is the output of the model.
+  bool IsOutput(const Node* node) const { return output_ == node; }
+
+ private:
+  friend class Node;
+
+  void CollectTunables(Node* node, std::vector<Node::Tunable*>* tunables)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+  mutex mu_;
+  std::unordered_map<string, Node*> lookup_table_ GUARDED_BY(mu_);
+  // Every node of the model, including ones whose prefix is shadowed in
+  // `lookup_table_` by a later node with the same prefix.
+  std::vector<std::unique_ptr<Node>> nodes_ GUARDED_BY(mu_);
+  std::atomic<Node*> output_{nullptr};
+  std::atomic<int64> next_optimization_micros_{0};
+  std::atomic<int64> next_profile_micros_{0};
+  std::atomic<bool> logged_end_of_sequence_{false};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Model);
+};
+
+}  // namespace model
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
@@ -0,0 +1,165 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/model.h"
+
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace model {
+namespace {
+
+// Records `num_elements` elements that took `micros_per_element` each.
+void RecordElements(Node* node, int64 num_elements, int64 micros_per_element) {
+  for (int64 i = 0; i < num_elements; ++i) {
+    node->record_element();
+    node->add_processing_time(micros_per_element);
+  }
+}
+
+TEST(ModelTest, LinksNodesByPrefix) {
+  Model model;
+  Node* map = model.AddNode("Iterator::Map", "Iterator");
+  Node* interleave =
+      model.AddNode("Iterator::Map::Interleave", "Iterator::Map");
+  Node* range = model.AddNode("Iterator::Map::Interleave[0]::Range",
+                              "Iterator::Map::Interleave[0]");
+  Node* unrelated = model.AddNode("Other", "Unknown");
+  EXPECT_TRUE(model.IsOutput(map));
+  EXPECT_FALSE(model.IsOutput(interleave));
+  EXPECT_FALSE(model.IsOutput(unrelated));
+
+  // The output time of `map` includes the time of its indirect inputs.
+  mutex mu;
+  condition_variable cond_var;
+  std::atomic<int64> parallelism(1);
+  map->add_tunable_parallelism(&parallelism, 1, 4, &mu, &cond_var);
+  RecordElements(map, 10, 0);
+  RecordElements(interleave, 10, 0);
+  RecordElements(range, 10, 1000);
+  model.Optimize(4);
+  // `map` is not the bottleneck, so it keeps the minimum parallelism.
+  EXPECT_EQ(1, parallelism);
+
+  model.RemoveNode(range);
+  model.RemoveNode(unrelated);
+  model.RemoveNode(interleave);
+  model.RemoveNode(map);
+}
+
+TEST(ModelTest, ParallelizesTheBottleneck) {
+  Model model;
+  Node* map = model.AddNode("Iterator::ParallelMap", "Iterator");
+  Node* range = model.AddNode("Iterator::ParallelMap::Range",
+                              "Iterator::ParallelMap");
+  mutex mu;
+  condition_variable cond_var;
+  std::atomic<int64> parallelism(1);
+  map->add_tunable_parallelism(&parallelism, 1, 6, &mu, &cond_var);
+  RecordElements(map, 100, 1000);
+  RecordElements(range, 100, 1);
+
+  model.Optimize(4);
+  EXPECT_EQ(4, parallelism);
+  model.Optimize(16);
+  EXPECT_EQ(6, parallelism);
+
+  model.RemoveNode(range);
+  model.RemoveNode(map);
+}
+
+TEST(ModelTest, SharesTheBudgetBetweenStages) {
+  Model model;
+  Node* outer = model.AddNode("Iterator::ParallelMap", "Iterator");
+  Node* inner = model.AddNode("Iterator::ParallelMap::ParallelMap",
+                              "Iterator::ParallelMap");
+  mutex mu;
+  condition_variable cond_var;
+  std::atomic<int64> outer_parallelism(1);
+  std::atomic<int64> inner_parallelism(1);
+  outer->add_tunable_parallelism(&outer_parallelism, 1, 16, &mu, &cond_var);
+  inner->add_tunable_parallelism(&inner_parallelism, 1, 16, &mu, &cond_var);
+  RecordElements(outer, 100, 1000);
+  RecordElements(inner, 100, 500);
+
+  model.Optimize(6);
+  // An output time of 250us needs 4 outer and 2 inner calls in parallel.
+  EXPECT_EQ(4, outer_parallelism);
+  EXPECT_EQ(2, inner_parallelism);
+
+  model.RemoveNode(inner);
+  model.RemoveNode(outer);
+}
+
+TEST(ModelTest, RecordsSelfTime) {
+  Model model;
+  Node* outer = model.AddNode("Iterator::Map", "Iterator");
+  Node* inner = model.AddNode("Iterator::Map::Range", "Iterator::Map");
+  Model::RecordStart(outer);
+  Model::RecordStart(inner);
+  Env::Default()->SleepForMicroseconds(2000);
+  Model::RecordStop(inner);
+  Model::RecordStop(outer);
+  EXPECT_GE(inner->processing_time(), 2000);
+  EXPECT_LT(outer->processing_time(), inner->processing_time());
+
+  model.RemoveNode(inner);
+  model.RemoveNode(outer);
+}
+
+TEST(ModelTest, AveragesBufferSizes) {
+  Model model;
+  Node* prefetch = model.AddNode("Iterator::Prefetch", "Iterator");
+  EXPECT_EQ(0, prefetch->average_buffer_size());
+  prefetch->record_buffer_size(1);
+  prefetch->record_buffer_size(4);
+  EXPECT_EQ(2.5, prefetch->average_buffer_size());
+  model.RemoveNode(prefetch);
+}
+
+TEST(ModelTest, ProfileRanksStagesByTheTimeTheyAdd) {
+  Model::Options options;
+  options.autotune = false;
+  options.profile = true;
+  Model model(options);
+  Node* map = model.AddNode("Iterator::Map", "Iterator");
+  Node* range = model.AddNode("Iterator::Map::Range", "Iterator::Map");
+  RecordElements(map, 100, 10);
+  // Two range elements per map element add 60us to each of them.
+  RecordElements(range, 200, 30);
+  for (int i = 0; i < 100; ++i) {
+    map->record_output(70, 8);
+  }
+
+  std::vector<string> lines = str_util::Split(model.ProfileReport(), '\n');
+  ASSERT_EQ(3, lines.size());
+  EXPECT_TRUE(str_util::StrContains(lines[0], "after 100 elements"));
+  EXPECT_TRUE(str_util::StrContains(lines[1], "Iterator::Map::Range: 60.0us"))
+      << lines[1];
+  EXPECT_TRUE(str_util::StrContains(lines[2], "Iterator::Map: 10.0us"))
+      << lines[2];
+  EXPECT_TRUE(str_util::StrContains(lines[2], "70.0us latency (median"));
+  EXPECT_TRUE(str_util::StrContains(lines[2], "60.0us waiting for inputs"));
+  EXPECT_TRUE(str_util::StrContains(lines[2], "8 bytes per element"));
+
+  model.RemoveNode(range);
+  model.RemoveNode(map);
+}
+
+}  // namespace
+}  // namespace model
+}  // namespace tensorflow
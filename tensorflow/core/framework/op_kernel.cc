@@ -673,8 +673,15 @@ Status OpKernelContext::allocate_output(StringPiece name,
 
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    AllocatorAttributes attr, const AllocationAttributes& allocation_attr,
+    bool step_local) {
+  Allocator* a;
+  if (step_local && params_->step_allocator != nullptr && attr.value == 0 &&
+      attr.scope_id == 0 && !track_allocations()) {
+    a = params_->step_allocator;
+  } else {
+    a = get_allocator(attr);
+  }
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
   Tensor new_tensor(a, type, shape, logged_attr);
@@ -703,7 +710,9 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Status s = allocate_tensor(type, shape, output_tensor, attr,
+                             AllocationAttributes(),
+                             !params_->outputs_outlive_step);
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -715,8 +724,10 @@ Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
     const AllocationAttributes& allocation_attr) {
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  // Temporaries are often passed to set_output(), so they follow the same
+  // rule as outputs.
+  Status s = allocate_tensor(type, shape, out_temp, allocator_attr,
+                             allocation_attr, !params_->outputs_outlive_step);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
     Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
@@ -525,6 +525,13 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not null, an allocator whose memory is reclaimed when the step
+    // finishes. Unless "outputs_outlive_step" is true it is used for
+    // outputs and temporaries whose requested allocator attributes are the
+    // defaults, as long as allocations are not being tracked.
+    Allocator* step_allocator = nullptr;
+    bool outputs_outlive_step = false;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -1122,9 +1129,12 @@ class OpKernelContext {
                            AllocationAttributes());
   }
 
+  // If "step_local" is true, the tensor is not expected to outlive the step
+  // and may be allocated from params_->step_allocator.
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
-                         const AllocationAttributes& allocation_attr);
+                         const AllocationAttributes& allocation_attr,
+                         bool step_local = false);
 
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
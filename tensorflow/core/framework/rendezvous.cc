@@ -36,6 +36,7 @@ namespace tensorflow {
 Rendezvous::ParsedKey& Rendezvous::ParsedKey::operator=(const ParsedKey& b) {
   const char* b_base = b.buf_.data();
   buf_ = b.buf_;
+  hash_ = b.hash_;
   src_device = StringPiece(buf_.data() + (b.src_device.data() - b_base),
                            b.src_device.size());
   src = b.src;
@@ -107,6 +108,7 @@ Status Rendezvous::ParseKey(StringPiece key, ParsedKey* out) {
     out->src_device = StringPiece(parts[0].data(), parts[0].size());
     out->dst_device = StringPiece(parts[2].data(), parts[2].size());
     out->edge_name = StringPiece(parts[3].data(), parts[3].size());
+    out->hash_ = Hash64(out->buf_.data(), out->buf_.size());
     return Status::OK();
   }
   return errors::InvalidArgument("Invalid  rendezvous key: ", key);
@@ -152,18 +154,19 @@ class LocalRendezvousImpl : public Rendezvous {
 
   Status Send(const ParsedKey& key, const Args& send_args, const Tensor& val,
               const bool is_dead) override {
-    uint64 key_hash = KeyHash(key.FullKey());
+    uint64 key_hash = key.KeyHash();
     VLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
 
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      shard->mu.unlock();
       return s;
     }
 
-    ItemQueue* queue = &table_[key_hash];
+    ItemQueue* queue = &shard->table[key_hash];
     if (queue->empty() || queue->front()->IsSendValue()) {
       // There is no waiter for this message. Append the message
       // into the queue. The waiter will pick it up when arrives.
@@ -176,14 +179,14 @@ class LocalRendezvousImpl : public Rendezvous {
         item->send_args.device_context->Ref();
       }
       queue->push_back(item);
-      mu_.unlock();
+      shard->mu.unlock();
       return Status::OK();
     }
 
     // There is an earliest waiter to consume this message.
     Item* item = queue->front();
     queue->pop_front();
-    mu_.unlock();
+    shard->mu.unlock();
 
     // Notify the waiter by invoking its done closure, outside the
     // lock.
@@ -195,19 +198,20 @@ class LocalRendezvousImpl : public Rendezvous {
 
   void RecvAsync(const ParsedKey& key, const Args& recv_args,
                  DoneCallback done) override {
-    uint64 key_hash = KeyHash(key.FullKey());
+    uint64 key_hash = key.KeyHash();
     VLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      shard->mu.unlock();
       done(s, Args(), recv_args, Tensor(), false);
       return;
     }
 
-    ItemQueue* queue = &table_[key_hash];
+    ItemQueue* queue = &shard->table[key_hash];
     if (queue->empty() || !queue->front()->IsSendValue()) {
       // There is no message to pick up.
       // Only recv-related fields need to be filled.
@@ -218,7 +222,7 @@ class LocalRendezvousImpl : public Rendezvous {
         item->recv_args.device_context->Ref();
       }
       queue->push_back(item);
-      mu_.unlock();
+      shard->mu.unlock();
       return;
     }
 
@@ -226,7 +230,7 @@ class LocalRendezvousImpl : public Rendezvous {
     // this key.  Consumes the message and invokes the done closure.
     Item* item = queue->front();
     queue->pop_front();
-    mu_.unlock();
+    shard->mu.unlock();
 
     // Invokes the done() by invoking its done closure, outside scope
     // of the table lock.
@@ -237,18 +241,20 @@ class LocalRendezvousImpl : public Rendezvous {
 
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
-    Table table;
-    {
-      mutex_lock l(mu_);
-      status_.Update(status);
-      table_.swap(table);
-    }
-    for (auto& p : table) {
-      for (Item* item : p.second) {
-        if (!item->IsSendValue()) {
-          item->waiter(status, Args(), Args(), Tensor(), false);
+    for (Shard& shard : shards_) {
+      Table table;
+      {
+        mutex_lock l(shard.mu);
+        shard.status.Update(status);
+        shard.table.swap(table);
+      }
+      for (auto& p : table) {
+        for (Item* item : p.second) {
+          if (!item->IsSendValue()) {
+            item->waiter(status, Args(), Args(), Tensor(), false);
+          }
+          delete item;
         }
-        delete item;
       }
     }
   }
@@ -276,11 +282,6 @@ class LocalRendezvousImpl : public Rendezvous {
     bool IsSendValue() const { return this->waiter == nullptr; }
   };
 
-  // We key the hash table by KeyHash of the Rendezvous::CreateKey string
-  static uint64 KeyHash(const StringPiece& k) {
-    return Hash64(k.data(), k.size());
-  }
-
   // By invariant, the item queue under each key is of the form
   //   [item.IsSendValue()]* meaning each item is a sent message.
   // or
@@ -288,16 +289,38 @@ class LocalRendezvousImpl : public Rendezvous {
   //
   // TODO(zhifengc): consider a better queue impl than std::deque.
   typedef std::deque<Item*> ItemQueue;
+  // We key the hash table by KeyHash of the Rendezvous::CreateKey string.
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_ GUARDED_BY(mu_);
+  // The table is split into shards by key hash, each with its own lock, so
+  // that concurrent transfers of different tensors (e.g. from concurrent
+  // steps sharing a rendezvous) rarely contend.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+    // The abort status; StartAbort() sets it on every shard.
+    Status status GUARDED_BY(mu);
+  };
+  Shard shards_[kNumShards];
+
+  Shard* GetShard(uint64 key_hash) {
+    // The low bits of the hash also pick the FlatMap bucket, so shard by
+    // the high bits.
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
 
   ~LocalRendezvousImpl() override {
-    if (!table_.empty()) {
-      StartAbort(errors::Cancelled("LocalRendezvousImpl deleted"));
+    for (Shard& shard : shards_) {
+      bool empty;
+      {
+        mutex_lock l(shard.mu);
+        empty = shard.table.empty();
+      }
+      if (!empty) {
+        StartAbort(errors::Cancelled("LocalRendezvousImpl deleted"));
+        break;
+      }
     }
   }
 
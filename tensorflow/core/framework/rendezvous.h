@@ -72,12 +72,16 @@ class Rendezvous : public core::RefCounted {
 
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
+    // Hash64 of FullKey(), computed once by ParseKey so that rendezvous
+    // implementations can look the key up without rehashing it.
+    uint64 KeyHash() const { return hash_; }
 
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     string buf_;
+    uint64 hash_ = 0;
   };
   static Status ParseKey(StringPiece key, ParsedKey* out);
 
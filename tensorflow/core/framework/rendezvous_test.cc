@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -53,6 +54,9 @@ TEST(RendezvousTest, Key) {
   EXPECT_EQ(parsed.src.type, "CPU");
   EXPECT_EQ(parsed.dst_device, "/job:mnist/replica:1/task:2/device:GPU:0");
   EXPECT_EQ(parsed.dst.type, "GPU");
+  EXPECT_EQ(parsed.KeyHash(), Hash64(key));
+  Rendezvous::ParsedKey copied(parsed);
+  EXPECT_EQ(copied.KeyHash(), parsed.KeyHash());
 
   EXPECT_FALSE(Rendezvous::ParseKey("foo;bar;baz", &parsed).ok());
   EXPECT_FALSE(Rendezvous::ParseKey("/job:mnist/replica:1/task:2/CPU:0;"
@@ -246,6 +250,30 @@ TEST_F(LocalRendezvousTest, RecvAbort) {
   EXPECT_TRUE(errors::IsAborted(status));
 }
 
+TEST_F(LocalRendezvousTest, AbortManyKeys) {
+  // The pending receives are spread over the shards of the table; all of
+  // them must be aborted, and every key must fail afterwards.
+  static const int N = 100;
+  int num_aborted = 0;
+  for (int i = 0; i < N; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat(i)), Rendezvous::Args(),
+        [&num_aborted](const Status& s, const Rendezvous::Args& send_args,
+                       const Rendezvous::Args& recv_args, const Tensor& v,
+                       const bool dead) {
+          EXPECT_TRUE(errors::IsAborted(s));
+          ++num_aborted;
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  EXPECT_EQ(N, num_aborted);
+  for (int i = 0; i < N; ++i) {
+    Status s = rendez_->Send(MakeKey(strings::StrCat(i)), Rendezvous::Args(),
+                             V("x"), false);
+    EXPECT_TRUE(errors::IsAborted(s));
+  }
+}
+
 // Similar to RecvAbort. But this test case ensures the main thread
 // Recv() call happens after StartAbort().
 TEST_F(LocalRendezvousTest, RecvSleepAbort) {
@@ -0,0 +1,101 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/shared_kernel_cache.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+SharedKernelCache::SharedKernelCache() {}
+
+SharedKernelCache::~SharedKernelCache() {
+  for (const auto& kv : kernels_) delete kv.second.kernel;
+}
+
+SharedKernelCache* SharedKernelCache::Global() {
+  static SharedKernelCache* cache = new SharedKernelCache;
+  return cache;
+}
+
+Status SharedKernelCache::FindOrCreate(const string& device_name,
+                                       int graph_def_version,
+                                       const NodeDef& ndef, OpKernel** kernel,
+                                       CreateKernelFn create_fn) {
+  string serialized;
+  if (!SerializeToStringDeterministic(ndef, &serialized)) {
+    return errors::Internal("Failed to serialize NodeDef ", ndef.name());
+  }
+  const Fprint128 fingerprint = Fingerprint128(serialized);
+  const string key = strings::StrCat(device_name, "/", graph_def_version, "/",
+                                     fingerprint.low64, ":",
+                                     fingerprint.high64);
+  {
+    mutex_lock l(mu_);
+    auto it = kernels_.find(key);
+    if (it != kernels_.end()) {
+      ++it->second.num_refs;
+      *kernel = it->second.kernel;
+      return Status::OK();
+    }
+  }
+  Status s = create_fn(kernel);
+  if (!s.ok()) {
+    LOG(ERROR) << "Create kernel failed: " << s;
+    return s;
+  }
+  OpKernel* created = *kernel;
+  {
+    mutex_lock l(mu_);
+    Item* item = &kernels_[key];
+    if (item->kernel == nullptr) {
+      item->kernel = created;  // Inserts 'created' in the map.
+      item->num_refs = 1;
+      keys_[created] = key;
+      return Status::OK();
+    }
+    ++item->num_refs;
+    *kernel = item->kernel;
+  }
+  // Another caller created the same kernel meanwhile.
+  delete created;
+  return Status::OK();
+}
+
+bool SharedKernelCache::Release(OpKernel* kernel) {
+  {
+    mutex_lock l(mu_);
+    auto key_it = keys_.find(kernel);
+    if (key_it == keys_.end()) return false;
+    auto it = kernels_.find(key_it->second);
+    DCHECK(it != kernels_.end());
+    if (--it->second.num_refs > 0) return true;
+    kernels_.erase(it);
+    keys_.erase(key_it);
+  }
+  delete kernel;
+  return true;
+}
+
+size_t SharedKernelCache::size() const {
+  mutex_lock l(mu_);
+  return kernels_.size();
+}
+
+}  // end namespace tensorflow
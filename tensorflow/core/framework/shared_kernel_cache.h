@@ -0,0 +1,90 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_FRAMEWORK_SHARED_KERNEL_CACHE_H_
+#define TENSORFLOW_FRAMEWORK_SHARED_KERNEL_CACHE_H_
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// SharedKernelCache lets the sessions of a process share the OpKernels of
+// stateless ops, so that sessions that load versions or replicas of the same
+// model construct each such kernel (and e.g. allocate each Const tensor)
+// once.
+//
+// Kernels are keyed by a fingerprint of their NodeDef, the name of the
+// device they are created for and the graph version, and are
+// reference-counted: a kernel is deleted once each FindOrCreate() that
+// returned it has been matched by a Release().
+class SharedKernelCache {
+ public:
+  SharedKernelCache();
+  ~SharedKernelCache();
+
+  // Returns the cache shared by the whole process.
+  static SharedKernelCache* Global();
+
+  // If the kernel for "ndef" has been created on "device_name" for
+  // "graph_def_version", returns the existing kernel in "*kernel".
+  // Otherwise, creates the kernel by calling create_fn(), caches it, and
+  // returns it in "*kernel". If create_fn() fails, returns the error.
+  //
+  // Either way, the caller holds a reference on "*kernel" until it calls
+  // Release(). Only kernels that don't depend on anything but "ndef" and the
+  // device, e.g. not on the function library of a session, may be shared.
+  typedef std::function<Status(OpKernel**)> CreateKernelFn;
+  Status FindOrCreate(const string& device_name, int graph_def_version,
+                      const NodeDef& ndef, OpKernel** kernel,
+                      CreateKernelFn create_fn);
+
+  // If "kernel" came from FindOrCreate(), drops a reference on it, deletes
+  // it if that was the last one, and returns true. Otherwise returns false.
+  bool Release(OpKernel* kernel);
+
+  // Returns the number of kernels in the cache.
+  size_t size() const;
+
+ private:
+  struct Item {
+    OpKernel* kernel = nullptr;
+    int num_refs = 0;
+  };
+
+  // key -> item, where the key combines the device name, the graph version
+  // and the NodeDef fingerprint.
+  typedef std::unordered_map<string, Item> KernelMap;
+
+  mutable mutex mu_;
+  KernelMap kernels_ GUARDED_BY(mu_);
+  // kernel -> its key in kernels_.
+  std::unordered_map<const OpKernel*, string> keys_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedKernelCache);
+};
+
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_FRAMEWORK_SHARED_KERNEL_CACHE_H_
@@ -0,0 +1,118 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/shared_kernel_cache.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+
+class SharedKernelCacheTest : public ::testing::Test {
+ protected:
+  SharedKernelCacheTest() : device_(Env::Default()) {}
+
+  NodeDef MulNodeDef(DataType dt) {
+    NodeDef def;
+    TF_CHECK_OK(NodeDefBuilder("mul", "Mul")
+                    .Input("x", 0, dt)
+                    .Input("y", 0, dt)
+                    .Finalize(&def));
+    return def;
+  }
+
+  SharedKernelCache::CreateKernelFn GetFn(const NodeDef* ndef) {
+    return [this, ndef](OpKernel** kernel) {
+      ++num_created_;
+      Status s;
+      auto created = CreateOpKernel(DEVICE_CPU, &device_, cpu_allocator(),
+                                    *ndef, TF_GRAPH_DEF_VERSION, &s);
+      if (s.ok()) {
+        *kernel = created.release();
+      }
+      return s;
+    };
+  }
+
+  DeviceBase device_;
+  int num_created_ = 0;
+};
+
+TEST_F(SharedKernelCacheTest, SharesKernelsWithSameKey) {
+  SharedKernelCache cache;
+  const NodeDef float_def = MulNodeDef(DT_FLOAT);
+  const NodeDef int32_def = MulNodeDef(DT_INT32);
+  const int v = TF_GRAPH_DEF_VERSION;
+
+  OpKernel* a;
+  OpKernel* b;
+  TF_EXPECT_OK(
+      cache.FindOrCreate("cpu:0", v, float_def, &a, GetFn(&float_def)));
+  TF_EXPECT_OK(
+      cache.FindOrCreate("cpu:0", v, float_def, &b, GetFn(&float_def)));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(1, num_created_);
+  EXPECT_EQ(1, cache.size());
+
+  // A different NodeDef, device or graph version gets its own kernel.
+  OpKernel* c;
+  OpKernel* d;
+  OpKernel* e;
+  TF_EXPECT_OK(
+      cache.FindOrCreate("cpu:0", v, int32_def, &c, GetFn(&int32_def)));
+  TF_EXPECT_OK(
+      cache.FindOrCreate("cpu:1", v, float_def, &d, GetFn(&float_def)));
+  TF_EXPECT_OK(
+      cache.FindOrCreate("cpu:0", v - 1, float_def, &e, GetFn(&float_def)));
+  EXPECT_EQ(DT_INT32, c->input_type(0));
+  EXPECT_NE(a, d);
+  EXPECT_NE(a, e);
+  EXPECT_EQ(4, num_created_);
+  EXPECT_EQ(4, cache.size());
+
+  EXPECT_TRUE(cache.Release(a));
+  EXPECT_EQ(4, cache.size());
+  EXPECT_TRUE(cache.Release(b));
+  EXPECT_EQ(3, cache.size());
+  for (OpKernel* kernel : {c, d, e}) EXPECT_TRUE(cache.Release(kernel));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST_F(SharedKernelCacheTest, ReleaseUnknownKernel) {
+  SharedKernelCache cache;
+  const NodeDef def = MulNodeDef(DT_FLOAT);
+  OpKernel* kernel;
+  TF_ASSERT_OK(GetFn(&def)(&kernel));
+  EXPECT_FALSE(cache.Release(kernel));
+  delete kernel;
+}
+
+TEST_F(SharedKernelCacheTest, CreateFailure) {
+  SharedKernelCache cache;
+  NodeDef def = MulNodeDef(DT_FLOAT);
+  def.set_op("nonexistop");
+  OpKernel* kernel;
+  Status s = cache.FindOrCreate("cpu:0", TF_GRAPH_DEF_VERSION, def, &kernel,
+                                GetFn(&def));
+  EXPECT_TRUE(errors::IsNotFound(s)) << s;
+  EXPECT_EQ(0, cache.size());
+}
+
+}  // namespace tensorflow
@@ -48,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -114,6 +115,58 @@ class Buffer : public BufferBase {
   TF_DISALLOW_COPY_AND_ASSIGN(Buffer);
 };
 
+// Tensors of at most this many bytes may keep their data in an
+// InlineBuffer.
+constexpr int64 kMaxInlineTensorBytes = 64;
+
+// Typed ref-counted buffer that keeps T[n] in the same allocation as
+// itself, so that a small tensor costs one heap allocation instead of one
+// for the buffer and one for the data. The data is not constructed or
+// destroyed, so T must be a type for which DataTypeCanUseMemcpy() holds.
+template <typename T>
+class InlineBuffer : public BufferBase {
+ public:
+  static InlineBuffer* New(Allocator* a, int64 n) {
+    static_assert(sizeof(InlineBuffer) <= kDataOffset,
+                  "InlineBuffer overlaps its data.");
+    void* mem = port::AlignedMalloc(kDataOffset + sizeof(T) * n,
+                                    Allocator::kAllocatorAlignment);
+    if (mem == nullptr) return nullptr;
+    return new (mem) InlineBuffer(a, n);
+  }
+
+  // Releases the memory that New() allocated once the buffer is unref'ed.
+  static void operator delete(void* mem) { port::AlignedFree(mem); }
+
+  void* data() const override {
+    return const_cast<char*>(reinterpret_cast<const char*>(this)) +
+           kDataOffset;
+  }
+  size_t size() const override { return sizeof(T) * elem_; }
+
+ private:
+  // Keeps the data as aligned as the allocator would.
+  static constexpr size_t kDataOffset = Allocator::kAllocatorAlignment;
+
+  InlineBuffer(Allocator* a, int64 n) : BufferBase(a), elem_(n) {}
+  ~InlineBuffer() override {}
+
+  const int64 elem_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Returns whether a tensor of "n" elements of "type" from "a" can use an
+// InlineBuffer. Its data bypasses "a", so this only holds for the plain CPU
+// allocator while nothing records the allocations it makes.
+bool UseInlineBuffer(Allocator* a, DataType type, int64 n) {
+  if (!DataTypeCanUseMemcpy(type) || n <= 0) return false;
+  const int elem_size = DataTypeSize(type);
+  if (elem_size == 0 || n > kMaxInlineTensorBytes / elem_size) return false;
+  return a == cpu_allocator() && !a->TracksAllocationSizes() &&
+         !CPUAllocatorStatsEnabled() && !LogMemory::IsEnabled();
+}
+
 void LogUnexpectedSize(int64 actual, int64 expected) {
   LOG(ERROR) << "Input size was " << actual << " and expected " << expected;
 }
@@ -721,7 +774,9 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
     : shape_(shape), buf_(nullptr) {
   set_dtype(type);
   CHECK_NOTNULL(a);
-  if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
+  if (UseInlineBuffer(a, type, shape_.num_elements())) {
+    CASES(type, buf_ = InlineBuffer<T>::New(a, shape.num_elements()));
+  } else if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
     CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -502,6 +502,8 @@ class Tensor {
 
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
+  friend class ShardedCacheReader;  // For access to the private constructor
+                                    // taking the buffer.
 
   // Creates a tensor with the input datatype, shape and buf.
   //
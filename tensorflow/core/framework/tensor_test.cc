@@ -1100,6 +1100,38 @@ TEST(Tensor, SharesBufferWith) {
   EXPECT_TRUE(a.SharesBufferWith(copy));
 }
 
+TEST(Tensor, SmallTensors) {
+  Tensor scalar(DT_INT64, TensorShape({}));
+  scalar.scalar<int64>()() = 42;
+  EXPECT_EQ(42, scalar.scalar<int64>()());
+  EXPECT_TRUE(scalar.IsAligned());
+  EXPECT_EQ(sizeof(int64), scalar.tensor_data().size());
+  EXPECT_EQ(sizeof(int64), scalar.AllocatedBytes());
+
+  Tensor vec(DT_FLOAT, TensorShape({16}));
+  EXPECT_TRUE(vec.IsAligned());
+  for (int i = 0; i < 16; ++i) vec.flat<float>()(i) = i;
+  Tensor copy(vec);
+  EXPECT_TRUE(copy.SharesBufferWith(vec));
+  Tensor slice = vec.Slice(4, 8);
+  EXPECT_TRUE(slice.SharesBufferWith(vec));
+  EXPECT_EQ(4.0f, slice.flat<float>()(0));
+  vec = Tensor();
+  copy = Tensor();
+  EXPECT_EQ(7.0f, slice.flat<float>()(3));
+
+  // Tensors the allocator stats should count don't bypass the allocator.
+  EnableCPUAllocatorStats(true);
+  cpu_allocator()->ClearStats();
+  AllocatorStats before;
+  cpu_allocator()->GetStats(&before);
+  { Tensor counted(DT_INT32, TensorShape({})); }
+  AllocatorStats after;
+  cpu_allocator()->GetStats(&after);
+  EnableCPUAllocatorStats(false);
+  EXPECT_EQ(before.num_allocs + 1, after.num_allocs);
+}
+
 TEST(Tensor, FailureToAllocate) {
   TensorShape shape({1});
   DummyCPUAllocator allocator;
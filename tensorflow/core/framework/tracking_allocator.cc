@@ -40,12 +40,14 @@ void* TrackingAllocator::AllocateRaw(
   }
   if (allocator_->TracksAllocationSizes()) {
     size_t allocated_bytes = allocator_->AllocatedSize(ptr);
+    int64 allocation_id = allocator_->AllocationId(ptr);
     {
       mutex_lock lock(mu_);
       allocated_ += allocated_bytes;
       high_watermark_ = std::max(high_watermark_, allocated_);
       total_bytes_ += allocated_bytes;
-      allocations_.emplace_back(allocated_bytes, Env::Default()->NowMicros());
+      allocations_.emplace_back(allocated_bytes, Env::Default()->NowMicros(),
+                                allocation_id);
       ++ref_;
     }
   } else if (track_sizes_locally_) {
@@ -61,7 +63,8 @@ void* TrackingAllocator::AllocateRaw(
     allocated_ += allocated_bytes;
     high_watermark_ = std::max(high_watermark_, allocated_);
     total_bytes_ += allocated_bytes;
-    allocations_.emplace_back(allocated_bytes, Env::Default()->NowMicros());
+    allocations_.emplace_back(allocated_bytes, Env::Default()->NowMicros(),
+                              next_allocation_id_);
     ++ref_;
   } else {
     mutex_lock lock(mu_);
@@ -82,14 +85,17 @@ void TrackingAllocator::DeallocateRaw(void* ptr) {
   // AllocatedSize is slow
   bool tracks_allocation_sizes = allocator_->TracksAllocationSizes();
   size_t allocated_bytes = 0;
+  int64 allocation_id = 0;
   if (tracks_allocation_sizes) {
     allocated_bytes = allocator_->AllocatedSize(ptr);
+    allocation_id = allocator_->AllocationId(ptr);
   } else if (track_sizes_locally_) {
     mutex_lock lock(mu_);
     auto itr = in_use_.find(ptr);
     if (itr != in_use_.end()) {
       tracks_allocation_sizes = true;
       allocated_bytes = (*itr).second.allocated_size;
+      allocation_id = (*itr).second.allocation_id;
       in_use_.erase(itr);
     }
   }
@@ -99,7 +105,8 @@ void TrackingAllocator::DeallocateRaw(void* ptr) {
     if (tracks_allocation_sizes) {
       CHECK_GE(allocated_, allocated_bytes);
       allocated_ -= allocated_bytes;
-      allocations_.emplace_back(-allocated_bytes, Env::Default()->NowMicros());
+      allocations_.emplace_back(-allocated_bytes, Env::Default()->NowMicros(),
+                                allocation_id);
     }
     should_delete = UnRef();
   }
@@ -44,12 +44,15 @@ namespace tensorflow {
 // reference count, and deletes itself once the last call has been
 // received and the high watermark has been retrieved.
 struct AllocRecord {
-  AllocRecord(int64 a_btyes, int64 a_micros)
-      : alloc_bytes(a_btyes), alloc_micros(a_micros) {}
+  AllocRecord(int64 a_btyes, int64 a_micros, int64 a_id = 0)
+      : alloc_bytes(a_btyes), alloc_micros(a_micros), allocation_id(a_id) {}
   AllocRecord() : AllocRecord(0, 0) {}
 
   int64 alloc_bytes;
   int64 alloc_micros;
+  // Shared by the allocation and deallocation records of a buffer, or 0 if
+  // neither the wrapper nor the underlying allocator assigns ids.
+  int64 allocation_id;
 };
 
 class TrackingAllocator : public Allocator {
@@ -111,6 +111,11 @@ TEST(TrackingAllocatorTest, SimpleNoTracking) {
   EXPECT_GE(-4, records[1].alloc_bytes);
   EXPECT_LE(12, records[2].alloc_bytes);
   EXPECT_GE(-12, records[3].alloc_bytes);
+  // The deallocation records carry the id of the buffer they free.
+  EXPECT_EQ(1, records[0].allocation_id);
+  EXPECT_EQ(1, records[1].allocation_id);
+  EXPECT_EQ(2, records[2].allocation_id);
+  EXPECT_EQ(2, records[3].allocation_id);
 }
 
 TEST(TrackingAllocatorTest, SimpleTracking) {
@@ -366,6 +366,13 @@ Node* Graph::AddNode(const NodeDef& node_def, Status* status) {
   return node;
 }
 
+Node* Graph::AddNode(const NodeDef& node_def, const OpDef* op_def,
+                     DataTypeSlice inputs, DataTypeSlice outputs) {
+  return AllocateNode(
+      std::make_shared<NodeProperties>(op_def, node_def, inputs, outputs),
+      nullptr);
+}
+
 Node* Graph::CopyNode(const Node* node) {
   DCHECK(!node->IsSource());
   DCHECK(!node->IsSink());
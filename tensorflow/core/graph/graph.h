@@ -444,6 +444,13 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(const NodeDef& node_def, Status* status);
 
+  // Same as above, but takes the Op and input/output types that the caller
+  // already inferred for the node, e.g. for many nodes in parallel.
+  // REQUIRES: `op_def` is this graph's OpDef for node_def.op(), and `inputs`
+  // and `outputs` are what InOutTypesForNode() returns for `node_def`.
+  Node* AddNode(const NodeDef& node_def, const OpDef* op_def,
+                DataTypeSlice inputs, DataTypeSlice outputs);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
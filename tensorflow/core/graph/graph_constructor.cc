@@ -35,9 +35,12 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
 
@@ -86,7 +89,8 @@ class GraphConstructor {
           return_nodes(in.return_nodes),
           importing(true),
           validate_colocation_constraints(in.validate_colocation_constraints),
-          validate_shape(in.validate_shape) {}
+          validate_shape(in.validate_shape),
+          validate_nodes(in.validate_nodes) {}
 
     bool allow_internal_ops;
     bool expect_device_spec;
@@ -111,6 +115,7 @@ class GraphConstructor {
     bool importing;
     bool validate_colocation_constraints;
     bool validate_shape = true;
+    bool validate_nodes = true;
   };
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
@@ -184,9 +189,27 @@ class GraphConstructor {
 
   void Undo();
 
+  // What ResolveNodeDefs() works out ahead of time for a NodeDef.
+  struct ResolvedNodeDef {
+    // Null if the NodeDef couldn't be resolved, in which case Convert()
+    // handles it as if nothing was resolved, so that errors are reported as
+    // and when they would be otherwise.
+    const OpDef* op_def = nullptr;
+    // When importing, a copy of the NodeDef with the defaults of its op's
+    // attrs, already validated unless opts_.validate_nodes is false.
+    NodeDef node_def;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+  };
+
+  // Fills in resolved_ for all of node_defs_, in parallel for large graphs.
+  void ResolveNodeDefs();
+
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
-  Status MakeNode(const NodeDef& node_def, Node** node);
+  // Uses the op and types in `resolved` unless it's null.
+  Status MakeNode(const NodeDef& node_def, const ResolvedNodeDef* resolved,
+                  Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -253,6 +276,9 @@ class GraphConstructor {
   // May be null. Not owned.
   std::vector<SafeTensorId>* missing_unused_input_map_keys_;
 
+  // Indexed like node_defs_.
+  std::vector<ResolvedNodeDef> resolved_;
+
   // Intermediate datastructure used to populate
   // `missing_unused_input_map_keys_`.
   std::set<TensorId> used_input_map_keys_;
@@ -569,11 +595,70 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
-Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
+void GraphConstructor::ResolveNodeDefs() {
+  // Look up each op once rather than once per node, which also keeps the
+  // threads below off the op registry's lock.
+  std::unordered_map<StringPiece, const OpDef*, StringPieceHasher> op_defs;
+  for (const NodeDef* node_def : node_defs_) {
+    auto it = op_defs.emplace(node_def->op(), nullptr);
+    if (it.second && !g_->op_registry()
+                          ->LookUpOpDef(node_def->op(), &it.first->second)
+                          .ok()) {
+      it.first->second = nullptr;
+    }
+  }
+
+  resolved_.resize(node_defs_.size());
+  auto resolve = [this, &op_defs](int64 begin, int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      const NodeDef* node_def = node_defs_[i];
+      const OpDef* op_def = op_defs.at(node_def->op());
+      if (op_def == nullptr) continue;
+      ResolvedNodeDef* resolved = &resolved_[i];
+      if (opts_.importing) {
+        resolved->node_def = *node_def;
+        AddDefaultsToNodeDef(*op_def, &resolved->node_def);
+        if (opts_.validate_nodes &&
+            !ValidateNodeDef(resolved->node_def, *op_def).ok()) {
+          resolved->node_def.Clear();
+          continue;
+        }
+        node_def = &resolved->node_def;
+      }
+      if (!InOutTypesForNode(*node_def, *op_def, &resolved->input_types,
+                             &resolved->output_types)
+               .ok()) {
+        resolved->node_def.Clear();
+        continue;
+      }
+      resolved->op_def = op_def;
+    }
+  };
+
+  // Below this many nodes, starting threads costs more than it saves.
+  const int64 kMinNodesToResolveInParallel = 4096;
+  const int num_threads = port::NumSchedulableCPUs();
+  if (node_defs_.size() < kMinNodesToResolveInParallel || num_threads <= 1) {
+    resolve(0, node_defs_.size());
+    return;
+  }
+  thread::ThreadPool pool(Env::Default(), "resolve_node_defs", num_threads);
+  const int64 kCostPerNode = 10000;
+  pool.ParallelFor(node_defs_.size(), kCostPerNode, resolve);
+}
+
+Status GraphConstructor::MakeNode(const NodeDef& node_def,
+                                  const ResolvedNodeDef* resolved,
+                                  Node** node) {
   // Add the node to the graph.
-  Status status;
-  *node = g_->AddNode(node_def, &status);
-  if (!status.ok()) return status;
+  if (resolved != nullptr) {
+    *node = g_->AddNode(node_def, resolved->op_def, resolved->input_types,
+                        resolved->output_types);
+  } else {
+    Status status;
+    *node = g_->AddNode(node_def, &status);
+    if (!status.ok()) return status;
+  }
   if (opts_.expect_device_spec) {
     (*node)->set_assigned_device_name(node_def.device());
   }
@@ -680,7 +765,9 @@ Status GraphConstructor::ModifyNodeDefForImport(NodeDef* node_def) {
   const OpDef* op_def;
   TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def->op(), &op_def));
   AddDefaultsToNodeDef(*op_def, node_def);
-  TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
+  if (opts_.validate_nodes) {
+    TF_RETURN_IF_ERROR(ValidateNodeDef(*node_def, *op_def));
+  }
   if (versions_) {
     TF_RETURN_IF_ERROR(CheckOpDeprecation(*op_def, versions_->producer()));
   }
@@ -910,6 +997,7 @@ Status GraphConstructor::Convert() {
   if (library_) {
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library_));
   }
+  ResolveNodeDefs();
 
   std::vector<InputInfo> inputs;
   int processed = 0;
@@ -928,6 +1016,8 @@ Status GraphConstructor::Convert() {
     bool has_data_back_edge = false;
 
     const NodeDef& original_node_def = *node_defs_[o];
+    ResolvedNodeDef* resolved = &resolved_[o];
+    if (resolved->op_def == nullptr) resolved = nullptr;
     NodeDef imported_node_def;
     const NodeDef* node_def;
 
@@ -950,11 +1040,16 @@ Status GraphConstructor::Convert() {
         }
       }
 
-      // TODO(ashankar): The line below means an additional copy of the
-      // NodeDef, which can be expensive if the NodeDef contains large tensors
-      // in it. Might make sense to change the API for ImportGraphDef to take
-      // a mutable GraphDef* and avoid the copying.
-      imported_node_def = original_node_def;
+      // TODO(ashankar): This means an additional copy of the NodeDef (made
+      // by ResolveNodeDefs() unless it failed to resolve the node), which can
+      // be expensive if the NodeDef contains large tensors in it. Might make
+      // sense to change the API for ImportGraphDef to take a mutable
+      // GraphDef* and avoid the copying.
+      if (resolved != nullptr) {
+        imported_node_def.Swap(&resolved->node_def);
+      } else {
+        imported_node_def = original_node_def;
+      }
       if (!opts_.input_map.empty()) {
         // Note that input_already_exists can shrink here
         RemapNodeDefInputs(&imported_node_def, &input_already_exists);
@@ -1016,9 +1111,14 @@ Status GraphConstructor::Convert() {
       if (opts_.uniquify_names && (prefix_.empty() || !opts_.uniquify_prefix)) {
         UniquifyNames(input_already_exists, &imported_node_def);
       }
-      TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
+      if (resolved == nullptr) {
+        TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
+      } else if (versions_) {
+        TF_RETURN_IF_ERROR(
+            CheckOpDeprecation(*resolved->op_def, versions_->producer()));
+      }
     }
-    TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
+    TF_RETURN_IF_ERROR(MakeNode(*node_def, resolved, &node));
     // Use original_node_def so name StringPiece remains valid
     gdef_nodes_[original_node_def.name()].node = node;
 
@@ -134,6 +134,11 @@ struct ImportGraphDefOptions {
   // If false skips shape validation.
   bool validate_shape;
 
+  // If false, skips checking that each imported NodeDef is valid for its op
+  // (see ValidateNodeDef()). Only meant for GraphDefs that this process just
+  // produced from valid graphs itself, e.g. ones that Grappler optimized.
+  bool validate_nodes = true;
+
   // TODO(ashankar): Enable handling of GraphDefs produced by newer binaries
   // with ops that are not defined in the binary calling ImportGraphDef.
   // Similar to the producer_op_list argument to import_graph_def in the
@@ -1001,6 +1001,60 @@ TEST_F(GraphConstructorTest, ImportGraphDef_DefaultAttrs) {
   EXPECT_EQ(31415, value);
 }
 
+TEST_F(GraphConstructorTest, ImportGraphDef_SkipNodeValidation) {
+  const string gdef_ascii =
+      "node { name: 'A' op: 'TestDefaultAttr' "
+      "       attr { key: 'unknown' value { i: 1 } } }";
+  ExpectError(gdef_ascii, ImportGraphDefOptions(),
+              {"NodeDef mentions attr 'unknown' not in Op"});
+
+  ImportGraphDefOptions opts;
+  opts.validate_nodes = false;
+  ExpectOK(gdef_ascii, opts);
+  Node* a = FindNode("A");
+  ASSERT_TRUE(a != nullptr);
+  int value = 0;
+  TF_EXPECT_OK(GetNodeAttr(a->attrs(), "default_int", &value));
+  EXPECT_EQ(31415, value);
+}
+
+TEST_F(GraphConstructorTest, LargeGraph) {
+  // Enough nodes for the constructor to resolve them in parallel.
+  const int kNumNodes = 10000;
+  GraphDef def;
+  NodeDef* input = def.add_node();
+  input->set_name("n0");
+  input->set_op("TestInput");
+  for (int i = 1; i < kNumNodes; ++i) {
+    NodeDef* node = def.add_node();
+    node->set_name(strings::StrCat("n", i));
+    node->set_op("TestMul");
+    node->add_input(strings::StrCat("n", i - 1));
+    node->add_input("n0:1");
+  }
+
+  GraphConstructorOptions opts;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, def, &graph_));
+  // Counts the source and sink nodes.
+  EXPECT_EQ(kNumNodes + 2, graph_.num_nodes());
+  EXPECT_TRUE(HasEdge("n41", 0, "n42", 0));
+  EXPECT_TRUE(HasEdge("n0", 1, "n42", 1));
+
+  Graph imported(OpRegistry::Global());
+  ImportGraphDefOptions import_opts;
+  import_opts.prefix = "import";
+  TF_ASSERT_OK(ImportGraphDef(import_opts, def, &imported, nullptr));
+  EXPECT_EQ(kNumNodes + 2, imported.num_nodes());
+
+  // Errors are still reported for the node that has them.
+  def.mutable_node(kNumNodes / 2)->set_op("NotRegistered");
+  Graph bad(OpRegistry::Global());
+  Status s = ConvertGraphDefToGraph(opts, def, &bad);
+  EXPECT_TRUE(str_util::StrContains(s.error_message(),
+                                    "Op type not registered 'NotRegistered'"))
+      << s;
+}
+
 TEST_F(GraphConstructorTest, ImportGraphDef_Versioning) {
   GraphDef def;
   const ImportGraphDefOptions opts;
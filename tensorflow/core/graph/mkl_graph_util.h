@@ -115,6 +115,24 @@ static inline bool IsMklElementWiseOp(const string& op_name, DataType T) {
 
   return result;
 }
+
+// Check whether opname is a unary element-wise op that is registered as an
+// MKL op that can take inputs in any MKL layout. These ops are applied to the
+// buffer of their input as it is, so they must map 0 to 0 to keep the padding
+// of blocked layouts (e.g. nChw8c) zero.
+// @input: name of the op
+// @input: T datatype to be used for checking op
+// @return: true if opname is registered as unary element-wise Mkl op;
+// false otherwise
+static inline bool IsMklUnaryElementWiseOp(const string& op_name, DataType T) {
+  if (!IsMklOp(op_name, T)) {
+    return false;
+  }
+  return 0 == op_name.compare(GetMklOpName("Abs")) ||
+         0 == op_name.compare(GetMklOpName("Neg")) ||
+         0 == op_name.compare(GetMklOpName("Sqrt")) ||
+         0 == op_name.compare(GetMklOpName("Square"));
+}
 }  // namespace mkl_op_registry
 }  // namespace tensorflow
 #endif  // INTEL_MKL
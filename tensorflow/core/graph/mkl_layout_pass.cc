@@ -2448,8 +2448,18 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
     csinfo_.squared_difference = "SquaredDifference";
     csinfo_.sub = "Sub";
     // End - element-wise ops. See note above.
+    // Unary element-wise ops. Ensure you also add any new ops to
+    // IsMklUnaryElementWiseOp in mkl_graph_util.h, so that they are only
+    // rewritten after MKL ops.
+    csinfo_.abs = "Abs";
+    csinfo_.neg = "Neg";
+    csinfo_.sqrt = "Sqrt";
+    csinfo_.square = "Square";
+    // End - unary element-wise ops.
 
     // NOTE: names are alphabetically sorted.
+    rinfo_.push_back({csinfo_.abs, mkl_op_registry::GetMklOpName(csinfo_.abs),
+                      CopyAttrsDataType, AlwaysRewrite});
     rinfo_.push_back({csinfo_.addn, mkl_op_registry::GetMklOpName(csinfo_.addn),
                       CopyAttrsAddN, AddNRewrite});
     rinfo_.push_back({csinfo_.add, mkl_op_registry::GetMklOpName(csinfo_.add),
@@ -2508,6 +2518,8 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
     rinfo_.push_back({csinfo_.mul,
                       mkl_op_registry::GetMklOpName(csinfo_.mul),
                       CopyAttrsDataType, AlwaysRewrite});
+    rinfo_.push_back({csinfo_.neg, mkl_op_registry::GetMklOpName(csinfo_.neg),
+                      CopyAttrsDataType, AlwaysRewrite});
     rinfo_.push_back({csinfo_.relu, mkl_op_registry::GetMklOpName(csinfo_.relu),
                       CopyAttrsDataType, AlwaysRewrite});
     rinfo_.push_back({csinfo_.relu_grad,
@@ -2528,6 +2540,12 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
                       mkl_op_registry::GetMklOpName(csinfo_.softmax),
                       CopyAttrsDataType, AlwaysRewrite});
 
+    rinfo_.push_back({csinfo_.sqrt,
+                      mkl_op_registry::GetMklOpName(csinfo_.sqrt),
+                      CopyAttrsDataType, AlwaysRewrite});
+    rinfo_.push_back({csinfo_.square,
+                      mkl_op_registry::GetMklOpName(csinfo_.square),
+                      CopyAttrsDataType, AlwaysRewrite});
     rinfo_.push_back({csinfo_.squared_difference,
                       mkl_op_registry::GetMklOpName(csinfo_.squared_difference),
                       CopyAttrsDataType, AlwaysRewrite});
@@ -2601,6 +2619,7 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
   /// Structure to store all constant strings
   /// NOTE: names are alphabetically sorted.
   typedef struct {
+    string abs;
     string addn;
     string add;
     string avg_pool;
@@ -2629,6 +2648,7 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
     string mkl_conv2d_grad_filter_with_bias;
     string mkl_conv2d_with_bias;
     string mul;
+    string neg;
     string relu;
     string relu_grad;
     string tanh;
@@ -2636,6 +2656,8 @@ class MklLayoutRewritePass : public GraphOptimizationPass {
     string reshape;
     string softmax;
     string split;
+    string sqrt;
+    string square;
     string squared_difference;
     string sub;
   } ConstStringsInfo;
@@ -4230,6 +4252,8 @@ MklLayoutRewritePass::CheckForNodeRewrite(const Node* n) const {
   VLOG(1) << "ELEMENTWISE: checking op: " << n->type_string();
   if (mkl_op_registry::IsMklElementWiseOp(
           mkl_op_registry::GetMklOpName(n->type_string()), T) ||
+      mkl_op_registry::IsMklUnaryElementWiseOp(
+          mkl_op_registry::GetMklOpName(n->type_string()), T) ||
       n->type_string().find("Identity") != string::npos) {
     VLOG(1) << "ELEMENTWISE: op is elementwise: " << n->type_string();
     bool incoming_mkl_edge = false;
@@ -2777,6 +2777,38 @@ TEST_F(MklLayoutPassTest, NodeRewrite_ReluReluGrad_Positive) {
             "DMT/_1->C:2");
 }
 
+// Unary element-wise op after an MKL op is rewritten, so that the MKL layout
+// passes through it.
+TEST_F(MklLayoutPassTest, NodeRewrite_UnaryElementWise_Positive) {
+  InitGraph(
+      "node { name: 'A' op: 'Input'}"
+      "node { name: 'B' op: 'Relu'"
+      " attr { key: 'T'                value { type: DT_FLOAT } }"
+      " input: ['A'] }"
+      "node { name: 'C' op: 'Square'"
+      " attr { key: 'T'                value { type: DT_FLOAT } }"
+      " input: ['B'] }"
+      "node { name: 'D' op: 'Zeta' attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'C'] }");
+  EXPECT_EQ(DoMklLayoutOptimizationPass(),
+            "A(Input);B(_MklRelu);C(_MklSquare);D(Zeta);DMT/_0(Const)|A->B;"
+            "A->D;A:control->DMT/_0:control;B->C;B:1->C:1;C->D:1;"
+            "DMT/_0->B:1");
+}
+
+// Unary element-wise op without MKL parents is not rewritten.
+TEST_F(MklLayoutPassTest, NodeRewrite_UnaryElementWise_Negative) {
+  InitGraph(
+      "node { name: 'A' op: 'Input'}"
+      "node { name: 'B' op: 'Square'"
+      " attr { key: 'T'                value { type: DT_FLOAT } }"
+      " input: ['A'] }"
+      "node { name: 'C' op: 'Zeta' attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B'] }");
+  EXPECT_EQ(DoMklLayoutOptimizationPass(),
+            "A(Input);B(Square);C(Zeta)|A->B;A->C;B->C:1");
+}
+
 TEST_F(MklLayoutPassTest, NodeRewrite_AvgPool_Positive) {
   InitGraph(
       "node { name: 'A' op: 'Input'}"
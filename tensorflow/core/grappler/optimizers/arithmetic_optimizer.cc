@@ -2818,6 +2818,8 @@ class UnaryOpsComposition : public ArithmeticOptimizerStage {
 
 class UniqueNodes {
  public:
+  explicit UniqueNodes(const NodeMap* node_map) : node_map_(node_map) {}
+
   NodeDef* FindOrAddRepresentative(NodeDef* node) {
     uint64 sig = ComputeSignature(*node);
     std::vector<NodeDef*>& candidates = rep_[sig];
@@ -2831,19 +2833,36 @@ class UniqueNodes {
   }
 
  private:
+  // Returns the tensor that `input` forwards through Identity nodes, such as
+  // the ones binding the arguments of inlined functions, so that computations
+  // from function bodies and from the outer graph match.
+  string CanonicalInput(const string& input) const;
   uint64 ComputeSignature(const NodeDef& node) const;
   bool SameNode(const NodeDef& node1, const NodeDef& node2) const;
 
+  const NodeMap* node_map_;  // Not owned.
   std::unordered_map<uint64, std::vector<NodeDef*>> rep_;
 };
 
+string UniqueNodes::CanonicalInput(const string& input) const {
+  string canonical = input;
+  int pos;
+  const NodeDef* node = node_map_->GetNode(ParseNodeName(canonical, &pos));
+  while (pos == 0 && node != nullptr && IsIdentity(*node) &&
+         node->input_size() == 1) {
+    canonical = node->input(0);
+    node = node_map_->GetNode(ParseNodeName(canonical, &pos));
+  }
+  return canonical;
+}
+
 uint64 UniqueNodes::ComputeSignature(const NodeDef& node) const {
   uint64 h = Hash64(node.op());
   h = Hash64Combine(Hash64(node.device()), h);
 
   for (const auto& input : node.input()) {
     int pos;
-    string node_name = ParseNodeName(input, &pos);
+    string node_name = ParseNodeName(CanonicalInput(input), &pos);
     h = Hash64CombineUnordered(Hash64(node_name), h);
     h = Hash64CombineUnordered(std::hash<int>()(pos), h);
   }
@@ -2870,8 +2889,12 @@ bool UniqueNodes::SameNode(const NodeDef& node1, const NodeDef& node2) const {
 
   // Compare inputs.
   if (IsCommutative(node1)) {
-    std::vector<string> inputs1(node1.input().begin(), node1.input().end());
-    std::vector<string> inputs2(node2.input().begin(), node2.input().end());
+    std::vector<string> inputs1;
+    std::vector<string> inputs2;
+    for (int index = 0; index < node1.input_size(); ++index) {
+      inputs1.push_back(CanonicalInput(node1.input(index)));
+      inputs2.push_back(CanonicalInput(node2.input(index)));
+    }
     std::sort(inputs1.begin(), inputs1.end());
     std::sort(inputs2.begin(), inputs2.end());
     return inputs1 == inputs2;
@@ -2885,8 +2908,8 @@ bool UniqueNodes::SameNode(const NodeDef& node1, const NodeDef& node2) const {
         ctrl_inputs1.push_back(node1.input(index));
         ctrl_inputs2.push_back(node2.input(index));
       } else {
-        regular_inputs1.push_back(node1.input(index));
-        regular_inputs2.push_back(node2.input(index));
+        regular_inputs1.push_back(CanonicalInput(node1.input(index)));
+        regular_inputs2.push_back(CanonicalInput(node2.input(index)));
       }
     }
     if (regular_inputs1 != regular_inputs2) {
@@ -2945,9 +2968,37 @@ bool ArithmeticOptimizer::CanDedup(const NodeDef& node) const {
   if (IsAssert(node)) {
     return true;
   }
+  // Calls to the same function with the same inputs compute the same outputs,
+  // unless the function has side effects.
+  if (function_library_ != nullptr &&
+      function_library_->Find(node.op()) != nullptr) {
+    return IsFunctionFreeOfSideEffect(node.op());
+  }
   return IsFreeOfSideEffect(node);
 }
 
+bool ArithmeticOptimizer::IsFunctionFreeOfSideEffect(
+    const string& name) const {
+  auto it = side_effect_free_functions_.find(name);
+  if (it != side_effect_free_functions_.end()) {
+    return it->second;
+  }
+  // Recursive calls don't make the function free of side effects.
+  side_effect_free_functions_[name] = false;
+  const FunctionDef* function = function_library_->Find(name);
+  bool free_of_side_effect = function != nullptr;
+  for (int i = 0; free_of_side_effect && i < function->node_def_size(); ++i) {
+    const NodeDef& node = function->node_def(i);
+    if (function_library_->Find(node.op()) != nullptr) {
+      free_of_side_effect = IsFunctionFreeOfSideEffect(node.op());
+    } else {
+      free_of_side_effect = IsFreeOfSideEffect(node);
+    }
+  }
+  side_effect_free_functions_[name] = free_of_side_effect;
+  return free_of_side_effect;
+}
+
 void ArithmeticOptimizer::DedupComputations() {
   bool stop = true;
   SimpleGraphView graph_view;
@@ -2958,7 +3009,7 @@ void ArithmeticOptimizer::DedupComputations() {
   std::set<int> duplicates;
   do {
     stop = true;
-    UniqueNodes nodes;
+    UniqueNodes nodes(node_map_.get());
     for (int i = 0; i < optimized_graph_->node_size(); ++i) {
       if (duplicates.find(i) != duplicates.end()) {
         continue;
@@ -3151,6 +3202,9 @@ Status ArithmeticOptimizer::Optimize(Cluster* /*cluster*/,
   GrapplerItem optimized_item(item, optimized_graph);
   optimized_graph_ = &optimized_item.graph;
   node_map_.reset(new NodeMap(optimized_graph_));
+  function_library_.reset(new FunctionLibraryDefinition(
+      OpRegistry::Global(), item.graph.library()));
+  side_effect_free_functions_.clear();
 
   if (options_.dedup_computations) {
     DedupComputations();
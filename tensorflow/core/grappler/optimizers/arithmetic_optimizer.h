@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
 
+#include <unordered_map>
 #include <unordered_set>
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
@@ -91,6 +93,10 @@ class ArithmeticOptimizer : public GraphOptimizer {
   // Returns true if it is safe to dedup node from the graph.
   bool CanDedup(const NodeDef& node) const;
 
+  // Returns true if the function `name` of the library, and the functions it
+  // calls, have no side effect.
+  bool IsFunctionFreeOfSideEffect(const string& name) const;
+
   // Dedup redundant nodes in the graph.
   void DedupComputations();
 
@@ -126,6 +132,9 @@ class ArithmeticOptimizer : public GraphOptimizer {
   std::unordered_set<string> nodes_to_preserve_;
   std::unique_ptr<NodeMap> node_map_;
   std::unique_ptr<GraphProperties> graph_properties_;
+  std::unique_ptr<FunctionLibraryDefinition> function_library_;
+  // Whether the functions of the library are free of side effects.
+  mutable std::unordered_map<string, bool> side_effect_free_functions_;
   GraphDef* optimized_graph_ = nullptr;  // Not owned.
 };
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -369,6 +370,80 @@ TEST_F(ArithmeticOptimizerTest, OpDeduppingAssertAndCheckNumerics) {
   test::ExpectTensorNear<double>(tensors_expected[0], tensors[0], 1e-6);
 }
 
+TEST_F(ArithmeticOptimizerTest, OpDedupThroughIdentity) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {1, 2});
+  Output y = ops::Const(s.WithOpName("y"), {3.0f, 4.0f}, {2, 1});
+  // E.g. the arguments of an inlined function.
+  Output x_arg = ops::Identity(s.WithOpName("x_arg"), x);
+  Output y_arg = ops::Identity(s.WithOpName("y_arg"), y);
+  Output matmul1 = ops::MatMul(s.WithOpName("matmul1"), x, y);
+  Output matmul2 = ops::MatMul(s.WithOpName("matmul2"), x_arg, y_arg);
+  Output sub = ops::Sub(s.WithOpName("sub"), matmul1, matmul2);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"sub"};
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+
+  ArithmeticOptimizer optimizer;
+  DisableAllStages(&optimizer);
+  optimizer.options_.dedup_computations = true;
+  GraphDef output;
+  OptimizeTwice(&optimizer, &item, &output);
+  NodeMap node_map(&output);
+  EXPECT_EQ(nullptr, node_map.GetNode("matmul2"));
+  const NodeDef* new_sub = node_map.GetNode("sub");
+  ASSERT_NE(new_sub, nullptr);
+  EXPECT_EQ("matmul1", new_sub->input(0));
+  EXPECT_EQ("matmul1", new_sub->input(1));
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-6);
+}
+
+TEST_F(ArithmeticOptimizerTest, OpDedupFunctionCalls) {
+  using test::function::NDef;
+  FunctionDef random_like = FunctionDefHelper::Define(
+      "RandomLike", {"x: float"}, {"y: float"}, {},
+      {{{"shape"}, "Shape", {"x"}, {{"T", DT_FLOAT}}},
+       {{"y"},
+        "RandomUniform",
+        {"shape"},
+        {{"T", DT_INT32}, {"dtype", DT_FLOAT}}}});
+  GrapplerItem item;
+  item.fetch = {"out1", "out2"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("twice1", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}}),
+       NDef("twice2", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}}),
+       NDef("random1", "RandomLike", {"x"}, {}),
+       NDef("random2", "RandomLike", {"x"}, {}),
+       NDef("out1", "Sub", {"twice1", "twice2"}, {{"T", DT_FLOAT}}),
+       NDef("out2", "Sub", {"random1", "random2"}, {{"T", DT_FLOAT}})},
+      {test::function::XTimesTwo(), random_like});
+
+  ArithmeticOptimizer optimizer;
+  DisableAllStages(&optimizer);
+  optimizer.options_.dedup_computations = true;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+
+  // The calls to the stateless function are merged.
+  EXPECT_EQ(nullptr, node_map.GetNode("twice2"));
+  const NodeDef* out1 = node_map.GetNode("out1");
+  ASSERT_NE(out1, nullptr);
+  EXPECT_EQ("twice1", out1->input(0));
+  EXPECT_EQ("twice1", out1->input(1));
+
+  // The calls to the stateful one aren't.
+  const NodeDef* out2 = node_map.GetNode("out2");
+  ASSERT_NE(out2, nullptr);
+  EXPECT_EQ("random1", out2->input(0));
+  EXPECT_EQ("random2", out2->input(1));
+}
+
 TEST_F(ArithmeticOptimizerTest, OpDedupCommutative) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output c1 = ops::Const(s.WithOpName("c1"), {1.0f, 2.0f}, {1, 2});
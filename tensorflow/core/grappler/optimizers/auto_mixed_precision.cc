@@ -0,0 +1,361 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns `ops` amended by TF_AUTO_MIXED_PRECISION_<name>_ADD and
+// TF_AUTO_MIXED_PRECISION_<name>_REMOVE.
+std::set<string> OpList(const string& name, std::set<string> ops) {
+  string to_add;
+  string to_remove;
+  TF_CHECK_OK(ReadStringFromEnvVar(
+      strings::StrCat("TF_AUTO_MIXED_PRECISION_", name, "_ADD"), "", &to_add));
+  TF_CHECK_OK(ReadStringFromEnvVar(
+      strings::StrCat("TF_AUTO_MIXED_PRECISION_", name, "_REMOVE"), "",
+      &to_remove));
+  for (const string& op : str_util::Split(to_add, ',', str_util::SkipEmpty())) {
+    ops.insert(op);
+  }
+  for (const string& op :
+       str_util::Split(to_remove, ',', str_util::SkipEmpty())) {
+    ops.erase(op);
+  }
+  return ops;
+}
+
+struct OpLists {
+  std::set<string> whitelist;
+  std::set<string> graylist;
+  std::set<string> blacklist;
+};
+
+const OpLists& GetOpLists() {
+  static const OpLists* lists = [] {
+    OpLists* lists = new OpLists;
+    lists->whitelist =
+        OpList("WHITELIST", {"BatchMatMul", "Conv2D", "Conv2DBackpropFilter",
+                             "Conv2DBackpropInput", "MatMul"});
+    // Besides the element-wise ops that are safe in float16, the graylist has
+    // the ops that only move data, so that converted regions span them.
+    lists->graylist = OpList(
+        "GRAYLIST",
+        {"Add", "AddN", "AvgPool", "AvgPoolGrad", "BiasAdd", "BiasAddGrad",
+         "ConcatV2", "Elu", "EluGrad", "ExpandDims", "FusedBatchNormGradV2",
+         "FusedBatchNormV2", "Identity", "MaxPool", "MaxPoolGrad", "Mul",
+         "Pack", "Pad", "Relu", "Relu6", "Relu6Grad", "ReluGrad", "Reshape",
+         "Sigmoid", "SigmoidGrad", "Slice", "Split", "Squeeze", "StridedSlice",
+         "Sub", "Tanh", "TanhGrad", "Tile", "Transpose", "Unpack"});
+    lists->blacklist = OpList(
+        "BLACKLIST",
+        {"Exp", "L2Loss", "Log", "LogSoftmax", "Mean", "Pow", "Prod",
+         "Softmax", "SoftmaxCrossEntropyWithLogits",
+         "SparseSoftmaxCrossEntropyWithLogits", "SquaredDifference", "Sum"});
+    return lists;
+  }();
+  return *lists;
+}
+
+// Whether the cluster has a GPU with Tensor Cores, which make float16 matrix
+// multiplications and convolutions several times faster.
+bool HasTensorCores(Cluster* cluster) {
+  if (cluster == nullptr) return false;
+  for (const auto& device : cluster->GetDevices()) {
+    const DeviceProperties& properties = device.second;
+    if (properties.type() != "GPU") continue;
+    auto it = properties.environment().find("architecture");
+    if (it == properties.environment().end()) continue;
+    const std::vector<string> version = str_util::Split(it->second, '.');
+    int32 major;
+    if (!version.empty() && strings::safe_strto32(version[0], &major) &&
+        major >= 7) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NodeIsOnGpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+         parsed.has_type && parsed.type == DEVICE_GPU;
+}
+
+// Finds the inputs and outputs of `node` whose type is its "T" attr. Returns
+// false if the node can not be converted to float16: its "T" is not float32,
+// does not allow float16, or types references.
+bool FindTypedArgs(const NodeDef& node, std::set<int>* inputs,
+                   std::set<int>* outputs) {
+  auto it = node.attr().find("T");
+  if (it == node.attr().end() || it->second.type() != DT_FLOAT) return false;
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  const OpDef::AttrDef* attr = FindAttr("T", *op_def);
+  if (attr == nullptr) return false;
+  if (attr->has_allowed_values()) {
+    const auto& allowed = attr->allowed_values().list().type();
+    if (std::find(allowed.begin(), allowed.end(), DT_HALF) == allowed.end()) {
+      return false;
+    }
+  }
+  NameRangeMap input_ranges;
+  NameRangeMap output_ranges;
+  if (!NameRangesForNode(node, *op_def, &input_ranges, &output_ranges).ok()) {
+    return false;
+  }
+  for (const auto& arg : op_def->input_arg()) {
+    if (arg.type_attr() != "T") continue;
+    if (arg.is_ref()) return false;
+    const auto& range = input_ranges[arg.name()];
+    for (int i = range.first; i < range.second; ++i) inputs->insert(i);
+  }
+  for (const auto& arg : op_def->output_arg()) {
+    if (arg.type_attr() != "T") continue;
+    if (arg.is_ref()) return false;
+    const auto& range = output_ranges[arg.name()];
+    for (int i = range.first; i < range.second; ++i) outputs->insert(i);
+  }
+  return true;
+}
+
+struct NodeInfo {
+  // Whether a blacklist op is upstream of the node through graylist ops.
+  bool tainted = false;
+  // Whether the node is converted to float16.
+  bool half = false;
+  // The inputs and outputs of the node whose type is its "T" attr.
+  std::set<int> typed_inputs;
+  std::set<int> typed_outputs;
+  // The inputs and outputs of the node that are float16 after the rewrite,
+  // but were float32 before.
+  std::set<int> half_inputs;
+  std::set<int> half_outputs;
+};
+
+class AutoMixedPrecisionImpl {
+ public:
+  AutoMixedPrecisionImpl(const GrapplerItem& item, GraphDef* graph)
+      : graph_(graph),
+        nodes_to_preserve_(item.NodesToPreserve()),
+        lists_(GetOpLists()) {}
+
+  Status Optimize() {
+    TF_RETURN_IF_ERROR(TopologicalSort(graph_));
+    num_nodes_ = graph_->node_size();
+    info_.resize(num_nodes_);
+    consumers_.resize(num_nodes_);
+    for (int i = 0; i < num_nodes_; ++i) {
+      index_[graph_->node(i).name()] = i;
+    }
+    for (int i = 0; i < num_nodes_; ++i) {
+      const NodeDef& node = graph_->node(i);
+      for (int j = 0; j < node.input_size(); ++j) {
+        if (IsControlInput(node.input(j))) break;
+        int port;
+        const int producer = Producer(node.input(j), &port);
+        if (producer >= 0) consumers_[producer].push_back({i, j});
+      }
+    }
+
+    PaintNodes();
+    RetargetCasts();
+    const int num_casts = InsertCasts();
+    int num_converted = 0;
+    for (int i = 0; i < num_nodes_; ++i) {
+      if (info_[i].half) {
+        (*graph_->mutable_node(i)->mutable_attr())["T"].set_type(DT_HALF);
+        ++num_converted;
+      }
+    }
+    VLOG(1) << "Converted " << num_converted
+            << " nodes to float16, inserting " << num_casts << " casts";
+    return Status::OK();
+  }
+
+ private:
+  // Returns the index of the node that produces `input`, or -1.
+  int Producer(const string& input, int* port) const {
+    auto it = index_.find(ParseNodeName(input, port));
+    return it == index_.end() ? -1 : it->second;
+  }
+
+  // Decides which nodes to convert, in topological order so that the
+  // producers of a node are decided before it.
+  void PaintNodes() {
+    for (int i = 0; i < num_nodes_; ++i) {
+      const NodeDef& node = graph_->node(i);
+      NodeInfo& info = info_[i];
+      const bool convertible =
+          NodeIsOnGpu(node) && nodes_to_preserve_.count(node.name()) == 0 &&
+          FindTypedArgs(node, &info.typed_inputs, &info.typed_outputs);
+      const bool white = lists_.whitelist.count(node.op()) > 0;
+      const bool gray = lists_.graylist.count(node.op()) > 0;
+      const bool black = lists_.blacklist.count(node.op()) > 0;
+
+      bool any_half_input = false;
+      bool any_tainted_input = false;
+      for (int j = 0; j < node.input_size(); ++j) {
+        if (IsControlInput(node.input(j))) break;
+        int port;
+        const int producer = Producer(node.input(j), &port);
+        if (producer < 0) continue;
+        const NodeInfo& producer_info = info_[producer];
+        any_tainted_input |= producer_info.tainted;
+        any_half_input |= info.typed_inputs.count(j) > 0 &&
+                          producer_info.half_outputs.count(port) > 0;
+      }
+      info.tainted = black || (gray && any_tainted_input);
+      info.half = convertible && !black &&
+                  (white || (gray && !info.tainted && any_half_input));
+      if (info.half) {
+        info.half_inputs = info.typed_inputs;
+        info.half_outputs = info.typed_outputs;
+      }
+    }
+  }
+
+  // Retargets the Cast ops next to converted nodes, rather than pairing them
+  // with new casts: a Cast fed by a converted node casts from float16, and a
+  // Cast all of whose consumers are converted casts to float16.
+  void RetargetCasts() {
+    for (int i = 0; i < num_nodes_; ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      if (!IsCast(*node) || nodes_to_preserve_.count(node->name()) > 0) {
+        continue;
+      }
+      NodeInfo& info = info_[i];
+      auto* attr = node->mutable_attr();
+      int port;
+      const int producer = Producer(node->input(0), &port);
+      if ((*attr)["SrcT"].type() == DT_FLOAT && producer >= 0 &&
+          info_[producer].half_outputs.count(port) > 0) {
+        (*attr)["SrcT"].set_type(DT_HALF);
+        info.half_inputs.insert(0);
+      }
+      bool all_consumers_half = !consumers_[i].empty();
+      for (const auto& consumer : consumers_[i]) {
+        all_consumers_half &=
+            info_[consumer.first].half_inputs.count(consumer.second) > 0;
+      }
+      if ((*attr)["DstT"].type() == DT_FLOAT && all_consumers_half) {
+        (*attr)["DstT"].set_type(DT_HALF);
+        info.half_outputs.insert(0);
+      }
+      if ((*attr)["SrcT"].type() == (*attr)["DstT"].type()) {
+        const DataType type = (*attr)["SrcT"].type();
+        node->set_op("Identity");
+        attr->clear();
+        (*attr)["T"].set_type(type);
+      }
+    }
+  }
+
+  // Inserts casts between the producers and the consumers that disagree on
+  // whether a tensor is float16. Returns the number of casts inserted.
+  int InsertCasts() {
+    std::unordered_set<string> casts;
+    for (int i = 0; i < num_nodes_; ++i) {
+      NodeDef* node = graph_->mutable_node(i);
+      for (int j = 0; j < node->input_size(); ++j) {
+        if (IsControlInput(node->input(j))) break;
+        int port;
+        const int producer = Producer(node->input(j), &port);
+        if (producer < 0) continue;
+        const bool from_half = info_[producer].half_outputs.count(port) > 0;
+        const bool to_half = info_[i].half_inputs.count(j) > 0;
+        if (from_half == to_half) continue;
+
+        const string cast_name = strings::StrCat(
+            graph_->node(producer).name(), "-", port, "-",
+            to_half ? "CastToFp16" : "CastToFp32", "-AutoMixedPrecision");
+        if (casts.insert(cast_name).second) {
+          NodeDef* cast = graph_->add_node();
+          cast->set_name(cast_name);
+          cast->set_op("Cast");
+          cast->set_device(node->device());
+          cast->add_input(node->input(j));
+          auto* attr = cast->mutable_attr();
+          (*attr)["SrcT"].set_type(from_half ? DT_HALF : DT_FLOAT);
+          (*attr)["DstT"].set_type(to_half ? DT_HALF : DT_FLOAT);
+          (*attr)["Truncate"].set_b(false);
+        }
+        node->set_input(j, cast_name);
+      }
+    }
+    return casts.size();
+  }
+
+  GraphDef* graph_;
+  const std::unordered_set<string> nodes_to_preserve_;
+  const OpLists& lists_;
+  int num_nodes_ = 0;
+  std::unordered_map<string, int> index_;
+  std::vector<NodeInfo> info_;
+  // The consumers of the outputs of each node, as pairs of the consumer and
+  // its input.
+  std::vector<std::vector<std::pair<int, int>>> consumers_;
+};
+
+}  // namespace
+
+Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                    GraphDef* output) {
+  *output = item.graph;
+  if (!HasTensorCores(cluster)) {
+    VLOG(1) << "No GPU with Tensor Cores, skipping the automatic mixed "
+               "precision rewrite";
+    return Status::OK();
+  }
+  return AutoMixedPrecisionImpl(item, output).Optimize();
+}
+
+void AutoMixedPrecision::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                  const GraphDef& optimized_graph,
+                                  double result) {
+  // Nothing to do for AutoMixedPrecision.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
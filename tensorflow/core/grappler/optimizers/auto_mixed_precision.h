@@ -0,0 +1,69 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Converts float32 ops placed on GPUs to float16 where it is fast and safe,
+// inserting the casts this requires. Runs only if the cluster has a GPU with
+// Tensor Cores (compute capability 7.0 or higher).
+//
+// Ops fall into three lists:
+//  - whitelist: ops that Tensor Cores speed up, like MatMul and Conv2D, which
+//    are always converted;
+//  - graylist: ops that are safe in float16, like Add, Relu or Reshape, which
+//    are converted when some of their inputs come from converted ops, unless
+//    a blacklist op is upstream of them through graylist ops;
+//  - blacklist: numerically sensitive ops, like Exp, Softmax or Sum, which
+//    stay in float32.
+// The comma-separated op names in TF_AUTO_MIXED_PRECISION_<LIST>_ADD and
+// TF_AUTO_MIXED_PRECISION_<LIST>_REMOVE amend the lists, where <LIST> is
+// WHITELIST, GRAYLIST or BLACKLIST. The ops added must have float16 GPU
+// kernels.
+//
+// Existing Cast ops next to converted ops are retargeted rather than paired
+// with new casts, and those that end up casting to their own type become
+// Identity ops. Gradients computed in float16 usually need loss scaling; see
+// tf.contrib.mixed_precision.
+class AutoMixedPrecision : public GraphOptimizer {
+ public:
+  explicit AutoMixedPrecision(
+      RewriterConfig::Toggle opt_level = RewriterConfig::ON)
+      : opt_level_(opt_level) {}
+
+  ~AutoMixedPrecision() override {}
+
+  string name() const override { return "auto_mixed_precision"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
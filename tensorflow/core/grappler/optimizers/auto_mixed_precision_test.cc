@@ -0,0 +1,143 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+
+#include <unordered_map>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class AutoMixedPrecisionTest : public GrapplerTest {
+ protected:
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster(
+      const string& architecture) {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.mutable_environment()->insert({"architecture", architecture});
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/job:localhost/replica:0/task:0/cpu:0"] = cpu_device;
+    devices["/job:localhost/replica:0/task:0/gpu:0"] = gpu_device;
+    return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
+  }
+
+  static GrapplerItem CreateItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+        "/job:localhost/replica:0/task:0/device:GPU:0");
+    Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+    Output w = ops::Const(s.WithOpName("w"), 1.0f, {8, 8});
+    Output mm = ops::MatMul(s.WithOpName("mm"), x, w);
+    Output relu = ops::Relu(s.WithOpName("relu"), mm);
+    Output exp = ops::Exp(s.WithOpName("exp"), relu);
+    Output add = ops::Add(s.WithOpName("add"), exp, relu);
+    Output mm2 = ops::MatMul(s.WithOpName("mm2"), relu, w);
+    Output cast16 = ops::Cast(s.WithOpName("cast16"), mm2, DT_HALF);
+    Output neg = ops::Neg(s.WithOpName("neg"), cast16);
+    Output i = ops::Placeholder(s.WithOpName("i"), DT_INT32);
+    Output xf = ops::Cast(s.WithOpName("xf"), i, DT_FLOAT);
+    Output mm3 = ops::MatMul(s.WithOpName("mm3"), xf, w);
+    Output exp3 = ops::Exp(s.WithOpName("exp3"), mm3);
+
+    GrapplerItem item;
+    item.fetch = {"add", "neg", "exp3"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(AutoMixedPrecisionTest, ConvertsToHalf) {
+  GrapplerItem item = CreateItem();
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster("7.0"));
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  // x, w, relu and mm3 get a cast each.
+  EXPECT_EQ(item.graph.node_size() + 4, output.node_size());
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : output.node()) {
+    nodes[node.name()] = &node;
+  }
+  auto type = [&nodes](const string& name, const string& attr) {
+    return nodes.at(name)->attr().at(attr).type();
+  };
+
+  const string x16 = "x-0-CastToFp16-AutoMixedPrecision";
+  const string w16 = "w-0-CastToFp16-AutoMixedPrecision";
+  const string relu32 = "relu-0-CastToFp32-AutoMixedPrecision";
+  const string mm3_32 = "mm3-0-CastToFp32-AutoMixedPrecision";
+  for (const string& cast : {x16, w16}) {
+    ASSERT_EQ(1, nodes.count(cast));
+    EXPECT_EQ(DT_FLOAT, type(cast, "SrcT"));
+    EXPECT_EQ(DT_HALF, type(cast, "DstT"));
+  }
+  for (const string& cast : {relu32, mm3_32}) {
+    ASSERT_EQ(1, nodes.count(cast));
+    EXPECT_EQ(DT_HALF, type(cast, "SrcT"));
+    EXPECT_EQ(DT_FLOAT, type(cast, "DstT"));
+  }
+
+  // The whitelist ops and the graylist ops they feed are converted.
+  EXPECT_EQ(DT_HALF, type("mm", "T"));
+  EXPECT_EQ(x16, nodes["mm"]->input(0));
+  EXPECT_EQ(w16, nodes["mm"]->input(1));
+  EXPECT_EQ(DT_HALF, type("relu", "T"));
+  EXPECT_EQ("mm", nodes["relu"]->input(0));
+  EXPECT_EQ(DT_HALF, type("mm2", "T"));
+  EXPECT_EQ("relu", nodes["mm2"]->input(0));
+  EXPECT_EQ(w16, nodes["mm2"]->input(1));
+
+  // The blacklist ops, and the graylist ops they feed, stay in float32.
+  EXPECT_EQ(DT_FLOAT, type("exp", "T"));
+  EXPECT_EQ(relu32, nodes["exp"]->input(0));
+  EXPECT_EQ(DT_FLOAT, type("add", "T"));
+  EXPECT_EQ("exp", nodes["add"]->input(0));
+  EXPECT_EQ(relu32, nodes["add"]->input(1));
+  EXPECT_EQ(mm3_32, nodes["exp3"]->input(0));
+
+  // The existing casts are retargeted.
+  EXPECT_EQ("Identity", nodes["cast16"]->op());
+  EXPECT_EQ(DT_HALF, type("cast16", "T"));
+  EXPECT_EQ("mm2", nodes["cast16"]->input(0));
+  EXPECT_EQ(DT_HALF, type("neg", "T"));
+  EXPECT_EQ("Cast", nodes["xf"]->op());
+  EXPECT_EQ(DT_INT32, type("xf", "SrcT"));
+  EXPECT_EQ(DT_HALF, type("xf", "DstT"));
+  EXPECT_EQ(DT_HALF, type("mm3", "T"));
+  EXPECT_EQ("xf", nodes["mm3"]->input(0));
+}
+
+TEST_F(AutoMixedPrecisionTest, NoTensorCores) {
+  GrapplerItem item = CreateItem();
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster("6.1"));
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
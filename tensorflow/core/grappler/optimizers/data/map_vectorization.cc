@@ -0,0 +1,299 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <map>
+#include <set>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/platform/protobuf.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Element-wise ops, whose output for a batch is the batch of their outputs
+// for each element. None of them fails on some values (as integer division
+// by zero does), which would otherwise fail the whole batch.
+bool IsUnaryElementWise(const string& op) {
+  static const auto* ops = new std::set<string>{
+      "Abs", "Acos", "Acosh", "Asin", "Asinh", "Atan", "Atanh", "Cast", "Ceil",
+      "Cos", "Cosh", "Elu", "Erf", "Exp", "Expm1", "Floor", "Identity",
+      "IsFinite", "IsInf", "IsNan", "Log", "Log1p", "LogicalNot", "Neg", "Relu",
+      "Relu6", "Rint", "Round", "Rsqrt", "Selu", "Sigmoid", "Sign", "Sin",
+      "Sinh", "Softplus", "Softsign", "Sqrt", "Square", "Tan", "Tanh"};
+  return ops->count(op) > 0;
+}
+
+bool IsBinaryElementWise(const string& op) {
+  static const auto* ops = new std::set<string>{
+      "Add", "AddV2", "Equal", "Greater", "GreaterEqual", "Less", "LessEqual",
+      "LogicalAnd", "LogicalOr", "Maximum", "Minimum", "Mul", "NotEqual",
+      "RealDiv", "SquaredDifference", "Sub"};
+  return ops->count(op) > 0;
+}
+
+// Returns true if `function` computes the batch of its outputs when applied
+// to a batch of elements with the given component shapes. Every output must
+// depend on the elements, and the operands of the binary ops must either be
+// scalar constants or have the same shape, so that broadcasting is the same
+// for a batch.
+bool IsBatchPolymorphic(const FunctionDef& function,
+                        const AttrValue& element_shapes) {
+  const auto& signature = function.signature();
+  if (signature.input_arg_size() != element_shapes.list().shape_size()) {
+    return false;
+  }
+  // The component whose shape each batched tensor has.
+  std::map<string, int> batched;
+  std::set<string> scalars;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    batched[signature.input_arg(i).name()] = i;
+  }
+  auto same_shape = [&element_shapes](int a, int b) {
+    if (a == b) return true;
+    PartialTensorShape shape_a(element_shapes.list().shape(a));
+    PartialTensorShape shape_b(element_shapes.list().shape(b));
+    return shape_a.IsFullyDefined() && shape_a.IsIdenticalTo(shape_b);
+  };
+
+  // The nodes of a function are not sorted, so they are resolved in as many
+  // passes as needed.
+  std::vector<const NodeDef*> pending;
+  for (const NodeDef& node : function.node_def()) pending.push_back(&node);
+  while (!pending.empty()) {
+    std::vector<const NodeDef*> unresolved;
+    for (const NodeDef* node : pending) {
+      std::vector<string> inputs;
+      bool ready = true;
+      for (const string& input : node->input()) {
+        if (IsControlInput(input)) continue;
+        const string name = input.substr(0, input.find(':'));
+        ready = ready && (batched.count(name) > 0 || scalars.count(name) > 0);
+        inputs.push_back(name);
+      }
+      if (!ready) {
+        unresolved.push_back(node);
+        continue;
+      }
+      if (node->op() == "Const") {
+        const auto& value = node->attr().find("value");
+        if (value == node->attr().end() ||
+            value->second.tensor().tensor_shape().dim_size() != 0) {
+          return false;
+        }
+        scalars.insert(node->name());
+      } else if (IsUnaryElementWise(node->op()) && inputs.size() == 1) {
+        if (batched.count(inputs[0])) {
+          batched[node->name()] = batched[inputs[0]];
+        } else {
+          scalars.insert(node->name());
+        }
+      } else if (IsBinaryElementWise(node->op()) && inputs.size() == 2) {
+        const bool batched_0 = batched.count(inputs[0]) > 0;
+        const bool batched_1 = batched.count(inputs[1]) > 0;
+        if (batched_0 && batched_1) {
+          if (!same_shape(batched[inputs[0]], batched[inputs[1]])) {
+            return false;
+          }
+          batched[node->name()] = batched[inputs[0]];
+        } else if (batched_0 || batched_1) {
+          batched[node->name()] = batched[inputs[batched_0 ? 0 : 1]];
+        } else {
+          scalars.insert(node->name());
+        }
+      } else {
+        return false;
+      }
+    }
+    if (unresolved.size() == pending.size()) return false;
+    pending.swap(unresolved);
+  }
+
+  for (const auto& ret : function.ret()) {
+    if (batched.count(ret.second.substr(0, ret.second.find(':'))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Makes the node batching the elements of `input`, given their types and
+// shapes. The batch dimension is the one of `batched_shapes`, the shapes of
+// the original batches.
+NodeDef MakeBatchNode(const string& input, const string& batch_op,
+                      const std::vector<string>& batch_inputs,
+                      const AttrValue& element_types,
+                      const AttrValue& element_shapes,
+                      const AttrValue& batched_shapes,
+                      MutableGraphView* graph) {
+  NodeDef new_node;
+  new_node.set_op(batch_op);
+  graph_utils::SetUniqueGraphNodeName(batch_op, graph->GetGraph(), &new_node);
+  new_node.add_input(input);
+  for (const string& batch_input : batch_inputs) {
+    new_node.add_input(batch_input);
+  }
+
+  int64 batch_dim = -1;
+  const TensorShapeProto& batched_shape = batched_shapes.list().shape(0);
+  if (!batched_shape.unknown_rank() && batched_shape.dim_size() > 0) {
+    batch_dim = batched_shape.dim(0).size();
+  }
+  AttrValue shapes;
+  for (const TensorShapeProto& element_shape : element_shapes.list().shape()) {
+    TensorShapeProto* shape = shapes.mutable_list()->add_shape();
+    if (element_shape.unknown_rank()) {
+      shape->set_unknown_rank(true);
+      continue;
+    }
+    shape->add_dim()->set_size(batch_dim);
+    for (const auto& dim : element_shape.dim()) {
+      shape->add_dim()->set_size(dim.size());
+    }
+  }
+  (*new_node.mutable_attr())["output_types"] = element_types;
+  (*new_node.mutable_attr())["output_shapes"] = shapes;
+  return new_node;
+}
+
+// Makes the node mapping the batches of `batch_node` with the function of
+// `map_node`, which produces the batches of `old_batch_node`.
+NodeDef MakeMapNode(const NodeDef& map_node, const NodeDef& batch_node,
+                    const string& map_op, const string& num_parallel_calls,
+                    const NodeDef& old_batch_node, MutableGraphView* graph) {
+  NodeDef new_node;
+  new_node.set_op(map_op);
+  graph_utils::SetUniqueGraphNodeName(map_op, graph->GetGraph(), &new_node);
+  new_node.add_input(batch_node.name());
+  if (map_op == "ParallelMapDataset") {
+    new_node.add_input(num_parallel_calls);
+  }
+  for (auto key : {"f", "Targuments"}) {
+    (*new_node.mutable_attr())[key] = map_node.attr().at(key);
+  }
+  for (auto key : {"output_shapes", "output_types"}) {
+    (*new_node.mutable_attr())[key] = old_batch_node.attr().at(key);
+  }
+  return new_node;
+}
+
+}  // namespace
+
+Status MapVectorization::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                  GraphDef* output) {
+  *output = item.graph;
+  MutableGraphView graph(output);
+  std::set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (const NodeDef& node : item.graph.node()) {
+    const NodeDef* map_node = nullptr;
+    const NodeDef& batch_node = node;
+    if (node.op() == "BatchDataset" || node.op() == "BatchDatasetV2") {
+      GraphView::InputPort input_port = graph.GetInputPort(node.name(), 0);
+      map_node = graph.GetRegularFanin(input_port).node;
+      if (map_node->op() != "MapDataset" &&
+          map_node->op() != "ParallelMapDataset") {
+        continue;
+      }
+    } else if (node.op() == "MapAndBatchDatasetV2") {
+      map_node = &node;
+    } else {
+      continue;
+    }
+
+    // Captured inputs would not be batched, so the function must not have
+    // any.
+    if (map_node->attr().at("Targuments").list().type_size() != 0) continue;
+    const NodeDef* input_node = graph.GetNode(map_node->input(0));
+    if (!input_node || !input_node->attr().count("output_types") ||
+        !input_node->attr().count("output_shapes")) {
+      continue;
+    }
+    const AttrValue& element_types = input_node->attr().at("output_types");
+    const AttrValue& element_shapes = input_node->attr().at("output_shapes");
+    const FunctionDef* function =
+        function_library.Find(map_node->attr().at("f").func().name());
+    if (!function || !IsBatchPolymorphic(*function, element_shapes)) continue;
+
+    std::vector<string> batch_inputs;
+    string batch_op = batch_node.op();
+    string map_op = map_node->op();
+    string num_parallel_calls;
+    if (&batch_node == map_node) {
+      // MapAndBatchDatasetV2 takes the batch size, the number of parallel
+      // calls and whether to drop the remainder.
+      batch_op = "BatchDatasetV2";
+      batch_inputs = {batch_node.input(1), batch_node.input(3)};
+      map_op = "MapDataset";
+      // The number of parallel calls is an int32 for ParallelMapDataset and
+      // an int64 for MapAndBatchDatasetV2, so it is a new Const node.
+      const NodeDef* v = graph.GetNode(batch_node.input(2));
+      if (v && v->op() == "Const" &&
+          v->attr().at("value").tensor().int64_val_size() > 0) {
+        const int64 calls = v->attr().at("value").tensor().int64_val(0);
+        map_op = "ParallelMapDataset";
+        num_parallel_calls =
+            graph_utils::AddScalarConstNode<int>(calls, &graph)->name();
+      }
+    } else {
+      for (int i = 1; i < batch_node.input_size(); ++i) {
+        batch_inputs.push_back(batch_node.input(i));
+      }
+      if (map_op == "ParallelMapDataset") {
+        num_parallel_calls = map_node->input(1);
+      }
+    }
+
+    auto* new_batch_node = graph.AddNode(MakeBatchNode(
+        map_node->input(0), batch_op, batch_inputs, element_types,
+        element_shapes, batch_node.attr().at("output_shapes"), &graph));
+    auto* new_map_node =
+        graph.AddNode(MakeMapNode(*map_node, *new_batch_node, map_op,
+                                  num_parallel_calls, batch_node, &graph));
+    graph.ReplaceInput(batch_node, *new_map_node);
+
+    // Mark the `Map` and `Batch` nodes for removal.
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+  }
+
+  graph.DeleteNodes(nodes_to_delete);
+  return Status::OK();
+}
+
+void MapVectorization::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                const GraphDef& optimize_output,
+                                double result) {
+  // no-op
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // end namespace grappler
+}  // end namespace tensorflow
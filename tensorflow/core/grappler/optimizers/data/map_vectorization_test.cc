@@ -0,0 +1,165 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+using ShapeList = gtl::ArraySlice<PartialTensorShape>;
+using TypeList = gtl::ArraySlice<DataType>;
+
+NodeDef MakeRangeNode() {
+  return NDef("range", "RangeDataset", {"start", "stop", "step"},
+              {{"output_shapes", ShapeList({PartialTensorShape({})})},
+               {"output_types", TypeList({DT_INT64})}});
+}
+
+NodeDef MakeMapNode(StringPiece function) {
+  return NDef("map", "MapDataset", {"range"},
+              {{"f", FunctionDefHelper::FunctionRef(function.ToString(),
+                                                    {{"T", DT_INT64}})},
+               {"Targuments", TypeList({})},
+               {"output_shapes", ShapeList({PartialTensorShape({})})},
+               {"output_types", TypeList({DT_INT64})}});
+}
+
+NodeDef MakeBatchNode() {
+  return NDef("batch", "BatchDataset", {"map", "batch_size"},
+              {{"output_shapes", ShapeList({PartialTensorShape({-1})})},
+               {"output_types", TypeList({DT_INT64})}});
+}
+
+TEST(MapVectorizationTest, BatchBeforeElementWiseMap) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("batch_size", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+       MakeRangeNode(), MakeMapNode("XTimesTwo"), MakeBatchNode(),
+       NDef("sink", "Identity", {"batch"}, {})},
+      // FunctionLib
+      {
+          test::function::XTimesTwo(),
+      });
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+
+  const NodeDef& new_batch_node =
+      output.node(graph_utils::FindNodeWithOp("BatchDataset", output));
+  EXPECT_EQ(new_batch_node.input_size(), 2);
+  EXPECT_EQ(new_batch_node.input(0), "range");
+  EXPECT_EQ(new_batch_node.input(1), "batch_size");
+  EXPECT_EQ(PartialTensorShape(
+                new_batch_node.attr().at("output_shapes").list().shape(0))
+                .DebugString(),
+            "[?]");
+
+  const NodeDef& new_map_node =
+      output.node(graph_utils::FindNodeWithOp("MapDataset", output));
+  EXPECT_EQ(new_map_node.input_size(), 1);
+  EXPECT_EQ(new_map_node.input(0), new_batch_node.name());
+  EXPECT_EQ(new_map_node.attr().at("f").func().name(), "XTimesTwo");
+  const NodeDef& sink_node =
+      output.node(graph_utils::FindGraphNodeWithName("sink", output));
+  EXPECT_EQ(sink_node.input(0), new_map_node.name());
+}
+
+TEST(MapVectorizationTest, MapAndBatchToBatchAndParallelMap) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("batch_size", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+       NDef("num_parallel_calls", "Const", {},
+            {{"value", test::AsScalar<int64>(2)}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", true}, {"dtype", DT_BOOL}}),
+       MakeRangeNode(),
+       NDef("map_and_batch", "MapAndBatchDatasetV2",
+            {"range", "batch_size", "num_parallel_calls", "drop_remainder"},
+            {{"f", FunctionDefHelper::FunctionRef("XTimesTwo",
+                                                  {{"T", DT_INT64}})},
+             {"Targuments", TypeList({})},
+             {"output_shapes", ShapeList({PartialTensorShape({5})})},
+             {"output_types", TypeList({DT_INT64})}})},
+      // FunctionLib
+      {
+          test::function::XTimesTwo(),
+      });
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsNodeWithOp("MapAndBatchDatasetV2", output));
+
+  const NodeDef& new_batch_node =
+      output.node(graph_utils::FindNodeWithOp("BatchDatasetV2", output));
+  EXPECT_EQ(new_batch_node.input(0), "range");
+  EXPECT_EQ(new_batch_node.input(1), "batch_size");
+  EXPECT_EQ(new_batch_node.input(2), "drop_remainder");
+  EXPECT_EQ(PartialTensorShape(
+                new_batch_node.attr().at("output_shapes").list().shape(0))
+                .DebugString(),
+            "[5]");
+
+  const NodeDef& new_map_node =
+      output.node(graph_utils::FindNodeWithOp("ParallelMapDataset", output));
+  EXPECT_EQ(new_map_node.input(0), new_batch_node.name());
+  const NodeDef& num_parallel_calls_node = output.node(
+      graph_utils::FindGraphNodeWithName(new_map_node.input(1), output));
+  EXPECT_EQ(num_parallel_calls_node.attr().at("value").tensor().int_val(0), 2);
+}
+
+TEST(MapVectorizationTest, KeepMapOfFunctionCall) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("batch_size", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+       MakeRangeNode(), MakeMapNode("XTimesFour"), MakeBatchNode()},
+      // FunctionLib
+      {
+          test::function::XTimesTwo(),
+          test::function::XTimesFour(),
+      });
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -53,6 +53,8 @@ class LoopInvariantNodeMotionOptimizer {
   Status Optimize();
 
  private:
+  void FindWrittenVariables(const int frame_id);
+  bool CanMoveOutOfLoop(const NodeDef& node) const;
   Status FindInvariantNodes(NodeDef* node);
   Status RevertInvariantNodes();
   Status MoveInvariantNodes(const int frame_id);
@@ -70,9 +72,76 @@ class LoopInvariantNodeMotionOptimizer {
   std::map<int, int> frame_parent_;
   std::map<int, const NodeDef*> loop_cond_;
   std::map<int, std::vector<NodeDef*>> invariant_enters_;
+  // The variables entering the current frame that are updated in it.
+  std::unordered_set<string> written_variables_;
   int new_enter_id_;
 };
 
+// Returns true if `enter` brings a variable (a ref or a resource) in its
+// frame.
+bool IsVariableEnter(const NodeDef& enter) {
+  if (enter.op() == "RefEnter") {
+    return true;
+  }
+  return enter.attr().count("T") && enter.attr().at("T").type() == DT_RESOURCE;
+}
+
+// Returns true if `consumer` of the variable brought in by `enter` only reads
+// its value.
+bool IsVariableRead(const NodeDef& enter, const NodeDef& consumer) {
+  if (enter.op() == "RefEnter") {
+    // Ops with no ref input dereference the variable. Control flow ops would
+    // forward it to nodes we don't look at.
+    return IsFreeOfSideEffect(consumer) && !ModifiesFrameInfo(consumer) &&
+           !IsSwitch(consumer) && !IsMerge(consumer);
+  }
+  return consumer.op() == "ReadVariableOp";
+}
+
+void LoopInvariantNodeMotionOptimizer::FindWrittenVariables(
+    const int frame_id) {
+  written_variables_.clear();
+  for (const NodeDef* enter : invariant_enters_[frame_id]) {
+    if (!IsVariableEnter(*enter)) {
+      continue;
+    }
+    for (const NodeDef* consumer : node_map_->GetOutputs(enter->name())) {
+      bool regular_input = false;
+      for (const string& input : consumer->input()) {
+        if (!IsControlInput(input) && NodeName(input) == enter->name()) {
+          regular_input = true;
+          break;
+        }
+      }
+      if (regular_input && !IsVariableRead(*enter, *consumer)) {
+        written_variables_.insert(NodeName(enter->input(0)));
+        break;
+      }
+    }
+  }
+}
+
+bool LoopInvariantNodeMotionOptimizer::CanMoveOutOfLoop(
+    const NodeDef& node) const {
+  // Moving stateful nodes out of the loop would change how many times they
+  // run, except for reads of variables that the loop doesn't update.
+  if (!IsFreeOfSideEffect(node) && node.op() != "ReadVariableOp") {
+    return false;
+  }
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      continue;
+    }
+    const NodeDef* producer = node_map_->GetNode(input);
+    if (producer != nullptr && IsEnter(*producer) &&
+        IsVariableEnter(*producer) &&
+        written_variables_.count(NodeName(producer->input(0)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status LoopInvariantNodeMotionOptimizer::HandleInvariantEnter(
     NodeDef* node, const int num_outputs) {
   auto consumers = node_map_->GetOutputs(node->name());
@@ -331,7 +400,8 @@ Status LoopInvariantNodeMotionOptimizer::FindInvariantNodes(
     auto consumers = node_map_->GetOutputs(node->name());
     invariant_nodes_.emplace(node, consumers.size());
     for (auto* consumer : consumers) {
-      if (invariant_nodes_.count(consumer) || ModifiesFrameInfo(*consumer)) {
+      if (invariant_nodes_.count(consumer) || ModifiesFrameInfo(*consumer) ||
+          !CanMoveOutOfLoop(*consumer)) {
         continue;
       }
       bool is_invariant = true;
@@ -430,6 +500,7 @@ Status LoopInvariantNodeMotionOptimizer::Optimize() {
       continue;
     }
     invariant_nodes_.clear();
+    FindWrittenVariables(frame_id);
     for (auto* enter : invariant_enters_[frame_id]) {
       TF_RETURN_IF_ERROR(FindInvariantNodes(enter));
     }
@@ -640,11 +711,402 @@ Status RemoveDeadBranches(const std::unordered_set<string>& nodes_to_preserve,
   return Status::OK();
 }
 
+// The largest trip count of the loops that are unrolled, and the largest
+// number of nodes that unrolling a loop may add to the graph.
+constexpr int kMaxUnrolledTripCount = 16;
+constexpr int kMaxUnrolledNodes = 2048;
+
+// Fully unrolls the innermost while loops whose trip count is known
+// statically, i.e. that run while a loop variable that starts at a constant
+// and is incremented by a constant is less than a constant.
+class LoopUnroller {
+ public:
+  LoopUnroller(std::unordered_set<string> nodes_to_preserve,
+               GraphDef* optimized_graph)
+      : nodes_to_preserve_(std::move(nodes_to_preserve)),
+        optimized_graph_(optimized_graph),
+        node_map_(optimized_graph) {}
+
+  Status Optimize();
+
+ private:
+  // A loop variable: it enters the loop through `enter`, and the value of the
+  // next iteration is the input of `next_iteration`.
+  struct LoopVar {
+    NodeDef* enter;
+    NodeDef* merge;
+    NodeDef* switch_node;
+    NodeDef* next_iteration;
+  };
+
+  struct Loop {
+    std::vector<LoopVar> vars;
+    std::vector<NodeDef*> enters;
+    std::vector<NodeDef*> exits;
+    NodeDef* loop_cond = nullptr;
+    // The nodes computing the loop condition, and the loop body.
+    std::unordered_set<const NodeDef*> cond;
+    std::vector<NodeDef*> body;
+  };
+
+  bool AnalyzeLoop(const std::vector<NodeDef*>& frame_nodes, Loop* loop) const;
+  bool GetScalarConstant(const string& input, int64* value) const;
+  bool IsLoopVarValue(const Loop& loop, int var, const string& input) const;
+  bool GetTripCount(const Loop& loop, int64* trip_count) const;
+  void Unroll(const Loop& loop, int64 trip_count);
+
+  const std::unordered_set<string> nodes_to_preserve_;
+  GraphDef* optimized_graph_;  // Not owned.
+  NodeMap node_map_;
+  std::set<string> nodes_to_delete_;
+};
+
+bool LoopUnroller::AnalyzeLoop(const std::vector<NodeDef*>& frame_nodes,
+                               Loop* loop) const {
+  std::unordered_set<const NodeDef*> in_frame(frame_nodes.begin(),
+                                              frame_nodes.end());
+  std::vector<NodeDef*> merges;
+  std::vector<NodeDef*> others;
+  size_t num_switches = 0;
+  size_t num_next_iterations = 0;
+  for (NodeDef* node : frame_nodes) {
+    if (IsEnter(*node)) {
+      loop->enters.push_back(node);
+      continue;
+    }
+    if (IsExit(*node)) {
+      loop->exits.push_back(node);
+      continue;
+    }
+    // The Enter and Exit nodes keep their names, the other ones are removed.
+    if (nodes_to_preserve_.count(node->name())) {
+      return false;
+    }
+    if (IsMerge(*node)) {
+      merges.push_back(node);
+    } else if (IsSwitch(*node)) {
+      ++num_switches;
+    } else if (IsNextIteration(*node)) {
+      ++num_next_iterations;
+    } else if (node->op() == "LoopCond") {
+      if (loop->loop_cond != nullptr) {
+        return false;
+      }
+      loop->loop_cond = node;
+    } else {
+      others.push_back(node);
+    }
+  }
+  if (loop->loop_cond == nullptr || loop->loop_cond->input_size() != 1 ||
+      merges.size() != num_switches || merges.size() != num_next_iterations) {
+    return false;
+  }
+
+  std::unordered_map<const NodeDef*, int> switch_vars;
+  std::unordered_set<const NodeDef*> var_enters;
+  for (NodeDef* merge : merges) {
+    LoopVar var;
+    if (merge->input_size() != 2) {
+      return false;
+    }
+    var.enter = node_map_.GetNode(merge->input(0));
+    var.next_iteration = node_map_.GetNode(merge->input(1));
+    if (var.enter == nullptr || !IsEnter(*var.enter) ||
+        var.enter->attr().at("is_constant").b() ||
+        node_map_.GetOutputs(var.enter->name()).size() != 1 ||
+        var.next_iteration == nullptr ||
+        !IsNextIteration(*var.next_iteration) ||
+        var.next_iteration->input_size() != 1) {
+      return false;
+    }
+    var.switch_node = nullptr;
+    for (NodeDef* output : node_map_.GetOutputs(merge->name())) {
+      if (!IsSwitch(*output)) {
+        continue;
+      }
+      if (var.switch_node != nullptr || output->input_size() != 2 ||
+          output->input(0) != merge->name() ||
+          output->input(1) != loop->loop_cond->name()) {
+        return false;
+      }
+      var.switch_node = output;
+    }
+    if (var.switch_node == nullptr) {
+      return false;
+    }
+    switch_vars[var.switch_node] = loop->vars.size();
+    var_enters.insert(var.enter);
+    loop->vars.push_back(var);
+  }
+  for (const NodeDef* enter : loop->enters) {
+    if (!enter->attr().at("is_constant").b() && !var_enters.count(enter)) {
+      return false;
+    }
+  }
+  for (const NodeDef* exit : loop->exits) {
+    int port;
+    const NodeDef* input =
+        node_map_.GetNode(ParseNodeName(exit->input(0), &port));
+    if (exit->input_size() != 1 || port != 0 || !switch_vars.count(input)) {
+      return false;
+    }
+  }
+
+  // The condition is computed from the values of the loop variables, before
+  // they go through the Switch nodes.
+  std::vector<const NodeDef*> queue(merges.begin(), merges.end());
+  while (!queue.empty()) {
+    const NodeDef* node = queue.back();
+    queue.pop_back();
+    for (const NodeDef* output : node_map_.GetOutputs(node->name())) {
+      if (output == loop->loop_cond || IsSwitch(*output)) {
+        continue;
+      }
+      if (!in_frame.count(output) || IsMerge(*output) || IsEnter(*output) ||
+          IsExit(*output) || IsNextIteration(*output)) {
+        return false;
+      }
+      if (loop->cond.insert(output).second) {
+        queue.push_back(output);
+      }
+    }
+  }
+  for (NodeDef* node : others) {
+    if (!loop->cond.count(node)) {
+      loop->body.push_back(node);
+    }
+  }
+  std::unordered_set<const NodeDef*> body(loop->body.begin(),
+                                          loop->body.end());
+
+  // The body only depends on the loop variables through the Switch nodes.
+  auto valid_body_input = [&](const string& input) {
+    int port;
+    const NodeDef* producer =
+        node_map_.GetNode(ParseNodeName(input, &port));
+    if (producer == nullptr) {
+      return false;
+    }
+    if (!in_frame.count(producer) || body.count(producer)) {
+      return true;
+    }
+    if (IsEnter(*producer)) {
+      return producer->attr().at("is_constant").b();
+    }
+    return switch_vars.count(producer) && port != 0;
+  };
+  for (const NodeDef* node : loop->body) {
+    for (const string& input : node->input()) {
+      if (!valid_body_input(input)) {
+        return false;
+      }
+    }
+  }
+  for (const LoopVar& var : loop->vars) {
+    if (!valid_body_input(var.next_iteration->input(0))) {
+      return false;
+    }
+  }
+  return node_map_.GetNode(loop->loop_cond->input(0)) != nullptr &&
+         loop->cond.count(node_map_.GetNode(loop->loop_cond->input(0)));
+}
+
+bool LoopUnroller::GetScalarConstant(const string& input, int64* value) const {
+  const NodeDef* node = node_map_.GetNode(input);
+  while (node != nullptr && (IsEnter(*node) || IsIdentity(*node)) &&
+         node->input_size() > 0 && !IsControlInput(node->input(0))) {
+    node = node_map_.GetNode(node->input(0));
+  }
+  if (node == nullptr || !IsConstant(*node) || !node->attr().count("value")) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(node->attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+  } else if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  // Keeps the trip count computation far from overflows.
+  return *value <= std::numeric_limits<int32>::max() &&
+         *value >= -std::numeric_limits<int32>::max();
+}
+
+bool LoopUnroller::IsLoopVarValue(const Loop& loop, int var,
+                                  const string& input) const {
+  int port;
+  const NodeDef* node = node_map_.GetNode(ParseNodeName(input, &port));
+  if (node == loop.vars[var].switch_node) {
+    return port == 1;
+  }
+  return node != nullptr && IsIdentity(*node) && port == 0 &&
+         IsLoopVarValue(loop, var, node->input(0));
+}
+
+bool LoopUnroller::GetTripCount(const Loop& loop, int64* trip_count) const {
+  const NodeDef* pred = node_map_.GetNode(loop.loop_cond->input(0));
+  if (!(IsLess(*pred) || IsLessEqual(*pred)) || pred->input_size() < 2) {
+    return false;
+  }
+  int64 limit;
+  if (!GetScalarConstant(pred->input(1), &limit)) {
+    return false;
+  }
+  for (int i = 0; i < static_cast<int>(loop.vars.size()); ++i) {
+    const LoopVar& var = loop.vars[i];
+    if (pred->input(0) != var.merge->name()) {
+      continue;
+    }
+    int64 start;
+    if (!GetScalarConstant(var.enter->input(0), &start)) {
+      return false;
+    }
+    const NodeDef* update = node_map_.GetNode(var.next_iteration->input(0));
+    if (update == nullptr || !IsAdd(*update) || update->input_size() < 2) {
+      return false;
+    }
+    int64 step;
+    if (!((IsLoopVarValue(loop, i, update->input(0)) &&
+           GetScalarConstant(update->input(1), &step)) ||
+          (IsLoopVarValue(loop, i, update->input(1)) &&
+           GetScalarConstant(update->input(0), &step))) ||
+        step <= 0) {
+      return false;
+    }
+    if (IsLessEqual(*pred)) {
+      ++limit;
+    }
+    *trip_count = limit > start ? (limit - start + step - 1) / step : 0;
+    return true;
+  }
+  return false;
+}
+
+void LoopUnroller::Unroll(const Loop& loop, int64 trip_count) {
+  std::unordered_map<const NodeDef*, int> switch_vars;
+  for (int i = 0; i < static_cast<int>(loop.vars.size()); ++i) {
+    switch_vars[loop.vars[i].switch_node] = i;
+  }
+  std::unordered_set<const NodeDef*> body(loop.body.begin(), loop.body.end());
+
+  // The Enter nodes become Identity nodes, which feed the first iteration.
+  std::vector<string> values;
+  for (const LoopVar& var : loop.vars) {
+    values.push_back(var.enter->name());
+  }
+  for (int64 iteration = 0; iteration < trip_count; ++iteration) {
+    auto unrolled_name = [iteration](const string& name) {
+      return AddPrefixToNodeName(StrCat(name, "/unrolled_", iteration),
+                                 kLoopOptimizer);
+    };
+    auto unrolled_input = [&](const string& input) {
+      int port;
+      const string name = ParseNodeName(input, &port);
+      const NodeDef* producer = node_map_.GetNode(name);
+      auto it = switch_vars.find(producer);
+      if (it != switch_vars.end()) {
+        const string& value = values[it->second];
+        return port < 0 ? AsControlDependency(NodeName(value)) : value;
+      }
+      if (!body.count(producer)) {
+        return input;
+      }
+      if (port < 0) {
+        return AsControlDependency(unrolled_name(name));
+      }
+      return port == 0 ? unrolled_name(name)
+                       : StrCat(unrolled_name(name), ":", port);
+    };
+    for (const NodeDef* node : loop.body) {
+      NodeDef* unrolled = optimized_graph_->add_node();
+      *unrolled = *node;
+      unrolled->set_name(unrolled_name(node->name()));
+      for (int i = 0; i < unrolled->input_size(); ++i) {
+        unrolled->set_input(i, unrolled_input(node->input(i)));
+      }
+    }
+    std::vector<string> next_values;
+    for (const LoopVar& var : loop.vars) {
+      next_values.push_back(unrolled_input(var.next_iteration->input(0)));
+    }
+    values.swap(next_values);
+  }
+
+  for (NodeDef* enter : loop.enters) {
+    enter->set_op(enter->op() == "RefEnter" ? "RefIdentity" : "Identity");
+    enter->mutable_attr()->erase("frame_name");
+    enter->mutable_attr()->erase("is_constant");
+    enter->mutable_attr()->erase("parallel_iterations");
+  }
+  for (NodeDef* exit : loop.exits) {
+    const int var = switch_vars[node_map_.GetNode(exit->input(0))];
+    exit->set_op(exit->op() == "RefExit" ? "RefIdentity" : "Identity");
+    exit->set_input(0, values[var]);
+  }
+  for (const LoopVar& var : loop.vars) {
+    nodes_to_delete_.insert(var.merge->name());
+    nodes_to_delete_.insert(var.switch_node->name());
+    nodes_to_delete_.insert(var.next_iteration->name());
+  }
+  nodes_to_delete_.insert(loop.loop_cond->name());
+  for (const NodeDef* node : loop.cond) {
+    nodes_to_delete_.insert(node->name());
+  }
+  for (const NodeDef* node : loop.body) {
+    nodes_to_delete_.insert(node->name());
+  }
+}
+
+Status LoopUnroller::Optimize() {
+  FrameMap frame_map;
+  int num_frames;
+  TF_RETURN_IF_ERROR(IdentifyFramesWithNodeMap(*optimized_graph_, node_map_,
+                                               &frame_map, &num_frames));
+  std::map<int, std::vector<NodeDef*>> frame_nodes;
+  std::set<int> outer_frames;
+  for (const auto& it : frame_map) {
+    const std::vector<int>& frame_ids = it.second;
+    if (frame_ids.empty()) {
+      continue;
+    }
+    frame_nodes[frame_ids.back()].push_back(const_cast<NodeDef*>(it.first));
+    outer_frames.insert(frame_ids.begin(), frame_ids.end() - 1);
+  }
+
+  for (const auto& it : frame_nodes) {
+    if (outer_frames.count(it.first)) {
+      continue;
+    }
+    Loop loop;
+    int64 trip_count;
+    if (!AnalyzeLoop(it.second, &loop) || !GetTripCount(loop, &trip_count) ||
+        trip_count > kMaxUnrolledTripCount ||
+        trip_count * static_cast<int64>(loop.body.size()) >
+            kMaxUnrolledNodes) {
+      continue;
+    }
+    VLOG(1) << "Unrolling the loop of " << loop.loop_cond->name() << " "
+            << trip_count << " times";
+    Unroll(loop, trip_count);
+  }
+  EraseNodesFromGraph(nodes_to_delete_, optimized_graph_);
+  return Status::OK();
+}
+
 }  // namespace
 
 Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   *optimized_graph = item.graph;
+  if (options_.enable_loop_unrolling) {
+    LoopUnroller unroller(item.NodesToPreserve(), optimized_graph);
+    TF_RETURN_IF_ERROR(unroller.Optimize());
+  }
   // Set up helper data structures.
   if (options_.enable_loop_invariant_node_motion) {
     LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
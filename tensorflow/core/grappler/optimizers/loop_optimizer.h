@@ -35,7 +35,7 @@ class LoopOptimizer : public GraphOptimizer {
         options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {}
   explicit LoopOptimizer(RewriterConfig::Toggle opt_level)
       : opt_level_(opt_level),
-        options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {}
+        options_(LoopOptimizerOptions::Default(opt_level)) {}
 
   ~LoopOptimizer() override {}
 
@@ -55,9 +55,13 @@ class LoopOptimizer : public GraphOptimizer {
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
+    // Fully unrolls the innermost loops with a small, statically known trip
+    // count.
+    bool enable_loop_unrolling = false;
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      options.enable_loop_unrolling = opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/ops/while_loop.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -73,6 +76,38 @@ class LoopOptimizerTest : public GrapplerTest {
     DisableAllStages(optimizer);
     optimizer->options_.enable_stack_push_removal = true;
   }
+
+  void EnableOnlyLoopUnrolling(LoopOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_dead_branch_removal = false;
+    optimizer->options_.enable_loop_unrolling = true;
+  }
+
+  // Builds `for (i = 0; i < num_iterations; ++i) x = x * (x + 1)`.
+  void BuildCountedLoop(int num_iterations, GrapplerItem* item) {
+    Scope scope = Scope::NewRootScope();
+    Output i = ops::Const(scope.WithOpName("i"), 0);
+    Output x = ops::Const(scope.WithOpName("x"), 1.5f);
+    OutputList outputs;
+    TF_CHECK_OK(ops::BuildWhileLoop(
+        scope.NewSubScope("while"), {i, x},
+        [num_iterations](const Scope& s, const std::vector<Output>& inputs,
+                         Output* output) {
+          *output = ops::Less(s, inputs[0], num_iterations);
+          return s.status();
+        },
+        [](const Scope& s, const std::vector<Output>& inputs,
+           std::vector<Output>* outputs) {
+          Output x_plus_1 = ops::Add(s, inputs[1], 1.0f);
+          outputs->push_back(ops::Add(s, inputs[0], 1));
+          outputs->push_back(ops::Mul(s, inputs[1], x_plus_1));
+          return s.status();
+        },
+        "while", &outputs));
+    ops::Identity(scope.WithOpName("out"), outputs[1]);
+    item->fetch = {"out"};
+    TF_CHECK_OK(scope.ToGraphDef(&item->graph));
+  }
 };
 
 TEST_F(LoopOptimizerTest, Basic) {
@@ -216,6 +251,88 @@ TEST_F(LoopOptimizerTest, ControlOutput) {
   EXPECT_EQ(frames.at(node_map->GetNode("InvariantAdd")).back(), 0);
 }
 
+TEST_F(LoopOptimizerTest, VariableReads) {
+  GraphDef graph;
+  AddSimpleNode("In", "Identity", {}, &graph);
+  AddSimpleNode("ReadOnlyVar", "VariableV2", {}, &graph);
+  AddSimpleNode("UpdatedVar", "VariableV2", {}, &graph);
+  AddEnterNode("ReadOnlyEnter", "while/while_context", true, 1,
+               {"ReadOnlyVar"}, &graph);
+  graph.mutable_node(graph.node_size() - 1)->set_op("RefEnter");
+  AddEnterNode("UpdatedEnter", "while/while_context", true, 1, {"UpdatedVar"},
+               &graph);
+  graph.mutable_node(graph.node_size() - 1)->set_op("RefEnter");
+  AddSimpleNode("ReadOnlyRead", "Identity", {"ReadOnlyEnter"}, &graph);
+  AddSimpleNode("UpdatedRead", "Identity", {"UpdatedEnter"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"ReadOnlyRead", "Identity"}, &graph);
+  AddSimpleNode("Assign", "Assign", {"UpdatedEnter", "VariantAdd"}, &graph);
+  AddSimpleNode("VariantAdd2", "Add", {"VariantAdd", "UpdatedRead"}, &graph);
+  AddEnterNode("VariantEnter", "while/while_context", false, 1, {"In"}, &graph);
+  AddSimpleNode("Merge", "Merge", {"VariantEnter", "NextIteration"}, &graph);
+  AddSimpleNode("Less/y", "Const", {"^Identity"}, &graph);
+  AddSimpleNode("Less", "Less", {"VariantAdd2", "Less/y"}, &graph);
+  AddSimpleNode("LoopCond", "LoopCond", {"Less"}, &graph);
+  AddSimpleNode("Switch", "Switch", {"Merge", "LoopCond"}, &graph);
+  AddSimpleNode("Identity", "Identity", {"Switch:1"}, &graph);
+  AddSimpleNode("NextIteration", "NextIteration", {"VariantAdd2"}, &graph);
+  AddSimpleNode("Exit", "Exit", {"Switch"}, &graph);
+  AddSimpleNode("Out", "Identity", {"Exit"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  std::unique_ptr<NodeMap> node_map(new NodeMap(&output));
+  std::unordered_map<const NodeDef*, std::vector<int>> frames;
+  int num_frames;
+  EXPECT_TRUE(IdentifyFrames(output, &frames, &num_frames).ok());
+  EXPECT_EQ(num_frames, 1);
+  // The variable that the loop doesn't write is read once before the loop.
+  EXPECT_EQ(frames.at(node_map->GetNode("ReadOnlyRead")).size(), 0);
+  EXPECT_EQ(frames.at(node_map->GetNode("UpdatedRead")).size(), 1);
+  EXPECT_EQ(frames.at(node_map->GetNode("Assign")).size(), 1);
+}
+
+TEST_F(LoopOptimizerTest, UnrollLoop) {
+  GrapplerItem item;
+  BuildCountedLoop(3, &item);
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopUnrolling(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int num_muls = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_FALSE(ModifiesFrameInfo(node)) << node.DebugString();
+    EXPECT_FALSE(IsMerge(node) || IsSwitch(node)) << node.DebugString();
+    if (IsMul(node)) {
+      ++num_muls;
+    }
+  }
+  EXPECT_EQ(3, num_muls);
+
+  auto expected = EvaluateNodes(item.graph, item.fetch);
+  auto actual = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(1, actual.size());
+  test::ExpectTensorNear<float>(expected[0], actual[0], 1e-5);
+}
+
+TEST_F(LoopOptimizerTest, DontUnrollLongLoop) {
+  GrapplerItem item;
+  BuildCountedLoop(1000, &item);
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopUnrolling(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
 TEST_F(LoopOptimizerTest, NestedLoop1) {
   GraphDef graph;
   AddSimpleNode("In", "Identity", {}, &graph);
@@ -941,6 +941,56 @@ struct MemInfo {
   bool operator<(const MemInfo& other) const { return fitness < other.fitness; }
 };
 
+// Runs the item on a virtual cluster, and records the time at which each node
+// completes and, if `op_run_times` isn't null, the time it takes to run.
+static bool SimulateExecution(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::NanoSeconds>* op_completion_times,
+    std::unordered_map<string, Costs::NanoSeconds>* op_run_times) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  if (!vcluster.Provision().ok()) {
+    return false;
+  }
+  if (!vcluster.Initialize(item).ok()) {
+    return false;
+  }
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return false;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      Costs::NanoSeconds exec_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.all_start_micros() +
+                              node_stats.op_end_rel_micros());
+      op_completion_times->emplace(node_stats.node_name(), exec_time);
+      if (op_run_times != nullptr) {
+        Costs::NanoSeconds run_time =
+            Costs::NanoSeconds(1) +
+            Costs::MicroSeconds(node_stats.op_end_rel_micros() -
+                                node_stats.op_start_rel_micros());
+        op_run_times->emplace(node_stats.node_name(), run_time);
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the time at which the peak memory usage is reached, i.e. the time at
+// which the last tensor that is live at the peak is allocated.
+static Costs::Duration PeakTime(const GraphMemory::MemoryUsage& mem_usage) {
+  Costs::Duration peak_time = -1;
+  for (const auto& live_tensor : mem_usage.live_tensors) {
+    if (live_tensor.allocation_time > peak_time) {
+      peak_time = live_tensor.allocation_time;
+    }
+  }
+  return peak_time;
+}
+
 static bool IdentifySwappingCandidates(
     Cluster* cluster, GrapplerItem* item, std::unordered_set<string>* skip_list,
     std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap) {
@@ -972,37 +1022,11 @@ static bool IdentifySwappingCandidates(
     int64 required_savings = mem_usage.used_memory - prop.memory_size();
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    if (!SimulateExecution(cluster, *item, &op_completion_times, nullptr)) {
+      return false;
     }
 
-    Costs::Duration peak_time = -1;
-    for (const auto& live_tensor : mem_usage.live_tensors) {
-      if (live_tensor.allocation_time > peak_time) {
-        peak_time = live_tensor.allocation_time;
-      }
-    }
+    const Costs::Duration peak_time = PeakTime(mem_usage);
 
     std::vector<MemInfo> mem_state;
 
@@ -1103,15 +1127,302 @@ static bool IdentifySwappingCandidates(
   return updated_graph;
 }
 
+// The bandwidth in bytes per nanosecond at which tensors are assumed to be
+// swapped, i.e. 16 GBps over PCIe.
+constexpr int64 kSwapBandwidth = 16;
+
+// A way to free the memory used by a tensor that is live at the peak: either by
+// swapping it to the host, or by recomputing it right before its remaining
+// uses.
+struct MemDecision {
+  bool recompute;
+  string node;
+  int64 memory_used;
+  // The inputs that use the tensor after the peak, as (node, port) pairs.
+  std::vector<std::pair<string, int>> uses_left;
+  // The time that the decision is estimated to add to the step.
+  Costs::NanoSeconds overhead;
+
+  // Cheapest per byte saved first.
+  bool operator<(const MemDecision& other) const {
+    return static_cast<double>(overhead.count()) * other.memory_used <
+           static_cast<double>(other.overhead.count()) * memory_used;
+  }
+};
+
+// Returns true if the output `port` can be recomputed right before its uses at
+// `earliest_use` from inputs that are still in memory by then.
+static bool IsRecomputable(
+    const GraphView& graph, GraphView::OutputPort port,
+    const std::vector<GraphView::InputPort>& uses,
+    Costs::Duration earliest_use, const std::unordered_set<string>& feeds,
+    const std::unordered_map<string, Costs::NanoSeconds>& op_completion_times) {
+  const NodeDef& node = *port.node;
+  // RecomputeSubgraph only reroutes inputs that refer to the first output by
+  // the name of the node.
+  if (port.port_id != 0) {
+    return false;
+  }
+  for (const GraphView::InputPort& use : uses) {
+    if (use.node->input(use.port_id) != node.name()) {
+      return false;
+    }
+  }
+  // The recomputed node must produce the same value as the original.
+  if (feeds.count(node.name()) > 0 || IsPersistent(node) ||
+      !IsFreeOfSideEffect(node) || ModifiesInputsInPlace(node) ||
+      ModifiesFrameInfo(node) || IsSwitch(node) || IsMerge(node)) {
+    return false;
+  }
+  // Recomputing the node must not extend the lifetime of its inputs, so they
+  // must be persistent or still be used at the time of the recomputation.
+  for (const GraphView::OutputPort& fanin :
+       graph.GetFanins(node, /*include_controlling_nodes=*/false)) {
+    if (IsPersistent(*fanin.node)) {
+      continue;
+    }
+    bool live = false;
+    for (const GraphView::InputPort& fanout : graph.GetFanout(fanin)) {
+      if (fanout.node == &node) {
+        continue;
+      }
+      auto it = op_completion_times.find(fanout.node->name());
+      if (it != op_completion_times.end() && it->second >= earliest_use) {
+        live = true;
+        break;
+      }
+    }
+    if (!live) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Uses the cost model to decide how to free enough memory to fit the peak
+// memory usage of each GPU in `target_peak_bytes` (or in the memory of the
+// device if 0). For each large tensor that is live at the peak and used after
+// it, estimates the time that swapping it and recomputing it would add to the
+// step, picks the cheapest of the two, and frees the tensors that are cheapest
+// per byte first. The recomputations are applied to the graph right away, and
+// the tensors to swap are added to `nodes_to_swap`. Returns true if the graph
+// was updated.
+static bool IdentifyCostModelCandidates(
+    Cluster* cluster, int64 target_peak_bytes, GrapplerItem* item,
+    std::unordered_set<string>* skip_list,
+    std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap) {
+  GraphMemory memory(*item);
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+
+  std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
+  std::unordered_map<string, Costs::NanoSeconds> op_run_times;
+  bool simulated = false;
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+
+  std::vector<MemDecision> decisions;
+  GraphView graph(&item->graph);
+  for (const auto& device : devices) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.type() != "GPU") {
+      continue;
+    }
+    const int64 target =
+        target_peak_bytes > 0 ? target_peak_bytes : prop.memory_size();
+    if (target <= 0) {
+      VLOG(1) << "Target peak memory usage unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= target) {
+      continue;
+    }
+    int64 required_savings = mem_usage.used_memory - target;
+
+    if (!simulated) {
+      if (!SimulateExecution(cluster, *item, &op_completion_times,
+                             &op_run_times)) {
+        return false;
+      }
+      simulated = true;
+    }
+    const Costs::Duration peak_time = PeakTime(mem_usage);
+
+    std::vector<MemDecision> candidates;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      if (skip_list->find(live_tensor.node) != skip_list->end()) {
+        continue;
+      }
+      GraphView::OutputPort port =
+          graph.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      if (port.node == nullptr) {
+        continue;
+      }
+      std::vector<GraphView::InputPort> uses_left;
+      Costs::Duration earliest_use(Costs::Duration::infinity());
+      bool valid = true;
+      for (GraphView::InputPort input : graph.GetFanout(port)) {
+        auto it = op_completion_times.find(input.node->name());
+        if (it == op_completion_times.end()) {
+          valid = false;
+          break;
+        }
+        if (it->second <= peak_time) {
+          continue;
+        }
+        if (skip_list->find(input.node->name()) != skip_list->end() ||
+            skip_list->find(strings::StrCat(input.node->name(), ":",
+                                            input.port_id)) !=
+                skip_list->end()) {
+          valid = false;
+          break;
+        }
+        uses_left.push_back(input);
+        earliest_use = std::min(earliest_use, it->second);
+      }
+      if (!valid || uses_left.empty()) {
+        continue;
+      }
+
+      MemDecision decision;
+      decision.node = live_tensor.node;
+      decision.memory_used = live_tensor.memory_used;
+      decision.overhead = Costs::NanoSeconds::infinity();
+
+      bool swappable = IsSwappable(graph, port);
+      for (const GraphView::InputPort& input : uses_left) {
+        swappable &= IsSwappable(input);
+      }
+      if (swappable) {
+        // The swap out has to happen between the allocation and the peak, and
+        // the swap in between the peak and the next use: whatever doesn't fit
+        // in these windows delays the step.
+        const Costs::NanoSeconds time_to_swap(live_tensor.memory_used /
+                                              kSwapBandwidth);
+        const Costs::NanoSeconds swap_out_delay(
+            time_to_swap - (peak_time - live_tensor.allocation_time));
+        const Costs::NanoSeconds swap_in_delay(
+            time_to_swap - (earliest_use - peak_time));
+        decision.overhead = std::max(Costs::NanoSeconds(0), swap_out_delay) +
+                            std::max(Costs::NanoSeconds(0), swap_in_delay);
+        decision.recompute = false;
+      }
+      auto run_time = op_run_times.find(live_tensor.node);
+      if (run_time != op_run_times.end() &&
+          run_time->second < decision.overhead &&
+          IsRecomputable(graph, port, uses_left, earliest_use, feeds,
+                         op_completion_times)) {
+        decision.overhead = run_time->second;
+        decision.recompute = true;
+      }
+      if (decision.overhead == Costs::NanoSeconds::infinity()) {
+        continue;
+      }
+      for (const GraphView::InputPort& input : uses_left) {
+        decision.uses_left.emplace_back(input.node->name(), input.port_id);
+      }
+      candidates.push_back(std::move(decision));
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    for (MemDecision& decision : candidates) {
+      if (required_savings <= 0) {
+        break;
+      }
+      VLOG(1) << "Will " << (decision.recompute ? "recompute" : "swap")
+              << " tensor " << decision.node << " of size "
+              << decision.memory_used << " at an estimated cost of "
+              << decision.overhead.count() << "ns";
+      required_savings -= decision.memory_used;
+      decisions.push_back(std::move(decision));
+    }
+  }
+  if (decisions.empty()) {
+    return false;
+  }
+
+  bool updated_graph = false;
+  bool has_recomputations = false;
+  for (const MemDecision& decision : decisions) {
+    has_recomputations |= decision.recompute;
+  }
+  if (has_recomputations) {
+    // This invalidates all NodeDef pointers, including the ones in `graph`.
+    // As in RecomputationRewritingPass, the topological numbering and the
+    // NodeMap stay valid for the nodes of the original graph.
+    if (!TopologicalSort(&item->graph).ok()) {
+      return false;
+    }
+    NodeMap node_map(&item->graph);
+    std::unordered_map<const NodeDef*, int> topological_numbering;
+    const int num_nodes = item->graph.node_size();
+    for (int i = 0; i < num_nodes; ++i) {
+      topological_numbering[item->graph.mutable_node(i)] = num_nodes - i - 1;
+    }
+    for (const MemDecision& decision : decisions) {
+      if (!decision.recompute) {
+        continue;
+      }
+      std::unordered_set<NodeDef*> target_nodes;
+      for (const auto& use : decision.uses_left) {
+        target_nodes.insert(node_map.GetNode(use.first));
+      }
+      RecomputeSubgraph({node_map.GetNode(decision.node)}, target_nodes,
+                        node_map, topological_numbering, &item->graph);
+      // Don't attempt to free the tensor again in a subsequent pass.
+      skip_list->insert(decision.node);
+      skip_list->insert(
+          AddPrefixToNodeName(decision.node, kRecomputedNodePrefix));
+      updated_graph = true;
+    }
+  }
+
+  std::unordered_map<string, NodeDef*> name_map;
+  for (NodeDef& node : *item->graph.mutable_node()) {
+    name_map[node.name()] = &node;
+  }
+  for (const MemDecision& decision : decisions) {
+    if (decision.recompute) {
+      continue;
+    }
+    for (const auto& use : decision.uses_left) {
+      auto it = name_map.find(use.first);
+      if (it != name_map.end()) {
+        (*nodes_to_swap)[it->second].inputs_to_swap.push_back(use.second);
+      }
+    }
+  }
+  return updated_graph;
+}
+
 bool SwappingPass(RewriterConfig::MemOptType optimization_level,
-                  Cluster* cluster, GrapplerItem* item,
-                  std::unordered_set<string>* skip_list) {
+                  int64 target_peak_bytes, Cluster* cluster,
+                  GrapplerItem* item, std::unordered_set<string>* skip_list) {
+  bool updated_graph = false;
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
       optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
       optimization_level == RewriterConfig::HEURISTICS) {
     // Use heuristics to figure out what needs to be swapped;
     IdentifySwappingCandidates(cluster, item, skip_list, &nodes_to_swap);
+  } else if (optimization_level == RewriterConfig::COST_MODEL_HEURISTICS) {
+    // Use the cost model to figure out what needs to be swapped, and
+    // recompute the rest.
+    updated_graph = IdentifyCostModelCandidates(
+        cluster, target_peak_bytes, item, skip_list, &nodes_to_swap);
   }
   // Look for manual annotatations in the graph.
   for (auto& node : *item->graph.mutable_node()) {
@@ -1130,13 +1441,13 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   }
   if (nodes_to_swap.empty()) {
     // Nothing to do.
-    return false;
+    return updated_graph;
   }
 
   // Estimate the size of the data to swap for each node.
   GraphProperties properties(*item);
   if (!properties.InferStatically(true).ok()) {
-    return false;
+    return updated_graph;
   }
   for (auto& swap : nodes_to_swap) {
     const NodeDef* node = swap.first;
@@ -1149,12 +1460,12 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
       bytes_to_swap += EstimateSize(t);
     }
     // Let's assume we're going to swap over PCIe running at 16 GBps.
-    swap_info.time_to_swap = bytes_to_swap / 16;
+    swap_info.time_to_swap = bytes_to_swap / kSwapBandwidth;
   }
 
   std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
   if (!EstimateEarliestExecutionTimes(*item, cluster, &execution_times).ok()) {
-    return false;
+    return updated_graph;
   }
 
   std::unordered_map<string, const NodeDef*> name_map;
@@ -1163,8 +1474,6 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   }
   GraphView view(&item->graph);
 
-  bool updated_graph = false;
-
   for (auto& swap : nodes_to_swap) {
     NodeDef* node = swap.first;
     const SwapInfo& swap_info = swap.second;
@@ -1296,6 +1605,18 @@ Status RelaxAllocatorConstraints(GraphDef* optimized_graph) {
   return Status::OK();
 }
 
+// Annotates the nodes with their rank in an order of execution that keeps the
+// memory usage low, which the executor uses to pick among the ready nodes.
+Status AnnotateExecutionPriorities(GrapplerItem* item) {
+  std::unordered_map<const NodeDef*, int> order;
+  TF_RETURN_IF_ERROR(EstimateMemoryEfficientOrder(*item, &order));
+  for (int i = 0; i < item->graph.node_size(); ++i) {
+    NodeDef* node = item->graph.mutable_node(i);
+    (*node->mutable_attr())[kExecutionPriorityAttr].set_i(order[node]);
+  }
+  return Status::OK();
+}
+
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* optimized_graph) {
   *optimized_graph = item.graph;
@@ -1321,13 +1642,21 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
          optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
          optimization_level_ == RewriterConfig::HEURISTICS ||
-         optimization_level_ == RewriterConfig::MANUAL) &&
+         optimization_level_ == RewriterConfig::MANUAL ||
+         optimization_level_ == RewriterConfig::COST_MODEL_HEURISTICS) &&
         cluster != nullptr) {
-      updated_graph |= SwappingPass(optimization_level_, cluster,
-                                    &optimized_item, &skip_list);
+      updated_graph |=
+          SwappingPass(optimization_level_, target_peak_bytes_, cluster,
+                       &optimized_item, &skip_list);
     }
   }
 
+  if (optimization_level_ == RewriterConfig::SCHEDULING_HEURISTICS ||
+      optimization_level_ == RewriterConfig::HEURISTICS) {
+    // Unlike the scheduling pass, this doesn't need a cluster.
+    TF_RETURN_IF_ERROR(AnnotateExecutionPriorities(&optimized_item));
+  }
+
   TF_RETURN_IF_ERROR(RelaxAllocatorConstraints(&optimized_item.graph));
 
   optimized_graph->Swap(&optimized_item.graph);
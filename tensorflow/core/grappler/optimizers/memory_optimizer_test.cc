@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
+#include <set>
 #include <vector>
 
 #include "tensorflow/cc/ops/standard_ops.h"
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -338,6 +340,65 @@ TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, CostModelHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Identity(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Square(s.WithOpName("b").WithDevice("/gpu:0"), v);
+  Output c = ops::Sqrt(s.WithOpName("c").WithDevice("/gpu:0"), a);
+  Output d = ops::Identity(s.WithOpName("d").WithDevice("/gpu:0"), b);
+  Output axis = ops::Const(s.WithOpName("axis"), 0);
+  Output e =
+      ops::Concat(s.WithOpName("e").WithDevice("/gpu:0"), {a, b, c, d}, axis);
+  Output f = ops::Square(s.WithOpName("f").WithDevice("/gpu:0"), a);
+  Output g = ops::Sqrt(s.WithOpName("g").WithDevice("/gpu:0"), b);
+  Output h = ops::Exp(s.WithOpName("h").WithDevice("/gpu:0"), c);
+  Output i = ops::Log(s.WithOpName("i").WithDevice("/gpu:0"), d);
+
+  Output constant = ops::Const(s.WithOpName("constant"), 0.0f, {128, 128, 8});
+  Output init = ops::Assign(s.WithOpName("init"), v, constant);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"e", "f", "g", "h", "i"};
+  item.init_ops = {init.name()};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // The peak memory usage already fits a large target.
+  MemoryOptimizer large_target(RewriterConfig::COST_MODEL_HEURISTICS,
+                               "gradients/", 1LL << 30);
+  GraphDef output;
+  TF_EXPECT_OK(large_target.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+
+  // It doesn't fit the memory of the GPU, so some of the inputs of the nodes
+  // that run after the peak are swapped in or recomputed.
+  MemoryOptimizer optimizer(RewriterConfig::COST_MODEL_HEURISTICS);
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_LT(item.graph.node_size(), output.node_size());
+  int num_rewritten_inputs = 0;
+  for (const auto& node : output.node()) {
+    for (const string& input : node.input()) {
+      if (str_util::StartsWith(input, "swap_in_") ||
+          str_util::StartsWith(input, "Recomputed/")) {
+        ++num_rewritten_inputs;
+      }
+    }
+  }
+  EXPECT_LT(0, num_rewritten_inputs);
+
+#if GOOGLE_CUDA
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized(item, std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  for (int i = 0; i < item.fetch.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+#endif
+}
+
 TEST_F(MemoryOptimizerTest, UnswappableInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
@@ -440,6 +501,31 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, ExecutionPriorities) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::RandomNormal(s.WithOpName("a"), {128, 128}, DT_FLOAT);
+  Output b = ops::Square(s.WithOpName("b"), a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"b"};
+
+  // The priorities don't require a cluster.
+  MemoryOptimizer optimizer(RewriterConfig::SCHEDULING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  std::set<int64> priorities;
+  for (const NodeDef& node : output.node()) {
+    ASSERT_EQ(1, node.attr().count("_execution_priority")) << node.name();
+    priorities.insert(node.attr().at("_execution_priority").i());
+  }
+  EXPECT_EQ(output.node_size(), priorities.size());
+
+  auto tensors = EvaluateNodes(output, item.fetch, {});
+  EXPECT_EQ(1, tensors.size());
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
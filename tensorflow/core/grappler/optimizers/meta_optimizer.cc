@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
@@ -35,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -90,6 +93,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("loop", new LoopOptimizer(cfg_.loop_optimization()));
   MK_OPT("dependency", new DependencyOptimizer(cfg_.dependency_optimization()));
   MK_OPT("debug_stripper", new DebugStripper());
+  MK_OPT("auto_mixed_precision",
+         new AutoMixedPrecision(cfg_.auto_mixed_precision()));
   MK_OPT("scoped_allocator",
          new ScopedAllocatorOptimizer(cfg_.scoped_allocator_optimization(),
                                       cfg_.scoped_allocator_opts()));
@@ -111,6 +116,10 @@ Status MetaOptimizer::InitializeOptimizers(
   if (cfg_.debug_stripper() == RewriterConfig::ON) {
     optimizers->emplace_back(new DebugStripper());
   }
+  if (cfg_.auto_mixed_precision() == RewriterConfig::ON) {
+    optimizers->emplace_back(
+        new AutoMixedPrecision(cfg_.auto_mixed_precision()));
+  }
   if (cfg_.constant_folding() != RewriterConfig::OFF) {
     optimizers->emplace_back(
         new ConstantFolding(cfg_.constant_folding(), cpu_device_));
@@ -136,15 +145,15 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->emplace_back(new LayoutOptimizer());
   }
   if (cfg_.memory_optimization() != RewriterConfig::NO_MEM_OPT) {
-    if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->emplace_back(
-          // Use the default target node name prefix "gradients/"
-          new MemoryOptimizer(cfg_.memory_optimization()));
-    } else {
-      optimizers->emplace_back(
-          new MemoryOptimizer(cfg_.memory_optimization(),
-                              cfg_.memory_optimizer_target_node_name_scope()));
-    }
+    // Use the default target node name prefix "gradients/" unless another one
+    // is set.
+    const string target_name_scope =
+        cfg_.memory_optimizer_target_node_name_scope().empty()
+            ? "gradients/"
+            : cfg_.memory_optimizer_target_node_name_scope();
+    optimizers->emplace_back(
+        new MemoryOptimizer(cfg_.memory_optimization(), target_name_scope,
+                            cfg_.memory_optimizer_target_peak_bytes()));
   }
   if (cfg_.auto_parallel().enable()) {
     optimizers->emplace_back(
@@ -280,7 +289,10 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
   }
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -324,7 +336,21 @@ Status MetaOptimizer::RunOptimizer(
 
 Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
-  optimization_results_.clear();
+  {
+    mutex_lock l(mu_);
+    optimization_results_.clear();
+  }
+
+  string cache_key;
+  if (cfg_.meta_optimizer_cache() == RewriterConfig::ON) {
+    cache_key = MetaOptimizerCache::Key(item, cluster, cfg_);
+    if (MetaOptimizerCache::Global()->Lookup(
+            cache_key, cfg_.meta_optimizer_cache_dir(), optimized_graph)) {
+      VLOG(1) << "Found the optimized graph of " << item.id
+              << " in the cache: key=" << cache_key;
+      return Status::OK();
+    }
+  }
 
   // 1. Optimize main graph
   TF_RETURN_IF_ERROR(OptimizeGraph(cluster, item, optimized_graph));
@@ -338,10 +364,11 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool optimize_function_library = true;
 
   while (optimize_function_library) {
-    optimize_function_library = false;
-
+    std::vector<const FunctionDef*> funcs;
+    std::unordered_set<string> library_funcs;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       const string& func_name = func.signature().name();
+      library_funcs.insert(func_name);
 
       // Skip already optimized functions.
       if (optimized_funcs.find(func_name) != optimized_funcs.end()) continue;
@@ -351,25 +378,72 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       if (IsParametrized(func)) continue;
 
       VLOG(3) << "Optimize function: function=" << func_name;
-
-      // Function optimization might specialize nested function calls, so we
-      // have to reset the flag and do at least one more pass over the library.
-      optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
+    // Function optimization might specialize nested function calls, so we
+    // have to do at least one more pass over the library after optimizing any
+    // function.
+    optimize_function_library = !funcs.empty();
+
+    // Optimize the function bodies. They are independent of each other, so
+    // they can be optimized in parallel.
+    const int num_funcs = funcs.size();
+    std::vector<GrapplerFunctionItem> func_items(num_funcs);
+    std::vector<GraphDef> optimized_func_graphs(num_funcs);
+    std::vector<Status> statuses(num_funcs);
+    auto optimize_func = [&](int i) {
       // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(func, flib, &func_item));
+      statuses[i] = MakeGrapplerFunctionItem(*funcs[i], flib, &func_items[i]);
+      if (statuses[i].ok()) {
+        statuses[i] =
+            OptimizeGraph(cluster, func_items[i], &optimized_func_graphs[i]);
+      }
+    };
+    const int num_threads =
+        std::min(cfg_.meta_optimizer_num_threads(), num_funcs);
+    if (num_threads > 1) {
+      thread::ThreadPool pool(Env::Default(), "optimize_function_library",
+                              num_threads);
+      for (int i = 0; i < num_funcs; ++i) {
+        pool.Schedule([&optimize_func, i]() { optimize_func(i); });
+      }
+      // The destructor of the pool waits for all the functions.
+    } else {
+      for (int i = 0; i < num_funcs; ++i) {
+        optimize_func(i);
+      }
+    }
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      TF_RETURN_IF_ERROR(
-          OptimizeGraph(cluster, func_item, &optimized_func_graph));
+    for (int i = 0; i < num_funcs; ++i) {
+      TF_RETURN_IF_ERROR(statuses[i]);
+      const string& func_name = funcs[i]->signature().name();
+
+      // Functions optimized in parallel don't see each other's specialized
+      // functions, so they might give the same name to different ones.
+      // Optimize the function again once the names are taken.
+      if (num_threads > 1) {
+        bool name_clash = false;
+        for (const FunctionDef& func_def :
+             optimized_func_graphs[i].library().function()) {
+          const string& name = func_def.signature().name();
+          if (library_funcs.count(name) == 0 && flib.Find(name) != nullptr) {
+            name_clash = true;
+            break;
+          }
+        }
+        if (name_clash) {
+          VLOG(3) << "Optimize function again: function=" << func_name;
+          optimize_func(i);
+          TF_RETURN_IF_ERROR(statuses[i]);
+        }
+      }
 
       // Function body optimization might have created new specialized
       // functions for each instantiation context. Add them to the library.
       for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
+           optimized_func_graphs[i].library().function()) {
         if (flib.Find(func_def.signature().name()) == nullptr) {
           TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
         }
@@ -377,8 +451,8 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 
       // Convert optimized graph back to FunctionDef.
       FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+      func_items[i].SwapFunctionBody(std::move(optimized_func_graphs[i]));
+      TF_RETURN_IF_ERROR(MakeFunctionDef(func_items[i], flib, &optimized_func));
 
       // Replace optimized function with a new FunctionDef.
       TF_RETURN_IF_ERROR(flib.RemoveFunction(func_name));
@@ -394,10 +468,16 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   VLOG(3) << "Optimized " << optimized_funcs.size()
           << " functions: " << str_util::Join(optimized_funcs, ", ");
 
+  if (!cache_key.empty()) {
+    MetaOptimizerCache::Global()->Insert(
+        cache_key, cfg_.meta_optimizer_cache_dir(), *optimized_graph);
+  }
+
   return Status::OK();
 }
 
 void MetaOptimizer::PrintResult() {
+  mutex_lock l(mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     LOG(INFO) << "Optimization results for grappler item: " << graph_result.id;
     for (const OptimizerResult& result : graph_result.results) {
@@ -424,6 +504,7 @@ bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
          cfg.auto_parallel().enable() ||
          cfg.memory_optimization() != RewriterConfig::NO_MEM_OPT ||
          cfg.debug_stripper() == RewriterConfig::ON ||
+         cfg.auto_mixed_precision() == RewriterConfig::ON ||
          cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          !cfg.optimizers().empty() || !cfg.custom_optimizers().empty();
 }
@@ -0,0 +1,178 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include <map>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Appends `value` to `data` prefixed by its size, so that the concatenation of
+// the values is unambiguous.
+void AppendValue(StringPiece value, string* data) {
+  strings::StrAppend(data, value.size(), ":", value);
+}
+
+void AppendProto(const protobuf::MessageLite& proto, string* data) {
+  string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  AppendValue(serialized, data);
+}
+
+void AppendNames(const std::vector<string>& names, string* data) {
+  strings::StrAppend(data, names.size(), ":");
+  for (const string& name : names) {
+    AppendValue(name, data);
+  }
+}
+
+string CacheFilename(const string& cache_dir, const string& key) {
+  return io::JoinPath(cache_dir, strings::StrCat(key, ".pb"));
+}
+
+}  // namespace
+
+MetaOptimizerCache* MetaOptimizerCache::Global() {
+  static MetaOptimizerCache* cache = new MetaOptimizerCache();
+  return cache;
+}
+
+string MetaOptimizerCache::Key(const GrapplerItem& item,
+                               const Cluster* cluster,
+                               const RewriterConfig& cfg) {
+  string data;
+  AppendProto(item.graph, &data);
+  // The values of the feeds don't matter to the optimizers, but their types
+  // and shapes do.
+  strings::StrAppend(&data, item.feed.size(), ":");
+  for (const auto& feed : item.feed) {
+    AppendValue(feed.first, &data);
+    AppendValue(DataTypeString(feed.second.dtype()), &data);
+    AppendValue(feed.second.shape().DebugString(), &data);
+  }
+  AppendNames(item.fetch, &data);
+  AppendNames(item.init_ops, &data);
+  AppendNames(item.keep_ops, &data);
+  AppendValue(item.save_op, &data);
+  AppendValue(item.restore_op, &data);
+  AppendValue(item.save_restore_loc_tensor, &data);
+  if (cluster == nullptr) {
+    AppendValue("", &data);
+  } else {
+    // Sort the devices, since the map doesn't have a deterministic order.
+    const std::map<string, DeviceProperties> devices(
+        cluster->GetDevices().begin(), cluster->GetDevices().end());
+    strings::StrAppend(&data, devices.size(), ":");
+    for (const auto& device : devices) {
+      AppendValue(device.first, &data);
+      AppendProto(device.second, &data);
+    }
+  }
+  AppendProto(cfg, &data);
+
+  const Fprint128 fingerprint = Fingerprint128(data);
+  return strings::Printf("%016llx%016llx",
+                         static_cast<unsigned long long>(fingerprint.high64),
+                         static_cast<unsigned long long>(fingerprint.low64));
+}
+
+bool MetaOptimizerCache::Lookup(const string& key, const string& cache_dir,
+                                GraphDef* optimized_graph) {
+  {
+    mutex_lock l(mu_);
+    auto it = graphs_.find(key);
+    if (it != graphs_.end()) {
+      *optimized_graph = it->second;
+      return true;
+    }
+  }
+  if (cache_dir.empty()) {
+    return false;
+  }
+  const string filename = CacheFilename(cache_dir, key);
+  Env* env = Env::Default();
+  if (!env->FileExists(filename).ok()) {
+    return false;
+  }
+  Status s = ReadBinaryProto(env, filename, optimized_graph);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to read the cached optimized graph " << filename
+                 << ": " << s;
+    return false;
+  }
+  mutex_lock l(mu_);
+  InsertInMemory(key, *optimized_graph);
+  return true;
+}
+
+void MetaOptimizerCache::Insert(const string& key, const string& cache_dir,
+                                const GraphDef& optimized_graph) {
+  {
+    mutex_lock l(mu_);
+    InsertInMemory(key, optimized_graph);
+  }
+  if (cache_dir.empty()) {
+    return;
+  }
+  // Write to a temporary file first, so that other processes never read a
+  // partial graph.
+  Env* env = Env::Default();
+  const string filename = CacheFilename(cache_dir, key);
+  const string tmp_filename =
+      strings::StrCat(filename, ".tmp", env->NowMicros());
+  Status s = env->RecursivelyCreateDir(cache_dir);
+  if (s.ok() || errors::IsAlreadyExists(s)) {
+    s = WriteBinaryProto(env, tmp_filename, optimized_graph);
+  }
+  if (s.ok()) {
+    s = env->RenameFile(tmp_filename, filename);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to cache the optimized graph in " << filename
+                 << ": " << s;
+  }
+}
+
+void MetaOptimizerCache::InsertInMemory(const string& key,
+                                        const GraphDef& optimized_graph) {
+  if (max_entries_ <= 0) {
+    return;
+  }
+  if (graphs_.find(key) != graphs_.end()) {
+    graphs_[key] = optimized_graph;
+    return;
+  }
+  while (keys_.size() >= static_cast<size_t>(max_entries_)) {
+    graphs_.erase(keys_.front());
+    keys_.pop_front();
+  }
+  graphs_.emplace(key, optimized_graph);
+  keys_.push_back(key);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
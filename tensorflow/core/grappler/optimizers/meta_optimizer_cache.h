@@ -0,0 +1,74 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+
+#include <deque>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Caches the graphs optimized by the meta-optimizer, keyed by a fingerprint of
+// everything the optimization depends on. The graphs are kept in memory, and
+// optionally in a directory, so that they outlive the process.
+class MetaOptimizerCache {
+ public:
+  // max_entries: The number of graphs kept in memory. The oldest ones are
+  //   evicted first.
+  explicit MetaOptimizerCache(int max_entries = 64)
+      : max_entries_(max_entries) {}
+
+  // The cache shared by all the meta-optimizers of the process.
+  static MetaOptimizerCache* Global();
+
+  // Returns the key of the optimization of `item` with `cfg`, on the devices
+  // of `cluster` (which may be null).
+  static string Key(const GrapplerItem& item, const Cluster* cluster,
+                    const RewriterConfig& cfg);
+
+  // Looks up `key` in memory, and then in `cache_dir` unless it is empty.
+  // Returns true and sets `optimized_graph` if it is found.
+  bool Lookup(const string& key, const string& cache_dir,
+              GraphDef* optimized_graph);
+
+  // Adds `optimized_graph` to the cache in memory, and to `cache_dir` unless it
+  // is empty. Failures to write to `cache_dir` are logged and ignored.
+  void Insert(const string& key, const string& cache_dir,
+              const GraphDef& optimized_graph);
+
+ private:
+  void InsertInMemory(const string& key, const GraphDef& optimized_graph)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int max_entries_;
+  mutex mu_;
+  std::unordered_map<string, GraphDef> graphs_ GUARDED_BY(mu_);
+  // The keys of `graphs_`, from the oldest to the newest.
+  std::deque<string> keys_ GUARDED_BY(mu_);
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
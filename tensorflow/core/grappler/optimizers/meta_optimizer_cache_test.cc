@@ -0,0 +1,93 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+GrapplerItem MakeItem() {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  CHECK(fake_input.NextItem(&item));
+  return item;
+}
+
+TEST(MetaOptimizerCacheTest, KeyDependsOnItemDevicesAndConfig) {
+  GrapplerItem item = MakeItem();
+  RewriterConfig cfg;
+  const string key = MetaOptimizerCache::Key(item, nullptr, cfg);
+  EXPECT_EQ(key, MetaOptimizerCache::Key(MakeItem(), nullptr, cfg));
+
+  GrapplerItem other_item = MakeItem();
+  other_item.fetch.push_back(other_item.graph.node(0).name());
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_item, nullptr, cfg));
+
+  std::unordered_map<string, DeviceProperties> devices;
+  devices["/job:localhost/replica:0/task:0/cpu:0"].set_type("CPU");
+  VirtualCluster cluster(devices);
+  EXPECT_NE(key, MetaOptimizerCache::Key(item, &cluster, cfg));
+
+  RewriterConfig other_cfg;
+  other_cfg.set_constant_folding(RewriterConfig::OFF);
+  EXPECT_NE(key, MetaOptimizerCache::Key(item, nullptr, other_cfg));
+}
+
+TEST(MetaOptimizerCacheTest, EvictsOldestGraphs) {
+  MetaOptimizerCache cache(/*max_entries=*/2);
+  GraphDef graph;
+  graph.add_node()->set_name("a");
+  cache.Insert("1", "", graph);
+  cache.Insert("2", "", graph);
+  cache.Insert("3", "", graph);
+
+  GraphDef cached;
+  EXPECT_FALSE(cache.Lookup("1", "", &cached));
+  EXPECT_TRUE(cache.Lookup("2", "", &cached));
+  EXPECT_TRUE(cache.Lookup("3", "", &cached));
+  EXPECT_EQ("a", cached.node(0).name());
+}
+
+TEST(MetaOptimizerCacheTest, KeepsGraphsInDirectory) {
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_cache_test");
+  GraphDef graph;
+  graph.add_node()->set_name("a");
+  MetaOptimizerCache(/*max_entries=*/1).Insert("key", cache_dir, graph);
+
+  // Another cache, e.g. of another process, reads it from the directory.
+  MetaOptimizerCache cache(/*max_entries=*/1);
+  GraphDef cached;
+  EXPECT_FALSE(cache.Lookup("other_key", cache_dir, &cached));
+  ASSERT_TRUE(cache.Lookup("key", cache_dir, &cached));
+  EXPECT_EQ("a", cached.node(0).name());
+  // Now it is in memory as well.
+  TF_ASSERT_OK(Env::Default()->DeleteFile(io::JoinPath(cache_dir, "key.pb")));
+  EXPECT_TRUE(cache.Lookup("key", cache_dir, &cached));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -83,6 +83,37 @@ TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, CachesOptimizedGraphs) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  CHECK(fake_input.NextItem(&item));
+
+  RewriterConfig rewriter_config;
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_cache(RewriterConfig::ON);
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  TF_EXPECT_OK(
+      MetaOptimizer(nullptr, rewriter_config).Optimize(nullptr, item, &output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // The same item is found in the cache.
+  TestOptimizer::SetOptimized(false);
+  GraphDef cached_output;
+  TF_EXPECT_OK(MetaOptimizer(nullptr, rewriter_config)
+                   .Optimize(nullptr, item, &cached_output));
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(output, cached_output);
+
+  // Another item isn't.
+  item.fetch.push_back(item.graph.node(0).name());
+  TF_EXPECT_OK(MetaOptimizer(nullptr, rewriter_config)
+                   .Optimize(nullptr, item, &cached_output));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+}
+
 TEST_F(MetaOptimizerTest, RunOptimizersTwice) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
   GrapplerItem item;
@@ -247,6 +278,22 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
     EXPECT_EQ(5, count);
   }
 
+  // Optimizing the functions in parallel gives the same result.
+  rewriter_config.set_meta_optimizer_num_threads(4);
+  MetaOptimizer parallel_optimizer(nullptr, rewriter_config);
+  GraphDef parallel_output;
+  TF_EXPECT_OK(parallel_optimizer.Optimize(nullptr, item, &parallel_output));
+  CompareGraphs(output, parallel_output);
+  FunctionLibraryDefinition parallel_flib(OpRegistry::Global(),
+                                          parallel_output.library());
+  EXPECT_EQ(optimized_flib.num_functions(), parallel_flib.num_functions());
+  for (const FunctionDef& func : output.library().function()) {
+    const FunctionDef* parallel_func =
+        parallel_flib.Find(func.signature().name());
+    ASSERT_NE(parallel_func, nullptr);
+    EXPECT_EQ(func.node_def_size(), parallel_func->node_def_size());
+  }
+
   item.fetch = {"out_s", "out_q"};
   item.feed.emplace_back("a", test::AsScalar<float>(2.0f));
   item.feed.emplace_back("b", test::AsScalar<int>(4));
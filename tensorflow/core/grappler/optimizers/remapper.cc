@@ -15,18 +15,611 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
 
+namespace {
+
+struct ElementwiseOp {
+  // Whether the op takes a second operand.
+  bool binary;
+  // Whether the operands of a binary op commute.
+  bool commutative;
+};
+
+// WARN: This should be consistent with fused_elementwise_op.cc.
+const std::unordered_map<string, ElementwiseOp>& FusableElementwiseOps() {
+  // clang-format off
+  static const auto* ops = new std::unordered_map<string, ElementwiseOp>({
+      {"Abs",     {false, false}},
+      {"Exp",     {false, false}},
+      {"Log",     {false, false}},
+      {"Neg",     {false, false}},
+      {"Relu",    {false, false}},
+      {"Relu6",   {false, false}},
+      {"Rsqrt",   {false, false}},
+      {"Sigmoid", {false, false}},
+      {"Sqrt",    {false, false}},
+      {"Square",  {false, false}},
+      {"Tanh",    {false, false}},
+      {"Add",     {true,  true}},
+      {"BiasAdd", {true,  false}},
+      {"Maximum", {true,  true}},
+      {"Minimum", {true,  true}},
+      {"Mul",     {true,  true}},
+      {"RealDiv", {true,  false}},
+      {"Sub",     {true,  false}}});
+  // clang-format on
+  return *ops;
+}
+
+// _FusedElementwise is defined only for CPU.
+bool NodeIsOnCpu(const NodeDef& node) {
+  string task;
+  string device;
+  return DeviceNameUtils::SplitDeviceName(node.device(), &task, &device) &&
+         str_util::StartsWith(device, DEVICE_CPU);
+}
+
+// A chain of elementwise ops, each applied to the result of the one before,
+// that _FusedElementwise computes in a single pass over memory.
+struct ElementwiseChain {
+  // The nodes of the chain, starting with the last one.
+  std::vector<const NodeDef*> nodes;
+  // The index of the input of each node that is the result of the chain.
+  std::vector<int> chain_inputs;
+};
+
+// Finds the chains of elementwise ops worth fusing: those of at least two
+// ops, one of them binary. Chains of unary ops are left to the
+// UnaryOpsComposition stage of the arithmetic optimizer, which supports more
+// ops.
+class ElementwiseChainFinder {
+ public:
+  // The nodes in `excluded_nodes` are fused by other rewrites.
+  ElementwiseChainFinder(const GrapplerItem& item,
+                         const GraphProperties& properties,
+                         const GraphView& graph,
+                         const std::unordered_set<string>& excluded_nodes)
+      : item_(item),
+        properties_(properties),
+        graph_(graph),
+        excluded_nodes_(excluded_nodes),
+        nodes_to_preserve_(item.NodesToPreserve()) {}
+
+  // Returns the chains by the name of their last node, which the fused node
+  // replaces, and the names of their other nodes.
+  void FindChains(std::unordered_map<string, ElementwiseChain>* chains,
+                  std::unordered_set<string>* fused_nodes) {
+    // The chained input of every node that can be fused, and the consumer
+    // that each node fuses into, if any.
+    std::unordered_map<const NodeDef*, int> chain_inputs;
+    std::unordered_map<const NodeDef*, const NodeDef*> fused_into;
+    for (const NodeDef& node : item_.graph.node()) {
+      const std::vector<int> candidates = ChainInputCandidates(node);
+      if (candidates.empty()) continue;
+      int chain_input = candidates[0];
+      for (int candidate : candidates) {
+        const NodeDef* input = graph_.GetNode(NodeName(node.input(candidate)));
+        if (input != nullptr && CanFuseInto(*input, node, candidate)) {
+          chain_input = candidate;
+          fused_into[input] = &node;
+          break;
+        }
+      }
+      chain_inputs[&node] = chain_input;
+    }
+
+    for (const auto& node_and_input : chain_inputs) {
+      const NodeDef* node = node_and_input.first;
+      if (fused_into.count(node) > 0) continue;
+      ElementwiseChain chain;
+      bool has_binary_op = false;
+      while (true) {
+        chain.nodes.push_back(node);
+        chain.chain_inputs.push_back(chain_inputs[node]);
+        has_binary_op |= FusableElementwiseOps().at(node->op()).binary;
+        const NodeDef* input =
+            graph_.GetNode(NodeName(node->input(chain.chain_inputs.back())));
+        auto it = fused_into.find(input);
+        if (it == fused_into.end() || it->second != node) break;
+        node = input;
+      }
+      if (chain.nodes.size() < 2 || !has_binary_op) continue;
+      for (size_t i = 1; i < chain.nodes.size(); ++i) {
+        fused_nodes->insert(chain.nodes[i]->name());
+      }
+      (*chains)[chain.nodes[0]->name()] = std::move(chain);
+    }
+  }
+
+ private:
+  // Returns the inputs of `node` that can be the result of a chain that it
+  // continues, or nothing if `node` can not be fused.
+  std::vector<int> ChainInputCandidates(const NodeDef& node) const {
+    auto it = FusableElementwiseOps().find(node.op());
+    if (it == FusableElementwiseOps().end()) return {};
+    if (excluded_nodes_.count(node.name()) > 0) return {};
+    const DataType dtype = GetDataTypeFromAttr(node, "T");
+    if (dtype != DT_FLOAT && dtype != DT_DOUBLE) return {};
+    if (!NodeIsOnCpu(node)) return {};
+    const ElementwiseOp& op = it->second;
+    if (!op.binary) return {0};
+    if (IsBiasAdd(node) && node.attr().count("data_format") > 0 &&
+        node.attr().at("data_format").s() != "NHWC") {
+      return {};
+    }
+
+    // The chained operand must have the shape of the output, and the other
+    // one must broadcast to it in a way that _FusedElementwise supports.
+    const auto& inputs = properties_.GetInputProperties(node.name());
+    const auto& outputs = properties_.GetOutputProperties(node.name());
+    if (inputs.size() != 2 || outputs.size() != 1) return {};
+    std::vector<int> candidates;
+    for (int i = 0; i < (op.commutative ? 2 : 1); ++i) {
+      const TensorShapeProto& chained = inputs[i].shape();
+      const TensorShapeProto& arg = inputs[1 - i].shape();
+      if (!ShapesSymbolicallyEqual(chained, outputs[0].shape())) continue;
+      if (IsBiasAdd(node) || NumCoefficients(arg) == 1 ||
+          ShapesSymbolicallyEqual(arg, chained) ||
+          IsLastDimension(arg, chained)) {
+        candidates.push_back(i);
+      }
+    }
+    return candidates;
+  }
+
+  // Whether `arg` is a vector of the size of the last dimension of `shape`.
+  static bool IsLastDimension(const TensorShapeProto& arg,
+                              const TensorShapeProto& shape) {
+    const int rank = Rank(shape);
+    return Rank(arg) == 1 && rank >= 1 && arg.dim(0).size() >= 0 &&
+           arg.dim(0).size() == shape.dim(rank - 1).size();
+  }
+
+  // Whether `input`, which produces input `index` of `consumer`, can be
+  // fused into it.
+  bool CanFuseInto(const NodeDef& input, const NodeDef& consumer,
+                   int index) const {
+    if (ChainInputCandidates(input).empty()) return false;
+    if (nodes_to_preserve_.count(input.name()) > 0) return false;
+    if (GetDataTypeFromAttr(input, "T") != GetDataTypeFromAttr(consumer, "T") ||
+        input.device() != consumer.device()) {
+      return false;
+    }
+    int port;
+    ParseNodeName(consumer.input(index), &port);
+    if (port != 0) return false;
+    // The fused node computes no intermediate results for other consumers.
+    return graph_.GetFanoutEdges(input, true).size() == 1;
+  }
+
+  const GrapplerItem& item_;
+  const GraphProperties& properties_;
+  const GraphView& graph_;
+  const std::unordered_set<string>& excluded_nodes_;
+  const std::unordered_set<string> nodes_to_preserve_;
+};
+
+void AddFusedElementwiseNode(GraphDef* optimized_graph,
+                             const ElementwiseChain& chain) {
+  const NodeDef& last = *chain.nodes.front();
+  const NodeDef& first = *chain.nodes.back();
+  NodeDef* fused_node = optimized_graph->add_node();
+  fused_node->set_name(last.name());
+  fused_node->set_op("_FusedElementwise");
+  fused_node->set_device(last.device());
+  fused_node->add_input(first.input(chain.chain_inputs.back()));
+
+  std::vector<string> op_names;
+  std::set<string> control_inputs;
+  for (int i = chain.nodes.size() - 1; i >= 0; --i) {
+    const NodeDef& node = *chain.nodes[i];
+    op_names.push_back(node.op());
+    for (int j = 0; j < node.input_size(); ++j) {
+      if (IsControlInput(node.input(j))) {
+        control_inputs.insert(node.input(j));
+      } else if (j != chain.chain_inputs[i]) {
+        fused_node->add_input(node.input(j));
+      }
+    }
+  }
+  for (const string& control_input : control_inputs) {
+    fused_node->add_input(control_input);
+  }
+
+  auto* attr = fused_node->mutable_attr();
+  (*attr)["T"] = last.attr().at("T");
+  SetAttrValue(fused_node->input_size() - 1 -
+                   static_cast<int>(control_inputs.size()),
+               &(*attr)["num_args"]);
+  SetAttrValue(op_names, &(*attr)["op_names"]);
+}
+
+// The resource apply ops that FindApplyGroups groups, and the fused op that
+// replaces each group.
+// WARN: This should be consistent with the fused apply ops of training_ops.cc.
+const std::unordered_map<string, string>& FusableApplyOps() {
+  static const auto* ops = new std::unordered_map<string, string>({
+      {"ResourceApplyAdam", "_FusedResourceApplyAdam"},
+      {"ResourceApplyMomentum", "_FusedResourceApplyMomentum"}});
+  return *ops;
+}
+
+// The fused apply ops only pay off on GPU, where each apply op is a kernel
+// launch of its own.
+bool NodeIsOnGpu(const NodeDef& node) {
+  string task;
+  string device;
+  return DeviceNameUtils::SplitDeviceName(node.device(), &task, &device) &&
+         str_util::StartsWith(device, DEVICE_GPU);
+}
+
+bool BoolAttrOrFalse(const NodeDef& node, const string& name) {
+  auto it = node.attr().find(name);
+  return it != node.attr().end() && it->second.b();
+}
+
+// Removes the nodes of `group` that other nodes of it depend on.  A fused
+// node replacing them would depend on itself.
+void RemoveDependentNodes(const GraphView& graph,
+                          std::vector<const NodeDef*>* group) {
+  std::vector<const NodeDef*> queue;
+  for (const NodeDef* node : *group) {
+    for (const auto& fanin : graph.GetFanins(*node, true)) {
+      queue.push_back(fanin.node);
+    }
+  }
+  std::unordered_set<const NodeDef*> upstream;
+  while (!queue.empty()) {
+    const NodeDef* node = queue.back();
+    queue.pop_back();
+    if (!upstream.insert(node).second) continue;
+    for (const auto& fanin : graph.GetFanins(*node, true)) {
+      queue.push_back(fanin.node);
+    }
+  }
+  group->erase(std::remove_if(group->begin(), group->end(),
+                              [&upstream](const NodeDef* node) {
+                                return upstream.count(node) > 0;
+                              }),
+               group->end());
+}
+
+// Finds the groups of resource apply ops that a single fused apply op can
+// replace: ops of the same kind, on the same GPU, with the same attributes,
+// none of which depends on another.
+std::vector<std::vector<const NodeDef*>> FindApplyGroups(
+    const GrapplerItem& item, const GraphView& graph) {
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  std::map<string, std::vector<const NodeDef*>> candidates;
+  for (const NodeDef& node : item.graph.node()) {
+    if (FusableApplyOps().count(node.op()) == 0) continue;
+    if (!NodeIsOnGpu(node) || nodes_to_preserve.count(node.name()) > 0) {
+      continue;
+    }
+    const DataType dtype = GetDataTypeFromAttr(node, "T");
+    if (dtype != DT_HALF && dtype != DT_FLOAT && dtype != DT_DOUBLE) continue;
+    const string key = strings::StrCat(
+        node.op(), ";", node.device(), ";", DataTypeString(dtype), ";",
+        BoolAttrOrFalse(node, "use_locking") ? 1 : 0, ";",
+        BoolAttrOrFalse(node, "use_nesterov") ? 1 : 0);
+    candidates[key].push_back(&node);
+  }
+
+  std::vector<std::vector<const NodeDef*>> groups;
+  for (auto& candidate : candidates) {
+    std::vector<const NodeDef*>& nodes = candidate.second;
+    RemoveDependentNodes(graph, &nodes);
+    if (nodes.size() >= 2) groups.push_back(std::move(nodes));
+  }
+  return groups;
+}
+
+string FusedApplyNodeName(const std::vector<const NodeDef*>& group) {
+  return AddPrefixToNodeName(group.front()->name(), "FusedApply");
+}
+
+// Adds the fused apply op that replaces `group`.  Its inputs are those of the
+// ops of the group, grouped by input.
+void AddFusedApplyNode(GraphDef* optimized_graph,
+                       const std::vector<const NodeDef*>& group) {
+  const NodeDef& first = *group.front();
+  NodeDef* fused_node = optimized_graph->add_node();
+  fused_node->set_name(FusedApplyNodeName(group));
+  fused_node->set_op(FusableApplyOps().at(first.op()));
+  fused_node->set_device(first.device());
+
+  int num_inputs = 0;
+  while (num_inputs < first.input_size() &&
+         !IsControlInput(first.input(num_inputs))) {
+    ++num_inputs;
+  }
+  for (int i = 0; i < num_inputs; ++i) {
+    for (const NodeDef* node : group) {
+      fused_node->add_input(node->input(i));
+    }
+  }
+  std::set<string> control_inputs;
+  for (const NodeDef* node : group) {
+    for (int i = num_inputs; i < node->input_size(); ++i) {
+      control_inputs.insert(node->input(i));
+    }
+  }
+  for (const string& control_input : control_inputs) {
+    fused_node->add_input(control_input);
+  }
+
+  auto* attr = fused_node->mutable_attr();
+  SetAttrValue(static_cast<int>(group.size()), &(*attr)["N"]);
+  for (const string& name : {"T", "use_locking", "use_nesterov"}) {
+    if (first.attr().count(name) > 0) (*attr)[name] = first.attr().at(name);
+  }
+}
+
+// A ResizeBilinear on CPU and the ops around it that
+// _FusedResizeBilinearNormalize computes with it in a single pass.
+struct ResizeNormalizeChain {
+  const NodeDef* cast_input = nullptr;   // Casts the images from uint8.
+  const NodeDef* resize = nullptr;       // The ResizeBilinear.
+  const NodeDef* sub = nullptr;          // Subtracts the mean.
+  const NodeDef* mul = nullptr;          // Mul or RealDiv by the scale.
+  int mul_chain_input = 0;               // The input of `mul` fed by `sub`.
+  const NodeDef* cast_output = nullptr;  // Casts the result to bfloat16.
+  const NodeDef* transpose = nullptr;    // Transposes the result to NCHW.
+  // The nodes of the chain, starting with the last one.
+  std::vector<const NodeDef*> nodes;
+};
+
+// Finds the image preprocessing chains worth fusing: a ResizeBilinear
+// followed by a normalization with a Sub, a Mul or RealDiv, or both, each by
+// a scalar or a per-channel vector, and optionally preceded by a Cast from
+// uint8 and followed by a Cast to bfloat16 and a Transpose to NCHW.
+class ResizeNormalizeFinder {
+ public:
+  ResizeNormalizeFinder(const GrapplerItem& item,
+                        const GraphProperties& properties,
+                        const GraphView& graph)
+      : item_(item),
+        properties_(properties),
+        graph_(graph),
+        nodes_to_preserve_(item.NodesToPreserve()) {}
+
+  // Returns the chains by the name of their last node, which the fused node
+  // replaces, and the names of all their nodes.
+  void FindChains(std::unordered_map<string, ResizeNormalizeChain>* chains,
+                  std::unordered_set<string>* fused_nodes) {
+    for (const NodeDef& node : item_.graph.node()) {
+      if (node.op() != "ResizeBilinear" || !NodeIsOnCpu(node)) continue;
+      ResizeNormalizeChain chain;
+      chain.resize = &node;
+      const DataType dtype = GetDataTypeFromAttr(node, "T");
+      const NodeDef* input = graph_.GetNode(NodeName(node.input(0)));
+      if (dtype == DT_FLOAT && input != nullptr && IsCast(*input) &&
+          GetDataTypeFromAttr(*input, "SrcT") == DT_UINT8 &&
+          SingleConsumer(*input) == &node) {
+        chain.cast_input = input;
+      } else if (dtype != DT_UINT8 && dtype != DT_FLOAT) {
+        continue;
+      }
+      const int64 channels = Channels(node);
+
+      const NodeDef* last = &node;
+      const NodeDef* next = SingleConsumer(*last);
+      if (next != nullptr && IsSub(*next) && ChainInput(*next, *last) == 0 &&
+          IsChannelParameter(*next, 1, channels)) {
+        chain.sub = next;
+        last = next;
+        next = SingleConsumer(*last);
+      }
+      if (next != nullptr && (IsMul(*next) || IsRealDiv(*next))) {
+        const int index = ChainInput(*next, *last);
+        if ((index == 0 || (index == 1 && IsMul(*next))) &&
+            IsChannelParameter(*next, 1 - index, channels)) {
+          chain.mul = next;
+          chain.mul_chain_input = index;
+          last = next;
+          next = SingleConsumer(*last);
+        }
+      }
+      if (chain.sub == nullptr && chain.mul == nullptr) continue;
+      if (next != nullptr && IsCast(*next) &&
+          GetDataTypeFromAttr(*next, "DstT") == DT_BFLOAT16) {
+        chain.cast_output = next;
+        last = next;
+        next = SingleConsumer(*last);
+      }
+      if (next != nullptr && IsTranspose(*next) && IsNhwcToNchw(*next)) {
+        chain.transpose = next;
+      }
+
+      for (const NodeDef* chain_node :
+           {chain.transpose, chain.cast_output, chain.mul, chain.sub,
+            chain.resize, chain.cast_input}) {
+        if (chain_node == nullptr) continue;
+        chain.nodes.push_back(chain_node);
+        fused_nodes->insert(chain_node->name());
+      }
+      (*chains)[chain.nodes.front()->name()] = std::move(chain);
+    }
+  }
+
+ private:
+  // Returns the only consumer of output 0 of `node` if `node` can be fused
+  // into it, or nullptr otherwise.
+  const NodeDef* SingleConsumer(const NodeDef& node) const {
+    if (nodes_to_preserve_.count(node.name()) > 0) return nullptr;
+    const auto fanouts = graph_.GetFanoutEdges(node, true);
+    if (fanouts.size() != 1) return nullptr;
+    const GraphView::Edge& edge = *fanouts.begin();
+    if (edge.src.port_id != 0 || edge.tgt.port_id < 0 ||
+        edge.tgt.node->device() != node.device()) {
+      return nullptr;
+    }
+    return edge.tgt.node;
+  }
+
+  // Returns the input of `consumer` that `node` produces.
+  static int ChainInput(const NodeDef& consumer, const NodeDef& node) {
+    for (int i = 0; i < consumer.input_size(); ++i) {
+      if (!IsControlInput(consumer.input(i)) &&
+          NodeName(consumer.input(i)) == node.name()) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Returns the number of channels of the images that `resize` outputs, or
+  // -1 if it is unknown.
+  int64 Channels(const NodeDef& resize) const {
+    const auto& outputs = properties_.GetOutputProperties(resize.name());
+    if (outputs.size() != 1 || Rank(outputs[0].shape()) != 4) return -1;
+    return outputs[0].shape().dim(3).size();
+  }
+
+  // Whether input `index` of `node` is a scalar or a vector of `channels`
+  // values.
+  bool IsChannelParameter(const NodeDef& node, int index,
+                          int64 channels) const {
+    const auto& inputs = properties_.GetInputProperties(node.name());
+    if (inputs.size() != 2 || inputs[index].dtype() != DT_FLOAT) return false;
+    const TensorShapeProto& shape = inputs[index].shape();
+    if (NumCoefficients(shape) == 1 && Rank(shape) <= 1) return true;
+    return Rank(shape) == 1 && channels >= 0 &&
+           shape.dim(0).size() == channels;
+  }
+
+  // Whether `transpose` has the constant permutation [0, 3, 1, 2].
+  bool IsNhwcToNchw(const NodeDef& transpose) const {
+    const auto& inputs = properties_.GetInputProperties(transpose.name());
+    if (inputs.size() != 2 || !inputs[1].has_value()) return false;
+    Tensor perm;
+    if (!perm.FromProto(inputs[1].value()) || perm.NumElements() != 4) {
+      return false;
+    }
+    const int64 nchw[] = {0, 3, 1, 2};
+    for (int i = 0; i < 4; ++i) {
+      int64 dim;
+      if (perm.dtype() == DT_INT32) {
+        dim = perm.flat<int32>()(i);
+      } else if (perm.dtype() == DT_INT64) {
+        dim = perm.flat<int64>()(i);
+      } else {
+        return false;
+      }
+      if (dim != nchw[i]) return false;
+    }
+    return true;
+  }
+
+  const GrapplerItem& item_;
+  const GraphProperties& properties_;
+  const GraphView& graph_;
+  const std::unordered_set<string> nodes_to_preserve_;
+};
+
+// Adds a float scalar constant named `name` for the fused node that replaces
+// the chain ending with `last`, and returns its name.
+string AddScalarConst(GraphDef* optimized_graph, const string& name,
+                      const NodeDef& last, const string& anchor, float value) {
+  NodeDef* node = optimized_graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(last.device());
+  // Keeps the constant in the frame of the chain.
+  *node->add_input() = AsControlDependency(NodeName(anchor));
+  (*node->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = value;
+  t.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+  return node->name();
+}
+
+void AddFusedResizeNormalizeNode(GraphDef* optimized_graph,
+                                 const ResizeNormalizeChain& chain) {
+  const NodeDef& last = *chain.nodes.front();
+  const NodeDef& resize = *chain.resize;
+  const string& images =
+      chain.cast_input ? chain.cast_input->input(0) : resize.input(0);
+
+  string mean;
+  if (chain.sub != nullptr) {
+    mean = chain.sub->input(1);
+  } else {
+    mean = AddScalarConst(
+        optimized_graph,
+        AddPrefixToNodeName(last.name(), "ResizeNormalizeMean"), last, images,
+        0.0f);
+  }
+  string scale;
+  if (chain.mul == nullptr) {
+    scale = AddScalarConst(
+        optimized_graph,
+        AddPrefixToNodeName(last.name(), "ResizeNormalizeScale"), last, images,
+        1.0f);
+  } else if (IsMul(*chain.mul)) {
+    scale = chain.mul->input(1 - chain.mul_chain_input);
+  } else {
+    NodeDef* reciprocal = optimized_graph->add_node();
+    reciprocal->set_name(
+        AddPrefixToNodeName(last.name(), "ResizeNormalizeScale"));
+    reciprocal->set_op("Reciprocal");
+    reciprocal->set_device(last.device());
+    *reciprocal->add_input() = chain.mul->input(1);
+    (*reciprocal->mutable_attr())["T"].set_type(DT_FLOAT);
+    scale = reciprocal->name();
+  }
+
+  NodeDef* fused_node = optimized_graph->add_node();
+  fused_node->set_name(last.name());
+  fused_node->set_op("_FusedResizeBilinearNormalize");
+  fused_node->set_device(last.device());
+  fused_node->add_input(images);
+  fused_node->add_input(resize.input(1));
+  fused_node->add_input(mean);
+  fused_node->add_input(scale);
+  std::set<string> control_inputs;
+  for (const NodeDef* node : chain.nodes) {
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) control_inputs.insert(input);
+    }
+  }
+  for (const string& control_input : control_inputs) {
+    fused_node->add_input(control_input);
+  }
+
+  auto* attr = fused_node->mutable_attr();
+  (*attr)["T"].set_type(chain.cast_input ? DT_UINT8
+                                         : GetDataTypeFromAttr(resize, "T"));
+  (*attr)["out_type"].set_type(chain.cast_output ? DT_BFLOAT16 : DT_FLOAT);
+  SetAttrValue(BoolAttrOrFalse(resize, "align_corners"),
+               &(*attr)["align_corners"]);
+  SetAttrValue(chain.transpose ? "NCHW" : "NHWC", &(*attr)["data_format"]);
+}
+
+}  // namespace
+
 void AddBatchNormNodes(GraphDef* optimized_graph, const NodeDef& fused_node) {
   const string& x = fused_node.input(0);
   string scale = fused_node.input(1);
@@ -171,9 +764,68 @@ Status Remapper::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
   TF_RETURN_IF_ERROR(properties.InferStatically(false));
   GraphView graph(const_cast<GraphDef*>(&item.graph));
 
+  // Image preprocessing on CPU resizes, normalizes, casts and transposes the
+  // images in a pass over memory per op, each allocating a new tensor.
+  // _FusedResizeBilinearNormalize computes each output row once.
+  std::unordered_map<string, ResizeNormalizeChain> resize_chains;
+  std::unordered_set<string> fused_resize_nodes;
+  ResizeNormalizeFinder(item, properties, graph)
+      .FindChains(&resize_chains, &fused_resize_nodes);
+
+  // Chains of elementwise ops on CPU pass over memory once per op. Fusing them
+  // into a single _FusedElementwise node passes over it once.
+  std::unordered_map<string, ElementwiseChain> elementwise_chains;
+  std::unordered_set<string> fused_elementwise_nodes;
+  ElementwiseChainFinder(item, properties, graph, fused_resize_nodes)
+      .FindChains(&elementwise_chains, &fused_elementwise_nodes);
+
+  // On GPU, each resource apply op updates its variable in kernel launches of
+  // its own. A fused apply op updates a group of variables in a few launches.
+  // The apply ops of a group become NoOps that wait for it, so that the
+  // dependencies on them keep their meaning.
+  const std::vector<std::vector<const NodeDef*>> apply_groups =
+      FindApplyGroups(item, graph);
+  std::unordered_map<string, int> apply_group_of;
+  for (int i = 0; i < static_cast<int>(apply_groups.size()); ++i) {
+    for (const NodeDef* node : apply_groups[i]) {
+      apply_group_of[node->name()] = i;
+    }
+  }
+
   // During inference, most of the inputs to FusedBatchNorm are constant, and we
   // can therefore replace the op with a much cheaper set of primitives.
   for (const NodeDef& node : item.graph.node()) {
+    auto resize_chain = resize_chains.find(node.name());
+    if (resize_chain != resize_chains.end()) {
+      VLOG(1) << "Fusing " << resize_chain->second.nodes.size()
+              << " image preprocessing ops into " << node.name();
+      AddFusedResizeNormalizeNode(optimized_graph, resize_chain->second);
+      continue;
+    }
+    if (fused_resize_nodes.count(node.name()) > 0) continue;
+    if (fused_elementwise_nodes.count(node.name()) > 0) continue;
+    auto apply_group = apply_group_of.find(node.name());
+    if (apply_group != apply_group_of.end()) {
+      const auto& group = apply_groups[apply_group->second];
+      if (group.front() == &node) {
+        VLOG(1) << "Fusing " << group.size() << " " << node.op()
+                << " ops into " << FusedApplyNodeName(group);
+        AddFusedApplyNode(optimized_graph, group);
+      }
+      NodeDef* no_op = optimized_graph->add_node();
+      no_op->set_name(node.name());
+      no_op->set_op("NoOp");
+      no_op->set_device(node.device());
+      no_op->add_input(AsControlDependency(FusedApplyNodeName(group)));
+      continue;
+    }
+    auto chain = elementwise_chains.find(node.name());
+    if (chain != elementwise_chains.end()) {
+      VLOG(1) << "Fusing " << chain->second.nodes.size()
+              << " elementwise ops into " << node.name();
+      AddFusedElementwiseNode(optimized_graph, chain->second);
+      continue;
+    }
     if (node.op() == "FusedBatchNorm" || node.op() == "FusedBatchNormV2") {
       bool optimizable = (node.attr().count("T") == 0 ||
                           node.attr().at("T").type() == DT_FLOAT);
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -91,5 +92,239 @@ TEST_F(RemapperTest, FusedBatchNormNCHW) {
   }
 }
 
+TEST_F(RemapperTest, FusedElementwiseChain) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  Output dflt = ops::Const(s.WithOpName("dflt"),
+                           {1.0f, -2.0f, 3.0f, -4.0f, 5.0f, -6.0f}, {2, 3});
+  Output x = ops::PlaceholderWithDefault(s.WithOpName("x"), dflt, {2, 3});
+  Output bias = ops::Const(s.WithOpName("bias"), {0.1f, -0.2f, 0.3f}, {3});
+  Output scale = ops::Const(s.WithOpName("scale"), 2.0f, {});
+  Output y = ops::Const(s.WithOpName("y"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f},
+                        {2, 3});
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), x, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  Output mul = ops::Mul(s.WithOpName("mul"), scale, relu);
+  Output sub = ops::Sub(s.WithOpName("sub"), mul, y);
+  Output sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), sub);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"sigmoid"};
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("bias_add", node.name());
+    EXPECT_NE("relu", node.name());
+    EXPECT_NE("mul", node.name());
+    EXPECT_NE("sub", node.name());
+    if (node.name() == "sigmoid") {
+      EXPECT_EQ("_FusedElementwise", node.op());
+      ASSERT_EQ(4, node.input_size());
+      EXPECT_EQ("x", node.input(0));
+      EXPECT_EQ("bias", node.input(1));
+      EXPECT_EQ("scale", node.input(2));
+      EXPECT_EQ("y", node.input(3));
+      EXPECT_EQ(3, node.attr().at("num_args").i());
+      const auto& op_names = node.attr().at("op_names").list().s();
+      ASSERT_EQ(5, op_names.size());
+      EXPECT_EQ("BiasAdd", op_names.Get(0));
+      EXPECT_EQ("Relu", op_names.Get(1));
+      EXPECT_EQ("Mul", op_names.Get(2));
+      EXPECT_EQ("Sub", op_names.Get(3));
+      EXPECT_EQ("Sigmoid", op_names.Get(4));
+      ++found;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  EXPECT_EQ(1, tensors_expected.size());
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FusedElementwiseChainKeepsSharedResults) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, -2.0f, 3.0f, -4.0f}, {2, 2});
+  Output bias = ops::Const(s.WithOpName("bias"), {0.5f, -0.5f}, {2});
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), x, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  Output mul = ops::Mul(s.WithOpName("mul"), relu, x);
+  Output tanh = ops::Tanh(s.WithOpName("tanh"), mul);
+  Output square = ops::Square(s.WithOpName("square"), relu);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"tanh", "square"};
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // `relu` has two consumers, so it ends a chain instead of joining one.
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("bias_add", node.name());
+    EXPECT_NE("mul", node.name());
+    if (node.name() == "relu") {
+      EXPECT_EQ("_FusedElementwise", node.op());
+      EXPECT_EQ(2, node.attr().at("op_names").list().s_size());
+      ++found;
+    } else if (node.name() == "tanh") {
+      EXPECT_EQ("_FusedElementwise", node.op());
+      ASSERT_EQ(2, node.input_size());
+      EXPECT_EQ("relu", node.input(0));
+      EXPECT_EQ("x", node.input(1));
+      ++found;
+    } else if (node.name() == "square") {
+      EXPECT_EQ("Square", node.op());
+      ++found;
+    }
+  }
+  EXPECT_EQ(3, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  EXPECT_EQ(2, tensors_expected.size());
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(2, tensors.size());
+  for (int i = 0; i < 2; ++i) {
+    test::ExpectTensorNear<float>(tensors_expected[i], tensors[i], 1e-6);
+  }
+}
+
+TEST_F(RemapperTest, FusedResizeBilinearNormalize) {
+  tensorflow::Scope s =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+  std::vector<uint8> pixels(4 * 6 * 3);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<uint8>(i * 29 % 256);
+  }
+  Output dflt = ops::Const(s.WithOpName("dflt"),
+                           test::AsTensor<uint8>(pixels, {1, 4, 6, 3}));
+  Output x = ops::PlaceholderWithDefault(s.WithOpName("x"), dflt, {1, 4, 6, 3});
+  Output cast = ops::Cast(s.WithOpName("cast"), x, DT_FLOAT);
+  Output size = ops::Const(s.WithOpName("size"), {5, 3}, {2});
+  Output resize = ops::ResizeBilinear(s.WithOpName("resize"), cast, size);
+  Output mean = ops::Const(s.WithOpName("mean"), {100.0f, 110.0f, 120.0f}, {3});
+  Output stddev = ops::Const(s.WithOpName("stddev"), 64.0f, {});
+  Output sub = ops::Sub(s.WithOpName("sub"), resize, mean);
+  Output div = ops::RealDiv(s.WithOpName("div"), sub, stddev);
+  Output perm = ops::Const(s.WithOpName("perm"), {0, 3, 1, 2}, {4});
+  Output transpose = ops::Transpose(s.WithOpName("transpose"), div, perm);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"transpose"};
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("cast", node.name());
+    EXPECT_NE("resize", node.name());
+    EXPECT_NE("sub", node.name());
+    EXPECT_NE("div", node.name());
+    if (node.name() == "transpose") {
+      EXPECT_EQ("_FusedResizeBilinearNormalize", node.op());
+      ASSERT_EQ(4, node.input_size());
+      EXPECT_EQ("x", node.input(0));
+      EXPECT_EQ("size", node.input(1));
+      EXPECT_EQ("mean", node.input(2));
+      EXPECT_EQ("ResizeNormalizeScale/transpose", node.input(3));
+      EXPECT_EQ(DT_UINT8, node.attr().at("T").type());
+      EXPECT_EQ(DT_FLOAT, node.attr().at("out_type").type());
+      EXPECT_EQ("NCHW", node.attr().at("data_format").s());
+      ++found;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  EXPECT_EQ(1, tensors_expected.size());
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-5);
+}
+
+TEST_F(RemapperTest, FusedResourceApplyAdam) {
+  tensorflow::Scope gpu =
+      tensorflow::Scope::NewRootScope().WithDevice("/device:GPU:0");
+  Output beta1_power = ops::Const(gpu.WithOpName("beta1_power"), 0.9f, {});
+  Output beta2_power = ops::Const(gpu.WithOpName("beta2_power"), 0.99f, {});
+  Output lr = ops::Const(gpu.WithOpName("lr"), 0.1f, {});
+  Output beta1 = ops::Const(gpu.WithOpName("beta1"), 0.9f, {});
+  Output beta2 = ops::Const(gpu.WithOpName("beta2"), 0.99f, {});
+  Output epsilon = ops::Const(gpu.WithOpName("epsilon"), 1e-8f, {});
+  auto apply = [&](const tensorflow::Scope& s, const string& name,
+                   Output grad) {
+    auto var = [&](const string& slot) {
+      return ops::VarHandleOp(s.WithOpName(strings::StrCat(name, "_", slot)),
+                              DT_FLOAT, {2});
+    };
+    return ops::ResourceApplyAdam(s.WithOpName(name), var("var"), var("m"),
+                                  var("v"), beta1_power, beta2_power, lr,
+                                  beta1, beta2, epsilon, grad)
+        .operation;
+  };
+  Output grad_a = ops::Const(gpu.WithOpName("grad_a"), {1.0f, 2.0f}, {2});
+  Operation a = apply(gpu, "a", grad_a);
+  Output grad_b = ops::Const(gpu.WithOpName("grad_b"), {1.0f, 2.0f}, {2});
+  Operation b = apply(gpu, "b", grad_b);
+  // `c` depends on `a`, which therefore can not be fused with it.
+  Output grad_c = ops::Const(
+      gpu.WithOpName("grad_c").WithControlDependencies(a), {1.0f, 2.0f}, {2});
+  Operation c = apply(gpu, "c", grad_c);
+  Output grad_d = ops::Const(gpu.WithOpName("grad_d"), {1.0f, 2.0f}, {2});
+  Operation d = apply(gpu.WithDevice("/device:CPU:0"), "d", grad_d);
+  ops::NoOp train(
+      gpu.WithOpName("train").WithControlDependencies({a, b, c, d}));
+
+  GrapplerItem item;
+  TF_CHECK_OK(gpu.ToGraphDef(&item.graph));
+  item.fetch = {"train"};
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "a" || node.name() == "d") {
+      EXPECT_EQ("ResourceApplyAdam", node.op());
+      ++found;
+    } else if (node.name() == "b" || node.name() == "c") {
+      EXPECT_EQ("NoOp", node.op());
+      ASSERT_EQ(1, node.input_size());
+      EXPECT_EQ("^FusedApply/b", node.input(0));
+      ++found;
+    } else if (node.name() == "FusedApply/b") {
+      EXPECT_EQ("_FusedResourceApplyAdam", node.op());
+      EXPECT_EQ("/device:GPU:0", node.device());
+      EXPECT_EQ(2, node.attr().at("N").i());
+      EXPECT_EQ(DT_FLOAT, node.attr().at("T").type());
+      ASSERT_EQ(20, node.input_size());
+      EXPECT_EQ("b_var", node.input(0));
+      EXPECT_EQ("c_var", node.input(1));
+      EXPECT_EQ("b_m", node.input(2));
+      EXPECT_EQ("c_m", node.input(3));
+      EXPECT_EQ("lr", node.input(10));
+      EXPECT_EQ("lr", node.input(11));
+      EXPECT_EQ("grad_b", node.input(18));
+      EXPECT_EQ("grad_c", node.input(19));
+      ++found;
+    }
+  }
+  EXPECT_EQ(5, found);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
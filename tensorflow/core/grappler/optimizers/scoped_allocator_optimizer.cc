@@ -651,7 +651,7 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
 
 ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
     RewriterConfig::Toggle opt_level, const ScopedAllocatorOptions& opts)
-    : opt_level_(opt_level) {
+    : opt_level_(opt_level), bucket_bytes_(opts.bucket_bytes()) {
   VLOG(1) << "ScopedAllocatorOptimizer::ScopedAllocatorOptimizer";
   Rewriter* r = new UnaryElementwiseRewriter();
   to_delete_.push_back(r);
@@ -812,6 +812,40 @@ void PartitionByLoopStructure(const FrameMap& frame_map,
   }
 }
 
+// Returns the size in bytes of the single output of n, or 0 if it is not
+// statically known.
+int64 OutputBytes(const GraphProperties& graph_properties, const NodeDef& n) {
+  if (!graph_properties.HasOutputProperties(n.name())) return 0;
+  const std::vector<OpInfo::TensorProperties>& prop_list =
+      graph_properties.GetOutputProperties(n.name());
+  if (prop_list.size() != 1 || !TensorShape::IsValid(prop_list[0].shape())) {
+    return 0;
+  }
+  return TensorShape(prop_list[0].shape()).num_elements() *
+         DataTypeSize(prop_list[0].dtype());
+}
+
+// Splits the ordered nodes into consecutive buckets whose outputs total at
+// most bucket_bytes.  A node whose output alone exceeds bucket_bytes gets a
+// bucket of its own.
+void PartitionIntoBuckets(const GraphProperties& graph_properties,
+                          int64 bucket_bytes,
+                          const std::vector<NodeDef*>& nodes,
+                          std::vector<std::vector<NodeDef*>>* buckets) {
+  int64 bytes_in_bucket = 0;
+  for (NodeDef* nd : nodes) {
+    int64 bytes = OutputBytes(graph_properties, *nd);
+    if (buckets->empty() ||
+        (!buckets->back().empty() &&
+         bytes_in_bucket + bytes > bucket_bytes)) {
+      buckets->emplace_back();
+      bytes_in_bucket = 0;
+    }
+    buckets->back().push_back(nd);
+    bytes_in_bucket += bytes;
+  }
+}
+
 }  // namespace
 
 Status ScopedAllocatorOptimizer::ProcessGraphDef(
@@ -841,26 +875,39 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
         // Nodes with a common depth and root path are now grouped
         // in the same Tree struct.  Split those groups into subgroups that
         // share identical loop nesting.
-        status = ApplyToAll(
-            root.get(), [this, rewriter, graph, &frame_map, &op_name](Tree* t) {
-              VLOG(2) << "applied to tree node " << t->edge_ << " at depth "
-                      << t->depth_ << " of size " << t->nodes_.size();
-              if (t->nodes_.size() > 1) {
-                std::vector<std::vector<NodeDef*>> loop_groups;
-                PartitionByLoopStructure(frame_map, t->nodes_, &loop_groups);
-                for (auto& lg : loop_groups) {
-                  if (lg.size() > 1) {
-                    bool applied = false;
-                    Status s = OrderNodeSet(&lg);
-                    TF_RETURN_IF_ERROR(s);
-                    VLOG(1) << "Applying Rewriter for " << op_name;
-                    s = rewriter->Rewrite(this, graph, op_name, lg, &applied);
-                    LOG_WARNING_AND_RETURN_IF_ERROR(s);
-                  }
+        status = ApplyToAll(root.get(), [this, rewriter, graph,
+                                         &graph_properties, &frame_map,
+                                         &op_name](Tree* t) {
+          VLOG(2) << "applied to tree node " << t->edge_ << " at depth "
+                  << t->depth_ << " of size " << t->nodes_.size();
+          if (t->nodes_.size() > 1) {
+            std::vector<std::vector<NodeDef*>> loop_groups;
+            PartitionByLoopStructure(frame_map, t->nodes_, &loop_groups);
+            for (auto& lg : loop_groups) {
+              if (lg.size() > 1) {
+                Status s = OrderNodeSet(&lg);
+                TF_RETURN_IF_ERROR(s);
+                std::vector<std::vector<NodeDef*>> buckets;
+                if (bucket_bytes_ > 0) {
+                  PartitionIntoBuckets(graph_properties, bucket_bytes_, lg,
+                                       &buckets);
+                } else {
+                  buckets.push_back(std::move(lg));
+                }
+                for (auto& bucket : buckets) {
+                  if (bucket.size() <= 1) continue;
+                  bool applied = false;
+                  VLOG(1) << "Applying Rewriter for " << op_name << " to "
+                          << bucket.size() << " nodes";
+                  s = rewriter->Rewrite(this, graph, op_name, bucket,
+                                        &applied);
+                  LOG_WARNING_AND_RETURN_IF_ERROR(s);
                 }
               }
-              return Status::OK();
-            });
+            }
+          }
+          return Status::OK();
+        });
         if (!status.ok()) {
           break;
         }
@@ -918,6 +965,13 @@ Status ScopedAllocatorOptimizer::OrderNodeSet(
   if (nodes->size() <= 1) return Status::OK();
   if (IsCollectiveNode(*nodes->at(0))) {
     sort(nodes->begin(), nodes->end(), InstanceKeyLess());
+    if (bucket_bytes_ > 0) {
+      // Collectives are typically created, and given instance_keys, in
+      // forward layer order, while backprop produces their inputs in
+      // reverse layer order.  Fill buckets in the latter order so that the
+      // first bucket is ready first.
+      std::reverse(nodes->begin(), nodes->end());
+    }
   } else {
     sort(nodes->begin(), nodes->end(), NameLess());
   }
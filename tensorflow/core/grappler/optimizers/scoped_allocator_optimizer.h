@@ -100,6 +100,9 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
   std::unordered_map<string, Rewriter*> rewriters_;
   std::vector<Rewriter*> to_delete_;
   int next_sa_id_ = 1;
+  // If positive, the upper bound on the output bytes of the ops rewritten
+  // to share one ScopedAllocator.
+  int64 bucket_bytes_ = 0;
   std::unique_ptr<NodeMap> node_map_;
 };
 
@@ -216,6 +216,52 @@ TEST_F(ScopedAllocatorOptimizerTest, UnaryExecute) {
   }
 }
 
+TEST_F(ScopedAllocatorOptimizerTest, UnaryRewriteInBuckets) {
+  // Tests that with bucket_bytes set, four parallel Abs ops are rewritten
+  // into two ScopedAllocators of two ops each.
+  GrapplerItem item;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  s = s.WithDevice("/job:localhost/replica:0/task:0/device:CPU:0");
+  Output a =
+      ops::Const<float>(s.WithOpName("a"), {1.0, 0.0, 0.0, -1.0}, {2, 2});
+  Output b =
+      ops::Const<float>(s.WithOpName("b"), {1.0, -2.0, 3.0, 4.0}, {2, 2});
+  for (int i = 1; i <= 4; ++i) {
+    Output si = ops::Add(s.WithOpName(strings::StrCat("s", i)), a, b);
+    Output ai = ops::Abs(s.WithOpName(strings::StrCat("a", i)), si);
+    ops::Reshape(s.WithOpName(strings::StrCat("r", i)), ai, {1, 4});
+  }
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  SetShapes(&item.graph);
+
+  ScopedAllocatorOptions opts;
+  opts.add_enable_op("Abs");
+  // Each 2x2 float output takes 16 bytes.
+  opts.set_bucket_bytes(32);
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  // Each ScopedAllocator id is followed by one id per field.
+  NodeMap node_map(&optimized_graph);
+  const std::vector<std::pair<string, std::unordered_set<string>>>
+      expected_buckets = {{"1", {"s1", "s2"}}, {"4", {"s3", "s4"}}};
+  for (const auto& bucket : expected_buckets) {
+    const string sa_name = strings::StrCat("scoped_allocator_", bucket.first);
+    ASSERT_TRUE(node_map.GetNode(sa_name)) << sa_name;
+    std::unordered_set<string> expected = bucket.second;
+    expected.insert(strings::StrCat("scoped_allocator_concat_", bucket.first));
+    auto& nd_set = node_map.GetOutputs(sa_name);
+    ASSERT_EQ(3, nd_set.size());
+    for (auto it : nd_set) {
+      EXPECT_NE(expected.find(it->name()), expected.end())
+          << "Unexpected output " << it->name() << " of " << sa_name;
+    }
+  }
+  EXPECT_FALSE(node_map.GetNode("scoped_allocator_7"));
+}
+
 // Tests static ScopedAllocatorOptimizer::ExtendNodeAttr.
 // Maybe this should be moved elsewhere?
 TEST_F(ScopedAllocatorOptimizerTest, Extend) {
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 #include <deque>
+#include <queue>
+#include <unordered_set>
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
@@ -191,5 +194,155 @@ Status EstimateRequiredTimes(
   return Status::OK();
 }
 
+const char kExecutionPriorityAttr[] = "_execution_priority";
+
+// Returns the estimated size in bytes of a tensor, counting the unknown
+// dimensions as 1.
+static int64 EstimateTensorSize(const OpInfo::TensorProperties& tensor) {
+  int64 num_elements = 1;
+  if (!tensor.shape().unknown_rank()) {
+    for (const auto& dim : tensor.shape().dim()) {
+      num_elements *= std::max<int64>(dim.size(), 1);
+    }
+  }
+  return num_elements * DataTypeSize(BaseType(tensor.dtype()));
+}
+
+Status EstimateMemoryEfficientOrder(
+    const GrapplerItem& item, std::unordered_map<const NodeDef*, int>* order) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(false));
+
+  // The tensors produced by the nodes, keyed by "node:port", along with the
+  // number of their consumers that didn't run yet.
+  struct TensorUse {
+    int64 size = 0;
+    int pending_consumers = 0;
+    std::vector<const NodeDef*> consumers;
+  };
+  std::unordered_map<string, TensorUse> tensors;
+  std::unordered_map<const NodeDef*, std::vector<string>> regular_inputs;
+  std::unordered_map<const NodeDef*, std::vector<const NodeDef*>> fanouts;
+  std::unordered_map<const NodeDef*, int> pending_inputs;
+  std::unordered_map<const NodeDef*, int64> output_sizes;
+  std::unordered_map<const NodeDef*, int> positions;
+  std::unordered_map<string, const NodeDef*> name_map;
+  int position = 0;
+  for (const NodeDef& node : item.graph.node()) {
+    name_map[node.name()] = &node;
+    positions[&node] = position++;
+    int64 output_size = 0;
+    int port = 0;
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      const int64 size = EstimateTensorSize(output);
+      tensors[strings::StrCat(node.name(), ":", port++)].size = size;
+      output_size += size;
+    }
+    output_sizes[&node] = output_size;
+    // Merge nodes are processed as soon as one of the input becomes
+    // available.
+    pending_inputs[&node] = IsMerge(node) ? std::min(node.input_size(), 1)
+                                          : node.input_size();
+  }
+
+  for (const NodeDef& node : item.graph.node()) {
+    std::unordered_set<string> seen;
+    for (const string& input : node.input()) {
+      int port;
+      const string node_name = ParseNodeName(input, &port);
+      auto it = name_map.find(node_name);
+      if (it == name_map.end()) {
+        return errors::InvalidArgument(
+            strings::StrCat("Unknown input node ", input));
+      }
+      fanouts[it->second].push_back(&node);
+      const string tensor = strings::StrCat(node_name, ":", port);
+      if (port >= 0 && seen.insert(tensor).second) {
+        TensorUse& use = tensors[tensor];
+        use.pending_consumers++;
+        use.consumers.push_back(&node);
+        regular_inputs[&node].push_back(tensor);
+      }
+    }
+  }
+
+  // The ready nodes, the ones that free the most memory first. The scores of
+  // the nodes change as their inputs lose consumers: the outdated entries of
+  // the queue are recognized by their version, and skipped.
+  struct Candidate {
+    int64 score;
+    int position;
+    int version;
+    const NodeDef* node;
+    bool operator<(const Candidate& other) const {
+      if (score != other.score) return score < other.score;
+      return position > other.position;
+    }
+  };
+  std::priority_queue<Candidate> ready_nodes;
+  std::unordered_map<const NodeDef*, int> versions;
+  auto push_ready = [&](const NodeDef* node) {
+    int64 score = -output_sizes[node];
+    for (const string& tensor : regular_inputs[node]) {
+      const TensorUse& use = tensors[tensor];
+      if (use.pending_consumers == 1) {
+        score += use.size;
+      }
+    }
+    ready_nodes.push({score, positions[node], ++versions[node], node});
+  };
+  for (const NodeDef& node : item.graph.node()) {
+    if (pending_inputs[&node] == 0) {
+      push_ready(&node);
+    }
+  }
+
+  while (!ready_nodes.empty()) {
+    const Candidate candidate = ready_nodes.top();
+    ready_nodes.pop();
+    const NodeDef* node = candidate.node;
+    if (candidate.version != versions[node] || order->count(node) > 0) {
+      continue;
+    }
+    const int rank = order->size();
+    (*order)[node] = rank;
+
+    for (const string& tensor : regular_inputs[node]) {
+      TensorUse& use = tensors[tensor];
+      if (--use.pending_consumers != 1) {
+        continue;
+      }
+      // The last consumer of the tensor now frees it: update its score if it
+      // is ready.
+      for (const NodeDef* consumer : use.consumers) {
+        if (order->count(consumer) == 0 && pending_inputs[consumer] == 0) {
+          push_ready(consumer);
+        }
+      }
+    }
+
+    for (const NodeDef* fanout : fanouts[node]) {
+      int& pending = pending_inputs[fanout];
+      if (pending == 0) {
+        // Already ready. Avoid going through loops more than once.
+        continue;
+      }
+      if (--pending == 0) {
+        push_ready(fanout);
+      }
+    }
+  }
+
+  // Nodes that are never ready, e.g. because they are part of a cycle, run
+  // last in the order of the graph.
+  for (const NodeDef& node : item.graph.node()) {
+    if (order->count(&node) == 0) {
+      const int rank = order->size();
+      (*order)[&node] = rank;
+    }
+  }
+  return Status::OK();
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
@@ -44,6 +44,19 @@ Status EstimateRequiredTimes(
         execution_times,
     std::unordered_map<const NodeDef*, Costs::NanoSeconds>* required_times);
 
+// The name of the node attribute in which the ranks computed by
+// EstimateMemoryEfficientOrder are stored for the executor, which runs the
+// ready nodes with the lowest rank first.
+extern const char kExecutionPriorityAttr[];
+
+// Compute an order of execution of the nodes of the graph that keeps the
+// memory usage low: among the nodes that are ready to run, we greedily pick
+// the one that frees the most memory, i.e. the size of the inputs it is the
+// last consumer of minus the size of its outputs. Ties are broken by the
+// position of the nodes in the graph. `order` maps each node to its rank.
+Status EstimateMemoryEfficientOrder(
+    const GrapplerItem& item, std::unordered_map<const NodeDef*, int>* order);
+
 }  // namespace grappler
 }  // end namespace tensorflow
 
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
+#include <set>
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
@@ -159,6 +160,36 @@ TEST_F(StaticScheduleTest, RequiredTimes) {
   }
 }
 
+TEST_F(StaticScheduleTest, MemoryEfficientOrder) {
+  // Two branches that each allocate a large tensor and reduce it.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::RandomNormal(s.WithOpName("a"), {1000, 1000}, DT_FLOAT);
+  Output b = ops::RandomNormal(s.WithOpName("b"), {1000, 1000}, DT_FLOAT);
+  Output sum_a = ops::Sum(s.WithOpName("sum_a"), a, {0, 1});
+  Output sum_b = ops::Sum(s.WithOpName("sum_b"), b, {0, 1});
+  Output c = ops::Add(s.WithOpName("c"), sum_a, sum_b);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  std::unordered_map<const NodeDef*, int> order;
+  TF_EXPECT_OK(EstimateMemoryEfficientOrder(item, &order));
+  EXPECT_EQ(item.graph.node_size(), order.size());
+  std::unordered_map<string, int> ranks;
+  std::set<int> distinct_ranks;
+  for (const auto& node : order) {
+    ranks[node.first->name()] = node.second;
+    distinct_ranks.insert(node.second);
+  }
+  EXPECT_EQ(item.graph.node_size(), distinct_ranks.size());
+
+  // The first branch is reduced before the second one allocates its tensor.
+  EXPECT_LT(ranks["a"], ranks["sum_a"]);
+  EXPECT_LT(ranks["sum_a"], ranks["b"]);
+  EXPECT_LT(ranks["b"], ranks["sum_b"]);
+  EXPECT_LT(ranks["sum_b"], ranks["c"]);
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,191 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/autotune_cache.h"
+
+#include <cctype>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns the name of the model of the first CUDA GPU and of the cuDNN
+// version, e.g. "Tesla_V100-SXM2-16GB_cudnn7.1.4", or "" if there is no GPU.
+string PlatformKey() {
+  auto platform = se::MultiPlatformManager::PlatformWithName("CUDA");
+  if (!platform.ok() || platform.ValueOrDie()->VisibleDeviceCount() <= 0) {
+    return "";
+  }
+  auto executor = platform.ValueOrDie()->ExecutorForDevice(0);
+  if (!executor.ok()) return "";
+  se::StreamExecutor* stream_exec = executor.ValueOrDie();
+  string key = stream_exec->GetDeviceDescription().name();
+  if (stream_exec->AsDnn() != nullptr) {
+    auto version = stream_exec->AsDnn()->GetVersion();
+    if (version.ok()) {
+      strings::StrAppend(&key, "_cudnn", version.ValueOrDie().major_version(),
+                         ".", version.ValueOrDie().minor_version(), ".",
+                         version.ValueOrDie().patch());
+    }
+  }
+  for (char& c : key) {
+    if (!isalnum(c) && c != '.' && c != '-' && c != '_') c = '_';
+  }
+  return key;
+}
+
+}  // namespace
+
+/* static */
+PersistentAutoTuneCache* PersistentAutoTuneCache::Get(const string& name) {
+  struct Location {
+    string dir;
+    string platform_key;
+  };
+  static const Location* location = [] {
+    Location* location = new Location;
+    const char* dir = getenv("TF_AUTOTUNE_CACHE_DIR");
+    if (dir != nullptr && *dir != '\0') {
+      location->dir = dir;
+      location->platform_key = PlatformKey();
+    }
+    return location;
+  }();
+  if (location->dir.empty() || location->platform_key.empty()) {
+    return nullptr;
+  }
+
+  static mutex* mu = new mutex;
+  static auto* caches =
+      new std::map<string, std::unique_ptr<PersistentAutoTuneCache>>;
+  mutex_lock l(*mu);
+  std::unique_ptr<PersistentAutoTuneCache>& cache = (*caches)[name];
+  if (cache == nullptr) {
+    cache.reset(new PersistentAutoTuneCache(io::JoinPath(
+        location->dir, strings::StrCat(name, ".", location->platform_key))));
+  }
+  return cache.get();
+}
+
+PersistentAutoTuneCache::PersistentAutoTuneCache(const string& path)
+    : path_(path) {
+  mutex_lock l(mu_);
+  Status s = Load();
+  if (!s.ok() && !errors::IsNotFound(s)) {
+    LOG(WARNING) << "Failed to load the autotune cache " << path_ << ": " << s;
+  }
+  VLOG(1) << "Loaded " << entries_.size() << " autotune results from "
+          << path_;
+}
+
+bool PersistentAutoTuneCache::Lookup(const string& key, string* value) {
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return false;
+  *value = it->second;
+  return true;
+}
+
+void PersistentAutoTuneCache::Record(const string& key, const string& value) {
+  mutex_lock l(mu_);
+  entries_[key] = value;
+  // Pick up the results that other processes recorded in the meantime.
+  Status s = Load();
+  if (s.ok() || errors::IsNotFound(s)) {
+    s = Save();
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to save the autotune cache " << path_ << ": " << s;
+  }
+}
+
+Status PersistentAutoTuneCache::Load() {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path_, &contents));
+  for (StringPiece line : str_util::Split(contents, '\n')) {
+    const std::vector<string> fields = str_util::Split(line, '\t');
+    if (fields.size() != 2) continue;
+    entries_.insert({fields[0], fields[1]});
+  }
+  return Status::OK();
+}
+
+Status PersistentAutoTuneCache::Save() {
+  string contents;
+  for (const auto& entry : entries_) {
+    strings::StrAppend(&contents, entry.first, "\t", entry.second, "\n");
+  }
+  // Write to a temporary file first, so that readers never see a partially
+  // written cache.
+  const string tmp_path = strings::StrCat(path_, ".tmp", random::New64());
+  TF_RETURN_IF_ERROR(WriteStringToFile(Env::Default(), tmp_path, contents));
+  return Env::Default()->RenameFile(tmp_path, path_);
+}
+
+/* static */
+string AutoTuneConfigCodec<se::dnn::AlgorithmConfig>::Encode(
+    const se::dnn::AlgorithmConfig& config) {
+  return strings::StrCat(
+      config.algorithm().algo_id(), ",",
+      config.algorithm().tensor_ops_enabled() ? 1 : 0, ",",
+      config.algorithm_no_scratch().algo_id(), ",",
+      config.algorithm_no_scratch().tensor_ops_enabled() ? 1 : 0);
+}
+
+/* static */
+bool AutoTuneConfigCodec<se::dnn::AlgorithmConfig>::Decode(
+    const string& value, se::dnn::AlgorithmConfig* config) {
+  const std::vector<string> fields = str_util::Split(value, ',');
+  int64 algo_id, tensor_ops, no_scratch_algo_id, no_scratch_tensor_ops;
+  if (fields.size() != 4 || !strings::safe_strto64(fields[0], &algo_id) ||
+      !strings::safe_strto64(fields[1], &tensor_ops) ||
+      !strings::safe_strto64(fields[2], &no_scratch_algo_id) ||
+      !strings::safe_strto64(fields[3], &no_scratch_tensor_ops)) {
+    return false;
+  }
+  *config = se::dnn::AlgorithmConfig(
+      se::dnn::AlgorithmDesc(algo_id, tensor_ops != 0),
+      se::dnn::AlgorithmDesc(no_scratch_algo_id, no_scratch_tensor_ops != 0));
+  return true;
+}
+
+/* static */
+string AutoTuneConfigCodec<se::blas::AlgorithmConfig>::Encode(
+    const se::blas::AlgorithmConfig& config) {
+  return strings::StrCat(config.algorithm());
+}
+
+/* static */
+bool AutoTuneConfigCodec<se::blas::AlgorithmConfig>::Decode(
+    const string& value, se::blas::AlgorithmConfig* config) {
+  int64 algorithm;
+  if (!strings::safe_strto64(value, &algorithm)) return false;
+  *config = se::blas::AlgorithmConfig(algorithm);
+  return true;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,96 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_AUTOTUNE_CACHE_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Autotuning results that persist in a file, so that processes which run the
+// same models on the same kind of GPU skip the benchmarks that another
+// process, or an earlier run, already made, and pick the same algorithms.
+//
+// Caches live in the directory named by TF_AUTOTUNE_CACHE_DIR; nothing
+// persists if it is not set.  The cache named "name" is stored in
+// "<dir>/<name>.<platform>", where <platform> names the model of the first
+// GPU and the cuDNN version, since results do not carry over between them.
+// The directory may be shared between processes, e.g. on a network
+// filesystem: whenever a process records a result, it merges its results
+// with those in the file and atomically replaces the file.
+//
+// The file holds one "key<TAB>value" line per result.  Keys and values must
+// not contain tabs or newlines.
+class PersistentAutoTuneCache {
+ public:
+  // Returns the cache named "name", loading it the first time, or nullptr if
+  // TF_AUTOTUNE_CACHE_DIR is not set or there is no GPU.
+  static PersistentAutoTuneCache* Get(const string& name);
+
+  // Creates a cache stored in "path" and loads it.  Use Get() outside of
+  // tests.
+  explicit PersistentAutoTuneCache(const string& path);
+
+  // Looks up the value recorded for "key".
+  bool Lookup(const string& key, string* value);
+
+  // Records "value" for "key" and writes the cache to its file.
+  void Record(const string& key, const string& value);
+
+ private:
+  // Adds the entries of the file that are not in "entries_" yet.
+  Status Load() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status Save() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string path_;
+  mutex mu_;
+  std::unordered_map<string, string> entries_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PersistentAutoTuneCache);
+};
+
+// Encodes the configs of an AutoTuneMap for a PersistentAutoTuneCache.  Maps
+// whose Config type has no specialization are not persisted.
+template <typename Config>
+struct AutoTuneConfigCodec {
+  static constexpr bool kPersistent = false;
+  static string Encode(const Config& config) { return ""; }
+  static bool Decode(const string& value, Config* config) { return false; }
+};
+
+template <>
+struct AutoTuneConfigCodec<se::dnn::AlgorithmConfig> {
+  static constexpr bool kPersistent = true;
+  static string Encode(const se::dnn::AlgorithmConfig& config);
+  static bool Decode(const string& value, se::dnn::AlgorithmConfig* config);
+};
+
+template <>
+struct AutoTuneConfigCodec<se::blas::AlgorithmConfig> {
+  static constexpr bool kPersistent = true;
+  static string Encode(const se::blas::AlgorithmConfig& config);
+  static bool Decode(const string& value, se::blas::AlgorithmConfig* config);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_AUTOTUNE_CACHE_H_
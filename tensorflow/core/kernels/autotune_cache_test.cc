@@ -0,0 +1,79 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/autotune_cache.h"
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(PersistentAutoTuneCacheTest, ResultsPersist) {
+  const string path = io::JoinPath(testing::TmpDir(), "persist_cache");
+  {
+    PersistentAutoTuneCache cache(path);
+    string value;
+    EXPECT_FALSE(cache.Lookup("conv 1", &value));
+    cache.Record("conv 1", "3,1,-1,1");
+    cache.Record("conv 2", "5,0,5,0");
+    ASSERT_TRUE(cache.Lookup("conv 1", &value));
+    EXPECT_EQ("3,1,-1,1", value);
+  }
+  PersistentAutoTuneCache reloaded(path);
+  string value;
+  ASSERT_TRUE(reloaded.Lookup("conv 1", &value));
+  EXPECT_EQ("3,1,-1,1", value);
+  ASSERT_TRUE(reloaded.Lookup("conv 2", &value));
+  EXPECT_EQ("5,0,5,0", value);
+}
+
+TEST(PersistentAutoTuneCacheTest, MergesResultsOfOtherProcesses) {
+  const string path = io::JoinPath(testing::TmpDir(), "merge_cache");
+  PersistentAutoTuneCache first(path);
+  PersistentAutoTuneCache second(path);
+  first.Record("a", "1");
+  second.Record("b", "2");
+  first.Record("c", "3");
+
+  PersistentAutoTuneCache reloaded(path);
+  string value;
+  EXPECT_TRUE(reloaded.Lookup("a", &value));
+  EXPECT_TRUE(reloaded.Lookup("b", &value));
+  EXPECT_TRUE(reloaded.Lookup("c", &value));
+}
+
+TEST(AutoTuneConfigCodecTest, DnnAlgorithmConfig) {
+  typedef AutoTuneConfigCodec<se::dnn::AlgorithmConfig> Codec;
+  const se::dnn::AlgorithmConfig config(se::dnn::AlgorithmDesc(7, true),
+                                        se::dnn::AlgorithmDesc(2, false));
+  se::dnn::AlgorithmConfig decoded;
+  ASSERT_TRUE(Codec::Decode(Codec::Encode(config), &decoded));
+  EXPECT_EQ(config, decoded);
+  EXPECT_FALSE(Codec::Decode("7,1", &decoded));
+}
+
+TEST(AutoTuneConfigCodecTest, BlasAlgorithmConfig) {
+  typedef AutoTuneConfigCodec<se::blas::AlgorithmConfig> Codec;
+  const se::blas::AlgorithmConfig config(42);
+  se::blas::AlgorithmConfig decoded;
+  ASSERT_TRUE(Codec::Decode(Codec::Encode(config), &decoded));
+  EXPECT_EQ(config, decoded);
+  EXPECT_FALSE(Codec::Decode("x", &decoded));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
+#include <limits>
+
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -28,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -210,6 +214,7 @@ class BatchResource : public ResourceBase {
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
                        int32 batch_timeout_micros, int32 max_enqueued_batches,
                        const std::vector<int32>& allowed_batch_sizes,
+                       bool enable_ragged_batching,
                        FunctionLibraryRuntime::Handle fhandle,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
@@ -226,6 +231,7 @@ class BatchResource : public ResourceBase {
         batch_timeout_micros;
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
+    new_resource->enable_ragged_batching_ = enable_ragged_batching;
 
     new_resource->fhandle_ = fhandle;
 
@@ -327,13 +333,86 @@ class BatchResource : public ResourceBase {
     return batch_size;
   }
 
-  Status ConcatInputTensors(const Batch& batch, OpKernelContext* context,
+  // Returns the sizes of the sub-batches that a batch of 'batch_size' runs
+  // as. Without ragged batching this is the single padded size. With it, the
+  // batch may instead be split into several entries of 'allowed_batch_sizes_'
+  // (e.g. 48 as 32 + 16 rather than padded to 64), with any padding in the
+  // last one. Each sub-batch is charged its size in rows plus a fixed
+  // per-invocation overhead of half the smallest allowed size, and the
+  // cheapest split wins; ties go to fewer sub-batches.
+  std::vector<int64> SubBatchSizes(int batch_size) const {
+    if (!enable_ragged_batching_ || allowed_batch_sizes_.empty() ||
+        batch_size > allowed_batch_sizes_.back()) {
+      return {RoundToLowestAllowedBatchSize(batch_size)};
+    }
+    const int64 overhead =
+        std::max<int64>(1, allowed_batch_sizes_.front() / 2);
+    // cost[r] is the cheapest way to run r rows; first_size[r] the size of
+    // the first sub-batch in it.
+    std::vector<int64> cost(batch_size + 1, 0);
+    std::vector<int64> first_size(batch_size + 1, 0);
+    for (int rows = 1; rows <= batch_size; ++rows) {
+      cost[rows] = std::numeric_limits<int64>::max();
+      // Larger sizes first, so that a single padded sub-batch wins ties.
+      for (auto it = allowed_batch_sizes_.rbegin();
+           it != allowed_batch_sizes_.rend(); ++it) {
+        const int64 size = *it;
+        const int64 candidate =
+            size + overhead + (size >= rows ? 0 : cost[rows - size]);
+        if (candidate < cost[rows]) {
+          cost[rows] = candidate;
+          first_size[rows] = size;
+        }
+      }
+    }
+    std::vector<int64> sizes;
+    for (int64 rows = batch_size; rows > 0; rows -= first_size[rows]) {
+      sizes.push_back(first_size[rows]);
+    }
+    return sizes;
+  }
+
+  // Concatenates 'inputs' with the element type of the first one.
+  static Status ConcatTensors(OpKernelContext* context,
+                              const std::vector<Tensor>& inputs,
+                              Tensor* output) {
+    const DataType type = inputs[0].dtype();
+    switch (type) {
+#define CASE(type)                  \
+  case DataTypeToEnum<type>::value: \
+    return Concat<type>(context, inputs, output);
+      TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+      default:
+        return errors::InvalidArgument("Unsupported data type: ", type);
+    }
+  }
+
+  // Splits 'input' along its 0th dimension into pieces of 'sizes' rows.
+  static Status SplitTensor(OpKernelContext* context, const Tensor& input,
+                            const std::vector<int64>& sizes,
+                            std::vector<Tensor>* outputs) {
+    const DataType type = input.dtype();
+    switch (type) {
+#define CASE(type)                  \
+  case DataTypeToEnum<type>::value: \
+    return Split<type>(context, input, sizes, outputs);
+      TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+      default:
+        return errors::InvalidArgument("Unsupported data type: ", type);
+    }
+  }
+
+  // Concatenates the inputs of the tasks of 'batch', padded with copies of the
+  // first row up to 'padded_batch_size' rows.
+  Status ConcatInputTensors(const Batch& batch, int64 padded_batch_size,
+                            OpKernelContext* context,
                             std::vector<Tensor>* concatenated_tensors) const {
     if (batch.num_tasks() == 0) {
       return errors::InvalidArgument("Empty batch.");
     }
 
-    const int padded_batch_size = RoundToLowestAllowedBatchSize(batch.size());
     const int padding_amount = padded_batch_size - batch.size();
 
     // All tasks should have the same number of input edges.
@@ -404,8 +483,10 @@ class BatchResource : public ResourceBase {
     return Status::OK();
   }
 
+  // Splits 'combined_outputs', which have 'padded_batch_size' rows, into the
+  // outputs of the tasks of 'batch'.
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
-                            Batch* batch) const {
+                            int64 padded_batch_size, Batch* batch) const {
     DCHECK_GE(batch->num_tasks(), 1);
     if (batch->num_tasks() < 1) {
       return errors::Internal("Batch size expected to be positive; was ",
@@ -417,8 +498,7 @@ class BatchResource : public ResourceBase {
     for (int i = 0; i < batch->num_tasks(); ++i) {
       task_sizes_plus_optional_padding.push_back(batch->task(i).size());
     }
-    const int padding_size =
-        RoundToLowestAllowedBatchSize(batch->size()) - batch->size();
+    const int padding_size = padded_batch_size - batch->size();
     if (padding_size > 0) {
       task_sizes_plus_optional_padding.push_back(padding_size);
     }
@@ -501,12 +581,38 @@ class BatchResource : public ResourceBase {
       return;
     }
 
+    const std::vector<int64> sub_batch_sizes = SubBatchSizes(batch->size());
+    const int num_sub_batches = sub_batch_sizes.size();
+    int64 padded_batch_size = 0;
+    for (const int64 size : sub_batch_sizes) {
+      padded_batch_size += size;
+    }
     std::vector<Tensor> concatenated_tensors;
-    status =
-        ConcatInputTensors(*batch, last_task_context, &concatenated_tensors);
+    status = ConcatInputTensors(*batch, padded_batch_size, last_task_context,
+                                &concatenated_tensors);
     if (!status.ok()) {
       return;
     }
+
+    // The function arguments of each sub-batch.
+    const auto& captured_inputs =
+        batch->task(batch->num_tasks() - 1).captured_inputs;
+    std::vector<std::vector<Tensor>> sub_batch_args(num_sub_batches);
+    for (const Tensor& concatenated_tensor : concatenated_tensors) {
+      std::vector<Tensor> pieces;
+      status = SplitTensor(last_task_context, concatenated_tensor,
+                           sub_batch_sizes, &pieces);
+      if (!status.ok()) {
+        return;
+      }
+      for (int j = 0; j < num_sub_batches; ++j) {
+        sub_batch_args[j].push_back(pieces[j]);
+      }
+    }
+    for (std::vector<Tensor>& args : sub_batch_args) {
+      args.insert(args.end(), captured_inputs.begin(), captured_inputs.end());
+    }
+
     FunctionLibraryRuntime::Options opts;
     opts.step_id = last_task_context->step_id();
     opts.step_container = last_task_context->step_container();
@@ -516,35 +622,72 @@ class BatchResource : public ResourceBase {
     opts.runner = last_task_context->runner();
 
     auto* flib = last_task_context->function_library();
-    std::vector<Tensor> combined_outputs;
+    std::vector<std::vector<Tensor>> sub_batch_outputs(num_sub_batches);
+    mutex run_mu;
+    Status run_status;
+    std::atomic<int> pending_sub_batches(num_sub_batches);
     Notification done;
-    std::vector<Tensor> args(concatenated_tensors.begin(),
-                             concatenated_tensors.end());
-    const auto& captured_inputs =
-        batch->task(batch->num_tasks() - 1).captured_inputs;
-    args.insert(args.end(), captured_inputs.begin(), captured_inputs.end());
 
-    // Releases the cleanup method here, because the callback of the function
-    // library runtime will handle it now.
+    // Releases the cleanup method here, because the callback of the last
+    // sub-batch to finish will handle it now.
     finally.release();
-    flib->Run(
-        opts, fhandle_, args, &combined_outputs, [&](const Status& run_status) {
-          Status final_status;
-          auto run_finally = gtl::MakeCleanup([&]() {
-            // We do the cleanup here as an optimization, so that it runs in
-            // the underlying TF inter-op threadpool. Running it in the
-            // threadpool, let's the ensuing ops be scheduled faster,
-            // because the executor will add them to the front of the
-            // threadpool's task queue rather than the end.
-            cleanup_fn(final_status);
-            done.Notify();
+    for (int j = 0; j < num_sub_batches; ++j) {
+      // The sub-batches run concurrently.
+      flib->Run(
+          opts, fhandle_, sub_batch_args[j], &sub_batch_outputs[j],
+          [&](const Status& sub_batch_status) {
+            {
+              mutex_lock l(run_mu);
+              run_status.Update(sub_batch_status);
+            }
+            if (--pending_sub_batches > 0) {
+              return;
+            }
+            Status final_status;
+            auto run_finally = gtl::MakeCleanup([&]() {
+              // We do the cleanup here as an optimization, so that it runs in
+              // the underlying TF inter-op threadpool. Running it in the
+              // threadpool, let's the ensuing ops be scheduled faster,
+              // because the executor will add them to the front of the
+              // threadpool's task queue rather than the end.
+              cleanup_fn(final_status);
+              done.Notify();
+            });
+            {
+              mutex_lock l(run_mu);
+              final_status = run_status;
+            }
+            if (!final_status.ok()) {
+              return;
+            }
+            std::vector<Tensor> combined_outputs;
+            if (num_sub_batches == 1) {
+              combined_outputs = std::move(sub_batch_outputs[0]);
+            } else {
+              for (int i = 0; i < sub_batch_outputs[0].size(); ++i) {
+                std::vector<Tensor> to_concatenate;
+                for (int k = 0; k < num_sub_batches; ++k) {
+                  if (sub_batch_outputs[k].size() !=
+                      sub_batch_outputs[0].size()) {
+                    final_status = errors::Internal(
+                        "Sub-batches have different numbers of outputs");
+                    return;
+                  }
+                  to_concatenate.push_back(sub_batch_outputs[k][i]);
+                }
+                Tensor combined_output;
+                final_status = ConcatTensors(last_task_context, to_concatenate,
+                                             &combined_output);
+                if (!final_status.ok()) {
+                  return;
+                }
+                combined_outputs.push_back(combined_output);
+              }
+            }
+            final_status = SplitOutputTensors(combined_outputs,
+                                              padded_batch_size, batch.get());
           });
-          final_status = run_status;
-          if (!final_status.ok()) {
-            return;
-          }
-          final_status = SplitOutputTensors(combined_outputs, batch.get());
-        });
+    }
     // By waiting for the notification we are ensuring that this thread isn't
     // used for processing other batches, which gives the batches time to
     // coalesce upstream. So overall the number of batches going through the
@@ -569,8 +712,9 @@ class BatchResource : public ResourceBase {
     // All tasks should have the same number of input edges.
     const int num_input_edges = batch->task(0).inputs.size();
     std::vector<Tensor> concatenated_tensors;
-    const Status concat_status =
-        ConcatInputTensors(*batch, last_task_context, &concatenated_tensors);
+    const Status concat_status = ConcatInputTensors(
+        *batch, RoundToLowestAllowedBatchSize(batch->size()),
+        last_task_context, &concatenated_tensors);
     OP_REQUIRES_OK_ASYNC(last_task_context, concat_status, last_task_callback);
 
     // Process each input edge one at a time (the typical case has just one).
@@ -685,6 +829,7 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+  bool enable_ragged_batching_ = false;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -707,6 +852,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
                    c->GetAttr("max_enqueued_batches", &max_enqueued_batches_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(c, c->GetAttr("enable_ragged_batching",
+                                 &enable_ragged_batching_));
 
     auto lib = c->function_library();
     OP_REQUIRES(c, lib != nullptr, errors::Internal("No function library"));
@@ -726,7 +873,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(
           BatchResource::Create(num_batch_threads_, max_batch_size_,
                                 batch_timeout_micros_, max_enqueued_batches_,
-                                allowed_batch_sizes_, fhandle_, &new_resource));
+                                allowed_batch_sizes_, enable_ragged_batching_,
+                                fhandle_, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -772,6 +920,7 @@ class BatchFunctionKernel : public AsyncOpKernel {
   int32 batch_timeout_micros_;
   int32 max_enqueued_batches_;
   std::vector<int32> allowed_batch_sizes_;
+  bool enable_ragged_batching_;
   FunctionLibraryRuntime::Handle fhandle_;
 };
 
@@ -806,7 +955,8 @@ class BatchKernel : public AsyncOpKernel {
           std::unique_ptr<BatchResource> new_resource;
           TF_RETURN_IF_ERROR(BatchResource::Create(
               num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-              max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
+              max_enqueued_batches_, allowed_batch_sizes_,
+              /*enable_ragged_batching=*/false, kInvalidHandle,
               &new_resource));
           *r = new_resource.release();
           return Status::OK();
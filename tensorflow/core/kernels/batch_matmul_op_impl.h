@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/small_matmul.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -212,6 +213,26 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
         std::min(in_x.dim_size(1), in_x.dim_size(2)), out->dim_size(2));
     const int64 kMaxCostOuterParallelism = 128 * 128 * 256;  // heuristic.
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 m = out->dim_size(1);
+    const int64 n = out->dim_size(2);
+    const int64 k = in_x.dim_size(adj_x ? 1 : 2);
+    if (functor::IsSmallMatMul<Scalar>(m, n, k)) {
+      // Small products are computed inline, and only parallelized over the
+      // batch. They are real, so adjoints are transposes.
+      const Scalar* x = in_x.flat<Scalar>().data();
+      const Scalar* y = in_y.flat<Scalar>().data();
+      Scalar* z = out->flat<Scalar>().data();
+      Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+            cost_per_unit,
+            [x, y, z, m, n, k, adj_x, adj_y](int64 start, int64 limit) {
+              for (int64 i = start; i < limit; ++i) {
+                functor::SmallMatMul<Scalar>(x + i * m * k, y + i * k * n, m,
+                                             n, k, adj_x, adj_y,
+                                             z + i * m * n);
+              }
+            });
+      return;
+    }
     if (small_dim > 1 &&
         (batch_size == 1 || cost_per_unit > kMaxCostOuterParallelism)) {
       // Parallelize over inner dims.
@@ -191,6 +191,7 @@ class BasicBatchScheduler : public BatchScheduler<TaskType> {
   Status Schedule(std::unique_ptr<TaskType>* task) override;
   size_t NumEnqueuedTasks() const override;
   size_t SchedulingCapacity() const override;
+  size_t NumEnqueuedTasksWithPriority(int priority) const override;
 
   size_t max_task_size() const override {
     return shared_scheduler_queue_->max_task_size();
@@ -257,6 +258,12 @@ size_t BasicBatchScheduler<TaskType>::SchedulingCapacity() const {
   return shared_scheduler_queue_->SchedulingCapacity();
 }
 
+template <typename TaskType>
+size_t BasicBatchScheduler<TaskType>::NumEnqueuedTasksWithPriority(
+    int priority) const {
+  return shared_scheduler_queue_->NumEnqueuedTasksWithPriority(priority);
+}
+
 template <typename TaskType>
 BasicBatchScheduler<TaskType>::BasicBatchScheduler(
     std::unique_ptr<BatchScheduler<TaskType>> shared_scheduler_queue)
@@ -62,6 +62,17 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the time, in the microseconds of Env::NowMicros(), after which the
+  // result of the task is of no use (e.g. because the client gave up on the
+  // request), or 0 if the task has no deadline. Schedulers may drop tasks that
+  // are past their deadline instead of processing them.
+  virtual uint64 deadline_micros() const { return 0; }
+
+  // Returns the priority class of the task. Schedulers that support priority
+  // classes batch the tasks of each class separately, and process the batches
+  // of higher classes first.
+  virtual int priority() const { return 0; }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -179,6 +190,15 @@ class BatchScheduler {
   // the schedule (but being mindful about the caveats listed above).
   virtual size_t SchedulingCapacity() const = 0;
 
+  // Returns the number of enqueued tasks, with the same semantics as
+  // NumEnqueuedTasks(), of the priority class 'priority' (see
+  // BatchTask::priority()). Useful to export queue depth metrics per class.
+  // Schedulers that don't support priority classes treat all tasks as being
+  // in class 0.
+  virtual size_t NumEnqueuedTasksWithPriority(int priority) const {
+    return priority == 0 ? NumEnqueuedTasks() : 0;
+  }
+
   // Returns the maximum allowed size of tasks submitted to the scheduler. (This
   // is typically equal to a configured maximum batch size.)
   virtual size_t max_task_size() const = 0;
@@ -17,9 +17,12 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SHARED_BATCH_SCHEDULER_H_
 
 #include <stddef.h>
+#include <algorithm>
+#include <cmath>
 #include <deque>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -91,6 +94,13 @@ namespace serving {
 // For bulk processing jobs and throughput-oriented benchmarks, you may want to
 // set the maximum queue size to a large value.
 //
+// Within a queue, tasks of different priority classes (see
+// BatchTask::priority()) are placed in separate batches, and the batches of the
+// highest class are processed first. Tasks that are past their deadline (see
+// BatchTask::deadline_micros()) can be dropped instead of processed, see
+// QueueOptions::expired_task_callback, so that under overload the batch slots
+// go to requests that can still be answered in time.
+//
 // TODO(b/26539183): Support queue servicing policies other than round-robin.
 // E.g. let each queue specify a "share" (an int >= 1), so e.g. with queues A
 // and B having shares 1 and 2 respectively, the servicing pattern is ABBABB...
@@ -158,6 +168,30 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     size_t max_enqueued_batches = 10;
+
+    // If positive, a target for the 99th percentile of the latency of tasks,
+    // from their submission to the end of the processing of their batch, in
+    // microseconds. The queue then measures the time to process its batches as
+    // a function of their size, and adapts to the traffic:
+    //  - batches are closed at the largest size, up to 'max_batch_size', whose
+    //    estimated processing time fits in the target;
+    //  - instead of 'batch_timeout_micros', an open batch is closed when its
+    //    first task has waited for as long as the target leaves after the
+    //    estimated processing time of the batch.
+    // So batches grow to use the latency budget when requests are sparse, and
+    // shrink when batches are processed more slowly. 'batch_timeout_micros' is
+    // used until a few batches have been measured. The time that batches wait
+    // for a batch thread isn't part of the estimate, so the target only holds
+    // if batch threads are available, see the class documentation above.
+    int64 latency_target_micros = 0;
+
+    // If set, the tasks of a batch that are past their deadline (see
+    // BatchTask::deadline_micros()) when the batch is about to be processed
+    // are removed from it and handed to this callback, on the batch thread,
+    // which is responsible for failing them. Whether or not it is set,
+    // Schedule() rejects tasks that are already past their deadline with a
+    // DEADLINE_EXCEEDED error.
+    std::function<void(std::unique_ptr<TaskType>)> expired_task_callback;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -206,24 +240,74 @@ class SharedBatchScheduler
 
 namespace internal {
 
+// An online estimate of the time to process a batch as a function of its size,
+// for the 'latency_target_micros' queue option. The time is modeled as
+// 'intercept + slope * size', fitted by least squares to measurements whose
+// weights decay exponentially, so that the model follows changes in load.
+// Not thread-safe.
+class BatchProcessingTimeModel {
+ public:
+  // The weight of the previous measurements is multiplied by this factor when
+  // a measurement is added.
+  static constexpr double kDecay = 0.95;
+
+  // The number of measurements needed before HasEstimate() is true.
+  static constexpr int kMinMeasurements = 3;
+
+  void AddMeasurement(size_t batch_size, int64 processing_micros);
+
+  bool HasEstimate() const { return num_measurements_ >= kMinMeasurements; }
+
+  // Estimates the 99th percentile of the time to process a batch of size
+  // 'batch_size', assuming normally distributed deviations from the model.
+  double EstimateP99Micros(size_t batch_size) const;
+
+  // Returns the largest batch size in [1, max_batch_size] whose estimated 99th
+  // percentile processing time is at most 'budget_micros', or 1 if there is
+  // none.
+  size_t LargestBatchSizeWithin(double budget_micros,
+                                size_t max_batch_size) const;
+
+ private:
+  // Computes the mean processing time of a batch of size 'batch_size'.
+  double EstimateMeanMicros(double batch_size) const;
+
+  int num_measurements_ = 0;
+
+  // Decayed sums of the weights, sizes (x) and processing times (y).
+  double sum_weights_ = 0;
+  double sum_x_ = 0;
+  double sum_y_ = 0;
+  double sum_xx_ = 0;
+  double sum_xy_ = 0;
+
+  // Decayed mean of the squared deviations from the model.
+  double mean_squared_error_ = 0;
+};
+
 // A task queue for SharedBatchScheduler. Accepts tasks and accumulates them
 // into batches, and dispenses those batches to be processed via a "pull"
 // interface. The queue's behavior is governed by maximum batch size, timeout
 // and maximum queue length parameters; see their documentation in
 // SharedBatchScheduler.
 //
-// The queue is implemented as a deque of batches, with these invariants:
-//  - The number of batches is between 1 and 'options_.max_enqueued_batches'.
-//  - The back-most batch is open; the rest are closed.
+// The queue is implemented as a deque of batches per priority class, with
+// these invariants:
+//  - Each class has at least 1 batch. The back-most batch is open; the rest
+//    are closed, and not empty.
+//  - The number of non-empty batches over all classes is at most
+//    'options_.max_enqueued_batches'.
 //
-// Submitted tasks are added to the open batch. If that batch doesn't have room
-// but the queue isn't full, then that batch is closed and a new open batch is
-// started.
+// Submitted tasks are added to the open batch of their class. If that batch
+// doesn't have room but the queue isn't full, then that batch is closed and a
+// new open batch is started.
 //
-// Batch pull requests are handled by dequeuing the front-most batch if it is
-// closed. If the front-most batch is open (i.e. the queue contains only one
-// batch) and has reached the timeout, it is immediately closed and returned;
-// otherwise no batch is returned for the request.
+// Batch pull requests are handled by going through the classes from the
+// highest priority, and dequeuing the front-most batch of the first class whose
+// front-most batch is closed. If the front-most batch of a class is open (i.e.
+// the class contains only one batch) and has reached the timeout, it is
+// immediately closed and returned. If no class has a batch to process, no batch
+// is returned for the request.
 template <typename TaskType>
 class Queue {
  public:
@@ -246,9 +330,14 @@ class Queue {
   size_t NumEnqueuedTasks() const;
 
   // Returns the queue capacity, with the same semantics as
-  // BatchScheduler::SchedulingCapacity().
+  // BatchScheduler::SchedulingCapacity(). The capacity is that of the tasks of
+  // priority class 0.
   size_t SchedulingCapacity() const;
 
+  // Returns the number of enqueued tasks of a priority class, with the same
+  // semantics as BatchScheduler::NumEnqueuedTasksWithPriority().
+  size_t NumEnqueuedTasksWithPriority(int priority) const;
+
   // Returns the maximum allowed size of tasks submitted to the queue.
   size_t max_task_size() const { return options_.max_batch_size; }
 
@@ -274,16 +363,51 @@ class Queue {
   }
 
  private:
+  // The enqueued tasks of one priority class.
+  struct PriorityClass {
+    // The enqueued batches. See the invariants in the class comments above.
+    std::deque<std::unique_ptr<Batch<TaskType>>> batches;
+
+    // The time at which the first task was added to the open (back-most)
+    // batch in 'batches'. Valid iff that batch contains at least one task.
+    uint64 open_batch_start_time_micros = 0;
+  };
+
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  // Closes the open batch residing at the back of 'batches_', and inserts a
-  // fresh open batch behind it.
-  void StartNewBatch() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the class of priority 'priority', which is created with an empty
+  // open batch if it doesn't exist yet.
+  PriorityClass* GetPriorityClass(int priority) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  // Determines whether the open batch residing at the back of 'batches_' is
-  // currently schedulable.
-  bool IsOpenBatchSchedulable() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the number of non-empty batches over all the priority classes.
+  size_t NumNonEmptyBatches() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Closes the open batch residing at the back of 'priority_class->batches',
+  // and inserts a fresh open batch behind it.
+  void StartNewBatch(PriorityClass* priority_class)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Determines whether the open batch residing at the back of
+  // 'priority_class.batches' is currently schedulable.
+  bool IsOpenBatchSchedulable(const PriorityClass& priority_class) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // The size at which an open batch is closed: 'options_.max_batch_size', or
+  // less under a latency target.
+  size_t CurrentMaxBatchSize() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // How long the first task of the open batch of 'priority_class' may wait
+  // before the batch is closed: 'options_.batch_timeout_micros', or what the
+  // latency target leaves after processing the open batch.
+  int64 CurrentBatchTimeoutMicros(const PriorityClass& priority_class) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Hands the tasks of 'batch' that are past their deadline to
+  // 'options_.expired_task_callback', and returns a closed batch with the
+  // other ones.
+  std::unique_ptr<Batch<TaskType>> RemoveExpiredTasks(
+      std::unique_ptr<Batch<TaskType>> batch);
 
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
@@ -305,12 +429,9 @@ class Queue {
   // for the duration of this object's life.
   bool closed_ GUARDED_BY(mu_) = false;
 
-  // The enqueued batches. See the invariants in the class comments above.
-  std::deque<std::unique_ptr<Batch<TaskType>>> batches_ GUARDED_BY(mu_);
-
-  // The time at which the first task was added to the open (back-most) batch
-  // in 'batches_'. Valid iff that batch contains at least one task.
-  uint64 open_batch_start_time_micros_ GUARDED_BY(mu_);
+  // The enqueued batches of each priority class, from the highest priority.
+  std::map<int, PriorityClass, std::greater<int>> priority_classes_
+      GUARDED_BY(mu_);
 
   // Whether this queue contains a batch that is eligible to be scheduled. Used
   // to keep track of when to call 'schedulable_batch_callback_'.
@@ -320,6 +441,10 @@ class Queue {
   // Incremented in ScheduleBatch() and decremented in ProcessBatch().
   int num_batches_being_processed_ GUARDED_BY(mu_) = 0;
 
+  // The processing times of the batches, if 'options_.latency_target_micros'
+  // is set.
+  BatchProcessingTimeModel processing_time_model_ GUARDED_BY(mu_);
+
   // Used by CloseAndWaitUntilEmpty() to wait until the queue is empty, for the
   // case in which the queue is not empty when CloseAndWaitUntilEmpty() starts.
   // When ProcessBatch() dequeues the last batch and makes the queue empty, if
@@ -341,6 +466,7 @@ class QueueHandle : public BatchScheduler<TaskType> {
   Status Schedule(std::unique_ptr<TaskType>* task) override;
   size_t NumEnqueuedTasks() const override;
   size_t SchedulingCapacity() const override;
+  size_t NumEnqueuedTasksWithPriority(int priority) const override;
 
   size_t max_task_size() const override { return queue_->max_task_size(); }
 
@@ -408,6 +534,11 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.latency_target_micros < 0) {
+    return errors::InvalidArgument(
+        "latency_target_micros must be non-negative; was ",
+        options.latency_target_micros);
+  }
 
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
@@ -511,8 +642,9 @@ Queue<TaskType>::Queue(
       env_(env),
       process_batch_callback_(process_batch_callback),
       schedulable_batch_callback_(schedulable_batch_callback) {
-  // Create an initial, open batch.
-  batches_.emplace_back(new Batch<TaskType>);
+  // Create the default priority class, with an initial, open batch.
+  mutex_lock l(mu_);
+  GetPriorityClass(0);
 }
 
 template <typename TaskType>
@@ -520,8 +652,10 @@ Queue<TaskType>::~Queue() {
   mutex_lock l(mu_);
   DCHECK(IsEmptyInternal());
 
-  // Close the (empty) open batch, so its destructor doesn't block.
-  batches_.back()->Close();
+  // Close the (empty) open batches, so their destructors don't block.
+  for (auto& entry : priority_classes_) {
+    entry.second.batches.back()->Close();
+  }
 }
 
 template <typename TaskType>
@@ -532,27 +666,40 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    options_.max_batch_size);
   }
 
+  const uint64 deadline_micros = (*task)->deadline_micros();
+  if (deadline_micros != 0 && env_->NowMicros() >= deadline_micros) {
+    return errors::DeadlineExceeded(
+        "The task was submitted after its deadline");
+  }
+
   bool notify_of_schedulable_batch = false;
   {
     mutex_lock l(mu_);
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() > options_.max_batch_size) {
-      if (batches_.size() >= options_.max_enqueued_batches) {
-        return errors::Unavailable(
-            "The batch scheduling queue to which this task was submitted is "
-            "full");
-      }
-      StartNewBatch();
+    PriorityClass* priority_class = GetPriorityClass((*task)->priority());
+    auto& batches = priority_class->batches;
+    const bool open_batch_full =
+        !batches.back()->empty() &&
+        batches.back()->size() + (*task)->size() > CurrentMaxBatchSize();
+    // The task needs a batch of its own if the open batch is full or empty.
+    if ((open_batch_full || batches.back()->empty()) &&
+        NumNonEmptyBatches() >= options_.max_enqueued_batches) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full");
+    }
+    if (open_batch_full) {
+      StartNewBatch(priority_class);
     }
-    if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+    if (batches.back()->empty()) {
+      priority_class->open_batch_start_time_micros = env_->NowMicros();
     }
-    batches_.back()->AddTask(std::move(*task));
+    batches.back()->AddTask(std::move(*task));
 
     if (!schedulable_batch_) {
-      if (batches_.size() > 1 || IsOpenBatchSchedulable()) {
+      if (batches.size() > 1 || IsOpenBatchSchedulable(*priority_class)) {
         schedulable_batch_ = true;
         notify_of_schedulable_batch = true;
       }
@@ -570,7 +717,23 @@ template <typename TaskType>
 size_t Queue<TaskType>::NumEnqueuedTasks() const {
   mutex_lock l(mu_);
   size_t num_enqueued_tasks = 0;
-  for (const auto& batch : batches_) {
+  for (const auto& entry : priority_classes_) {
+    for (const auto& batch : entry.second.batches) {
+      num_enqueued_tasks += batch->num_tasks();
+    }
+  }
+  return num_enqueued_tasks;
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::NumEnqueuedTasksWithPriority(int priority) const {
+  mutex_lock l(mu_);
+  auto it = priority_classes_.find(priority);
+  if (it == priority_classes_.end()) {
+    return 0;
+  }
+  size_t num_enqueued_tasks = 0;
+  for (const auto& batch : it->second.batches) {
     num_enqueued_tasks += batch->num_tasks();
   }
   return num_enqueued_tasks;
@@ -579,10 +742,12 @@ size_t Queue<TaskType>::NumEnqueuedTasks() const {
 template <typename TaskType>
 size_t Queue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
+  const Batch<TaskType>& open_batch =
+      *priority_classes_.at(0).batches.back();
   const int num_new_batches_schedulable =
-      options_.max_enqueued_batches - batches_.size();
+      options_.max_enqueued_batches - NumNonEmptyBatches();
   const int open_batch_capacity =
-      options_.max_batch_size - batches_.back()->size();
+      open_batch.empty() ? 0 : options_.max_batch_size - open_batch.size();
   return (num_new_batches_schedulable * options_.max_batch_size) +
          open_batch_capacity;
 }
@@ -596,17 +761,24 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
   {
     mutex_lock l(mu_);
 
-    // Consider closing the open batch at this time, to schedule it.
-    if (batches_.size() == 1 && IsOpenBatchSchedulable()) {
-      StartNewBatch();
-    }
+    for (auto& entry : priority_classes_) {
+      PriorityClass* priority_class = &entry.second;
+      auto& batches = priority_class->batches;
 
-    if (batches_.size() >= 2) {
-      // There is at least one closed batch that is ready to be scheduled.
-      ++num_batches_being_processed_;
-      batch_to_schedule = std::move(batches_.front());
-      batches_.pop_front();
-    } else {
+      // Consider closing the open batch at this time, to schedule it.
+      if (batches.size() == 1 && IsOpenBatchSchedulable(*priority_class)) {
+        StartNewBatch(priority_class);
+      }
+
+      if (batches.size() >= 2) {
+        // There is at least one closed batch that is ready to be scheduled.
+        ++num_batches_being_processed_;
+        batch_to_schedule = std::move(batches.front());
+        batches.pop_front();
+        break;
+      }
+    }
+    if (batch_to_schedule == nullptr) {
       schedulable_batch_ = false;
     }
   }
@@ -616,10 +788,22 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 
 template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
-  process_batch_callback_(std::move(batch));
+  if (options_.expired_task_callback) {
+    batch = RemoveExpiredTasks(std::move(batch));
+  }
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
+  if (!batch->empty()) {
+    process_batch_callback_(std::move(batch));
+  }
+  const uint64 end_time_micros = env_->NowMicros();
 
   {
     mutex_lock l(mu_);
+    if (options_.latency_target_micros > 0 && batch_size > 0) {
+      processing_time_model_.AddMeasurement(
+          batch_size, end_time_micros - start_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -651,25 +835,168 @@ void Queue<TaskType>::CloseAndWaitUntilEmpty() {
 
 template <typename TaskType>
 bool Queue<TaskType>::IsEmptyInternal() const {
-  return num_batches_being_processed_ == 0 && batches_.size() == 1 &&
-         batches_.back()->empty();
+  return num_batches_being_processed_ == 0 && NumNonEmptyBatches() == 0;
+}
+
+template <typename TaskType>
+typename Queue<TaskType>::PriorityClass* Queue<TaskType>::GetPriorityClass(
+    int priority) {
+  PriorityClass* priority_class = &priority_classes_[priority];
+  if (priority_class->batches.empty()) {
+    priority_class->batches.emplace_back(new Batch<TaskType>);
+  }
+  return priority_class;
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::NumNonEmptyBatches() const {
+  size_t num_batches = 0;
+  for (const auto& entry : priority_classes_) {
+    const auto& batches = entry.second.batches;
+    num_batches += batches.size() - (batches.back()->empty() ? 1 : 0);
+  }
+  return num_batches;
 }
 
 template <typename TaskType>
-void Queue<TaskType>::StartNewBatch() {
-  batches_.back()->Close();
-  batches_.emplace_back(new Batch<TaskType>);
+void Queue<TaskType>::StartNewBatch(PriorityClass* priority_class) {
+  priority_class->batches.back()->Close();
+  priority_class->batches.emplace_back(new Batch<TaskType>);
 }
 
 template <typename TaskType>
-bool Queue<TaskType>::IsOpenBatchSchedulable() const {
-  Batch<TaskType>* open_batch = batches_.back().get();
+bool Queue<TaskType>::IsOpenBatchSchedulable(
+    const PriorityClass& priority_class) const {
+  Batch<TaskType>* open_batch = priority_class.batches.back().get();
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+  return closed_ || open_batch->size() >= CurrentMaxBatchSize() ||
+         env_->NowMicros() >= priority_class.open_batch_start_time_micros +
+                                  CurrentBatchTimeoutMicros(priority_class);
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::CurrentMaxBatchSize() const {
+  if (options_.latency_target_micros <= 0 ||
+      !processing_time_model_.HasEstimate()) {
+    return options_.max_batch_size;
+  }
+  return processing_time_model_.LargestBatchSizeWithin(
+      options_.latency_target_micros, options_.max_batch_size);
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::CurrentBatchTimeoutMicros(
+    const PriorityClass& priority_class) const {
+  if (options_.latency_target_micros <= 0 ||
+      !processing_time_model_.HasEstimate()) {
+    return options_.batch_timeout_micros;
+  }
+  const double slack_micros =
+      options_.latency_target_micros -
+      processing_time_model_.EstimateP99Micros(
+          priority_class.batches.back()->size());
+  return std::max<int64>(0, std::llround(slack_micros));
+}
+
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::RemoveExpiredTasks(
+    std::unique_ptr<Batch<TaskType>> batch) {
+  const uint64 now_micros = env_->NowMicros();
+  auto is_expired = [now_micros](const TaskType& task) {
+    return task.deadline_micros() != 0 && now_micros >= task.deadline_micros();
+  };
+  bool any_expired = false;
+  for (int i = 0; i < batch->num_tasks() && !any_expired; ++i) {
+    any_expired = is_expired(batch->task(i));
+  }
+  if (!any_expired) {
+    return batch;
+  }
+
+  // Batch only removes its last task, so take all of them out and put the
+  // unexpired ones back in order in a new batch.
+  std::vector<std::unique_ptr<TaskType>> tasks;
+  while (!batch->empty()) {
+    tasks.push_back(batch->RemoveTask());
+  }
+  std::unique_ptr<Batch<TaskType>> unexpired_batch(new Batch<TaskType>);
+  for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+    if (is_expired(**it)) {
+      options_.expired_task_callback(std::move(*it));
+    } else {
+      unexpired_batch->AddTask(std::move(*it));
+    }
+  }
+  unexpired_batch->Close();
+  return unexpired_batch;
+}
+
+inline void BatchProcessingTimeModel::AddMeasurement(size_t batch_size,
+                                                     int64 processing_micros) {
+  const double x = batch_size;
+  const double y = processing_micros;
+  if (HasEstimate()) {
+    const double error = y - EstimateMeanMicros(x);
+    mean_squared_error_ =
+        kDecay * mean_squared_error_ + (1 - kDecay) * error * error;
+  }
+  sum_weights_ = kDecay * sum_weights_ + 1;
+  sum_x_ = kDecay * sum_x_ + x;
+  sum_y_ = kDecay * sum_y_ + y;
+  sum_xx_ = kDecay * sum_xx_ + x * x;
+  sum_xy_ = kDecay * sum_xy_ + x * y;
+  ++num_measurements_;
+}
+
+inline double BatchProcessingTimeModel::EstimateMeanMicros(
+    double batch_size) const {
+  if (sum_weights_ == 0) {
+    return 0;
+  }
+  const double mean_x = sum_x_ / sum_weights_;
+  const double mean_y = sum_y_ / sum_weights_;
+  const double variance_x = sum_xx_ / sum_weights_ - mean_x * mean_x;
+  double slope;
+  if (variance_x > 1e-6 * mean_x * mean_x) {
+    slope = (sum_xy_ / sum_weights_ - mean_x * mean_y) / variance_x;
+  } else {
+    // All the batches had about the same size, which tells nothing about the
+    // fixed cost of a batch. Assume that the time is proportional to the size,
+    // which overestimates the time of larger batches.
+    slope = mean_x > 0 ? mean_y / mean_x : 0;
+  }
+  // A negative slope can only come from noise.
+  slope = std::max(0.0, slope);
+  const double intercept = std::max(0.0, mean_y - slope * mean_x);
+  return intercept + slope * batch_size;
+}
+
+inline double BatchProcessingTimeModel::EstimateP99Micros(
+    size_t batch_size) const {
+  // The 99th percentile of a normal distribution is 2.33 standard deviations
+  // above its mean.
+  const double kP99StandardDeviations = 2.33;
+  return EstimateMeanMicros(batch_size) +
+         kP99StandardDeviations * std::sqrt(mean_squared_error_);
+}
+
+inline size_t BatchProcessingTimeModel::LargestBatchSizeWithin(
+    double budget_micros, size_t max_batch_size) const {
+  // The estimate grows with the size, so binary search the largest size that
+  // fits.
+  size_t low = 1;
+  size_t high = max_batch_size;
+  while (low < high) {
+    const size_t mid = low + (high - low + 1) / 2;
+    if (EstimateP99Micros(mid) <= budget_micros) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low;
 }
 
 template <typename TaskType>
@@ -698,6 +1025,12 @@ size_t QueueHandle<TaskType>::SchedulingCapacity() const {
   return queue_->SchedulingCapacity();
 }
 
+template <typename TaskType>
+size_t QueueHandle<TaskType>::NumEnqueuedTasksWithPriority(
+    int priority) const {
+  return queue_->NumEnqueuedTasksWithPriority(priority);
+}
+
 }  // namespace internal
 
 }  // namespace serving
@@ -28,14 +28,21 @@ namespace {
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size) : size_(size) {}
+  explicit FakeTask(size_t size, int priority = 0, uint64 deadline_micros = 0)
+      : size_(size), priority_(priority), deadline_micros_(deadline_micros) {}
 
   ~FakeTask() override = default;
 
   size_t size() const override { return size_; }
 
+  int priority() const override { return priority_; }
+
+  uint64 deadline_micros() const override { return deadline_micros_; }
+
  private:
   const size_t size_;
+  const int priority_;
+  const uint64 deadline_micros_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
 };
@@ -591,6 +598,231 @@ TEST(SharedBatchSchedulerTest, QueueDestructorBlocksUntilAllTasksProcessed) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, ObeysLatencyTarget) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    // Processing a batch of size n takes 100 + 10 * n microseconds, so under a
+    // latency target of 1000 microseconds batches are capped at about 90.
+    std::vector<Notification> batch_processed(6);
+    std::vector<size_t> batch_sizes(batch_processed.size());
+    int current_batch = 0;
+    auto callback = [&env, &batch_processed, &batch_sizes,
+                     &current_batch](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      ASSERT_LT(current_batch, static_cast<int>(batch_processed.size()));
+      env.AdvanceByMicroseconds(100 + 10 * batch->size());
+      batch_sizes[current_batch] = batch->size();
+      batch_processed[current_batch].Notify();
+      ++current_batch;
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 100;
+    queue_options.batch_timeout_micros = 0;
+    queue_options.latency_target_micros = 1000;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // Until the processing time is estimated, 'batch_timeout_micros' applies.
+    for (int i = 0; i < 3; ++i) {
+      TF_ASSERT_OK(ScheduleTask(i + 1, queue.get()));
+      batch_processed[i].WaitForNotification();
+      EXPECT_EQ(i + 1, batch_sizes[i]);
+    }
+    // Let the queue record the processing time of the last batch, which it
+    // does after the callback returns.
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+
+    // A batch of 50 may wait 400 microseconds, but overflows at 90.
+    TF_ASSERT_OK(ScheduleTask(50, queue.get()));
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed[3].HasBeenNotified());
+    TF_ASSERT_OK(ScheduleTask(45, queue.get()));
+    batch_processed[3].WaitForNotification();
+    EXPECT_EQ(50, batch_sizes[3]);
+    // The batch of 45 waited for the first one to be processed, which used up
+    // its budget.
+    batch_processed[4].WaitForNotification();
+    EXPECT_EQ(45, batch_sizes[4]);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+
+    // A batch of 20 may wait 700 microseconds.
+    TF_ASSERT_OK(ScheduleTask(20, queue.get()));
+    env.AdvanceByMicroseconds(699);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed[5].HasBeenNotified());
+    env.AdvanceByMicroseconds(1);
+    batch_processed[5].WaitForNotification();
+    EXPECT_EQ(20, batch_sizes[5]);
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, ProcessesHigherPrioritiesFirst) {
+  Notification processing, proceed;
+  mutex mu;
+  std::vector<int> batch_priorities;
+  auto callback = [&processing, &proceed, &mu,
+                   &batch_priorities](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    const int priority = batch->task(0).priority();
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      EXPECT_EQ(priority, batch->task(i).priority());
+    }
+    {
+      mutex_lock l(mu);
+      batch_priorities.push_back(priority);
+    }
+    if (!processing.HasBeenNotified()) {
+      processing.Notify();
+    }
+    proceed.WaitForNotification();
+  };
+
+  SharedBatchScheduler<FakeTask>::Options options;
+  options.num_batch_threads = 1;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 2;
+  queue_options.batch_timeout_micros = 0;
+  queue_options.max_enqueued_batches = 3;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+  // Keep the thread busy while the tasks are enqueued.
+  TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+  processing.WaitForNotification();
+
+  for (const int priority : {0, 0, 2, 1}) {
+    std::unique_ptr<FakeTask> task(new FakeTask(1, priority));
+    TF_ASSERT_OK(queue->Schedule(&task));
+  }
+  EXPECT_EQ(4, queue->NumEnqueuedTasks());
+  EXPECT_EQ(2, queue->NumEnqueuedTasksWithPriority(0));
+  EXPECT_EQ(1, queue->NumEnqueuedTasksWithPriority(1));
+  EXPECT_EQ(1, queue->NumEnqueuedTasksWithPriority(2));
+  EXPECT_EQ(0, queue->NumEnqueuedTasksWithPriority(3));
+
+  // Each class takes one of the three batches, so the queue is full.
+  std::unique_ptr<FakeTask> task(new FakeTask(1, 3));
+  Status status = queue->Schedule(&task);
+  EXPECT_EQ(error::UNAVAILABLE, status.code());
+
+  proceed.Notify();
+  queue = nullptr;
+  EXPECT_EQ(std::vector<int>({0, 2, 1, 0}), batch_priorities);
+}
+
+TEST(SharedBatchSchedulerTest, DropsExpiredTasks) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification processing, proceed, second_batch_processed;
+    mutex mu;
+    std::vector<size_t> batch_sizes;
+    auto callback = [&processing, &proceed, &second_batch_processed, &mu,
+                     &batch_sizes](std::unique_ptr<Batch<FakeTask>> batch) {
+      {
+        mutex_lock l(mu);
+        batch_sizes.push_back(batch->size());
+      }
+      if (!processing.HasBeenNotified()) {
+        processing.Notify();
+        proceed.WaitForNotification();
+      } else {
+        second_batch_processed.Notify();
+      }
+    };
+    std::vector<size_t> expired_task_sizes;
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 0;
+    queue_options.expired_task_callback =
+        [&mu, &expired_task_sizes](std::unique_ptr<FakeTask> task) {
+          mutex_lock l(mu);
+          expired_task_sizes.push_back(task->size());
+        };
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    env.AdvanceByMicroseconds(100);
+    // A task past its deadline is rejected.
+    std::unique_ptr<FakeTask> late_task(new FakeTask(1, 0, 100));
+    Status status = queue->Schedule(&late_task);
+    EXPECT_EQ(error::DEADLINE_EXCEEDED, status.code());
+    EXPECT_NE(nullptr, late_task);
+
+    // Keep the thread busy while the deadlines of enqueued tasks pass.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    processing.WaitForNotification();
+    for (const auto& size_and_deadline :
+         std::vector<std::pair<size_t, uint64>>{{2, 110}, {3, 0}, {4, 200}}) {
+      std::unique_ptr<FakeTask> task(
+          new FakeTask(size_and_deadline.first, 0, size_and_deadline.second));
+      TF_ASSERT_OK(queue->Schedule(&task));
+    }
+    env.AdvanceByMicroseconds(10);
+    proceed.Notify();
+    second_batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(std::vector<size_t>({1, 7}), batch_sizes);
+      EXPECT_EQ(std::vector<size_t>({2}), expired_task_sizes);
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(BatchProcessingTimeModelTest, FitsLinearProcessingTime) {
+  internal::BatchProcessingTimeModel model;
+  model.AddMeasurement(1, 110);
+  model.AddMeasurement(4, 140);
+  EXPECT_FALSE(model.HasEstimate());
+  model.AddMeasurement(2, 120);
+  ASSERT_TRUE(model.HasEstimate());
+  EXPECT_NEAR(1100, model.EstimateP99Micros(100), 1e-3);
+  EXPECT_EQ(90, model.LargestBatchSizeWithin(1005, 1000));
+  EXPECT_EQ(50, model.LargestBatchSizeWithin(1000, 50));
+  EXPECT_EQ(1, model.LargestBatchSizeWithin(10, 50));
+
+  // Noise makes the 99th percentile estimate larger than the mean.
+  model.AddMeasurement(3, 180);
+  EXPECT_GT(model.EstimateP99Micros(3), 130);
+  EXPECT_LT(model.LargestBatchSizeWithin(1005, 1000), 90);
+}
+
+TEST(BatchProcessingTimeModelTest, SameSizeBatches) {
+  internal::BatchProcessingTimeModel model;
+  for (int i = 0; i < 3; ++i) {
+    model.AddMeasurement(8, 400);
+  }
+  // The time is assumed to be proportional to the size.
+  EXPECT_NEAR(800, model.EstimateP99Micros(16), 1e-3);
+  EXPECT_EQ(20, model.LargestBatchSizeWithin(1005, 100));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
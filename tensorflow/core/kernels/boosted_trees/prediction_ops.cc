@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -226,31 +227,23 @@ class BoostedTreesPredictOp : public OpKernel {
 
     const int32 last_tree = resource->num_trees() - 1;
 
-    auto do_work = [&resource, &batch_bucketized_features, &output_logits,
-                    batch_size, last_tree](int32 start, int32 end) {
-      for (int32 i = start; i < end; ++i) {
-        float tree_logit = 0.0;
-        int32 tree_id = 0;
-        int32 node_id = 0;
-        while (true) {
-          if (resource->is_leaf(tree_id, node_id)) {
-            tree_logit += resource->GetTreeWeight(tree_id) *
-                          resource->node_value(tree_id, node_id);
+    // Walks the examples through a flattened copy of the ensemble, which
+    // stays valid even if the ensemble is updated meanwhile.
+    std::shared_ptr<const FlatTreeEnsemble> flat_tree_ensemble;
+    {
+      tf_shared_lock l(*resource->get_mutex());
+      flat_tree_ensemble = resource->GetFlatTreeEnsemble();
+    }
+    std::vector<const int32*> bucketized_features;
+    bucketized_features.reserve(batch_bucketized_features.size());
+    for (const auto& features : batch_bucketized_features) {
+      bucketized_features.push_back(features.data());
+    }
+    float* const logits = output_logits.data();
 
-            // Stop if it was the last tree.
-            if (tree_id == last_tree) {
-              break;
-            }
-            // Move onto other trees.
-            ++tree_id;
-            node_id = 0;
-          } else {
-            node_id = resource->next_node(tree_id, node_id, i,
-                                          batch_bucketized_features);
-          }
-        }
-        output_logits(i, 0) = tree_logit;
-      }
+    auto do_work = [&flat_tree_ensemble, &bucketized_features, logits](
+                       int32 start, int32 end) {
+      flat_tree_ensemble->Predict(bucketized_features, start, end, logits);
     };
     // 10 is the magic number. The actual number might depend on (the number of
     // layers in the trees) and (cpu cycles spent on each layer), but this
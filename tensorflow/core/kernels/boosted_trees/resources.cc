@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/boosted_trees/resources.h"
+
+#include <algorithm>
+#include <deque>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -23,6 +27,92 @@ namespace tensorflow {
 
 namespace {
 constexpr float kLayerByLayerTreeWeight = 1.0;
+
+// Examples are walked through each tree in blocks of this size, so that the
+// steps of different examples are independent and can overlap.
+constexpr int32 kFlatPredictBlockSize = 16;
+}  // namespace
+
+void FlatTreeEnsemble::Predict(
+    const std::vector<const int32*>& bucketized_features, const int32 start,
+    const int32 end, float* logits) const {
+  int32 node_ids[kFlatPredictBlockSize];
+  for (int32 block_start = start; block_start < end;
+       block_start += kFlatPredictBlockSize) {
+    const int32 block_size =
+        std::min(end - block_start, kFlatPredictBlockSize);
+    float* const block_logits = logits + block_start;
+    std::fill(block_logits, block_logits + block_size, 0.0f);
+    for (size_t tree = 0; tree < roots.size(); ++tree) {
+      std::fill(node_ids, node_ids + block_size, roots[tree]);
+      for (int32 level = 0; level < depths[tree]; ++level) {
+        for (int32 i = 0; i < block_size; ++i) {
+          const int32 node_id = node_ids[i];
+          const int32 bucket =
+              bucketized_features[feature_ids[node_id]][block_start + i];
+          node_ids[i] = bucket <= thresholds[node_id] ? left_ids[node_id]
+                                                      : right_ids[node_id];
+        }
+      }
+      for (int32 i = 0; i < block_size; ++i) {
+        block_logits[i] += weighted_values[node_ids[i]];
+      }
+    }
+  }
+}
+
+namespace {
+
+// Appends the nodes of 'tree' to 'flat', and its root and depth.
+void FlattenTree(const boosted_trees::Tree& tree, const float weight,
+                 FlatTreeEnsemble* flat) {
+  const int32 offset = flat->feature_ids.size();
+  int32 depth = 0;
+  if (tree.nodes_size() > 0) {
+    std::vector<int32> node_depths(tree.nodes_size(), 0);
+    std::deque<int32> queue = {0};
+    while (!queue.empty()) {
+      const int32 node_id = queue.front();
+      queue.pop_front();
+      const auto& node = tree.nodes(node_id);
+      if (node.node_case() != boosted_trees::Node::kBucketizedSplit) continue;
+      const auto& split = node.bucketized_split();
+      for (const int32 child_id : {split.left_id(), split.right_id()}) {
+        node_depths[child_id] = node_depths[node_id] + 1;
+        depth = std::max(depth, node_depths[child_id]);
+        queue.push_back(child_id);
+      }
+    }
+  }
+  for (int32 node_id = 0; node_id < tree.nodes_size(); ++node_id) {
+    const auto& node = tree.nodes(node_id);
+    if (node.node_case() == boosted_trees::Node::kBucketizedSplit) {
+      const auto& split = node.bucketized_split();
+      flat->feature_ids.push_back(split.feature_id());
+      flat->thresholds.push_back(split.threshold());
+      flat->left_ids.push_back(offset + split.left_id());
+      flat->right_ids.push_back(offset + split.right_id());
+      flat->weighted_values.push_back(0.0f);
+    } else {
+      flat->feature_ids.push_back(0);
+      flat->thresholds.push_back(0);
+      flat->left_ids.push_back(offset + node_id);
+      flat->right_ids.push_back(offset + node_id);
+      flat->weighted_values.push_back(weight * node.leaf().scalar());
+    }
+  }
+  if (tree.nodes_size() == 0) {
+    // An empty tree predicts zero.
+    flat->feature_ids.push_back(0);
+    flat->thresholds.push_back(0);
+    flat->left_ids.push_back(offset);
+    flat->right_ids.push_back(offset);
+    flat->weighted_values.push_back(0.0f);
+  }
+  flat->roots.push_back(offset);
+  flat->depths.push_back(depth);
+}
+
 }  // namespace
 
 // Constructor.
@@ -263,6 +353,10 @@ void BoostedTreesEnsembleResource::AddBucketizedSplitNode(
 void BoostedTreesEnsembleResource::Reset() {
   // Reset stamp.
   set_stamp(-1);
+  {
+    mutex_lock l(flat_mu_);
+    flat_tree_ensemble_.reset();
+  }
 
   // Clear tree ensemle.
   arena_.Reset();
@@ -271,6 +365,24 @@ void BoostedTreesEnsembleResource::Reset() {
       protobuf::Arena::CreateMessage<boosted_trees::TreeEnsemble>(&arena_);
 }
 
+std::shared_ptr<const FlatTreeEnsemble>
+BoostedTreesEnsembleResource::GetFlatTreeEnsemble() {
+  mutex_lock l(flat_mu_);
+  // Every change to the ensemble comes with a new stamp or a Reset().
+  if (flat_tree_ensemble_ == nullptr || flat_stamp_ != stamp()) {
+    std::shared_ptr<FlatTreeEnsemble> flat =
+        std::make_shared<FlatTreeEnsemble>();
+    for (int32 tree_id = 0; tree_id < tree_ensemble_->trees_size();
+         ++tree_id) {
+      FlattenTree(tree_ensemble_->trees(tree_id), GetTreeWeight(tree_id),
+                  flat.get());
+    }
+    flat_tree_ensemble_ = std::move(flat);
+    flat_stamp_ = stamp();
+  }
+  return flat_tree_ensemble_;
+}
+
 void BoostedTreesEnsembleResource::PostPruneTree(const int32 current_tree) {
   // No-op if tree is empty.
   auto* tree = tree_ensemble_->mutable_trees(current_tree);
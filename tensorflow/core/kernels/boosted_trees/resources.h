@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 #define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -43,6 +46,29 @@ class StampedResource : public ResourceBase {
   int64 stamp_;
 };
 
+// An immutable copy of a tree ensemble laid out for fast inference. The nodes
+// of all the trees are stored in parallel arrays, and a leaf is a split on
+// feature 0 whose children are the leaf itself, so that every example can
+// take the same number of branch-free steps through a tree.
+struct FlatTreeEnsemble {
+  // Per node, indexed by the position of the node in the ensemble.
+  std::vector<int32> feature_ids;
+  std::vector<int32> thresholds;
+  std::vector<int32> left_ids;
+  std::vector<int32> right_ids;
+  // The values of the leaves, multiplied by the weights of their trees.
+  std::vector<float> weighted_values;
+
+  // Per tree, the position of the root and the number of levels below it.
+  std::vector<int32> roots;
+  std::vector<int32> depths;
+
+  // Sums the weighted leaf values that the examples in [start, end) reach in
+  // all the trees into logits[start, end).
+  void Predict(const std::vector<const int32*>& bucketized_features,
+               int32 start, int32 end, float* logits) const;
+};
+
 // Keep a tree ensemble in memory for efficient evaluation and mutation.
 class BoostedTreesEnsembleResource : public StampedResource {
  public:
@@ -143,6 +169,11 @@ class BoostedTreesEnsembleResource : public StampedResource {
                               float* logit_update) const;
   mutex* get_mutex() { return &mu_; }
 
+  // Returns the flattened copy of the current ensemble, and builds it if the
+  // ensemble changed since the last call.
+  // Caller needs to hold the mutex lock, shared or not, while calling this.
+  std::shared_ptr<const FlatTreeEnsemble> GetFlatTreeEnsemble();
+
  private:
   // Helper method to check whether a node is a terminal node in that it
   // only has leaf nodes as children.
@@ -166,6 +197,14 @@ class BoostedTreesEnsembleResource : public StampedResource {
   protobuf::Arena arena_;
   mutex mu_;
   boosted_trees::TreeEnsemble* tree_ensemble_;
+
+ private:
+  mutex flat_mu_;
+  // Built from the ensemble with stamp 'flat_stamp_'. Null until the first
+  // call to GetFlatTreeEnsemble() after a Reset().
+  std::shared_ptr<const FlatTreeEnsemble> flat_tree_ensemble_
+      GUARDED_BY(flat_mu_);
+  int64 flat_stamp_ GUARDED_BY(flat_mu_) = -1;
 };
 
 }  // namespace tensorflow
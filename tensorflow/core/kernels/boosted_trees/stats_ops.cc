@@ -15,9 +15,13 @@ limitations under the License.
 
 #include <vector>
 
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -243,17 +247,59 @@ class BoostedTreesMakeStatsSummaryOp : public OpKernel {
     auto temp_stats_double = temp_stats_double_t.tensor<double, 4>();
     temp_stats_double.setZero();
 
-    // Partition by node, and then bucketize.
-    for (int feature_idx = 0; feature_idx < num_features_; ++feature_idx) {
-      const auto& features = bucketized_features_list[feature_idx].vec<int32>();
-      for (int i = 0; i < batch_size; ++i) {
-        const int32 node = node_ids(i);
-        const int32 bucket = features(i);
-        temp_stats_double(feature_idx, node, bucket, 0) += gradients(i, 0);
-        temp_stats_double(feature_idx, node, bucket, 1) += hessians(i, 0);
+    // Partition the examples by node, so that each histogram is accumulated
+    // in a single pass over the examples of its node while it stays in cache.
+    std::vector<int64> node_starts(max_splits_ + 1, 0);
+    for (int64 i = 0; i < batch_size; ++i) {
+      const int32 node = node_ids(i);
+      OP_REQUIRES(context, node >= 0 && node < max_splits_,
+                  errors::InvalidArgument("Node id ", node,
+                                          " is out of range [0, ", max_splits_,
+                                          ")."));
+      ++node_starts[node + 1];
+    }
+    for (int node = 0; node < max_splits_; ++node) {
+      node_starts[node + 1] += node_starts[node];
+    }
+    std::vector<int64> sorted_examples(batch_size);
+    std::vector<float> sorted_gradients(batch_size);
+    std::vector<float> sorted_hessians(batch_size);
+    {
+      std::vector<int64> positions(node_starts.begin(), node_starts.end() - 1);
+      for (int64 i = 0; i < batch_size; ++i) {
+        const int64 position = positions[node_ids(i)]++;
+        sorted_examples[position] = i;
+        sorted_gradients[position] = gradients(i, 0);
+        sorted_hessians[position] = hessians(i, 0);
       }
     }
 
+    // Each feature owns a slice of the stats, so features are bucketized in
+    // parallel.
+    auto do_work = [this, &bucketized_features_list, &node_starts,
+                    &sorted_examples, &sorted_gradients, &sorted_hessians,
+                    &temp_stats_double](int64 begin, int64 end) {
+      for (int64 feature_idx = begin; feature_idx < end; ++feature_idx) {
+        const auto features =
+            bucketized_features_list[feature_idx].vec<int32>();
+        for (int node = 0; node < max_splits_; ++node) {
+          double* const histogram = &temp_stats_double(feature_idx, node, 0, 0);
+          for (int64 position = node_starts[node];
+               position < node_starts[node + 1]; ++position) {
+            const int32 bucket = features(sorted_examples[position]);
+            histogram[2 * bucket] += sorted_gradients[position];
+            histogram[2 * bucket + 1] += sorted_hessians[position];
+          }
+        }
+      }
+    };
+    // Reading an example and updating its bucket costs about 10 cycles.
+    const int64 cost = batch_size * 10;
+    thread::ThreadPool* const worker_threads =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
+    Shard(worker_threads->NumThreads(), worker_threads, num_features_,
+          /*cost_per_unit=*/cost, do_work);
+
     // Copy temp tensor over to output tensor.
     Tensor* output_stats_summary_t = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(
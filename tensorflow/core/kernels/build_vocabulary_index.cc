@@ -0,0 +1,42 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes the index file of a vocabulary file, for the VocabularyIndexTable op:
+//
+//   build_vocabulary_index <vocabulary_file> <index_file>
+
+#include "tensorflow/core/kernels/vocabulary_index.h"
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+
+int main(int argc, char* argv[]) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  if (argc != 3) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <vocabulary_file> <index_file>";
+    return 1;
+  }
+  tensorflow::Status status =
+      tensorflow::lookup::WriteVocabularyIndexFromTextFile(
+          tensorflow::Env::Default(), argv[1], argv[2]);
+  if (!status.ok()) {
+    LOG(ERROR) << "Error indexing '" << argv[1] << "': " << status;
+    return 1;
+  }
+  LOG(INFO) << "Wrote vocabulary index to " << argv[2];
+  return 0;
+}
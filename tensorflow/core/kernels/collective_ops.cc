@@ -74,6 +74,9 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
     OP_REQUIRES_OK(
         c, c->GetAttr("subdiv_offsets",
                       &col_params_.instance.impl_details.subdiv_offsets));
+    OP_REQUIRES_OK(c,
+                   c->GetAttr("hierarchical",
+                              &col_params_.instance.impl_details.hierarchical));
     string merge_op_name;
     OP_REQUIRES_OK(c, c->GetAttr("merge_op", &merge_op_name));
     OP_REQUIRES(c, merge_op_name == "Add" || merge_op_name == "Mul",
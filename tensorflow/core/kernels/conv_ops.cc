@@ -25,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/conv_ops.h"
 
 #include <string.h>
+#include <array>
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -37,13 +39,17 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
+#include "tensorflow/core/kernels/direct_conv2d.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/padding.h"
 #include "tensorflow/core/util/tensor_format.h"
 #include "tensorflow/core/util/use_cudnn.h"
@@ -196,6 +202,144 @@ class LaunchDeepConvOp<CPUDevice, float> {
   }
 };
 
+// The CPU algorithms that Conv2D chooses between by timing them, when the
+// TF_CPU_CONV_USE_AUTOTUNE environment variable is set.
+enum class CpuConv2DAlgorithm { kGeneric, kDeepConv2D, kDirectConv2D };
+
+// The shape, strides and dilations of a CPU convolution, for which the
+// fastest algorithm is cached.
+class CpuConv2DParameters {
+ public:
+  CpuConv2DParameters(const Conv2DArgs& args, int stride_rows, int stride_cols,
+                      int dilation_rows, int dilation_cols)
+      : values_{{args.batch, args.in_rows, args.in_cols, args.in_depth,
+                 args.filter_rows, args.filter_cols, args.pad_rows,
+                 args.pad_cols, args.out_rows, args.out_cols, args.out_depth,
+                 stride_rows, stride_cols, dilation_rows, dilation_cols}} {}
+
+  bool operator<(const CpuConv2DParameters& other) const {
+    return values_ < other.values_;
+  }
+
+  string ToString() const { return str_util::Join(values_, ", "); }
+
+ private:
+  std::array<int, 15> values_;
+};
+
+// The fastest algorithms found for the CPU convolutions run so far.
+class CpuConv2DAutotuneMap {
+ public:
+  static CpuConv2DAutotuneMap* Get() {
+    static CpuConv2DAutotuneMap* map = new CpuConv2DAutotuneMap;
+    return map;
+  }
+
+  bool Find(const CpuConv2DParameters& params, CpuConv2DAlgorithm* algorithm) {
+    mutex_lock lock(mu_);
+    auto it = algorithms_.find(params);
+    if (it == algorithms_.end()) return false;
+    *algorithm = it->second;
+    return true;
+  }
+
+  void Insert(const CpuConv2DParameters& params,
+              CpuConv2DAlgorithm algorithm) {
+    mutex_lock lock(mu_);
+    algorithms_[params] = algorithm;
+  }
+
+ private:
+  mutex mu_;
+  std::map<CpuConv2DParameters, CpuConv2DAlgorithm> algorithms_
+      GUARDED_BY(mu_);
+};
+
+template <typename Device, typename T>
+class LaunchAutotunedConvOp {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, const Conv2DArgs& args,
+                  int dilation_rows, int dilation_cols, int stride_rows,
+                  int stride_cols, const Padding& padding, Tensor* output,
+                  TensorFormat data_format) {
+    return false;
+  }
+};
+
+// Runs the fastest of the generic, DeepConv2D (Winograd) and DirectConv2D
+// algorithms that can compute the convolution. The first convolution of each
+// shape runs all of them, timing each, and the output is the one of the last.
+template <>
+class LaunchAutotunedConvOp<CPUDevice, float> {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, const Conv2DArgs& args,
+                  int dilation_rows, int dilation_cols, int stride_rows,
+                  int stride_cols, const Padding& padding, Tensor* output,
+                  TensorFormat data_format) {
+    if (data_format != FORMAT_NHWC || args.in_depth != filter.dim_size(2)) {
+      return false;
+    }
+    std::vector<CpuConv2DAlgorithm> algorithms = {
+        CpuConv2DAlgorithm::kGeneric};
+    if (dilation_rows == 1 && dilation_cols == 1 &&
+        IsDeepConv2DSupported(stride_rows, stride_cols, args.filter_rows,
+                              args.filter_cols)) {
+      algorithms.push_back(CpuConv2DAlgorithm::kDeepConv2D);
+    }
+    if (CanUseDirectConv2D(args.in_depth)) {
+      algorithms.push_back(CpuConv2DAlgorithm::kDirectConv2D);
+    }
+    if (algorithms.size() == 1) return false;
+
+    auto run = [&](CpuConv2DAlgorithm algorithm) {
+      switch (algorithm) {
+        case CpuConv2DAlgorithm::kGeneric:
+          LaunchGeneric<CPUDevice, float>()(
+              ctx, input, filter, stride_rows, stride_cols, dilation_rows,
+              dilation_cols, padding, output, data_format);
+          break;
+        case CpuConv2DAlgorithm::kDeepConv2D:
+          functor::DeepConv2D<CPUDevice, float>()(
+              ctx, args, input.flat<float>().data(),
+              filter.flat<float>().data(), output->flat<float>().data());
+          break;
+        case CpuConv2DAlgorithm::kDirectConv2D:
+          functor::DirectConv2D<CPUDevice, float>()(
+              ctx, args, stride_rows, stride_cols, dilation_rows,
+              dilation_cols, input.flat<float>().data(),
+              filter.flat<float>().data(), output->flat<float>().data());
+          break;
+      }
+    };
+
+    const CpuConv2DParameters params(args, stride_rows, stride_cols,
+                                     dilation_rows, dilation_cols);
+    CpuConv2DAlgorithm best_algorithm;
+    if (CpuConv2DAutotuneMap::Get()->Find(params, &best_algorithm)) {
+      run(best_algorithm);
+      return true;
+    }
+    uint64 best_time = std::numeric_limits<uint64>::max();
+    for (CpuConv2DAlgorithm algorithm : algorithms) {
+      const uint64 start = Env::Default()->NowMicros();
+      run(algorithm);
+      if (!ctx->status().ok()) return true;
+      const uint64 time = Env::Default()->NowMicros() - start;
+      if (time < best_time) {
+        best_time = time;
+        best_algorithm = algorithm;
+      }
+    }
+    VLOG(1) << "Conv2D autotune: " << params.ToString() << " -> algorithm "
+            << static_cast<int>(best_algorithm) << " in " << best_time
+            << " us";
+    CpuConv2DAutotuneMap::Get()->Insert(params, best_algorithm);
+    return true;
+  }
+};
+
 #ifdef TENSORFLOW_USE_LIBXSMM_CONVOLUTIONS
 template <typename Device, typename T>
 class LaunchXsmmConvOp {
@@ -307,6 +451,8 @@ class Conv2DOp : public BinaryOp<T> {
         context, dilation_h > 0 && dilation_w > 0,
         errors::InvalidArgument("Dilated rates should be larger than 0."));
     OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    OP_REQUIRES_OK(context, ReadBoolFromEnvVar("TF_CPU_CONV_USE_AUTOTUNE",
+                                               false, &cpu_use_autotune_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -424,6 +570,26 @@ class Conv2DOp : public BinaryOp<T> {
     }
 #endif
 
+    if (cpu_use_autotune_) {
+      Conv2DArgs args;
+      args.batch = batch;
+      args.in_rows = input_rows;
+      args.in_cols = input_cols;
+      args.in_depth = in_depth;
+      args.filter_rows = filter_rows;
+      args.filter_cols = filter_cols;
+      args.pad_rows = pad_rows;
+      args.pad_cols = pad_cols;
+      args.out_rows = out_rows;
+      args.out_cols = out_cols;
+      args.out_depth = out_depth;
+      if (LaunchAutotunedConvOp<Device, T>::Run(
+              context, input, filter, args, dilation_rows, dilation_cols,
+              stride_rows, stride_cols, padding_, output, data_format_)) {
+        return;
+      }
+    }
+
     if (LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, batch, input_rows, input_cols, in_depth,
             filter_rows, filter_cols, pad_rows, pad_cols, out_rows, out_cols,
@@ -445,6 +611,7 @@ class Conv2DOp : public BinaryOp<T> {
   TensorFormat data_format_;
   LaunchConv2DOp<Device, T> launcher_;
   bool cudnn_use_autotune_;
+  bool cpu_use_autotune_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/ctc/ctc_beam_search.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -259,6 +260,10 @@ class CTCBeamSearchDecoderOp : public OpKernel {
   explicit CTCBeamSearchDecoderOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("merge_repeated", &merge_repeated_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("beam_width", &beam_width_));
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("label_selection_size", &label_selection_size_));
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("label_selection_margin", &label_selection_margin_));
     int top_paths;
     OP_REQUIRES_OK(ctx, ctx->GetAttr("top_paths", &top_paths));
     decode_helper_.SetTopPaths(top_paths);
@@ -298,35 +303,52 @@ class CTCBeamSearchDecoderOp : public OpKernel {
                                 batch_size, num_classes);
     }
 
-    ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
-                                            &beam_scorer_, 1 /* batch_size */,
-                                            merge_repeated_);
-    Tensor input_chip(DT_FLOAT, TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<float>();
-
-    std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<float> log_probs;
-
     // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi =
-            Eigen::Map<const Eigen::ArrayXf>(input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
-      }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
+    const int top_paths = decode_helper_.GetTopPaths();
+    std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
+    mutex mu;
+    Status decode_status;
 
-      beam_search.Reset();
+    // Each shard decodes its batch entries with its own decoder, which it
+    // resets between them. The default beam scorer has no state, so the
+    // shards share it.
+    auto decode = [&](const int64 begin, const int64 end) {
+      ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
+                                              &beam_scorer_, 1 /* batch_size */,
+                                              merge_repeated_);
+      beam_search.SetLabelSelectionParameters(label_selection_size_,
+                                              label_selection_margin_);
+      std::vector<float> log_probs;
+      for (int64 b = begin; b < end; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(top_paths);
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          // Row b of the time step is contiguous, so it's decoded in place.
+          auto input_bi = Eigen::Map<const Eigen::ArrayXf>(
+              input_list_t[t].data() + b * num_classes, num_classes);
+          beam_search.Step(input_bi);
+        }
+        Status s = beam_search.TopPaths(top_paths, &best_paths_b, &log_probs,
+                                        merge_repeated_);
+        beam_search.Reset();
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          decode_status.Update(s);
+          return;
+        }
 
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+        for (int bp = 0; bp < top_paths; ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
-    }
+    };
+
+    const int64 kCostPerUnit = 50 * max_time * num_classes * beam_width_;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          kCostPerUnit, decode);
+    OP_REQUIRES_OK(ctx, decode_status);
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
                             best_paths, &decoded_indices, &decoded_values,
@@ -338,6 +360,8 @@ class CTCBeamSearchDecoderOp : public OpKernel {
   ctc::CTCBeamSearchDecoder<>::DefaultBeamScorer beam_scorer_;
   bool merge_repeated_;
   int beam_width_;
+  int label_selection_size_;
+  float label_selection_margin_;
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoderOp);
 };
 
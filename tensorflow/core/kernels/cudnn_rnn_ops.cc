@@ -19,7 +19,9 @@ limitations under the License.
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <map>
 #include <string>
+#include <tuple>
 #include <unordered_set>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -499,9 +501,12 @@ struct CudnnRnnModelShapes {
   TensorShape output_shape;
   TensorShape hidden_state_shape;
   // At present only fields related to cached RnnDescriptor are concerned.
+  // The batch size is one of them: CUDNN_RNN_ALGO_PERSIST_DYNAMIC builds a
+  // persistent plan for a specific batch size.
   bool IsCompatibleWith(const CudnnRnnModelShapes& rhs) const {
     return num_layers == rhs.num_layers && input_size == rhs.input_size &&
-           num_units == rhs.num_units && dir_count == rhs.dir_count;
+           num_units == rhs.num_units && dir_count == rhs.dir_count &&
+           batch_size == rhs.batch_size;
   }
   string DebugString() const {
     return strings::Printf(
@@ -826,9 +831,13 @@ class CudnnRNNKernelCommon : public OpKernel {
   uint64 seed() { return (static_cast<uint64>(seed_) << 32) | seed2_; }
   bool ResetRndGenState() { return reset_rnd_gen_state_; }
 
+  // Returns in "*rnn_desc" a descriptor of the model that the num_layers,
+  // num_units and input_size inputs describe, for kernels that only deal
+  // with the layout of the params buffer. The descriptors are cached by the
+  // kernel and live as long as it.
   template <typename T>
   Status ExtractCudnnRNNParamsInfo(OpKernelContext* context,
-                                   std::unique_ptr<RnnDescriptor>* rnn_desc) {
+                                   RnnDescriptor** rnn_desc) {
     const Tensor* num_layers_t = nullptr;
     TF_RETURN_IF_ERROR(context->input("num_layers", &num_layers_t));
     if (!TensorShapeUtils::IsScalar(num_layers_t->shape())) {
@@ -848,6 +857,14 @@ class CudnnRNNKernelCommon : public OpKernel {
     }
     int input_size = input_size_t->scalar<int>()();
 
+    mutex_lock l(params_info_mu_);
+    std::unique_ptr<RnnDescriptor>& cached =
+        params_info_cache_[std::make_tuple(num_layers, num_units, input_size)];
+    if (cached != nullptr) {
+      *rnn_desc = cached.get();
+      return Status::OK();
+    }
+
     RnnInputMode input_mode;
     TF_RETURN_IF_ERROR(
         ToRNNInputMode(rnn_input_mode(), num_units, input_size, &input_mode));
@@ -863,7 +880,8 @@ class CudnnRNNKernelCommon : public OpKernel {
     if (!rnn_desc_s.ok()) {
       return FromExecutorStatus(rnn_desc_s);
     }
-    *rnn_desc = rnn_desc_s.ConsumeValueOrDie();
+    cached = rnn_desc_s.ConsumeValueOrDie();
+    *rnn_desc = cached.get();
     return Status::OK();
   }
 
@@ -922,6 +940,12 @@ class CudnnRNNKernelCommon : public OpKernel {
   bool reset_rnd_gen_state_;
 
   CudnnModelTypes model_types_;
+
+  // (num_layers, num_units, input_size) -> descriptor. See
+  // ExtractCudnnRNNParamsInfo().
+  mutex params_info_mu_;
+  std::map<std::tuple<int, int, int>, std::unique_ptr<RnnDescriptor>>
+      params_info_cache_ GUARDED_BY(params_info_mu_);
 };
 
 // A class that returns the size of the opaque parameter buffer. The user should
@@ -934,7 +958,7 @@ class CudnnRNNParamsSizeOp<GPUDevice, T, Index> : public CudnnRNNKernelCommon {
       : CudnnRNNKernelCommon(context) {}
 
   void Compute(OpKernelContext* context) override {
-    std::unique_ptr<RnnDescriptor> rnn_desc;
+    RnnDescriptor* rnn_desc = nullptr;
     OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
@@ -978,7 +1002,7 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
     auto input_ptr = StreamExecutorUtil::AsDeviceMemory<T>(input);
     Stream* stream = context->op_device_context()->stream();
 
-    std::unique_ptr<RnnDescriptor> rnn_desc;
+    RnnDescriptor* rnn_desc = nullptr;
     OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
@@ -1106,7 +1130,7 @@ class CudnnRNNCanonicalToParams<GPUDevice, T> : public CudnnRNNKernelCommon {
       : CudnnRNNKernelCommon(context) {}
 
   void Compute(OpKernelContext* context) override {
-    std::unique_ptr<RnnDescriptor> rnn_desc;
+    RnnDescriptor* rnn_desc = nullptr;
     OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
@@ -1231,111 +1255,28 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                                Tensor* output_c,
                                AlgorithmConfig* best_algo_config) {
     CHECK_NE(best_algo_config, nullptr);
-    *best_algo_config = AlgorithmConfig();
-    return Status::OK();
-  }
-
-  bool is_training() const { return is_training_; }
-  bool is_debug_mode_;
-  bool debug_use_tensor_ops_;
-  int64 debug_cudnn_rnn_algo_;
-
- private:
-  Status AllocateOutputs(OpKernelContext* context,
-                         const CudnnRnnModelShapes& model_shapes,
-                         Tensor** output, Tensor** output_h,
-                         Tensor** output_c) {
-    const TensorShape& hidden_state_shape = model_shapes.hidden_state_shape;
-    const TensorShape& output_shape = model_shapes.output_shape;
-
-    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, output));
-    TF_RETURN_IF_ERROR(
-        context->allocate_output(1, hidden_state_shape, output_h));
-    if (HasInputC()) {
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(2, hidden_state_shape, output_c));
-    } else {
-      // Only LSTM uses input_c and output_c. So for all other models, we only
-      // need to create dummy outputs.
-      TF_RETURN_IF_ERROR(context->allocate_output(2, {}, output_c));
-    }
-    if (!is_training_) {
-      Tensor* dummy_reserve_space = nullptr;
-      TF_RETURN_IF_ERROR(context->allocate_output(3, {}, &dummy_reserve_space));
-    }
-    return Status::OK();
-  }
-
-  mutex mu_;
-  bool is_training_;
-  RnnStateCache rnn_state_cache_ GUARDED_BY(mu_);
-};
-
-#define REGISTER_GPU(T)                                           \
-  REGISTER_KERNEL_BUILDER(                                        \
-      Name("CudnnRNN").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
-      CudnnRNNForwardOp<GPUDevice, T>);
-
-TF_CALL_half(REGISTER_GPU);
-TF_CALL_float(REGISTER_GPU);
-TF_CALL_double(REGISTER_GPU);
-#undef REGISTER_GPU
-
-template <typename T>
-class CudnnRNNForwardOpV2<GPUDevice, T>
-    : public CudnnRNNForwardOp<GPUDevice, T> {
- private:
-  using CudnnRNNForwardOp<GPUDevice, T>::is_training;
-  using CudnnRNNKernelCommon::CreateRnnDescriptor;
-  using CudnnRNNKernelCommon::dropout;
-  using CudnnRNNKernelCommon::HasInputC;
-  using CudnnRNNKernelCommon::model_types;
-
- public:
-  explicit CudnnRNNForwardOpV2(OpKernelConstruction* context)
-      : CudnnRNNForwardOp<GPUDevice, T>(context) {}
-
-  void Compute(OpKernelContext* context) override {
-    AlgorithmConfig best_algo_config;
-    CudnnRNNForwardOp<GPUDevice, T>::ComputeAndReturnAlgorithm(
-        context, &best_algo_config);
-    if (!context->status().ok()) {
-      return;
-    }
-
-    Tensor* output_host_reserved = nullptr;
-    // output_host_reserved stores opaque info used for backprop when running
-    // in training mode. At present, it includes a serialization of the best
-    // AlgorithmDesc picked during rnn forward pass autotune.
-    // int8 algorithm_id
-    // int8 use_tensor_op
-    // If autotune is not enabled, the algorithm_id is
-    // stream_executor::dnn::kDefaultAlgorithm and use_tensor_op is false. If
-    // running in inference mode, the output_host_reserved is currently not
-    // populated.
-    if (is_training()) {
-      OP_REQUIRES_OK(context, context->allocate_output(4, TensorShape({2}),
-                                                       &output_host_reserved));
-      auto output_host_reserved_int8 = output_host_reserved->vec<int8>();
-      output_host_reserved_int8(0) = best_algo_config.algorithm().algo_id();
-      output_host_reserved_int8(1) =
-          best_algo_config.algorithm().tensor_ops_enabled();
-    } else {
-      OP_REQUIRES_OK(context,
-                     context->allocate_output(4, {}, &output_host_reserved));
+    // CudnnRNNBackward always runs the default algorithm, so the forward
+    // pass may only pick another one for inference.
+    if (is_training_) {
+      *best_algo_config = AlgorithmConfig();
+      return Status::OK();
     }
+    return AutoTune(context, model_shapes, input_mode, input, input_h, input_c,
+                    params, output, output_h, output_c, best_algo_config);
   }
 
- protected:
-  Status MaybeAutoTune(OpKernelContext* context,
-                       const CudnnRnnModelShapes& model_shapes,
-                       const RnnInputMode& input_mode, const Tensor* input,
-                       const Tensor* input_h, const Tensor* input_c,
-                       const Tensor* params, Tensor* output, Tensor* output_h,
-                       Tensor* output_c,
-                       AlgorithmConfig* algo_config) override {
+  // Unless autotuning is disabled, profiles the algorithms of the device
+  // (including the persistent ones, which are the fastest for small batches)
+  // on the given inputs and returns the fastest in "*algo_config". Results
+  // are cached per model configuration.
+  Status AutoTune(OpKernelContext* context,
+                  const CudnnRnnModelShapes& model_shapes,
+                  const RnnInputMode& input_mode, const Tensor* input,
+                  const Tensor* input_h, const Tensor* input_c,
+                  const Tensor* params, Tensor* output, Tensor* output_h,
+                  Tensor* output_c, AlgorithmConfig* algo_config) {
     CHECK_NE(algo_config, nullptr);
-    if (!CudnnRnnUseAutotune() || this->is_debug_mode_) {
+    if (!CudnnRnnUseAutotune() || is_debug_mode_) {
       *algo_config = AlgorithmConfig();
       return Status::OK();
     }
@@ -1453,6 +1394,110 @@ class CudnnRNNForwardOpV2<GPUDevice, T>
     AutoTuneRnnConfigMap::GetInstance()->Insert(rnn_params, *algo_config);
     return Status::OK();
   }
+
+  bool is_training() const { return is_training_; }
+  bool is_debug_mode_;
+  bool debug_use_tensor_ops_;
+  int64 debug_cudnn_rnn_algo_;
+
+ private:
+  Status AllocateOutputs(OpKernelContext* context,
+                         const CudnnRnnModelShapes& model_shapes,
+                         Tensor** output, Tensor** output_h,
+                         Tensor** output_c) {
+    const TensorShape& hidden_state_shape = model_shapes.hidden_state_shape;
+    const TensorShape& output_shape = model_shapes.output_shape;
+
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, output));
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(1, hidden_state_shape, output_h));
+    if (HasInputC()) {
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(2, hidden_state_shape, output_c));
+    } else {
+      // Only LSTM uses input_c and output_c. So for all other models, we only
+      // need to create dummy outputs.
+      TF_RETURN_IF_ERROR(context->allocate_output(2, {}, output_c));
+    }
+    if (!is_training_) {
+      Tensor* dummy_reserve_space = nullptr;
+      TF_RETURN_IF_ERROR(context->allocate_output(3, {}, &dummy_reserve_space));
+    }
+    return Status::OK();
+  }
+
+  mutex mu_;
+  bool is_training_;
+  RnnStateCache rnn_state_cache_ GUARDED_BY(mu_);
+};
+
+#define REGISTER_GPU(T)                                           \
+  REGISTER_KERNEL_BUILDER(                                        \
+      Name("CudnnRNN").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      CudnnRNNForwardOp<GPUDevice, T>);
+
+TF_CALL_half(REGISTER_GPU);
+TF_CALL_float(REGISTER_GPU);
+TF_CALL_double(REGISTER_GPU);
+#undef REGISTER_GPU
+
+template <typename T>
+class CudnnRNNForwardOpV2<GPUDevice, T>
+    : public CudnnRNNForwardOp<GPUDevice, T> {
+ private:
+  using CudnnRNNForwardOp<GPUDevice, T>::is_training;
+  using CudnnRNNKernelCommon::CreateRnnDescriptor;
+  using CudnnRNNKernelCommon::dropout;
+  using CudnnRNNKernelCommon::HasInputC;
+  using CudnnRNNKernelCommon::model_types;
+
+ public:
+  explicit CudnnRNNForwardOpV2(OpKernelConstruction* context)
+      : CudnnRNNForwardOp<GPUDevice, T>(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    AlgorithmConfig best_algo_config;
+    CudnnRNNForwardOp<GPUDevice, T>::ComputeAndReturnAlgorithm(
+        context, &best_algo_config);
+    if (!context->status().ok()) {
+      return;
+    }
+
+    Tensor* output_host_reserved = nullptr;
+    // output_host_reserved stores opaque info used for backprop when running
+    // in training mode. At present, it includes a serialization of the best
+    // AlgorithmDesc picked during rnn forward pass autotune.
+    // int8 algorithm_id
+    // int8 use_tensor_op
+    // If autotune is not enabled, the algorithm_id is
+    // stream_executor::dnn::kDefaultAlgorithm and use_tensor_op is false. If
+    // running in inference mode, the output_host_reserved is currently not
+    // populated.
+    if (is_training()) {
+      OP_REQUIRES_OK(context, context->allocate_output(4, TensorShape({2}),
+                                                       &output_host_reserved));
+      auto output_host_reserved_int8 = output_host_reserved->vec<int8>();
+      output_host_reserved_int8(0) = best_algo_config.algorithm().algo_id();
+      output_host_reserved_int8(1) =
+          best_algo_config.algorithm().tensor_ops_enabled();
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(4, {}, &output_host_reserved));
+    }
+  }
+
+ protected:
+  Status MaybeAutoTune(OpKernelContext* context,
+                       const CudnnRnnModelShapes& model_shapes,
+                       const RnnInputMode& input_mode, const Tensor* input,
+                       const Tensor* input_h, const Tensor* input_c,
+                       const Tensor* params, Tensor* output, Tensor* output_h,
+                       Tensor* output_c,
+                       AlgorithmConfig* algo_config) override {
+    return this->AutoTune(context, model_shapes, input_mode, input, input_h,
+                          input_c, params, output, output_h, output_c,
+                          algo_config);
+  }
 };
 
 #define REGISTER_GPU(T)                                    \
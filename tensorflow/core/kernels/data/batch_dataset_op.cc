@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
@@ -21,6 +23,12 @@ namespace tensorflow {
 
 namespace {
 
+// Bounds the memory allocated for a batch before its elements arrive, so that
+// batching a short input with a large batch size, e.g. to gather all of its
+// elements, does not allocate memory for elements that never arrive. Larger
+// batches grow as their elements arrive.
+constexpr int64 kMaxPreallocatedBatchBytes = 256 << 20;
+
 // See documentation in ../ops/dataset_ops.cc for a high-level
 // description of the following op.
 
@@ -122,75 +130,68 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
-        // Each row of `batch_elements` is a tuple of tensors from the
-        // input iterator.
-        std::vector<std::vector<Tensor>> batch_elements;
+        // The input writes its elements directly into one output tensor per
+        // tuple component. The tensors are allocated once their shapes are
+        // known: up front if the input has static shapes, and otherwise from
+        // the first element.
+        std::vector<Tensor> batch;
+        int64 num_batch_elements = 0;
         {
           mutex_lock l(mu_);
           if (!input_impl_) {
             *end_of_sequence = true;
             return Status::OK();
           }
-          batch_elements.reserve(dataset()->batch_size_);
           *end_of_sequence = false;
-          for (int i = 0; i < dataset()->batch_size_ && !*end_of_sequence;
-               ++i) {
-            std::vector<Tensor> batch_element_tuple;
-            TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &batch_element_tuple,
-                                                    end_of_sequence));
-            if (!*end_of_sequence) {
-              batch_elements.emplace_back(std::move(batch_element_tuple));
+          std::vector<TensorShape> shapes;
+          if (GetStaticElementShapes(&shapes)) {
+            AllocateBatch(ctx, shapes, &batch);
+          }
+          while (num_batch_elements < dataset()->batch_size_) {
+            if (batch.empty()) {
+              std::vector<Tensor> first_element;
+              TF_RETURN_IF_ERROR(
+                  input_impl_->GetNext(ctx, &first_element, end_of_sequence));
+              if (*end_of_sequence) break;
+              shapes.clear();
+              for (const Tensor& component : first_element) {
+                shapes.push_back(component.shape());
+              }
+              AllocateBatch(ctx, shapes, &batch);
+              TF_RETURN_IF_ERROR(CopyElementToBatch(&first_element, 0, &batch));
             } else {
-              input_impl_.reset();
+              if (num_batch_elements == batch[0].dim_size(0)) {
+                TF_RETURN_IF_ERROR(GrowBatch(ctx, num_batch_elements, &batch));
+              }
+              TF_RETURN_IF_ERROR(input_impl_->GetNextIntoBatch(
+                  ctx, num_batch_elements, &batch, end_of_sequence));
+              if (*end_of_sequence) break;
             }
+            ++num_batch_elements;
+          }
+          if (*end_of_sequence) {
+            input_impl_.reset();
           }
         }
 
-        if (batch_elements.empty()) {
+        if (num_batch_elements == 0) {
           DCHECK(*end_of_sequence);
           return Status::OK();
         }
 
         if (dataset()->drop_remainder_ &&
-            batch_elements.size() < dataset()->batch_size_) {
+            num_batch_elements < dataset()->batch_size_) {
           *end_of_sequence = true;
           return Status::OK();
         }
 
-        // Copy the retrieved batch elements into one output tensor
-        // per tuple component.
-        // NOTE(mrry): If the input or output sizes are statically
-        // known, we could potentially read the input values in-place
-        // into their respective slice locations. This would require a
-        // different GetNext() overload that supports zero-copy, and might
-        // make sense in an optimization pass.
-        const size_t num_tuple_components = batch_elements[0].size();
-        const int64 num_batch_elements = batch_elements.size();
-        for (size_t component_index = 0; component_index < num_tuple_components;
-             ++component_index) {
-          const Tensor& first_element = batch_elements[0][component_index];
-          TensorShape batch_component_shape({num_batch_elements});
-          batch_component_shape.AppendShape(first_element.shape());
-          Tensor batch_component(ctx->allocator({}), first_element.dtype(),
-                                 batch_component_shape);
-          // Build the output tuple component by copying one slice
-          // from each input element in the batch.
-          for (size_t i = 0; i < num_batch_elements; ++i) {
-            if (batch_elements[i][component_index].shape() !=
-                first_element.shape()) {
-              return errors::InvalidArgument(
-                  "Cannot batch tensors with different shapes in component ",
-                  component_index, ". First element had shape ",
-                  first_element.shape().DebugString(), " and element ", i,
-                  " had shape ",
-                  batch_elements[i][component_index].shape().DebugString(),
-                  ".");
-            }
-            TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
-                std::move(batch_elements[i][component_index]), &batch_component,
-                i));
+        for (Tensor& component : batch) {
+          if (num_batch_elements < component.dim_size(0)) {
+            // The slice shares the buffer, so the batch is not copied again.
+            out_tensors->emplace_back(component.Slice(0, num_batch_elements));
+          } else {
+            out_tensors->emplace_back(std::move(component));
           }
-          out_tensors->emplace_back(std::move(batch_component));
         }
         *end_of_sequence = false;
         return Status::OK();
@@ -220,6 +221,79 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Returns true and stores the shapes of the tuple components of the
+      // input elements in `*shapes`, if they are statically known.
+      bool GetStaticElementShapes(std::vector<TensorShape>* shapes) {
+        shapes->clear();
+        for (const PartialTensorShape& shape :
+             dataset()->input_->output_shapes()) {
+          TensorShape static_shape;
+          if (!shape.AsTensorShape(&static_shape)) return false;
+          shapes->push_back(std::move(static_shape));
+        }
+        return true;
+      }
+
+      // Allocates one output tensor for each tuple component, with room for
+      // as many elements as fit in `kMaxPreallocatedBatchBytes`, up to the
+      // batch size.
+      void AllocateBatch(IteratorContext* ctx,
+                         const std::vector<TensorShape>& shapes,
+                         std::vector<Tensor>* batch) {
+        const DataTypeVector& dtypes = dataset()->input_->output_dtypes();
+        int64 bytes_per_element = 0;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+          // Approximates the size of non-memcpy-able types, like strings,
+          // with the size of a string.
+          const int64 bytes_per_value = DataTypeCanUseMemcpy(dtypes[i])
+                                            ? DataTypeSize(dtypes[i])
+                                            : sizeof(string);
+          bytes_per_element += shapes[i].num_elements() * bytes_per_value;
+        }
+        int64 num_rows = dataset()->batch_size_;
+        if (bytes_per_element > 0) {
+          num_rows = std::max<int64>(
+              1, std::min(num_rows,
+                          kMaxPreallocatedBatchBytes / bytes_per_element));
+        }
+        batch->clear();
+        batch->reserve(shapes.size());
+        for (size_t i = 0; i < shapes.size(); ++i) {
+          TensorShape batch_component_shape({num_rows});
+          batch_component_shape.AppendShape(shapes[i]);
+          batch->emplace_back(ctx->allocator({}), dtypes[i],
+                              batch_component_shape);
+        }
+      }
+
+      // Reallocates the tensors in `*batch`, which hold `num_rows` elements,
+      // with room for twice as many elements, up to the batch size.
+      Status GrowBatch(IteratorContext* ctx, int64 num_rows,
+                       std::vector<Tensor>* batch) {
+        const int64 new_num_rows =
+            std::min(2 * num_rows, dataset()->batch_size_);
+        for (Tensor& component : *batch) {
+          TensorShape new_shape = component.shape();
+          new_shape.set_dim(0, new_num_rows);
+          Tensor new_component(ctx->allocator({}), component.dtype(),
+                               new_shape);
+          if (component.NumElements() > 0) {
+            // Copies all existing rows at once, as a single slice.
+            const TensorShape flat_shape({1, component.NumElements()});
+            Tensor src;
+            Tensor dst;
+            if (!src.CopyFrom(component, flat_shape) ||
+                !dst.CopyFrom(new_component.Slice(0, num_rows), flat_shape)) {
+              return errors::Internal("Failed to reshape a batch of ",
+                                      num_rows, " elements.");
+            }
+            TF_RETURN_IF_ERROR(batch_util::CopySliceToSlice(src, 0, &dst, 0));
+          }
+          component = std::move(new_component);
+        }
+        return Status::OK();
+      }
+
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     };
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
+#include "tensorflow/core/kernels/data/sharded_cache.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -108,19 +109,13 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     class FileCacheIterator : public DatasetIterator<FileDataset> {
      public:
       explicit FileCacheIterator(const Params& params)
-          : DatasetIterator<FileDataset>(params) {
-        if (params.dataset->env_
-                ->FileExists(MetaFilename(params.dataset->filename_))
-                .ok()) {
-          mode_ = Mode::read;
-        } else {
-          mode_ = Mode::write;
-        }
-        InitializeIterator();
-      }
+          : DatasetIterator<FileDataset>(params) {}
 
       Status Initialize(IteratorContext* ctx) override {
         mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(OpenCache());
+        mode_ = cache_complete() ? Mode::read : Mode::write;
+        InitializeIterator();
         return iterator_->Initialize(ctx);
       }
 
@@ -145,54 +140,54 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("mode"), &temp));
           mode_ = static_cast<Mode>(temp);
         }
-        if (mode_ == Mode::write &&
-            dataset()
-                ->env_->FileExists(MetaFilename(dataset()->filename_))
-                .ok()) {
+        // Other iterators may have added to the cache since it was opened.
+        TF_RETURN_IF_ERROR(OpenCache());
+        if (mode_ == Mode::write && cache_complete()) {
           // This could happen if the cache was completely written after the
           // checkpoint was saved.
           LOG(WARNING)
-              << "It looks like the cache was already completely written("
-              << MetaFilename(dataset()->filename_)
-              << ") after the last checkpoint was saved. "
-              << "Attempting to read the cache instead of continuing to "
-              << "write. If this is a mistake, please remove the above file "
-              << "and try running again.";
+              << "It looks like the cache with prefix " << dataset()->filename_
+              << " was already completely written after the last checkpoint "
+              << "was saved. Attempting to read the cache instead of "
+              << "continuing to write. If this is a mistake, please remove "
+              << "the cache files and try running again.";
           mode_ = Mode::read;
         }
+        if (mode_ == Mode::read && !cache_complete()) {
+          return errors::FailedPrecondition(
+              "The checkpoint was saved while reading the cache with prefix ",
+              dataset()->filename_, ", which is no longer complete.");
+        }
         InitializeIterator();
         TF_RETURN_IF_ERROR(iterator_->Initialize(ctx));
         return RestoreParent(ctx, reader, iterator_);
       }
 
      private:
+      // Flush the elements written to the cache at least this often, so that
+      // the elements are not lost if the iterator is not destroyed cleanly,
+      // and so that concurrent iterators can read them.
+      static constexpr int64 kFlushIntervalElements = 1000;
+
       // FileWriterIterator passes through and caches items from the input
-      // FileDataset.
+      // dataset.
       //
-      // This iterator is used when the cache directory is not found on disk. It
-      // creates the cache directory, and passes on the underlying iterator's
-      // elements.
+      // This iterator is used when the cache is not complete. It produces the
+      // elements that are already in the cache, e.g. because another
+      // iterator has cached them or a previous iterator was destroyed before
+      // the end of the dataset, from the cache, and the other elements from
+      // the input, which it writes to a new shard of the cache. Any number of
+      // iterators, in this process or in others, may write to the same cache
+      // at once.
       //
-      // Caching is performed by writing the input tensors to disk using the
-      // `BundleWriter`. Note that the cache gets fully flushed to disk only
-      // after the input iterator has been fully exhausted. If the program
-      // exits, before completion of an epoch, the cached state would be lost.
-      // To ensure that the partial cache persists across sessions, one should
-      // checkpoint the input pipeline. On each call to `SaveInternal` the
-      // partial cache gets flushed to disk in files with prefix
-      // <filename>_<shard_id> where shard_id is unique for each checkpoint.
-      // When all elements have been produced, these shards get coalesced.
+      // The input iterator cannot skip elements without computing them, so
+      // after a run of elements from the cache, the input iterator is
+      // advanced past them when the next element is missing from the cache.
       class FileWriterIterator : public DatasetIterator<FileDataset> {
        public:
-        explicit FileWriterIterator(const Params& params)
-            : DatasetIterator<FileDataset>(params),
-              cur_index_(0),
-              shard_id_(0),
-              filename_(
-                  strings::StrCat(params.dataset->filename_, "_", shard_id_)),
-              lockfile_(strings::StrCat(filename_, ".lockfile")),
-              lockfile_created_(false),
-              iteration_completed_(false) {}
+        FileWriterIterator(const Params& params,
+                           std::shared_ptr<const ShardedCacheReader> cache)
+            : DatasetIterator<FileDataset>(params), cache_(std::move(cache)) {}
 
         Status Initialize(IteratorContext* ctx) override {
           return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
@@ -202,42 +197,57 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                                std::vector<Tensor>* out_tensors,
                                bool* end_of_sequence) override {
           mutex_lock l(mu_);
-          TF_RETURN_IF_ERROR(EnsureLockFileExists());
-          TF_RETURN_IF_ERROR(writer_->status());
-          if (cur_index_ >= kMaxItems) {
-            // As a courtesy, close the [truncated] cache file.
-            Status s = Finish();
-            if (!s.ok()) {
-              LOG(ERROR) << s;
-            }
-            return errors::InvalidArgument(
-                "Upstream iterator is producing more than ", kMaxItems,
-                " items, which is more than the cache limit.");
+          if (iteration_completed_) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          *end_of_sequence = false;
+          if (cache_->Contains(cur_index_)) {
+            TF_RETURN_IF_ERROR(cache_->Read(cur_index_, out_tensors));
+            cur_index_++;
+            return Status::OK();
+          }
+          if (cur_index_ == cache_->num_elements()) {
+            *end_of_sequence = true;
+            return Finish();
           }
 
+          while (input_index_ < cur_index_) {
+            std::vector<Tensor> skipped;
+            bool input_end_of_sequence = false;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &skipped, &input_end_of_sequence));
+            if (input_end_of_sequence) {
+              return errors::FailedPrecondition(
+                  "The input of the cache with prefix ", dataset()->filename_,
+                  " has ", input_index_, " elements, but the cache has ",
+                  cur_index_, ". Is the input the same dataset that the ",
+                  "cache was written from?");
+            }
+            input_index_++;
+          }
           TF_RETURN_IF_ERROR(
               input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
-          if (*end_of_sequence && out_tensors->empty()) {
-            TF_RETURN_IF_ERROR(Finish());
-            cur_index_++;
-            return Status::OK();
+          if (*end_of_sequence) {
+            return Finish();
           }
+          input_index_++;
           if (out_tensors->size() != dataset()->num_tensors_) {
             return errors::Internal(
                 "Upstream iterator returned invalid number of tensors. "
                 "Expected ",
                 dataset()->num_tensors_, " got: ", out_tensors->size());
           }
-          size_t tensor_index = 0;
-          for (const Tensor& t : *out_tensors) {
-            DCHECK_LT(tensor_index, dataset()->num_tensors_);
-            string key = dataset()->FormatName(cur_index_, tensor_index++);
-            TF_RETURN_IF_ERROR(writer_->Add(key, t));
-          }
-          if (*end_of_sequence) {
-            TF_RETURN_IF_ERROR(Finish());
+          if (!writer_) {
+            TF_RETURN_IF_ERROR(ShardedCacheWriter::Create(
+                dataset()->env_, dataset()->filename_, &writer_));
           }
+          TF_RETURN_IF_ERROR(writer_->Add(cur_index_, *out_tensors));
           cur_index_++;
+          if (++num_unflushed_ >= kFlushIntervalElements) {
+            TF_RETURN_IF_ERROR(writer_->Flush());
+            num_unflushed_ = 0;
+          }
           return Status::OK();
         }
 
@@ -249,31 +259,17 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
                 writer->WriteScalar(full_name("iteration_completed"), ""));
             return Status::OK();
           }
-
-          // lockfile is created on the first call to GetNextInternal. The
-          // absence of a lockfile means that GetNextInternal was not called
-          // and hence nothing was written to cache. So we don't need to worry
-          // about flushing the current shard. This ensures that we never write
-          // empty shards.
-          if (lockfile_created_) {
-            // Flush the current bundle.
-            TF_RETURN_IF_ERROR(writer_->Finish());
-
-            // Note: We do not delete the lockfile here. We keep lockfiles of
-            // all shards around until the entire cache has been written to
-            // prevent concurrent iterators from corrupting any of the shards.
-
-            // Start caching to a new shard.
-            shard_id_++;
-            filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
-            lockfile_ = strings::StrCat(filename_, ".lockfile");
-            lockfile_created_ = false;
+          // Make sure that the elements produced before the checkpoint are
+          // in the cache when the iterator is restored.
+          if (writer_) {
+            TF_RETURN_IF_ERROR(writer_->Flush());
+            num_unflushed_ = 0;
           }
           TF_RETURN_IF_ERROR(SaveParent(writer, input_impl_));
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("cur_index"), cur_index_));
           TF_RETURN_IF_ERROR(
-              writer->WriteScalar(full_name("shard_id"), shard_id_));
+              writer->WriteScalar(full_name("input_index"), input_index_));
           return Status::OK();
         }
 
@@ -286,142 +282,104 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
           }
 
           TF_RETURN_IF_ERROR(RestoreParent(ctx, reader, input_impl_));
-          int64 temp;
-          // TODO(b/78048575): Update this when saving size_t tensors directly
-          // is supported.
-          {
-            TF_RETURN_IF_ERROR(
-                reader->ReadScalar(full_name("cur_index"), &temp));
-            cur_index_ = static_cast<size_t>(temp);
-            if (cur_index_ != temp) {
-              return errors::Internal("Invalid value for cur_index ", temp);
-            }
-          }
-          // TODO(b/78048575): Update this when saving size_t tensors directly
-          // is supported.
-          {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("cur_index"), &cur_index_));
+          // Checkpoints written before the input could fall behind do not
+          // have an `input_index`.
+          input_index_ = cur_index_;
+          if (reader->Contains(full_name("input_index"))) {
             TF_RETURN_IF_ERROR(
-                reader->ReadScalar(full_name("shard_id"), &temp));
-            shard_id_ = static_cast<size_t>(temp);
-            if (shard_id_ != temp) {
-              return errors::Internal("Invalid value for shard_id ", temp);
-            }
+                reader->ReadScalar(full_name("input_index"), &input_index_));
           }
-          filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
-          lockfile_ = strings::StrCat(filename_, ".lockfile");
-          writer_.reset(new BundleWriter(dataset()->env_, filename_));
+          // Write the elements produced from now on to a new shard.
+          writer_.reset();
+          num_unflushed_ = 0;
           return Status::OK();
         }
 
        private:
-        Status EnsureLockFileExists() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-          if (iteration_completed_)
-            return errors::OutOfRange(
-                "Attempting to call get_next after iteration should have "
-                "finished.");
-          if (lockfile_created_ && !iteration_completed_) return Status::OK();
-
-          // Perform rudimentary locking to help catch concurrent writes to the
-          // same cache files.
-
-          // 1. Check that a checkpoint for the shard has not already been
-          // written.
-          if (dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
-            return errors::AlreadyExists("Existing cache files found: \n",
-                                         MetaFilename(filename_), "\n",
-                                         DataFilename(filename_, 0, 1), "\n",
-                                         "To continue delete the above files.");
-          }
-
-          // 2. Check that there isn't a concurrent iterator that is writing
-          // to cache.
-          if (dataset()->env_->FileExists(lockfile_).ok()) {
-            // Attempt to read the contents of the lockfile.
-            char contents_scratch[151] = {0};  // Initialize all to 0.
-            StringPiece contents;
-            std::unique_ptr<RandomAccessFile> file;
-            if (dataset()->env_->NewRandomAccessFile(lockfile_, &file).ok()) {
-              file->Read(0, 150, &contents, contents_scratch).IgnoreError();
-            }
-            return errors::AlreadyExists(
-                "There appears to be a concurrent caching iterator running - "
-                "cache lockfile already exists ('",
-                lockfile_,
-                "'). If you are sure no other running TF computations are "
-                "using "
-                "this cache prefix, delete the lockfile and re-initialize the "
-                "iterator. Lockfile contents: ",
-                contents);
-          } else {
-            // Create the file, and write some basic contents.
-            std::unique_ptr<WritableFile> lockfile;
-            TF_RETURN_IF_ERROR(
-                dataset()->env_->NewWritableFile(lockfile_, &lockfile));
-            TF_RETURN_IF_ERROR(lockfile->Append(strings::StrCat(
-                "Created at: ", dataset()->env_->NowSeconds())));
-
-            // At this point we know that
-            // 1. There is no conflicting checkpoint with prefix `filename_`.
-            // 2. There is no concurrent session that is trying to write a ckpt
-            //    to filename.
-            // So it is safe to create a BundleWriter here. Note that it is
-            // unsafe to initialize the BundleWriter anywhere the above
-            // conditions are not met since BundleWriter's constructor creates
-            // new temp files which can delete the temp files created by a
-            // BundleWriter in another Session.
-            writer_.reset(new BundleWriter(dataset()->env_, filename_));
-            lockfile_created_ = true;
-            return Status::OK();
-          }
-        }
-
         Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           iteration_completed_ = true;
-          // Flush the current bundle.
-          TF_RETURN_IF_ERROR(writer_->Finish());
-          // Merge all the bundles.
-          // Currently there are `shard_id_ + 1` bundles, one for each
-          // checkpoint. Each bundle has prefix <filename>_<id> where `id` is an
-          // integer starting at 0 an incremented by 1 for each new checkpoint.
-          // We merge all these bundles into a bundle with prefix <filename> so
-          // that the next call to `MakeIterator` can build a
-          // `FileReaderIterator`.
-          {
-            std::vector<string> prefixes;
-            prefixes.reserve(shard_id_ + 1);
-            for (size_t i = 0; i <= shard_id_; ++i) {
-              prefixes.emplace_back(
-                  strings::StrCat(dataset()->filename_, "_", i));
+          if (!writer_) {
+            if (cache_->num_elements() == cur_index_) {
+              return Status::OK();
             }
-            TF_RETURN_IF_ERROR(
-                MergeBundles(dataset()->env_, prefixes, dataset()->filename_));
-          }
-          // Delete all lockfiles.
-          for (size_t i = 0; i <= shard_id_; ++i) {
-            TF_RETURN_IF_ERROR(dataset()->env_->DeleteFile(
-                strings::StrCat(dataset()->filename_, "_", i, ".lockfile")));
+            // Record the number of elements, even though all of them were
+            // read from the cache.
+            TF_RETURN_IF_ERROR(ShardedCacheWriter::Create(
+                dataset()->env_, dataset()->filename_, &writer_));
           }
-          return Status::OK();
+          Status s = writer_->Finish(cur_index_);
+          writer_.reset();
+          return s;
         }
 
         mutex mu_;
-        size_t cur_index_ GUARDED_BY(mu_);
-        // Index of the current shard. This gets incremented whenever a new
-        // cache shard is saved.
-        size_t shard_id_ GUARDED_BY(mu_);
+        const std::shared_ptr<const ShardedCacheReader> cache_;
+        // The index of the next element to produce.
+        int64 cur_index_ GUARDED_BY(mu_) = 0;
+        // The index of the next element of `input_impl_`, which falls behind
+        // `cur_index_` while elements are read from the cache.
+        int64 input_index_ GUARDED_BY(mu_) = 0;
         std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
-        // The current prefix for the cache file. This is equal to
-        // `StrCat(dataset()->filename_, "_", shard_id_)`.
-        string filename_;
-        std::unique_ptr<BundleWriter> writer_ GUARDED_BY(mu_);
-        string lockfile_ GUARDED_BY(mu_);
-        bool lockfile_created_ GUARDED_BY(mu_);
-        bool iteration_completed_ GUARDED_BY(mu_);
+        // Created when the first element is missing from the cache.
+        std::unique_ptr<ShardedCacheWriter> writer_ GUARDED_BY(mu_);
+        int64 num_unflushed_ GUARDED_BY(mu_) = 0;
+        bool iteration_completed_ GUARDED_BY(mu_) = false;
       };  // FileWriterIterator
 
+      // FileReaderIterator produces the elements of a complete cache.
+      //
+      // The elements are read with random access from the mapped shards of
+      // the cache, and tensors of memcpy-able types refer to the mapped files
+      // instead of copies of their contents.
       class FileReaderIterator : public DatasetIterator<FileDataset> {
        public:
-        explicit FileReaderIterator(const Params& params)
+        FileReaderIterator(const Params& params,
+                           std::shared_ptr<const ShardedCacheReader> cache)
+            : DatasetIterator<FileDataset>(params), cache_(std::move(cache)) {}
+
+        Status GetNextInternal(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) override {
+          mutex_lock l(mu_);
+          if (cur_index_ >= cache_->num_elements()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          *end_of_sequence = false;
+          TF_RETURN_IF_ERROR(cache_->Read(cur_index_, out_tensors));
+          cur_index_++;
+          return Status::OK();
+        }
+
+       protected:
+        Status SaveInternal(IteratorStateWriter* writer) override {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("cur_index"), cur_index_));
+          return Status::OK();
+        }
+
+        Status RestoreInternal(IteratorContext* ctx,
+                               IteratorStateReader* reader) override {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("cur_index"), &cur_index_));
+          return Status::OK();
+        }
+
+       private:
+        mutex mu_;
+        const std::shared_ptr<const ShardedCacheReader> cache_;
+        int64 cur_index_ GUARDED_BY(mu_) = 0;
+      };  // FileReaderIterator
+
+      // BundleReaderIterator produces the elements of a cache written in the
+      // bundle format of earlier versions.
+      class BundleReaderIterator : public DatasetIterator<FileDataset> {
+       public:
+        explicit BundleReaderIterator(const Params& params)
             : DatasetIterator<FileDataset>(params),
               cur_index_(0),
               reader_(dataset()->env_, dataset()->filename_),
@@ -502,29 +460,60 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         size_t cur_index_ GUARDED_BY(mu_);
         BundleReader reader_ GUARDED_BY(mu_);
         bool iterator_restored_ GUARDED_BY(mu_);
-      };  // FileReaderIterator
+      };  // BundleReaderIterator
+
+      // Opens the cache, which may have been written in the bundle format of
+      // earlier versions.
+      Status OpenCache() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const FileDataset* d = dataset();
+        bundle_ = !ShardedCacheReader::Exists(d->env_, d->filename_) &&
+                  d->env_->FileExists(MetaFilename(d->filename_)).ok();
+        if (bundle_) {
+          cache_.reset();
+          return Status::OK();
+        }
+        std::unique_ptr<ShardedCacheReader> cache;
+        TF_RETURN_IF_ERROR(
+            ShardedCacheReader::Open(d->env_, d->filename_, &cache));
+        cache_ = std::move(cache);
+        return Status::OK();
+      }
+
+      bool cache_complete() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return bundle_ || cache_->complete();
+      }
 
       void InitializeIterator() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        // We intentionally use the same prefix for both `FileReaderIterator`
-        // and `FileWriterIterator`. Since at any time there will be at most
-        // one of them alive, there should be no conflicts. This allows both
-        // iterators to use a common key for `cur_index`. We leverage this
-        // in the corner case when this iterator is restored from an old
-        // checkpoint in `write` mode and the cache has been completely
-        // flushed to disk since then. In that case we simply build a
-        // `FileReaderIterator` and seek to the `cur_index`.
+        // We intentionally use the same prefix for all iterators. Since at
+        // any time there will be at most one of them alive, there should be
+        // no conflicts. This allows the iterators to use a common key for
+        // `cur_index`. We leverage this in the corner case when this iterator
+        // is restored from an old checkpoint in `write` mode and the cache
+        // has been completely written since then. In that case we simply
+        // build a reader iterator and seek to the `cur_index`.
         switch (mode_) {
           case Mode::read:
-            iterator_.reset(new FileReaderIterator({dataset(), prefix()}));
+            if (bundle_) {
+              iterator_.reset(
+                  new BundleReaderIterator({dataset(), prefix()}));
+            } else {
+              iterator_.reset(
+                  new FileReaderIterator({dataset(), prefix()}, cache_));
+            }
             break;
           case Mode::write:
-            iterator_.reset(new FileWriterIterator({dataset(), prefix()}));
+            iterator_.reset(
+                new FileWriterIterator({dataset(), prefix()}, cache_));
         }
       }
 
       mutex mu_;
       enum Mode { read, write };
       Mode mode_ GUARDED_BY(mu_);
+      // Whether the cache is in the bundle format of earlier versions, which
+      // is read with `BundleReaderIterator`.
+      bool bundle_ GUARDED_BY(mu_) = false;
+      std::shared_ptr<const ShardedCacheReader> cache_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> iterator_ GUARDED_BY(mu_);
     };  // FileCacheIterator
 
@@ -533,6 +522,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     Env* const env_;
     const size_t num_tensors_;
     const size_t tensor_index_padding_size_;
+    // The maximum number of elements of a cache in the bundle format.
     static const size_t kMaxItems = 10000000;  // 10 million
     const size_t item_index_padding_size_;
     const string tensor_format_string_;
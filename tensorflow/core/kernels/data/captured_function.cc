@@ -55,8 +55,11 @@ CapturedFunction::~CapturedFunction() {
 namespace {
 class CallFrameBase : public CallFrameInterface {
  public:
-  explicit CallFrameBase(DataTypeSlice ret_types)
-      : ret_types_(ret_types), retvals_(ret_types.size()) {}
+  explicit CallFrameBase(DataTypeSlice ret_types,
+                         CapturedFunction::RetvalCallback set_retval = nullptr)
+      : ret_types_(ret_types),
+        retvals_(ret_types.size()),
+        set_retval_(std::move(set_retval)) {}
 
   // Caller methods.
   Status ConsumeRetvals(std::vector<Tensor>* retvals) {
@@ -72,13 +75,30 @@ class CallFrameBase : public CallFrameInterface {
     return Status::OK();
   }
 
+  // Returns an error unless every return value has been passed to the
+  // `set_retval` callback.
+  Status CheckRetvalsSet() const {
+    for (size_t i = 0; i < retvals_.size(); ++i) {
+      if (!retvals_[i]) {
+        return errors::Internal("No return value for index ", i, ".");
+      }
+    }
+    return Status::OK();
+  }
+
   size_t num_retvals() const override { return retvals_.size(); }
 
   // Callee methods.
   Status SetRetval(int index, const Tensor& val) override {
     if (index < retvals_.size() && val.dtype() == ret_types_[index] &&
         !retvals_[index]) {
-      retvals_[index] = val;
+      if (set_retval_) {
+        TF_RETURN_IF_ERROR(set_retval_(index, val));
+        // Only records that the value has been set.
+        retvals_[index] = Tensor();
+      } else {
+        retvals_[index] = val;
+      }
       return Status::OK();
     } else if (index >= retvals_.size()) {
       return errors::InvalidArgument("Return value ", index,
@@ -97,6 +117,7 @@ class CallFrameBase : public CallFrameInterface {
  private:
   DataTypeSlice ret_types_;
   std::vector<gtl::optional<Tensor>> retvals_;
+  const CapturedFunction::RetvalCallback set_retval_;
   TF_DISALLOW_COPY_AND_ASSIGN(CallFrameBase);
 };
 
@@ -104,8 +125,9 @@ class OwnedArgsCallFrame : public CallFrameBase {
  public:
   OwnedArgsCallFrame(std::vector<Tensor>&& args,
                      const std::vector<Tensor>* captured_inputs,
-                     DataTypeSlice ret_types)
-      : CallFrameBase(ret_types),
+                     DataTypeSlice ret_types,
+                     CapturedFunction::RetvalCallback set_retval = nullptr)
+      : CallFrameBase(ret_types, std::move(set_retval)),
         args_(std::move(args)),
         captured_inputs_(captured_inputs) {}
 
@@ -339,6 +361,22 @@ void CapturedFunction::RunAsync(IteratorContext* ctx,
                                 std::vector<Tensor>&& args,
                                 std::vector<Tensor>* rets,
                                 FunctionLibraryRuntime::DoneCallback done) {
+  RunAsyncInternal(ctx, std::move(args), rets, nullptr, std::move(done));
+}
+
+void CapturedFunction::RunAsync(IteratorContext* ctx,
+                                std::vector<Tensor>&& args,
+                                RetvalCallback set_retval,
+                                FunctionLibraryRuntime::DoneCallback done) {
+  DCHECK(set_retval);
+  RunAsyncInternal(ctx, std::move(args), nullptr, std::move(set_retval),
+                   std::move(done));
+}
+
+void CapturedFunction::RunAsyncInternal(
+    IteratorContext* ctx, std::vector<Tensor>&& args,
+    std::vector<Tensor>* rets, RetvalCallback set_retval,
+    FunctionLibraryRuntime::DoneCallback done) {
   // NOTE(mrry): This method does not transfer ownership of `ctx`, and it may
   // be deleted before `done` is called. Take care not to capture `ctx` in any
   // code that may execute asynchronously in this function.
@@ -348,8 +386,8 @@ void CapturedFunction::RunAsync(IteratorContext* ctx,
     done(s);
     return;
   }
-  auto frame =
-      new OwnedArgsCallFrame(std::move(args), &captured_inputs_, ret_types_);
+  auto frame = new OwnedArgsCallFrame(std::move(args), &captured_inputs_,
+                                      ret_types_, std::move(set_retval));
 
   FunctionLibraryRuntime::Options f_opts;
   f_opts.step_id = CapturedFunction::generate_step_id();
@@ -382,7 +420,8 @@ void CapturedFunction::RunAsync(IteratorContext* ctx,
                         delete step_container;
                         delete c_mgr;
                         if (s.ok()) {
-                          s = frame->ConsumeRetvals(rets);
+                          s = rets != nullptr ? frame->ConsumeRetvals(rets)
+                                              : frame->CheckRetvalsSet();
                         }
                         delete frame;
                         done(s);
@@ -95,6 +95,19 @@ class CapturedFunction {
                 std::vector<Tensor>* rets,
                 FunctionLibraryRuntime::DoneCallback done);
 
+  // Called with the index and the value of each result of a function, as
+  // soon as the function produces it. A non-OK status fails the function.
+  using RetvalCallback = std::function<Status(int index, const Tensor& val)>;
+
+  // Asynchronously runs the captured function on the given `args` like
+  // `RunAsync()` above, but passes each result to `set_retval` instead of
+  // storing it, so that callers can write the results straight into their
+  // destination, e.g. a slice of a batch. `done` is called once all results
+  // have been passed to `set_retval`, or the function has failed.
+  void RunAsync(IteratorContext* ctx, std::vector<Tensor>&& args,
+                RetvalCallback set_retval,
+                FunctionLibraryRuntime::DoneCallback done);
+
   // Returns the named list of function arguments.
   const NameAttrList& func() { return func_; }
 
@@ -119,6 +132,12 @@ class CapturedFunction {
   Status MaybeInstantiate(IteratorContext* ctx,
                           FunctionLibraryRuntime::Handle* out_handle);
 
+  // Implements both `RunAsync()` methods: exactly one of `rets` and
+  // `set_retval` is set.
+  void RunAsyncInternal(IteratorContext* ctx, std::vector<Tensor>&& args,
+                        std::vector<Tensor>* rets, RetvalCallback set_retval,
+                        FunctionLibraryRuntime::DoneCallback done);
+
   mutex mu_;
   const NameAttrList func_;
   FunctionLibraryRuntime* lib_ GUARDED_BY(mu_);
@@ -0,0 +1,449 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Throughput benchmarks of canonical input pipelines over synthetic data.
+//
+// Each benchmark builds a pipeline as a graph, creates an iterator over it in
+// a DirectSession, and times IteratorGetNext, which produces one batch of
+// kBatchSize elements. Besides the time per batch, it reports the elements
+// and bytes of input per second, and the process CPU time per element in its
+// label. The argument of each benchmark is the parallelism of the pipeline's
+// parallel stages. The data is generated with fixed seeds and sizes, so that
+// the results can be compared across runs and releases.
+//
+// Run with:
+//   bazel run -c opt //tensorflow/core/kernels/data:dataset_benchmark_test \
+//     -- --benchmarks=all
+
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+typedef FunctionDefHelper FDH;
+using test::function::NDef;
+
+constexpr int kBatchSize = 64;
+// TFRecord pipelines: the files, and the examples in each file.
+constexpr int kNumFiles = 32;
+constexpr int kRecordsPerFile = 512;
+constexpr int kNumFeatures = 128;
+// Image pipelines: the number of distinct JPEG images, and their size.
+constexpr int kNumImages = 64;
+constexpr int kImageSize = 224;
+
+// Synthetic TFRecord files of tf.Examples with a "features" float feature of
+// kNumFeatures values and an int64 "label" feature.
+struct RecordFiles {
+  std::vector<string> filenames;
+  int64 bytes_per_record = 0;
+};
+
+const RecordFiles& GetRecordFiles() {
+  static const RecordFiles* files = []() {
+    RecordFiles* files = new RecordFiles;
+    const string dir = io::JoinPath(testing::TmpDir(), "dataset_benchmark");
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(dir));
+    random::PhiloxRandom philox(301, 17);
+    random::SimplePhilox rnd(&philox);
+    int64 total_bytes = 0;
+    for (int i = 0; i < kNumFiles; ++i) {
+      const string filename = io::JoinPath(dir, strings::StrCat("data-", i));
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(Env::Default()->NewWritableFile(filename, &file));
+      io::RecordWriter writer(file.get());
+      for (int j = 0; j < kRecordsPerFile; ++j) {
+        Example example;
+        auto* features = example.mutable_features()->mutable_feature();
+        auto* values = (*features)["features"].mutable_float_list();
+        for (int k = 0; k < kNumFeatures; ++k) {
+          values->add_value(rnd.RandFloat() * 255);
+        }
+        (*features)["label"].mutable_int64_list()->add_value(rnd.Uniform(1000));
+        const string record = example.SerializeAsString();
+        TF_CHECK_OK(writer.WriteRecord(record));
+        total_bytes += record.size();
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(file->Close());
+      files->filenames.push_back(filename);
+    }
+    files->bytes_per_record = total_bytes / (kNumFiles * kRecordsPerFile);
+    return files;
+  }();
+  return *files;
+}
+
+// kNumImages synthetic JPEG images of kImageSize x kImageSize RGB pixels.
+// They are gradients plus noise, so that they compress like photos rather
+// than like noise or like flat colors.
+struct Images {
+  Tensor jpegs;
+  int64 bytes_per_image = 0;
+};
+
+const Images& GetImages() {
+  static const Images* images = []() {
+    random::PhiloxRandom philox(302, 17);
+    random::SimplePhilox rnd(&philox);
+    std::vector<NodeDef> nodes;
+    std::vector<string> outputs;
+    for (int i = 0; i < kNumImages; ++i) {
+      Tensor pixels(DT_UINT8, TensorShape({kImageSize, kImageSize, 3}));
+      auto flat = pixels.flat<uint8>();
+      for (int64 j = 0; j < flat.size(); ++j) {
+        const int row = j / (kImageSize * 3);
+        const int col = (j / 3) % kImageSize;
+        flat(j) = (row + col + 64 * (j % 3) + i + rnd.Uniform(16)) % 256;
+      }
+      const string pixels_name = strings::StrCat("pixels", i);
+      const string jpeg_name = strings::StrCat("jpeg", i);
+      nodes.push_back(NDef(pixels_name, "Const", {},
+                           {{"dtype", DT_UINT8}, {"value", pixels}}));
+      nodes.push_back(NDef(jpeg_name, "EncodeJpeg", {pixels_name}));
+      outputs.push_back(strings::StrCat(jpeg_name, ":0"));
+    }
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_CHECK_OK(session->Create(test::function::GDef(nodes)));
+    std::vector<Tensor> jpegs;
+    TF_CHECK_OK(session->Run({}, outputs, {}, &jpegs));
+
+    Images* images = new Images;
+    images->jpegs = Tensor(DT_STRING, TensorShape({kNumImages}));
+    int64 total_bytes = 0;
+    for (int i = 0; i < kNumImages; ++i) {
+      images->jpegs.vec<string>()(i) = jpegs[i].scalar<string>()();
+      total_bytes += jpegs[i].scalar<string>()().size();
+    }
+    images->bytes_per_image = total_bytes / kNumImages;
+    return images;
+  }();
+  return *images;
+}
+
+// record: string -> (features: float[kNumFeatures], label: int64), the
+// parsed example with its features scaled to [0, 1].
+FunctionDef ParseRecord() {
+  return FDH::Create(
+      // Name
+      "ParseRecord",
+      // Args
+      {"record: string"},
+      // Return values
+      {"features: float", "label: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          {{"no_default_features"},
+           "Const",
+           {},
+           {{"dtype", DT_FLOAT},
+            {"value", Tensor(DT_FLOAT, TensorShape({0}))}}},
+          {{"no_default_label"},
+           "Const",
+           {},
+           {{"dtype", DT_INT64},
+            {"value", Tensor(DT_INT64, TensorShape({0}))}}},
+          {{"parse"},
+           "ParseSingleExample",
+           {"record", "no_default_features:output:0",
+            "no_default_label:output:0"},
+           {{"num_sparse", 0},
+            {"sparse_keys", std::vector<string>()},
+            {"sparse_types", DataTypeVector()},
+            {"dense_keys", std::vector<string>({"features", "label"})},
+            {"Tdense", DataTypeVector({DT_FLOAT, DT_INT64})},
+            {"dense_shapes",
+             std::vector<PartialTensorShape>(
+                 {PartialTensorShape({kNumFeatures}),
+                  PartialTensorShape({})})}}},
+          {{"scale"},
+           "Const",
+           {},
+           {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(1 / 255.f)}}},
+          {{"scaled"},
+           "Mul",
+           {"parse:dense_values:0", "scale:output:0"},
+           {{"T", DT_FLOAT}}},
+      },
+      // Output mapping
+      {{"features", "scaled:z:0"}, {"label", "parse:dense_values:1"}});
+}
+
+// jpeg: string -> image: float[kImageSize, kImageSize, 3].
+FunctionDef DecodeImage() {
+  return FDH::Create(
+      // Name
+      "DecodeImage",
+      // Args
+      {"jpeg: string"},
+      // Return values
+      {"image: float"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          {{"decode"}, "DecodeJpeg", {"jpeg"}, {{"channels", 3}}},
+          {{"cast"},
+           "Cast",
+           {"decode:image:0"},
+           {{"SrcT", DT_UINT8}, {"DstT", DT_FLOAT}}},
+      },
+      // Output mapping
+      {{"image", "cast:y:0"}});
+}
+
+// filename: string -> the dataset of the records in the file.
+FunctionDef ReadRecords() {
+  return FDH::Create(
+      // Name
+      "ReadRecords",
+      // Args
+      {"filename: string"},
+      // Return values
+      {"records: variant"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          FDH::Const<string>("compression_type", ""),
+          FDH::Const<int64>("buffer_size", 256 << 10),
+          {{"reader"},
+           "TFRecordDataset",
+           {"filename", "compression_type:output:0", "buffer_size:output:0"}},
+      },
+      // Output mapping
+      {{"records", "reader:handle:0"}});
+}
+
+// Builds the graph of an input pipeline from a chain of dataset nodes.
+class PipelineBuilder {
+ public:
+  // Adds a dataset node of type "op", which consumes the dataset added last,
+  // if any, and the given nodes as further inputs. The nodes are scalar
+  // constants made by Const().
+  PipelineBuilder& Dataset(
+      const string& op, const std::vector<string>& inputs,
+      std::vector<std::pair<string, FDH::AttrValueWrapper>> attrs = {}) {
+    const string name = strings::StrCat("dataset", nodes_.size());
+    std::vector<string> all_inputs;
+    if (!last_dataset_.empty()) all_inputs.push_back(last_dataset_);
+    all_inputs.insert(all_inputs.end(), inputs.begin(), inputs.end());
+    attrs.push_back({"output_types", types_});
+    attrs.push_back({"output_shapes", shapes_});
+    nodes_.push_back(NDef(name, op, all_inputs, attrs));
+    last_dataset_ = name;
+    return *this;
+  }
+
+  // Sets the element types and shapes of the datasets added after this call.
+  PipelineBuilder& Elements(const DataTypeVector& types,
+                            const std::vector<PartialTensorShape>& shapes) {
+    types_ = types;
+    shapes_ = shapes;
+    return *this;
+  }
+
+  template <typename T>
+  string Const(const T& value) {
+    const string name = strings::StrCat("const", nodes_.size());
+    nodes_.push_back(NDef(name, "Const", {},
+                          {{"dtype", DataTypeToEnum<T>::value},
+                           {"value", test::AsScalar<T>(value)}}));
+    return name;
+  }
+
+  string Const(const Tensor& value) {
+    const string name = strings::StrCat("const", nodes_.size());
+    nodes_.push_back(
+        NDef(name, "Const", {}, {{"dtype", value.dtype()}, {"value", value}}));
+    return name;
+  }
+
+  // Returns the graph, with the nodes "make_iterator" that initializes an
+  // iterator over the dataset added last, and "get_next" that gets its next
+  // element.
+  GraphDef Finish(const std::vector<FunctionDef>& functions) {
+    std::vector<NodeDef> nodes = nodes_;
+    nodes.push_back(NDef("iterator", "Iterator", {},
+                         {{"shared_name", "iterator"},
+                          {"container", ""},
+                          {"output_types", types_},
+                          {"output_shapes", shapes_}}));
+    nodes.push_back(
+        NDef("make_iterator", "MakeIterator", {last_dataset_, "iterator"}));
+    nodes.push_back(NDef("get_next", "IteratorGetNext", {"iterator"},
+                         {{"output_types", types_},
+                          {"output_shapes", shapes_}}));
+    return test::function::GDef(nodes, functions);
+  }
+
+ private:
+  std::vector<NodeDef> nodes_;
+  string last_dataset_;
+  DataTypeVector types_;
+  std::vector<PartialTensorShape> shapes_;
+};
+
+// Times "iters" batches of the pipeline in "graph", whose elements are made
+// from "bytes_per_element" bytes of input each.
+void RunPipeline(int iters, const GraphDef& graph, int64 bytes_per_element) {
+  testing::StopTiming();
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_CHECK_OK(session->Create(graph));
+  TF_CHECK_OK(session->Run({}, {}, {"make_iterator"}, nullptr));
+  // Warm up, so that the buffers are full and the threads started.
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 10; ++i) {
+    TF_CHECK_OK(session->Run({}, {"get_next:0"}, {}, &outputs));
+  }
+
+  const std::clock_t start_cpu = std::clock();
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({}, {"get_next:0"}, {}, &outputs));
+  }
+  testing::StopTiming();
+  const double cpu_seconds =
+      static_cast<double>(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+
+  const int64 num_elements = static_cast<int64>(iters) * kBatchSize;
+  testing::ItemsProcessed(num_elements);
+  testing::BytesProcessed(num_elements * bytes_per_element);
+  testing::SetLabel(strings::StrCat(
+      "cpu_us_per_element=", cpu_seconds * 1e6 / num_elements));
+  TF_CHECK_OK(session->Close());
+}
+
+// TFRecord read -> parse Example -> map -> shuffle -> batch -> prefetch.
+static void BM_TFRecordParseShuffleBatch(int iters, int parallelism) {
+  const RecordFiles& files = GetRecordFiles();
+  Tensor filenames(DT_STRING, TensorShape({kNumFiles}));
+  for (int i = 0; i < kNumFiles; ++i) {
+    filenames.vec<string>()(i) = files.filenames[i];
+  }
+
+  PipelineBuilder b;
+  const string filenames_node = b.Const(filenames);
+  b.Elements({DT_STRING}, {PartialTensorShape({})})
+      .Dataset("TFRecordDataset", {filenames_node, b.Const<string>(""),
+                                   b.Const<int64>(256 << 10)})
+      .Dataset("RepeatDataset", {b.Const<int64>(-1)})
+      .Elements({DT_FLOAT, DT_INT64},
+                {PartialTensorShape({kNumFeatures}), PartialTensorShape({})})
+      .Dataset("ParallelMapDataset", {b.Const<int32>(parallelism)},
+               {{"f", FDH::FunctionRef("ParseRecord")},
+                {"Targuments", DataTypeVector()}})
+      .Dataset("ShuffleDataset", {b.Const<int64>(1024), b.Const<int64>(1),
+                                  b.Const<int64>(2)})
+      .Elements({DT_FLOAT, DT_INT64},
+                {PartialTensorShape({-1, kNumFeatures}),
+                 PartialTensorShape({-1})})
+      .Dataset("BatchDataset", {b.Const<int64>(kBatchSize)})
+      .Dataset("PrefetchDataset", {b.Const<int64>(2)});
+
+  RunPipeline(iters, b.Finish({ParseRecord()}), files.bytes_per_record);
+}
+
+BENCHMARK(BM_TFRecordParseShuffleBatch)->Arg(1)->Arg(4)->Arg(16);
+
+// JPEG decode -> batch -> prefetch.
+static void BM_ImageDecodeBatch(int iters, int parallelism) {
+  const Images& images = GetImages();
+
+  PipelineBuilder b;
+  const string jpegs_node = b.Const(images.jpegs);
+  b.Elements({DT_STRING}, {PartialTensorShape({})})
+      .Dataset("TensorSliceDataset", {jpegs_node},
+               {{"Toutput_types", DataTypeVector({DT_STRING})}})
+      .Dataset("RepeatDataset", {b.Const<int64>(-1)})
+      .Elements({DT_FLOAT}, {PartialTensorShape({-1, -1, 3})})
+      .Dataset("ParallelMapDataset", {b.Const<int32>(parallelism)},
+               {{"f", FDH::FunctionRef("DecodeImage")},
+                {"Targuments", DataTypeVector()}})
+      .Elements({DT_FLOAT}, {PartialTensorShape({-1, -1, -1, 3})})
+      .Dataset("BatchDataset", {b.Const<int64>(kBatchSize)})
+      .Dataset("PrefetchDataset", {b.Const<int64>(2)});
+
+  RunPipeline(iters, b.Finish({DecodeImage()}), images.bytes_per_image);
+}
+
+BENCHMARK(BM_ImageDecodeBatch)->Arg(1)->Arg(4)->Arg(16);
+
+// Interleave over the files -> parse Example -> batch -> prefetch. Both the
+// interleave cycle and the parsing use "parallelism".
+static void BM_InterleaveFilesParseBatch(int iters, int parallelism) {
+  const RecordFiles& files = GetRecordFiles();
+  Tensor filenames(DT_STRING, TensorShape({kNumFiles}));
+  for (int i = 0; i < kNumFiles; ++i) {
+    filenames.vec<string>()(i) = files.filenames[i];
+  }
+
+  PipelineBuilder b;
+  const string filenames_node = b.Const(filenames);
+  b.Elements({DT_STRING}, {PartialTensorShape({})})
+      .Dataset("TensorSliceDataset", {filenames_node},
+               {{"Toutput_types", DataTypeVector({DT_STRING})}})
+      .Dataset("RepeatDataset", {b.Const<int64>(-1)})
+      .Dataset("ParallelInterleaveDataset",
+               {b.Const<int64>(parallelism), b.Const<int64>(1),
+                b.Const<bool>(false), b.Const<int64>(kBatchSize),
+                b.Const<int64>(parallelism)},
+               {{"f", FDH::FunctionRef("ReadRecords")},
+                {"Targuments", DataTypeVector()}})
+      .Elements({DT_FLOAT, DT_INT64},
+                {PartialTensorShape({kNumFeatures}), PartialTensorShape({})})
+      .Dataset("ParallelMapDataset", {b.Const<int32>(parallelism)},
+               {{"f", FDH::FunctionRef("ParseRecord")},
+                {"Targuments", DataTypeVector()}})
+      .Elements({DT_FLOAT, DT_INT64},
+                {PartialTensorShape({-1, kNumFeatures}),
+                 PartialTensorShape({-1})})
+      .Dataset("BatchDataset", {b.Const<int64>(kBatchSize)})
+      .Dataset("PrefetchDataset", {b.Const<int64>(2)});
+
+  RunPipeline(iters, b.Finish({ReadRecords(), ParseRecord()}),
+              files.bytes_per_record);
+}
+
+BENCHMARK(BM_InterleaveFilesParseBatch)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/dataset_scheduler.h"
 #include "tensorflow/core/framework/iterator.pb.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -43,6 +46,36 @@ namespace {
 
 const char kIteratorVariantTypeName[] = "tensorflow::Iterator";
 
+// Returns a new performance model for the iterator tree of an iterator
+// resource, or nullptr if both TF_DATA_AUTOTUNE and TF_DATA_PROFILE are
+// false. If TF_DATA_PROFILE is true, the model logs a profile of the
+// pipeline periodically and when it reaches its end.
+std::shared_ptr<model::Model> MaybeNewModel() {
+  static const model::Model::Options* options = [] {
+    auto* options = new model::Model::Options;
+    TF_CHECK_OK(
+        ReadBoolFromEnvVar("TF_DATA_AUTOTUNE", true, &options->autotune));
+    TF_CHECK_OK(
+        ReadBoolFromEnvVar("TF_DATA_PROFILE", false, &options->profile));
+    return options;
+  }();
+  if (!options->autotune && !options->profile) return nullptr;
+  return std::make_shared<model::Model>(*options);
+}
+
+// Returns a new pipeline of the process-wide scheduler for the iterator tree
+// of an iterator resource, or nullptr if TF_DATA_SHARED_SCHEDULER is false.
+std::shared_ptr<DatasetScheduler::Pipeline> MaybeNewSchedulerPipeline() {
+  static const bool shared_scheduler = [] {
+    bool shared_scheduler;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_DATA_SHARED_SCHEDULER", true,
+                                   &shared_scheduler));
+    return shared_scheduler;
+  }();
+  if (!shared_scheduler) return nullptr;
+  return DatasetScheduler::Global()->NewPipeline();
+}
+
 Status VerifyTypesMatch(const DataTypeVector& expected,
                         const DataTypeVector& received) {
   if (expected.size() != received.size()) {
@@ -158,7 +191,12 @@ class IteratorResource : public ResourceBase {
         graph_runner.Run(&graph, lib, {}, {output_node}, &outputs));
     TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(outputs[0], &dataset));
 
+    std::shared_ptr<model::Model> model = MaybeNewModel();
+    std::shared_ptr<DatasetScheduler::Pipeline> scheduler =
+        MaybeNewSchedulerPipeline();
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model(model);
+    iter_ctx.set_scheduler(scheduler);
     std::unique_ptr<IteratorBase> iterator;
     TF_RETURN_IF_ERROR(dataset->MakeIterator(&iter_ctx, "Iterator", &iterator));
     TF_RETURN_IF_ERROR(set_iterator(std::move(iterator)));
@@ -173,6 +211,8 @@ class IteratorResource : public ResourceBase {
       params.allocator_getter = [device](AllocatorAttributes attrs) {
         return device->GetAllocator(attrs);
       };
+      params.model = model;
+      params.scheduler = scheduler;
       IteratorContext iter_ctx(std::move(params));
 
       TF_RETURN_IF_ERROR(captured_iterator->Restore(&iter_ctx, reader));
@@ -655,6 +695,8 @@ class MakeIteratorOp : public OpKernel {
     core::ScopedUnref unref(iterator_resource);
 
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model(MaybeNewModel());
+    iter_ctx.set_scheduler(MaybeNewSchedulerPipeline());
     std::unique_ptr<IteratorBase> iterator;
     OP_REQUIRES_OK(ctx,
                    dataset->MakeIterator(&iter_ctx, "Iterator", &iterator));
@@ -952,6 +994,8 @@ class OneShotIteratorOp : public AsyncOpKernel {
     DatasetBase* dataset;
     TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(return_values[0], &dataset));
     IteratorContext iter_ctx = dataset::MakeIteratorContext(ctx);
+    iter_ctx.set_model(MaybeNewModel());
+    iter_ctx.set_scheduler(MaybeNewSchedulerPipeline());
     std::unique_ptr<IteratorBase> iter;
     TF_RETURN_IF_ERROR(dataset->MakeIterator(&iter_ctx, "Iterator", &iter));
     TF_RETURN_IF_ERROR((*iterator)->set_iterator(std::move(iter)));
@@ -14,9 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -69,17 +72,25 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         int64 num_parallel_batches;
         OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_batches",
                                                 &num_parallel_batches));
-        num_parallel_calls = num_parallel_batches * batch_size;
-        OP_REQUIRES(ctx, num_parallel_batches > 0,
+        num_parallel_calls = num_parallel_batches == model::kAutoTune
+                                 ? model::kAutoTune
+                                 : num_parallel_batches * batch_size;
+        OP_REQUIRES(ctx,
+                    num_parallel_batches > 0 ||
+                        num_parallel_batches == model::kAutoTune,
                     errors::InvalidArgument(
-                        "num_parallel_batches must be greater than zero."));
+                        "num_parallel_batches must be greater than zero, or ",
+                        model::kAutoTune, " to tune it automatically."));
         break;
       case 2:
         OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                                 &num_parallel_calls));
-        OP_REQUIRES(ctx, num_parallel_calls > 0,
+        OP_REQUIRES(ctx,
+                    num_parallel_calls > 0 ||
+                        num_parallel_calls == model::kAutoTune,
                     errors::InvalidArgument(
-                        "num_parallel_calls must be greater than zero."));
+                        "num_parallel_calls must be greater than zero, or ",
+                        model::kAutoTune, " to tune it automatically."));
         break;
       default:
         OP_REQUIRES(ctx, false,
@@ -189,7 +200,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            num_parallel_calls_(params.dataset->num_parallel_calls_) {}
 
       ~Iterator() override {
         mutex_lock l(mu_);
@@ -203,6 +215,18 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        if (num_parallel_calls_ == model::kAutoTune) {
+          if (model_node() != nullptr) {
+            num_parallel_calls_ = 1;
+            model_node()->add_tunable_parallelism(&num_parallel_calls_, 1,
+                                                  port::NumSchedulableCPUs(),
+                                                  &mu_, &cond_var_);
+          } else {
+            num_parallel_calls_ = port::NumSchedulableCPUs();
+          }
+        } else if (model_node() != nullptr) {
+          model_node()->set_asynchronous();
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
@@ -213,6 +237,9 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         {
           mutex_lock l(mu_);
           EnsureRunnerThreadStarted(ctx);
+          if (model_node() != nullptr) {
+            model_node()->record_buffer_size(batch_results_.size());
+          }
           while (batch_results_.empty() ||
                  batch_results_.front()->num_calls > 0) {
             cond_var_.wait(l);
@@ -260,7 +287,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
 
      private:
       struct BatchResult {
-        explicit BatchResult(int64 batch_size) {
+        BatchResult(int64 batch_size, size_t num_components)
+            : output(num_components), allocated(num_components, false) {
           end_of_input = false;
           num_calls = batch_size;
           num_elements = 0;
@@ -276,49 +304,72 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         mutex mu;
         bool end_of_input GUARDED_BY(mu);
         int64 num_elements GUARDED_BY(mu);
+        // One tensor per component, allocated when the first call returns
+        // a value for the component.
         std::vector<Tensor> output;
+        // Whether the respective tensor in `output` has been allocated.
+        std::vector<bool> allocated GUARDED_BY(mu);
+        // Whether all tensors in `output` have been allocated.
         bool output_allocated GUARDED_BY(mu);
         Status status GUARDED_BY(mu);
         // Counts the number of outstanding calls for this batch.
         int64 num_calls;  // access guarded by owner's mutex
       };
 
-      void Callback(const std::shared_ptr<IteratorContext>& ctx,
-                    const std::shared_ptr<BatchResult>& result,
-                    const std::shared_ptr<std::vector<Tensor>>& return_values,
-                    int64 offset, const Status& status) LOCKS_EXCLUDED(mu_) {
+      void Callback(const std::shared_ptr<BatchResult>& result,
+                    const Status& status) LOCKS_EXCLUDED(mu_) {
         result->UpdateStatus(status);
         if (status.ok()) {
-          EnsureOutputAllocated(ctx, result, return_values);
-          for (size_t i = 0; i < return_values->size(); ++i) {
-            const Tensor& tensor = return_values->at(i);
-            Tensor* batch = &(result->output)[i];
-            if (tensor.NumElements() !=
-                (batch->NumElements() / batch->dim_size(0))) {
-              TensorShape batch_shape = batch->shape();
-              batch_shape.RemoveDim(0);
-              result->UpdateStatus(errors::InvalidArgument(
-                  "Cannot add tensor to the batch: number of elements does not "
-                  "match. Shapes are: [tensor]: ",
-                  tensor.shape().DebugString(),
-                  ", [batch]: ", batch_shape.DebugString()));
-              break;
-            }
-            // TODO(mrry): Add a version of DoParallelConcat that allows us to
-            // move `tensor` where possible, to speed up string tensor batching.
-            Status copy_status = ::tensorflow::functor::DoParallelConcat(
-                *dataset()->device_, tensor, offset, batch);
-            if (!copy_status.ok()) {
-              result->UpdateStatus(copy_status);
-              break;
-            }
+          mutex_lock l(result->mu);
+          result->num_elements++;
+        }
+        CallCompleted(result);
+      }
+
+      // Writes `value`, the `index`-th return value of the call for the
+      // `offset`-th element of `result`, into its slice of the batch.
+      Status WriteReturnValue(const std::shared_ptr<IteratorContext>& ctx,
+                              const std::shared_ptr<BatchResult>& result,
+                              int64 offset, int index, const Tensor& value) {
+        Tensor* batch;
+        {
+          mutex_lock l(result->mu);
+          if (index >= result->output.size()) {
+            return errors::InvalidArgument(
+                "Map function returned more than ", result->output.size(),
+                " values.");
           }
-          {
-            mutex_lock l(result->mu);
-            result->num_elements++;
+          if (!result->allocated[index]) {
+            TensorShape component_shape({dataset()->batch_size_});
+            component_shape.AppendShape(value.shape());
+            AllocatorAttributes attr;
+            attr.set_gpu_compatible(true);
+            result->output[index] =
+                Tensor(ctx->allocator(attr), value.dtype(), component_shape);
+            result->allocated[index] = true;
+            result->output_allocated =
+                std::all_of(result->allocated.begin(),
+                            result->allocated.end(), [](bool b) { return b; });
           }
+          // The tensor is not reallocated, so it can be written without
+          // holding the lock; each call writes a distinct slice.
+          batch = &result->output[index];
         }
-        CallCompleted(result);
+        if (value.dtype() != batch->dtype() ||
+            value.NumElements() !=
+                (batch->NumElements() / batch->dim_size(0))) {
+          TensorShape batch_shape = batch->shape();
+          batch_shape.RemoveDim(0);
+          return errors::InvalidArgument(
+              "Cannot add tensor to the batch: number of elements does not "
+              "match. Shapes are: [tensor]: ",
+              value.shape().DebugString(),
+              ", [batch]: ", batch_shape.DebugString());
+        }
+        // TODO(mrry): Add a version of DoParallelConcat that allows us to
+        // move `value` where possible, to speed up string tensor batching.
+        return ::tensorflow::functor::DoParallelConcat(*dataset()->device_,
+                                                       value, offset, batch);
       }
 
       void CallCompleted(const std::shared_ptr<BatchResult>& result)
@@ -351,17 +402,24 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
           return;
         }
 
-        // Call `captured_func_(input_element)`, using `Callback` to store the
-        // result in `result`.
+        // Call `captured_func_(input_element)`, which writes its return
+        // values straight into the batch of `result`, and use `Callback` to
+        // record the completion of the call.
         (*ctx->runner())(std::bind(
             [this, result, offset](std::shared_ptr<IteratorContext> ctx,
                                    std::vector<Tensor> input_element) {
-              std::shared_ptr<std::vector<Tensor>> return_values(
-                  new std::vector<Tensor>());
+              const int64 start_micros = ctx->env()->NowMicros();
               dataset()->captured_func_->RunAsync(
-                  ctx.get(), std::move(input_element), return_values.get(),
-                  [this, ctx, result, return_values, offset](Status status) {
-                    Callback(ctx, result, return_values, offset, status);
+                  ctx.get(), std::move(input_element),
+                  [this, ctx, result, offset](int index, const Tensor& value) {
+                    return WriteReturnValue(ctx, result, offset, index, value);
+                  },
+                  [this, ctx, result, start_micros](Status status) {
+                    if (model_node() != nullptr) {
+                      model_node()->add_processing_time(
+                          ctx->env()->NowMicros() - start_micros);
+                    }
+                    Callback(result, status);
                   });
             },
             ctx, std::move(input_element)));
@@ -398,29 +456,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
-      void EnsureOutputAllocated(
-          const std::shared_ptr<IteratorContext>& ctx,
-          const std::shared_ptr<BatchResult>& result,
-          const std::shared_ptr<std::vector<Tensor>>& return_values) {
-        mutex_lock l(result->mu);
-        if (result->output_allocated) {
-          return;
-        }
-        const size_t num_components = return_values->size();
-        for (size_t i = 0; i < num_components; ++i) {
-          TensorShape component_shape({dataset()->batch_size_});
-          component_shape.AppendShape(return_values->at(i).shape());
-          AllocatorAttributes attr;
-          attr.set_gpu_compatible(true);
-          Tensor component(ctx->allocator(attr), return_values->at(i).dtype(),
-                           component_shape);
-          result->output.emplace_back(std::move(component));
-        }
-        result->output_allocated = true;
-      }
-
       int MaxBatchResults() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        return (dataset()->num_parallel_calls_ + dataset()->batch_size_ - 1) /
+        return (num_parallel_calls_ + dataset()->batch_size_ - 1) /
                dataset()->batch_size_;
       }
 
@@ -472,12 +509,12 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       void RunnerThread(const std::shared_ptr<IteratorContext>& ctx)
           LOCKS_EXCLUDED(mu_) {
         std::vector<std::pair<std::shared_ptr<BatchResult>, int64>> new_calls;
-        new_calls.reserve(dataset()->num_parallel_calls_);
+        new_calls.reserve(num_parallel_calls_);
         while (true) {
           {
             mutex_lock l(mu_);
             while (!cancelled_ &&
-                   (num_calls_ >= dataset()->num_parallel_calls_ ||
+                   (num_calls_ >= num_parallel_calls_ ||
                     batch_results_.size() > MaxBatchResults() ||
                     (batch_results_.size() == MaxBatchResults() &&
                      call_counter_ % dataset()->batch_size_ == 0))) {
@@ -488,13 +525,13 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
               return;
             }
 
-            while (num_calls_ < dataset()->num_parallel_calls_ &&
+            while (num_calls_ < num_parallel_calls_ &&
                    (batch_results_.size() < MaxBatchResults() ||
                     (batch_results_.size() == MaxBatchResults() &&
                      call_counter_ % dataset()->batch_size_ != 0))) {
               if (call_counter_ % dataset()->batch_size_ == 0) {
-                batch_results_.emplace_back(
-                    new BatchResult(dataset()->batch_size_));
+                batch_results_.emplace_back(new BatchResult(
+                    dataset()->batch_size_, dataset()->output_types_.size()));
               }
               int64 offset = call_counter_++ % dataset()->batch_size_;
               new_calls.emplace_back(batch_results_.back(), offset);
@@ -511,7 +548,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
 
       Status ReadBatchResult(IteratorContext* ctx, IteratorStateReader* reader,
                              size_t index) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        batch_results_.emplace_back(new BatchResult(dataset()->batch_size_));
+        batch_results_.emplace_back(new BatchResult(
+            dataset()->batch_size_, dataset()->output_types_.size()));
         std::shared_ptr<BatchResult> result = batch_results_.back();
         string prefix = strings::StrCat("batch_results_", index);
         mutex_lock l(result->mu);
@@ -528,7 +566,14 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         int64 output_size;
         TF_RETURN_IF_ERROR(reader->ReadScalar(
             full_name(strings::StrCat(prefix, "_output_size")), &output_size));
+        if (output_size == 0) {
+          // No call has returned a value for the batch yet.
+          return ReadStatus(reader, strings::StrCat(prefix, "_status"),
+                            &result->status);
+        }
+        result->output.clear();
         result->output.reserve(output_size);
+        result->allocated.assign(output_size, true);
         for (int i = 0; i < output_size; i++) {
           Tensor t;
           TF_RETURN_IF_ERROR(reader->ReadTensor(
@@ -591,10 +636,12 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               full_name(strings::StrCat(prefix, "_output_allocated")), ""));
         }
+        // Only a batch whose tensors have all been allocated stores them.
+        const size_t output_size =
+            result->output_allocated ? result->output.size() : 0;
         TF_RETURN_IF_ERROR(writer->WriteScalar(
-            full_name(strings::StrCat(prefix, "_output_size")),
-            result->output.size()));
-        for (int i = 0; i < result->output.size(); i++) {
+            full_name(strings::StrCat(prefix, "_output_size")), output_size));
+        for (int i = 0; i < output_size; i++) {
           // If the batch is not full, we only store the first `num_elements`
           // values. The rest of the batch tensor is *uninitialized* and
           // accessing that will raise msan errors.
@@ -635,6 +682,9 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       // user specified level of parallelism and there are slots available in
       // the `batch_results_` buffer.
       condition_variable cond_var_;
+      // The number of calls to run in parallel; chosen by the model of the
+      // pipeline if the dataset asks for `model::kAutoTune`.
+      std::atomic<int64> num_parallel_calls_;
       // Counts the number of outstanding calls for this batch.
       int64 num_calls_ GUARDED_BY(mu_) = 0;
       // Counts the total number of calls.
@@ -249,6 +249,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        if (model_node() != nullptr) model_node()->set_asynchronous();
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
@@ -477,7 +478,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             worker_threads_.emplace_back(ctx->env()->StartThread(
                 {}, "worker_thread",
                 std::bind(&Iterator::WorkerThread, this,
-                          new IteratorContext(*ctx), i)));
+                          NewWorkerContext(ctx), i)));
           }
         }
         return Status::OK();
@@ -560,6 +561,18 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         WorkerThreadState() : output_elem(Status::OK()) {}
       };
 
+      // Returns a copy of `ctx` for a worker thread. With a scheduler, the
+      // kernels that the worker runs, e.g. those of `f`, are scheduled on it
+      // rather than on the runner of `ctx`.
+      static IteratorContext* NewWorkerContext(IteratorContext* ctx) {
+        IteratorContext* worker_ctx = new IteratorContext(*ctx);
+        if (ctx->scheduler() != nullptr) {
+          *worker_ctx->runner() =
+              ctx->scheduler()->Runner(DatasetScheduler::kMaxPriority);
+        }
+        return worker_ctx;
+      }
+
       Status EnsureWorkerThreadsStarted(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (worker_threads_.empty()) {
@@ -576,7 +589,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             worker_threads_.emplace_back(ctx->env()->StartThread(
                 {}, "worker_thread",
                 std::bind(&Iterator::WorkerThread, this,
-                          new IteratorContext(*ctx), i)));
+                          NewWorkerContext(ctx), i)));
             if (i < dataset()->cycle_length_) {
               interleave_indices_.push_back(i);
             } else {
@@ -15,12 +15,14 @@ limitations under the License.
 #include <deque>
 
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
 #include "tensorflow/core/kernels/data/dataset.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace tensorflow {
 
@@ -53,9 +55,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
     int32 num_parallel_calls;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                             &num_parallel_calls));
-    OP_REQUIRES(ctx, num_parallel_calls > 0,
+    OP_REQUIRES(ctx,
+                num_parallel_calls > 0 ||
+                    num_parallel_calls == model::kAutoTune,
                 errors::InvalidArgument(
-                    "num_parallel_calls must be greater than zero."));
+                    "num_parallel_calls must be greater than zero, or ",
+                    model::kAutoTune, " to tune it automatically."));
 
     std::unique_ptr<CapturedFunction> captured_func;
     OP_REQUIRES_OK(ctx, CapturedFunction::Create(
@@ -151,7 +156,8 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            num_parallel_calls_(params.dataset->num_parallel_calls_) {}
 
       ~Iterator() override {
         // TODO(mrry): Replace this cancellation logic with a
@@ -164,12 +170,25 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         cancelled_ = true;
         cond_var_.notify_all();
         // Wait for all in-flight calls to complete.
-        while (num_calls_ > 0) {
+        while (num_calls_ > 0 || fetching_) {
           cond_var_.wait(l);
         }
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        scheduler_ = ctx->scheduler();
+        if (num_parallel_calls_ == model::kAutoTune) {
+          if (model_node() != nullptr) {
+            num_parallel_calls_ = 1;
+            model_node()->add_tunable_parallelism(&num_parallel_calls_, 1,
+                                                  port::NumSchedulableCPUs(),
+                                                  &mu_, &cond_var_);
+          } else {
+            num_parallel_calls_ = port::NumSchedulableCPUs();
+          }
+        } else if (model_node() != nullptr) {
+          model_node()->set_asynchronous();
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
@@ -180,11 +199,15 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         {
           mutex_lock l(mu_);
           EnsureRunnerThreadStarted(ctx);
+          if (model_node() != nullptr) {
+            model_node()->record_buffer_size(invocation_results_.size());
+          }
           while (invocation_results_.empty()) {
             cond_var_.wait(l);
           }
           std::swap(result, invocation_results_.front());
           invocation_results_.pop_front();
+          MaybeScheduleCallsLocked();
         }
         cond_var_.notify_all();
         result->notification.WaitForNotification();
@@ -274,6 +297,17 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
 
       void EnsureRunnerThreadStarted(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (scheduler_ != nullptr) {
+          if (!runner_ctx_) {
+            runner_ctx_.reset(new IteratorContext(*ctx));
+            // The kernels of `func_` finish calls that are already in flight,
+            // so they run before new calls are started.
+            *runner_ctx_->runner() =
+                scheduler_->Runner(DatasetScheduler::kMaxPriority);
+          }
+          MaybeScheduleCallsLocked();
+          return;
+        }
         if (!runner_thread_) {
           std::shared_ptr<IteratorContext> ctx_copy(new IteratorContext(*ctx));
           runner_thread_.reset(ctx->env()->StartThread(
@@ -287,6 +321,7 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         {
           mutex_lock l(mu_);
           num_calls_--;
+          MaybeScheduleCallsLocked();
         }
         result->notification.Notify();
         cond_var_.notify_all();
@@ -307,7 +342,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         // Call `func_(input_element)`, store the result in
         // `result->return_values`, and notify `result->notification` to unblock
         // a consumer.
-        auto done = [this, result](Status status) {
+        const int64 start_micros = ctx->env()->NowMicros();
+        auto done = [this, ctx, result, start_micros](Status status) {
+          if (model_node() != nullptr) {
+            model_node()->add_processing_time(ctx->env()->NowMicros() -
+                                              start_micros);
+          }
           result->status.Update(status);
           CallCompleted(result);
         };
@@ -315,7 +355,7 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
                                             &result->return_values, done);
       }
 
-      int64 MaxInvocationResults() { return dataset()->num_parallel_calls_; }
+      int64 MaxInvocationResults() { return num_parallel_calls_; }
 
       Status ProcessResult(const std::shared_ptr<InvocationResult>& result,
                            std::vector<Tensor>* out_tensors,
@@ -335,26 +375,73 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         return result->status;
       }
 
+      bool HasCapacityLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return num_calls_ < num_parallel_calls_ &&
+               invocation_results_.size() < MaxInvocationResults();
+      }
+
+      void StartCallsLocked(
+          std::vector<std::shared_ptr<InvocationResult>>* new_calls)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (HasCapacityLocked()) {
+          invocation_results_.emplace_back(new InvocationResult());
+          new_calls->push_back(invocation_results_.back());
+          num_calls_++;
+        }
+      }
+
       void RunnerThread(const std::shared_ptr<IteratorContext>& ctx) {
         std::vector<std::shared_ptr<InvocationResult>> new_calls;
-        new_calls.reserve(dataset()->num_parallel_calls_);
+        new_calls.reserve(num_parallel_calls_);
         while (true) {
           {
             mutex_lock l(mu_);
-            while (!cancelled_ &&
-                   (num_calls_ >= dataset()->num_parallel_calls_ ||
-                    invocation_results_.size() >= MaxInvocationResults())) {
+            while (!cancelled_ && !HasCapacityLocked()) {
               cond_var_.wait(l);
             }
             if (cancelled_) {
               return;
             }
-            while (num_calls_ < dataset()->num_parallel_calls_ &&
-                   invocation_results_.size() < MaxInvocationResults()) {
-              invocation_results_.emplace_back(new InvocationResult());
-              new_calls.push_back(invocation_results_.back());
-              num_calls_++;
+            StartCallsLocked(&new_calls);
+          }
+          cond_var_.notify_all();
+          for (const auto& call : new_calls) {
+            CallFunction(ctx, call);
+          }
+          new_calls.clear();
+        }
+      }
+
+      // With a scheduler, schedules a task that does what one iteration of
+      // RunnerThread() does until there is no capacity left, unless such a
+      // task is already queued or running.
+      void MaybeScheduleCallsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (scheduler_ == nullptr || !runner_ctx_ || fetching_ ||
+            cancelled_ || !HasCapacityLocked()) {
+          return;
+        }
+        fetching_ = true;
+        scheduler_->Schedule(
+            [this]() { FetchInputs(); },
+            DatasetScheduler::PriorityFromBufferFill(
+                invocation_results_.size(), MaxInvocationResults()));
+      }
+
+      void FetchInputs() LOCKS_EXCLUDED(mu_) {
+        std::vector<std::shared_ptr<InvocationResult>> new_calls;
+        std::shared_ptr<IteratorContext> ctx;
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            if (cancelled_ || !HasCapacityLocked()) {
+              fetching_ = false;
+              // Notify while holding `mu_`, as the destructor may run as
+              // soon as it is released.
+              cond_var_.notify_all();
+              return;
             }
+            ctx = runner_ctx_;
+            StartCallsLocked(&new_calls);
           }
           cond_var_.notify_all();
           for (const auto& call : new_calls) {
@@ -411,6 +498,9 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
       // parallelism and there are slots available in the `invocation_results_`
       // buffer.
       condition_variable cond_var_;
+      // The number of calls to run in parallel; chosen by the model of the
+      // pipeline if the dataset asks for `model::kAutoTune`.
+      std::atomic<int64> num_parallel_calls_;
       // Counts the number of outstanding calls.
       int64 num_calls_ GUARDED_BY(mu_) = 0;
       std::unique_ptr<IteratorBase> input_impl_;
@@ -419,6 +509,13 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
           GUARDED_BY(mu_);
       std::unique_ptr<Thread> runner_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
+      // If set, the runner thread is replaced by FetchInputs() tasks on this
+      // pipeline of the process-wide scheduler.
+      std::shared_ptr<DatasetScheduler::Pipeline> scheduler_;
+      // The context of the calls run by FetchInputs().
+      std::shared_ptr<IteratorContext> runner_ctx_ GUARDED_BY(mu_);
+      // Whether a FetchInputs() task is queued or running.
+      bool fetching_ GUARDED_BY(mu_) = false;
     };
 
     const DatasetBase* const input_;
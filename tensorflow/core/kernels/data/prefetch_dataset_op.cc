@@ -14,10 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include <deque>
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/dataset.h"
 #include "tensorflow/core/kernels/data/prefetch_autotuner.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 
 namespace tensorflow {
@@ -26,11 +28,17 @@ namespace {
 
 // See documentation in ../ops/dataset_ops.cc for a high-level
 // description of the following op.
+//
+// When the op is placed on a GPU and iterated by an iterator on a GPU, the
+// prefetched elements are copied to the GPU ahead of time, so that
+// IteratorGetNext returns tensors that are already in device memory. The
+// prefetch must then be the last transformation of the pipeline.
 
 class PrefetchDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit PrefetchDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx),
+        on_gpu_(ctx->device_type() == DEVICE_GPU) {}
 
  protected:
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -42,14 +50,18 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
                 buffer_size >= 0 || buffer_size == PrefetchAutotuner::kAutoTune,
                 errors::InvalidArgument("buffer_size must be >= 0"));
 
-    *output = new Dataset(ctx, input, buffer_size);
+    *output = new Dataset(ctx, input, buffer_size, on_gpu_);
   }
 
  private:
   class Dataset : public GraphDatasetBase {
    public:
-    Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size)
-        : GraphDatasetBase(ctx), input_(input), buffer_size_(buffer_size) {
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
+            bool on_gpu)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          buffer_size_(buffer_size),
+          on_gpu_(on_gpu) {
       input_->Ref();
     }
 
@@ -106,6 +118,14 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
       }
 
       Status Initialize(IteratorContext* ctx) override {
+        if (model_node() != nullptr) model_node()->set_asynchronous();
+        if (dataset()->on_gpu_ && ctx->lib() != nullptr) {
+          Device* device = ctx->lib()->device();
+          if (device->device_type() == DEVICE_GPU &&
+              device->tensorflow_gpu_device_info() != nullptr) {
+            device_ = device;
+          }
+        }
         return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
       }
 
@@ -115,6 +135,9 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
         {
           mutex_lock l(mu_);
           TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
+          if (model_node() != nullptr) {
+            model_node()->record_buffer_size(buffer_.size());
+          }
           // Wait until the next element in the buffer has been
           // produced, or we are shutting down.
           while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
@@ -203,6 +226,7 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
                   full_name(strings::StrCat("buffer[", i, "][", j, "]")),
                   &buffer_element.value.back()));
             }
+            TF_RETURN_IF_ERROR(MaybeCopyToDevice(&buffer_element));
           }
         }
         return Status::OK();
@@ -216,6 +240,10 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
         Status status;
         // The buffered data element.
         std::vector<Tensor> value;
+        // The buffered data element with its tensors in device memory, if
+        // the element has been copied to `device_`. `value` is kept for
+        // SaveInternal().
+        std::vector<Tensor> device_value;
       };
 
       Status Consume(std::vector<Tensor>* out_tensors, bool* end_of_sequence)
@@ -224,7 +252,11 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
         // (if we successfully got an element) the output values.
         Status s = buffer_.front().status;
         if (s.ok()) {
-          *out_tensors = std::move(buffer_.front().value);
+          if (device_ != nullptr) {
+            *out_tensors = std::move(buffer_.front().device_value);
+          } else {
+            *out_tensors = std::move(buffer_.front().value);
+          }
         }
         buffer_.pop_front();
         *end_of_sequence = false;
@@ -288,6 +320,9 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
             cond_var_.notify_all();
             return;
           }
+          if (buffer_element.status.ok()) {
+            buffer_element.status = MaybeCopyToDevice(&buffer_element);
+          }
 
           // 3. Signal that the element has been produced.
           {
@@ -298,6 +333,53 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
+      // Copies the tensors of `element` that a GPU kernel expects in device
+      // memory to `device_`, on the device's host-to-device stream, and
+      // waits for the copies to complete. Other tensors, e.g. int32 ones,
+      // are shared with `element->value`.
+      Status MaybeCopyToDevice(BufferElement* element) {
+        if (device_ == nullptr) return Status::OK();
+        const std::vector<Tensor>& value = element->value;
+        std::vector<Tensor>* device_value = &element->device_value;
+        device_value->resize(value.size());
+        DeviceContext* device_context =
+            device_->tensorflow_gpu_device_info()->default_context;
+        Allocator* allocator = device_->GetAllocator(AllocatorAttributes());
+        mutex status_mu;
+        Status status;
+        BlockingCounter counter(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+          const Tensor& tensor = value[i];
+          if (MTypeFromDType(tensor.dtype()) == HOST_MEMORY ||
+              !DataTypeCanUseMemcpy(tensor.dtype())) {
+            (*device_value)[i] = tensor;
+            counter.DecrementCount();
+            continue;
+          }
+          Tensor* device_tensor = &(*device_value)[i];
+          *device_tensor = Tensor(allocator, tensor.dtype(), tensor.shape());
+          if (!device_tensor->IsInitialized()) {
+            mutex_lock l(status_mu);
+            status.Update(errors::ResourceExhausted(
+                "OOM when prefetching a tensor of shape ",
+                tensor.shape().DebugString(), " to ", device_->name()));
+            counter.DecrementCount();
+            continue;
+          }
+          device_context->CopyCPUTensorToDevice(
+              &tensor, device_, device_tensor,
+              [&status_mu, &status, &counter](const Status& s) {
+                {
+                  mutex_lock l(status_mu);
+                  status.Update(s);
+                }
+                counter.DecrementCount();
+              });
+        }
+        counter.Wait();
+        return status;
+      }
+
       Status WriteStatus(IteratorStateWriter* writer, size_t index,
                          const Status& status) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(
@@ -342,6 +424,9 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
       // allow prefetching to run in parallel with GetNext calls.
       mutex parent_mu_ ACQUIRED_BEFORE(mu_);
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(parent_mu_);
+      // The GPU to which elements are prefetched, or nullptr if they stay in
+      // host memory. Set in Initialize().
+      Device* device_ = nullptr;
       condition_variable cond_var_;
       PrefetchAutotuner auto_tuner_ GUARDED_BY(mu_);
       std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
@@ -352,7 +437,10 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
 
     const DatasetBase* const input_;
     const int64 buffer_size_;
+    const bool on_gpu_;
   };
+
+  const bool on_gpu_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("PrefetchDataset").Device(DEVICE_CPU),
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -500,6 +501,9 @@ class TFRecordDatasetOp : public DatasetOpKernel {
  public:
   using DatasetOpKernel::DatasetOpKernel;
 
+  // Keeps 1MB in flight per file with the default 256KB buffer.
+  static constexpr int64 kDefaultReadaheadNumChunks = 4;
+
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
     const Tensor* filenames_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
@@ -524,15 +528,22 @@ class TFRecordDatasetOp : public DatasetOpKernel {
                 errors::InvalidArgument(
                     "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-    *output =
-        new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+    // The number of buffers read ahead of the current record, in parallel.
+    int64 readahead_num_chunks = 0;
+    OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar("TF_DATA_TFRECORD_READAHEAD_CHUNKS",
+                                            kDefaultReadaheadNumChunks,
+                                            &readahead_num_chunks));
+
+    *output = new Dataset(ctx, std::move(filenames), compression_type,
+                          buffer_size, readahead_num_chunks);
   }
 
  private:
   class Dataset : public GraphDatasetBase {
    public:
     explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                     const string& compression_type, int64 buffer_size)
+                     const string& compression_type, int64 buffer_size,
+                     int64 readahead_num_chunks)
         : GraphDatasetBase(ctx),
           filenames_(std::move(filenames)),
           compression_type_(compression_type),
@@ -540,6 +551,7 @@ class TFRecordDatasetOp : public DatasetOpKernel {
               compression_type)) {
       if (buffer_size > 0) {
         options_.buffer_size = buffer_size;
+        options_.readahead_num_chunks = readahead_num_chunks;
       }
     }
 
@@ -0,0 +1,448 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/sharded_cache.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The first bytes of every index file.
+constexpr char kIndexMagic[] = "tfdcache";
+constexpr size_t kIndexMagicSize = sizeof(kIndexMagic) - 1;
+
+// An index entry is the index of the element, the offset and the length of
+// its record, and the masked crc32c of these fields.
+constexpr size_t kIndexEntrySize = 3 * sizeof(uint64) + sizeof(uint32);
+// The index of the entry that records the number of elements in its offset.
+constexpr int64 kNumElementsEntry = -1;
+
+// How the contents of a tensor are stored.
+enum Encoding : uint32 {
+  // The bytes of the buffer of a tensor with a memcpy-able type.
+  kRaw = 0,
+  // A serialized TensorProto.
+  kProto = 1,
+};
+
+// The alignment of the contents of tensors in the data files.
+constexpr uint64 kAlignment = Allocator::kAllocatorAlignment;
+
+uint64 PaddingSize(uint64 offset) {
+  return (kAlignment - offset % kAlignment) % kAlignment;
+}
+
+string DataFilename(StringPiece index_filename) {
+  StringPiece shard_prefix = index_filename;
+  shard_prefix.remove_suffix(strlen(".index"));
+  return strings::StrCat(shard_prefix, ".data");
+}
+
+// Reads a file into aligned memory, for file systems that cannot map files.
+class AlignedMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit AlignedMemoryRegion(uint64 length)
+      : data_(port::AlignedMalloc(length, kAlignment)), length_(length) {}
+  ~AlignedMemoryRegion() override { port::AlignedFree(data_); }
+
+  static Status Read(Env* env, const string& filename, uint64 length,
+                     std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+    std::unique_ptr<AlignedMemoryRegion> result(
+        new AlignedMemoryRegion(length));
+    char* scratch = static_cast<char*>(result->data_);
+    StringPiece contents;
+    TF_RETURN_IF_ERROR(file->Read(0, length, &contents, scratch));
+    if (contents.size() != length) {
+      return errors::DataLoss("Read ", contents.size(), " instead of ", length,
+                              " bytes from ", filename);
+    }
+    if (contents.data() != scratch) {
+      memcpy(scratch, contents.data(), length);
+    }
+    *region = std::move(result);
+    return Status::OK();
+  }
+
+  const void* data() override { return data_; }
+  uint64 length() override { return length_; }
+
+ private:
+  void* const data_;
+  const uint64 length_;
+};
+
+// Refers to the contents of a tensor in a data file. Keeps the file mapped
+// for as long as the tensor is alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : region_(std::move(region)), data_(data), size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+
+  // Prevents input forwarding from overwriting the mapped file.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const size_t size_;
+};
+
+// Reads the fields of a record, checking that they lie within the record.
+class RecordDecoder {
+ public:
+  RecordDecoder(const char* base, uint64 offset, uint64 length)
+      : base_(base), offset_(offset), limit_(offset + length) {}
+
+  bool ReadFixed32(uint32* value) {
+    const char* p;
+    if (!Skip(sizeof(*value), &p)) return false;
+    *value = core::DecodeFixed32(p);
+    return true;
+  }
+
+  bool ReadFixed64(uint64* value) {
+    const char* p;
+    if (!Skip(sizeof(*value), &p)) return false;
+    *value = core::DecodeFixed64(p);
+    return true;
+  }
+
+  // Skips the padding before the contents of a tensor.
+  bool Align() {
+    const char* p;
+    return Skip(PaddingSize(offset_), &p);
+  }
+
+  // Skips `n` bytes, and sets `*data` to the first of them.
+  bool Skip(uint64 n, const char** data) {
+    if (n > limit_ - offset_) return false;
+    *data = base_ + offset_;
+    offset_ += n;
+    return true;
+  }
+
+ private:
+  const char* const base_;
+  uint64 offset_;
+  const uint64 limit_;
+};
+
+}  // namespace
+
+Status ShardedCacheWriter::Create(Env* env, const string& prefix,
+                                  std::unique_ptr<ShardedCacheWriter>* writer) {
+  const StringPiece dirname = io::Dirname(prefix);
+  if (!dirname.empty()) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dirname.ToString()));
+  }
+  const string shard_prefix =
+      strings::StrCat(prefix, ".shard-",
+                      strings::Hex(random::New64(), strings::ZERO_PAD_16));
+  std::unique_ptr<WritableFile> data_file;
+  TF_RETURN_IF_ERROR(
+      env->NewWritableFile(strings::StrCat(shard_prefix, ".data"), &data_file));
+  std::unique_ptr<WritableFile> index_file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(
+      strings::StrCat(shard_prefix, ".index"), &index_file));
+  TF_RETURN_IF_ERROR(
+      index_file->Append(StringPiece(kIndexMagic, kIndexMagicSize)));
+  writer->reset(
+      new ShardedCacheWriter(std::move(data_file), std::move(index_file)));
+  return Status::OK();
+}
+
+ShardedCacheWriter::ShardedCacheWriter(std::unique_ptr<WritableFile> data_file,
+                                       std::unique_ptr<WritableFile> index_file)
+    : data_file_(std::move(data_file)), index_file_(std::move(index_file)) {}
+
+ShardedCacheWriter::~ShardedCacheWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close cache shard: " << s;
+  }
+}
+
+Status ShardedCacheWriter::Add(int64 index,
+                               const std::vector<Tensor>& element) {
+  if (closed_) {
+    return errors::FailedPrecondition("The cache shard is closed.");
+  }
+  const uint64 offset = offset_;
+  string header;
+  core::PutFixed32(&header, element.size());
+  for (const Tensor& t : element) {
+    const bool raw = DataTypeCanUseMemcpy(t.dtype());
+    string serialized;
+    if (!raw) {
+      TensorProto proto;
+      t.AsProtoField(&proto);
+      if (!proto.SerializeToString(&serialized)) {
+        return errors::Internal("Failed to serialize tensor of type ",
+                                DataTypeString(t.dtype()));
+      }
+    }
+    const StringPiece contents = raw ? t.tensor_data() : serialized;
+    core::PutFixed32(&header, t.dtype());
+    core::PutFixed32(&header, raw ? kRaw : kProto);
+    core::PutFixed32(&header, t.dims());
+    for (int i = 0; i < t.dims(); ++i) {
+      core::PutFixed64(&header, t.dim_size(i));
+    }
+    core::PutFixed64(&header, contents.size());
+    header.append(PaddingSize(offset_ + header.size()), '\0');
+    TF_RETURN_IF_ERROR(Append(header));
+    TF_RETURN_IF_ERROR(Append(contents));
+    header.clear();
+  }
+  return AppendIndexEntry(index, offset, offset_ - offset);
+}
+
+Status ShardedCacheWriter::Flush() {
+  if (closed_) return Status::OK();
+  // The entries of the index must not refer to unflushed records.
+  TF_RETURN_IF_ERROR(data_file_->Flush());
+  return index_file_->Flush();
+}
+
+Status ShardedCacheWriter::Finish(int64 num_elements) {
+  if (closed_) {
+    return errors::FailedPrecondition("The cache shard is closed.");
+  }
+  TF_RETURN_IF_ERROR(AppendIndexEntry(kNumElementsEntry, num_elements, 0));
+  return Close();
+}
+
+Status ShardedCacheWriter::Append(StringPiece data) {
+  TF_RETURN_IF_ERROR(data_file_->Append(data));
+  offset_ += data.size();
+  return Status::OK();
+}
+
+Status ShardedCacheWriter::AppendIndexEntry(int64 index, uint64 offset,
+                                            uint64 length) {
+  string entry;
+  core::PutFixed64(&entry, index);
+  core::PutFixed64(&entry, offset);
+  core::PutFixed64(&entry, length);
+  core::PutFixed32(&entry,
+                   crc32c::Mask(crc32c::Value(entry.data(), entry.size())));
+  return index_file_->Append(entry);
+}
+
+Status ShardedCacheWriter::Close() {
+  if (closed_) return Status::OK();
+  closed_ = true;
+  TF_RETURN_IF_ERROR(data_file_->Close());
+  return index_file_->Close();
+}
+
+Status ShardedCacheReader::Open(Env* env, const string& prefix,
+                                std::unique_ptr<ShardedCacheReader>* reader) {
+  std::vector<string> index_filenames;
+  Status s = env->GetMatchingPaths(strings::StrCat(prefix, ".shard-*.index"),
+                                   &index_filenames);
+  if (!s.ok() && !errors::IsNotFound(s)) return s;
+  // Visit the shards in a deterministic order, so that all readers agree on
+  // where each element is read from.
+  std::sort(index_filenames.begin(), index_filenames.end());
+  std::unique_ptr<ShardedCacheReader> result(new ShardedCacheReader);
+  for (const string& index_filename : index_filenames) {
+    TF_RETURN_IF_ERROR(result->AddShard(env, index_filename));
+  }
+  if (result->num_elements_ >= 0 &&
+      result->locations_.size() > result->num_elements_) {
+    result->locations_.resize(result->num_elements_);
+  }
+  while (result->num_contiguous_elements_ < result->locations_.size() &&
+         result->Contains(result->num_contiguous_elements_)) {
+    ++result->num_contiguous_elements_;
+  }
+  *reader = std::move(result);
+  return Status::OK();
+}
+
+bool ShardedCacheReader::Exists(Env* env, const string& prefix) {
+  std::vector<string> index_filenames;
+  return env
+             ->GetMatchingPaths(strings::StrCat(prefix, ".shard-*.index"),
+                                &index_filenames)
+             .ok() &&
+         !index_filenames.empty();
+}
+
+Status ShardedCacheReader::AddShard(Env* env, const string& index_filename) {
+  string index;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, index_filename, &index));
+  if (index.size() < kIndexMagicSize) {
+    // The writer of the shard has not flushed anything yet.
+    return Status::OK();
+  }
+  if (StringPiece(index.data(), kIndexMagicSize) !=
+      StringPiece(kIndexMagic, kIndexMagicSize)) {
+    return errors::DataLoss(index_filename, " is not a cache index.");
+  }
+
+  // Map the data file after reading the index, so that it covers all the
+  // records the index refers to.
+  const string data_filename = DataFilename(index_filename);
+  uint64 data_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(data_filename, &data_size));
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  if (data_size > 0) {
+    Status s = env->NewReadOnlyMemoryRegionFromFile(data_filename, &region);
+    if (errors::IsUnimplemented(s)) {
+      s = AlignedMemoryRegion::Read(env, data_filename, data_size, &region);
+    }
+    TF_RETURN_IF_ERROR(s);
+    data_size = std::min<uint64>(data_size, region->length());
+  }
+
+  const int32 shard = shards_.size();
+  for (size_t pos = kIndexMagicSize; pos + kIndexEntrySize <= index.size();
+       pos += kIndexEntrySize) {
+    const char* entry = index.data() + pos;
+    const uint32 crc = core::DecodeFixed32(entry + 3 * sizeof(uint64));
+    if (crc32c::Unmask(crc) !=
+        crc32c::Value(entry, kIndexEntrySize - sizeof(uint32))) {
+      LOG(WARNING) << "Ignoring the entries after offset " << pos << " of "
+                   << index_filename << ", which are corrupt.";
+      break;
+    }
+    const int64 element_index = core::DecodeFixed64(entry);
+    const uint64 offset = core::DecodeFixed64(entry + sizeof(uint64));
+    const uint64 length = core::DecodeFixed64(entry + 2 * sizeof(uint64));
+    if (element_index == kNumElementsEntry) {
+      const int64 num_elements = offset;
+      if (num_elements_ < 0) {
+        num_elements_ = num_elements;
+      } else if (num_elements_ != num_elements) {
+        LOG(WARNING) << index_filename << " records " << num_elements
+                     << " elements, but another shard of the cache recorded "
+                     << num_elements_ << " elements. Are the writers of the "
+                     << "cache producing the same dataset?";
+      }
+      continue;
+    }
+    if (element_index < 0 || offset > data_size ||
+        length > data_size - offset) {
+      LOG(WARNING) << "Ignoring the entries after offset " << pos << " of "
+                   << index_filename << ", which refer past the end of "
+                   << data_filename;
+      break;
+    }
+    if (element_index >= locations_.size()) {
+      locations_.resize(element_index + 1);
+    }
+    Location* location = &locations_[element_index];
+    if (location->shard < 0) {
+      location->shard = shard;
+      location->offset = offset;
+      location->length = length;
+    }
+  }
+  shards_.push_back(std::move(region));
+  return Status::OK();
+}
+
+Status ShardedCacheReader::Read(int64 index,
+                                std::vector<Tensor>* element) const {
+  if (!Contains(index)) {
+    return errors::NotFound("Element ", index, " is not in the cache.");
+  }
+  const Location& location = locations_[index];
+  const std::shared_ptr<ReadOnlyMemoryRegion>& region = shards_[location.shard];
+  RecordDecoder decoder(static_cast<const char*>(region->data()),
+                        location.offset, location.length);
+  auto corrupt = [index]() {
+    return errors::DataLoss("The record of element ", index,
+                            " in the cache is corrupt.");
+  };
+
+  uint32 num_components;
+  if (!decoder.ReadFixed32(&num_components)) return corrupt();
+  element->clear();
+  element->reserve(num_components);
+  for (uint32 i = 0; i < num_components; ++i) {
+    uint32 dtype, encoding, rank;
+    if (!decoder.ReadFixed32(&dtype) || !decoder.ReadFixed32(&encoding) ||
+        !decoder.ReadFixed32(&rank) || rank > TensorShape::MaxDimensions()) {
+      return corrupt();
+    }
+    gtl::InlinedVector<int64, 4> dims(rank);
+    for (uint32 d = 0; d < rank; ++d) {
+      uint64 dim;
+      if (!decoder.ReadFixed64(&dim)) return corrupt();
+      dims[d] = dim;
+    }
+    TensorShape shape;
+    if (!TensorShapeUtils::MakeShape(dims, &shape).ok()) return corrupt();
+    uint64 num_bytes;
+    const char* contents;
+    if (!decoder.ReadFixed64(&num_bytes) || !decoder.Align() ||
+        !decoder.Skip(num_bytes, &contents)) {
+      return corrupt();
+    }
+    const DataType type = static_cast<DataType>(dtype);
+    if (encoding == kRaw) {
+      if (!DataTypeCanUseMemcpy(type) ||
+          num_bytes != shape.num_elements() * DataTypeSize(type)) {
+        return corrupt();
+      }
+      MappedTensorBuffer* buf =
+          new MappedTensorBuffer(region, contents, num_bytes);
+      element->push_back(Tensor(type, shape, buf));
+      buf->Unref();
+    } else if (encoding == kProto) {
+      TensorProto proto;
+      Tensor t;
+      if (num_bytes > kint32max || !proto.ParseFromArray(contents, num_bytes) ||
+          !t.FromProto(proto) || t.dtype() != type || t.shape() != shape) {
+        return corrupt();
+      }
+      element->push_back(std::move(t));
+    } else {
+      return corrupt();
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
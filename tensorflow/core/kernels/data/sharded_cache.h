@@ -0,0 +1,143 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SHARDED_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SHARDED_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A file cache of the elements of a dataset, stored in shards that are
+// written independently and read back with random access.
+//
+// Each writer appends to its own shard, so any number of writers, e.g. the
+// workers of several jobs, can fill a cache concurrently. A shard consists
+// of two append-only files:
+//
+// * `<prefix>.shard-<id>.data` holds the records of the elements. The
+//   contents of tensors of memcpy-able types are aligned so that readers can
+//   use them in place.
+// * `<prefix>.shard-<id>.index` maps the indices of the elements in the
+//   dataset to the offsets of their records, and records the number of
+//   elements of the dataset once a writer has seen all of them. Every entry
+//   has a checksum, so that the entries a writer has flushed before dying
+//   can be read back.
+//
+// Readers map the data files into memory, so the tensors they return refer
+// to the file contents without copying them.
+
+// Appends elements to a new shard of the cache with prefix `prefix`.
+//
+// Not thread-safe.
+class ShardedCacheWriter {
+ public:
+  static Status Create(Env* env, const string& prefix,
+                       std::unique_ptr<ShardedCacheWriter>* writer);
+
+  // Flushes and closes the shard.
+  ~ShardedCacheWriter();
+
+  // Appends `element`, the `index`-th element of the dataset.
+  Status Add(int64 index, const std::vector<Tensor>& element);
+
+  // Makes the elements added so far visible to readers.
+  Status Flush();
+
+  // Records that the dataset has `num_elements` elements, and closes the
+  // shard.
+  Status Finish(int64 num_elements);
+
+ private:
+  ShardedCacheWriter(std::unique_ptr<WritableFile> data_file,
+                     std::unique_ptr<WritableFile> index_file);
+
+  Status Append(StringPiece data);
+  Status AppendIndexEntry(int64 index, uint64 offset, uint64 length);
+  Status Close();
+
+  std::unique_ptr<WritableFile> data_file_;
+  std::unique_ptr<WritableFile> index_file_;
+  // The size of the data file.
+  uint64 offset_ = 0;
+  bool closed_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedCacheWriter);
+};
+
+// Reads the elements in all shards of the cache with prefix `prefix`, as
+// they were when the reader was opened.
+//
+// Thread-safe.
+class ShardedCacheReader {
+ public:
+  // Opens the cache. A cache without shards is empty.
+  static Status Open(Env* env, const string& prefix,
+                     std::unique_ptr<ShardedCacheReader>* reader);
+
+  // Returns true if any shard of the cache with prefix `prefix` exists.
+  static bool Exists(Env* env, const string& prefix);
+
+  // The number of elements of the dataset, or -1 if no writer has finished.
+  int64 num_elements() const { return num_elements_; }
+
+  // The number of elements from the start of the dataset that are cached.
+  int64 num_contiguous_elements() const { return num_contiguous_elements_; }
+
+  // Whether all elements of the dataset are cached.
+  bool complete() const {
+    return num_elements_ >= 0 && num_contiguous_elements_ >= num_elements_;
+  }
+
+  // Whether the `index`-th element of the dataset is cached.
+  bool Contains(int64 index) const {
+    return index >= 0 && index < locations_.size() &&
+           locations_[index].shard >= 0;
+  }
+
+  // Reads the `index`-th element of the dataset. Tensors of memcpy-able
+  // types refer to the mapped file and must not be modified.
+  Status Read(int64 index, std::vector<Tensor>* element) const;
+
+ private:
+  struct Location {
+    int32 shard = -1;
+    uint64 offset = 0;
+    uint64 length = 0;
+  };
+
+  ShardedCacheReader() {}
+
+  Status AddShard(Env* env, const string& index_filename);
+
+  // The mapped data files of the shards.
+  std::vector<std::shared_ptr<ReadOnlyMemoryRegion>> shards_;
+  // Indexed by the index of the element in the dataset.
+  std::vector<Location> locations_;
+  int64 num_elements_ = -1;
+  int64 num_contiguous_elements_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedCacheReader);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SHARDED_CACHE_H_
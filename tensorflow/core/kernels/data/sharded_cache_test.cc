@@ -0,0 +1,185 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/sharded_cache.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the prefix of a new cache.
+string Prefix(const string& name) {
+  const string dirname =
+      io::JoinPath(testing::TmpDir(), "sharded_cache_test", name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dirname, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return io::JoinPath(dirname, "cache");
+}
+
+std::vector<Tensor> MakeElement(int64 i) {
+  return {test::AsTensor<int64>({i, 2 * i}, {2}),
+          test::AsTensor<string>({strings::StrCat("element ", i)}, {1}),
+          test::AsScalar<float>(i / 2.0f)};
+}
+
+void ExpectElement(int64 i, const ShardedCacheReader& reader) {
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(reader.Read(i, &element));
+  std::vector<Tensor> expected = MakeElement(i);
+  ASSERT_EQ(expected.size(), element.size());
+  test::ExpectTensorEqual<int64>(expected[0], element[0]);
+  test::ExpectTensorEqual<string>(expected[1], element[1]);
+  test::ExpectTensorEqual<float>(expected[2], element[2]);
+}
+
+TEST(ShardedCacheTest, RoundTrip) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("round_trip");
+  {
+    std::unique_ptr<ShardedCacheWriter> writer;
+    TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &writer));
+    for (int64 i = 0; i < 10; ++i) {
+      TF_ASSERT_OK(writer->Add(i, MakeElement(i)));
+    }
+    TF_ASSERT_OK(writer->Finish(10));
+  }
+  EXPECT_TRUE(ShardedCacheReader::Exists(env, prefix));
+  std::unique_ptr<ShardedCacheReader> reader;
+  TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+  EXPECT_TRUE(reader->complete());
+  EXPECT_EQ(10, reader->num_elements());
+  // Read out of order, as a shuffling consumer would.
+  for (int64 i : {7, 0, 9, 3, 3, 5, 1, 2, 8, 6, 4}) {
+    ExpectElement(i, *reader);
+  }
+  std::vector<Tensor> element;
+  EXPECT_TRUE(errors::IsNotFound(reader->Read(10, &element)));
+}
+
+TEST(ShardedCacheTest, TensorsReferToAlignedFileContents) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("aligned");
+  {
+    std::unique_ptr<ShardedCacheWriter> writer;
+    TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &writer));
+    for (int64 i = 0; i < 3; ++i) {
+      TF_ASSERT_OK(writer->Add(i, MakeElement(i)));
+    }
+    TF_ASSERT_OK(writer->Finish(3));
+  }
+  std::unique_ptr<ShardedCacheReader> reader;
+  TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+  for (int64 i = 0; i < 3; ++i) {
+    std::vector<Tensor> first, second;
+    TF_ASSERT_OK(reader->Read(i, &first));
+    TF_ASSERT_OK(reader->Read(i, &second));
+    EXPECT_EQ(0, reinterpret_cast<intptr_t>(first[0].tensor_data().data()) %
+                     Allocator::kAllocatorAlignment);
+    // Both reads refer to the same bytes.
+    EXPECT_EQ(first[0].tensor_data().data(), second[0].tensor_data().data());
+  }
+}
+
+TEST(ShardedCacheTest, PartialCache) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("partial");
+  std::unique_ptr<ShardedCacheWriter> writer;
+  TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &writer));
+  for (int64 i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(writer->Add(i, MakeElement(i)));
+  }
+  TF_ASSERT_OK(writer->Flush());
+
+  // The writer is still running, but the flushed elements can be read.
+  std::unique_ptr<ShardedCacheReader> reader;
+  TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+  EXPECT_FALSE(reader->complete());
+  EXPECT_EQ(-1, reader->num_elements());
+  EXPECT_EQ(4, reader->num_contiguous_elements());
+  for (int64 i = 0; i < 4; ++i) {
+    EXPECT_TRUE(reader->Contains(i));
+    ExpectElement(i, *reader);
+  }
+  EXPECT_FALSE(reader->Contains(4));
+}
+
+TEST(ShardedCacheTest, MergesConcurrentWriters) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("concurrent");
+  std::unique_ptr<ShardedCacheWriter> even, odd;
+  TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &even));
+  TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &odd));
+  for (int64 i = 0; i < 10; ++i) {
+    TF_ASSERT_OK((i % 2 == 0 ? even : odd)->Add(i, MakeElement(i)));
+  }
+  TF_ASSERT_OK(even->Flush());
+  {
+    std::unique_ptr<ShardedCacheReader> reader;
+    TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+    EXPECT_EQ(1, reader->num_contiguous_elements());
+    EXPECT_TRUE(reader->Contains(8));
+    EXPECT_FALSE(reader->Contains(9));
+  }
+  TF_ASSERT_OK(odd->Finish(10));
+  even.reset();
+
+  std::unique_ptr<ShardedCacheReader> reader;
+  TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+  EXPECT_TRUE(reader->complete());
+  for (int64 i = 0; i < 10; ++i) {
+    ExpectElement(i, *reader);
+  }
+}
+
+TEST(ShardedCacheTest, IgnoresTruncatedIndex) {
+  Env* env = Env::Default();
+  const string prefix = Prefix("truncated");
+  {
+    std::unique_ptr<ShardedCacheWriter> writer;
+    TF_ASSERT_OK(ShardedCacheWriter::Create(env, prefix, &writer));
+    for (int64 i = 0; i < 3; ++i) {
+      TF_ASSERT_OK(writer->Add(i, MakeElement(i)));
+    }
+    TF_ASSERT_OK(writer->Finish(3));
+  }
+  std::vector<string> index_filenames;
+  TF_ASSERT_OK(env->GetMatchingPaths(strings::StrCat(prefix, ".shard-*.index"),
+                                     &index_filenames));
+  ASSERT_EQ(1, index_filenames.size());
+  string index;
+  TF_ASSERT_OK(ReadFileToString(env, index_filenames[0], &index));
+  // Drop part of the last two entries, as if the writer had died while
+  // writing them.
+  index.resize(index.size() - 30);
+  TF_ASSERT_OK(WriteStringToFile(env, index_filenames[0], index));
+
+  std::unique_ptr<ShardedCacheReader> reader;
+  TF_ASSERT_OK(ShardedCacheReader::Open(env, prefix, &reader));
+  EXPECT_FALSE(reader->complete());
+  EXPECT_EQ(2, reader->num_contiguous_elements());
+  ExpectElement(0, *reader);
+  ExpectElement(1, *reader);
+}
+
+}  // namespace
+}  // namespace tensorflow
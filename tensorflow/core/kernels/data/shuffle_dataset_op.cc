@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -29,6 +30,25 @@ namespace {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 
+// Returns true if shuffle iterators are saved as their seeds and the number of
+// elements they have produced, which are replayed from a fresh input iterator
+// on restore, instead of as the contents of their buffers. This keeps the
+// checkpoints small, but requires the input to be deterministic and makes
+// restoring as slow as producing the elements again.
+bool SaveByReplay() {
+  static bool save_by_replay = [] {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY",
+                                  false, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+    return value;
+  }();
+  return save_by_replay;
+}
+
 // See documentation in ../ops/dataset_ops.cc for a high-level
 // description of the following op.
 
@@ -82,6 +102,14 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
+        return GetNextLocked(ctx, out_tensors, end_of_sequence);
+      }
+
+     protected:
+      Status GetNextLocked(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         int64 start_micros = ctx->env()->NowMicros();
         int64 num_log_entries = 0;
         bool first_call = false;
@@ -155,6 +183,7 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
               buffer_[slices_.front()->start % this->dataset()->buffer_size_]);
           slices_.front()->start++;
           num_elements_--;
+          if (num_elements_produced_ >= 0) num_elements_produced_++;
         } else {
           DCHECK(input_impl_ == nullptr);
           *end_of_sequence = true;
@@ -162,9 +191,20 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
-     protected:
       Status SaveInternal(IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
+        if (SaveByReplay() && num_elements_produced_ >= 0) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(this->full_name("seed"), seed_));
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(this->full_name("seed2"), seed2_));
+          return writer->WriteScalar(
+              this->full_name("replay_num_elements_produced"),
+              num_elements_produced_);
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            this->full_name("num_elements_produced"), num_elements_produced_));
+
         // Save state needed to restore the random number generators.
         TF_RETURN_IF_ERROR(writer->WriteScalar(
             this->full_name("num_random_samples"), num_random_samples_));
@@ -214,6 +254,18 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
       Status RestoreInternal(IteratorContext* ctx,
                              IteratorStateReader* reader) override {
         mutex_lock l(mu_);
+        if (reader->Contains(
+                this->full_name("replay_num_elements_produced"))) {
+          return RestoreByReplayLocked(ctx, reader);
+        }
+        // Checkpoints from before the count was saved can't be replayed.
+        num_elements_produced_ = -1;
+        if (reader->Contains(this->full_name("num_elements_produced"))) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(this->full_name("num_elements_produced"),
+                                 &num_elements_produced_));
+        }
+
         // Restore the random number generators.
         TF_RETURN_IF_ERROR(reader->ReadScalar(
             this->full_name("num_random_samples"), &num_random_samples_));
@@ -271,6 +323,43 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Restores the state saved by SaveByReplay(): starts from a fresh input
+      // iterator and produces the same elements again.
+      Status RestoreByReplayLocked(IteratorContext* ctx,
+                                   IteratorStateReader* reader)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(reader->ReadScalar(this->full_name("seed"), &seed_));
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(this->full_name("seed2"), &seed2_));
+        int64 num_elements_produced;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(this->full_name("replay_num_elements_produced"),
+                               &num_elements_produced));
+        num_random_samples_ = 0;
+        ResetRngs();
+        input_impl_.reset();
+        epoch_ = 0;
+        num_elements_ = 0;
+        num_elements_produced_ = 0;
+        slices_.clear();
+        slices_.emplace_back(new Slice{0, 0});
+        buffer_.reset(new std::vector<Tensor>[this->dataset()->buffer_size_]);
+        while (num_elements_produced_ < num_elements_produced) {
+          std::vector<Tensor> unused;
+          bool end_of_sequence;
+          TF_RETURN_IF_ERROR(GetNextLocked(ctx, &unused, &end_of_sequence));
+          if (end_of_sequence) {
+            return errors::FailedPrecondition(
+                "The input of the shuffle ended after ",
+                num_elements_produced_, " of the ", num_elements_produced,
+                " elements to replay. Replaying a checkpoint (see "
+                "TF_DATA_SHUFFLE_CHECKPOINT_BY_REPLAY) requires a "
+                "deterministic input.");
+          }
+        }
+        return Status::OK();
+      }
+
       // Used to represent slices of `buffer_` that belong to different epochs.
       // The invariant maintained by the implementation is: `start` <= `end`.
       // When using `start` and `end` to index into `buffer_`, their values
@@ -310,6 +399,8 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
       random::SingleSampleAdapter<random::PhiloxRandom> generator_
           GUARDED_BY(mu_);
       int64 num_random_samples_ GUARDED_BY(mu_) = 0;
+      // The number of elements produced, or -1 if unknown.
+      int64 num_elements_produced_ GUARDED_BY(mu_) = 0;
     };
 
     const DatasetBase* const input_;
@@ -132,6 +132,45 @@ class TensorSliceDatasetOp : public DatasetOpKernel {
         return Status::OK();
       }
 
+      Status GetNextIntoBatchInternal(IteratorContext* ctx, int64 index,
+                                      std::vector<Tensor>* batch,
+                                      bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (i_ >= n_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (batch->size() != dataset()->tensors_.size()) {
+          return errors::InvalidArgument(
+              "Cannot batch an element with ", dataset()->tensors_.size(),
+              " components into ", batch->size(), " batch components.");
+        }
+        // Copies each slice straight into the batch, instead of through a
+        // tensor for the element.
+        for (int i = 0; i < dataset()->tensors_.size(); ++i) {
+          const Tensor& t = dataset()->tensors_[i];
+          Tensor* batch_component = &(*batch)[i];
+          TensorShape slice_shape = batch_component->shape();
+          slice_shape.RemoveDim(0);
+          if (t.dtype() != batch_component->dtype() ||
+              !dataset()->shapes_[i].IsIdenticalTo(slice_shape)) {
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different types or shapes in "
+                "component ",
+                i, ". Batch has element type ",
+                DataTypeString(batch_component->dtype()), " and shape ",
+                slice_shape.DebugString(), " and element ", index,
+                " had type ", DataTypeString(t.dtype()), " and shape ",
+                dataset()->shapes_[i].DebugString(), ".");
+          }
+          TF_RETURN_IF_ERROR(
+              batch_util::CopySliceToSlice(t, i_, batch_component, index));
+        }
+        ++i_;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
      protected:
       Status SaveInternal(IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
@@ -0,0 +1,393 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/png/png_io.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// The estimated costs of decoding a byte of an encoded image, and of
+// computing a value of a resized image.
+constexpr int64 kDecodeCostPerByte = 200;
+constexpr int64 kResizeCostPerValue = 20;
+
+// A window of an image, in pixels.
+struct Window {
+  int y;
+  int x;
+  int height;
+  int width;
+};
+
+// Returns the crop window of the `image_height` x `image_width` image given
+// by `crop`, which is the whole image if the crop height or width is 0.
+Status GetCropWindow(const int32* crop, int image_height, int image_width,
+                     Window* window) {
+  if (crop[2] == 0 || crop[3] == 0) {
+    *window = {0, 0, image_height, image_width};
+    return Status::OK();
+  }
+  *window = {crop[0], crop[1], crop[2], crop[3]};
+  if (window->y < 0 || window->x < 0 || window->height < 0 ||
+      window->width < 0 ||
+      static_cast<int64>(window->y) + window->height > image_height ||
+      static_cast<int64>(window->x) + window->width > image_width) {
+    return errors::InvalidArgument(
+        "Crop window [", window->y, ", ", window->x, ", ", window->height,
+        ", ", window->width, "] is out of the ", image_height, "x",
+        image_width, " image");
+  }
+  return Status::OK();
+}
+
+// Resizes bilinearly the window of the `in_height` x `in_width` image `in`,
+// whose rows are `in_stride` bytes apart, with top left corner
+// (`window_y`, `window_x`) and size `window_height` x `window_width`, into
+// the contiguous `height` x `width` image `out`, rounding the values to the
+// nearest integer. The window may be fractional, and the pixels are sampled
+// at their centers, which is where libjpeg places the pixels of the images
+// it scales down, so that the windows of images decoded at any scale line
+// up.
+void ResizeBilinear(const uint8* in, int in_height, int in_width,
+                    int64 in_stride, int channels, float window_y,
+                    float window_x, float window_height, float window_width,
+                    int height, int width, uint8* out) {
+  const float height_scale = window_height / height;
+  const float width_scale = window_width / width;
+  std::vector<int64> xs_left(width);
+  std::vector<int64> xs_right(width);
+  std::vector<float> xs_lerp(width);
+  for (int x = 0; x < width; ++x) {
+    const float in_x =
+        std::min(std::max(window_x + (x + 0.5f) * width_scale - 0.5f, 0.0f),
+                 in_width - 1.0f);
+    const int left = static_cast<int>(in_x);
+    xs_left[x] = static_cast<int64>(left) * channels;
+    xs_right[x] = static_cast<int64>(std::min(left + 1, in_width - 1)) *
+                  channels;
+    xs_lerp[x] = in_x - left;
+  }
+  for (int y = 0; y < height; ++y) {
+    const float in_y =
+        std::min(std::max(window_y + (y + 0.5f) * height_scale - 0.5f, 0.0f),
+                 in_height - 1.0f);
+    const int top = static_cast<int>(in_y);
+    const uint8* top_row = in + top * in_stride;
+    const uint8* bottom_row = in + std::min(top + 1, in_height - 1) * in_stride;
+    const float y_lerp = in_y - top;
+    for (int x = 0; x < width; ++x) {
+      const uint8* top_left = top_row + xs_left[x];
+      const uint8* top_right = top_row + xs_right[x];
+      const uint8* bottom_left = bottom_row + xs_left[x];
+      const uint8* bottom_right = bottom_row + xs_right[x];
+      for (int c = 0; c < channels; ++c) {
+        const float top_value =
+            top_left[c] + (top_right[c] - top_left[c]) * xs_lerp[x];
+        const float bottom_value =
+            bottom_left[c] + (bottom_right[c] - bottom_left[c]) * xs_lerp[x];
+        const float value = top_value + (bottom_value - top_value) * y_lerp;
+        *out++ = static_cast<uint8>(value + 0.5f);
+      }
+    }
+  }
+}
+
+// Decodes, crops and resizes a batch of JPEG or PNG images into a single
+// tensor.
+class DecodeImageBatchOp : public OpKernel {
+ public:
+  explicit DecodeImageBatchOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("height", &height_));
+    OP_REQUIRES_OK(context, context->GetAttr("width", &width_));
+    OP_REQUIRES(context, height_ > 0 && width_ > 0,
+                errors::InvalidArgument("height and width must be positive, ",
+                                        "got ", height_, " and ", width_));
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        channels_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("ignore_errors", &ignore_errors_));
+
+    flags_.components = channels_;
+    // The TensorFlow-chosen default for jpeg decoding is IFAST, sacrificing
+    // image quality for speed.
+    flags_.dct_method = JDCT_IFAST;
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    if (dct_method == "INTEGER_ACCURATE") {
+      flags_.dct_method = JDCT_ISLOW;
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& crop_windows = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be a vector, got shape ",
+                                        contents.shape().DebugString()));
+    const int64 batch_size = contents.NumElements();
+    OP_REQUIRES(
+        context,
+        crop_windows.dims() == 2 && crop_windows.dim_size(0) == batch_size &&
+            crop_windows.dim_size(1) == 4,
+        errors::InvalidArgument("crop_windows must have shape [", batch_size,
+                                ", 4], got ",
+                                crop_windows.shape().DebugString()));
+
+    Tensor* images = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch_size, height_, width_, channels_}),
+                       &images));
+    Tensor* valid = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({batch_size}), &valid));
+    if (batch_size == 0) {
+      return;
+    }
+
+    const auto contents_vec = contents.vec<string>();
+    const int32* crop_data = crop_windows.flat<int32>().data();
+    uint8* images_data = images->flat<uint8>().data();
+    const int64 image_size =
+        static_cast<int64>(height_) * width_ * channels_;
+    auto valid_vec = valid->vec<bool>();
+    std::vector<Status> statuses(batch_size);
+
+    int64 total_bytes = 0;
+    for (int64 i = 0; i < batch_size; ++i) {
+      total_bytes += contents_vec(i).size();
+    }
+    const int64 cost_per_image = total_bytes / batch_size * kDecodeCostPerByte +
+                                 image_size * kResizeCostPerValue;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          cost_per_image, [&](int64 start, int64 limit) {
+            // The decoded images which need resizing, reused across images.
+            std::vector<uint8> scratch;
+            for (int64 i = start; i < limit; ++i) {
+              uint8* image = images_data + i * image_size;
+              statuses[i] = DecodeImage(contents_vec(i), crop_data + 4 * i,
+                                        image, &scratch);
+              valid_vec(i) = statuses[i].ok();
+              if (!statuses[i].ok()) {
+                memset(image, 0, image_size);
+              }
+            }
+          });
+
+    if (!ignore_errors_) {
+      for (int64 i = 0; i < batch_size; ++i) {
+        OP_REQUIRES(context, statuses[i].ok(),
+                    errors::InvalidArgument("Image ", i, ": ",
+                                            statuses[i].error_message()));
+      }
+    }
+  }
+
+ private:
+  // Decodes the image `input`, crops it to `crop` and resizes it into
+  // `output`.
+  Status DecodeImage(StringPiece input, const int32* crop, uint8* output,
+                     std::vector<uint8>* scratch) const {
+    if (input.size() > std::numeric_limits<int>::max()) {
+      return errors::InvalidArgument("Image is too large: ", input.size(),
+                                     " bytes");
+    }
+    if (str_util::StartsWith(input, "\xff\xd8\xff")) {
+      return DecodeJpeg(input, crop, output, scratch);
+    }
+    if (str_util::StartsWith(input, "\x89PNG\r\n\x1a\n")) {
+      return DecodePng(input, crop, output, scratch);
+    }
+    return errors::InvalidArgument("Expected a JPEG or PNG image, got ",
+                                   input.empty() ? "an empty string"
+                                                 : "an unknown format");
+  }
+
+  Status DecodeJpeg(StringPiece input, const int32* crop, uint8* output,
+                    std::vector<uint8>* scratch) const {
+    int image_height;
+    int image_width;
+    if (!jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                            &image_height, nullptr)) {
+      return errors::InvalidArgument("Invalid JPEG header, data size ",
+                                     input.size());
+    }
+    Window window;
+    TF_RETURN_IF_ERROR(GetCropWindow(crop, image_height, image_width, &window));
+
+    // Lets libjpeg scale the image down by the largest ratio that keeps the
+    // crop window at least as large as the output, which skips most of the
+    // work of the inverse DCT and of the resize.
+    jpeg::UncompressFlags flags = flags_;
+    while (flags.ratio < 8 && window.height / (2 * flags.ratio) >= height_ &&
+           window.width / (2 * flags.ratio) >= width_) {
+      flags.ratio *= 2;
+    }
+    // Decodes the smallest window of the scaled image holding the scaled crop
+    // window, whose fractional position is kept for the resize. libjpeg
+    // rounds up the size of the scaled image.
+    const int ratio = flags.ratio;
+    const int scaled_height = (image_height + ratio - 1) / ratio;
+    const int scaled_width = (image_width + ratio - 1) / ratio;
+    const int y_begin = window.y / ratio;
+    const int x_begin = window.x / ratio;
+    const int y_end = std::min(
+        scaled_height,
+        static_cast<int>((static_cast<int64>(window.y) + window.height +
+                          ratio - 1) /
+                         ratio));
+    const int x_end = std::min(
+        scaled_width,
+        static_cast<int>((static_cast<int64>(window.x) + window.width +
+                          ratio - 1) /
+                         ratio));
+    flags.crop = y_begin > 0 || x_begin > 0 || y_end < scaled_height ||
+                 x_end < scaled_width;
+    flags.crop_y = y_begin;
+    flags.crop_x = x_begin;
+    flags.crop_height = y_end - y_begin;
+    flags.crop_width = x_end - x_begin;
+
+    // Decodes directly into the output when the decoded window needs no
+    // resize.
+    const bool exact = flags.crop_height == height_ &&
+                       flags.crop_width == width_ &&
+                       window.y == y_begin * ratio &&
+                       window.x == x_begin * ratio &&
+                       window.height == height_ * ratio &&
+                       window.width == width_ * ratio;
+    int decoded_height = 0;
+    int decoded_width = 0;
+    const uint8* decoded = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [this, output, scratch, exact, &decoded_height, &decoded_width](
+            int width, int height, int channels) -> uint8* {
+          if (channels != channels_) {
+            return nullptr;
+          }
+          decoded_height = height;
+          decoded_width = width;
+          if (exact && height == height_ && width == width_) {
+            return output;
+          }
+          scratch->resize(static_cast<int64>(height) * width * channels);
+          return scratch->data();
+        });
+    if (decoded == nullptr) {
+      return errors::InvalidArgument("Invalid JPEG data, data size ",
+                                     input.size());
+    }
+    if (decoded != output) {
+      ResizeBilinear(decoded, decoded_height, decoded_width,
+                     static_cast<int64>(decoded_width) * channels_, channels_,
+                     static_cast<float>(window.y) / ratio - y_begin,
+                     static_cast<float>(window.x) / ratio - x_begin,
+                     static_cast<float>(window.height) / ratio,
+                     static_cast<float>(window.width) / ratio, height_, width_,
+                     output);
+    }
+    return Status::OK();
+  }
+
+  Status DecodePng(StringPiece input, const int32* crop, uint8* output,
+                   std::vector<uint8>* scratch) const {
+    png::DecodeContext decode;
+    if (!png::CommonInitDecode(input, channels_, 8, &decode)) {
+      return errors::InvalidArgument("Invalid PNG header, data size ",
+                                     input.size());
+    }
+    // Same limits as DecodePng.
+    const int image_width = static_cast<int>(decode.width);
+    const int image_height = static_cast<int>(decode.height);
+    const int64 total_size = static_cast<int64>(image_width) * image_height;
+    if (image_width != static_cast<int64>(decode.width) || image_width <= 0 ||
+        image_width >= (1LL << 27) ||
+        image_height != static_cast<int64>(decode.height) ||
+        image_height <= 0 || image_height >= (1LL << 27) ||
+        total_size >= (1LL << 29)) {
+      png::CommonFreeDecode(&decode);
+      return errors::InvalidArgument("PNG size too large for int: ",
+                                     decode.width, " by ", decode.height);
+    }
+    Window window;
+    const Status status =
+        GetCropWindow(crop, image_height, image_width, &window);
+    if (!status.ok()) {
+      png::CommonFreeDecode(&decode);
+      return status;
+    }
+
+    // PNG has no scaled decoding, so only an uncropped image of the size of
+    // the output is decoded directly into it.
+    const int64 row_bytes = static_cast<int64>(image_width) * channels_;
+    const bool resize = window.height != height_ || window.width != width_ ||
+                        window.height != image_height ||
+                        window.width != image_width;
+    uint8* decoded = output;
+    if (resize) {
+      scratch->resize(row_bytes * image_height);
+      decoded = scratch->data();
+    }
+    if (!png::CommonFinishDecode(reinterpret_cast<png_bytep>(decoded),
+                                 row_bytes, &decode)) {
+      return errors::InvalidArgument("Invalid PNG data, size ", input.size());
+    }
+    if (resize) {
+      ResizeBilinear(decoded, image_height, image_width, row_bytes, channels_,
+                     window.y, window.x, window.height, window.width, height_,
+                     width_, output);
+    }
+    return Status::OK();
+  }
+
+  int height_;
+  int width_;
+  int channels_;
+  bool ignore_errors_;
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeImageBatch").Device(DEVICE_CPU),
+                        DecodeImageBatchOp);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define USE_EIGEN_TENSOR
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/direct_conv2d.h"
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// DirectConv2D computes each output pixel as the sum of the rows of the
+// filter, each of out_depth values, scaled by the input values of the
+// pixel's window:
+//
+//   output[b, r, c, :] += input[b, r', c', d] * filter[fr, fc, d, :]
+//
+// where r' and c' are the input row and column of the filter tap (fr, fc).
+// The accumulation along out_depth is vectorized, and the output row stays
+// in cache over the whole window.
+//
+// The im2col contraction that Conv2D uses otherwise reduces over patches of
+// filter_rows * filter_cols * in_depth values, which are too short for it to
+// be efficient when in_depth is small (as for the first layer of image
+// models), while this implementation does not copy any patches.
+
+bool CanUseDirectConv2D(int in_depth) {
+  return in_depth <= kMaxDirectConv2DInDepth;
+}
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace functor {
+
+template <typename T>
+struct DirectConv2D<CPUDevice, T> {
+  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, int stride_rows,
+                  int stride_cols, int dilation_rows, int dilation_cols,
+                  const T* input, const T* filter, T* output) {
+    typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> OutputRow;
+    typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> FilterRow;
+    const int64 out_depth = args.out_depth;
+    const int64 in_depth = args.in_depth;
+    // Each unit of work is an output row of an image.
+    auto compute_rows = [&](int64 begin, int64 end) {
+      for (int64 unit = begin; unit < end; ++unit) {
+        const int64 b = unit / args.out_rows;
+        const int64 r = unit % args.out_rows;
+        const T* image = input + b * args.in_rows * args.in_cols * in_depth;
+        for (int64 c = 0; c < args.out_cols; ++c) {
+          OutputRow out(output + (unit * args.out_cols + c) * out_depth,
+                        out_depth);
+          out.setZero();
+          for (int64 fr = 0; fr < args.filter_rows; ++fr) {
+            const int64 in_r = r * stride_rows + fr * dilation_rows -
+                               args.pad_rows;
+            if (in_r < 0 || in_r >= args.in_rows) continue;
+            for (int64 fc = 0; fc < args.filter_cols; ++fc) {
+              const int64 in_c = c * stride_cols + fc * dilation_cols -
+                                 args.pad_cols;
+              if (in_c < 0 || in_c >= args.in_cols) continue;
+              const T* pixel = image + (in_r * args.in_cols + in_c) * in_depth;
+              const T* taps =
+                  filter + (fr * args.filter_cols + fc) * in_depth * out_depth;
+              for (int64 d = 0; d < in_depth; ++d) {
+                out += pixel[d] * FilterRow(taps + d * out_depth, out_depth);
+              }
+            }
+          }
+        }
+      }
+    };
+    const int64 cost_per_row = args.out_cols * args.filter_rows *
+                               args.filter_cols * in_depth * out_depth;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          static_cast<int64>(args.batch) * args.out_rows, cost_per_row,
+          compute_rows);
+  }
+};
+
+}  // namespace functor
+
+template struct functor::DirectConv2D<CPUDevice, float>;
+template struct functor::DirectConv2D<CPUDevice, double>;
+
+}  // namespace tensorflow
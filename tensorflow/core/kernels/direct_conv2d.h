@@ -0,0 +1,50 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DIRECT_CONV2D_H_
+#define TENSORFLOW_CORE_KERNELS_DIRECT_CONV2D_H_
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/deep_conv2d.h"
+
+namespace tensorflow {
+
+class OpKernelContext;
+
+// DirectConv2D is a Conv2D implementation for NHWC convolutions with few
+// input channels (see direct_conv2d.cc for details).
+
+// The largest in_depth of the convolutions computed by DirectConv2D.
+constexpr int kMaxDirectConv2DInDepth = 16;
+
+// Returns true if DirectConv2D computes the convolution of an input with
+// `in_depth` channels.
+bool CanUseDirectConv2D(int in_depth);
+
+namespace functor {
+
+// Calls DirectConv2D implementation (see direct_conv2d.cc for details).
+template <typename Device, typename T>
+struct DirectConv2D {
+  void operator()(OpKernelContext* ctx, const Conv2DArgs& args, int stride_rows,
+                  int stride_cols, int dilation_rows, int dilation_cols,
+                  const T* input, const T* filter, T* output);
+};
+
+}  // namespace functor
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DIRECT_CONV2D_H_
@@ -50,6 +50,32 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // When no other enqueue is waiting and there is room, the element goes
+  // straight into the queue, without registering an attempt or a
+  // cancellation callback, and the whole enqueue takes mu_ once.
+  if (!cm->IsCancelled()) {
+    bool enqueued = false;
+    bool dequeues_waiting = false;
+    {
+      mutex_lock l(mu_);
+      if (!closed_ && enqueue_attempts_.empty() &&
+          queues_[0].size() < static_cast<size_t>(capacity_)) {
+        for (int i = 0; i < num_components(); ++i) {
+          queues_[i].push_back(PersistentTensor(tuple[i]));
+        }
+        enqueued = true;
+        dequeues_waiting = !dequeue_attempts_.empty();
+      }
+    }
+    if (enqueued) {
+      if (dequeues_waiting) {
+        FlushUnlocked();
+      }
+      callback();
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -154,6 +180,27 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  // Like in TryEnqueue, an element is taken straight from the queue when no
+  // other dequeue is waiting.
+  if (!cm->IsCancelled()) {
+    Tuple tuple;
+    bool enqueues_waiting = false;
+    {
+      mutex_lock l(mu_);
+      if (dequeue_attempts_.empty() && !queues_[0].empty()) {
+        DequeueLocked(ctx, &tuple);
+        enqueues_waiting = !enqueue_attempts_.empty();
+      }
+    }
+    if (!tuple.empty()) {
+      if (enqueues_waiting) {
+        FlushUnlocked();
+      }
+      callback(tuple);
+      return;
+    }
+  }
+
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -0,0 +1,275 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/kernels/cwise_ops_common.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+namespace tensorflow {
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  using InputBuffer = typename TTypes<T>::ConstFlat;
+  using OutputBuffer = typename TTypes<T>::Flat;
+
+  using UnaryFn = void (*)(const InputBuffer&, OutputBuffer*);
+  using BinaryFn = void (*)(const InputBuffer&, const InputBuffer&,
+                            OutputBuffer*);
+  using ScalarFn = void (*)(const InputBuffer&, T, OutputBuffer*);
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> op_names;
+    OP_REQUIRES_OK(context, context->GetAttr("op_names", &op_names));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, !op_names.empty(),
+                errors::InvalidArgument(
+                    "Fused elementwise op must have at least one op"));
+
+    int next_arg = 0;
+    for (const string& op_name : op_names) {
+      Step step;
+      OP_REQUIRES(context, LookupStep(op_name, &step),
+                  errors::InvalidArgument(
+                      "Unsupported op in fused elementwise op: ", op_name));
+      if (step.binary != nullptr) step.arg = next_arg++;
+      cost_ += step.cost;
+      steps_.push_back(step);
+    }
+    OP_REQUIRES(context, next_arg == num_args,
+                errors::InvalidArgument("Fused elementwise op has ", num_args,
+                                        " args but its ops take ", next_arg));
+
+    VLOG(2) << "Fused elementwise op: [" << str_util::Join(op_names, ", ")
+            << "]; cost=" << cost_;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& in = ctx->input(0);
+    OpInputList args;
+    OP_REQUIRES_OK(ctx, ctx->input_list("args", &args));
+
+    const int64 num_elements = in.NumElements();
+    const int64 row_size = in.dims() > 0 ? in.dim_size(in.dims() - 1) : 1;
+    std::vector<ArgMode> arg_modes(args.size());
+    int num_elementwise_args = 0;
+    for (int i = 0; i < args.size(); ++i) {
+      const Tensor& arg = args[i];
+      if (arg.NumElements() == num_elements) {
+        arg_modes[i] = kElementwise;
+        ++num_elementwise_args;
+      } else if (arg.NumElements() == 1) {
+        arg_modes[i] = kScalar;
+      } else if (arg.dims() == 1 && arg.dim_size(0) == row_size) {
+        arg_modes[i] = kRow;
+      } else {
+        ctx->CtxFailure(errors::InvalidArgument(
+            "Argument ", i, " of shape ", arg.shape().DebugString(),
+            " does not broadcast to the input shape ",
+            in.shape().DebugString()));
+        return;
+      }
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->forward_input_or_allocate_output({0}, 0, in.shape(), &out));
+    if (num_elements == 0) return;
+
+    const T* in_data = in.flat<T>().data();
+    T* out_data = out->flat<T>().data();
+    std::vector<const T*> arg_data(args.size());
+    for (int i = 0; i < args.size(); ++i) {
+      arg_data[i] = args[i].flat<T>().data();
+    }
+
+    // Applies all the steps to one tile before moving to the next, so that
+    // the intermediate results stay in cache.
+    auto compute_fn = [&](int64 begin, int64 end) {
+      for (int64 tile_begin = begin; tile_begin < end;
+           tile_begin += kTileSize) {
+        const int64 tile_end = std::min(end, tile_begin + kTileSize);
+        const int64 len = tile_end - tile_begin;
+        OutputBuffer out_slice(out_data + tile_begin, len);
+        for (size_t i = 0; i < steps_.size(); ++i) {
+          const Step& step = steps_[i];
+          const InputBuffer in_slice(
+              (i == 0 ? in_data : out_data) + tile_begin, len);
+          if (step.unary != nullptr) {
+            step.unary(in_slice, &out_slice);
+            continue;
+          }
+          const T* arg = arg_data[step.arg];
+          switch (arg_modes[step.arg]) {
+            case kElementwise:
+              step.binary(in_slice, InputBuffer(arg + tile_begin, len),
+                          &out_slice);
+              break;
+            case kScalar:
+              step.scalar(in_slice, *arg, &out_slice);
+              break;
+            case kRow:
+              // Splits the tile at row boundaries, where the argument starts
+              // over.
+              for (int64 pos = tile_begin; pos < tile_end;) {
+                const int64 row_end =
+                    std::min(tile_end, (pos / row_size + 1) * row_size);
+                OutputBuffer out_row(out_data + pos, row_end - pos);
+                step.binary(
+                    InputBuffer(in_slice.data() + (pos - tile_begin),
+                                row_end - pos),
+                    InputBuffer(arg + pos % row_size, row_end - pos),
+                    &out_row);
+                pos = row_end;
+              }
+              break;
+          }
+        }
+      }
+    };
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    const int kOverheadCycles = static_cast<int>(steps_.size()) * 10;
+    Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/sizeof(T) * (1 + num_elementwise_args),
+        /*bytes_stored=*/sizeof(T), kOverheadCycles + cost_);
+    device.parallelFor(num_elements, cost, std::move(compute_fn));
+  }
+
+ private:
+  // The number of elements that all steps are applied to at a time.
+  static constexpr int64 kTileSize = 4096;
+
+  // How an argument of a binary op broadcasts to the input.
+  enum ArgMode { kElementwise, kScalar, kRow };
+
+  // One op of the chain. Binary ops use `binary` or `scalar`, depending on
+  // the shape of their argument `arg`.
+  struct Step {
+    UnaryFn unary = nullptr;
+    BinaryFn binary = nullptr;
+    ScalarFn scalar = nullptr;
+    int arg = -1;
+    int cost = 0;
+  };
+
+  template <typename Functor>
+  static void ComputeUnary(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.unaryExpr(typename Functor::func());
+  }
+
+  template <typename Functor>
+  static void ComputeBinary(const InputBuffer& in, const InputBuffer& arg,
+                            OutputBuffer* out) {
+    *out = in.binaryExpr(arg, typename Functor::func());
+  }
+
+  template <typename Functor>
+  static void ComputeScalar(const InputBuffer& in, T arg, OutputBuffer* out) {
+    *out = in.binaryExpr(in.constant(arg), typename Functor::func());
+  }
+
+  static void ComputeRelu(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.cwiseMax(static_cast<T>(0));
+  }
+
+  static void ComputeRelu6(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+  }
+
+  template <typename Functor>
+  static int Cost() {
+    return Eigen::internal::functor_traits<typename Functor::func>::Cost;
+  }
+
+  // WARN: This should be consistent with the ops fused by the remapper.
+  static bool LookupStep(const string& op_name, Step* step) {
+#define UNARY_STEP(name, functor)            \
+  if (op_name == name) {                     \
+    step->unary = ComputeUnary<functor>;     \
+    step->cost = Cost<functor>();            \
+    return true;                             \
+  }
+#define BINARY_STEP(name, functor)           \
+  if (op_name == name) {                     \
+    step->binary = ComputeBinary<functor>;   \
+    step->scalar = ComputeScalar<functor>;   \
+    step->cost = Cost<functor>();            \
+    return true;                             \
+  }
+    UNARY_STEP("Abs", functor::abs<T>);
+    UNARY_STEP("Exp", functor::exp<T>);
+    UNARY_STEP("Log", functor::log<T>);
+    UNARY_STEP("Neg", functor::neg<T>);
+    UNARY_STEP("Rsqrt", functor::rsqrt<T>);
+    UNARY_STEP("Sigmoid", functor::sigmoid<T>);
+    UNARY_STEP("Sqrt", functor::sqrt<T>);
+    UNARY_STEP("Square", functor::square<T>);
+    UNARY_STEP("Tanh", functor::tanh<T>);
+    BINARY_STEP("Add", functor::add<T>);
+    BINARY_STEP("BiasAdd", functor::add<T>);
+    BINARY_STEP("Maximum", functor::maximum<T>);
+    BINARY_STEP("Minimum", functor::minimum<T>);
+    BINARY_STEP("Mul", functor::mul<T>);
+    BINARY_STEP("RealDiv", functor::div<T>);
+    BINARY_STEP("Sub", functor::sub<T>);
+#undef UNARY_STEP
+#undef BINARY_STEP
+    using MaxCost = Eigen::internal::functor_traits<
+        Eigen::internal::scalar_max_op<T>>;
+    using MinCost = Eigen::internal::functor_traits<
+        Eigen::internal::scalar_min_op<T>>;
+    if (op_name == "Relu") {
+      step->unary = ComputeRelu;
+      step->cost = MaxCost::Cost;
+      return true;
+    }
+    if (op_name == "Relu6") {
+      step->unary = ComputeRelu6;
+      step->cost = MaxCost::Cost + MinCost::Cost;
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<Step> steps_;
+  int cost_ = 0;
+};
+
+template <typename T>
+constexpr int64 FusedElementwiseOp<T>::kTileSize;
+
+// Register the CPU kernels.
+#define REGISTER_CPU(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
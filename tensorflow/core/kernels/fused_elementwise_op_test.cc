@@ -0,0 +1,107 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const std::vector<string>& op_names, int num_args) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_args, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("num_args", num_args)
+                     .Attr("op_names", op_names)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, UnaryOps) {
+  MakeOp({"Neg", "Relu6", "Square"}, 0);
+  AddInputFromArray<float>(TensorShape({4}), {-3, -1, 1, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {9, 1, 0, 0});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, BroadcastsArguments) {
+  MakeOp({"BiasAdd", "Relu", "Mul", "Sub"}, 3);
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, -2, 3, -4, 5, -6});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 1, 1, 2, 2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  // relu(x + bias) * 2 - y
+  test::FillValues<float>(&expected, {3, -1, 11, -2, 12, -2});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, SpansManyTiles) {
+  MakeOp({"BiasAdd", "Sigmoid"}, 1);
+  const int kRows = 1000;
+  const int kRowSize = 7;
+  std::vector<float> x(kRows * kRowSize);
+  for (size_t i = 0; i < x.size(); ++i) {
+    x[i] = 0.01f * i - 30;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kRowSize}), x);
+  AddInputFromArray<float>(TensorShape({kRowSize}), {0, 1, 2, 3, 4, 5, 6});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kRowSize}));
+  auto expected_flat = expected.flat<float>();
+  for (size_t i = 0; i < x.size(); ++i) {
+    expected_flat(i) = 1 / (1 + std::exp(-(x[i] + i % kRowSize)));
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsArgumentsThatDoNotBroadcast) {
+  MakeOp({"Add"}, 1);
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsWrongNumberOfArguments) {
+  TF_ASSERT_OK(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(0, DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("num_args", 0)
+                   .Attr("op_names", {"Add"})
+                   .Finalize(node_def()));
+  EXPECT_TRUE(errors::IsInvalidArgument(InitOp()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,250 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/sparse_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Looks up, weights and combines the rows of the partitioned params of the
+// ids of each row of the sparse input, one output row at a time, so that the
+// looked up and weighted embeddings of all the ids are never materialized.
+template <typename T, typename Tids>
+class FusedEmbeddingLookupSparseOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    string combiner;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("combiner", &combiner));
+    if (combiner == "sum") {
+      combiner_ = kSum;
+    } else if (combiner == "mean") {
+      combiner_ = kMean;
+    } else {
+      combiner_ = kSqrtN;
+    }
+    string partition_strategy;
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("partition_strategy", &partition_strategy));
+    mod_partitioning_ = partition_strategy == "mod";
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OpInputList params;
+    OP_REQUIRES_OK(ctx, ctx->input_list("params", &params));
+    const Tensor* indices;
+    const Tensor* ids;
+    const Tensor* weights;
+    OP_REQUIRES_OK(ctx, ctx->input("indices", &indices));
+    OP_REQUIRES_OK(ctx, ctx->input("ids", &ids));
+    OP_REQUIRES_OK(ctx, ctx->input("weights", &weights));
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(params[0].shape()),
+                errors::InvalidArgument("params[0] must be at least 1-D"));
+    TensorShape row_shape = params[0].shape();
+    row_shape.RemoveDim(0);
+    int64 num_ids = 0;
+    for (int p = 0; p < params.size(); ++p) {
+      const TensorShape& shape = params[p].shape();
+      bool same_row_shape = shape.dims() == params[0].dims();
+      for (int d = 1; same_row_shape && d < shape.dims(); ++d) {
+        same_row_shape = shape.dim_size(d) == params[0].dim_size(d);
+      }
+      OP_REQUIRES(ctx, same_row_shape,
+                  errors::InvalidArgument(
+                      "params[", p, "] must have the shape [?] + ",
+                      row_shape.DebugString(), ", got ", shape.DebugString()));
+      num_ids += shape.dim_size(0);
+    }
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(ids->shape()),
+                errors::InvalidArgument("ids must be a vector, got ",
+                                        ids->shape().DebugString()));
+    const int64 nnz = ids->NumElements();
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsMatrix(indices->shape()) &&
+                    indices->dim_size(0) == nnz && indices->dim_size(1) >= 1,
+                errors::InvalidArgument(
+                    "indices must be a matrix with a row per id, got ",
+                    indices->shape().DebugString()));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(weights->shape()) &&
+                    (weights->NumElements() == nnz ||
+                     weights->NumElements() == 0),
+                errors::InvalidArgument(
+                    "weights must be a vector with a weight per id or empty, "
+                    "got ",
+                    weights->shape().DebugString()));
+    const int64 row_size = row_shape.num_elements();
+
+    // Resolves the params row of each id, and groups the ids by output row.
+    auto indices_t = indices->matrix<int64>();
+    auto ids_t = ids->vec<Tids>();
+    std::vector<int64> rows(nnz);
+    std::vector<const T*> param_rows(nnz);
+    int64 num_rows = 0;
+    for (int64 i = 0; i < nnz; ++i) {
+      const int64 row = internal::SubtleMustCopy(indices_t(i, 0));
+      OP_REQUIRES(ctx, row >= 0,
+                  errors::InvalidArgument("indices[", i, ", 0] = ", row,
+                                          " is negative"));
+      rows[i] = row;
+      num_rows = std::max(num_rows, row + 1);
+      const int64 id = internal::SubtleMustCopy(ids_t(i));
+      int partition;
+      int64 param_row;
+      OP_REQUIRES(
+          ctx,
+          Locate(id, params, num_ids, &partition, &param_row),
+          errors::InvalidArgument("ids[", i, "] = ", id,
+                                  " is not in the params, of ", num_ids,
+                                  " rows"));
+      param_rows[i] = params[partition].flat<T>().data() + param_row * row_size;
+    }
+    std::vector<int64> row_starts(num_rows + 1, 0);
+    for (int64 i = 0; i < nnz; ++i) {
+      ++row_starts[rows[i] + 1];
+    }
+    for (int64 r = 0; r < num_rows; ++r) {
+      row_starts[r + 1] += row_starts[r];
+    }
+    std::vector<int64> order(nnz);
+    {
+      std::vector<int64> next(row_starts.begin(), row_starts.end() - 1);
+      for (int64 i = 0; i < nnz; ++i) {
+        order[next[rows[i]]++] = i;
+      }
+    }
+
+    TensorShape output_shape({num_rows});
+    output_shape.AppendShape(row_shape);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    typedef Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>> Row;
+    typedef Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>> ConstRow;
+    T* output_data = output->flat<T>().data();
+    const T* weights_data =
+        weights->NumElements() > 0 ? weights->flat<T>().data() : nullptr;
+    const int64 row_bytes = row_size * sizeof(T);
+    auto combine_rows = [&](int64 begin, int64 end) {
+      const int64 last = row_starts[end];
+      for (int64 r = begin; r < end; ++r) {
+        Row output_row(output_data + r * row_size, row_size);
+        output_row.setZero();
+        T weight_sum(0);
+        for (int64 j = row_starts[r]; j < row_starts[r + 1]; ++j) {
+          if (j + kPrefetchDistance < last) {
+            const char* ahead = reinterpret_cast<const char*>(
+                param_rows[order[j + kPrefetchDistance]]);
+            for (int64 b = 0; b < row_bytes; b += kCacheLineSize) {
+              port::prefetch<port::PREFETCH_HINT_T0>(ahead + b);
+            }
+          }
+          const int64 i = order[j];
+          const ConstRow param_row(param_rows[i], row_size);
+          if (weights_data == nullptr) {
+            output_row += param_row;
+            weight_sum += T(1);
+          } else {
+            const T weight = weights_data[i];
+            output_row += weight * param_row;
+            weight_sum += combiner_ == kSqrtN ? weight * weight : weight;
+          }
+        }
+        if (row_starts[r + 1] > row_starts[r]) {
+          if (combiner_ == kMean) {
+            output_row /= weight_sum;
+          } else if (combiner_ == kSqrtN) {
+            output_row /= std::sqrt(weight_sum);
+          }
+        }
+      }
+    };
+    const int64 cost_per_row = (nnz / num_rows + 1) * row_size * 3;
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+          cost_per_row, combine_rows);
+  }
+
+ private:
+  enum Combiner { kSum, kMean, kSqrtN };
+
+  // The number of ids ahead whose params rows are prefetched.
+  static constexpr int64 kPrefetchDistance = 4;
+  static constexpr int64 kCacheLineSize = 64;
+
+  // Sets the partition of `id` and its row in the partition, with the same
+  // partitioning as embedding_lookup. Returns false if `id` is out of range.
+  bool Locate(int64 id, const OpInputList& params, int64 num_ids,
+              int* partition, int64* param_row) const {
+    if (id < 0 || id >= num_ids) return false;
+    const int64 num_partitions = params.size();
+    if (mod_partitioning_) {
+      *partition = id % num_partitions;
+      *param_row = id / num_partitions;
+    } else {
+      // The first `extras` partitions hold one more id than the others.
+      const int64 ids_per_partition = num_ids / num_partitions;
+      const int64 extras = num_ids % num_partitions;
+      const int64 first_ids = extras * (ids_per_partition + 1);
+      if (id < first_ids) {
+        *partition = id / (ids_per_partition + 1);
+        *param_row = id % (ids_per_partition + 1);
+      } else {
+        *partition = extras + (id - first_ids) / ids_per_partition;
+        *param_row = (id - first_ids) % ids_per_partition;
+      }
+    }
+    return *param_row < params[*partition].dim_size(0);
+  }
+
+  Combiner combiner_;
+  bool mod_partitioning_;
+};
+
+#define REGISTER_KERNELS(T, Tids)                           \
+  REGISTER_KERNEL_BUILDER(Name("FusedEmbeddingLookupSparse") \
+                              .Device(DEVICE_CPU)            \
+                              .TypeConstraint<T>("T")        \
+                              .TypeConstraint<Tids>("Tids"), \
+                          FusedEmbeddingLookupSparseOp<T, Tids>);
+
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_KERNELS(T, int32);   \
+  REGISTER_KERNELS(T, int64);
+
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
+}  // namespace tensorflow
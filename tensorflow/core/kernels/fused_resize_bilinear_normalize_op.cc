@@ -0,0 +1,222 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/tensor_format.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The source indices and the weight of the upper one for an output index.
+struct Interpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+// WARN: This should be consistent with compute_interpolation_weights in
+// resize_bilinear_op.cc, so that the fused op matches ResizeBilinear.
+std::vector<Interpolation> ComputeInterpolation(const int64 out_size,
+                                                const int64 in_size,
+                                                const float scale) {
+  std::vector<Interpolation> interpolation(out_size);
+  for (int64 i = 0; i < out_size; ++i) {
+    const float in = i * scale;
+    interpolation[i].lower = static_cast<int64>(in);
+    interpolation[i].upper = std::min(interpolation[i].lower + 1, in_size - 1);
+    interpolation[i].lerp = in - interpolation[i].lower;
+  }
+  return interpolation;
+}
+
+Status ValidateChannelParameter(const char* name, const Tensor& t,
+                                const int64 channels) {
+  if ((t.dims() <= 1 && t.NumElements() == 1) ||
+      (t.dims() == 1 && t.dim_size(0) == channels)) {
+    return Status::OK();
+  }
+  return errors::InvalidArgument(name, " must be a scalar or a vector of ",
+                                 channels, " values, but has shape ",
+                                 t.shape().DebugString());
+}
+
+inline void StoreRow(const float* src, const int64 size, float* dst) {
+  std::copy(src, src + size, dst);
+}
+
+inline void StoreRow(const float* src, const int64 size, bfloat16* dst) {
+  FloatToBFloat16(src, dst, size);
+}
+
+}  // namespace
+
+// Resizes a batch of images like ResizeBilinear, and normalizes and lays out
+// each output row before writing it, instead of passing over the whole image
+// once per op. The row is computed with Eigen array expressions, which are
+// vectorized for the instruction set the kernel is built for.
+template <typename T, typename OutT>
+class FusedResizeBilinearNormalizeOp : public OpKernel {
+ public:
+  explicit FusedResizeBilinearNormalizeOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES(context, FormatFromString(data_format, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    ImageResizerState st(align_corners_);
+    st.ValidateAndCalculateOutputSize(context, input);
+    if (!context->status().ok()) return;
+
+    const int64 channels = st.channels;
+    const Tensor& mean = context->input(2);
+    const Tensor& scale = context->input(3);
+    OP_REQUIRES_OK(context, ValidateChannelParameter("mean", mean, channels));
+    OP_REQUIRES_OK(context, ValidateChannelParameter("scale", scale, channels));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                ShapeFromFormat(data_format_, st.batch_size,
+                                                st.out_height, st.out_width,
+                                                channels),
+                                &output));
+    if (output->NumElements() == 0) return;
+
+    const std::vector<Interpolation> ys =
+        ComputeInterpolation(st.out_height, st.in_height, st.height_scale);
+    const std::vector<Interpolation> xs =
+        ComputeInterpolation(st.out_width, st.in_width, st.width_scale);
+
+    // The source offsets, the x weight, the mean and the scale of each value
+    // of an output row in NHWC order, so that rows are computed with dense
+    // array operations.
+    const int64 row_size = st.out_width * channels;
+    std::vector<int64> x_lower(row_size);
+    std::vector<int64> x_upper(row_size);
+    Eigen::ArrayXf x_lerps(row_size);
+    Eigen::ArrayXf means(row_size);
+    Eigen::ArrayXf scales(row_size);
+    const auto mean_flat = mean.flat<float>();
+    const auto scale_flat = scale.flat<float>();
+    for (int64 x = 0; x < st.out_width; ++x) {
+      for (int64 c = 0; c < channels; ++c) {
+        const int64 i = x * channels + c;
+        x_lower[i] = xs[x].lower * channels + c;
+        x_upper[i] = xs[x].upper * channels + c;
+        x_lerps(i) = xs[x].lerp;
+        means(i) = mean_flat(mean.NumElements() == 1 ? 0 : c);
+        scales(i) = scale_flat(scale.NumElements() == 1 ? 0 : c);
+      }
+    }
+
+    const T* input_data = input.flat<T>().data();
+    OutT* output_data = output->flat<OutT>().data();
+    const bool nchw = data_format_ == FORMAT_NCHW;
+    const int64 out_height = st.out_height;
+    const int64 out_width = st.out_width;
+    const int64 in_row_size = st.in_width * channels;
+    const int64 in_image_size = st.in_height * in_row_size;
+    const int64 out_plane_size = out_height * out_width;
+
+    auto compute_rows = [&](int64 start, int64 limit) {
+      Eigen::ArrayXf top_left(row_size);
+      Eigen::ArrayXf top_right(row_size);
+      Eigen::ArrayXf bottom_left(row_size);
+      Eigen::ArrayXf bottom_right(row_size);
+      Eigen::ArrayXf planar(nchw ? row_size : 0);
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / out_height;
+        const int64 y = row % out_height;
+        const T* image = input_data + b * in_image_size;
+        const T* top = image + ys[y].lower * in_row_size;
+        const T* bottom = image + ys[y].upper * in_row_size;
+        for (int64 i = 0; i < row_size; ++i) {
+          top_left(i) = static_cast<float>(top[x_lower[i]]);
+          top_right(i) = static_cast<float>(top[x_upper[i]]);
+          bottom_left(i) = static_cast<float>(bottom[x_lower[i]]);
+          bottom_right(i) = static_cast<float>(bottom[x_upper[i]]);
+        }
+        // Interpolates along x into top_left and bottom_left, then along y
+        // into top_left, which is then normalized in place.
+        top_left += (top_right - top_left) * x_lerps;
+        bottom_left += (bottom_right - bottom_left) * x_lerps;
+        top_left += (bottom_left - top_left) * ys[y].lerp;
+        top_left = (top_left - means) * scales;
+
+        if (!nchw) {
+          StoreRow(top_left.data(), row_size, output_data + row * row_size);
+          continue;
+        }
+        for (int64 c = 0; c < channels; ++c) {
+          for (int64 x = 0; x < out_width; ++x) {
+            planar(c * out_width + x) = top_left(x * channels + c);
+          }
+          StoreRow(planar.data() + c * out_width, out_width,
+                   output_data + (b * channels + c) * out_plane_size +
+                       y * out_width);
+        }
+      }
+    };
+
+    const Eigen::TensorOpCost cost_per_row(
+        4 * row_size * sizeof(T), row_size * sizeof(OutT),
+        row_size * 12 * Eigen::TensorOpCost::AddCost<float>());
+    context->eigen_device<CPUDevice>().parallelFor(
+        st.batch_size * out_height, cost_per_row, compute_rows);
+  }
+
+ private:
+  bool align_corners_;
+  TensorFormat data_format_;
+};
+
+#define REGISTER_KERNEL(T, OutT)                                 \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResizeBilinearNormalize")  \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<T>("T")            \
+                              .TypeConstraint<OutT>("out_type")  \
+                              .HostMemory("size"),               \
+                          FusedResizeBilinearNormalizeOp<T, OutT>);
+
+REGISTER_KERNEL(uint8, float);
+REGISTER_KERNEL(uint8, bfloat16);
+REGISTER_KERNEL(float, float);
+REGISTER_KERNEL(float, bfloat16);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
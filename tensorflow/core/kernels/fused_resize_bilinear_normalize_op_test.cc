@@ -0,0 +1,136 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedResizeBilinearNormalizeOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType input_type, DataType out_type,
+              const string& data_format) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_resize", "_FusedResizeBilinearNormalize")
+                     .Input(FakeInput(input_type))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("out_type", out_type)
+                     .Attr("data_format", data_format)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Computes (ResizeBilinear(image) - mean) * scale in NHWC order, one
+  // output value at a time, for an image of shape [1, height, width, 3].
+  static std::vector<float> Reference(const std::vector<float>& image,
+                                      int height, int width, int out_height,
+                                      int out_width,
+                                      const std::vector<float>& mean,
+                                      float scale) {
+    const float height_scale = static_cast<float>(height) / out_height;
+    const float width_scale = static_cast<float>(width) / out_width;
+    std::vector<float> result;
+    for (int y = 0; y < out_height; ++y) {
+      const float in_y = y * height_scale;
+      const int y0 = static_cast<int>(in_y);
+      const int y1 = std::min(y0 + 1, height - 1);
+      for (int x = 0; x < out_width; ++x) {
+        const float in_x = x * width_scale;
+        const int x0 = static_cast<int>(in_x);
+        const int x1 = std::min(x0 + 1, width - 1);
+        for (int c = 0; c < 3; ++c) {
+          auto at = [&](int iy, int ix) {
+            return image[(iy * width + ix) * 3 + c];
+          };
+          const float x_lerp = in_x - x0;
+          const float top = at(y0, x0) + (at(y0, x1) - at(y0, x0)) * x_lerp;
+          const float bottom =
+              at(y1, x0) + (at(y1, x1) - at(y1, x0)) * x_lerp;
+          const float value = top + (bottom - top) * (in_y - y0);
+          result.push_back((value - mean[c]) * scale);
+        }
+      }
+    }
+    return result;
+  }
+};
+
+TEST_F(FusedResizeBilinearNormalizeOpTest, Uint8ToFloatNHWC) {
+  MakeOp(DT_UINT8, DT_FLOAT, "NHWC");
+  std::vector<uint8> image(3 * 5 * 3);
+  std::vector<float> image_float(image.size());
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = static_cast<uint8>((i * 37) % 256);
+    image_float[i] = image[i];
+  }
+  AddInputFromArray<uint8>(TensorShape({1, 3, 5, 3}), image);
+  AddInputFromArray<int32>(TensorShape({2}), {7, 4});
+  AddInputFromArray<float>(TensorShape({3}), {100, 120, 140});
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 7, 4, 3}));
+  test::FillValues<float>(
+      &expected, Reference(image_float, 3, 5, 7, 4, {100, 120, 140}, 0.5f));
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+}
+
+TEST_F(FusedResizeBilinearNormalizeOpTest, FloatToBfloat16NCHW) {
+  MakeOp(DT_FLOAT, DT_BFLOAT16, "NCHW");
+  std::vector<float> image(4 * 4 * 3);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = static_cast<float>(i % 11);
+  }
+  AddInputFromArray<float>(TensorShape({1, 4, 4, 3}), image);
+  AddInputFromArray<int32>(TensorShape({2}), {2, 6});
+  AddInputFromArray<float>(TensorShape({}), {5});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const std::vector<float> nhwc = Reference(image, 4, 4, 2, 6, {5, 5, 5}, 1);
+  const Tensor& output = *GetOutput(0);
+  ASSERT_EQ("[1,3,2,6]", output.shape().DebugString());
+  const auto output_t = output.tensor<bfloat16, 4>();
+  for (int c = 0; c < 3; ++c) {
+    for (int y = 0; y < 2; ++y) {
+      for (int x = 0; x < 6; ++x) {
+        EXPECT_NEAR(nhwc[(y * 6 + x) * 3 + c],
+                    static_cast<float>(output_t(0, c, y, x)), 0.05);
+      }
+    }
+  }
+}
+
+TEST_F(FusedResizeBilinearNormalizeOpTest, RejectsMeanOfWrongSize) {
+  MakeOp(DT_FLOAT, DT_FLOAT, "NHWC");
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 3}), std::vector<float>(12));
+  AddInputFromArray<int32>(TensorShape({2}), {4, 4});
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
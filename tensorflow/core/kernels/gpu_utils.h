@@ -20,6 +20,7 @@ limitations under the License.
 
 #include <unordered_map>
 
+#include "tensorflow/core/kernels/autotune_cache.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -45,12 +46,29 @@ inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+//
+// Accepted configs are also recorded in a PersistentAutoTuneCache, if one is
+// enabled and Config has an AutoTuneConfigCodec, and the configs found there
+// are accepted without autotuning.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
-  bool Find(const Parameters& params, Config* config) const {
+  bool Find(const Parameters& params, Config* config) {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
+    if (iter == params_config_map_.end() && persistent_cache_ != nullptr) {
+      string value;
+      Config persisted_config;
+      if (persistent_cache_->Lookup(params.ToString(), &value) &&
+          AutoTuneConfigCodec<Config>::Decode(value, &persisted_config)) {
+        VLOG(1) << GetActionSummary("loads", params, persisted_config);
+        iter = params_config_map_
+                   .insert(std::make_pair(
+                       params, ValueType{persisted_config,
+                                         min_score_threshold_, 1}))
+                   .first;
+      }
+    }
     if (iter == params_config_map_.end() ||
         (iter->second.score < min_score_threshold_ &&
          iter->second.count <= max_autotune_count_)) {
@@ -91,6 +109,10 @@ class AutoTuneMap {
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
     }
+    if (new_score == min_score_threshold_ && persistent_cache_ != nullptr) {
+      persistent_cache_->Record(params.ToString(),
+                                AutoTuneConfigCodec<Config>::Encode(config));
+    }
   }
 
  private:
@@ -109,6 +131,9 @@ class AutoTuneMap {
     min_score_threshold_ = std::max(min_score_threshold_, 1);
     max_autotune_count_ = std::max(
         5 * min_score_threshold_ * min_score_threshold_, min_warmup_iterations);
+    if (AutoTuneConfigCodec<Config>::kPersistent) {
+      persistent_cache_ = PersistentAutoTuneCache::Get(name);
+    }
   }
 
   template <class Group, class Params, class Cfg>
@@ -139,6 +164,8 @@ class AutoTuneMap {
   string name_;
   int32 min_score_threshold_;
   int32 max_autotune_count_;
+  // Not owned. Null if the configs are not persisted.
+  PersistentAutoTuneCache* persistent_cache_ = nullptr;
 
   TF_DISALLOW_COPY_AND_ASSIGN(AutoTuneMap);
 };
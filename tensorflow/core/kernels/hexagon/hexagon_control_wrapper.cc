@@ -325,10 +325,6 @@ bool HexagonControlWrapper::FillInputNode(
   const string tensor_name = AddPort(node_name);
   CHECK(input_port_map_.count(tensor_name) > 0);
   const int port = input_port_map_.at(tensor_name);
-  if (input_tensor_data_.count(port) <= 0) {
-    input_tensor_data_.emplace(port, std::vector<uint8>{});
-  }
-  std::vector<uint8>& input_tensor_data = input_tensor_data_.at(port);
 
   // hexagon only supports 32bit dimension
   const int x = static_cast<int>(shape[0]);
@@ -338,13 +334,24 @@ bool HexagonControlWrapper::FillInputNode(
 
   const uint64 byte_size = x * y * z * d * DataTypeSize(std::get<2>(bytes));
   CHECK_EQ(byte_size, std::get<1>(bytes));
-  input_tensor_data.resize(byte_size + ALIGNMENT_BYTES);
-  uint8* data_ptr = FindAlignedPointer(input_tensor_data.data());
 
-  if (DBG_USE_DUMMY_INPUT) {
-    std::memset(data_ptr, 0, byte_size);
-  } else {
-    std::memcpy(data_ptr, std::get<0>(bytes), byte_size);
+  // Aligned input data is passed as is, since the caller keeps it alive
+  // until the graph is executed.
+  const uint8* data_ptr = std::get<0>(bytes);
+  if (DBG_USE_DUMMY_INPUT ||
+      reinterpret_cast<uintptr_t>(data_ptr) % ALIGNMENT_BYTES != 0) {
+    if (input_tensor_data_.count(port) <= 0) {
+      input_tensor_data_.emplace(port, std::vector<uint8>{});
+    }
+    std::vector<uint8>& input_tensor_data = input_tensor_data_.at(port);
+    input_tensor_data.resize(byte_size + ALIGNMENT_BYTES);
+    uint8* aligned_data_ptr = FindAlignedPointer(input_tensor_data.data());
+    if (DBG_USE_DUMMY_INPUT) {
+      std::memset(aligned_data_ptr, 0, byte_size);
+    } else {
+      std::memcpy(aligned_data_ptr, data_ptr, byte_size);
+    }
+    data_ptr = aligned_data_ptr;
   }
 
   return soc_interface_FillInputNodeWithPort(port, x, y, z, d, data_ptr,
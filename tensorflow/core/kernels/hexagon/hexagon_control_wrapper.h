@@ -72,9 +72,7 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
 
   const RemoteFusedGraphExecuteInfo* execute_info_{};
   GraphTransferer graph_transferer_{};
-  // Dummy float array for input node.
-  // TODO(satok): Use actual data passed by FillInputNode and remove
-  // std::vector<float> dummy_input_float_{};
+  // Aligned copies of the input data that isn't aligned for hexagon.
   std::unordered_map<int, std::vector<uint8>> input_tensor_data_{};
   // Dummy byte array for cosnt node.
   // TODO(satok): Remove
@@ -54,7 +54,8 @@ class IRemoteFusedGraphExecutor {
   // Teardown Graph
   virtual bool TeardownGraph() = 0;
 
-  // Fill input node's output with Tensor
+  // Fill input node's output with Tensor. The executor may keep reading the
+  // tensor's buffer until the next ExecuteGraph() returns.
   virtual bool FillInputNode(const string& node_name, const Tensor& tensor) = 0;
 
   // Read output node's outputs as ByteArrays
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -41,6 +42,11 @@ class ImmutableConstantOp : public OpKernel {
   string region_name_;
   DataType dtype_;
   TensorShape shape_;
+  // The region is mapped by the first Compute, and the tensor over it is
+  // output by all of them.
+  mutex mu_;
+  Tensor tensor_ GUARDED_BY(mu_);
+  bool mapped_ GUARDED_BY(mu_) = false;
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableConstantOp);
 };
 
@@ -16,21 +16,346 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/vocabulary_index.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
 
 namespace tensorflow {
 namespace lookup {
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+// A hash map from scalar keys to scalar values, split into kNumShards shards
+// guarded by their own reader/writer lock, so that the lookups never contend
+// with each other and rarely with the inserts.
+//
+// Each shard is an open addressing table, probed linearly by groups of
+// kGroupSize buckets. A bucket has a one byte tag, which is 0 if the bucket is
+// empty and holds 7 bits of the hash of its key otherwise. The 8 tags of a
+// group are compared at once as a uint64 before any key is, so that a probe
+// usually touches a single cache line of tags and a single key. A shard grows
+// by rehashing its own buckets only, which bounds the pause of an insert to
+// 1/kNumShards of a rehash of the whole map.
+//
+// Find() and InsertOrUpdate() process a batch of keys shard by shard, taking
+// each lock once per batch, and prefetch the buckets of the keys ahead.
+template <class K, class V>
+class ShardedFlatMap {
+ public:
+  ShardedFlatMap() {}
+
+  int64 size() const {
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.size;
+    }
+    return size;
+  }
+
+  int64 MemoryUsed() const {
+    int64 ret = 0;
+    for (const Shard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      ret += shard.tags.size() * (sizeof(uint8) + sizeof(K) + sizeof(V));
+    }
+    return ret;
+  }
+
+  // Sets values[i] to the value of keys[i], or to `default_value` if the map
+  // doesn't have it, for i in [0, n).
+  template <class KeyArray, class ValueArray>
+  void Find(const KeyArray& keys, int64 n, const V& default_value,
+            ValueArray* values) const {
+    Batch batch(keys, n);
+    for (int s = 0; s < kNumShards; ++s) {
+      const int64 begin = batch.shard_starts[s];
+      const int64 end = batch.shard_starts[s + 1];
+      if (begin == end) continue;
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 j = begin; j < end; ++j) {
+        if (j + kPrefetchDistance < end) {
+          shard.Prefetch(batch.hashes[batch.order[j + kPrefetchDistance]]);
+        }
+        const int64 i = batch.order[j];
+        const int64 bucket = shard.FindBucket(
+            SubtleMustCopyIfIntegral(keys(i)), batch.hashes[i]);
+        (*values)(i) = bucket < 0 ? default_value : shard.values[bucket];
+      }
+    }
+  }
+
+  // Maps keys[i] to values[i] for i in [0, n), the last value winning for
+  // repeated keys. If `clear`, the map only holds these keys afterwards, and
+  // the lookups never see it partially cleared.
+  template <class KeyArray, class ValueArray>
+  void InsertOrUpdate(bool clear, const KeyArray& keys, int64 n,
+                      const ValueArray& values) {
+    Batch batch(keys, n);
+    if (clear) {
+      AllShardsLock l(this, false /* shared */);
+      for (int s = 0; s < kNumShards; ++s) {
+        shards_[s].Clear();
+        InsertIntoShard(batch, s, keys, values);
+      }
+      return;
+    }
+    for (int s = 0; s < kNumShards; ++s) {
+      if (batch.shard_starts[s] == batch.shard_starts[s + 1]) continue;
+      mutex_lock l(shards_[s].mu);
+      InsertIntoShard(batch, s, keys, values);
+    }
+  }
+
+  // Copies the keys and values of the map into the outputs "keys" and
+  // "values" of `ctx`.
+  Status Export(OpKernelContext* ctx) const {
+    AllShardsLock l(this, true /* shared */);
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      size += shard.size;
+    }
+
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64 i = 0;
+    for (const Shard& shard : shards_) {
+      for (size_t bucket = 0; bucket < shard.tags.size(); ++bucket) {
+        if (shard.tags[bucket] != 0) {
+          keys_data(i) = shard.keys[bucket];
+          values_data(i) = shard.values[bucket];
+          ++i;
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  static constexpr int kShardBits = 4;
+  static constexpr int kNumShards = 1 << kShardBits;
+  static constexpr int kGroupSize = 8;
+  // The number of keys of a batch whose buckets are prefetched ahead.
+  static constexpr int kPrefetchDistance = 8;
+  static constexpr uint64 kTagLsbs = 0x0101010101010101ULL;
+  static constexpr uint64 kTagMsbs = 0x8080808080808080ULL;
+
+  // Mixes the bits of the hash of `key`, since the integers hash to
+  // themselves. The top kShardBits bits select the shard, the 7 bits below
+  // them the tag, and the low bits the first group probed.
+  static uint64 Hash(const K& key) {
+    uint64 h = tensorflow::hash<K>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+  static int ShardOf(uint64 hash) { return hash >> (64 - kShardBits); }
+  static uint8 TagOf(uint64 hash) {
+    return 0x80 | ((hash >> (64 - kShardBits - 7)) & 0x7f);
+  }
+
+  // The hashes of a batch of keys, and the indices of the keys ordered by
+  // shard, keeping the order of the keys within a shard.
+  struct Batch {
+    template <class KeyArray>
+    Batch(const KeyArray& keys, int64 n) : hashes(n), order(n) {
+      std::array<int64, kNumShards + 1> counts{};
+      for (int64 i = 0; i < n; ++i) {
+        hashes[i] = Hash(SubtleMustCopyIfIntegral(keys(i)));
+        ++counts[ShardOf(hashes[i]) + 1];
+      }
+      shard_starts[0] = 0;
+      for (int s = 0; s < kNumShards; ++s) {
+        shard_starts[s + 1] = shard_starts[s] + counts[s + 1];
+        counts[s + 1] = shard_starts[s];
+      }
+      for (int64 i = 0; i < n; ++i) {
+        order[counts[ShardOf(hashes[i]) + 1]++] = i;
+      }
+    }
+
+    std::vector<uint64> hashes;
+    std::vector<int64> order;
+    // The keys of shard s are order[shard_starts[s], shard_starts[s + 1]).
+    std::array<int64, kNumShards + 1> shard_starts;
+  };
+
+  struct Shard {
+    // Returns the bucket holding `key`, or -1.
+    int64 FindBucket(const K& key, uint64 hash) const {
+      const int64 num_groups = tags.size() / kGroupSize;
+      const uint8 tag = TagOf(hash);
+      int64 group = hash & (num_groups - 1);
+      for (int64 probes = 0; probes < num_groups; ++probes) {
+        const uint8* group_tags = &tags[group * kGroupSize];
+        uint64 word;
+        std::memcpy(&word, group_tags, sizeof(word));
+        // Has a zero byte, possibly with false positives, iff one of the tags
+        // is equal to `tag`.
+        const uint64 diff = word ^ (kTagLsbs * tag);
+        if (((diff - kTagLsbs) & ~diff & kTagMsbs) != 0) {
+          for (int b = 0; b < kGroupSize; ++b) {
+            const int64 bucket = group * kGroupSize + b;
+            if (group_tags[b] == tag && keys[bucket] == key) {
+              return bucket;
+            }
+          }
+        }
+        // An empty bucket ends the probe sequence.
+        if ((~word & kTagMsbs) != 0) {
+          return -1;
+        }
+        group = (group + 1) & (num_groups - 1);
+      }
+      return -1;
+    }
+
+    // Returns the first empty bucket of the probe sequence of `hash`. The
+    // shard must have one.
+    int64 FindEmptyBucket(uint64 hash) const {
+      const int64 num_groups = tags.size() / kGroupSize;
+      int64 group = hash & (num_groups - 1);
+      while (true) {
+        for (int b = 0; b < kGroupSize; ++b) {
+          if (tags[group * kGroupSize + b] == 0) {
+            return group * kGroupSize + b;
+          }
+        }
+        group = (group + 1) & (num_groups - 1);
+      }
+    }
+
+    void InsertOrUpdate(const K& key, const V& value, uint64 hash) {
+      const int64 bucket = FindBucket(key, hash);
+      if (bucket >= 0) {
+        values[bucket] = value;
+        return;
+      }
+      // Keeps the load factor under 3/4, so that the probe sequences stay
+      // short.
+      if (4 * (size + 1) > 3 * static_cast<int64>(tags.size())) {
+        Grow();
+      }
+      const int64 empty = FindEmptyBucket(hash);
+      tags[empty] = TagOf(hash);
+      keys[empty] = key;
+      values[empty] = value;
+      ++size;
+    }
+
+    // Doubles the number of buckets, and rehashes the keys.
+    void Grow() {
+      const size_t num_buckets =
+          std::max<size_t>(2 * tags.size(), 2 * kGroupSize);
+      std::vector<uint8> old_tags = std::move(tags);
+      std::vector<K> old_keys = std::move(keys);
+      std::vector<V> old_values = std::move(values);
+      tags.assign(num_buckets, 0);
+      keys = std::vector<K>(num_buckets);
+      values = std::vector<V>(num_buckets);
+      for (size_t bucket = 0; bucket < old_tags.size(); ++bucket) {
+        if (old_tags[bucket] != 0) {
+          const uint64 hash = Hash(old_keys[bucket]);
+          const int64 empty = FindEmptyBucket(hash);
+          tags[empty] = old_tags[bucket];
+          keys[empty] = std::move(old_keys[bucket]);
+          values[empty] = std::move(old_values[bucket]);
+        }
+      }
+    }
+
+    void Clear() {
+      tags.clear();
+      keys.clear();
+      values.clear();
+      size = 0;
+    }
+
+    // Prefetches the first group probed for `hash`, and its keys.
+    void Prefetch(uint64 hash) const {
+      if (tags.empty()) return;
+      const int64 bucket =
+          (hash & (tags.size() / kGroupSize - 1)) * kGroupSize;
+      port::prefetch<port::PREFETCH_HINT_T0>(&tags[bucket]);
+      port::prefetch<port::PREFETCH_HINT_T0>(&keys[bucket]);
+    }
+
+    mutable mutex mu;
+    // The number of buckets is 0 or a power of 2 multiple of kGroupSize.
+    std::vector<uint8> tags GUARDED_BY(mu);
+    std::vector<K> keys GUARDED_BY(mu);
+    std::vector<V> values GUARDED_BY(mu);
+    int64 size GUARDED_BY(mu) = 0;
+  };
+
+  // Holds the locks of all the shards while in scope.
+  class AllShardsLock {
+   public:
+    AllShardsLock(const ShardedFlatMap* map, bool shared)
+        : map_(map), shared_(shared) {
+      for (const Shard& shard : map_->shards_) {
+        if (shared_) {
+          shard.mu.lock_shared();
+        } else {
+          shard.mu.lock();
+        }
+      }
+    }
+    ~AllShardsLock() {
+      for (const Shard& shard : map_->shards_) {
+        if (shared_) {
+          shard.mu.unlock_shared();
+        } else {
+          shard.mu.unlock();
+        }
+      }
+    }
+
+   private:
+    const ShardedFlatMap* const map_;
+    const bool shared_;
+  };
+
+  template <class KeyArray, class ValueArray>
+  void InsertIntoShard(const Batch& batch, int s, const KeyArray& keys,
+                       const ValueArray& values) {
+    Shard& shard = shards_[s];
+    const int64 end = batch.shard_starts[s + 1];
+    for (int64 j = batch.shard_starts[s]; j < end; ++j) {
+      if (j + kPrefetchDistance < end) {
+        shard.Prefetch(batch.hashes[batch.order[j + kPrefetchDistance]]);
+      }
+      const int64 i = batch.order[j];
+      shard.InsertOrUpdate(SubtleMustCopyIfIntegral(keys(i)),
+                           SubtleMustCopyIfIntegral(values(i)),
+                           batch.hashes[i]);
+    }
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+// Lookup table that wraps a ShardedFlatMap, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
@@ -49,10 +374,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -60,12 +382,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
-    }
-
+    table_.Find(key_values, key_values.size(), default_val, &value_values);
     return Status::OK();
   }
 
@@ -73,14 +390,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
-    }
+    table_.InsertOrUpdate(clear, key_values, key_values.size(), value_values);
     return Status::OK();
   }
 
@@ -95,24 +405,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+    return table_.Export(ctx);
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -124,23 +417,11 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    mutex_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.MemoryUsed();
   }
 
  private:
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  ShardedFlatMap<K, V> table_;
 };
 
 // Lookup table that wraps an unordered_map. Behaves identical to
@@ -274,6 +555,78 @@ class MutableHashTableOfTensors final : public LookupInterface {
   std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
 };
 
+// Read-only lookup table mapping the keys of a vocabulary to their line
+// number, backed by a memory mapped VocabularyIndex file. Unlike a HashTable
+// initialized from the vocabulary file, it costs no parsing nor allocation
+// when created, and the processes of a machine share the pages of the file.
+class VocabularyIndexTable final : public LookupInterface {
+ public:
+  VocabularyIndexTable(OpKernelContext* ctx, OpKernel* kernel) {
+    string index_file;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "index_file", &index_file));
+    OP_REQUIRES_OK(ctx,
+                   VocabularyIndex::Open(ctx->env(), index_file, &index_));
+  }
+
+  size_t size() const override { return index_->size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const int64 default_val = default_value.flat<int64>()(0);
+    const auto key_values = key.flat<string>();
+    auto value_values = value->flat<int64>();
+
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const int64 found = index_->Find(key_values(i));
+      value_values(i) = found < 0 ? default_val : found;
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::FailedPrecondition("VocabularyIndexTable is read-only.");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::FailedPrecondition("VocabularyIndexTable is read-only.");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64 size = index_->size();
+
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+
+    auto keys_data = keys->flat<string>();
+    auto values_data = values->flat<int64>();
+    for (int64 i = 0; i < size; ++i) {
+      keys_data(i) = index_->key(i).ToString();
+      values_data(i) = index_->value(i);
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DT_STRING; }
+
+  DataType value_dtype() const override { return DT_INT64; }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  // The index file is memory mapped rather than allocated.
+  int64 MemoryUsed() const override { return sizeof(VocabularyIndexTable); }
+
+ private:
+  std::unique_ptr<VocabularyIndex> index_;
+};
+
 namespace {
 
 template <typename T>
@@ -903,4 +1256,9 @@ REGISTER_KERNEL(int64, Variant);
 
 #undef REGISTER_KERNEL
 
+// Register the VocabularyIndexTable op.
+REGISTER_KERNEL_BUILDER(
+    Name("VocabularyIndexTable").Device(DEVICE_CPU),
+    LookupTableOp<lookup::VocabularyIndexTable, string, int64>);
+
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/small_matmul.h"
 #include "tensorflow/core/util/matmul_autotune.h"
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -141,7 +142,27 @@ struct LaunchMatMulBase {
 };
 // On CPUs, we ignore USE_CUBLAS
 template <typename T>
-struct LaunchMatMulCPU : LaunchMatMulBase<CPUDevice, T> {};
+struct LaunchMatMulCPU : LaunchMatMulBase<CPUDevice, T> {
+  typedef typename LaunchMatMulBase<CPUDevice, T>::AlgorithmType AlgorithmType;
+
+  static void launch(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      std::vector<AlgorithmType>* algorithms, bool use_aututone, Tensor* out) {
+    // Small products are computed inline, as the Eigen contraction spends
+    // more time blocking and scheduling them than computing them.
+    const int64 k = a.dim_size(dim_pair[0].first);
+    if (functor::IsSmallMatMul<T>(out->dim_size(0), out->dim_size(1), k)) {
+      functor::SmallMatMul<T>(a.flat<T>().data(), b.flat<T>().data(),
+                              out->dim_size(0), out->dim_size(1), k,
+                              dim_pair[0].first == 0, dim_pair[0].second == 1,
+                              out->flat<T>().data());
+      return;
+    }
+    LaunchMatMulBase<CPUDevice, T>::launch(ctx, a, b, dim_pair, algorithms,
+                                           use_aututone, out);
+  }
+};
 
 template <typename T, bool USE_CUBLAS>
 struct LaunchMatMul<CPUDevice, T, USE_CUBLAS> : public LaunchMatMulCPU<T> {};
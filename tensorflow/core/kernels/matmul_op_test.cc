@@ -113,6 +113,14 @@ BM_Matmul(1, 2000, 2000, true, false);
 BM_Matmul(1, 2000, 2000, false, true);
 BM_Matmul(1, 2000, 2000, true, true);
 
+// Test some small products, which are computed inline.
+BM_Matmul(8, 8, 8, false, false);
+BM_Matmul(16, 16, 16, false, false);
+BM_Matmul(32, 32, 32, false, false);
+BM_Matmul(32, 32, 32, true, false);
+BM_Matmul(32, 32, 32, false, true);
+BM_Matmul(48, 48, 48, false, false);
+
 // Test some rank-one products.
 BM_Matmul(50, 1, 50, false, false);
 BM_Matmul(50, 1, 50, true, false);
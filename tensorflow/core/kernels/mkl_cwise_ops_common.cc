@@ -56,6 +56,34 @@ class MklBinaryOp : public BinaryOp<Device, Functor> {
   }
 };
 
+// Unary element-wise ops are applied to the buffer of their input as it is,
+// whatever its layout, since each element of the output only depends on the
+// element of the input at the same offset. The functor must map 0 to 0, so
+// that the padding of blocked layouts (e.g. nChw8c) stays zero.
+template <typename Device, typename Functor>
+class MklUnaryOp : public OpKernel {
+ public:
+  typedef typename Functor::in_type T;
+
+  explicit MklUnaryOp(OpKernelConstruction* context) : OpKernel(context) {
+    const DataType dt = DataTypeToEnum<T>::v();
+    OP_REQUIRES_OK(context, context->MatchSignature({dt, DT_UINT8},
+                                                    {dt, DT_UINT8}));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& in = context->input(0);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, in.shape(), &out));
+    functor::UnaryFunctor<Device, Functor>()(
+        context->eigen_device<Device>(), out->flat<T>(), in.flat<T>());
+
+    // The output has the layout of the input.
+    ForwardMklMetaDataInToOut(context, 0, 0);
+  }
+};
+
 //---------- Registration macros for various element-wise ops -----------
 // We will need to redefine "REGISTER" to include the mkl_op_registry flag
 #pragma push_macro("REGISTER")
@@ -79,6 +107,11 @@ REGISTER5(MklBinaryOp, CPU, "_MklSquaredDifference",
           functor::squared_difference, float, Eigen::half, double, int32,
           int64);
 
+REGISTER(MklUnaryOp, CPU, "_MklAbs", functor::abs, float);
+REGISTER(MklUnaryOp, CPU, "_MklNeg", functor::neg, float);
+REGISTER(MklUnaryOp, CPU, "_MklSqrt", functor::sqrt, float);
+REGISTER(MklUnaryOp, CPU, "_MklSquare", functor::square, float);
+
 #undef REGISTER
 #pragma pop_macro("REGISTER")
 //-----------------------------------------------------------------------
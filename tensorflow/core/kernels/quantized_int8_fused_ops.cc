@@ -0,0 +1,386 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements the eight-bit convolution and matmul operations fused with their
+// bias and relu, which take uint8 inputs and int8 filters quantized per output
+// channel, and compute their products with QuantizedInt8Gemm.
+
+#define EIGEN_USE_THREADS
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The inputs that both ops have after their two operands.
+enum {
+  kBiasInput = 2,
+  kMinInputInput,
+  kMaxInputInput,
+  kMinFilterInput,
+  kMaxFilterInput,
+  kMinFreezedOutputInput,
+  kMaxFreezedOutputInput,
+};
+
+// Converts the int32 products of the quantized input and filter to the
+// quantized outputs, adding the bias and applying the relu in between. Each
+// output channel has its own scale, since the filter of each one is quantized
+// symmetrically over its own range.
+class OutputRequantizer {
+ public:
+  // Reads the bias and the ranges of the input, filter and output from the
+  // inputs of `context`.
+  Status Init(OpKernelContext* context, int64 out_depth) {
+    const Tensor& bias = context->input(kBiasInput);
+    const Tensor& min_filter = context->input(kMinFilterInput);
+    const Tensor& max_filter = context->input(kMaxFilterInput);
+    if (bias.NumElements() != out_depth) {
+      return errors::InvalidArgument("bias must have ", out_depth,
+                                     " elements, got ",
+                                     bias.shape().DebugString());
+    }
+    const int64 num_filter_ranges = min_filter.NumElements();
+    if (max_filter.NumElements() != num_filter_ranges ||
+        (num_filter_ranges != 1 && num_filter_ranges != out_depth)) {
+      return errors::InvalidArgument(
+          "min_filter and max_filter must have 1 or ", out_depth,
+          " elements, got ", min_filter.shape().DebugString(), " and ",
+          max_filter.shape().DebugString());
+    }
+    const float min_input = context->input(kMinInputInput).flat<float>()(0);
+    const float max_input = context->input(kMaxInputInput).flat<float>()(0);
+    min_output_ = context->input(kMinFreezedOutputInput).flat<float>()(0);
+    max_output_ = context->input(kMaxFreezedOutputInput).flat<float>()(0);
+    if (max_input <= min_input) {
+      return errors::InvalidArgument(
+          "max_input must be larger than min_input.");
+    }
+    if (max_output_ <= min_output_) {
+      return errors::InvalidArgument(
+          "max_freezed_output must be larger than min_freezed_output.");
+    }
+    input_offset_ =
+        FloatToQuantizedUnclamped<quint8>(0.0f, min_input, max_input);
+
+    // The products of the quantized values are scaled by the input and filter
+    // steps to get back to floats, and by the inverse of the output step to
+    // get to the quantized output.
+    const float input_scale = (max_input - min_input) / 255.0f;
+    const float output_scale = 255.0f / (max_output_ - min_output_);
+    output_offset_ = static_cast<int32>(round(min_output_ * output_scale));
+    const auto bias_values = bias.flat<float>();
+    const auto min_filter_values = min_filter.flat<float>();
+    const auto max_filter_values = max_filter.flat<float>();
+    scales_.resize(out_depth);
+    offsets_.resize(out_depth);
+    for (int64 c = 0; c < out_depth; ++c) {
+      const int64 range = num_filter_ranges == 1 ? 0 : c;
+      const float filter_scale =
+          std::max(std::abs(min_filter_values(range)),
+                   std::abs(max_filter_values(range))) /
+          127.0f;
+      scales_[c] = input_scale * filter_scale * output_scale;
+      offsets_[c] = bias_values(c) * output_scale;
+    }
+    return Status::OK();
+  }
+
+  // The quantized value of 0 in the input, by which the products are offset.
+  int32 input_offset() const { return input_offset_; }
+
+  // Writes the quantized outputs of a row of products.
+  void Requantize(const int32* products, quint8* output) const {
+    const int64 out_depth = scales_.size();
+    for (int64 c = 0; c < out_depth; ++c) {
+      const float value =
+          std::max(products[c] * scales_[c] + offsets_[c], 0.0f);
+      const int32 quantized =
+          static_cast<int32>(value + 0.5f) - output_offset_;
+      output[c] = static_cast<uint8>(std::min(std::max(quantized, 0), 255));
+    }
+  }
+
+  // Sets the outputs with the range of the quantized output.
+  Status SetOutputRange(OpKernelContext* context) const {
+    Tensor* output_min = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(1, {}, &output_min));
+    output_min->flat<float>()(0) = min_output_;
+    Tensor* output_max = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(2, {}, &output_max));
+    output_max->flat<float>()(0) = max_output_;
+    return Status::OK();
+  }
+
+ private:
+  int32 input_offset_;
+  int32 output_offset_;
+  float min_output_;
+  float max_output_;
+  std::vector<float> scales_;
+  std::vector<float> offsets_;
+};
+
+// Holds the packed filter of a kernel across runs, since the filters of
+// inference graphs are constants. The filter is repacked whenever its values
+// differ from the ones last packed.
+class PackedFilterCache {
+ public:
+  std::shared_ptr<const PackedInt8Weights> Get(const int8* filter, int64 k,
+                                               int64 n) {
+    mutex_lock lock(mu_);
+    if (packed_ == nullptr || packed_->k() != k || packed_->n() != n ||
+        memcmp(filter, filter_.data(), k * n) != 0) {
+      filter_.assign(filter, filter + k * n);
+      packed_ = std::make_shared<PackedInt8Weights>(filter, k, n);
+    }
+    return packed_;
+  }
+
+ private:
+  mutex mu_;
+  std::vector<int8> filter_ GUARDED_BY(mu_);
+  std::shared_ptr<const PackedInt8Weights> packed_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+class QuantizedConv2DWithBiasAndReluOp : public OpKernel {
+ public:
+  explicit QuantizedConv2DWithBiasAndReluOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(
+        context, (strides_[0] == 1 && strides_[3] == 1),
+        errors::InvalidArgument("Current implementation does not yet support "
+                                "strides in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("dilations", &dilations_));
+    OP_REQUIRES(context, dilations_.size() == 4,
+                errors::InvalidArgument("Dilations field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(context, (dilations_[0] == 1 && dilations_[3] == 1),
+                errors::InvalidArgument(
+                    "Current implementation does not yet support "
+                    "dilations in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // Input tensor is of the following dimensions:
+    // [ batch, in_rows, in_cols, in_depth ]
+    const Tensor& input = context->input(0);
+
+    // Input filter is of the following dimensions:
+    // [ filter_rows, filter_cols, in_depth, out_depth]
+    const Tensor& filter = context->input(1);
+
+    OP_REQUIRES(context, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+    const int64 in_depth = input.dim_size(3);
+    OP_REQUIRES(context, in_depth == filter.dim_size(2),
+                errors::InvalidArgument(
+                    "input and filter must have the same depth: ", in_depth,
+                    " vs ", filter.dim_size(2)));
+    const int64 batch = input.dim_size(0);
+    const int64 input_rows = input.dim_size(1);
+    const int64 input_cols = input.dim_size(2);
+    const int64 filter_rows = filter.dim_size(0);
+    const int64 filter_cols = filter.dim_size(1);
+    const int64 out_depth = filter.dim_size(3);
+
+    OutputRequantizer requantizer;
+    OP_REQUIRES_OK(context, requantizer.Init(context, out_depth));
+
+    int64 out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(context, GetWindowedOutputSizeV2(
+                                input_rows, filter_rows, dilations_[1],
+                                strides_[1], padding_, &out_rows, &pad_rows));
+    OP_REQUIRES_OK(context, GetWindowedOutputSizeV2(
+                                input_cols, filter_cols, dilations_[2],
+                                strides_[2], padding_, &out_cols, &pad_cols));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, out_rows, out_cols, out_depth}),
+                       &output));
+    OP_REQUIRES_OK(context, requantizer.SetOutputRange(context));
+    if (output->NumElements() == 0) return;
+
+    // The filter is the [patch_size, out_depth] right-hand side of the
+    // product of the patches of the input.
+    const int64 patch_size = filter_rows * filter_cols * in_depth;
+    std::shared_ptr<const PackedInt8Weights> packed_filter =
+        packed_filter_cache_.Get(
+            reinterpret_cast<const int8*>(filter.flat<qint8>().data()),
+            patch_size, out_depth);
+
+    // The padding represents zeros, which are offset like the input values.
+    const uint8 padding_value = static_cast<uint8>(
+        std::min(std::max(requantizer.input_offset(), 0), 255));
+    const uint8* input_data =
+        reinterpret_cast<const uint8*>(input.flat<quint8>().data());
+    quint8* output_data = output->flat<quint8>().data();
+    const int stride_rows = strides_[1];
+    const int stride_cols = strides_[2];
+    const int dilation_rows = dilations_[1];
+    const int dilation_cols = dilations_[2];
+
+    // Each unit of work is an output row of an image, whose patches are
+    // gathered into a buffer and multiplied with the filter at once.
+    auto compute_rows = [&](int64 begin, int64 end) {
+      std::vector<uint8> patches(out_cols * patch_size);
+      std::vector<int32> products(out_cols * out_depth);
+      for (int64 unit = begin; unit < end; ++unit) {
+        const int64 b = unit / out_rows;
+        const int64 out_r = unit % out_rows;
+        const uint8* image =
+            input_data + b * input_rows * input_cols * in_depth;
+        for (int64 out_c = 0; out_c < out_cols; ++out_c) {
+          uint8* patch = patches.data() + out_c * patch_size;
+          for (int64 fr = 0; fr < filter_rows; ++fr) {
+            const int64 in_r = out_r * stride_rows + fr * dilation_rows -
+                               pad_rows;
+            for (int64 fc = 0; fc < filter_cols; ++fc) {
+              const int64 in_c = out_c * stride_cols + fc * dilation_cols -
+                                 pad_cols;
+              uint8* tap = patch + (fr * filter_cols + fc) * in_depth;
+              if (in_r < 0 || in_r >= input_rows || in_c < 0 ||
+                  in_c >= input_cols) {
+                std::fill(tap, tap + in_depth, padding_value);
+              } else {
+                const uint8* pixel =
+                    image + (in_r * input_cols + in_c) * in_depth;
+                std::copy(pixel, pixel + in_depth, tap);
+              }
+            }
+          }
+        }
+        QuantizedInt8Gemm(patches.data(), patch_size,
+                          requantizer.input_offset(), out_cols,
+                          *packed_filter, products.data(), out_depth);
+        quint8* output_row = output_data + unit * out_cols * out_depth;
+        for (int64 out_c = 0; out_c < out_cols; ++out_c) {
+          requantizer.Requantize(products.data() + out_c * out_depth,
+                                 output_row + out_c * out_depth);
+        }
+      }
+    };
+    const int64 cost_per_unit = out_cols * patch_size * out_depth;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch * out_rows, cost_per_unit, compute_rows);
+  }
+
+ private:
+  std::vector<int32> strides_;
+  std::vector<int32> dilations_;
+  Padding padding_;
+  PackedFilterCache packed_filter_cache_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedConv2DWithBiasAndRelu")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("Tinput")
+                            .TypeConstraint<qint8>("Tfilter")
+                            .TypeConstraint<quint8>("out_type"),
+                        QuantizedConv2DWithBiasAndReluOp);
+
+class QuantizedMatMulWithBiasAndReluOp : public OpKernel {
+ public:
+  explicit QuantizedMatMulWithBiasAndReluOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix"));
+    OP_REQUIRES(context, a.dim_size(1) == b.dim_size(0),
+                errors::InvalidArgument(
+                    "Matrix size-compatible: In[0]: ", a.shape().DebugString(),
+                    ", In[1]: ", b.shape().DebugString()));
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = b.dim_size(1);
+
+    OutputRequantizer requantizer;
+    OP_REQUIRES_OK(context, requantizer.Init(context, n));
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, {m, n}, &out));
+    OP_REQUIRES_OK(context, requantizer.SetOutputRange(context));
+    if (out->NumElements() == 0) return;
+
+    std::shared_ptr<const PackedInt8Weights> packed_b = packed_b_cache_.Get(
+        reinterpret_cast<const int8*>(b.flat<qint8>().data()), k, n);
+    const uint8* a_data =
+        reinterpret_cast<const uint8*>(a.flat<quint8>().data());
+    quint8* out_data = out->flat<quint8>().data();
+
+    // The rows are multiplied by blocks, whose products fit in a small buffer.
+    const int64 kBlockRows = 16;
+    auto compute_blocks = [&](int64 begin, int64 end) {
+      std::vector<int32> products(kBlockRows * n);
+      for (int64 block = begin; block < end; ++block) {
+        const int64 row = block * kBlockRows;
+        const int64 rows = std::min(kBlockRows, m - row);
+        QuantizedInt8Gemm(a_data + row * k, k, requantizer.input_offset(),
+                          rows, *packed_b, products.data(), n);
+        for (int64 r = 0; r < rows; ++r) {
+          requantizer.Requantize(products.data() + r * n,
+                                 out_data + (row + r) * n);
+        }
+      }
+    };
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          (m + kBlockRows - 1) / kBlockRows, kBlockRows * k * n,
+          compute_blocks);
+  }
+
+ private:
+  PackedFilterCache packed_b_cache_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedMatMulWithBiasAndRelu")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("T1")
+                            .TypeConstraint<qint8>("T2")
+                            .TypeConstraint<quint8>("Toutput"),
+                        QuantizedMatMulWithBiasAndReluOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,195 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class QuantizedInt8FusedOpsTest : public OpsTestBase {
+ protected:
+  // Adds the float inputs that follow the two operands. The filter range has
+  // one element per output channel when `max_filter` has more than one.
+  void AddRangeInputs(const std::vector<float>& bias, float max_input,
+                      const std::vector<float>& max_filter, float max_output) {
+    const int64 num_ranges = max_filter.size();
+    std::vector<float> min_filter(num_ranges);
+    for (int64 i = 0; i < num_ranges; ++i) min_filter[i] = -max_filter[i];
+    AddInputFromArray<float>(TensorShape({static_cast<int64>(bias.size())}),
+                             bias);
+    AddInputFromArray<float>(TensorShape({}), {0.0f});
+    AddInputFromArray<float>(TensorShape({}), {max_input});
+    AddInputFromArray<float>(TensorShape({num_ranges}), min_filter);
+    AddInputFromArray<float>(TensorShape({num_ranges}), max_filter);
+    AddInputFromArray<float>(TensorShape({}), {0.0f});
+    AddInputFromArray<float>(TensorShape({}), {max_output});
+  }
+
+  // Checks that the quantized output matches `expected` to within a step of
+  // its range.
+  void ExpectOutput(const std::vector<float>& expected) {
+    const Tensor& output = *GetOutput(0);
+    const float min_output = GetOutput(1)->flat<float>()(0);
+    const float max_output = GetOutput(2)->flat<float>()(0);
+    const float step = (max_output - min_output) / 255.0f;
+    ASSERT_EQ(expected.size(), output.NumElements());
+    for (int64 i = 0; i < output.NumElements(); ++i) {
+      const float value =
+          min_output + static_cast<int>(output.flat<quint8>()(i)) * step;
+      EXPECT_NEAR(std::min(std::max(expected[i], 0.0f), max_output), value,
+                  step)
+          << "at " << i;
+    }
+  }
+};
+
+TEST_F(QuantizedInt8FusedOpsTest, Conv2D) {
+  TF_ASSERT_OK(NodeDefBuilder("quantized_conv_op",
+                              "QuantizedConv2DWithBiasAndRelu")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("strides", {1, 1, 1, 1})
+                   .Attr("padding", "SAME")
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // The [1, 3, 3, 2] input has the range [0, 2.55], so each quantized value
+  // is a hundredth of its float value.
+  const int in_depth = 2;
+  const int out_depth = 3;
+  std::vector<quint8> input(18);
+  for (int i = 0; i < 18; ++i) input[i] = i * 13 % 256;
+  AddInputFromArray<quint8>(TensorShape({1, 3, 3, in_depth}), input);
+  // The [2, 2, 2, 3] filter has a different range for each output channel.
+  const std::vector<float> max_filter = {1.27f, 0.127f, 2.54f};
+  std::vector<qint8> filter(24);
+  for (int i = 0; i < 24; ++i) filter[i] = (i * 37 % 255) - 127;
+  AddInputFromArray<qint8>(TensorShape({2, 2, in_depth, out_depth}), filter);
+  const std::vector<float> bias = {0.5f, -0.25f, 1.0f};
+  AddRangeInputs(bias, 2.55f, max_filter, 20.0f);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // With SAME padding the 2x2 window covers the input element and the ones
+  // below and to its right.
+  std::vector<float> expected;
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col) {
+      for (int c = 0; c < out_depth; ++c) {
+        float sum = bias[c];
+        for (int fr = 0; fr < 2; ++fr) {
+          for (int fc = 0; fc < 2; ++fc) {
+            if (row + fr >= 3 || col + fc >= 3) continue;
+            for (int d = 0; d < in_depth; ++d) {
+              const int in_index = ((row + fr) * 3 + col + fc) * in_depth + d;
+              const int filter_index =
+                  ((fr * 2 + fc) * in_depth + d) * out_depth + c;
+              const float in = static_cast<int>(input[in_index]) * 0.01f;
+              const float weight = static_cast<int>(filter[filter_index]) *
+                                   max_filter[c] / 127.0f;
+              sum += in * weight;
+            }
+          }
+        }
+        expected.push_back(sum);
+      }
+    }
+  }
+  ExpectOutput(expected);
+}
+
+TEST_F(QuantizedInt8FusedOpsTest, MatMul) {
+  TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op",
+                              "QuantizedMatMulWithBiasAndRelu")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // A is [5, 7] and B is [7, 18], so that the rows and columns of the
+  // products span more than one block of the kernels.
+  const int m = 5;
+  const int k = 7;
+  const int n = 18;
+  std::vector<quint8> a(m * k);
+  for (int i = 0; i < m * k; ++i) a[i] = i * 29 % 256;
+  AddInputFromArray<quint8>(TensorShape({m, k}), a);
+  std::vector<qint8> b(k * n);
+  for (int i = 0; i < k * n; ++i) b[i] = (i * 53 % 255) - 127;
+  AddInputFromArray<qint8>(TensorShape({k, n}), b);
+  std::vector<float> bias(n);
+  for (int j = 0; j < n; ++j) bias[j] = (j - 9) * 0.1f;
+  AddRangeInputs(bias, 2.55f, {1.27f}, 10.0f);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected;
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float sum = bias[j];
+      for (int p = 0; p < k; ++p) {
+        sum += static_cast<int>(a[i * k + p]) * 0.01f *
+               static_cast<int>(b[p * n + j]) * 0.01f;
+      }
+      expected.push_back(sum);
+    }
+  }
+  ExpectOutput(expected);
+}
+
+TEST_F(QuantizedInt8FusedOpsTest, MatMulBadFilterRange) {
+  TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op",
+                              "QuantizedMatMulWithBiasAndRelu")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<qint8>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddRangeInputs({0.0f, 0.0f, 0.0f}, 1.0f, {1.0f, 2.0f}, 1.0f);
+  EXPECT_TRUE(
+      str_util::StrContains(RunOpKernel().ToString(), "must have 1 or 3"));
+}
+
+}  // namespace tensorflow
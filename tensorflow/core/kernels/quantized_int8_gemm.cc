@@ -0,0 +1,322 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+
+// The x86 kernels are compiled for their instruction sets with function
+// target attributes, and chosen at run time, so that they are available
+// whatever instruction set the rest of TensorFlow is compiled for.
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ >= 8)
+#define TENSORFLOW_USE_X86_INT8_GEMM_KERNELS
+#include <immintrin.h>
+#define TF_TARGET_AVX2 __attribute__((target("avx2")))
+#define TF_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512vnni")))
+#endif
+
+namespace tensorflow {
+namespace {
+
+// The number of columns of the blocks of the packed weights.
+constexpr int64 kBlockCols = 16;
+
+// The number of rows of the left-hand side that the kernels compute at once.
+constexpr int kMaxRows = 4;
+
+int64 RoundUp(int64 value, int64 multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Reads four consecutive uint8 values as a 32-bit word.
+inline int32 LoadWord(const uint8* values) {
+  int32 word;
+  memcpy(&word, values, sizeof(word));
+  return word;
+}
+
+// The kernels compute kRows rows of the product from the rows of `a`, which
+// have RoundUp(k, 4) values, the ones past k being zero.
+
+template <int kRows>
+void PortableRows(const uint8* a, int64 lda, int32 a_offset,
+                  const PackedInt8Weights& b, int32* out, int64 ldc) {
+  const int64 groups = RoundUp(b.k(), 4) / 4;
+  for (int r = 0; r < kRows; ++r) {
+    const uint8* row = a + r * lda;
+    for (int64 j = 0; j < b.n(); j += kBlockCols) {
+      int32 acc[kBlockCols] = {0};
+      const int8* block = b.data() + j * 4;
+      for (int64 g = 0; g < groups; ++g) {
+        const uint8* values = row + 4 * g;
+        const int8* weights = block + g * b.padded_n() * 4;
+        for (int c = 0; c < kBlockCols; ++c) {
+          acc[c] += values[0] * weights[4 * c] +
+                    values[1] * weights[4 * c + 1] +
+                    values[2] * weights[4 * c + 2] +
+                    values[3] * weights[4 * c + 3];
+        }
+      }
+      const int64 cols = std::min(kBlockCols, b.n() - j);
+      for (int64 c = 0; c < cols; ++c) {
+        out[r * ldc + j + c] = acc[c] - a_offset * b.column_sums()[j + c];
+      }
+    }
+  }
+}
+
+#ifdef TENSORFLOW_USE_X86_INT8_GEMM_KERNELS
+
+// Multiplies the four uint8 values of `word` with the four int8 values of
+// each of eight columns in `weights`, and adds the sums of pairs of products
+// of the first four columns to `lo`, and of the last four columns to `hi`.
+// The values are widened to 16 bits, for the products to be exact.
+TF_TARGET_AVX2 inline void Avx2MultiplyAdd(int32 word, __m256i weights_lo,
+                                           __m256i weights_hi, __m256i* lo,
+                                           __m256i* hi) {
+  const __m256i values = _mm256_cvtepu8_epi16(_mm_set1_epi32(word));
+  *lo = _mm256_add_epi32(*lo, _mm256_madd_epi16(values, weights_lo));
+  *hi = _mm256_add_epi32(*hi, _mm256_madd_epi16(values, weights_hi));
+}
+
+// Stores the eight columns of a row accumulated by Avx2MultiplyAdd.
+TF_TARGET_AVX2 inline void Avx2Store(__m256i lo, __m256i hi, int32 a_offset,
+                                     const int32* column_sums, int64 cols,
+                                     int32* out) {
+  // The adjacent pairs of lo and hi hold the halves of the sums of columns
+  // [0, 1, 4, 5 | 2, 3, 6, 7] once added, which are then put in order.
+  __m256i sums = _mm256_permute4x64_epi64(_mm256_hadd_epi32(lo, hi), 0xd8);
+  const __m256i sums_of_columns =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column_sums));
+  sums = _mm256_sub_epi32(
+      sums,
+      _mm256_mullo_epi32(_mm256_set1_epi32(a_offset), sums_of_columns));
+  if (cols >= 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), sums);
+  } else {
+    int32 values[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), sums);
+    std::copy(values, values + cols, out);
+  }
+}
+
+// Computes the rows eight columns at a time. The accumulators are separate
+// variables rather than an array, which compilers only keep in registers
+// when they fully unroll the loops over it.
+template <int kRows>
+TF_TARGET_AVX2 void Avx2Rows(const uint8* a, int64 lda, int32 a_offset,
+                             const PackedInt8Weights& b, int32* out,
+                             int64 ldc) {
+  const int64 groups = RoundUp(b.k(), 4) / 4;
+  const int64 group_stride = b.padded_n() * 4;
+  for (int64 j = 0; j < b.n(); j += 8) {
+    const int8* block = b.data() + j * 4;
+    __m256i lo0 = _mm256_setzero_si256(), hi0 = lo0, lo1 = lo0, hi1 = lo0,
+            lo2 = lo0, hi2 = lo0, lo3 = lo0, hi3 = lo0;
+    for (int64 g = 0; g < groups; ++g) {
+      const __m256i weights = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(block + g * group_stride));
+      const __m256i weights_lo =
+          _mm256_cvtepi8_epi16(_mm256_castsi256_si128(weights));
+      const __m256i weights_hi =
+          _mm256_cvtepi8_epi16(_mm256_extracti128_si256(weights, 1));
+      const uint8* values = a + 4 * g;
+      Avx2MultiplyAdd(LoadWord(values), weights_lo, weights_hi, &lo0, &hi0);
+      if (kRows > 1) {
+        Avx2MultiplyAdd(LoadWord(values + lda), weights_lo, weights_hi, &lo1,
+                        &hi1);
+      }
+      if (kRows > 2) {
+        Avx2MultiplyAdd(LoadWord(values + 2 * lda), weights_lo, weights_hi,
+                        &lo2, &hi2);
+      }
+      if (kRows > 3) {
+        Avx2MultiplyAdd(LoadWord(values + 3 * lda), weights_lo, weights_hi,
+                        &lo3, &hi3);
+      }
+    }
+    const int32* column_sums = b.column_sums() + j;
+    const int64 cols = b.n() - j;
+    Avx2Store(lo0, hi0, a_offset, column_sums, cols, out + j);
+    if (kRows > 1) {
+      Avx2Store(lo1, hi1, a_offset, column_sums, cols, out + ldc + j);
+    }
+    if (kRows > 2) {
+      Avx2Store(lo2, hi2, a_offset, column_sums, cols, out + 2 * ldc + j);
+    }
+    if (kRows > 3) {
+      Avx2Store(lo3, hi3, a_offset, column_sums, cols, out + 3 * ldc + j);
+    }
+  }
+}
+
+// Stores a block of sixteen columns of a row.
+TF_TARGET_AVX512_VNNI inline void VnniStore(__m512i acc, int32 a_offset,
+                                            const int32* column_sums,
+                                            int64 cols, int32* out) {
+  acc = _mm512_sub_epi32(
+      acc, _mm512_mullo_epi32(_mm512_set1_epi32(a_offset),
+                              _mm512_loadu_si512(column_sums)));
+  if (cols >= kBlockCols) {
+    _mm512_storeu_si512(out, acc);
+  } else {
+    _mm512_mask_storeu_epi32(out, static_cast<__mmask16>((1 << cols) - 1),
+                             acc);
+  }
+}
+
+// Computes kBlocks blocks of sixteen columns of the rows, from column j.
+template <int kRows, int kBlocks>
+TF_TARGET_AVX512_VNNI inline void VnniTile(const uint8* a, int64 lda,
+                                           int32 a_offset,
+                                           const PackedInt8Weights& b, int64 j,
+                                           int32* out, int64 ldc) {
+  const int64 groups = RoundUp(b.k(), 4) / 4;
+  const int64 group_stride = b.padded_n() * 4;
+  const int8* block = b.data() + j * 4;
+  __m512i c00 = _mm512_setzero_si512(), c01 = c00, c10 = c00, c11 = c00,
+          c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+  for (int64 g = 0; g < groups; ++g) {
+    const int8* weights = block + g * group_stride;
+    const __m512i b0 = _mm512_loadu_si512(weights);
+    const __m512i b1 =
+        kBlocks > 1 ? _mm512_loadu_si512(weights + 4 * kBlockCols) : b0;
+    const uint8* values = a + 4 * g;
+    __m512i a_r = _mm512_set1_epi32(LoadWord(values));
+    c00 = _mm512_dpbusd_epi32(c00, a_r, b0);
+    if (kBlocks > 1) c01 = _mm512_dpbusd_epi32(c01, a_r, b1);
+    if (kRows > 1) {
+      a_r = _mm512_set1_epi32(LoadWord(values + lda));
+      c10 = _mm512_dpbusd_epi32(c10, a_r, b0);
+      if (kBlocks > 1) c11 = _mm512_dpbusd_epi32(c11, a_r, b1);
+    }
+    if (kRows > 2) {
+      a_r = _mm512_set1_epi32(LoadWord(values + 2 * lda));
+      c20 = _mm512_dpbusd_epi32(c20, a_r, b0);
+      if (kBlocks > 1) c21 = _mm512_dpbusd_epi32(c21, a_r, b1);
+    }
+    if (kRows > 3) {
+      a_r = _mm512_set1_epi32(LoadWord(values + 3 * lda));
+      c30 = _mm512_dpbusd_epi32(c30, a_r, b0);
+      if (kBlocks > 1) c31 = _mm512_dpbusd_epi32(c31, a_r, b1);
+    }
+  }
+  const __m512i acc[kMaxRows][2] = {
+      {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+  for (int r = 0; r < kRows; ++r) {
+    for (int block_index = 0; block_index < kBlocks; ++block_index) {
+      const int64 col = j + block_index * kBlockCols;
+      VnniStore(acc[r][block_index], a_offset, b.column_sums() + col,
+                b.n() - col, out + r * ldc + col);
+    }
+  }
+}
+
+// Computes the rows by tiles of two blocks of columns, so that eight
+// independent accumulators hide the latency of the multiply-adds.
+template <int kRows>
+TF_TARGET_AVX512_VNNI void VnniRows(const uint8* a, int64 lda, int32 a_offset,
+                                    const PackedInt8Weights& b, int32* out,
+                                    int64 ldc) {
+  int64 j = 0;
+  for (; j + kBlockCols < b.n(); j += 2 * kBlockCols) {
+    VnniTile<kRows, 2>(a, lda, a_offset, b, j, out, ldc);
+  }
+  if (j < b.n()) VnniTile<kRows, 1>(a, lda, a_offset, b, j, out, ldc);
+}
+
+#endif  // TENSORFLOW_USE_X86_INT8_GEMM_KERNELS
+
+typedef void (*RowsKernel)(const uint8* a, int64 lda, int32 a_offset,
+                           const PackedInt8Weights& b, int32* out, int64 ldc);
+
+// Computes the product kMaxRows rows at a time with the kernels of each
+// number of rows, indexed by the number of rows minus one.
+void Gemm(const RowsKernel (&kernels)[kMaxRows], const uint8* a, int64 lda,
+          int32 a_offset, int64 m, const PackedInt8Weights& b, int32* out,
+          int64 ldc) {
+  // The kernels read the rows by groups of four values, so rows whose
+  // length is not a multiple of four are copied and padded with zeros.
+  const int64 padded_k = RoundUp(b.k(), 4);
+  std::vector<uint8> padded_rows;
+  if (padded_k != b.k()) padded_rows.resize(kMaxRows * padded_k, 0);
+  for (int64 i = 0; i < m; i += kMaxRows) {
+    const int rows = static_cast<int>(std::min<int64>(kMaxRows, m - i));
+    const uint8* rows_a = a + i * lda;
+    int64 rows_lda = lda;
+    if (!padded_rows.empty()) {
+      for (int r = 0; r < rows; ++r) {
+        std::copy(rows_a + r * lda, rows_a + r * lda + b.k(),
+                  padded_rows.begin() + r * padded_k);
+      }
+      rows_a = padded_rows.data();
+      rows_lda = padded_k;
+    }
+    kernels[rows - 1](rows_a, rows_lda, a_offset, b, out + i * ldc, ldc);
+  }
+}
+
+const RowsKernel kPortableKernels[kMaxRows] = {
+    PortableRows<1>, PortableRows<2>, PortableRows<3>, PortableRows<4>};
+
+}  // namespace
+
+PackedInt8Weights::PackedInt8Weights(const int8* b, int64 k, int64 n)
+    : k_(k),
+      n_(n),
+      padded_n_(RoundUp(n, kBlockCols)),
+      data_(RoundUp(k, 4) * padded_n_, 0),
+      column_sums_(padded_n_, 0) {
+  for (int64 p = 0; p < k; ++p) {
+    for (int64 j = 0; j < n; ++j) {
+      const int8 value = b[p * n + j];
+      data_[((p / 4) * padded_n_ + j) * 4 + p % 4] = value;
+      column_sums_[j] += value;
+    }
+  }
+}
+
+void QuantizedInt8Gemm(const uint8* a, int64 lda, int32 a_offset, int64 m,
+                       const PackedInt8Weights& b, int32* out, int64 ldc) {
+#ifdef TENSORFLOW_USE_X86_INT8_GEMM_KERNELS
+  static const bool has_vnni =
+      port::TestCPUFeature(port::CPUFeature::AVX512_VNNI);
+  static const bool has_avx2 = port::TestCPUFeature(port::CPUFeature::AVX2);
+  if (has_vnni) {
+    static const RowsKernel kernels[kMaxRows] = {
+        VnniRows<1>, VnniRows<2>, VnniRows<3>, VnniRows<4>};
+    Gemm(kernels, a, lda, a_offset, m, b, out, ldc);
+    return;
+  }
+  if (has_avx2) {
+    static const RowsKernel kernels[kMaxRows] = {
+        Avx2Rows<1>, Avx2Rows<2>, Avx2Rows<3>, Avx2Rows<4>};
+    Gemm(kernels, a, lda, a_offset, m, b, out, ldc);
+    return;
+  }
+#endif  // TENSORFLOW_USE_X86_INT8_GEMM_KERNELS
+  Gemm(kPortableKernels, a, lda, a_offset, m, b, out, ldc);
+}
+
+void ReferenceQuantizedInt8Gemm(const uint8* a, int64 lda, int32 a_offset,
+                                int64 m, const PackedInt8Weights& b,
+                                int32* out, int64 ldc) {
+  Gemm(kPortableKernels, a, lda, a_offset, m, b, out, ldc);
+}
+
+}  // namespace tensorflow
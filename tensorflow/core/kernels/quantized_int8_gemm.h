@@ -0,0 +1,70 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
+#define TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The int8 right-hand side of QuantizedInt8Gemm, packed for its kernels.
+//
+// The matrix is stored by groups of four rows, and within a group column by
+// column, so that each 32-bit word holds the four int8 values of one column
+// that a kernel multiplies with four consecutive uint8 values of a row of the
+// left-hand side. The rows are padded to a multiple of 4 and the columns to a
+// multiple of 16 with zeros.
+class PackedInt8Weights {
+ public:
+  // Packs the row-major [k, n] matrix `b`.
+  PackedInt8Weights(const int8* b, int64 k, int64 n);
+
+  int64 k() const { return k_; }
+  int64 n() const { return n_; }
+  int64 padded_n() const { return padded_n_; }
+  const int8* data() const { return data_.data(); }
+  // The sum of each column, padded like the columns.
+  const int32* column_sums() const { return column_sums_.data(); }
+
+ private:
+  int64 k_;
+  int64 n_;
+  int64 padded_n_;
+  std::vector<int8> data_;
+  std::vector<int32> column_sums_;
+};
+
+// Computes the row-major [m, n] `out` = (a - a_offset) * b, with `ldc`
+// elements between the rows of `out`. `a` is a row-major [m, k] uint8 matrix
+// with `lda` elements between its rows, and `b` a [k, n] int8 matrix. The
+// products are exact in int32 as long as k is below 2^16.
+//
+// Uses AVX-512 VNNI instructions when the CPU has them, which multiply and
+// accumulate 64 pairs of uint8 and int8 values at once, and otherwise AVX2
+// instructions, or portable code on other CPUs.
+void QuantizedInt8Gemm(const uint8* a, int64 lda, int32 a_offset, int64 m,
+                       const PackedInt8Weights& b, int32* out, int64 ldc);
+
+// Like QuantizedInt8Gemm, but only uses the portable code. For testing.
+void ReferenceQuantizedInt8Gemm(const uint8* a, int64 lda, int32 a_offset,
+                                int64 m, const PackedInt8Weights& b,
+                                int32* out, int64 ldc);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_QUANTIZED_INT8_GEMM_H_
@@ -0,0 +1,94 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/quantized_int8_gemm.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Checks QuantizedInt8Gemm and its portable version against a direct
+// computation, for matrices whose dimensions cover the remainders of the
+// blocks of rows, columns and reductions of the kernels.
+void TestGemm(int64 m, int64 k, int64 n, int32 a_offset) {
+  random::PhiloxRandom philox(m * 10000 + k * 100 + n);
+  random::SimplePhilox rnd(&philox);
+  // The rows of a and out are longer than the matrices, to check the strides.
+  const int64 lda = k + 3;
+  const int64 ldc = n + 2;
+  std::vector<uint8> a(m * lda);
+  for (uint8& value : a) value = rnd.Uniform(256);
+  std::vector<int8> b(k * n);
+  for (int8& value : b) value = static_cast<int8>(rnd.Uniform(256));
+
+  std::vector<int32> expected(m * ldc, -1);
+  for (int64 i = 0; i < m; ++i) {
+    for (int64 j = 0; j < n; ++j) {
+      int32 sum = 0;
+      for (int64 p = 0; p < k; ++p) {
+        sum += (a[i * lda + p] - a_offset) * b[p * n + j];
+      }
+      expected[i * ldc + j] = sum;
+    }
+  }
+
+  const PackedInt8Weights packed_b(b.data(), k, n);
+  std::vector<int32> out(m * ldc, -1);
+  QuantizedInt8Gemm(a.data(), lda, a_offset, m, packed_b, out.data(), ldc);
+  EXPECT_EQ(expected, out) << "m=" << m << " k=" << k << " n=" << n;
+  std::vector<int32> reference_out(m * ldc, -1);
+  ReferenceQuantizedInt8Gemm(a.data(), lda, a_offset, m, packed_b,
+                             reference_out.data(), ldc);
+  EXPECT_EQ(expected, reference_out) << "m=" << m << " k=" << k << " n=" << n;
+}
+
+TEST(QuantizedInt8GemmTest, Shapes) {
+  for (int64 m : {1, 3, 4, 7, 16}) {
+    for (int64 k : {1, 4, 5, 35, 64}) {
+      for (int64 n : {1, 8, 15, 16, 33, 70}) {
+        TestGemm(m, k, n, 0);
+      }
+    }
+  }
+}
+
+TEST(QuantizedInt8GemmTest, Offsets) {
+  for (int32 a_offset : {1, 128, 255}) {
+    TestGemm(9, 27, 40, a_offset);
+  }
+}
+
+TEST(QuantizedInt8GemmTest, LargeReduction) {
+  // The largest products of uint8 and int8 values sum exactly.
+  const int64 k = 4099;
+  std::vector<uint8> a(k, 255);
+  std::vector<int8> b(k * 2);
+  for (int64 p = 0; p < k; ++p) {
+    b[p * 2] = -128;
+    b[p * 2 + 1] = 127;
+  }
+  const PackedInt8Weights packed_b(b.data(), k, 2);
+  int32 out[2];
+  QuantizedInt8Gemm(a.data(), k, 0, 1, packed_b, out, 2);
+  EXPECT_EQ(255 * -128 * k, out[0]);
+  EXPECT_EQ(255 * 127 * k, out[1]);
+}
+
+}  // namespace
+}  // namespace tensorflow
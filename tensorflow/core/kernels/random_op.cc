@@ -22,6 +22,7 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -68,6 +69,80 @@ struct FillPhiloxRandom {
   }
 };
 
+// A generator that returns the groups of random numbers that
+// PhiloxRandom::GenerateBatch() produced in advance, one group per call.
+class PhiloxBatchReplay {
+ public:
+  typedef PhiloxRandom::ResultType ResultType;
+  typedef PhiloxRandom::ResultElementType ResultElementType;
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount;
+  static const int kElementCost = PhiloxRandom::kElementCost;
+
+  explicit PhiloxBatchReplay(const ResultType* next) : next_(next) {}
+
+  ResultType operator()() { return *next_++; }
+
+ private:
+  const ResultType* next_;
+};
+
+// BatchedDistribution<Distribution>::type draws the same samples as
+// Distribution from a PhiloxBatchReplay, if Distribution is stateless and
+// calls its generator once per group. Then kEnabled is true.
+template <class Distribution>
+struct BatchedDistribution {
+  static const bool kEnabled = false;
+};
+
+// The uniform integer distributions carry their range, so they aren't
+// batched.
+#define REGISTER_BATCHED_UNIFORM(T)                                          \
+  template <>                                                                \
+  struct BatchedDistribution<random::UniformDistribution<PhiloxRandom, T>> { \
+    static const bool kEnabled = true;                                       \
+    typedef random::UniformDistribution<PhiloxBatchReplay, T> type;          \
+  }
+REGISTER_BATCHED_UNIFORM(Eigen::half);
+REGISTER_BATCHED_UNIFORM(bfloat16);
+REGISTER_BATCHED_UNIFORM(float);
+REGISTER_BATCHED_UNIFORM(double);
+#undef REGISTER_BATCHED_UNIFORM
+
+template <typename T>
+struct BatchedDistribution<random::NormalDistribution<PhiloxRandom, T>> {
+  static const bool kEnabled = true;
+  typedef random::NormalDistribution<PhiloxBatchReplay, T> type;
+};
+
+// Fills the groups from "*index" up to "limit_group" in batches of
+// PhiloxRandom::kBatchSize while whole batches fit, and advances "*index",
+// "*offset" and "*gen" past them.
+template <class Distribution>
+typename std::enable_if<BatchedDistribution<Distribution>::kEnabled>::type
+FillPhiloxRandomBatches(PhiloxRandom* gen,
+                        typename Distribution::ResultElementType* data,
+                        int64 limit_group, int64* index, int64* offset) {
+  const int kGroupSize = Distribution::kResultElementCount;
+  typename BatchedDistribution<Distribution>::type dist;
+  PhiloxRandom::ResultType batch[PhiloxRandom::kBatchSize];
+  for (; *index + PhiloxRandom::kBatchSize <= limit_group;
+       *index += PhiloxRandom::kBatchSize) {
+    gen->GenerateBatch(batch);
+    PhiloxBatchReplay replay(batch);
+    for (int i = 0; i < PhiloxRandom::kBatchSize; ++i) {
+      auto samples = dist(&replay);
+      std::copy(&samples[0], &samples[0] + kGroupSize, data + *offset);
+      *offset += kGroupSize;
+    }
+  }
+}
+
+template <class Distribution>
+typename std::enable_if<!BatchedDistribution<Distribution>::kEnabled>::type
+FillPhiloxRandomBatches(PhiloxRandom* gen,
+                        typename Distribution::ResultElementType* data,
+                        int64 limit_group, int64* index, int64* offset) {}
+
 // A class to fill a specified range of random groups
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
@@ -84,9 +159,13 @@ struct FillPhiloxRandomTask<Distribution, false> {
     gen.Skip(start_group);
     int64 offset = start_group * kGroupSize;
 
-    // First fill all the full-size groups
+    // First fill all the full-size groups, as many of them as possible in
+    // batches.
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
-    for (int64 index = start_group; index < limit_group_full; ++index) {
+    int64 index = start_group;
+    FillPhiloxRandomBatches<Distribution>(&gen, data, limit_group_full, &index,
+                                          &offset);
+    for (; index < limit_group_full; ++index) {
       auto samples = dist(&gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
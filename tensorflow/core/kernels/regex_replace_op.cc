@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <memory>
 #include <string>
 
 #include "re2/re2.h"
@@ -20,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -39,11 +42,9 @@ class RegexReplaceOp : public OpKernel {
     OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(pattern_tensor->shape()),
                 errors::InvalidArgument("Pattern must be scalar, but received ",
                                         pattern_tensor->shape().DebugString()));
-    const string pattern = pattern_tensor->flat<string>()(0);
-    const RE2 match(pattern);
-    OP_REQUIRES(ctx, match.ok(),
-                errors::InvalidArgument("Invalid pattern: ", pattern,
-                                        ", error: ", match.error()));
+    const string& pattern = pattern_tensor->flat<string>()(0);
+    std::shared_ptr<const RE2> match;
+    OP_REQUIRES_OK(ctx, GetRegex(pattern, &match));
 
     const Tensor* rewrite_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("rewrite", &rewrite_tensor));
@@ -56,18 +57,47 @@ class RegexReplaceOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->allocate_output("output", input_tensor->shape(),
                                              &output_tensor));
     auto output_flat = output_tensor->flat<string>();
-    for (size_t i = 0; i < input_flat.size(); ++i) {
-      output_flat(i) = input_flat(i);
-      if (replace_global_) {
-        RE2::GlobalReplace(&output_flat(i), match, rewrite);
-      } else {
-        RE2::Replace(&output_flat(i), match, rewrite);
+    const bool replace_global = replace_global_;
+    // Matching a byte costs tens of cycles.
+    const int64 kCostPerElement = 1000;
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), kCostPerElement,
+          [&input_flat, &output_flat, &match, &rewrite, replace_global](
+              int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              output_flat(i) = input_flat(i);
+              if (replace_global) {
+                RE2::GlobalReplace(&output_flat(i), *match, rewrite);
+              } else {
+                RE2::Replace(&output_flat(i), *match, rewrite);
+              }
+            }
+          });
+  }
+
+ private:
+  // Returns the compiled `pattern`, which is compiled again only when it
+  // differs from the one of the previous step, since the pattern is usually a
+  // constant.
+  Status GetRegex(const string& pattern, std::shared_ptr<const RE2>* match) {
+    mutex_lock l(mu_);
+    if (regex_ == nullptr || regex_->pattern() != pattern) {
+      std::shared_ptr<const RE2> regex(new RE2(pattern));
+      if (!regex->ok()) {
+        return errors::InvalidArgument("Invalid pattern: ", pattern,
+                                       ", error: ", regex->error());
       }
+      regex_ = std::move(regex);
     }
+    *match = regex_;
+    return Status::OK();
   }
 
- private:
   bool replace_global_;
+  mutex mu_;
+  // RE2 objects are thread safe, so the steps running concurrently share it.
+  std::shared_ptr<const RE2> regex_ GUARDED_BY(mu_);
 };
 
 REGISTER_KERNEL_BUILDER(Name("RegexReplace").Device(DEVICE_CPU),
@@ -20,14 +20,18 @@ limitations under the License.
 #include "tensorflow/core/kernels/i_remote_fused_graph_executor.h"
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
-class RemoteFusedGraphExecuteOp : public OpKernel {
+// Runs the fused graph on the remote processor asynchronously, so that the
+// CPU threads of the executor can run other ops, e.g. the pre- and
+// post-processing of other steps, while the remote processor is busy.
+class RemoteFusedGraphExecuteOp : public AsyncOpKernel {
  public:
   explicit RemoteFusedGraphExecuteOp(OpKernelConstruction* const ctx)
-      : OpKernel(ctx), execute_info_() {
+      : AsyncOpKernel(ctx), execute_info_() {
     string serialized_proto;
     OP_REQUIRES_OK(
         ctx, ctx->GetAttr(RemoteFusedGraphExecuteUtils::
@@ -58,10 +62,17 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
 
       // 2. Setup graph in remote processor
       remote_fused_graph_executor_->SetupGraph();
+
+      // The remote processor runs one graph at a time, so the executions are
+      // queued on a single thread.
+      thread_pool_.reset(new thread::ThreadPool(
+          ctx->env(), "remote_fused_graph_execute", /*num_threads=*/1));
     }
   }
 
   ~RemoteFusedGraphExecuteOp() final {
+    // Waits for the pending executions.
+    thread_pool_.reset();
     if (remote_fused_graph_executor_) {
       // 6. Teardown graph in remote processor
       remote_fused_graph_executor_->TeardownGraph();
@@ -71,7 +82,24 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
     }
   }
 
-  void Compute(OpKernelContext* const ctx) final {
+  void ComputeAsync(OpKernelContext* const ctx, DoneCallback done) final {
+    if (!thread_pool_) {
+      Execute(ctx);
+      done();
+      return;
+    }
+    // The inputs stay alive until done() is called, so the remote processor
+    // can read them without copies.
+    thread_pool_->Schedule([this, ctx, done]() {
+      Execute(ctx);
+      done();
+    });
+  }
+
+  bool IsExpensive() final { return true; }
+
+ private:
+  void Execute(OpKernelContext* const ctx) {
     CHECK(ctx != nullptr);
     const int input_count = ctx->num_inputs();
     const int graph_input_count = execute_info_.graph_input_node_name_size();
@@ -120,11 +148,9 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
     }
   }
 
-  bool IsExpensive() final { return true; }
-
- private:
   RemoteFusedGraphExecuteInfo execute_info_;
   std::unique_ptr<IRemoteFusedGraphExecutor> remote_fused_graph_executor_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
   DataTypeVector input_types_;
   DataTypeVector output_types_;
 
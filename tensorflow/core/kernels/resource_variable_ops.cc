@@ -61,6 +61,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/dense_update_functor.h"
 #include "tensorflow/core/kernels/gather_functor.h"
 #include "tensorflow/core/kernels/scatter_functor.h"
+#include "tensorflow/core/kernels/sparse_update_combiner.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -620,6 +621,88 @@ class ResourceScatterUpdateOp : public OpKernel {
   }
 };
 
+// ResourceScatterAdd on CPU, which combines the concurrent updates of a
+// variable, e.g. on a parameter server, when TF_SPARSE_UPDATE_COALESCING is
+// at least 1.
+template <typename T, typename Index>
+class ResourceScatterAddOp
+    : public ResourceScatterUpdateOp<CPUDevice, T, Index,
+                                     scatter_op::UpdateOp::ADD> {
+ public:
+  typedef ResourceScatterUpdateOp<CPUDevice, T, Index,
+                                  scatter_op::UpdateOp::ADD>
+      Base;
+
+  explicit ResourceScatterAddOp(OpKernelConstruction* c)
+      : Base(c),
+        coalesce_(GetSparseUpdateCoalescing() >=
+                  SparseUpdateCoalescing::kExact) {}
+
+  void Compute(OpKernelContext* c) override {
+    const Tensor& indices = c->input(1);
+    const Tensor& updates = c->input(2);
+    const int64 N = indices.NumElements();
+    if (!coalesce_ || N == 0 || N > std::numeric_limits<Index>::max() ||
+        TensorShapeUtils::IsScalar(updates.shape()) ||
+        updates.NumElements() % N != 0) {
+      // The base kernel reports the invalid arguments.
+      Base::Compute(c);
+      return;
+    }
+    const ResourceHandle& handle = HandleFromInput(c, 0);
+    SparseUpdateCombiner<T, Index>* combiner = nullptr;
+    OP_REQUIRES_OK(c, LookupOrCreateSparseUpdateCombiner(
+                          c, this->type_string(), handle, nullptr, &combiner));
+    core::ScopedUnref unref_combiner(combiner);
+
+    Tensor flat_indices;
+    CHECK(flat_indices.CopyFrom(indices, TensorShape({N})));
+    Tensor flat_updates;
+    CHECK(flat_updates.CopyFrom(
+        updates, TensorShape({N, updates.NumElements() / N})));
+    OP_REQUIRES_OK(
+        c, combiner->Apply({}, flat_indices, flat_updates,
+                           [c, &handle](const std::vector<T>& params,
+                                        const Tensor& indices,
+                                        const Tensor& updates) {
+                             return ScatterAdd(c, handle, indices, updates);
+                           }));
+  }
+
+ private:
+  static Status ScatterAdd(OpKernelContext* c, const ResourceHandle& handle,
+                           const Tensor& indices, const Tensor& updates) {
+    Var* v = nullptr;
+    TF_RETURN_IF_ERROR(LookupResource(c, handle, &v));
+    core::ScopedUnref unref_v(v);
+    mutex_lock ml(*v->mu());
+    Tensor* params = v->tensor();
+    TF_RETURN_IF_ERROR(PrepareToUpdateVariable<CPUDevice, T>(c, params));
+    if (params->dim_size(0) > std::numeric_limits<Index>::max()) {
+      return errors::InvalidArgument(
+          "params.shape[0] too large for ",
+          DataTypeString(DataTypeToEnum<Index>::v()),
+          " indexing: ", params->dim_size(0), " > ",
+          std::numeric_limits<Index>::max());
+    }
+    auto indices_flat = indices.flat<Index>();
+    functor::ScatterFunctor<CPUDevice, T, Index, scatter_op::UpdateOp::ADD>
+        functor;
+    const Index bad_i =
+        functor(c, c->eigen_device<CPUDevice>(), params->flat_outer_dims<T>(),
+                updates.matrix<T>(), indices_flat);
+    if (bad_i >= 0) {
+      return errors::InvalidArgument("indices[", bad_i,
+                                     "] = ", indices_flat(bad_i),
+                                     " is not in [0, ", params->dim_size(0),
+                                     ")");
+    }
+    return Status::OK();
+  }
+
+  const bool coalesce_;
+};
+
 #define REGISTER_SCATTER_KERNEL_INDEX(type, index_type, dev, name, op) \
   REGISTER_KERNEL_BUILDER(                                             \
       Name(name)                                                       \
@@ -633,9 +716,7 @@ class ResourceScatterUpdateOp : public OpKernel {
   REGISTER_SCATTER_KERNEL_INDEX(type, int32, dev, name, op); \
   REGISTER_SCATTER_KERNEL_INDEX(type, int64, dev, name, op);
 
-#define REGISTER_SCATTER_ARITHMETIC(type, dev)                \
-  REGISTER_SCATTER_KERNEL(type, dev, "ResourceScatterAdd",    \
-                          scatter_op::UpdateOp::ADD);         \
+#define REGISTER_SCATTER_ARITHMETIC_NO_ADD(type, dev)         \
   REGISTER_SCATTER_KERNEL(type, dev, "ResourceScatterSub",    \
                           scatter_op::UpdateOp::SUB);         \
   REGISTER_SCATTER_KERNEL(type, dev, "ResourceScatterMul",    \
@@ -651,8 +732,17 @@ class ResourceScatterUpdateOp : public OpKernel {
                           scatter_op::UpdateOp::MAX);
 
 // Registers CPU kernels.
-#define REGISTER_SCATTER_ARITHMETIC_CPU(type) \
-  REGISTER_SCATTER_ARITHMETIC(type, CPU);
+#define REGISTER_SCATTER_ADD_CPU_INDEX(type, index_type)              \
+  REGISTER_KERNEL_BUILDER(Name("ResourceScatterAdd")                   \
+                              .Device(DEVICE_CPU)                      \
+                              .HostMemory("resource")                  \
+                              .TypeConstraint<type>("dtype")           \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          ResourceScatterAddOp<type, index_type>)
+#define REGISTER_SCATTER_ARITHMETIC_CPU(type)    \
+  REGISTER_SCATTER_ADD_CPU_INDEX(type, int32); \
+  REGISTER_SCATTER_ADD_CPU_INDEX(type, int64); \
+  REGISTER_SCATTER_ARITHMETIC_NO_ADD(type, CPU);
 #define REGISTER_SCATTER_MINMAX_CPU(type) REGISTER_SCATTER_MINMAX(type, CPU);
 
 TF_CALL_NUMBER_TYPES(REGISTER_SCATTER_ARITHMETIC_CPU);
@@ -667,8 +757,10 @@ REGISTER_SCATTER_KERNEL(Variant, CPU, "ResourceScatterUpdate",
 
 // Registers GPU kernels.
 #if GOOGLE_CUDA
-#define REGISTER_SCATTER_ARITHMETIC_GPU(type) \
-  REGISTER_SCATTER_ARITHMETIC(type, GPU);
+#define REGISTER_SCATTER_ARITHMETIC_GPU(type)                 \
+  REGISTER_SCATTER_KERNEL(type, GPU, "ResourceScatterAdd",    \
+                          scatter_op::UpdateOp::ADD);         \
+  REGISTER_SCATTER_ARITHMETIC_NO_ADD(type, GPU);
 #define REGISTER_SCATTER_MINMAX_GPU(type) REGISTER_SCATTER_MINMAX(type, GPU);
 
 #define REGISTER_SCATTER_UPDATE_GPU(type) REGISTER_SCATTER_UPDATE(type, GPU);
@@ -702,7 +794,8 @@ REGISTER_KERNEL_BUILDER(Name("ResourceScatterUpdate")
 
 #endif  // GOOGLE_CUDA
 
-#undef REGISTER_SCATTER_ARITHMETIC
+#undef REGISTER_SCATTER_ARITHMETIC_NO_ADD
+#undef REGISTER_SCATTER_ADD_CPU_INDEX
 #undef REGISTER_SCATTER_ARITHMETIC_CPU
 #undef REGISTER_SCATTER_MINMAX
 #undef REGISTER_SCATTER_MINMAX_CPU
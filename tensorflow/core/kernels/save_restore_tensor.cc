@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -23,12 +24,15 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -232,6 +236,14 @@ namespace {
 // Tensors larger than this threshold will be restored from a thread-pool.
 const int64 kLargeShapeThreshold = 16 << 20;  // 16M
 
+// The contents of tensors larger than this many bytes are read in blocks of
+// this size in parallel, to hide the latency of remote file systems.
+const int64 kParallelReadBlockBytes = 16 << 20;  // 16MB
+
+// Small tensors are restored in chunks of about this many bytes, the first
+// one from the op thread and the others from the thread-pool.
+const int64 kRestoreChunkBytes = 16 << 20;  // 16MB
+
 // A restore operation for a single tensor.  Small tensors may be restored
 // directly from the op thread to improve read locality.  Large tensors can be
 // restored from a thread pool: this requires creating a separate BundleReader
@@ -250,6 +262,17 @@ struct RestoreOp {
     return restored_full_shape.num_elements() > kLargeShapeThreshold;
   }
 
+  // The bytes of the full tensor, or 0 if it can't be looked up.
+  int64 full_tensor_bytes(BundleReader* reader) const {
+    DataType dtype;
+    TensorShape restored_full_shape;
+    if (!reader->LookupDtypeAndShape(tensor_name, &dtype, &restored_full_shape)
+             .ok()) {
+      return 0;
+    }
+    return restored_full_shape.num_elements() * DataTypeSize(dtype);
+  }
+
   // Run this restore operation using a new BundleReader.
   void run_with_new_reader() {
     BundleReader reader(Env::Default(), reader_prefix);
@@ -257,6 +280,9 @@ struct RestoreOp {
       status = reader.status();
       return;
     }
+    if (read_pool != nullptr) {
+      reader.EnableParallelReads(read_pool, kParallelReadBlockBytes);
+    }
 
     status = run(&reader);
   }
@@ -304,6 +330,8 @@ struct RestoreOp {
   string tensor_name;
   string shape_and_slice;
   string reader_prefix;
+  // If not null, the pool reading the contents of large tensors in parallel.
+  thread::ThreadPool* read_pool;
 
   ::tensorflow::Status status;
 };
@@ -333,33 +361,76 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   BundleReader default_reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(default_reader.status());
 
+  // Reads the blocks of large tensors, for all the readers.  This is separate
+  // from the pool of the restore ops, which blocks on the reads.
+  std::unique_ptr<thread::ThreadPool> read_pool;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    auto op =
-        new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
+    auto op = new RestoreOp{context, i, tensor_name, shape_and_slice,
+                            prefix_string, /*read_pool=*/nullptr};
+    if (read_pool == nullptr &&
+        op->full_tensor_bytes(&default_reader) > kParallelReadBlockBytes) {
+      read_pool.reset(
+          new thread::ThreadPool(Env::Default(), "restore_reads", 16));
+      default_reader.EnableParallelReads(read_pool.get(),
+                                         kParallelReadBlockBytes);
+    }
     if (op->should_run_in_pool(&default_reader)) {
       pool_restore_ops.emplace_back(op);
     } else {
       direct_restore_ops.emplace_back(op);
     }
   }
+  for (auto& op : pool_restore_ops) {
+    op->read_pool = read_pool.get();
+  }
+
+  // Splits the small tensors into chunks of consecutive names, so that many of
+  // them are restored in parallel while keeping the read locality.
+  std::vector<std::vector<RestoreOp*>> direct_chunks(1);
+  int64 chunk_bytes = 0;
+  for (auto& op : direct_restore_ops) {
+    if (chunk_bytes >= kRestoreChunkBytes) {
+      direct_chunks.emplace_back();
+      chunk_bytes = 0;
+    }
+    direct_chunks.back().push_back(op.get());
+    chunk_bytes += op->full_tensor_bytes(&default_reader);
+  }
+  std::vector<Status> chunk_statuses(direct_chunks.size());
 
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
     std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
+    if (!pool_restore_ops.empty() || direct_chunks.size() > 1) {
       reader_pool.reset(
           new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
       for (auto& op : pool_restore_ops) {
         reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
       }
+      for (size_t c = 1; c < direct_chunks.size(); ++c) {
+        reader_pool->Schedule([&direct_chunks, &chunk_statuses, &prefix_string,
+                               &read_pool, c]() {
+          BundleReader reader(Env::Default(), prefix_string);
+          chunk_statuses[c] = reader.status();
+          if (read_pool != nullptr) {
+            reader.EnableParallelReads(read_pool.get(),
+                                       kParallelReadBlockBytes);
+          }
+          for (RestoreOp* op : direct_chunks[c]) {
+            if (!chunk_statuses[c].ok()) return;
+            chunk_statuses[c] = op->run(&reader);
+          }
+        });
+      }
     }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+    // Read the first chunk of small tensors from the op thread
+    for (RestoreOp* op : direct_chunks[0]) {
+      chunk_statuses[0] = op->run(&default_reader);
+      if (!chunk_statuses[0].ok()) break;
     }
   }
 
@@ -367,6 +438,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto& op : pool_restore_ops) {
     TF_RETURN_IF_ERROR(op->status);
   }
+  for (const Status& status : chunk_statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
 
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
@@ -381,4 +455,166 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   return Status::OK();
 }
 
+namespace {
+
+// Asynchronous saves are split into shards of at least this many bytes.
+const int64 kAsyncSaveShardBytes = 64 << 20;  // 64MB
+
+// Writes the tensors at "indices" in a bundle under "prefix".
+Status WriteBundle(const string& prefix,
+                   const std::vector<string>& tensor_names,
+                   const std::vector<string>& shape_and_slices,
+                   const std::vector<Tensor>& tensors,
+                   const std::vector<int>& indices) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (int i : indices) {
+    if (shape_and_slices[i].empty()) {
+      TF_RETURN_IF_ERROR(writer.Add(tensor_names[i], tensors[i]));
+    } else {
+      TensorShape shape;
+      TensorSlice slice(tensors[i].dims());
+      TensorShape slice_shape;
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+          shape_and_slices[i], &shape, &slice, &slice_shape));
+      TF_RETURN_IF_ERROR(
+          writer.AddSlice(tensor_names[i], shape, slice, tensors[i]));
+    }
+  }
+  return writer.Finish();
+}
+
+// The asynchronous saves in flight by prefix, and the first error of those
+// that completed since the last WaitForAsyncSavesV2().
+struct AsyncSaves {
+  mutex mu;
+  condition_variable cond;
+  std::unordered_map<string, int> pending GUARDED_BY(mu);
+  std::unordered_map<string, Status> errors GUARDED_BY(mu);
+};
+
+AsyncSaves* GetAsyncSaves() {
+  static AsyncSaves* saves = new AsyncSaves;
+  return saves;
+}
+
+}  // namespace
+
+Status SaveTensorsV2(const string& prefix,
+                     const std::vector<string>& tensor_names,
+                     const std::vector<string>& shape_and_slices,
+                     const std::vector<Tensor>& tensors) {
+  std::vector<int> indices(tensors.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  return WriteBundle(prefix, tensor_names, shape_and_slices, tensors, indices);
+}
+
+void SaveTensorsV2Async(const string& prefix, std::vector<string> tensor_names,
+                        std::vector<string> shape_and_slices,
+                        std::vector<Tensor> tensors, int num_shards,
+                        std::function<void(const Status&)> done) {
+  AsyncSaves* saves = GetAsyncSaves();
+  {
+    mutex_lock l(saves->mu);
+    ++saves->pending[prefix];
+  }
+
+  // Balances the bytes of the shards by adding the largest tensors first to
+  // the smallest shard.
+  int64 total_bytes = 0;
+  for (const Tensor& tensor : tensors) {
+    total_bytes += tensor.TotalBytes();
+  }
+  num_shards = std::min<int64>(
+      {static_cast<int64>(num_shards), static_cast<int64>(tensors.size()),
+       total_bytes / kAsyncSaveShardBytes});
+  num_shards = std::max(num_shards, 1);
+  std::vector<int> order(tensors.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&tensors](int a, int b) {
+    return tensors[a].TotalBytes() > tensors[b].TotalBytes();
+  });
+  std::vector<std::vector<int>> shard_indices(num_shards);
+  std::vector<int64> shard_bytes(num_shards, 0);
+  for (int i : order) {
+    const int shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shard_indices[shard].push_back(i);
+    shard_bytes[shard] += tensors[i].TotalBytes();
+  }
+
+  Env::Default()->SchedClosure([prefix, tensor_names, shape_and_slices,
+                                tensors, shard_indices, done, saves]() {
+    Status status;
+    if (shard_indices.size() == 1) {
+      status = WriteBundle(prefix, tensor_names, shape_and_slices, tensors,
+                           shard_indices[0]);
+    } else {
+      // Each shard is written to its own bundle next to "prefix", the last
+      // one from this thread.
+      const int num_shards = shard_indices.size();
+      std::vector<string> shard_prefixes(num_shards);
+      std::vector<Status> statuses(num_shards);
+      BlockingCounter counter(num_shards - 1);
+      for (int shard = 0; shard < num_shards; ++shard) {
+        shard_prefixes[shard] = strings::StrCat(
+            prefix, "_async_temp/part-", shard, "-of-", num_shards);
+        auto write = [&, shard]() {
+          statuses[shard] =
+              WriteBundle(shard_prefixes[shard], tensor_names,
+                          shape_and_slices, tensors, shard_indices[shard]);
+        };
+        if (shard == num_shards - 1) {
+          write();
+        } else {
+          Env::Default()->SchedClosure([write, &counter]() {
+            write();
+            counter.DecrementCount();
+          });
+        }
+      }
+      counter.Wait();
+      for (const Status& shard_status : statuses) {
+        status.Update(shard_status);
+      }
+      if (status.ok()) {
+        status = MergeBundles(Env::Default(), shard_prefixes, prefix);
+      }
+      Env::Default()
+          ->DeleteDir(strings::StrCat(prefix, "_async_temp"))
+          .IgnoreError();
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << "Asynchronous save to " << prefix << " failed: " << status;
+    }
+    {
+      mutex_lock l(saves->mu);
+      if (!status.ok() && saves->errors[prefix].ok()) {
+        saves->errors[prefix] = status;
+      }
+      if (--saves->pending[prefix] == 0) {
+        saves->pending.erase(prefix);
+      }
+      saves->cond.notify_all();
+    }
+    done(status);
+  });
+}
+
+Status WaitForAsyncSavesV2(const string& prefix) {
+  AsyncSaves* saves = GetAsyncSaves();
+  mutex_lock l(saves->mu);
+  while (saves->pending.count(prefix) > 0) {
+    saves->cond.wait(l);
+  }
+  auto it = saves->errors.find(prefix);
+  if (it == saves->errors.end()) {
+    return Status::OK();
+  }
+  Status status = it->second;
+  saves->errors.erase(it);
+  return status;
+}
+
 }  // namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SAVE_RESTORE_TENSOR_H_
 #define TENSORFLOW_KERNELS_SAVE_RESTORE_TENSOR_H_
 
+#include <functional>
+#include <vector>
+
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
 
@@ -68,6 +71,28 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes);
 
+// Writes "tensors" named "tensor_names" in a V2 checkpoint under "prefix".
+// The non-empty "shape_and_slices" are the slice specs of the tensors that are
+// slices of larger ones.
+Status SaveTensorsV2(const string& prefix,
+                     const std::vector<string>& tensor_names,
+                     const std::vector<string>& shape_and_slices,
+                     const std::vector<Tensor>& tensors);
+
+// Like SaveTensorsV2(), but writes the checkpoint in the background and calls
+// "done" with the status once it is complete.  The tensors must not be
+// modified until then, so callers pass snapshots of variables made with
+// tensor::DeepCopy().  Large checkpoints are split across up to "num_shards"
+// bundles written in parallel and merged into "prefix".
+void SaveTensorsV2Async(const string& prefix, std::vector<string> tensor_names,
+                        std::vector<string> shape_and_slices,
+                        std::vector<Tensor> tensors, int num_shards,
+                        std::function<void(const Status&)> done);
+
+// Blocks until the SaveTensorsV2Async() calls writing "prefix" are complete.
+// Returns the first of their errors since the last call, or OK.
+Status WaitForAsyncSavesV2(const string& prefix);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_SAVE_RESTORE_TENSOR_H_
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -37,6 +38,9 @@ namespace tensorflow {
 
 namespace {
 
+// The maximum number of bundles written in parallel by an asynchronous save.
+const int kAsyncSaveNumShards = 8;
+
 // Shared validations of the inputs to the SaveV2 and RestoreV2 ops.
 void ValidateInputs(bool is_save_op, OpKernelContext* context,
                     const Tensor& prefix, const Tensor& tensor_names,
@@ -90,7 +94,9 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("asynchronous", &asynchronous_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -105,12 +111,12 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<string>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<string> names(num_tensors);
+    std::vector<string> slices(num_tensors);
+    std::vector<Tensor> tensors(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
+      names[i] = tensor_names_flat(i);
+      slices[i] = shape_and_slices_flat(i);
       const Tensor& tensor = context->input(i + kFixedInputs);
 
       if (!shape_and_slices_flat(i).empty()) {
@@ -127,15 +133,29 @@ class SaveV2 : public OpKernel {
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
                                             tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
       }
+      // Snapshots the tensors of an asynchronous save, since variables may
+      // be updated while they are written.
+      tensors[i] = asynchronous_ ? tensor::DeepCopy(tensor) : tensor;
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+
+    // Errors of the earlier asynchronous saves are logged and superseded.
+    WaitForAsyncSavesV2(prefix_string).IgnoreError();
+    if (asynchronous_) {
+      VLOG(1) << "Asynchronous save, prefix_string: " << prefix_string;
+      SaveTensorsV2Async(prefix_string, std::move(names), std::move(slices),
+                         std::move(tensors), kAsyncSaveNumShards,
+                         [](const Status&) {});
+      return;
+    }
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
+    OP_REQUIRES_OK(context,
+                   SaveTensorsV2(prefix_string, names, slices, tensors));
   }
+
+ private:
+  // Whether the tensors are written in the background, after Compute().
+  bool asynchronous_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -158,6 +178,7 @@ class RestoreV2 : public OpKernel {
                    shape_and_slices);
 
     const string& prefix_string = prefix.scalar<string>()();
+    OP_REQUIRES_OK(context, WaitForAsyncSavesV2(prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -216,6 +237,9 @@ class MergeV2Checkpoints : public OpKernel {
         gtl::ArraySlice<string>(checkpoint_prefixes.flat<string>());
     Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<string>()();
+    for (const string& input_prefix : input_prefixes) {
+      OP_REQUIRES_OK(context, WaitForAsyncSavesV2(input_prefix));
+    }
     OP_REQUIRES_OK(
         context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
@@ -339,5 +340,37 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+TEST_F(SaveV2OpTest, Async) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async");
+  TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                   .Input(FakeInput())            // prefix
+                   .Input(FakeInput())            // tensor_names
+                   .Input(FakeInput())            // shape_and_slices
+                   .Input(FakeInput({DT_FLOAT}))  // tensors
+                   .Attr("asynchronous", true)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInputFromArray<string>(TensorShape({1}), {"tensor_float"});
+  AddInputFromArray<string>(TensorShape({1}), {""});
+  AddInput<float>(TensorShape({2, 4}),
+                  [](int x) -> float { return static_cast<float>(x) / 10; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The tensor was snapshotted, so updating it doesn't change the checkpoint.
+  tensors_[3]->flat<float>().setZero();
+  TF_ASSERT_OK(WaitForAsyncSavesV2(prefix));
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_float", &val));
+  EXPECT_EQ(DT_FLOAT, val.dtype());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(static_cast<float>(i) / 10, val.template flat<float>()(i));
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
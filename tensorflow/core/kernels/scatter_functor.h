@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 #define TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -184,6 +186,69 @@ struct AssignSYCL<scatter_op::UpdateOp::MAX> {
 };
 #endif  // TENSORFLOW_USE_SYCL
 
+// The minimum number of updated elements for the CPU functors to apply the
+// updates in parallel.
+constexpr int64 kMinParallelScatterSize = 1 << 15;
+
+// Applies `update_row(i, index)` for each `index = indices(i)` on the threads
+// of `d`. The rows of params are split into ranges, each updated by a single
+// thread in the order of `indices`, so that no locking is needed and repeated
+// indices are updated in the same order as serially. Sets `*bad_i` to the
+// first i whose index is not in [0, limit), without applying any update, or
+// to -1. Returns false, without applying any update, if the update is too
+// small to be worth it.
+template <typename Device, typename Index, typename UpdateRow>
+bool ParallelScatter(const Device& d, typename TTypes<Index>::ConstFlat indices,
+                     Index limit, int64 row_size, UpdateRow update_row,
+                     Index* bad_i) {
+  const Index N = static_cast<Index>(indices.size());
+  const int num_threads = d.numThreads();
+  if (num_threads <= 1 || N < 2 || N * row_size < kMinParallelScatterSize) {
+    return false;
+  }
+  std::vector<Index> rows(N);
+  for (Index i = 0; i < N; i++) {
+    rows[i] = ::tensorflow::internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(rows[i], limit)) {
+      *bad_i = i;
+      return true;
+    }
+  }
+  // A few ranges per thread balance the indices that are not uniform.
+  const int64 num_ranges = std::min<int64>(4 * num_threads, limit);
+  auto range_of = [limit, num_ranges](Index row) {
+    return static_cast<int64>(row) * num_ranges / limit;
+  };
+  std::vector<int64> range_starts(num_ranges + 1, 0);
+  for (Index i = 0; i < N; i++) {
+    ++range_starts[range_of(rows[i]) + 1];
+  }
+  for (int64 r = 0; r < num_ranges; r++) {
+    range_starts[r + 1] += range_starts[r];
+  }
+  std::vector<Index> order(N);
+  {
+    std::vector<int64> next(range_starts.begin(), range_starts.end() - 1);
+    for (Index i = 0; i < N; i++) {
+      order[next[range_of(rows[i])]++] = i;
+    }
+  }
+  const double cost_per_range =
+      static_cast<double>(N) * row_size / num_ranges;
+  d.parallelFor(num_ranges, Eigen::TensorOpCost(0, 0, cost_per_range),
+                [&](int64 begin, int64 end) {
+                  for (int64 r = begin; r < end; r++) {
+                    for (int64 k = range_starts[r]; k < range_starts[r + 1];
+                         k++) {
+                      const Index i = order[k];
+                      update_row(i, rows[i]);
+                    }
+                  }
+                });
+  *bad_i = -1;
+  return true;
+}
+
 }  // namespace internal
 }  // namespace scatter_op
 
@@ -320,7 +385,27 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
 
 template <typename T, typename Index, scatter_op::UpdateOp op>
 struct ScatterFunctor<CPUDevice, T, Index, op>
-    : ScatterFunctorBase<CPUDevice, T, Index, op> {};
+    : ScatterFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    Index bad_i;
+    if (scatter_op::internal::ParallelScatter(
+            d, indices, static_cast<Index>(params.dimension(0)),
+            updates.dimension(1),
+            [&params, &updates](Index i, Index index) {
+              // Copy last Ndim-1 dimensions of updates[i] to params[index]
+              scatter_op::internal::Assign<op>::Run(
+                  params.template chip<0>(index), updates.template chip<0>(i));
+            },
+            &bad_i)) {
+      return bad_i;
+    }
+    return ScatterFunctorBase<CPUDevice, T, Index, op>::operator()(
+        c, d, params, updates, indices);
+  }
+};
 
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T, typename Index, scatter_op::UpdateOp op>
@@ -461,7 +546,27 @@ struct ScatterScalarFunctorBase<CPUDevice, T, Index,
 
 template <typename T, typename Index, scatter_op::UpdateOp op>
 struct ScatterScalarFunctor<CPUDevice, T, Index, op>
-    : ScatterScalarFunctorBase<CPUDevice, T, Index, op> {};
+    : ScatterScalarFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   const typename TTypes<T>::ConstScalar update,
+                   typename TTypes<Index>::ConstFlat indices) {
+    Index bad_i;
+    if (scatter_op::internal::ParallelScatter(
+            d, indices, static_cast<Index>(params.dimension(0)),
+            params.dimension(1),
+            [&params, &update](Index i, Index index) {
+              // Broadcast update to params[index]
+              scatter_op::internal::Assign<op>::RunScalar(
+                  params.template chip<0>(index), update());
+            },
+            &bad_i)) {
+      return bad_i;
+    }
+    return ScatterScalarFunctorBase<CPUDevice, T, Index, op>::operator()(
+        c, d, params, update, indices);
+  }
+};
 
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T, typename Index, scatter_op::UpdateOp op>
@@ -227,6 +227,95 @@ TEST_F(ScatterUpdateOpTest, Error_MismatchedIndicesAndUpdateDimensions) {
       << s;
 }
 
+// The large updates below are applied in parallel on ranges of rows.
+TEST_F(ScatterUpdateOpTest, Large_RepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  const int kRows = 1000;
+  const int kCols = 64;
+  const int kUpdates = 4000;
+  std::vector<float> params(kRows * kCols, 0);
+  std::vector<int32> indices(kUpdates);
+  std::vector<float> updates(kUpdates * kCols);
+  for (int i = 0; i < kUpdates; ++i) {
+    indices[i] = (i * 7919) % kRows;
+    for (int j = 0; j < kCols; ++j) {
+      updates[i * kCols + j] = i * kCols + j;
+      // The last update of a row wins.
+      params[indices[i] * kCols + j] = i * kCols + j;
+    }
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 0));
+  AddInputFromArray<int32>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, params);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
+TEST_F(ScatterUpdateOpTest, Large_Error_IndexOutOfRange) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  const int kRows = 1000;
+  const int kCols = 64;
+  const int kUpdates = 4000;
+  std::vector<int32> indices(kUpdates, 0);
+  indices[1234] = 1000;
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 0));
+  AddInputFromArray<int32>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}),
+                           std::vector<float>(kUpdates * kCols, 1));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(str_util::StrContains(s.ToString(),
+                                    "indices[1234] = 1000 is not in [0, 1000)"))
+      << s;
+}
+
+class ScatterAddOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType variable_ref_type, DataType index_type) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "ScatterAdd")
+                     .Input(FakeInput(variable_ref_type))
+                     .Input(FakeInput(index_type))
+                     .Input(FakeInput(RemoveRefType(variable_ref_type)))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(ScatterAddOpTest, Large_RepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT64);
+
+  const int kRows = 1000;
+  const int kCols = 64;
+  const int kUpdates = 4000;
+  std::vector<float> params(kRows * kCols, 1);
+  std::vector<int64> indices(kUpdates);
+  std::vector<float> updates(kUpdates * kCols);
+  std::vector<float> expected_params = params;
+  for (int i = 0; i < kUpdates; ++i) {
+    indices[i] = (i * i) % kRows;
+    for (int j = 0; j < kCols; ++j) {
+      updates[i * kCols + j] = i % 5 + j;
+      expected_params[indices[i] * kCols + j] += i % 5 + j;
+    }
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), params);
+  AddInputFromArray<int64>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, expected_params);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
 class ScatterUpdateBM : public ScatterUpdateOpTest {
  public:
   void TestBody() override {}
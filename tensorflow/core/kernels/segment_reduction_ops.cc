@@ -1000,6 +1000,214 @@ REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
+#if GOOGLE_CUDA
+// SparseSegmentReductionGPUOp is the GPU implementation of the sparse segment
+// reduction ops, which embedding_lookup_sparse runs. It gathers and reduces
+// the input rows in a single kernel. The segment ids must be sorted: unlike
+// the CPU kernels, it does not check them, and out of range indices read as
+// zeros.
+template <class T>
+class SparseSegmentReductionGPUOp : public AsyncOpKernel {
+ public:
+  SparseSegmentReductionGPUOp(OpKernelConstruction* context, bool is_mean,
+                              bool is_sqrtn, bool has_num_segments)
+      : AsyncOpKernel(context),
+        is_mean_(is_mean),
+        is_sqrtn_(is_sqrtn),
+        has_num_segments_(has_num_segments) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVectorOrHigher(input.shape()),
+        errors::InvalidArgument("data must be at least 1 dimensional."), done);
+    OP_REQUIRES_ASYNC(context, TensorShapeUtils::IsVector(indices.shape()),
+                      errors::InvalidArgument("indices should be a vector."),
+                      done);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(segment_ids.shape()),
+        errors::InvalidArgument("segment_ids should be a vector."), done);
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES_ASYNC(context, num_indices == segment_ids.NumElements(),
+                      errors::InvalidArgument(
+                          "segment_ids and indices should have same size."),
+                      done);
+
+    if (has_num_segments_) {
+      const Tensor& num_segments = context->input(3);
+      OP_REQUIRES_ASYNC(
+          context, num_segments.shape().dims() == 0,
+          errors::InvalidArgument("num_segments should be a scalar, not shape ",
+                                  num_segments.shape().DebugString()),
+          done);
+      const int32 output_rows =
+          internal::SubtleMustCopy(num_segments.scalar<int32>()());
+      OP_REQUIRES_ASYNC(context, output_rows >= 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      ComputeWithOutputRows(context, output_rows);
+      done();
+      return;
+    }
+    if (num_indices == 0) {
+      ComputeWithOutputRows(context, 0);
+      done();
+      return;
+    }
+
+    // The segment ids are sorted, so the last one gives the number of output
+    // rows, once copied to the host.
+    se::DeviceMemoryBase last_segment_id_device(
+        const_cast<Tensor&>(segment_ids).flat<int32>().data() +
+        (num_indices - 1));
+    ScratchSpace<int32> last_segment_id_host(context, 1, /* on_host */ true);
+
+    auto stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(last_segment_id_host.mutable_data(),
+                         last_segment_id_device, sizeof(int32))
+            .ok(),
+        errors::Internal("SparseSegmentReductionGPUOp: failed to copy the "
+                         "last segment id from device"),
+        done);
+
+    auto compute = [this, context, last_segment_id_host, done]() {
+      // Ensure that within the callback, the proper GPU settings are
+      // configured.
+      auto stream = context->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{stream->parent()};
+
+      const int32 output_rows = *last_segment_id_host.data() + 1;
+      OP_REQUIRES_ASYNC(context, output_rows > 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+      ComputeWithOutputRows(context, output_rows);
+      done();
+    };
+
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, compute);
+  }
+
+ private:
+  void ComputeWithOutputRows(OpKernelContext* context, int32 output_rows) {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    functor::SparseSegmentReductionFunctor<T, int32>()(
+        context->eigen_device<GPUDevice>(), is_mean_, is_sqrtn_, T(0),
+        input.flat_outer_dims<T>(), indices.vec<int32>(),
+        segment_ids.vec<int32>(), output->flat_outer_dims<T>());
+  }
+
+  const bool is_mean_;
+  const bool is_sqrtn_;
+  const bool has_num_segments_;
+};
+
+template <class T>
+class SparseSegmentReductionSumGPUOp : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionSumGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, false /*is_mean*/,
+                                       false /*is_sqrtn*/,
+                                       false /* has_num_segments */) {}
+};
+
+template <class T>
+class SparseSegmentReductionSumWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionSumWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, false /*is_mean*/,
+                                       false /*is_sqrtn*/,
+                                       true /* has_num_segments */) {}
+};
+
+template <class T>
+class SparseSegmentReductionMeanGPUOp : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionMeanGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, true /*is_mean*/,
+                                       false /*is_sqrtn*/,
+                                       false /* has_num_segments */) {}
+};
+
+template <class T>
+class SparseSegmentReductionMeanWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionMeanWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, true /*is_mean*/,
+                                       false /*is_sqrtn*/,
+                                       true /* has_num_segments */) {}
+};
+
+template <class T>
+class SparseSegmentReductionSqrtNGPUOp : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionSqrtNGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, false /*is_mean*/,
+                                       true /*is_sqrtn*/,
+                                       false /* has_num_segments */) {}
+};
+
+template <class T>
+class SparseSegmentReductionSqrtNWithNumSegmentsGPUOp
+    : public SparseSegmentReductionGPUOp<T> {
+ public:
+  explicit SparseSegmentReductionSqrtNWithNumSegmentsGPUOp(
+      OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T>(context, false /*is_mean*/,
+                                       true /*is_sqrtn*/,
+                                       true /* has_num_segments */) {}
+};
+
+#define REGISTER_GPU_SPARSE_KERNELS(name, op, type)                   \
+  REGISTER_KERNEL_BUILDER(Name(name)                                  \
+                              .Device(DEVICE_GPU)                     \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<int32>("Tidx"),         \
+                          op##GPUOp<type>);                           \
+  REGISTER_KERNEL_BUILDER(Name(name "WithNumSegments")                \
+                              .Device(DEVICE_GPU)                     \
+                              .HostMemory("num_segments")             \
+                              .TypeConstraint<type>("T")              \
+                              .TypeConstraint<int32>("Tidx")          \
+                              .TypeConstraint<int32>("Tnumsegments"), \
+                          op##WithNumSegmentsGPUOp<type>);
+
+
+#define REGISTER_GPU_SPARSE_SUM_KERNELS(type)                                \
+  REGISTER_GPU_SPARSE_KERNELS("SparseSegmentSum", SparseSegmentReductionSum, \
+                              type)
+
+#define REGISTER_GPU_SPARSE_MEAN_KERNELS(type)                                 \
+  REGISTER_GPU_SPARSE_KERNELS("SparseSegmentMean", SparseSegmentReductionMean, \
+                              type)                                            \
+  REGISTER_GPU_SPARSE_KERNELS("SparseSegmentSqrtN",                            \
+                              SparseSegmentReductionSqrtN, type)
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_SPARSE_SUM_KERNELS);
+REGISTER_GPU_SPARSE_MEAN_KERNELS(float);
+REGISTER_GPU_SPARSE_MEAN_KERNELS(double);
+#undef REGISTER_GPU_SPARSE_KERNELS
+#undef REGISTER_GPU_SPARSE_SUM_KERNELS
+#undef REGISTER_GPU_SPARSE_MEAN_KERNELS
+#endif  // GOOGLE_CUDA
+
 template <class T>
 class SparseSegmentGradOpBase : public OpKernel {
  public:
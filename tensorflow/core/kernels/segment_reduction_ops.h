@@ -68,6 +68,24 @@ struct SegmentSumFunctor {
                   typename TTypes<T, 2>::Tensor output);
 };
 
+// Functor for SparseSegmentReductionGPUOp.
+// is_mean, is_sqrtn: whether to divide the sums by the number of rows in
+//                the segment, or by its square root.
+// default_value: value of the output rows of the empty segments.
+// input: input data tensor, reshaped to {input_rows, input.size/input_rows}.
+// indices: the input rows to reduce.
+// segment_ids: sorted output segment ids of the rows in 'indices'.
+// output: output reshaped to {output_rows, output.size/output_rows}
+template <typename T, typename Index>
+struct SparseSegmentReductionFunctor {
+  void operator()(const GPUDevice& d, const bool is_mean, const bool is_sqrtn,
+                  const T default_value,
+                  typename TTypes<T, 2>::ConstTensor input,
+                  typename TTypes<Index>::ConstVec indices,
+                  typename TTypes<int32>::ConstVec segment_ids,
+                  typename TTypes<T, 2>::Tensor output);
+};
+
 #endif
 
 template <typename Device, typename T, typename Index, typename InitialValueF,
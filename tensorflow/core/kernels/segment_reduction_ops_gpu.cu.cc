@@ -22,7 +22,13 @@ limitations under the License.
 #include "tensorflow/core/util/cuda_kernel_helper.h"
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+
+#include <limits>
+
+#include "external/cub_archive/cub/device/device_radix_sort.cuh"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/util/cuda_device_functions.h"
 
 
@@ -125,8 +131,183 @@ __global__ void UnsortedSegmentCustomKernel(const Index input_outer_dim_size,
   }
 }
 
+template <typename Index>
+__global__ void RowIndicesKernel(const Index num_rows, Index* rows) {
+  for (Index row : CudaGridRangeX(num_rows)) {
+    rows[row] = row;
+  }
+}
+
+// SortedRowsSegmentSumKernel reduces the input rows of an unsorted segment
+// sum after they have been sorted by segment id, so that the rows of each
+// segment are consecutive. For each inner dimension index, the thread that
+// handles the first row of a segment sums the whole segment, in a fixed
+// order and without atomic operations.
+template <typename T, typename Index>
+__global__ void SortedRowsSegmentSumKernel(const Index num_rows,
+                                           const Index inner_dim_size,
+                                           const Index output_outer_dim_size,
+                                           const Index* sorted_segment_ids,
+                                           const Index* sorted_rows,
+                                           const T* input, T* output) {
+  for (Index index : CudaGridRangeX(num_rows * inner_dim_size)) {
+    const Index first = index / inner_dim_size;
+    const Index segment_offset = index % inner_dim_size;
+    const Index segment_id = ldg(sorted_segment_ids + first);
+    if (segment_id < 0 || segment_id >= output_outer_dim_size) continue;
+    if (first > 0 && ldg(sorted_segment_ids + first - 1) == segment_id) {
+      continue;
+    }
+    T sum = T(0);
+    for (Index i = first;
+         i < num_rows && ldg(sorted_segment_ids + i) == segment_id; ++i) {
+      sum += ldg(input + ldg(sorted_rows + i) * inner_dim_size +
+                 segment_offset);
+    }
+    output[segment_id * inner_dim_size + segment_offset] = sum;
+  }
+}
+
+// SparseSegmentReductionKernel computes one output element per thread. It
+// finds the rows of its segment by a binary search in the sorted
+// 'segment_ids', then gathers and reduces them, so that the gather of
+// embedding_lookup_sparse is fused with the reduction and needs no atomic
+// operations. Out of range indices are read as zeros.
+template <typename T, typename Index>
+__global__ void SparseSegmentReductionKernel(
+    const Index num_indices, const Index input_outer_dim_size,
+    const Index inner_dim_size, const Index output_outer_dim_size,
+    const bool is_mean, const bool is_sqrtn, const T default_value,
+    const Index* indices, const int32* segment_ids, const T* input,
+    T* output) {
+  for (Index output_index :
+       CudaGridRangeX(output_outer_dim_size * inner_dim_size)) {
+    const Index segment_id = output_index / inner_dim_size;
+    const Index segment_offset = output_index % inner_dim_size;
+    Index first = 0;
+    Index last = num_indices;
+    while (first < last) {
+      const Index middle = first + (last - first) / 2;
+      if (ldg(segment_ids + middle) < segment_id) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+    T sum = T(0);
+    Index count = 0;
+    for (Index i = first;
+         i < num_indices && ldg(segment_ids + i) == segment_id; ++i) {
+      const Index row = ldg(indices + i);
+      if (FastBoundsCheck(row, input_outer_dim_size)) {
+        sum += ldg(input + row * inner_dim_size + segment_offset);
+      }
+      ++count;
+    }
+    if (count == 0) {
+      sum = default_value;
+    } else if (is_mean) {
+      sum /= T(count);
+    } else if (is_sqrtn) {
+      sum /= T(sqrt(static_cast<double>(count)));
+    }
+    output[output_index] = sum;
+  }
+}
+
 namespace functor {
 
+namespace {
+
+// An unsorted segment sum is reduced with atomic operations, which are
+// nondeterministic and serialize on the large segments, e.g. on the popular
+// ids of an embedding gradient. Sorting the rows by segment id first avoids
+// both issues, and is worth its cost when the segments are large on average,
+// or the rows are wide enough for the sort to be cheap in comparison.
+const int kSortedRowsMinSegmentSize = 16;
+const int kSortedRowsMinInnerDimSize = 64;
+
+// Reduces the input with SortedRowsSegmentSumKernel instead of atomic
+// operations if ReductionF allows it and it is expected to be faster. Returns
+// whether it did.
+template <typename T, typename Index, typename ReductionF>
+struct SortedRowsSegmentReduction {
+  bool operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  const Index num_rows, const Index inner_dim_size,
+                  const Index num_segments, const Index* segment_ids,
+                  const T* input, T* output) {
+    return false;
+  }
+};
+
+template <typename T, typename Index>
+struct SortedRowsSegmentReduction<T, Index, SumOpGpu<T>> {
+  bool operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  const Index num_rows, const Index inner_dim_size,
+                  const Index num_segments, const Index* segment_ids,
+                  const T* input, T* output) {
+    // cub sorts at most int32 max items.
+    if (num_rows > std::numeric_limits<int>::max()) return false;
+    if (num_rows < kSortedRowsMinSegmentSize * num_segments &&
+        inner_dim_size < kSortedRowsMinInnerDimSize) {
+      return false;
+    }
+
+    const Status status = SortAndSum(ctx, d, num_rows, inner_dim_size,
+                                     num_segments, segment_ids, input, output);
+    if (!status.ok()) ctx->SetStatus(status);
+    return true;
+  }
+
+ private:
+  static Status SortAndSum(OpKernelContext* ctx, const GPUDevice& d,
+                           const Index num_rows, const Index inner_dim_size,
+                           const Index num_segments, const Index* segment_ids,
+                           const T* input, T* output) {
+    const DataType index_type = DataTypeToEnum<Index>::value;
+    Tensor rows;
+    Tensor sorted_rows;
+    Tensor sorted_segment_ids;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(index_type, TensorShape({num_rows}), &rows));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(index_type, TensorShape({num_rows}), &sorted_rows));
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        index_type, TensorShape({num_rows}), &sorted_segment_ids));
+    Index* rows_ptr = rows.flat<Index>().data();
+    Index* sorted_rows_ptr = sorted_rows.flat<Index>().data();
+    Index* sorted_segment_ids_ptr = sorted_segment_ids.flat<Index>().data();
+
+    CudaLaunchConfig config = GetCudaLaunchConfig(num_rows, d);
+    RowIndicesKernel<Index>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            num_rows, rows_ptr);
+
+    size_t temp_storage_bytes = 0;
+    cub::DeviceRadixSort::SortPairs(
+        nullptr, temp_storage_bytes, segment_ids, sorted_segment_ids_ptr,
+        rows_ptr, sorted_rows_ptr, static_cast<int>(num_rows), 0,
+        sizeof(Index) * 8, d.stream());
+    Tensor temp_storage;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+        &temp_storage));
+    cub::DeviceRadixSort::SortPairs(
+        temp_storage.flat<int8>().data(), temp_storage_bytes, segment_ids,
+        sorted_segment_ids_ptr, rows_ptr, sorted_rows_ptr,
+        static_cast<int>(num_rows), 0, sizeof(Index) * 8, d.stream());
+
+    config = GetCudaLaunchConfig(num_rows * inner_dim_size, d);
+    SortedRowsSegmentSumKernel<T, Index>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            num_rows, inner_dim_size, num_segments, sorted_segment_ids_ptr,
+            sorted_rows_ptr, input, output);
+    return Status::OK();
+  }
+};
+
+}  // namespace
+
 template <typename T, typename Index>
 void SegmentSumFunctor<T, Index>::operator()(
     OpKernelContext* ctx, const GPUDevice& d, const Index output_rows,
@@ -194,6 +375,11 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
     // *) 'input_outer_dim_size' is the total number of segments to process.
     const Index input_outer_dim_size = segment_ids.dimension(0);
     const Index input_inner_dim_size = data_size / input_outer_dim_size;
+    if (SortedRowsSegmentReduction<T, Index, ReductionF>()(
+            ctx, d, input_outer_dim_size, input_inner_dim_size, num_segments,
+            segment_ids.data(), data, output.data())) {
+      return;
+    }
     config = GetCudaLaunchConfig(data_size, d);
 
     UnsortedSegmentCustomKernel<T, Index, ReductionF>
@@ -203,6 +389,24 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
   }
 };
 
+template <typename T, typename Index>
+void SparseSegmentReductionFunctor<T, Index>::operator()(
+    const GPUDevice& d, const bool is_mean, const bool is_sqrtn,
+    const T default_value, typename TTypes<T, 2>::ConstTensor input,
+    typename TTypes<Index>::ConstVec indices,
+    typename TTypes<int32>::ConstVec segment_ids,
+    typename TTypes<T, 2>::Tensor output) {
+  if (output.size() == 0) {
+    return;
+  }
+  CudaLaunchConfig config = GetCudaLaunchConfig(output.size(), d);
+  SparseSegmentReductionKernel<T, Index>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          indices.size(), input.dimension(0), input.dimension(1),
+          output.dimension(0), is_mean, is_sqrtn, default_value,
+          indices.data(), segment_ids.data(), input.data(), output.data());
+}
+
 #define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index) \
   template struct SegmentSumFunctor<T, Index>
 
@@ -212,6 +416,11 @@ struct UnsortedSegmentFunctor<GPUDevice, T, Index, InitialValueF, ReductionF> {
 
 TF_CALL_GPU_NUMBER_TYPES(DEFINE_SORTED_GPU_SPECS);
 
+#define DEFINE_SPARSE_GPU_SPECS(T) \
+  template struct SparseSegmentReductionFunctor<T, int32>;
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_SPARSE_GPU_SPECS);
+
 #define DEFINE_REAL_UNSORTED_GPU_SPECS_INDEX(T, Index)                         \
   template struct UnsortedSegmentFunctor<                                      \
       GPUDevice, T, Index, functor::Lowest<T>, functor::MaxOpGpu<T>>;          \
@@ -242,6 +451,7 @@ TF_CALL_complex128(DEFINE_SUM_GPU_SPECS);
 
 #undef DEFINE_SORTED_GPU_SPECS_INDEX
 #undef DEFINE_SORTED_GPU_SPECS
+#undef DEFINE_SPARSE_GPU_SPECS
 #undef DEFINE_REAL_UNSORTED_GPU_SPECS_INDEX
 #undef DEFINE_SUM_UNSORTED_GPU_SPECS_INDEX
 #undef DEFINE_REAL_GPU_SPECS
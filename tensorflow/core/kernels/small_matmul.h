@@ -0,0 +1,178 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SMALL_MATMUL_H_
+#define TENSORFLOW_CORE_KERNELS_SMALL_MATMUL_H_
+
+#include <type_traits>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Matrix products whose dimensions are all below kSmallMatMulMaxDim are
+// computed inline by SmallMatMul, since the blocking and thread pool setup of
+// the Eigen contraction costs more than the product itself.
+constexpr int64 kSmallMatMulMaxDim = 64;
+
+// Returns true if SmallMatMul computes the product of a [m, k] and a [k, n]
+// matrix of T. Matrix-vector products (n = 1) are left to Eigen, which
+// vectorizes them along k.
+template <typename T>
+bool IsSmallMatMul(int64 m, int64 n, int64 k) {
+  return (std::is_same<T, float>::value || std::is_same<T, double>::value) &&
+         Eigen::internal::packet_traits<T>::Vectorizable && m > 0 && n > 1 &&
+         k > 0 && m < kSmallMatMulMaxDim && n < kSmallMatMulMaxDim &&
+         k < kSmallMatMulMaxDim;
+}
+
+namespace small_matmul {
+
+// Computes the [kRows, kPackets * packet size] tile of the product at `out`
+// from the rows of `a` and the row-major [k, n] matrix `b`, keeping the whole
+// tile in registers over the reduction. `a` is read with the given strides
+// between its rows and columns, so that it may be transposed. The
+// accumulators are separate variables rather than an array, which compilers
+// only keep in registers when they fully unroll the loops over it.
+template <typename T, int kRows, int kPackets>
+void Tile(const T* a, int64 a_row_stride, int64 a_col_stride, const T* b,
+          int64 n, int64 k, T* out) {
+  static_assert(kRows >= 1 && kRows <= 4, "Tiles have 1 to 4 rows");
+  static_assert(kPackets >= 1 && kPackets <= 3, "Tiles have 1 to 3 packets");
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  using Eigen::internal::pmadd;
+  using Eigen::internal::pset1;
+  const int kPacketSize = Eigen::internal::unpacket_traits<Packet>::size;
+  Packet c00 = pset1<Packet>(T(0)), c01 = c00, c02 = c00, c10 = c00,
+         c11 = c00, c12 = c00, c20 = c00, c21 = c00, c22 = c00, c30 = c00,
+         c31 = c00, c32 = c00;
+  for (int64 p = 0; p < k; ++p) {
+    const T* a_p = a + p * a_col_stride;
+    const Packet b0 = Eigen::internal::ploadu<Packet>(b + p * n);
+    const Packet b1 =
+        kPackets > 1 ? Eigen::internal::ploadu<Packet>(b + p * n + kPacketSize)
+                     : b0;
+    const Packet b2 =
+        kPackets > 2
+            ? Eigen::internal::ploadu<Packet>(b + p * n + 2 * kPacketSize)
+            : b0;
+    Packet a_rp = pset1<Packet>(a_p[0]);
+    c00 = pmadd(a_rp, b0, c00);
+    if (kPackets > 1) c01 = pmadd(a_rp, b1, c01);
+    if (kPackets > 2) c02 = pmadd(a_rp, b2, c02);
+    if (kRows > 1) {
+      a_rp = pset1<Packet>(a_p[a_row_stride]);
+      c10 = pmadd(a_rp, b0, c10);
+      if (kPackets > 1) c11 = pmadd(a_rp, b1, c11);
+      if (kPackets > 2) c12 = pmadd(a_rp, b2, c12);
+    }
+    if (kRows > 2) {
+      a_rp = pset1<Packet>(a_p[2 * a_row_stride]);
+      c20 = pmadd(a_rp, b0, c20);
+      if (kPackets > 1) c21 = pmadd(a_rp, b1, c21);
+      if (kPackets > 2) c22 = pmadd(a_rp, b2, c22);
+    }
+    if (kRows > 3) {
+      a_rp = pset1<Packet>(a_p[3 * a_row_stride]);
+      c30 = pmadd(a_rp, b0, c30);
+      if (kPackets > 1) c31 = pmadd(a_rp, b1, c31);
+      if (kPackets > 2) c32 = pmadd(a_rp, b2, c32);
+    }
+  }
+  const Packet acc[4][3] = {
+      {c00, c01, c02}, {c10, c11, c12}, {c20, c21, c22}, {c30, c31, c32}};
+  for (int r = 0; r < kRows; ++r) {
+    for (int c = 0; c < kPackets; ++c) {
+      Eigen::internal::pstoreu(out + r * n + c * kPacketSize, acc[r][c]);
+    }
+  }
+}
+
+// Computes kRows rows of the product, by tiles of three packets, then one
+// packet, then the remaining columns one at a time.
+template <typename T, int kRows>
+void Rows(const T* a, int64 a_row_stride, int64 a_col_stride, const T* b,
+          int64 n, int64 k, T* out) {
+  const int64 packet_size = Eigen::internal::unpacket_traits<
+      typename Eigen::internal::packet_traits<T>::type>::size;
+  int64 j = 0;
+  for (; j + 3 * packet_size <= n; j += 3 * packet_size) {
+    Tile<T, kRows, 3>(a, a_row_stride, a_col_stride, b + j, n, k, out + j);
+  }
+  for (; j + packet_size <= n; j += packet_size) {
+    Tile<T, kRows, 1>(a, a_row_stride, a_col_stride, b + j, n, k, out + j);
+  }
+  for (; j < n; ++j) {
+    for (int r = 0; r < kRows; ++r) {
+      T sum(0);
+      for (int64 p = 0; p < k; ++p) {
+        sum += a[r * a_row_stride + p * a_col_stride] * b[p * n + j];
+      }
+      out[r * n + j] = sum;
+    }
+  }
+}
+
+}  // namespace small_matmul
+
+// Computes the row-major [m, n] `out` = op(a) * op(b), where op(a) is [m, k]
+// and op(b) is [k, n], and op transposes its matrix if `transpose_a` or
+// `transpose_b` is set. Requires IsSmallMatMul<T>(m, n, k).
+template <typename T>
+void SmallMatMul(const T* a, const T* b, int64 m, int64 n, int64 k,
+                 bool transpose_a, bool transpose_b, T* out) {
+  constexpr int kRows = 4;
+  // The tiles load packets of the rows of op(b), which must then be
+  // contiguous.
+  T b_transposed[kSmallMatMulMaxDim * kSmallMatMulMaxDim];
+  if (transpose_b) {
+    for (int64 p = 0; p < k; ++p) {
+      for (int64 j = 0; j < n; ++j) {
+        b_transposed[p * n + j] = b[j * k + p];
+      }
+    }
+    b = b_transposed;
+  }
+  const int64 a_row_stride = transpose_a ? 1 : k;
+  const int64 a_col_stride = transpose_a ? m : 1;
+  int64 i = 0;
+  for (; i + kRows <= m; i += kRows) {
+    small_matmul::Rows<T, kRows>(a + i * a_row_stride, a_row_stride,
+                                 a_col_stride, b, n, k, out + i * n);
+  }
+  const T* a_rest = a + i * a_row_stride;
+  T* out_rest = out + i * n;
+  switch (m - i) {
+    case 3:
+      small_matmul::Rows<T, 3>(a_rest, a_row_stride, a_col_stride, b, n, k,
+                               out_rest);
+      break;
+    case 2:
+      small_matmul::Rows<T, 2>(a_rest, a_row_stride, a_col_stride, b, n, k,
+                               out_rest);
+      break;
+    case 1:
+      small_matmul::Rows<T, 1>(a_rest, a_row_stride, a_col_stride, b, n, k,
+                               out_rest);
+      break;
+  }
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SMALL_MATMUL_H_
@@ -13,8 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+
 // Contains OP to generate sparse crosses.
 #include <assert.h>
+#include <algorithm>
 #include <limits>
 #include <string>
 #include <vector>
@@ -27,13 +29,77 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
-#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 namespace {
+// The feature values of an input, converted once per batch to the
+// representation the crosser combines, so that crossing only reads them.
+template <typename InternalType>
+class FeatureValues;
+
+// InternalType is int64 only when using HashCrosser. String values are
+// fingerprinted, int64 values are read from the input tensor.
+template <>
+class FeatureValues<int64> {
+ public:
+  FeatureValues(OpKernelContext* context, const Tensor& values) {
+    if (DT_STRING != values.dtype()) {
+      data_ = values.flat<int64>().data();
+      return;
+    }
+    const auto strings = values.flat<string>();
+    fingerprints_.resize(strings.size());
+    auto fingerprint = [this, &strings](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        fingerprints_[i] = Fingerprint64(strings(i));
+      }
+    };
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    const int kCostPerUnit = 100;
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          strings.size(), kCostPerUnit, fingerprint);
+    data_ = fingerprints_.data();
+  }
+
+  const int64* data() const { return data_; }
+
+ private:
+  std::vector<int64> fingerprints_;
+  const int64* data_;
+};
+
+// InternalType is StringPiece when using StringCrosser. int64 values are
+// formatted as strings.
+template <>
+class FeatureValues<StringPiece> {
+ public:
+  FeatureValues(OpKernelContext* context, const Tensor& values) {
+    const int64 size = values.NumElements();
+    pieces_.reserve(size);
+    if (DT_STRING == values.dtype()) {
+      const auto strings = values.flat<string>();
+      for (int64 i = 0; i < size; ++i) pieces_.emplace_back(strings(i));
+      return;
+    }
+    const auto ints = values.flat<int64>();
+    strings_.reserve(size);
+    for (int64 i = 0; i < size; ++i) {
+      strings_.push_back(std::to_string(ints(i)));
+      pieces_.emplace_back(strings_.back());
+    }
+  }
+
+  const StringPiece* data() const { return pieces_.data(); }
+
+ private:
+  std::vector<string> strings_;
+  std::vector<StringPiece> pieces_;
+};
+
 // An interface that represents a column with batches.
 template <typename InternalType>
 class ColumnInterface {
@@ -51,9 +117,10 @@ class ColumnInterface {
 template <typename InternalType>
 class SparseTensorColumn : public ColumnInterface<InternalType> {
  public:
-  SparseTensorColumn(const Tensor& values, std::vector<int64> feature_counts,
+  SparseTensorColumn(OpKernelContext* context, const Tensor& values,
+                     std::vector<int64> feature_counts,
                      std::vector<int64> feature_start_indices)
-      : values_(values),
+      : values_(context, values),
         feature_counts_(std::move(feature_counts)),
         feature_start_indices_(std::move(feature_start_indices)) {
     CHECK_EQ(feature_counts_.size(), feature_start_indices_.size());
@@ -63,78 +130,38 @@ class SparseTensorColumn : public ColumnInterface<InternalType> {
     return feature_counts_[batch];
   }
 
-  InternalType Feature(int64 batch, int64 n) const override;
+  InternalType Feature(int64 batch, int64 n) const override {
+    return values_.data()[feature_start_indices_[batch] + n];
+  }
 
   ~SparseTensorColumn() override {}
 
  private:
-  const Tensor& values_;
+  const FeatureValues<InternalType> values_;
   std::vector<int64> feature_counts_;
   std::vector<int64> feature_start_indices_;
 };
 
-// InternalType is int64 only when using HashCrosser.
-template <>
-int64 SparseTensorColumn<int64>::Feature(int64 batch, int64 n) const {
-  const int64 start = feature_start_indices_[batch];
-  if (DT_STRING == values_.dtype())
-    return Fingerprint64(values_.vec<string>().data()[start + n]);
-  return values_.vec<int64>().data()[start + n];
-}
-
-// InternalType is string or StringPiece when using StringCrosser.
-template <>
-string SparseTensorColumn<string>::Feature(int64 batch, int64 n) const {
-  const int64 start = feature_start_indices_[batch];
-  if (DT_STRING == values_.dtype())
-    return values_.vec<string>().data()[start + n];
-  return std::to_string(values_.vec<int64>().data()[start + n]);
-}
-
-template <>
-StringPiece SparseTensorColumn<StringPiece>::Feature(int64 batch,
-                                                     int64 n) const {
-  const int64 start = feature_start_indices_[batch];
-  return values_.vec<string>().data()[start + n];
-}
-
 // A column that is backed by a dense tensor.
 template <typename InternalType>
 class DenseTensorColumn : public ColumnInterface<InternalType> {
  public:
-  explicit DenseTensorColumn(const Tensor& tensor) : tensor_(tensor) {}
+  DenseTensorColumn(OpKernelContext* context, const Tensor& tensor)
+      : values_(context, tensor), feature_count_(tensor.dim_size(1)) {}
 
-  int64 FeatureCount(int64 batch) const override { return tensor_.dim_size(1); }
+  int64 FeatureCount(int64 batch) const override { return feature_count_; }
 
-  InternalType Feature(int64 batch, int64 n) const override;
+  InternalType Feature(int64 batch, int64 n) const override {
+    return values_.data()[batch * feature_count_ + n];
+  }
 
   ~DenseTensorColumn() override {}
 
  private:
-  const Tensor& tensor_;
+  const FeatureValues<InternalType> values_;
+  const int64 feature_count_;
 };
 
-// InternalType is int64 only when using HashCrosser.
-template <>
-int64 DenseTensorColumn<int64>::Feature(int64 batch, int64 n) const {
-  if (DT_STRING == tensor_.dtype())
-    return Fingerprint64(tensor_.matrix<string>()(batch, n));
-  return tensor_.matrix<int64>()(batch, n);
-}
-
-// Internal type is string or StringPiece when using StringCrosser.
-template <>
-string DenseTensorColumn<string>::Feature(int64 batch, int64 n) const {
-  if (DT_STRING == tensor_.dtype()) return tensor_.matrix<string>()(batch, n);
-  return std::to_string(tensor_.matrix<int64>()(batch, n));
-}
-
-template <>
-StringPiece DenseTensorColumn<StringPiece>::Feature(int64 batch,
-                                                    int64 n) const {
-  return tensor_.matrix<string>()(batch, n);
-}
-
 // Updates Output tensors with sparse crosses.
 template <typename OutType>
 class OutputUpdater {
@@ -172,21 +199,26 @@ class StringCrosser {
                 const int64 num_buckets_unused, const uint64 hash_key_unused)
       : columns_(columns) {}
 
-  string Generate(const int64 batch_index,
-                  const std::vector<int>& permutation) const {
+  // Builds the cross in a buffer that is reused across calls, so the
+  // returned reference is only valid until the next call.
+  const string& Generate(const int64 batch_index,
+                         const gtl::InlinedVector<int, 8>& permutation,
+                         const int first_changed_unused) {
     static const auto k_feature_separator = "_X_";
 
-    gtl::InlinedVector<InternalType, 6> cross_vec(columns_.size());
+    cross_.clear();
     for (int i = 0; i < permutation.size(); i++) {
-      cross_vec[i] = columns_[i]->Feature(batch_index, permutation[i]);
+      if (i > 0) cross_.append(k_feature_separator);
+      const StringPiece feature =
+          columns_[i]->Feature(batch_index, permutation[i]);
+      cross_.append(feature.data(), feature.size());
     }
-    // TODO(zakaria): this will copy the string twice, might effect
-    // performance.
-    return str_util::Join(cross_vec, k_feature_separator);
+    return cross_;
   }
 
  private:
   const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
+  string cross_;
 };
 
 // Generates the sparse crosses as nested hash to avoid string manipulations.
@@ -195,16 +227,24 @@ class HashCrosser {
   HashCrosser(
       const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns,
       const int64 num_buckets, const uint64 hash_key)
-      : columns_(columns), num_buckets_(num_buckets), hash_key_(hash_key) {}
+      : columns_(columns),
+        num_buckets_(num_buckets),
+        hash_key_(hash_key),
+        prefix_hashes_(columns.size()) {}
 
+  // Only the hashes of the columns from `first_changed` on are recomputed,
+  // the prefix before it is reused from the previous call.
   int64 Generate(const int64 batch_index,
-                 const std::vector<int>& permutation) const {
+                 const gtl::InlinedVector<int, 8>& permutation,
+                 const int first_changed) {
     // Do the fingerprint concatenation on uint64.
-    uint64 hashed_output = hash_key_;
-    for (size_t i = 0; i < permutation.size(); ++i) {
-      uint64 hash_i = columns_[i]->Feature(batch_index, permutation[i]);
-      hashed_output = FingerprintCat64(hashed_output, hash_i);
+    for (size_t i = first_changed; i < permutation.size(); ++i) {
+      const uint64 previous = i == 0 ? hash_key_ : prefix_hashes_[i - 1];
+      const uint64 hash_i = columns_[i]->Feature(batch_index, permutation[i]);
+      prefix_hashes_[i] = FingerprintCat64(previous, hash_i);
     }
+    const uint64 hashed_output =
+        permutation.empty() ? hash_key_ : prefix_hashes_.back();
     // The return value is int64 based on the number of buckets.
     if (num_buckets_ > 0) {
       return hashed_output % num_buckets_;
@@ -218,55 +258,61 @@ class HashCrosser {
   const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns_;
   const int64 num_buckets_;
   const uint64 hash_key_;
+  gtl::InlinedVector<uint64, 8> prefix_hashes_;
 };
 
-// ProductIterator generates cartesian products based on indices.
+// ProductIterator generates cartesian products based on indices. It is
+// reset for each batch index, so one iterator serves a whole shard.
 template <typename InternalType>
 class ProductIterator {
  public:
   explicit ProductIterator(
       const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>&
-          columns,
-      int64 batch_index)
-      : columns_(columns), batch_index_(batch_index) {
-    next_permutation_.resize(columns_.size(), 0);
+          columns)
+      : columns_(columns),
+        feature_counts_(columns.size()),
+        permutation_(columns.size()) {}
+
+  void Reset(int64 batch_index) {
     // Sets has_next_ to false if any feature column has 0 features.
     has_next_ = true;
+    first_changed_ = 0;
     for (int i = 0; i < columns_.size(); i++) {
-      if (columns_[i]->FeatureCount(batch_index_) == 0) {
-        has_next_ = false;
-        break;
-      }
+      permutation_[i] = 0;
+      feature_counts_[i] = columns_[i]->FeatureCount(batch_index);
+      if (feature_counts_[i] == 0) has_next_ = false;
     }
   }
 
-  std::vector<int> Next() {
-    std::vector<int> permutation(next_permutation_);
+  // Returns the current permutation.
+  const gtl::InlinedVector<int, 8>& permutation() const {
+    return permutation_;
+  }
 
-    // Generates next permutation, if available.
-    bool carry = true;
-    for (int i = next_permutation_.size() - 1; i >= 0; i--) {
-      if (carry) {
-        next_permutation_[i] = next_permutation_[i] + 1;
-      }
-      if (next_permutation_[i] == columns_[i]->FeatureCount(batch_index_)) {
-        next_permutation_[i] = 0;
-      } else {
-        carry = false;
-        break;
+  // Returns the first column whose index differs from the previous
+  // permutation.
+  int first_changed() const { return first_changed_; }
+
+  // Generates next permutation, if available.
+  void Advance() {
+    for (int i = permutation_.size() - 1; i >= 0; i--) {
+      if (++permutation_[i] < feature_counts_[i]) {
+        first_changed_ = i;
+        return;
       }
+      permutation_[i] = 0;
     }
-    has_next_ = !carry;
-    return permutation;
+    has_next_ = false;
   }
 
-  bool HasNext() { return has_next_; }
+  bool HasNext() const { return has_next_; }
 
  private:
   bool has_next_;
+  int first_changed_;
   const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
-  const int64 batch_index_;
-  std::vector<int> next_permutation_;
+  gtl::InlinedVector<int64, 8> feature_counts_;
+  gtl::InlinedVector<int, 8> permutation_;
 };
 
 template <bool HASHED_OUTPUT, typename InternalType>
@@ -310,13 +356,12 @@ class SparseCrossOp : public OpKernel {
 
     ValidateInput(context, indices_list_in, values_list_in, shapes_list_in,
                   dense_list_in);
+    if (!context->status().ok()) return;
 
     std::vector<std::unique_ptr<ColumnInterface<InternalType>>> columns =
-        GenerateColumnsFromInput(indices_list_in, values_list_in,
+        GenerateColumnsFromInput(context, indices_list_in, values_list_in,
                                  shapes_list_in, dense_list_in);
 
-    typename CrossTraits<HASHED_OUTPUT, InternalType>::Crosser crosser(
-        columns, num_buckets_, hash_key_);
     Tensor* indices_out;
     Tensor* values_out;
     Tensor* shape_out;
@@ -324,26 +369,42 @@ class SparseCrossOp : public OpKernel {
     std::vector<int64> output_start_indices(batch_size);
     CreateOutputTensors(columns, batch_size, context, &indices_out, &values_out,
                         &shape_out, &output_start_indices);
+    if (!context->status().ok() || batch_size == 0) return;
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Updater updater(
         output_start_indices, indices_out, values_out);
-    auto do_work = [&columns, crosser, updater](int64 begin, int64 end) {
-      for (int b = begin; b < end; b++) {
-        ProductIterator<InternalType> product_iterator(columns, b);
+    const int64 num_buckets = num_buckets_;
+    const uint64 hash_key = hash_key_;
+    auto do_work = [&columns, &updater, num_buckets, hash_key](int64 begin,
+                                                               int64 end) {
+      // The crosser and the iterator keep per-shard state, which is reused
+      // for every batch index of the shard.
+      typename CrossTraits<HASHED_OUTPUT, InternalType>::Crosser crosser(
+          columns, num_buckets, hash_key);
+      ProductIterator<InternalType> product_iterator(columns);
+      for (int64 b = begin; b < end; b++) {
+        product_iterator.Reset(b);
         int64 cross_count = 0;
         while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count, crosser.Generate(b, permutation));
+          updater.Update(b, cross_count,
+                         crosser.Generate(b, product_iterator.permutation(),
+                                          product_iterator.first_changed()));
+          product_iterator.Advance();
           cross_count++;
         }
       }
     };
 
+    // Each cross costs about one fingerprint concatenation when hashing,
+    // since only the changed suffix of the permutation is rehashed, and a
+    // copy of every feature when concatenating strings.
+    const int64 crosses_per_batch =
+        std::max<int64>(1, indices_out->dim_size(0) / batch_size);
+    const int64 cost_per_cross =
+        HASHED_OUTPUT ? 50 : 100 * std::max<size_t>(1, columns.size());
     auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
-    // TODO(zakaria): optimize kCostPerUnit
-    const int kCostPerUnit = 5000 * indices_list_in.size();
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
-          kCostPerUnit, do_work);
+          crosses_per_batch * cost_per_cross, do_work);
   }
 
  private:
@@ -443,7 +504,8 @@ class SparseCrossOp : public OpKernel {
 
   // Generate the columns given the sparse and dense inputs.
   std::vector<std::unique_ptr<ColumnInterface<InternalType>>>
-  GenerateColumnsFromInput(const OpInputList& indices_list_in,
+  GenerateColumnsFromInput(OpKernelContext* context,
+                           const OpInputList& indices_list_in,
                            const OpInputList& values_list_in,
                            const OpInputList& shapes_list_in,
                            const OpInputList& dense_list_in) {
@@ -462,12 +524,12 @@ class SparseCrossOp : public OpKernel {
     columns.reserve(values_list_in.size());
     for (int i = 0; i < values_list_in.size(); ++i) {
       columns.emplace_back(new SparseTensorColumn<InternalType>(
-          values_list_in[i], std::move(feature_counts[i]),
+          context, values_list_in[i], std::move(feature_counts[i]),
           std::move(feature_start_indices[i])));
     }
     for (int i = 0; i < dense_list_in.size(); ++i) {
       columns.emplace_back(
-          new DenseTensorColumn<InternalType>(dense_list_in[i]));
+          new DenseTensorColumn<InternalType>(context, dense_list_in[i]));
     }
 
     return columns;
@@ -563,7 +625,7 @@ REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<string>("out_type")
                             .TypeConstraint<int64>("internal_type"),
-                        SparseCrossOp<false, string>);
+                        SparseCrossOp<false, StringPiece>);
 
 REGISTER_KERNEL_BUILDER(Name("SparseCross")
                             .Device(DEVICE_CPU)
@@ -0,0 +1,161 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class SparseCrossOpTest : public OpsTestBase {
+ protected:
+  // Crosses a sparse string column with a dense int64 column.
+  void MakeOp(bool hashed_output) {
+    TF_ASSERT_OK(NodeDefBuilder("sparse_cross", "SparseCross")
+                     .Input(FakeInput(1, DT_INT64))
+                     .Input(FakeInput(1, DT_STRING))
+                     .Input(FakeInput(1, DT_INT64))
+                     .Input(FakeInput(1, DT_INT64))
+                     .Attr("hashed_output", hashed_output)
+                     .Attr("num_buckets", 0)
+                     .Attr("hash_key", 7)
+                     .Attr("out_type", hashed_output ? DT_INT64 : DT_STRING)
+                     .Attr("internal_type", DT_STRING)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Batch 0 has the sparse features {a, b}, batch 1 has none and batch 2
+  // has {c}. Every batch has the dense features {batch, 10 + batch}.
+  void AddInputs() {
+    AddInputFromArray<int64>(TensorShape({3, 2}), {0, 0, 0, 1, 2, 0});
+    AddInputFromArray<string>(TensorShape({3}), {"a", "b", "c"});
+    AddInputFromArray<int64>(TensorShape({2}), {3, 2});
+    AddInputFromArray<int64>(TensorShape({3, 2}), {0, 10, 1, 11, 2, 12});
+  }
+
+  static int64 Hash(const string& sparse, int64 dense) {
+    const uint64 hash = FingerprintCat64(
+        FingerprintCat64(7, Fingerprint64(sparse)), static_cast<uint64>(dense));
+    return hash % std::numeric_limits<int64>::max();
+  }
+};
+
+TEST_F(SparseCrossOpTest, StringOutput) {
+  MakeOp(false);
+  AddInputs();
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected_indices(allocator(), DT_INT64, TensorShape({6, 2}));
+  test::FillValues<int64>(&expected_indices,
+                          {0, 0, 0, 1, 0, 2, 0, 3, 2, 0, 2, 1});
+  test::ExpectTensorEqual<int64>(expected_indices, *GetOutput(0));
+  Tensor expected_values(allocator(), DT_STRING, TensorShape({6}));
+  test::FillValues<string>(&expected_values,
+                           {"a_X_0", "a_X_10", "b_X_0", "b_X_10", "c_X_2",
+                            "c_X_12"});
+  test::ExpectTensorEqual<string>(expected_values, *GetOutput(1));
+  Tensor expected_shape(allocator(), DT_INT64, TensorShape({2}));
+  test::FillValues<int64>(&expected_shape, {3, 4});
+  test::ExpectTensorEqual<int64>(expected_shape, *GetOutput(2));
+}
+
+TEST_F(SparseCrossOpTest, HashedOutput) {
+  MakeOp(true);
+  AddInputs();
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected_values(allocator(), DT_INT64, TensorShape({6}));
+  test::FillValues<int64>(&expected_values,
+                          {Hash("a", 0), Hash("a", 10), Hash("b", 0),
+                           Hash("b", 10), Hash("c", 2), Hash("c", 12)});
+  test::ExpectTensorEqual<int64>(expected_values, *GetOutput(1));
+}
+
+// Crosses `num_columns` sparse string columns with `features_per_column`
+// features in every batch, from a vocabulary of 1000 strings.
+static Graph* SparseCross(int batch_size, int num_columns,
+                          int features_per_column, bool hashed_output) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int64 num_values = static_cast<int64>(batch_size) * features_per_column;
+  std::vector<NodeBuilder::NodeOut> indices;
+  std::vector<NodeBuilder::NodeOut> values;
+  std::vector<NodeBuilder::NodeOut> shapes;
+  for (int c = 0; c < num_columns; ++c) {
+    Tensor column_indices(DT_INT64, TensorShape({num_values, 2}));
+    Tensor column_values(DT_STRING, TensorShape({num_values}));
+    auto indices_matrix = column_indices.matrix<int64>();
+    auto values_vec = column_values.vec<string>();
+    for (int64 i = 0; i < num_values; ++i) {
+      indices_matrix(i, 0) = i / features_per_column;
+      indices_matrix(i, 1) = i % features_per_column;
+      values_vec(i) = strings::StrCat("feature_", c, "_", (i * 7919) % 1000);
+    }
+    Tensor column_shape(DT_INT64, TensorShape({2}));
+    column_shape.vec<int64>().setValues({batch_size, features_per_column});
+    indices.emplace_back(test::graph::Constant(g, column_indices));
+    values.emplace_back(test::graph::Constant(g, column_values));
+    shapes.emplace_back(test::graph::Constant(g, column_shape));
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseCross")
+                  .Input(indices)
+                  .Input(values)
+                  .Input(shapes)
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Attr("hashed_output", hashed_output)
+                  .Attr("num_buckets", hashed_output ? 1000000 : 0)
+                  .Attr("hash_key", int64{956888297470})
+                  .Attr("out_type", hashed_output ? DT_INT64 : DT_STRING)
+                  .Attr("internal_type", DT_STRING)
+                  .Attr("dense_types", DataTypeVector())
+                  .Finalize(g, &node));
+  return g;
+}
+
+#define BM_SparseCrossDev(B, C, F, H, DEVICE)                              \
+  static void BM_SparseCross_##DEVICE##_##B##_##C##_##F##_##H(int iters) { \
+    int64 crosses = B;                                                     \
+    for (int c = 0; c < C; ++c) crosses *= F;                              \
+    testing::ItemsProcessed(static_cast<int64>(iters) * crosses);          \
+    test::Benchmark(#DEVICE, SparseCross(B, C, F, H)).Run(iters);          \
+  }                                                                        \
+  BENCHMARK(BM_SparseCross_##DEVICE##_##B##_##C##_##F##_##H);
+
+BM_SparseCrossDev(256, 2, 10, true, cpu);
+BM_SparseCrossDev(256, 3, 10, true, cpu);
+BM_SparseCrossDev(1024, 2, 10, true, cpu);
+BM_SparseCrossDev(1024, 3, 5, true, cpu);
+BM_SparseCrossDev(256, 2, 10, false, cpu);
+BM_SparseCrossDev(256, 3, 10, false, cpu);
+BM_SparseCrossDev(1024, 2, 10, false, cpu);
+BM_SparseCrossDev(1024, 3, 5, false, cpu);
+
+}  // namespace
+}  // namespace tensorflow
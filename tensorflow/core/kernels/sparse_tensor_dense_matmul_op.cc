@@ -19,16 +19,51 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+// The nonzeros of the sparse matrix A, or of its adjoint, grouped by row of
+// the output in the compressed sparse row (CSR) format, so that the rows of
+// the product can be computed independently.
+template <typename Tindices>
+struct SparseRows {
+  int64 num_rows = 0;
+  int64 num_columns = 0;
+  // The nonzeros of the row m are at [row_starts[m], row_starts[m + 1]), in
+  // their order in a_indices.
+  std::vector<int64> row_starts;
+  // The column k of each nonzero, i.e. the row of B which it multiplies.
+  std::vector<Tindices> columns;
+  // The position of each nonzero in a_values.
+  std::vector<int64> value_indices;
+};
+
+// Groups the nonzeros `a_indices` of A (or of its adjoint if `adj_a`) into
+// the `num_rows` rows of the output. Returns InvalidArgument if an index is
+// out of bounds.
+template <typename Tindices>
+Status MakeSparseRows(typename TTypes<Tindices>::ConstMatrix a_indices,
+                      bool adj_a, int64 num_rows, int64 num_columns,
+                      SparseRows<Tindices>* rows);
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Tindices>
 class SparseTensorDenseMatMulOp : public OpKernel {
  public:
@@ -132,6 +167,33 @@ class SparseTensorDenseMatMulOp : public OpKernel {
       return;
     }
 
+    typedef functor::SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices,
+                                                    false, false>
+        CPUFunctor;
+    if (std::is_same<Device, CPUDevice>::value &&
+        CPUFunctor::UseSparseRows(ctx->eigen_device<CPUDevice>(), nnz,
+                                  outer_right)) {
+      std::shared_ptr<const functor::SparseRows<Tindices>> rows;
+      OP_REQUIRES_OK(ctx, GetSparseRows(*a_indices, outer_left, inner_left,
+                                        &rows));
+#define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                        \
+  if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                        \
+    functor::SparseTensorDenseMatMulFunctor<                               \
+        CPUDevice, T, Tindices, ADJ_A,                                     \
+        ADJ_B>::Multiply(ctx->eigen_device<CPUDevice>(), *rows,            \
+                         a_values->vec<T>(), b->matrix<T>(),               \
+                         out->matrix<T>());                                \
+  }
+
+      MAYBE_ADJOINT(false, false);
+      MAYBE_ADJOINT(false, true);
+      MAYBE_ADJOINT(true, false);
+      MAYBE_ADJOINT(true, true);
+
+#undef MAYBE_ADJOINT
+      return;
+    }
+
 #define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                        \
   if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                        \
     Status functor_status = functor::SparseTensorDenseMatMulFunctor<       \
@@ -151,8 +213,48 @@ class SparseTensorDenseMatMulOp : public OpKernel {
   }
 
  private:
+  // Returns the rows of A, or of its adjoint, whose indices are
+  // `a_indices`. They are cached across steps, since A is often constant,
+  // e.g. the feature ids of a constant batch: the cached rows are reused if
+  // `a_indices` is the same buffer as in the previous step, which the cache
+  // keeps alive, with the same contents.
+  Status GetSparseRows(
+      const Tensor& a_indices, int64 num_rows, int64 num_columns,
+      std::shared_ptr<const functor::SparseRows<Tindices>>* rows) {
+    const StringPiece data = a_indices.tensor_data();
+    const uint64 fingerprint = Hash64(data.data(), data.size());
+    {
+      mutex_lock l(mu_);
+      if (cached_rows_ != nullptr &&
+          cached_indices_.SharesBufferWith(a_indices) &&
+          cached_indices_.shape() == a_indices.shape() &&
+          cached_fingerprint_ == fingerprint &&
+          cached_rows_->num_rows == num_rows &&
+          cached_rows_->num_columns == num_columns) {
+        *rows = cached_rows_;
+        return Status::OK();
+      }
+    }
+    auto new_rows = std::make_shared<functor::SparseRows<Tindices>>();
+    TF_RETURN_IF_ERROR(functor::MakeSparseRows<Tindices>(
+        a_indices.matrix<Tindices>(), adjoint_a_, num_rows, num_columns,
+        new_rows.get()));
+    mutex_lock l(mu_);
+    cached_indices_ = a_indices;
+    cached_fingerprint_ = fingerprint;
+    cached_rows_ = new_rows;
+    *rows = std::move(new_rows);
+    return Status::OK();
+  }
+
   bool adjoint_a_;
   bool adjoint_b_;
+
+  mutex mu_;
+  Tensor cached_indices_ GUARDED_BY(mu_);
+  uint64 cached_fingerprint_ GUARDED_BY(mu_) = 0;
+  std::shared_ptr<const functor::SparseRows<Tindices>> cached_rows_
+      GUARDED_BY(mu_);
 };
 
 #define REGISTER_CPU(TypeT, TypeIndex)           \
@@ -239,11 +341,67 @@ Status MOutOfBoundsError(int64 m, std::size_t i, int lhs_index_a,
 }
 }  // namespace
 
+template <typename Tindices>
+Status MakeSparseRows(typename TTypes<Tindices>::ConstMatrix a_indices,
+                      bool adj_a, int64 num_rows, int64 num_columns,
+                      SparseRows<Tindices>* rows) {
+  const int64 nnz = a_indices.dimension(0);
+  const int lhs_index_a = adj_a ? 1 : 0;
+  const int rhs_index_a = adj_a ? 0 : 1;
+  rows->num_rows = num_rows;
+  rows->num_columns = num_columns;
+  // Counting sort of the nonzeros by row, which keeps their order within a
+  // row, and so the order of the sums of the output values.
+  rows->row_starts.assign(num_rows + 1, 0);
+  for (int64 i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, num_columns)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, num_columns);
+    }
+    if (!FastBoundsCheck(m, num_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+    }
+    ++rows->row_starts[m + 1];
+  }
+  for (int64 m = 0; m < num_rows; ++m) {
+    rows->row_starts[m + 1] += rows->row_starts[m];
+  }
+  std::vector<int64> next(rows->row_starts.begin(),
+                          rows->row_starts.end() - 1);
+  rows->columns.resize(nnz);
+  rows->value_indices.resize(nnz);
+  for (int64 i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    // The indices may have changed since they were checked.
+    if (!FastBoundsCheck(k, num_columns) || !FastBoundsCheck(m, num_rows) ||
+        next[m] == rows->row_starts[m + 1]) {
+      return errors::InvalidArgument("a_indices changed while being read");
+    }
+    rows->columns[next[m]] = k;
+    rows->value_indices[next[m]] = i;
+    ++next[m];
+  }
+  return Status::OK();
+}
+
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
 struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   // Vectorize certain operations above this size.
   static const std::size_t kNumVectorize = 32;
 
+  // Below this number of multiply-adds, the product isn't worth sharding.
+  static const int64 kMinParallelWork = 1 << 15;
+
+  // Whether to compute the product from the rows of A. Otherwise the
+  // nonzeros are accumulated one by one into the output, which is faster on
+  // a single thread when the output has few columns.
+  static bool UseSparseRows(const CPUDevice& d, int64 nnz, int64 rhs_right) {
+    return rhs_right >= kNumVectorize ||
+           (d.numThreads() > 1 && nnz * rhs_right >= kMinParallelWork);
+  }
+
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
                         typename TTypes<T>::ConstVec a_values,
@@ -251,67 +409,100 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     const std::size_t nnz = a_values.size();
     const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
     const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+    if (UseSparseRows(d, nnz, rhs_right)) {
+      SparseRows<Tindices> rows;
+      TF_RETURN_IF_ERROR(MakeSparseRows<Tindices>(
+          a_indices, ADJ_A, out.dimension(0), lhs_right, &rows));
+      Multiply(d, rows, a_values, b, out);
+      return Status::OK();
+    }
+
     const int lhs_index_a = ADJ_A ? 1 : 0;
     const int rhs_index_a = ADJ_A ? 0 : 1;
-
     out.setZero();
-
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
-
-    if (rhs_right < kNumVectorize) {
-      // Disable vectorization if the RHS of output is too small
-      auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
-
-      for (std::size_t i = 0; i < nnz; ++i) {
-        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-        if (!FastBoundsCheck(k, lhs_right)) {
-          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-        }
-        if (!FastBoundsCheck(m, out.dimension(0))) {
-          return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-        }
-        const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-        for (std::size_t n = 0; n < rhs_right; ++n) {
-          const T b_value = maybe_adjoint_b(k, n);
-          out(m, n) += a_value * b_value;
-        }
+    auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+      if (!FastBoundsCheck(k, lhs_right)) {
+        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
       }
-    } else {
-      // Vectorization via Eigen.
-      const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k) * a_value;                  \
-  }
-
-      if (ADJ_B) {
-        // Perform transpose and conjugation on B once, since we chip out B's
-        // columns in the nnz loop.
-        Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
-        Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-            b.swap_layout().shuffle(shuffle).conjugate();
-        LOOP_NNZ(col_major_conj_b);
-      } else {
-        LOOP_NNZ(b);
+      if (!FastBoundsCheck(m, out.dimension(0))) {
+        return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
+      }
+      const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+      for (std::size_t n = 0; n < rhs_right; ++n) {
+        const T b_value = maybe_adjoint_b(k, n);
+        out(m, n) += a_value * b_value;
       }
-#undef LOOP_NNZ
     }
     return Status::OK();
   }
+
+  // Computes `out` from the rows of A, sharding its rows over the threads of
+  // `d`.
+  static void Multiply(const CPUDevice& d, const SparseRows<Tindices>& rows,
+                       typename TTypes<T>::ConstVec a_values,
+                       typename TTypes<T>::ConstMatrix b,
+                       typename TTypes<T>::Matrix out) {
+    const int64 num_rows = out.dimension(0);
+    const int64 rhs_right = out.dimension(1);
+    const int64 lhs_right = ADJ_B ? b.dimension(1) : b.dimension(0);
+
+    // The rows of B, or of its adjoint, which are the rows multiplied by the
+    // nonzeros of A. The adjoint of B is computed once, so that its rows are
+    // contiguous.
+    const T* b_rows = b.data();
+    Eigen::Tensor<T, 2, Eigen::RowMajor> b_adjoint;
+    if (ADJ_B) {
+      b_adjoint.resize(lhs_right, rhs_right);
+      Eigen::array<int, 2> shuffle{{1, 0}};
+      b_adjoint.device(d) = b.shuffle(shuffle).conjugate();
+      b_rows = b_adjoint.data();
+    }
+
+    typedef Eigen::Map<Eigen::Matrix<T, 1, Eigen::Dynamic>> RowMap;
+    typedef Eigen::Map<const Eigen::Matrix<T, 1, Eigen::Dynamic>> ConstRowMap;
+    auto work = [&rows, &a_values, b_rows, rhs_right, &out](int64 begin,
+                                                            int64 end) {
+      for (int64 m = begin; m < end; ++m) {
+        T* out_row = &out(m, 0);
+        const int64 row_end = rows.row_starts[m + 1];
+        if (rhs_right < kNumVectorize) {
+          // Disable vectorization if the RHS of output is too small
+          std::fill(out_row, out_row + rhs_right, T(0));
+          for (int64 j = rows.row_starts[m]; j < row_end; ++j) {
+            const T a_value = ADJ_A ? MaybeConj(a_values(rows.value_indices[j]))
+                                    : a_values(rows.value_indices[j]);
+            const T* b_row = b_rows + rows.columns[j] * rhs_right;
+            for (int64 n = 0; n < rhs_right; ++n) {
+              out_row[n] += a_value * b_row[n];
+            }
+          }
+        } else {
+          RowMap out_map(out_row, rhs_right);
+          out_map.setZero();
+          for (int64 j = rows.row_starts[m]; j < row_end; ++j) {
+            const T a_value = ADJ_A ? MaybeConj(a_values(rows.value_indices[j]))
+                                    : a_values(rows.value_indices[j]);
+            out_map.noalias() +=
+                a_value *
+                ConstRowMap(b_rows + rows.columns[j] * rhs_right, rhs_right);
+          }
+        }
+      }
+    };
+    const double nnz_per_row =
+        static_cast<double>(rows.columns.size()) / std::max<int64>(num_rows, 1);
+    d.parallelFor(num_rows,
+                  Eigen::TensorOpCost(
+                      nnz_per_row * (rhs_right * sizeof(T) + sizeof(Tindices)),
+                      rhs_right * sizeof(T),
+                      nnz_per_row * rhs_right *
+                          (Eigen::TensorOpCost::AddCost<T>() +
+                           Eigen::TensorOpCost::MulCost<T>())),
+                  work);
+  }
 };
 
 }  // namespace functor
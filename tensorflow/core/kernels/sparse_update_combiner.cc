@@ -0,0 +1,40 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/sparse_update_combiner.h"
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+SparseUpdateCoalescing GetSparseUpdateCoalescing() {
+  static const SparseUpdateCoalescing coalescing = [] {
+    int64 level = 0;
+    Status s = ReadInt64FromEnvVar("TF_SPARSE_UPDATE_COALESCING", 0, &level);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      level = 0;
+    } else if (level < 0 ||
+               level > static_cast<int64>(SparseUpdateCoalescing::kRelaxed)) {
+      LOG(ERROR) << "Ignoring invalid TF_SPARSE_UPDATE_COALESCING: " << level;
+      level = 0;
+    }
+    return static_cast<SparseUpdateCoalescing>(level);
+  }();
+  return coalescing;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,239 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_COMBINER_H_
+#define TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_COMBINER_H_
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Levels of the TF_SPARSE_UPDATE_COALESCING environment variable, which
+// selects the sparse update kernels that go through a SparseUpdateCombiner.
+enum class SparseUpdateCoalescing {
+  // Every update is applied on its own (the default).
+  kNone = 0,
+  // Updates are merged when that only reorders additions, e.g. for
+  // ResourceScatterAdd.
+  kExact = 1,
+  // Updates are also merged when that changes the result, e.g. for
+  // ResourceSparseApplyAdagrad, where the gradients of duplicate indices are
+  // summed before they are accumulated.
+  kRelaxed = 2,
+};
+
+// Returns the level read from TF_SPARSE_UPDATE_COALESCING.
+SparseUpdateCoalescing GetSparseUpdateCoalescing();
+
+// Combines the sparse updates that concurrent kernels make to the same
+// variable, which would otherwise serialize on the variable's mutex.
+//
+// A kernel submits its update with Apply().  If no other thread is applying
+// updates, the caller becomes the combiner: it takes every pending update,
+// merges the compatible ones (same scalar parameters and same row shape)
+// into a single update without duplicate indices, and applies each merged
+// update with one call of its ApplyFn.  Otherwise the caller waits until a
+// combiner has applied its update.  Updates thus batch up for exactly as
+// long as the previous batch takes to apply, and no timer is involved.
+//
+// An update that is applied on its own is passed through unchanged.  All the
+// updates merged into one call share the status that the call returns.
+template <typename T, typename Index>
+class SparseUpdateCombiner : public ResourceBase {
+ public:
+  // Applies `updates` at `indices` to the variable, with the same shapes as
+  // in Apply(). It is called without any lock held and must lock the
+  // variable itself.
+  typedef std::function<Status(const std::vector<T>& params,
+                               const Tensor& indices, const Tensor& updates)>
+      ApplyFn;
+
+  SparseUpdateCombiner() {}
+
+  // Applies the update and returns its status once it has been applied,
+  // either by `apply_fn` or by the ApplyFn of another caller.
+  // `indices` must be a vector of size N, `updates` must have shape
+  // [N] + row shape, and both must stay alive until Apply() returns.
+  Status Apply(std::vector<T> params, const Tensor& indices,
+               const Tensor& updates, const ApplyFn& apply_fn) {
+    Update update(std::move(params), &indices, &updates);
+    std::vector<Update*> batch;
+    {
+      mutex_lock l(mu_);
+      pending_.push_back(&update);
+      while (!update.done && combining_) {
+        cv_.wait(l);
+      }
+      if (update.done) {
+        return update.status;
+      }
+      combining_ = true;
+      batch.swap(pending_);
+    }
+    ApplyBatch(batch, apply_fn);
+    Status status = update.status;
+    {
+      mutex_lock l(mu_);
+      combining_ = false;
+      // The waiting callers may return, and destroy their Update, as soon
+      // as `done` is set.
+      for (Update* u : batch) {
+        u->done = true;
+      }
+    }
+    cv_.notify_all();
+    return status;
+  }
+
+  string DebugString() override { return "SparseUpdateCombiner"; }
+
+  // Returns the number of updates that wait for a combiner. For testing.
+  int64 num_pending() {
+    mutex_lock l(mu_);
+    return pending_.size();
+  }
+
+ private:
+  struct Update {
+    Update(std::vector<T> params, const Tensor* indices,
+           const Tensor* updates)
+        : params(std::move(params)),
+          indices(indices),
+          updates(updates),
+          row_shape(updates->shape()) {
+      row_shape.RemoveDim(0);
+    }
+
+    std::vector<T> params;
+    const Tensor* indices;
+    const Tensor* updates;
+    TensorShape row_shape;
+    Status status;
+    bool done = false;
+  };
+
+  void ApplyBatch(const std::vector<Update*>& batch, const ApplyFn& apply_fn) {
+    std::vector<bool> applied(batch.size(), false);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (applied[i]) continue;
+      std::vector<Update*> group = {batch[i]};
+      for (size_t j = i + 1; j < batch.size(); ++j) {
+        if (!applied[j] && batch[j]->params == batch[i]->params &&
+            batch[j]->row_shape == batch[i]->row_shape) {
+          group.push_back(batch[j]);
+          applied[j] = true;
+        }
+      }
+      const Status s =
+          group.size() == 1
+              ? apply_fn(group[0]->params, *group[0]->indices,
+                         *group[0]->updates)
+              : ApplyMerged(group, apply_fn);
+      for (Update* u : group) {
+        u->status = s;
+      }
+    }
+  }
+
+  // Sums the rows of every update in `group` that share an index, and
+  // applies the sums with a single call of `apply_fn`.
+  static Status ApplyMerged(const std::vector<Update*>& group,
+                            const ApplyFn& apply_fn) {
+    const TensorShape& row_shape = group[0]->row_shape;
+    const int64 row_size = row_shape.num_elements();
+    gtl::FlatMap<Index, int64> slots;
+    std::vector<Index> unique_indices;
+    std::vector<std::vector<int64>> update_slots(group.size());
+    for (size_t g = 0; g < group.size(); ++g) {
+      const auto indices = group[g]->indices->template flat<Index>();
+      update_slots[g].reserve(indices.size());
+      for (int64 i = 0; i < indices.size(); ++i) {
+        const Index index = indices(i);
+        auto it = slots.insert(
+            {index, static_cast<int64>(unique_indices.size())});
+        if (it.second) {
+          unique_indices.push_back(index);
+        }
+        update_slots[g].push_back(it.first->second);
+      }
+    }
+
+    const int64 num_unique = unique_indices.size();
+    Tensor merged_indices(DataTypeToEnum<Index>::v(),
+                          TensorShape({num_unique}));
+    std::copy(unique_indices.begin(), unique_indices.end(),
+              merged_indices.vec<Index>().data());
+    TensorShape merged_shape({num_unique});
+    merged_shape.AppendShape(row_shape);
+    Tensor merged_updates(DataTypeToEnum<T>::v(), merged_shape);
+    auto merged_rows = merged_updates.shaped<T, 2>({num_unique, row_size});
+    merged_rows.setZero();
+    for (size_t g = 0; g < group.size(); ++g) {
+      const int64 n = update_slots[g].size();
+      const auto rows =
+          group[g]->updates->template shaped<T, 2>({n, row_size});
+      for (int64 i = 0; i < n; ++i) {
+        merged_rows.template chip<0>(update_slots[g][i]) +=
+            rows.template chip<0>(i);
+      }
+    }
+    return apply_fn(group[0]->params, merged_indices, merged_updates);
+  }
+
+  mutex mu_;
+  condition_variable cv_;
+  std::vector<Update*> pending_ GUARDED_BY(mu_);
+  // True while a caller is applying a batch of updates.
+  bool combining_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SparseUpdateCombiner);
+};
+
+// Looks up, or creates, the combiner that `kernel` shares with the other
+// kernels of the same type that update the variable behind `handle` (and
+// behind `slot_handle`, for optimizers that keep a slot variable).
+template <typename T, typename Index>
+Status LookupOrCreateSparseUpdateCombiner(
+    OpKernelContext* ctx, const string& kernel_type,
+    const ResourceHandle& handle, const ResourceHandle* slot_handle,
+    SparseUpdateCombiner<T, Index>** combiner) {
+  string name = strings::StrCat(kernel_type, "/", handle.name());
+  if (slot_handle != nullptr) {
+    strings::StrAppend(&name, "/", slot_handle->name());
+  }
+  return ctx->resource_manager()
+      ->LookupOrCreate<SparseUpdateCombiner<T, Index>>(
+          handle.container(), name, combiner,
+          [](SparseUpdateCombiner<T, Index>** ret) {
+            *ret = new SparseUpdateCombiner<T, Index>;
+            return Status::OK();
+          });
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SPARSE_UPDATE_COMBINER_H_
@@ -0,0 +1,158 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/sparse_update_combiner.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class SparseUpdateCombinerTest : public ::testing::Test {
+ protected:
+  struct Call {
+    std::vector<float> params;
+    Tensor indices;
+    Tensor updates;
+  };
+
+  SparseUpdateCombinerTest()
+      : combiner_(new SparseUpdateCombiner<float, int64>) {}
+  ~SparseUpdateCombinerTest() override { combiner_->Unref(); }
+
+  // Records the calls. The first call blocks until `release_` is notified
+  // when `block_first_call_` is set.
+  Status Record(const std::vector<float>& params, const Tensor& indices,
+                const Tensor& updates) {
+    bool block = false;
+    {
+      mutex_lock l(mu_);
+      calls_.push_back({params, indices, updates});
+      block = block_first_call_ && calls_.size() == 1;
+    }
+    if (block) {
+      first_call_started_.Notify();
+      release_.WaitForNotification();
+    }
+    return Status::OK();
+  }
+
+  void Apply(std::vector<float> params, const Tensor& indices,
+             const Tensor& updates) {
+    TF_EXPECT_OK(combiner_->Apply(
+        std::move(params), indices, updates,
+        [this](const std::vector<float>& params, const Tensor& indices,
+               const Tensor& updates) {
+          return Record(params, indices, updates);
+        }));
+  }
+
+  // Applies `first` while it blocks the combiner, then applies the updates
+  // of `rest` concurrently, so that they are combined in a single batch.
+  void ApplyBatchAfter(const Call& first, const std::vector<Call>& rest) {
+    block_first_call_ = true;
+    {
+      thread::ThreadPool pool(Env::Default(), "test", 1 + rest.size());
+      pool.Schedule([this, &first] {
+        Apply(first.params, first.indices, first.updates);
+      });
+      first_call_started_.WaitForNotification();
+      for (const Call& call : rest) {
+        pool.Schedule([this, &call] {
+          Apply(call.params, call.indices, call.updates);
+        });
+      }
+      while (combiner_->num_pending() < static_cast<int64>(rest.size())) {
+        Env::Default()->SleepForMicros(1000);
+      }
+      release_.Notify();
+    }
+  }
+
+  SparseUpdateCombiner<float, int64>* combiner_;
+  mutex mu_;
+  std::vector<Call> calls_ GUARDED_BY(mu_);
+  bool block_first_call_ = false;
+  Notification first_call_started_;
+  Notification release_;
+};
+
+TEST_F(SparseUpdateCombinerTest, SingleUpdateIsNotMerged) {
+  Tensor indices = test::AsTensor<int64>({1, 1});
+  Tensor updates = test::AsTensor<float>({1, 2}, {2, 1});
+  Apply({0.5}, indices, updates);
+
+  mutex_lock l(mu_);
+  ASSERT_EQ(1, calls_.size());
+  EXPECT_EQ(std::vector<float>({0.5}), calls_[0].params);
+  test::ExpectTensorEqual<int64>(indices, calls_[0].indices);
+  test::ExpectTensorEqual<float>(updates, calls_[0].updates);
+}
+
+TEST_F(SparseUpdateCombinerTest, MergesConcurrentUpdates) {
+  ApplyBatchAfter({{0.5},
+                   test::AsTensor<int64>({0}),
+                   test::AsTensor<float>({1, 1}, {1, 2})},
+                  {{{0.5},
+                    test::AsTensor<int64>({2, 0}),
+                    test::AsTensor<float>({1, 2, 3, 4}, {2, 2})},
+                   {{0.5},
+                    test::AsTensor<int64>({0, 2, 0}),
+                    test::AsTensor<float>({10, 20, 30, 40, 50, 60}, {3, 2})}});
+
+  mutex_lock l(mu_);
+  ASSERT_EQ(2, calls_.size());
+  EXPECT_EQ(std::vector<float>({0.5}), calls_[1].params);
+  // The merged update lists each index once, in order of appearance.
+  const bool two_first = calls_[1].indices.vec<int64>()(0) == 2;
+  if (two_first) {
+    test::ExpectTensorEqual<int64>(test::AsTensor<int64>({2, 0}),
+                                   calls_[1].indices);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({31, 42, 63, 84}, {2, 2}), calls_[1].updates);
+  } else {
+    test::ExpectTensorEqual<int64>(test::AsTensor<int64>({0, 2}),
+                                   calls_[1].indices);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({63, 84, 31, 42}, {2, 2}), calls_[1].updates);
+  }
+}
+
+TEST_F(SparseUpdateCombinerTest, KeepsIncompatibleUpdatesApart) {
+  ApplyBatchAfter({{0.5},
+                   test::AsTensor<int64>({0}),
+                   test::AsTensor<float>({1, 1}, {1, 2})},
+                  {{{0.5},
+                    test::AsTensor<int64>({0}),
+                    test::AsTensor<float>({1, 2}, {1, 2})},
+                   {{0.25},
+                    test::AsTensor<int64>({0}),
+                    test::AsTensor<float>({3, 4}, {1, 2})},
+                   {{0.5},
+                    test::AsTensor<int64>({0}),
+                    test::AsTensor<float>({5, 6, 7}, {1, 3})}});
+
+  mutex_lock l(mu_);
+  // Neither the parameters nor the row shapes of the three updates match.
+  EXPECT_EQ(4, calls_.size());
+}
+
+}  // namespace
+}  // namespace tensorflow
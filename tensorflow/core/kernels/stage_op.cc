@@ -19,6 +19,8 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -35,71 +37,60 @@ class Buffer : public ResourceBase {
   using Tuple = std::vector<Tensor>;
 
   explicit Buffer(std::size_t capacity, std::size_t memory_limit)
-      : capacity_(capacity), memory_limit_(memory_limit), current_bytes_(0) {}
+      : capacity_(capacity),
+        memory_limit_(memory_limit),
+        current_bytes_(0),
+        next_copy_id_(0) {}
 
   // the Buffer takes ownership of the Tuple
-  Status Put(Tuple* tuple) {
-    std::unique_lock<std::mutex> lock(mu_);
-
-    std::size_t tuple_bytes = GetTupleBytes(*tuple);
-
-    // Sanity check so that we don't block for ever below
-    if (memory_limit_ > 0 && tuple_bytes > memory_limit_) {
-      return Status(
-          errors::ResourceExhausted("Attempted to insert "
-                                    "tensors with combined size of '",
-                                    tuple_bytes,
-                                    "' bytes into "
-                                    "Staging Area with a memory limit of '",
-                                    memory_limit_, "'."));
+  Status Put(Tuple* tuple) { return PutInternal(tuple, 0); }
+
+  // Like Put, but the tuple is still being copied to the device: Get and
+  // Peek wait for it until CopyDone is called with the returned '*copy_id'.
+  // It does count towards the size and the memory limit meanwhile.
+  Status PutPending(Tuple* tuple, int64* copy_id) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      *copy_id = ++next_copy_id_;
     }
+    return PutInternal(tuple, *copy_id);
+  }
 
-    // If buffer capacity is bounded wait until elements have been removed
-    if (IsBounded()) {
-      full_cond_var_.wait(lock, [tuple_bytes, this]() {
-        // If there's a memory limit, check if there's space for insertion
-        bool memory_limit_valid =
-            memory_limit_ > 0 ? !WouldExceedMemoryLimit(tuple_bytes) : true;
-        // If we're configured for capacity check if there's space for insertion
-        bool capacity_valid = capacity_ > 0 ? !IsCapacityFull() : true;
-
-        // Stop waiting upon success for both conditions
-        return capacity_valid && memory_limit_valid;
-      });
+  // Marks the tuple put with 'copy_id' as ready. If 'status' is an error,
+  // getting or peeking at the tuple returns it.
+  void CopyDone(int64 copy_id, const Status& status) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      for (Element& element : buf_) {
+        if (element.copy_id == copy_id) {
+          element.copy_id = 0;
+          element.status = status;
+          break;
+        }
+      }
     }
-
-    // Update bytes in the Staging Area
-    current_bytes_ += tuple_bytes;
-
-    // Store tuple
-    buf_.push_back(std::move(*tuple));
-
-    lock.unlock();
-    // Notify all removers. Removers
-    // may be peeking at a specific element or waiting
-    // for the element at the front of the deque.
-    // As we don't know the appropriate one to wake up
-    // we should wake them all.
     non_empty_cond_var_.notify_all();
-
-    return Status::OK();
   }
 
   // Get tuple at front of the buffer
-  void Get(Tuple* tuple) {  // TODO(zhifengc): Support cancellation.
+  Status Get(Tuple* tuple) {  // TODO(zhifengc): Support cancellation.
     std::unique_lock<std::mutex> lock(mu_);
 
-    // Wait for data if the buffer is empty
-    non_empty_cond_var_.wait(lock, [this]() { return !buf_.empty(); });
+    // Wait for data if the buffer is empty or still being copied
+    non_empty_cond_var_.wait(lock, [this]() {
+      return !buf_.empty() && buf_.front().copy_id == 0;
+    });
 
     // Move data into the output tuple
-    *tuple = std::move(buf_.front());
+    *tuple = std::move(buf_.front().tuple);
+    Status status = buf_.front().status;
     buf_.pop_front();
 
     // Update bytes in the Staging Area
     current_bytes_ -= GetTupleBytes(*tuple);
 
     notify_inserters_if_bounded(&lock);
+    return status;
   }
 
   // Return tuple at index
@@ -107,11 +98,13 @@ class Buffer : public ResourceBase {
     std::unique_lock<std::mutex> lock(mu_);
 
     // Wait if the requested index is not available
-    non_empty_cond_var_.wait(
-        lock, [index, this]() { return index < this->buf_.size(); });
+    non_empty_cond_var_.wait(lock, [index, this]() {
+      return index < this->buf_.size() && this->buf_[index].copy_id == 0;
+    });
+    TF_RETURN_IF_ERROR(buf_[index].status);
 
     // Place tensors in the output tuple
-    for (const auto& tensor : buf_[index]) {
+    for (const auto& tensor : buf_[index].tuple) {
       tuple->push_back(tensor);
     }
 
@@ -138,6 +131,60 @@ class Buffer : public ResourceBase {
   }
 
  private:
+  // A staged tuple. copy_id is nonzero while the tuple is being copied.
+  struct Element {
+    Tuple tuple;
+    int64 copy_id;
+    Status status;
+  };
+
+  Status PutInternal(Tuple* tuple, int64 copy_id) {
+    std::unique_lock<std::mutex> lock(mu_);
+
+    std::size_t tuple_bytes = GetTupleBytes(*tuple);
+
+    // Sanity check so that we don't block for ever below
+    if (memory_limit_ > 0 && tuple_bytes > memory_limit_) {
+      return Status(
+          errors::ResourceExhausted("Attempted to insert "
+                                    "tensors with combined size of '",
+                                    tuple_bytes,
+                                    "' bytes into "
+                                    "Staging Area with a memory limit of '",
+                                    memory_limit_, "'."));
+    }
+
+    // If buffer capacity is bounded wait until elements have been removed
+    if (IsBounded()) {
+      full_cond_var_.wait(lock, [tuple_bytes, this]() {
+        // If there's a memory limit, check if there's space for insertion
+        bool memory_limit_valid =
+            memory_limit_ > 0 ? !WouldExceedMemoryLimit(tuple_bytes) : true;
+        // If we're configured for capacity check if there's space for insertion
+        bool capacity_valid = capacity_ > 0 ? !IsCapacityFull() : true;
+
+        // Stop waiting upon success for both conditions
+        return capacity_valid && memory_limit_valid;
+      });
+    }
+
+    // Update bytes in the Staging Area
+    current_bytes_ += tuple_bytes;
+
+    // Store tuple
+    buf_.push_back({std::move(*tuple), copy_id, Status::OK()});
+
+    lock.unlock();
+    // Notify all removers. Removers
+    // may be peeking at a specific element or waiting
+    // for the element at the front of the deque.
+    // As we don't know the appropriate one to wake up
+    // we should wake them all.
+    non_empty_cond_var_.notify_all();
+
+    return Status::OK();
+  }
+
   // If the buffer is configured for bounded capacity, notify
   // waiting inserters that space is now available
   void notify_inserters_if_bounded(std::unique_lock<std::mutex>* lock) {
@@ -173,7 +220,8 @@ class Buffer : public ResourceBase {
   std::mutex mu_;
   std::condition_variable non_empty_cond_var_;
   std::condition_variable full_cond_var_;
-  std::deque<Tuple> buf_;
+  int64 next_copy_id_;
+  std::deque<Element> buf_;
 };
 
 Status GetBuffer(OpKernelContext* ctx, const NodeDef& ndef, Buffer** buf) {
@@ -223,6 +271,87 @@ REGISTER_KERNEL_BUILDER(Name("Stage").Device(DEVICE_GPU), StageOp);
 REGISTER_KERNEL_BUILDER(Name("Stage").Device(DEVICE_SYCL), StageOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+#if GOOGLE_CUDA
+// A Stage kernel that takes its inputs in host memory and copies them to
+// the device on the device's host-to-device stream without waiting for
+// the copies: Unstage and StagePeek see the tuple once they complete, so
+// the copy overlaps with the rest of the step and with the next one.
+// Selected with the "host_to_device" kernel label, e.g. in Python with
+//   g._kernel_label_map({"Stage": "host_to_device"})
+class HostToDeviceStageOp : public OpKernel {
+ public:
+  explicit HostToDeviceStageOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    Buffer* buf = nullptr;
+    OP_REQUIRES_OK(ctx, GetBuffer(ctx, def(), &buf));
+    core::ScopedUnref scope(buf);
+    DeviceContext* device_ctx = ctx->op_device_context();
+    OP_REQUIRES(ctx, device_ctx != nullptr,
+                errors::Internal("No device context for ", name()));
+
+    // Holds the tensors until the last copy is done.
+    struct CopyState {
+      std::mutex mu;
+      Status status;
+      int pending;
+      Buffer* buf;
+      std::vector<Tensor> host_tensors;
+      Buffer::Tuple device_tensors;
+    };
+    std::unique_ptr<CopyState> state(new CopyState);
+    state->pending = ctx->num_inputs();
+    for (int i = 0; i < ctx->num_inputs(); ++i) {
+      const Tensor& input = ctx->input(i);
+      OP_REQUIRES(ctx, DataTypeCanUseMemcpy(input.dtype()),
+                  errors::InvalidArgument("Cannot stage ",
+                                          DataTypeString(input.dtype()),
+                                          " tensors to the device."));
+      Tensor device_tensor;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(input.dtype(), input.shape(),
+                                             &device_tensor));
+      state->host_tensors.push_back(input);
+      state->device_tensors.push_back(device_tensor);
+    }
+
+    // The device tensors count against the memory limit while the copies
+    // are in flight.
+    Buffer::Tuple tuple(state->device_tensors);
+    int64 copy_id;
+    OP_REQUIRES_OK(ctx, buf->PutPending(&tuple, &copy_id));
+    if (state->pending == 0) {
+      buf->CopyDone(copy_id, Status::OK());
+      return;
+    }
+
+    buf->Ref();
+    state->buf = buf;
+    Device* device = static_cast<Device*>(ctx->device());
+    CopyState* s = state.release();
+    for (int i = 0; i < ctx->num_inputs(); ++i) {
+      device_ctx->CopyCPUTensorToDevice(
+          &s->host_tensors[i], device, &s->device_tensors[i],
+          [s, copy_id](const Status& status) {
+            {
+              std::unique_lock<std::mutex> lock(s->mu);
+              s->status.Update(status);
+              if (--s->pending > 0) return;
+            }
+            s->buf->CopyDone(copy_id, s->status);
+            s->buf->Unref();
+            delete s;
+          });
+    }
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("Stage")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("values")
+                            .Label("host_to_device"),
+                        HostToDeviceStageOp);
+#endif  // GOOGLE_CUDA
+
 class UnstageOp : public OpKernel {
  public:
   explicit UnstageOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
@@ -235,7 +364,7 @@ class UnstageOp : public OpKernel {
     core::ScopedUnref scope(buf);
     Buffer::Tuple tuple;
 
-    buf->Get(&tuple);
+    OP_REQUIRES_OK(ctx, buf->Get(&tuple));
 
     OP_REQUIRES(
         ctx, tuple.size() == (size_t)ctx->num_outputs(),
@@ -15,7 +15,10 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -24,27 +27,95 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 namespace {
 
-std::vector<string> Split(const string& str, const string& delimiter,
-                          const bool skipEmpty) {
-  if (!delimiter.empty()) {
-    if (skipEmpty) {
-      return str_util::Split(str, delimiter, str_util::SkipEmpty());
+// A set of delimiter characters, scanned for with memchr() when there is a
+// single one.
+class DelimiterSet {
+ public:
+  explicit DelimiterSet(StringPiece delimiter) : single_(-1) {
+    std::memset(is_delimiter_, 0, sizeof(is_delimiter_));
+    for (char c : delimiter) {
+      is_delimiter_[static_cast<uint8>(c)] = true;
+    }
+    if (delimiter.size() == 1) {
+      single_ = static_cast<uint8>(delimiter[0]);
     }
-    return str_util::Split(str, delimiter);
   }
-  std::vector<string> char_vector(str.size());
-  for (size_t i = 0; i < str.size(); ++i) {
-    char_vector[i] = str[i];
+
+  // Returns the position of the first delimiter of `text` at or after `pos`,
+  // or text.size() if there is none.
+  size_t Find(StringPiece text, size_t pos) const {
+    if (single_ >= 0) {
+      const void* found =
+          std::memchr(text.data() + pos, single_, text.size() - pos);
+      return found == nullptr
+                 ? text.size()
+                 : static_cast<const char*>(found) - text.data();
+    }
+    while (pos < text.size() && !is_delimiter_[static_cast<uint8>(text[pos])]) {
+      ++pos;
+    }
+    return pos;
+  }
+
+ private:
+  bool is_delimiter_[256];
+  int single_;
+};
+
+// Appends the pieces of `str` between the characters of `delimiter` to
+// `tokens`, as str_util::Split() would, without copying them. An empty
+// delimiter splits the string into its characters.
+void Split(StringPiece str, StringPiece delimiter,
+           const DelimiterSet& delimiters, const bool skipEmpty,
+           std::vector<StringPiece>* tokens) {
+  if (delimiter.empty()) {
+    for (size_t i = 0; i < str.size(); ++i) {
+      tokens->emplace_back(str.data() + i, 1);
+    }
+    return;
+  }
+  if (str.empty()) {
+    return;
+  }
+  size_t start = 0;
+  while (true) {
+    const size_t end = delimiters.Find(str, start);
+    if (!skipEmpty || end > start) {
+      tokens->push_back(str.substr(start, end - start));
+    }
+    if (end == str.size()) {
+      return;
+    }
+    start = end + 1;
+  }
+}
+
+// Returns the position of the first occurrence of `sep` in `text`, or
+// text.size(). Candidates are found with memchr() on the first character.
+size_t FindSeparator(StringPiece text, StringPiece sep) {
+  const char* begin = text.data();
+  const char* end = text.data() + text.size();
+  for (const char* p = begin; end - p >= static_cast<ptrdiff_t>(sep.size());
+       ++p) {
+    p = static_cast<const char*>(std::memchr(p, sep[0], end - p));
+    if (p == nullptr || end - p < static_cast<ptrdiff_t>(sep.size())) {
+      break;
+    }
+    if (std::memcmp(p, sep.data(), sep.size()) == 0) {
+      return p - begin;
+    }
   }
-  return char_vector;
+  return text.size();
 }
 
-std::vector<string> SplitV2(const string& str, StringPiece sep, int maxsplit) {
+void SplitV2(StringPiece text, StringPiece sep, int maxsplit,
+             std::vector<StringPiece>* result) {
   // This SplitV2 method matches the behavior of python's str.split:
   //   If sep is given, consecutive delimiters are not grouped together
   //   and are deemed to delimit empty strings (for example, '1,,2'.split(',')
@@ -59,12 +130,9 @@ std::vector<string> SplitV2(const string& str, StringPiece sep, int maxsplit) {
   //   splitting an empty string or a string consisting of just whitespace
   //   with a None separator returns [].
 
-  std::vector<string> result;
-
-  StringPiece text(str);
   if (maxsplit == 0) {
-    result.emplace_back(std::string(text));
-    return result;
+    result->push_back(text);
+    return;
   }
 
   if (sep.empty()) {
@@ -73,32 +141,96 @@ std::vector<string> SplitV2(const string& str, StringPiece sep, int maxsplit) {
     str_util::RemoveLeadingWhitespace(&text);
     int split = 0;
     while (str_util::ConsumeNonWhitespace(&text, &token)) {
-      result.emplace_back(std::string(token));
+      result->push_back(token);
       str_util::RemoveLeadingWhitespace(&text);
       ++split;
       if (maxsplit > 0 && split == maxsplit) {
-        result.emplace_back(std::string(text));
-        return result;
+        result->push_back(text);
+        return;
       }
     }
-    return result;
+    return;
   }
-  auto p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+  size_t p = FindSeparator(text, sep);
   int split = 0;
-  while (p != text.end()) {
-    StringPiece token = text.substr(0, p - text.begin());
-    result.emplace_back(std::string(token));
+  while (p != text.size()) {
+    StringPiece token = text.substr(0, p);
+    result->push_back(token);
     text.remove_prefix(token.size());
     text.remove_prefix(sep.size());
     ++split;
     if (maxsplit > 0 && split == maxsplit) {
-      result.emplace_back(std::string(text));
-      return result;
+      result->push_back(text);
+      return;
     }
-    p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+    p = FindSeparator(text, sep);
   }
-  result.emplace_back(std::string(text));
-  return result;
+  result->push_back(text);
+}
+
+// Splits each element of `input_vec` with `split`, in parallel over the
+// batch, and outputs the tokens as a SparseTensor. The tokens point into the
+// input until they are copied into the output, once each.
+template <typename SplitFn>
+void SplitBatch(OpKernelContext* ctx, TTypes<string>::ConstVec input_vec,
+                SplitFn split) {
+  const int64 batch_size = input_vec.dimension(0);
+  int64 total_bytes = 0;
+  for (int64 i = 0; i < batch_size; ++i) {
+    total_bytes += input_vec(i).size();
+  }
+  // Scanning and copying a byte costs a few cycles.
+  const int64 cost_per_example =
+      10 * (batch_size > 0 ? total_bytes / batch_size : 0) + 100;
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+
+  std::vector<std::vector<StringPiece>> tokens(batch_size);
+  Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+        cost_per_example, [&input_vec, &split, &tokens](int64 start,
+                                                         int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            split(input_vec(i), &tokens[i]);
+          }
+        });
+
+  int64 output_size = 0;
+  int64 max_num_entries = 0;
+  std::vector<int64> output_starts(batch_size);
+  for (int64 i = 0; i < batch_size; ++i) {
+    const int64 n_entries = tokens[i].size();
+    output_starts[i] = output_size;
+    output_size += n_entries;
+    max_num_entries = std::max(max_num_entries, n_entries);
+  }
+
+  Tensor* sp_indices_t;
+  OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
+                                           &sp_indices_t));
+  Tensor* sp_tokens_t;
+  OP_REQUIRES_OK(
+      ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
+  Tensor* sp_shape_t;
+  OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
+
+  auto sp_indices = sp_indices_t->matrix<int64>();
+  auto sp_tokens = sp_tokens_t->vec<string>();
+  auto sp_shape = sp_shape_t->vec<int64>();
+  sp_shape(0) = batch_size;
+  sp_shape(1) = max_num_entries;
+  Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+        cost_per_example,
+        [&tokens, &output_starts, &sp_indices, &sp_tokens](int64 start,
+                                                           int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            int64 c = output_starts[i];
+            for (size_t j = 0; j < tokens[i].size(); ++j) {
+              sp_indices(c, 0) = i;
+              sp_indices(c, 1) = j;
+              sp_tokens(c).assign(tokens[i][j].data(), tokens[i][j].size());
+              ++c;
+            }
+          }
+        });
 }
 
 }  // namespace
@@ -123,7 +255,6 @@ class StringSplitOp : public OpKernel {
                                         input_tensor->shape().DebugString()));
 
     const auto input_vec = input_tensor->vec<string>();
-    const int64 batch_size = input_vec.dimension(0);
 
     const Tensor* delimiter_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("delimiter", &delimiter_tensor));
@@ -134,46 +265,13 @@ class StringSplitOp : public OpKernel {
     const auto delimiter_vec = delimiter_tensor->flat<string>();
     const string& delimiter = delimiter_vec(0);
     // Empty delimiter means split the input character by character.
-    std::vector<string> tokens;
-    // Guess that we'll be unpacking a handful of tokens per example.
-    static constexpr int kReserveSize = 4;
-    tokens.reserve(batch_size * kReserveSize);
-
-    int64 output_size = 0;
-    int64 max_num_entries = 0;
-    std::vector<int64> num_indices(batch_size);
-    for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<string> parts = Split(input_vec(i), delimiter, skip_empty_);
-      int64 n_entries = parts.size();
-      num_indices[i] = n_entries;
-      output_size += n_entries;
-      max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
-    }
-
-    Tensor* sp_indices_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
-                                             &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
-    Tensor* sp_shape_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
-
-    auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<string>();
-    auto sp_shape = sp_shape_t->vec<int64>();
-    sp_shape(0) = batch_size;
-    sp_shape(1) = max_num_entries;
-    size_t c = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-      for (size_t j = 0; j < num_indices[i]; ++j) {
-        sp_indices(c, 0) = i;
-        sp_indices(c, 1) = j;
-        sp_tokens(c) = tokens[c];
-        ++c;
-      }
-    }
+    const DelimiterSet delimiters(delimiter);
+    const bool skip_empty = skip_empty_;
+    SplitBatch(ctx, input_vec,
+               [&delimiter, &delimiters, skip_empty](
+                   StringPiece str, std::vector<StringPiece>* tokens) {
+                 Split(str, delimiter, delimiters, skip_empty, tokens);
+               });
   }
 
  private:
@@ -195,7 +293,6 @@ class StringSplitV2Op : public OpKernel {
                                         input_tensor->shape().DebugString()));
 
     const auto input_vec = input_tensor->vec<string>();
-    const int64 batch_size = input_vec.dimension(0);
 
     const Tensor* sep_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("sep", &sep_tensor));
@@ -204,46 +301,12 @@ class StringSplitV2Op : public OpKernel {
                                         sep_tensor->shape().DebugString()));
     const auto sep_vec = sep_tensor->flat<string>();
     StringPiece sep(sep_vec(0));
-    std::vector<string> tokens;
-    // Guess that we'll be unpacking a handful of tokens per example.
-    static constexpr int kReserveSize = 4;
-    tokens.reserve(batch_size * kReserveSize);
-
-    int64 output_size = 0;
-    int64 max_num_entries = 0;
-    std::vector<int64> num_indices(batch_size);
-    for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<string> parts = SplitV2(input_vec(i), sep, maxsplit_);
-      int64 n_entries = parts.size();
-      num_indices[i] = n_entries;
-      output_size += n_entries;
-      max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
-    }
-
-    Tensor* sp_indices_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
-                                             &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
-    Tensor* sp_shape_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
-
-    auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<string>();
-    auto sp_shape = sp_shape_t->vec<int64>();
-    sp_shape(0) = batch_size;
-    sp_shape(1) = max_num_entries;
-    size_t c = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-      for (size_t j = 0; j < num_indices[i]; ++j) {
-        sp_indices(c, 0) = i;
-        sp_indices(c, 1) = j;
-        sp_tokens(c) = tokens[c];
-        ++c;
-      }
-    }
+    const int maxsplit = maxsplit_;
+    SplitBatch(ctx, input_vec,
+               [sep, maxsplit](StringPiece str,
+                               std::vector<StringPiece>* tokens) {
+                 SplitV2(str, sep, maxsplit, tokens);
+               });
   }
 
  private:
@@ -23,9 +23,21 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+// The cost of hashing an element of `input_flat` for Shard(), proportional to
+// the average size of the strings.
+inline int64 HashCostPerElement(TTypes<string>::ConstFlat input_flat) {
+  int64 total_bytes = 0;
+  for (int64 i = 0; i < input_flat.size(); ++i) {
+    total_bytes += input_flat(i).size();
+  }
+  return 2 * (input_flat.size() > 0 ? total_bytes / input_flat.size() : 0) +
+         20;
+}
+
 template <uint64 hash(StringPiece)>
 class StringToHashBucketOp : public OpKernel {
  public:
@@ -44,15 +56,20 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    const int64 num_buckets = num_buckets_;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), HashCostPerElement(input_flat),
+          [&input_flat, &output_flat, num_buckets](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 input_hash = hash(input_flat(i));
+              const uint64 bucket_id = input_hash % num_buckets;
+              // The number of buckets is always in the positive range of int64
+              // so is the resulting bucket_id. Casting the bucket_id from
+              // uint64 to int64 is safe.
+              output_flat(i) = static_cast<int64>(bucket_id);
+            }
+          });
   }
 
  private:
@@ -86,15 +103,21 @@ class StringToKeyedHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    const int64 num_buckets = num_buckets_;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), HashCostPerElement(input_flat),
+          [this, &input_flat, &output_flat, num_buckets](int64 start,
+                                                         int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              const uint64 input_hash = hash(key_, input_flat(i));
+              const uint64 bucket_id = input_hash % num_buckets;
+              // The number of buckets is always in the positive range of int64
+              // so is the resulting bucket_id. Casting the bucket_id from
+              // uint64 to int64 is safe.
+              output_flat(i) = static_cast<int64>(bucket_id);
+            }
+          });
   }
 
  private:
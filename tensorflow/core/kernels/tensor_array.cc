@@ -19,6 +19,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/aggregate_ops_cpu.h"
+#include "tensorflow/core/kernels/dense_update_functor.h"
 
 namespace tensorflow {
 
@@ -77,6 +78,32 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 
 #undef TENSOR_ARRAY_SET_ZERO
 
+#define TENSOR_ARRAY_COPY(Device, T)                                       \
+  template <>                                                              \
+  Status TensorCopy<Device, T>(OpKernelContext * ctx, Tensor * dst,        \
+                               const Tensor* src) {                        \
+    functor::DenseUpdate<Device, T, ASSIGN> copy_functor;                  \
+    copy_functor(ctx->template eigen_device<Device>(), dst->flat<T>(),     \
+                 src->flat<T>());                                          \
+    return Status::OK();                                                   \
+  }
+
+#define TENSOR_ARRAY_COPY_CPU(T) TENSOR_ARRAY_COPY(CPUDevice, T)
+TF_CALL_NUMBER_TYPES(TENSOR_ARRAY_COPY_CPU)
+#undef TENSOR_ARRAY_COPY_CPU
+
+#if GOOGLE_CUDA
+
+#define TENSOR_ARRAY_COPY_GPU(T) TENSOR_ARRAY_COPY(GPUDevice, T)
+TF_CALL_GPU_NUMBER_TYPES(TENSOR_ARRAY_COPY_GPU);
+TF_CALL_complex64(TENSOR_ARRAY_COPY_GPU);
+TF_CALL_complex128(TENSOR_ARRAY_COPY_GPU);
+#undef TENSOR_ARRAY_COPY_GPU
+
+#endif  // GOOGLE_CUDA
+
+#undef TENSOR_ARRAY_COPY
+
 }  // namespace tensor_array
 
 std::atomic<int64> TensorArray::tensor_array_counter{0};
@@ -114,4 +141,29 @@ Status TensorArray::CopyShapesFrom(TensorArray* rhs,
   return Status::OK();
 }
 
+bool TensorArray::ReadContiguous(const std::vector<int32>& indices,
+                                 PersistentTensor* value) {
+  mutex_lock l(mu_);
+  if (closed_ || !buffer_.IsInitialized() ||
+      indices.size() != tensors_.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    const TensorAndState& t = tensors_[i];
+    if (indices[i] != static_cast<int32>(i) || !t.in_buffer || t.cleared) {
+      return false;
+    }
+  }
+  *value = buffer_;
+  for (TensorAndState& t : tensors_) {
+    if (clear_after_read_) {
+      t.tensor = PersistentTensor();
+      t.cleared = true;
+    }
+    t.read = true;
+  }
+  if (clear_after_read_) buffer_ = PersistentTensor();
+  return true;
+}
+
 }  // namespace tensorflow
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/aggregate_ops.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
@@ -96,6 +97,34 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 
 #undef TENSOR_ARRAY_SET_ZERO
 
+template <typename Device, typename T>
+Status TensorCopy(OpKernelContext* ctx, Tensor* dst, const Tensor* src) {
+  return errors::InvalidArgument(
+      "tensor_array::TensorCopy type not supported: ",
+      DataTypeString(DataTypeToEnum<T>::value));
+};
+
+#define TENSOR_ARRAY_COPY(Device, T)                                \
+  template <>                                                       \
+  Status TensorCopy<Device, T>(OpKernelContext * ctx, Tensor * dst, \
+                               const Tensor* src);
+
+#define TENSOR_ARRAY_COPY_CPU(T) TENSOR_ARRAY_COPY(CPUDevice, T)
+TF_CALL_NUMBER_TYPES(TENSOR_ARRAY_COPY_CPU)
+#undef TENSOR_ARRAY_COPY_CPU
+
+#if GOOGLE_CUDA
+
+#define TENSOR_ARRAY_COPY_GPU(T) TENSOR_ARRAY_COPY(GPUDevice, T)
+TF_CALL_GPU_NUMBER_TYPES(TENSOR_ARRAY_COPY_GPU);
+TF_CALL_complex64(TENSOR_ARRAY_COPY_GPU);
+TF_CALL_complex128(TENSOR_ARRAY_COPY_GPU);
+#undef TENSOR_ARRAY_COPY_GPU
+
+#endif  // GOOGLE_CUDA
+
+#undef TENSOR_ARRAY_COPY
+
 }  // namespace tensor_array
 
 // The TensorArray object keeps an array of PersistentTensors.  It
@@ -114,6 +143,10 @@ TF_CALL_complex128(TENSOR_ARRAY_SET_ZERO_GPU);
 //     All operations on a TensorArray are thread-safe.
 //   * A TensorArray may be preemptively closed, which releases all
 //     memory associated with it.
+//   * A fixed-size TensorArray with a fully defined element shape may use
+//     contiguous storage (see EnableContiguousStorage): writes are then
+//     copied into one [N] + element_shape buffer, and packing or gathering
+//     the whole array in order returns that buffer without a copy.
 //
 // These properties together allow the TensorArray to work as a
 // functional object and makes gradient computation easy.  For
@@ -153,6 +186,7 @@ class TensorArray : public ResourceBase {
         marked_size_(marked_size),
         element_shape_(element_shape),
         identical_element_shapes_(identical_element_shapes),
+        contiguous_storage_(false),
         tensors_(N) {}
 
   // Write PersistentTensor 'value' to index 'index'.
@@ -324,6 +358,23 @@ class TensorArray : public ResourceBase {
 
   bool HasIdenticalElementShapes() const { return identical_element_shapes_; }
 
+  // Makes writes land in a single buffer holding all N elements, which is
+  // allocated on the first write.  Only takes effect for arrays that have
+  // a fixed size, a fully defined element shape and write-once semantics;
+  // otherwise this is a no-op.  Must be called before the first write.
+  void EnableContiguousStorage() {
+    mutex_lock l(mu_);
+    contiguous_storage_ = !dynamic_size_ && !multiple_writes_aggregate_ &&
+                          !is_grad_ && element_shape_.IsFullyDefined();
+  }
+
+  // If 'indices' is [0, N) in order and every element was written to the
+  // contiguous buffer and not yet cleared, marks all elements read (as
+  // ReadMany would), returns the buffer in '*value' and returns true.
+  // Otherwise leaves the TensorArray untouched and returns false.
+  bool ReadContiguous(const std::vector<int32>& indices,
+                      PersistentTensor* value);
+
   // Copy the TensorShapes from another TensorArray into this one.
   // If `shapes_to_prepend` is set, expands the rank of the copied shape by
   // prepending the passed in shape prefix to the shape values in `rhs`.
@@ -339,6 +390,7 @@ class TensorArray : public ResourceBase {
   void ClearAndMarkClosed() {
     mutex_lock l(mu_);
     tensors_.clear();
+    buffer_ = PersistentTensor();
     closed_ = true;
   }
 
@@ -362,6 +414,14 @@ class TensorArray : public ResourceBase {
   Status LockedRead(OpKernelContext* ctx, const int32 index,
                     PersistentTensor* value) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Copies 'value' into the slice of buffer_ at 'index', allocating buffer_
+  // if needed, and stores that slice as the element.  Sets '*written' to
+  // false instead if the slices of buffer_ would not be aligned for Eigen.
+  template <typename Device, typename T>
+  Status LockedWriteToBuffer(OpKernelContext* ctx, const int32 index,
+                             const Tensor& value, bool* written)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status LockedReturnIfClosed() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     if (closed_) {
       return errors::InvalidArgument("TensorArray ", handle_.vec<string>()(1),
@@ -413,12 +473,24 @@ class TensorArray : public ResourceBase {
   // was not fully defined.
   const bool identical_element_shapes_;
 
+  // Whether writes are copied into buffer_ (see EnableContiguousStorage).
+  bool contiguous_storage_ GUARDED_BY(mu_);
+
+  // The [N] + element_shape buffer backing the elements when
+  // contiguous_storage_ is true.  Elements read with clear_after_read keep
+  // the buffer alive until the whole array is read or closed.
+  PersistentTensor buffer_ GUARDED_BY(mu_);
+
   // TensorAndState is used to keep track of the PersistentTensors
   // stored in the TensorArray, along with their shapes, and a boolean
   // that determines whether they have already been read or not.
   struct TensorAndState {
     TensorAndState()
-        : written(false), read(false), cleared(false), local_copy(false) {}
+        : written(false),
+          read(false),
+          cleared(false),
+          local_copy(false),
+          in_buffer(false) {}
     PersistentTensor tensor;
     TensorShape shape;
     bool written;  // True if a Tensor has been written to the index.
@@ -433,6 +505,9 @@ class TensorArray : public ResourceBase {
     // aggregated value.  This flag marks that such a Tensor is being
     // used.  All future writes will aggregate to the existing local Tensor.
     bool local_copy;
+
+    // True if the tensor is a slice of the contiguous buffer_.
+    bool in_buffer;
   };
   // The list of underlying PersistentTensors and states.
   std::vector<TensorAndState> tensors_ GUARDED_BY(mu_);
@@ -535,13 +610,45 @@ Status TensorArray::LockedWriteOrAggregate(OpKernelContext* ctx,
     // TensorArray.
     gradients_disallowed_ = true;
   } else {
-    t.tensor = *value;
+    bool written = false;
+    if (contiguous_storage_ && value_t->NumElements() > 0) {
+      TF_RETURN_IF_ERROR(
+          LockedWriteToBuffer<Device, T>(ctx, index, *value_t, &written));
+    }
+    if (!written) t.tensor = *value;
     t.shape = value_t->shape();
     t.written = true;
   }
   return Status::OK();
 }
 
+template <typename Device, typename T>
+Status TensorArray::LockedWriteToBuffer(OpKernelContext* ctx,
+                                        const int32 index,
+                                        const Tensor& value, bool* written) {
+  *written = false;
+  TensorShape buffer_shape(value.shape());
+  buffer_shape.InsertDim(0, tensors_.size());
+  if (!IsInnerDimsSizeAligned<T>(buffer_shape)) return Status::OK();
+  if (!buffer_.IsInitialized()) {
+    Tensor* unused;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_persistent(dtype_, buffer_shape, &buffer_, &unused));
+  }
+  Tensor* buffer_t = buffer_.AccessTensor(ctx);
+  if (buffer_t->shape() != buffer_shape) return Status::OK();
+
+  Tensor element;
+  CHECK(element.CopyFrom(buffer_t->Slice(index, index + 1), value.shape()));
+  TF_RETURN_IF_ERROR(
+      tensor_array::TensorCopy<Device, T>(ctx, &element, &value));
+  TensorAndState& t = tensors_[index];
+  t.tensor = PersistentTensor(element);
+  t.in_buffer = true;
+  *written = true;
+  return Status::OK();
+}
+
 template <typename Device, typename T>
 Status TensorArray::LockedRead(OpKernelContext* ctx, const int32 index,
                                PersistentTensor* value) {
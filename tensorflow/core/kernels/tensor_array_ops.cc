@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 #if GOOGLE_CUDA
@@ -175,6 +176,9 @@ class TensorArrayOp : public TensorArrayCreationOp {
     OP_REQUIRES_OK(context,
                    context->GetAttr("tensor_array_name", &tensor_array_name_));
     if (tensor_array_name_.empty()) tensor_array_name_ = name();
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar("TF_TENSOR_ARRAY_CONTIGUOUS_STORAGE",
+                                      false, &contiguous_storage_));
   }
 
   Status CreateTensorArray(OpKernelContext* ctx, ResourceMgr* rm,
@@ -207,6 +211,7 @@ class TensorArrayOp : public TensorArrayCreationOp {
         identical_element_shapes_, dynamic_size_,
         false /* multiple_writes_aggregate */, false /* is_grad */,
         -1 /* marked_size */, clear_after_read_);
+    if (contiguous_storage_) tensor_array->EnableContiguousStorage();
 
     TF_RETURN_IF_ERROR(
         rm->Create(ctx->step_container()->name(), key, tensor_array));
@@ -222,6 +227,8 @@ class TensorArrayOp : public TensorArrayCreationOp {
   bool identical_element_shapes_;
   bool dynamic_size_;
   bool clear_after_read_;
+  // Whether to back the TensorArray with one contiguous buffer.
+  bool contiguous_storage_;
   string tensor_array_name_;  // The name used to create the TensorArray.
 
   TF_DISALLOW_COPY_AND_ASSIGN(TensorArrayOp);
@@ -652,6 +659,14 @@ class TensorArrayPackOrGatherOp : public OpKernel {
       return;
     }
 
+    // If the elements were written in place to a contiguous buffer, the
+    // buffer already is the packed result.
+    PersistentTensor buffer;
+    if (tensor_array->ReadContiguous(indices, &buffer)) {
+      ctx->set_output(0, *buffer.AccessTensor(ctx));
+      return;
+    }
+
     // Read all the PersistentTensors into a vector to keep track of
     // their memory.
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
@@ -858,11 +873,45 @@ class TensorArrayConcatOp : public OpKernel {
       return;
     }
 
+    std::vector<int32> indices(array_size);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    // If the elements were written in place to a contiguous buffer, the
+    // result is the buffer with its first two dimensions merged.
+    PersistentTensor buffer;
+    if (tensor_array->ReadContiguous(indices, &buffer)) {
+      const Tensor* buffer_t = buffer.AccessTensor(ctx);
+      OP_REQUIRES(
+          ctx, buffer_t->dims() >= 2,
+          errors::InvalidArgument(
+              "Concat saw a scalar shape at index 0"
+              " but requires at least vectors.  Did you mean to call pack?"));
+      TensorShape output_shape(buffer_t->shape());
+      output_shape.RemoveDim(0);
+      const int64 length = output_shape.dim_size(0);
+      TensorShape output_shape_except0(output_shape);
+      output_shape_except0.RemoveDim(0);
+      OP_REQUIRES(
+          ctx, element_shape_except0_.IsCompatibleWith(output_shape_except0),
+          errors::InvalidArgument(
+              "TensorArray was passed element_shape_except0 ",
+              element_shape_except0_.DebugString(),
+              " but index 0 has (excepting dimension 0) shape: ",
+              output_shape_except0.DebugString(), " which does not match."));
+      output_shape.set_dim(0, length * array_size);
+      Tensor output;
+      CHECK(output.CopyFrom(*buffer_t, output_shape));
+      ctx->set_output(0, output);
+      Tensor* lengths_tensor = nullptr;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({array_size}),
+                                               &lengths_tensor));
+      lengths_tensor->vec<int64>().setConstant(length);
+      return;
+    }
+
     // Read all the PersistentTensors into a vector to keep track of
     // their memory.
     std::vector<PersistentTensor> values;
-    std::vector<int32> indices(array_size);
-    std::iota(indices.begin(), indices.end(), 0);
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
     OP_REQUIRES_OK(ctx, s);
 
@@ -99,6 +99,17 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// The fraction of the elements of a row above which its top k are selected
+// rather than filtered with a heap.
+constexpr int64 kMaxHeapFraction = 8;
+// The minimum size of the chunks of a row processed in parallel, overall and
+// relative to k.
+constexpr int64 kMinChunkSize = 16 * 1024;
+constexpr int64 kMinChunkSizePerK = 8;
+// The number of elements whose maximum is compared with the smallest of the
+// top k so far, before looking at each of them.
+constexpr int32 kBlockSize = 16;
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -176,6 +187,17 @@ struct TopKFunctor<CPUDevice, T> {
             }
             run_begin = run_end;
           }
+        } else if (k > num_cols / kMaxHeapFraction) {
+          // A selection is faster than a heap of a large fraction of the
+          // elements.
+          std::vector<int32> order(num_cols);
+          std::iota(order.begin(), order.end(), 0);
+          std::nth_element(order.begin(), order.begin() + k, order.end(),
+                           stable_comp);
+          if (sorted) {
+            std::sort(order.begin(), order.begin() + k, stable_comp);
+          }
+          std::copy(order.begin(), order.begin() + k, &indices(b, 0));
         } else {
           // Use the TopN heap object to sort.
           gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
@@ -220,11 +242,103 @@ struct TopKFunctor<CPUDevice, T> {
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // When there are fewer rows than threads, each row is split into chunks
+    // whose top k are found in parallel and then merged, if the chunks are
+    // large enough compared with k.
+    const int64 num_chunks = std::min<int64>(
+        4 * worker_threads.num_threads,
+        num_cols / std::max<int64>(kMinChunkSize, kMinChunkSizePerK * k));
+    if (k < num_cols && num_rows < worker_threads.num_threads &&
+        num_chunks >= 2) {
+      for (int64 b = 0; b < num_rows; ++b) {
+        TopKOfRowInChunks(worker_threads, &input(b, 0), num_cols, k, sorted,
+                          num_chunks, &values(b, 0), &indices(b, 0));
+      }
+      return Status::OK();
+    }
+
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+ private:
+  // Sets `top_k` to the indices of the k largest elements of `data` in
+  // [begin, end), in no particular order, the smallest index first among
+  // equal elements.
+  static void TopKOfRange(const T* data, int32 begin, int32 end, int k,
+                          int32* top_k) {
+    // A heap of the top k so far, whose top is the smallest.
+    const auto worse = [data](const int32 a, const int32 b) {
+      return data[b] < data[a] || (!(data[a] < data[b]) && a < b);
+    };
+    int32* heap_end = top_k;
+    int32 c = begin;
+    for (; c < end && heap_end - top_k < k; ++c) {
+      *heap_end++ = c;
+      std::push_heap(top_k, heap_end, worse);
+    }
+    T threshold = data[top_k[0]];
+    while (c < end) {
+      const int32 block_end = std::min(c + kBlockSize, end);
+      // The maximum of the block, in a loop that vectorizes, skips most
+      // blocks without looking at each element. An element equal to the
+      // threshold comes after it, so it is not in the top k.
+      T block_max = data[c];
+      for (int32 i = c + 1; i < block_end; ++i) {
+        block_max = data[i] > block_max ? data[i] : block_max;
+      }
+      if (threshold < block_max) {
+        for (int32 i = c; i < block_end; ++i) {
+          if (threshold < data[i]) {
+            std::pop_heap(top_k, heap_end, worse);
+            heap_end[-1] = i;
+            std::push_heap(top_k, heap_end, worse);
+            threshold = data[top_k[0]];
+          }
+        }
+      }
+      c = block_end;
+    }
+  }
+
+  // Computes the top k of a row, splitting it into `num_chunks` chunks whose
+  // top k are found in parallel and then merged.
+  static void TopKOfRowInChunks(
+      const DeviceBase::CpuWorkerThreads& worker_threads, const T* data,
+      int64 num_cols, int k, bool sorted, int64 num_chunks, T* values,
+      int32* indices) {
+    auto chunk_start = [num_cols, num_chunks](int64 chunk) {
+      return static_cast<int32>(chunk * num_cols / num_chunks);
+    };
+    std::vector<int32> candidates(num_chunks * k);
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_chunks,
+          static_cast<int64>(cmp_cost * num_cols / num_chunks),
+          [&](int64 begin, int64 end) {
+            for (int64 chunk = begin; chunk < end; ++chunk) {
+              TopKOfRange(data, chunk_start(chunk), chunk_start(chunk + 1), k,
+                          &candidates[chunk * k]);
+            }
+          });
+
+    const auto stable_comp = [data](const int32 a, const int32 b) {
+      return data[b] < data[a] || (!(data[a] < data[b]) && a < b);
+    };
+    if (sorted) {
+      std::partial_sort(candidates.begin(), candidates.begin() + k,
+                        candidates.end(), stable_comp);
+    } else {
+      std::nth_element(candidates.begin(), candidates.begin() + k,
+                       candidates.end(), stable_comp);
+    }
+    std::copy(candidates.begin(), candidates.begin() + k, indices);
+    std::transform(indices, indices + k, values,
+                   [data](const int32 loc) { return data[loc]; });
+  }
 };
 
 }  // namespace functor
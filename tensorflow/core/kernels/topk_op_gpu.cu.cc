@@ -20,6 +20,7 @@ limitations under the License.
 #include <cmath>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "external/cub_archive/cub/block/block_scan.cuh"
 #include "external/cub_archive/cub/device/device_segmented_radix_sort.cuh"
 #include "external/cub_archive/cub/iterator/counting_input_iterator.cuh"
 #include "external/cub_archive/cub/iterator/transform_input_iterator.cuh"
@@ -527,6 +528,211 @@ Status LaunchSortKernel(OpKernelContext* ctx, const T* input, int num_rows,
   return Status::OK();
 }
 
+// RadixSelectTopKKernel finds the top k elements of a row in a few passes
+// over it, rather than by sorting it, which is faster when the row is large
+// compared to k. Each block handles one row.
+//
+// The elements are compared by their radix keys, whose unsigned order is the
+// order of the values. The key of the k-th largest element is found
+// kRadixBits at a time, from the most significant bits: each pass computes
+// the histogram of the next digit of the keys that match the digits found so
+// far, and picks the digit whose bin contains the k-th largest element. The
+// top k elements are then those whose key is greater than the k-th largest
+// one, and the first ones equal to it. They are written in index order, so
+// that the lower indices are preferred among equal values, like the other
+// kernels do.
+constexpr int kRadixBits = 8;
+constexpr int kRadixBins = 1 << kRadixBits;
+constexpr int kRadixSelectThreads = 512;
+
+template <typename T>
+__device__ EIGEN_STRONG_INLINE typename cub::Traits<T>::UnsignedBits RadixKey(
+    T value) {
+  typedef typename cub::Traits<T>::UnsignedBits UnsignedBits;
+  return cub::Traits<T>::TwiddleIn(*reinterpret_cast<UnsignedBits*>(&value));
+}
+
+template <typename T>
+__global__ void __launch_bounds__(kRadixSelectThreads)
+    RadixSelectTopKKernel(const T* input, int length, int k, T* output,
+                          int* indices) {
+  typedef typename cub::Traits<T>::UnsignedBits UnsignedBits;
+  typedef cub::BlockScan<int, kRadixSelectThreads> BlockScan;
+  __shared__ int histogram[kRadixBins];
+  __shared__ typename BlockScan::TempStorage scan_storage;
+  __shared__ UnsignedBits shared_prefix;
+  __shared__ int shared_remaining;
+
+  const int batch_index = blockIdx.x;
+  const T* batch_input = input + static_cast<int64>(batch_index) * length;
+  T* batch_output = output + static_cast<int64>(batch_index) * k;
+  int* batch_indices = indices + static_cast<int64>(batch_index) * k;
+
+  // The digits of the key of the k-th largest element found so far, and the
+  // rank of that element among the elements that match them.
+  UnsignedBits prefix = 0;
+  UnsignedBits prefix_mask = 0;
+  int remaining = k;
+  for (int shift = sizeof(UnsignedBits) * 8 - kRadixBits; shift >= 0;
+       shift -= kRadixBits) {
+    for (int i = threadIdx.x; i < kRadixBins; i += blockDim.x) {
+      histogram[i] = 0;
+    }
+    __syncthreads();
+    for (int i = threadIdx.x; i < length; i += blockDim.x) {
+      const UnsignedBits key = RadixKey(batch_input[i]);
+      if ((key & prefix_mask) == prefix) {
+        atomicAdd(&histogram[(key >> shift) & (kRadixBins - 1)], 1);
+      }
+    }
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      int digit = kRadixBins - 1;
+      while (histogram[digit] < remaining) {
+        remaining -= histogram[digit];
+        --digit;
+      }
+      shared_prefix = prefix | (static_cast<UnsignedBits>(digit) << shift);
+      shared_remaining = remaining;
+    }
+    __syncthreads();
+    prefix = shared_prefix;
+    remaining = shared_remaining;
+    prefix_mask |= static_cast<UnsignedBits>(kRadixBins - 1) << shift;
+  }
+
+  // Gathers the top k elements in index order. All the threads of the block
+  // take part in the scans, so they all run the same number of iterations.
+  int num_selected = 0;
+  int num_equal = 0;
+  for (int base = 0; base < length && num_selected < k; base += blockDim.x) {
+    const int i = base + threadIdx.x;
+    T value = T(0);
+    bool greater = false;
+    bool equal = false;
+    if (i < length) {
+      value = batch_input[i];
+      const UnsignedBits key = RadixKey(value);
+      greater = key > prefix;
+      equal = key == prefix;
+    }
+    int equal_rank;
+    int num_equal_in_chunk;
+    BlockScan(scan_storage)
+        .ExclusiveSum(equal ? 1 : 0, equal_rank, num_equal_in_chunk);
+    __syncthreads();
+    const bool selected =
+        greater || (equal && num_equal + equal_rank < remaining);
+    int position;
+    int num_selected_in_chunk;
+    BlockScan(scan_storage)
+        .ExclusiveSum(selected ? 1 : 0, position, num_selected_in_chunk);
+    __syncthreads();
+    if (selected) {
+      batch_output[num_selected + position] = value;
+      batch_indices[num_selected + position] = i;
+    }
+    num_selected += num_selected_in_chunk;
+    num_equal += num_equal_in_chunk;
+  }
+}
+
+// Sorts the top k elements of each row found by RadixSelectTopKKernel in
+// descending order. The sort is stable, so the lower indices stay first among
+// equal values.
+template <typename T>
+Status SortTopK(OpKernelContext* ctx, const T* input_values,
+                const int* input_indices, int num_rows, int k, T* values,
+                int* indices) {
+  const cudaStream_t& cu_stream = GetCudaStream(ctx);
+  cub::CountingInputIterator<int> counting_iter(0);
+  cub::TransformInputIterator<int, SegmentOffsetCreator,
+                              cub::CountingInputIterator<int>>
+      segment_offsets_t(counting_iter, SegmentOffsetCreator(k));
+
+  size_t temp_storage_bytes = 0;
+  auto err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      /* d_temp_storage */ nullptr,
+      /* temp_storage_bytes */ temp_storage_bytes,
+      /* d_keys_in */ input_values,
+      /* d_keys_out */ values,
+      /* d_values_in */ input_indices,
+      /* d_values_out */ indices,
+      /* num_items */ k * num_rows,
+      /* num_segments */ num_rows,
+      /* d_begin_offsets */ segment_offsets_t,
+      /* d_end_offsets */ segment_offsets_t + 1,
+      /* begin_bit */ 0,
+      /* end_bit */ sizeof(T) * 8,
+      /* stream */ cu_stream);
+  if (err != cudaSuccess) {
+    return errors::Internal(
+        "TopKOp: Could not launch "
+        "cub::DeviceSegmentedRadixSort::SortPairsDescending to calculate "
+        "temp_storage_bytes, status: ",
+        cudaGetErrorString(err));
+  }
+  Tensor temp_storage;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DT_INT8, TensorShape({static_cast<int64>(temp_storage_bytes)}),
+      &temp_storage));
+  err = cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      /* d_temp_storage */ temp_storage.flat<int8>().data(),
+      /* temp_storage_bytes */ temp_storage_bytes,
+      /* d_keys_in */ input_values,
+      /* d_keys_out */ values,
+      /* d_values_in */ input_indices,
+      /* d_values_out */ indices,
+      /* num_items */ k * num_rows,
+      /* num_segments */ num_rows,
+      /* d_begin_offsets */ segment_offsets_t,
+      /* d_end_offsets */ segment_offsets_t + 1,
+      /* begin_bit */ 0,
+      /* end_bit */ sizeof(T) * 8,
+      /* stream */ cu_stream);
+  if (err != cudaSuccess) {
+    return errors::Internal(
+        "TopKOp: Could not launch "
+        "cub::DeviceSegmentedRadixSort::SortPairsDescending to sort the top "
+        "k elements, temp_storage_bytes: ",
+        temp_storage_bytes, ", status: ", cudaGetErrorString(err));
+  }
+  return Status::OK();
+}
+
+template <typename T>
+Status LaunchRadixSelectKernel(OpKernelContext* ctx, const T* input,
+                               int num_rows, int num_cols, int k, bool sorted,
+                               typename TTypes<T, 2>::Tensor values,
+                               TTypes<int, 2>::Tensor indices) {
+  const cudaStream_t& cu_stream = GetCudaStream(ctx);
+  Tensor temp_values;
+  Tensor temp_indices;
+  T* selected_values_ptr = values.data();
+  int* selected_indices_ptr = indices.data();
+  if (sorted) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DT_INT32, TensorShape({num_rows, k}), &temp_indices));
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({num_rows, k}), &temp_values));
+    selected_values_ptr = temp_values.flat<T>().data();
+    selected_indices_ptr = temp_indices.flat<int32>().data();
+  }
+
+  RadixSelectTopKKernel<T><<<num_rows, kRadixSelectThreads, 0, cu_stream>>>(
+      input, num_cols, k, selected_values_ptr, selected_indices_ptr);
+  auto err = cudaGetLastError();
+  if (err != cudaSuccess) {
+    return errors::Internal("Could not launch RadixSelectTopKKernel: ",
+                            cudaGetErrorString(err), ".");
+  }
+  if (!sorted) {
+    return Status::OK();
+  }
+  return SortTopK(ctx, selected_values_ptr, selected_indices_ptr, num_rows, k,
+                  values.data(), indices.data());
+}
+
 }  // end namespace impl
 
 namespace functor {
@@ -539,10 +745,18 @@ struct TopKFunctor<GPUDevice, T> {
           const int64 num_cols, typename TTypes<T, 2>::Tensor values,
           typename TTypes<int, 2>::Tensor indices) {
     // For small k, use the heap implementation.  For larger k, use
-    // the in-place cub sort.  For k == num_cols, always use the
-    // in-place cub sort.  The thresholds for n and k were determined
-    // empirically.
-    if (num_cols <= 1000 || k == num_cols || k >= 100) {
+    // the radix select if the rows are large compared to k, and the
+    // in-place cub sort otherwise.  For small rows or k == num_cols,
+    // always use the in-place cub sort.  The thresholds for n and k
+    // were determined empirically, see BM_TopK in topk_op_test.cc.
+    if (num_cols <= 1000 || k == num_cols) {
+      return impl::LaunchSortKernel(context, input.data(), num_rows, num_cols,
+                                    k, values, indices);
+    } else if (k >= 100 && k <= num_cols / 4) {
+      return impl::LaunchRadixSelectKernel(context, input.data(), num_rows,
+                                           num_cols, k, sorted, values,
+                                           indices);
+    } else if (k >= 100) {
       return impl::LaunchSortKernel(context, input.data(), num_rows, num_cols,
                                     k, values, indices);
     } else {
@@ -0,0 +1,71 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+static Graph* TopK(int rows, int cols, int k) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({rows, cols}));
+  input.flat<float>().setRandom();
+  Tensor k_tensor(DT_INT32, TensorShape({}));
+  k_tensor.scalar<int32>()() = k;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "TopKV2")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::HostConstant(g, k_tensor))
+                  .Attr("sorted", true)
+                  .Finalize(g, &node));
+  return g;
+}
+
+// The GPU kernel picks a heap for small k, a radix select for larger k and
+// rows, and a sort otherwise: the cases below cover the crossover points
+// between them.
+#define BM_TopKDev(ROWS, COLS, K, DEVICE)                             \
+  static void BM_TopK##_##ROWS##_##COLS##_##K##_##DEVICE(int iters) { \
+    testing::UseRealTime();                                           \
+    testing::ItemsProcessed(static_cast<int64>(iters) * ROWS * COLS); \
+    test::Benchmark(#DEVICE, TopK(ROWS, COLS, K)).Run(iters);         \
+  }                                                                   \
+  BENCHMARK(BM_TopK##_##ROWS##_##COLS##_##K##_##DEVICE);
+
+#define BM_TopK(ROWS, COLS, K)    \
+  BM_TopKDev(ROWS, COLS, K, cpu); \
+  BM_TopKDev(ROWS, COLS, K, gpu);
+
+BM_TopK(128, 1000, 10);
+BM_TopK(128, 1000, 100);
+BM_TopK(128, 10000, 10);
+BM_TopK(128, 10000, 99);
+BM_TopK(128, 10000, 100);
+BM_TopK(128, 10000, 1000);
+BM_TopK(128, 10000, 2500);
+BM_TopK(128, 10000, 2501);
+BM_TopK(16, 100000, 10);
+BM_TopK(16, 100000, 100);
+BM_TopK(16, 100000, 1000);
+BM_TopK(16, 100000, 10000);
+BM_TopK(1, 1000000, 10);
+BM_TopK(1, 1000000, 100);
+BM_TopK(1, 1000000, 10000);
+
+}  // end namespace tensorflow
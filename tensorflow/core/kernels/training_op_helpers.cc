@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
 
+#include <algorithm>
+
 namespace tensorflow {
 
 mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input) {
@@ -51,20 +53,16 @@ std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
     return locks;
   }
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
   for (auto input : input_ids) {
-    mutex* mutex = GetTrainingVariableMutex(ctx, input);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
-      mutexes.push_back(mutex);
-    }
+    mutexes.push_back(GetTrainingVariableMutex(ctx, input));
   }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
+  // Only lock each mutex once if duplicates exist.  The fused apply ops pass
+  // the inputs of many variables, so this avoids comparing all pairs.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
 
-  for (auto input : acquire_order) {
-    mutex* mu = GetTrainingVariableMutex(ctx, input);
+  locks.reserve(mutexes.size());
+  for (mutex* mu : mutexes) {
     if (mu != nullptr) {
       locks.emplace_back(*mu);
     }
@@ -18,10 +18,13 @@ limitations under the License.
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
 
 #include <algorithm>
+#include <numeric>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/sparse_update_combiner.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/kernels/variable_ops.h"
@@ -418,6 +421,42 @@ struct ApplyPowerSign<CPUDevice, T> {
   }
 };
 
+template <typename T>
+struct FusedApplyAdam<CPUDevice, T> {
+  void operator()(const CPUDevice& d,
+                  const std::vector<FusedApplyAdamArgs<T>>& args,
+                  bool use_nesterov) {
+    for (const FusedApplyAdamArgs<T>& arg : args) {
+      typedef typename TTypes<T>::ConstScalar Scalar;
+      ApplyAdam<CPUDevice, T>()(
+          d, typename TTypes<T>::Flat(arg.variables[0], arg.size),
+          typename TTypes<T>::Flat(arg.variables[1], arg.size),
+          typename TTypes<T>::Flat(arg.variables[2], arg.size),
+          Scalar(arg.scalars[0]), Scalar(arg.scalars[1]),
+          Scalar(arg.scalars[2]), Scalar(arg.scalars[3]),
+          Scalar(arg.scalars[4]), Scalar(arg.scalars[5]),
+          typename TTypes<T>::ConstFlat(arg.grad, arg.size), use_nesterov);
+    }
+  }
+};
+
+template <typename T>
+struct FusedApplyMomentum<CPUDevice, T> {
+  void operator()(const CPUDevice& d,
+                  const std::vector<FusedApplyMomentumArgs<T>>& args,
+                  bool use_nesterov) {
+    for (const FusedApplyMomentumArgs<T>& arg : args) {
+      typedef typename TTypes<T>::ConstScalar Scalar;
+      ApplyMomentum<CPUDevice, T>()(
+          d, typename TTypes<T>::Flat(arg.variables[0], arg.size),
+          typename TTypes<T>::Flat(arg.variables[1], arg.size),
+          Scalar(arg.scalars[0]),
+          typename TTypes<T>::ConstFlat(arg.grad, arg.size),
+          Scalar(arg.scalars[1]), use_nesterov);
+    }
+  }
+};
+
 }  // namespace functor
 
 template <typename Device, typename T>
@@ -1272,33 +1311,13 @@ class SparseApplyAdagradOp : public OpKernel {
   explicit SparseApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    // Merging the gradients of duplicate indices changes the accumulator
+    // update, hence only the relaxed level applies to this op.
+    coalesce_ = ctx->input_type(0) == DT_RESOURCE &&
+                GetSparseUpdateCoalescing() >= SparseUpdateCoalescing::kRelaxed;
   }
 
-  void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
-    auto locks =
-        MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
-    Tensor var;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
-                            ctx, 0, use_exclusive_lock_, true, &var));
-    Tensor accum;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
-                            ctx, 1, use_exclusive_lock_, true, &accum));
-    OP_REQUIRES(
-        ctx, var.IsInitialized(),
-        errors::FailedPrecondition(
-            "Attempting to use uninitialized variables: ", requested_input(0)));
-    OP_REQUIRES(
-        ctx, accum.IsInitialized(),
-        errors::FailedPrecondition(
-            "Attempting to use uninitialized variables: ", requested_input(1)));
-    OP_REQUIRES(
-        ctx, var.shape().IsSameSize(accum.shape()),
-        errors::InvalidArgument("var and accum do not have the same shape",
-                                var.shape().DebugString(), " ",
-                                accum.shape().DebugString()));
-    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(var.shape()),
-                errors::InvalidArgument("var must be at least 1 dimensional"));
-
+  void Compute(OpKernelContext* ctx) override {
     const Tensor& lr = ctx->input(2);
     OP_REQUIRES(ctx, IsLegacyScalar(lr.shape()),
                 errors::InvalidArgument("lr is not a scalar: ",
@@ -1308,22 +1327,80 @@ class SparseApplyAdagradOp : public OpKernel {
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
 
+    if (coalesce_ && indices.dim_size(0) > 0 &&
+        TensorShapeUtils::IsVectorOrHigher(grad.shape()) &&
+        grad.dim_size(0) == indices.dim_size(0)) {
+      SparseUpdateCombiner<T, Tindex>* combiner = nullptr;
+      const string kernel_type =
+          update_slots_ ? type_string()
+                        : strings::StrCat(type_string(), "/no_update_slots");
+      OP_REQUIRES_OK(ctx, LookupOrCreateSparseUpdateCombiner(
+                              ctx, kernel_type, HandleFromInput(ctx, 0),
+                              &HandleFromInput(ctx, 1), &combiner));
+      core::ScopedUnref unref_combiner(combiner);
+      OP_REQUIRES_OK(
+          ctx, combiner->Apply({lr.scalar<T>()()}, indices, grad,
+                               [this, ctx](const std::vector<T>& params,
+                                           const Tensor& indices,
+                                           const Tensor& grad) {
+                                 return ApplySparse(ctx, params[0], grad,
+                                                    indices);
+                               }));
+      return;
+    }
+
+    OP_REQUIRES_OK(ctx, ApplySparse(ctx, lr.scalar<T>()(), grad, indices));
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  // Applies `grad` at `indices` to the variable and accumulator inputs of
+  // `ctx`.
+  Status ApplySparse(OpKernelContext* ctx, T lr_scalar, const Tensor& grad,
+                     const Tensor& indices) NO_THREAD_SAFETY_ANALYSIS {
+    auto locks =
+        MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
+    Tensor var;
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        ctx, 0, use_exclusive_lock_, true, &var));
+    Tensor accum;
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        ctx, 1, use_exclusive_lock_, true, &accum));
+    if (!var.IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ", requested_input(0));
+    }
+    if (!accum.IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ", requested_input(1));
+    }
+    if (!var.shape().IsSameSize(accum.shape())) {
+      return errors::InvalidArgument("var and accum do not have the same shape",
+                                     var.shape().DebugString(), " ",
+                                     accum.shape().DebugString());
+    }
+    if (!TensorShapeUtils::IsVectorOrHigher(var.shape())) {
+      return errors::InvalidArgument("var must be at least 1 dimensional");
+    }
+
     int64 inner_dim = 1;
     for (int d = 1; d < var.dims(); d++) {
-      OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
-                  errors::InvalidArgument(strings::StrCat(
-                      "var and grad must match in dimension ", d)));
+      if (var.dim_size(d) != grad.dim_size(d)) {
+        return errors::InvalidArgument(
+            strings::StrCat("var and grad must match in dimension ", d));
+      }
       inner_dim *= grad.dim_size(d);
     }
     const Tindex N = indices.dim_size(0);
-    OP_REQUIRES(
-        ctx, grad.dim_size(0) == N,
-        errors::InvalidArgument(
-            "grad must be the same size as indices in the first dimension."));
+    if (grad.dim_size(0) != N) {
+      return errors::InvalidArgument(
+          "grad must be the same size as indices in the first dimension.");
+    }
 
-    OP_REQUIRES(ctx, inner_dim > 0,
-                errors::InvalidArgument(
-                    "Inner dimension should be greater than zero."));
+    if (inner_dim <= 0) {
+      return errors::InvalidArgument(
+          "Inner dimension should be greater than zero.");
+    }
 
     if (N > 0) {
       if (inner_dim > 1) {
@@ -1332,16 +1409,16 @@ class SparseApplyAdagradOp : public OpKernel {
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto grad_flat = grad.flat_outer_dims<T>();
-        T lr_scalar = lr.scalar<T>()();
 
         // Note(yonghui): It might be worth multi-threading square() and
         // rsqrt().
         for (Tindex i = 0; i < N; i++) {
           const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+          if (!FastBoundsCheck(index, first_dim_size)) {
+            return errors::InvalidArgument(
+                strings::StrCat("Index ", index, " at offset ", i,
+                                " in indices is out of range"));
+          }
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
@@ -1355,15 +1432,15 @@ class SparseApplyAdagradOp : public OpKernel {
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto grad_flat = grad.flat<T>();
-        T lr_scalar = lr.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
         for (Tindex i = 0; i < N; i++) {
           const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+          if (!FastBoundsCheck(index, first_dim_size)) {
+            return errors::InvalidArgument(
+                strings::StrCat("Index ", index, " at offset ", i,
+                                " in indices is out of range"));
+          }
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           if (update_slots_) {
@@ -1373,13 +1450,12 @@ class SparseApplyAdagradOp : public OpKernel {
         }
       }
     }
-
-    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+    return Status::OK();
   }
 
- private:
   bool use_exclusive_lock_;
   bool update_slots_;
+  bool coalesce_;
 };
 
 #define REGISTER_KERNELS(T, Tindices)                                \
@@ -3664,4 +3740,132 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Applies the update of a single-variable op to `N` resource variables at
+// once.  Each input of the single-variable op becomes a list of `N` inputs:
+// first the lists of the variable and its slots, then the lists of the scalar
+// hyperparameters, with the list of the gradients at `kGradList`.
+template <typename Device, typename T, typename Args, typename Functor,
+          int kGradList>
+class FusedResourceApplyOp : public OpKernel {
+ public:
+  explicit FusedResourceApplyOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int num_variables = Args::kVariables * n_;
+    std::vector<int> variable_inputs(num_variables);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> variables(num_variables);
+    std::vector<Args> args(n_);
+    for (int i = 0; i < n_; ++i) {
+      Args& arg = args[i];
+      const Tensor& var = variables[i];
+      int num_scalars = 0;
+      for (int list = 0; list < Args::kVariables + Args::kScalars + 1;
+           ++list) {
+        const int input = list * n_ + i;
+        if (list < Args::kVariables) {
+          Tensor* variable = &variables[input];
+          OP_REQUIRES_OK(ctx,
+                         GetInputTensorFromVariable<Device, T>(
+                             ctx, input, use_exclusive_lock_, false, variable));
+          OP_REQUIRES(ctx, variable->IsInitialized(),
+                      errors::FailedPrecondition(
+                          "Attempting to use uninitialized variables: ",
+                          requested_input(input)));
+          OP_REQUIRES(ctx, var.shape().IsSameSize(variable->shape()),
+                      errors::InvalidArgument(
+                          requested_input(input),
+                          " does not have the shape of the variable ",
+                          requested_input(i), ": ",
+                          variable->shape().DebugString(), " vs. ",
+                          var.shape().DebugString()));
+          arg.variables[list] = variable->flat<T>().data();
+        } else if (list == kGradList) {
+          const Tensor& grad = ctx->input(input);
+          OP_REQUIRES(ctx, var.shape().IsSameSize(grad.shape()),
+                      errors::InvalidArgument(
+                          "var and grad do not have the same shape",
+                          var.shape().DebugString(), " ",
+                          grad.shape().DebugString()));
+          arg.grad = grad.flat<T>().data();
+        } else {
+          const Tensor& scalar = ctx->input(input);
+          OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                      errors::InvalidArgument(requested_input(input),
+                                              " is not a scalar: ",
+                                              scalar.shape().DebugString()));
+          arg.scalars[num_scalars++] = scalar.flat<T>().data();
+        }
+      }
+      arg.size = var.NumElements();
+    }
+
+    Functor()(ctx->template eigen_device<Device>(), args, use_nesterov_);
+  }
+
+ private:
+  int n_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                                               \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_FusedResourceApplyAdam")                                        \
+          .Device(DEVICE_##D)                                                \
+          .HostMemory("var")                                                 \
+          .HostMemory("m")                                                   \
+          .HostMemory("v")                                                   \
+          .TypeConstraint<T>("T"),                                           \
+      FusedResourceApplyOp<D##Device, T, functor::FusedApplyAdamArgs<T>,     \
+                           functor::FusedApplyAdam<D##Device, T>, 9>);       \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_FusedResourceApplyMomentum")                                    \
+          .Device(DEVICE_##D)                                                \
+          .HostMemory("var")                                                 \
+          .HostMemory("accum")                                               \
+          .TypeConstraint<T>("T"),                                           \
+      FusedResourceApplyOp<D##Device, T, functor::FusedApplyMomentumArgs<T>, \
+                           functor::FusedApplyMomentum<D##Device, T>, 3>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                               \
+  template <>                                                             \
+  void FusedApplyAdam<GPUDevice, T>::operator()(                          \
+      const GPUDevice& d, const std::vector<FusedApplyAdamArgs<T>>& args, \
+      bool use_nesterov);                                                 \
+  extern template struct FusedApplyAdam<GPUDevice, T>;                    \
+  template <>                                                             \
+  void FusedApplyMomentum<GPUDevice, T>::operator()(                      \
+      const GPUDevice& d,                                                 \
+      const std::vector<FusedApplyMomentumArgs<T>>& args,                 \
+      bool use_nesterov);                                                 \
+  extern template struct FusedApplyMomentum<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 }  // namespace tensorflow
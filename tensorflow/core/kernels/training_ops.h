@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_TRAINING_OPS_H_
 #define TENSORFLOW_KERNELS_TRAINING_OPS_H_
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
@@ -196,6 +198,45 @@ struct ApplyPowerSign {
                   typename TTypes<T>::ConstFlat grad);
 };
 
+// The fused apply ops update many variables at once, so that a GPU updates
+// them all in a few kernel launches rather than in one launch per variable.
+// FusedApplyArgs points to the flattened tensors of one variable: the
+// variable and its slots, in the order of the inputs of the single-variable
+// op, its scalar hyperparameters and its gradient.  All of them live in the
+// memory of the device.
+template <typename T, int kNumVariables, int kNumScalars>
+struct FusedApplyArgs {
+  static constexpr int kVariables = kNumVariables;
+  static constexpr int kScalars = kNumScalars;
+
+  T* variables[kNumVariables];
+  const T* scalars[kNumScalars];
+  const T* grad;
+  int64 size;
+};
+
+// {var, m, v}, {beta1_power, beta2_power, lr, beta1, beta2, epsilon}.
+template <typename T>
+using FusedApplyAdamArgs = FusedApplyArgs<T, 3, 6>;
+
+// {var, accum}, {lr, momentum}.
+template <typename T>
+using FusedApplyMomentumArgs = FusedApplyArgs<T, 2, 2>;
+
+template <typename Device, typename T>
+struct FusedApplyAdam {
+  void operator()(const Device& d,
+                  const std::vector<FusedApplyAdamArgs<T>>& args,
+                  bool use_nesterov);
+};
+
+template <typename Device, typename T>
+struct FusedApplyMomentum {
+  void operator()(const Device& d,
+                  const std::vector<FusedApplyMomentumArgs<T>>& args,
+                  bool use_nesterov);
+};
+
 }  // end namespace functor
 }  // end namespace tensorflow
 
@@ -0,0 +1,156 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedResourceApplyOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, int num_variables, int num_inputs, int n) {
+    NodeDefBuilder builder("fused_apply", op);
+    for (int i = 0; i < num_inputs; ++i) {
+      builder.Input(FakeInput(n, i < num_variables ? DT_RESOURCE : DT_FLOAT));
+    }
+    TF_ASSERT_OK(builder.Attr("N", n)
+                     .Attr("T", DT_FLOAT)
+                     .Attr("use_nesterov", false)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddVariable(const string& name, const std::vector<float>& values) {
+    Var* var = new Var(DT_FLOAT);
+    *var->tensor() = test::AsTensor<float>(values);
+    var->is_initialized = true;
+    AddResourceInput("vars", name, var);
+  }
+
+  void AddScalar(float value) {
+    AddInputFromArray<float>(TensorShape({}), {value});
+  }
+
+  void AddGrad(const std::vector<float>& values) {
+    AddInputFromArray<float>(TensorShape({static_cast<int64>(values.size())}),
+                             values);
+  }
+
+  Tensor GetVariable(const string& name) {
+    Var* var;
+    TF_CHECK_OK(device_->resource_manager()->Lookup("vars", name, &var));
+    core::ScopedUnref unref(var);
+    return *var->tensor();
+  }
+};
+
+TEST_F(FusedResourceApplyOpTest, Momentum) {
+  MakeOp("_FusedResourceApplyMomentum", 2, 5, 2);
+  AddVariable("var_a", {1, 2});
+  AddVariable("var_b", {3});
+  AddVariable("accum_a", {0.5, 0.5});
+  AddVariable("accum_b", {1});
+  AddScalar(0.1);  // lr
+  AddScalar(0.5);
+  AddGrad({1, 2});
+  AddGrad({-2});
+  AddScalar(0.9);  // momentum
+  AddScalar(0.5);
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorNear<float>(test::AsTensor<float>({1.45, 2.45}),
+                                GetVariable("accum_a"), 1e-6);
+  test::ExpectTensorNear<float>(test::AsTensor<float>({0.855, 1.755}),
+                                GetVariable("var_a"), 1e-6);
+  test::ExpectTensorNear<float>(test::AsTensor<float>({-1.5}),
+                                GetVariable("accum_b"), 1e-6);
+  test::ExpectTensorNear<float>(test::AsTensor<float>({3.75}),
+                                GetVariable("var_b"), 1e-6);
+}
+
+TEST_F(FusedResourceApplyOpTest, Adam) {
+  MakeOp("_FusedResourceApplyAdam", 3, 10, 2);
+  const std::vector<std::vector<float>> vars = {{1, -1}, {2}};
+  const std::vector<std::vector<float>> grads = {{0.5, 0.25}, {-1}};
+  const std::vector<float> lrs = {0.1, 0.01};
+  const float beta1_power = 0.9, beta2_power = 0.999;
+  const float beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+  AddVariable("var_a", vars[0]);
+  AddVariable("var_b", vars[1]);
+  AddVariable("m_a", {0, 0});
+  AddVariable("m_b", {0});
+  AddVariable("v_a", {0, 0});
+  AddVariable("v_b", {0});
+  for (float value : {beta1_power, beta2_power}) {
+    AddScalar(value);
+    AddScalar(value);
+  }
+  AddScalar(lrs[0]);
+  AddScalar(lrs[1]);
+  for (float value : {beta1, beta2, epsilon}) {
+    AddScalar(value);
+    AddScalar(value);
+  }
+  AddGrad(grads[0]);
+  AddGrad(grads[1]);
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int i = 0; i < 2; ++i) {
+    const string suffix = i == 0 ? "_a" : "_b";
+    const float alpha =
+        lrs[i] * std::sqrt(1 - beta2_power) / (1 - beta1_power);
+    std::vector<float> m, v, var;
+    for (size_t j = 0; j < vars[i].size(); ++j) {
+      const float g = grads[i][j];
+      m.push_back((1 - beta1) * g);
+      v.push_back((1 - beta2) * g * g);
+      var.push_back(vars[i][j] -
+                    alpha * m.back() / (std::sqrt(v.back()) + epsilon));
+    }
+    test::ExpectTensorNear<float>(test::AsTensor<float>(m),
+                                  GetVariable("m" + suffix), 1e-6);
+    test::ExpectTensorNear<float>(test::AsTensor<float>(v),
+                                  GetVariable("v" + suffix), 1e-6);
+    test::ExpectTensorNear<float>(test::AsTensor<float>(var),
+                                  GetVariable("var" + suffix), 1e-6);
+  }
+}
+
+TEST_F(FusedResourceApplyOpTest, ChecksGradientShapes) {
+  MakeOp("_FusedResourceApplyMomentum", 2, 5, 2);
+  AddVariable("var_a", {1, 2});
+  AddVariable("var_b", {3});
+  AddVariable("accum_a", {0, 0});
+  AddVariable("accum_b", {0});
+  AddScalar(0.1);
+  AddScalar(0.1);
+  AddGrad({1, 2});
+  AddGrad({1, 2});
+  AddScalar(0.9);
+  AddScalar(0.9);
+  EXPECT_EQ(error::INVALID_ARGUMENT, RunOpKernel().code());
+}
+
+}  // namespace
+}  // namespace tensorflow
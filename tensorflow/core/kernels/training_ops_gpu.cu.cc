@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/training_ops.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
@@ -284,6 +285,180 @@ struct ApplyPowerSign<GPUDevice, T> {
   }
 };
 
+namespace {
+
+// The fused apply kernels split the variables into chunks of kChunkSize
+// elements, and each block of a launch updates one chunk.
+constexpr int64 kChunkSize = 65536;
+constexpr int kThreadsPerBlock = 512;
+
+// The variables that one launch of FusedApplyKernel updates.  The table is
+// passed as a kernel argument, which is limited to 4KB, so a launch covers at
+// most kMaxTensors variables and kMaxBlocks chunks of them.
+template <typename T, int kNumVariables, int kNumScalars>
+struct FusedApplyLaunch {
+  static constexpr int kMaxTensors = 24;
+  static constexpr int kMaxBlocks = 320;
+
+  T* variables[kNumVariables][kMaxTensors];
+  const T* scalars[kNumScalars][kMaxTensors];
+  const T* grads[kMaxTensors];
+  int64 sizes[kMaxTensors];
+  // The variable and its chunk that each block updates.
+  uint8 block_tensors[kMaxBlocks];
+  int32 block_chunks[kMaxBlocks];
+};
+
+// Updates of half precision variables are computed in float.
+template <typename T>
+struct FusedApplyComputeType {
+  typedef T type;
+};
+
+template <>
+struct FusedApplyComputeType<Eigen::half> {
+  typedef float type;
+};
+
+template <typename Launch, typename Update>
+__global__ void FusedApplyKernel(const Launch launch, const Update update) {
+  const int tensor = launch.block_tensors[blockIdx.x];
+  const int64 begin = launch.block_chunks[blockIdx.x] * kChunkSize;
+  const int64 size = launch.sizes[tensor];
+  const int64 end = begin + kChunkSize < size ? begin + kChunkSize : size;
+  update(launch, tensor, begin, end);
+}
+
+template <typename T>
+struct AdamUpdate {
+  template <typename Launch>
+  __device__ void operator()(const Launch& launch, int tensor, int64 begin,
+                             int64 end) const {
+    typedef typename FusedApplyComputeType<T>::type U;
+    T* var = launch.variables[0][tensor];
+    T* m = launch.variables[1][tensor];
+    T* v = launch.variables[2][tensor];
+    const T* grad = launch.grads[tensor];
+    const U beta1_power = static_cast<U>(*launch.scalars[0][tensor]);
+    const U beta2_power = static_cast<U>(*launch.scalars[1][tensor]);
+    const U lr = static_cast<U>(*launch.scalars[2][tensor]);
+    const U beta1 = static_cast<U>(*launch.scalars[3][tensor]);
+    const U beta2 = static_cast<U>(*launch.scalars[4][tensor]);
+    const U epsilon = static_cast<U>(*launch.scalars[5][tensor]);
+    const U one = static_cast<U>(1);
+    const U alpha =
+        lr * Eigen::numext::sqrt(one - beta2_power) / (one - beta1_power);
+    for (int64 i = begin + threadIdx.x; i < end; i += blockDim.x) {
+      const U g = static_cast<U>(grad[i]);
+      U m_i = static_cast<U>(m[i]);
+      U v_i = static_cast<U>(v[i]);
+      m_i += (one - beta1) * (g - m_i);
+      v_i += (one - beta2) * (g * g - v_i);
+      m[i] = static_cast<T>(m_i);
+      v[i] = static_cast<T>(v_i);
+      const U step = use_nesterov ? g * (one - beta1) + beta1 * m_i : m_i;
+      const U denominator = Eigen::numext::sqrt(v_i) + epsilon;
+      var[i] = static_cast<T>(static_cast<U>(var[i]) -
+                              alpha * step / denominator);
+    }
+  }
+
+  bool use_nesterov;
+};
+
+template <typename T>
+struct MomentumUpdate {
+  template <typename Launch>
+  __device__ void operator()(const Launch& launch, int tensor, int64 begin,
+                             int64 end) const {
+    typedef typename FusedApplyComputeType<T>::type U;
+    T* var = launch.variables[0][tensor];
+    T* accum = launch.variables[1][tensor];
+    const T* grad = launch.grads[tensor];
+    const U lr = static_cast<U>(*launch.scalars[0][tensor]);
+    const U momentum = static_cast<U>(*launch.scalars[1][tensor]);
+    for (int64 i = begin + threadIdx.x; i < end; i += blockDim.x) {
+      const U g = static_cast<U>(grad[i]);
+      const U accum_i = static_cast<U>(accum[i]) * momentum + g;
+      accum[i] = static_cast<T>(accum_i);
+      const U step = use_nesterov ? g * lr + accum_i * momentum * lr
+                                  : accum_i * lr;
+      var[i] = static_cast<T>(static_cast<U>(var[i]) - step);
+    }
+  }
+
+  bool use_nesterov;
+};
+
+// Updates all variables of `args` in as few launches of FusedApplyKernel as
+// the size of its argument allows.
+template <typename T, typename Args, typename Update>
+void LaunchFusedApply(const GPUDevice& d, const std::vector<Args>& args,
+                      const Update& update) {
+  typedef FusedApplyLaunch<T, Args::kVariables, Args::kScalars> Launch;
+  static_assert(sizeof(Launch) + sizeof(Update) <= 4096,
+                "Kernel arguments exceed 4KB");
+  Launch launch;
+  int num_tensors = 0;
+  int num_blocks = 0;
+  auto flush = [&]() {
+    if (num_blocks > 0) {
+      FusedApplyKernel<Launch, Update>
+          <<<num_blocks, kThreadsPerBlock, 0, d.stream()>>>(launch, update);
+    }
+    num_tensors = 0;
+    num_blocks = 0;
+  };
+
+  for (const Args& arg : args) {
+    const int64 num_chunks = (arg.size + kChunkSize - 1) / kChunkSize;
+    // The slot of the variable in the current launch, if any.  A variable
+    // whose chunks span several launches takes a slot in each.
+    int slot = -1;
+    for (int64 chunk = 0; chunk < num_chunks; ++chunk) {
+      if (slot < 0) {
+        slot = num_tensors++;
+        for (int i = 0; i < Args::kVariables; ++i) {
+          launch.variables[i][slot] = arg.variables[i];
+        }
+        for (int i = 0; i < Args::kScalars; ++i) {
+          launch.scalars[i][slot] = arg.scalars[i];
+        }
+        launch.grads[slot] = arg.grad;
+        launch.sizes[slot] = arg.size;
+      }
+      launch.block_tensors[num_blocks] = slot;
+      launch.block_chunks[num_blocks] = chunk;
+      if (++num_blocks == Launch::kMaxBlocks) {
+        flush();
+        slot = -1;
+      }
+    }
+    if (num_tensors == Launch::kMaxTensors) flush();
+  }
+  flush();
+}
+
+}  // namespace
+
+template <typename T>
+struct FusedApplyAdam<GPUDevice, T> {
+  void operator()(const GPUDevice& d,
+                  const std::vector<FusedApplyAdamArgs<T>>& args,
+                  bool use_nesterov) {
+    LaunchFusedApply<T>(d, args, AdamUpdate<T>{use_nesterov});
+  }
+};
+
+template <typename T>
+struct FusedApplyMomentum<GPUDevice, T> {
+  void operator()(const GPUDevice& d,
+                  const std::vector<FusedApplyMomentumArgs<T>>& args,
+                  bool use_nesterov) {
+    LaunchFusedApply<T>(d, args, MomentumUpdate<T>{use_nesterov});
+  }
+};
+
 }  // namespace functor
 
 template struct functor::ApplyGradientDescent<GPUDevice, Eigen::half>;
@@ -326,6 +501,14 @@ template struct functor::ApplyPowerSign<GPUDevice, Eigen::half>;
 template struct functor::ApplyPowerSign<GPUDevice, float>;
 template struct functor::ApplyPowerSign<GPUDevice, double>;
 
+template struct functor::FusedApplyAdam<GPUDevice, Eigen::half>;
+template struct functor::FusedApplyAdam<GPUDevice, float>;
+template struct functor::FusedApplyAdam<GPUDevice, double>;
+
+template struct functor::FusedApplyMomentum<GPUDevice, Eigen::half>;
+template struct functor::FusedApplyMomentum<GPUDevice, float>;
+template struct functor::FusedApplyMomentum<GPUDevice, double>;
+
 }  // end namespace tensorflow
 
 #endif  // GOOGLE_CUDA
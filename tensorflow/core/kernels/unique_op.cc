@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -24,11 +27,257 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+// Unique of a vector of integers, which partitions the elements by hash
+// across the threads of the device. Each partition is deduplicated by a
+// single thread with an open addressing table, and the unique elements are
+// then numbered in the order of their first occurrence, as in the serial
+// implementation.
+template <typename T, typename TIndex, bool = std::is_integral<T>::value>
+struct PartitionedUnique {
+  static constexpr bool kSupported = false;
+
+  static Status Compute(OpKernelContext* context, const Tensor& input,
+                        int64 axis, typename TTypes<TIndex>::Vec idx,
+                        bool with_counts) {
+    return errors::Unimplemented("Unique of ", DataTypeString(input.dtype()),
+                                 " by hash partitions");
+  }
+};
+
+template <typename T, typename TIndex>
+struct PartitionedUnique<T, TIndex, true> {
+  static constexpr bool kSupported = true;
+
+  static Status Compute(OpKernelContext* context, const Tensor& input,
+                        int64 axis, typename TTypes<TIndex>::Vec idx,
+                        bool with_counts) {
+    auto Tin = input.flat<T>();
+    // The input has less than 2^31 elements.
+    const int32 N = static_cast<int32>(Tin.size());
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    int num_partitions = 1;
+    while (worker_threads->num_threads > 1 &&
+           num_partitions < 4 * worker_threads->num_threads &&
+           num_partitions < kMaxPartitions &&
+           N / (2 * num_partitions) >= kMinPartitionSize) {
+      num_partitions *= 2;
+    }
+    auto partition_of = [num_partitions](uint64 hash) {
+      return static_cast<uint8>(((hash >> 32) * num_partitions) >> 32);
+    };
+    if (num_partitions == 1) {
+      std::vector<int32> ids(N);
+      std::vector<T> uniques;
+      std::vector<TIndex> counts;
+      Deduplicate(Tin, nullptr, N, ids.data(), nullptr, &uniques,
+                  with_counts ? &counts : nullptr);
+      for (int32 i = 0; i < N; ++i) {
+        idx(i) = ids[i];
+      }
+      T* output_data;
+      TIndex* count_data;
+      TF_RETURN_IF_ERROR(AllocateOutputs(context, input, axis, uniques.size(),
+                                         with_counts, &output_data,
+                                         &count_data));
+      std::copy(uniques.begin(), uniques.end(), output_data);
+      if (with_counts) {
+        std::copy(counts.begin(), counts.end(), count_data);
+      }
+      return Status::OK();
+    }
+    // The input is split into as many chunks as there are partitions.
+    const int num_chunks = num_partitions;
+    auto chunk_start = [N, num_chunks](int64 chunk) {
+      return static_cast<int32>(chunk * N / num_chunks);
+    };
+    auto shard_chunks = [&](int64 cost_per_element,
+                            const std::function<void(int64)>& work) {
+      Shard(worker_threads->num_threads, worker_threads->workers, num_chunks,
+            cost_per_element * N / num_chunks, [&](int64 begin, int64 end) {
+              for (int64 chunk = begin; chunk < end; ++chunk) {
+                work(chunk);
+              }
+            });
+    };
+
+    // Groups the positions of the elements by partition, in order.
+    std::vector<uint8> partitions(N);
+    std::vector<int32> offsets(num_chunks * num_partitions, 0);
+    shard_chunks(10, [&](int64 chunk) {
+      int32* chunk_counts = &offsets[chunk * num_partitions];
+      for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        partitions[i] = partition_of(Hash(Tin(i)));
+        ++chunk_counts[partitions[i]];
+      }
+    });
+    std::vector<int32> partition_starts(num_partitions + 1);
+    int32 next_offset = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_starts[p] = next_offset;
+      for (int chunk = 0; chunk < num_chunks; ++chunk) {
+        const int32 count = offsets[chunk * num_partitions + p];
+        offsets[chunk * num_partitions + p] = next_offset;
+        next_offset += count;
+      }
+    }
+    partition_starts[num_partitions] = N;
+    std::vector<int32> positions(N);
+    shard_chunks(5, [&](int64 chunk) {
+      int32* chunk_offsets = &offsets[chunk * num_partitions];
+      for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        positions[chunk_offsets[partitions[i]]++] = i;
+      }
+    });
+
+    // Deduplicates each partition, numbering its unique elements in order.
+    std::vector<int32> local_ids(N);
+    std::vector<uint8> is_first(N, 0);
+    std::vector<std::vector<T>> uniques(num_partitions);
+    std::vector<std::vector<TIndex>> counts(num_partitions);
+    Shard(worker_threads->num_threads, worker_threads->workers, num_partitions,
+          50 * N / num_partitions, [&](int64 begin, int64 end) {
+            for (int64 p = begin; p < end; ++p) {
+              Deduplicate(Tin, positions.data() + partition_starts[p],
+                          partition_starts[p + 1] - partition_starts[p],
+                          local_ids.data(), is_first.data(), &uniques[p],
+                          with_counts ? &counts[p] : nullptr);
+            }
+          });
+
+    // Numbers the unique elements by the position of their first occurrence.
+    std::vector<int32> chunk_ranks(num_chunks + 1, 0);
+    shard_chunks(1, [&](int64 chunk) {
+      for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        chunk_ranks[chunk + 1] += is_first[i];
+      }
+    });
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      chunk_ranks[chunk + 1] += chunk_ranks[chunk];
+    }
+    std::vector<std::vector<TIndex>> ids(num_partitions);
+    for (int p = 0; p < num_partitions; ++p) {
+      ids[p].resize(uniques[p].size());
+    }
+    shard_chunks(2, [&](int64 chunk) {
+      TIndex rank = chunk_ranks[chunk];
+      for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        if (is_first[i]) {
+          ids[partitions[i]][local_ids[i]] = rank++;
+        }
+      }
+    });
+    shard_chunks(3, [&](int64 chunk) {
+      for (int32 i = chunk_start(chunk); i < chunk_start(chunk + 1); ++i) {
+        idx(i) = ids[partitions[i]][local_ids[i]];
+      }
+    });
+
+    const int64 uniq_size = chunk_ranks[num_chunks];
+    T* output_data;
+    TIndex* count_data;
+    TF_RETURN_IF_ERROR(AllocateOutputs(context, input, axis, uniq_size,
+                                       with_counts, &output_data,
+                                       &count_data));
+    Shard(worker_threads->num_threads, worker_threads->workers, num_partitions,
+          2 * uniq_size / num_partitions, [&](int64 begin, int64 end) {
+            for (int64 p = begin; p < end; ++p) {
+              for (size_t u = 0; u < uniques[p].size(); ++u) {
+                output_data[ids[p][u]] = uniques[p][u];
+                if (with_counts) {
+                  count_data[ids[p][u]] = counts[p][u];
+                }
+              }
+            }
+          });
+    return Status::OK();
+  }
+
+ private:
+  // Allocates the unique elements, and their counts if `with_counts`.
+  static Status AllocateOutputs(OpKernelContext* context, const Tensor& input,
+                                int64 axis, int64 uniq_size, bool with_counts,
+                                T** output_data, TIndex** count_data) {
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    Tensor* output = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+    *output_data = output->flat<T>().data();
+    *count_data = nullptr;
+    if (with_counts) {
+      Tensor* count_output = nullptr;
+      TF_RETURN_IF_ERROR(context->allocate_output(
+          2, TensorShape({uniq_size}), &count_output));
+      *count_data = count_output->vec<TIndex>().data();
+    }
+    return Status::OK();
+  }
+
+  static constexpr int kMaxPartitions = 256;
+  static constexpr int32 kMinPartitionSize = 16 * 1024;
+
+  // The 64-bit finalizer of MurmurHash3, so that the high bits giving the
+  // partition and the low bits giving the slot are independent.
+  static uint64 Hash(T key) {
+    uint64 h = static_cast<uint64>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Sets the local id of the elements at `positions`, or of the first `size`
+  // elements if `positions` is null, in `uniques`, which it fills in the
+  // order of their first occurrence. Flags the first occurrences in
+  // `is_first` if it is set, and counts the occurrences if `counts` is set.
+  static void Deduplicate(typename TTypes<T>::ConstFlat Tin,
+                          const int32* positions, int32 size,
+                          int32* local_ids, uint8* is_first,
+                          std::vector<T>* uniques,
+                          std::vector<TIndex>* counts) {
+    // The table grows with the unique elements, which may be much fewer than
+    // the elements, so that it stays in cache.
+    std::vector<int32> table(16, -1);
+    uint64 mask = table.size() - 1;
+    for (int32 k = 0; k < size; ++k) {
+      const int32 i = positions != nullptr ? positions[k] : k;
+      const T key = Tin(i);
+      uint64 slot = Hash(key) & mask;
+      while (table[slot] >= 0 && (*uniques)[table[slot]] != key) {
+        slot = (slot + 1) & mask;
+      }
+      if (table[slot] < 0) {
+        table[slot] = static_cast<int32>(uniques->size());
+        uniques->push_back(key);
+        if (counts != nullptr) counts->push_back(0);
+        if (is_first != nullptr) is_first[i] = 1;
+        if (2 * uniques->size() > table.size()) {
+          table.assign(2 * table.size(), -1);
+          mask = table.size() - 1;
+          for (size_t u = 0; u < uniques->size(); ++u) {
+            uint64 free_slot = Hash((*uniques)[u]) & mask;
+            while (table[free_slot] >= 0) {
+              free_slot = (free_slot + 1) & mask;
+            }
+            table[free_slot] = static_cast<int32>(u);
+          }
+        }
+        local_ids[i] = static_cast<int32>(uniques->size()) - 1;
+      } else {
+        local_ids[i] = table[slot];
+      }
+      if (counts != nullptr) ++(*counts)[local_ids[i]];
+    }
+  }
+};
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -98,6 +347,14 @@ class UniqueOp : public OpKernel {
                                 1, TensorShape({new_sizes[1]}), &idx));
     auto idx_vec = idx->template vec<TIndex>();
 
+    if (new_sizes[0] == 1 && new_sizes[2] == 1 &&
+        PartitionedUnique<T, TIndex>::kSupported) {
+      OP_REQUIRES_OK(context, PartitionedUnique<T, TIndex>::Compute(
+                                  context, input, axis, idx_vec,
+                                  num_outputs() > 2));
+      return;
+    }
+
     int64 uniq_size;
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
@@ -15,9 +15,14 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -26,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -35,6 +41,50 @@ namespace {
 
 const int kMaxStrLen = 40;
 
+class UniqueWithCountsOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType input_type, DataType index_type) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "UniqueWithCounts")
+                     .Input(FakeInput(input_type))
+                     .Attr("out_idx", index_type)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(UniqueWithCountsOpTest, Large) {
+  // Large enough to be split into partitions on several threads.
+  const int kSize = 1 << 18;
+  std::vector<int64> x(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    x[i] = (i * 7919LL) % 30011 - 1000;
+  }
+  std::unordered_map<int64, int32> ids;
+  std::vector<int64> y;
+  std::vector<int32> idx;
+  std::vector<int32> count;
+  for (int64 value : x) {
+    auto it = ids.emplace(value, y.size());
+    if (it.second) {
+      y.push_back(value);
+      count.push_back(0);
+    }
+    idx.push_back(it.first->second);
+    ++count[it.first->second];
+  }
+
+  MakeOp(DT_INT64, DT_INT32);
+  AddInputFromArray<int64>(TensorShape({kSize}), x);
+  TF_ASSERT_OK(RunOpKernel());
+  const int64 num_unique = y.size();
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>(y, TensorShape({num_unique})), *GetOutput(0));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>(idx, TensorShape({kSize})), *GetOutput(1));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>(count, TensorShape({num_unique})), *GetOutput(2));
+}
+
 TensorProto GetRandomInt32TensorProto(int dim, int max_int) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_INT32);
@@ -102,6 +152,37 @@ static void BM_Unique_INT32_Repeat(int iters, int dim, int max_int) {
   test::Benchmark("cpu", g).Run(iters);
 }
 
+TensorProto GetRandomInt64TensorProto(int dim, int64 max_int) {
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT64);
+  tensor_proto.mutable_tensor_shape()->add_dim()->set_size(dim);
+  tensor_proto.mutable_tensor_shape()->set_unknown_rank(false);
+  for (int i = 0; i < dim; ++i) {
+    tensor_proto.add_int64_val(random::New64() % max_int);
+  }
+  return tensor_proto;
+}
+
+// Deduplicating the ids of a batch, as before an embedding lookup.
+static void BM_Unique_INT64(int iters, int dim, int max_int) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_INT64, TensorShape({dim}));
+  CHECK(input.FromProto(GetRandomInt64TensorProto(dim, max_int)));
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UniqueWithCounts")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * dim * sizeof(int64));
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
 TensorProto GetRandomStringsTensorProto(int dim, int max_str_len) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_STRING);
@@ -180,6 +261,12 @@ BENCHMARK(BM_Unique_INT32_Repeat)
     ->ArgPair(64 * 1024, 64 * 1024 * 1024)
     ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
 
+BENCHMARK(BM_Unique_INT64)
+    ->ArgPair(1024 * 1024, 1024)
+    ->ArgPair(1024 * 1024, 64 * 1024)
+    ->ArgPair(1024 * 1024, 1024 * 1024)
+    ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
+
 BENCHMARK(BM_Unique_STRING)
     ->Arg(32)
     ->Arg(256)
@@ -0,0 +1,248 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/vocabulary_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/inputbuffer.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+constexpr char kMagic[] = "TFVIDX01";
+constexpr size_t kMagicSize = 8;
+constexpr size_t kHeaderSize = kMagicSize + 2 * sizeof(uint64);
+// The slots of a key are the hashes with the seeds in [1, kMaxSeed].
+constexpr int32 kMaxSeed = 0x7fffffff;
+constexpr size_t kBufferSize = 1 * 1024 * 1024;
+
+// The bucket of a key. The hash uses the default seed, which is larger than
+// kMaxSeed, so that it is independent of the hashes giving the slots.
+uint64 BucketOf(StringPiece key, uint64 num_buckets) {
+  return Hash64(key.data(), key.size()) % num_buckets;
+}
+
+uint64 SlotOf(StringPiece key, int32 seed, uint64 num_keys) {
+  return Hash64(key.data(), key.size(), seed) % num_keys;
+}
+
+// The size of the entries of `num_buckets` buckets, padded to 8 bytes.
+uint64 BucketsSize(uint64 num_buckets) {
+  return (num_buckets * sizeof(int32) + 7) / 8 * 8;
+}
+
+}  // namespace
+
+Status VocabularyIndex::Open(Env* env, const string& filename,
+                             std::unique_ptr<VocabularyIndex>* index) {
+  std::unique_ptr<VocabularyIndex> result(new VocabularyIndex);
+  TF_RETURN_IF_ERROR(
+      env->NewReadOnlyMemoryRegionFromFile(filename, &result->region_));
+  const uint64 length = result->region_->length();
+  result->data_ = static_cast<const char*>(result->region_->data());
+  if (length < kHeaderSize ||
+      memcmp(result->data_, kMagic, kMagicSize) != 0) {
+    return errors::DataLoss("Not a vocabulary index file: ", filename);
+  }
+  result->num_keys_ = core::DecodeFixed64(result->data_ + kMagicSize);
+  result->num_buckets_ =
+      core::DecodeFixed64(result->data_ + kMagicSize + sizeof(uint64));
+  result->buckets_ = result->data_ + kHeaderSize;
+  result->values_ = result->buckets_ + BucketsSize(result->num_buckets_);
+  result->key_offsets_ = result->values_ + result->num_keys_ * sizeof(int64);
+  result->keys_ =
+      result->key_offsets_ + (result->num_keys_ + 1) * sizeof(uint64);
+  const uint64 keys_offset = result->keys_ - result->data_;
+  if ((result->num_keys_ > 0) != (result->num_buckets_ > 0) ||
+      keys_offset > length ||
+      keys_offset + core::DecodeFixed64(result->key_offsets_ +
+                                        result->num_keys_ * sizeof(uint64)) !=
+          length) {
+    return errors::DataLoss("Truncated or corrupted vocabulary index file: ",
+                            filename);
+  }
+  *index = std::move(result);
+  return Status::OK();
+}
+
+int64 VocabularyIndex::Find(StringPiece key) const {
+  if (num_keys_ == 0) {
+    return -1;
+  }
+  const uint64 bucket = BucketOf(key, num_buckets_);
+  const int32 entry = static_cast<int32>(
+      core::DecodeFixed32(buckets_ + bucket * sizeof(int32)));
+  if (entry == 0) {
+    return -1;
+  }
+  const int64 slot = entry < 0 ? -static_cast<int64>(entry) - 1
+                               : SlotOf(key, entry, num_keys_);
+  if (this->key(slot) != key) {
+    return -1;
+  }
+  return value(slot);
+}
+
+StringPiece VocabularyIndex::key(int64 slot) const {
+  const uint64 begin = core::DecodeFixed64(key_offsets_ + slot * 8);
+  const uint64 end = core::DecodeFixed64(key_offsets_ + (slot + 1) * 8);
+  return StringPiece(keys_ + begin, end - begin);
+}
+
+int64 VocabularyIndex::value(int64 slot) const {
+  return static_cast<int64>(core::DecodeFixed64(values_ + slot * 8));
+}
+
+Status WriteVocabularyIndex(Env* env, const std::vector<string>& keys,
+                            const string& filename) {
+  const uint64 num_keys = keys.size();
+  if (num_keys >= static_cast<uint64>(kMaxSeed)) {
+    return errors::InvalidArgument("Too many keys for a vocabulary index: ",
+                                   num_keys);
+  }
+  // One bucket per key on average.
+  const uint64 num_buckets = num_keys;
+
+  // Groups the keys by bucket, and places the largest buckets first, while
+  // most of the slots are free.
+  std::vector<std::pair<uint64, int64>> bucket_keys(num_keys);
+  for (uint64 i = 0; i < num_keys; ++i) {
+    bucket_keys[i] = {BucketOf(keys[i], num_buckets), i};
+  }
+  std::sort(bucket_keys.begin(), bucket_keys.end());
+  std::vector<std::pair<int64, int64>> groups;  // {-size, start}
+  for (uint64 start = 0; start < num_keys;) {
+    uint64 end = start + 1;
+    const uint64 bucket = bucket_keys[start].first;
+    while (end < num_keys && bucket_keys[end].first == bucket) {
+      ++end;
+    }
+    for (uint64 i = start; i < end; ++i) {
+      for (uint64 j = start; j < i; ++j) {
+        if (keys[bucket_keys[i].second] == keys[bucket_keys[j].second]) {
+          return errors::InvalidArgument("Repeated key in the vocabulary: ",
+                                         keys[bucket_keys[i].second]);
+        }
+      }
+    }
+    groups.emplace_back(-static_cast<int64>(end - start), start);
+    start = end;
+  }
+  std::sort(groups.begin(), groups.end());
+
+  std::vector<int32> entries(num_buckets, 0);
+  std::vector<int64> slot_keys(num_keys, -1);
+  std::vector<uint64> slots;
+  uint64 next_free_slot = 0;
+  for (const auto& group : groups) {
+    const int64 size = -group.first;
+    const auto begin = bucket_keys.begin() + group.second;
+    const uint64 bucket = begin->first;
+    if (size == 1) {
+      // A single key takes the next free slot directly.
+      while (slot_keys[next_free_slot] >= 0) {
+        ++next_free_slot;
+      }
+      slot_keys[next_free_slot] = begin->second;
+      entries[bucket] = -static_cast<int32>(next_free_slot) - 1;
+      continue;
+    }
+    // Finds the first seed placing all the keys of the bucket into distinct
+    // free slots.
+    int32 seed = 1;
+    for (;; ++seed) {
+      if (seed == kMaxSeed) {
+        return errors::Internal("Could not build the vocabulary index");
+      }
+      slots.clear();
+      bool placed = true;
+      for (auto it = begin; it != begin + size && placed; ++it) {
+        const uint64 slot = SlotOf(keys[it->second], seed, num_keys);
+        placed = slot_keys[slot] < 0 &&
+                 std::find(slots.begin(), slots.end(), slot) == slots.end();
+        slots.push_back(slot);
+      }
+      if (placed) break;
+    }
+    for (int64 i = 0; i < size; ++i) {
+      slot_keys[slots[i]] = begin[i].second;
+    }
+    entries[bucket] = seed;
+  }
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  string buffer(kMagic, kMagicSize);
+  // Appends the buffer to the file once it is large enough.
+  auto maybe_flush = [&buffer, &file](bool force) -> Status {
+    if (force || buffer.size() >= kBufferSize) {
+      TF_RETURN_IF_ERROR(file->Append(buffer));
+      buffer.clear();
+    }
+    return Status::OK();
+  };
+  core::PutFixed64(&buffer, num_keys);
+  core::PutFixed64(&buffer, num_buckets);
+  for (int32 entry : entries) {
+    core::PutFixed32(&buffer, static_cast<uint32>(entry));
+    TF_RETURN_IF_ERROR(maybe_flush(false));
+  }
+  buffer.append(BucketsSize(num_buckets) - num_buckets * sizeof(int32), '\0');
+  for (int64 key : slot_keys) {
+    core::PutFixed64(&buffer, key);
+    TF_RETURN_IF_ERROR(maybe_flush(false));
+  }
+  uint64 offset = 0;
+  core::PutFixed64(&buffer, offset);
+  for (int64 key : slot_keys) {
+    offset += keys[key].size();
+    core::PutFixed64(&buffer, offset);
+    TF_RETURN_IF_ERROR(maybe_flush(false));
+  }
+  for (int64 key : slot_keys) {
+    buffer.append(keys[key]);
+    TF_RETURN_IF_ERROR(maybe_flush(false));
+  }
+  TF_RETURN_IF_ERROR(maybe_flush(true));
+  return file->Close();
+}
+
+Status WriteVocabularyIndexFromTextFile(Env* env,
+                                        const string& vocabulary_file,
+                                        const string& filename) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(vocabulary_file, &file));
+  io::InputBuffer input_buffer(file.get(), kBufferSize);
+  std::vector<string> keys;
+  string line;
+  while (true) {
+    const Status status = input_buffer.ReadLine(&line);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+    keys.push_back(line);
+  }
+  return WriteVocabularyIndex(env, keys, filename);
+}
+
+}  // namespace lookup
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_VOCABULARY_INDEX_H_
+#define TENSORFLOW_CORE_KERNELS_VOCABULARY_INDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A read-only map from the keys of a vocabulary to their position in it,
+// stored in a file indexed by a minimal perfect hash function.
+//
+// The index file is generated offline, e.g. with build_vocabulary_index, and
+// is memory mapped when opened, so that opening it costs no parsing nor
+// allocation however large the vocabulary, and so that the processes of a
+// machine share its pages.
+//
+// The perfect hash function maps the n keys to the slots [0, n) with the
+// "hash and displace" scheme: the keys are hashed into buckets, and each
+// bucket stores either the seed of the hash function that places all its keys
+// into free slots, or directly the slot of its single key. A lookup thus
+// hashes the key twice and compares it with the key of its slot, which tells
+// the keys out of the vocabulary apart.
+//
+// The file holds, in little endian:
+//   the magic "TFVIDX01", the number of keys and the number of buckets,
+//   the int32 entries of the buckets, padded to 8 bytes,
+//   the int64 values of the slots,
+//   the uint64 offsets of the keys of the slots, followed by their end,
+//   the keys of the slots.
+class VocabularyIndex {
+ public:
+  // Opens the index file `filename`.
+  static Status Open(Env* env, const string& filename,
+                     std::unique_ptr<VocabularyIndex>* index);
+
+  // The number of keys.
+  int64 size() const { return num_keys_; }
+
+  // Returns the value of `key`, or -1 if it isn't in the vocabulary.
+  int64 Find(StringPiece key) const;
+
+  // The key and the value of the slot `slot`, in [0, size()).
+  StringPiece key(int64 slot) const;
+  int64 value(int64 slot) const;
+
+  // The size of the index file.
+  uint64 MemoryUsed() const { return region_->length(); }
+
+ private:
+  VocabularyIndex() {}
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const char* data_ = nullptr;
+  uint64 num_keys_ = 0;
+  uint64 num_buckets_ = 0;
+  const char* buckets_ = nullptr;
+  const char* values_ = nullptr;
+  const char* key_offsets_ = nullptr;
+  const char* keys_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(VocabularyIndex);
+};
+
+// Writes the index file `filename` of `keys`, whose values are their
+// positions in `keys`. Returns InvalidArgument if a key is repeated.
+Status WriteVocabularyIndex(Env* env, const std::vector<string>& keys,
+                            const string& filename);
+
+// Writes the index file `filename` of the vocabulary file `vocabulary_file`,
+// whose lines are the keys and whose line numbers are their values.
+Status WriteVocabularyIndexFromTextFile(Env* env,
+                                        const string& vocabulary_file,
+                                        const string& filename);
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_VOCABULARY_INDEX_H_
@@ -0,0 +1,117 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/vocabulary_index.h"
+
+#include <set>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+string IndexFile(const string& name) {
+  return io::JoinPath(testing::TmpDir(), strings::StrCat(name, ".vidx"));
+}
+
+TEST(VocabularyIndexTest, FindsAllKeys) {
+  Env* env = Env::Default();
+  std::vector<string> keys;
+  for (int i = 0; i < 10000; ++i) {
+    keys.push_back(strings::StrCat("key_", i));
+  }
+  keys.push_back("");
+  const string filename = IndexFile("FindsAllKeys");
+  TF_ASSERT_OK(WriteVocabularyIndex(env, keys, filename));
+
+  std::unique_ptr<VocabularyIndex> index;
+  TF_ASSERT_OK(VocabularyIndex::Open(env, filename, &index));
+  EXPECT_EQ(keys.size(), index->size());
+  for (int i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(i, index->Find(keys[i])) << keys[i];
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(-1, index->Find(strings::StrCat("other_", i)));
+  }
+  // The slots hold each key once.
+  std::set<int64> values;
+  for (int64 slot = 0; slot < index->size(); ++slot) {
+    EXPECT_EQ(keys[index->value(slot)], index->key(slot));
+    values.insert(index->value(slot));
+  }
+  EXPECT_EQ(keys.size(), values.size());
+}
+
+TEST(VocabularyIndexTest, EmptyVocabulary) {
+  Env* env = Env::Default();
+  const string filename = IndexFile("EmptyVocabulary");
+  TF_ASSERT_OK(WriteVocabularyIndex(env, {}, filename));
+  std::unique_ptr<VocabularyIndex> index;
+  TF_ASSERT_OK(VocabularyIndex::Open(env, filename, &index));
+  EXPECT_EQ(0, index->size());
+  EXPECT_EQ(-1, index->Find("a"));
+}
+
+TEST(VocabularyIndexTest, RepeatedKey) {
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            WriteVocabularyIndex(Env::Default(), {"a", "b", "a"},
+                                 IndexFile("RepeatedKey"))
+                .code());
+}
+
+TEST(VocabularyIndexTest, FromTextFile) {
+  Env* env = Env::Default();
+  const string vocabulary_file =
+      io::JoinPath(testing::TmpDir(), "vocabulary_index_test_vocab.txt");
+  TF_ASSERT_OK(
+      WriteStringToFile(env, vocabulary_file, "brain\nsalad\nsurgery\n"));
+  const string filename = IndexFile("FromTextFile");
+  TF_ASSERT_OK(
+      WriteVocabularyIndexFromTextFile(env, vocabulary_file, filename));
+  std::unique_ptr<VocabularyIndex> index;
+  TF_ASSERT_OK(VocabularyIndex::Open(env, filename, &index));
+  EXPECT_EQ(3, index->size());
+  EXPECT_EQ(0, index->Find("brain"));
+  EXPECT_EQ(1, index->Find("salad"));
+  EXPECT_EQ(2, index->Find("surgery"));
+  EXPECT_EQ(-1, index->Find("tarkus"));
+}
+
+TEST(VocabularyIndexTest, CorruptedFile) {
+  Env* env = Env::Default();
+  const string filename = IndexFile("CorruptedFile");
+  std::unique_ptr<VocabularyIndex> index;
+  TF_ASSERT_OK(WriteStringToFile(env, filename, "not an index"));
+  EXPECT_EQ(error::DATA_LOSS,
+            VocabularyIndex::Open(env, filename, &index).code());
+
+  TF_ASSERT_OK(WriteVocabularyIndex(env, {"a", "b", "c"}, filename));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, filename, &contents));
+  TF_ASSERT_OK(WriteStringToFile(env, filename,
+                                 contents.substr(0, contents.size() - 1)));
+  EXPECT_EQ(error::DATA_LOSS,
+            VocabularyIndex::Open(env, filename, &index).code());
+}
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/memory_pressure.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr int MemoryPressureRegistry::kCachePriority;
+constexpr int MemoryPressureRegistry::kBufferPriority;
+
+namespace {
+
+// True while the current thread runs release functions.
+thread_local bool releasing_memory = false;
+
+}  // namespace
+
+/* static */ MemoryPressureRegistry* MemoryPressureRegistry::Global() {
+  static MemoryPressureRegistry* registry = new MemoryPressureRegistry;
+  return registry;
+}
+
+MemoryPressureRegistry::HandlerId MemoryPressureRegistry::Register(
+    int priority, ReleaseFn release_fn) {
+  mutex_lock l(mu_);
+  const HandlerId id = next_id_++;
+  auto pos = std::upper_bound(
+      handlers_.begin(), handlers_.end(), priority,
+      [](int p, const Handler& h) { return p < h.priority; });
+  handlers_.insert(pos, Handler{priority, id, std::move(release_fn)});
+  return id;
+}
+
+void MemoryPressureRegistry::Unregister(HandlerId id) {
+  mutex_lock l(mu_);
+  auto it = std::find_if(handlers_.begin(), handlers_.end(),
+                         [id](const Handler& h) { return h.id == id; });
+  CHECK(it != handlers_.end()) << "Unknown memory pressure handler " << id;
+  handlers_.erase(it);
+}
+
+int64 MemoryPressureRegistry::ReleaseMemory(int64 bytes) {
+  if (releasing_memory) return 0;
+  releasing_memory = true;
+  int64 released = 0;
+  {
+    // Holding mu_ while the handlers run makes Unregister() wait for them.
+    mutex_lock l(mu_);
+    for (const Handler& h : handlers_) {
+      if (released >= bytes) break;
+      released += h.release_fn(bytes - released);
+    }
+  }
+  releasing_memory = false;
+  if (released > 0) {
+    VLOG(1) << "Released " << released << " bytes under memory pressure";
+  }
+  return released;
+}
+
+}  // namespace tensorflow
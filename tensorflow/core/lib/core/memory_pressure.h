@@ -0,0 +1,99 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_CORE_MEMORY_PRESSURE_H_
+#define TENSORFLOW_CORE_LIB_CORE_MEMORY_PRESSURE_H_
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// MemoryPressureRegistry lets components that hold memory they can give
+// up, such as caches, release it when an allocator runs out of memory,
+// so that they can share a memory budget with the model instead of
+// requiring a static partition of it.
+//
+// An allocator that fails to allocate calls ReleaseMemory() before it
+// waits for memory to be returned, and retries at once if any was
+// released. Handlers are asked in increasing order of priority until
+// enough bytes have been released:
+//
+//   MemoryPressureRegistry::HandlerId id =
+//       MemoryPressureRegistry::Global()->Register(
+//           MemoryPressureRegistry::kCachePriority,
+//           [this](int64 bytes) { return EvictLeastRecentlyUsed(bytes); });
+//   ...
+//   MemoryPressureRegistry::Global()->Unregister(id);
+//
+// A release function runs on the allocating thread, which may hold any
+// lock, including locks of the handler itself. It must therefore not block
+// (e.g. it should use mutex_lock with std::try_to_lock and release nothing
+// if that fails), and it must not call Register() or Unregister().
+// Allocations made by a release function do not trigger further releases.
+//
+// Thread-safe.
+class MemoryPressureRegistry {
+ public:
+  // Releases about "bytes" bytes, if possible, and returns the number of
+  // bytes actually released.
+  typedef std::function<int64(int64 bytes)> ReleaseFn;
+  typedef int64 HandlerId;
+
+  // Suggested priorities. Memory that is cheap to recreate should be
+  // released first.
+  static constexpr int kCachePriority = 0;
+  static constexpr int kBufferPriority = 100;
+
+  MemoryPressureRegistry() {}
+
+  // Returns the process-wide registry consulted by allocators.
+  static MemoryPressureRegistry* Global();
+
+  // Registers "release_fn". Handlers with equal priority are asked in
+  // registration order.
+  HandlerId Register(int priority, ReleaseFn release_fn) LOCKS_EXCLUDED(mu_);
+
+  // Unregisters the handler "id". After this returns, its release function
+  // is not running and will not be called again.
+  void Unregister(HandlerId id) LOCKS_EXCLUDED(mu_);
+
+  // Asks the registered handlers to release "bytes" bytes, and returns the
+  // number of bytes released.
+  int64 ReleaseMemory(int64 bytes) LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Handler {
+    int priority;
+    HandlerId id;
+    ReleaseFn release_fn;
+  };
+
+  mutex mu_;
+  // Sorted by (priority, id).
+  std::vector<Handler> handlers_ GUARDED_BY(mu_);
+  HandlerId next_id_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPressureRegistry);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_CORE_MEMORY_PRESSURE_H_
@@ -0,0 +1,73 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/memory_pressure.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MemoryPressureRegistryTest, AsksHandlersInPriorityOrder) {
+  MemoryPressureRegistry registry;
+  std::vector<string> calls;
+  auto handler = [&calls](const string& name, int64 available) {
+    return [&calls, name, available](int64 bytes) {
+      calls.push_back(name);
+      return std::min(bytes, available);
+    };
+  };
+  auto low = registry.Register(10, handler("low", 100));
+  auto cache = registry.Register(MemoryPressureRegistry::kCachePriority,
+                                 handler("cache", 30));
+  auto also_low = registry.Register(10, handler("also_low", 100));
+
+  EXPECT_EQ(0, registry.ReleaseMemory(0));
+  EXPECT_TRUE(calls.empty());
+
+  EXPECT_EQ(20, registry.ReleaseMemory(20));
+  EXPECT_EQ(std::vector<string>({"cache"}), calls);
+
+  calls.clear();
+  EXPECT_EQ(150, registry.ReleaseMemory(150));
+  EXPECT_EQ(std::vector<string>({"cache", "low", "also_low"}), calls);
+
+  registry.Unregister(low);
+  registry.Unregister(cache);
+  calls.clear();
+  EXPECT_EQ(100, registry.ReleaseMemory(1000));
+  EXPECT_EQ(std::vector<string>({"also_low"}), calls);
+  registry.Unregister(also_low);
+  EXPECT_EQ(0, registry.ReleaseMemory(1000));
+}
+
+TEST(MemoryPressureRegistryTest, ReleaseIsNotReentrant) {
+  MemoryPressureRegistry registry;
+  int calls = 0;
+  auto id = registry.Register(0, [&registry, &calls](int64 bytes) {
+    ++calls;
+    // E.g. an allocation made while releasing memory fails in turn.
+    EXPECT_EQ(0, registry.ReleaseMemory(bytes));
+    return bytes;
+  });
+  EXPECT_EQ(8, registry.ReleaseMemory(8));
+  EXPECT_EQ(1, calls);
+  registry.Unregister(id);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <algorithm>
+#include <atomic>
+
 #define EIGEN_USE_THREADS
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/platform/context.h"
@@ -28,6 +31,54 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+namespace {
+
+// Makes the threads of a pool spin for new closures after running one.
+class Spinner {
+ public:
+  Spinner(ThreadPool::SpinPolicy policy, int64 duration_us)
+      : policy_(policy), duration_us_(duration_us) {}
+
+  // Records that a closure is scheduled.
+  void RecordSchedule(Env* env) {
+    num_scheduled_.fetch_add(1, std::memory_order_release);
+    if (policy_ != ThreadPool::SpinPolicy::kAdaptive) return;
+    // Races between threads only blur the average.
+    const int64 now = env->NowMicros();
+    const int64 last = last_schedule_us_.exchange(now,
+                                                  std::memory_order_relaxed);
+    const int64 mean = mean_interval_us_.load(std::memory_order_relaxed);
+    mean_interval_us_.store(mean + (now - last - mean) / 8,
+                            std::memory_order_relaxed);
+  }
+
+  // Busy-waits until another closure is scheduled or the spin duration
+  // elapses, unless the policy says not to spin.
+  void SpinForWork(Env* env) {
+    if (policy_ == ThreadPool::SpinPolicy::kAdaptive &&
+        mean_interval_us_.load(std::memory_order_relaxed) > duration_us_) {
+      return;
+    }
+    const uint64 num_scheduled =
+        num_scheduled_.load(std::memory_order_acquire);
+    const uint64 deadline = env->NowMicros() + duration_us_;
+    while (num_scheduled_.load(std::memory_order_acquire) == num_scheduled &&
+           env->NowMicros() < deadline) {
+    }
+  }
+
+ private:
+  const ThreadPool::SpinPolicy policy_;
+  const int64 duration_us_;
+  std::atomic<uint64> num_scheduled_{0};
+  std::atomic<int64> last_schedule_us_{0};
+  // Starts high, so that an adaptive pool doesn't spin before it has seen
+  // closures arrive.
+  std::atomic<int64> mean_interval_us_{kint64max / 2};
+};
+
+}  // namespace
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
@@ -42,10 +93,16 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  // Shared by the copies of the environment. Null when the threads don't
+  // spin after running closures.
+  const std::shared_ptr<Spinner> spinner_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, std::shared_ptr<Spinner> spinner)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        spinner_(std::move(spinner)) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
     return env_->StartThread(thread_options_, name_, [=]() {
@@ -58,6 +115,9 @@ struct EigenEnvironment {
   }
 
   Task CreateTask(std::function<void()> f) {
+    if (spinner_ != nullptr) {
+      spinner_->RecordSchedule(env_);
+    }
     uint64 id = 0;
     if (tracing::EventCollector::IsEnabled()) {
       id = tracing::GetUniqueArg();
@@ -73,29 +133,78 @@ struct EigenEnvironment {
   }
 
   void ExecuteTask(const Task& t) {
-    WithContext wc(t.f->context);
-    tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
-                                 t.f->trace_id);
-    t.f->f();
+    {
+      WithContext wc(t.f->context);
+      tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
+                                   t.f->trace_id);
+      t.f->f();
+    }
+    if (spinner_ != nullptr) {
+      spinner_->SpinForWork(env_);
+    }
   }
 };
 
+namespace {
+
+// The pool whose ParallelFor shard the current thread is running, or null.
+thread_local const ThreadPool::Impl* current_parallel_for_pool = nullptr;
+
+std::shared_ptr<Spinner> NewSpinner(ThreadPool::SpinPolicy spin_policy,
+                                    int64 spin_duration_us) {
+  if (spin_policy != ThreadPool::SpinPolicy::kAlways &&
+      spin_policy != ThreadPool::SpinPolicy::kAdaptive) {
+    return nullptr;
+  }
+  return std::make_shared<Spinner>(spin_policy, spin_duration_us);
+}
+
+}  // namespace
+
 struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
+  // The pool spins on its own only with kDefault, since the other policies
+  // either don't spin or spin in EigenEnvironment.
   Impl(Env* env, const ThreadOptions& thread_options, const string& name,
-       int num_threads, bool low_latency_hint)
+       int num_threads, bool low_latency_hint, SpinPolicy spin_policy,
+       int64 spin_duration_us)
       : Eigen::ThreadPoolTempl<EigenEnvironment>(
-            num_threads, low_latency_hint,
-            EigenEnvironment(env, thread_options, name)) {}
+            num_threads,
+            low_latency_hint && spin_policy == SpinPolicy::kDefault,
+            EigenEnvironment(env, thread_options, name,
+                             NewSpinner(spin_policy, spin_duration_us))) {}
 
   void ParallelFor(int64 total, int64 cost_per_unit,
                    std::function<void(int64, int64)> fn) {
     CHECK_GE(total, 0);
     CHECK_EQ(total, (int64)(Eigen::Index)total);
-    Eigen::ThreadPoolDevice device(this, this->NumThreads());
-    device.parallelFor(
-        total, Eigen::TensorOpCost(0, 0, cost_per_unit),
-        [&fn](Eigen::Index first, Eigen::Index last) { fn(first, last); });
+    int num_threads = this->NumThreads();
+    if (current_parallel_for_pool == this) {
+      // A ParallelFor nested in the shard of another one only gets the
+      // threads that no shard is running on, besides its own thread, so that
+      // inner regions don't flood the queues of threads that are busy with
+      // the outer one. When none is left, it runs inline.
+      num_threads = std::max(
+          1, num_threads - active_shards_.load(std::memory_order_relaxed) + 1);
+      if (num_threads == 1) {
+        fn(0, total);
+        return;
+      }
+    }
+    Eigen::ThreadPoolDevice device(this, num_threads);
+    device.parallelFor(total, Eigen::TensorOpCost(0, 0, cost_per_unit),
+                       [this, &fn](Eigen::Index first, Eigen::Index last) {
+                         const Impl* outer_pool = current_parallel_for_pool;
+                         current_parallel_for_pool = this;
+                         active_shards_.fetch_add(1, std::memory_order_relaxed);
+                         fn(first, last);
+                         active_shards_.fetch_sub(1, std::memory_order_relaxed);
+                         current_parallel_for_pool = outer_pool;
+                       });
   }
+
+ private:
+  // The number of ParallelFor shards running on any thread.
+  std::atomic<int> active_shards_{0};
 };
 
 ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
@@ -110,7 +219,18 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
                        bool low_latency_hint) {
   CHECK_GE(num_threads, 1);
   impl_.reset(new ThreadPool::Impl(env, thread_options, "tf_" + name,
-                                   num_threads, low_latency_hint));
+                                   num_threads, low_latency_hint,
+                                   SpinPolicy::kDefault, 0));
+}
+
+ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
+                       const string& name, int num_threads,
+                       SpinPolicy spin_policy, int64 spin_duration_us) {
+  CHECK_GE(num_threads, 1);
+  CHECK_GE(spin_duration_us, 0);
+  impl_.reset(new ThreadPool::Impl(env, thread_options, "tf_" + name,
+                                   num_threads, true, spin_policy,
+                                   spin_duration_us));
 }
 
 ThreadPool::~ThreadPool() {}
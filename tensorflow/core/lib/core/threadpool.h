@@ -27,6 +27,21 @@ namespace thread {
 
 class ThreadPool {
  public:
+  // How the threads of a pool wait for new closures once they are idle.
+  enum class SpinPolicy {
+    // Only the spinning that "low_latency_hint" turns on.
+    kDefault,
+    // Idle threads park right away.
+    kNever,
+    // Threads spin for "spin_duration_us" after each closure before they
+    // park, so that closures scheduled meanwhile start without the latency
+    // of waking a parked thread.
+    kAlways,
+    // Like kAlways, but threads only spin while the recent closures were
+    // scheduled at intervals shorter than "spin_duration_us" on average.
+    kAdaptive,
+  };
+
   // Constructs a pool that contains "num_threads" threads with specified
   // "name". env->StartThread() is used to create individual threads with the
   // given ThreadOptions. If "low_latency_hint" is true the thread pool
@@ -39,6 +54,15 @@ class ThreadPool {
   ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
              int num_threads, bool low_latency_hint);
 
+  // Constructs a pool that contains "num_threads" threads with specified
+  // "name", whose idle threads wait for work according to "spin_policy".
+  // env->StartThread() is used to create individual threads with the given
+  // ThreadOptions.
+  //
+  // REQUIRES: num_threads > 0
+  ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
+             int num_threads, SpinPolicy spin_policy, int64 spin_duration_us);
+
   // Constructs a pool for low-latency ops that contains "num_threads" threads
   // with specified "name". env->StartThread() is used to create individual
   // threads.
@@ -69,6 +93,10 @@ class ThreadPool {
   // many shards and CPU time will be dominated by per-shard overhead, such as
   // Context creation. Underestimating may not fully make use of the specified
   // parallelism.
+  //
+  // A ParallelFor called from the shard of another ParallelFor on the same
+  // pool only uses the threads that are not running shards, and runs inline
+  // when all of them are.
   void ParallelFor(int64 total, int64 cost_per_unit,
                    std::function<void(int64, int64)> fn);
 
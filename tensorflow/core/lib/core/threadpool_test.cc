@@ -61,6 +61,34 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
+TEST(ThreadPool, DoWorkWithSpinPolicies) {
+  for (ThreadPool::SpinPolicy spin_policy :
+       {ThreadPool::SpinPolicy::kDefault, ThreadPool::SpinPolicy::kNever,
+        ThreadPool::SpinPolicy::kAlways, ThreadPool::SpinPolicy::kAdaptive}) {
+    for (int num_threads = 1; num_threads < 5; num_threads++) {
+      const int kWorkItems = 100;
+      std::atomic<int> work[kWorkItems];
+      for (int i = 0; i < kWorkItems; i++) {
+        work[i] = 0;
+      }
+      {
+        ThreadPool pool(Env::Default(), ThreadOptions(), "test", num_threads,
+                        spin_policy, 20);
+        for (int i = 0; i < kWorkItems; i++) {
+          pool.Schedule([&work, i]() { work[i]++; });
+          if (i % 10 == 0) {
+            // Leaves the threads idle long enough to stop spinning.
+            Env::Default()->SleepForMicroseconds(100);
+          }
+        }
+      }
+      for (int i = 0; i < kWorkItems; i++) {
+        ASSERT_EQ(1, work[i]);
+      }
+    }
+  }
+}
+
 TEST(ThreadPool, ParallelFor) {
   Context outer_context(ContextKind::kThread);
   // Make ParallelFor use as many threads as possible.
@@ -88,6 +116,49 @@ TEST(ThreadPool, ParallelFor) {
   }
 }
 
+TEST(ThreadPool, NestedParallelFor) {
+  int64 kHugeCost = 1 << 30;
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    fprintf(stderr, "Testing with %d threads\n", num_threads);
+    const int kOuterItems = 6;
+    const int kInnerItems = 10;
+    std::atomic<int> work[kOuterItems * kInnerItems];
+    for (int i = 0; i < kOuterItems * kInnerItems; i++) {
+      work[i] = 0;
+    }
+    ThreadPool pool(Env::Default(), "test", num_threads);
+    pool.ParallelFor(kOuterItems, kHugeCost, [&](int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        pool.ParallelFor(kInnerItems, kHugeCost,
+                         [&, i](int64 inner_begin, int64 inner_end) {
+                           for (int64 j = inner_begin; j < inner_end; ++j) {
+                             work[i * kInnerItems + j]++;
+                           }
+                         });
+      }
+    });
+    for (int i = 0; i < kOuterItems * kInnerItems; i++) {
+      ASSERT_EQ(1, work[i]);
+    }
+  }
+}
+
+TEST(ThreadPool, NestedParallelForRunsInlineWhenThreadsAreBusy) {
+  int64 kHugeCost = 1 << 30;
+  ThreadPool pool(Env::Default(), "test", 1);
+  pool.ParallelFor(1, kHugeCost, [&pool, kHugeCost](int64, int64) {
+    // The only thread of the pool runs the outer shard, so the inner work is
+    // done in a single call.
+    int num_calls = 0;
+    pool.ParallelFor(100, kHugeCost, [&num_calls](int64 begin, int64 end) {
+      EXPECT_EQ(0, begin);
+      EXPECT_EQ(100, end);
+      ++num_calls;
+    });
+    EXPECT_EQ(1, num_calls);
+  });
+}
+
 TEST(ThreadPool, ParallelForWithWorkerId) {
   // Make ParallelForWithWorkerId use as many threads as possible.
   int64 kHugeCost = 1 << 30;
@@ -0,0 +1,188 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+// The reads are mostly waiting for the file system, so the shared pool has
+// more threads than there are cores.
+constexpr int kNumSharedThreads = 16;
+
+thread::ThreadPool* SharedThreadPool() {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "readahead", kNumSharedThreads);
+  return pool;
+}
+
+}  // namespace
+
+struct ReadaheadInputStream::Chunk {
+  explicit Chunk(int64 offset) : offset(offset) {}
+
+  const int64 offset;
+  // Written by the reading thread until `done` is set.
+  string data;
+  Status status;
+  // Guarded by the `mu_` of the stream.
+  bool done = false;
+};
+
+ReadaheadInputStream::ReadaheadInputStream(RandomAccessFile* file,
+                                           int64 chunk_bytes, int num_chunks,
+                                           thread::ThreadPool* pool)
+    : file_(file),
+      chunk_bytes_(chunk_bytes),
+      num_chunks_(num_chunks),
+      pool_(pool != nullptr ? pool : SharedThreadPool()) {
+  DCHECK_GT(chunk_bytes_, 0);
+  DCHECK_GT(num_chunks_, 0);
+}
+
+ReadaheadInputStream::~ReadaheadInputStream() {
+  Clear();
+  mutex_lock l(mu_);
+  while (num_in_flight_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+void ReadaheadInputStream::FillPipeline() {
+  while (!end_requested_ && chunks_.size() < static_cast<size_t>(num_chunks_)) {
+    std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>(next_offset_);
+    next_offset_ += chunk_bytes_;
+    chunks_.push_back(chunk);
+    {
+      mutex_lock l(mu_);
+      ++num_in_flight_;
+    }
+    pool_->Schedule([this, chunk]() {
+      chunk->data.resize(chunk_bytes_);
+      StringPiece result;
+      Status s =
+          file_->Read(chunk->offset, chunk_bytes_, &result, &chunk->data[0]);
+      if (result.data() != chunk->data.data()) {
+        string(result.data(), result.size()).swap(chunk->data);
+      } else {
+        chunk->data.resize(result.size());
+      }
+      mutex_lock l(mu_);
+      chunk->status = s;
+      chunk->done = true;
+      --num_in_flight_;
+      cond_var_.notify_all();
+    });
+  }
+}
+
+void ReadaheadInputStream::WaitForFront() {
+  mutex_lock l(mu_);
+  while (!chunks_.front()->done) {
+    cond_var_.wait(l);
+  }
+}
+
+void ReadaheadInputStream::Clear() {
+  // Reads in flight keep their chunks alive until they finish.
+  chunks_.clear();
+}
+
+Status ReadaheadInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  while (result->size() < bytes_to_read) {
+    FillPipeline();
+    if (chunks_.empty()) break;
+    WaitForFront();
+    const Chunk& chunk = *chunks_.front();
+    if (!chunk.status.ok() && !errors::IsOutOfRange(chunk.status)) {
+      return chunk.status;
+    }
+    const int64 chunk_pos = pos_ - chunk.offset;
+    const int64 available = static_cast<int64>(chunk.data.size()) - chunk_pos;
+    if (available <= 0) {
+      // There is no data after a short read.
+      end_requested_ = true;
+      break;
+    }
+    const int64 n = std::min<int64>(available, bytes_to_read - result->size());
+    result->append(chunk.data, chunk_pos, n);
+    pos_ += n;
+    if (pos_ - chunk.offset == chunk_bytes_) {
+      chunks_.pop_front();
+    }
+  }
+  if (result->size() < bytes_to_read) {
+    return errors::OutOfRange("reached end of file");
+  }
+  return Status::OK();
+}
+
+Status ReadaheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes");
+  }
+  if (bytes_to_skip == 0) {
+    return Status::OK();
+  }
+  // Read the last skipped byte, to find out whether the file is long enough.
+  const int64 start = pos_;
+  TF_RETURN_IF_ERROR(Seek(start + bytes_to_skip - 1));
+  string skipped;
+  Status s = ReadNBytes(1, &skipped);
+  if (errors::IsOutOfRange(s)) {
+    // Read up to the end of the file, which is where Tell() must then be.
+    TF_RETURN_IF_ERROR(Seek(start));
+    s = ReadNBytes(bytes_to_skip, &skipped);
+  }
+  return s;
+}
+
+int64 ReadaheadInputStream::Tell() const { return pos_; }
+
+Status ReadaheadInputStream::Seek(int64 position) {
+  if (position < 0) {
+    return errors::InvalidArgument("Seeking to a negative position: ",
+                                   position);
+  }
+  while (!chunks_.empty() &&
+         chunks_.front()->offset + chunk_bytes_ <= position) {
+    chunks_.pop_front();
+  }
+  if (chunks_.empty() || chunks_.front()->offset > position) {
+    Clear();
+    next_offset_ = position;
+    end_requested_ = false;
+  }
+  pos_ = position;
+  return Status::OK();
+}
+
+Status ReadaheadInputStream::Reset() { return Seek(0); }
+
+}  // namespace io
+}  // namespace tensorflow
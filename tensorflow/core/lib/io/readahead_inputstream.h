@@ -0,0 +1,97 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a RandomAccessFile sequentially, keeping several reads of the chunks
+// ahead of the current position in flight at once, so that the latency of
+// the file system is hidden from the reader and high-latency file systems,
+// e.g. object stores, serve the chunks in parallel.
+//
+// The reads run on `pool`, or on a pool that is shared by the process if
+// `pool` is null. A single instance of ReadaheadInputStream is NOT safe for
+// concurrent use by multiple threads.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this, and which
+  // must support concurrent reads, as all RandomAccessFiles do.
+  ReadaheadInputStream(RandomAccessFile* file, int64 chunk_bytes,
+                       int num_chunks, thread::ThreadPool* pool = nullptr);
+
+  // Waits for the reads in flight.
+  ~ReadaheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  // Seeks to `position`. Reuses the chunks at or after `position` that have
+  // already been requested.
+  Status Seek(int64 position);
+
+  Status Reset() override;
+
+ private:
+  struct Chunk;
+
+  // Requests chunks until `num_chunks_` are ahead of the current position.
+  void FillPipeline();
+  // Waits for the first chunk to be read.
+  void WaitForFront();
+  // Drops all chunks.
+  void Clear();
+
+  RandomAccessFile* const file_;  // Not owned.
+  const int64 chunk_bytes_;
+  const int num_chunks_;
+  thread::ThreadPool* const pool_;  // Not owned.
+
+  // The current position in the file.
+  int64 pos_ = 0;
+  // The chunks from the one that contains `pos_` onwards, in file order.
+  std::deque<std::shared_ptr<Chunk>> chunks_;
+  // The offset of the next chunk to request.
+  int64 next_offset_ = 0;
+  // Set once a read reaches the end of the file or fails, to stop requesting
+  // chunks beyond it.
+  bool end_requested_ = false;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int num_in_flight_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,136 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+string WriteTestFile(const string& contents) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  return fname;
+}
+
+TEST(ReadaheadInputStream, ReadNBytes) {
+  const string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  for (int64 chunk_bytes : {1, 2, 3, 4, 10, 11, 100}) {
+    for (int num_chunks : {1, 2, 5}) {
+      string read;
+      ReadaheadInputStream in(file.get(), chunk_bytes, num_chunks);
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(5, &read));
+      EXPECT_EQ(read, "34567");
+      EXPECT_EQ(8, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+      EXPECT_EQ(read, "89");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(10, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SkipNBytes) {
+  const string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  for (int64 chunk_bytes : {1, 2, 3, 4, 10, 11}) {
+    for (int num_chunks : {1, 3}) {
+      string read;
+      ReadaheadInputStream in(file.get(), chunk_bytes, num_chunks);
+      TF_ASSERT_OK(in.SkipNBytes(3));
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "34");
+      TF_ASSERT_OK(in.SkipNBytes(0));
+      EXPECT_EQ(5, in.Tell());
+      TF_ASSERT_OK(in.SkipNBytes(5));
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      TF_ASSERT_OK(in.Reset());
+      TF_ASSERT_OK(in.SkipNBytes(8));
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(5)));
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SeekAndReset) {
+  const string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  for (int64 chunk_bytes : {1, 3, 4, 11}) {
+    string read;
+    ReadaheadInputStream in(file.get(), chunk_bytes, 2);
+    TF_ASSERT_OK(in.ReadNBytes(6, &read));
+    EXPECT_EQ(read, "012345");
+    TF_ASSERT_OK(in.Seek(2));
+    TF_ASSERT_OK(in.ReadNBytes(3, &read));
+    EXPECT_EQ(read, "234");
+    TF_ASSERT_OK(in.Seek(7));
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "78");
+    TF_ASSERT_OK(in.Reset());
+    EXPECT_EQ(0, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(10, &read));
+    EXPECT_EQ(read, "0123456789");
+    EXPECT_TRUE(errors::IsInvalidArgument(in.Seek(-1)));
+  }
+}
+
+TEST(ReadaheadInputStream, SharesThreadPool) {
+  string contents;
+  for (int i = 0; i < 1000; ++i) {
+    contents.append(std::to_string(i));
+  }
+  const string fname = WriteTestFile(contents);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  thread::ThreadPool pool(Env::Default(), "test", 2);
+  ReadaheadInputStream first(file.get(), 7, 4, &pool);
+  ReadaheadInputStream second(file.get(), 13, 8, &pool);
+  string first_read, second_read;
+  for (size_t pos = 0; pos < contents.size(); pos += 100) {
+    const int64 n = std::min<int64>(100, contents.size() - pos);
+    TF_ASSERT_OK(first.ReadNBytes(n, &first_read));
+    TF_ASSERT_OK(second.ReadNBytes(n, &second_read));
+    EXPECT_EQ(contents.substr(pos, n), first_read);
+    EXPECT_EQ(contents.substr(pos, n), second_read);
+  }
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
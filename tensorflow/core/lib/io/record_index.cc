@@ -0,0 +1,145 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+constexpr char kMagic[] = "tfrindex";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+constexpr size_t kLengthSize = sizeof(uint64);
+constexpr size_t kHeaderSize = kLengthSize + sizeof(uint32);
+constexpr size_t kFooterSize = sizeof(uint32);
+
+}  // namespace
+
+RecordIndex::RecordIndex() : offsets_({0}) {}
+
+RecordIndex::RecordIndex(std::vector<uint64> offsets)
+    : offsets_(std::move(offsets)) {
+  DCHECK(!offsets_.empty());
+}
+
+string RecordIndex::IndexFilename(const string& filename) {
+  return strings::StrCat(filename, ".index");
+}
+
+Status RecordIndex::Read(Env* env, const string& filename,
+                         RecordIndex* index) {
+  string data;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, IndexFilename(filename), &data));
+  Status s = Decode(data, index);
+  if (!s.ok()) {
+    return errors::DataLoss("Invalid index of ", filename, ": ",
+                            s.error_message());
+  }
+  return Status::OK();
+}
+
+Status RecordIndex::Build(RandomAccessFile* file, RecordIndex* index) {
+  std::vector<uint64> offsets;
+  uint64 offset = 0;
+  char scratch[kHeaderSize];
+  while (true) {
+    offsets.push_back(offset);
+    StringPiece header;
+    Status s = file->Read(offset, kHeaderSize, &header, scratch);
+    if (header.empty() && errors::IsOutOfRange(s)) break;
+    if (header.size() != kHeaderSize) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    const uint32 masked_crc = core::DecodeFixed32(header.data() + kLengthSize);
+    if (crc32c::Unmask(masked_crc) !=
+        crc32c::Value(header.data(), kLengthSize)) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+    const uint64 length = core::DecodeFixed64(header.data());
+    // The footer must be there, as it would be missing from a truncated file.
+    StringPiece footer;
+    s = file->Read(offset + kHeaderSize + length, kFooterSize, &footer,
+                   scratch);
+    if (footer.size() != kFooterSize) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    offset += kHeaderSize + length + kFooterSize;
+  }
+  *index = RecordIndex(std::move(offsets));
+  return Status::OK();
+}
+
+Status RecordIndex::Decode(StringPiece data, RecordIndex* index) {
+  if (data.size() < kMagicSize + 2 * sizeof(uint64) + sizeof(uint32) ||
+      StringPiece(data.data(), kMagicSize) != kMagic) {
+    return errors::DataLoss("not a record index");
+  }
+  const size_t crc_pos = data.size() - sizeof(uint32);
+  const uint32 masked_crc = core::DecodeFixed32(data.data() + crc_pos);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data.data(), crc_pos)) {
+    return errors::DataLoss("corrupted record index");
+  }
+  const uint64 num_records = core::DecodeFixed64(data.data() + kMagicSize);
+  const char* p = data.data() + kMagicSize + sizeof(uint64);
+  if (num_records >= crc_pos / sizeof(uint64) ||
+      crc_pos - (p - data.data()) != (num_records + 1) * sizeof(uint64)) {
+    return errors::DataLoss("record index has the wrong size for ",
+                            num_records, " records");
+  }
+  std::vector<uint64> offsets(num_records + 1);
+  for (uint64& offset : offsets) {
+    offset = core::DecodeFixed64(p);
+    p += sizeof(uint64);
+  }
+  *index = RecordIndex(std::move(offsets));
+  return Status::OK();
+}
+
+void RecordIndex::Encode(string* data) const {
+  data->clear();
+  data->reserve(kMagicSize + (offsets_.size() + 1) * sizeof(uint64) +
+                sizeof(uint32));
+  data->append(kMagic, kMagicSize);
+  core::PutFixed64(data, num_records());
+  for (uint64 offset : offsets_) {
+    core::PutFixed64(data, offset);
+  }
+  core::PutFixed32(data,
+                   crc32c::Mask(crc32c::Value(data->data(), data->size())));
+}
+
+Status RecordIndex::Write(Env* env, const string& filename) const {
+  string data;
+  Encode(&data);
+  // Write to a temporary file first, so that readers never see a partial
+  // index.
+  const string index_filename = IndexFilename(filename);
+  const string tmp_filename = strings::StrCat(index_filename, ".tmp");
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_filename, data));
+  return env->RenameFile(tmp_filename, index_filename);
+}
+
+}  // namespace io
+}  // namespace tensorflow
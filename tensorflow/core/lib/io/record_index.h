@@ -0,0 +1,80 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+class RandomAccessFile;
+
+namespace io {
+
+// The offsets of the records of an uncompressed TFRecord file, which allow
+// reading any record without reading the records before it.
+//
+// The index of a file is stored next to it, in IndexFilename(filename):
+//   char      magic[8]      "tfrindex"
+//   uint64    num_records
+//   uint64    offsets[num_records + 1]
+//   uint32    masked crc of the preceding bytes
+// where offsets[num_records] is the end of the last record.
+class RecordIndex {
+ public:
+  // An index of an empty file.
+  RecordIndex();
+
+  // `offsets` holds the offset of each record, then the end of the last one.
+  explicit RecordIndex(std::vector<uint64> offsets);
+
+  // Returns the name of the index of the TFRecord file `filename`.
+  static string IndexFilename(const string& filename);
+
+  // Reads the index of the TFRecord file `filename`. Returns NotFound if the
+  // file has no index.
+  static Status Read(Env* env, const string& filename, RecordIndex* index);
+
+  // Builds the index of an uncompressed TFRecord file by reading the header
+  // of each of its records.
+  static Status Build(RandomAccessFile* file, RecordIndex* index);
+
+  // Parses the encoding of an index (see above).
+  static Status Decode(StringPiece data, RecordIndex* index);
+
+  void Encode(string* data) const;
+
+  // Writes the index of the TFRecord file `filename`.
+  Status Write(Env* env, const string& filename) const;
+
+  int64 num_records() const { return offsets_.size() - 1; }
+
+  // Returns the offset of record `i`, for 0 <= i <= num_records().
+  uint64 offset(int64 i) const { return offsets_[i]; }
+
+ private:
+  std::vector<uint64> offsets_;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_RECORD_INDEX_H_
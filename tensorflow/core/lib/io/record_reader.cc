@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -57,9 +58,14 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 RecordReader::RecordReader(RandomAccessFile* file,
                            const RecordReaderOptions& options)
     : options_(options),
-      input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.buffer_size > 0 && options.readahead_num_chunks > 0) {
+    input_stream_.reset(new ReadaheadInputStream(
+        file, options.buffer_size, options.readahead_num_chunks));
+  } else {
+    input_stream_.reset(new RandomAccessInputStream(file));
+  }
+  if (options.buffer_size > 0 && options.readahead_num_chunks <= 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
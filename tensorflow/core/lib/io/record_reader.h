@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -42,6 +43,12 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If both buffer_size and readahead_num_chunks are non-zero, up to
+  // readahead_num_chunks reads of buffer_size bytes ahead of the current
+  // record are kept in flight, so that reading a record rarely waits for the
+  // file system. Seeking backward drops the chunks read ahead.
+  int readahead_num_chunks = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -114,6 +121,18 @@ class SequentialRecordReader {
     return Status::OK();
   }
 
+  // Seeks to the record numbered `record_number` in `index`, the index of
+  // the file. Unlike SeekOffset(), may seek backward.
+  Status SeekRecord(const RecordIndex& index, int64 record_number) {
+    if (record_number < 0 || record_number > index.num_records()) {
+      return errors::InvalidArgument("Trying to seek to record ",
+                                     record_number, " of ",
+                                     index.num_records());
+    }
+    offset_ = index.offset(record_number);
+    return Status::OK();
+  }
+
  private:
   RecordReader underlying_;
   uint64 offset_ = 0;
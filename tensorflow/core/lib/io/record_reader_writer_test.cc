@@ -189,4 +189,72 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  std::vector<string> records = {"abc", "", "defg", string(1000, 'x'), "h"};
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriterOptions options;
+    options.build_index = true;
+    io::RecordWriter writer(file.get(), options);
+    for (const string& record : records) {
+      TF_EXPECT_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+    TF_CHECK_OK(writer.index().Write(env, fname));
+  }
+
+  io::RecordIndex index;
+  TF_ASSERT_OK(io::RecordIndex::Read(env, fname, &index));
+  ASSERT_EQ(records.size(), index.num_records());
+  EXPECT_EQ(GetFileSize(fname), index.offset(index.num_records()));
+
+  // An index built by scanning the file is the same.
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordIndex built;
+  TF_ASSERT_OK(io::RecordIndex::Build(read_file.get(), &built));
+  ASSERT_EQ(index.num_records(), built.num_records());
+  for (int64 i = 0; i <= index.num_records(); ++i) {
+    EXPECT_EQ(index.offset(i), built.offset(i));
+  }
+
+  for (auto buf_size : {0, 3, 65536}) {
+    io::RecordReaderOptions options;
+    options.buffer_size = buf_size;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    string record;
+    for (int64 i : {3, 0, 4, 2, 2, 1}) {
+      TF_ASSERT_OK(reader.SeekRecord(index, i));
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(records[i], record);
+    }
+    TF_ASSERT_OK(reader.SeekRecord(index, index.num_records()));
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        reader.SeekRecord(index, index.num_records() + 1)));
+  }
+}
+
+TEST(RecordReaderWriterTest, TestCorruptIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_corrupt_index";
+  EXPECT_TRUE(errors::IsNotFound(
+      io::RecordIndex::Read(env, fname, nullptr)));
+
+  string data;
+  io::RecordIndex({0, 15, 31}).Encode(&data);
+  io::RecordIndex index;
+  TF_ASSERT_OK(io::RecordIndex::Decode(data, &index));
+  EXPECT_EQ(2, index.num_records());
+  EXPECT_EQ(15, index.offset(1));
+
+  data[data.size() - 10] ^= 1;
+  EXPECT_TRUE(errors::IsDataLoss(io::RecordIndex::Decode(data, &index)));
+  EXPECT_TRUE(errors::IsDataLoss(io::RecordIndex::Decode("tfrindex", &index)));
+}
+
 }  // namespace tensorflow
@@ -72,6 +72,11 @@ RecordWriter::RecordWriter(WritableFile* dest,
     }
     dest_ = zlib_output_buffer;
 #endif  // IS_SLIM_BUILD
+    if (options.build_index) {
+      LOG(ERROR) << "Compressed files can't be indexed. No index will be "
+                 << "built.";
+      options_.build_index = false;
+    }
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
   } else {
@@ -107,7 +112,22 @@ Status RecordWriter::WriteRecord(StringPiece data) {
 
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  if (options_.build_index) {
+    record_offsets_.push_back(num_bytes_);
+    num_bytes_ += sizeof(header) + data.size() + sizeof(footer);
+  }
+  return Status::OK();
+}
+
+RecordIndex RecordWriter::index() const {
+  DCHECK(options_.build_index);
+  std::vector<uint64> offsets;
+  offsets.reserve(record_offsets_.size() + 1);
+  offsets.insert(offsets.end(), record_offsets_.begin(),
+                 record_offsets_.end());
+  offsets.push_back(num_bytes_);
+  return RecordIndex(std::move(offsets));
 }
 
 Status RecordWriter::Close() {
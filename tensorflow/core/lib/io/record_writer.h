@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
@@ -39,6 +42,10 @@ class RecordWriterOptions {
   static RecordWriterOptions CreateRecordWriterOptions(
       const string& compression_type);
 
+  // If true, the writer keeps the offset of every record, so that index() can
+  // be written next to the file. Not supported with compression.
+  bool build_index = false;
+
 // Options specific to zlib compression.
 #if !defined(IS_SLIM_BUILD)
   ZlibCompressionOptions zlib_options;
@@ -72,9 +79,17 @@ class RecordWriter {
   // are invalid.
   Status Close();
 
+  // Returns the index of the records written so far. Requires
+  // `options.build_index`.
+  RecordIndex index() const;
+
  private:
   WritableFile* dest_;
   RecordWriterOptions options_;
+  // The number of bytes written and the offset of each record, if
+  // `options_.build_index`.
+  uint64 num_bytes_ = 0;
+  std::vector<uint64> record_offsets_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordWriter);
 };
@@ -62,6 +62,12 @@ class Table {
   // be close to the file length.
   uint64 ApproximateOffsetOf(const StringPiece& key) const;
 
+  // Looks up "key".  If the table contains it, sets "*value" to its value
+  // and "*found" to true, otherwise sets "*found" to false.  Unlike a seek
+  // of an iterator, this consults the filter block of the table, if any,
+  // so that most lookups of absent keys read no data block.
+  Status Get(const StringPiece& key, string* value, bool* found) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -69,12 +75,16 @@ class Table {
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const StringPiece&);
 
+  // Reads the meta blocks listed in the metaindex block, i.e. the filter
+  // block, if any.
+  void ReadMeta(const Footer& footer);
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
   Status InternalGet(const StringPiece& key, void* arg,
                      void (*handle_result)(void* arg, const StringPiece& k,
-                                           const StringPiece& v));
+                                           const StringPiece& v)) const;
 
   // No copying allowed
   Table(const Table&);
@@ -21,6 +21,8 @@ limitations under the License.
 namespace tensorflow {
 namespace table {
 
+class Cache;
+
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
 // being stored in a file.  The following enum describes which
@@ -60,6 +62,22 @@ struct Options {
   // incompressible, the kSnappyCompression implementation will
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression = kSnappyCompression;
+
+  // If positive, a table builder writes a bloom filter block with about
+  // this many bits per key, which lets Table::Get() skip reading the data
+  // block for most keys that are absent from it.  10 bits per key give
+  // about 1% false positives.  Tables with a filter block remain readable
+  // by readers that don't know about it.
+  //
+  // Default: 0, i.e. no filter block.
+  int filter_bits_per_key = 0;
+
+  // If non-null, use the specified cache for the (uncompressed) data
+  // blocks that a table reads.  The cache may be shared by many tables,
+  // and must outlive them.  See NewLRUCache() in cache.h.
+  //
+  // Default: nullptr, i.e. every lookup reads its block from the file.
+  Cache* block_cache = nullptr;
 };
 
 }  // namespace table
@@ -17,16 +17,20 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -223,8 +227,7 @@ class TableConstructor : public Constructor {
 
     // Open the table
     source_ = new StringSource(sink.contents());
-    Options table_options;
-    return Table::Open(table_options, source_, sink.contents().size(), &table_);
+    return Table::Open(options, source_, sink.contents().size(), &table_);
   }
 
   Iterator* NewIterator() const override { return table_->NewIterator(); }
@@ -235,6 +238,8 @@ class TableConstructor : public Constructor {
 
   uint64 BytesRead() const { return source_->BytesRead(); }
 
+  const Table* table() const { return table_; }
+
  private:
   void Reset() {
     delete table_;
@@ -621,5 +626,69 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, GetWithBloomFilter) {
+  TableConstructor c;
+  const int kNumKeys = 1000;
+  for (int i = 0; i < kNumKeys; ++i) {
+    c.Add(strings::StrCat("k", 2 * i), strings::StrCat("v", i));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kNoCompression;
+  options.filter_bits_per_key = 10;
+  c.Finish(options, &keys, &kvmap);
+
+  string value;
+  bool found;
+  for (int i = 0; i < kNumKeys; ++i) {
+    TF_ASSERT_OK(c.table()->Get(strings::StrCat("k", 2 * i), &value, &found));
+    ASSERT_TRUE(found);
+    EXPECT_EQ(strings::StrCat("v", i), value);
+  }
+
+  // Each lookup of an absent key would read a data block without the
+  // filter, but reads one only for the ~1% false positives with it.
+  const uint64 bytes_read = c.BytesRead();
+  for (int i = 0; i < kNumKeys; ++i) {
+    TF_ASSERT_OK(
+        c.table()->Get(strings::StrCat("k", 2 * i + 1), &value, &found));
+    ASSERT_FALSE(found);
+  }
+  EXPECT_LT(c.BytesRead() - bytes_read, 50 * options.block_size);
+}
+
+TEST(TableTest, BlockCache) {
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  TableConstructor c;
+  c.Add("k01", "firstvalue");
+  c.Add("k02", string(1000, 'x'));
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kNoCompression;
+  options.block_cache = cache.get();
+  c.Finish(options, &keys, &kvmap);
+
+  string value;
+  bool found;
+  TF_ASSERT_OK(c.table()->Get("k02", &value, &found));
+  ASSERT_TRUE(found);
+  const uint64 bytes_read = c.BytesRead();
+  EXPECT_GT(cache->TotalCharge(), 1000);
+
+  // The second lookup and an iterator find the block in the cache.
+  TF_ASSERT_OK(c.table()->Get("k02", &value, &found));
+  ASSERT_TRUE(found);
+  EXPECT_EQ(string(1000, 'x'), value);
+  std::unique_ptr<Iterator> iter(c.NewIterator());
+  iter->Seek("k02");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(string(1000, 'x'), iter->value());
+  EXPECT_EQ(bytes_read, c.BytesRead());
+}
+
 }  // namespace table
 }  // namespace tensorflow
@@ -183,6 +183,49 @@ class PhiloxRandom {
     return counter;
   }
 
+  // The number of groups that GenerateBatch() returns.
+  static const int kBatchSize = 16;
+
+  // Returns the next kBatchSize groups of four random numbers in "results",
+  // exactly as kBatchSize calls of operator() would. The rounds run on all
+  // the groups at once over arrays of counter words, which the compiler
+  // turns into SIMD code on the CPU.
+  inline void GenerateBatch(ResultType* results) {
+    uint32 c0[kBatchSize];
+    uint32 c1[kBatchSize];
+    uint32 c2[kBatchSize];
+    uint32 c3[kBatchSize];
+    for (int i = 0; i < kBatchSize; ++i) {
+      c0[i] = counter_[0];
+      c1[i] = counter_[1];
+      c2[i] = counter_[2];
+      c3[i] = counter_[3];
+      SkipOne();
+    }
+
+    uint32 key0 = key_[0];
+    uint32 key1 = key_[1];
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        const uint64 product0 = static_cast<uint64>(kPhiloxM4x32A) * c0[i];
+        const uint64 product1 = static_cast<uint64>(kPhiloxM4x32B) * c2[i];
+        c0[i] = static_cast<uint32>(product1 >> 32) ^ c1[i] ^ key0;
+        c1[i] = static_cast<uint32>(product1);
+        c2[i] = static_cast<uint32>(product0 >> 32) ^ c3[i] ^ key1;
+        c3[i] = static_cast<uint32>(product0);
+      }
+      key0 += kPhiloxW32A;
+      key1 += kPhiloxW32B;
+    }
+
+    for (int i = 0; i < kBatchSize; ++i) {
+      results[i][0] = c0[i];
+      results[i][1] = c1[i];
+      results[i][2] = c2[i];
+      results[i][3] = c3[i];
+    }
+  }
+
  private:
   // We use the same constants as recommended by the original paper.
   static const uint32 kPhiloxW32A = 0x9E3779B9;
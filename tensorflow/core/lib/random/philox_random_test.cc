@@ -68,6 +68,29 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// This test checks that a batch holds the same samples as the same number of
+// single generations, and that both continue the stream in the same way.
+TEST(PhiloxRandomTest, BatchMatchTest) {
+  // Starts right below a carry into the second counter word.
+  PhiloxRandom gen1(GetTestSeed());
+  gen1.Skip(0xFFFFFFF8ull);
+  PhiloxRandom gen2 = gen1;
+
+  PhiloxRandom::ResultType batch[PhiloxRandom::kBatchSize];
+  gen1.GenerateBatch(batch);
+  for (int i = 0; i < PhiloxRandom::kBatchSize; ++i) {
+    const PhiloxRandom::ResultType sample = gen2();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(sample[j], batch[i][j]) << i << " " << j;
+    }
+  }
+  const PhiloxRandom::ResultType next1 = gen1();
+  const PhiloxRandom::ResultType next2 = gen2();
+  for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+    EXPECT_EQ(next1[j], next2[j]);
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
@@ -95,6 +95,8 @@ REGISTER_OP("CTCBeamSearchDecoder")
     .Attr("beam_width: int >= 1")
     .Attr("top_paths: int >= 1")
     .Attr("merge_repeated: bool = true")
+    .Attr("label_selection_size: int >= 0 = 0")
+    .Attr("label_selection_margin: float = -1")
     .Output("decoded_indices: top_paths * int64")
     .Output("decoded_values: top_paths * int64")
     .Output("decoded_shape: top_paths * int64")
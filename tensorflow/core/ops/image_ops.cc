@@ -151,6 +151,37 @@ REGISTER_OP("ResizeBilinear")
     .Attr("align_corners: bool = false")
     .SetShapeFn(ResizeShapeFn);
 
+// --------------------------------------------------------------------------
+REGISTER_OP("_FusedResizeBilinearNormalize")
+    .Input("images: T")
+    .Input("size: int32")
+    .Input("mean: float")
+    .Input("scale: float")
+    .Output("output: out_type")
+    .Attr("T: {uint8, float}")
+    .Attr("out_type: {float, bfloat16} = DT_FLOAT")
+    .Attr("align_corners: bool = false")
+    .Attr("data_format: {'NHWC', 'NCHW'} = 'NHWC'")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(ResizeShapeFn(c));
+      string data_format;
+      TF_RETURN_IF_ERROR(c->GetAttr("data_format", &data_format));
+      if (data_format == "NCHW") {
+        ShapeHandle nhwc = c->output(0);
+        c->set_output(0, c->MakeShape({c->Dim(nhwc, 0), c->Dim(nhwc, 3),
+                                       c->Dim(nhwc, 1), c->Dim(nhwc, 2)}));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes `(ResizeBilinear(images, size) - mean) * scale` in a single pass, and
+converts the result to `out_type` and `data_format`. `mean` and `scale` are
+scalars or vectors with one value per channel.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("QuantizedResizeBilinear")
     .Input("images: T")
@@ -311,6 +342,50 @@ REGISTER_OP("DecodeAndCropJpeg")
       return Status::OK();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeImageBatch")
+    .Input("contents: string")
+    .Input("crop_windows: int32")
+    .Attr("height: int")
+    .Attr("width: int")
+    .Attr("channels: int = 3")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("dct_method: string = ''")
+    .Attr("ignore_errors: bool = false")
+    .Output("images: uint8")
+    .Output("valid: bool")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &crop_windows));
+      DimensionHandle batch_dim = c->Dim(contents, 0);
+      TF_RETURN_IF_ERROR(
+          c->Merge(batch_dim, c->Dim(crop_windows, 0), &batch_dim));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->WithValue(c->Dim(crop_windows, 1), 4, &unused_dim));
+
+      int32 height;
+      TF_RETURN_IF_ERROR(c->GetAttr("height", &height));
+      int32 width;
+      TF_RETURN_IF_ERROR(c->GetAttr("width", &width));
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (height <= 0 || width <= 0) {
+        return errors::InvalidArgument(
+            "height and width must be positive, got ", height, " and ",
+            width);
+      }
+      if (channels != 1 && channels != 3) {
+        return errors::InvalidArgument("channels must be 1 or 3, got ",
+                                       channels);
+      }
+      c->set_output(0, c->MakeShape({batch_dim, height, width, channels}));
+      c->set_output(1, c->Vector(batch_dim));
+      return Status::OK();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
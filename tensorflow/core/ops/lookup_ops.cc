@@ -306,6 +306,17 @@ REGISTER_OP("MutableDenseHashTableV2")
     .SetIsStateful()
     .SetShapeFn(ScalarOutput);
 
+REGISTER_OP("VocabularyIndexTable")
+    .Output("table_handle: resource")
+    .Attr("index_file: string")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: {string} = DT_STRING")
+    .Attr("value_dtype: {int64} = DT_INT64")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput);
+
 REGISTER_OP("InitializeTable")
     .Input("table_handle: Ref(string)")
     .Input("keys: Tkey")
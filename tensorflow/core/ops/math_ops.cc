@@ -189,6 +189,25 @@ REGISTER_OP("Sqrt").UNARY_COMPLEX();
 
 REGISTER_OP("SqrtGrad").UNARY_GRADIENT_COMPLEX();
 
+// Declares the MKL versions of cwise unary operations that map 0 to 0. They
+// take and produce the MKL layout metadata of x and y, which have the same
+// layout.
+#define MKL_UNARY()                     \
+  Input("x: T")                         \
+      .Input("mkl_x: uint8")            \
+      .Output("y: T")                   \
+      .Output("mkl_y: uint8")           \
+      .Attr("T: {half, float, double}") \
+      .SetShapeFn(shape_inference::UnchangedShape)
+
+REGISTER_OP("_MklAbs").MKL_UNARY();
+
+REGISTER_OP("_MklNeg").MKL_UNARY();
+
+REGISTER_OP("_MklSqrt").MKL_UNARY();
+
+REGISTER_OP("_MklSquare").MKL_UNARY();
+
 REGISTER_OP("Rsqrt").UNARY_COMPLEX();
 
 REGISTER_OP("Round").UNARY();
@@ -256,6 +275,24 @@ REGISTER_OP("_UnaryOpsComposition")
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("x: T")
+    .Input("args: num_args * T")
+    .Output("y: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("op_names: list(string)")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Applies the elementwise ops `op_names` in order, starting with `x`. Each binary
+op takes the result so far as its first operand, and the next tensor of `args`
+as its second one. An argument must have the shape of `x`, be a scalar, or be a
+vector broadcast along the last dimension of `x`, like the bias of `BiasAdd`.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 #undef UNARY
 #undef UNARY_REAL
 #undef UNARY_COMPLEX
@@ -1469,6 +1506,43 @@ REGISTER_OP("QuantizedMatMul")
       return Status::OK();
     });
 
+REGISTER_OP("QuantizedMatMulWithBiasAndRelu")
+    .Input("a: T1")
+    .Input("b: T2")
+    .Input("bias: float")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Input("min_freezed_output: float")
+    .Input("max_freezed_output: float")
+    .Output("out: Toutput")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("T1: {quint8}")
+    .Attr("T2: {qint8}")
+    .Attr("Toutput: {quint8} = DT_QUINT8")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(a, 1), c->Dim(b, 0), &unused_dim));
+      c->set_output(0, c->Matrix(c->Dim(a, 0), c->Dim(b, 1)));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 0, &unused));
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    });
+
 REGISTER_OP("QuantizedMul")
     .Input("x: T1")
     .Input("y: T2")
@@ -611,4 +611,46 @@ REGISTER_OP("SparseFillEmptyRowsGrad")
       return Status::OK();
     });
 
+REGISTER_OP("FusedEmbeddingLookupSparse")
+    .Input("params: num_partitions * T")
+    .Input("indices: int64")
+    .Input("ids: Tids")
+    .Input("weights: T")
+    .Output("output: T")
+    .Attr("num_partitions: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("Tids: {int32, int64}")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'}")
+    .Attr("partition_strategy: {'mod', 'div'} = 'mod'")
+    .SetShapeFn([](InferenceContext* c) {
+      int num_partitions;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_partitions", &num_partitions));
+      ShapeHandle row_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &row_shape));
+      TF_RETURN_IF_ERROR(c->Subshape(row_shape, 1, &row_shape));
+      for (int i = 1; i < num_partitions; ++i) {
+        ShapeHandle partition_row_shape;
+        TF_RETURN_IF_ERROR(
+            c->WithRankAtLeast(c->input(i), 1, &partition_row_shape));
+        TF_RETURN_IF_ERROR(
+            c->Subshape(partition_row_shape, 1, &partition_row_shape));
+        TF_RETURN_IF_ERROR(
+            c->Merge(row_shape, partition_row_shape, &row_shape));
+      }
+      ShapeHandle indices;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(num_partitions), 2, &indices));
+      ShapeHandle ids;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(num_partitions + 1), 1, &ids));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(indices, 0), c->Dim(ids, 0), &unused));
+      ShapeHandle weights;
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(num_partitions + 2), 1, &weights));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->Vector(InferenceContext::kUnknownDim), row_shape, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
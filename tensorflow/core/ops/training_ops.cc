@@ -1053,4 +1053,75 @@ REGISTER_OP("ResourceApplyPowerSign")
       return ApplyPowerSignShapeFn(c, /*sparse=*/false);
     });
 
+// Checks the inputs of a fused apply op.  Its inputs are lists of `N` tensors
+// each: the lists of the variables and their slots, the first
+// `num_variables`, then the lists of scalar hyperparameters, with the list of
+// the gradients at `grad_list`.
+static Status FusedApplyShapeFn(InferenceContext* c, int num_variables,
+                                int grad_list) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  const int num_lists = c->num_inputs() / n;
+  ShapeHandle unused;
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = ShapeOrHandleShape(c, i);
+    for (int list = 1; list < num_lists; ++list) {
+      const int input = list * n + i;
+      if (list < num_variables || list == grad_list) {
+        TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, input), &s));
+      } else {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(input), 0, &unused));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+REGISTER_OP("_FusedResourceApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: N * T")
+    .Input("beta2_power: N * T")
+    .Input("lr: N * T")
+    .Input("beta1: N * T")
+    .Input("beta2: N * T")
+    .Input("epsilon: N * T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: {half, float, double}")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return FusedApplyShapeFn(c, 3 /* num_variables */, 9 /* grad_list */);
+    })
+    .Doc(R"doc(
+Applies `ResourceApplyAdam` to `N` variables at once. Each input of
+`ResourceApplyAdam` is a list of `N` tensors, one for each variable.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedResourceApplyMomentum")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: N * T")
+    .Input("grad: N * T")
+    .Input("momentum: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: {half, float, double}")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return FusedApplyShapeFn(c, 2 /* num_variables */, 3 /* grad_list */);
+    })
+    .Doc(R"doc(
+Applies `ResourceApplyMomentum` to `N` variables at once. Each input of
+`ResourceApplyMomentum` is a list of `N` tensors, one for each variable.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 }  // namespace tensorflow
@@ -0,0 +1,347 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kBlockFileSuffix[] = ".blk";
+constexpr char kTempFileInfix[] = ".tmp.";
+constexpr char kLockFileName[] = "lock";
+// The temporary files older than this were left by crashed processes.
+constexpr int64 kTempFileMaxAgeSecs = 600;
+// The size of the header of a block file: the timestamp at which the block
+// was fetched, and the size of the filename that follows it.
+constexpr size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+
+#ifndef _WIN32
+// Holds an exclusive lock on a file while in scope.
+class FileLock {
+ public:
+  explicit FileLock(const string& path)
+      : fd_(open(path.c_str(), O_RDWR | O_CREAT, 0644)) {
+    if (fd_ >= 0 && flock(fd_, LOCK_EX) != 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+  ~FileLock() {
+    if (fd_ >= 0) {
+      close(fd_);  // Releases the lock.
+    }
+  }
+
+ private:
+  int fd_;
+};
+#endif
+
+}  // namespace
+
+DiskFileBlockCache::DiskFileBlockCache(const string& directory,
+                                       size_t block_size, size_t max_bytes,
+                                       uint64 max_staleness,
+                                       BlockFetcher block_fetcher, Env* env)
+    : directory_(directory),
+      block_size_(block_size),
+      max_bytes_(max_bytes),
+      max_staleness_(max_staleness),
+      block_fetcher_(std::move(block_fetcher)),
+      env_(env) {
+  if (block_size_ == 0 || max_bytes_ == 0) {
+    VLOG(1) << "Disk file block cache is disabled";
+    return;
+  }
+  const Status status = env_->RecursivelyCreateDir(directory_);
+  directory_ok_ = status.ok() || status.code() == error::ALREADY_EXISTS;
+  if (!directory_ok_) {
+    LOG(WARNING) << "Disk file block cache is disabled, since its directory "
+                 << directory_ << " can't be created: " << status;
+    return;
+  }
+  // Evicts the blocks over max_bytes_, and estimates the size of the others.
+  mutex_lock l(mu_);
+  Evict();
+  VLOG(1) << "Disk file block cache in " << directory_ << " is enabled";
+}
+
+Status DiskFileBlockCache::Read(const string& filename, size_t offset,
+                                size_t n, char* buffer,
+                                size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  if (n == 0) {
+    return Status::OK();
+  }
+  if (!IsCacheEnabled()) {
+    return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
+  }
+  // Calculate the block-aligned start and end of the read.
+  size_t start = block_size_ * (offset / block_size_);
+  size_t finish = block_size_ * ((offset + n) / block_size_);
+  if (finish < offset + n) {
+    finish += block_size_;
+  }
+  size_t total_bytes_transferred = 0;
+  string data;
+  for (size_t pos = start; pos < finish; pos += block_size_) {
+    TF_RETURN_IF_ERROR(GetBlock(filename, pos, &data));
+    if (offset >= pos + data.size()) {
+      // The requested offset is at or beyond the end of the file.
+      *bytes_transferred = total_bytes_transferred;
+      return errors::OutOfRange("EOF at offset ", offset, " in file ", filename,
+                                " at position ", pos, " with data size ",
+                                data.size());
+    }
+    const size_t begin = offset > pos ? offset - pos : 0;
+    const size_t end = std::min(data.size(), offset + n - pos);
+    if (begin < end) {
+      memcpy(&buffer[total_bytes_transferred], &data[begin], end - begin);
+      total_bytes_transferred += end - begin;
+    }
+    if (data.size() < block_size_) {
+      // The block was a partial block and thus signals EOF at its upper bound.
+      break;
+    }
+  }
+  *bytes_transferred = total_bytes_transferred;
+  return Status::OK();
+}
+
+Status DiskFileBlockCache::GetBlock(const string& filename, size_t offset,
+                                    string* data) {
+  const string path = BlockPath(filename, offset);
+  if (ReadBlockFile(path, filename, data)) {
+#ifndef _WIN32
+    // The modification time of a block file is its recency for the eviction.
+    utime(path.c_str(), nullptr);
+#endif
+    return Status::OK();
+  }
+  data->resize(block_size_);
+  size_t bytes_transferred;
+  TF_RETURN_IF_ERROR(block_fetcher_(filename, offset, block_size_, &(*data)[0],
+                                    &bytes_transferred));
+  data->resize(bytes_transferred);
+  const Status status = WriteBlockFile(path, filename, *data);
+  if (!status.ok()) {
+    VLOG(1) << "Could not cache a block of " << filename << " in " << path
+            << ": " << status;
+  }
+  return Status::OK();
+}
+
+bool DiskFileBlockCache::ReadBlockFile(const string& path,
+                                       const string& filename, string* data) {
+  uint64 file_size;
+  std::unique_ptr<RandomAccessFile> file;
+  if (!env_->GetFileSize(path, &file_size).ok() || file_size < kHeaderSize ||
+      !env_->NewRandomAccessFile(path, &file).ok()) {
+    return false;
+  }
+  // Another process may replace the file after GetFileSize(), but only with
+  // the same block, which has the same size.
+  string scratch(file_size, '\0');
+  StringPiece contents;
+  if (!file->Read(0, file_size, &contents, &scratch[0]).ok() ||
+      contents.size() != file_size) {
+    return false;
+  }
+  const uint64 timestamp = core::DecodeFixed64(contents.data());
+  const uint32 filename_size = core::DecodeFixed32(contents.data() + 8);
+  if (max_staleness_ > 0 && env_->NowSeconds() - timestamp > max_staleness_) {
+    return false;
+  }
+  // The name of a block file only holds a hash of the filename.
+  const size_t data_offset = kHeaderSize + filename_size;
+  if (file_size < data_offset ||
+      StringPiece(contents.data() + kHeaderSize, filename_size) != filename) {
+    return false;
+  }
+  data->assign(contents.data() + data_offset, file_size - data_offset);
+  return true;
+}
+
+Status DiskFileBlockCache::WriteBlockFile(const string& path,
+                                          const string& filename,
+                                          const string& data) {
+  string header;
+  core::PutFixed64(&header, env_->NowSeconds());
+  core::PutFixed32(&header, filename.size());
+  // The block is written to a temporary file and renamed, so that the other
+  // processes never read a partial block.
+  const string tmp_path = strings::StrCat(path, kTempFileInfix,
+                                          strings::Hex(random::New64()));
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(tmp_path, &file));
+  Status status = file->Append(header);
+  if (status.ok()) status = file->Append(filename);
+  if (status.ok()) status = file->Append(data);
+  status.Update(file->Close());
+  if (status.ok()) {
+    status = env_->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return status;
+  }
+  mutex_lock l(mu_);
+  estimated_size_ += header.size() + filename.size() + data.size();
+  if (estimated_size_ > max_bytes_) {
+    Evict();
+  }
+  return Status::OK();
+}
+
+string DiskFileBlockCache::BlockPrefix(const string& filename) const {
+  return strings::StrCat(strings::Hex(Hash64(filename), strings::ZERO_PAD_16),
+                         "_");
+}
+
+string DiskFileBlockCache::BlockPath(const string& filename, size_t offset) {
+  int64 file_signature = 0;
+  {
+    mutex_lock l(mu_);
+    auto it = file_signature_map_.find(filename);
+    if (it != file_signature_map_.end()) {
+      file_signature = it->second;
+    }
+  }
+  return io::JoinPath(directory_,
+                      strings::StrCat(BlockPrefix(filename), file_signature,
+                                      "_", offset, kBlockFileSuffix));
+}
+
+bool DiskFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
+                                                        int64 file_signature) {
+  {
+    mutex_lock l(mu_);
+    auto it = file_signature_map_.find(filename);
+    if (it == file_signature_map_.end()) {
+      file_signature_map_[filename] = file_signature;
+      return true;
+    }
+    if (it->second == file_signature) {
+      return true;
+    }
+    it->second = file_signature;
+  }
+  RemoveFile(filename);
+  return false;
+}
+
+void DiskFileBlockCache::RemoveFile(const string& filename) {
+  RemoveBlockFiles(BlockPrefix(filename));
+}
+
+void DiskFileBlockCache::Flush() { RemoveBlockFiles(""); }
+
+void DiskFileBlockCache::RemoveBlockFiles(const string& prefix) {
+  std::vector<string> children;
+  if (!env_->GetChildren(directory_, &children).ok()) {
+    return;
+  }
+  for (const string& child : children) {
+    if (str_util::StartsWith(child, prefix) &&
+        str_util::EndsWith(child, kBlockFileSuffix)) {
+      // The file may already have been removed by another process.
+      env_->DeleteFile(io::JoinPath(directory_, child)).IgnoreError();
+    }
+  }
+}
+
+size_t DiskFileBlockCache::CacheSize() const {
+  std::vector<string> children;
+  if (!env_->GetChildren(directory_, &children).ok()) {
+    return 0;
+  }
+  size_t size = 0;
+  for (const string& child : children) {
+    uint64 file_size;
+    if (str_util::EndsWith(child, kBlockFileSuffix) &&
+        env_->GetFileSize(io::JoinPath(directory_, child), &file_size).ok()) {
+      size += file_size;
+    }
+  }
+  return size;
+}
+
+void DiskFileBlockCache::Evict() {
+#ifndef _WIN32
+  // Serializes the evictions of the processes sharing the directory.
+  FileLock lock(io::JoinPath(directory_, kLockFileName));
+#endif
+  std::vector<string> children;
+  if (!env_->GetChildren(directory_, &children).ok()) {
+    return;
+  }
+  struct BlockFile {
+    int64 mtime_nsec;
+    uint64 size;
+    string path;
+  };
+  std::vector<BlockFile> block_files;
+  size_t total_size = 0;
+  const int64 now_nsec = env_->NowMicros() * 1000;
+  for (const string& child : children) {
+    const string path = io::JoinPath(directory_, child);
+    FileStatistics stat;
+    if (!env_->Stat(path, &stat).ok()) {
+      continue;  // Removed by another process.
+    }
+    if (str_util::EndsWith(child, kBlockFileSuffix)) {
+      block_files.push_back({stat.mtime_nsec, static_cast<uint64>(stat.length),
+                             path});
+      total_size += stat.length;
+    } else if (child.find(kTempFileInfix) != string::npos &&
+               now_nsec - stat.mtime_nsec > kTempFileMaxAgeSecs * 1000000000) {
+      env_->DeleteFile(path).IgnoreError();
+    }
+  }
+  std::sort(block_files.begin(), block_files.end(),
+            [](const BlockFile& a, const BlockFile& b) {
+              return a.mtime_nsec < b.mtime_nsec;
+            });
+  const size_t target_size = max_bytes_ / 10 * 9;
+  for (const BlockFile& block_file : block_files) {
+    if (total_size <= target_size) {
+      break;
+    }
+    env_->DeleteFile(block_file.path).IgnoreError();
+    total_size -= block_file.size;
+  }
+  estimated_size_ = total_size;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,147 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
+
+#include <map>
+#include <string>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief An LRU block cache of file contents in a local directory, keyed by
+/// {filename, file signature, offset}.
+///
+/// Each block is stored in its own file of the directory, written to a
+/// temporary file and renamed into place, so that the directory can be shared
+/// by the caches of several processes, e.g. the training processes of a node,
+/// and can outlive them, e.g. across the epochs over a dataset larger than the
+/// RAM. The recency of a block is the modification time of its file, which is
+/// updated on each hit. When the blocks written by this process make the
+/// directory exceed `max_bytes`, the least recently used blocks of all the
+/// processes are evicted, under a lock file, down to 90% of `max_bytes`.
+class DiskFileBlockCache : public FileBlockCache {
+ public:
+  DiskFileBlockCache(const string& directory, size_t block_size,
+                     size_t max_bytes, uint64 max_staleness,
+                     BlockFetcher block_fetcher, Env* env = Env::Default());
+
+  /// Read `n` bytes from `filename` starting at `offset` into `out`. This
+  /// method will return:
+  ///
+  /// 1) The error from the remote filesystem, if the read from the remote
+  ///    filesystem failed.
+  /// 2) OUT_OF_RANGE if the read from the remote filesystem succeeded, but
+  ///    the file contents do not extend past `offset` and thus nothing was
+  ///    placed in `out`.
+  /// 3) OK otherwise (i.e. the read succeeded, and at least one byte was placed
+  ///    in `out`).
+  ///
+  /// Failures to read or write the cache directory are not errors: the blocks
+  /// are fetched from the remote filesystem instead.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred) override;
+
+  // Validate the given file signature with the existing file signature in the
+  // cache. Returns true if the signature doesn't change or the file doesn't
+  // exist before. If the signature changes, update the existing signature with
+  // the new one and remove the file from cache. The signature is part of the
+  // key of the blocks, so that the processes sharing the directory don't read
+  // the blocks of another version of the file.
+  bool ValidateAndUpdateFileSignature(const string& filename,
+                                      int64 file_signature) override
+      LOCKS_EXCLUDED(mu_);
+
+  /// Remove all cached blocks for `filename`, of all its signatures.
+  void RemoveFile(const string& filename) override;
+
+  /// Remove all cached data, including that of the other processes sharing
+  /// the directory.
+  void Flush() override;
+
+  /// Accessors for cache parameters.
+  size_t block_size() const override { return block_size_; }
+  size_t max_bytes() const override { return max_bytes_; }
+  uint64 max_staleness() const override { return max_staleness_; }
+  const string& directory() const { return directory_; }
+
+  /// The current size (in bytes) of the blocks in the directory.
+  size_t CacheSize() const override;
+
+  // Returns true if the cache is enabled. If false, the BlockFetcher callback
+  // is always executed during Read.
+  bool IsCacheEnabled() const override {
+    return block_size_ > 0 && max_bytes_ > 0 && directory_ok_;
+  }
+
+ private:
+  /// Reads the block of `filename` at `offset` from the directory, or fetches
+  /// and writes it if it isn't there or is stale.
+  Status GetBlock(const string& filename, size_t offset, string* data);
+
+  /// Reads the block file `path` of `filename` into `data`. Returns false if
+  /// there is no such file, or if it is stale or belongs to another file.
+  bool ReadBlockFile(const string& path, const string& filename, string* data);
+
+  /// Writes `data` to the block file `path` of `filename`, and evicts blocks
+  /// if the directory grew past max_bytes_.
+  Status WriteBlockFile(const string& path, const string& filename,
+                        const string& data) LOCKS_EXCLUDED(mu_);
+
+  /// The path of the file of the block of `filename` at `offset`.
+  string BlockPath(const string& filename, size_t offset) LOCKS_EXCLUDED(mu_);
+
+  /// The prefix of the names of the block files of `filename`.
+  string BlockPrefix(const string& filename) const;
+
+  /// Removes the block files whose names start with `prefix`.
+  void RemoveBlockFiles(const string& prefix);
+
+  /// Evicts the least recently used blocks of the directory down to 90% of
+  /// max_bytes_, and removes the temporary files left by crashed processes.
+  void Evict() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string directory_;
+  /// The size of the blocks, as well as the size of the reads from the
+  /// underlying filesystem.
+  const size_t block_size_;
+  /// The maximum number of bytes of the block files in the directory.
+  const size_t max_bytes_;
+  /// The maximum staleness of any block, in seconds.
+  const uint64 max_staleness_;
+  /// The callback to read a block from the underlying filesystem.
+  const BlockFetcher block_fetcher_;
+  /// The Env used for the files and timestamps.
+  Env* const env_;  // not owned
+  /// Whether the directory could be created.
+  bool directory_ok_ = false;
+
+  mutex mu_;
+  /// An estimate of the size of the block files in the directory: its size
+  /// at the last eviction, plus the blocks this process wrote since.
+  size_t estimated_size_ GUARDED_BY(mu_) = 0;
+  /// A filename->file_signature map.
+  std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_DISK_FILE_BLOCK_CACHE_H_
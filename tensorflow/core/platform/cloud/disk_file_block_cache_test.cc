@@ -0,0 +1,186 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
+#include <algorithm>
+#include <cstring>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/cloud/now_seconds_env.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Status ReadCache(DiskFileBlockCache* cache, const string& filename,
+                 size_t offset, size_t n, std::vector<char>* out) {
+  out->clear();
+  out->resize(n, 0);
+  size_t bytes_transferred = 0;
+  Status status =
+      cache->Read(filename, offset, n, out->data(), &bytes_transferred);
+  EXPECT_LE(bytes_transferred, n);
+  out->resize(bytes_transferred, n);
+  return status;
+}
+
+// Returns an empty cache directory for the test `name`.
+string CacheDir(const string& name) {
+  const string dir =
+      io::JoinPath(testing::TmpDir(), "disk_file_block_cache_test", name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+// A fetcher of 20 byte files, whose byte at offset i is 'a' + i, which counts
+// its calls.
+DiskFileBlockCache::BlockFetcher CountingFetcher(int* calls) {
+  return [calls](const string& filename, size_t offset, size_t n,
+                 char* buffer, size_t* bytes_transferred) {
+    ++*calls;
+    const size_t file_size = 20;
+    *bytes_transferred = offset < file_size ? std::min(n, file_size - offset)
+                                            : 0;
+    for (size_t i = 0; i < *bytes_transferred; ++i) {
+      buffer[i] = 'a' + offset + i;
+    }
+    return Status::OK();
+  };
+}
+
+TEST(DiskFileBlockCacheTest, IsCacheEnabled) {
+  int calls = 0;
+  const string dir = CacheDir("IsCacheEnabled");
+  EXPECT_FALSE(
+      DiskFileBlockCache(dir, 0, 100, 0, CountingFetcher(&calls))
+          .IsCacheEnabled());
+  EXPECT_FALSE(DiskFileBlockCache(dir, 8, 0, 0, CountingFetcher(&calls))
+                   .IsCacheEnabled());
+  EXPECT_TRUE(DiskFileBlockCache(dir, 8, 100, 0, CountingFetcher(&calls))
+                  .IsCacheEnabled());
+}
+
+TEST(DiskFileBlockCacheTest, ReadsAndCachesBlocks) {
+  int calls = 0;
+  DiskFileBlockCache cache(CacheDir("ReadsAndCachesBlocks"), 8, 1000, 0,
+                           CountingFetcher(&calls));
+  std::vector<char> out;
+  // A read across blocks, up to the end of the file.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 5, 100, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "fghijklmnopqrst");
+  EXPECT_EQ(calls, 3);
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 10, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "abcdefghij");
+  EXPECT_EQ(calls, 3);
+  // Past the end of the file.
+  EXPECT_EQ(error::OUT_OF_RANGE, ReadCache(&cache, "a", 22, 2, &out).code());
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(calls, 3);
+  // Another file.
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 2, &out));
+  EXPECT_EQ(calls, 4);
+}
+
+TEST(DiskFileBlockCacheTest, SharedBetweenCaches) {
+  int calls = 0;
+  const string dir = CacheDir("SharedBetweenCaches");
+  DiskFileBlockCache cache(dir, 8, 1000, 0, CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_EQ(calls, 1);
+  // A cache on the same directory, e.g. in another process, reads the block
+  // written by the first one.
+  int other_calls = 0;
+  DiskFileBlockCache other_cache(dir, 8, 1000, 0,
+                                 CountingFetcher(&other_calls));
+  TF_EXPECT_OK(ReadCache(&other_cache, "a", 0, 8, &out));
+  EXPECT_EQ(string(out.begin(), out.end()), "abcdefgh");
+  EXPECT_EQ(other_calls, 0);
+  EXPECT_EQ(cache.CacheSize(), other_cache.CacheSize());
+}
+
+TEST(DiskFileBlockCacheTest, Eviction) {
+  int calls = 0;
+  // Each block file holds a 12 byte header, the filename and 8 bytes of data.
+  const size_t max_bytes = 100;
+  DiskFileBlockCache cache(CacheDir("Eviction"), 8, max_bytes, 0,
+                           CountingFetcher(&calls));
+  std::vector<char> out;
+  for (const string& filename : {"a", "b", "c", "d", "e", "f", "g"}) {
+    TF_EXPECT_OK(ReadCache(&cache, filename, 0, 8, &out));
+    EXPECT_LE(cache.CacheSize(), max_bytes);
+  }
+  EXPECT_GT(cache.CacheSize(), 0);
+  EXPECT_EQ(calls, 7);
+}
+
+TEST(DiskFileBlockCacheTest, FileSignature) {
+  int calls = 0;
+  DiskFileBlockCache cache(CacheDir("FileSignature"), 8, 1000, 0,
+                           CountingFetcher(&calls));
+  std::vector<char> out;
+  EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("a", 1));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_TRUE(cache.ValidateAndUpdateFileSignature("a", 1));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_EQ(calls, 1);
+  // A new version of the file is fetched again.
+  EXPECT_FALSE(cache.ValidateAndUpdateFileSignature("a", 2));
+  EXPECT_EQ(cache.CacheSize(), 0);
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, MaxStaleness) {
+  int calls = 0;
+  std::unique_ptr<NowSecondsEnv> env(new NowSecondsEnv);
+  env->SetNowSeconds(100);
+  DiskFileBlockCache cache(CacheDir("MaxStaleness"), 8, 1000,
+                           2 /* max staleness */, CountingFetcher(&calls),
+                           env.get());
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  env->SetNowSeconds(102);
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_EQ(calls, 1);
+  env->SetNowSeconds(103);
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 8, &out));
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(DiskFileBlockCacheTest, RemoveFileAndFlush) {
+  int calls = 0;
+  DiskFileBlockCache cache(CacheDir("RemoveFileAndFlush"), 8, 1000, 0,
+                           CountingFetcher(&calls));
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 16, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 8, &out));
+  const size_t size = cache.CacheSize();
+  cache.RemoveFile("a");
+  EXPECT_EQ(cache.CacheSize(), size / 3);
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 8, &out));
+  EXPECT_EQ(calls, 3);
+  cache.Flush();
+  EXPECT_EQ(cache.CacheSize(), 0);
+  TF_EXPECT_OK(ReadCache(&cache, "b", 0, 8, &out));
+  EXPECT_EQ(calls, 4);
+}
+
+}  // namespace
+}  // namespace tensorflow
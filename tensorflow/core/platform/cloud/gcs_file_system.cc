@@ -21,12 +21,14 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <vector>
 #ifdef _WIN32
 #include <io.h>  // for _mktemp
 #endif
 #include "include/json/json.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cloud/curl_http_request.h"
+#include "tensorflow/core/platform/cloud/disk_file_block_cache.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/google_auth_provider.h"
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
@@ -81,6 +84,27 @@ constexpr size_t kDefaultMaxCacheSize = 2 * kDefaultBlockSize;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets a local directory in which the blocks read
+// from GCS are cached, instead of in memory. The directory can be shared by the
+// processes of a node. GCS_READ_CACHE_MAX_SIZE_MB then bounds its size.
+constexpr char kDiskCacheDir[] = "GCS_READ_CACHE_DISK_DIR";
+// The environment variable that sets the maximum number of blocks fetched ahead
+// of sequential reads, concurrently with them. The blocks of a read that spans
+// several blocks are then also fetched concurrently. A value of 0 (the default)
+// disables prefetching.
+constexpr char kPrefetchBlocks[] = "GCS_READ_CACHE_PREFETCH_BLOCKS";
+// The environment variable that sets the size of the parts in which large files
+// are uploaded while they are written, in MB. A value of 0 (the default)
+// uploads files as a whole when they are synced or closed.
+constexpr char kUploadPartSize[] = "GCS_UPLOAD_PART_SIZE_MB";
+// The environment variable that overrides the number of parts of a file
+// uploaded concurrently.
+constexpr char kUploadPartsInFlight[] = "GCS_UPLOAD_PARTS_IN_FLIGHT";
+constexpr int kDefaultUploadPartsInFlight = 4;
+// The maximum number of source objects of a GCS compose request.
+constexpr size_t kMaxComposeSources = 32;
+// The infix of the names of the temporary objects of a streaming upload.
+constexpr char kUploadPartInfix[] = "_tmp_upload_part_";
 // The environment variable that overrides the maximum age of entries in the
 // Stat cache. A value of 0 (the default) means nothing is cached.
 constexpr char kStatCacheMaxAge[] = "GCS_STAT_CACHE_MAX_AGE";
@@ -574,6 +598,253 @@ class GcsWritableFile : public WritableFile {
   int64 initial_retry_delay_usec_;
 };
 
+/// \brief GCS-based implementation of a writable file that is uploaded while
+/// it is written.
+///
+/// The contents are buffered in memory. Once they reach the part size, they
+/// are uploaded in parts, as temporary objects of which several are uploaded
+/// concurrently, and the parts are composed after the object and deleted on
+/// Sync() and Close(). A file smaller than a part is uploaded as a whole on
+/// each Sync(), as in GcsWritableFile, but without a local temporary file.
+class GcsStreamingWritableFile : public WritableFile {
+ public:
+  GcsStreamingWritableFile(const string& bucket, const string& object,
+                           GcsFileSystem* filesystem,
+                           GcsFileSystem::TimeoutConfig* timeouts,
+                           std::function<void()> file_cache_erase,
+                           int64 initial_retry_delay_usec, size_t part_size,
+                           int max_parts_in_flight)
+      : bucket_(bucket),
+        object_(object),
+        filesystem_(filesystem),
+        timeouts_(timeouts),
+        file_cache_erase_(std::move(file_cache_erase)),
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        part_size_(part_size),
+        max_parts_in_flight_(max_parts_in_flight) {}
+
+  ~GcsStreamingWritableFile() override { Close().IgnoreError(); }
+
+  Status Append(const StringPiece& data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    sync_needed_ = true;
+    buffer_.append(data.data(), data.size());
+    size_t uploaded = 0;
+    while (buffer_.size() - uploaded >= part_size_) {
+      streaming_ = true;
+      TF_RETURN_IF_ERROR(StartPartUpload(buffer_.substr(uploaded, part_size_)));
+      uploaded += part_size_;
+    }
+    buffer_.erase(0, uploaded);
+    return Status::OK();
+  }
+
+  Status Close() override {
+    if (!closed_) {
+      TF_RETURN_IF_ERROR(Sync());
+      closed_ = true;
+      buffer_.clear();
+    }
+    return Status::OK();
+  }
+
+  Status Flush() override { return Sync(); }
+
+  Status Sync() override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!sync_needed_) {
+      return Status::OK();
+    }
+    Status status;
+    if (streaming_) {
+      status = SyncParts();
+    } else {
+      status = RetryingUtils::CallWithRetries(
+          [this]() { return UploadObject(object_, buffer_); },
+          initial_retry_delay_usec_);
+    }
+    if (status.ok()) {
+      sync_needed_ = false;
+      // Erase the file from the file cache on every successful write.
+      file_cache_erase_();
+    }
+    return status;
+  }
+
+ private:
+  /// Uploads the buffered contents as a last part, waits for the parts to be
+  /// uploaded, and composes them after the object.
+  Status SyncParts() {
+    if (!buffer_.empty()) {
+      TF_RETURN_IF_ERROR(StartPartUpload(std::move(buffer_)));
+      buffer_.clear();
+    }
+    {
+      mutex_lock l(mu_);
+      while (parts_in_flight_ > 0) {
+        cond_var_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(upload_status_);
+    }
+    while (!parts_.empty()) {
+      // Once the object holds the beginning of the file, it is the first
+      // source of each compose request.
+      std::vector<string> sources;
+      if (composed_) {
+        sources.push_back(object_);
+      }
+      const size_t num_parts =
+          std::min(parts_.size(), kMaxComposeSources - sources.size());
+      sources.insert(sources.end(), parts_.begin(),
+                     parts_.begin() + num_parts);
+      TF_RETURN_IF_ERROR(RetryingUtils::CallWithRetries(
+          [this, &sources]() { return Compose(sources); },
+          initial_retry_delay_usec_));
+      composed_ = true;
+      parts_.erase(parts_.begin(), parts_.begin() + num_parts);
+      for (size_t i = sources.size() - num_parts; i < sources.size(); ++i) {
+        const string part_path =
+            strings::StrCat("gs://", bucket_, "/", sources[i]);
+        TF_RETURN_IF_ERROR(RetryingUtils::DeleteWithRetries(
+            [this, &part_path]() { return filesystem_->DeleteFile(part_path); },
+            initial_retry_delay_usec_));
+      }
+    }
+    return Status::OK();
+  }
+
+  /// Uploads `data` as the next part on upload_pool_, once fewer than
+  /// max_parts_in_flight_ parts are being uploaded.
+  Status StartPartUpload(string data) {
+    {
+      mutex_lock l(mu_);
+      while (parts_in_flight_ >= max_parts_in_flight_) {
+        cond_var_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(upload_status_);
+      ++parts_in_flight_;
+    }
+    const string part = strings::StrCat(object_, kUploadPartInfix, num_parts_);
+    ++num_parts_;
+    parts_.push_back(part);
+    if (!upload_pool_) {
+      upload_pool_.reset(new thread::ThreadPool(
+          Env::Default(), "gcs_upload_parts", max_parts_in_flight_));
+    }
+    // std::function needs a copyable closure, so the data is shared.
+    auto shared_data = std::make_shared<string>(std::move(data));
+    upload_pool_->Schedule([this, part, shared_data]() {
+      const Status status = RetryingUtils::CallWithRetries(
+          [this, &part, &shared_data]() {
+            return UploadObject(part, *shared_data);
+          },
+          initial_retry_delay_usec_);
+      mutex_lock l(mu_);
+      upload_status_.Update(status);
+      --parts_in_flight_;
+      cond_var_.notify_all();
+    });
+    return Status::OK();
+  }
+
+  /// Uploads `data` as the object `name` in a single request.
+  Status UploadObject(const string& name, const string& data) {
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+    request->SetUri(strings::StrCat(kGcsUploadUriBase, "b/", bucket_,
+                                    "/o?uploadType=media&name=",
+                                    request->EscapeString(name)));
+    if (data.empty()) {
+      request->SetPostEmptyBody();
+    } else {
+      request->SetPostFromBuffer(data.data(), data.size());
+    }
+    std::vector<char> output_buffer;
+    request->SetResultBuffer(&output_buffer);
+    request->SetTimeouts(timeouts_->connect, timeouts_->idle, timeouts_->write);
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading gs://",
+                                    bucket_, "/", name);
+    return Status::OK();
+  }
+
+  /// Composes the objects `sources` into the object. When the object is one
+  /// of the sources, the request only succeeds if the object wasn't changed
+  /// since the previous compose, so that a retried request can't append the
+  /// same parts twice.
+  Status Compose(const std::vector<string>& sources) {
+    string body = "{\"sourceObjects\": [";
+    for (size_t i = 0; i < sources.size(); ++i) {
+      strings::StrAppend(&body, i > 0 ? ", " : "", "{\"name\": ",
+                         Json::valueToQuotedString(sources[i].c_str()), "}");
+    }
+    body += "]}";
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+    string uri = strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                 request->EscapeString(object_), "/compose");
+    if (composed_) {
+      strings::StrAppend(&uri, "?ifGenerationMatch=", generation_);
+    }
+    request->SetUri(uri);
+    request->AddHeader("Content-Type", "application/json");
+    request->SetPostFromBuffer(body.data(), body.size());
+    std::vector<char> output_buffer;
+    request->SetResultBuffer(&output_buffer);
+    request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                         timeouts_->metadata);
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when composing ",
+                                    GetGcsPath());
+    Json::Value root;
+    TF_RETURN_IF_ERROR(ParseJson(output_buffer, &root));
+    return GetInt64Value(root, "generation", &generation_);
+  }
+
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file ", GetGcsPath(),
+                                        " is closed.");
+    }
+    return Status::OK();
+  }
+
+  string GetGcsPath() const {
+    return strings::StrCat("gs://", bucket_, "/", object_);
+  }
+
+  string bucket_;
+  string object_;
+  GcsFileSystem* const filesystem_;  // Not owned.
+  GcsFileSystem::TimeoutConfig* timeouts_;
+  std::function<void()> file_cache_erase_;
+  int64 initial_retry_delay_usec_;
+  const size_t part_size_;
+  const int max_parts_in_flight_;
+
+  // The contents that weren't uploaded in a part yet, or all of them if the
+  // file was never larger than a part.
+  string buffer_;
+  bool sync_needed_ = true;
+  bool closed_ = false;
+  // Whether the file is uploaded in parts.
+  bool streaming_ = false;
+  // Whether the object holds the beginning of the file composed from parts,
+  // and its generation.
+  bool composed_ = false;
+  int64 generation_ = 0;
+  // The parts that weren't composed into the object yet, and the number of
+  // parts created so far.
+  std::vector<string> parts_;
+  int64 num_parts_ = 0;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int parts_in_flight_ GUARDED_BY(mu_) = 0;
+  // The first error of the part uploads.
+  Status upload_status_ GUARDED_BY(mu_);
+  // Destroyed first, so that the pending uploads finish before mu_ goes away.
+  std::unique_ptr<thread::ThreadPool> upload_pool_;
+};
+
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
   GcsReadOnlyMemoryRegion(std::unique_ptr<char[]> data, uint64 length)
@@ -627,13 +898,28 @@ GcsFileSystem::GcsFileSystem()
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+  if (const char* disk_cache_dir = std::getenv(kDiskCacheDir)) {
+    disk_cache_dir_ = disk_cache_dir;
+  }
+  if (GetEnvVar(kPrefetchBlocks, strings::safe_strtou64, &value)) {
+    max_prefetch_blocks_ = value;
+  }
+  if (GetEnvVar(kUploadPartSize, strings::safe_strtou64, &value)) {
+    upload_part_size_ = value * 1024 * 1024;
+  }
+  max_upload_parts_in_flight_ = kDefaultUploadPartsInFlight;
+  if (GetEnvVar(kUploadPartsInFlight, strings::safe_strtou64, &value) &&
+      value > 0) {
+    max_upload_parts_in_flight_ = value;
+  }
   if (std::getenv(kReadCacheDisabled)) {
     // Setting either to 0 disables the cache; set both for good measure.
     block_size = max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "prefetch blocks = " << max_prefetch_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -812,16 +1098,32 @@ void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
   }
 }
 
+void GcsFileSystem::SetStreamingUploads(size_t part_size_bytes,
+                                        int max_parts_in_flight) {
+  upload_part_size_ = part_size_bytes;
+  max_upload_parts_in_flight_ = std::max(1, max_parts_in_flight);
+}
+
 // A helper function to build a FileBlockCache for GcsFileSystem.
 std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
     size_t block_size, size_t max_bytes, uint64 max_staleness) {
+  if (!disk_cache_dir_.empty()) {
+    return std::unique_ptr<FileBlockCache>(new DiskFileBlockCache(
+        disk_cache_dir_, block_size, max_bytes, max_staleness,
+        [this](const string& filename, size_t offset, size_t n, char* buffer,
+               size_t* bytes_transferred) {
+          return LoadBufferFromGCS(filename, offset, n, buffer,
+                                   bytes_transferred);
+        }));
+  }
   std::unique_ptr<FileBlockCache> file_block_cache(new RamFileBlockCache(
       block_size, max_bytes, max_staleness,
       [this](const string& filename, size_t offset, size_t n, char* buffer,
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), max_prefetch_blocks_));
   return file_block_cache;
 }
 
@@ -891,6 +1193,13 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
                                       std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
+  if (upload_part_size_ > 0) {
+    result->reset(new GcsStreamingWritableFile(
+        bucket, object, this, &timeouts_,
+        [this, fname]() { ClearFileCaches(fname); }, initial_retry_delay_usec_,
+        upload_part_size_, max_upload_parts_in_flight_));
+    return Status::OK();
+  }
   result->reset(new GcsWritableFile(bucket, object, this, &timeouts_,
                                     [this, fname]() { ClearFileCaches(fname); },
                                     initial_retry_delay_usec_));
@@ -217,6 +217,20 @@ class GcsFileSystem : public FileSystem {
   void ResetFileBlockCache(size_t block_size_bytes, size_t max_bytes,
                            uint64 max_staleness_secs);
 
+  /// \brief Configures the streaming uploads of the writable files.
+  ///
+  /// Once a file opened with NewWritableFile() grows past `part_size_bytes`,
+  /// it is uploaded while it is written, in temporary objects of
+  /// `part_size_bytes` of which up to `max_parts_in_flight` are uploaded
+  /// concurrently, and which are composed into the file on Sync() and Close().
+  /// A `part_size_bytes` of 0 disables streaming uploads, in which case the
+  /// files are buffered in a local temporary file and uploaded as a whole.
+  ///
+  /// Note: only the files opened afterwards are affected.
+  void SetStreamingUploads(size_t part_size_bytes, int max_parts_in_flight);
+  size_t upload_part_size() const { return upload_part_size_; }
+  int max_upload_parts_in_flight() const { return max_upload_parts_in_flight_; }
+
  private:
   // GCS file statistics.
   struct GcsFileStat {
@@ -276,6 +290,11 @@ class GcsFileSystem : public FileSystem {
   mutex mu_;
   std::unique_ptr<AuthProvider> auth_provider_ GUARDED_BY(mu_);
   std::unique_ptr<HttpRequest::Factory> http_request_factory_;
+  // The maximum number of blocks the file block cache fetches ahead of
+  // sequential reads.
+  size_t max_prefetch_blocks_ = 0;
+  // The directory of the file block cache if it is on disk, or empty.
+  string disk_cache_dir_;
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -292,6 +311,10 @@ class GcsFileSystem : public FileSystem {
 
   TimeoutConfig timeouts_;
 
+  // The configuration of the streaming uploads, see SetStreamingUploads().
+  size_t upload_part_size_ = 0;
+  int max_upload_parts_in_flight_ = 1;
+
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
   /// The initial delay for exponential backoffs when retrying failed calls.
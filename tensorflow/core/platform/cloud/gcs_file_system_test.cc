@@ -820,6 +820,131 @@ TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
             fs.NewWritableFile("gs://bucket/", &file).code());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_StreamingUpload) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable_tmp_upload_part_0\n"
+           "Auth Token: fake_token\n"
+           "Post body: content1\n"
+           "Timeouts: 5 1 30\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable_tmp_upload_part_1\n"
+           "Auth Token: fake_token\n"
+           "Post body: ,content\n"
+           "Timeouts: 5 1 30\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable_tmp_upload_part_2\n"
+           "Auth Token: fake_token\n"
+           "Post body: 2\n"
+           "Timeouts: 5 1 30\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fwriteable/compose\n"
+           "Auth Token: fake_token\n"
+           "Header Content-Type: application/json\n"
+           "Post body: {\"sourceObjects\": ["
+           "{\"name\": \"path/writeable_tmp_upload_part_0\"}, "
+           "{\"name\": \"path/writeable_tmp_upload_part_1\"}, "
+           "{\"name\": \"path/writeable_tmp_upload_part_2\"}]}\n"
+           "Timeouts: 5 1 10\n",
+           "{\"generation\": \"1\"}"),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable_tmp_upload_part_0\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable_tmp_upload_part_1\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable_tmp_upload_part_2\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable_tmp_upload_part_3\n"
+           "Auth Token: fake_token\n"
+           "Post body: 3\n"
+           "Timeouts: 5 1 30\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fwriteable/compose?ifGenerationMatch=1\n"
+           "Auth Token: fake_token\n"
+           "Header Content-Type: application/json\n"
+           "Post body: {\"sourceObjects\": ["
+           "{\"name\": \"path/writeable\"}, "
+           "{\"name\": \"path/writeable_tmp_upload_part_3\"}]}\n"
+           "Timeouts: 5 1 10\n",
+           "{\"generation\": \"2\"}"),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fwriteable_tmp_upload_part_3\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* block size */, 0 /* max bytes */, 0 /* max staleness */,
+      0 /* stat cache max age */, 0 /* stat cache max entries */,
+      0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, 0 /* initial retry delay */,
+      kTestTimeoutConfig, nullptr /* gcs additional header */);
+  fs.SetStreamingUploads(8 /* part size */, 1 /* max parts in flight */);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable", &wfile));
+  // The parts are uploaded as they fill up, and composed on Flush().
+  TF_EXPECT_OK(wfile->Append("content1,"));
+  TF_EXPECT_OK(wfile->Append("content2"));
+  TF_EXPECT_OK(wfile->Flush());
+  // The parts written afterwards are composed after the object.
+  TF_EXPECT_OK(wfile->Append("3"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_StreamingUploadOfSmallFile) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fwriteable\n"
+           "Auth Token: fake_token\n"
+           "Post body: content1\n"
+           "Timeouts: 5 1 30\n",
+           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* block size */, 0 /* max bytes */, 0 /* max staleness */,
+      0 /* stat cache max age */, 0 /* stat cache max entries */,
+      0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, 0 /* initial retry delay */,
+      kTestTimeoutConfig, nullptr /* gcs additional header */);
+  fs.SetStreamingUploads(100 /* part size */, 4 /* max parts in flight */);
+
+  // A file smaller than a part is uploaded as a whole.
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable", &wfile));
+  TF_EXPECT_OK(wfile->Append("content1"));
+  TF_EXPECT_OK(wfile->Close());
+  EXPECT_FALSE(wfile->Append("content2").ok());
+}
+
 TEST(GcsFileSystemTest, NewAppendableFile) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
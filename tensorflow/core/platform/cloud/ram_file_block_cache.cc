@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -62,6 +63,20 @@ void RamFileBlockCache::Trim() {
   }
 }
 
+int64 RamFileBlockCache::ReleaseMemory(int64 bytes) {
+  // This runs on allocating threads, which may already hold mu_.
+  mutex_lock lock(mu_, std::try_to_lock);
+  if (!lock) {
+    return 0;
+  }
+  const size_t initial_size = cache_size_;
+  while (!lru_list_.empty() &&
+         initial_size - cache_size_ < static_cast<size_t>(bytes)) {
+    RemoveBlock(block_map_.find(lru_list_.back()));
+  }
+  return initial_size - cache_size_;
+}
+
 /// Move the block to the front of the LRU list if it isn't already there.
 Status RamFileBlockCache::UpdateLRU(const Key& key,
                                     const std::shared_ptr<Block>& block) {
@@ -76,15 +91,21 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
     block->lru_iterator = lru_list_.begin();
   }
 
-  // Check for inconsistent state. If there is a block later in the same file
-  // in the cache, and our current block is not block size, this likely means
-  // we have inconsistent state within the cache. Note: it's possible some
-  // incomplete reads may still go undetected.
+  // Check for inconsistent state. If there is a block with data later in the
+  // same file in the cache, and our current block is not block size, this
+  // likely means we have inconsistent state within the cache. Blocks that are
+  // still being fetched, or that were prefetched past the end of the file, are
+  // ignored. Note: it's possible some incomplete reads may still go
+  // undetected.
   if (block->data.size() < block_size_) {
-    Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
-    auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    for (auto later = block_map_.upper_bound(key);
+         later != block_map_.end() && later->first.first == key.first;
+         ++later) {
+      mutex_lock l(later->second->mu);
+      if (later->second->state == FetchState::FINISHED &&
+          !later->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -155,6 +176,26 @@ Status RamFileBlockCache::MaybeFetch(const Key& key,
       "Control flow should never reach the end of RamFileBlockCache::Fetch.");
 }
 
+void RamFileBlockCache::Prefetch(const string& filename, size_t start,
+                                 size_t finish) {
+  for (size_t pos = start; pos < finish; pos += block_size_) {
+    Key key = std::make_pair(filename, pos);
+    {
+      mutex_lock lock(mu_);
+      if (block_map_.count(key) > 0) {
+        continue;  // The block is cached or already being fetched.
+      }
+    }
+    std::shared_ptr<Block> block = Lookup(key);
+    prefetch_pool_->Schedule([this, key, block]() {
+      // Errors are left for the read of the block to report.
+      if (MaybeFetch(key, block).ok()) {
+        UpdateLRU(key, block).IgnoreError();
+      }
+    });
+  }
+}
+
 Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
                                char* buffer, size_t* bytes_transferred) {
   *bytes_transferred = 0;
@@ -172,6 +213,26 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (prefetch_pool_) {
+    size_t prefetch_blocks;
+    {
+      mutex_lock lock(mu_);
+      ReadPattern& pattern = read_patterns_[filename];
+      if (offset == pattern.next_offset) {
+        pattern.prefetch_blocks = std::min(
+            std::max<size_t>(1, 2 * pattern.prefetch_blocks),
+            max_prefetch_blocks_);
+      } else {
+        pattern.prefetch_blocks = 0;
+      }
+      pattern.next_offset = offset + n;
+      prefetch_blocks = pattern.prefetch_blocks;
+    }
+    // The first block is fetched below by this thread, concurrently with the
+    // other blocks of the read and the blocks after a sequential read.
+    Prefetch(filename, start + block_size_,
+             finish + prefetch_blocks * block_size_);
+  }
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -261,6 +322,7 @@ void RamFileBlockCache::Flush() {
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  read_patterns_.clear();
   cache_size_ = 0;
 }
 
@@ -277,6 +339,7 @@ void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
     RemoveBlock(it);
     it = next;
   }
+  read_patterns_.erase(filename);
 }
 
 void RamFileBlockCache::RemoveBlock(BlockMap::iterator entry) {
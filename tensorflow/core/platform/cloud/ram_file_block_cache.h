@@ -16,14 +16,17 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
+#include "tensorflow/core/lib/core/memory_pressure.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -49,22 +52,46 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// If `max_prefetch_blocks` > 0, the blocks of a read after the first, and
+  /// up to `max_prefetch_blocks` blocks after the read when a file is read
+  /// sequentially, are fetched concurrently on a thread pool. The number of
+  /// prefetched blocks is capped so that they fill at most half of the cache.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t max_prefetch_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
+        max_prefetch_blocks_(
+            block_size > 0
+                ? std::min(max_prefetch_blocks, max_bytes / block_size / 2)
+                : 0),
         block_fetcher_(block_fetcher),
         env_(env) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (IsCacheEnabled()) {
+      memory_pressure_handler_ = MemoryPressureRegistry::Global()->Register(
+          MemoryPressureRegistry::kCachePriority,
+          [this](int64 bytes) { return ReleaseMemory(bytes); });
+    }
+    if (IsCacheEnabled() && max_prefetch_blocks_ > 0) {
+      prefetch_pool_.reset(new thread::ThreadPool(env_, "TF_prefetch_FBC",
+                                                  max_prefetch_blocks_));
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying prefetch_pool_ will block until the pending prefetches are
+    // done.
+    prefetch_pool_.reset();
+    if (memory_pressure_handler_ >= 0) {
+      MemoryPressureRegistry::Global()->Unregister(memory_pressure_handler_);
+    }
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -108,6 +135,7 @@ class RamFileBlockCache : public FileBlockCache {
   size_t block_size() const override { return block_size_; }
   size_t max_bytes() const override { return max_bytes_; }
   uint64 max_staleness() const override { return max_staleness_; }
+  size_t max_prefetch_blocks() const { return max_prefetch_blocks_; }
 
   /// The current size (in bytes) of the cache.
   size_t CacheSize() const override LOCKS_EXCLUDED(mu_);
@@ -126,6 +154,8 @@ class RamFileBlockCache : public FileBlockCache {
   const size_t max_bytes_;
   /// The maximum staleness of any block in the LRU cache, in seconds.
   const uint64 max_staleness_;
+  /// The maximum number of blocks fetched ahead of a sequential read.
+  const size_t max_prefetch_blocks_;
   /// The callback to read a block from the underlying filesystem.
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
@@ -182,6 +212,18 @@ class RamFileBlockCache : public FileBlockCache {
     condition_variable cond_var;
   };
 
+  /// \brief The recent reads of a file.
+  ///
+  /// A read that starts where the previous one ended is sequential, and
+  /// doubles the number of blocks prefetched after it, up to
+  /// max_prefetch_blocks_. Any other read stops the prefetching.
+  struct ReadPattern {
+    /// The offset right after the previous read.
+    size_t next_offset = 0;
+    /// The number of blocks prefetched after the previous read.
+    size_t prefetch_blocks = 0;
+  };
+
   /// \brief The block map type for the file block cache.
   ///
   /// The block map is an ordered map from Key to Block.
@@ -199,9 +241,18 @@ class RamFileBlockCache : public FileBlockCache {
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       LOCKS_EXCLUDED(mu_);
 
+  /// Start fetching the blocks of `filename` in [`start`, `finish`) that are
+  /// not in the cache on prefetch_pool_.
+  void Prefetch(const string& filename, size_t start, size_t finish)
+      LOCKS_EXCLUDED(mu_);
+
   /// Trim the block cache to make room for another entry.
   void Trim() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  /// Evicts least recently used blocks totalling at least `bytes` bytes, if
+  /// it can do so without blocking, and returns the number of bytes evicted.
+  int64 ReleaseMemory(int64 bytes) LOCKS_EXCLUDED(mu_);
+
   /// Update the LRU iterator for the block at `key`.
   Status UpdateLRU(const Key& key, const std::shared_ptr<Block>& block)
       LOCKS_EXCLUDED(mu_);
@@ -219,6 +270,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// The threads that prefetch blocks, or null if prefetching is disabled.
+  std::unique_ptr<thread::ThreadPool> prefetch_pool_;
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -239,8 +293,14 @@ class RamFileBlockCache : public FileBlockCache {
   /// The combined number of bytes in all of the cached blocks.
   size_t cache_size_ GUARDED_BY(mu_) = 0;
 
+  /// The handler that evicts blocks under memory pressure, or -1.
+  MemoryPressureRegistry::HandlerId memory_pressure_handler_ = -1;
+
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
+
+  /// The read patterns of the files, used when prefetching.
+  std::map<string, ReadPattern> read_patterns_ GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 #include <cstring>
+#include <set>
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/cloud/now_seconds_env.h"
@@ -311,6 +312,32 @@ TEST(RamFileBlockCacheTest, LRU) {
   TF_EXPECT_OK(ReadCache(&cache, "", 0, 1, &out));
 }
 
+TEST(RamFileBlockCacheTest, ReleasesMemoryUnderPressure) {
+  const size_t block_size = 16;
+  int calls = 0;
+  auto fetcher = [&calls](const string& filename, size_t offset, size_t n,
+                          char* buffer, size_t* bytes_transferred) {
+    calls++;
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 3 * block_size, 0, fetcher);
+  std::vector<char> out;
+  for (int i = 0; i < 3; i++) {
+    TF_EXPECT_OK(ReadCache(&cache, "", i * block_size, 1, &out));
+  }
+  EXPECT_EQ(3 * block_size, cache.CacheSize());
+  // The two least recently used blocks are evicted.
+  EXPECT_EQ(2 * block_size,
+            MemoryPressureRegistry::Global()->ReleaseMemory(block_size + 1));
+  EXPECT_EQ(block_size, cache.CacheSize());
+  TF_EXPECT_OK(ReadCache(&cache, "", 2 * block_size, 1, &out));
+  EXPECT_EQ(3, calls);
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, 1, &out));
+  EXPECT_EQ(4, calls);
+}
+
 TEST(RamFileBlockCacheTest, MaxStaleness) {
   int calls = 0;
   auto fetcher = [&calls](const string& filename, size_t offset, size_t n,
@@ -507,6 +534,89 @@ TEST(RamFileBlockCacheTest, ParallelReads) {
   // executed, or 10 seconds have passed).
 }
 
+TEST(RamFileBlockCacheTest, ParallelBlocksOfRead) {
+  // The four blocks of a read are only returned if they are all fetched
+  // concurrently.
+  const int blocks = 4;
+  BlockingCounter counter(blocks);
+  auto fetcher = [&counter](const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+    if (offset < blocks * n) {
+      counter.DecrementCount();
+      if (!counter.WaitFor(std::chrono::seconds(10))) {
+        return errors::FailedPrecondition("desired concurrency not reached");
+      }
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  const int block_size = 8;
+  RamFileBlockCache cache(block_size, 4 * blocks * block_size, 0, fetcher,
+                          Env::Default(), blocks);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "", 0, blocks * block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(blocks * block_size, 'x'));
+}
+
+TEST(RamFileBlockCacheTest, Prefetch) {
+  const size_t block_size = 8;
+  const size_t file_size = 10 * block_size;
+  mutex mu;
+  std::set<size_t> fetched;
+  auto fetcher = [&mu, &fetched, file_size](
+                     const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      fetched.insert(offset);
+    }
+    *bytes_transferred = offset < file_size ? std::min(n, file_size - offset)
+                                            : 0;
+    memset(buffer, 'x', *bytes_transferred);
+    return Status::OK();
+  };
+  // Waits for `count` blocks to be fetched, and returns their offsets.
+  auto wait_for_fetched = [&mu, &fetched](size_t count) {
+    uint64 start = Env::Default()->NowSeconds();
+    while (true) {
+      {
+        mutex_lock l(mu);
+        if (fetched.size() >= count ||
+            Env::Default()->NowSeconds() - start > 10) {
+          return fetched;
+        }
+      }
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+  };
+  RamFileBlockCache cache(block_size, 20 * block_size, 0, fetcher,
+                          Env::Default(), 4);
+  EXPECT_EQ(cache.max_prefetch_blocks(), 4);
+  std::vector<char> out;
+  // The first read of a file prefetches the next block.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  EXPECT_EQ(wait_for_fetched(2), std::set<size_t>({0, 8}));
+  // Each sequential read doubles the number of prefetched blocks, up to 4.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 8, block_size, &out));
+  EXPECT_EQ(wait_for_fetched(4), std::set<size_t>({0, 8, 16, 24}));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 16, block_size, &out));
+  EXPECT_EQ(wait_for_fetched(7), std::set<size_t>({0, 8, 16, 24, 32, 40, 48}));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 24, block_size, &out));
+  EXPECT_EQ(wait_for_fetched(8).size(), 8);
+  EXPECT_EQ(out, std::vector<char>(block_size, 'x'));
+  // A read that isn't sequential stops the prefetching.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 72, block_size, &out));
+  Env::Default()->SleepForMicroseconds(100000);
+  EXPECT_EQ(wait_for_fetched(9).size(), 9);
+
+  // The prefetched blocks fill at most half of the cache.
+  RamFileBlockCache small_cache(block_size, 4 * block_size, 0, fetcher,
+                                Env::Default(), 4);
+  EXPECT_EQ(small_cache.max_prefetch_blocks(), 2);
+}
+
 TEST(RamFileBlockCacheTest, CoalesceConcurrentReads) {
   // Concurrent reads to the same file blocks should be de-duplicated.
   const size_t block_size = 16;
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/platform/numa.h"
 
+#include <memory>
+
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -54,6 +57,23 @@ TEST(Numa, SetNodeAffinity) {
       int affinity_node = port::NUMAGetThreadNodeAffinity();
       EXPECT_EQ(affinity_node, request_node);
     }
+    port::NUMASetThreadNodeAffinity(port::kNUMANoAffinity);
+    EXPECT_EQ(-1, port::NUMAGetThreadNodeAffinity());
+  }
+}
+
+TEST(Numa, ThreadOptions) {
+  const int num_nodes = port::NUMAEnabled() ? port::NUMANumNodes() : 0;
+  for (int request_node = 0; request_node < num_nodes; ++request_node) {
+    ThreadOptions thread_options;
+    thread_options.numa_node = request_node;
+    int affinity_node = -1;
+    std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+        thread_options, "numa_test", [&affinity_node]() {
+          affinity_node = port::NUMAGetThreadNodeAffinity();
+        }));
+    thread.reset();
+    EXPECT_EQ(affinity_node, request_node);
   }
 }
 
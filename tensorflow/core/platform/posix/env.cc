@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/load_library.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -40,10 +41,15 @@ namespace {
 
 class StdThread : public Thread {
  public:
-  // name and thread_options are both ignored.
+  // name and the stack options in thread_options are ignored.
   StdThread(const ThreadOptions& thread_options, const string& name,
             std::function<void()> fn)
-      : thread_(fn) {}
+      : thread_([thread_options, fn]() {
+          if (thread_options.numa_node != port::kNUMANoAffinity) {
+            port::NUMASetThreadNodeAffinity(thread_options.numa_node);
+          }
+          fn();
+        }) {}
   ~StdThread() override { thread_.join(); }
 
  private:
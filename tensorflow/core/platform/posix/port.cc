@@ -29,7 +29,9 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 
 #if defined(__linux__) && !defined(__ANDROID__)
+#include <errno.h>
 #include <sched.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
 #endif
 #include <stdio.h>
@@ -43,6 +45,10 @@ limitations under the License.
     defined(__HAIKU__)
 #include <thread>
 #endif
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <algorithm>
+#include <vector>
+#endif
 
 namespace tensorflow {
 namespace port {
@@ -80,16 +86,125 @@ int NumHyperthreadsPerCore() {
   return (ht_per_core > 0) ? ht_per_core : 1;
 }
 
-bool NUMAEnabled() {
-  // Not yet implemented: coming soon.
-  return false;
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Memory policy constants from <linux/mempolicy.h>, which is not always
+// installed alongside the C library headers.
+constexpr int kMpolPreferred = 1;
+constexpr int kMpolFNode = 1 << 0;
+constexpr int kMpolFAddr = 1 << 1;
+
+// Parses a sysfs list such as "0-3,8-11" into "*ids".
+bool ParseSysfsList(const char* path, std::vector<int>* ids) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  char buf[4096];
+  const bool read = fgets(buf, sizeof(buf), f) != nullptr;
+  fclose(f);
+  if (!read) return false;
+  const char* p = buf;
+  while (*p != '\0' && *p != '\n') {
+    char* end;
+    const long first = strtol(p, &end, 10);
+    if (end == p) return false;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      if (end == p + 1) return false;
+      p = end;
+    }
+    for (long id = first; id <= last; ++id) ids->push_back(id);
+    if (*p == ',') ++p;
+  }
+  return true;
+}
+
+// The NUMA nodes that have CPUs, numbered densely from 0 in the order the
+// kernel lists them. Memory-only nodes are skipped: nothing can be pinned
+// to them.
+struct NUMATopology {
+  std::vector<int> kernel_node_ids;
+  std::vector<cpu_set_t> node_cpus;
+  cpu_set_t all_cpus;
+};
+
+const NUMATopology& GetNUMATopology() {
+  static const NUMATopology* topology = [] {
+    NUMATopology* t = new NUMATopology;
+    CPU_ZERO(&t->all_cpus);
+    std::vector<int> nodes;
+    if (!ParseSysfsList("/sys/devices/system/node/online", &nodes)) return t;
+    for (int node : nodes) {
+      char path[64];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               node);
+      std::vector<int> cpus;
+      if (!ParseSysfsList(path, &cpus) || cpus.empty()) continue;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+          CPU_SET(cpu, &set);
+          CPU_SET(cpu, &t->all_cpus);
+        }
+      }
+      t->kernel_node_ids.push_back(node);
+      t->node_cpus.push_back(set);
+    }
+    return t;
+  }();
+  return *topology;
 }
 
-int NUMANumNodes() { return 1; }
+}  // namespace
+#endif  // defined(__linux__) && !defined(__ANDROID__)
 
-void NUMASetThreadNodeAffinity(int node) {}
+bool NUMAEnabled() { return NUMANumNodes() > 1; }
+
+int NUMANumNodes() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const int num_nodes = GetNUMATopology().node_cpus.size();
+  return num_nodes > 0 ? num_nodes : 1;
+#else
+  return 1;
+#endif
+}
+
+void NUMASetThreadNodeAffinity(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!NUMAEnabled()) return;
+  const NUMATopology& topology = GetNUMATopology();
+  const cpu_set_t* cpus = &topology.all_cpus;
+  if (node >= 0 && node < topology.node_cpus.size()) {
+    cpus = &topology.node_cpus[node];
+  } else if (node != kNUMANoAffinity) {
+    LOG(ERROR) << "Invalid NUMA node " << node;
+    return;
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), cpus) != 0) {
+    LOG(ERROR) << "sched_setaffinity to NUMA node " << node
+               << " failed: " << strerror(errno);
+  }
+#endif
+}
 
 int NUMAGetThreadNodeAffinity() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!NUMAEnabled()) return kNUMANoAffinity;
+  cpu_set_t cpus;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus) != 0) {
+    return kNUMANoAffinity;
+  }
+  const NUMATopology& topology = GetNUMATopology();
+  for (int node = 0; node < topology.node_cpus.size(); ++node) {
+    // The thread has affinity to "node" if it may only run on its CPUs.
+    cpu_set_t on_node;
+    CPU_AND(&on_node, &cpus, &topology.node_cpus[node]);
+    if (CPU_EQUAL(&on_node, &cpus)) return node;
+  }
+#endif
   return kNUMANoAffinity;
 }
 
@@ -143,12 +258,50 @@ void Free(void* ptr) {
 }
 
 void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const NUMATopology& topology = GetNUMATopology();
+  if (NUMAEnabled() && node >= 0 && node < topology.node_cpus.size()) {
+    // Memory policies apply to whole pages, so page-align the buffer and
+    // ask the kernel to back it from "node" when its pages are first
+    // touched. The policy is only a preference: if the node runs out of
+    // memory the pages come from another node instead of failing.
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    void* ptr = AlignedMalloc(
+        size, std::max<size_t>(minimum_alignment, page_size));
+    if (ptr == nullptr || size == 0) return ptr;
+    const int kernel_node = topology.kernel_node_ids[node];
+    unsigned long mask[CPU_SETSIZE / (8 * sizeof(unsigned long))] = {};
+    if (kernel_node < 8 * sizeof(mask)) {
+      mask[kernel_node / (8 * sizeof(unsigned long))] |=
+          1UL << (kernel_node % (8 * sizeof(unsigned long)));
+      const size_t len = (size + page_size - 1) / page_size * page_size;
+      if (syscall(SYS_mbind, ptr, len, kMpolPreferred, mask, 8 * sizeof(mask),
+                  0) != 0) {
+        VLOG(1) << "mbind to NUMA node " << node
+                << " failed: " << strerror(errno);
+      }
+    }
+    return ptr;
+  }
+#endif
   return AlignedMalloc(size, minimum_alignment);
 }
 
 void NUMAFree(void* ptr, size_t size) { Free(ptr); }
 
 int NUMAGetMemAffinity(const void* addr) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (!NUMAEnabled()) return kNUMANoAffinity;
+  int kernel_node = -1;
+  if (syscall(SYS_get_mempolicy, &kernel_node, nullptr, 0, addr,
+              kMpolFNode | kMpolFAddr) != 0) {
+    return kNUMANoAffinity;
+  }
+  const NUMATopology& topology = GetNUMATopology();
+  for (int node = 0; node < topology.kernel_node_ids.size(); ++node) {
+    if (topology.kernel_node_ids[node] == kernel_node) return node;
+  }
+#endif
   return kNUMANoAffinity;
 }
 
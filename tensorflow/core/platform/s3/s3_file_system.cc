@@ -13,8 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/platform/s3/s3_file_system.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/s3/aws_crypto.h"
@@ -29,15 +33,23 @@ limitations under the License.
 #include <aws/core/utils/StringUtils.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/S3Errors.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
 #include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/DeleteObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <vector>
 
 namespace tensorflow {
 
@@ -45,6 +57,37 @@ namespace {
 static const char* kS3FileSystemAllocationTag = "S3FileSystemAllocation";
 static const size_t kS3ReadAppendableFileBufferSize = 1024 * 1024;
 static const int kS3GetChildrenMaxKeys = 100;
+// The environment variables configuring the block cache of the reads.
+static const char* kReadCacheBlockSizeEnv = "S3_READ_CACHE_BLOCK_SIZE_MB";
+static const size_t kDefaultReadCacheBlockSize = 16 * 1024 * 1024;
+static const char* kReadCacheMaxSizeEnv = "S3_READ_CACHE_MAX_SIZE_MB";
+static const size_t kDefaultReadCacheMaxSize = 128 * 1024 * 1024;
+static const char* kReadCachePrefetchBlocksEnv =
+    "S3_READ_CACHE_PREFETCH_BLOCKS";
+static const size_t kDefaultReadCachePrefetchBlocks = 4;
+// The environment variables configuring the multipart uploads.
+static const char* kUploadPartSizeEnv = "S3_UPLOAD_PART_SIZE_MB";
+static const size_t kDefaultUploadPartSize = 64 * 1024 * 1024;
+// S3 rejects the parts smaller than 5MB, but the last one.
+static const size_t kMinUploadPartSize = 5 * 1024 * 1024;
+static const char* kUploadPartsInFlightEnv = "S3_UPLOAD_PARTS_IN_FLIGHT";
+static const size_t kDefaultUploadPartsInFlight = 4;
+
+// Returns the value of the environment variable `name`, multiplied by
+// `multiplier`, or `default_value` if it isn't set to a number.
+size_t GetEnvSize(const char* name, size_t multiplier, size_t default_value) {
+  const char* value = getenv(name);
+  uint64 parsed;
+  if (value && strings::safe_strtou64(value, &parsed)) {
+    return parsed * multiplier;
+  }
+  return default_value;
+}
+
+Status AwsErrorToStatus(const Aws::Client::AWSError<Aws::S3::S3Errors>& error) {
+  return errors::Internal(strings::StrCat(error.GetExceptionName().c_str(),
+                                          ": ", error.GetMessage().c_str()));
+}
 
 Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   static mutex cfg_lock(LINKER_INITIALIZED);
@@ -165,49 +208,46 @@ Status ParseS3Path(const string& fname, bool empty_object_ok, string* bucket,
   return Status::OK();
 }
 
+// Reads through the block cache of the file system, which turns the small
+// reads into block sized ranged GETs and prefetches the next blocks of the
+// sequential reads concurrently.
 class S3RandomAccessFile : public RandomAccessFile {
  public:
-  S3RandomAccessFile(const string& bucket, const string& object,
-                     std::shared_ptr<Aws::S3::S3Client> s3_client)
-      : bucket_(bucket), object_(object), s3_client_(s3_client) {}
+  S3RandomAccessFile(const string& filename, FileBlockCache* file_block_cache)
+      : filename_(filename), file_block_cache_(file_block_cache) {}
 
   Status Read(uint64 offset, size_t n, StringPiece* result,
               char* scratch) const override {
-    Aws::S3::Model::GetObjectRequest getObjectRequest;
-    getObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
-    string bytes = strings::StrCat("bytes=", offset, "-", offset + n - 1);
-    getObjectRequest.SetRange(bytes.c_str());
-    getObjectRequest.SetResponseStreamFactory([]() {
-      return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag);
-    });
-    auto getObjectOutcome = this->s3_client_->GetObject(getObjectRequest);
-    if (!getObjectOutcome.IsSuccess()) {
-      n = 0;
-      *result = StringPiece(scratch, n);
-      return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
-    }
-    n = getObjectOutcome.GetResult().GetContentLength();
-    std::stringstream ss;
-    ss << getObjectOutcome.GetResult().GetBody().rdbuf();
-    ss.read(scratch, n);
-
-    *result = StringPiece(scratch, n);
+    *result = StringPiece();
+    size_t bytes_transferred;
+    TF_RETURN_IF_ERROR(file_block_cache_->Read(filename_, offset, n, scratch,
+                                               &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      return errors::OutOfRange("Read less bytes than requested");
+    }
     return Status::OK();
   }
 
  private:
-  string bucket_;
-  string object_;
-  std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  const string filename_;
+  FileBlockCache* const file_block_cache_;  // not owned
 };
 
 class S3WritableFile : public WritableFile {
  public:
   S3WritableFile(const string& bucket, const string& object,
-                 std::shared_ptr<Aws::S3::S3Client> s3_client)
+                 std::shared_ptr<Aws::S3::S3Client> s3_client,
+                 thread::ThreadPool* upload_pool, size_t upload_part_size,
+                 int max_upload_parts_in_flight,
+                 std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         s3_client_(s3_client),
+        upload_pool_(upload_pool),
+        upload_part_size_(upload_part_size),
+        max_upload_parts_in_flight_(max_upload_parts_in_flight),
+        file_cache_erase_(std::move(file_cache_erase)),
         sync_needed_(true),
         outfile_(Aws::MakeShared<Aws::Utils::TempFile>(
             kS3FileSystemAllocationTag, "/tmp/s3_filesystem_XXXXXX",
@@ -246,28 +286,139 @@ class S3WritableFile : public WritableFile {
     if (!sync_needed_) {
       return Status::OK();
     }
-    Aws::S3::Model::PutObjectRequest putObjectRequest;
-    putObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
     long offset = outfile_->tellp();
     outfile_->seekg(0);
-    putObjectRequest.SetBody(outfile_);
-    putObjectRequest.SetContentLength(offset);
-    auto putObjectOutcome = this->s3_client_->PutObject(putObjectRequest);
+    Status status = offset > static_cast<long>(upload_part_size_)
+                        ? MultipartUpload(offset)
+                        : PutObject(offset);
     outfile_->clear();
     outfile_->seekp(offset);
+    file_cache_erase_();
+    if (status.ok()) {
+      sync_needed_ = false;
+    }
+    return status;
+  }
+
+ private:
+  // Uploads the `size` bytes of the temporary file with a single request.
+  Status PutObject(long size) {
+    Aws::S3::Model::PutObjectRequest putObjectRequest;
+    putObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+    putObjectRequest.SetBody(outfile_);
+    putObjectRequest.SetContentLength(size);
+    auto putObjectOutcome = this->s3_client_->PutObject(putObjectRequest);
     if (!putObjectOutcome.IsSuccess()) {
-      string error = strings::StrCat(
-          putObjectOutcome.GetError().GetExceptionName().c_str(), ": ",
-          putObjectOutcome.GetError().GetMessage().c_str());
-      return errors::Internal(error);
+      return AwsErrorToStatus(putObjectOutcome.GetError());
+    }
+    return Status::OK();
+  }
+
+  // Uploads the `size` bytes of the temporary file in parts of
+  // upload_part_size_, uploaded concurrently on upload_pool_. The parts
+  // uploaded so far are discarded if any of them fails.
+  Status MultipartUpload(long size) {
+    Aws::S3::Model::CreateMultipartUploadRequest createRequest;
+    createRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
+    auto createOutcome =
+        this->s3_client_->CreateMultipartUpload(createRequest);
+    if (!createOutcome.IsSuccess()) {
+      return AwsErrorToStatus(createOutcome.GetError());
+    }
+    const Aws::String upload_id = createOutcome.GetResult().GetUploadId();
+
+    Aws::S3::Model::CompletedMultipartUpload completedUpload;
+    Status status = UploadParts(size, upload_id, &completedUpload);
+    if (status.ok()) {
+      Aws::S3::Model::CompleteMultipartUploadRequest completeRequest;
+      completeRequest.WithBucket(bucket_.c_str())
+          .WithKey(object_.c_str())
+          .WithUploadId(upload_id)
+          .WithMultipartUpload(completedUpload);
+      auto completeOutcome =
+          this->s3_client_->CompleteMultipartUpload(completeRequest);
+      if (!completeOutcome.IsSuccess()) {
+        status = AwsErrorToStatus(completeOutcome.GetError());
+      }
+    }
+    if (!status.ok()) {
+      Aws::S3::Model::AbortMultipartUploadRequest abortRequest;
+      abortRequest.WithBucket(bucket_.c_str())
+          .WithKey(object_.c_str())
+          .WithUploadId(upload_id);
+      this->s3_client_->AbortMultipartUpload(abortRequest);
+    }
+    return status;
+  }
+
+  // Uploads the parts of the multipart upload `upload_id`, in waves of
+  // max_upload_parts_in_flight_ parts, and adds them to `completed`.
+  Status UploadParts(long size, const Aws::String& upload_id,
+                     Aws::S3::Model::CompletedMultipartUpload* completed) {
+    const long part_size = upload_part_size_;
+    const int num_parts = (size + part_size - 1) / part_size;
+    std::vector<Aws::S3::Model::CompletedPart> parts(num_parts);
+    std::vector<Status> statuses(num_parts);
+    for (int first = 0; first < num_parts;
+         first += max_upload_parts_in_flight_) {
+      const int last =
+          std::min(num_parts, first + max_upload_parts_in_flight_);
+      BlockingCounter counter(last - first);
+      for (int i = first; i < last; ++i) {
+        // The parts are copied out of the temporary file, since its stream
+        // can't be read concurrently.
+        const long length = std::min(part_size, size - i * part_size);
+        std::unique_ptr<char[]> data(new char[length]);
+        outfile_->read(data.get(), length);
+        if (outfile_->gcount() != length) {
+          statuses[i] = errors::Internal(
+              "Could not read the internal temporary file.");
+          counter.DecrementCount();
+          continue;
+        }
+        auto body =
+            Aws::MakeShared<Aws::StringStream>(kS3FileSystemAllocationTag);
+        body->write(data.get(), length);
+        upload_pool_->Schedule([this, i, length, body, &upload_id, &parts,
+                                &statuses, &counter]() {
+          Aws::S3::Model::UploadPartRequest uploadPartRequest;
+          uploadPartRequest.WithBucket(bucket_.c_str())
+              .WithKey(object_.c_str())
+              .WithUploadId(upload_id)
+              .WithPartNumber(i + 1)
+              .WithContentLength(length);
+          uploadPartRequest.SetBody(body);
+          auto uploadPartOutcome =
+              this->s3_client_->UploadPart(uploadPartRequest);
+          if (uploadPartOutcome.IsSuccess()) {
+            parts[i]
+                .WithETag(uploadPartOutcome.GetResult().GetETag())
+                .WithPartNumber(i + 1);
+          } else {
+            statuses[i] = AwsErrorToStatus(uploadPartOutcome.GetError());
+          }
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+      for (int i = first; i < last; ++i) {
+        TF_RETURN_IF_ERROR(statuses[i]);
+      }
+    }
+    for (const auto& part : parts) {
+      completed->AddParts(part);
     }
     return Status::OK();
   }
 
- private:
   string bucket_;
   string object_;
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  thread::ThreadPool* const upload_pool_;  // not owned
+  const size_t upload_part_size_;
+  const int max_upload_parts_in_flight_;
+  // Removes the blocks of the object from the read cache after an upload.
+  const std::function<void()> file_cache_erase_;
   bool sync_needed_;
   std::shared_ptr<Aws::Utils::TempFile> outfile_;
 };
@@ -287,7 +438,13 @@ class S3ReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
 }  // namespace
 
 S3FileSystem::S3FileSystem()
-    : s3_client_(nullptr, ShutdownClient), client_lock_() {}
+    : s3_client_(nullptr, ShutdownClient), client_lock_() {
+  upload_part_size_ =
+      std::max(kMinUploadPartSize, GetEnvSize(kUploadPartSizeEnv, 1024 * 1024,
+                                              kDefaultUploadPartSize));
+  max_upload_parts_in_flight_ = std::max<size_t>(
+      1, GetEnvSize(kUploadPartsInFlightEnv, 1, kDefaultUploadPartsInFlight));
+}
 
 S3FileSystem::~S3FileSystem() {}
 
@@ -321,11 +478,89 @@ std::shared_ptr<Aws::S3::S3Client> S3FileSystem::GetS3Client() {
   return this->s3_client_;
 }
 
+FileBlockCache* S3FileSystem::GetFileBlockCache() {
+  std::lock_guard<mutex> lock(this->cache_lock_);
+
+  if (this->file_block_cache_ == nullptr) {
+    const size_t block_size = GetEnvSize(kReadCacheBlockSizeEnv, 1024 * 1024,
+                                         kDefaultReadCacheBlockSize);
+    const size_t max_bytes = GetEnvSize(kReadCacheMaxSizeEnv, 1024 * 1024,
+                                        kDefaultReadCacheMaxSize);
+    const size_t max_prefetch_blocks = GetEnvSize(
+        kReadCachePrefetchBlocksEnv, 1, kDefaultReadCachePrefetchBlocks);
+    this->file_block_cache_.reset(new RamFileBlockCache(
+        block_size, max_bytes, 0 /* max staleness */,
+        [this](const string& filename, size_t offset, size_t n, char* buffer,
+               size_t* bytes_transferred) {
+          return LoadBufferFromS3(filename, offset, n, buffer,
+                                  bytes_transferred);
+        },
+        Env::Default(), max_prefetch_blocks));
+  }
+
+  return this->file_block_cache_.get();
+}
+
+thread::ThreadPool* S3FileSystem::GetUploadPool() {
+  std::lock_guard<mutex> lock(this->cache_lock_);
+
+  if (this->upload_pool_ == nullptr) {
+    this->upload_pool_.reset(new thread::ThreadPool(
+        Env::Default(), "s3_upload", this->max_upload_parts_in_flight_));
+  }
+
+  return this->upload_pool_.get();
+}
+
+Status S3FileSystem::LoadBufferFromS3(const string& fname, size_t offset,
+                                      size_t n, char* buffer,
+                                      size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+
+  Aws::S3::Model::GetObjectRequest getObjectRequest;
+  getObjectRequest.WithBucket(bucket.c_str()).WithKey(object.c_str());
+  string bytes = strings::StrCat("bytes=", offset, "-", offset + n - 1);
+  getObjectRequest.SetRange(bytes.c_str());
+  getObjectRequest.SetResponseStreamFactory(
+      []() { return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag); });
+  auto getObjectOutcome = this->GetS3Client()->GetObject(getObjectRequest);
+  if (!getObjectOutcome.IsSuccess()) {
+    if (getObjectOutcome.GetError().GetResponseCode() ==
+        Aws::Http::HttpResponseCode::REQUESTED_RANGE_NOT_SATISFIABLE) {
+      // The offset is at or past the end of the object.
+      return Status::OK();
+    }
+    return AwsErrorToStatus(getObjectOutcome.GetError());
+  }
+  const size_t length = std::min<size_t>(
+      n, getObjectOutcome.GetResult().GetContentLength());
+  getObjectOutcome.GetResult().GetBody().read(buffer, length);
+  *bytes_transferred = getObjectOutcome.GetResult().GetBody().gcount();
+  return Status::OK();
+}
+
 Status S3FileSystem::NewRandomAccessFile(
     const string& fname, std::unique_ptr<RandomAccessFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
-  result->reset(new S3RandomAccessFile(bucket, object, this->GetS3Client()));
+
+  FileBlockCache* file_block_cache = GetFileBlockCache();
+  if (file_block_cache->IsCacheEnabled()) {
+    // The blocks of a previous version of the object are dropped.
+    Aws::S3::Model::HeadObjectRequest headObjectRequest;
+    headObjectRequest.WithBucket(bucket.c_str()).WithKey(object.c_str());
+    auto headObjectOutcome =
+        this->GetS3Client()->HeadObject(headObjectRequest);
+    if (headObjectOutcome.IsSuccess()) {
+      file_block_cache->ValidateAndUpdateFileSignature(
+          fname, Hash64(headObjectOutcome.GetResult().GetETag().c_str()));
+    } else {
+      file_block_cache->RemoveFile(fname);
+    }
+  }
+  result->reset(new S3RandomAccessFile(fname, file_block_cache));
   return Status::OK();
 }
 
@@ -333,7 +568,11 @@ Status S3FileSystem::NewWritableFile(const string& fname,
                                      std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
-  result->reset(new S3WritableFile(bucket, object, this->GetS3Client()));
+  FileBlockCache* file_block_cache = GetFileBlockCache();
+  result->reset(new S3WritableFile(
+      bucket, object, this->GetS3Client(), GetUploadPool(), upload_part_size_,
+      max_upload_parts_in_flight_,
+      [file_block_cache, fname]() { file_block_cache->RemoveFile(fname); }));
   return Status::OK();
 }
 
@@ -346,9 +585,7 @@ Status S3FileSystem::NewAppendableFile(const string& fname,
   uint64 offset = 0;
   StringPiece read_chunk;
 
-  string bucket, object;
-  TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
-  result->reset(new S3WritableFile(bucket, object, this->GetS3Client()));
+  TF_RETURN_IF_ERROR(NewWritableFile(fname, result));
 
   while (true) {
     status = reader->Read(offset, kS3ReadAppendableFileBufferSize, &read_chunk,
@@ -512,6 +749,7 @@ Status S3FileSystem::DeleteFile(const string& fname) {
 
   auto deleteObjectOutcome =
       this->GetS3Client()->DeleteObject(deleteObjectRequest);
+  GetFileBlockCache()->RemoveFile(fname);
   if (!deleteObjectOutcome.IsSuccess()) {
     string error = strings::StrCat(
         deleteObjectOutcome.GetError().GetExceptionName().c_str(), ": ",
@@ -652,6 +890,10 @@ Status S3FileSystem::RenameFile(const string& src, const string& target) {
             deleteObjectOutcome.GetError().GetMessage().c_str());
         return errors::Internal(error);
       }
+      GetFileBlockCache()->RemoveFile(
+          strings::StrCat("s3://", src_bucket, "/", src_key.c_str()));
+      GetFileBlockCache()->RemoveFile(
+          strings::StrCat("s3://", target_bucket, "/", target_key.c_str()));
     }
     listObjectsRequest.SetMarker(listObjectsResult.GetNextMarker());
   } while (listObjectsResult.GetIsTruncated());
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CONTRIB_S3_S3_FILE_SYSTEM_H_
 
 #include <aws/s3/S3Client.h>
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 
@@ -75,9 +77,39 @@ class S3FileSystem : public FileSystem {
   // for a bucket.
   std::shared_ptr<Aws::S3::S3Client> GetS3Client();
 
+  // Returns the cache of the blocks read by the random access files, which
+  // prefetches the next blocks of sequential reads with concurrent ranged
+  // GETs, initializing as-needed. Its size is controlled by
+  // `S3_READ_CACHE_BLOCK_SIZE_MB`, `S3_READ_CACHE_MAX_SIZE_MB` and
+  // `S3_READ_CACHE_PREFETCH_BLOCKS`; a max size of 0 disables it.
+  FileBlockCache* GetFileBlockCache();
+
+  // Returns the threads uploading the parts of the files larger than
+  // `S3_UPLOAD_PART_SIZE_MB`, at most `S3_UPLOAD_PARTS_IN_FLIGHT` at a time,
+  // initializing as-needed.
+  thread::ThreadPool* GetUploadPool();
+
+  // Reads `n` bytes of `fname` at `offset` into `buffer` with a ranged GET.
+  // Reads past the end of the object transfer fewer bytes and return OK.
+  Status LoadBufferFromS3(const string& fname, size_t offset, size_t n,
+                          char* buffer, size_t* bytes_transferred);
+
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
   // Lock held when checking for s3_client_ initialization.
   mutex client_lock_;
+
+  // The size of the parts of the multipart uploads, in bytes.
+  size_t upload_part_size_;
+  // The maximum number of parts uploaded concurrently by a file.
+  int max_upload_parts_in_flight_;
+
+  // Declared after s3_client_, so that they are destroyed before the client
+  // used by their pending requests.
+  std::unique_ptr<FileBlockCache> file_block_cache_ GUARDED_BY(cache_lock_);
+  std::unique_ptr<thread::ThreadPool> upload_pool_ GUARDED_BY(cache_lock_);
+  // Lock held when checking for file_block_cache_ and upload_pool_
+  // initialization.
+  mutex cache_lock_;
 };
 
 }  // namespace tensorflow
@@ -120,6 +120,11 @@ void DeleteProfiler() {
   }
 }
 
+void SetMaxSampledSteps(int64 max_steps) {
+  CHECK(tf_stat);
+  tf_stat->SetMaxSampledSteps(max_steps);
+}
+
 double AddStep(int64 step, const string* graph, const string* run_meta,
                const string* op_log) {
   CHECK(tf_stat);
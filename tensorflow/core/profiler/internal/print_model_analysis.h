@@ -38,6 +38,10 @@ void DeleteProfiler();
 double AddStep(int64 step, const string* graph, const string* run_meta,
                const string* op_log);
 
+// Keeps the stats of at most `max_steps` of the steps added afterwards,
+// sampled uniformly. 0 keeps all the steps.
+void SetMaxSampledSteps(int64 max_steps);
+
 // Write the profiler's profile to a proto buffer.
 void WriteProfile(const string* filename);
 
@@ -95,6 +95,9 @@ void ExecStep::AddMemoryStats(const string& dev,
     // TODO(xpan): Fix this hack. Currently the allocator name seems quite
     // ad-hoc.
     if (mem.allocator_name().find("GPU") == mem.allocator_name().npos) {
+      for (const auto& alloc : mem.allocation_records()) {
+        host_allocations_.push_back(alloc);
+      }
       continue;
     }
     ++accelerator_allocator_cnt;
@@ -187,6 +187,9 @@ class ExecStep {
   const std::vector<AllocationRecord>& allocations() const {
     return allocations_;
   }
+  const std::vector<AllocationRecord>& host_allocations() const {
+    return host_allocations_;
+  }
 
   const ExecProfile& ToProto() {
     exec_.mutable_accelerator_execs()->clear();
@@ -218,6 +221,10 @@ class ExecStep {
     for (const auto& r : allocations_) {
       exec_.add_allocations()->MergeFrom(r);
     }
+    exec_.mutable_host_allocations()->Clear();
+    for (const auto& r : host_allocations_) {
+      exec_.add_host_allocations()->MergeFrom(r);
+    }
 
     exec_.mutable_memory_execs()->Clear();
     for (const auto& m : memory_execs_) {
@@ -238,6 +245,7 @@ class ExecStep {
     op_execs_.clear();
 
     allocations_.clear();
+    host_allocations_.clear();
     memory_execs_.clear();
 
     for (const auto& exec_time : exec_.accelerator_execs()) {
@@ -259,6 +267,9 @@ class ExecStep {
     for (const auto& r : exec_.allocations()) {
       allocations_.push_back(r);
     }
+    for (const auto& r : exec_.host_allocations()) {
+      host_allocations_.push_back(r);
+    }
     for (const auto& m : exec_.memory_execs()) {
       memory_execs_.push_back(m);
     }
@@ -285,6 +296,8 @@ class ExecStep {
 
   // The history of accelerator allocations and deallocations of this step.
   std::vector<AllocationRecord> allocations_;
+  // The history of host allocations and deallocations of this step.
+  std::vector<AllocationRecord> host_allocations_;
 };
 
 #define GRAPH_NODE_BYTES(type)             \
@@ -355,6 +368,12 @@ class TFGraphNode {
 
   void AddFloatOps(int64 float_ops) { node_.set_float_ops(float_ops); }
 
+  // Drops the run time stats of `step`.
+  void RemoveStep(int64 step) {
+    execs_.erase(step);
+    node_.mutable_execs()->erase(step);
+  }
+
   // TODO(xpan): This could take a lot of memory.
   void AddCode(const CodeDef& code,
                const std::map<int64, string>* id_to_string) {
@@ -638,6 +657,14 @@ class TFGraphNode {
     }
     return persistent_bytes;
   }
+  int64 host_persistent_bytes() const {
+    int64 persistent_bytes = 0;
+    for (const auto& exec : execs_) {
+      persistent_bytes =
+          std::max(persistent_bytes, exec.second.host_persistent_bytes());
+    }
+    return persistent_bytes;
+  }
   const std::map<int64, int64> allocator_bytes_in_use(int64 step) const {
     auto exec = execs_.find(step);
     if (exec == execs_.end()) {
@@ -654,6 +681,14 @@ class TFGraphNode {
     return exec->second.allocations();
   }
 
+  const std::vector<AllocationRecord>& host_allocations(int64 step) const {
+    auto exec = execs_.find(step);
+    if (exec == execs_.end()) {
+      return empty_allocations_;
+    }
+    return exec->second.host_allocations();
+  }
+
   int64 parameters() const {
     if (!shape().empty()) {
       int64 params = 1;
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/internal/tfprof_stats.h"
 
 #include <stdio.h>
+#include <iterator>
 #include <utility>
 
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -260,13 +261,41 @@ void TFStats::AddOpLogProto(std::unique_ptr<OpLogProto> op_log) {
   }
 }
 
+void TFStats::SetMaxSampledSteps(int64 max_steps) {
+  max_sampled_steps_ = max_steps;
+  num_offered_steps_ = steps_.size();
+}
+
+bool TFStats::MaybeSampleStep() {
+  if (max_sampled_steps_ <= 0) {
+    return true;
+  }
+  ++num_offered_steps_;
+  if (static_cast<int64>(steps_.size()) < max_sampled_steps_) {
+    return true;
+  }
+  // Reservoir sampling: the n-th step replaces a random sampled step with
+  // probability max_sampled_steps_ / n.
+  const uint64 slot = rng_.Uniform64(num_offered_steps_);
+  if (slot >= static_cast<uint64>(max_sampled_steps_)) {
+    return false;
+  }
+  auto evicted = steps_.begin();
+  std::advance(evicted, slot);
+  for (auto& node : nodes_map_) {
+    node.second->RemoveStep(*evicted);
+  }
+  steps_.erase(evicted);
+  return true;
+}
+
 void TFStats::AddRunMeta(int64 step, std::unique_ptr<RunMetadata> run_meta) {
   if (!run_meta || !run_meta->has_step_stats()) {
     fprintf(stderr, "Invalid RunMetadata for step %lld\n", step);
     return;
   }
-  if (steps_.find(step) == steps_.end()) {
-    steps_.insert(step);
+  if (steps_.find(step) == steps_.end() && !MaybeSampleStep()) {
+    return;
   }
   steps_.insert(step);
 
@@ -33,6 +33,8 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/profiler/internal/tfprof_code.h"
 #include "tensorflow/core/profiler/internal/tfprof_graph.h"
@@ -88,6 +90,11 @@ class TFStats {
 
   // Add a step of run time meta data.
   void AddRunMeta(int64 step, std::unique_ptr<RunMetadata> run_meta);
+  // Keeps the stats of at most `max_steps` of the steps added from now on,
+  // picked uniformly at random, so that the per-step averages of the views
+  // estimate the costs over a long run with bounded memory. 0 keeps all the
+  // steps.
+  void SetMaxSampledSteps(int64 max_steps);
   // Add tfprof operation meta data, such as customized op type, float_ops,
   // and code traces.
   void AddOpLogProto(std::unique_ptr<OpLogProto> op_log);
@@ -101,8 +108,16 @@ class TFStats {
  private:
   bool Validate(const Options& opts) const;
   string MaybeReportMissingTrace() const;
+  // Returns whether a new step should be added, evicting a sampled step to
+  // make room for it when needed.
+  bool MaybeSampleStep();
 
   std::set<int64> steps_;
+  int64 max_sampled_steps_ = 0;
+  // The number of new steps added since SetMaxSampledSteps, kept or not.
+  int64 num_offered_steps_ = 0;
+  random::PhiloxRandom philox_{0x5eed};
+  random::SimplePhilox rng_{&philox_};
   bool has_code_traces_;
   bool miss_accelerator_stream_;
   std::unique_ptr<TFScope> scope_view_;
@@ -42,13 +42,7 @@ class TFProfStatsTest : public ::testing::Test {
     TF_CHECK_OK(
         ReadProtoFile(Env::Default(), graph_path, graph_pb.get(), false));
 
-    std::unique_ptr<tensorflow::RunMetadata> run_meta_pb(
-        new tensorflow::RunMetadata());
-    string run_meta_path =
-        io::JoinPath(testing::TensorFlowSrcRoot(),
-                     "core/profiler/internal/testdata/run_meta");
-    TF_CHECK_OK(
-        ReadProtoFile(Env::Default(), run_meta_path, run_meta_pb.get(), true));
+    std::unique_ptr<tensorflow::RunMetadata> run_meta_pb = ReadRunMeta();
 
     std::unique_ptr<OpLogProto> op_log_pb(new OpLogProto());
     string op_log_path =
@@ -69,6 +63,17 @@ class TFProfStatsTest : public ::testing::Test {
     tf_stats_->BuildAllViews();
   }
 
+  static std::unique_ptr<RunMetadata> ReadRunMeta() {
+    std::unique_ptr<tensorflow::RunMetadata> run_meta_pb(
+        new tensorflow::RunMetadata());
+    string run_meta_path =
+        io::JoinPath(testing::TensorFlowSrcRoot(),
+                     "core/profiler/internal/testdata/run_meta");
+    TF_CHECK_OK(
+        ReadProtoFile(Env::Default(), run_meta_path, run_meta_pb.get(), true));
+    return run_meta_pb;
+  }
+
   string TestToFromProto(const string& cmd, const Options& opts) {
     string profile_file = io::JoinPath(testing::TmpDir(), "profile");
     tf_stats_->WriteProfile(profile_file);
@@ -375,5 +380,21 @@ TEST_F(TFProfStatsTest, TestShowTensorValue) {
   EXPECT_EQ(expected.DebugString(), root.DebugString());
 }
 
+TEST_F(TFProfStatsTest, SampledSteps) {
+  tf_stats_->SetMaxSampledSteps(10);
+  const int kNumSteps = 1000;
+  for (int step = 1; step < kNumSteps; ++step) {
+    tf_stats_->AddRunMeta(step, ReadRunMeta());
+  }
+  EXPECT_EQ(10, tf_stats_->steps().size());
+  // The sample spans the whole run rather than its first steps.
+  EXPECT_GT(*tf_stats_->steps().rbegin(), kNumSteps / 2);
+  for (const auto& node : tf_stats_->nodes()) {
+    for (const auto& exec : node.second->all_op_execs()) {
+      EXPECT_EQ(1, tf_stats_->steps().count(exec.first)) << exec.first;
+    }
+  }
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -149,15 +149,26 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
     return;
   }
 
-  Device& dev = devices_[node->node->canonical_device()];
+  const string& device = node->node->canonical_device();
+  Device& dev = devices_[device];
+
+  // Ops placed on cpu are charged for their host allocations, other ops for
+  // their accelerator allocations.
+  const bool on_cpu = IsPlacedOnCPU(device);
+  const std::vector<AllocationRecord>& records =
+      on_cpu ? node->node->host_allocations(step)
+             : node->node->allocations(step);
+  const int64 persistent_bytes =
+      on_cpu ? node->node->host_persistent_bytes()
+             : node->node->accelerator_persistent_bytes();
 
   std::map<int64, int64> allocs;
-  for (const auto& alloc : node->node->allocations(step)) {
+  for (const auto& alloc : records) {
     allocs[alloc.alloc_micros()] += alloc.alloc_bytes();
     dev.tracked_allocations[alloc.alloc_micros()] += alloc.alloc_bytes();
   }
-  dev.tracked_allocations[0] += node->node->accelerator_persistent_bytes();
-  allocs[0] += node->node->accelerator_persistent_bytes();
+  dev.tracked_allocations[0] += persistent_bytes;
+  allocs[0] += persistent_bytes;
 
   int64 last = 0;
   std::map<int64, int64>& aggregate_allocs = dev.tensor_allocs[node->name()];
@@ -165,12 +176,43 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
     last += it->second;
     aggregate_allocs[it->first] = last;
   }
+  // Only the accelerator allocators report their bytes in use.
+  if (on_cpu) return;
   for (const auto& bytes_in_use : node->node->allocator_bytes_in_use(step)) {
     if (bytes_in_use.first <= 0) continue;
     dev.allocations[bytes_in_use.first] = bytes_in_use.second;
   }
 }
 
+std::map<int64, int64> MemoryTracker::Device::BytesInUse() const {
+  if (!allocations.empty()) {
+    return allocations;
+  }
+  std::map<int64, int64> bytes_in_use;
+  int64 bytes = 0;
+  for (const auto& alloc : tracked_allocations) {
+    bytes += alloc.second;
+    bytes_in_use[alloc.first] = bytes;
+  }
+  return bytes_in_use;
+}
+
+std::map<int64, std::vector<string>> MemoryTracker::Device::LiveBytesByNode(
+    int64 ts) const {
+  std::map<int64, std::vector<string>> tensor_mem;
+  for (const auto& tensor_alloc_it : tensor_allocs) {
+    const auto& tensor_alloc = tensor_alloc_it.second;
+    auto it = tensor_alloc.lower_bound(ts);
+    if (it != tensor_alloc.begin()) {
+      --it;
+    }
+    if (it->second > 0) {
+      tensor_mem[it->second].push_back(tensor_alloc_it.first);
+    }
+  }
+  return tensor_mem;
+}
+
 void Timeline::AllocateTimeNodes(GraphNode* gnode) {
   if (gnode->Trackable(step_)) {
     TrackNode(gnode);
@@ -263,8 +305,11 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
     }
   }
   for (const auto& dev : mem_tracker_.devices()) {
-    if (IsPlacedOnCPU(dev.first)) {
-      // TODO(xpan): Maybe also support CPU allocator memory tracking.
+    const MemoryTracker::Device& device = dev.second;
+    // The host allocators don't report their bytes in use, so the host lanes
+    // plot the bytes tracked for the ops.
+    const std::map<int64, int64> bytes_in_use = device.BytesInUse();
+    if (bytes_in_use.empty()) {
       continue;
     }
     int64 pid = AllocatePID();
@@ -273,36 +318,39 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
     chrome_formatter_.EmitPID(GetMemoryLaneName(dev.first) + " allocations",
                               pid2);
 
-    const MemoryTracker::Device& device = dev.second;
-
     int64 max_bytes_in_use = 0;
+    int64 max_bytes_micros = 0;
     int64 cur_bytes_in_use = 0;
     int64 last_point = 0;
-    for (const auto& alloc : device.allocations) {
+    for (const auto& alloc : bytes_in_use) {
       cur_bytes_in_use = alloc.second;
-      max_bytes_in_use = std::max(max_bytes_in_use, cur_bytes_in_use);
+      if (cur_bytes_in_use > max_bytes_in_use) {
+        max_bytes_in_use = cur_bytes_in_use;
+        max_bytes_micros = alloc.first;
+      }
       // Do not plot too dense to reduce file size.
       int64 ts = alloc.first;
       if (ts - last_point < 100) continue;
       last_point = ts;
 
-      std::map<int64, std::vector<string>> tensor_mem;
-      for (const auto& tensor_alloc_it : dev.second.tensor_allocs) {
-        const auto& tensor_alloc = tensor_alloc_it.second;
-        auto it = tensor_alloc.lower_bound(ts);
-        if (it != tensor_alloc.begin()) {
-          --it;
-        }
-        if (it->second > 0) {
-          tensor_mem[it->second].push_back(tensor_alloc_it.first);
-        }
-      }
       chrome_formatter_.EmitCounter("Memory", "Memory Series", pid, ts,
-                                    dev.first, cur_bytes_in_use, tensor_mem);
+                                    dev.first, cur_bytes_in_use,
+                                    device.LiveBytesByNode(ts));
     }
-    if (IsPlacedOnAccelerator(dev.first)) {
-      fprintf(stdout, "%s peak memory: %.2f MB\n", dev.first.c_str(),
-              max_bytes_in_use / 1000000.0);
+    fprintf(stdout, "%s peak memory: %.2f MB\n", dev.first.c_str(),
+            max_bytes_in_use / 1000000.0);
+    // Attributes the peak to the ops whose memory is live at that time.
+    const std::map<int64, std::vector<string>> peak_mem =
+        device.LiveBytesByNode(max_bytes_micros + 1);
+    int count = 0;
+    for (auto it = peak_mem.rbegin();
+         it != peak_mem.rend() && count < kMaxDisplayedMemNode; ++it) {
+      for (const string& name : it->second) {
+        if (count >= kMaxDisplayedMemNode) break;
+        fprintf(stdout, "  %.2f MB from %s\n", it->first / 1000000.0,
+                name.c_str());
+        ++count;
+      }
     }
   }
   OutputTimeline();
@@ -109,6 +109,13 @@ class MemoryTracker {
     std::map<int64, int64> allocations;
     // tracked allocations, might miss some bytes.
     std::map<int64, int64> tracked_allocations;
+
+    // The ground truth bytes in use over time if the allocator reports them,
+    // otherwise the running sum of the tracked allocations.
+    std::map<int64, int64> BytesInUse() const;
+    // The bytes allocated by each node that are live at time `ts`, keyed by
+    // bytes.
+    std::map<int64, std::vector<string>> LiveBytesByNode(int64 ts) const;
   };
 
   void TrackNode(int64 step, const GraphNode* node);
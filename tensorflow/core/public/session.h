@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_PUBLIC_SESSION_H_
 #define TENSORFLOW_PUBLIC_SESSION_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -230,6 +231,43 @@ class Session {
     return errors::Unimplemented(
         "ReleaseCallable is not supported for this session.");
   }
+
+  /// \brief A callable bound to caller-owned feed and fetch tensors, created
+  /// with `Session::BindCallable()`.
+  ///
+  /// Running a bound callable does not look up the callable's handle and
+  /// does not allocate the vector of fetched tensors, so a caller that runs
+  /// the same subgraph repeatedly only pays for the step itself.
+  /// NOTE: This API is still experimental and may change.
+  class BoundCallable {
+   public:
+    virtual ~BoundCallable() {}
+
+    /// \brief Runs the callable on the tensors currently in the bound feed
+    /// vector, and replaces the tensors in the bound fetch vector with its
+    /// outputs.
+    ///
+    /// `run_metadata` may be nullptr. Concurrent calls to `Run()` on the
+    /// same bound callable are not allowed, since they share the bound
+    /// vectors.
+    virtual Status Run(RunMetadata* run_metadata) = 0;
+  };
+
+  /// \brief Binds the callable named by `handle` to `feed_tensors` and
+  /// `fetch_tensors`, which must outlive `*out_bound`.
+  ///
+  /// `fetch_tensors` is resized once to the number of fetches; the bound
+  /// callable then only assigns its elements. The session, not the handle,
+  /// must outlive `*out_bound`: the bound callable stays valid after
+  /// `ReleaseCallable(handle)`.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status BindCallable(CallableHandle handle,
+                              const std::vector<Tensor>* feed_tensors,
+                              std::vector<Tensor>* fetch_tensors,
+                              std::unique_ptr<BoundCallable>* out_bound) {
+    return errors::Unimplemented(
+        "BindCallable is not supported for this session.");
+  }
 };
 
 /// \brief Create a new session with the given options.
@@ -118,6 +118,13 @@ void HandleSliceToElement<Variant>(Tensor* parent, Tensor* element, int64 index,
   }
 }
 
+template <typename T>
+void HandleSliceToSlice(const Tensor& src, int64 src_index, Tensor* dst,
+                        int64 dst_index) {
+  dst->flat_outer_dims<T>().chip(dst_index, 0) =
+      src.flat_outer_dims<T>().chip(src_index, 0);
+}
+
 }  // namespace
 
 // Copies element into the index^th slice of parent (in the 0th dimension).
@@ -187,6 +194,49 @@ Status MaybeMoveSliceToElement(Tensor* parent, Tensor* element, int64 index) {
   }
 }
 
+// Copies the src_index^th slice of src into the dst_index^th slice of dst (in
+// the 0th dimension).
+Status CopySliceToSlice(const Tensor& src, int64 src_index, Tensor* dst,
+                        int64 dst_index) {
+  DCHECK_NE(src.dim_size(0), 0);
+  DCHECK_NE(dst->dim_size(0), 0);
+  DCHECK_GE(src_index, 0);
+  DCHECK_GE(dst_index, 0);
+  if (src.dtype() != dst->dtype()) {
+    return errors::Internal("CopySliceToSlice Cannot perform copy: types do ",
+                            "not match. Types are: [src]: ",
+                            DataTypeString(src.dtype()),
+                            ", [dst]: ", DataTypeString(dst->dtype()));
+  }
+  if (src.NumElements() / src.dim_size(0) !=
+      dst->NumElements() / dst->dim_size(0)) {
+    TensorShape src_chip_shape = src.shape();
+    src_chip_shape.RemoveDim(0);
+    TensorShape dst_chip_shape = dst->shape();
+    dst_chip_shape.RemoveDim(0);
+    return errors::Internal(
+        "CopySliceToSlice Cannot perform copy: number of elements does not "
+        "match. Shapes are: [src slice]: ",
+        src_chip_shape.DebugString(),
+        ", [dst slice]: ", dst_chip_shape.DebugString());
+  }
+
+#define HANDLE_TYPE(T)                                     \
+  case DataTypeToEnum<T>::value: {                         \
+    HandleSliceToSlice<T>(src, src_index, dst, dst_index); \
+    return Status::OK();                                   \
+  }
+
+  switch (src.dtype()) {
+    TF_CALL_ALL_TYPES(HANDLE_TYPE);
+    TF_CALL_QUANTIZED_TYPES(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return errors::Unimplemented("CopySliceToSlice Unhandled data type: ",
+                                   src.dtype());
+  }
+}
+
 // The following five functions are copied from padding_fifo_queue.cc.
 // TODO(mrry): Reconcile these functions with the similar methods in the
 // queue implementation.
@@ -38,6 +38,11 @@ Status CopySliceToElement(const Tensor& parent, Tensor* element, int64 index);
 // This is particularly important for DT_STRING tensors.
 Status MaybeMoveSliceToElement(Tensor* parent, Tensor* element, int64 index);
 
+// Copies the src_index^th slice of src into the dst_index^th slice of dst (in
+// the 0th dimension), without materializing the slice as a separate tensor.
+Status CopySliceToSlice(const Tensor& src, int64 src_index, Tensor* dst,
+                        int64 dst_index);
+
 // Zero-initializes the tensor `element` using the scalar stored in `padding`.
 // Both `element` and `padding` must have matching `dtype`.
 Status SetElementZero(Tensor* element, const Tensor& padding);
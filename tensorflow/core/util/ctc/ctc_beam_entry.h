@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <new>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -109,23 +110,57 @@ struct BeamEntry {
 
 // This class owns all instances of BeamEntry.  This is used to avoid recursive
 // destructor call during destruction.
+//
+// The entries are constructed in blocks of memory that Reset() keeps, so that
+// a decoder that is reset between sequences stops allocating entries once
+// the blocks hold as many as its largest beam tree.
 template <class CTCBeamState = EmptyBeamState>
 class BeamRoot {
  public:
   BeamRoot(BeamEntry<CTCBeamState>* p, int l) { root_entry_ = AddEntry(p, l); }
   BeamRoot(const BeamRoot&) = delete;
   BeamRoot& operator=(const BeamRoot&) = delete;
+  ~BeamRoot() { DestroyEntries(); }
 
   BeamEntry<CTCBeamState>* AddEntry(BeamEntry<CTCBeamState>* p, int l) {
-    auto* new_entry = new BeamEntry<CTCBeamState>(p, l, this);
-    beam_entries_.emplace_back(new_entry);
+    const size_t block = num_entries_ / kBlockSize;
+    if (block == blocks_.size()) {
+      // operator new[] aligns the block for any fundamental type.
+      blocks_.emplace_back(
+          new char[kBlockSize * sizeof(BeamEntry<CTCBeamState>)]);
+    }
+    auto* new_entry = new (EntryAddress(num_entries_))
+        BeamEntry<CTCBeamState>(p, l, this);
+    ++num_entries_;
     return new_entry;
   }
   BeamEntry<CTCBeamState>* RootEntry() const { return root_entry_; }
 
+  // Destroys all the entries, and adds a new root entry in their memory.
+  void Reset(BeamEntry<CTCBeamState>* p, int l) {
+    DestroyEntries();
+    root_entry_ = AddEntry(p, l);
+  }
+
  private:
+  static const size_t kBlockSize = 256;
+
+  void* EntryAddress(size_t index) const {
+    return blocks_[index / kBlockSize].get() +
+           index % kBlockSize * sizeof(BeamEntry<CTCBeamState>);
+  }
+
+  void DestroyEntries() {
+    for (size_t i = 0; i < num_entries_; ++i) {
+      static_cast<BeamEntry<CTCBeamState>*>(EntryAddress(i))->~BeamEntry();
+    }
+    num_entries_ = 0;
+    root_entry_ = nullptr;
+  }
+
   BeamEntry<CTCBeamState>* root_entry_ = nullptr;
-  std::vector<std::unique_ptr<BeamEntry<CTCBeamState>>> beam_entries_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t num_entries_ = 0;
 };
 
 // BeamComparer is the default beam comparer provided in CTCBeamSearch.
@@ -150,6 +150,12 @@ class CTCBeamSearchDecoder : public CTCDecoder {
   std::unique_ptr<BeamRoot> beam_root_;
   BaseBeamScorer<CTCBeamState>* beam_scorer_;
 
+  // Scratch space of Step() and Decode(), kept so that they don't allocate
+  // once the decoder has warmed up.
+  std::vector<BeamEntry*> branches_;
+  std::vector<float> top_k_logits_;
+  std::vector<int> top_k_indices_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
 };
 
@@ -184,10 +190,9 @@ Status CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Decode(
     }  // for (int t...
 
     // O(n * log(n))
-    std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+    leaves_.ExtractNondestructive(&branches_);
     leaves_.Reset();
-    for (int i = 0; i < branches->size(); ++i) {
-      BeamEntry* entry = (*branches)[i];
+    for (BeamEntry* entry : branches_) {
       beam_scorer_->ExpandStateEnd(&entry->state);
       entry->newp.total +=
           beam_scorer_->GetStateEndExpansionScore(entry->state);
@@ -245,8 +250,6 @@ template <typename CTCBeamState, typename CTCBeamComparer>
 template <typename Vector>
 void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     const Vector& raw_input) {
-  std::vector<float> top_k_logits;
-  std::vector<int> top_k_indices;
   const bool top_k =
       (label_selection_size_ > 0 && label_selection_size_ < raw_input.size());
   // Number of character classes to consider in each step.
@@ -254,8 +257,8 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // Get max coefficient and remove it from raw_input later.
   float max_coeff;
   if (top_k) {
-    max_coeff = GetTopK(label_selection_size_, raw_input, &top_k_logits,
-                        &top_k_indices);
+    max_coeff = GetTopK(label_selection_size_, raw_input, &top_k_logits_,
+                        &top_k_indices_);
   } else {
     max_coeff = raw_input.maxCoeff();
   }
@@ -266,15 +269,15 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // Extract the beams sorted in decreasing new probability
   CHECK_EQ(num_classes_, raw_input.size());
 
-  std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+  leaves_.ExtractNondestructive(&branches_);
   leaves_.Reset();
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // P(.. @ t) becomes the new P(.. @ t-1)
     b->oldp = b->newp;
   }
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     if (b->parent != nullptr) {  // if not the root
       if (b->parent->Active()) {
         // If last two sequence characters are identical:
@@ -308,7 +311,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // originally in descending newp order and we copied newp to oldp.
 
   // Grow new leaves
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // A new leaf (represented by its BeamProbability) is a candidate
     // iff its total probability is nonzero and either the beam list
     // isn't full, or the lowest probability entry in the beam has a
@@ -324,8 +327,8 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     }
 
     for (int ind = 0; ind < max_classes; ind++) {
-      const int label = top_k ? top_k_indices[ind] : ind;
-      const float logit = top_k ? top_k_logits[ind] : raw_input(ind);
+      const int label = top_k ? top_k_indices_[ind] : ind;
+      const float logit = top_k ? top_k_logits_[ind] : raw_input(ind);
       // Perform label selection: if input for this label looks very
       // unpromising, never evaluate it with a scorer.
       if (logit < label_selection_input_min) {
@@ -371,8 +374,12 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   leaves_.Reset();
 
   // This beam root, and all of its children, will be in memory until
-  // the next reset.
-  beam_root_.reset(new BeamRoot(nullptr, -1));
+  // the next reset, which reuses their memory.
+  if (beam_root_ == nullptr) {
+    beam_root_.reset(new BeamRoot(nullptr, -1));
+  } else {
+    beam_root_->Reset(nullptr, -1);
+  }
   beam_root_->RootEntry()->newp.total = 0.0;  // ln(1)
   beam_root_->RootEntry()->newp.blank = 0.0;  // ln(1)
 
@@ -343,4 +343,51 @@ TEST(CtcBeamSearch, LabelSelection) {
   }
 }
 
+// The decoder reuses the memory of its beam entries after each batch entry,
+// which must not change the results of the next ones.
+TEST(CtcBeamSearch, ReusesBeamEntries) {
+  const int batch_size = 2;
+  const int timesteps = 20;
+  const int top_paths = 4;
+  const int num_classes = 30;
+  const int beam_width = 64;
+
+  CTCBeamSearchDecoder<>::DefaultBeamScorer default_scorer;
+  CTCBeamSearchDecoder<> decoder(num_classes, beam_width, &default_scorer,
+                                 batch_size);
+
+  // Both batch entries have the same input, which creates more beam entries
+  // than a block holds. The inputs are stored in the column-major order of
+  // Eigen::MatrixXf.
+  int sequence_lengths[batch_size] = {timesteps, timesteps};
+  float input_data_mat[timesteps][num_classes][batch_size];
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      const float logit = -0.1f * ((t * 7 + c * 13) % 17);
+      input_data_mat[t][c][0] = logit;
+      input_data_mat[t][c][1] = logit;
+    }
+  }
+
+  Eigen::Map<const Eigen::ArrayXi> seq_len(&sequence_lengths[0], batch_size);
+  std::vector<Eigen::Map<const Eigen::MatrixXf>> inputs;
+  inputs.reserve(timesteps);
+  for (int t = 0; t < timesteps; ++t) {
+    inputs.emplace_back(&input_data_mat[t][0][0], batch_size, num_classes);
+  }
+
+  std::vector<CTCDecoder::Output> outputs(top_paths);
+  for (CTCDecoder::Output& output : outputs) {
+    output.resize(batch_size);
+  }
+  float score[batch_size][top_paths] = {{0.0}};
+  Eigen::Map<Eigen::MatrixXf> scores(&score[0][0], batch_size, top_paths);
+
+  EXPECT_TRUE(decoder.Decode(seq_len, inputs, &outputs, &scores).ok());
+  for (int path = 0; path < top_paths; ++path) {
+    EXPECT_EQ(outputs[path][0], outputs[path][1]);
+    EXPECT_EQ(score[0][path], score[1][path]);
+  }
+}
+
 }  // namespace
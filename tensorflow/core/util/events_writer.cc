@@ -31,9 +31,14 @@ limitations under the License.
 namespace tensorflow {
 
 EventsWriter::EventsWriter(const string& file_prefix)
+    : EventsWriter(file_prefix, io::RecordWriterOptions()) {}
+
+EventsWriter::EventsWriter(const string& file_prefix,
+                           const io::RecordWriterOptions& options)
     // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
     : env_(Env::Default()),
       file_prefix_(file_prefix),
+      options_(options),
       num_outstanding_events_(0) {}
 
 EventsWriter::~EventsWriter() {
@@ -72,7 +77,7 @@ Status EventsWriter::InitIfNeeded() {
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
       env_->NewWritableFile(filename_, &recordio_file_),
       "Creating writable file ", filename_);
-  recordio_writer_.reset(new io::RecordWriter(recordio_file_.get()));
+  recordio_writer_.reset(new io::RecordWriter(recordio_file_.get(), options_));
   if (recordio_writer_ == nullptr) {
     return errors::Unknown("Could not create record writer");
   }
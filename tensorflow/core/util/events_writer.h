@@ -45,6 +45,10 @@ class EventsWriter {
   // Note that it is not recommended to simultaneously have two
   // EventWriters writing to the same file_prefix.
   explicit EventsWriter(const string& file_prefix);
+  // Like the above, but writes the records with the given options, e.g. to
+  // compress them. Readers of the file need the same compression type.
+  EventsWriter(const string& file_prefix,
+               const io::RecordWriterOptions& options);
   ~EventsWriter();
 
   // Sets the event file filename and opens file for writing.  If not called by
@@ -85,6 +89,7 @@ class EventsWriter {
 
   Env* env_;
   const string file_prefix_;
+  const io::RecordWriterOptions options_;
   string file_suffix_;
   string filename_;
   std::unique_ptr<WritableFile> recordio_file_;
@@ -61,11 +61,13 @@ static bool ReadEventProto(io::RecordReader* reader, uint64* offset,
   return ParseProtoUnlimited(proto, record);
 }
 
-void VerifyFile(const string& filename) {
+void VerifyFile(const string& filename,
+                const io::RecordReaderOptions& options =
+                    io::RecordReaderOptions()) {
   CHECK(env()->FileExists(filename).ok());
   std::unique_ptr<RandomAccessFile> event_file;
   TF_CHECK_OK(env()->NewRandomAccessFile(filename, &event_file));
-  io::RecordReader* reader = new io::RecordReader(event_file.get());
+  io::RecordReader* reader = new io::RecordReader(event_file.get(), options);
 
   uint64 offset = 0;
 
@@ -126,6 +128,17 @@ TEST(EventWriter, WriteClose) {
   VerifyFile(filename);
 }
 
+TEST(EventWriter, WriteCompressed) {
+  string file_prefix = GetDirName("/writecompressed_test");
+  EventsWriter writer(
+      file_prefix, io::RecordWriterOptions::CreateRecordWriterOptions("ZLIB"));
+  WriteFile(&writer);
+  TF_EXPECT_OK(writer.Close());
+  string filename = writer.FileName();
+  VerifyFile(filename,
+             io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB"));
+}
+
 TEST(EventWriter, WriteDelete) {
   string file_prefix = GetDirName("/writedelete_test");
   EventsWriter* writer = new EventsWriter(file_prefix);
@@ -23,10 +23,12 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/casts.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/presized_cuckoo_map.h"
@@ -56,6 +58,82 @@ uint8 PeekTag(protobuf::io::CodedInputStream* stream) {
   return *static_cast<const uint8*>(ptr);
 }
 
+template <typename T>
+class LimitedArraySlice {
+ public:
+  LimitedArraySlice(T* begin, size_t num_elements)
+      : current_(begin), end_(begin + num_elements) {}
+
+  // May return negative if there were push_back calls after slice was filled.
+  int64 EndDistance() const { return end_ - current_; }
+
+  // Attempts to push value to the back of this. If the slice has
+  // already been filled, this method has no effect on the underlying data, but
+  // it changes the number returned by EndDistance into negative values.
+  void push_back(T&& value) {
+    if (EndDistance() > 0) *current_ = std::move(value);
+    ++current_;
+  }
+
+  // Appends the `n` values at `values`, which need not be aligned, as `n`
+  // calls to push_back would.
+  void append_unaligned(const char* values, size_t n) {
+    const int64 num_copied =
+        std::min<int64>(n, std::max<int64>(0, EndDistance()));
+    memcpy(current_, values, num_copied * sizeof(T));
+    current_ += n;
+  }
+
+ private:
+  T* current_;
+  T* end_;
+};
+
+// Appends the `n` little-endian floats at `data` to `float_list`, with a
+// single copy where the layout of the list allows it.
+template <typename Result>
+void AppendFloats(const char* data, size_t n, Result* float_list) {
+  for (size_t i = 0; i < n; ++i) {
+    float_list->push_back(
+        bit_cast<float>(core::DecodeFixed32(data + i * sizeof(float))));
+  }
+}
+
+void AppendFloats(const char* data, size_t n,
+                  LimitedArraySlice<float>* float_list) {
+  if (!port::kLittleEndian) {
+    return AppendFloats<LimitedArraySlice<float>>(data, n, float_list);
+  }
+  float_list->append_unaligned(data, n);
+}
+
+void AppendFloats(const char* data, size_t n, SmallVector<float>* float_list) {
+  if (!port::kLittleEndian) {
+    return AppendFloats<SmallVector<float>>(data, n, float_list);
+  }
+  const size_t old_size = float_list->size();
+  float_list->resize(old_size + n);
+  memcpy(float_list->data() + old_size, data, n * sizeof(float));
+}
+
+// Decodes the varint at `*p`, which must end before `end`, and advances `*p`
+// past it. Unlike CodedInputStream, this keeps no per-value state, which
+// matters for long packed lists.
+inline bool DecodeVarint64(const uint8** p, const uint8* end, uint64* value) {
+  const uint8* ptr = *p;
+  uint64 result = 0;
+  for (int shift = 0; shift < 64 && ptr < end; shift += 7) {
+    const uint8 byte = *ptr++;
+    result |= static_cast<uint64>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      *p = ptr;
+      return true;
+    }
+  }
+  return false;
+}
+
 constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
@@ -161,6 +239,15 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
+        const void* data;
+        int size;
+        if (packed_length % sizeof(float) == 0 &&
+            stream.GetDirectBufferPointer(&data, &size) &&
+            static_cast<uint32>(size) == packed_length) {
+          AppendFloats(static_cast<const char*>(data),
+                       packed_length / sizeof(float), float_list);
+          if (!stream.Skip(packed_length)) return false;
+        }
         while (!stream.ExpectAtEnd()) {
           uint32 buffer32;
           if (!stream.ReadLittleEndian32(&buffer32)) return false;
@@ -203,6 +290,19 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
+        const void* data;
+        int size;
+        if (stream.GetDirectBufferPointer(&data, &size) &&
+            static_cast<uint32>(size) == packed_length) {
+          const uint8* p = static_cast<const uint8*>(data);
+          const uint8* end = p + size;
+          while (p < end) {
+            uint64 n;
+            if (!DecodeVarint64(&p, end, &n)) return false;
+            int64_list->push_back(static_cast<int64>(n));
+          }
+          if (!stream.Skip(packed_length)) return false;
+        }
         while (!stream.ExpectAtEnd()) {
           protobuf_uint64 n;  // There is no API for int64
           if (!stream.ReadVarint64(&n)) return false;
@@ -445,28 +545,6 @@ struct SeededHasher {
   uint64 seed{0xDECAFCAFFE};
 };
 
-template <typename T>
-class LimitedArraySlice {
- public:
-  LimitedArraySlice(T* begin, size_t num_elements)
-      : current_(begin), end_(begin + num_elements) {}
-
-  // May return negative if there were push_back calls after slice was filled.
-  int64 EndDistance() const { return end_ - current_; }
-
-  // Attempts to push value to the back of this. If the slice has
-  // already been filled, this method has no effect on the underlying data, but
-  // it changes the number returned by EndDistance into negative values.
-  void push_back(T&& value) {
-    if (EndDistance() > 0) *current_ = std::move(value);
-    ++current_;
-  }
-
- private:
-  T* current_;
-  T* end_;
-};
-
 void LogDenseFeatureDataLoss(StringPiece feature_name) {
   LOG(WARNING) << "Data loss! Feature '" << feature_name
                << "' is present in multiple concatenated "
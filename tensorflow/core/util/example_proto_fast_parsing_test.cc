@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -168,6 +169,19 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, LongPackedLists) {
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  auto* int64_list = features["ids"].mutable_int64_list();
+  auto* float_list = features["weights"].mutable_float_list();
+  for (int i = 0; i < 100; ++i) {
+    // Varints of every length from 1 to 10 bytes, including negative values.
+    int64_list->add_value((i % 2 ? -1 : 1) * (int64{1} << (i % 63)));
+    float_list->add_value(i / 3.0f);
+  }
+  TestCorrectness(Serialize(example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -346,6 +360,48 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, FixedLengthDensePackedLists) {
+  constexpr int kNumValues = 33;
+  std::vector<string> serialized;
+  for (int e = 0; e < 3; ++e) {
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    for (int i = 0; i < kNumValues; ++i) {
+      features[kDenseInt64Key].mutable_int64_list()->add_value(
+          (e - 1) * (int64{1} << (2 * i % 63)));
+      features[kDenseFloatKey].mutable_float_list()->add_value(e + i / 4.0f);
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  config.dense.push_back({kDenseInt64Key, DT_INT64,
+                          PartialTensorShape({kNumValues}),
+                          Tensor(DT_INT64, TensorShape({0})), false,
+                          kNumValues});
+  config.dense.push_back({kDenseFloatKey, DT_FLOAT,
+                          PartialTensorShape({kNumValues}),
+                          Tensor(DT_FLOAT, TensorShape({0})), false,
+                          kNumValues});
+  Result result;
+  TF_ASSERT_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(2, result.dense_values.size());
+  auto ids = result.dense_values[0].matrix<int64>();
+  auto weights = result.dense_values[1].matrix<float>();
+  for (int e = 0; e < 3; ++e) {
+    for (int i = 0; i < kNumValues; ++i) {
+      EXPECT_EQ((e - 1) * (int64{1} << (2 * i % 63)), ids(e, i));
+      EXPECT_EQ(e + i / 4.0f, weights(e, i));
+    }
+  }
+
+  // Lists of the wrong length are still rejected.
+  config.dense[1].shape = PartialTensorShape({kNumValues - 1});
+  config.dense[1].elements_per_stride = kNumValues - 1;
+  EXPECT_FALSE(
+      FastParseExample(config, serialized, {}, nullptr, &result).ok());
+}
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
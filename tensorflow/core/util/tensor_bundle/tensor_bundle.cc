@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -346,6 +347,10 @@ table::Options TableBuilderOptions() {
   // (version 1.2) with the intention that they will be enabled again at
   // some point (perhaps the 1.3 release?).
   o.compression = table::kNoCompression;
+  // Bloom filters let Contains() rule out most absent keys, e.g. before
+  // falling back to a base bundle, without reading a data block.  Readers
+  // that predate them ignore the filter block.
+  o.filter_bits_per_key = 10;
   return o;
 }
 
@@ -469,6 +474,79 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   return status_;
 }
 
+Status BundleWriter::AddRows(StringPiece key,
+                             const TensorShape& full_tensor_shape,
+                             const Tensor& row_indices, const Tensor& rows) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  const string key_string = std::string(key);
+  if (options_.base_prefix.empty()) {
+    status_ = errors::FailedPrecondition(
+        "Adding rows of ", key, " to a bundle without a base bundle");
+    return status_;
+  }
+  if (entries_.find(key_string) != entries_.end()) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+    return status_;
+  }
+  if (!DataTypeCanUseMemcpy(rows.dtype())) {
+    status_ = errors::InvalidArgument("Adding rows of ", key, " of type ",
+                                      DataTypeString(rows.dtype()));
+    return status_;
+  }
+  if (row_indices.dtype() != DT_INT64 || row_indices.dims() != 1 ||
+      full_tensor_shape.dims() < 1 || rows.dims() != full_tensor_shape.dims() ||
+      rows.dim_size(0) != row_indices.dim_size(0)) {
+    status_ = errors::InvalidArgument(
+        "Adding rows of ", key, " with mismatched shapes: full tensor ",
+        full_tensor_shape.DebugString(), ", row indices ",
+        row_indices.shape().DebugString(), ", rows ",
+        rows.shape().DebugString());
+    return status_;
+  }
+  for (int i = 1; i < full_tensor_shape.dims(); ++i) {
+    if (rows.dim_size(i) != full_tensor_shape.dim_size(i)) {
+      status_ = errors::InvalidArgument(
+          "Adding rows of ", key, " of shape ", rows.shape().DebugString(),
+          " to a tensor of shape ", full_tensor_shape.DebugString());
+      return status_;
+    }
+  }
+  const auto indices = row_indices.vec<int64>();
+  for (int64 i = 0; i < indices.size(); ++i) {
+    if (indices(i) < 0 || indices(i) >= full_tensor_shape.dim_size(0)) {
+      status_ = errors::InvalidArgument("Adding row ", indices(i), " of ", key,
+                                        " out of range");
+      return status_;
+    }
+  }
+
+  BundleEntryProto* entry = &entries_[key_string];
+  entry->set_dtype(rows.dtype());
+  full_tensor_shape.AsProto(entry->mutable_shape());
+  entry->set_shard_id(0);
+  entry->set_offset(size_);
+  entry->set_delta(true);
+  entry->set_num_delta_rows(indices.size());
+
+  // Updates the data file with the indices, then the rows.
+  size_t indices_bytes_written = 0;
+  size_t rows_bytes_written = 0;
+  out_->clear_crc32c();
+  status_ = WriteTensor(row_indices, out_.get(), &indices_bytes_written);
+  if (status_.ok()) {
+    status_ = WriteTensor(rows, out_.get(), &rows_bytes_written);
+  }
+
+  if (status_.ok()) {
+    entry->set_size(indices_bytes_written + rows_bytes_written);
+    entry->set_crc32c(crc32c::Mask(out_->crc32c()));
+    size_ += entry->size();
+    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
+  }
+  return status_;
+}
+
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
@@ -490,9 +568,7 @@ Status BundleWriter::Finish() {
   {
     // N.B.: the default use of Snappy compression may not be supported on all
     // platforms (e.g. Android).  The metadata file is small, so this is fine.
-    table::Options options;
-    options.compression = table::kNoCompression;
-    table::TableBuilder builder(options, file.get());
+    table::TableBuilder builder(TableBuilderOptions(), file.get());
     // Header entry.
     BundleHeaderProto header;
     header.set_num_shards(1);
@@ -501,6 +577,7 @@ Status BundleWriter::Finish() {
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
     version->set_min_consumer(kTensorBundleMinConsumer);
+    header.set_base_prefix(options_.base_prefix);
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -536,6 +613,7 @@ struct MergeState {
   bool seen_first_bundle = false;
   BundleHeaderProto_Endianness endianness;
   VersionDef version;
+  string base_prefix;
 
   // Tensor key -> BundleEntryProto.
   std::map<string, BundleEntryProto> entries;
@@ -577,6 +655,7 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
       merge_state->seen_first_bundle = true;
       merge_state->endianness = header.endianness();
       merge_state->version = header.version();
+      merge_state->base_prefix = header.base_prefix();
     } else {
       // Validates "endianness".
       if (merge_state->endianness != header.endianness()) {
@@ -592,6 +671,12 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
             "Merging bundles with different format versions: merged ",
             merge_version, " vs. curr ", curr_version);
       }
+      // Validates "base_prefix".
+      if (merge_state->base_prefix != header.base_prefix()) {
+        return errors::InvalidArgument(
+            "Merging bundles with different base bundles: ",
+            merge_state->base_prefix, " vs. ", header.base_prefix());
+      }
     }
     num_shards = header.num_shards();
     iter->Next();
@@ -675,6 +760,7 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
     header.set_num_shards(merge.num_shards);
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    header.set_base_prefix(merge.base_prefix);
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -729,6 +815,7 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
     return;
   }
   num_shards_ = header.num_shards();
+  base_prefix_ = header.base_prefix();
   if ((header.endianness() == BundleHeaderProto::BIG && port::kLittleEndian) ||
       (header.endianness() == BundleHeaderProto::LITTLE &&
        !port::kLittleEndian)) {
@@ -804,18 +891,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
-
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
 
@@ -823,12 +900,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
     size_t unused_bytes_read;
     if (entry.size() > kBufferSize) {
-      StringPiece sp;
-      TF_RETURN_IF_ERROR(buffered_file->file()->Read(
-          entry.offset(), entry.size(), &sp, backing_buffer));
-      if (sp.data() != backing_buffer) {
-        memmove(backing_buffer, sp.data(), entry.size());
-      }
+      TF_RETURN_IF_ERROR(ReadDirect(buffered_file->file(), entry.offset(),
+                                    entry.size(), backing_buffer));
     } else {
       TF_RETURN_IF_ERROR(buffered_file->ReadNBytes(entry.size(), backing_buffer,
                                                    &unused_bytes_read));
@@ -858,12 +931,137 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  *buffered_file = data_[shard_id];
+  if (*buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    *buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    data_[shard_id] = *buffered_file;
+  }
+  return Status::OK();
+}
+
+Status BundleReader::GetBaseReader(BundleReader** base) {
+  if (base_ == nullptr) {
+    base_.reset(new BundleReader(env_, base_prefix_));
+    base_->EnableParallelReads(read_pool_, read_block_bytes_);
+  }
+  if (!base_->status().ok()) {
+    return errors::DataLoss("Unable to read the base bundle ", base_prefix_,
+                            " of ", prefix_, ": ",
+                            base_->status().error_message());
+  }
+  *base = base_.get();
+  return Status::OK();
+}
+
+Status BundleReader::GetDeltaRows(const BundleEntryProto& entry, Tensor* val) {
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || val->dims() < 1 ||
+      val->dtype() != entry.dtype() ||
+      val->shape() != TensorShape(entry.shape())) {
+    return errors::DataLoss("Invalid delta entry: key ", key());
+  }
+  const int64 num_rows = entry.num_delta_rows();
+  const int64 num_all_rows = val->dim_size(0);
+  const size_t row_bytes =
+      num_all_rows > 0 ? val->TotalBytes() / num_all_rows : 0;
+  if (entry.size() != num_rows * (sizeof(int64) + row_bytes)) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(), "; expected size ",
+                            num_rows * (sizeof(int64) + row_bytes));
+  }
+
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+  std::unique_ptr<char[]> data(new char[entry.size()]);
+  TF_RETURN_IF_ERROR(ReadDirect(buffered_file->file(), entry.offset(),
+                                entry.size(), data.get()));
+  const uint32 actual_crc32c = crc32c::Value(data.get(), entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+
+  char* backing_buffer = const_cast<char*>(val->tensor_data().data());
+  const char* rows = data.get() + num_rows * sizeof(int64);
+  for (int64 i = 0; i < num_rows; ++i) {
+    int64 row;
+    memcpy(&row, data.get() + i * sizeof(int64), sizeof(int64));
+    if (row < 0 || row >= num_all_rows) {
+      return errors::DataLoss("Invalid row ", row, " in delta entry: key ",
+                              key());
+    }
+    memcpy(backing_buffer + row * row_bytes, rows + i * row_bytes, row_bytes);
+  }
+  return Status::OK();
+}
+
+Status BundleReader::ReadDirect(RandomAccessFile* file, uint64 offset,
+                                size_t size, char* buffer) {
+  auto read_block = [file, offset, buffer](size_t start, size_t block_size) {
+    StringPiece sp;
+    TF_RETURN_IF_ERROR(
+        file->Read(offset + start, block_size, &sp, buffer + start));
+    if (sp.data() != buffer + start) {
+      memmove(buffer + start, sp.data(), block_size);
+    }
+    return Status::OK();
+  };
+  if (read_pool_ == nullptr || read_block_bytes_ <= 0 ||
+      size <= read_block_bytes_) {
+    return read_block(0, size);
+  }
+
+  // RandomAccessFile::Read() is thread-safe, so the blocks are read
+  // concurrently.  The last one is read by this thread.
+  const size_t num_blocks = (size + read_block_bytes_ - 1) / read_block_bytes_;
+  std::vector<Status> statuses(num_blocks);
+  BlockingCounter counter(num_blocks - 1);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const size_t start = i * read_block_bytes_;
+    const size_t block_size =
+        std::min<size_t>(read_block_bytes_, size - start);
+    if (i == num_blocks - 1) {
+      statuses[i] = read_block(start, block_size);
+    } else {
+      read_pool_->Schedule([&read_block, &statuses, &counter, i, start,
+                            block_size]() {
+        statuses[i] = read_block(start, block_size);
+        counter.DecrementCount();
+      });
+    }
+  }
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
-
-  if (entry.slices().empty()) {
+  Status status = GetBundleEntryProto(key, &entry);
+  if (errors::IsNotFound(status) && !base_prefix_.empty()) {
+    // Unchanged since the base bundle.
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    return base->Lookup(key, val);
+  }
+  TF_RETURN_IF_ERROR(status);
+
+  if (entry.delta()) {
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    TF_RETURN_IF_ERROR(base->Lookup(key, val));
+    return GetDeltaRows(entry, val);
+  } else if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
     return GetSliceValue(
@@ -881,7 +1079,10 @@ Status BundleReader::ReadCurrent(Tensor* val) {
                             ProtoShortDebugString(entry.shape()));
   }
 
-  if (entry.slices().empty()) {
+  if (entry.delta()) {
+    // Merges the rows with those of the base bundle.
+    return Lookup(std::string(iter_->key()), val);
+  } else if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
     return GetSliceValue(
@@ -894,7 +1095,13 @@ Status BundleReader::LookupTensorSlices(StringPiece key,
                                         std::vector<TensorSlice>* slices) {
   slices->clear();
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  Status status = GetBundleEntryProto(key, &entry);
+  if (errors::IsNotFound(status) && !base_prefix_.empty()) {
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    return base->LookupTensorSlices(key, slices);
+  }
+  TF_RETURN_IF_ERROR(status);
   slices->reserve(entry.slices_size());
   for (const auto& slice : entry.slices()) {
     slices->emplace_back(slice);
@@ -906,7 +1113,17 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
                                  const TensorSlice& slice_spec, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(full_tensor_key, &entry));
+  Status status = GetBundleEntryProto(full_tensor_key, &entry);
+  if (errors::IsNotFound(status) && !base_prefix_.empty()) {
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    return base->LookupSlice(full_tensor_key, slice_spec, val);
+  }
+  TF_RETURN_IF_ERROR(status);
+  if (entry.delta()) {
+    return errors::Unimplemented("Looking up a slice of the delta tensor ",
+                                 full_tensor_key);
+  }
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
@@ -1025,14 +1242,25 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
 }
 
 bool BundleReader::Contains(StringPiece key) {
-  Seek(key);
-  return Valid() && (this->key() == key);
+  // Unlike Seek(), Table::Get() uses the bloom filter of the metadata table.
+  string value;
+  bool found = false;
+  if (table_->Get(key, &value, &found).ok() && found) return true;
+  BundleReader* base;
+  return !base_prefix_.empty() && GetBaseReader(&base).ok() &&
+         base->Contains(key);
 }
 
 Status BundleReader::LookupDtypeAndShape(StringPiece key, DataType* dtype,
                                          TensorShape* shape) {
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  Status status = GetBundleEntryProto(key, &entry);
+  if (errors::IsNotFound(status) && !base_prefix_.empty()) {
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    return base->LookupDtypeAndShape(key, dtype, shape);
+  }
+  TF_RETURN_IF_ERROR(status);
   *dtype = entry.dtype();
   *shape = TensorShape(entry.shape());
   return Status::OK();
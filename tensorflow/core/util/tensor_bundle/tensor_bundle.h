@@ -64,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -71,6 +72,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/table.h"
@@ -112,6 +114,10 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // If non-empty, the bundle is a delta of the bundle with this prefix:
+    // lookups of the tensors that it doesn't hold are served by the base
+    // bundle.  Chains of deltas are resolved by BundleReader.
+    string base_prefix;
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
@@ -140,6 +146,16 @@ class BundleWriter {
                   const TensorShape& full_tensor_shape,
                   const TensorSlice& slice_spec, const Tensor& slice_tensor);
 
+  // Delta support, for tensors such as embedding tables of which few rows
+  // change between checkpoints.  Adds the rows "row_indices" (an int64 vector)
+  // of the tensor of shape "full_tensor_shape" keyed by "key", with values
+  // "rows".  The other rows are read from the base bundle.
+  //
+  // Returns an error if Options::base_prefix isn't set, or if the dtype of
+  // "rows" can't be memcpy'ed.
+  Status AddRows(StringPiece key, const TensorShape& full_tensor_shape,
+                 const Tensor& row_indices, const Tensor& rows);
+
   // Finishes the writer and flushes.
   Status Finish() TF_MUST_USE_RESULT;
 
@@ -188,8 +204,18 @@ class BundleReader {
   // the metadata).
   Status status() const { return status_; }
 
-  // Queries whether the bundle contains an entry keyed by "key".  Calls Seek()
-  // internally, so this call invalidates the reader's current position.
+  // Makes the lookups of tensors larger than "block_bytes" read their contents
+  // in blocks of "block_bytes" issued concurrently on "pool", directly into
+  // the destination tensor.  This hides the latency of file systems such as
+  // GCS.  Only applies to tensors whose type can be memcpy'ed.  "pool" is not
+  // owned, and must outlive the reader.
+  void EnableParallelReads(thread::ThreadPool* pool, int64 block_bytes) {
+    read_pool_ = pool;
+    read_block_bytes_ = block_bytes;
+  }
+
+  // Queries whether the bundle contains an entry keyed by "key".  This call
+  // invalidates the reader's current position.
   // REQUIRES: status().ok()
   bool Contains(StringPiece key);
 
@@ -206,6 +232,8 @@ class BundleReader {
 
   // Looks up the tensor keyed by "key".  If "key" refers to a partitioned
   // tensor, attempts to look up the full contents using all stored slices.
+  // If the bundle is a delta, the tensors that it doesn't hold and the rows
+  // that it doesn't update are read from the chain of base bundles.
   //
   // Caller must make sure "val" has the same shape and dtype as the
   // corresponding contents, so that its buffer can be filled without needing
@@ -239,6 +267,8 @@ class BundleReader {
   // Looks up a specific slice of a partitioned tensor.
   // It is only required that the stored slices cover the requested slice,
   // namely "slice_spec" is a subset of the union of the stored slices.
+  // Returns an Unimplemented error for the tensors of a delta bundle that were
+  // added with BundleWriter::AddRows().
   // REQUIRES: status().ok()
   Status LookupSlice(StringPiece full_tensor_key, const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
@@ -282,6 +312,24 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Overwrites the rows of "val" stored in the delta entry "entry".
+  // REQUIRES: entry.delta()
+  Status GetDeltaRows(const BundleEntryProto& entry,
+                      Tensor* val) TF_MUST_USE_RESULT;
+
+  // Sets "*base" to the reader of the base bundle, opened on first use.
+  // REQUIRES: !base_prefix_.empty()
+  Status GetBaseReader(BundleReader** base) TF_MUST_USE_RESULT;
+
+  // Opens the data file "shard_id" if it has not been opened.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
+  // Reads "size" bytes at "offset" of "file" into "buffer", in parallel blocks
+  // if EnableParallelReads() was called.
+  Status ReadDirect(RandomAccessFile* file, uint64 offset, size_t size,
+                    char* buffer) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const string prefix_;
 
@@ -300,6 +348,14 @@ class BundleReader {
   // the header entry in the metadata table.
   int num_shards_;
 
+  // The prefix of the base bundle if this bundle is a delta, and its reader.
+  string base_prefix_;
+  std::unique_ptr<BundleReader> base_;
+
+  // See EnableParallelReads().  Not owned.
+  thread::ThreadPool* read_pool_ = nullptr;
+  int64 read_block_bytes_ = 0;
+
   friend class TensorBundleAlignmentTest;  // For testing data alignment.
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
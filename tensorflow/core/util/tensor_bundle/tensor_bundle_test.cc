@@ -458,6 +458,113 @@ TEST(TensorBundleTest, NonStandardShapes) {
   TestNonStandardShapes<qint8>();
 }
 
+TEST(TensorBundleTest, ParallelReads) {
+  // Larger than the read buffer of the reader, so that the contents are read
+  // directly into the tensor.
+  Tensor large(DT_FLOAT, TensorShape({1000, 1001}));
+  auto flat = large.flat<float>();
+  for (int i = 0; i < flat.size(); ++i) {
+    flat(i) = i;
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("parallel"));
+    TF_EXPECT_OK(writer.Add("small", Constant_2x3<float>(1.f)));
+    TF_EXPECT_OK(writer.Add("large", large));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  BundleReader reader(Env::Default(), Prefix("parallel"));
+  TF_ASSERT_OK(reader.status());
+  // Blocks that don't divide the size of the tensor.
+  reader.EnableParallelReads(&pool, 300 << 10);
+  Expect<float>(&reader, "large", large);
+  Expect<float>(&reader, "small", Constant_2x3<float>(1.f));
+}
+
+TEST(TensorBundleTest, DeltaBundles) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("base"));
+    TF_EXPECT_OK(writer.Add("embedding", Constant<float>(0.f, {4, 2})));
+    TF_EXPECT_OK(writer.Add("bias", Constant_2x3<float>(1.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Updates rows 1 and 3, then row 3 again.
+  {
+    BundleWriter::Options options;
+    options.base_prefix = Prefix("base");
+    BundleWriter writer(Env::Default(), Prefix("delta1"), options);
+    TF_EXPECT_OK(writer.AddRows("embedding", TensorShape({4, 2}),
+                                test::AsTensor<int64>({1, 3}),
+                                Constant<float>(1.f, {2, 2})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options options;
+    options.base_prefix = Prefix("delta1");
+    BundleWriter writer(Env::Default(), Prefix("delta2"), options);
+    TF_EXPECT_OK(writer.AddRows("embedding", TensorShape({4, 2}),
+                                test::AsTensor<int64>({3}),
+                                Constant<float>(2.f, {1, 2})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  {
+    BundleReader reader(Env::Default(), Prefix("delta1"));
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "embedding",
+                  test::AsTensor<float>({0, 0, 1, 1, 0, 0, 1, 1}, {4, 2}));
+  }
+  {
+    BundleReader reader(Env::Default(), Prefix("delta2"));
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "embedding",
+                  test::AsTensor<float>({0, 0, 1, 1, 0, 0, 2, 2}, {4, 2}));
+    // Read from the base bundle.
+    Expect<float>(&reader, "bias", Constant_2x3<float>(1.f));
+    EXPECT_FALSE(reader.Contains("missing"));
+  }
+}
+
+TEST(TensorBundleTest, DeltaBundlesErrors) {
+  {
+    // No base bundle.
+    BundleWriter writer(Env::Default(), Prefix("no_base"));
+    EXPECT_TRUE(errors::IsFailedPrecondition(
+        writer.AddRows("embedding", TensorShape({4, 2}),
+                       test::AsTensor<int64>({1}),
+                       Constant<float>(1.f, {1, 2}))));
+  }
+  BundleWriter::Options options;
+  options.base_prefix = Prefix("base");
+  {
+    BundleWriter writer(Env::Default(), Prefix("bad_rows"), options);
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        writer.AddRows("embedding", TensorShape({4, 2}),
+                       test::AsTensor<int64>({4}),
+                       Constant<float>(1.f, {1, 2}))));
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("bad_shape"), options);
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        writer.AddRows("embedding", TensorShape({4, 2}),
+                       test::AsTensor<int64>({1}),
+                       Constant<float>(1.f, {1, 3}))));
+  }
+  {
+    // The base bundle doesn't exist.
+    options.base_prefix = Prefix("missing_base");
+    BundleWriter writer(Env::Default(), Prefix("missing_base_delta"), options);
+    TF_EXPECT_OK(writer.AddRows("embedding", TensorShape({4, 2}),
+                                test::AsTensor<int64>({1}),
+                                Constant<float>(1.f, {1, 2})));
+    TF_ASSERT_OK(writer.Finish());
+    BundleReader reader(Env::Default(), Prefix("missing_base_delta"));
+    TF_ASSERT_OK(reader.status());
+    Tensor val(DT_FLOAT, TensorShape({4, 2}));
+    EXPECT_TRUE(errors::IsDataLoss(reader.Lookup("embedding", &val)));
+  }
+}
+
 TEST(TensorBundleTest, StringTensors) {
   {
     BundleWriter writer(Env::Default(), Prefix("foo"));
@@ -38,6 +38,7 @@ class TableBuilder : public TensorSliceWriter::Builder {
   TableBuilder(const string& name, WritableFile* f) : name_(name), file_(f) {
     table::Options option;
     option.compression = table::kNoCompression;
+    option.filter_bits_per_key = 10;
     builder_.reset(new table::TableBuilder(option, f));
   }
   void Add(StringPiece key, StringPiece val) override {
@@ -16,6 +16,7 @@ limitations under the License.
 package org.tensorflow;
 
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.List;
 
 /**
@@ -260,6 +261,60 @@ public final class Session implements AutoCloseable {
       return runHelper(true);
     }
 
+    /**
+     * Prepares the feeds, fetches and targets of this runner to be run repeatedly.
+     *
+     * <p>The returned {@link Callable} runs the same graph fragments as {@link #run()}, without
+     * the cost of pruning the graph and setting up the execution on every call. The Tensors fed to
+     * this runner are ignored, and may be {@code null}: the values of the feeds are passed to
+     * {@link Callable#call(List, List)} instead. The options set by {@link #setOptions(byte[])}
+     * apply to every call.
+     *
+     * <p>The Callable must be closed before the Session.
+     */
+    public Callable prepare() {
+      long[] feedOpHandles = new long[inputs.size()];
+      int[] feedOpIndices = new int[inputs.size()];
+      long[] fetchOpHandles = new long[outputs.size()];
+      int[] fetchOpIndices = new int[outputs.size()];
+      long[] targetOpHandles = new long[targets.size()];
+
+      // It's okay to use Operation.getUnsafeNativeHandle() here since the safety depends on the
+      // validity of the Graph and graphRef ensures that.
+      int idx = 0;
+      for (Output<?> o : inputs) {
+        feedOpHandles[idx] = o.op().getUnsafeNativeHandle();
+        feedOpIndices[idx] = o.index();
+        idx++;
+      }
+      idx = 0;
+      for (Output<?> o : outputs) {
+        fetchOpHandles[idx] = o.op().getUnsafeNativeHandle();
+        fetchOpIndices[idx] = o.index();
+        idx++;
+      }
+      idx = 0;
+      for (Operation op : targets) {
+        targetOpHandles[idx++] = op.getUnsafeNativeHandle();
+      }
+      Reference runRef = new Reference();
+      long callableHandle = 0;
+      try {
+        callableHandle =
+            Session.makeCallable(
+                nativeHandle,
+                runOptions,
+                feedOpHandles,
+                feedOpIndices,
+                fetchOpHandles,
+                fetchOpIndices,
+                targetOpHandles);
+      } finally {
+        runRef.close();
+      }
+      return new Callable(callableHandle, inputs.size(), outputs.size());
+    }
+
     private Run runHelper(boolean wantMetadata) {
       long[] inputTensorHandles = new long[inputTensors.size()];
       long[] inputOpHandles = new long[inputs.size()];
@@ -327,29 +382,6 @@ public final class Session implements AutoCloseable {
       return ret;
     }
 
-    private class Reference implements AutoCloseable {
-      public Reference() {
-        synchronized (nativeHandleLock) {
-          if (nativeHandle == 0) {
-            throw new IllegalStateException("run() cannot be called on the Session after close()");
-          }
-          ++numActiveRuns;
-        }
-      }
-
-      @Override
-      public void close() {
-        synchronized (nativeHandleLock) {
-          if (nativeHandle == 0) {
-            return;
-          }
-          if (--numActiveRuns == 0) {
-            nativeHandleLock.notifyAll();
-          }
-        }
-      }
-    }
-
     private Operation operationByName(String opName) {
       Operation op = graph.operation(opName);
       if (op == null) {
@@ -385,6 +417,140 @@ public final class Session implements AutoCloseable {
     return new Runner();
   }
 
+  /**
+   * Graph fragments prepared by {@link Runner#prepare()} to be run repeatedly.
+   *
+   * <p>A Callable may be called concurrently from multiple threads.
+   *
+   * <p><b>WARNING:</b>Resources consumed by the Callable object must be explicitly freed by
+   * invoking the {@link #close()} method before the Session is closed.
+   */
+  public final class Callable implements AutoCloseable {
+    private Callable(long handle, int numFeeds, int numFetches) {
+      this.handle = handle;
+      this.numFeeds = numFeeds;
+      this.numFetches = numFetches;
+    }
+
+    /**
+     * Runs the graph fragments with the given values of the feeds.
+     *
+     * @param inputs the values of the feeds, in the order they were fed to the {@link Runner}.
+     * @return new Tensors holding the values of the fetches, in the order they were fetched by the
+     *     {@link Runner}. The caller is responsible for closing them.
+     */
+    public List<Tensor<?>> call(Tensor<?>... inputs) {
+      List<Tensor<?>> outputs = new ArrayList<Tensor<?>>();
+      for (int i = 0; i < numFetches; ++i) {
+        outputs.add(null);
+      }
+      call(Arrays.asList(inputs), outputs);
+      return outputs;
+    }
+
+    /**
+     * Runs the graph fragments with the given values of the feeds, writing the values of the
+     * fetches to Tensors of the caller.
+     *
+     * <p>Each element of {@code outputs} is either {@code null}, which is replaced by a new Tensor
+     * that the caller is responsible for closing, or a Tensor of the type and shape of the fetched
+     * value that receives the value, such as a Tensor from {@link Tensor#createDirect(Class,
+     * long[], java.nio.ByteBuffer)} over a buffer of the caller. Fetches of {@code String} values
+     * require {@code null} elements.
+     *
+     * @param inputs the values of the feeds, in the order they were fed to the {@link Runner}.
+     * @param outputs the values of the fetches, in the order they were fetched by the {@link
+     *     Runner}.
+     * @throws IllegalArgumentException if the number of inputs or outputs does not match the
+     *     feeds and fetches of the Runner
+     */
+    public void call(List<Tensor<?>> inputs, List<Tensor<?>> outputs) {
+      if (inputs.size() != numFeeds || outputs.size() != numFetches) {
+        throw new IllegalArgumentException(
+            String.format(
+                "expected %d inputs and %d outputs, got %d and %d",
+                numFeeds, numFetches, inputs.size(), outputs.size()));
+      }
+      long[] inputTensorHandles = new long[numFeeds];
+      long[] outputTensorHandles = new long[numFetches];
+      for (int i = 0; i < numFeeds; ++i) {
+        inputTensorHandles[i] = inputs.get(i).getNativeHandle();
+      }
+      for (int i = 0; i < numFetches; ++i) {
+        Tensor<?> t = outputs.get(i);
+        outputTensorHandles[i] = t == null ? 0 : t.getNativeHandle();
+      }
+      Reference runRef = new Reference();
+      try {
+        runCallable(nativeHandle, handle, inputTensorHandles, outputTensorHandles);
+      } finally {
+        runRef.close();
+      }
+      for (int i = 0; i < numFetches; ++i) {
+        Tensor<?> t = outputs.get(i);
+        if (t == null) {
+          outputs.set(i, Tensor.fromHandle(outputTensorHandles[i]));
+        } else {
+          t.syncDirectBuffer();
+        }
+      }
+    }
+
+    /**
+     * Release resources associated with the Callable.
+     *
+     * <p>Blocks until there are no active calls to the Callable. The Callable is no longer usable
+     * after {@code close} returns.
+     */
+    @Override
+    public void close() {
+      synchronized (nativeHandleLock) {
+        if (handle == 0 || nativeHandle == 0) {
+          handle = 0;
+          return;
+        }
+        while (numActiveRuns > 0) {
+          try {
+            nativeHandleLock.wait();
+          } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            // Possible leak of the callable.
+            return;
+          }
+        }
+        releaseCallable(nativeHandle, handle);
+        handle = 0;
+      }
+    }
+
+    private long handle;
+    private final int numFeeds;
+    private final int numFetches;
+  }
+
+  private class Reference implements AutoCloseable {
+    public Reference() {
+      synchronized (nativeHandleLock) {
+        if (nativeHandle == 0) {
+          throw new IllegalStateException("run() cannot be called on the Session after close()");
+        }
+        ++numActiveRuns;
+      }
+    }
+
+    @Override
+    public void close() {
+      synchronized (nativeHandleLock) {
+        if (nativeHandle == 0) {
+          return;
+        }
+        if (--numActiveRuns == 0) {
+          nativeHandleLock.notifyAll();
+        }
+      }
+    }
+  }
+
   /**
    * Output tensors and metadata obtained when executing a session.
    *
@@ -460,4 +626,42 @@ public final class Session implements AutoCloseable {
       long[] targetOpHandles,
       boolean wantRunMetadata,
       long[] outputTensorHandles);
+
+  /**
+   * Prepare graph fragments of a session to be run repeatedly.
+   *
+   * @param handle to the C API TF_Session object (Session.nativeHandle)
+   * @param runOptions serialized representation of a RunOptions protocol buffer, or null
+   * @param feedOpHandles together with feedOpIndices identifies the values that are fed to every
+   *     run, as in {@link #run}.
+   * @param feedOpIndices (see feedOpHandles)
+   * @param fetchOpHandles together with fetchOpIndices identifies the values that are computed by
+   *     every run, as in {@link #run}.
+   * @param fetchOpIndices (see fetchOpHandles)
+   * @param targetOpHandles is the set of Operations in the graph that are to be executed but whose
+   *     output will not be returned
+   * @return handle to the C API TF_Callable object
+   */
+  private static native long makeCallable(
+      long handle,
+      byte[] runOptions,
+      long[] feedOpHandles,
+      int[] feedOpIndices,
+      long[] fetchOpHandles,
+      int[] fetchOpIndices,
+      long[] targetOpHandles);
+
+  /**
+   * Run graph fragments prepared by {@link #makeCallable}.
+   *
+   * @param handle to the C API TF_Session object (Session.nativeHandle)
+   * @param callableHandle to the C API TF_Callable object
+   * @param inputTensorHandles the values of the feeds of the callable.
+   * @param outputTensorHandles the Tensors to write the values of the fetches of the callable to.
+   *     Zero elements are replaced by handles to new Tensors.
+   */
+  private static native void runCallable(
+      long handle, long callableHandle, long[] inputTensorHandles, long[] outputTensorHandles);
+
+  private static native void releaseCallable(long handle, long callableHandle);
 }
@@ -245,6 +245,56 @@ public final class Tensor<T> implements AutoCloseable {
     return ret;
   }
 
+  /**
+   * Creates a Tensor that shares the memory of a direct buffer instead of copying its contents.
+   *
+   * <p>The remaining bytes of {@code data} must hold the tensor data in native byte order, as per
+   * the specification of the TensorFlow <a
+   * href="https://www.tensorflow.org/code/tensorflow/c/c_api.h">C API</a>. Feeding the Tensor to a
+   * {@link Session} then reads {@code data} in place, and a {@link Session.Callable} that fetches
+   * values into the Tensor writes them to {@code data}. The buffer must not be used for anything
+   * else until the Tensor is closed.
+   *
+   * <p>TensorFlow requires tensor data aligned to 64 bytes on some platforms. When {@code data} is
+   * not aligned enough, its contents are copied once here, and the values fetched into the Tensor
+   * are copied back to {@code data}.
+   *
+   * @param <T> the tensor element type
+   * @param type the tensor element type, represented as a class object.
+   * @param shape the tensor shape.
+   * @param data a direct buffer holding exactly the tensor data.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, if the tensor type is
+   *     {@code String}, or if the shape is not compatible with the buffer
+   */
+  public static <T> Tensor<T> createDirect(Class<T> type, long[] shape, ByteBuffer data) {
+    DataType dtype = DataType.fromClass(type);
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("createDirect() requires a direct ByteBuffer");
+    }
+    if (dtype == DataType.STRING) {
+      throw new IllegalArgumentException("createDirect() does not support String tensors");
+    }
+    int elemBytes = elemByteSize(dtype);
+    if (data.remaining() % elemBytes != 0) {
+      throw new IllegalArgumentException(
+          String.format(
+              "ByteBuffer with %d bytes is not compatible with a %s Tensor (%d bytes/element)",
+              data.remaining(), dtype.toString(), elemBytes));
+    }
+    int nremaining = data.remaining() / elemBytes;
+    if (nremaining != numElements(shape)) {
+      throw incompatibleBuffer(nremaining, shape);
+    }
+    Tensor<T> t = new Tensor<T>(dtype);
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    t.directBuffer = data.slice();
+    t.nativeHandle = allocateDirect(dtype.c(), t.shapeCopy, t.directBuffer);
+    if (isBackedBy(t.nativeHandle, t.directBuffer)) {
+      t.directBuffer = null;
+    }
+    return t;
+  }
+
   /**
    * Creates a Tensor of any type with data from the given buffer.
    *
@@ -561,7 +611,21 @@ public final class Tensor<T> implements AutoCloseable {
     return nativeHandle;
   }
 
+  /**
+   * Copies the values written to this Tensor to the buffer it was created from by {@link
+   * #createDirect(Class, long[], ByteBuffer)}, if the Tensor could not share its memory.
+   */
+  void syncDirectBuffer() {
+    if (directBuffer != null) {
+      ByteBuffer dst = directBuffer.duplicate();
+      dst.clear();
+      dst.put(buffer());
+    }
+  }
+
   private long nativeHandle;
+  // The buffer of createDirect(), only when the tensor holds a copy of its contents.
+  private ByteBuffer directBuffer = null;
   private DataType dtype;
   private long[] shapeCopy = null;
 
@@ -763,6 +827,10 @@ public final class Tensor<T> implements AutoCloseable {
 
   private static native long allocateNonScalarBytes(long[] shape, Object[] value);
 
+  private static native long allocateDirect(int dtype, long[] shape, ByteBuffer buffer);
+
+  private static native boolean isBackedBy(long handle, ByteBuffer buffer);
+
   private static native void delete(long handle);
 
   private static native ByteBuffer buffer(long handle);
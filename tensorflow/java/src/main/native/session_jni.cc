@@ -15,8 +15,11 @@ limitations under the License.
 
 #include <string.h>
 #include <memory>
+#include <string>
 
 #include "tensorflow/c/c_api.h"
+#include "tensorflow/c/c_api_experimental.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/java/src/main/native/utils_jni.h"
 #include "tensorflow/java/src/main/native/exception_jni.h"
 #include "tensorflow/java/src/main/native/session_jni.h"
@@ -68,6 +71,25 @@ unique_tf_buffer MakeUniqueBuffer(TF_Buffer* buf) {
   return unique_tf_buffer(buf, TF_MaybeDeleteBuffer);
 }
 
+TF_Callable* requireCallableHandle(JNIEnv* env, jlong handle) {
+  if (handle == 0) {
+    throwException(env, kNullPointerException,
+                   "close() has been called on the Callable");
+    return nullptr;
+  }
+  return reinterpret_cast<TF_Callable*>(handle);
+}
+
+// Appends the names of `outputs` to `names`, in the "op_name:index" form of
+// CallableOptions.
+void outputNames(const TF_Output* outputs, int n,
+                 google::protobuf::RepeatedPtrField<std::string>* names) {
+  for (int i = 0; i < n; ++i) {
+    names->Add()->assign(std::string(TF_OperationName(outputs[i].oper)) + ":" +
+                         std::to_string(outputs[i].index));
+  }
+}
+
 }  // namespace
 
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Session_allocate(
@@ -201,3 +223,109 @@ JNIEXPORT jbyteArray JNICALL Java_org_tensorflow_Session_run(
   TF_DeleteStatus(status);
   return ret;
 }
+
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Session_makeCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jbyteArray jrun_options,
+    jlongArray feed_op_handles, jintArray feed_op_indices,
+    jlongArray fetch_op_handles, jintArray fetch_op_indices,
+    jlongArray target_op_handles) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return 0;
+
+  const jint nfeeds = env->GetArrayLength(feed_op_handles);
+  const jint nfetches = env->GetArrayLength(fetch_op_handles);
+  const jint ntargets = env->GetArrayLength(target_op_handles);
+
+  std::unique_ptr<TF_Output[]> feeds(new TF_Output[nfeeds]);
+  std::unique_ptr<TF_Output[]> fetches(new TF_Output[nfetches]);
+  std::unique_ptr<TF_Operation* []> targets(new TF_Operation*[ntargets]);
+  resolveOutputs(env, "feed", feed_op_handles, feed_op_indices, feeds.get(),
+                 nfeeds);
+  resolveOutputs(env, "fetch", fetch_op_handles, fetch_op_indices,
+                 fetches.get(), nfetches);
+  resolveHandles(env, "target Operations", target_op_handles, targets.get(),
+                 ntargets);
+  if (env->ExceptionCheck()) return 0;
+
+  tensorflow::CallableOptions options;
+  outputNames(feeds.get(), nfeeds, options.mutable_feed());
+  outputNames(fetches.get(), nfetches, options.mutable_fetch());
+  for (int i = 0; i < ntargets; ++i) {
+    options.add_target(TF_OperationName(targets[i]));
+  }
+  if (jrun_options != nullptr) {
+    jbyte* data = env->GetByteArrayElements(jrun_options, nullptr);
+    bool parsed = options.mutable_run_options()->ParseFromArray(
+        data, env->GetArrayLength(jrun_options));
+    env->ReleaseByteArrayElements(jrun_options, data, JNI_ABORT);
+    if (!parsed) {
+      throwException(env, kIllegalArgumentException,
+                     "Unparseable RunOptions proto");
+      return 0;
+    }
+  }
+  const std::string proto = options.SerializeAsString();
+
+  TF_Status* status = TF_NewStatus();
+  TF_Callable* callable =
+      TF_SessionMakeCallable(session, proto.data(), proto.size(), status);
+  bool ok = throwExceptionIfNotOK(env, status);
+  TF_DeleteStatus(status);
+  return ok ? reinterpret_cast<jlong>(callable) : 0;
+}
+
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_runCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jlong callable_handle,
+    jlongArray input_tensor_handles, jlongArray output_tensor_handles) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return;
+  TF_Callable* callable = requireCallableHandle(env, callable_handle);
+  if (callable == nullptr) return;
+
+  const jint ninputs = env->GetArrayLength(input_tensor_handles);
+  const jint noutputs = env->GetArrayLength(output_tensor_handles);
+  std::unique_ptr<TF_Tensor* []> input_values(new TF_Tensor*[ninputs]);
+  std::unique_ptr<TF_Tensor* []> output_values(new TF_Tensor*[noutputs]);
+  resolveHandles(env, "input Tensors", input_tensor_handles, input_values.get(),
+                 ninputs);
+  if (env->ExceptionCheck()) return;
+  // Outputs may be null, for TF_SessionRunCallable to allocate, or tensors of
+  // the caller to write the fetched values into.
+  jlong* t = env->GetLongArrayElements(output_tensor_handles, nullptr);
+  for (int i = 0; i < noutputs; ++i) {
+    output_values[i] = reinterpret_cast<TF_Tensor*>(t[i]);
+  }
+
+  TF_Status* status = TF_NewStatus();
+  TF_SessionRunCallable(session, callable, input_values.get(),
+                        static_cast<int>(ninputs), output_values.get(),
+                        static_cast<int>(noutputs), nullptr, status);
+  if (!throwExceptionIfNotOK(env, status)) {
+    // Delete the outputs allocated before the failure.
+    for (int i = 0; i < noutputs; ++i) {
+      if (t[i] == 0 && output_values[i] != nullptr) {
+        TF_DeleteTensor(output_values[i]);
+      }
+    }
+    env->ReleaseLongArrayElements(output_tensor_handles, t, JNI_ABORT);
+    TF_DeleteStatus(status);
+    return;
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    t[i] = reinterpret_cast<jlong>(output_values[i]);
+  }
+  env->ReleaseLongArrayElements(output_tensor_handles, t, 0);
+  TF_DeleteStatus(status);
+}
+
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_releaseCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jlong callable_handle) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return;
+  TF_Callable* callable = requireCallableHandle(env, callable_handle);
+  if (callable == nullptr) return;
+  TF_Status* status = TF_NewStatus();
+  TF_SessionReleaseCallable(session, callable, status);
+  throwExceptionIfNotOK(env, status);
+  TF_DeleteStatus(status);
+}
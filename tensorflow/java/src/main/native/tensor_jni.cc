@@ -321,6 +321,31 @@ void readNDStringArray(JNIEnv* env, StringTensorReader* reader, int dims_left,
     if (TF_GetCode(status) != TF_OK) return;
   }
 }
+
+// A global reference that keeps the direct ByteBuffer of a Tensor, and thus
+// its memory, alive for as long as TensorFlow uses the memory.
+struct DirectBufferRef {
+  JavaVM* vm;
+  jobject buffer;
+};
+
+void releaseDirectBuffer(void* data, size_t len, void* arg) {
+  DirectBufferRef* ref = static_cast<DirectBufferRef*>(arg);
+  // The last reference to the memory may be dropped by a thread of
+  // TensorFlow that the JVM does not know about.
+  JNIEnv* env = nullptr;
+  if (ref->vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) !=
+      JNI_OK) {
+#ifdef __ANDROID__
+    ref->vm->AttachCurrentThreadAsDaemon(&env, nullptr);
+#else
+    ref->vm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env),
+                                         nullptr);
+#endif
+  }
+  env->DeleteGlobalRef(ref->buffer);
+  delete ref;
+}
 }  // namespace
 
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
@@ -473,6 +498,46 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateNonScalarBytes(
   return ret;
 }
 
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject buffer) {
+  void* data = env->GetDirectBufferAddress(buffer);
+  if (data == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "the ByteBuffer is not a direct buffer");
+    return 0;
+  }
+  const size_t len = static_cast<size_t>(env->GetDirectBufferCapacity(buffer));
+  const int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  std::unique_ptr<int64_t[]> dims(new int64_t[num_dims]);
+  {
+    jlong* jdims = env->GetLongArrayElements(shape, nullptr);
+    for (int i = 0; i < num_dims; ++i) {
+      dims[i] = static_cast<int64_t>(jdims[i]);
+    }
+    env->ReleaseLongArrayElements(shape, jdims, JNI_ABORT);
+  }
+  DirectBufferRef* ref = new DirectBufferRef;
+  env->GetJavaVM(&ref->vm);
+  ref->buffer = env->NewGlobalRef(buffer);
+  // TF_NewTensor copies the data, and releases the buffer right away, when
+  // the buffer is not aligned enough for TensorFlow.
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.get(),
+                              num_dims, data, len, releaseDirectBuffer, ref);
+  if (t == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "the ByteBuffer is too small for the Tensor");
+    return 0;
+  }
+  return reinterpret_cast<jlong>(t);
+}
+
+JNIEXPORT jboolean JNICALL Java_org_tensorflow_Tensor_isBackedBy(
+    JNIEnv* env, jclass clazz, jlong handle, jobject buffer) {
+  TF_Tensor* t = requireHandle(env, handle);
+  if (t == nullptr) return JNI_FALSE;
+  return TF_TensorData(t) == env->GetDirectBufferAddress(buffer);
+}
+
 JNIEXPORT void JNICALL Java_org_tensorflow_Tensor_delete(JNIEnv* env,
                                                          jclass clazz,
                                                          jlong handle) {
@@ -47,6 +47,25 @@ Java_org_tensorflow_Tensor_allocateScalarBytes(JNIEnv *, jclass, jbyteArray);
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateNonScalarBytes(
     JNIEnv *, jclass, jlongArray, jobjectArray);
 
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    allocateDirect
+ * Signature: (I[JLjava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(JNIEnv *,
+                                                                  jclass, jint,
+                                                                  jlongArray,
+                                                                  jobject);
+
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    isBackedBy
+ * Signature: (JLjava/nio/ByteBuffer;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_tensorflow_Tensor_isBackedBy(JNIEnv *,
+                                                                 jclass, jlong,
+                                                                 jobject);
+
 /*
  * Class:     org_tensorflow_Tensor
  * Method:    delete
@@ -20,6 +20,10 @@ import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertTrue;
 import static org.junit.Assert.fail;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Arrays;
+import java.util.List;
 import org.junit.Test;
 import org.junit.runner.RunWith;
 import org.junit.runners.JUnit4;
@@ -97,6 +101,36 @@ public class SessionTest {
     }
   }
 
+  @Test
+  public void prepareAndCall() {
+    try (Graph g = new Graph();
+        Session s = new Session(g)) {
+      TestUtil.transpose_A_times_X(g, new int[][] {{2}, {3}});
+      try (Session.Callable callable = s.runner().feed("X", null).fetch("Y").prepare()) {
+        for (int i = 0; i < 3; ++i) {
+          try (Tensor<Integer> x = Tensors.create(new int[][] {{5 + i}, {7}});
+              TestUtil.AutoCloseableList<Tensor<?>> outputs =
+                  new TestUtil.AutoCloseableList<Tensor<?>>(callable.call(x))) {
+            assertEquals(1, outputs.size());
+            final int[][] expected = {{31 + 2 * i}};
+            assertArrayEquals(expected, outputs.get(0).copyTo(new int[1][1]));
+          }
+        }
+
+        // Fetch into a buffer of the caller.
+        ByteBuffer buf = ByteBuffer.allocateDirect(4).order(ByteOrder.nativeOrder());
+        try (Tensor<Integer> x = Tensors.create(new int[][] {{5}, {7}});
+            Tensor<Integer> y = Tensor.createDirect(Integer.class, new long[] {1, 1}, buf)) {
+          List<Tensor<?>> inputs = Arrays.<Tensor<?>>asList(x);
+          List<Tensor<?>> outputs = Arrays.<Tensor<?>>asList(y);
+          callable.call(inputs, outputs);
+          assertEquals(31, buf.getInt(0));
+          assertEquals(y, outputs.get(0));
+        }
+      }
+    }
+  }
+
   @Test
   public void runWithMetadata() {
     try (Graph g = new Graph();
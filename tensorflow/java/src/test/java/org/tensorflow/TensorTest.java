@@ -89,6 +89,31 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void createDirect() {
+    int[] ints = {1, 2, 3, 4};
+    long[] shape = {2, 2};
+    ByteBuffer buf = ByteBuffer.allocateDirect(4 * ints.length).order(ByteOrder.nativeOrder());
+    buf.asIntBuffer().put(ints);
+    try (Tensor<Integer> t = Tensor.createDirect(Integer.class, shape, buf)) {
+      assertArrayEquals(shape, t.shape());
+      assertArrayEquals(new int[][] {{1, 2}, {3, 4}}, t.copyTo(new int[2][2]));
+    }
+
+    // validate that only direct buffers of the tensor size are accepted
+    try (Tensor<Integer> t =
+        Tensor.createDirect(Integer.class, shape, ByteBuffer.allocate(4 * ints.length))) {
+      fail("should have failed on a non-direct buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+    try (Tensor<Integer> t = Tensor.createDirect(Integer.class, new long[] {3}, buf)) {
+      fail("should have failed on incompatible buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+  }
+
   @Test
   public void createFromBufferWithNonNativeByteOrder() {
     double[] doubles = {1d, 2d, 3d, 4d};
@@ -201,6 +201,34 @@ class BatchDatasetTest(test.TestCase, parameterized.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  def testBatchTensorSlices(self):
+    components = (np.arange(7), np.array([str(i) for i in range(7)]),
+                  np.reshape(np.arange(21.0), (7, 3)))
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components).batch(3)
+                .make_one_shot_iterator())
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for start in [0, 3, 6]:
+        result = sess.run(get_next)
+        for component, result_component in zip(components, result):
+          self.assertAllEqual(
+              [compat.as_bytes(x) for x in component[start:start + 3]]
+              if component.dtype.kind == 'U' else component[start:start + 3],
+              result_component)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testBatchLargerThanInput(self):
+    iterator = (dataset_ops.Dataset.range(10).map(lambda x: [x, x])
+                .batch(2**31 - 1).make_one_shot_iterator())
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      self.assertAllEqual([[i, i] for i in range(10)], sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   def testBatchShapeError(self):
 
     def generator():
@@ -139,10 +139,24 @@ class FilesystemCacheDatasetTest(test.TestCase):
 
       sess.run(
           init_cache_op2, feed_dict={filename_placeholder: self.cache_prefix})
-      with self.assertRaises(errors.AlreadyExistsError):
+      # Both iterators write to their own shard of the cache.
+      elements2 = [sess.run(get_next2) for _ in range(3)]
+      elements1 = [sess.run(get_next1) for _ in range(3)]
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next1)
+      elements2.append(sess.run(get_next2))
+      with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next2)
+      self.assertAllEqual(elements1, elements2[1:])
 
-      sess.run(get_next1)  # this should continue to succeed
+      # The cache is complete and produces all elements.
+      sess.run(
+          init_cache_op1, feed_dict={filename_placeholder: self.cache_prefix})
+      for i in range(4):
+        self.assertAllEqual(
+            tuple(c[i] for c in components), sess.run(get_next1))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next1)
 
   def testConcurrentReaders(self):
     components = (np.array([1, 2, 3, 4]), np.array([5, 6, 7, 8]),
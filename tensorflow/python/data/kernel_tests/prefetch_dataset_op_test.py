@@ -22,7 +22,10 @@ from absl.testing import parameterized
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
 
@@ -54,6 +57,23 @@ class PrefetchDatasetTest(test.TestCase, parameterized.TestCase):
       with self.test_session() as sess:
         sess.run(init_op, feed_dict={buffer_size_t: buffer_size})
 
+  def testPrefetchToGpu(self):
+    if not test_util.is_gpu_available():
+      self.skipTest("No GPU available")
+
+    with ops.device("/gpu:0"):
+      iterator = dataset_ops.Dataset.range(10).map(
+          lambda x: math_ops.cast(x, dtypes.float32)).prefetch(
+              2).make_initializable_iterator()
+      squared = math_ops.square(iterator.get_next())
+
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for m in range(10):
+        self.assertEqual(m * m, sess.run(squared))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(squared)
+
 
 if __name__ == "__main__":
   test.main()
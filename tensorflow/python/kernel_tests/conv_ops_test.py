@@ -1796,6 +1796,61 @@ class DeepConv2DTest(test.TestCase):
     self._RunTestCases([1, 1], "SAME")
 
 
+class Conv2DAutotuneTest(test.TestCase):
+
+  def _CompareFwdConv2D(self, tensor_in_sizes, filter_in_sizes, conv_strides,
+                        padding):
+    """Verifies that autotuned and default CPU Conv2D produce the same values.
+
+    Args:
+      tensor_in_sizes: Input tensor dimensions in
+        [batch, input_rows, input_cols, input_depth].
+      filter_in_sizes: Filter tensor dimensions in
+        [kernel_rows, kernel_cols, input_depth, output_depth].
+      conv_strides: [row_stride, col_stride] for the convolution;
+      padding: Padding type.
+    """
+    x1 = np.random.rand(*tensor_in_sizes).astype(np.float32)
+    x2 = np.random.rand(*filter_in_sizes).astype(np.float32)
+    strides = [1] + conv_strides + [1]
+
+    def _Run(use_autotune):
+      # The kernel reads TF_CPU_CONV_USE_AUTOTUNE when it is created.
+      os.environ["TF_CPU_CONV_USE_AUTOTUNE"] = use_autotune
+      with ops.Graph().as_default() as g, self.test_session(
+          graph=g, use_gpu=False) as sess:
+        t1 = constant_op.constant(x1, shape=tensor_in_sizes)
+        t2 = constant_op.constant(x2, shape=filter_in_sizes)
+        conv = nn_ops.conv2d(t1, t2, strides=strides, padding=padding)
+        # The first run times every algorithm, the second the chosen one.
+        return [sess.run(conv), sess.run(conv)]
+
+    try:
+      values_expect = _Run("0")
+      values_test = _Run("1")
+    finally:
+      del os.environ["TF_CPU_CONV_USE_AUTOTUNE"]
+    for value_test in values_test:
+      self.assertAllClose(values_expect[0], value_test, rtol=1e-4, atol=1e-4)
+
+  def _RunTestCases(self, conv_strides, padding):
+    input_sizes = [[2, 17, 17, 3], [3, 11, 13, 16], [2, 35, 35, 32],
+                   [2, 7, 4, 81]]
+    filter_sizes = [[3, 3, 3, 32], [5, 5, 16, 24], [3, 3, 32, 48],
+                    [3, 3, 81, 77]]
+    for input_shape, filter_shape in zip(input_sizes, filter_sizes):
+      self._CompareFwdConv2D(input_shape, filter_shape, conv_strides, padding)
+
+  def testConv2DStride1x1Valid(self):
+    self._RunTestCases([1, 1], "VALID")
+
+  def testConv2DStride1x1Same(self):
+    self._RunTestCases([1, 1], "SAME")
+
+  def testConv2DStride2x2Same(self):
+    self._RunTestCases([2, 2], "SAME")
+
+
 class Conv2DBenchmark(test.Benchmark):
 
   def benchmarkGPUConvStackFirst(self):
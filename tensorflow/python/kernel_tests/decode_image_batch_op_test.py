@@ -0,0 +1,137 @@
+# Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for DecodeImageBatchOp."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os.path
+
+import numpy as np
+
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors_impl
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_image_ops
+from tensorflow.python.ops import image_ops
+from tensorflow.python.ops import io_ops
+from tensorflow.python.platform import test
+
+prefix_path = "tensorflow/core/lib"
+
+
+class DecodeImageBatchOpTest(test.TestCase):
+
+  def _jpeg(self):
+    # 256 high, 128 wide.
+    return io_ops.read_file(
+        os.path.join(prefix_path, "jpeg", "testdata", "jpeg_merge_test1.jpg"))
+
+  def _png(self):
+    # 26 high, 51 wide.
+    return io_ops.read_file(
+        os.path.join(prefix_path, "png", "testdata", "lena_rgba.png"))
+
+  def testUnscaled(self):
+    with self.test_session() as sess:
+      jpeg = self._jpeg()
+      png = self._png()
+      contents = array_ops.stack([jpeg, jpeg])
+      crop_windows = [[0, 0, 0, 0], [10, 20, 26, 51]]
+      images, valid = gen_image_ops.decode_image_batch(
+          contents, crop_windows, height=26, width=51)
+      cropped_jpeg = image_ops.decode_and_crop_jpeg(
+          jpeg, [10, 20, 26, 51], channels=3)
+      png_images, png_valid = gen_image_ops.decode_image_batch(
+          array_ops.stack([png]), [[0, 0, 0, 0]], height=26, width=51)
+      decoded_png = image_ops.decode_png(png, channels=3)
+      (images, valid, cropped_jpeg, png_images, png_valid,
+       decoded_png) = sess.run([
+           images, valid, cropped_jpeg, png_images, png_valid, decoded_png
+       ])
+      self.assertEqual(images.shape, (2, 26, 51, 3))
+      self.assertAllEqual(valid, [True, True])
+      # A crop window of the size of the output is decoded as is.
+      self.assertAllEqual(images[1], cropped_jpeg)
+      self.assertAllEqual(png_valid, [True])
+      self.assertAllEqual(png_images[0], decoded_png)
+
+  def testScaled(self):
+    with self.test_session() as sess:
+      jpeg = self._jpeg()
+      # Decoded at 1/4 and 1/2 scale.
+      images, valid = gen_image_ops.decode_image_batch(
+          array_ops.stack([jpeg, jpeg]), [[0, 0, 0, 0], [64, 32, 128, 64]],
+          height=64,
+          width=32)
+      decoded = image_ops.decode_jpeg(jpeg, channels=3)
+      expected = image_ops.resize_area(
+          array_ops.stack([decoded, decoded[64:192, 32:96]]), [64, 32])
+      images, valid, expected = sess.run([images, valid, expected])
+      self.assertEqual(images.shape, (2, 64, 32, 3))
+      self.assertAllEqual(valid, [True, True])
+      self.assertLess(
+          np.mean(np.abs(images.astype(np.float32) - expected)), 8)
+
+  def testGrayscale(self):
+    with self.test_session() as sess:
+      images = gen_image_ops.decode_image_batch(
+          array_ops.stack([self._jpeg(), self._png()]),
+          [[0, 0, 0, 0]] * 2,
+          height=20,
+          width=10,
+          channels=1)[0]
+      self.assertEqual(sess.run(images).shape, (2, 20, 10, 1))
+
+  def testInvalidImages(self):
+    with self.test_session() as sess:
+      jpeg = self._jpeg()
+      contents = array_ops.stack([jpeg, "not an image", jpeg])
+      # The last crop window is out of the image.
+      crop_windows = [[0, 0, 0, 0], [0, 0, 0, 0], [200, 0, 100, 100]]
+      images, valid = gen_image_ops.decode_image_batch(
+          contents, crop_windows, height=8, width=8, ignore_errors=True)
+      images, valid = sess.run([images, valid])
+      self.assertAllEqual(valid, [True, False, False])
+      self.assertGreater(np.max(images[0]), 0)
+      self.assertAllEqual(images[1:], np.zeros((2, 8, 8, 3)))
+
+      images = gen_image_ops.decode_image_batch(
+          contents, crop_windows, height=8, width=8)[0]
+      with self.assertRaisesOpError("Image 1: Expected a JPEG or PNG image"):
+        sess.run(images)
+
+  def testEmptyBatch(self):
+    with self.test_session() as sess:
+      images, valid = gen_image_ops.decode_image_batch(
+          constant_op.constant([], dtype=dtypes.string),
+          np.zeros([0, 4], dtype=np.int32),
+          height=8,
+          width=8)
+      images, valid = sess.run([images, valid])
+      self.assertEqual(images.shape, (0, 8, 8, 3))
+      self.assertEqual(valid.shape, (0,))
+
+  def testBadCropWindows(self):
+    with self.test_session():
+      with self.assertRaises((ValueError, errors_impl.InvalidArgumentError)):
+        gen_image_ops.decode_image_batch(
+            array_ops.stack([self._jpeg()]), [[0, 0, 0]], height=8, width=8)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -31,6 +31,7 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
 from tensorflow.python.ops import embedding_ops
+from tensorflow.python.ops import gen_sparse_ops
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import init_ops
 from tensorflow.python.ops import linalg_ops
@@ -257,6 +258,30 @@ class EmbeddingLookupTest(test.TestCase):
     self.assertAllEqual(np_result, tf_result)
     self.assertShapeEqual(np_result, embedding)
 
+  def testShardedRepeatedIds(self):
+    with self.test_session() as sess:
+      num_shards = 2
+      vocab_size = 4
+      p, params, feed_dict = _EmbeddingParams(num_shards, vocab_size)
+
+      id_vals = np.array([3, 0, 3, 0, 1, 3])
+      ids = constant_op.constant(id_vals, dtype=dtypes.int32)
+      embedding = embedding_ops.embedding_lookup(p, ids)
+      # Every shard only gathers the distinct ids that it holds.
+      shard_ids = [
+          op.inputs[1] for op in sess.graph.get_operations()
+          if op.type == "GatherV2" and op.inputs[0] in p
+      ]
+      self.assertEqual(num_shards, len(shard_ids))
+
+      tf_result, tf_shard_ids = sess.run([embedding, shard_ids],
+                                         feed_dict=feed_dict)
+    np_result, _, _ = _EmbeddingResult(params, id_vals, num_shards, vocab_size)
+    self.assertAllEqual(np_result, tf_result)
+    self.assertShapeEqual(np_result, embedding)
+    self.assertItemsEqual([[0], [0, 1]],
+                          [sorted(ids.tolist()) for ids in tf_shard_ids])
+
   def testMaxNorm(self):
     with self.test_session():
       embeddings = constant_op.constant([[2.0]])
@@ -721,6 +746,80 @@ class EmbeddingLookupSparseTest(test.TestCase):
             x, x_shape, y, y_shape, x_init_value=x_init_value)
       self.assertLess(err, 1e-5 if dtype == dtypes.float64 else 2e-3)
 
+  def testFusedMatchesUnfused(self):
+    vocab_size = 13
+    batch_size = 10
+    param_shape = [2, 5]
+    sp_ids, sp_weights, _, _, _ = self._RandomIdsAndWeights(
+        batch_size, vocab_size)
+
+    for num_shards, combiner, partition_strategy, ignore_weights in (
+        itertools.product([1, 4], ["sum", "mean", "sqrtn"], ["mod", "div"],
+                          [True, False])):
+      with self.test_session() as sess:
+        p, _, feed_dict = _EmbeddingParams(
+            num_shards, vocab_size, shape=param_shape)
+        fused = gen_sparse_ops.fused_embedding_lookup_sparse(
+            p,
+            sp_ids.indices,
+            sp_ids.values,
+            constant_op.constant([], dtypes.float32)
+            if ignore_weights else sp_weights.values,
+            combiner=combiner,
+            partition_strategy=partition_strategy)
+        # A max_norm keeps the lookup unfused.
+        unfused = embedding_ops.embedding_lookup_sparse(
+            p,
+            sp_ids,
+            None if ignore_weights else sp_weights,
+            partition_strategy=partition_strategy,
+            combiner=combiner,
+            max_norm=1e9)
+        fused, unfused = sess.run([fused, unfused], feed_dict=feed_dict)
+        self.assertAllClose(unfused, fused)
+
+  def testFusedGradients(self):
+    vocab_size = 12
+    batch_size = 4
+    param_shape = [2, 3]
+    sp_ids, _, _, weights, _ = self._RandomIdsAndWeights(
+        batch_size, vocab_size)
+
+    for num_shards, combiner, partition_strategy in itertools.product(
+        [1, 3], ["sum", "mean", "sqrtn"], ["mod", "div"]):
+      with self.test_session():
+        x, params, _ = _EmbeddingParams(
+            num_shards, vocab_size, shape=param_shape, dtype=dtypes.float64)
+        w = constant_op.constant(weights, dtypes.float64)
+        y = gen_sparse_ops.fused_embedding_lookup_sparse(
+            x,
+            sp_ids.indices,
+            sp_ids.values,
+            w,
+            combiner=combiner,
+            partition_strategy=partition_strategy)
+        x_init_value = [params[_PName(i) + ":0"] for i in range(num_shards)]
+        x_init_value.append(weights)
+        x_shape = [i.shape for i in x_init_value]
+        y_shape = [batch_size] + param_shape
+        err = gradient_checker.compute_gradient_error(
+            x + [w], x_shape, y, y_shape, x_init_value=x_init_value)
+      self.assertLess(err, 1e-5)
+
+  def testFusedEmptyRowsAndInvalidIds(self):
+    with self.test_session():
+      params = constant_op.constant([[1.0, 2.0], [3.0, 4.0]])
+      indices = constant_op.constant([[0, 0], [0, 1], [2, 0]], dtypes.int64)
+      weights = constant_op.constant([1.0, 3.0, 2.0])
+      y = gen_sparse_ops.fused_embedding_lookup_sparse(
+          [params], indices, [0, 1, 1], weights, combiner="mean")
+      self.assertAllClose([[2.5, 3.5], [0.0, 0.0], [3.0, 4.0]], y.eval())
+
+      y = gen_sparse_ops.fused_embedding_lookup_sparse(
+          [params], indices, [0, 2, 1], weights, combiner="sum")
+      with self.assertRaisesOpError(r"ids\[1\] = 2 is not in the params"):
+        y.eval()
+
   def testIncompatibleShapes(self):
     with self.test_session():
       x, _, _ = _EmbeddingParams(1, 10, dtype=dtypes.float32)
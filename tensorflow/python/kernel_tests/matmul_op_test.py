@@ -156,6 +156,28 @@ class MatMulStatsTest(test_lib.TestCase):
           self.assertEqual(7200, flops)
 
 
+class MatMulSmallTest(test_lib.TestCase):
+
+  def testTileSizes(self):
+    # Small products are computed by tiles of rows and packets of columns,
+    # with the remaining rows and columns computed separately.
+    np.random.seed(42)
+    for dtype in (np.float32, np.float64):
+      for m, k, n in ((13, 29, 37), (4, 63, 24), (63, 7, 63), (2, 1, 17)):
+        a = np.random.normal(0, 1, m * k).astype(dtype).reshape([m, k])
+        b = np.random.normal(0, 1, k * n).astype(dtype).reshape([k, n])
+        for transpose_a in (False, True):
+          for transpose_b in (False, True):
+            with self.test_session(use_gpu=False):
+              c = math_ops.matmul(
+                  a.T if transpose_a else a,
+                  b.T if transpose_b else b,
+                  transpose_a=transpose_a,
+                  transpose_b=transpose_b)
+              self.assertAllClose(np.matmul(a, b), c.eval(), rtol=1e-4,
+                                  atol=1e-4)
+
+
 try:
   # @ operator supported since python 3.5.
   infix_matmul = operator.matmul
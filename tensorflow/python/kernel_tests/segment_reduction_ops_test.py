@@ -447,6 +447,26 @@ class UnsortedSegmentTest(SegmentReductionHelper):
         self.assertAllClose(np_ans, tf_ans)
         self.assertShapeEqual(np_ans, s)
 
+  def testSumOfLargeSegments(self):
+    # Large segments and wide rows sum the rows sorted by segment id on GPUs,
+    # rather than with atomic additions.
+    for num_segments, inner_dim_size in (3, 2), (50, 64):
+      indices = np.random.randint(-1, num_segments, 200).astype(np.int32)
+      for dtype in dtypes_lib.float32, dtypes_lib.float64:
+        with self.test_session(use_gpu=True):
+          tf_x, np_x = self._input([200, inner_dim_size], dtype=dtype)
+          # The rows of negative segment ids are dropped.
+          kept = indices >= 0
+          np_ans = self._segmentReduce(
+              indices[kept], np_x[kept], np.add, op2=None,
+              num_segments=num_segments)
+          s = math_ops.unsorted_segment_sum(
+              data=tf_x, segment_ids=indices, num_segments=num_segments)
+          tf_ans = s.eval()
+          self.assertAllClose(np_ans, tf_ans)
+          # The sum is deterministic.
+          self.assertAllEqual(tf_ans, s.eval())
+
 
 class SparseSegmentReductionHelper(SegmentReductionHelper):
 
@@ -507,6 +527,32 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           # and may therefore vary dynamically.
           self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
+  def testValuesGpu(self):
+    ops_list = [(np.add, None, math_ops.sparse_segment_sum),
+                (self._mean_cum_op, self._mean_reduce_op,
+                 math_ops.sparse_segment_mean),
+                (self._mean_cum_op, self._sqrt_n_reduce_op,
+                 math_ops.sparse_segment_sqrt_n)]
+    segment_indices = [0, 0, 2, 2, 2, 3, 5, 5]
+    for dtype in dtypes_lib.float32, dtypes_lib.float64:
+      with self.test_session(use_gpu=True):
+        tf_indices, np_indices, tf_x, np_x = self._sparse_input(
+            [20, 3], len(segment_indices), dtype=dtype)
+        for np_op1, np_op2, tf_op in ops_list:
+          np_ans = self._sparseSegmentReduce(np_x, np_indices, segment_indices,
+                                             np_op1, np_op2)
+          s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
+          self.assertAllClose(np_ans, s.eval())
+          np_ans = self._sparseSegmentReduce(
+              np_x, np_indices, segment_indices, np_op1, np_op2,
+              num_segments=8)
+          s = tf_op(
+              data=tf_x,
+              indices=tf_indices,
+              segment_ids=segment_indices,
+              num_segments=8)
+          self.assertAllClose(np_ans, s.eval())
+
   def testSegmentIdsHole(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
     ops_list = [(np.add, None, math_ops.sparse_segment_sum), (
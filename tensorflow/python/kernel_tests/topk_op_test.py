@@ -148,6 +148,34 @@ class TopKTest(test.TestCase):
     self._testMediumTopK(np.float32)
     self._testMediumTopK(np.float16)
 
+  def _testLargeRowsTopK(self, dtype, is_sorted):
+    # Rows that are large compared to k use the radix select on GPUs.
+    b = 4
+    n = 20000
+    k = 1000
+    inputs = np.random.permutation(
+        np.linspace(-100, 100, b * n).astype(dtype)).reshape(b, n)
+    # Use mergesort, a stable sort, to get the indices.
+    indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+    values = -np.sort(-inputs, axis=1)[:, :k]
+    self._validateTopK(inputs, k, values, indices, sorted=is_sorted)
+
+  def testLargeRowsTopK(self):
+    for dtype in np.float32, np.float16, np.int32:
+      self._testLargeRowsTopK(dtype, is_sorted=True)
+    self._testLargeRowsTopK(np.int32, is_sorted=False)
+
+  def testSingleLargeRowTopK(self):
+    # A single row that is large compared to k is split into chunks on CPUs.
+    n = 200000
+    for k in [10, 1000]:
+      # Lots of repeated integers, so that the chunks have ties.
+      inputs = np.random.randint(0, 1000, size=[1, n]).astype(np.int32)
+      # Use mergesort, a stable sort, to get the indices.
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+
   def testStableSort(self):
     b = 5
     n = 500
@@ -22,7 +22,7 @@ from tensorflow.python.ops import gen_collective_ops
 
 
 def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
-               subdiv_offsets=(0,)):
+               subdiv_offsets=(0,), hierarchical=False):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -38,6 +38,8 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
     subdiv_offsets: a list of integer offsets into the tensor at which each
       independent subdivision should begin.  Use [0] if no subdivision should
       be done.
+    hierarchical: if True, reduce within each task first, then across tasks
+      through one device per task, then broadcast back within each task.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -55,7 +57,8 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
                                               instance_key=instance_key,
                                               merge_op=merge_op,
                                               final_op=final_op,
-                                              subdiv_offsets=subdiv_offsets)
+                                              subdiv_offsets=subdiv_offsets,
+                                              hierarchical=hierarchical)
 
 
 def broadcast_send(t, shape, dtype, group_size, group_key, instance_key):
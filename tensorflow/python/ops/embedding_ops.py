@@ -29,6 +29,7 @@ from tensorflow.python.ops import clip_ops
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_sparse_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import sparse_ops
@@ -81,6 +82,64 @@ def _clip(params, ids, max_norm):
             else math_ops.range(ids_rank, params_rank)))
 
 
+def _partition_ids(params, flat_ids, partition_strategy):
+  """Assigns the ids to the partitions of `params`.
+
+  Args:
+    params: The list of partitions, see embedding_lookup.
+    flat_ids: A 1-D `Tensor` of ids.
+    partition_strategy: See embedding_lookup.
+
+  Returns:
+    The int32 partition of each id, and its row in the partition.
+
+  Raises:
+    ValueError: If `partition_strategy` is unknown.
+  """
+  np = len(params)  # Number of partitions
+  if partition_strategy == "mod":
+    p_assignments = flat_ids % np
+    new_ids = flat_ids // np
+  elif partition_strategy == "div":
+    # Compute num_total_ids as the sum of dim-0 of params, then assign to
+    # partitions based on a constant number of ids per partition. Optimize
+    # if we already know the full shape statically.
+    dim_0_size = params[0].get_shape()[0]
+    for p in xrange(1, np):
+      dim_0_size += params[p].get_shape()[0]
+    if dim_0_size.value:
+      num_total_ids = constant_op.constant(dim_0_size.value, flat_ids.dtype)
+    else:
+      dim_0_sizes = []
+      for p in xrange(np):
+        if params[p].get_shape()[0].value is not None:
+          dim_0_sizes.append(params[p].get_shape()[0].value)
+        else:
+          with ops.colocate_with(params[p]):
+            dim_0_sizes.append(array_ops.shape(params[p])[0])
+      num_total_ids = math_ops.reduce_sum(
+          math_ops.cast(array_ops.stack(dim_0_sizes), flat_ids.dtype))
+    ids_per_partition = num_total_ids // np
+    extras = num_total_ids % np
+
+    p_assignments = math_ops.maximum(
+        flat_ids // (ids_per_partition + 1),
+        (flat_ids - extras) // ids_per_partition)
+
+    # Emulate a conditional using a boolean indicator tensor
+    new_ids = array_ops.where(p_assignments < extras,
+                              flat_ids % (ids_per_partition + 1),
+                              (flat_ids - extras) % ids_per_partition)
+  else:
+    raise ValueError("Unrecognized partition strategy: " +
+                     partition_strategy)
+
+  # Cast partition assignments to int32 for use in dynamic_partition.
+  # There really should not be more than 2^32 partitions.
+  p_assignments = math_ops.cast(p_assignments, dtypes.int32)
+  return p_assignments, new_ids
+
+
 def _embedding_lookup_and_transform(params,
                                     ids,
                                     partition_strategy="mod",
@@ -142,49 +201,14 @@ def _embedding_lookup_and_transform(params,
       #   We must flatten in this case because transform_fn expects a flat
       #   tensor of embeddings.
       flat_ids = array_ops.reshape(ids, [-1])
+      # Look up every distinct id once, so that repeated ids cost neither
+      # extra gathers and transfers from the partitions nor extra gradient
+      # rows for them.
+      flat_ids, unique_idx = array_ops.unique(flat_ids)
       original_indices = math_ops.range(array_ops.size(flat_ids))
 
-      # Create p_assignments and set new_ids depending on the strategy.
-      if partition_strategy == "mod":
-        p_assignments = flat_ids % np
-        new_ids = flat_ids // np
-      elif partition_strategy == "div":
-        # Compute num_total_ids as the sum of dim-0 of params, then assign to
-        # partitions based on a constant number of ids per partition. Optimize
-        # if we already know the full shape statically.
-        dim_0_size = params[0].get_shape()[0]
-        for p in xrange(1, np):
-          dim_0_size += params[p].get_shape()[0]
-        if dim_0_size.value:
-          num_total_ids = constant_op.constant(dim_0_size.value, flat_ids.dtype)
-        else:
-          dim_0_sizes = []
-          for p in xrange(np):
-            if params[p].get_shape()[0].value is not None:
-              dim_0_sizes.append(params[p].get_shape()[0].value)
-            else:
-              with ops.colocate_with(params[p]):
-                dim_0_sizes.append(array_ops.shape(params[p])[0])
-          num_total_ids = math_ops.reduce_sum(
-              math_ops.cast(array_ops.stack(dim_0_sizes), flat_ids.dtype))
-        ids_per_partition = num_total_ids // np
-        extras = num_total_ids % np
-
-        p_assignments = math_ops.maximum(
-            flat_ids // (ids_per_partition + 1),
-            (flat_ids - extras) // ids_per_partition)
-
-        # Emulate a conditional using a boolean indicator tensor
-        new_ids = array_ops.where(p_assignments < extras,
-                                  flat_ids % (ids_per_partition + 1),
-                                  (flat_ids - extras) % ids_per_partition)
-      else:
-        raise ValueError("Unrecognized partition strategy: " +
-                         partition_strategy)
-
-      # Cast partition assignments to int32 for use in dynamic_partition.
-      # There really should not be more than 2^32 partitions.
-      p_assignments = math_ops.cast(p_assignments, dtypes.int32)
+      p_assignments, new_ids = _partition_ids(params, flat_ids,
+                                              partition_strategy)
       # Partition list of ids based on assignments into np separate lists
       gather_ids = data_flow_ops.dynamic_partition(new_ids, p_assignments, np)
       # Similarly, partition the original indices.
@@ -203,8 +227,9 @@ def _embedding_lookup_and_transform(params,
             result = transform_fn(_clip(result, pids, max_norm))
         partitioned_result.append(result)
       # Stitch these back together
-      ret = data_flow_ops.parallel_dynamic_stitch(
-          pindices, partitioned_result, name=name)
+      ret = data_flow_ops.parallel_dynamic_stitch(pindices, partitioned_result)
+      # Expand the embeddings of the distinct ids to all the ids.
+      ret = array_ops.gather(ret, unique_idx, name=name)
 
       # Determine the static element shape.
       if transform_fn is None:
@@ -310,6 +335,127 @@ def embedding_lookup(
       transform_fn=None)
 
 
+def _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+  """Whether embedding_lookup_sparse can run as a single fused op.
+
+  The fused op has a CPU kernel only, and reads the whole of every partition,
+  so it is only used when all the partitions are on the same device.
+  """
+  if max_norm is not None or pywrap_tensorflow.IsGoogleCudaEnabled():
+    return False
+  if len(set(getattr(p, "device", "") for p in params)) > 1:
+    return False
+  if sp_ids.values.dtype not in (dtypes.int32, dtypes.int64):
+    return False
+  try:
+    dtype = dtypes.as_dtype(params[0].dtype).base_dtype
+  except (AttributeError, TypeError):
+    return False
+  return dtype in (dtypes.float32, dtypes.float64)
+
+
+def _fused_embedding_lookup_sparse(params, sp_ids, sp_weights,
+                                   partition_strategy, combiner, name):
+  """Computes embedding_lookup_sparse with a FusedEmbeddingLookupSparse op.
+
+  Unlike the unfused computation, the rows of the output without ids are 0
+  for all the combiners.
+  """
+  params = ops.convert_n_to_tensor(params, name="params")
+  with ops.colocate_with(params[0]):
+    if sp_weights is None:
+      weights = constant_op.constant([], dtype=params[0].dtype)
+    else:
+      weights = sp_weights.values
+      if weights.dtype != params[0].dtype:
+        weights = math_ops.cast(weights, params[0].dtype)
+    return gen_sparse_ops.fused_embedding_lookup_sparse(
+        params,
+        sp_ids.indices,
+        sp_ids.values,
+        weights,
+        combiner=combiner,
+        partition_strategy=partition_strategy,
+        name=name)
+
+
+@ops.RegisterGradient("FusedEmbeddingLookupSparse")
+def _FusedEmbeddingLookupSparseGrad(op, grad):
+  """Gradients for FusedEmbeddingLookupSparse.
+
+  The gradient of each partition of the params is an `IndexedSlices` of the
+  rows of its ids.
+  """
+  num_partitions = op.get_attr("num_partitions")
+  combiner = op.get_attr("combiner")
+  partition_strategy = op.get_attr("partition_strategy")
+  params = op.inputs[:num_partitions]
+  indices, ids, weights = op.inputs[num_partitions:]
+  rows = indices[:, 0]
+  num_rows = array_ops.shape(grad, out_type=dtypes.int64)[0]
+  # The weights are empty when they are all 1.
+  weighted = weights.get_shape().num_elements() != 0
+  if not weighted:
+    weights = array_ops.ones_like(ids, dtype=grad.dtype)
+
+  # The output row of the i-th id is scales[i] * sum_j(weights[j] * e[j]) over
+  # the ids j of that row, where e[j] is the embedding of the id j.
+  if combiner == "sum":
+    scales = array_ops.ones_like(weights)
+  elif combiner == "mean":
+    scales = 1 / array_ops.gather(
+        math_ops.unsorted_segment_sum(weights, rows, num_rows), rows)
+  else:
+    scales = math_ops.rsqrt(
+        array_ops.gather(
+            math_ops.unsorted_segment_sum(
+                math_ops.square(weights), rows, num_rows), rows))
+  row_grads = array_ops.gather(grad, rows)
+  ones = array_ops.fill(array_ops.expand_dims(array_ops.rank(grad) - 1, 0), 1)
+
+  def _broadcastable(values):
+    return array_ops.reshape(
+        values, array_ops.concat([array_ops.shape(values), ones], 0))
+
+  values = row_grads * _broadcastable(weights * scales)
+  if num_partitions == 1:
+    params_grads = [
+        ops.IndexedSlices(values, ids, array_ops.shape(params[0]))
+    ]
+  else:
+    p_assignments, new_ids = _partition_ids(params, ids, partition_strategy)
+    partition_values = data_flow_ops.dynamic_partition(
+        values, p_assignments, num_partitions)
+    partition_ids = data_flow_ops.dynamic_partition(new_ids, p_assignments,
+                                                    num_partitions)
+    params_grads = [
+        ops.IndexedSlices(partition_values[p], partition_ids[p],
+                          array_ops.shape(params[p]))
+        for p in xrange(num_partitions)
+    ]
+  if not weighted:
+    return params_grads + [None, None, None]
+
+  def _row_dot(a, b):
+    return math_ops.reduce_sum(
+        array_ops.reshape(a * b, [array_ops.shape(a)[0], -1]), 1)
+
+  embeddings = embedding_lookup(
+      list(params), ids, partition_strategy=partition_strategy)
+  grads_dot_embeddings = _row_dot(row_grads, embeddings)
+  if combiner == "sum":
+    weights_grad = grads_dot_embeddings
+  else:
+    # The derivative of the scale of the row.
+    grads_dot_outputs = array_ops.gather(_row_dot(grad, op.outputs[0]), rows)
+    if combiner == "mean":
+      weights_grad = scales * (grads_dot_embeddings - grads_dot_outputs)
+    else:
+      weights_grad = scales * (
+          grads_dot_embeddings - weights * scales * grads_dot_outputs)
+  return params_grads + [None, None, weights_grad]
+
+
 @tf_export("nn.embedding_lookup_sparse")
 def embedding_lookup_sparse(params,
                             sp_ids,
@@ -418,6 +564,11 @@ def embedding_lookup_sparse(params,
 
   with ops.name_scope(name, "embedding_lookup_sparse",
                       params + [sp_ids]) as name:
+    if _can_fuse_embedding_lookup_sparse(params, sp_ids, max_norm):
+      return _fused_embedding_lookup_sparse(params, sp_ids, sp_weights,
+                                            partition_strategy, combiner,
+                                            name)
+
     segment_ids = sp_ids.indices[:, 0]
     if segment_ids.dtype != dtypes.int32:
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
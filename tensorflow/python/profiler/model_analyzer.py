@@ -204,6 +204,17 @@ class Profiler(object):
                                        run_meta.SerializeToString(),
                                        op_log.SerializeToString())
 
+  def _set_max_sampled_steps(self, max_steps):
+    """Keeps at most `max_steps` of the steps added afterwards.
+
+    The kept steps are sampled uniformly, so that the per-step averages of the
+    profiles estimate the costs over a long run with bounded memory.
+
+    Args:
+      max_steps: int, the number of steps to keep, or 0 to keep all of them.
+    """
+    print_mdl.SetMaxSampledSteps(max_steps)
+
   def profile_python(self, options):
     """Profile the statistics of the Python codes.
 
@@ -128,6 +128,13 @@ class ProfileContext(object):
       # dumped to train_dir. Use web UI or command line to do profiling.
       train_loop().
 
+    # Sample every 1000th step of a long job. The profiles estimate per-op
+    # costs from a uniform sample of the traced steps.
+    with tf.contrib.tfprof.ProfileContext('/tmp/train_dir',
+                                          sample_every_n_steps=1000,
+                                          dump_steps=[100000]) as pctx:
+      train_loop().
+
     # When session object is available, do explicit trace, profile and dump.
     with tf.contrib.tfprof.ProfileContext('/tmp/train_dir',
                                           trace_steps=[],
@@ -148,6 +155,10 @@ class ProfileContext(object):
         user to only enable profiling when needed.
     debug: If true, also dumps the raw trace RunMetadata text file to
         profile_dir. And print debugging message. Useful for bug report.
+    sample_every_n_steps: If set, traces every n-th step after the warm up
+        steps, for as long as the context is active. The profiler then keeps
+        the stats of up to 100 of the traced steps, sampled uniformly, so that
+        the profiles estimate the average per-op costs of the whole run.
   """
 
   def __init__(self,
@@ -155,7 +166,8 @@ class ProfileContext(object):
                trace_steps=None,
                dump_steps=None,
                enabled=True,
-               debug=False):
+               debug=False,
+               sample_every_n_steps=None):
     self._enabled = enabled
     if not self._enabled:
       return
@@ -174,6 +186,12 @@ class ProfileContext(object):
       self._trace_steps = set(trace_steps[:])
       self._auto_tracing = False
 
+    if sample_every_n_steps is not None:
+      if sample_every_n_steps <= 0:
+        raise ValueError('sample_every_n_steps must be positive.\n')
+      self._auto_tracing = False
+    self._sample_every_n_steps = sample_every_n_steps
+
     if dump_steps is None:
       self._dump_steps = set([MAX_TRACED_STEPS])
     else:
@@ -235,6 +253,8 @@ class ProfileContext(object):
       return None
     if not self._profiler:
       self._profiler = model_analyzer.Profiler(ops.get_default_graph())
+      if self._sample_every_n_steps is not None:
+        self._profiler._set_max_sampled_steps(MAX_TRACED_STEPS)  # pylint: disable=protected-access
     return self._profiler
 
   def trace_next_step(self):
@@ -251,8 +271,12 @@ class ProfileContext(object):
     self._dump_next_step = True
     self._slow_path_steps.add(self._step)
 
+  def _is_sampled_step(self, step):
+    return (self._sample_every_n_steps is not None and step > WARMUP_STEPS and
+            step % self._sample_every_n_steps == 0)
+
   def _is_fast_path(self, step):
-    if step in self._slow_path_steps:
+    if step in self._slow_path_steps or self._is_sampled_step(step):
       return False
     # When user doesn't set the tracing steps explicitly, auto decide it.
     if (self._auto_tracing and step > WARMUP_STEPS and
@@ -262,6 +286,10 @@ class ProfileContext(object):
 
   def _should_trace(self, step, graph, fetches):
     """Whether should do tracing at current step."""
+    # Sampled steps are not limited, the profiler bounds the steps it keeps.
+    if self._is_sampled_step(step):
+      self._traced_steps += 1
+      return True
     if self._traced_steps > MAX_TRACED_STEPS:
       return False
     # Check user-set tracing steps.
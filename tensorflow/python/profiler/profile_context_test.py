@@ -90,6 +90,25 @@ class ProfilerContextTest(test.TestCase):
         for f in gfile.ListDirectory(test.get_temp_dir()):
           self.assertFalse("run_meta" in f)
 
+  def testSampling(self):
+    ops.reset_default_graph()
+    x = lib.BuildFullModel()
+
+    with profile_context.ProfileContext(test.get_temp_dir(), debug=True,
+                                        sample_every_n_steps=5):
+      with session.Session() as sess:
+        sess.run(variables.global_variables_initializer())
+        for _ in range(30):
+          sess.run(x)
+        traced = [f for f in gfile.ListDirectory(test.get_temp_dir())
+                  if f.startswith("run_meta")]
+        # Only every 5th step after the warm up is traced.
+        self.assertEqual(
+            set(["run_meta_15", "run_meta_20", "run_meta_25", "run_meta_30"]),
+            set(traced))
+        for f in traced:
+          gfile.Remove(os.path.join(test.get_temp_dir(), f))
+
   def testDisabled(self):
     ops.reset_default_graph()
     x = lib.BuildFullModel()
@@ -775,6 +775,34 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   return true;
 }
 
+/* static */ bool CUDADriver::CreateStreamWithPriority(CudaContext *context,
+                                                       int priority,
+                                                       CUstream *out) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuStreamCreateWithPriority(out, 0, priority);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "could not allocate CUDA stream with priority " << priority
+               << " for context " << context << ": " << ToString(res);
+    return false;
+  }
+
+  VLOG(2) << "successfully created stream " << *out << " with priority "
+          << priority << " for context " << context << " on thread";
+  return true;
+}
+
+/* static */ port::Status CUDADriver::GetStreamPriorityRange(
+    CudaContext *context, int *least_priority, int *greatest_priority) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuCtxGetStreamPriorityRange(least_priority, greatest_priority);
+  if (res != CUDA_SUCCESS) {
+    return port::Status(
+        port::error::INTERNAL,
+        port::StrCat("failed to get stream priority range: ", ToString(res)));
+  }
+  return port::Status::OK();
+}
+
 /* static */ void CUDADriver::DestroyStream(CudaContext* context,
                                             CUstream *stream) {
   if (*stream == nullptr) {
@@ -854,6 +882,29 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   }
 }
 
+/* static */ bool CUDADriver::UnifiedMemoryPrefetch(CudaContext *context,
+                                                    const void *location,
+                                                    uint64 bytes,
+                                                    CUdevice device,
+                                                    CUstream stream) {
+#if CUDA_VERSION >= 8000
+  ScopedActivateContext activation(context);
+  CUdeviceptr pointer = port::bit_cast<CUdeviceptr>(location);
+  CUresult res = cuMemPrefetchAsync(pointer, bytes, device, stream);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to prefetch " << bytes
+               << " bytes of unified memory at " << location
+               << "; result: " << ToString(res);
+    return false;
+  }
+  VLOG(2) << "enqueued prefetch of " << bytes << " bytes of unified memory at "
+          << location << " to device " << device << " on stream " << stream;
+  return true;
+#else
+  return false;
+#endif  // CUDA_VERSION >= 8000
+}
+
 /* static */ void *CUDADriver::HostAllocate(CudaContext *context,
                                             uint64 bytes) {
   ScopedActivateContext activation(context);
@@ -1043,6 +1094,80 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   return false;
 }
 
+#if CUDA_VERSION >= 10000
+/* static */ port::Status CUDADriver::StreamBeginCapture(CudaContext *context,
+                                                         CUstream stream) {
+  ScopedActivateContext activated{context};
+#if CUDA_VERSION >= 10010
+  // Only the calling thread's unsafe API calls invalidate the capture.
+  CUresult res =
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL);
+#else
+  CUresult res = cuStreamBeginCapture(stream);
+#endif
+  if (res != CUDA_SUCCESS) {
+    return port::InternalError(port::StrCat(
+        "could not begin capturing CUDA stream: ", ToString(res)));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::StreamEndCapture(CudaContext *context,
+                                                       CUstream stream,
+                                                       CUgraph *graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuStreamEndCapture(stream, graph);
+  if (res != CUDA_SUCCESS) {
+    return port::InternalError(
+        port::StrCat("could not end capturing CUDA stream: ", ToString(res)));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::GraphInstantiate(CudaContext *context,
+                                                       CUgraphExec *graph_exec,
+                                                       CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphInstantiate(graph_exec, graph, /*phErrorNode=*/nullptr,
+                                    /*logBuffer=*/nullptr, /*bufferSize=*/0);
+  if (res != CUDA_SUCCESS) {
+    return port::InternalError(
+        port::StrCat("could not instantiate CUDA graph: ", ToString(res)));
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::Status CUDADriver::GraphLaunch(CudaContext *context,
+                                                  CUgraphExec graph_exec,
+                                                  CUstream stream) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphLaunch(graph_exec, stream);
+  if (res != CUDA_SUCCESS) {
+    return port::InternalError(
+        port::StrCat("could not launch CUDA graph: ", ToString(res)));
+  }
+  return port::Status::OK();
+}
+
+/* static */ void CUDADriver::DestroyGraph(CudaContext *context,
+                                           CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ void CUDADriver::DestroyGraphExec(CudaContext *context,
+                                               CUgraphExec graph_exec) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(graph_exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph executable: " << ToString(res);
+  }
+}
+#endif  // CUDA_VERSION >= 10000
+
 /* static */ port::Status CUDADriver::SynchronousMemcpyD2H(CudaContext *context,
                                                            void *host_dst,
                                                            CUdeviceptr gpu_src,
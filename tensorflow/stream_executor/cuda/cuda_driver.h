@@ -74,6 +74,22 @@ class CUDADriver {
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html#group__CUDA__STREAM_1ga581f0c5833e21ded8b5a56594e243f4
   static bool CreateStream(CudaContext* context, CUstream *stream);
 
+  // Creates a new CUDA stream with the given priority, associated with the
+  // given context via cuStreamCreateWithPriority. Lower numbers are higher
+  // priorities, see GetStreamPriorityRange.
+  // stream is an outparam owned by the caller, must not be null.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html#group__CUDA__STREAM_1g95c1a8c7c3dacb13091692dd9c7f7471
+  static bool CreateStreamWithPriority(CudaContext* context, int priority,
+                                       CUstream* stream);
+
+  // Returns the least and the greatest stream priorities of the device of the
+  // given context via cuCtxGetStreamPriorityRange. Both are 0 if the device
+  // does not support stream priorities.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__CTX.html#group__CUDA__CTX_1g137920ab61a71be6ce67605b9f294091
+  static port::Status GetStreamPriorityRange(CudaContext* context,
+                                             int* least_priority,
+                                             int* greatest_priority);
+
   // Destroys a CUDA stream associated with the given context.
   // stream is owned by the caller, must not be null, and *stream is set to null
   // if the stream is successfully destroyed.
@@ -116,6 +132,14 @@ class CUDADriver {
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1g89b3f154e17cc89b6eea277dbdf5c93a
   static void UnifiedMemoryDeallocate(CudaContext* context, void* location);
 
+  // Enqueues on the stream a migration of the given range of unified memory
+  // to the given device, or to the host if device is CU_DEVICE_CPU, via
+  // cuMemPrefetchAsync.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__UNIFIED.html#group__CUDA__UNIFIED_1gfe94f8b7fb56291ebcea44261aa4cb84
+  static bool UnifiedMemoryPrefetch(CudaContext* context, const void* location,
+                                    uint64 bytes, CUdevice device,
+                                    CUstream stream);
+
   // Allocates page-locked and CUDA-registered memory on the host via
   // cuMemAllocHost.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1gdd8311286d2c2691605362c689bc64e0
@@ -326,6 +350,34 @@ class CUDADriver {
   // the stream immediately after this returns).
   static bool IsStreamIdle(CudaContext* context, CUstream stream);
 
+#if CUDA_VERSION >= 10000
+  // Begins capturing the work enqueued on stream into a graph instead of
+  // executing it, via cuStreamBeginCapture.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status StreamBeginCapture(CudaContext* context,
+                                         CUstream stream);
+
+  // Ends the capture begun by StreamBeginCapture and stores the captured
+  // graph in *graph, via cuStreamEndCapture.
+  static port::Status StreamEndCapture(CudaContext* context, CUstream stream,
+                                       CUgraph* graph);
+
+  // Creates an executable graph from graph, via cuGraphInstantiate.
+  // https://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::Status GraphInstantiate(CudaContext* context,
+                                       CUgraphExec* graph_exec, CUgraph graph);
+
+  // Enqueues the execution of graph_exec onto stream, via cuGraphLaunch.
+  static port::Status GraphLaunch(CudaContext* context, CUgraphExec graph_exec,
+                                  CUstream stream);
+
+  // Destroys graph, via cuGraphDestroy.
+  static void DestroyGraph(CudaContext* context, CUgraph graph);
+
+  // Destroys graph_exec, via cuGraphExecDestroy.
+  static void DestroyGraphExec(CudaContext* context, CUgraphExec graph_exec);
+#endif  // CUDA_VERSION >= 10000
+
   // Returns whether code in the from context can access memory in the to
   // context via cuDeviceCanAccessPeer.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__PEER__ACCESS.html#group__CUDA__PEER__ACCESS_1g496bdaae1f632ebfb695b99d2c40f19e
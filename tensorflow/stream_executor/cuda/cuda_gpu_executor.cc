@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/stream_executor/lib/path.h"
 #include "tensorflow/stream_executor/lib/process_state.h"
 #include "tensorflow/stream_executor/lib/ptr_util.h"
+#include "tensorflow/stream_executor/lib/status_macros.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 #include "tensorflow/stream_executor/lib/str_util.h"
 #include "tensorflow/stream_executor/lib/strcat.h"
@@ -587,6 +588,13 @@ bool CUDAExecutor::MemZero(Stream *stream, DeviceMemoryBase *location,
   }
 }
 
+bool CUDAExecutor::UnifiedMemoryPrefetch(Stream *stream, const void *location,
+                                         uint64 size, bool to_host) {
+  return CUDADriver::UnifiedMemoryPrefetch(
+      context_, location, size, to_host ? CU_DEVICE_CPU : device_,
+      AsCUDAStreamValue(stream));
+}
+
 bool CUDAExecutor::Memset(Stream *stream, DeviceMemoryBase *location,
                            uint8 pattern, uint64 size) {
   VLOG(2) << "enqueueing memset8 operation onto stream " << stream
@@ -678,7 +686,7 @@ Event::Status CUDAExecutor::PollForEventStatus(Event *event) {
 }
 
 bool CUDAExecutor::AllocateStream(Stream *stream) {
-  return AsCUDAStream(stream)->Init();
+  return AsCUDAStream(stream)->Init(stream->priority());
 }
 
 void CUDAExecutor::DeallocateStream(Stream *stream) {
@@ -724,6 +732,48 @@ port::Status CUDAExecutor::BlockHostUntilDone(Stream *stream) {
   return CUDADriver::SynchronizeStream(context_, AsCUDAStreamValue(stream));
 }
 
+#if CUDA_VERSION >= 10000
+port::Status CUDAExecutor::BeginGraphCapture(Stream *stream) {
+  return CUDADriver::StreamBeginCapture(context_, AsCUDAStreamValue(stream));
+}
+
+port::StatusOr<void *> CUDAExecutor::EndGraphCapture(Stream *stream) {
+  CUgraph graph = nullptr;
+  SE_RETURN_IF_ERROR(CUDADriver::StreamEndCapture(
+      context_, AsCUDAStreamValue(stream), &graph));
+  // The executable graph doesn't refer to the graph it was instantiated from.
+  CUgraphExec graph_exec = nullptr;
+  port::Status status =
+      CUDADriver::GraphInstantiate(context_, &graph_exec, graph);
+  CUDADriver::DestroyGraph(context_, graph);
+  SE_RETURN_IF_ERROR(status);
+  return static_cast<void *>(graph_exec);
+}
+
+port::Status CUDAExecutor::LaunchGraph(Stream *stream, void *graph) {
+  return CUDADriver::GraphLaunch(context_, static_cast<CUgraphExec>(graph),
+                                 AsCUDAStreamValue(stream));
+}
+
+void CUDAExecutor::DestroyGraph(void *graph) {
+  CUDADriver::DestroyGraphExec(context_, static_cast<CUgraphExec>(graph));
+}
+#else
+port::Status CUDAExecutor::BeginGraphCapture(Stream *stream) {
+  return port::UnimplementedError("CUDA graphs require CUDA 10 or later");
+}
+
+port::StatusOr<void *> CUDAExecutor::EndGraphCapture(Stream *stream) {
+  return port::UnimplementedError("CUDA graphs require CUDA 10 or later");
+}
+
+port::Status CUDAExecutor::LaunchGraph(Stream *stream, void *graph) {
+  return port::UnimplementedError("CUDA graphs require CUDA 10 or later");
+}
+
+void CUDAExecutor::DestroyGraph(void *graph) {}
+#endif  // CUDA_VERSION >= 10000
+
 blas::BlasSupport *CUDAExecutor::CreateBlas() {
   PluginRegistry *registry = PluginRegistry::Instance();
   port::StatusOr<PluginRegistry::BlasFactory> status =
@@ -85,6 +85,9 @@ class CUDAExecutor : public internal::StreamExecutorInterface {
     return CUDADriver::UnifiedMemoryDeallocate(context_, location);
   }
 
+  bool UnifiedMemoryPrefetch(Stream *stream, const void *location, uint64 size,
+                             bool to_host) override;
+
   // CUDA allocation/registration functions are necessary because the driver
   // internally sets up buffers for DMA operations (and page locks them).
   // There's no external interface for us to otherwise control these DMA
@@ -164,6 +167,14 @@ class CUDAExecutor : public internal::StreamExecutorInterface {
 
   port::Status BlockHostUntilDone(Stream *stream) override;
 
+  port::Status BeginGraphCapture(Stream *stream) override;
+
+  port::StatusOr<void *> EndGraphCapture(Stream *stream) override;
+
+  port::Status LaunchGraph(Stream *stream, void *graph) override;
+
+  void DestroyGraph(void *graph) override;
+
   int PlatformDeviceCount() override { return CUDADriver::GetDeviceCount(); }
 
   port::Status EnablePeerAccessTo(StreamExecutorInterface *other) override;
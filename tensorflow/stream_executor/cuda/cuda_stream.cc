@@ -22,8 +22,26 @@ limitations under the License.
 namespace stream_executor {
 namespace cuda {
 
-bool CUDAStream::Init() {
-  if (!CUDADriver::CreateStream(parent_->cuda_context(), &cuda_stream_)) {
+bool CUDAStream::Init(StreamPriority priority) {
+  int least_priority = 0;
+  int greatest_priority = 0;
+  if (priority != StreamPriority::kDefault) {
+    port::Status status = CUDADriver::GetStreamPriorityRange(
+        parent_->cuda_context(), &least_priority, &greatest_priority);
+    if (!status.ok()) {
+      LOG(WARNING) << status.error_message()
+                   << "; creating a stream with the default priority";
+    }
+  }
+  if (least_priority == greatest_priority) {
+    if (!CUDADriver::CreateStream(parent_->cuda_context(), &cuda_stream_)) {
+      return false;
+    }
+  } else if (!CUDADriver::CreateStreamWithPriority(
+                 parent_->cuda_context(),
+                 priority == StreamPriority::kHighest ? greatest_priority
+                                                      : least_priority,
+                 &cuda_stream_)) {
     return false;
   }
   return CUDADriver::CreateEvent(parent_->cuda_context(), &completed_event_,
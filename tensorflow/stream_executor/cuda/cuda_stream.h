@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/stream_executor/cuda/cuda_driver.h"
 #include "tensorflow/stream_executor/platform/thread_annotations.h"
+#include "tensorflow/stream_executor/stream.h"
 #include "tensorflow/stream_executor/stream_executor_internal.h"
 
 namespace stream_executor {
@@ -46,8 +47,9 @@ class CUDAStream : public internal::StreamInterface {
   }
 
   // Explicitly initialize the CUDA resources associated with this stream, used
-  // by StreamExecutor::AllocateStream().
-  bool Init();
+  // by StreamExecutor::AllocateStream(). The stream gets the highest or the
+  // lowest priority the device supports unless priority is kDefault.
+  bool Init(StreamPriority priority);
 
   // Explicitly destroy the CUDA resources associated with this stream, used by
   // StreamExecutor::DeallocateStream().
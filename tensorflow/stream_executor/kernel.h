@@ -80,6 +80,7 @@ limitations under the License.
 #include "tensorflow/stream_executor/lib/array_slice.h"
 #include "tensorflow/stream_executor/lib/inlined_vector.h"
 #include "tensorflow/stream_executor/lib/stringpiece.h"
+#include "tensorflow/stream_executor/platform/logging.h"
 #include "tensorflow/stream_executor/platform/port.h"
 
 namespace stream_executor {
@@ -420,6 +421,16 @@ class KernelArgsArray : public KernelArgsArrayBase {
     ++number_of_argument_addresses_;
   }
 
+  // Replaces the device memory argument at the given index, which must have
+  // been added by add_device_memory_argument. This lets repeated launches of a
+  // kernel reuse the array and only update the buffers they pass.
+  void set_device_memory_argument(size_t index, const DeviceMemoryBase &arg) {
+    DCHECK_LT(index, number_of_argument_addresses_);
+    DCHECK_EQ(argument_addresses_[index],
+              &device_memory_opaque_pointers_[index]);
+    device_memory_opaque_pointers_[index] = arg.opaque();
+  }
+
   // Adds a shared memory argument to the list.
   //
   // The only significant information about a shared argument is its size, so
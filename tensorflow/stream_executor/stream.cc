@@ -134,6 +134,18 @@ string ToVlogString(float f) { return port::StrCat(f); }
 
 string ToVlogString(double d) { return port::StrCat(d); }
 
+string ToVlogString(StreamPriority priority) {
+  switch (priority) {
+    case StreamPriority::kDefault:
+      return "kDefault";
+    case StreamPriority::kLowest:
+      return "kLowest";
+    case StreamPriority::kHighest:
+      return "kHighest";
+  }
+  return "unknown";
+}
+
 template <typename T>
 string ToVlogString(const HostOrDeviceScalar<T> &memory_or_constant) {
   if (memory_or_constant.is_pointer()) {
@@ -249,6 +261,7 @@ Stream::Stream(StreamExecutor *parent)
     : parent_(parent),
       implementation_(parent->implementation()->GetStreamImplementation()),
       allocated_(false),
+      priority_(StreamPriority::kDefault),
       ok_(false),
       temporary_memory_manager_(this) {
   VLOG_CALL(PARAM(parent));
@@ -259,6 +272,7 @@ Stream::Stream(StreamExecutor *parent,
     : parent_(parent),
       implementation_(implementation),
       allocated_(false),
+      priority_(StreamPriority::kDefault),
       ok_(false),
       temporary_memory_manager_(this) {
   VLOG_CALL(PARAM(parent), PARAM(implementation));
@@ -299,6 +313,18 @@ Stream &Stream::Init() {
   return *this;
 }
 
+Stream &Stream::InitWithPriority(StreamPriority priority) {
+  VLOG_CALL(PARAM(priority));
+
+  {
+    mutex_lock lock(mu_);
+    CHECK_EQ(false, allocated_)
+        << "stream appears to already have been initialized";
+    priority_ = priority;
+  }
+  return Init();
+}
+
 Stream &Stream::InitTimer(Timer *timer) {
   VLOG_CALL(PARAM(timer));
 
@@ -1931,7 +1957,7 @@ Stream *Stream::GetOrCreateSubStream() {
   sub_streams_.emplace_back(std::unique_ptr<Stream>{new Stream{parent_}},
                             false);
   Stream *sub_stream = sub_streams_.back().first.get();
-  sub_stream->Init();
+  sub_stream->InitWithPriority(priority_);
   CHECK(ok_) << "sub-stream failed to be initialized";
 
   return sub_stream;
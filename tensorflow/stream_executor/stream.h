@@ -88,6 +88,18 @@ struct Quantization;
 // indicate that an error has occurred. After initialization, once a stream is
 // !ok(), it will never be ok().
 //
+// The priority with which the platform schedules the work of a stream against
+// the work of the other streams on the same device.
+enum class StreamPriority {
+  // The priority of streams created without one.
+  kDefault,
+  // The lowest priority the device supports, e.g. for bulk copies.
+  kLowest,
+  // The highest priority the device supports, e.g. for latency-critical
+  // kernels.
+  kHighest,
+};
+
 // Thread-safe post-initialization.
 class Stream {
  public:
@@ -113,6 +125,13 @@ class Stream {
   // operations.
   Stream &Init() LOCKS_EXCLUDED(mu_);
 
+  // Like Init(), but asks the platform to give the stream the given priority.
+  // Platforms that don't support priorities ignore it.
+  Stream &InitWithPriority(StreamPriority priority) LOCKS_EXCLUDED(mu_);
+
+  // The priority the stream was initialized with.
+  StreamPriority priority() const { return priority_; }
+
   // Initializes timer t via the StreamExecutor.
   Stream &InitTimer(Timer *t);
 
@@ -2066,6 +2085,9 @@ class Stream {
   // See StreamExecutor::AllocateStream.
   bool allocated_ GUARDED_BY(mu_);
 
+  // Set before the stream is allocated and constant afterwards.
+  StreamPriority priority_;
+
   // Whether all operations have entrained successfully to the current program
   // point.
   bool ok_ GUARDED_BY(mu_);
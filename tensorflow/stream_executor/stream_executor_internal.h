@@ -207,6 +207,13 @@ class StreamExecutorInterface {
   // Deallocates unified memory space previously allocated with
   // UnifiedMemoryAllocate.
   virtual void UnifiedMemoryDeallocate(void *mem) {}
+
+  // Enqueues on the stream a migration of the given range of unified memory
+  // to the device, or to the host if to_host is true, if supported.
+  virtual bool UnifiedMemoryPrefetch(Stream *stream, const void *location,
+                                     uint64 size, bool to_host) {
+    return false;
+  }
   virtual void *HostMemoryAllocate(uint64 size) = 0;
   virtual void HostMemoryDeallocate(void *mem) = 0;
   virtual bool HostMemoryRegister(void *mem, uint64 size) = 0;
@@ -252,6 +259,19 @@ class StreamExecutorInterface {
   virtual bool StartTimer(Stream *stream, Timer *timer) = 0;
   virtual bool StopTimer(Stream *stream, Timer *timer) = 0;
   virtual port::Status BlockHostUntilDone(Stream *stream) = 0;
+
+  // Graph capture; see StreamExecutor::BeginGraphCapture. Not supported by
+  // default.
+  virtual port::Status BeginGraphCapture(Stream *stream) {
+    return port::UnimplementedError("graph capture is not supported");
+  }
+  virtual port::StatusOr<void *> EndGraphCapture(Stream *stream) {
+    return port::UnimplementedError("graph capture is not supported");
+  }
+  virtual port::Status LaunchGraph(Stream *stream, void *graph) {
+    return port::UnimplementedError("graph capture is not supported");
+  }
+  virtual void DestroyGraph(void *graph) {}
   virtual int PlatformDeviceCount() = 0;
   virtual port::Status EnablePeerAccessTo(StreamExecutorInterface *other) = 0;
   virtual bool CanEnablePeerAccessTo(StreamExecutorInterface *other) = 0;
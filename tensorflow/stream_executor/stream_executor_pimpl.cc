@@ -459,6 +459,22 @@ port::Status StreamExecutor::BlockHostUntilDone(Stream *stream) {
   return result;
 }
 
+port::Status StreamExecutor::BeginGraphCapture(Stream *stream) {
+  return implementation_->BeginGraphCapture(stream);
+}
+
+port::StatusOr<void *> StreamExecutor::EndGraphCapture(Stream *stream) {
+  return implementation_->EndGraphCapture(stream);
+}
+
+port::Status StreamExecutor::LaunchGraph(Stream *stream, void *graph) {
+  return implementation_->LaunchGraph(stream, graph);
+}
+
+void StreamExecutor::DestroyGraph(void *graph) {
+  implementation_->DestroyGraph(graph);
+}
+
 void *StreamExecutor::Allocate(uint64 size) {
   void *buf = implementation_->Allocate(size);
   VLOG(1) << "Called StreamExecutor::Allocate(size=" << size << ") returns "
@@ -512,6 +528,15 @@ void StreamExecutor::UnifiedMemoryDeallocate(void *location) {
   return implementation_->UnifiedMemoryDeallocate(location);
 }
 
+bool StreamExecutor::UnifiedMemoryPrefetch(Stream *stream,
+                                           const void *location, uint64 bytes,
+                                           bool to_host) {
+  VLOG(2) << "Called StreamExecutor::UnifiedMemoryPrefetch(location="
+          << location << ", size=" << bytes << ", to_host=" << to_host << ")";
+  return implementation_->UnifiedMemoryPrefetch(stream, location, bytes,
+                                                to_host);
+}
+
 void *StreamExecutor::HostMemoryAllocate(uint64 size) {
   void *buffer = implementation_->HostMemoryAllocate(size);
   VLOG(1) << "Called StreamExecutor::HostMemoryAllocate(size=" << size
@@ -218,6 +218,14 @@ class StreamExecutor {
   // UnifiedMemoryAllocate.
   void UnifiedMemoryDeallocate(void *location);
 
+  // Enqueues on the stream a migration of the given range of unified memory
+  // to this device, or to the host if to_host is true. The migration is a
+  // hint: the memory stays accessible from both sides in any case. Returns
+  // false if it could not be enqueued, e.g. if unified memory prefetching is
+  // not supported.
+  bool UnifiedMemoryPrefetch(Stream *stream, const void *location, uint64 bytes,
+                             bool to_host);
+
   // Allocates a region of host memory and registers it with the platform API.
   // Memory allocated in this manner (or allocated and registered with
   // HostMemoryRegister() is required for use in asynchronous memcpy operations,
@@ -422,6 +430,24 @@ class StreamExecutor {
   createRnnStateTensorDescriptor(int num_layer, int batch_size, int data_size,
                                  dnn::DataType data_type);
 
+  // Begins capturing the work subsequently enqueued on `stream` into a graph,
+  // instead of executing it, until EndGraphCapture is called. The captured
+  // work must not synchronize with the host. Returns UNIMPLEMENTED if the
+  // platform doesn't support graphs.
+  port::Status BeginGraphCapture(Stream *stream);
+
+  // Ends the capture begun by BeginGraphCapture and returns an opaque handle
+  // to the captured graph, ready to be launched. The caller owns the graph
+  // and must destroy it with DestroyGraph.
+  port::StatusOr<void *> EndGraphCapture(Stream *stream);
+
+  // Enqueues the work captured in `graph` onto `stream`. The work uses the
+  // same memory as when it was captured.
+  port::Status LaunchGraph(Stream *stream, void *graph);
+
+  // Destroys a graph returned by EndGraphCapture.
+  void DestroyGraph(void *graph);
+
   // Returns the device ordinal that this StreamExecutor was initialized with.
   // Meaningless before initialization.
   int device_ordinal() const { return device_ordinal_; }
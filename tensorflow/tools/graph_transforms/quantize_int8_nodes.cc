@@ -0,0 +1,315 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Reads the float tensor of a Const node.
+bool GetConstTensor(const NodeDef& node, Tensor* tensor) {
+  return node.op() == "Const" && node.attr().count("value") &&
+         tensor->FromProto(node.attr().at("value").tensor()) &&
+         tensor->dtype() == DT_FLOAT;
+}
+
+// Reads a float scalar from a Const node.
+bool GetConstFloat(const NodeDef& node, float* value) {
+  Tensor tensor;
+  if (!GetConstTensor(node, &tensor) || tensor.NumElements() != 1) {
+    return false;
+  }
+  *value = tensor.flat<float>()(0);
+  return true;
+}
+
+// Reads the range of an eight-bit FakeQuantWithMinMaxArgs node, or of an
+// eight-bit FakeQuantWithMinMaxVars node whose min and max are constants.
+bool GetFakeQuantRange(const NodeDef& node,
+                       const std::map<string, const NodeDef*>& node_map,
+                       float* min, float* max) {
+  if (node.attr().count("num_bits") && node.attr().at("num_bits").i() != 8) {
+    return false;
+  }
+  if (node.op() == "FakeQuantWithMinMaxArgs") {
+    *min = node.attr().count("min") ? node.attr().at("min").f() : -6.0f;
+    *max = node.attr().count("max") ? node.attr().at("max").f() : 6.0f;
+    return true;
+  }
+  if (node.op() != "FakeQuantWithMinMaxVars" || node.input_size() < 3) {
+    return false;
+  }
+  const auto min_node = node_map.find(NodeNameFromInput(node.input(1)));
+  const auto max_node = node_map.find(NodeNameFromInput(node.input(2)));
+  return min_node != node_map.end() && max_node != node_map.end() &&
+         GetConstFloat(*min_node->second, min) &&
+         GetConstFloat(*max_node->second, max);
+}
+
+NodeDef MakeFloatConst(const string& name, const Tensor& value) {
+  NodeDef node;
+  node.set_op("Const");
+  node.set_name(name);
+  SetNodeAttr("dtype", DT_FLOAT, &node);
+  SetNodeTensorAttr<float>("value", value, &node);
+  return node;
+}
+
+NodeDef MakeFloatConst(const string& name, float value) {
+  Tensor tensor(DT_FLOAT, {});
+  tensor.scalar<float>()() = value;
+  return MakeFloatConst(name, tensor);
+}
+
+// Quantizes the float `weights`, whose last dimension is the output channels,
+// to int8 values symmetrically around zero over the range of each channel.
+void QuantizeWeightsPerChannel(const Tensor& weights, Tensor* quantized,
+                               Tensor* min_weights, Tensor* max_weights) {
+  const int64 channels = weights.dim_size(weights.dims() - 1);
+  const auto values = weights.flat<float>();
+  std::vector<float> max_abs(channels, 0.0f);
+  for (int64 i = 0; i < values.size(); ++i) {
+    float& channel_max_abs = max_abs[i % channels];
+    channel_max_abs = std::max(channel_max_abs, std::abs(values(i)));
+  }
+  *min_weights = Tensor(DT_FLOAT, {channels});
+  *max_weights = Tensor(DT_FLOAT, {channels});
+  for (int64 c = 0; c < channels; ++c) {
+    // An all-zero channel still needs a valid range.
+    if (max_abs[c] == 0.0f) max_abs[c] = 1.0f;
+    min_weights->flat<float>()(c) = -max_abs[c];
+    max_weights->flat<float>()(c) = max_abs[c];
+  }
+  *quantized = Tensor(DT_QINT8, weights.shape());
+  auto quantized_values = quantized->flat<qint8>();
+  for (int64 i = 0; i < values.size(); ++i) {
+    const float scaled = std::round(values(i) / max_abs[i % channels] * 127.0f);
+    quantized_values(i) =
+        static_cast<int8>(std::min(std::max(scaled, -127.0f), 127.0f));
+  }
+}
+
+// Replaces a match of Conv2D or MatMul, BiasAdd, Relu and the FakeQuant of
+// the output with the fused eight-bit op, if the input of the Conv2D or
+// MatMul is also a FakeQuant and its weights and bias are constants.
+Status QuantizeMatch(const NodeMatch& match,
+                     const std::map<string, const NodeDef*>& node_map,
+                     const std::set<string>& output_nodes,
+                     std::vector<NodeDef>* new_nodes) {
+  const NodeDef& output_fake_quant = match.node;
+  const NodeMatch& relu_match = match.inputs[0];
+  const NodeMatch& bias_add_match = relu_match.inputs[0];
+  const NodeDef& op_node = bias_add_match.inputs[0].node;
+  const NodeDef& bias_node = bias_add_match.inputs[1].node;
+  const bool is_conv = op_node.op() == "Conv2D";
+
+  // Any node of the match other than the output that is used elsewhere has to
+  // stay, and so does the float computation.
+  for (const NodeDef* node :
+       {&relu_match.node, &bias_add_match.node, &op_node}) {
+    if (output_nodes.count(node->name())) {
+      CopyOriginalMatch(match, new_nodes);
+      return Status::OK();
+    }
+  }
+
+  bool supported = op_node.input_size() >= 2 &&
+                   op_node.attr().count("T") &&
+                   op_node.attr().at("T").type() == DT_FLOAT;
+  if (is_conv) {
+    supported = supported && (!op_node.attr().count("data_format") ||
+                              op_node.attr().at("data_format").s() == "NHWC");
+  } else {
+    supported = supported && (!op_node.attr().count("transpose_a") ||
+                              !op_node.attr().at("transpose_a").b());
+  }
+  float input_min = 0.0f, input_max = 0.0f, output_min = 0.0f,
+        output_max = 0.0f;
+  const auto input_node = node_map.find(NodeNameFromInput(op_node.input(0)));
+  supported = supported && input_node != node_map.end() &&
+              GetFakeQuantRange(*input_node->second, node_map, &input_min,
+                                &input_max) &&
+              GetFakeQuantRange(output_fake_quant, node_map, &output_min,
+                                &output_max);
+  const auto weights_node = node_map.find(NodeNameFromInput(op_node.input(1)));
+  Tensor weights;
+  supported = supported && weights_node != node_map.end() &&
+              GetConstTensor(*weights_node->second, &weights) &&
+              weights.dims() == (is_conv ? 4 : 2);
+  Tensor bias;
+  supported = supported && GetConstTensor(bias_node, &bias);
+  if (!supported) {
+    CopyOriginalMatch(match, new_nodes);
+    return Status::OK();
+  }
+
+  // The MatMul op takes its weights as [k, n].
+  if (!is_conv && op_node.attr().count("transpose_b") &&
+      op_node.attr().at("transpose_b").b()) {
+    Tensor transposed(DT_FLOAT, {weights.dim_size(1), weights.dim_size(0)});
+    transposed.matrix<float>() =
+        weights.matrix<float>().shuffle(Eigen::array<int, 2>({1, 0}));
+    weights = transposed;
+  }
+  const int64 channels = weights.dim_size(weights.dims() - 1);
+  if (bias.NumElements() != channels) {
+    CopyOriginalMatch(match, new_nodes);
+    return Status::OK();
+  }
+
+  // The nodes of the output FakeQuantWithMinMaxVars range may be shared.
+  for (size_t i = 1; i < match.inputs.size(); ++i) {
+    new_nodes->push_back(match.inputs[i].node);
+  }
+  new_nodes->push_back(bias_node);
+
+  const string& name = output_fake_quant.name();
+  const NodeDef input_min_node = MakeFloatConst(name + "/input_min", input_min);
+  const NodeDef input_max_node = MakeFloatConst(name + "/input_max", input_max);
+  new_nodes->push_back(input_min_node);
+  new_nodes->push_back(input_max_node);
+
+  NodeDef quantize_node;
+  quantize_node.set_op("QuantizeV2");
+  quantize_node.set_name(name + "/quantize_input");
+  SetNodeAttr("T", DT_QUINT8, &quantize_node);
+  SetNodeAttr("mode", "MIN_FIRST", &quantize_node);
+  AddNodeInput(op_node.input(0), &quantize_node);
+  AddNodeInput(input_min_node.name(), &quantize_node);
+  AddNodeInput(input_max_node.name(), &quantize_node);
+  new_nodes->push_back(quantize_node);
+
+  Tensor quantized_weights, min_weights, max_weights;
+  QuantizeWeightsPerChannel(weights, &quantized_weights, &min_weights,
+                            &max_weights);
+  NodeDef weights_const;
+  weights_const.set_op("Const");
+  weights_const.set_name(name + "/weights");
+  SetNodeAttr("dtype", DT_QINT8, &weights_const);
+  SetNodeTensorAttr<qint8>("value", quantized_weights, &weights_const);
+  new_nodes->push_back(weights_const);
+  const NodeDef min_weights_node =
+      MakeFloatConst(name + "/weights_min", min_weights);
+  const NodeDef max_weights_node =
+      MakeFloatConst(name + "/weights_max", max_weights);
+  new_nodes->push_back(min_weights_node);
+  new_nodes->push_back(max_weights_node);
+
+  const NodeDef output_min_node =
+      MakeFloatConst(name + "/output_min", output_min);
+  const NodeDef output_max_node =
+      MakeFloatConst(name + "/output_max", output_max);
+  new_nodes->push_back(output_min_node);
+  new_nodes->push_back(output_max_node);
+
+  NodeDef fused_node;
+  fused_node.set_name(name + "/quantized");
+  if (is_conv) {
+    fused_node.set_op("QuantizedConv2DWithBiasAndRelu");
+    SetNodeAttr("Tinput", DT_QUINT8, &fused_node);
+    SetNodeAttr("Tfilter", DT_QINT8, &fused_node);
+    SetNodeAttr("out_type", DT_QUINT8, &fused_node);
+    CopyNodeAttr(op_node, "strides", "strides", &fused_node);
+    CopyNodeAttr(op_node, "padding", "padding", &fused_node);
+    if (op_node.attr().count("dilations")) {
+      CopyNodeAttr(op_node, "dilations", "dilations", &fused_node);
+    }
+  } else {
+    fused_node.set_op("QuantizedMatMulWithBiasAndRelu");
+    SetNodeAttr("T1", DT_QUINT8, &fused_node);
+    SetNodeAttr("T2", DT_QINT8, &fused_node);
+    SetNodeAttr("Toutput", DT_QUINT8, &fused_node);
+  }
+  AddNodeInput(quantize_node.name() + ":0", &fused_node);
+  AddNodeInput(weights_const.name(), &fused_node);
+  AddNodeInput(bias_node.name(), &fused_node);
+  AddNodeInput(quantize_node.name() + ":1", &fused_node);
+  AddNodeInput(quantize_node.name() + ":2", &fused_node);
+  AddNodeInput(min_weights_node.name(), &fused_node);
+  AddNodeInput(max_weights_node.name(), &fused_node);
+  AddNodeInput(output_min_node.name(), &fused_node);
+  AddNodeInput(output_max_node.name(), &fused_node);
+  new_nodes->push_back(fused_node);
+
+  // The dequantized output takes the place of the output FakeQuant.
+  NodeDef dequantize_node;
+  dequantize_node.set_op("Dequantize");
+  dequantize_node.set_name(name);
+  SetNodeAttr("T", DT_QUINT8, &dequantize_node);
+  SetNodeAttr("mode", "MIN_FIRST", &dequantize_node);
+  AddNodeInput(fused_node.name() + ":0", &dequantize_node);
+  AddNodeInput(fused_node.name() + ":1", &dequantize_node);
+  AddNodeInput(fused_node.name() + ":2", &dequantize_node);
+  new_nodes->push_back(dequantize_node);
+  return Status::OK();
+}
+
+}  // namespace
+
+// Converts the Conv2D and MatMul ops of a float graph that are followed by a
+// BiasAdd and a Relu into the fused eight-bit ops with per-channel quantized
+// weights, which compute their products with int8 instructions on CPUs that
+// have them. The ranges of the inputs and outputs are taken from the
+// FakeQuantWithMinMaxArgs or FakeQuantWithMinMaxVars ops that calibration or
+// quantization-aware training inserted around them.
+Status QuantizeInt8Nodes(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def) {
+  // The Conv2D and MatMul inputs are not part of the patterns, so that a
+  // FakeQuant can be both the output of a match and the input of the next.
+  const OpTypePattern bias_relu_pattern =  // clang-format off
+      {"Relu",
+          {
+              {"BiasAdd",
+                  {
+                      {"Conv2D|MatMul"},
+                      {"Const"}
+                  }
+              }
+          }
+      };  // clang-format on
+  const std::vector<OpTypePattern> patterns = {
+      {"FakeQuantWithMinMaxArgs", {bias_relu_pattern}},
+      {"FakeQuantWithMinMaxVars", {bias_relu_pattern, {"Const"}, {"Const"}}},
+  };
+  GraphDef current_graph_def = input_graph_def;
+  for (const OpTypePattern& pattern : patterns) {
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(current_graph_def, &node_map);
+    GraphDef replaced_graph_def;
+    TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+        current_graph_def, pattern,
+        [&node_map](const NodeMatch& match, const std::set<string>& input_nodes,
+                    const std::set<string>& output_nodes,
+                    std::vector<NodeDef>* new_nodes) {
+          return QuantizeMatch(match, node_map, output_nodes, new_nodes);
+        },
+        {}, &replaced_graph_def));
+    current_graph_def = replaced_graph_def;
+  }
+  *output_graph_def = current_graph_def;
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("quantize_int8_nodes", QuantizeInt8Nodes);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,203 @@
+/* Copyright 2018 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status QuantizeInt8Nodes(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def);
+
+class QuantizeInt8NodesTest : public ::testing::Test {
+ protected:
+  // Runs the original and the quantized graph, and checks that the quantized
+  // graph computes `expected_op` and matches the original to within
+  // `tolerance`.
+  void TestQuantizedVersusFloatGraph(const GraphDef& float_graph_def,
+                                     const string& expected_op,
+                                     float tolerance) {
+    std::unique_ptr<Session> float_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(float_session->Create(float_graph_def));
+    std::vector<Tensor> float_outputs;
+    TF_ASSERT_OK(float_session->Run({}, {"output"}, {}, &float_outputs));
+
+    GraphDef quantized_graph_def;
+    TF_ASSERT_OK(QuantizeInt8Nodes(float_graph_def, {{}, {"output"}},
+                                   &quantized_graph_def));
+
+    std::unique_ptr<Session> quantized_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(quantized_session->Create(quantized_graph_def));
+    std::vector<Tensor> quantized_outputs;
+    TF_ASSERT_OK(
+        quantized_session->Run({}, {"output"}, {}, &quantized_outputs));
+
+    test::ExpectTensorNear<float>(float_outputs[0], quantized_outputs[0],
+                                  tolerance);
+
+    int expected_op_count = 0;
+    for (const NodeDef& node : quantized_graph_def.node()) {
+      EXPECT_NE("Conv2D", node.op());
+      EXPECT_NE("MatMul", node.op());
+      EXPECT_NE("Relu", node.op());
+      if (node.op() == expected_op) {
+        ++expected_op_count;
+      }
+    }
+    EXPECT_EQ(1, expected_op_count);
+  }
+
+  void TestQuantizeConv() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({1, 3, 3, 2}));
+    test::FillValues<float>(&input_data,
+                            {0.1f, 1.2f, 2.3f, 3.4f, 4.5f, 5.6f, 0.7f, 1.8f,
+                             2.9f, 3.0f, 4.1f, 5.2f, 0.3f, 1.4f, 2.5f, 3.6f,
+                             4.7f, 5.8f});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+    Output input_fake_quant_op = FakeQuantWithMinMaxArgs(
+        root.WithOpName("input_fake_quant_op"), input_op,
+        FakeQuantWithMinMaxArgs::Min(0.0f).Max(6.0f));
+
+    Tensor weights_data(DT_FLOAT, TensorShape({2, 2, 2, 2}));
+    test::FillValues<float>(&weights_data,
+                            {1.0f, -0.1f, 2.0f, 0.2f, -3.0f, 0.3f, 4.0f, -0.4f,
+                             0.5f, 0.05f, -0.6f, -0.06f, 0.7f, 0.07f, 0.8f,
+                             0.08f});
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output conv_op = Conv2D(root.WithOpName("conv_op"), input_fake_quant_op,
+                            weights_op, {1, 1, 1, 1}, "SAME");
+
+    Tensor bias_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&bias_data, {1.0f, -0.5f});
+    Output bias_op =
+        Const(root.WithOpName("bias_op"), Input::Initializer(bias_data));
+    Output bias_add_op =
+        BiasAdd(root.WithOpName("bias_add_op"), conv_op, bias_op);
+    Output relu_op = Relu(root.WithOpName("relu_op"), bias_add_op);
+    Output output_op = FakeQuantWithMinMaxArgs(
+        root.WithOpName("output"), relu_op,
+        FakeQuantWithMinMaxArgs::Min(0.0f).Max(40.0f));
+
+    GraphDef float_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&float_graph_def));
+    // The quantized weights and the requantized output each add an error of
+    // about a step of their range.
+    TestQuantizedVersusFloatGraph(float_graph_def,
+                                  "QuantizedConv2DWithBiasAndRelu", 0.5f);
+  }
+
+  void TestQuantizeMatMul() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({2, 3}));
+    test::FillValues<float>(&input_data, {0.5f, 1.0f, 1.5f, 2.0f, 2.5f, 3.0f});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+    Output min_op = Const(root.WithOpName("min_op"), 0.0f);
+    Output max_op = Const(root.WithOpName("max_op"), 4.0f);
+    Output input_fake_quant_op =
+        FakeQuantWithMinMaxVars(root.WithOpName("input_fake_quant_op"),
+                                input_op, min_op, max_op);
+
+    // The weights are transposed, to check that they are transposed back
+    // before being quantized.
+    Tensor weights_data(DT_FLOAT, TensorShape({2, 3}));
+    test::FillValues<float>(&weights_data,
+                            {1.0f, -2.0f, 3.0f, 0.4f, 0.5f, -0.6f});
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output mat_mul_op =
+        MatMul(root.WithOpName("mat_mul_op"), input_fake_quant_op, weights_op,
+               MatMul::TransposeB(true));
+
+    Tensor bias_data(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&bias_data, {0.25f, 0.75f});
+    Output bias_op =
+        Const(root.WithOpName("bias_op"), Input::Initializer(bias_data));
+    Output bias_add_op =
+        BiasAdd(root.WithOpName("bias_add_op"), mat_mul_op, bias_op);
+    Output relu_op = Relu(root.WithOpName("relu_op"), bias_add_op);
+    Output output_min_op = Const(root.WithOpName("output_min_op"), 0.0f);
+    Output output_max_op = Const(root.WithOpName("output_max_op"), 10.0f);
+    Output output_op =
+        FakeQuantWithMinMaxVars(root.WithOpName("output"), relu_op,
+                                output_min_op, output_max_op);
+
+    GraphDef float_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&float_graph_def));
+    TestQuantizedVersusFloatGraph(float_graph_def,
+                                  "QuantizedMatMulWithBiasAndRelu", 0.15f);
+  }
+
+  void TestLeavesUnquantizedInputAlone() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    // Without a FakeQuant on its input there is no range to quantize the
+    // input with, so the graph is left unchanged.
+    Tensor input_data(DT_FLOAT, TensorShape({1, 2}));
+    test::FillValues<float>(&input_data, {1.0f, 2.0f});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+    Tensor weights_data(DT_FLOAT, TensorShape({2, 1}));
+    test::FillValues<float>(&weights_data, {1.0f, -1.0f});
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output mat_mul_op =
+        MatMul(root.WithOpName("mat_mul_op"), input_op, weights_op);
+    Output bias_op = Const(root.WithOpName("bias_op"), {2.0f});
+    Output bias_add_op =
+        BiasAdd(root.WithOpName("bias_add_op"), mat_mul_op, bias_op);
+    Output relu_op = Relu(root.WithOpName("relu_op"), bias_add_op);
+    Output output_op = FakeQuantWithMinMaxArgs(root.WithOpName("output"),
+                                               relu_op);
+
+    GraphDef float_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&float_graph_def));
+    GraphDef quantized_graph_def;
+    TF_ASSERT_OK(QuantizeInt8Nodes(float_graph_def, {{}, {"output"}},
+                                   &quantized_graph_def));
+    EXPECT_EQ(float_graph_def.node_size(), quantized_graph_def.node_size());
+    for (const NodeDef& node : quantized_graph_def.node()) {
+      EXPECT_NE("QuantizedMatMulWithBiasAndRelu", node.op());
+    }
+  }
+};
+
+TEST_F(QuantizeInt8NodesTest, TestQuantizeConv) { TestQuantizeConv(); }
+
+TEST_F(QuantizeInt8NodesTest, TestQuantizeMatMul) { TestQuantizeMatMul(); }
+
+TEST_F(QuantizeInt8NodesTest, TestLeavesUnquantizedInputAlone) {
+  TestLeavesUnquantizedInputAlone();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
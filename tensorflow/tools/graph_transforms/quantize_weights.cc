@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/command_line_flags.h"
@@ -38,6 +39,10 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
   int32 minimum_size;
   TF_RETURN_IF_ERROR(
       context.GetOneInt32Parameter("minimum_size", 1024, &minimum_size));
+  // Constants are converted independently, so spread them over the cores.
+  int32 num_threads;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter(
+      "num_threads", port::NumSchedulableCPUs(), &num_threads));
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       input_graph_def, {"Const"},
       [minimum_size](const NodeMatch& match,
@@ -136,7 +141,7 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
 
         return Status::OK();
       },
-      {}, output_graph_def));
+      {false, num_threads}, output_graph_def));
 
   return Status::OK();
 }
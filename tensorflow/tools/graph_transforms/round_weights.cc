@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/command_line_flags.h"
@@ -36,6 +37,10 @@ Status RoundWeights(const GraphDef& input_graph_def,
   int32 num_steps;
   TF_RETURN_IF_ERROR(
       context.GetOneInt32Parameter("num_steps", 256, &num_steps));
+  // Constants are converted independently, so spread them over the cores.
+  int32 num_threads;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter(
+      "num_threads", port::NumSchedulableCPUs(), &num_threads));
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       input_graph_def, {"Const"},
       [num_steps](const NodeMatch& match, const std::set<string>& input_nodes,
@@ -105,7 +110,7 @@ Status RoundWeights(const GraphDef& input_graph_def,
 
         return Status::OK();
       },
-      {}, output_graph_def));
+      {false, num_threads}, output_graph_def));
 
   return Status::OK();
 }
@@ -332,16 +332,18 @@ Status TransformGraph(const std::vector<string>& inputs,
       if (ignore_errors) {
         LOG(ERROR) << transform_name << ": Ignoring error "
                    << transform_result.error_message();
-        transformed_graph_def = *graph_def;
+        TF_RETURN_IF_ERROR(IsGraphValid(*graph_def));
+        continue;
       } else {
         return transform_result;
       }
     }
-    // Copy over the library from the original input graph.
-    *transformed_graph_def.mutable_library() = graph_def->library();
+    // Move over the library from the original input graph. Graphs can be
+    // several gigabytes, so they're swapped rather than copied.
+    transformed_graph_def.mutable_library()->Swap(graph_def->mutable_library());
     TF_RETURN_IF_ERROR(IsGraphValid(transformed_graph_def));
 
-    *graph_def = transformed_graph_def;
+    graph_def->Swap(&transformed_graph_def);
   }
   return Status::OK();
 }
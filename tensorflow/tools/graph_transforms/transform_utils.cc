@@ -17,8 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace graph_transforms {
@@ -358,38 +360,116 @@ bool GraphMatcher::DoesOpTypeMatch(
   return true;
 }
 
+namespace {
+// The state of one matched subgraph while it's being replaced.
+struct Replacement {
+  // The match, or null for a single-node pattern, whose match is only built
+  // from the head node when the replacement function runs so that the graph
+  // isn't copied into matches.
+  const NodeMatch* match = nullptr;
+  const NodeDef* head = nullptr;
+  std::set<string> input_nodes;
+  std::set<string> output_nodes;
+  std::vector<NodeDef> new_nodes;
+  Status status;
+};
+
+bool OpMatchesPattern(const NodeDef& node, const OpTypePattern& pattern) {
+  if (pattern.op == "*") {
+    return true;
+  }
+  for (const string& pattern_op : str_util::Split(pattern.op, '|')) {
+    if (node.op() == pattern_op) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Calls the replacement function for `replacement`, and falls back to the
+// original nodes if the function didn't preserve the ones used elsewhere.
+void GenerateReplacement(
+    const std::function<Status(const NodeMatch&, const std::set<string>&,
+                               const std::set<string>&, std::vector<NodeDef>*)>&
+        node_generator,
+    const ReplaceMatchingOpTypesOptions& options, Replacement* replacement) {
+  NodeMatch single_node_match;
+  const NodeMatch* match = replacement->match;
+  if (match == nullptr) {
+    single_node_match.node = *replacement->head;
+    match = &single_node_match;
+  }
+  replacement->status =
+      node_generator(*match, replacement->input_nodes,
+                     replacement->output_nodes, &replacement->new_nodes);
+  if (!replacement->status.ok() || options.allow_inconsistencies) {
+    return;
+  }
+  // Check to make sure the generator function preserved all of the nodes
+  // that are used elsewhere in the graph, and add them back in if not.
+  std::set<string> new_node_names;
+  for (const NodeDef& new_node : replacement->new_nodes) {
+    new_node_names.insert(new_node.name());
+  }
+  bool abort_replacement = false;
+  for (const string& expected_output : replacement->output_nodes) {
+    if (!new_node_names.count(expected_output)) {
+      LOG(WARNING) << "Expected " << expected_output << " to be preserved.";
+      abort_replacement = true;
+    }
+  }
+  if (abort_replacement) {
+    LOG(WARNING) << "Generator function didn't preserve needed nodes, "
+                 << "copying old replacements back in instead.";
+    replacement->new_nodes.clear();
+    MatchedNodesAsArray(*match, &replacement->new_nodes);
+  }
+}
+}  // namespace
+
 Status ReplaceMatchingOpTypes(
     const GraphDef& input_graph_def, const OpTypePattern& pattern,
     const std::function<Status(const NodeMatch&, const std::set<string>&,
                                const std::set<string>&, std::vector<NodeDef>*)>&
         node_generator,
     const ReplaceMatchingOpTypesOptions& options, GraphDef* output_graph_def) {
-  // Start off by retrieving all the matching subgraphs.
-  GraphMatcher matcher(input_graph_def);
-  std::vector<NodeMatch> matches;
-  TF_RETURN_IF_ERROR(matcher.GetOpTypeMatches(pattern, &matches));
-
-  // Do some housekeeping so we can easily look up the resulting matches given
-  // a node name.
-  std::set<string> matched_nodes;
-  std::map<string, const NodeMatch*> matches_by_head_name;
-  for (const NodeMatch& match : matches) {
-    matches_by_head_name[match.node.name()] = &match;
-    RecordMatchedNodes(match, &matched_nodes);
-  }
   std::map<string, std::vector<const NodeDef*>> outputs_map;
   MapNodesToOutputs(input_graph_def, &outputs_map);
 
-  // Go through all the nodes in the input graph, see if they are part of a
-  // match or if they can be left untouched.
-  output_graph_def->Clear();
-  for (const NodeDef& input_node : input_graph_def.node()) {
-    if (matches_by_head_name.count(input_node.name())) {
-      // This node is the beginning of a match, so call the replacement function
-      // after setting up some information it will need.
-      const NodeMatch* match = matches_by_head_name[input_node.name()];
+  // Start off by retrieving all the matching subgraphs, and do some
+  // housekeeping so we can easily look up the resulting matches given a node
+  // name.
+  std::vector<NodeMatch> matches;
+  std::set<string> matched_nodes;
+  std::vector<Replacement> replacements;
+  if (pattern.inputs.empty()) {
+    // Matches of a single node can't overlap, so there's no need for the
+    // execution order and the copy of the graph that GraphMatcher makes.
+    for (const NodeDef& node : input_graph_def.node()) {
+      if (!OpMatchesPattern(node, pattern)) {
+        continue;
+      }
+      replacements.emplace_back();
+      Replacement& replacement = replacements.back();
+      replacement.head = &node;
+      if (node.input_size() > 0) {
+        replacement.input_nodes.insert(node.name());
+      }
+      if (outputs_map.count(node.name())) {
+        replacement.output_nodes.insert(node.name());
+      }
+    }
+  } else {
+    GraphMatcher matcher(input_graph_def);
+    TF_RETURN_IF_ERROR(matcher.GetOpTypeMatches(pattern, &matches));
+    replacements.resize(matches.size());
+    for (int i = 0; i < matches.size(); ++i) {
+      const NodeMatch& match = matches[i];
+      RecordMatchedNodes(match, &matched_nodes);
+      Replacement& replacement = replacements[i];
+      replacement.match = &match;
       std::vector<NodeDef> matched_nodes_array;
-      MatchedNodesAsArray(*match, &matched_nodes_array);
+      MatchedNodesAsArray(match, &matched_nodes_array);
       // This tells us whether a node is part of the current match.
       std::set<string> matched_nodes_lookup;
       for (const NodeDef& matched_node : matched_nodes_array) {
@@ -398,8 +478,6 @@ Status ReplaceMatchingOpTypes(
       // These are helper arrays that the replacement function can use to tell
       // whether it can safely remove an internal node (because nothing outside
       // of the match uses it) or whether external nodes depend on it.
-      std::set<string> input_nodes;
-      std::set<string> output_nodes;
       for (const NodeDef& matched_node : matched_nodes_array) {
         // Look through all of this node's inputs, and if any of them come from
         // outside the match, then this should be noted as one of the external
@@ -407,7 +485,7 @@ Status ReplaceMatchingOpTypes(
         for (const string& input_name : matched_node.input()) {
           string input_node_name = NodeNameFromInput(input_name);
           if (!matched_nodes_lookup.count(input_node_name)) {
-            input_nodes.insert(matched_node.name());
+            replacement.input_nodes.insert(matched_node.name());
           }
         }
         // Do a reverse input lookup, to see which other nodes use the current
@@ -418,46 +496,53 @@ Status ReplaceMatchingOpTypes(
           for (const NodeDef* dependent_node :
                outputs_map[matched_node.name()]) {
             if (!matched_nodes_lookup.count(dependent_node->name())) {
-              output_nodes.insert(matched_node.name());
+              replacement.output_nodes.insert(matched_node.name());
             }
           }
         }
       }
-      // Call the generator function and add all the returned nodes to the
-      // graph.
-      std::vector<NodeDef> new_nodes;
-      TF_RETURN_IF_ERROR(
-          node_generator(*match, input_nodes, output_nodes, &new_nodes));
-      std::set<string> new_node_names;
-      for (const NodeDef& new_node : new_nodes) {
-        new_node_names.insert(new_node.name());
-      }
-      // Check to make sure the generator function preserved all of the nodes
-      // that are used elsewhere in the graph, and add them back in if not.
-      bool abort_replacement = false;
-      if (!options.allow_inconsistencies) {
-        for (const string& expected_output : output_nodes) {
-          if (!new_node_names.count(expected_output)) {
-            LOG(WARNING) << "Expected " << expected_output
-                         << " to be preserved.";
-            abort_replacement = true;
-          }
-        }
-      }
-      if (abort_replacement) {
-        LOG(WARNING) << "Generator function didn't preserve needed nodes, "
-                     << "copying old replacements back in instead.";
-        std::vector<NodeDef> old_nodes;
-        MatchedNodesAsArray(*match, &old_nodes);
-        for (const NodeDef& old_node : old_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = old_node;
-        }
-      } else {
-        for (const NodeDef& new_node : new_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = new_node;
-        }
+    }
+  }
+
+  // Call the generator function for every match. The matches are independent,
+  // so they can be spread over threads.
+  if (options.num_threads > 1 && replacements.size() > 1) {
+    thread::ThreadPool pool(Env::Default(), "replace_matching_op_types",
+                            options.num_threads);
+    // Each replacement is typically expensive, e.g. quantizing a tensor.
+    const int64 kCostPerReplacement = 1 << 20;
+    pool.ParallelFor(replacements.size(), kCostPerReplacement,
+                     [&](int64 begin, int64 end) {
+                       for (int64 i = begin; i < end; ++i) {
+                         GenerateReplacement(node_generator, options,
+                                             &replacements[i]);
+                       }
+                     });
+  } else {
+    for (Replacement& replacement : replacements) {
+      GenerateReplacement(node_generator, options, &replacement);
+    }
+  }
+  std::map<string, Replacement*> replacements_by_head_name;
+  for (Replacement& replacement : replacements) {
+    TF_RETURN_IF_ERROR(replacement.status);
+    const string& head_name = replacement.match != nullptr
+                                  ? replacement.match->node.name()
+                                  : replacement.head->name();
+    replacements_by_head_name[head_name] = &replacement;
+  }
+
+  // Go through all the nodes in the input graph, see if they are part of a
+  // match or if they can be left untouched.
+  output_graph_def->Clear();
+  for (const NodeDef& input_node : input_graph_def.node()) {
+    auto replacement_it = replacements_by_head_name.find(input_node.name());
+    if (replacement_it != replacements_by_head_name.end()) {
+      // This node is the beginning of a match, so add its replacement nodes
+      // to the graph. They're moved rather than copied, since they can hold
+      // large tensors.
+      for (NodeDef& new_node : replacement_it->second->new_nodes) {
+        output_graph_def->mutable_node()->Add()->Swap(&new_node);
       }
     } else if (!matched_nodes.count(input_node.name())) {
       // This node isn't part of any match, so just copy it over.
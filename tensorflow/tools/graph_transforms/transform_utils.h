@@ -183,6 +183,9 @@ struct ReplaceMatchingOpTypesOptions {
   // Whether to raise an error if the graph is left with dangling inputs. If you
   // enable this option, you must fix inconsistencies in a later pass.
   bool allow_inconsistencies;
+  // The number of threads to call the replacement function on, concurrently
+  // for different matches. Values below 2 call it on the caller's thread.
+  int num_threads;
 };
 
 // Replaces all of the matching sub-graphs with new ops. This calls into the
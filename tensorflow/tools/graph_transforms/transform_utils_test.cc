@@ -488,6 +488,58 @@ class TransformUtilsTest : public ::testing::Test {
     }
   }
 
+  void TestReplaceMatchingOpTypesInParallel() {
+    GraphDef graph_def;
+    const int num_consts = 20;
+    for (int i = 0; i < num_consts; ++i) {
+      NodeDef* const_node = graph_def.mutable_node()->Add();
+      const_node->set_op("Const");
+      const_node->set_name(strings::StrCat("const_", i));
+      NodeDef* add_node = graph_def.mutable_node()->Add();
+      add_node->set_op("Add");
+      add_node->set_name(strings::StrCat("add_", i));
+      AddNodeInput(const_node->name(), add_node);
+      AddNodeInput(const_node->name(), add_node);
+    }
+
+    for (int num_threads : {1, 4}) {
+      GraphDef replaced_graph_def;
+      TF_ASSERT_OK(ReplaceMatchingOpTypes(
+          graph_def, {"Const"},
+          [](const NodeMatch& match, const std::set<string>& input_nodes,
+             const std::set<string>& output_nodes,
+             std::vector<NodeDef>* new_nodes) {
+            EXPECT_TRUE(input_nodes.empty());
+            EXPECT_EQ(std::set<string>({match.node.name()}), output_nodes);
+            NodeDef new_node = match.node;
+            SetNodeAttr("replaced", true, &new_node);
+            new_nodes->push_back(new_node);
+            return Status::OK();
+          },
+          {false, num_threads}, &replaced_graph_def));
+
+      // The nodes keep their order, and only the Const ones are replaced.
+      ASSERT_EQ(graph_def.node_size(), replaced_graph_def.node_size());
+      for (int i = 0; i < graph_def.node_size(); ++i) {
+        const NodeDef& node = replaced_graph_def.node(i);
+        EXPECT_EQ(graph_def.node(i).name(), node.name());
+        EXPECT_EQ(node.op() == "Const", node.attr().count("replaced") == 1);
+      }
+    }
+
+    // The first error in graph order is returned.
+    GraphDef replaced_graph_def;
+    Status status = ReplaceMatchingOpTypes(
+        graph_def, {"Const"},
+        [](const NodeMatch& match, const std::set<string>& input_nodes,
+           const std::set<string>& output_nodes,
+           std::vector<NodeDef>* new_nodes) {
+          return errors::InvalidArgument(match.node.name());
+        },
+        {false, 4}, &replaced_graph_def);
+    EXPECT_EQ("const_0", status.error_message());
+  }
+
   void TestMatchedNodesAsArray() {
     NodeMatch fourth;
     fourth.node.set_name("fourth");
@@ -1106,6 +1158,10 @@ TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypes) {
   TestReplaceMatchingOpTypes();
 }
 
+TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypesInParallel) {
+  TestReplaceMatchingOpTypesInParallel();
+}
+
 TEST_F(TransformUtilsTest, TestMatchedNodesAsArray) {
   TestMatchedNodesAsArray();
 }